@@ -84,6 +84,13 @@
  *
  * ]|
  * </refsect2>
+ *
+ * With #GstCairoOverlay:cache-overlay enabled, the draw signal is only
+ * emitted for the first frame and after the application emitted the
+ * #GstCairoOverlay::invalidate action signal. The drawing is kept as an
+ * overlay of its bounding box, which is either attached to the buffers as
+ * #GstVideoOverlayCompositionMeta when downstream supports it, or blended
+ * into the frames without touching the rest of the picture.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -96,6 +103,9 @@
 
 #include <cairo.h>
 
+#include <string.h>
+#include <math.h>
+
 /* RGB16 is native-endianness in GStreamer */
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
 #define TEMPLATE_CAPS GST_VIDEO_CAPS_MAKE("{ BGRx, BGRA, RGB16 }")
@@ -123,11 +133,89 @@ enum
 {
   SIGNAL_DRAW,
   SIGNAL_CAPS_CHANGED,
+  SIGNAL_INVALIDATE,
   N_SIGNALS
 };
 
+enum
+{
+  PROP_0,
+  PROP_CACHE_OVERLAY
+};
+
+#define DEFAULT_CACHE_OVERLAY FALSE
+
 static guint gst_cairo_overlay_signals[N_SIGNALS];
 
+static void
+gst_cairo_overlay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstCairoOverlay *overlay = GST_CAIRO_OVERLAY (object);
+
+  switch (prop_id) {
+    case PROP_CACHE_OVERLAY:
+      GST_OBJECT_LOCK (overlay);
+      overlay->cache_overlay = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (overlay);
+      g_atomic_int_set (&overlay->need_redraw, TRUE);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_cairo_overlay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstCairoOverlay *overlay = GST_CAIRO_OVERLAY (object);
+
+  switch (prop_id) {
+    case PROP_CACHE_OVERLAY:
+      GST_OBJECT_LOCK (overlay);
+      g_value_set_boolean (value, overlay->cache_overlay);
+      GST_OBJECT_UNLOCK (overlay);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_cairo_overlay_finalize (GObject * object)
+{
+  GstCairoOverlay *overlay = GST_CAIRO_OVERLAY (object);
+
+  if (overlay->composition)
+    gst_video_overlay_composition_unref (overlay->composition);
+
+  G_OBJECT_CLASS (gst_cairo_overlay_parent_class)->finalize (object);
+}
+
+static void
+gst_cairo_overlay_invalidate (GstCairoOverlay * overlay)
+{
+  g_atomic_int_set (&overlay->need_redraw, TRUE);
+}
+
+static gboolean
+gst_cairo_overlay_decide_allocation (GstBaseTransform * trans,
+    GstQuery * query)
+{
+  GstCairoOverlay *overlay = GST_CAIRO_OVERLAY (trans);
+
+  overlay->attach_compo_to_buffer = gst_query_find_allocation_meta (query,
+      GST_VIDEO_OVERLAY_COMPOSITION_META_API_TYPE, NULL);
+  GST_DEBUG_OBJECT (overlay, "downstream %s overlay composition meta",
+      overlay->attach_compo_to_buffer ? "supports" : "doesn't support");
+
+  return GST_BASE_TRANSFORM_CLASS (gst_cairo_overlay_parent_class)->
+      decide_allocation (trans, query);
+}
+
 static gboolean
 gst_cairo_overlay_set_info (GstVideoFilter * vfilter, GstCaps * in_caps,
     GstVideoInfo * in_info, GstCaps * out_caps, GstVideoInfo * out_info)
@@ -136,10 +224,74 @@ gst_cairo_overlay_set_info (GstVideoFilter * vfilter, GstCaps * in_caps,
 
   g_signal_emit (overlay, gst_cairo_overlay_signals[SIGNAL_CAPS_CHANGED], 0,
       in_caps, NULL);
+  g_atomic_int_set (&overlay->need_redraw, TRUE);
 
   return TRUE;
 }
 
+/* Lets the application draw into a recording surface and keeps the inked
+ * area as an overlay rectangle in premultiplied ARGB */
+static GstVideoOverlayComposition *
+gst_cairo_overlay_redraw (GstCairoOverlay * overlay, GstVideoFrame * frame)
+{
+  GstVideoOverlayComposition *composition = NULL;
+  GstVideoOverlayRectangle *rect;
+  cairo_rectangle_t extents = { 0, 0, GST_VIDEO_FRAME_WIDTH (frame),
+    GST_VIDEO_FRAME_HEIGHT (frame)
+  };
+  cairo_surface_t *recording, *surface;
+  cairo_t *cr;
+  double x0, y0, w0, h0;
+  gint x, y, width, height;
+  GstBuffer *buffer;
+  GstMapInfo map;
+
+  recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA,
+      &extents);
+  cr = cairo_create (recording);
+  g_signal_emit (overlay, gst_cairo_overlay_signals[SIGNAL_DRAW], 0,
+      cr, GST_BUFFER_PTS (frame->buffer), GST_BUFFER_DURATION (frame->buffer),
+      NULL);
+  cairo_destroy (cr);
+
+  cairo_recording_surface_ink_extents (recording, &x0, &y0, &w0, &h0);
+  x = CLAMP ((gint) floor (x0), 0, GST_VIDEO_FRAME_WIDTH (frame));
+  y = CLAMP ((gint) floor (y0), 0, GST_VIDEO_FRAME_HEIGHT (frame));
+  width = CLAMP ((gint) ceil (x0 + w0), x, GST_VIDEO_FRAME_WIDTH (frame)) - x;
+  height = CLAMP ((gint) ceil (y0 + h0), y,
+      GST_VIDEO_FRAME_HEIGHT (frame)) - y;
+
+  GST_LOG_OBJECT (overlay, "overlay drawn in %dx%d at %d,%d", width, height,
+      x, y);
+
+  if (width > 0 && height > 0) {
+    buffer = gst_buffer_new_allocate (NULL, width * height * 4, NULL);
+    gst_buffer_add_video_meta (buffer, GST_VIDEO_FRAME_FLAG_NONE,
+        GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_RGB, width, height);
+
+    /* replay the drawing into the buffer */
+    gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+    memset (map.data, 0, map.size);
+    surface = cairo_image_surface_create_for_data (map.data,
+        CAIRO_FORMAT_ARGB32, width, height, width * 4);
+    cr = cairo_create (surface);
+    cairo_set_source_surface (cr, recording, -x, -y);
+    cairo_paint (cr);
+    cairo_destroy (cr);
+    cairo_surface_destroy (surface);
+    gst_buffer_unmap (buffer, &map);
+
+    rect = gst_video_overlay_rectangle_new_raw (buffer, x, y, width, height,
+        GST_VIDEO_OVERLAY_FORMAT_FLAG_PREMULTIPLIED_ALPHA);
+    composition = gst_video_overlay_composition_new (rect);
+    gst_video_overlay_rectangle_unref (rect);
+    gst_buffer_unref (buffer);
+  }
+  cairo_surface_destroy (recording);
+
+  return composition;
+}
+
 static GstFlowReturn
 gst_cairo_overlay_transform_frame_ip (GstVideoFilter * vfilter,
     GstVideoFrame * frame)
@@ -148,6 +300,30 @@ gst_cairo_overlay_transform_frame_ip (GstVideoFilter * vfilter,
   cairo_surface_t *surface;
   cairo_t *cr;
   cairo_format_t format;
+  gboolean cache_overlay;
+
+  GST_OBJECT_LOCK (overlay);
+  cache_overlay = overlay->cache_overlay;
+  GST_OBJECT_UNLOCK (overlay);
+
+  if (cache_overlay) {
+    if (g_atomic_int_compare_and_exchange (&overlay->need_redraw, TRUE, FALSE)) {
+      if (overlay->composition)
+        gst_video_overlay_composition_unref (overlay->composition);
+      overlay->composition = gst_cairo_overlay_redraw (overlay, frame);
+    }
+
+    if (overlay->composition == NULL)
+      return GST_FLOW_OK;
+
+    if (overlay->attach_compo_to_buffer) {
+      gst_buffer_add_video_overlay_composition_meta (frame->buffer,
+          overlay->composition);
+    } else {
+      gst_video_overlay_composition_blend (overlay->composition, frame);
+    }
+    return GST_FLOW_OK;
+  }
 
   switch (GST_VIDEO_FRAME_FORMAT (frame)) {
     case GST_VIDEO_FORMAT_ARGB:
@@ -196,15 +372,40 @@ gst_cairo_overlay_transform_frame_ip (GstVideoFilter * vfilter,
 static void
 gst_cairo_overlay_class_init (GstCairoOverlayClass * klass)
 {
+  GObjectClass *gobject_class;
+  GstBaseTransformClass *trans_class;
   GstVideoFilterClass *vfilter_class;
   GstElementClass *element_class;
 
+  gobject_class = (GObjectClass *) klass;
+  trans_class = (GstBaseTransformClass *) klass;
   vfilter_class = (GstVideoFilterClass *) klass;
   element_class = (GstElementClass *) klass;
 
+  gobject_class->set_property = gst_cairo_overlay_set_property;
+  gobject_class->get_property = gst_cairo_overlay_get_property;
+  gobject_class->finalize = gst_cairo_overlay_finalize;
+
+  trans_class->decide_allocation = gst_cairo_overlay_decide_allocation;
+
   vfilter_class->set_info = gst_cairo_overlay_set_info;
   vfilter_class->transform_frame_ip = gst_cairo_overlay_transform_frame_ip;
 
+  klass->invalidate = gst_cairo_overlay_invalidate;
+
+  /**
+   * GstCairoOverlay:cache-overlay:
+   *
+   * Only emit the draw signal when the overlay was invalidated and reuse
+   * the drawing for the other frames, see #GstCairoOverlay::invalidate.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_CACHE_OVERLAY,
+      g_param_spec_boolean ("cache-overlay", "Cache overlay",
+          "Only redraw the overlay after the invalidate signal",
+          DEFAULT_CACHE_OVERLAY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstCairoOverlay::draw:
    * @overlay: Overlay element emitting the signal.
@@ -237,6 +438,22 @@ gst_cairo_overlay_class_init (GstCairoOverlayClass * klass)
       0,
       0, NULL, NULL, g_cclosure_marshal_generic, G_TYPE_NONE, 1, GST_TYPE_CAPS);
 
+  /**
+   * GstCairoOverlay::invalidate:
+   * @overlay: Overlay element to redraw.
+   *
+   * Action signal to make the element emit the draw signal again for the
+   * next frame when #GstCairoOverlay:cache-overlay is enabled.
+   *
+   * Since: 1.4
+   */
+  gst_cairo_overlay_signals[SIGNAL_INVALIDATE] =
+      g_signal_new ("invalidate",
+      G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstCairoOverlayClass, invalidate),
+      NULL, NULL, g_cclosure_marshal_generic, G_TYPE_NONE, 0);
+
   gst_element_class_set_static_metadata (element_class, "Cairo overlay",
       "Filter/Editor/Video",
       "Render overlay on a video stream using Cairo",
@@ -251,5 +468,6 @@ gst_cairo_overlay_class_init (GstCairoOverlayClass * klass)
 static void
 gst_cairo_overlay_init (GstCairoOverlay * overlay)
 {
-  /* nothing to do */
+  overlay->cache_overlay = DEFAULT_CACHE_OVERLAY;
+  overlay->need_redraw = TRUE;
 }
@@ -23,6 +23,7 @@
 #include <gst/gst.h>
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
+#include <gst/video/video-overlay-composition.h>
 
 #include <cairo.h>
 #include <cairo-gobject.h>
@@ -45,10 +46,21 @@ typedef struct _GstCairoOverlayClass GstCairoOverlayClass;
 
 struct _GstCairoOverlay {
   GstVideoFilter video_filter;
+
+  /* < private > */
+  gboolean cache_overlay;
+
+  /* cached overlay mode */
+  gint need_redraw;
+  gboolean attach_compo_to_buffer;
+  GstVideoOverlayComposition *composition;
 };
 
 struct _GstCairoOverlayClass {
   GstVideoFilterClass video_filter_class;
+
+  /* actions */
+  void (*invalidate) (GstCairoOverlay * overlay);
 };
 
 GType gst_cairo_overlay_get_type (void);
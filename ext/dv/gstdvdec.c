@@ -28,6 +28,11 @@
  * property. Setting this property to a value N > 1 will only decode every 
  * Nth frame.
  *
+ * With the #GstDVDec:n-threads property set to more than one thread,
+ * successive frames are decoded in parallel by a pool of decoders. Frames
+ * are still output in order, with a delay of up to twice the number of
+ * threads.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -72,6 +77,7 @@
 
 #define DV_DEFAULT_QUALITY DV_QUALITY_BEST
 #define DV_DEFAULT_DECODE_NTH 1
+#define DV_DEFAULT_N_THREADS 1
 
 GST_DEBUG_CATEGORY_STATIC (dvdec_debug);
 #define GST_CAT_DEFAULT dvdec_debug
@@ -82,7 +88,8 @@ enum
   PROP_CLAMP_LUMA,
   PROP_CLAMP_CHROMA,
   PROP_QUALITY,
-  PROP_DECODE_NTH
+  PROP_DECODE_NTH,
+  PROP_N_THREADS
 };
 
 const gint qualities[] = {
@@ -146,6 +153,7 @@ static void gst_dvdec_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_dvdec_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
+static void gst_dvdec_finalize (GObject * object);
 
 static void
 gst_dvdec_class_init (GstDVDecClass * klass)
@@ -158,6 +166,7 @@ gst_dvdec_class_init (GstDVDecClass * klass)
 
   gobject_class->set_property = gst_dvdec_set_property;
   gobject_class->get_property = gst_dvdec_get_property;
+  gobject_class->finalize = gst_dvdec_finalize;
 
   g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_CLAMP_LUMA,
       g_param_spec_boolean ("clamp-luma", "Clamp luma", "Clamp luma",
@@ -173,6 +182,18 @@ gst_dvdec_class_init (GstDVDecClass * klass)
       g_param_spec_int ("drop-factor", "Drop Factor", "Only decode Nth frame",
           1, G_MAXINT, DV_DEFAULT_DECODE_NTH,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstDVDec:n-threads:
+   *
+   * Number of frames decoded in parallel.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of frames decoded in parallel (0 = number of processors)",
+          0, G_MAXUINT, DV_DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_dvdec_change_state);
 
@@ -209,6 +230,169 @@ gst_dvdec_init (GstDVDec * dvdec)
   dvdec->clamp_luma = FALSE;
   dvdec->clamp_chroma = FALSE;
   dvdec->quality = DV_DEFAULT_QUALITY;
+  dvdec->n_threads = DV_DEFAULT_N_THREADS;
+
+  g_queue_init (&dvdec->decode_jobs);
+  g_queue_init (&dvdec->free_decoders);
+  g_mutex_init (&dvdec->decode_lock);
+  g_cond_init (&dvdec->decode_cond);
+}
+
+static void
+gst_dvdec_finalize (GObject * object)
+{
+  GstDVDec *dvdec = GST_DVDEC (object);
+
+  g_mutex_clear (&dvdec->decode_lock);
+  g_cond_clear (&dvdec->decode_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static dv_decoder_t *
+gst_dvdec_new_decoder (GstDVDec * dvdec)
+{
+  dv_decoder_t *decoder;
+
+  decoder = dv_decoder_new (0, dvdec->clamp_luma, dvdec->clamp_chroma);
+  decoder->quality = qualities[dvdec->quality];
+  dv_set_error_log (decoder, NULL);
+
+  return decoder;
+}
+
+static void
+gst_dvdec_decode_frame (GstDVDec * dvdec, dv_decoder_t * decoder,
+    guint8 * inframe, GstVideoFrame * frame)
+{
+  guint8 *outframe_ptrs[3];
+  gint outframe_pitches[3];
+
+  outframe_ptrs[0] = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  outframe_pitches[0] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+
+  /* the rest only matters for YUY2 */
+  if (dvdec->bpp < 3) {
+    outframe_ptrs[1] = GST_VIDEO_FRAME_COMP_DATA (frame, 1);
+    outframe_ptrs[2] = GST_VIDEO_FRAME_COMP_DATA (frame, 2);
+
+    outframe_pitches[1] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 1);
+    outframe_pitches[2] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 2);
+  }
+
+  dv_decode_full_frame (decoder, inframe,
+      e_dv_color_yuv, outframe_ptrs, outframe_pitches);
+}
+
+static void
+gst_dvdec_decode_func (gpointer data, gpointer user_data)
+{
+  GstDVDecJob *job = data;
+  GstDVDec *dvdec = job->dvdec;
+
+  /* every decoder needs the header of its own frame */
+  dv_parse_header (job->decoder, job->inmap.data);
+  gst_dvdec_decode_frame (dvdec, job->decoder, job->inmap.data, &job->frame);
+
+  g_mutex_lock (&dvdec->decode_lock);
+  job->done = TRUE;
+  g_cond_broadcast (&dvdec->decode_cond);
+  g_mutex_unlock (&dvdec->decode_lock);
+}
+
+static void
+gst_dvdec_job_free (GstDVDec * dvdec, GstDVDecJob * job)
+{
+  if (job->outbuf)
+    gst_buffer_unref (job->outbuf);
+  gst_buffer_unmap (job->inbuf, &job->inmap);
+  gst_buffer_unref (job->inbuf);
+
+  g_mutex_lock (&dvdec->decode_lock);
+  g_queue_push_tail (&dvdec->free_decoders, job->decoder);
+  g_mutex_unlock (&dvdec->decode_lock);
+
+  g_slice_free (GstDVDecJob, job);
+}
+
+/* Pushes decoded frames in input order and waits until at most max_pending
+ * frames are left. Without push the frames are dropped instead. */
+static GstFlowReturn
+gst_dvdec_collect_jobs (GstDVDec * dvdec, guint max_pending, gboolean push)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstDVDecJob *job;
+
+  g_mutex_lock (&dvdec->decode_lock);
+  while ((job = g_queue_peek_head (&dvdec->decode_jobs))) {
+    if (!job->done) {
+      if (g_queue_get_length (&dvdec->decode_jobs) <= max_pending)
+        break;
+      g_cond_wait (&dvdec->decode_cond, &dvdec->decode_lock);
+      continue;
+    }
+
+    g_queue_pop_head (&dvdec->decode_jobs);
+    g_mutex_unlock (&dvdec->decode_lock);
+
+    gst_video_frame_unmap (&job->frame);
+    if (push && ret == GST_FLOW_OK) {
+      ret = gst_pad_push (dvdec->srcpad, job->outbuf);
+      job->outbuf = NULL;
+    }
+    gst_dvdec_job_free (dvdec, job);
+
+    g_mutex_lock (&dvdec->decode_lock);
+  }
+  g_mutex_unlock (&dvdec->decode_lock);
+
+  return ret;
+}
+
+/* takes ownership of outbuf */
+static GstFlowReturn
+gst_dvdec_queue_job (GstDVDec * dvdec, GstBuffer * buf, GstBuffer * outbuf)
+{
+  GstDVDecJob *job;
+  guint n_threads;
+
+  n_threads = g_thread_pool_get_max_threads (dvdec->decode_pool);
+
+  job = g_slice_new0 (GstDVDecJob);
+  job->dvdec = dvdec;
+  job->inbuf = gst_buffer_ref (buf);
+  gst_buffer_map (buf, &job->inmap, GST_MAP_READ);
+  job->outbuf = outbuf;
+  gst_video_frame_map (&job->frame, &dvdec->vinfo, outbuf, GST_MAP_WRITE);
+
+  g_mutex_lock (&dvdec->decode_lock);
+  job->decoder = g_queue_pop_head (&dvdec->free_decoders);
+  g_mutex_unlock (&dvdec->decode_lock);
+  /* decoders are only created here, libdv's initialization is not thread
+   * safe */
+  if (job->decoder == NULL)
+    job->decoder = gst_dvdec_new_decoder (dvdec);
+
+  g_mutex_lock (&dvdec->decode_lock);
+  g_queue_push_tail (&dvdec->decode_jobs, job);
+  g_mutex_unlock (&dvdec->decode_lock);
+  g_thread_pool_push (dvdec->decode_pool, job, NULL);
+
+  return gst_dvdec_collect_jobs (dvdec, 2 * n_threads, TRUE);
+}
+
+static void
+gst_dvdec_stop_jobs (GstDVDec * dvdec)
+{
+  dv_decoder_t *decoder;
+
+  if (dvdec->decode_pool) {
+    gst_dvdec_collect_jobs (dvdec, 0, FALSE);
+    g_thread_pool_free (dvdec->decode_pool, FALSE, TRUE);
+    dvdec->decode_pool = NULL;
+  }
+  while ((decoder = g_queue_pop_head (&dvdec->free_decoders)))
+    dv_decoder_free (decoder);
 }
 
 static gboolean
@@ -365,6 +549,11 @@ gst_dvdec_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 
   dvdec = GST_DVDEC (parent);
 
+  /* output the frames that are still decoding before serialized events */
+  if (dvdec->decode_pool && GST_EVENT_IS_SERIALIZED (event))
+    gst_dvdec_collect_jobs (dvdec, 0,
+        GST_EVENT_TYPE (event) != GST_EVENT_FLUSH_STOP);
+
   switch (GST_EVENT_TYPE (event)) {
     case GST_EVENT_FLUSH_STOP:
       gst_segment_init (&dvdec->segment, GST_FORMAT_UNDEFINED);
@@ -415,8 +604,6 @@ gst_dvdec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
   GstDVDec *dvdec;
   guint8 *inframe;
-  guint8 *outframe_ptrs[3];
-  gint outframe_pitches[3];
   GstMapInfo map;
   GstVideoFrame frame;
   GstBuffer *outbuf;
@@ -472,6 +659,29 @@ gst_dvdec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 
   dvdec->interlaced = !dv_is_progressive (dvdec->decoder);
 
+  if (dvdec->n_threads != 1 && dvdec->decode_pool == NULL) {
+    guint n_threads = dvdec->n_threads;
+
+    if (n_threads == 0)
+      n_threads = g_get_num_processors ();
+    if (n_threads > 1)
+      dvdec->decode_pool = g_thread_pool_new (gst_dvdec_decode_func, NULL,
+          n_threads, FALSE, NULL);
+  }
+
+  /* frames of the old configuration go out first */
+  if (dvdec->decode_pool) {
+    gboolean reconfigure = gst_pad_check_reconfigure (dvdec->srcpad);
+
+    if (reconfigure)
+      gst_pad_mark_reconfigure (dvdec->srcpad);
+    if (!dvdec->src_negotiated || reconfigure) {
+      ret = gst_dvdec_collect_jobs (dvdec, 0, TRUE);
+      if (ret != GST_FLOW_OK)
+        goto done;
+    }
+  }
+
   /* negotiate if not done yet */
   if (!dvdec->src_negotiated) {
     if (!gst_dvdec_src_negotiate (dvdec))
@@ -495,26 +705,6 @@ gst_dvdec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   if (G_UNLIKELY (ret != GST_FLOW_OK))
     goto no_buffer;
 
-  gst_video_frame_map (&frame, &dvdec->vinfo, outbuf, GST_MAP_WRITE);
-
-  outframe_ptrs[0] = GST_VIDEO_FRAME_COMP_DATA (&frame, 0);
-  outframe_pitches[0] = GST_VIDEO_FRAME_COMP_STRIDE (&frame, 0);
-
-  /* the rest only matters for YUY2 */
-  if (dvdec->bpp < 3) {
-    outframe_ptrs[1] = GST_VIDEO_FRAME_COMP_DATA (&frame, 1);
-    outframe_ptrs[2] = GST_VIDEO_FRAME_COMP_DATA (&frame, 2);
-
-    outframe_pitches[1] = GST_VIDEO_FRAME_COMP_STRIDE (&frame, 1);
-    outframe_pitches[2] = GST_VIDEO_FRAME_COMP_STRIDE (&frame, 2);
-  }
-
-  GST_DEBUG_OBJECT (dvdec, "decoding and pushing buffer");
-  dv_decode_full_frame (dvdec->decoder, inframe,
-      e_dv_color_yuv, outframe_ptrs, outframe_pitches);
-
-  gst_video_frame_unmap (&frame);
-
   GST_BUFFER_FLAG_UNSET (outbuf, GST_VIDEO_BUFFER_FLAG_TFF);
 
   GST_BUFFER_OFFSET (outbuf) = GST_BUFFER_OFFSET (buf);
@@ -522,6 +712,17 @@ gst_dvdec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   GST_BUFFER_TIMESTAMP (outbuf) = cstart;
   GST_BUFFER_DURATION (outbuf) = cstop - cstart;
 
+  if (dvdec->decode_pool) {
+    GST_DEBUG_OBJECT (dvdec, "queueing buffer for decoding");
+    ret = gst_dvdec_queue_job (dvdec, buf, outbuf);
+    goto skip;
+  }
+
+  gst_video_frame_map (&frame, &dvdec->vinfo, outbuf, GST_MAP_WRITE);
+  GST_DEBUG_OBJECT (dvdec, "decoding and pushing buffer");
+  gst_dvdec_decode_frame (dvdec, dvdec->decoder, inframe, &frame);
+  gst_video_frame_unmap (&frame);
+
   ret = gst_pad_push (dvdec->srcpad, outbuf);
 
 skip:
@@ -579,10 +780,7 @@ gst_dvdec_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_NULL_TO_READY:
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
-      dvdec->decoder =
-          dv_decoder_new (0, dvdec->clamp_luma, dvdec->clamp_chroma);
-      dvdec->decoder->quality = qualities[dvdec->quality];
-      dv_set_error_log (dvdec->decoder, NULL);
+      dvdec->decoder = gst_dvdec_new_decoder (dvdec);
       gst_video_info_init (&dvdec->vinfo);
       gst_segment_init (&dvdec->segment, GST_FORMAT_UNDEFINED);
       dvdec->src_negotiated = FALSE;
@@ -606,6 +804,7 @@ gst_dvdec_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_dvdec_stop_jobs (dvdec);
       dv_decoder_free (dvdec->decoder);
       dvdec->decoder = NULL;
       if (dvdec->pool) {
@@ -643,6 +842,9 @@ gst_dvdec_set_property (GObject * object, guint prop_id, const GValue * value,
     case PROP_DECODE_NTH:
       dvdec->drop_factor = g_value_get_int (value);
       break;
+    case PROP_N_THREADS:
+      dvdec->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -668,6 +870,9 @@ gst_dvdec_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_DECODE_NTH:
       g_value_set_int (value, dvdec->drop_factor);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, dvdec->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
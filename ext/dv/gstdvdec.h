@@ -46,6 +46,18 @@ G_BEGIN_DECLS
 typedef struct _GstDVDec GstDVDec;
 typedef struct _GstDVDecClass GstDVDecClass;
 
+typedef struct {
+  GstDVDec      *dvdec;
+  dv_decoder_t  *decoder;
+
+  GstBuffer     *inbuf;
+  GstMapInfo     inmap;
+  GstBuffer     *outbuf;
+  GstVideoFrame  frame;
+
+  gboolean       done;
+} GstDVDecJob;
+
 
 struct _GstDVDec {
   GstElement     element;
@@ -84,6 +96,14 @@ struct _GstDVDec {
   GstBufferPool *pool;
   GstSegment     segment;
   gboolean       need_segment;
+
+  /* frame parallel decoding */
+  guint          n_threads;
+  GThreadPool   *decode_pool;
+  GQueue         decode_jobs;
+  GQueue         free_decoders;
+  GMutex         decode_lock;
+  GCond          decode_cond;
 };
 
 struct _GstDVDecClass {
@@ -1168,18 +1168,15 @@ gst_dvdemux_handle_src_event (GstPad * pad, GstObject * parent,
   return res;
 }
 
-/* does not take ownership of buffer */
 static GstFlowReturn
-gst_dvdemux_demux_audio (GstDVDemux * dvdemux, GstBuffer * buffer,
+gst_dvdemux_demux_audio (GstDVDemux * dvdemux, guint8 * data,
     guint64 duration)
 {
   gint num_samples;
   GstFlowReturn ret;
   GstMapInfo map;
 
-  gst_buffer_map (buffer, &map, GST_MAP_READ);
-  dv_decode_full_audio (dvdemux->decoder, map.data, dvdemux->audio_buffers);
-  gst_buffer_unmap (buffer, &map);
+  dv_decode_full_audio (dvdemux->decoder, data, dvdemux->audio_buffers);
 
   if (G_LIKELY ((num_samples = dv_get_num_samples (dvdemux->decoder)) > 0)) {
     gint16 *a_ptr;
@@ -1213,15 +1210,32 @@ gst_dvdemux_demux_audio (GstDVDemux * dvdemux, GstBuffer * buffer,
       gst_caps_unref (caps);
     }
 
+    /* nobody wants the samples, don't bother interleaving them */
+    if (!gst_pad_is_linked (dvdemux->audiosrcpad)) {
+      dvdemux->audio_offset += num_samples;
+      return GST_FLOW_NOT_LINKED;
+    }
+
     outbuf = gst_buffer_new_and_alloc (num_samples *
         sizeof (gint16) * dvdemux->channels);
 
     gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
     a_ptr = (gint16 *) map.data;
 
-    for (i = 0; i < num_samples; i++) {
-      for (j = 0; j < dvdemux->channels; j++) {
-        *(a_ptr++) = dvdemux->audio_buffers[j][i];
+    if (dvdemux->channels == 2) {
+      const gint16 *left = dvdemux->audio_buffers[0];
+      const gint16 *right = dvdemux->audio_buffers[1];
+
+      for (i = 0; i < num_samples; i++) {
+        a_ptr[0] = left[i];
+        a_ptr[1] = right[i];
+        a_ptr += 2;
+      }
+    } else {
+      for (i = 0; i < num_samples; i++) {
+        for (j = 0; j < dvdemux->channels; j++) {
+          *(a_ptr++) = dvdemux->audio_buffers[j][i];
+        }
       }
     }
     gst_buffer_unmap (outbuf, &map);
@@ -1342,17 +1356,13 @@ get_ssyb_offset (int dif, int ssyb)
 }
 
 static gboolean
-gst_dvdemux_get_timecode (GstDVDemux * dvdemux, GstBuffer * buffer,
+gst_dvdemux_get_timecode (GstDVDemux * dvdemux, const guint8 * data,
     GstSMPTETimeCode * timecode)
 {
-  guint8 *data;
-  GstMapInfo map;
   int offset;
   int dif;
   int n_difs = dvdemux->decoder->num_dif_seqs;
 
-  gst_buffer_map (buffer, &map, GST_MAP_READ);
-  data = map.data;
   for (dif = 0; dif < n_difs; dif++) {
     offset = get_ssyb_offset (dif, 3);
     if (data[offset + 3] == 0x13) {
@@ -1366,28 +1376,22 @@ gst_dvdemux_get_timecode (GstDVDemux * dvdemux, GstBuffer * buffer,
           (data[offset + 7] & 0xf);
       GST_DEBUG ("got timecode %" GST_SMPTE_TIME_CODE_FORMAT,
           GST_SMPTE_TIME_CODE_ARGS (timecode));
-      gst_buffer_unmap (buffer, &map);
       return TRUE;
     }
   }
 
-  gst_buffer_unmap (buffer, &map);
   return FALSE;
 }
 
 static gboolean
-gst_dvdemux_is_new_media (GstDVDemux * dvdemux, GstBuffer * buffer)
+gst_dvdemux_is_new_media (GstDVDemux * dvdemux, const guint8 * data)
 {
-  guint8 *data;
-  GstMapInfo map;
   int aaux_offset;
   int dif;
   int n_difs;
 
   n_difs = dvdemux->decoder->num_dif_seqs;
 
-  gst_buffer_map (buffer, &map, GST_MAP_READ);
-  data = map.data;
   for (dif = 0; dif < n_difs; dif++) {
     if (dif & 1) {
       aaux_offset = (dif * 12000) + (6 + 16 * 1) * 80 + 3;
@@ -1396,13 +1400,11 @@ gst_dvdemux_is_new_media (GstDVDemux * dvdemux, GstBuffer * buffer)
     }
     if (data[aaux_offset + 0] == 0x51) {
       if ((data[aaux_offset + 2] & 0x80) == 0) {
-        gst_buffer_unmap (buffer, &map);
         return TRUE;
       }
     }
   }
 
-  gst_buffer_unmap (buffer, &map);
   return FALSE;
 }
 
@@ -1451,7 +1453,11 @@ gst_dvdemux_demux_frame (GstDVDemux * dvdemux, GstBuffer * buffer)
     dvdemux->need_segment = FALSE;
   }
 
-  gst_dvdemux_get_timecode (dvdemux, buffer, &timecode);
+  /* the frame is mapped once for the parsing and the audio, the video
+   * is pushed as the same buffer without copying */
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+
+  gst_dvdemux_get_timecode (dvdemux, map.data, &timecode);
   gst_smpte_time_code_get_frame_number (
       (dvdemux->decoder->system == e_dv_system_625_50) ?
       GST_SMPTE_TIME_CODE_SYSTEM_25 : GST_SMPTE_TIME_CODE_SYSTEM_30,
@@ -1462,19 +1468,17 @@ gst_dvdemux_demux_frame (GstDVDemux * dvdemux, GstBuffer * buffer)
       dvdemux->framerate_denominator, dvdemux->framerate_numerator);
   duration = next_ts - dvdemux->time_segment.position;
 
-  gst_buffer_map (buffer, &map, GST_MAP_READ);
   dv_parse_packs (dvdemux->decoder, map.data);
-  gst_buffer_unmap (buffer, &map);
   dvdemux->new_media = FALSE;
-  if (gst_dvdemux_is_new_media (dvdemux, buffer) &&
+  if (gst_dvdemux_is_new_media (dvdemux, map.data) &&
       dvdemux->frames_since_new_media > 2) {
     dvdemux->new_media = TRUE;
     dvdemux->frames_since_new_media = 0;
   }
   dvdemux->frames_since_new_media++;
 
-  /* does not take ownership of buffer */
-  aret = ret = gst_dvdemux_demux_audio (dvdemux, buffer, duration);
+  aret = ret = gst_dvdemux_demux_audio (dvdemux, map.data, duration);
+  gst_buffer_unmap (buffer, &map);
   if (G_UNLIKELY (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED)) {
     gst_buffer_unref (buffer);
     goto done;
@@ -48,6 +48,11 @@
 #include <gst/gst-i18n-plugin.h>
 #include <gst/tag/tag.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_FLAC_DEC_SSE2 1
+#endif
+
 /* Taken from http://flac.sourceforge.net/format.html#frame_header */
 static const GstAudioChannelPosition channel_positions[8][8] = {
   {GST_AUDIO_CHANNEL_POSITION_MONO},
@@ -572,6 +577,182 @@ gst_flac_dec_read_stream (const FLAC__StreamDecoder * decoder,
   return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
 }
 
+#ifdef HAVE_FLAC_DEC_SSE2
+/* loads 4 samples of a channel shifted to the output depth */
+#define LOAD_SHIFTED(p) \
+    _mm_sll_epi32 (_mm_loadu_si128 ((const __m128i *) (p)), sh)
+
+/* sign extends the low 16 bits of every lane, like a cast to gint16 */
+#define TRUNC_16(v) _mm_srai_epi32 (_mm_slli_epi32 (v, 16), 16)
+
+/* transposes 4 channels of 4 samples to 4 samples of 4 channels */
+#define TRANSPOSE_4X4(a, b, c, d) G_STMT_START { \
+  __m128i t0 = _mm_unpacklo_epi32 (a, b); \
+  __m128i t1 = _mm_unpacklo_epi32 (c, d); \
+  __m128i t2 = _mm_unpackhi_epi32 (a, b); \
+  __m128i t3 = _mm_unpackhi_epi32 (c, d); \
+  a = _mm_unpacklo_epi64 (t0, t1); \
+  b = _mm_unpackhi_epi64 (t0, t1); \
+  c = _mm_unpacklo_epi64 (t2, t3); \
+  d = _mm_unpackhi_epi64 (t2, t3); \
+} G_STMT_END
+
+/* stores the first two 16 bit values of v */
+static inline void
+store_2x16 (gint16 * dest, __m128i v)
+{
+  guint32 val = _mm_cvtsi128_si32 (v);
+
+  memcpy (dest, &val, sizeof (val));
+}
+#endif
+
+/* The interleave functions write the channel planes of libFLAC shifted to
+ * the output depth, src is already in output channel order. Stereo and 5.1
+ * and 7.1 layouts are interleaved 4 samples at a time with SSE2. */
+static void
+gst_flac_dec_interleave_8 (gint8 * dest, const FLAC__int32 * const *src,
+    guint channels, guint samples, guint shift)
+{
+  guint i, j;
+
+  for (i = 0; i < samples; i++)
+    for (j = 0; j < channels; j++)
+      *dest++ = (gint8) (src[j][i] << shift);
+}
+
+static void
+gst_flac_dec_interleave_16 (gint16 * dest, const FLAC__int32 * const *src,
+    guint channels, guint samples, guint shift)
+{
+  guint i = 0, j;
+
+#ifdef HAVE_FLAC_DEC_SSE2
+  __m128i sh = _mm_cvtsi32_si128 (shift);
+
+  if (channels == 2) {
+    for (; i + 4 <= samples; i += 4) {
+      __m128i l = TRUNC_16 (LOAD_SHIFTED (src[0] + i));
+      __m128i r = TRUNC_16 (LOAD_SHIFTED (src[1] + i));
+      __m128i p = _mm_packs_epi32 (l, r);
+
+      _mm_storeu_si128 ((__m128i *) (dest + 2 * i),
+          _mm_unpacklo_epi16 (p, _mm_srli_si128 (p, 8)));
+    }
+  } else if (channels == 6 || channels == 8) {
+    for (; i + 4 <= samples; i += 4) {
+      gint16 *d = dest + channels * i;
+      __m128i a = TRUNC_16 (LOAD_SHIFTED (src[0] + i));
+      __m128i b = TRUNC_16 (LOAD_SHIFTED (src[1] + i));
+      __m128i c = TRUNC_16 (LOAD_SHIFTED (src[2] + i));
+      __m128i e = TRUNC_16 (LOAD_SHIFTED (src[3] + i));
+      __m128i f = TRUNC_16 (LOAD_SHIFTED (src[4] + i));
+      __m128i g = TRUNC_16 (LOAD_SHIFTED (src[5] + i));
+
+      TRANSPOSE_4X4 (a, b, c, e);
+      if (channels == 8) {
+        __m128i h = TRUNC_16 (LOAD_SHIFTED (src[6] + i));
+        __m128i k = TRUNC_16 (LOAD_SHIFTED (src[7] + i));
+
+        TRANSPOSE_4X4 (f, g, h, k);
+        _mm_storeu_si128 ((__m128i *) d, _mm_packs_epi32 (a, f));
+        _mm_storeu_si128 ((__m128i *) (d + 8), _mm_packs_epi32 (b, g));
+        _mm_storeu_si128 ((__m128i *) (d + 16), _mm_packs_epi32 (c, h));
+        _mm_storeu_si128 ((__m128i *) (d + 24), _mm_packs_epi32 (e, k));
+      } else {
+        /* channels 4 and 5 of samples 0 and 1, and of 2 and 3 */
+        __m128i lo = _mm_unpacklo_epi32 (f, g);
+        __m128i hi = _mm_unpackhi_epi32 (f, g);
+        __m128i p;
+
+        p = _mm_packs_epi32 (a, lo);
+        _mm_storel_epi64 ((__m128i *) d, p);
+        store_2x16 (d + 4, _mm_srli_si128 (p, 8));
+        p = _mm_packs_epi32 (b, _mm_srli_si128 (lo, 8));
+        _mm_storel_epi64 ((__m128i *) (d + 6), p);
+        store_2x16 (d + 10, _mm_srli_si128 (p, 8));
+        p = _mm_packs_epi32 (c, hi);
+        _mm_storel_epi64 ((__m128i *) (d + 12), p);
+        store_2x16 (d + 16, _mm_srli_si128 (p, 8));
+        p = _mm_packs_epi32 (e, _mm_srli_si128 (hi, 8));
+        _mm_storel_epi64 ((__m128i *) (d + 18), p);
+        store_2x16 (d + 22, _mm_srli_si128 (p, 8));
+      }
+    }
+  }
+  dest += channels * i;
+#endif
+
+  for (; i < samples; i++)
+    for (j = 0; j < channels; j++)
+      *dest++ = (gint16) (src[j][i] << shift);
+}
+
+static void
+gst_flac_dec_interleave_32 (gint32 * dest, const FLAC__int32 * const *src,
+    guint channels, guint samples, guint shift)
+{
+  guint i = 0, j;
+
+#ifdef HAVE_FLAC_DEC_SSE2
+  __m128i sh = _mm_cvtsi32_si128 (shift);
+
+  if (channels == 2) {
+    for (; i + 4 <= samples; i += 4) {
+      __m128i l = LOAD_SHIFTED (src[0] + i);
+      __m128i r = LOAD_SHIFTED (src[1] + i);
+
+      _mm_storeu_si128 ((__m128i *) (dest + 2 * i), _mm_unpacklo_epi32 (l, r));
+      _mm_storeu_si128 ((__m128i *) (dest + 2 * i + 4),
+          _mm_unpackhi_epi32 (l, r));
+    }
+  } else if (channels == 6 || channels == 8) {
+    for (; i + 4 <= samples; i += 4) {
+      gint32 *d = dest + channels * i;
+      __m128i a = LOAD_SHIFTED (src[0] + i);
+      __m128i b = LOAD_SHIFTED (src[1] + i);
+      __m128i c = LOAD_SHIFTED (src[2] + i);
+      __m128i e = LOAD_SHIFTED (src[3] + i);
+      __m128i f = LOAD_SHIFTED (src[4] + i);
+      __m128i g = LOAD_SHIFTED (src[5] + i);
+
+      TRANSPOSE_4X4 (a, b, c, e);
+      if (channels == 8) {
+        __m128i h = LOAD_SHIFTED (src[6] + i);
+        __m128i k = LOAD_SHIFTED (src[7] + i);
+
+        TRANSPOSE_4X4 (f, g, h, k);
+        _mm_storeu_si128 ((__m128i *) d, a);
+        _mm_storeu_si128 ((__m128i *) (d + 4), f);
+        _mm_storeu_si128 ((__m128i *) (d + 8), b);
+        _mm_storeu_si128 ((__m128i *) (d + 12), g);
+        _mm_storeu_si128 ((__m128i *) (d + 16), c);
+        _mm_storeu_si128 ((__m128i *) (d + 20), h);
+        _mm_storeu_si128 ((__m128i *) (d + 24), e);
+        _mm_storeu_si128 ((__m128i *) (d + 28), k);
+      } else {
+        __m128i lo = _mm_unpacklo_epi32 (f, g);
+        __m128i hi = _mm_unpackhi_epi32 (f, g);
+
+        _mm_storeu_si128 ((__m128i *) d, a);
+        _mm_storel_epi64 ((__m128i *) (d + 4), lo);
+        _mm_storeu_si128 ((__m128i *) (d + 6), b);
+        _mm_storel_epi64 ((__m128i *) (d + 10), _mm_srli_si128 (lo, 8));
+        _mm_storeu_si128 ((__m128i *) (d + 12), c);
+        _mm_storel_epi64 ((__m128i *) (d + 16), hi);
+        _mm_storeu_si128 ((__m128i *) (d + 18), e);
+        _mm_storel_epi64 ((__m128i *) (d + 22), _mm_srli_si128 (hi, 8));
+      }
+    }
+  }
+  dest += channels * i;
+#endif
+
+  for (; i < samples; i++)
+    for (j = 0; j < channels; j++)
+      *dest++ = (gint32) (src[j][i] << shift);
+}
+
 static FLAC__StreamDecoderWriteStatus
 gst_flac_dec_write (GstFlacDec * flacdec, const FLAC__Frame * frame,
     const FLAC__int32 * const buffer[])
@@ -583,7 +764,8 @@ gst_flac_dec_write (GstFlacDec * flacdec, const FLAC__Frame * frame,
   guint sample_rate = frame->header.sample_rate;
   guint channels = frame->header.channels;
   guint samples = frame->header.blocksize;
-  guint j, i;
+  const FLAC__int32 *src[8];
+  guint j;
   GstMapInfo map;
   gboolean caps_changed;
 
@@ -665,61 +847,20 @@ gst_flac_dec_write (GstFlacDec * flacdec, const FLAC__Frame * frame,
   outbuf =
       gst_buffer_new_allocate (NULL, samples * channels * (width / 8), NULL);
 
+  /* planes in output channel order */
+  for (j = 0; j < channels; j++)
+    src[j] = buffer[flacdec->channel_reorder_map[j]];
+
   gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
   if (width == 8) {
-    gint8 *outbuffer = (gint8 *) map.data;
-    gint *reorder_map = flacdec->channel_reorder_map;
-
-    if (gdepth != depth) {
-      for (i = 0; i < samples; i++) {
-        for (j = 0; j < channels; j++) {
-          *outbuffer++ =
-              (gint8) (buffer[reorder_map[j]][i] << (gdepth - depth));
-        }
-      }
-    } else {
-      for (i = 0; i < samples; i++) {
-        for (j = 0; j < channels; j++) {
-          *outbuffer++ = (gint8) buffer[reorder_map[j]][i];
-        }
-      }
-    }
+    gst_flac_dec_interleave_8 ((gint8 *) map.data, src, channels, samples,
+        gdepth - depth);
   } else if (width == 16) {
-    gint16 *outbuffer = (gint16 *) map.data;
-    gint *reorder_map = flacdec->channel_reorder_map;
-
-    if (gdepth != depth) {
-      for (i = 0; i < samples; i++) {
-        for (j = 0; j < channels; j++) {
-          *outbuffer++ =
-              (gint16) (buffer[reorder_map[j]][i] << (gdepth - depth));
-        }
-      }
-    } else {
-      for (i = 0; i < samples; i++) {
-        for (j = 0; j < channels; j++) {
-          *outbuffer++ = (gint16) buffer[reorder_map[j]][i];
-        }
-      }
-    }
+    gst_flac_dec_interleave_16 ((gint16 *) map.data, src, channels, samples,
+        gdepth - depth);
   } else if (width == 32) {
-    gint32 *outbuffer = (gint32 *) map.data;
-    gint *reorder_map = flacdec->channel_reorder_map;
-
-    if (gdepth != depth) {
-      for (i = 0; i < samples; i++) {
-        for (j = 0; j < channels; j++) {
-          *outbuffer++ =
-              (gint32) (buffer[reorder_map[j]][i] << (gdepth - depth));
-        }
-      }
-    } else {
-      for (i = 0; i < samples; i++) {
-        for (j = 0; j < channels; j++) {
-          *outbuffer++ = (gint32) buffer[reorder_map[j]][i];
-        }
-      }
-    }
+    gst_flac_dec_interleave_32 ((gint32 *) map.data, src, channels, samples,
+        gdepth - depth);
   } else {
     g_assert_not_reached ();
   }
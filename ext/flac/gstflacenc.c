@@ -55,6 +55,11 @@
 #include <gst/tag/tag.h>
 #include <gst/gsttagsetter.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_FLAC_ENC_SSE2 1
+#endif
+
 /* Taken from http://flac.sourceforge.net/format.html#frame_header */
 static const GstAudioChannelPosition channel_positions[8][8] = {
   {GST_AUDIO_CHANNEL_POSITION_MONO},
@@ -391,6 +396,7 @@ gst_flac_enc_finalize (GObject * object)
   GstFlacEnc *flacenc = GST_FLAC_ENC (object);
 
   FLAC__stream_encoder_delete (flacenc->encoder);
+  g_free (flacenc->data);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -423,6 +429,9 @@ gst_flac_enc_stop (GstAudioEncoder * enc)
   if (flacenc->toc)
     gst_toc_unref (flacenc->toc);
   flacenc->toc = NULL;
+  g_free (flacenc->data);
+  flacenc->data = NULL;
+  flacenc->data_size = 0;
   if (FLAC__stream_encoder_get_state (flacenc->encoder) !=
       FLAC__STREAM_ENCODER_UNINITIALIZED) {
     flacenc->stopped = TRUE;
@@ -1243,14 +1252,122 @@ gst_flac_enc_sink_event (GstAudioEncoder * enc, GstEvent * event)
 #define READ_INT24 GST_READ_UINT24_BE
 #endif
 
+/* widening of interleaved samples that are already in FLAC channel order */
+static void
+gst_flac_enc_widen_s8 (FLAC__int32 * dest, const gint8 * src, gsize n)
+{
+  gsize i = 0;
+
+#ifdef HAVE_FLAC_ENC_SSE2
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128 ((const __m128i *) (src + i));
+    __m128i lo = _mm_unpacklo_epi8 (v, v);
+    __m128i hi = _mm_unpackhi_epi8 (v, v);
+
+    /* every byte ends up in the top byte of a 32 bit lane */
+    _mm_storeu_si128 ((__m128i *) (dest + i),
+        _mm_srai_epi32 (_mm_unpacklo_epi16 (lo, lo), 24));
+    _mm_storeu_si128 ((__m128i *) (dest + i + 4),
+        _mm_srai_epi32 (_mm_unpackhi_epi16 (lo, lo), 24));
+    _mm_storeu_si128 ((__m128i *) (dest + i + 8),
+        _mm_srai_epi32 (_mm_unpacklo_epi16 (hi, hi), 24));
+    _mm_storeu_si128 ((__m128i *) (dest + i + 12),
+        _mm_srai_epi32 (_mm_unpackhi_epi16 (hi, hi), 24));
+  }
+#endif
+  for (; i < n; i++)
+    dest[i] = src[i];
+}
+
+static void
+gst_flac_enc_widen_s16 (FLAC__int32 * dest, const gint16 * src, gsize n)
+{
+  gsize i = 0;
+
+#ifdef HAVE_FLAC_ENC_SSE2
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadu_si128 ((const __m128i *) (src + i));
+
+    _mm_storeu_si128 ((__m128i *) (dest + i),
+        _mm_srai_epi32 (_mm_unpacklo_epi16 (v, v), 16));
+    _mm_storeu_si128 ((__m128i *) (dest + i + 4),
+        _mm_srai_epi32 (_mm_unpackhi_epi16 (v, v), 16));
+  }
+#endif
+  for (; i < n; i++)
+    dest[i] = src[i];
+}
+
+static void
+gst_flac_enc_widen_s24 (FLAC__int32 * dest, const guint8 * src, gsize n)
+{
+  gsize i;
+
+  for (i = 0; i < n; i++, src += 3)
+    dest[i] = ((gint32) (READ_INT24 (src) << 8)) >> 8;
+}
+
+/* widens the samples to FLAC__int32 in FLAC channel order */
+static void
+gst_flac_enc_widen (FLAC__int32 * data, const guint8 * indata, gint width,
+    gsize samples, gint channels, const gint * reorder_map)
+{
+  gboolean reorder = FALSE;
+  gsize i;
+  gint j;
+
+  for (j = 0; j < channels; j++)
+    reorder |= reorder_map[j] != j;
+
+  if (!reorder) {
+    if (width == 8)
+      gst_flac_enc_widen_s8 (data, (const gint8 *) indata, samples * channels);
+    else if (width == 16)
+      gst_flac_enc_widen_s16 (data, (const gint16 *) indata,
+          samples * channels);
+    else if (width == 24)
+      gst_flac_enc_widen_s24 (data, indata, samples * channels);
+    else if (width == 32)
+      memcpy (data, indata, samples * channels * sizeof (FLAC__int32));
+    else
+      g_assert_not_reached ();
+    return;
+  }
+
+  if (width == 8) {
+    const gint8 *in = (const gint8 *) indata;
+
+    for (i = 0; i < samples; i++, in += channels, data += channels)
+      for (j = 0; j < channels; j++)
+        data[reorder_map[j]] = in[j];
+  } else if (width == 16) {
+    const gint16 *in = (const gint16 *) indata;
+
+    for (i = 0; i < samples; i++, in += channels, data += channels)
+      for (j = 0; j < channels; j++)
+        data[reorder_map[j]] = in[j];
+  } else if (width == 24) {
+    const guint8 *in = indata;
+
+    for (i = 0; i < samples; i++, data += channels)
+      for (j = 0; j < channels; j++, in += 3)
+        data[reorder_map[j]] = ((gint32) (READ_INT24 (in) << 8)) >> 8;
+  } else if (width == 32) {
+    const gint32 *in = (const gint32 *) indata;
+
+    for (i = 0; i < samples; i++, in += channels, data += channels)
+      for (j = 0; j < channels; j++)
+        data[reorder_map[j]] = in[j];
+  } else {
+    g_assert_not_reached ();
+  }
+}
+
 static GstFlowReturn
 gst_flac_enc_handle_frame (GstAudioEncoder * enc, GstBuffer * buffer)
 {
   GstFlacEnc *flacenc;
-  FLAC__int32 *data;
   gint samples, width, channels;
-  gulong i;
-  gint j;
   FLAC__bool res;
   GstMapInfo map;
   GstAudioInfo *info =
@@ -1284,52 +1401,22 @@ gst_flac_enc_handle_frame (GstAudioEncoder * enc, GstBuffer * buffer)
   gst_buffer_map (buffer, &map, GST_MAP_READ);
   samples = map.size / (width >> 3);
 
-  data = g_malloc (samples * sizeof (FLAC__int32));
+  /* the scratch buffer only grows */
+  if (flacenc->data_size < samples) {
+    g_free (flacenc->data);
+    flacenc->data = g_new (FLAC__int32, samples);
+    flacenc->data_size = samples;
+  }
 
   samples /= channels;
   GST_LOG_OBJECT (flacenc, "processing %d samples, %d channels", samples,
       channels);
-  if (width == 8) {
-    gint8 *indata = (gint8 *) map.data;
-
-    for (i = 0; i < samples; i++)
-      for (j = 0; j < channels; j++)
-        data[i * channels + reorder_map[j]] =
-            (FLAC__int32) indata[i * channels + j];
-  } else if (width == 16) {
-    gint16 *indata = (gint16 *) map.data;
-
-    for (i = 0; i < samples; i++)
-      for (j = 0; j < channels; j++)
-        data[i * channels + reorder_map[j]] =
-            (FLAC__int32) indata[i * channels + j];
-  } else if (width == 24) {
-    guint8 *indata = (guint8 *) map.data;
-    guint32 val;
-
-    for (i = 0; i < samples; i++)
-      for (j = 0; j < channels; j++) {
-        val = READ_INT24 (&indata[3 * (i * channels + j)]);
-        if (val & 0x00800000)
-          val |= 0xff000000;
-        data[i * channels + reorder_map[j]] = (FLAC__int32) val;
-      }
-  } else if (width == 32) {
-    gint32 *indata = (gint32 *) map.data;
-
-    for (i = 0; i < samples; i++)
-      for (j = 0; j < channels; j++)
-        data[i * channels + reorder_map[j]] =
-            (FLAC__int32) indata[i * channels + j];
-  } else {
-    g_assert_not_reached ();
-  }
+  gst_flac_enc_widen (flacenc->data, map.data, width, samples, channels,
+      reorder_map);
   gst_buffer_unmap (buffer, &map);
 
   res = FLAC__stream_encoder_process_interleaved (flacenc->encoder,
-      (const FLAC__int32 *) data, samples);
-
-  g_free (data);
+      (const FLAC__int32 *) flacenc->data, samples);
 
   if (!res) {
     if (flacenc->last_flow == GST_FLOW_OK)
@@ -65,6 +65,10 @@ struct _GstFlacEnc {
   GList           *headers;
 
   gint             channel_reorder_map[8];
+
+  /* scratch buffer for the widened samples */
+  FLAC__int32     *data;
+  gsize            data_size;
 };
 
 struct _GstFlacEncClass {
@@ -32,6 +32,10 @@
  *
  * Negative offsets are also not yet supported.
  *
+ * If downstream advertises support for #GstVideoOverlayCompositionMeta in
+ * the allocation query, the image is attached to the buffers as such a meta
+ * and left to downstream to render instead of being blended into the video.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -313,16 +317,25 @@ gst_gdk_pixbuf_overlay_finalize (GObject * object)
   g_free (overlay->location);
   overlay->location = NULL;
 
+  if (overlay->comp) {
+    gst_video_overlay_composition_unref (overlay->comp);
+    overlay->comp = NULL;
+  }
+
+  gst_buffer_replace (&overlay->pixels, NULL);
+
+  if (overlay->pixbuf) {
+    g_object_unref (overlay->pixbuf);
+    overlay->pixbuf = NULL;
+  }
+
   G_OBJECT_CLASS (gst_gdk_pixbuf_overlay_parent_class)->finalize (object);
 }
 
 static gboolean
 gst_gdk_pixbuf_overlay_load_image (GstGdkPixbufOverlay * overlay, GError ** err)
 {
-  GstVideoMeta *video_meta;
   GdkPixbuf *pixbuf;
-  guint8 *pixels, *p;
-  gint width, height, stride, w, h, plane;
 
   pixbuf = gdk_pixbuf_new_from_file (overlay->location, err);
 
@@ -340,8 +353,51 @@ gst_gdk_pixbuf_overlay_load_image (GstGdkPixbufOverlay * overlay, GError ** err)
     pixbuf = alpha_pixbuf;
   }
 
-  width = gdk_pixbuf_get_width (pixbuf);
-  height = gdk_pixbuf_get_height (pixbuf);
+  if (overlay->pixbuf)
+    g_object_unref (overlay->pixbuf);
+  overlay->pixbuf = pixbuf;
+
+  /* the scaled pixels are made from the new image on the next update */
+  gst_buffer_replace (&overlay->pixels, NULL);
+  overlay->update_composition = TRUE;
+
+  GST_INFO_OBJECT (overlay, "Loaded image, %d x %d",
+      gdk_pixbuf_get_width (pixbuf), gdk_pixbuf_get_height (pixbuf));
+  return TRUE;
+}
+
+/* makes overlay->pixels hold the image scaled to @width x @height, reusing
+ * the current pixels if they already have that size */
+static void
+gst_gdk_pixbuf_overlay_make_pixels (GstGdkPixbufOverlay * overlay, gint width,
+    gint height)
+{
+  GstVideoMeta *video_meta;
+  GdkPixbuf *pixbuf;
+  guint8 *pixels, *p;
+  gint stride, w, h, plane;
+
+  if (overlay->pixels != NULL) {
+    video_meta = gst_buffer_get_video_meta (overlay->pixels);
+    if (video_meta->width == width && video_meta->height == height)
+      return;
+    gst_buffer_replace (&overlay->pixels, NULL);
+  }
+
+  /* the loaded image stays R-G-B-A so it can be scaled again later */
+  if (width == gdk_pixbuf_get_width (overlay->pixbuf)
+      && height == gdk_pixbuf_get_height (overlay->pixbuf))
+    pixbuf = gdk_pixbuf_copy (overlay->pixbuf);
+  else
+    pixbuf = gdk_pixbuf_scale_simple (overlay->pixbuf, width, height,
+        GDK_INTERP_BILINEAR);
+
+  if (pixbuf == NULL) {
+    GST_WARNING_OBJECT (overlay, "could not scale image to %d x %d", width,
+        height);
+    return;
+  }
+
   stride = gdk_pixbuf_get_rowstride (pixbuf);
   pixels = gdk_pixbuf_get_pixels (pixbuf);
 
@@ -382,10 +438,7 @@ gst_gdk_pixbuf_overlay_load_image (GstGdkPixbufOverlay * overlay, GError ** err)
   for (plane = 0; plane < video_meta->n_planes; ++plane)
     video_meta->stride[plane] = stride;
 
-  overlay->update_composition = TRUE;
-
-  GST_INFO_OBJECT (overlay, "Loaded image, %d x %d", width, height);
-  return TRUE;
+  GST_DEBUG_OBJECT (overlay, "scaled image to %d x %d", width, height);
 }
 
 static gboolean
@@ -428,6 +481,11 @@ gst_gdk_pixbuf_overlay_stop (GstBaseTransform * trans)
 
   gst_buffer_replace (&overlay->pixels, NULL);
 
+  if (overlay->pixbuf) {
+    g_object_unref (overlay->pixbuf);
+    overlay->pixbuf = NULL;
+  }
+
   return TRUE;
 }
 
@@ -435,16 +493,53 @@ static gboolean
 gst_gdk_pixbuf_overlay_set_info (GstVideoFilter * filter, GstCaps * incaps,
     GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
 {
+  GstGdkPixbufOverlay *overlay = GST_GDK_PIXBUF_OVERLAY (filter);
+
   GST_INFO_OBJECT (filter, "caps: %" GST_PTR_FORMAT, incaps);
+
+  GST_OBJECT_LOCK (overlay);
+  /* negative offsets depend on the video size */
+  overlay->update_composition = TRUE;
+  overlay->attach_meta = FALSE;
+  overlay->meta_query_pending = TRUE;
+  GST_OBJECT_UNLOCK (overlay);
+
   return TRUE;
 }
 
+/* we transform in place and so don't get to see the allocation query
+ * answer, ask downstream ourselves whether it can render the overlay */
+static gboolean
+gst_gdk_pixbuf_overlay_query_downstream (GstGdkPixbufOverlay * overlay)
+{
+  GstPad *srcpad = GST_BASE_TRANSFORM_SRC_PAD (overlay);
+  GstCaps *caps;
+  GstQuery *query;
+  gboolean res = FALSE;
+
+  caps = gst_pad_get_current_caps (srcpad);
+  if (caps == NULL)
+    return FALSE;
+
+  query = gst_query_new_allocation (caps, FALSE);
+  if (gst_pad_peer_query (srcpad, query))
+    res = gst_query_find_allocation_meta (query,
+        GST_VIDEO_OVERLAY_COMPOSITION_META_API_TYPE, NULL);
+  gst_query_unref (query);
+  gst_caps_unref (caps);
+
+  GST_DEBUG_OBJECT (overlay, "downstream %s overlay compositions",
+      res ? "renders" : "does not render");
+
+  return res;
+}
+
 static void
 gst_gdk_pixbuf_overlay_update_composition (GstGdkPixbufOverlay * overlay)
 {
   GstVideoOverlayComposition *comp;
   GstVideoOverlayRectangle *rect;
-  GstVideoMeta *overlay_meta;
+  gint image_width, image_height;
   gint x, y, width, height;
   gint video_width =
       GST_VIDEO_INFO_WIDTH (&GST_VIDEO_FILTER (overlay)->in_info);
@@ -456,30 +551,31 @@ gst_gdk_pixbuf_overlay_update_composition (GstGdkPixbufOverlay * overlay)
     overlay->comp = NULL;
   }
 
-  if (overlay->alpha == 0.0 || overlay->pixels == NULL)
+  if (overlay->alpha == 0.0 || overlay->pixbuf == NULL)
     return;
 
-  overlay_meta = gst_buffer_get_video_meta (overlay->pixels);
+  image_width = gdk_pixbuf_get_width (overlay->pixbuf);
+  image_height = gdk_pixbuf_get_height (overlay->pixbuf);
 
   x = overlay->offset_x < 0 ?
-      video_width + overlay->offset_x - overlay_meta->width +
-      (overlay->relative_x * overlay_meta->width) :
-      overlay->offset_x + (overlay->relative_x * overlay_meta->width);
+      video_width + overlay->offset_x - image_width +
+      (overlay->relative_x * image_width) :
+      overlay->offset_x + (overlay->relative_x * image_width);
   y = overlay->offset_y < 0 ?
-      video_height + overlay->offset_y - overlay_meta->height +
-      (overlay->relative_y * overlay_meta->height) :
-      overlay->offset_y + (overlay->relative_y * overlay_meta->height);
+      video_height + overlay->offset_y - image_height +
+      (overlay->relative_y * image_height) :
+      overlay->offset_y + (overlay->relative_y * image_height);
 
   width = overlay->overlay_width;
   if (width == 0)
-    width = overlay_meta->width;
+    width = image_width;
 
   height = overlay->overlay_height;
   if (height == 0)
-    height = overlay_meta->height;
+    height = image_height;
 
   GST_DEBUG_OBJECT (overlay, "overlay image dimensions: %d x %d, alpha=%.2f",
-      overlay_meta->width, overlay_meta->height, overlay->alpha);
+      image_width, image_height, overlay->alpha);
   GST_DEBUG_OBJECT (overlay, "properties: x,y: %d,%d (%g%%,%g%%) - WxH: %dx%d",
       overlay->offset_x, overlay->offset_y,
       overlay->relative_x * 100.0, overlay->relative_y * 100.0,
@@ -487,6 +583,11 @@ gst_gdk_pixbuf_overlay_update_composition (GstGdkPixbufOverlay * overlay)
   GST_DEBUG_OBJECT (overlay, "overlay rendered: %d x %d @ %d,%d (onto %d x %d)",
       width, height, x, y, video_width, video_height);
 
+  /* scale once here instead of in every blend */
+  gst_gdk_pixbuf_overlay_make_pixels (overlay, width, height);
+  if (overlay->pixels == NULL)
+    return;
+
   rect = gst_video_overlay_rectangle_new_raw (overlay->pixels,
       x, y, width, height, GST_VIDEO_OVERLAY_FORMAT_FLAG_NONE);
 
@@ -517,6 +618,9 @@ gst_gdk_pixbuf_overlay_transform_frame_ip (GstVideoFilter * filter,
     GstVideoFrame * frame)
 {
   GstGdkPixbufOverlay *overlay = GST_GDK_PIXBUF_OVERLAY (filter);
+  GstVideoOverlayComposition *comp = NULL;
+  GstVideoOverlayCompositionMeta *meta;
+  gboolean attach_meta;
 
   GST_OBJECT_LOCK (overlay);
 
@@ -525,10 +629,43 @@ gst_gdk_pixbuf_overlay_transform_frame_ip (GstVideoFilter * filter,
     overlay->update_composition = FALSE;
   }
 
+  if (overlay->comp != NULL)
+    comp = gst_video_overlay_composition_ref (overlay->comp);
+
   GST_OBJECT_UNLOCK (overlay);
 
-  if (overlay->comp != NULL)
-    gst_video_overlay_composition_blend (overlay->comp, frame);
+  if (comp == NULL)
+    return GST_FLOW_OK;
+
+  if (G_UNLIKELY (overlay->meta_query_pending)) {
+    overlay->attach_meta = gst_gdk_pixbuf_overlay_query_downstream (overlay);
+    overlay->meta_query_pending = FALSE;
+  }
+  attach_meta = overlay->attach_meta;
+
+  if (!attach_meta) {
+    gst_video_overlay_composition_blend (comp, frame);
+    gst_video_overlay_composition_unref (comp);
+    return GST_FLOW_OK;
+  }
+
+  /* leave the rendering to downstream, on top of what an upstream overlay
+   * element may already have attached */
+  meta = gst_buffer_get_video_overlay_composition_meta (frame->buffer);
+  if (meta != NULL) {
+    GstVideoOverlayComposition *merged;
+
+    merged = gst_video_overlay_composition_copy (meta->overlay);
+    gst_video_overlay_composition_add_rectangle (merged,
+        gst_video_overlay_composition_get_rectangle (comp, 0));
+    gst_video_overlay_composition_unref (comp);
+    comp = merged;
+
+    gst_buffer_remove_meta (frame->buffer, (GstMeta *) meta);
+  }
+
+  gst_buffer_add_video_overlay_composition_meta (frame->buffer, comp);
+  gst_video_overlay_composition_unref (comp);
 
   return GST_FLOW_OK;
 }
@@ -60,13 +60,21 @@ struct _GstGdkPixbufOverlay
 
   gdouble                      alpha;
 
-  /* the loaded image, as BGRA/ARGB pixels, with GstVideoMeta */
+  /* the loaded image, as R-G-B-A with alpha */
+  GdkPixbuf                  * pixbuf;
+
+  /* the image scaled to the render size, as BGRA/ARGB pixels, with
+   * GstVideoMeta, so that blending does not need to rescale every frame */
   GstBuffer                  * pixels;
 
   GstVideoOverlayComposition * comp;
 
   /* render position or dimension has changed */
   gboolean                     update_composition;
+
+  /* downstream renders a GstVideoOverlayCompositionMeta for us */
+  gboolean                     attach_meta;
+  gboolean                     meta_query_pending;
 };
 
 struct _GstGdkPixbufOverlayClass
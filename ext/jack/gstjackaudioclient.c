@@ -146,7 +146,17 @@ jack_process_cb (jack_nframes_t nframes, void *arg)
         g_list_length (conn->src_clients), g_list_length (conn->sink_clients));
   }
 
-  g_mutex_lock (&conn->lock);
+  /* This runs in the jack realtime thread, which must not block. The lock is
+   * only held by other threads for short moments while clients are added,
+   * removed or (de)activated, or while waiting for a client to be flushed,
+   * during which the condition wait releases it. If it is taken right now
+   * this period is skipped rather than waited for, the next one will run
+   * the clients again. */
+  if (!g_mutex_trylock (&conn->lock)) {
+    GST_LOG ("clients are being changed, skipping period");
+    return 0;
+  }
+
   /* call sources first, then sinks. Sources will either push data into the
    * ringbuffer of the sinks, which will then pull the data out of it, or
    * sinks will pull the data from the sources. */
@@ -66,6 +66,7 @@
 
 #include "gstjackaudiosink.h"
 #include "gstjackringbuffer.h"
+#include "gstjackutil.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_jack_audio_sink_debug);
 #define GST_CAT_DEFAULT gst_jack_audio_sink_debug
@@ -190,7 +191,7 @@ jack_process_cb (jack_nframes_t nframes, void *arg)
   GstAudioRingBuffer *buf;
   gint readseg, len;
   guint8 *readptr;
-  gint i, j, flen, channels;
+  gint i, flen, channels;
   sample_t *data;
 
   buf = GST_AUDIO_RING_BUFFER_CAST (arg);
@@ -217,11 +218,7 @@ jack_process_cb (jack_nframes_t nframes, void *arg)
 
     /* the samples in the ringbuffer have the channels interleaved, we need to
      * deinterleave into the jack target buffers */
-    for (i = 0; i < nframes; i++) {
-      for (j = 0; j < channels; j++) {
-        sink->buffers[j][i] = *data++;
-      }
-    }
+    gst_jack_deinterleave (sink->buffers, data, channels, nframes);
 
     /* clear written samples in the ringbuffer */
     gst_audio_ring_buffer_clear (buf, readseg);
@@ -211,7 +211,7 @@ jack_process_cb (jack_nframes_t nframes, void *arg)
   gint len;
   guint8 *writeptr;
   gint writeseg;
-  gint channels, i, j, flen;
+  gint channels, i, flen;
   sample_t *data;
 
   buf = GST_AUDIO_RING_BUFFER_CAST (arg);
@@ -234,9 +234,7 @@ jack_process_cb (jack_nframes_t nframes, void *arg)
     /* the samples in the jack input buffers have to be interleaved into the
      * ringbuffer */
     data = (sample_t *) writeptr;
-    for (i = 0; i < nframes; ++i)
-      for (j = 0; j < channels; ++j)
-        *data++ = src->buffers[j][i];
+    gst_jack_interleave (data, src->buffers, channels, nframes);
 
     GST_DEBUG ("copy %d frames: %p, %d bytes, %d channels", nframes, writeptr,
         len / channels, channels);
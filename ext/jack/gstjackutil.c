@@ -19,6 +19,7 @@
 
 #include "gstjackutil.h"
 #include <gst/audio/audio.h>
+#include <string.h>
 
 static const GstAudioChannelPosition default_positions[8][8] = {
   /* 1 channel */
@@ -108,3 +109,98 @@ gst_jack_set_layout (GstAudioRingBuffer * buffer, GstAudioRingBufferSpec * spec)
   gst_caps_unref (spec->caps);
   spec->caps = gst_audio_info_to_caps (&spec->info);
 }
+
+/* Copying between the interleaved ringbuffer and the per-channel jack port
+ * buffers happens in the realtime thread. Mono is a plain copy and stereo has
+ * its own loop; other layouts are handled four channels at a time, so every
+ * frame is read as one contiguous run and written to four streams, which the
+ * compiler can vectorize. The remaining channels are copied one by one. */
+void
+gst_jack_deinterleave (sample_t ** dest, const sample_t * src, gint channels,
+    gint nframes)
+{
+  const sample_t *s;
+  sample_t *d0, *d1, *d2, *d3;
+  gint i, c;
+
+  if (channels == 1) {
+    memcpy (dest[0], src, nframes * sizeof (sample_t));
+    return;
+  }
+
+  if (channels == 2) {
+    d0 = dest[0];
+    d1 = dest[1];
+    for (i = 0; i < nframes; i++) {
+      d0[i] = src[2 * i];
+      d1[i] = src[2 * i + 1];
+    }
+    return;
+  }
+
+  for (c = 0; c + 4 <= channels; c += 4) {
+    d0 = dest[c];
+    d1 = dest[c + 1];
+    d2 = dest[c + 2];
+    d3 = dest[c + 3];
+    s = src + c;
+    for (i = 0; i < nframes; i++) {
+      d0[i] = s[0];
+      d1[i] = s[1];
+      d2[i] = s[2];
+      d3[i] = s[3];
+      s += channels;
+    }
+  }
+  for (; c < channels; c++) {
+    d0 = dest[c];
+    s = src + c;
+    for (i = 0; i < nframes; i++)
+      d0[i] = s[i * channels];
+  }
+}
+
+void
+gst_jack_interleave (sample_t * dest, sample_t ** src, gint channels,
+    gint nframes)
+{
+  const sample_t *s0, *s1, *s2, *s3;
+  sample_t *d;
+  gint i, c;
+
+  if (channels == 1) {
+    memcpy (dest, src[0], nframes * sizeof (sample_t));
+    return;
+  }
+
+  if (channels == 2) {
+    s0 = src[0];
+    s1 = src[1];
+    for (i = 0; i < nframes; i++) {
+      dest[2 * i] = s0[i];
+      dest[2 * i + 1] = s1[i];
+    }
+    return;
+  }
+
+  for (c = 0; c + 4 <= channels; c += 4) {
+    s0 = src[c];
+    s1 = src[c + 1];
+    s2 = src[c + 2];
+    s3 = src[c + 3];
+    d = dest + c;
+    for (i = 0; i < nframes; i++) {
+      d[0] = s0[i];
+      d[1] = s1[i];
+      d[2] = s2[i];
+      d[3] = s3[i];
+      d += channels;
+    }
+  }
+  for (; c < channels; c++) {
+    s0 = src[c];
+    d = dest + c;
+    for (i = 0; i < nframes; i++)
+      d[i * channels] = s0[i];
+  }
+}
@@ -25,7 +25,17 @@
 #include <gst/gst.h>
 #include <gst/audio/audio.h>
 
+#include "gstjack.h"
+
 void
 gst_jack_set_layout (GstAudioRingBuffer * buffer, GstAudioRingBufferSpec *spec);
 
+void
+gst_jack_deinterleave (sample_t ** dest, const sample_t * src, gint channels,
+    gint nframes);
+
+void
+gst_jack_interleave (sample_t * dest, sample_t ** src, gint channels,
+    gint nframes);
+
 #endif  // _GST_JACK_UTIL_H_
@@ -56,14 +56,45 @@
 
 #define JPEG_DEFAULT_IDCT_METHOD	JDCT_FASTEST
 #define JPEG_DEFAULT_MAX_ERRORS 	0
+#define JPEG_DEFAULT_N_THREADS		1
+#define JPEG_DEFAULT_MAX_PENDING_FRAMES	0
+#define JPEG_DEFAULT_SCALE_DENOMINATOR	1
+
+/* size of the IDCT output blocks of a component */
+#if JPEG_LIB_VERSION >= 70
+#define COMP_DCT_H_SCALED_SIZE(comp) ((comp)->DCT_h_scaled_size)
+#define COMP_DCT_V_SCALED_SIZE(comp) ((comp)->DCT_v_scaled_size)
+#else
+#define COMP_DCT_H_SCALED_SIZE(comp) ((comp)->DCT_scaled_size)
+#define COMP_DCT_V_SCALED_SIZE(comp) ((comp)->DCT_scaled_size)
+#endif
 
 enum
 {
   PROP_0,
   PROP_IDCT_METHOD,
-  PROP_MAX_ERRORS
+  PROP_MAX_ERRORS,
+  PROP_N_THREADS,
+  PROP_MAX_PENDING_FRAMES,
+  PROP_SCALE_DENOMINATOR
 };
 
+/* a frame decoded by one of the threads */
+typedef struct
+{
+  GstVideoCodecFrame *frame;
+  GstMapInfo map;
+  GstVideoFrame vframe;
+  gint idct_method;
+  guint scale_denom;
+
+  /* with lock */
+  gboolean done;
+
+  GstFlowReturn ret;
+  gchar *error;
+} GstJpegDecJob;
+
 /* *INDENT-OFF* */
 static GstStaticPadTemplate gst_jpeg_dec_src_pad_template =
 GST_STATIC_PAD_TEMPLATE ("src",
@@ -98,6 +129,7 @@ static gboolean gst_jpeg_dec_set_format (GstVideoDecoder * dec,
 static gboolean gst_jpeg_dec_start (GstVideoDecoder * bdec);
 static gboolean gst_jpeg_dec_stop (GstVideoDecoder * bdec);
 static gboolean gst_jpeg_dec_flush (GstVideoDecoder * bdec);
+static GstFlowReturn gst_jpeg_dec_finish (GstVideoDecoder * bdec);
 static GstFlowReturn gst_jpeg_dec_parse (GstVideoDecoder * bdec,
     GstVideoCodecFrame * frame, GstAdapter * adapter, gboolean at_eos);
 static GstFlowReturn gst_jpeg_dec_handle_frame (GstVideoDecoder * bdec,
@@ -105,6 +137,11 @@ static GstFlowReturn gst_jpeg_dec_handle_frame (GstVideoDecoder * bdec,
 static gboolean gst_jpeg_dec_decide_allocation (GstVideoDecoder * bdec,
     GstQuery * query);
 
+static void gst_jpeg_dec_context_init (GstJpegDec * dec,
+    GstJpegDecContext * ctx);
+static void gst_jpeg_dec_context_clear (GstJpegDecContext * ctx);
+static void gst_jpeg_dec_update_latency (GstJpegDec * dec);
+
 #define gst_jpeg_dec_parent_class parent_class
 G_DEFINE_TYPE (GstJpegDec, gst_jpeg_dec, GST_TYPE_VIDEO_DECODER);
 
@@ -113,10 +150,13 @@ gst_jpeg_dec_finalize (GObject * object)
 {
   GstJpegDec *dec = GST_JPEG_DEC (object);
 
-  jpeg_destroy_decompress (&dec->cinfo);
+  gst_jpeg_dec_context_clear (&dec->ctx);
   if (dec->input_state)
     gst_video_codec_state_unref (dec->input_state);
 
+  g_mutex_clear (&dec->lock);
+  g_cond_clear (&dec->cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -158,6 +198,55 @@ gst_jpeg_dec_class_init (GstJpegDecClass * klass)
           -1, G_MAXINT, JPEG_DEFAULT_MAX_ERRORS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstJpegDec:n-threads:
+   *
+   * Number of threads decoding frames at the same time. Frames are still
+   * output in order. 0 uses one thread per processor, 1 decodes in the
+   * streaming thread.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of frames decoded in parallel (0 = number of processors)",
+          0, G_MAXUINT, JPEG_DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstJpegDec:max-pending-frames:
+   *
+   * Number of frames that can still be decoding when a new frame comes in
+   * with more than one thread. This is the latency the decoder adds, in
+   * frames. 0 uses the number of threads.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_PENDING_FRAMES,
+      g_param_spec_uint ("max-pending-frames", "Maximum pending frames",
+          "Maximum number of frames being decoded while accepting a new one, "
+          "when using threads (0 = number of threads)",
+          0, G_MAXUINT, JPEG_DEFAULT_MAX_PENDING_FRAMES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstJpegDec:scale-denominator:
+   *
+   * Decode pictures at 1/scale-denominator of their size, the scaling is
+   * done by the IDCT and makes decoding a lot cheaper. Only 1, 2, 4 and 8
+   * are supported, other values are rounded down to one of those.
+   *
+   * Independent of this, pictures are scaled down further when downstream
+   * does not accept their size but accepts one of the smaller sizes.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_SCALE_DENOMINATOR,
+      g_param_spec_uint ("scale-denominator", "Scale denominator",
+          "Decode at 1/scale-denominator of the picture size (1, 2, 4 or 8)",
+          1, 8, JPEG_DEFAULT_SCALE_DENOMINATOR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&gst_jpeg_dec_src_pad_template));
   gst_element_class_add_pad_template (element_class,
@@ -169,6 +258,7 @@ gst_jpeg_dec_class_init (GstJpegDecClass * klass)
   vdec_class->start = gst_jpeg_dec_start;
   vdec_class->stop = gst_jpeg_dec_stop;
   vdec_class->flush = gst_jpeg_dec_flush;
+  vdec_class->finish = gst_jpeg_dec_finish;
   vdec_class->parse = gst_jpeg_dec_parse;
   vdec_class->set_format = gst_jpeg_dec_set_format;
   vdec_class->handle_frame = gst_jpeg_dec_handle_frame;
@@ -181,15 +271,13 @@ gst_jpeg_dec_class_init (GstJpegDecClass * klass)
 static boolean
 gst_jpeg_dec_fill_input_buffer (j_decompress_ptr cinfo)
 {
-  GstJpegDec *dec;
+  struct GstJpegDecSourceMgr *src = (struct GstJpegDecSourceMgr *) cinfo->src;
 
-  dec = CINFO_GET_JPEGDEC (cinfo);
-  g_return_val_if_fail (dec != NULL, FALSE);
-  g_return_val_if_fail (dec->current_frame != NULL, FALSE);
-  g_return_val_if_fail (dec->current_frame_map.data != NULL, FALSE);
+  g_return_val_if_fail (src->dec != NULL, FALSE);
+  g_return_val_if_fail (src->data != NULL, FALSE);
 
-  cinfo->src->next_input_byte = dec->current_frame_map.data;
-  cinfo->src->bytes_in_buffer = dec->current_frame_map.size;
+  cinfo->src->next_input_byte = src->data;
+  cinfo->src->bytes_in_buffer = src->size;
 
   return TRUE;
 }
@@ -250,32 +338,44 @@ METHODDEF (void)
   longjmp (err_mgr->setjmp_buffer, 1);
 }
 
+static void
+gst_jpeg_dec_context_init (GstJpegDec * dec, GstJpegDecContext * ctx)
+{
+  /* setup jpeglib */
+  memset (ctx, 0, sizeof (GstJpegDecContext));
+  ctx->cinfo.err = jpeg_std_error (&ctx->jerr.pub);
+  ctx->jerr.pub.output_message = gst_jpeg_dec_my_output_message;
+  ctx->jerr.pub.emit_message = gst_jpeg_dec_my_emit_message;
+  ctx->jerr.pub.error_exit = gst_jpeg_dec_my_error_exit;
+
+  jpeg_create_decompress (&ctx->cinfo);
+
+  ctx->cinfo.src = (struct jpeg_source_mgr *) &ctx->jsrc;
+  ctx->cinfo.src->init_source = gst_jpeg_dec_init_source;
+  ctx->cinfo.src->fill_input_buffer = gst_jpeg_dec_fill_input_buffer;
+  ctx->cinfo.src->skip_input_data = gst_jpeg_dec_skip_input_data;
+  ctx->cinfo.src->resync_to_restart = gst_jpeg_dec_resync_to_restart;
+  ctx->cinfo.src->term_source = gst_jpeg_dec_term_source;
+  ctx->jsrc.dec = dec;
+}
+
 static void
 gst_jpeg_dec_init (GstJpegDec * dec)
 {
   GST_DEBUG ("initializing");
 
-  /* setup jpeglib */
-  memset (&dec->cinfo, 0, sizeof (dec->cinfo));
-  memset (&dec->jerr, 0, sizeof (dec->jerr));
-  dec->cinfo.err = jpeg_std_error (&dec->jerr.pub);
-  dec->jerr.pub.output_message = gst_jpeg_dec_my_output_message;
-  dec->jerr.pub.emit_message = gst_jpeg_dec_my_emit_message;
-  dec->jerr.pub.error_exit = gst_jpeg_dec_my_error_exit;
-
-  jpeg_create_decompress (&dec->cinfo);
-
-  dec->cinfo.src = (struct jpeg_source_mgr *) &dec->jsrc;
-  dec->cinfo.src->init_source = gst_jpeg_dec_init_source;
-  dec->cinfo.src->fill_input_buffer = gst_jpeg_dec_fill_input_buffer;
-  dec->cinfo.src->skip_input_data = gst_jpeg_dec_skip_input_data;
-  dec->cinfo.src->resync_to_restart = gst_jpeg_dec_resync_to_restart;
-  dec->cinfo.src->term_source = gst_jpeg_dec_term_source;
-  dec->jsrc.dec = dec;
+  gst_jpeg_dec_context_init (dec, &dec->ctx);
+
+  g_mutex_init (&dec->lock);
+  g_cond_init (&dec->cond);
+  g_queue_init (&dec->jobs);
 
   /* init properties */
   dec->idct_method = JPEG_DEFAULT_IDCT_METHOD;
   dec->max_errors = JPEG_DEFAULT_MAX_ERRORS;
+  dec->n_threads = JPEG_DEFAULT_N_THREADS;
+  dec->max_pending_frames = JPEG_DEFAULT_MAX_PENDING_FRAMES;
+  dec->scale_denom = JPEG_DEFAULT_SCALE_DENOMINATOR;
 }
 
 static inline gboolean
@@ -607,6 +707,9 @@ gst_jpeg_dec_set_format (GstVideoDecoder * dec, GstVideoCodecState * state)
     gst_video_codec_state_unref (jpeg->input_state);
   jpeg->input_state = gst_video_codec_state_ref (state);
 
+  if (jpeg->max_pending > 0)
+    gst_jpeg_dec_update_latency (jpeg);
+
   return TRUE;
 }
 
@@ -627,50 +730,76 @@ hresamplecpy1 (guint8 * dest, const guint8 * src, guint len)
 }
 
 static void
-gst_jpeg_dec_free_buffers (GstJpegDec * dec)
+gst_jpeg_dec_free_buffers (GstJpegDecContext * ctx)
 {
   gint i;
 
   for (i = 0; i < 16; i++) {
-    g_free (dec->idr_y[i]);
-    g_free (dec->idr_u[i]);
-    g_free (dec->idr_v[i]);
-    dec->idr_y[i] = NULL;
-    dec->idr_u[i] = NULL;
-    dec->idr_v[i] = NULL;
+    g_free (ctx->idr_y[i]);
+    g_free (ctx->idr_u[i]);
+    g_free (ctx->idr_v[i]);
+    ctx->idr_y[i] = NULL;
+    ctx->idr_u[i] = NULL;
+    ctx->idr_v[i] = NULL;
   }
 
-  dec->idr_width_allocated = 0;
+  ctx->idr_width_allocated = 0;
+}
+
+static void
+gst_jpeg_dec_context_clear (GstJpegDecContext * ctx)
+{
+  jpeg_destroy_decompress (&ctx->cinfo);
+  gst_jpeg_dec_free_buffers (ctx);
 }
 
 static inline gboolean
-gst_jpeg_dec_ensure_buffers (GstJpegDec * dec, guint maxrowbytes)
+gst_jpeg_dec_ensure_buffers (GstJpegDecContext * ctx, guint maxrowbytes)
 {
+  GstJpegDec *dec = ctx->jsrc.dec;
   gint i;
 
-  if (G_LIKELY (dec->idr_width_allocated == maxrowbytes))
+  if (G_LIKELY (ctx->idr_width_allocated == maxrowbytes))
     return TRUE;
 
   /* FIXME: maybe just alloc one or three blocks altogether? */
   for (i = 0; i < 16; i++) {
-    dec->idr_y[i] = g_try_realloc (dec->idr_y[i], maxrowbytes);
-    dec->idr_u[i] = g_try_realloc (dec->idr_u[i], maxrowbytes);
-    dec->idr_v[i] = g_try_realloc (dec->idr_v[i], maxrowbytes);
+    ctx->idr_y[i] = g_try_realloc (ctx->idr_y[i], maxrowbytes);
+    ctx->idr_u[i] = g_try_realloc (ctx->idr_u[i], maxrowbytes);
+    ctx->idr_v[i] = g_try_realloc (ctx->idr_v[i], maxrowbytes);
 
-    if (G_UNLIKELY (!dec->idr_y[i] || !dec->idr_u[i] || !dec->idr_v[i])) {
+    if (G_UNLIKELY (!ctx->idr_y[i] || !ctx->idr_u[i] || !ctx->idr_v[i])) {
       GST_WARNING_OBJECT (dec, "out of memory, i=%d, bytes=%u", i, maxrowbytes);
       return FALSE;
     }
   }
 
-  dec->idr_width_allocated = maxrowbytes;
+  ctx->idr_width_allocated = maxrowbytes;
   GST_LOG_OBJECT (dec, "allocated temp memory, %u bytes/row", maxrowbytes);
   return TRUE;
 }
 
+/* bytes jpeglib writes to a row of indirect decoding, which is more than
+ * width when it outputs whole blocks */
+static guint
+gst_jpeg_dec_get_row_bytes (GstJpegDecContext * ctx, gint width)
+{
+  guint i, bytes = width;
+
+  for (i = 0; i < ctx->cinfo.num_components; i++) {
+    jpeg_component_info *comp = &ctx->cinfo.comp_info[i];
+
+    bytes = MAX (bytes, GST_ROUND_UP_N (comp->width_in_blocks,
+            comp->h_samp_factor) * COMP_DCT_H_SCALED_SIZE (comp));
+  }
+
+  return GST_ROUND_UP_32 (bytes);
+}
+
 static void
-gst_jpeg_dec_decode_grayscale (GstJpegDec * dec, GstVideoFrame * frame)
+gst_jpeg_dec_decode_grayscale (GstJpegDecContext * ctx, GstVideoFrame * frame)
 {
+  GstJpegDec *dec = ctx->jsrc.dec;
   guchar *rows[16];
   guchar **scanarray[1] = { rows };
   gint i, j, k;
@@ -684,20 +813,21 @@ gst_jpeg_dec_decode_grayscale (GstJpegDec * dec, GstVideoFrame * frame)
   width = GST_VIDEO_FRAME_WIDTH (frame);
   height = GST_VIDEO_FRAME_HEIGHT (frame);
 
-  if (G_UNLIKELY (!gst_jpeg_dec_ensure_buffers (dec, GST_ROUND_UP_32 (width))))
+  if (G_UNLIKELY (!gst_jpeg_dec_ensure_buffers (ctx,
+              gst_jpeg_dec_get_row_bytes (ctx, width))))
     return;
 
   base[0] = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
   pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 0);
   rstride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
 
-  memcpy (rows, dec->idr_y, 16 * sizeof (gpointer));
+  memcpy (rows, ctx->idr_y, 16 * sizeof (gpointer));
 
   i = 0;
   while (i < height) {
-    lines = jpeg_read_raw_data (&dec->cinfo, scanarray, DCTSIZE);
+    lines = jpeg_read_raw_data (&ctx->cinfo, scanarray, DCTSIZE);
     if (G_LIKELY (lines > 0)) {
-      for (j = 0; (j < DCTSIZE) && (i < height); j++, i++) {
+      for (j = 0; (j < lines) && (i < height); j++, i++) {
         gint p;
 
         p = 0;
@@ -714,8 +844,9 @@ gst_jpeg_dec_decode_grayscale (GstJpegDec * dec, GstVideoFrame * frame)
 }
 
 static void
-gst_jpeg_dec_decode_rgb (GstJpegDec * dec, GstVideoFrame * frame)
+gst_jpeg_dec_decode_rgb (GstJpegDecContext * ctx, GstVideoFrame * frame)
 {
+  GstJpegDec *dec = ctx->jsrc.dec;
   guchar *r_rows[16], *g_rows[16], *b_rows[16];
   guchar **scanarray[3] = { r_rows, g_rows, b_rows };
   gint i, j, k;
@@ -729,7 +860,8 @@ gst_jpeg_dec_decode_rgb (GstJpegDec * dec, GstVideoFrame * frame)
   width = GST_VIDEO_FRAME_WIDTH (frame);
   height = GST_VIDEO_FRAME_HEIGHT (frame);
 
-  if (G_UNLIKELY (!gst_jpeg_dec_ensure_buffers (dec, GST_ROUND_UP_32 (width))))
+  if (G_UNLIKELY (!gst_jpeg_dec_ensure_buffers (ctx,
+              gst_jpeg_dec_get_row_bytes (ctx, width))))
     return;
 
   for (i = 0; i < 3; i++)
@@ -738,15 +870,15 @@ gst_jpeg_dec_decode_rgb (GstJpegDec * dec, GstVideoFrame * frame)
   pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 0);
   rstride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
 
-  memcpy (r_rows, dec->idr_y, 16 * sizeof (gpointer));
-  memcpy (g_rows, dec->idr_u, 16 * sizeof (gpointer));
-  memcpy (b_rows, dec->idr_v, 16 * sizeof (gpointer));
+  memcpy (r_rows, ctx->idr_y, 16 * sizeof (gpointer));
+  memcpy (g_rows, ctx->idr_u, 16 * sizeof (gpointer));
+  memcpy (b_rows, ctx->idr_v, 16 * sizeof (gpointer));
 
   i = 0;
   while (i < height) {
-    lines = jpeg_read_raw_data (&dec->cinfo, scanarray, DCTSIZE);
+    lines = jpeg_read_raw_data (&ctx->cinfo, scanarray, DCTSIZE);
     if (G_LIKELY (lines > 0)) {
-      for (j = 0; (j < DCTSIZE) && (i < height); j++, i++) {
+      for (j = 0; (j < lines) && (i < height); j++, i++) {
         gint p;
 
         p = 0;
@@ -767,9 +899,10 @@ gst_jpeg_dec_decode_rgb (GstJpegDec * dec, GstVideoFrame * frame)
 }
 
 static void
-gst_jpeg_dec_decode_indirect (GstJpegDec * dec, GstVideoFrame * frame, gint r_v,
-    gint r_h, gint comp)
+gst_jpeg_dec_decode_indirect (GstJpegDecContext * ctx, GstVideoFrame * frame,
+    gint r_v, gint r_h, gint comp)
 {
+  GstJpegDec *dec = ctx->jsrc.dec;
   guchar *y_rows[16], *u_rows[16], *v_rows[16];
   guchar **scanarray[3] = { y_rows, u_rows, v_rows };
   gint i, j, k;
@@ -784,7 +917,8 @@ gst_jpeg_dec_decode_indirect (GstJpegDec * dec, GstVideoFrame * frame, gint r_v,
   width = GST_VIDEO_FRAME_WIDTH (frame);
   height = GST_VIDEO_FRAME_HEIGHT (frame);
 
-  if (G_UNLIKELY (!gst_jpeg_dec_ensure_buffers (dec, GST_ROUND_UP_32 (width))))
+  if (G_UNLIKELY (!gst_jpeg_dec_ensure_buffers (ctx,
+              gst_jpeg_dec_get_row_bytes (ctx, width))))
     return;
 
   for (i = 0; i < 3; i++) {
@@ -796,9 +930,9 @@ gst_jpeg_dec_decode_indirect (GstJpegDec * dec, GstVideoFrame * frame, gint r_v,
         (GST_VIDEO_FRAME_COMP_HEIGHT (frame, i) - 1));
   }
 
-  memcpy (y_rows, dec->idr_y, 16 * sizeof (gpointer));
-  memcpy (u_rows, dec->idr_u, 16 * sizeof (gpointer));
-  memcpy (v_rows, dec->idr_v, 16 * sizeof (gpointer));
+  memcpy (y_rows, ctx->idr_y, 16 * sizeof (gpointer));
+  memcpy (u_rows, ctx->idr_u, 16 * sizeof (gpointer));
+  memcpy (v_rows, ctx->idr_v, 16 * sizeof (gpointer));
 
   /* fill chroma components for grayscale */
   if (comp == 1) {
@@ -810,7 +944,7 @@ gst_jpeg_dec_decode_indirect (GstJpegDec * dec, GstVideoFrame * frame, gint r_v,
   }
 
   for (i = 0; i < height; i += r_v * DCTSIZE) {
-    lines = jpeg_read_raw_data (&dec->cinfo, scanarray, r_v * DCTSIZE);
+    lines = jpeg_read_raw_data (&ctx->cinfo, scanarray, r_v * DCTSIZE);
     if (G_LIKELY (lines > 0)) {
       for (j = 0, k = 0; j < (r_v * DCTSIZE); j += r_v, k++) {
         if (G_LIKELY (base[0] <= last[0])) {
@@ -846,9 +980,83 @@ gst_jpeg_dec_decode_indirect (GstJpegDec * dec, GstVideoFrame * frame, gint r_v,
   }
 }
 
+/* With IDCT scaling jpeglib decodes the chroma components at a size that
+ * depends on the scale, up to the size of the luma. The rows and columns
+ * of the I420 planes are picked from the components here. */
+static void
+gst_jpeg_dec_decode_scaled (GstJpegDecContext * ctx, GstVideoFrame * frame)
+{
+  GstJpegDec *dec = ctx->jsrc.dec;
+  guchar *y_rows[16], *u_rows[16], *v_rows[16];
+  guchar **scanarray[3] = { y_rows, u_rows, v_rows };
+  guchar **rows;
+  gint c, i, lines, first, sub;
+  guint8 *base;
+  gint stride, width, height, comp_width, comp_height;
+  gint out_width = ctx->cinfo.output_width;
+  gint out_height = ctx->cinfo.output_height;
+  gint next[3] = { 0, 0, 0 };
+
+  GST_DEBUG_OBJECT (dec, "decoding at 1/%u scale", ctx->cinfo.scale_denom);
+
+  if (G_UNLIKELY (!gst_jpeg_dec_ensure_buffers (ctx,
+              gst_jpeg_dec_get_row_bytes (ctx,
+                  GST_VIDEO_FRAME_WIDTH (frame)))))
+    return;
+
+  memcpy (y_rows, ctx->idr_y, 16 * sizeof (gpointer));
+  memcpy (u_rows, ctx->idr_u, 16 * sizeof (gpointer));
+  memcpy (v_rows, ctx->idr_v, 16 * sizeof (gpointer));
+
+  while (ctx->cinfo.output_scanline < ctx->cinfo.output_height) {
+    lines = jpeg_read_raw_data (&ctx->cinfo, scanarray, 2 * DCTSIZE);
+    if (G_UNLIKELY (lines == 0)) {
+      GST_INFO_OBJECT (dec, "jpeg_read_raw_data() returned 0");
+      break;
+    }
+
+    for (c = 0; c < 3; c++) {
+      jpeg_component_info *comp = &ctx->cinfo.comp_info[c];
+      gint comp_lines = comp->v_samp_factor * COMP_DCT_V_SCALED_SIZE (comp);
+
+      rows = scanarray[c];
+      base = GST_VIDEO_FRAME_COMP_DATA (frame, c);
+      stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, c);
+      width = GST_VIDEO_FRAME_COMP_WIDTH (frame, c);
+      height = GST_VIDEO_FRAME_COMP_HEIGHT (frame, c);
+      comp_width = MAX (comp->downsampled_width, 1);
+      comp_height = MAX (comp->downsampled_height, 1);
+      /* the I420 chroma planes are subsampled by 2 */
+      sub = c == 0 ? 1 : 2;
+
+      /* first row of the component in this call */
+      first = (ctx->cinfo.output_scanline - lines) * comp_lines / lines;
+
+      /* row of the component at the first picture row of the plane row */
+      for (; next[c] < height; next[c]++) {
+        gint row = next[c] * sub * comp_height / out_height - first;
+        guint8 *dest = base + next[c] * stride;
+
+        if (row >= comp_lines)
+          break;
+
+        if (comp_width * sub == out_width || comp_width == width) {
+          memcpy (dest, rows[row], width);
+        } else if (comp_width == out_width) {
+          hresamplecpy1 (dest, rows[row], width);
+        } else {
+          for (i = 0; i < width; i++)
+            dest[i] = rows[row][i * sub * comp_width / out_width];
+        }
+      }
+    }
+  }
+}
+
 static GstFlowReturn
-gst_jpeg_dec_decode_direct (GstJpegDec * dec, GstVideoFrame * frame)
+gst_jpeg_dec_decode_direct (GstJpegDecContext * ctx, GstVideoFrame * frame)
 {
+  GstJpegDec *dec = ctx->jsrc.dec;
   guchar **line[3];             /* the jpeg line buffer         */
   guchar *y[4 * DCTSIZE] = { NULL, };   /* alloc enough for the lines   */
   guchar *u[4 * DCTSIZE] = { NULL, };   /* r_v will be <4               */
@@ -863,9 +1071,9 @@ gst_jpeg_dec_decode_direct (GstJpegDec * dec, GstVideoFrame * frame)
   line[1] = u;
   line[2] = v;
 
-  v_samp[0] = dec->cinfo.comp_info[0].v_samp_factor;
-  v_samp[1] = dec->cinfo.comp_info[1].v_samp_factor;
-  v_samp[2] = dec->cinfo.comp_info[2].v_samp_factor;
+  v_samp[0] = ctx->cinfo.comp_info[0].v_samp_factor;
+  v_samp[1] = ctx->cinfo.comp_info[1].v_samp_factor;
+  v_samp[2] = ctx->cinfo.comp_info[2].v_samp_factor;
 
   if (G_UNLIKELY (v_samp[0] > 2 || v_samp[1] > 2 || v_samp[2] > 2))
     goto format_not_supported;
@@ -908,7 +1116,7 @@ gst_jpeg_dec_decode_direct (GstJpegDec * dec, GstVideoFrame * frame)
         line[2][j] = last[2];
     }
 
-    lines = jpeg_read_raw_data (&dec->cinfo, line, v_samp[0] * DCTSIZE);
+    lines = jpeg_read_raw_data (&ctx->cinfo, line, v_samp[0] * DCTSIZE);
     if (G_UNLIKELY (!lines)) {
       GST_INFO_OBJECT (dec, "jpeg_read_raw_data() returned 0");
     }
@@ -928,6 +1136,81 @@ format_not_supported:
   }
 }
 
+static GstVideoFormat
+gst_jpeg_dec_get_format (gint clrspc)
+{
+  switch (clrspc) {
+    case JCS_RGB:
+      return GST_VIDEO_FORMAT_RGB;
+    case JCS_GRAYSCALE:
+      return GST_VIDEO_FORMAT_GRAY8;
+    default:
+      return GST_VIDEO_FORMAT_I420;
+  }
+}
+
+/* picks the scale denominator for the picture of which the header was read,
+ * starting from the configured one and going down until downstream accepts
+ * the size */
+static guint
+gst_jpeg_dec_choose_scale (GstJpegDec * dec, GstJpegDecContext * ctx)
+{
+  GstCaps *peercaps, *caps;
+  const gchar *format;
+  guint denom, d;
+  gint width, height;
+
+  GST_OBJECT_LOCK (dec);
+  denom = dec->scale_denom;
+  GST_OBJECT_UNLOCK (dec);
+
+  /* only powers of two are supported by all libjpeg versions */
+  while (denom & (denom - 1))
+    denom &= denom - 1;
+
+  width = ctx->cinfo.image_width;
+  height = ctx->cinfo.image_height;
+
+  if (dec->scale_width == width && dec->scale_height == height &&
+      dec->scale_clrspc == ctx->cinfo.jpeg_color_space &&
+      dec->scale_requested == denom)
+    return dec->scale_chosen;
+
+  dec->scale_width = width;
+  dec->scale_height = height;
+  dec->scale_clrspc = ctx->cinfo.jpeg_color_space;
+  dec->scale_requested = denom;
+
+  peercaps = gst_pad_peer_query_caps (GST_VIDEO_DECODER_SRC_PAD (dec), NULL);
+  if (peercaps && !gst_caps_is_any (peercaps)) {
+    format = gst_video_format_to_string (gst_jpeg_dec_get_format
+        (ctx->cinfo.jpeg_color_space));
+
+    for (d = denom; d <= 8; d *= 2) {
+      gboolean accepted;
+
+      caps = gst_caps_new_simple ("video/x-raw",
+          "format", G_TYPE_STRING, format,
+          "width", G_TYPE_INT, (width + d - 1) / d,
+          "height", G_TYPE_INT, (height + d - 1) / d, NULL);
+      accepted = gst_caps_can_intersect (caps, peercaps);
+      gst_caps_unref (caps);
+
+      if (accepted) {
+        denom = d;
+        break;
+      }
+    }
+  }
+  if (peercaps)
+    gst_caps_unref (peercaps);
+
+  GST_DEBUG_OBJECT (dec, "decoding %dx%d at 1/%u scale", width, height, denom);
+  dec->scale_chosen = denom;
+
+  return denom;
+}
+
 static void
 gst_jpeg_dec_negotiate (GstJpegDec * dec, gint width, gint height, gint clrspc)
 {
@@ -935,17 +1218,7 @@ gst_jpeg_dec_negotiate (GstJpegDec * dec, gint width, gint height, gint clrspc)
   GstVideoInfo *info;
   GstVideoFormat format;
 
-  switch (clrspc) {
-    case JCS_RGB:
-      format = GST_VIDEO_FORMAT_RGB;
-      break;
-    case JCS_GRAYSCALE:
-      format = GST_VIDEO_FORMAT_GRAY8;
-      break;
-    default:
-      format = GST_VIDEO_FORMAT_I420;
-      break;
-  }
+  format = gst_jpeg_dec_get_format (clrspc);
 
   /* Compare to currently configured output state */
   outstate = gst_video_decoder_get_output_state (GST_VIDEO_DECODER (dec));
@@ -981,8 +1254,276 @@ gst_jpeg_dec_negotiate (GstJpegDec * dec, gint width, gint height, gint clrspc)
 
   gst_video_decoder_negotiate (GST_VIDEO_DECODER (dec));
 
-  GST_DEBUG_OBJECT (dec, "max_v_samp_factor=%d", dec->cinfo.max_v_samp_factor);
-  GST_DEBUG_OBJECT (dec, "max_h_samp_factor=%d", dec->cinfo.max_h_samp_factor);
+  GST_DEBUG_OBJECT (dec, "max_v_samp_factor=%d",
+      dec->ctx.cinfo.max_v_samp_factor);
+  GST_DEBUG_OBJECT (dec, "max_h_samp_factor=%d",
+      dec->ctx.cinfo.max_h_samp_factor);
+}
+
+/* set up the decompression for raw output */
+static void
+gst_jpeg_dec_prepare_decompress (j_decompress_ptr cinfo, gint idct_method,
+    guint scale_denom)
+{
+  cinfo->scale_num = 1;
+  cinfo->scale_denom = scale_denom;
+  cinfo->do_fancy_upsampling = FALSE;
+  cinfo->do_block_smoothing = FALSE;
+  cinfo->out_color_space = cinfo->jpeg_color_space;
+  cinfo->dct_method = idct_method;
+  cinfo->raw_data_out = TRUE;
+}
+
+/* decodes the picture of a started decompression into frame */
+static GstFlowReturn
+gst_jpeg_dec_decode_image (GstJpegDecContext * ctx, GstVideoFrame * frame)
+{
+  GstJpegDec *dec = ctx->jsrc.dec;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gint width = GST_VIDEO_FRAME_WIDTH (frame);
+  gint r_h, r_v;
+
+  r_h = ctx->cinfo.comp_info[0].h_samp_factor;
+  r_v = ctx->cinfo.comp_info[0].v_samp_factor;
+
+  if (ctx->cinfo.jpeg_color_space == JCS_RGB) {
+    gst_jpeg_dec_decode_rgb (ctx, frame);
+  } else if (ctx->cinfo.jpeg_color_space == JCS_GRAYSCALE) {
+    gst_jpeg_dec_decode_grayscale (ctx, frame);
+  } else if (ctx->cinfo.scale_denom > ctx->cinfo.scale_num) {
+    gst_jpeg_dec_decode_scaled (ctx, frame);
+  } else {
+    GST_LOG_OBJECT (dec, "decompressing (reqired scanline buffer height = %u)",
+        ctx->cinfo.rec_outbuf_height);
+
+    /* For some widths jpeglib requires more horizontal padding than I420 
+     * provides. In those cases we need to decode into separate buffers and then
+     * copy over the data into our final picture buffer, otherwise jpeglib might
+     * write over the end of a line into the beginning of the next line,
+     * resulting in blocky artifacts on the left side of the picture. */
+    if (G_UNLIKELY (width % (ctx->cinfo.max_h_samp_factor * DCTSIZE) != 0
+            || ctx->cinfo.comp_info[0].h_samp_factor != 2
+            || ctx->cinfo.comp_info[1].h_samp_factor != 1
+            || ctx->cinfo.comp_info[2].h_samp_factor != 1)) {
+      GST_CAT_LOG_OBJECT (GST_CAT_PERFORMANCE, dec,
+          "indirect decoding using extra buffer copy");
+      gst_jpeg_dec_decode_indirect (ctx, frame, r_v, r_h,
+          ctx->cinfo.num_components);
+    } else {
+      ret = gst_jpeg_dec_decode_direct (ctx, frame);
+    }
+  }
+
+  return ret;
+}
+
+/* runs in the thread pool, the header of the job was already checked by
+ * handle_frame with the element context */
+static void
+gst_jpeg_dec_decode_job (GstJpegDecJob * job, GstJpegDec * dec)
+{
+  GstJpegDecContext *ctx = NULL;
+
+  g_mutex_lock (&dec->lock);
+  if (dec->free_contexts) {
+    ctx = dec->free_contexts->data;
+    dec->free_contexts =
+        g_slist_delete_link (dec->free_contexts, dec->free_contexts);
+  }
+  g_mutex_unlock (&dec->lock);
+
+  if (ctx == NULL) {
+    ctx = g_slice_new (GstJpegDecContext);
+    gst_jpeg_dec_context_init (dec, ctx);
+  }
+
+  ctx->jsrc.data = job->map.data;
+  ctx->jsrc.size = job->map.size;
+  gst_jpeg_dec_fill_input_buffer (&ctx->cinfo);
+
+  if (setjmp (ctx->jerr.setjmp_buffer)) {
+    gchar err_msg[JMSG_LENGTH_MAX];
+
+    ctx->jerr.pub.format_message ((j_common_ptr) (&ctx->cinfo), err_msg);
+    job->error = g_strdup_printf ("Decode error #%u: %s",
+        ctx->jerr.pub.msg_code, err_msg);
+    jpeg_abort_decompress (&ctx->cinfo);
+    goto done;
+  }
+
+  jpeg_read_header (&ctx->cinfo, TRUE);
+  gst_jpeg_dec_prepare_decompress (&ctx->cinfo, job->idct_method,
+      job->scale_denom);
+  guarantee_huff_tables (&ctx->cinfo);
+  jpeg_start_decompress (&ctx->cinfo);
+
+  job->ret = gst_jpeg_dec_decode_image (ctx, &job->vframe);
+  if (job->ret == GST_FLOW_OK)
+    jpeg_finish_decompress (&ctx->cinfo);
+  else
+    jpeg_abort_decompress (&ctx->cinfo);
+
+done:
+  g_mutex_lock (&dec->lock);
+  dec->free_contexts = g_slist_prepend (dec->free_contexts, ctx);
+  job->done = TRUE;
+  g_cond_broadcast (&dec->cond);
+  g_mutex_unlock (&dec->lock);
+}
+
+static GstFlowReturn
+gst_jpeg_dec_finish_job (GstJpegDec * dec, GstJpegDecJob * job)
+{
+  GstVideoDecoder *bdec = GST_VIDEO_DECODER (dec);
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  gst_video_frame_unmap (&job->vframe);
+  gst_buffer_unmap (job->frame->input_buffer, &job->map);
+
+  if (job->error) {
+    GST_VIDEO_DECODER_ERROR (dec, 1, STREAM, DECODE,
+        (_("Failed to decode JPEG image")), ("%s", job->error), ret);
+    gst_video_decoder_drop_frame (bdec, job->frame);
+  } else if (job->ret != GST_FLOW_OK) {
+    /* already posted an error message */
+    ret = job->ret;
+    gst_video_decoder_drop_frame (bdec, job->frame);
+  } else {
+    ret = gst_video_decoder_finish_frame (bdec, job->frame);
+  }
+
+  g_free (job->error);
+  g_slice_free (GstJpegDecJob, job);
+
+  return ret;
+}
+
+/* outputs the decoded frames in order, waiting for the oldest ones until
+ * at most max_pending frames are left */
+static GstFlowReturn
+gst_jpeg_dec_push_jobs (GstJpegDec * dec, guint max_pending)
+{
+  GstJpegDecJob *job;
+  GstFlowReturn ret = GST_FLOW_OK, res;
+
+  g_mutex_lock (&dec->lock);
+  while ((job = g_queue_peek_head (&dec->jobs))) {
+    if (!job->done) {
+      if (g_queue_get_length (&dec->jobs) <= max_pending)
+        break;
+      g_cond_wait (&dec->cond, &dec->lock);
+      continue;
+    }
+    g_queue_pop_head (&dec->jobs);
+    g_mutex_unlock (&dec->lock);
+
+    res = gst_jpeg_dec_finish_job (dec, job);
+    if (ret == GST_FLOW_OK)
+      ret = res;
+
+    g_mutex_lock (&dec->lock);
+  }
+  g_mutex_unlock (&dec->lock);
+
+  return ret;
+}
+
+/* waits for the pending frames and throws them away */
+static void
+gst_jpeg_dec_release_jobs (GstJpegDec * dec)
+{
+  GstJpegDecJob *job;
+
+  g_mutex_lock (&dec->lock);
+  while ((job = g_queue_pop_head (&dec->jobs))) {
+    while (!job->done)
+      g_cond_wait (&dec->cond, &dec->lock);
+    g_mutex_unlock (&dec->lock);
+
+    gst_video_frame_unmap (&job->vframe);
+    gst_buffer_unmap (job->frame->input_buffer, &job->map);
+    gst_video_decoder_release_frame (GST_VIDEO_DECODER (dec), job->frame);
+    g_free (job->error);
+    g_slice_free (GstJpegDecJob, job);
+
+    g_mutex_lock (&dec->lock);
+  }
+  g_mutex_unlock (&dec->lock);
+}
+
+static void
+gst_jpeg_dec_update_latency (GstJpegDec * dec)
+{
+  GstClockTime latency = 0;
+
+  if (dec->max_pending > 0 && dec->input_state &&
+      GST_VIDEO_INFO_FPS_N (&dec->input_state->info) > 0) {
+    latency = gst_util_uint64_scale (GST_SECOND * dec->max_pending,
+        GST_VIDEO_INFO_FPS_D (&dec->input_state->info),
+        GST_VIDEO_INFO_FPS_N (&dec->input_state->info));
+  }
+
+  GST_DEBUG_OBJECT (dec, "latency %" GST_TIME_FORMAT, GST_TIME_ARGS (latency));
+  gst_video_decoder_set_latency (GST_VIDEO_DECODER (dec), latency, latency);
+}
+
+/* returns TRUE if frames are decoded by the thread pool */
+static gboolean
+gst_jpeg_dec_setup_threads (GstJpegDec * dec)
+{
+  guint n_threads, max_pending;
+
+  GST_OBJECT_LOCK (dec);
+  n_threads = dec->n_threads;
+  max_pending = dec->max_pending_frames;
+  GST_OBJECT_UNLOCK (dec);
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  if (max_pending == 0)
+    max_pending = n_threads;
+
+  if (n_threads <= 1)
+    max_pending = 0;
+
+  if (max_pending != dec->max_pending) {
+    dec->max_pending = max_pending;
+    gst_jpeg_dec_update_latency (dec);
+  }
+
+  if (n_threads <= 1)
+    return FALSE;
+
+  if (dec->pool == NULL) {
+    GST_DEBUG_OBJECT (dec, "decoding with %u threads, %u pending frames",
+        n_threads, max_pending);
+    dec->pool = g_thread_pool_new ((GFunc) gst_jpeg_dec_decode_job, dec,
+        n_threads, FALSE, NULL);
+  } else if (g_thread_pool_get_max_threads (dec->pool) != n_threads) {
+    g_thread_pool_set_max_threads (dec->pool, n_threads, NULL);
+  }
+
+  return TRUE;
+}
+
+static void
+gst_jpeg_dec_free_threads (GstJpegDec * dec)
+{
+  GSList *walk;
+
+  gst_jpeg_dec_release_jobs (dec);
+
+  if (dec->pool) {
+    g_thread_pool_free (dec->pool, FALSE, TRUE);
+    dec->pool = NULL;
+  }
+
+  for (walk = dec->free_contexts; walk; walk = walk->next) {
+    gst_jpeg_dec_context_clear (walk->data);
+    g_slice_free (GstJpegDecContext, walk->data);
+  }
+  g_slist_free (dec->free_contexts);
+  dec->free_contexts = NULL;
 }
 
 static GstFlowReturn
@@ -990,19 +1531,34 @@ gst_jpeg_dec_handle_frame (GstVideoDecoder * bdec, GstVideoCodecFrame * frame)
 {
   GstFlowReturn ret = GST_FLOW_OK;
   GstJpegDec *dec = (GstJpegDec *) bdec;
+  GstJpegDecContext *ctx = &dec->ctx;
   GstVideoFrame vframe;
   gint width, height;
   gint r_h, r_v;
   guint code, hdr_ok;
   gboolean need_unmap = TRUE;
+  gboolean threaded;
+  guint scale_denom;
   GstVideoCodecState *state = NULL;
 
+  threaded = gst_jpeg_dec_setup_threads (dec);
+  if (!threaded && !g_queue_is_empty (&dec->jobs)) {
+    /* the number of threads was changed, output what is left first */
+    ret = gst_jpeg_dec_push_jobs (dec, 0);
+    if (ret != GST_FLOW_OK) {
+      gst_video_decoder_drop_frame (bdec, frame);
+      return ret;
+    }
+  }
+
   dec->current_frame = frame;
   gst_buffer_map (frame->input_buffer, &dec->current_frame_map, GST_MAP_READ);
-  gst_jpeg_dec_fill_input_buffer (&dec->cinfo);
+  ctx->jsrc.data = dec->current_frame_map.data;
+  ctx->jsrc.size = dec->current_frame_map.size;
+  gst_jpeg_dec_fill_input_buffer (&ctx->cinfo);
 
-  if (setjmp (dec->jerr.setjmp_buffer)) {
-    code = dec->jerr.pub.msg_code;
+  if (setjmp (ctx->jerr.setjmp_buffer)) {
+    code = ctx->jerr.pub.msg_code;
 
     if (code == JERR_INPUT_EOF) {
       GST_DEBUG ("jpeg input EOF error, we probably need more data");
@@ -1012,74 +1568,78 @@ gst_jpeg_dec_handle_frame (GstVideoDecoder * bdec, GstVideoCodecFrame * frame)
   }
 
   /* read header */
-  hdr_ok = jpeg_read_header (&dec->cinfo, TRUE);
+  hdr_ok = jpeg_read_header (&ctx->cinfo, TRUE);
   if (G_UNLIKELY (hdr_ok != JPEG_HEADER_OK)) {
     GST_WARNING_OBJECT (dec, "reading the header failed, %d", hdr_ok);
   }
 
-  GST_LOG_OBJECT (dec, "num_components=%d", dec->cinfo.num_components);
-  GST_LOG_OBJECT (dec, "jpeg_color_space=%d", dec->cinfo.jpeg_color_space);
+  GST_LOG_OBJECT (dec, "num_components=%d", ctx->cinfo.num_components);
+  GST_LOG_OBJECT (dec, "jpeg_color_space=%d", ctx->cinfo.jpeg_color_space);
 
-  if (!dec->cinfo.num_components || !dec->cinfo.comp_info)
+  if (!ctx->cinfo.num_components || !ctx->cinfo.comp_info)
     goto components_not_supported;
 
-  r_h = dec->cinfo.comp_info[0].h_samp_factor;
-  r_v = dec->cinfo.comp_info[0].v_samp_factor;
+  r_h = ctx->cinfo.comp_info[0].h_samp_factor;
+  r_v = ctx->cinfo.comp_info[0].v_samp_factor;
 
   GST_LOG_OBJECT (dec, "r_h = %d, r_v = %d", r_h, r_v);
 
-  if (dec->cinfo.num_components > 3)
+  if (ctx->cinfo.num_components > 3)
     goto components_not_supported;
 
   /* verify color space expectation to avoid going *boom* or bogus output */
-  if (dec->cinfo.jpeg_color_space != JCS_YCbCr &&
-      dec->cinfo.jpeg_color_space != JCS_GRAYSCALE &&
-      dec->cinfo.jpeg_color_space != JCS_RGB)
+  if (ctx->cinfo.jpeg_color_space != JCS_YCbCr &&
+      ctx->cinfo.jpeg_color_space != JCS_GRAYSCALE &&
+      ctx->cinfo.jpeg_color_space != JCS_RGB)
     goto unsupported_colorspace;
 
 #ifndef GST_DISABLE_GST_DEBUG
   {
     gint i;
 
-    for (i = 0; i < dec->cinfo.num_components; ++i) {
+    for (i = 0; i < ctx->cinfo.num_components; ++i) {
       GST_LOG_OBJECT (dec, "[%d] h_samp_factor=%d, v_samp_factor=%d, cid=%d",
-          i, dec->cinfo.comp_info[i].h_samp_factor,
-          dec->cinfo.comp_info[i].v_samp_factor,
-          dec->cinfo.comp_info[i].component_id);
+          i, ctx->cinfo.comp_info[i].h_samp_factor,
+          ctx->cinfo.comp_info[i].v_samp_factor,
+          ctx->cinfo.comp_info[i].component_id);
     }
   }
 #endif
 
   /* prepare for raw output */
-  dec->cinfo.do_fancy_upsampling = FALSE;
-  dec->cinfo.do_block_smoothing = FALSE;
-  dec->cinfo.out_color_space = dec->cinfo.jpeg_color_space;
-  dec->cinfo.dct_method = dec->idct_method;
-  dec->cinfo.raw_data_out = TRUE;
-
-  GST_LOG_OBJECT (dec, "starting decompress");
-  guarantee_huff_tables (&dec->cinfo);
-  if (!jpeg_start_decompress (&dec->cinfo)) {
-    GST_WARNING_OBJECT (dec, "failed to start decompression cycle");
+  scale_denom = gst_jpeg_dec_choose_scale (dec, ctx);
+  gst_jpeg_dec_prepare_decompress (&ctx->cinfo, dec->idct_method,
+      scale_denom);
+
+  if (threaded) {
+    /* only the output size is needed here, one of the threads decodes */
+    jpeg_calc_output_dimensions (&ctx->cinfo);
+  } else {
+    GST_LOG_OBJECT (dec, "starting decompress");
+    guarantee_huff_tables (&ctx->cinfo);
+    if (!jpeg_start_decompress (&ctx->cinfo)) {
+      GST_WARNING_OBJECT (dec, "failed to start decompression cycle");
+    }
   }
 
   /* sanity checks to get safe and reasonable output */
-  switch (dec->cinfo.jpeg_color_space) {
+  switch (ctx->cinfo.jpeg_color_space) {
     case JCS_GRAYSCALE:
-      if (dec->cinfo.num_components != 1)
+      if (ctx->cinfo.num_components != 1)
         goto invalid_yuvrgbgrayscale;
       break;
     case JCS_RGB:
-      if (dec->cinfo.num_components != 3 || dec->cinfo.max_v_samp_factor > 1 ||
-          dec->cinfo.max_h_samp_factor > 1)
+      if (ctx->cinfo.num_components != 3 || ctx->cinfo.max_v_samp_factor > 1 ||
+          ctx->cinfo.max_h_samp_factor > 1)
         goto invalid_yuvrgbgrayscale;
       break;
     case JCS_YCbCr:
-      if (dec->cinfo.num_components != 3 ||
-          r_v > 2 || r_v < dec->cinfo.comp_info[0].v_samp_factor ||
-          r_v < dec->cinfo.comp_info[1].v_samp_factor ||
-          r_h < dec->cinfo.comp_info[0].h_samp_factor ||
-          r_h < dec->cinfo.comp_info[1].h_samp_factor)
+      if (ctx->cinfo.num_components != 3 ||
+          r_v > 2 || r_v < ctx->cinfo.comp_info[0].v_samp_factor ||
+          r_v < ctx->cinfo.comp_info[1].v_samp_factor ||
+          ctx->cinfo.comp_info[2].v_samp_factor > 2 ||
+          r_h < ctx->cinfo.comp_info[0].h_samp_factor ||
+          r_h < ctx->cinfo.comp_info[1].h_samp_factor)
         goto invalid_yuvrgbgrayscale;
       break;
     default:
@@ -1087,14 +1647,14 @@ gst_jpeg_dec_handle_frame (GstVideoDecoder * bdec, GstVideoCodecFrame * frame)
       break;
   }
 
-  width = dec->cinfo.output_width;
-  height = dec->cinfo.output_height;
+  width = ctx->cinfo.output_width;
+  height = ctx->cinfo.output_height;
 
   if (G_UNLIKELY (width < MIN_WIDTH || width > MAX_WIDTH ||
           height < MIN_HEIGHT || height > MAX_HEIGHT))
     goto wrong_size;
 
-  gst_jpeg_dec_negotiate (dec, width, height, dec->cinfo.jpeg_color_space);
+  gst_jpeg_dec_negotiate (dec, width, height, ctx->cinfo.jpeg_color_space);
 
   state = gst_video_decoder_get_output_state (bdec);
   ret = gst_video_decoder_allocate_output_frame (bdec, frame);
@@ -1107,39 +1667,37 @@ gst_jpeg_dec_handle_frame (GstVideoDecoder * bdec, GstVideoCodecFrame * frame)
 
   GST_LOG_OBJECT (dec, "width %d, height %d", width, height);
 
-  if (dec->cinfo.jpeg_color_space == JCS_RGB) {
-    gst_jpeg_dec_decode_rgb (dec, &vframe);
-  } else if (dec->cinfo.jpeg_color_space == JCS_GRAYSCALE) {
-    gst_jpeg_dec_decode_grayscale (dec, &vframe);
-  } else {
-    GST_LOG_OBJECT (dec, "decompressing (reqired scanline buffer height = %u)",
-        dec->cinfo.rec_outbuf_height);
+  if (threaded) {
+    GstJpegDecJob *job;
 
-    /* For some widths jpeglib requires more horizontal padding than I420 
-     * provides. In those cases we need to decode into separate buffers and then
-     * copy over the data into our final picture buffer, otherwise jpeglib might
-     * write over the end of a line into the beginning of the next line,
-     * resulting in blocky artifacts on the left side of the picture. */
-    if (G_UNLIKELY (width % (dec->cinfo.max_h_samp_factor * DCTSIZE) != 0
-            || dec->cinfo.comp_info[0].h_samp_factor != 2
-            || dec->cinfo.comp_info[1].h_samp_factor != 1
-            || dec->cinfo.comp_info[2].h_samp_factor != 1)) {
-      GST_CAT_LOG_OBJECT (GST_CAT_PERFORMANCE, dec,
-          "indirect decoding using extra buffer copy");
-      gst_jpeg_dec_decode_indirect (dec, &vframe, r_v, r_h,
-          dec->cinfo.num_components);
-    } else {
-      ret = gst_jpeg_dec_decode_direct (dec, &vframe);
+    jpeg_abort_decompress (&ctx->cinfo);
 
-      if (G_UNLIKELY (ret != GST_FLOW_OK))
-        goto decode_direct_failed;
-    }
+    job = g_slice_new0 (GstJpegDecJob);
+    job->frame = frame;
+    job->map = dec->current_frame_map;
+    job->vframe = vframe;
+    job->idct_method = dec->idct_method;
+    job->scale_denom = scale_denom;
+    job->ret = GST_FLOW_OK;
+    need_unmap = FALSE;
+
+    g_mutex_lock (&dec->lock);
+    g_queue_push_tail (&dec->jobs, job);
+    g_mutex_unlock (&dec->lock);
+    g_thread_pool_push (dec->pool, job, NULL);
+
+    ret = gst_jpeg_dec_push_jobs (dec, dec->max_pending);
+    goto exit;
   }
 
+  ret = gst_jpeg_dec_decode_image (ctx, &vframe);
   gst_video_frame_unmap (&vframe);
 
+  if (G_UNLIKELY (ret != GST_FLOW_OK))
+    goto decode_direct_failed;
+
   GST_LOG_OBJECT (dec, "decompressing finished");
-  jpeg_finish_decompress (&dec->cinfo);
+  jpeg_finish_decompress (&ctx->cinfo);
 
   gst_buffer_unmap (frame->input_buffer, &dec->current_frame_map);
   ret = gst_video_decoder_finish_frame (bdec, frame);
@@ -1177,7 +1735,7 @@ decode_error:
   {
     gchar err_msg[JMSG_LENGTH_MAX];
 
-    dec->jerr.pub.format_message ((j_common_ptr) (&dec->cinfo), err_msg);
+    ctx->jerr.pub.format_message ((j_common_ptr) (&ctx->cinfo), err_msg);
 
     GST_VIDEO_DECODER_ERROR (dec, 1, STREAM, DECODE,
         (_("Failed to decode JPEG image")), ("Decode error #%u: %s", code,
@@ -1186,14 +1744,14 @@ decode_error:
     gst_buffer_unmap (frame->input_buffer, &dec->current_frame_map);
     gst_video_decoder_drop_frame (bdec, frame);
     need_unmap = FALSE;
-    jpeg_abort_decompress (&dec->cinfo);
+    jpeg_abort_decompress (&ctx->cinfo);
 
     goto done;
   }
 decode_direct_failed:
   {
     /* already posted an error message */
-    jpeg_abort_decompress (&dec->cinfo);
+    jpeg_abort_decompress (&ctx->cinfo);
     goto done;
   }
 alloc_failed:
@@ -1204,13 +1762,13 @@ alloc_failed:
 
     GST_DEBUG_OBJECT (dec, "failed to alloc buffer, reason %s", reason);
     /* Reset for next time */
-    jpeg_abort_decompress (&dec->cinfo);
+    jpeg_abort_decompress (&ctx->cinfo);
     if (ret != GST_FLOW_EOS && ret != GST_FLOW_FLUSHING &&
         ret != GST_FLOW_NOT_LINKED) {
       GST_VIDEO_DECODER_ERROR (dec, 1, STREAM, DECODE,
           (_("Failed to decode JPEG image")),
           ("Buffer allocation failed, reason: %s", reason), ret);
-      jpeg_abort_decompress (&dec->cinfo);
+      jpeg_abort_decompress (&ctx->cinfo);
     }
     goto exit;
   }
@@ -1219,8 +1777,8 @@ components_not_supported:
     GST_VIDEO_DECODER_ERROR (dec, 1, STREAM, DECODE,
         (_("Failed to decode JPEG image")),
         ("number of components not supported: %d (max 3)",
-            dec->cinfo.num_components), ret);
-    jpeg_abort_decompress (&dec->cinfo);
+            ctx->cinfo.num_components), ret);
+    jpeg_abort_decompress (&ctx->cinfo);
     goto done;
   }
 unsupported_colorspace:
@@ -1228,7 +1786,7 @@ unsupported_colorspace:
     GST_VIDEO_DECODER_ERROR (dec, 1, STREAM, DECODE,
         (_("Failed to decode JPEG image")),
         ("Picture has unknown or unsupported colourspace"), ret);
-    jpeg_abort_decompress (&dec->cinfo);
+    jpeg_abort_decompress (&ctx->cinfo);
     goto done;
   }
 invalid_yuvrgbgrayscale:
@@ -1236,7 +1794,7 @@ invalid_yuvrgbgrayscale:
     GST_VIDEO_DECODER_ERROR (dec, 1, STREAM, DECODE,
         (_("Failed to decode JPEG image")),
         ("Picture is corrupt or unhandled YUV/RGB/grayscale layout"), ret);
-    jpeg_abort_decompress (&dec->cinfo);
+    jpeg_abort_decompress (&ctx->cinfo);
     goto done;
   }
 }
@@ -1275,6 +1833,8 @@ gst_jpeg_dec_start (GstVideoDecoder * bdec)
   dec->saw_header = FALSE;
   dec->parse_entropy_len = 0;
   dec->parse_resync = FALSE;
+  dec->scale_width = 0;
+  dec->scale_height = 0;
 
   gst_video_decoder_set_packetized (bdec, FALSE);
 
@@ -1286,7 +1846,9 @@ gst_jpeg_dec_flush (GstVideoDecoder * bdec)
 {
   GstJpegDec *dec = (GstJpegDec *) bdec;
 
-  jpeg_abort_decompress (&dec->cinfo);
+  gst_jpeg_dec_release_jobs (dec);
+
+  jpeg_abort_decompress (&dec->ctx.cinfo);
   dec->parse_entropy_len = 0;
   dec->parse_resync = FALSE;
   dec->saw_header = FALSE;
@@ -1309,6 +1871,21 @@ gst_jpeg_dec_set_property (GObject * object, guint prop_id,
     case PROP_MAX_ERRORS:
       g_atomic_int_set (&dec->max_errors, g_value_get_int (value));
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (dec);
+      dec->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (dec);
+      break;
+    case PROP_MAX_PENDING_FRAMES:
+      GST_OBJECT_LOCK (dec);
+      dec->max_pending_frames = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (dec);
+      break;
+    case PROP_SCALE_DENOMINATOR:
+      GST_OBJECT_LOCK (dec);
+      dec->scale_denom = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (dec);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -1331,6 +1908,21 @@ gst_jpeg_dec_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_MAX_ERRORS:
       g_value_set_int (value, g_atomic_int_get (&dec->max_errors));
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (dec);
+      g_value_set_uint (value, dec->n_threads);
+      GST_OBJECT_UNLOCK (dec);
+      break;
+    case PROP_MAX_PENDING_FRAMES:
+      GST_OBJECT_LOCK (dec);
+      g_value_set_uint (value, dec->max_pending_frames);
+      GST_OBJECT_UNLOCK (dec);
+      break;
+    case PROP_SCALE_DENOMINATOR:
+      GST_OBJECT_LOCK (dec);
+      g_value_set_uint (value, dec->scale_denom);
+      GST_OBJECT_UNLOCK (dec);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -1343,7 +1935,16 @@ gst_jpeg_dec_stop (GstVideoDecoder * bdec)
 {
   GstJpegDec *dec = (GstJpegDec *) bdec;
 
-  gst_jpeg_dec_free_buffers (dec);
+  gst_jpeg_dec_free_threads (dec);
+  gst_jpeg_dec_free_buffers (&dec->ctx);
 
   return TRUE;
 }
+
+static GstFlowReturn
+gst_jpeg_dec_finish (GstVideoDecoder * bdec)
+{
+  GstJpegDec *dec = (GstJpegDec *) bdec;
+
+  return gst_jpeg_dec_push_jobs (dec, 0);
+}
@@ -61,8 +61,24 @@ struct GstJpegDecErrorMgr {
 struct GstJpegDecSourceMgr {
   struct jpeg_source_mgr   pub;   /* public fields */
   GstJpegDec              *dec;
+
+  /* data of the image being decoded */
+  const guint8            *data;
+  gsize                    size;
 };
 
+/* libjpeg state, the element has one and every decoding thread
+ * has its own */
+typedef struct _GstJpegDecContext {
+  struct jpeg_decompress_struct cinfo;
+  struct GstJpegDecErrorMgr     jerr;
+  struct GstJpegDecSourceMgr    jsrc;
+
+  /* arrays for indirect decoding */
+  gboolean idr_width_allocated;
+  guchar *idr_y[16],*idr_u[16],*idr_v[16];
+} GstJpegDecContext;
+
 /* Can't use GstBaseTransform, because GstBaseTransform
  * doesn't handle the N buffers in, 1 buffer out case,
  * but only the 1-in 1-out case */
@@ -82,14 +98,25 @@ struct _GstJpegDec {
   /* properties */
   gint     idct_method;
   gint     max_errors;  /* ATOMIC */
+  guint    n_threads;
+  guint    max_pending_frames;
+  guint    scale_denom;
 
-  struct jpeg_decompress_struct cinfo;
-  struct GstJpegDecErrorMgr     jerr;
-  struct GstJpegDecSourceMgr    jsrc;
+  GstJpegDecContext ctx;
+
+  /* frame threading */
+  GThreadPool *pool;
+  GMutex   lock;
+  GCond    cond;
+  GQueue   jobs;           /* in decoding order, with lock */
+  GSList  *free_contexts;  /* with lock */
+  guint    max_pending;
+
+  /* last picture size the scale was chosen for */
+  gint     scale_width, scale_height, scale_clrspc;
+  guint    scale_requested;
+  guint    scale_chosen;
 
-  /* arrays for indirect decoding */
-  gboolean idr_width_allocated;
-  guchar *idr_y[16],*idr_u[16],*idr_v[16];
   /* current (parsed) image size */
   guint    rem_img_len;
 };
@@ -30,6 +30,10 @@
  * ]| a pipeline to mux 5 JPEG frames per second into a 10 sec. long motion jpeg
  * avi.
  * </refsect2>
+ *
+ * With #GstJpegEnc:n-threads set to more than one thread, frames are split
+ * into horizontal strips of whole MCU rows that are encoded in parallel and
+ * joined with restart markers into a single baseline JPEG image.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -54,6 +58,7 @@ GST_DEBUG_CATEGORY_STATIC (jpegenc_debug);
 #define JPEG_DEFAULT_QUALITY 85
 #define JPEG_DEFAULT_SMOOTHING 0
 #define JPEG_DEFAULT_IDCT_METHOD	JDCT_FASTEST
+#define JPEG_DEFAULT_N_THREADS 1
 
 /* JpegEnc signals and args */
 enum
@@ -67,12 +72,14 @@ enum
   PROP_0,
   PROP_QUALITY,
   PROP_SMOOTHING,
-  PROP_IDCT_METHOD
+  PROP_IDCT_METHOD,
+  PROP_N_THREADS
 };
 
 static void gst_jpegenc_finalize (GObject * object);
 
 static void gst_jpegenc_resync (GstJpegEnc * jpegenc);
+static void gst_jpegenc_free_slices (GstJpegEnc * jpegenc);
 static void gst_jpegenc_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_jpegenc_get_property (GObject * object, guint prop_id,
@@ -150,6 +157,21 @@ gst_jpegenc_class_init (GstJpegEncClass * klass)
           JPEG_DEFAULT_IDCT_METHOD,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstJpegEnc:n-threads:
+   *
+   * Number of threads used to encode a frame. With more than one thread the
+   * frame is encoded as strips of MCU rows separated by restart markers.
+   * 0 uses one thread per processor.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Maximum number of threads used to encode a frame "
+          "(0 = number of processors)", 0, G_MAXUINT, JPEG_DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&gst_jpegenc_sink_pad_template));
   gst_element_class_add_pad_template (element_class,
@@ -225,33 +247,27 @@ gst_jpegenc_flush_destination (j_compress_ptr cinfo)
   return TRUE;
 }
 
-static void
-gst_jpegenc_term_destination (j_compress_ptr cinfo)
+static gint
+gst_jpegenc_find_sof_marker (const guint8 * data, gsize size)
 {
-  GstBuffer *outbuf;
-  GstJpegEnc *jpegenc = (GstJpegEnc *) (cinfo->client_data);
-  gsize memory_size = jpegenc->output_map.size - jpegenc->jdest.free_in_buffer;
-  GstByteReader reader =
-      GST_BYTE_READER_INIT (jpegenc->output_map.data, memory_size);
+  GstByteReader reader = GST_BYTE_READER_INIT (data, size);
   guint16 marker;
-  gint sof_marker = -1;
 
-  GST_DEBUG_OBJECT (jpegenc, "gst_jpegenc_chain: term_source");
-
-  /* Find the SOF marker */
   while (gst_byte_reader_get_uint16_be (&reader, &marker)) {
     /* SOF marker */
-    if (marker >> 4 == 0x0ffc) {
-      sof_marker = marker & 0x4;
-      break;
-    }
+    if (marker >> 4 == 0x0ffc)
+      return marker & 0x4;
   }
 
-  gst_memory_unmap (jpegenc->output_mem, &jpegenc->output_map);
-  /* Trim the buffer size. we will push it in the chain function */
-  gst_memory_resize (jpegenc->output_mem, 0, memory_size);
-  jpegenc->output_map.data = NULL;
-  jpegenc->output_map.size = 0;
+  return -1;
+}
+
+/* pushes the encoded image in mem as the output of the current frame */
+static void
+gst_jpegenc_finish_output (GstJpegEnc * jpegenc, GstMemory * mem,
+    gint sof_marker)
+{
+  GstBuffer *outbuf;
 
   if (jpegenc->sof_marker != sof_marker) {
     GstVideoCodecState *output;
@@ -266,8 +282,7 @@ gst_jpegenc_term_destination (j_compress_ptr cinfo)
   outbuf = gst_buffer_new ();
   gst_buffer_copy_into (outbuf, jpegenc->current_frame->input_buffer,
       GST_BUFFER_COPY_METADATA, 0, -1);
-  gst_buffer_append_memory (outbuf, jpegenc->output_mem);
-  jpegenc->output_mem = NULL;
+  gst_buffer_append_memory (outbuf, mem);
 
   jpegenc->current_frame->output_buffer = outbuf;
 
@@ -280,6 +295,67 @@ gst_jpegenc_term_destination (j_compress_ptr cinfo)
   jpegenc->current_frame = NULL;
 }
 
+static void
+gst_jpegenc_term_destination (j_compress_ptr cinfo)
+{
+  GstJpegEnc *jpegenc = (GstJpegEnc *) (cinfo->client_data);
+  gsize memory_size = jpegenc->output_map.size - jpegenc->jdest.free_in_buffer;
+  gint sof_marker;
+
+  GST_DEBUG_OBJECT (jpegenc, "gst_jpegenc_chain: term_source");
+
+  /* Find the SOF marker */
+  sof_marker =
+      gst_jpegenc_find_sof_marker (jpegenc->output_map.data, memory_size);
+
+  gst_memory_unmap (jpegenc->output_mem, &jpegenc->output_map);
+  /* Trim the buffer size. we will push it in the chain function */
+  gst_memory_resize (jpegenc->output_mem, 0, memory_size);
+  jpegenc->output_map.data = NULL;
+  jpegenc->output_map.size = 0;
+
+  gst_jpegenc_finish_output (jpegenc, jpegenc->output_mem, sof_marker);
+  jpegenc->output_mem = NULL;
+}
+
+/* the strips of sliced encoding are compressed to growing heap buffers */
+static void
+gst_jpegenc_slice_init_destination (j_compress_ptr cinfo)
+{
+  GstJpegEncSlice *slice = (GstJpegEncSlice *) (cinfo->client_data);
+
+  if (slice->data == NULL) {
+    slice->alloc_size =
+        GST_ROUND_UP_4 (slice->enc->bufsize / slice->enc->n_slices + 1024);
+    slice->data = g_malloc (slice->alloc_size);
+  }
+
+  slice->jdest.next_output_byte = slice->data;
+  slice->jdest.free_in_buffer = slice->alloc_size;
+}
+
+static boolean
+gst_jpegenc_slice_flush_destination (j_compress_ptr cinfo)
+{
+  GstJpegEncSlice *slice = (GstJpegEncSlice *) (cinfo->client_data);
+  gsize old_size = slice->alloc_size;
+
+  slice->alloc_size *= 2;
+  slice->data = g_realloc (slice->data, slice->alloc_size);
+  slice->jdest.next_output_byte = slice->data + old_size;
+  slice->jdest.free_in_buffer = slice->alloc_size - old_size;
+
+  return TRUE;
+}
+
+static void
+gst_jpegenc_slice_term_destination (j_compress_ptr cinfo)
+{
+  GstJpegEncSlice *slice = (GstJpegEncSlice *) (cinfo->client_data);
+
+  slice->size = slice->alloc_size - slice->jdest.free_in_buffer;
+}
+
 static void
 gst_jpegenc_init (GstJpegEnc * jpegenc)
 {
@@ -299,6 +375,10 @@ gst_jpegenc_init (GstJpegEnc * jpegenc)
   jpegenc->quality = JPEG_DEFAULT_QUALITY;
   jpegenc->smoothing = JPEG_DEFAULT_SMOOTHING;
   jpegenc->idct_method = JPEG_DEFAULT_IDCT_METHOD;
+  jpegenc->n_threads = JPEG_DEFAULT_N_THREADS;
+
+  g_mutex_init (&jpegenc->slice_lock);
+  g_cond_init (&jpegenc->slice_cond);
 }
 
 static void
@@ -308,6 +388,12 @@ gst_jpegenc_finalize (GObject * object)
 
   jpeg_destroy_compress (&filter->cinfo);
 
+  gst_jpegenc_free_slices (filter);
+  if (filter->slice_pool)
+    g_thread_pool_free (filter->slice_pool, FALSE, TRUE);
+  g_mutex_clear (&filter->slice_lock);
+  g_cond_clear (&filter->slice_cond);
+
   if (filter->input_state)
     gst_video_codec_state_unref (filter->input_state);
 
@@ -363,12 +449,98 @@ gst_jpegenc_set_format (GstVideoEncoder * encoder, GstVideoCodecState * state)
   return TRUE;
 }
 
+/* configures cinfo for raw input of the negotiated format at the given
+ * image height */
+static void
+gst_jpegenc_setup_compress (GstJpegEnc * jpegenc, j_compress_ptr cinfo,
+    gint height)
+{
+  GstVideoInfo *info = &jpegenc->input_state->info;
+  gint i;
+
+  cinfo->image_width = GST_VIDEO_INFO_WIDTH (info);
+  cinfo->image_height = height;
+  cinfo->input_components = jpegenc->channels;
+
+  if (GST_VIDEO_INFO_IS_RGB (info)) {
+    cinfo->in_color_space = JCS_RGB;
+  } else if (GST_VIDEO_INFO_IS_GRAY (info)) {
+    cinfo->in_color_space = JCS_GRAYSCALE;
+  } else {
+    cinfo->in_color_space = JCS_YCbCr;
+  }
+
+  jpeg_set_defaults (cinfo);
+  cinfo->raw_data_in = TRUE;
+  /* duh, libjpeg maps RGB to YUV ... and don't expect some conversion */
+  if (cinfo->in_color_space == JCS_RGB)
+    jpeg_set_colorspace (cinfo, JCS_RGB);
+
+  for (i = 0; i < jpegenc->channels; i++) {
+    cinfo->comp_info[i].h_samp_factor = jpegenc->h_samp[i];
+    cinfo->comp_info[i].v_samp_factor = jpegenc->v_samp[i];
+  }
+}
+
+/* allocates the jpeg line buffers, for packed formats they point to rows
+ * the components are copied to */
+static void
+gst_jpegenc_alloc_lines (GstJpegEnc * jpegenc, guchar ** line[3],
+    guchar * row[3][4 * DCTSIZE])
+{
+  gint width = GST_VIDEO_INFO_WIDTH (&jpegenc->input_state->info);
+  gint i, j;
+
+  for (i = 0; i < jpegenc->channels; i++) {
+    g_free (line[i]);
+    line[i] = g_new (guchar *, jpegenc->v_max_samp * DCTSIZE);
+    if (!jpegenc->planar) {
+      for (j = 0; j < jpegenc->v_max_samp * DCTSIZE; j++) {
+        g_free (row[i][j]);
+        row[i][j] = g_malloc (width);
+        line[i][j] = row[i][j];
+      }
+    }
+  }
+}
+
+static void
+gst_jpegenc_free_lines (guchar ** line[3], guchar * row[3][4 * DCTSIZE])
+{
+  gint i, j;
+
+  for (i = 0; i < 3; i++) {
+    g_free (line[i]);
+    line[i] = NULL;
+    for (j = 0; j < 4 * DCTSIZE; j++) {
+      g_free (row[i][j]);
+      row[i][j] = NULL;
+    }
+  }
+}
+
+static void
+gst_jpegenc_free_slices (GstJpegEnc * jpegenc)
+{
+  guint i;
+
+  for (i = 0; i < jpegenc->n_slices; i++) {
+    GstJpegEncSlice *slice = &jpegenc->slices[i];
+
+    jpeg_destroy_compress (&slice->cinfo);
+    gst_jpegenc_free_lines (slice->line, slice->row);
+    g_free (slice->data);
+  }
+  g_free (jpegenc->slices);
+  jpegenc->slices = NULL;
+  jpegenc->n_slices = 0;
+}
+
 static void
 gst_jpegenc_resync (GstJpegEnc * jpegenc)
 {
   GstVideoInfo *info;
-  gint width, height;
-  gint i, j;
+  gint i;
 
   GST_DEBUG_OBJECT (jpegenc, "resync");
 
@@ -377,31 +549,14 @@ gst_jpegenc_resync (GstJpegEnc * jpegenc)
 
   info = &jpegenc->input_state->info;
 
-  jpegenc->cinfo.image_width = width = GST_VIDEO_INFO_WIDTH (info);
-  jpegenc->cinfo.image_height = height = GST_VIDEO_INFO_HEIGHT (info);
-  jpegenc->cinfo.input_components = jpegenc->channels;
-
-  GST_DEBUG_OBJECT (jpegenc, "width %d, height %d", width, height);
+  GST_DEBUG_OBJECT (jpegenc, "width %d, height %d",
+      GST_VIDEO_INFO_WIDTH (info), GST_VIDEO_INFO_HEIGHT (info));
   GST_DEBUG_OBJECT (jpegenc, "format %d", GST_VIDEO_INFO_FORMAT (info));
 
-  if (GST_VIDEO_INFO_IS_RGB (info)) {
-    GST_DEBUG_OBJECT (jpegenc, "RGB");
-    jpegenc->cinfo.in_color_space = JCS_RGB;
-  } else if (GST_VIDEO_INFO_IS_GRAY (info)) {
-    GST_DEBUG_OBJECT (jpegenc, "gray");
-    jpegenc->cinfo.in_color_space = JCS_GRAYSCALE;
-  } else {
-    GST_DEBUG_OBJECT (jpegenc, "YUV");
-    jpegenc->cinfo.in_color_space = JCS_YCbCr;
-  }
-
   /* input buffer size as max output */
   jpegenc->bufsize = GST_VIDEO_INFO_SIZE (info);
-  jpeg_set_defaults (&jpegenc->cinfo);
-  jpegenc->cinfo.raw_data_in = TRUE;
-  /* duh, libjpeg maps RGB to YUV ... and don't expect some conversion */
-  if (jpegenc->cinfo.in_color_space == JCS_RGB)
-    jpeg_set_colorspace (&jpegenc->cinfo, JCS_RGB);
+  gst_jpegenc_setup_compress (jpegenc, &jpegenc->cinfo,
+      GST_VIDEO_INFO_HEIGHT (info));
 
   GST_DEBUG_OBJECT (jpegenc, "h_max_samp=%d, v_max_samp=%d",
       jpegenc->h_max_samp, jpegenc->v_max_samp);
@@ -409,18 +564,12 @@ gst_jpegenc_resync (GstJpegEnc * jpegenc)
   for (i = 0; i < jpegenc->channels; i++) {
     GST_DEBUG_OBJECT (jpegenc, "comp %i: h_samp=%d, v_samp=%d", i,
         jpegenc->h_samp[i], jpegenc->v_samp[i]);
-    jpegenc->cinfo.comp_info[i].h_samp_factor = jpegenc->h_samp[i];
-    jpegenc->cinfo.comp_info[i].v_samp_factor = jpegenc->v_samp[i];
-    g_free (jpegenc->line[i]);
-    jpegenc->line[i] = g_new (guchar *, jpegenc->v_max_samp * DCTSIZE);
-    if (!jpegenc->planar) {
-      for (j = 0; j < jpegenc->v_max_samp * DCTSIZE; j++) {
-        g_free (jpegenc->row[i][j]);
-        jpegenc->row[i][j] = g_malloc (width);
-        jpegenc->line[i][j] = jpegenc->row[i][j];
-      }
-    }
   }
+  gst_jpegenc_alloc_lines (jpegenc, jpegenc->line, jpegenc->row);
+
+  /* the strips depend on the format, they are set up again on the next
+   * sliced frame */
+  gst_jpegenc_free_slices (jpegenc);
 
   /* guard against a potential error in gst_jpegenc_term_destination
      which occurs iff bufsize % 4 < free_space_remaining */
@@ -431,68 +580,36 @@ gst_jpegenc_resync (GstJpegEnc * jpegenc)
   GST_DEBUG_OBJECT (jpegenc, "resync done");
 }
 
-static GstFlowReturn
-gst_jpegenc_handle_frame (GstVideoEncoder * encoder, GstVideoCodecFrame * frame)
+/* feeds the rows from y_start to y_end of the frame to cinfo, y_start is a
+ * multiple of the MCU height */
+static void
+gst_jpegenc_write_rows (GstJpegEnc * jpegenc, j_compress_ptr cinfo,
+    guchar ** line[3], GstVideoFrame * vframe, gint y_start, gint y_end)
 {
-  GstJpegEnc *jpegenc;
-  guint height;
   guchar *base[3], *end[3];
   guint stride[3];
   gint i, j, k;
-  static GstAllocationParams params = { 0, 0, 0, 3, };
-
-  jpegenc = GST_JPEGENC (encoder);
-
-  GST_LOG_OBJECT (jpegenc, "got new frame");
-
-  if (!gst_video_frame_map (&jpegenc->current_vframe,
-          &jpegenc->input_state->info, frame->input_buffer, GST_MAP_READ))
-    goto invalid_frame;
-
-  jpegenc->current_frame = frame;
-
-  height = GST_VIDEO_INFO_HEIGHT (&jpegenc->input_state->info);
 
   for (i = 0; i < jpegenc->channels; i++) {
-    base[i] = GST_VIDEO_FRAME_COMP_DATA (&jpegenc->current_vframe, i);
-    stride[i] = GST_VIDEO_FRAME_COMP_STRIDE (&jpegenc->current_vframe, i);
-    end[i] =
-        base[i] + GST_VIDEO_FRAME_COMP_HEIGHT (&jpegenc->current_vframe,
-        i) * stride[i];
+    base[i] = GST_VIDEO_FRAME_COMP_DATA (vframe, i);
+    stride[i] = GST_VIDEO_FRAME_COMP_STRIDE (vframe, i);
+    end[i] = base[i] + GST_VIDEO_FRAME_COMP_HEIGHT (vframe, i) * stride[i];
+    base[i] += y_start * jpegenc->v_samp[i] / jpegenc->v_max_samp * stride[i];
   }
 
-  jpegenc->res = GST_FLOW_OK;
-  jpegenc->output_mem = gst_allocator_alloc (NULL, jpegenc->bufsize, &params);
-  gst_memory_map (jpegenc->output_mem, &jpegenc->output_map, GST_MAP_READWRITE);
-
-  jpegenc->jdest.next_output_byte = jpegenc->output_map.data;
-  jpegenc->jdest.free_in_buffer = jpegenc->output_map.size;
-
-  /* prepare for raw input */
-#if JPEG_LIB_VERSION >= 70
-  jpegenc->cinfo.do_fancy_downsampling = FALSE;
-#endif
-  jpegenc->cinfo.smoothing_factor = jpegenc->smoothing;
-  jpegenc->cinfo.dct_method = jpegenc->idct_method;
-  jpeg_set_quality (&jpegenc->cinfo, jpegenc->quality, TRUE);
-  jpeg_start_compress (&jpegenc->cinfo, TRUE);
-
-  GST_LOG_OBJECT (jpegenc, "compressing");
-
   if (jpegenc->planar) {
-    for (i = 0; i < height; i += jpegenc->v_max_samp * DCTSIZE) {
+    for (i = y_start; i < y_end; i += jpegenc->v_max_samp * DCTSIZE) {
       for (k = 0; k < jpegenc->channels; k++) {
         for (j = 0; j < jpegenc->v_samp[k] * DCTSIZE; j++) {
-          jpegenc->line[k][j] = base[k];
+          line[k][j] = base[k];
           if (base[k] + stride[k] < end[k])
             base[k] += stride[k];
         }
       }
-      jpeg_write_raw_data (&jpegenc->cinfo, jpegenc->line,
-          jpegenc->v_max_samp * DCTSIZE);
+      jpeg_write_raw_data (cinfo, line, jpegenc->v_max_samp * DCTSIZE);
     }
   } else {
-    for (i = 0; i < height; i += jpegenc->v_max_samp * DCTSIZE) {
+    for (i = y_start; i < y_end; i += jpegenc->v_max_samp * DCTSIZE) {
       for (k = 0; k < jpegenc->channels; k++) {
         for (j = 0; j < jpegenc->v_samp[k] * DCTSIZE; j++) {
           guchar *src, *dst;
@@ -500,7 +617,7 @@ gst_jpegenc_handle_frame (GstVideoEncoder * encoder, GstVideoCodecFrame * frame)
 
           /* ouch, copy line */
           src = base[k];
-          dst = jpegenc->line[k][j];
+          dst = line[k][j];
           for (l = jpegenc->cwidth[k]; l > 0; l--) {
             *dst = *src;
             src += jpegenc->inc[k];
@@ -510,11 +627,278 @@ gst_jpegenc_handle_frame (GstVideoEncoder * encoder, GstVideoCodecFrame * frame)
             base[k] += stride[k];
         }
       }
-      jpeg_write_raw_data (&jpegenc->cinfo, jpegenc->line,
-          jpegenc->v_max_samp * DCTSIZE);
+      jpeg_write_raw_data (cinfo, line, jpegenc->v_max_samp * DCTSIZE);
+    }
+  }
+}
+
+static void
+gst_jpegenc_start_compress (GstJpegEnc * jpegenc, j_compress_ptr cinfo)
+{
+  /* prepare for raw input */
+#if JPEG_LIB_VERSION >= 70
+  cinfo->do_fancy_downsampling = FALSE;
+#endif
+  cinfo->smoothing_factor = jpegenc->smoothing;
+  cinfo->dct_method = jpegenc->idct_method;
+  jpeg_set_quality (cinfo, jpegenc->quality, TRUE);
+  jpeg_start_compress (cinfo, TRUE);
+}
+
+static void
+gst_jpegenc_encode_slice (GstJpegEncSlice * slice)
+{
+  gst_jpegenc_start_compress (slice->enc, &slice->cinfo);
+  gst_jpegenc_write_rows (slice->enc, &slice->cinfo, slice->line,
+      slice->vframe, slice->y_start, slice->y_end);
+  jpeg_finish_compress (&slice->cinfo);
+}
+
+static void
+gst_jpegenc_slice_func (gpointer data, gpointer user_data)
+{
+  GstJpegEncSlice *slice = data;
+  GstJpegEnc *jpegenc = slice->enc;
+
+  gst_jpegenc_encode_slice (slice);
+
+  g_mutex_lock (&jpegenc->slice_lock);
+  if (--jpegenc->slice_pending == 0)
+    g_cond_signal (&jpegenc->slice_cond);
+  g_mutex_unlock (&jpegenc->slice_lock);
+}
+
+/* finds the SOF and SOS markers in the image of a strip and the start of
+ * its entropy coded data */
+static gboolean
+gst_jpegenc_parse_slice (GstJpegEncSlice * slice, gsize * sof, gsize * sos,
+    gsize * scan)
+{
+  const guint8 *data = slice->data;
+  gsize pos = 2;
+
+  *sof = 0;
+  while (pos + 4 <= slice->size && data[pos] == 0xff) {
+    guint8 marker = data[pos + 1];
+
+    if (marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8
+        && marker != 0xcc)
+      *sof = pos;
+
+    if (marker == 0xda) {
+      *sos = pos;
+      *scan = pos + 2 + GST_READ_UINT16_BE (data + pos + 2);
+      /* the scan ends with the EOI marker */
+      return *sof != 0 && *scan + 2 <= slice->size &&
+          data[slice->size - 2] == 0xff && data[slice->size - 1] == 0xd9;
+    }
+    pos += 2 + GST_READ_UINT16_BE (data + pos + 2);
+  }
+
+  return FALSE;
+}
+
+/* Encodes the frame as strips of MCU rows on up to n_threads threads and
+ * joins them into one image, the restart interval being one strip. The
+ * entropy coded data of the strips is concatenated with RSTn markers in
+ * between, behind the headers of the first strip where the image height is
+ * patched and a DRI marker is added. */
+static GstFlowReturn
+gst_jpegenc_encode_slices (GstJpegEnc * jpegenc, guint n_threads,
+    guint n_slices, gint slice_height, guint restart_interval)
+{
+  static GstAllocationParams params = { 0, 0, 0, 3, };
+  gint height = GST_VIDEO_INFO_HEIGHT (&jpegenc->input_state->info);
+  gsize sof = 0, sos = 0, total;
+  GstMemory *mem;
+  GstMapInfo map;
+  guint8 *out;
+  guint i;
+
+  if (jpegenc->n_slices != n_slices) {
+    gst_jpegenc_free_slices (jpegenc);
+    jpegenc->slices = g_new0 (GstJpegEncSlice, n_slices);
+    jpegenc->n_slices = n_slices;
+    for (i = 0; i < n_slices; i++) {
+      GstJpegEncSlice *slice = &jpegenc->slices[i];
+
+      slice->enc = jpegenc;
+      slice->cinfo.err = jpeg_std_error (&slice->jerr);
+      jpeg_create_compress (&slice->cinfo);
+      slice->jdest.init_destination = gst_jpegenc_slice_init_destination;
+      slice->jdest.empty_output_buffer = gst_jpegenc_slice_flush_destination;
+      slice->jdest.term_destination = gst_jpegenc_slice_term_destination;
+      slice->cinfo.dest = &slice->jdest;
+      slice->cinfo.client_data = slice;
+      gst_jpegenc_alloc_lines (jpegenc, slice->line, slice->row);
+    }
+  }
+
+  n_threads = MIN (n_threads, n_slices);
+  if (jpegenc->slice_pool == NULL) {
+    jpegenc->slice_pool =
+        g_thread_pool_new (gst_jpegenc_slice_func, NULL, n_threads - 1,
+        FALSE, NULL);
+  } else if (g_thread_pool_get_max_threads (jpegenc->slice_pool) <
+      n_threads - 1) {
+    g_thread_pool_set_max_threads (jpegenc->slice_pool, n_threads - 1, NULL);
+  }
+
+  for (i = 0; i < n_slices; i++) {
+    GstJpegEncSlice *slice = &jpegenc->slices[i];
+
+    slice->vframe = &jpegenc->current_vframe;
+    slice->y_start = i * slice_height;
+    slice->y_end = MIN ((i + 1) * slice_height, height);
+    gst_jpegenc_setup_compress (jpegenc, &slice->cinfo,
+        slice->y_end - slice->y_start);
+  }
+
+  GST_LOG_OBJECT (jpegenc, "compressing %u slices of %d rows", n_slices,
+      slice_height);
+
+  if (jpegenc->slice_pool) {
+    jpegenc->slice_pending = n_slices - 1;
+    for (i = 1; i < n_slices; i++)
+      g_thread_pool_push (jpegenc->slice_pool, &jpegenc->slices[i], NULL);
+
+    gst_jpegenc_encode_slice (&jpegenc->slices[0]);
+
+    g_mutex_lock (&jpegenc->slice_lock);
+    while (jpegenc->slice_pending > 0)
+      g_cond_wait (&jpegenc->slice_cond, &jpegenc->slice_lock);
+    g_mutex_unlock (&jpegenc->slice_lock);
+  } else {
+    for (i = 0; i < n_slices; i++)
+      gst_jpegenc_encode_slice (&jpegenc->slices[i]);
+  }
+
+  /* DRI and EOI */
+  total = 6 + 2;
+  for (i = 0; i < n_slices; i++) {
+    GstJpegEncSlice *slice = &jpegenc->slices[i];
+    gsize slice_sof, slice_sos;
+
+    if (!gst_jpegenc_parse_slice (slice, &slice_sof, &slice_sos, &slice->scan))
+      goto invalid_slice;
+
+    if (i == 0) {
+      /* headers of the first strip */
+      sof = slice_sof;
+      sos = slice_sos;
+      total += slice->scan;
+    } else {
+      /* RSTn */
+      total += 2;
     }
+    /* without the EOI */
+    total += slice->size - 2 - slice->scan;
+  }
+
+  mem = gst_allocator_alloc (NULL, total, &params);
+  gst_memory_map (mem, &map, GST_MAP_WRITE);
+  out = map.data;
+
+  for (i = 0; i < n_slices; i++) {
+    GstJpegEncSlice *slice = &jpegenc->slices[i];
+    gsize scan = slice->scan;
+
+    if (i == 0) {
+      memcpy (out, slice->data, sos);
+      GST_WRITE_UINT16_BE (out + sof + 5, height);
+      out += sos;
+      out[0] = 0xff;
+      out[1] = 0xdd;
+      GST_WRITE_UINT16_BE (out + 2, 4);
+      GST_WRITE_UINT16_BE (out + 4, restart_interval);
+      out += 6;
+      memcpy (out, slice->data + sos, scan - sos);
+      out += scan - sos;
+    } else {
+      out[0] = 0xff;
+      out[1] = 0xd0 + ((i - 1) & 7);
+      out += 2;
+    }
+    memcpy (out, slice->data + scan, slice->size - 2 - scan);
+    out += slice->size - 2 - scan;
+  }
+  out[0] = 0xff;
+  out[1] = 0xd9;
+
+  gst_memory_unmap (mem, &map);
+
+  gst_jpegenc_finish_output (jpegenc, mem,
+      gst_jpegenc_find_sof_marker (jpegenc->slices[0].data,
+          jpegenc->slices[0].scan));
+
+  return jpegenc->res;
+
+invalid_slice:
+  {
+    gst_video_frame_unmap (&jpegenc->current_vframe);
+    gst_video_encoder_finish_frame (GST_VIDEO_ENCODER (jpegenc),
+        jpegenc->current_frame);
+    jpegenc->current_frame = NULL;
+    GST_ELEMENT_ERROR (jpegenc, STREAM, ENCODE, (NULL),
+        ("Failed to parse encoded slice"));
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstFlowReturn
+gst_jpegenc_handle_frame (GstVideoEncoder * encoder, GstVideoCodecFrame * frame)
+{
+  GstJpegEnc *jpegenc;
+  guint n_threads;
+  static GstAllocationParams params = { 0, 0, 0, 3, };
+
+  jpegenc = GST_JPEGENC (encoder);
+
+  GST_LOG_OBJECT (jpegenc, "got new frame");
+
+  if (!gst_video_frame_map (&jpegenc->current_vframe,
+          &jpegenc->input_state->info, frame->input_buffer, GST_MAP_READ))
+    goto invalid_frame;
+
+  jpegenc->current_frame = frame;
+
+  n_threads = jpegenc->n_threads;
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  if (n_threads > 1) {
+    GstVideoInfo *info = &jpegenc->input_state->info;
+    gint mcu_width = jpegenc->h_max_samp * DCTSIZE;
+    gint mcu_height = jpegenc->v_max_samp * DCTSIZE;
+    guint mcus_per_row, mcu_rows, slice_rows, n_slices;
+
+    mcus_per_row = (GST_VIDEO_INFO_WIDTH (info) + mcu_width - 1) / mcu_width;
+    mcu_rows = (GST_VIDEO_INFO_HEIGHT (info) + mcu_height - 1) / mcu_height;
+    slice_rows = (mcu_rows + n_threads - 1) / n_threads;
+    /* the restart interval is a 16 bit MCU count */
+    slice_rows = MIN (slice_rows, 65535 / mcus_per_row);
+    n_slices = (mcu_rows + slice_rows - 1) / slice_rows;
+
+    if (n_slices > 1)
+      return gst_jpegenc_encode_slices (jpegenc, n_threads, n_slices,
+          slice_rows * mcu_height, slice_rows * mcus_per_row);
   }
 
+  jpegenc->res = GST_FLOW_OK;
+  jpegenc->output_mem = gst_allocator_alloc (NULL, jpegenc->bufsize, &params);
+  gst_memory_map (jpegenc->output_mem, &jpegenc->output_map, GST_MAP_READWRITE);
+
+  jpegenc->jdest.next_output_byte = jpegenc->output_map.data;
+  jpegenc->jdest.free_in_buffer = jpegenc->output_map.size;
+
+  gst_jpegenc_start_compress (jpegenc, &jpegenc->cinfo);
+
+  GST_LOG_OBJECT (jpegenc, "compressing");
+
+  gst_jpegenc_write_rows (jpegenc, &jpegenc->cinfo, jpegenc->line,
+      &jpegenc->current_vframe, 0,
+      GST_VIDEO_INFO_HEIGHT (&jpegenc->input_state->info));
+
   /* This will ensure that gst_jpegenc_term_destination is called */
   jpeg_finish_compress (&jpegenc->cinfo);
   GST_LOG_OBJECT (jpegenc, "compressing done");
@@ -557,6 +941,9 @@ gst_jpegenc_set_property (GObject * object, guint prop_id,
     case PROP_IDCT_METHOD:
       jpegenc->idct_method = g_value_get_enum (value);
       break;
+    case PROP_N_THREADS:
+      jpegenc->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -585,6 +972,9 @@ gst_jpegenc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_IDCT_METHOD:
       g_value_set_enum (value, jpegenc->idct_method);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, jpegenc->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -610,20 +1000,9 @@ static gboolean
 gst_jpegenc_stop (GstVideoEncoder * benc)
 {
   GstJpegEnc *enc = (GstJpegEnc *) benc;
-  gint i, j;
 
-  g_free (enc->line[0]);
-  g_free (enc->line[1]);
-  g_free (enc->line[2]);
-  enc->line[0] = NULL;
-  enc->line[1] = NULL;
-  enc->line[2] = NULL;
-  for (i = 0; i < 3; i++) {
-    for (j = 0; j < 4 * DCTSIZE; j++) {
-      g_free (enc->row[i][j]);
-      enc->row[i][j] = NULL;
-    }
-  }
+  gst_jpegenc_free_lines (enc->line, enc->row);
+  gst_jpegenc_free_slices (enc);
 
   return TRUE;
 }
@@ -48,6 +48,29 @@ G_BEGIN_DECLS
 
 typedef struct _GstJpegEnc GstJpegEnc;
 typedef struct _GstJpegEncClass GstJpegEncClass;
+typedef struct _GstJpegEncSlice GstJpegEncSlice;
+
+/* a strip of MCU rows compressed on its own for sliced encoding */
+struct _GstJpegEncSlice
+{
+  GstJpegEnc *enc;
+  GstVideoFrame *vframe;
+  gint y_start, y_end;
+
+  struct jpeg_compress_struct cinfo;
+  struct jpeg_error_mgr jerr;
+  struct jpeg_destination_mgr jdest;
+
+  guchar **line[3];
+  guchar *row[3][4 * DCTSIZE];
+
+  /* the compressed strip */
+  guint8 *data;
+  gsize alloc_size;
+  gsize size;
+  /* start of the entropy coded data */
+  gsize scan;
+};
 
 struct _GstJpegEnc
 {
@@ -84,9 +107,18 @@ struct _GstJpegEnc
   gint quality;
   gint smoothing;
   gint idct_method;
+  guint n_threads;
 
   GstMemory *output_mem;
   GstMapInfo output_map;
+
+  /* sliced encoding */
+  GstJpegEncSlice *slices;
+  guint n_slices;
+  GThreadPool *slice_pool;
+  GMutex slice_lock;
+  GCond slice_cond;
+  guint slice_pending;
 };
 
 struct _GstJpegEncClass
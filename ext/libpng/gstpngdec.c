@@ -144,8 +144,21 @@ user_info_callback (png_structp png_ptr, png_infop info)
   ret =
       gst_video_decoder_allocate_output_frame (GST_VIDEO_DECODER (pngdec),
       pngdec->current_frame);
-  if (G_UNLIKELY (ret != GST_FLOW_OK))
+  if (G_UNLIKELY (ret != GST_FLOW_OK)) {
     GST_DEBUG_OBJECT (pngdec, "failed to acquire buffer");
+    goto beach;
+  }
+
+  /* rows are decoded straight into the output buffer, which stays mapped
+   * until the image is complete */
+  if (!gst_video_frame_map (&pngdec->output_frame,
+          &pngdec->output_state->info, pngdec->current_frame->output_buffer,
+          GST_MAP_WRITE)) {
+    GST_DEBUG_OBJECT (pngdec, "failed to map output buffer");
+    ret = GST_FLOW_ERROR;
+    goto beach;
+  }
+  pngdec->output_mapped = TRUE;
 
 beach:
   pngdec->ret = ret;
@@ -179,34 +192,28 @@ user_endrow_callback (png_structp png_ptr, png_bytep new_row,
 
   pngdec = GST_PNGDEC (png_get_io_ptr (png_ptr));
 
-  /* FIXME: implement interlaced pictures */
-
-  /* If buffer_out doesn't exist, it means buffer_alloc failed, which 
+  /* If the output frame isn't mapped, it means buffer_alloc failed, which
    * will already have set the return code */
-  if (GST_IS_BUFFER (pngdec->current_frame->output_buffer)) {
-    GstVideoFrame frame;
-    GstBuffer *buffer = pngdec->current_frame->output_buffer;
-    size_t offset;
-    gint width;
-    guint8 *data;
-
-    if (!gst_video_frame_map (&frame, &pngdec->output_state->info, buffer,
-            GST_MAP_WRITE)) {
-      pngdec->ret = GST_FLOW_ERROR;
-      return;
-    }
+  if (pngdec->output_mapped) {
+    guint8 *row = GST_VIDEO_FRAME_COMP_DATA (&pngdec->output_frame, 0) +
+        row_num * GST_VIDEO_FRAME_COMP_STRIDE (&pngdec->output_frame, 0);
 
-    data = GST_VIDEO_FRAME_COMP_DATA (&frame, 0);
-    offset = row_num * GST_VIDEO_FRAME_COMP_STRIDE (&frame, 0);
-    GST_LOG ("got row %u, copying in buffer %p at offset %" G_GSIZE_FORMAT,
-        (guint) row_num, pngdec->current_frame->output_buffer, offset);
-    width = GST_ROUND_UP_4 (png_get_rowbytes (pngdec->png, pngdec->info));
-    memcpy (data + offset, new_row, width);
-    gst_video_frame_unmap (&frame);
+    GST_LOG ("got row %u of pass %d", (guint) row_num, pass);
+    /* combines the pixels of the pass for interlaced images */
+    png_progressive_combine_row (pngdec->png, row, new_row);
     pngdec->ret = GST_FLOW_OK;
   }
 }
 
+static void
+gst_pngdec_unmap_output (GstPngDec * pngdec)
+{
+  if (pngdec->output_mapped) {
+    gst_video_frame_unmap (&pngdec->output_frame);
+    pngdec->output_mapped = FALSE;
+  }
+}
+
 static void
 user_end_callback (png_structp png_ptr, png_infop info)
 {
@@ -219,6 +226,7 @@ user_end_callback (png_structp png_ptr, png_infop info)
   if (!pngdec->current_frame->output_buffer)
     return;
 
+  gst_pngdec_unmap_output (pngdec);
   gst_buffer_unmap (pngdec->current_frame->input_buffer,
       &pngdec->current_frame_map);
 
@@ -286,6 +294,9 @@ gst_pngdec_caps_create_and_set (GstPngDec * pngdec)
     png_set_palette_to_rgb (pngdec->png);
   }
 
+  /* Interlaced images are assembled in the output frame pass by pass */
+  png_set_interlace_handling (pngdec->png);
+
   /* Update the info structure */
   png_read_update_info (pngdec->png, pngdec->info);
 
@@ -378,8 +389,12 @@ gst_pngdec_handle_frame (GstVideoDecoder * decoder, GstVideoCodecFrame * frame)
     goto beach;
   }
 
+  /* the start of the frame may already have been decoded while parsing */
+  if (pngdec->fed > pngdec->current_frame_map.size)
+    pngdec->fed = 0;
   png_process_data (pngdec->png, pngdec->info,
-      pngdec->current_frame_map.data, pngdec->current_frame_map.size);
+      pngdec->current_frame_map.data + pngdec->fed,
+      pngdec->current_frame_map.size - pngdec->fed);
 
   if (pngdec->image_ready) {
     /* Reset ourselves for the next frame */
@@ -400,6 +415,32 @@ beach:
   return ret;
 }
 
+/* Gives the complete chunks of the frame parsed so far to libpng, so rows
+ * are decoded while the rest of the image is still arriving */
+static gboolean
+gst_pngdec_feed (GstPngDec * pngdec, GstVideoCodecFrame * frame,
+    const guint8 * data, gsize size)
+{
+  if (size <= pngdec->fed)
+    return TRUE;
+
+  /* Let libpng come back here on error */
+  if (setjmp (png_jmpbuf (pngdec->png))) {
+    GST_WARNING_OBJECT (pngdec, "error during decoding");
+    return FALSE;
+  }
+
+  GST_LOG_OBJECT (pngdec, "decoding %" G_GSIZE_FORMAT " bytes while parsing",
+      size - pngdec->fed);
+
+  pngdec->current_frame = frame;
+  png_process_data (pngdec->png, pngdec->info, (png_bytep) data + pngdec->fed,
+      size - pngdec->fed);
+  pngdec->fed = size;
+
+  return TRUE;
+}
+
 /* Based on pngparse */
 #define PNG_SIGNATURE G_GUINT64_CONSTANT (0x89504E470D0A1A0A)
 
@@ -407,9 +448,10 @@ static GstFlowReturn
 gst_pngdec_parse (GstVideoDecoder * decoder, GstVideoCodecFrame * frame,
     GstAdapter * adapter, gboolean at_eos)
 {
-  gsize toadd = 0;
+  GstPngDec *pngdec = (GstPngDec *) decoder;
+  gsize toadd = 0, complete = 0;
   GstByteReader reader;
-  gconstpointer data;
+  gconstpointer data = NULL;
   guint64 signature;
   gsize size;
 
@@ -480,15 +522,22 @@ gst_pngdec_parse (GstVideoDecoder * decoder, GstVideoCodecFrame * frame,
           toadd);
       goto have_full_frame;
     }
+
+    /* the IEND chunk is left for handle_frame, which finishes the frame */
+    complete = gst_byte_reader_get_pos (&reader);
   }
 
   g_assert_not_reached ();
   return GST_FLOW_ERROR;
 
 need_more_data:
+  if (complete > 0 && !gst_pngdec_feed (pngdec, frame, data, complete))
+    return GST_FLOW_ERROR;
   return GST_VIDEO_DECODER_FLOW_NEED_DATA;
 
 have_full_frame:
+  if (complete > 0 && !gst_pngdec_feed (pngdec, frame, data, complete))
+    return GST_FLOW_ERROR;
   if (toadd)
     gst_video_decoder_add_to_frame (decoder, toadd);
   return gst_video_decoder_have_frame (decoder);
@@ -591,6 +640,8 @@ gst_pngdec_libpng_clear (GstPngDec * pngdec)
     pngdec->endinfo = NULL;
   }
 
+  gst_pngdec_unmap_output (pngdec);
+  pngdec->fed = 0;
   pngdec->color_type = -1;
 }
 
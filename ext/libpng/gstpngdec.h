@@ -47,6 +47,13 @@ struct _GstPngDec
   GstMapInfo current_frame_map;
   GstVideoCodecFrame *current_frame;
 
+  /* output frame the rows are decoded into */
+  GstVideoFrame output_frame;
+  gboolean output_mapped;
+
+  /* bytes of the current frame already given to libpng while parsing */
+  gsize fed;
+
   GstFlowReturn ret;
 
   png_structp png;
@@ -47,12 +47,14 @@ enum
 
 #define DEFAULT_SNAPSHOT                FALSE
 #define DEFAULT_COMPRESSION_LEVEL       6
+#define DEFAULT_N_THREADS               1
 
 enum
 {
   ARG_0,
   ARG_SNAPSHOT,
-  ARG_COMPRESSION_LEVEL
+  ARG_COMPRESSION_LEVEL,
+  ARG_N_THREADS
 };
 
 static GstStaticPadTemplate pngenc_src_template =
@@ -128,6 +130,21 @@ gst_pngenc_class_init (GstPngEncClass * klass)
           DEFAULT_COMPRESSION_LEVEL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstPngEnc:n-threads:
+   *
+   * Number of threads used to compress a frame. With more than one thread
+   * the rows are split into stripes that are deflated independently and
+   * written as separate IDAT chunks of one zlib stream.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, ARG_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads used to compress a frame "
+          "(0 = number of processors)", 0, G_MAXUINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template
       (element_class, gst_static_pad_template_get (&pngenc_sink_template));
   gst_element_class_add_pad_template
@@ -205,6 +222,10 @@ gst_pngenc_init (GstPngEnc * pngenc)
 
   pngenc->snapshot = DEFAULT_SNAPSHOT;
   pngenc->compression_level = DEFAULT_COMPRESSION_LEVEL;
+  pngenc->n_threads = DEFAULT_N_THREADS;
+
+  g_mutex_init (&pngenc->stripe_lock);
+  g_cond_init (&pngenc->stripe_cond);
 }
 
 static void
@@ -215,6 +236,11 @@ gst_pngenc_finalize (GObject * object)
   if (pngenc->input_state)
     gst_video_codec_state_unref (pngenc->input_state);
 
+  if (pngenc->stripe_pool)
+    g_thread_pool_free (pngenc->stripe_pool, FALSE, TRUE);
+  g_mutex_clear (&pngenc->stripe_lock);
+  g_cond_clear (&pngenc->stripe_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -257,6 +283,247 @@ user_write_data (png_structp png_ptr, png_bytep data, png_uint_32 length)
   gst_buffer_append_memory (pngenc->buffer_out, mem);
 }
 
+/* the zlib stream header as deflate would write it for the level */
+static void
+gst_pngenc_write_zlib_header (guint8 * out, guint level)
+{
+  guint cmf = 0x78, flg;
+
+  if (level < 2)
+    flg = 0 << 6;
+  else if (level < 6)
+    flg = 1 << 6;
+  else if (level == 6)
+    flg = 2 << 6;
+  else
+    flg = 3 << 6;
+  flg += 31 - ((cmf * 256 + flg) % 31);
+
+  out[0] = cmf;
+  out[1] = flg;
+}
+
+/* runs deflate on the input, growing the chunk as needed. 8 bytes stay
+ * free at the end for the adler32 and CRC fields */
+static gboolean
+gst_pngenc_deflate (GstPngEncStripe * stripe, z_stream * zs,
+    const guint8 * in, gsize size, gint flush)
+{
+  zs->next_in = (Bytef *) in;
+  zs->avail_in = size;
+
+  for (;;) {
+    gint zret;
+
+    if (zs->avail_out == 0) {
+      gsize used = zs->next_out - stripe->data;
+
+      stripe->alloc_size *= 2;
+      stripe->data = g_realloc (stripe->data, stripe->alloc_size);
+      zs->next_out = stripe->data + used;
+      zs->avail_out = stripe->alloc_size - used - 8;
+    }
+
+    zret = deflate (zs, flush);
+    if (zret == Z_STREAM_ERROR)
+      return FALSE;
+
+    if (flush == Z_FINISH) {
+      if (zret == Z_STREAM_END)
+        break;
+    } else if (zs->avail_in == 0 && zs->avail_out != 0) {
+      break;
+    }
+  }
+
+  return TRUE;
+}
+
+/* Deflates the rows of a stripe as a raw deflate stream. All but the last
+ * stripe end with a sync flush so the streams can be concatenated, like
+ * pigz does, and the window is primed with the rows before the stripe. */
+static void
+gst_pngenc_encode_stripe (GstPngEncStripe * stripe)
+{
+  GstPngEnc *pngenc = stripe->enc;
+  GstVideoFrame *vframe = stripe->vframe;
+  guint8 *pixels = GST_VIDEO_FRAME_COMP_DATA (vframe, 0);
+  gint stride = GST_VIDEO_FRAME_COMP_STRIDE (vframe, 0);
+  gsize rowbytes = GST_VIDEO_FRAME_WIDTH (vframe) *
+      GST_VIDEO_FRAME_COMP_PSTRIDE (vframe, 0);
+  guint8 filter = PNG_FILTER_VALUE_NONE;
+  gsize offset = 8;
+  z_stream zs;
+  gint y;
+
+  stripe->ok = FALSE;
+
+  memset (&zs, 0, sizeof (zs));
+  if (deflateInit2 (&zs, pngenc->compression_level, Z_DEFLATED, -MAX_WBITS,
+          8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return;
+
+  if (stripe->y_start > 0) {
+    gint n_rows = MIN (stripe->y_start, 32768 / (rowbytes + 1) + 1);
+    gsize dict_size = n_rows * (rowbytes + 1);
+    guint8 *dict = g_malloc (dict_size), *d = dict;
+
+    for (y = stripe->y_start - n_rows; y < stripe->y_start; y++) {
+      *d++ = filter;
+      memcpy (d, pixels + y * stride, rowbytes);
+      d += rowbytes;
+    }
+    if (dict_size > 32768) {
+      deflateSetDictionary (&zs, dict + dict_size - 32768, 32768);
+    } else {
+      deflateSetDictionary (&zs, dict, dict_size);
+    }
+    g_free (dict);
+  } else {
+    /* the first stripe starts the zlib stream */
+    offset += 2;
+  }
+
+  stripe->in_size = (stripe->y_end - stripe->y_start) * (rowbytes + 1);
+  stripe->size = 0;
+  stripe->alloc_size = offset + deflateBound (&zs, stripe->in_size) + 64;
+  stripe->data = g_realloc (stripe->data, stripe->alloc_size);
+  if (stripe->y_start == 0)
+    gst_pngenc_write_zlib_header (stripe->data + 8, pngenc->compression_level);
+  zs.next_out = stripe->data + offset;
+  zs.avail_out = stripe->alloc_size - offset - 8;
+
+  stripe->adler = adler32 (0, NULL, 0);
+  for (y = stripe->y_start; y < stripe->y_end; y++) {
+    guint8 *row = pixels + y * stride;
+    gint flush = Z_NO_FLUSH;
+
+    if (y == stripe->y_end - 1)
+      flush = stripe->last ? Z_FINISH : Z_SYNC_FLUSH;
+
+    stripe->adler = adler32 (stripe->adler, &filter, 1);
+    stripe->adler = adler32 (stripe->adler, row, rowbytes);
+    if (!gst_pngenc_deflate (stripe, &zs, &filter, 1, Z_NO_FLUSH) ||
+        !gst_pngenc_deflate (stripe, &zs, row, rowbytes, flush)) {
+      deflateEnd (&zs);
+      return;
+    }
+  }
+  stripe->size = zs.next_out - stripe->data;
+  deflateEnd (&zs);
+
+  GST_WRITE_UINT32_BE (stripe->data, stripe->size - 8);
+  memcpy (stripe->data + 4, "IDAT", 4);
+  if (!stripe->last) {
+    GST_WRITE_UINT32_BE (stripe->data + stripe->size,
+        crc32 (0, stripe->data + 4, stripe->size - 4));
+    stripe->size += 4;
+  }
+
+  stripe->ok = TRUE;
+}
+
+static void
+gst_pngenc_stripe_func (gpointer data, gpointer user_data)
+{
+  GstPngEncStripe *stripe = data;
+  GstPngEnc *pngenc = stripe->enc;
+
+  gst_pngenc_encode_stripe (stripe);
+
+  g_mutex_lock (&pngenc->stripe_lock);
+  if (--pngenc->stripe_pending == 0)
+    g_cond_signal (&pngenc->stripe_cond);
+  g_mutex_unlock (&pngenc->stripe_lock);
+}
+
+/* Writes the image data as one IDAT chunk per stripe and the IEND chunk
+ * to the output buffer */
+static gboolean
+gst_pngenc_encode_stripes (GstPngEnc * pngenc, GstVideoFrame * vframe,
+    guint n_stripes)
+{
+  static const guint8 iend[] = {
+    0, 0, 0, 0, 'I', 'E', 'N', 'D', 0xae, 0x42, 0x60, 0x82
+  };
+  gint height = GST_VIDEO_FRAME_HEIGHT (vframe);
+  gint stripe_height = (height + n_stripes - 1) / n_stripes;
+  GstPngEncStripe *stripes, *last;
+  gboolean ret = TRUE;
+  gulong adler;
+  guint i;
+
+  /* no empty stripes */
+  n_stripes = (height + stripe_height - 1) / stripe_height;
+
+  stripes = g_new0 (GstPngEncStripe, n_stripes);
+  for (i = 0; i < n_stripes; i++) {
+    stripes[i].enc = pngenc;
+    stripes[i].vframe = vframe;
+    stripes[i].y_start = i * stripe_height;
+    stripes[i].y_end = MIN ((i + 1) * stripe_height, height);
+    stripes[i].last = (i == n_stripes - 1);
+  }
+
+  if (pngenc->stripe_pool == NULL) {
+    pngenc->stripe_pool =
+        g_thread_pool_new (gst_pngenc_stripe_func, NULL, n_stripes - 1,
+        FALSE, NULL);
+  } else if (g_thread_pool_get_max_threads (pngenc->stripe_pool) <
+      n_stripes - 1) {
+    g_thread_pool_set_max_threads (pngenc->stripe_pool, n_stripes - 1, NULL);
+  }
+
+  GST_LOG_OBJECT (pngenc, "deflating %u stripes of %d rows", n_stripes,
+      stripe_height);
+
+  pngenc->stripe_pending = n_stripes - 1;
+  for (i = 1; i < n_stripes; i++)
+    g_thread_pool_push (pngenc->stripe_pool, &stripes[i], NULL);
+
+  gst_pngenc_encode_stripe (&stripes[0]);
+
+  g_mutex_lock (&pngenc->stripe_lock);
+  while (pngenc->stripe_pending > 0)
+    g_cond_wait (&pngenc->stripe_cond, &pngenc->stripe_lock);
+  g_mutex_unlock (&pngenc->stripe_lock);
+
+  adler = stripes[0].adler;
+  for (i = 0; i < n_stripes; i++) {
+    if (!stripes[i].ok)
+      ret = FALSE;
+    if (i > 0)
+      adler = adler32_combine (adler, stripes[i].adler, stripes[i].in_size);
+  }
+
+  if (ret) {
+    /* the last chunk ends the zlib stream */
+    last = &stripes[n_stripes - 1];
+    GST_WRITE_UINT32_BE (last->data + last->size, adler);
+    last->size += 4;
+    GST_WRITE_UINT32_BE (last->data, last->size - 8);
+    GST_WRITE_UINT32_BE (last->data + last->size,
+        crc32 (0, last->data + 4, last->size - 4));
+    last->size += 4;
+
+    for (i = 0; i < n_stripes; i++) {
+      gst_buffer_append_memory (pngenc->buffer_out,
+          gst_memory_new_wrapped (0, stripes[i].data, stripes[i].alloc_size,
+              0, stripes[i].size, stripes[i].data, g_free));
+      stripes[i].data = NULL;
+    }
+    gst_buffer_append_memory (pngenc->buffer_out,
+        gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, (gpointer) iend,
+            sizeof (iend), 0, sizeof (iend), NULL, NULL));
+  }
+
+  for (i = 0; i < n_stripes; i++)
+    g_free (stripes[i].data);
+  g_free (stripes);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_pngenc_handle_frame (GstVideoEncoder * encoder, GstVideoCodecFrame * frame)
 {
@@ -266,6 +533,7 @@ gst_pngenc_handle_frame (GstVideoEncoder * encoder, GstVideoCodecFrame * frame)
   GstFlowReturn ret = GST_FLOW_OK;
   GstVideoInfo *info;
   GstVideoFrame vframe;
+  guint n_stripes;
 
   pngenc = GST_PNGENC (encoder);
   info = &pngenc->input_state->info;
@@ -319,9 +587,20 @@ gst_pngenc_handle_frame (GstVideoEncoder * encoder, GstVideoCodecFrame * frame)
   /* allocate the output buffer */
   pngenc->buffer_out = gst_buffer_new ();
 
+  n_stripes = pngenc->n_threads;
+  if (n_stripes == 0)
+    n_stripes = g_get_num_processors ();
+  /* at least 16 rows per stripe */
+  n_stripes = MIN (n_stripes, GST_VIDEO_INFO_HEIGHT (info) / 16);
+
   png_write_info (pngenc->png_struct_ptr, pngenc->png_info_ptr);
-  png_write_image (pngenc->png_struct_ptr, row_pointers);
-  png_write_end (pngenc->png_struct_ptr, NULL);
+  if (n_stripes > 1) {
+    if (!gst_pngenc_encode_stripes (pngenc, &vframe, n_stripes))
+      goto compress_fail;
+  } else {
+    png_write_image (pngenc->png_struct_ptr, row_pointers);
+    png_write_end (pngenc->png_struct_ptr, NULL);
+  }
 
   g_free (row_pointers);
   gst_video_frame_unmap (&vframe);
@@ -361,6 +640,18 @@ png_info_fail:
     return GST_FLOW_ERROR;
   }
 
+compress_fail:
+  {
+    g_free (row_pointers);
+    gst_video_frame_unmap (&vframe);
+    gst_buffer_unref (pngenc->buffer_out);
+    pngenc->buffer_out = NULL;
+    png_destroy_write_struct (&pngenc->png_struct_ptr, &pngenc->png_info_ptr);
+    GST_ELEMENT_ERROR (pngenc, LIBRARY, ENCODE, (NULL),
+        ("Failed to compress the image"));
+    return GST_FLOW_ERROR;
+  }
+
 longjmp_fail:
   {
     png_destroy_write_struct (&pngenc->png_struct_ptr, &pngenc->png_info_ptr);
@@ -394,6 +685,9 @@ gst_pngenc_get_property (GObject * object,
     case ARG_COMPRESSION_LEVEL:
       g_value_set_uint (value, pngenc->compression_level);
       break;
+    case ARG_N_THREADS:
+      g_value_set_uint (value, pngenc->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -416,6 +710,9 @@ gst_pngenc_set_property (GObject * object,
     case ARG_COMPRESSION_LEVEL:
       pngenc->compression_level = g_value_get_uint (value);
       break;
+    case ARG_N_THREADS:
+      pngenc->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -40,6 +40,26 @@ extern "C" {
 
 typedef struct _GstPngEnc GstPngEnc;
 typedef struct _GstPngEncClass GstPngEncClass;
+typedef struct _GstPngEncStripe GstPngEncStripe;
+
+/* a strip of rows deflated on its own for parallel encoding */
+struct _GstPngEncStripe
+{
+  GstPngEnc *enc;
+  GstVideoFrame *vframe;
+  gint y_start, y_end;
+  gboolean last;
+
+  /* an IDAT chunk, CRC not yet written for the last stripe */
+  guint8 *data;
+  gsize alloc_size;
+  gsize size;
+
+  /* checksum and size of the uncompressed data */
+  gulong adler;
+  gsize in_size;
+  gboolean ok;
+};
 
 struct _GstPngEnc
 {
@@ -57,6 +77,14 @@ struct _GstPngEnc
 
   gboolean snapshot;
   gboolean newmedia;
+
+  guint n_threads;
+
+  /* parallel encoding */
+  GThreadPool *stripe_pool;
+  GMutex stripe_lock;
+  GCond stripe_cond;
+  guint stripe_pending;
 };
 
 struct _GstPngEncClass
@@ -71,6 +71,13 @@ GST_DEBUG_CATEGORY_EXTERN (pulse_debug);
 #define DEFAULT_DEVICE_NAME     NULL
 #define DEFAULT_VOLUME          1.0
 #define DEFAULT_MUTE            FALSE
+#define DEFAULT_ADAPT_LATENCY   FALSE
+
+/* adaptive buffering grows tlength by one segment per underflow, up to this
+ * many times the configured tlength, and gives a segment back after this
+ * long without underflows */
+#define ADAPT_MAX_FACTOR        4
+#define ADAPT_STABLE_TIME       (10 * G_USEC_PER_SEC)
 #define MAX_VOLUME              10.0
 
 enum
@@ -84,6 +91,7 @@ enum
   PROP_MUTE,
   PROP_CLIENT_NAME,
   PROP_STREAM_PROPERTIES,
+  PROP_ADAPT_LATENCY,
   PROP_LAST
 };
 
@@ -121,7 +129,8 @@ static GHashTable *gst_pulse_shared_contexts = NULL;
 
 /* use one static main-loop for all instances
  * this is needed to make the context sharing work as the contexts are
- * released when releasing their parent main-loop
+ * released when releasing their parent main-loop. The main-loop itself is
+ * the one shared with pulsesrc, see gst_pulse_shared_mainloop_ref().
  */
 static pa_threaded_mainloop *mainloop = NULL;
 static guint mainloop_ref_ct = 0;
@@ -153,9 +162,15 @@ struct _GstPulseRingBuffer
   gint64 m_offset;
   gint64 m_lastoffset;
 
+  /* adaptive buffering */
+  guint32 base_tlength;
+  gint64 last_adapt;
+  guint underflows;
+
   gboolean corked:1;
   gboolean in_commit:1;
   gboolean paused:1;
+  gboolean adapting:1;
 };
 struct _GstPulseRingBufferClass
 {
@@ -240,9 +255,14 @@ gst_pulseringbuffer_init (GstPulseRingBuffer * pbuf)
   pbuf->m_offset = 0;
   pbuf->m_lastoffset = 0;
 
+  pbuf->base_tlength = 0;
+  pbuf->last_adapt = 0;
+  pbuf->underflows = 0;
+
   pbuf->corked = TRUE;
   pbuf->in_commit = FALSE;
   pbuf->paused = FALSE;
+  pbuf->adapting = FALSE;
 }
 
 /* Call with mainloop lock held if wait == TRUE) */
@@ -666,6 +686,73 @@ gst_pulsering_stream_request_cb (pa_stream * s, size_t length, void *userdata)
   }
 }
 
+static void
+gst_pulsering_buffer_attr_cb (pa_stream * s, int success, void *userdata)
+{
+  GstPulseSink *psink;
+  GstPulseRingBuffer *pbuf;
+  GstAudioRingBuffer *ringbuf;
+  const pa_buffer_attr *actual;
+
+  pbuf = GST_PULSERING_BUFFER_CAST (userdata);
+  psink = GST_PULSESINK_CAST (GST_OBJECT_PARENT (pbuf));
+  ringbuf = GST_AUDIO_RING_BUFFER_CAST (pbuf);
+
+  pbuf->adapting = FALSE;
+
+  if (!success || !(actual = pa_stream_get_buffer_attr (s))) {
+    GST_WARNING_OBJECT (psink, "could not change the buffer attributes");
+    return;
+  }
+
+  GST_INFO_OBJECT (psink, "tlength now %u, %u underflows so far",
+      actual->tlength, pbuf->underflows);
+
+  /* the data queued in the server is our latency, let the pipeline know */
+  ringbuf->spec.seglatency = actual->tlength / ringbuf->spec.segsize;
+  gst_element_post_message (GST_ELEMENT_CAST (psink),
+      gst_message_new_latency (GST_OBJECT_CAST (psink)));
+}
+
+/* Grow the buffer in the server by one segment, or give one back. Call with
+ * the mainloop lock. */
+static void
+gst_pulsering_adapt_tlength (GstPulseRingBuffer * pbuf, gboolean grow)
+{
+  GstPulseSink *psink;
+  const pa_buffer_attr *actual;
+  pa_buffer_attr attr;
+  pa_operation *o;
+
+  psink = GST_PULSESINK_CAST (GST_OBJECT_PARENT (pbuf));
+
+  /* one change at a time, a burst of underflows is one problem */
+  if (pbuf->adapting || !(actual = pa_stream_get_buffer_attr (pbuf->stream)))
+    return;
+
+  attr = *actual;
+  if (grow) {
+    if (attr.tlength + attr.minreq > pbuf->base_tlength * ADAPT_MAX_FACTOR)
+      return;
+    attr.tlength += attr.minreq;
+  } else {
+    if (attr.tlength <= pbuf->base_tlength)
+      return;
+    attr.tlength -= MIN (attr.minreq, attr.tlength - pbuf->base_tlength);
+  }
+
+  GST_DEBUG_OBJECT (psink, "%s tlength to %u", grow ? "growing" : "shrinking",
+      attr.tlength);
+
+  if (!(o = pa_stream_set_buffer_attr (pbuf->stream, &attr,
+              gst_pulsering_buffer_attr_cb, pbuf)))
+    return;
+
+  pa_operation_unref (o);
+  pbuf->adapting = TRUE;
+  pbuf->last_adapt = g_get_monotonic_time ();
+}
+
 static void
 gst_pulsering_stream_underflow_cb (pa_stream * s, void *userdata)
 {
@@ -676,6 +763,10 @@ gst_pulsering_stream_underflow_cb (pa_stream * s, void *userdata)
   psink = GST_PULSESINK_CAST (GST_OBJECT_PARENT (pbuf));
 
   GST_WARNING_OBJECT (psink, "Got underflow");
+
+  pbuf->underflows++;
+  if (psink->adapt_latency && !pbuf->paused)
+    gst_pulsering_adapt_tlength (pbuf, TRUE);
 }
 
 static void
@@ -725,6 +816,12 @@ gst_pulsering_stream_latency_cb (pa_stream * s, void *userdata)
 
   sink_usec = info->configured_sink_usec;
 
+  /* latency updates come every 100ms, good enough to see that we have been
+   * running without underflows for a while */
+  if (psink->adapt_latency && pbuf->last_adapt != 0 &&
+      g_get_monotonic_time () - pbuf->last_adapt > ADAPT_STABLE_TIME)
+    gst_pulsering_adapt_tlength (pbuf, FALSE);
+
   GST_LOG_OBJECT (psink,
       "latency_update, %" G_GUINT64_FORMAT ", %d:%" G_GINT64_FORMAT ", %d:%"
       G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT ", %" G_GUINT64_FORMAT,
@@ -1016,6 +1113,11 @@ gst_pulseringbuffer_acquire (GstAudioRingBuffer * buf,
   spec->segsize = actual->minreq;
   spec->segtotal = actual->tlength / spec->segsize;
 
+  pbuf->base_tlength = actual->tlength;
+  pbuf->last_adapt = 0;
+  pbuf->underflows = 0;
+  pbuf->adapting = FALSE;
+
   pa_threaded_mainloop_unlock (mainloop);
 
   return TRUE;
@@ -1933,6 +2035,23 @@ gst_pulsesink_class_init (GstPulseSinkClass * klass)
           "list of pulseaudio stream properties",
           GST_TYPE_STRUCTURE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstPulseSink:adapt-latency:
+   *
+   * Grow the amount of data queued in the server by one segment after each
+   * underflow, and shrink it again slowly once playback has been stable.
+   * This allows to start with a small #GstAudioBaseSink:buffer-time and only
+   * pay for more latency on systems that need it. The reported latency
+   * follows the changes.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_ADAPT_LATENCY,
+      g_param_spec_boolean ("adapt-latency", "Adapt latency",
+          "Grow the server side buffer after underflows", DEFAULT_ADAPT_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "PulseAudio Audio Sink",
       "Sink/Audio", "Plays audio to a PulseAudio server", "Lennart Poettering");
@@ -2322,6 +2441,8 @@ gst_pulsesink_init (GstPulseSink * pulsesink)
 
   pulsesink->notify = 0;
 
+  pulsesink->adapt_latency = DEFAULT_ADAPT_LATENCY;
+
   g_atomic_int_set (&pulsesink->format_lost, FALSE);
   pulsesink->format_lost_time = GST_CLOCK_TIME_NONE;
 
@@ -2845,6 +2966,9 @@ gst_pulsesink_set_property (GObject * object,
         pa_proplist_free (pulsesink->proplist);
       pulsesink->proplist = gst_pulse_make_proplist (pulsesink->properties);
       break;
+    case PROP_ADAPT_LATENCY:
+      pulsesink->adapt_latency = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2899,6 +3023,9 @@ gst_pulsesink_get_property (GObject * object,
     case PROP_STREAM_PROPERTIES:
       gst_value_set_structure (value, pulsesink->properties);
       break;
+    case PROP_ADAPT_LATENCY:
+      g_value_set_boolean (value, pulsesink->adapt_latency);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3171,9 +3298,8 @@ gst_pulsesink_release_mainloop (GstPulseSink * psink)
   g_mutex_lock (&pa_shared_resource_mutex);
   mainloop_ref_ct--;
   if (!mainloop_ref_ct) {
-    GST_INFO_OBJECT (psink, "terminating pa main loop thread");
-    pa_threaded_mainloop_stop (mainloop);
-    pa_threaded_mainloop_free (mainloop);
+    GST_INFO_OBJECT (psink, "releasing pa main loop");
+    gst_pulse_shared_mainloop_unref ();
     mainloop = NULL;
   }
   g_mutex_unlock (&pa_shared_resource_mutex);
@@ -3189,13 +3315,9 @@ gst_pulsesink_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_NULL_TO_READY:
       g_mutex_lock (&pa_shared_resource_mutex);
       if (!mainloop_ref_ct) {
-        GST_INFO_OBJECT (element, "new pa main loop thread");
-        if (!(mainloop = pa_threaded_mainloop_new ()))
+        GST_INFO_OBJECT (element, "acquiring pa main loop");
+        if (!(mainloop = gst_pulse_shared_mainloop_ref ()))
           goto mainloop_failed;
-        if (pa_threaded_mainloop_start (mainloop) < 0) {
-          pa_threaded_mainloop_free (mainloop);
-          goto mainloop_start_failed;
-        }
         mainloop_ref_ct = 1;
         g_mutex_unlock (&pa_shared_resource_mutex);
       } else {
@@ -3239,14 +3361,7 @@ mainloop_failed:
   {
     g_mutex_unlock (&pa_shared_resource_mutex);
     GST_ELEMENT_ERROR (pulsesink, RESOURCE, FAILED,
-        ("pa_threaded_mainloop_new() failed"), (NULL));
-    return GST_STATE_CHANGE_FAILURE;
-  }
-mainloop_start_failed:
-  {
-    g_mutex_unlock (&pa_shared_resource_mutex);
-    GST_ELEMENT_ERROR (pulsesink, RESOURCE, FAILED,
-        ("pa_threaded_mainloop_start() failed"), (NULL));
+        ("Failed to start the pa main loop"), (NULL));
     return GST_STATE_CHANGE_FAILURE;
   }
 state_failure:
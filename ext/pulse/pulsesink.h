@@ -78,6 +78,8 @@ struct _GstPulseSink
 
   gint notify; /* atomic */
 
+  gboolean adapt_latency;
+
   const gchar *pa_version;
 
   GstStructure *properties;
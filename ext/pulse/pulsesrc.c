@@ -75,6 +75,25 @@ enum
   PROP_LAST
 };
 
+typedef struct _GstPulseSrcContext GstPulseSrcContext;
+
+/* Store the PA contexts in a hash table to allow sharing them among
+ * multiple instances of the source. Keys are $client_name@$server_name
+ * (strings) and values are GstPulseSrcContext pointers.
+ */
+struct _GstPulseSrcContext
+{
+  pa_context *context;
+  GSList *srcs;
+};
+
+static GHashTable *gst_pulsesrc_shared_contexts = NULL;
+
+/* All instances run on the main-loop shared with pulsesink, see
+ * gst_pulse_shared_mainloop_ref(). Both the hash table and the source lists
+ * are only accessed with that main-loop's lock held.
+ */
+
 static void gst_pulsesrc_destroy_stream (GstPulseSrc * pulsesrc);
 static void gst_pulsesrc_destroy_context (GstPulseSrc * pulsesrc);
 
@@ -128,6 +147,9 @@ gst_pulsesrc_class_init (GstPulseSrcClass * klass)
   GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
   gchar *clientname;
 
+  gst_pulsesrc_shared_contexts = g_hash_table_new_full (g_str_hash,
+      g_str_equal, g_free, NULL);
+
   gobject_class->finalize = gst_pulsesrc_finalize;
   gobject_class->set_property = gst_pulsesrc_set_property;
   gobject_class->get_property = gst_pulsesrc_get_property;
@@ -252,7 +274,9 @@ gst_pulsesrc_init (GstPulseSrc * pulsesrc)
   pulsesrc->client_name = gst_pulse_client_name ();
   pulsesrc->device_description = NULL;
 
+  pulsesrc->mainloop = NULL;
   pulsesrc->context = NULL;
+  pulsesrc->context_name = NULL;
   pulsesrc->stream = NULL;
   pulsesrc->stream_connected = FALSE;
   pulsesrc->source_output_idx = PA_INVALID_INDEX;
@@ -313,15 +337,40 @@ gst_pulsesrc_destroy_context (GstPulseSrc * pulsesrc)
   gst_pulsesrc_destroy_stream (pulsesrc);
 
   if (pulsesrc->context) {
-    pa_context_disconnect (pulsesrc->context);
+    pa_context_unref (pulsesrc->context);
+    pulsesrc->context = NULL;
+  }
 
-    /* Make sure we don't get any further callbacks */
-    pa_context_set_state_callback (pulsesrc->context, NULL, NULL);
-    pa_context_set_subscribe_callback (pulsesrc->context, NULL, NULL);
+  if (pulsesrc->context_name) {
+    GstPulseSrcContext *pctx;
 
-    pa_context_unref (pulsesrc->context);
+    pctx = g_hash_table_lookup (gst_pulsesrc_shared_contexts,
+        pulsesrc->context_name);
 
-    pulsesrc->context = NULL;
+    GST_DEBUG_OBJECT (pulsesrc, "releasing context with name %s, pctx=%p",
+        pulsesrc->context_name, pctx);
+
+    if (pctx) {
+      pctx->srcs = g_slist_remove (pctx->srcs, pulsesrc);
+      if (pctx->srcs == NULL) {
+        GST_DEBUG_OBJECT (pulsesrc, "destroying final context with name %s",
+            pulsesrc->context_name);
+
+        pa_context_disconnect (pctx->context);
+
+        /* Make sure we don't get any further callbacks */
+        pa_context_set_state_callback (pctx->context, NULL, NULL);
+        pa_context_set_subscribe_callback (pctx->context, NULL, NULL);
+
+        g_hash_table_remove (gst_pulsesrc_shared_contexts,
+            pulsesrc->context_name);
+
+        pa_context_unref (pctx->context);
+        g_slice_free (GstPulseSrcContext, pctx);
+      }
+    }
+    g_free (pulsesrc->context_name);
+    pulsesrc->context_name = NULL;
   }
 }
 
@@ -874,13 +923,13 @@ gst_pulsesrc_get_property (GObject * object,
 static void
 gst_pulsesrc_context_state_cb (pa_context * c, void *userdata)
 {
-  GstPulseSrc *pulsesrc = GST_PULSESRC_CAST (userdata);
+  pa_threaded_mainloop *ml = (pa_threaded_mainloop *) userdata;
 
   switch (pa_context_get_state (c)) {
     case PA_CONTEXT_READY:
     case PA_CONTEXT_TERMINATED:
     case PA_CONTEXT_FAILED:
-      pa_threaded_mainloop_signal (pulsesrc->mainloop, 0);
+      pa_threaded_mainloop_signal (ml, 0);
       break;
 
     case PA_CONTEXT_UNCONNECTED:
@@ -962,28 +1011,34 @@ static void
 gst_pulsesrc_context_subscribe_cb (pa_context * c,
     pa_subscription_event_type_t t, uint32_t idx, void *userdata)
 {
-  GstPulseSrc *psrc = GST_PULSESRC (userdata);
+  GstPulseSrcContext *pctx = (GstPulseSrcContext *) userdata;
+  GSList *walk;
 
   if (t != (PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT | PA_SUBSCRIPTION_EVENT_CHANGE)
       && t != (PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT | PA_SUBSCRIPTION_EVENT_NEW))
     return;
 
-  if (idx != psrc->source_output_idx)
-    return;
+  for (walk = pctx->srcs; walk; walk = g_slist_next (walk)) {
+    GstPulseSrc *psrc = GST_PULSESRC_CAST (walk->data);
 
-  /* Actually this event is also triggered when other properties of the stream
-   * change that are unrelated to the volume. However it is probably cheaper to
-   * signal the change here and check for the volume when the GObject property
-   * is read instead of querying it always. */
+    if (idx != psrc->source_output_idx)
+      continue;
 
-  /* inform streaming thread to notify */
-  g_atomic_int_compare_and_exchange (&psrc->notify, 0, 1);
+    /* Actually this event is also triggered when other properties of the
+     * stream change that are unrelated to the volume. However it is probably
+     * cheaper to signal the change here and check for the volume when the
+     * GObject property is read instead of querying it always. */
+
+    /* inform streaming thread to notify */
+    g_atomic_int_compare_and_exchange (&psrc->notify, 0, 1);
+  }
 }
 
 static gboolean
 gst_pulsesrc_open (GstAudioSrc * asrc)
 {
   GstPulseSrc *pulsesrc = GST_PULSESRC_CAST (asrc);
+  GstPulseSrcContext *pctx;
 
   pa_threaded_mainloop_lock (pulsesrc->mainloop);
 
@@ -992,28 +1047,54 @@ gst_pulsesrc_open (GstAudioSrc * asrc)
 
   GST_DEBUG_OBJECT (pulsesrc, "opening device");
 
-  if (!(pulsesrc->context =
-          pa_context_new (pa_threaded_mainloop_get_api (pulsesrc->mainloop),
-              pulsesrc->client_name))) {
-    GST_ELEMENT_ERROR (pulsesrc, RESOURCE, FAILED, ("Failed to create context"),
-        (NULL));
-    goto unlock_and_fail;
-  }
+  if (pulsesrc->server)
+    pulsesrc->context_name = g_strdup_printf ("%s@%s", pulsesrc->client_name,
+        pulsesrc->server);
+  else
+    pulsesrc->context_name = g_strdup (pulsesrc->client_name);
+
+  pctx = g_hash_table_lookup (gst_pulsesrc_shared_contexts,
+      pulsesrc->context_name);
+  if (pctx == NULL) {
+    pctx = g_slice_new0 (GstPulseSrcContext);
+
+    GST_INFO_OBJECT (pulsesrc, "new context with name %s, pctx=%p",
+        pulsesrc->context_name, pctx);
+
+    if (!(pctx->context =
+            pa_context_new (pa_threaded_mainloop_get_api (pulsesrc->mainloop),
+                pulsesrc->client_name))) {
+      g_slice_free (GstPulseSrcContext, pctx);
+      GST_ELEMENT_ERROR (pulsesrc, RESOURCE, FAILED,
+          ("Failed to create context"), (NULL));
+      goto unlock_and_fail;
+    }
 
-  pa_context_set_state_callback (pulsesrc->context,
-      gst_pulsesrc_context_state_cb, pulsesrc);
-  pa_context_set_subscribe_callback (pulsesrc->context,
-      gst_pulsesrc_context_subscribe_cb, pulsesrc);
+    pctx->srcs = g_slist_prepend (pctx->srcs, pulsesrc);
+    g_hash_table_insert (gst_pulsesrc_shared_contexts,
+        g_strdup (pulsesrc->context_name), pctx);
 
-  GST_DEBUG_OBJECT (pulsesrc, "connect to server %s",
-      GST_STR_NULL (pulsesrc->server));
+    pa_context_set_state_callback (pctx->context,
+        gst_pulsesrc_context_state_cb, pulsesrc->mainloop);
+    pa_context_set_subscribe_callback (pctx->context,
+        gst_pulsesrc_context_subscribe_cb, pctx);
 
-  if (pa_context_connect (pulsesrc->context, pulsesrc->server, 0, NULL) < 0) {
-    GST_ELEMENT_ERROR (pulsesrc, RESOURCE, FAILED, ("Failed to connect: %s",
-            pa_strerror (pa_context_errno (pulsesrc->context))), (NULL));
-    goto unlock_and_fail;
+    GST_DEBUG_OBJECT (pulsesrc, "connect to server %s",
+        GST_STR_NULL (pulsesrc->server));
+
+    if (pa_context_connect (pctx->context, pulsesrc->server, 0, NULL) < 0) {
+      GST_ELEMENT_ERROR (pulsesrc, RESOURCE, FAILED, ("Failed to connect: %s",
+              pa_strerror (pa_context_errno (pctx->context))), (NULL));
+      goto unlock_and_fail;
+    }
+  } else {
+    GST_INFO_OBJECT (pulsesrc, "reusing shared context with name %s, pctx=%p",
+        pulsesrc->context_name, pctx);
+    pctx->srcs = g_slist_prepend (pctx->srcs, pulsesrc);
   }
 
+  pulsesrc->context = pa_context_ref (pctx->context);
+
   for (;;) {
     pa_context_state_t state;
 
@@ -1759,13 +1840,8 @@ gst_pulsesrc_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_NULL_TO_READY:
-      if (!(this->mainloop = pa_threaded_mainloop_new ()))
+      if (!(this->mainloop = gst_pulse_shared_mainloop_ref ()))
         goto mainloop_failed;
-      if (pa_threaded_mainloop_start (this->mainloop) < 0) {
-        pa_threaded_mainloop_free (this->mainloop);
-        this->mainloop = NULL;
-        goto mainloop_start_failed;
-      }
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       gst_element_post_message (element,
@@ -1795,14 +1871,13 @@ gst_pulsesrc_change_state (GstElement * element, GstStateChange transition)
       gst_pulsesrc_pause (this);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
-      if (this->mainloop)
-        pa_threaded_mainloop_stop (this->mainloop);
-
-      gst_pulsesrc_destroy_context (this);
-
       if (this->mainloop) {
-        pa_threaded_mainloop_free (this->mainloop);
+        pa_threaded_mainloop_lock (this->mainloop);
+        gst_pulsesrc_destroy_context (this);
+        pa_threaded_mainloop_unlock (this->mainloop);
+
         this->mainloop = NULL;
+        gst_pulse_shared_mainloop_unref ();
       }
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
@@ -1821,13 +1896,7 @@ gst_pulsesrc_change_state (GstElement * element, GstStateChange transition)
 mainloop_failed:
   {
     GST_ELEMENT_ERROR (this, RESOURCE, FAILED,
-        ("pa_threaded_mainloop_new() failed"), (NULL));
-    return GST_STATE_CHANGE_FAILURE;
-  }
-mainloop_start_failed:
-  {
-    GST_ELEMENT_ERROR (this, RESOURCE, FAILED,
-        ("pa_threaded_mainloop_start() failed"), (NULL));
+        ("Failed to start the pa main loop"), (NULL));
     return GST_STATE_CHANGE_FAILURE;
   }
 }
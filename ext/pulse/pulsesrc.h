@@ -54,9 +54,11 @@ struct _GstPulseSrc
 
   gchar *server, *device, *client_name;
 
+  /* shared between all instances */
   pa_threaded_mainloop *mainloop;
 
   pa_context *context;
+  gchar *context_name;
   pa_stream *stream;
   guint32 source_output_idx;
 
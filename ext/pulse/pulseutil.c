@@ -34,6 +34,9 @@
 # include <process.h>           /* getpid on win32 */
 #endif
 
+GST_DEBUG_CATEGORY_EXTERN (pulse_debug);
+#define GST_CAT_DEFAULT pulse_debug
+
 static const struct
 {
   GstAudioChannelPosition gst_pos;
@@ -258,6 +261,52 @@ gst_pulse_client_name (void)
     return g_strdup_printf ("GStreamer-pid-%lu", (gulong) getpid ());
 }
 
+/* one threaded main-loop is shared by all pulsesink and pulsesrc instances
+ * so that each stream doesn't cost an extra thread */
+static pa_threaded_mainloop *shared_mainloop = NULL;
+static guint shared_mainloop_ref_ct = 0;
+static GMutex shared_mainloop_mutex;
+
+pa_threaded_mainloop *
+gst_pulse_shared_mainloop_ref (void)
+{
+  pa_threaded_mainloop *ml = NULL;
+
+  g_mutex_lock (&shared_mainloop_mutex);
+  if (!shared_mainloop_ref_ct) {
+    GST_INFO ("new pa main loop thread");
+    if (!(shared_mainloop = pa_threaded_mainloop_new ()))
+      goto done;
+    if (pa_threaded_mainloop_start (shared_mainloop) < 0) {
+      pa_threaded_mainloop_free (shared_mainloop);
+      shared_mainloop = NULL;
+      goto done;
+    }
+  }
+  shared_mainloop_ref_ct++;
+  ml = shared_mainloop;
+
+done:
+  g_mutex_unlock (&shared_mainloop_mutex);
+
+  return ml;
+}
+
+void
+gst_pulse_shared_mainloop_unref (void)
+{
+  g_mutex_lock (&shared_mainloop_mutex);
+  g_assert (shared_mainloop_ref_ct > 0);
+  shared_mainloop_ref_ct--;
+  if (!shared_mainloop_ref_ct) {
+    GST_INFO ("terminating pa main loop thread");
+    pa_threaded_mainloop_stop (shared_mainloop);
+    pa_threaded_mainloop_free (shared_mainloop);
+    shared_mainloop = NULL;
+  }
+  g_mutex_unlock (&shared_mainloop_mutex);
+}
+
 pa_channel_map *
 gst_pulse_gst_to_channel_map (pa_channel_map * map,
     const GstAudioRingBufferSpec * spec)
@@ -78,6 +78,9 @@ const char * gst_pulse_sample_format_to_caps_format (pa_sample_format_t sf);
 
 gchar *gst_pulse_client_name (void);
 
+pa_threaded_mainloop *gst_pulse_shared_mainloop_ref (void);
+void gst_pulse_shared_mainloop_unref (void);
+
 pa_channel_map *gst_pulse_gst_to_channel_map (pa_channel_map * map,
     const GstAudioRingBufferSpec * spec);
 
@@ -70,7 +70,12 @@ enum
   ARG_PROTOCOL,                 /* Protocol to connect with */
 
   ARG_MOUNT,                    /* mountpoint of stream (icecast only) */
-  ARG_URL                       /* the stream's homepage URL */
+  ARG_URL,                      /* the stream's homepage URL */
+
+  ARG_QUEUE_SIZE,               /* buffers to queue for the sender thread */
+  ARG_QUEUE_LEVEL,              /* buffers currently queued */
+  ARG_DROPPED,                  /* buffers dropped from a full queue */
+  ARG_SEND_LATENCY              /* time the last send took */
 };
 
 #define DEFAULT_IP           "127.0.0.1"
@@ -84,6 +89,7 @@ enum
 #define DEFAULT_MOUNT        ""
 #define DEFAULT_URL          ""
 #define DEFAULT_PROTOCOL     SHOUT2SEND_PROTOCOL_HTTP
+#define DEFAULT_QUEUE_SIZE   0
 
 #ifdef SHOUT_FORMAT_WEBM
 #define WEBM_CAPS "; video/webm; audio/webm"
@@ -207,6 +213,60 @@ gst_shout2send_class_init (GstShout2sendClass * klass)
       g_param_spec_string ("url", "url", "the stream's homepage URL",
           DEFAULT_URL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstShout2send:queue-size:
+   *
+   * Number of buffers that are queued for a separate sender thread. With 0
+   * the data is sent from the streaming thread, which then blocks for as
+   * long as the server connection does. Otherwise the streaming thread only
+   * queues the buffers, and if the connection can't keep up the oldest
+   * buffers are dropped once the queue is full.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), ARG_QUEUE_SIZE,
+      g_param_spec_uint ("queue-size", "Queue size",
+          "Number of buffers to queue for a separate sender thread, dropping "
+          "the oldest when full (0 = send from the streaming thread)",
+          0, G_MAXUINT, DEFAULT_QUEUE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstShout2send:queue-level:
+   *
+   * Number of buffers currently waiting in the queue.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), ARG_QUEUE_LEVEL,
+      g_param_spec_uint ("queue-level", "Queue level",
+          "Number of buffers currently queued", 0, G_MAXUINT, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstShout2send:dropped:
+   *
+   * Number of buffers that were dropped because the queue was full.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), ARG_DROPPED,
+      g_param_spec_uint64 ("dropped", "Dropped",
+          "Number of buffers dropped from a full queue", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstShout2send:send-latency:
+   *
+   * Time in nanoseconds the last buffer took to be sent to the server.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), ARG_SEND_LATENCY,
+      g_param_spec_uint64 ("send-latency", "Send latency",
+          "Time the last buffer took to be sent in ns", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   /* signals */
   gst_shout2send_signals[SIGNAL_CONNECTION_PROBLEM] =
       g_signal_new ("connection-problem", G_TYPE_FROM_CLASS (klass),
@@ -262,6 +322,12 @@ gst_shout2send_init (GstShout2send * shout2send)
   shout2send->songmetadata = NULL;
   shout2send->songartist = NULL;
   shout2send->songtitle = NULL;
+
+  shout2send->queue_size = DEFAULT_QUEUE_SIZE;
+  g_queue_init (&shout2send->queue);
+  g_mutex_init (&shout2send->queue_lock);
+  g_cond_init (&shout2send->queue_cond);
+  g_mutex_init (&shout2send->conn_lock);
 }
 
 static void
@@ -280,6 +346,10 @@ gst_shout2send_finalize (GstShout2send * shout2send)
 
   gst_poll_free (shout2send->timer);
 
+  g_mutex_clear (&shout2send->queue_lock);
+  g_cond_clear (&shout2send->queue_cond);
+  g_mutex_clear (&shout2send->conn_lock);
+
   G_OBJECT_CLASS (parent_class)->finalize ((GObject *) (shout2send));
 }
 
@@ -370,6 +440,153 @@ gst_shout2send_set_metadata (GstShout2send * shout2send)
 #endif
 
 
+/* Sender thread, only used if queue-size > 0. It takes buffers from the
+ * queue, waits until libshout wants more data and sends them, so that a slow
+ * or stalled server connection never blocks the streaming thread. */
+static gpointer
+gst_shout2send_sender_loop (GstShout2send * sink)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  GstClockTime start;
+  gint64 deadline;
+  gint delay;
+  glong ret;
+
+  GST_DEBUG_OBJECT (sink, "sender thread started");
+
+  g_mutex_lock (&sink->queue_lock);
+  while (sink->sender_running) {
+    if (g_queue_is_empty (&sink->queue)) {
+      g_cond_wait (&sink->queue_cond, &sink->queue_lock);
+      continue;
+    }
+
+    g_mutex_lock (&sink->conn_lock);
+    delay = shout_delay (sink->conn);
+    g_mutex_unlock (&sink->conn_lock);
+
+    if (delay > 0) {
+      GST_LOG_OBJECT (sink, "waiting %d msec", delay);
+      deadline = g_get_monotonic_time () + delay * G_TIME_SPAN_MILLISECOND;
+      while (sink->sender_running &&
+          g_cond_wait_until (&sink->queue_cond, &sink->queue_lock, deadline));
+      /* other buffers might have been dropped meanwhile */
+      continue;
+    }
+
+    buf = g_queue_pop_head (&sink->queue);
+    sink->sending = TRUE;
+    g_mutex_unlock (&sink->queue_lock);
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    GST_LOG_OBJECT (sink, "sending %u bytes of data", (guint) map.size);
+    start = g_get_monotonic_time ();
+    g_mutex_lock (&sink->conn_lock);
+    ret = shout_send (sink->conn, map.data, map.size);
+    g_mutex_unlock (&sink->conn_lock);
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_unref (buf);
+
+    g_mutex_lock (&sink->queue_lock);
+    sink->sending = FALSE;
+    sink->send_latency = (g_get_monotonic_time () - start) * GST_USECOND;
+    g_cond_broadcast (&sink->queue_cond);
+
+    if (ret != SHOUTERR_SUCCESS) {
+      sink->send_error = TRUE;
+      g_mutex_unlock (&sink->queue_lock);
+      GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL),
+          ("shout_send() failed: %s", shout_get_error (sink->conn)));
+      g_signal_emit (sink, gst_shout2send_signals[SIGNAL_CONNECTION_PROBLEM],
+          0, shout_get_errno (sink->conn));
+      g_mutex_lock (&sink->queue_lock);
+      break;
+    }
+  }
+  g_mutex_unlock (&sink->queue_lock);
+
+  GST_DEBUG_OBJECT (sink, "sender thread stopped");
+
+  return NULL;
+}
+
+static GstFlowReturn
+gst_shout2send_queue_buffer (GstShout2send * sink, GstBuffer * buf)
+{
+  GstFlowReturn fret = GST_FLOW_OK;
+
+  g_mutex_lock (&sink->queue_lock);
+  if (sink->send_error) {
+    fret = GST_FLOW_ERROR;
+    goto done;
+  }
+
+  if (sink->sender == NULL) {
+    GError *err = NULL;
+
+    sink->sender_running = TRUE;
+    sink->sender = g_thread_try_new ("shout2send",
+        (GThreadFunc) gst_shout2send_sender_loop, sink, &err);
+    if (sink->sender == NULL) {
+      sink->sender_running = FALSE;
+      g_mutex_unlock (&sink->queue_lock);
+      GST_ELEMENT_ERROR (sink, RESOURCE, FAILED, (NULL),
+          ("Could not start sender thread: %s", err->message));
+      g_error_free (err);
+      return GST_FLOW_ERROR;
+    }
+  }
+
+  while (!g_queue_is_empty (&sink->queue) &&
+      g_queue_get_length (&sink->queue) >= sink->queue_size) {
+    gst_buffer_unref (g_queue_pop_head (&sink->queue));
+    sink->dropped++;
+    GST_DEBUG_OBJECT (sink, "queue full, dropped oldest buffer (%"
+        G_GUINT64_FORMAT " so far)", sink->dropped);
+  }
+
+  g_queue_push_tail (&sink->queue, gst_buffer_ref (buf));
+  g_cond_broadcast (&sink->queue_cond);
+
+done:
+  g_mutex_unlock (&sink->queue_lock);
+
+  return fret;
+}
+
+/* waits until the sender thread has sent everything that is queued */
+static void
+gst_shout2send_drain (GstShout2send * sink)
+{
+  g_mutex_lock (&sink->queue_lock);
+  while (sink->sender_running && !sink->send_error && !sink->flushing &&
+      (sink->sending || !g_queue_is_empty (&sink->queue)))
+    g_cond_wait (&sink->queue_cond, &sink->queue_lock);
+  g_mutex_unlock (&sink->queue_lock);
+}
+
+static void
+gst_shout2send_stop_sender (GstShout2send * sink)
+{
+  g_mutex_lock (&sink->queue_lock);
+  sink->sender_running = FALSE;
+  g_cond_broadcast (&sink->queue_cond);
+  g_mutex_unlock (&sink->queue_lock);
+
+  if (sink->sender) {
+    g_thread_join (sink->sender);
+    sink->sender = NULL;
+  }
+
+  g_queue_foreach (&sink->queue, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&sink->queue);
+  sink->sending = FALSE;
+  sink->send_error = FALSE;
+  sink->dropped = 0;
+  sink->send_latency = 0;
+}
+
 static gboolean
 gst_shout2send_event (GstBaseSink * sink, GstEvent * event)
 {
@@ -402,12 +619,24 @@ gst_shout2send_event (GstBaseSink * sink, GstEvent * event)
 
           pmetadata = shout_metadata_new ();
           shout_metadata_add (pmetadata, "song", shout2send->songmetadata);
+          g_mutex_lock (&shout2send->conn_lock);
           shout_set_metadata (shout2send->conn, pmetadata);
+          g_mutex_unlock (&shout2send->conn_lock);
           shout_metadata_free (pmetadata);
         }
       }
       break;
     }
+    case GST_EVENT_EOS:
+      /* make sure everything that is still queued gets out before the EOS
+       * message is posted */
+      gst_shout2send_drain (shout2send);
+      GST_LOG_OBJECT (shout2send, "let base class handle event");
+      if (GST_BASE_SINK_CLASS (parent_class)->event) {
+        event = gst_event_ref (event);
+        ret = GST_BASE_SINK_CLASS (parent_class)->event (sink, event);
+      }
+      break;
     default:{
       GST_LOG_OBJECT (shout2send, "let base class handle event");
       if (GST_BASE_SINK_CLASS (parent_class)->event) {
@@ -577,6 +806,8 @@ gst_shout2send_stop (GstBaseSink * basesink)
 {
   GstShout2send *sink = GST_SHOUT2SEND (basesink);
 
+  gst_shout2send_stop_sender (sink);
+
   if (sink->conn) {
     if (sink->connected)
       shout_close (sink->conn);
@@ -605,6 +836,11 @@ gst_shout2send_unlock (GstBaseSink * basesink)
   GST_DEBUG_OBJECT (basesink, "unlock");
   gst_poll_set_flushing (sink->timer, TRUE);
 
+  g_mutex_lock (&sink->queue_lock);
+  sink->flushing = TRUE;
+  g_cond_broadcast (&sink->queue_cond);
+  g_mutex_unlock (&sink->queue_lock);
+
   return TRUE;
 }
 
@@ -618,6 +854,10 @@ gst_shout2send_unlock_stop (GstBaseSink * basesink)
   GST_DEBUG_OBJECT (basesink, "unlock_stop");
   gst_poll_set_flushing (sink->timer, FALSE);
 
+  g_mutex_lock (&sink->queue_lock);
+  sink->flushing = FALSE;
+  g_mutex_unlock (&sink->queue_lock);
+
   return TRUE;
 }
 
@@ -641,6 +881,11 @@ gst_shout2send_render (GstBaseSink * basesink, GstBuffer * buf)
       goto done;
   }
 
+  if (sink->queue_size > 0) {
+    fret = gst_shout2send_queue_buffer (sink, buf);
+    goto done;
+  }
+
   delay = shout_delay (sink->conn);
 
   if (delay > 0) {
@@ -736,6 +981,11 @@ gst_shout2send_set_property (GObject * object, guint prop_id,
         g_free (shout2send->url);
       shout2send->url = g_strdup (g_value_get_string (value));
       break;
+    case ARG_QUEUE_SIZE:
+      g_mutex_lock (&shout2send->queue_lock);
+      shout2send->queue_size = g_value_get_uint (value);
+      g_mutex_unlock (&shout2send->queue_lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -784,6 +1034,26 @@ gst_shout2send_get_property (GObject * object, guint prop_id,
     case ARG_URL:              /* the stream's homepage URL */
       g_value_set_string (value, shout2send->url);
       break;
+    case ARG_QUEUE_SIZE:
+      g_mutex_lock (&shout2send->queue_lock);
+      g_value_set_uint (value, shout2send->queue_size);
+      g_mutex_unlock (&shout2send->queue_lock);
+      break;
+    case ARG_QUEUE_LEVEL:
+      g_mutex_lock (&shout2send->queue_lock);
+      g_value_set_uint (value, g_queue_get_length (&shout2send->queue));
+      g_mutex_unlock (&shout2send->queue_lock);
+      break;
+    case ARG_DROPPED:
+      g_mutex_lock (&shout2send->queue_lock);
+      g_value_set_uint64 (value, shout2send->dropped);
+      g_mutex_unlock (&shout2send->queue_lock);
+      break;
+    case ARG_SEND_LATENCY:
+      g_mutex_lock (&shout2send->queue_lock);
+      g_value_set_uint64 (value, shout2send->send_latency);
+      g_mutex_unlock (&shout2send->queue_lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -63,6 +63,20 @@ struct _GstShout2send {
   int    format;
 
   GstTagList* tags;
+
+  /* backlog sent from a separate thread, if queue_size > 0 */
+  guint queue_size;
+  GQueue queue;
+  GMutex queue_lock;
+  GCond queue_cond;
+  GThread *sender;
+  gboolean sender_running;
+  gboolean sending;
+  gboolean send_error;
+  gboolean flushing;
+  GMutex conn_lock;
+  guint64 dropped;
+  GstClockTime send_latency;
 };
 
 
@@ -32,6 +32,12 @@
  * This example encodes 10 seconds of video and sends it to the HTTP
  * server "server" using HTTP PUT commands.
  * </refsect2>
+ *
+ * By default the buffers that arrive while a request is in progress are
+ * collected and sent with the next PUT, using a Content-Range header for the
+ * offset in the stream. With #GstSoupHttpClientSink:chunked a single PUT
+ * with chunked transfer encoding is kept open instead, and buffers are sent
+ * as they arrive until EOS or until the location changes.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -65,6 +71,7 @@ static void gst_soup_http_client_sink_get_times (GstBaseSink * sink,
 static gboolean gst_soup_http_client_sink_start (GstBaseSink * sink);
 static gboolean gst_soup_http_client_sink_stop (GstBaseSink * sink);
 static gboolean gst_soup_http_client_sink_unlock (GstBaseSink * sink);
+static gboolean gst_soup_http_client_sink_unlock_stop (GstBaseSink * sink);
 static gboolean gst_soup_http_client_sink_event (GstBaseSink * sink,
     GstEvent * event);
 static GstFlowReturn gst_soup_http_client_sink_preroll (GstBaseSink * sink,
@@ -73,6 +80,7 @@ static GstFlowReturn gst_soup_http_client_sink_render (GstBaseSink * sink,
     GstBuffer * buffer);
 
 static void free_buffer_list (GList * list);
+static gboolean send_message (GstSoupHttpClientSink * souphttpsink);
 static void gst_soup_http_client_sink_reset (GstSoupHttpClientSink *
     souphttpsink);
 static void authenticate (SoupSession * session, SoupMessage * msg,
@@ -95,11 +103,24 @@ enum
   PROP_PROXY_PW,
   PROP_COOKIES,
   PROP_SESSION,
-  PROP_SOUP_LOG_LEVEL
+  PROP_SOUP_LOG_LEVEL,
+  PROP_CHUNKED,
+  PROP_MAX_BACKLOG
 };
 
 #define DEFAULT_USER_AGENT           "GStreamer souphttpclientsink "
 #define DEFAULT_SOUP_LOG_LEVEL       SOUP_LOGGER_LOG_NONE
+#define DEFAULT_CHUNKED              FALSE
+#define DEFAULT_MAX_BACKLOG          0
+
+/* a piece of a request body, keeps the memory mapped for libsoup */
+typedef struct
+{
+  GstSoupHttpClientSink *sink;
+  GstMemory *memory;
+  GstMapInfo map;
+  gboolean backlog;
+} GstSoupHttpClientSinkChunk;
 
 /* pad templates */
 
@@ -184,6 +205,34 @@ gst_soup_http_client_sink_class_init (GstSoupHttpClientSinkClass * klass)
           "Set log level for soup's HTTP session log",
           SOUP_TYPE_LOGGER_LOG_LEVEL, DEFAULT_SOUP_LOG_LEVEL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstSoupHttpClientSink::chunked:
+   *
+   * Stream the data in one PUT request with chunked transfer encoding,
+   * sending every buffer as it arrives, instead of collecting the buffers
+   * for one request per round trip. The request is finished at EOS or
+   * when the location changes, and the request for the new location is
+   * started right away without waiting for the answer to the previous one.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_CHUNKED,
+      g_param_spec_boolean ("chunked", "Chunked",
+          "Stream the data with chunked transfer encoding",
+          DEFAULT_CHUNKED, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstSoupHttpClientSink::max-backlog:
+   *
+   * Block the streaming thread while this many bytes are waiting to be
+   * sent, 0 for no limit.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_BACKLOG,
+      g_param_spec_uint64 ("max-backlog", "Max backlog",
+          "Maximum number of bytes waiting to be sent (0 = unlimited)",
+          0, G_MAXUINT64, DEFAULT_MAX_BACKLOG,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&gst_soup_http_client_sink_sink_template));
@@ -201,6 +250,8 @@ gst_soup_http_client_sink_class_init (GstSoupHttpClientSinkClass * klass)
   base_sink_class->stop = GST_DEBUG_FUNCPTR (gst_soup_http_client_sink_stop);
   base_sink_class->unlock =
       GST_DEBUG_FUNCPTR (gst_soup_http_client_sink_unlock);
+  base_sink_class->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_soup_http_client_sink_unlock_stop);
   base_sink_class->event = GST_DEBUG_FUNCPTR (gst_soup_http_client_sink_event);
   if (0)
     base_sink_class->preroll =
@@ -231,6 +282,8 @@ gst_soup_http_client_sink_init (GstSoupHttpClientSink * souphttpsink)
   souphttpsink->prop_session = NULL;
   souphttpsink->timeout = 1;
   souphttpsink->log_level = DEFAULT_SOUP_LOG_LEVEL;
+  souphttpsink->chunked = DEFAULT_CHUNKED;
+  souphttpsink->max_backlog = DEFAULT_MAX_BACKLOG;
   proxy = g_getenv ("http_proxy");
   if (proxy && !gst_soup_http_client_sink_set_proxy (souphttpsink, proxy)) {
     GST_WARNING_OBJECT (souphttpsink,
@@ -248,7 +301,8 @@ gst_soup_http_client_sink_reset (GstSoupHttpClientSink * souphttpsink)
   souphttpsink->reason_phrase = NULL;
   souphttpsink->status_code = 0;
   souphttpsink->offset = 0;
-
+  souphttpsink->reopen = FALSE;
+  souphttpsink->eos = FALSE;
 }
 
 static gboolean
@@ -289,6 +343,18 @@ gst_soup_http_client_sink_set_property (GObject * object, guint property_id,
       g_free (souphttpsink->location);
       souphttpsink->location = g_value_dup_string (value);
       souphttpsink->offset = 0;
+      souphttpsink->reopen = TRUE;
+      if (souphttpsink->chunked && souphttpsink->message) {
+        GSource *source;
+
+        /* finish the request for the previous location now instead of
+         * with the first buffer for the new one */
+        source = g_idle_source_new ();
+        g_source_set_callback (source, (GSourceFunc) (send_message),
+            souphttpsink, NULL);
+        g_source_attach (source, souphttpsink->context);
+        g_source_unref (source);
+      }
       break;
     case PROP_USER_AGENT:
       g_free (souphttpsink->user_agent);
@@ -336,6 +402,13 @@ gst_soup_http_client_sink_set_property (GObject * object, guint property_id,
     case PROP_SOUP_LOG_LEVEL:
       souphttpsink->log_level = g_value_get_enum (value);
       break;
+    case PROP_CHUNKED:
+      souphttpsink->chunked = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_BACKLOG:
+      souphttpsink->max_backlog = g_value_get_uint64 (value);
+      g_cond_broadcast (&souphttpsink->cond);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -391,6 +464,12 @@ gst_soup_http_client_sink_get_property (GObject * object, guint property_id,
     case PROP_SOUP_LOG_LEVEL:
       g_value_set_enum (value, souphttpsink->log_level);
       break;
+    case PROP_CHUNKED:
+      g_value_set_boolean (value, souphttpsink->chunked);
+      break;
+    case PROP_MAX_BACKLOG:
+      g_value_set_uint64 (value, souphttpsink->max_backlog);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -579,8 +658,29 @@ gst_soup_http_client_sink_stop (GstBaseSink * sink)
 static gboolean
 gst_soup_http_client_sink_unlock (GstBaseSink * sink)
 {
+  GstSoupHttpClientSink *souphttpsink = GST_SOUP_HTTP_CLIENT_SINK (sink);
+
   GST_DEBUG ("unlock");
 
+  g_mutex_lock (&souphttpsink->mutex);
+  souphttpsink->flushing = TRUE;
+  g_cond_broadcast (&souphttpsink->cond);
+  g_mutex_unlock (&souphttpsink->mutex);
+
+  return TRUE;
+}
+
+static gboolean
+gst_soup_http_client_sink_unlock_stop (GstBaseSink * sink)
+{
+  GstSoupHttpClientSink *souphttpsink = GST_SOUP_HTTP_CLIENT_SINK (sink);
+
+  GST_DEBUG ("unlock stop");
+
+  g_mutex_lock (&souphttpsink->mutex);
+  souphttpsink->flushing = FALSE;
+  g_mutex_unlock (&souphttpsink->mutex);
+
   return TRUE;
 }
 
@@ -594,7 +694,20 @@ gst_soup_http_client_sink_event (GstBaseSink * sink, GstEvent * event)
   if (GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
     GST_DEBUG_OBJECT (souphttpsink, "got eos");
     g_mutex_lock (&souphttpsink->mutex);
-    while (souphttpsink->message) {
+    if (souphttpsink->chunked) {
+      GSource *source;
+
+      /* finish the open request from the session thread */
+      souphttpsink->eos = TRUE;
+      source = g_idle_source_new ();
+      g_source_set_callback (source, (GSourceFunc) (send_message),
+          souphttpsink, NULL);
+      g_source_attach (source, souphttpsink->context);
+      g_source_unref (source);
+    }
+    while ((souphttpsink->message || souphttpsink->in_flight > 0
+            || (souphttpsink->chunked && souphttpsink->eos))
+        && !souphttpsink->flushing) {
       GST_DEBUG_OBJECT (souphttpsink, "waiting");
       g_cond_wait (&souphttpsink->cond, &souphttpsink->mutex);
     }
@@ -624,53 +737,194 @@ free_buffer_list (GList * list)
   g_list_free (list);
 }
 
+/* called by libsoup when it no longer needs the data */
 static void
-send_message_locked (GstSoupHttpClientSink * souphttpsink)
+chunk_free (GstSoupHttpClientSinkChunk * chunk)
+{
+  GstSoupHttpClientSink *souphttpsink = chunk->sink;
+
+  if (chunk->backlog) {
+    g_mutex_lock (&souphttpsink->mutex);
+    souphttpsink->backlog -= chunk->map.size;
+    g_cond_broadcast (&souphttpsink->cond);
+    g_mutex_unlock (&souphttpsink->mutex);
+  }
+
+  gst_memory_unmap (chunk->memory, &chunk->map);
+  gst_memory_unref (chunk->memory);
+  g_slice_free (GstSoupHttpClientSinkChunk, chunk);
+}
+
+/* append the memories of @buffer to the request body without copying them,
+ * libsoup keeps them mapped until the body is sent */
+static guint64
+append_buffer_locked (GstSoupHttpClientSink * souphttpsink, SoupMessage * msg,
+    GstBuffer * buffer, gboolean backlog)
+{
+  guint i, n_mem;
+  guint64 n = 0;
+
+  n_mem = gst_buffer_n_memory (buffer);
+  for (i = 0; i < n_mem; i++) {
+    GstSoupHttpClientSinkChunk *chunk;
+    SoupBuffer *sbuf;
+
+    chunk = g_slice_new (GstSoupHttpClientSinkChunk);
+    chunk->sink = souphttpsink;
+    chunk->memory = gst_buffer_get_memory (buffer, i);
+    chunk->backlog = backlog;
+
+    /* an empty chunk would end a chunked body */
+    if (!gst_memory_map (chunk->memory, &chunk->map, GST_MAP_READ)
+        || chunk->map.size == 0) {
+      if (chunk->map.size == 0)
+        gst_memory_unmap (chunk->memory, &chunk->map);
+      else
+        GST_WARNING_OBJECT (souphttpsink, "could not map memory");
+      gst_memory_unref (chunk->memory);
+      g_slice_free (GstSoupHttpClientSinkChunk, chunk);
+      continue;
+    }
+
+    sbuf = soup_buffer_new_with_owner (chunk->map.data, chunk->map.size,
+        chunk, (GDestroyNotify) chunk_free);
+    soup_message_body_append_buffer (msg->request_body, sbuf);
+    soup_buffer_free (sbuf);
+    n += chunk->map.size;
+  }
+
+  return n;
+}
+
+/* move the queued buffers, and the streamheaders at the start, to the body
+ * of @msg */
+static guint64
+append_queued_buffers_locked (GstSoupHttpClientSink * souphttpsink,
+    SoupMessage * msg)
 {
   GList *g;
+  guint64 n = 0;
+
+  if (souphttpsink->offset == 0) {
+    for (g = souphttpsink->streamheader_buffers; g; g = g_list_next (g))
+      n += append_buffer_locked (souphttpsink, msg, g->data, FALSE);
+  }
+
+  for (g = souphttpsink->queued_buffers; g; g = g_list_next (g)) {
+    GstBuffer *buffer = g->data;
+    gsize size = gst_buffer_get_size (buffer);
+
+    /* the body data is accounted until libsoup releases it */
+    if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_HEADER))
+      n += append_buffer_locked (souphttpsink, msg, buffer, TRUE);
+    souphttpsink->backlog -= size;
+  }
+  free_buffer_list (souphttpsink->queued_buffers);
+  souphttpsink->queued_buffers = NULL;
+
+  return n;
+}
+
+static void
+drop_queued_buffers_locked (GstSoupHttpClientSink * souphttpsink)
+{
+  GList *g;
+
+  for (g = souphttpsink->queued_buffers; g; g = g_list_next (g))
+    souphttpsink->backlog -= gst_buffer_get_size (g->data);
+  free_buffer_list (souphttpsink->queued_buffers);
+  souphttpsink->queued_buffers = NULL;
+  g_cond_broadcast (&souphttpsink->cond);
+}
+
+/* end the body of the open chunked request */
+static void
+finish_chunked_message_locked (GstSoupHttpClientSink * souphttpsink)
+{
+  GST_DEBUG_OBJECT (souphttpsink, "finish request at %" G_GUINT64_FORMAT,
+      souphttpsink->offset);
+
+  soup_message_body_complete (souphttpsink->message->request_body);
+  soup_session_unpause_message (souphttpsink->session, souphttpsink->message);
+  souphttpsink->message = NULL;
+}
+
+static void
+send_chunks_locked (GstSoupHttpClientSink * souphttpsink)
+{
+  gboolean new_message = FALSE;
+  guint64 n;
+
+  /* the queued data is for the new location, the answer for the previous
+   * request is handled in the callback */
+  if (souphttpsink->message && souphttpsink->reopen)
+    finish_chunked_message_locked (souphttpsink);
+  souphttpsink->reopen = FALSE;
+
+  if (souphttpsink->queued_buffers) {
+    if (souphttpsink->location == NULL) {
+      drop_queued_buffers_locked (souphttpsink);
+    } else {
+      if (souphttpsink->message == NULL) {
+        souphttpsink->message =
+            soup_message_new ("PUT", souphttpsink->location);
+        soup_message_headers_set_encoding
+            (souphttpsink->message->request_headers, SOUP_ENCODING_CHUNKED);
+        /* let libsoup release the data once it is written */
+        soup_message_body_set_accumulate
+            (souphttpsink->message->request_body, FALSE);
+        new_message = TRUE;
+      }
+
+      n = append_queued_buffers_locked (souphttpsink, souphttpsink->message);
+      souphttpsink->offset += n;
+
+      if (new_message && n == 0) {
+        g_object_unref (souphttpsink->message);
+        souphttpsink->message = NULL;
+      } else if (new_message) {
+        GST_DEBUG_OBJECT (souphttpsink, "queue chunked message");
+        souphttpsink->in_flight++;
+        soup_session_queue_message (souphttpsink->session,
+            souphttpsink->message, callback, souphttpsink);
+      } else if (n > 0) {
+        soup_session_unpause_message (souphttpsink->session,
+            souphttpsink->message);
+      }
+    }
+  }
+
+  if (souphttpsink->eos) {
+    if (souphttpsink->message)
+      finish_chunked_message_locked (souphttpsink);
+    souphttpsink->eos = FALSE;
+    g_cond_broadcast (&souphttpsink->cond);
+  }
+}
+
+static void
+send_message_locked (GstSoupHttpClientSink * souphttpsink)
+{
   guint64 n;
 
+  if (souphttpsink->chunked) {
+    send_chunks_locked (souphttpsink);
+    return;
+  }
+
   if (souphttpsink->queued_buffers == NULL || souphttpsink->message) {
     return;
   }
 
   /* If the URI went away, drop all these buffers */
   if (souphttpsink->location == NULL) {
-    free_buffer_list (souphttpsink->queued_buffers);
-    souphttpsink->queued_buffers = NULL;
+    drop_queued_buffers_locked (souphttpsink);
     return;
   }
 
   souphttpsink->message = soup_message_new ("PUT", souphttpsink->location);
 
-  n = 0;
-  if (souphttpsink->offset == 0) {
-    for (g = souphttpsink->streamheader_buffers; g; g = g_list_next (g)) {
-      GstBuffer *buffer = g->data;
-      GstMapInfo map;
-
-      /* FIXME, lifetime of the buffer? */
-      gst_buffer_map (buffer, &map, GST_MAP_READ);
-      soup_message_body_append (souphttpsink->message->request_body,
-          SOUP_MEMORY_STATIC, map.data, map.size);
-      n += map.size;
-      gst_buffer_unmap (buffer, &map);
-    }
-  }
-
-  for (g = souphttpsink->queued_buffers; g; g = g_list_next (g)) {
-    GstBuffer *buffer = g->data;
-    if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_HEADER)) {
-      GstMapInfo map;
-
-      /* FIXME, lifetime of the buffer? */
-      gst_buffer_map (buffer, &map, GST_MAP_READ);
-      soup_message_body_append (souphttpsink->message->request_body,
-          SOUP_MEMORY_STATIC, map.data, map.size);
-      n += map.size;
-      gst_buffer_unmap (buffer, &map);
-    }
-  }
+  n = append_queued_buffers_locked (souphttpsink, souphttpsink->message);
 
   if (souphttpsink->offset != 0) {
     char *s;
@@ -682,19 +936,15 @@ send_message_locked (GstSoupHttpClientSink * souphttpsink)
   }
 
   if (n == 0) {
-    free_buffer_list (souphttpsink->queued_buffers);
-    souphttpsink->queued_buffers = NULL;
     g_object_unref (souphttpsink->message);
     souphttpsink->message = NULL;
     return;
   }
 
-  souphttpsink->sent_buffers = souphttpsink->queued_buffers;
-  souphttpsink->queued_buffers = NULL;
-
   GST_DEBUG_OBJECT (souphttpsink,
       "queue message %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT,
       souphttpsink->offset, n);
+  souphttpsink->in_flight++;
   soup_session_queue_message (souphttpsink->session, souphttpsink->message,
       callback, souphttpsink);
 
@@ -720,20 +970,22 @@ callback (SoupSession * session, SoupMessage * msg, gpointer user_data)
       msg->status_code, msg->reason_phrase);
 
   g_mutex_lock (&souphttpsink->mutex);
-  g_cond_signal (&souphttpsink->cond);
-  souphttpsink->message = NULL;
+  g_cond_broadcast (&souphttpsink->cond);
+  if (msg == souphttpsink->message)
+    souphttpsink->message = NULL;
+  souphttpsink->in_flight--;
 
   if (!SOUP_STATUS_IS_SUCCESSFUL (msg->status_code)) {
     souphttpsink->status_code = msg->status_code;
+    g_free (souphttpsink->reason_phrase);
     souphttpsink->reason_phrase = g_strdup (msg->reason_phrase);
     g_mutex_unlock (&souphttpsink->mutex);
     return;
   }
 
-  free_buffer_list (souphttpsink->sent_buffers);
-  souphttpsink->sent_buffers = NULL;
-
-  send_message_locked (souphttpsink);
+  /* in chunked mode the data is sent as soon as it is queued */
+  if (!souphttpsink->chunked)
+    send_message_locked (souphttpsink);
   g_mutex_unlock (&souphttpsink->mutex);
 }
 
@@ -754,10 +1006,24 @@ gst_soup_http_client_sink_render (GstBaseSink * sink, GstBuffer * buffer)
   }
 
   g_mutex_lock (&souphttpsink->mutex);
+  /* wait until enough of the backlog was sent */
+  while (souphttpsink->max_backlog > 0
+      && souphttpsink->backlog >= souphttpsink->max_backlog
+      && souphttpsink->status_code == 0 && !souphttpsink->flushing) {
+    GST_LOG_OBJECT (souphttpsink, "backlog of %" G_GUINT64_FORMAT " bytes, "
+        "waiting", souphttpsink->backlog);
+    g_cond_wait (&souphttpsink->cond, &souphttpsink->mutex);
+  }
+  if (souphttpsink->flushing) {
+    g_mutex_unlock (&souphttpsink->mutex);
+    return GST_FLOW_FLUSHING;
+  }
+
   if (souphttpsink->location != NULL) {
     wake = (souphttpsink->queued_buffers == NULL);
     souphttpsink->queued_buffers =
         g_list_append (souphttpsink->queued_buffers, gst_buffer_ref (buffer));
+    souphttpsink->backlog += gst_buffer_get_size (buffer);
 
     if (wake) {
       source = g_idle_source_new ();
@@ -46,9 +46,17 @@ struct _GstSoupHttpClientSink
   SoupMessage *message;
   SoupSession *session;
   GList *queued_buffers;
-  GList *sent_buffers;
   GList *streamheader_buffers;
 
+  /* bytes queued or still referenced by request bodies */
+  guint64 backlog;
+  /* requests queued on the session and not finished yet */
+  guint in_flight;
+  gboolean flushing;
+  /* chunked mode: finish the open request before sending more */
+  gboolean reopen;
+  gboolean eos;
+
   int status_code;
   char *reason_phrase;
 
@@ -67,6 +75,8 @@ struct _GstSoupHttpClientSink
   gboolean automatic_redirect;
   gchar **cookies;
   SoupLoggerLogLevel log_level;
+  gboolean chunked;
+  guint64 max_backlog;
 };
 
 struct _GstSoupHttpClientSinkClass
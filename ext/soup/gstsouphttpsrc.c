@@ -112,7 +112,13 @@ enum
   PROP_KEEP_ALIVE,
   PROP_SSL_STRICT,
   PROP_SSL_CA_FILE,
-  PROP_SSL_USE_SYSTEM_CA_FILE
+  PROP_SSL_USE_SYSTEM_CA_FILE,
+  PROP_SHARE_SESSION,
+  PROP_PARALLEL_REQUESTS,
+  PROP_PARALLEL_RANGE_SIZE,
+  PROP_CACHE_SIZE,
+  PROP_CACHE_HITS,
+  PROP_CACHE_MISSES
 };
 
 #define DEFAULT_USER_AGENT           "GStreamer souphttpsrc "
@@ -123,6 +129,13 @@ enum
 #define DEFAULT_SSL_STRICT           TRUE
 #define DEFAULT_SSL_CA_FILE          NULL
 #define DEFAULT_SSL_USE_SYSTEM_CA_FILE TRUE
+#define DEFAULT_SHARE_SESSION        FALSE
+#define DEFAULT_PARALLEL_REQUESTS    1
+#define DEFAULT_PARALLEL_RANGE_SIZE  (4 * 1024 * 1024)
+#define DEFAULT_CACHE_SIZE           0
+
+/* maximum number of idle sessions kept around for share-session */
+#define SESSION_POOL_MAX_SIZE        16
 
 static void gst_soup_http_src_uri_handler_init (gpointer g_iface,
     gpointer iface_data);
@@ -155,6 +168,11 @@ static char *gst_soup_http_src_unicodify (const char *str);
 static gboolean gst_soup_http_src_build_message (GstSoupHTTPSrc * src,
     const gchar * method);
 static void gst_soup_http_src_cancel_message (GstSoupHTTPSrc * src);
+static gboolean gst_soup_http_src_session_pool_put (GstSoupHTTPSrc * src);
+static gboolean gst_soup_http_src_session_pool_take (GstSoupHTTPSrc * src);
+static void gst_soup_http_src_parallel_reset (GstSoupHTTPSrc * src);
+static void gst_soup_http_src_cache_clear (GstSoupHTTPSrc * src);
+static gint gst_soup_http_src_cache_compare (gconstpointer a, gconstpointer b);
 static void gst_soup_http_src_queue_message (GstSoupHTTPSrc * src);
 static gboolean gst_soup_http_src_add_range_header (GstSoupHTTPSrc * src,
     guint64 offset, guint64 stop_offset);
@@ -343,6 +361,95 @@ gst_soup_http_src_class_init (GstSoupHTTPSrcClass * klass)
           "Use system CA file", DEFAULT_SSL_USE_SYSTEM_CA_FILE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+ /**
+   * GstSoupHTTPSrc::share-session:
+   *
+   * If set to %TRUE, souphttpsrc will hand its session to a process-wide pool
+   * when it is closed instead of destroying it, and will pick up a pooled
+   * session with the same proxy, user agent, timeout and SSL settings when
+   * it is opened. Together with #GstSoupHTTPSrc:keep-alive this lets
+   * consecutive souphttpsrc instances, e.g. for the fragments of an adaptive
+   * stream, reuse already established connections.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_SHARE_SESSION,
+      g_param_spec_boolean ("share-session", "Share Session",
+          "Reuse sessions and their connections across element instances",
+          DEFAULT_SHARE_SESSION, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+ /**
+   * GstSoupHTTPSrc::parallel-requests:
+   *
+   * Number of concurrent Range requests to download a resource with. Once
+   * the server has reported the size of a seekable resource, souphttpsrc
+   * requests consecutive windows of #GstSoupHTTPSrc:parallel-range-size
+   * bytes over this many connections and outputs them in order. 1 disables
+   * parallel downloading.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_PARALLEL_REQUESTS,
+      g_param_spec_uint ("parallel-requests", "Parallel Requests",
+          "Number of concurrent range requests (1 = disabled)", 1, 64,
+          DEFAULT_PARALLEL_REQUESTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+ /**
+   * GstSoupHTTPSrc::parallel-range-size:
+   *
+   * Size of the windows requested in parallel when
+   * #GstSoupHTTPSrc:parallel-requests is bigger than 1.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_PARALLEL_RANGE_SIZE,
+      g_param_spec_uint ("parallel-range-size", "Parallel Range Size",
+          "Size in bytes of each parallel range request", 64 * 1024,
+          G_MAXUINT, DEFAULT_PARALLEL_RANGE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+ /**
+   * GstSoupHTTPSrc::cache-size:
+   *
+   * Amount of recently downloaded data to keep in memory. Reads after a
+   * seek into cached data are served from memory, and if they catch up with
+   * the position of the running request no new request is made. This avoids
+   * round trips for the many small seeks demuxers do while parsing headers
+   * and indexes. 0 disables the cache.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_CACHE_SIZE,
+      g_param_spec_uint ("cache-size", "Cache Size",
+          "Number of bytes of downloaded data to keep for seeks (0 = disabled)",
+          0, G_MAXUINT, DEFAULT_CACHE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+ /**
+   * GstSoupHTTPSrc::cache-hits:
+   *
+   * Number of reads that were served from the cache.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_CACHE_HITS,
+      g_param_spec_uint64 ("cache-hits", "Cache Hits",
+          "Number of reads served from the cache", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+ /**
+   * GstSoupHTTPSrc::cache-misses:
+   *
+   * Number of reads after a seek that could not be served from the cache.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_CACHE_MISSES,
+      g_param_spec_uint64 ("cache-misses", "Cache Misses",
+          "Number of reads after a seek not served from the cache", 0,
+          G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&srctemplate));
 
@@ -383,6 +490,8 @@ gst_soup_http_src_reset (GstSoupHTTPSrc * src)
   src->stop_position = -1;
   src->content_size = 0;
   src->have_body = FALSE;
+  src->parallel_failed = FALSE;
+  gst_soup_http_src_cache_clear (src);
 
   src->ret = GST_FLOW_OK;
 
@@ -419,6 +528,13 @@ gst_soup_http_src_init (GstSoupHTTPSrc * src)
   src->log_level = DEFAULT_SOUP_LOG_LEVEL;
   src->ssl_strict = DEFAULT_SSL_STRICT;
   src->ssl_use_system_ca_file = DEFAULT_SSL_USE_SYSTEM_CA_FILE;
+  src->share_session = DEFAULT_SHARE_SESSION;
+  src->parallel_requests = DEFAULT_PARALLEL_REQUESTS;
+  src->parallel_range_size = DEFAULT_PARALLEL_RANGE_SIZE;
+  g_queue_init (&src->ranges);
+  src->cache_size = DEFAULT_CACHE_SIZE;
+  src->cache = g_tree_new (gst_soup_http_src_cache_compare);
+  g_queue_init (&src->cache_lru);
   proxy = g_getenv ("http_proxy");
   if (proxy && !gst_soup_http_src_set_proxy (src, proxy)) {
     GST_WARNING_OBJECT (src,
@@ -473,6 +589,9 @@ gst_soup_http_src_finalize (GObject * gobject)
 
   g_free (src->ssl_ca_file);
 
+  gst_soup_http_src_cache_clear (src);
+  g_tree_destroy (src->cache);
+
   G_OBJECT_CLASS (parent_class)->finalize (gobject);
 }
 
@@ -585,6 +704,18 @@ gst_soup_http_src_set_property (GObject * object, guint prop_id,
     case PROP_SSL_USE_SYSTEM_CA_FILE:
       src->ssl_use_system_ca_file = g_value_get_boolean (value);
       break;
+    case PROP_SHARE_SESSION:
+      src->share_session = g_value_get_boolean (value);
+      break;
+    case PROP_PARALLEL_REQUESTS:
+      src->parallel_requests = g_value_get_uint (value);
+      break;
+    case PROP_PARALLEL_RANGE_SIZE:
+      src->parallel_range_size = g_value_get_uint (value);
+      break;
+    case PROP_CACHE_SIZE:
+      src->cache_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -664,6 +795,28 @@ gst_soup_http_src_get_property (GObject * object, guint prop_id,
     case PROP_SSL_USE_SYSTEM_CA_FILE:
       g_value_set_boolean (value, src->ssl_strict);
       break;
+    case PROP_SHARE_SESSION:
+      g_value_set_boolean (value, src->share_session);
+      break;
+    case PROP_PARALLEL_REQUESTS:
+      g_value_set_uint (value, src->parallel_requests);
+      break;
+    case PROP_PARALLEL_RANGE_SIZE:
+      g_value_set_uint (value, src->parallel_range_size);
+      break;
+    case PROP_CACHE_SIZE:
+      g_value_set_uint (value, src->cache_size);
+      break;
+    case PROP_CACHE_HITS:
+      GST_OBJECT_LOCK (src);
+      g_value_set_uint64 (value, src->cache_hits);
+      GST_OBJECT_UNLOCK (src);
+      break;
+    case PROP_CACHE_MISSES:
+      GST_OBJECT_LOCK (src);
+      g_value_set_uint64 (value, src->cache_misses);
+      GST_OBJECT_UNLOCK (src);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -724,10 +877,17 @@ gst_soup_http_src_add_range_header (GstSoupHTTPSrc * src, guint64 offset,
   return TRUE;
 }
 
+typedef struct
+{
+  GstSoupHTTPSrc *src;
+  SoupMessage *msg;
+} AppendExtraHeadersData;
+
 static gboolean
 _append_extra_header (GQuark field_id, const GValue * value, gpointer user_data)
 {
-  GstSoupHTTPSrc *src = GST_SOUP_HTTP_SRC (user_data);
+  AppendExtraHeadersData *data = user_data;
+  GstSoupHTTPSrc *src = data->src;
   const gchar *field_name = g_quark_to_string (field_id);
   gchar *field_content = NULL;
 
@@ -750,7 +910,7 @@ _append_extra_header (GQuark field_id, const GValue * value, gpointer user_data)
 
   GST_DEBUG_OBJECT (src, "Appending extra header: \"%s: %s\"", field_name,
       field_content);
-  soup_message_headers_append (src->msg->request_headers, field_name,
+  soup_message_headers_append (data->msg->request_headers, field_name,
       field_content);
 
   g_free (field_content);
@@ -791,12 +951,17 @@ _append_extra_headers (GQuark field_id, const GValue * value,
 
 
 static gboolean
-gst_soup_http_src_add_extra_headers (GstSoupHTTPSrc * src)
+gst_soup_http_src_add_extra_headers (GstSoupHTTPSrc * src, SoupMessage * msg)
 {
+  AppendExtraHeadersData data;
+
   if (!src->extra_headers)
     return TRUE;
 
-  return gst_structure_foreach (src->extra_headers, _append_extra_headers, src);
+  data.src = src;
+  data.msg = msg;
+  return gst_structure_foreach (src->extra_headers, _append_extra_headers,
+      &data);
 }
 
 
@@ -826,6 +991,9 @@ gst_soup_http_src_session_open (GstSoupHTTPSrc * src)
     return FALSE;
   }
 
+  if (src->share_session && gst_soup_http_src_session_pool_take (src))
+    goto have_session;
+
   if (!src->context)
     src->context = g_main_context_new ();
 
@@ -877,6 +1045,22 @@ gst_soup_http_src_session_open (GstSoupHTTPSrc * src)
     GST_DEBUG_OBJECT (src, "Re-using session");
   }
 
+have_session:
+  /* one connection for every range request plus the regular one */
+  if (src->parallel_requests > 1) {
+    guint max_conns;
+
+    g_object_get (src->session, SOUP_SESSION_MAX_CONNS_PER_HOST, &max_conns,
+        NULL);
+    if (max_conns < src->parallel_requests + 1)
+      g_object_set (src->session, SOUP_SESSION_MAX_CONNS_PER_HOST,
+          src->parallel_requests + 1, NULL);
+    g_object_get (src->session, SOUP_SESSION_MAX_CONNS, &max_conns, NULL);
+    if (max_conns < src->parallel_requests + 1)
+      g_object_set (src->session, SOUP_SESSION_MAX_CONNS,
+          src->parallel_requests + 1, NULL);
+  }
+
   if (src->compress)
     soup_session_add_feature_by_type (src->session, SOUP_TYPE_CONTENT_DECODER);
   else
@@ -886,9 +1070,144 @@ gst_soup_http_src_session_open (GstSoupHTTPSrc * src)
   return TRUE;
 }
 
+typedef struct
+{
+  gchar *key;
+  SoupSession *session;
+  GMainContext *context;
+  GMainLoop *loop;
+} GstSoupHTTPSrcPooledSession;
+
+static GMutex session_pool_lock;
+static GQueue session_pool = G_QUEUE_INIT;      /* most recently used first */
+
+/* all the settings that are fixed when the session is created */
+static gchar *
+gst_soup_http_src_session_key (GstSoupHTTPSrc * src)
+{
+  gchar *proxy, *key;
+
+  proxy = src->proxy ? soup_uri_to_string (src->proxy, FALSE) : NULL;
+  key = g_strdup_printf ("%s|%s|%u|%d|%s|%d", GST_STR_NULL (proxy),
+      GST_STR_NULL (src->user_agent), src->timeout, src->ssl_strict,
+      GST_STR_NULL (src->ssl_ca_file), src->ssl_use_system_ca_file);
+  g_free (proxy);
+
+  return key;
+}
+
+static void
+gst_soup_http_src_pooled_session_free (GstSoupHTTPSrcPooledSession * pooled)
+{
+  soup_session_abort (pooled->session);
+  g_object_unref (pooled->session);
+  g_main_loop_unref (pooled->loop);
+  g_main_context_unref (pooled->context);
+  g_free (pooled->key);
+  g_slice_free (GstSoupHTTPSrcPooledSession, pooled);
+}
+
+/* Moves the session, together with the context it is bound to, into the
+ * pool. Returns FALSE if the session can't be shared. */
+static gboolean
+gst_soup_http_src_session_pool_put (GstSoupHTTPSrc * src)
+{
+  GstSoupHTTPSrcPooledSession *pooled;
+
+  /* let a cancelled message finish, its callbacks refer to us */
+  if (src->msg != NULL) {
+    gst_soup_http_src_cancel_message (src);
+    while (src->msg != NULL && g_main_context_iteration (src->context, FALSE));
+    if (src->msg != NULL) {
+      GST_DEBUG_OBJECT (src, "message still pending, not sharing session");
+      return FALSE;
+    }
+  }
+
+  g_signal_handlers_disconnect_by_data (src->session, src);
+  /* the logger holds a reference to us */
+  soup_session_remove_feature_by_type (src->session, SOUP_TYPE_LOGGER);
+
+  pooled = g_slice_new (GstSoupHTTPSrcPooledSession);
+  pooled->key = gst_soup_http_src_session_key (src);
+  pooled->session = src->session;
+  pooled->context = src->context;
+  pooled->loop = src->loop;
+  src->session = NULL;
+  src->context = NULL;
+  src->loop = NULL;
+
+  GST_DEBUG_OBJECT (src, "putting session %p into pool", pooled->session);
+
+  g_mutex_lock (&session_pool_lock);
+  g_queue_push_head (&session_pool, pooled);
+  if (session_pool.length > SESSION_POOL_MAX_SIZE)
+    pooled = g_queue_pop_tail (&session_pool);
+  else
+    pooled = NULL;
+  g_mutex_unlock (&session_pool_lock);
+
+  if (pooled)
+    gst_soup_http_src_pooled_session_free (pooled);
+
+  return TRUE;
+}
+
+static gboolean
+gst_soup_http_src_session_pool_take (GstSoupHTTPSrc * src)
+{
+  GstSoupHTTPSrcPooledSession *pooled = NULL;
+  gchar *key;
+  GList *l;
+
+  key = gst_soup_http_src_session_key (src);
+
+  g_mutex_lock (&session_pool_lock);
+  for (l = session_pool.head; l != NULL; l = l->next) {
+    GstSoupHTTPSrcPooledSession *p = l->data;
+
+    if (strcmp (p->key, key) == 0) {
+      pooled = p;
+      g_queue_delete_link (&session_pool, l);
+      break;
+    }
+  }
+  g_mutex_unlock (&session_pool_lock);
+  g_free (key);
+
+  if (pooled == NULL)
+    return FALSE;
+
+  GST_DEBUG_OBJECT (src, "using session %p from pool", pooled->session);
+
+  /* previous loop and context are not used anymore, take the ones the
+   * session is bound to */
+  if (src->loop)
+    g_main_loop_unref (src->loop);
+  if (src->context)
+    g_main_context_unref (src->context);
+  src->session = pooled->session;
+  src->context = pooled->context;
+  src->loop = pooled->loop;
+  g_free (pooled->key);
+  g_slice_free (GstSoupHTTPSrcPooledSession, pooled);
+
+  g_signal_connect (src->session, "authenticate",
+      G_CALLBACK (gst_soup_http_src_authenticate_cb), src);
+  gst_soup_util_log_setup (src->session, src->log_level, GST_ELEMENT (src));
+
+  return TRUE;
+}
+
 static void
 gst_soup_http_src_session_close (GstSoupHTTPSrc * src)
 {
+  gst_soup_http_src_parallel_reset (src);
+
+  if (src->session && src->share_session &&
+      gst_soup_http_src_session_pool_put (src))
+    return;
+
   if (src->session) {
     soup_session_abort (src->session);  /* This unrefs the message. */
     g_object_unref (src->session);
@@ -1449,7 +1768,7 @@ gst_soup_http_src_build_message (GstSoupHTTPSrc * src, const gchar * method)
   gst_soup_http_src_add_range_header (src, src->request_position,
       src->stop_position);
 
-  gst_soup_http_src_add_extra_headers (src);
+  gst_soup_http_src_add_extra_headers (src, src->msg);
 
   return TRUE;
 }
@@ -1543,17 +1862,454 @@ gst_soup_http_src_do_request (GstSoupHTTPSrc * src, const gchar * method,
   return src->ret;
 }
 
+/* Parallel range downloading.
+ *
+ * A window of consecutive ranges is requested at the same time, each with
+ * its own SoupMessage on the shared session. Chunks are allocated with
+ * gst_soup_http_src_chunk_allocator() as for the regular message, but are
+ * queued on their range instead of being returned right away. create()
+ * only returns data from the first range of the window, which gives the
+ * in-order output, and requests a new range whenever one is complete.
+ *
+ * A cancelled range may still get callbacks from the session after the
+ * element is done with it, so it is only freed from its response callback
+ * and never touches the element once cancelled.
+ */
+typedef struct
+{
+  GstSoupHTTPSrc *src;
+  SoupMessage *msg;
+  guint64 start;
+  guint64 stop;                 /* exclusive */
+  guint64 received;
+  GQueue chunks;
+  gboolean done;
+  gboolean failed;
+  gboolean cancelled;
+} GstSoupHTTPSrcRange;
+
+static void
+gst_soup_http_src_range_free (GstSoupHTTPSrcRange * range)
+{
+  GstBuffer *buf;
+
+  while ((buf = g_queue_pop_head (&range->chunks)))
+    gst_buffer_unref (buf);
+  g_slice_free (GstSoupHTTPSrcRange, range);
+}
+
+static SoupBuffer *
+gst_soup_http_src_range_chunk_allocator (SoupMessage * msg, gsize max_len,
+    gpointer user_data)
+{
+  GstSoupHTTPSrcRange *range = user_data;
+
+  /* let soup allocate the memory, we don't need it anymore */
+  if (range->cancelled)
+    return NULL;
+
+  return gst_soup_http_src_chunk_allocator (msg, max_len, range->src);
+}
+
+static void
+gst_soup_http_src_range_got_headers_cb (SoupMessage * msg,
+    GstSoupHTTPSrcRange * range)
+{
+  if (range->cancelled || SOUP_STATUS_IS_REDIRECTION (msg->status_code))
+    return;
+
+  if (msg->status_code != SOUP_STATUS_PARTIAL_CONTENT) {
+    GST_DEBUG_OBJECT (range->src, "range request got response %d, disabling "
+        "parallel download", msg->status_code);
+    range->failed = TRUE;
+    g_main_loop_quit (range->src->loop);
+  }
+}
+
+static void
+gst_soup_http_src_range_got_chunk_cb (SoupMessage * msg, SoupBuffer * chunk,
+    GstSoupHTTPSrcRange * range)
+{
+  SoupGstChunk *gchunk;
+  GstBuffer *buf;
+
+  if (range->cancelled || range->failed ||
+      msg->status_code != SOUP_STATUS_PARTIAL_CONTENT)
+    return;
+
+  gchunk = (SoupGstChunk *) soup_buffer_get_owner (chunk);
+  buf = gst_buffer_ref (gchunk->buffer);
+  gst_buffer_resize (buf, 0, chunk->length);
+
+  g_queue_push_tail (&range->chunks, buf);
+  range->received += chunk->length;
+
+  GST_LOG_OBJECT (range->src, "range %" G_GUINT64_FORMAT " got chunk of %"
+      G_GSIZE_FORMAT " bytes", range->start, chunk->length);
+
+  if (range == g_queue_peek_head (&range->src->ranges))
+    g_main_loop_quit (range->src->loop);
+}
+
+static void
+gst_soup_http_src_range_response_cb (SoupSession * session, SoupMessage * msg,
+    GstSoupHTTPSrcRange * range)
+{
+  if (range->cancelled) {
+    gst_soup_http_src_range_free (range);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (range->src, "range %" G_GUINT64_FORMAT "-%"
+      G_GUINT64_FORMAT " finished with %d, got %" G_GUINT64_FORMAT " bytes",
+      range->start, range->stop, msg->status_code, range->received);
+
+  if (range->received < range->stop - range->start)
+    range->failed = TRUE;
+  range->done = TRUE;
+  range->msg = NULL;
+  g_main_loop_quit (range->src->loop);
+}
+
+static gboolean
+gst_soup_http_src_range_queue (GstSoupHTTPSrc * src, guint64 start,
+    guint64 stop)
+{
+  GstSoupHTTPSrcRange *range;
+  SoupMessage *msg;
+  gchar buf[64];
+
+  msg = soup_message_new (SOUP_METHOD_GET, src->location);
+  if (msg == NULL)
+    return FALSE;
+
+  range = g_slice_new0 (GstSoupHTTPSrcRange);
+  range->src = src;
+  range->msg = msg;
+  range->start = start;
+  range->stop = stop;
+  g_queue_init (&range->chunks);
+
+  if (!src->keep_alive)
+    soup_message_headers_append (msg->request_headers, "Connection", "close");
+  if (src->cookies) {
+    gchar **cookie;
+
+    for (cookie = src->cookies; *cookie != NULL; cookie++)
+      soup_message_headers_append (msg->request_headers, "Cookie", *cookie);
+  }
+  g_snprintf (buf, sizeof (buf), "bytes=%" G_GUINT64_FORMAT "-%"
+      G_GUINT64_FORMAT, start, stop - 1);
+  soup_message_headers_append (msg->request_headers, "Range", buf);
+  gst_soup_http_src_add_extra_headers (src, msg);
+
+  g_signal_connect (msg, "got_headers",
+      G_CALLBACK (gst_soup_http_src_range_got_headers_cb), range);
+  g_signal_connect (msg, "got_chunk",
+      G_CALLBACK (gst_soup_http_src_range_got_chunk_cb), range);
+  soup_message_set_flags (msg, SOUP_MESSAGE_OVERWRITE_CHUNKS |
+      (src->automatic_redirect ? 0 : SOUP_MESSAGE_NO_REDIRECT));
+  soup_message_set_chunk_allocator (msg,
+      gst_soup_http_src_range_chunk_allocator, range, NULL);
+
+  GST_DEBUG_OBJECT (src, "requesting range %s", buf);
+
+  g_queue_push_tail (&src->ranges, range);
+  soup_session_queue_message (src->session, msg,
+      (SoupSessionCallback) gst_soup_http_src_range_response_cb, range);
+
+  return TRUE;
+}
+
+static void
+gst_soup_http_src_range_cancel (GstSoupHTTPSrc * src,
+    GstSoupHTTPSrcRange * range)
+{
+  if (range->msg == NULL) {
+    gst_soup_http_src_range_free (range);
+    return;
+  }
+
+  /* freed in the response callback */
+  range->cancelled = TRUE;
+  soup_session_cancel_message (src->session, range->msg,
+      SOUP_STATUS_CANCELLED);
+}
+
+static void
+gst_soup_http_src_parallel_reset (GstSoupHTTPSrc * src)
+{
+  GstSoupHTTPSrcRange *range;
+
+  while ((range = g_queue_pop_head (&src->ranges)))
+    gst_soup_http_src_range_cancel (src, range);
+  src->ranges_end = 0;
+}
+
+/* keeps parallel-requests ranges in flight up to @end */
+static gboolean
+gst_soup_http_src_parallel_schedule (GstSoupHTTPSrc * src, guint64 end)
+{
+  guint64 stop;
+
+  while (src->ranges.length < src->parallel_requests && src->ranges_end < end) {
+    stop = MIN (src->ranges_end + src->parallel_range_size, end);
+    if (!gst_soup_http_src_range_queue (src, src->ranges_end, stop))
+      return FALSE;
+    src->ranges_end = stop;
+  }
+  return TRUE;
+}
+
+/* Returns GST_FLOW_CUSTOM_SUCCESS if the data should be downloaded with the
+ * regular request instead */
+static GstFlowReturn
+gst_soup_http_src_parallel_create (GstSoupHTTPSrc * src, GstBuffer ** outbuf)
+{
+  GstSoupHTTPSrcRange *range;
+  GstBuffer *buf;
+  guint64 end;
+
+  end = src->content_size;
+  if (src->stop_position != -1 && src->stop_position < end)
+    end = src->stop_position;
+
+  if (src->request_position != src->read_position || !src->ranges_end) {
+    /* start or seek, drop everything and request from the new position */
+    gst_soup_http_src_parallel_reset (src);
+    gst_soup_http_src_cancel_message (src);
+    /* the cancelled message may have flagged EOS */
+    src->ret = GST_FLOW_OK;
+    src->read_position = src->request_position;
+    src->ranges_end = src->read_position;
+    GST_DEBUG_OBJECT (src, "starting parallel download at %" G_GUINT64_FORMAT,
+        src->read_position);
+  }
+
+  if (!gst_soup_http_src_parallel_schedule (src, end))
+    goto fallback;
+
+  while (TRUE) {
+    if (src->interrupted)
+      return GST_FLOW_FLUSHING;
+    /* set by the chunk allocator */
+    if (src->ret != GST_FLOW_OK)
+      return src->ret;
+
+    range = g_queue_peek_head (&src->ranges);
+    if (range == NULL) {
+      GST_DEBUG_OBJECT (src, "parallel download complete");
+      return GST_FLOW_EOS;
+    }
+    if (range->failed)
+      goto fallback;
+
+    if ((buf = g_queue_pop_head (&range->chunks))) {
+      GST_BUFFER_OFFSET (buf) = src->read_position;
+      src->read_position += gst_buffer_get_size (buf);
+      src->request_position = src->read_position;
+      *outbuf = buf;
+      return GST_FLOW_OK;
+    }
+
+    if (range->done) {
+      g_queue_pop_head (&src->ranges);
+      gst_soup_http_src_range_free (range);
+      if (!gst_soup_http_src_parallel_schedule (src, end))
+        goto fallback;
+      continue;
+    }
+
+    g_main_loop_run (src->loop);
+  }
+
+fallback:
+  {
+    GST_INFO_OBJECT (src, "falling back to a single request at %"
+        G_GUINT64_FORMAT, src->read_position);
+    gst_soup_http_src_parallel_reset (src);
+    src->parallel_failed = TRUE;
+    return GST_FLOW_CUSTOM_SUCCESS;
+  }
+}
+
+/* Seek cache.
+ *
+ * Buffers returned by create() are kept, up to cache-size bytes, in a tree
+ * sorted by offset and an LRU list. The entries never overlap, so the tree
+ * can be searched for the entry containing a position. A read at a position
+ * that is in the cache only moves request_position; the running request
+ * stays at read_position and is only restarted if a read misses the cache.
+ */
+typedef struct
+{
+  guint64 offset;               /* first, used as tree key */
+  GstBuffer *buffer;
+  GList link;                   /* in cache_lru, most recent first */
+} GstSoupHTTPSrcCacheEntry;
+
+typedef struct
+{
+  guint64 start;
+  guint64 stop;                 /* exclusive */
+} GstSoupHTTPSrcCacheRange;
+
+static gint
+gst_soup_http_src_cache_compare (gconstpointer a, gconstpointer b)
+{
+  guint64 off_a = *(const guint64 *) a;
+  guint64 off_b = *(const guint64 *) b;
+
+  return (off_a > off_b) - (off_a < off_b);
+}
+
+/* finds an entry overlapping the range */
+static gint
+gst_soup_http_src_cache_search (gconstpointer key, gconstpointer user_data)
+{
+  const GstSoupHTTPSrcCacheEntry *entry = key;
+  const GstSoupHTTPSrcCacheRange *range = user_data;
+
+  if (range->stop <= entry->offset)
+    return -1;
+  if (range->start >= entry->offset + gst_buffer_get_size (entry->buffer))
+    return 1;
+  return 0;
+}
+
+static GstSoupHTTPSrcCacheEntry *
+gst_soup_http_src_cache_lookup (GstSoupHTTPSrc * src, guint64 start,
+    guint64 stop)
+{
+  GstSoupHTTPSrcCacheRange range;
+
+  range.start = start;
+  range.stop = stop;
+  return g_tree_search (src->cache, gst_soup_http_src_cache_search, &range);
+}
+
+static void
+gst_soup_http_src_cache_remove (GstSoupHTTPSrc * src,
+    GstSoupHTTPSrcCacheEntry * entry)
+{
+  g_tree_remove (src->cache, &entry->offset);
+  g_queue_unlink (&src->cache_lru, &entry->link);
+  src->cache_bytes -= gst_buffer_get_size (entry->buffer);
+  gst_buffer_unref (entry->buffer);
+  g_slice_free (GstSoupHTTPSrcCacheEntry, entry);
+}
+
+static void
+gst_soup_http_src_cache_clear (GstSoupHTTPSrc * src)
+{
+  while (src->cache_lru.head)
+    gst_soup_http_src_cache_remove (src, src->cache_lru.head->data);
+}
+
+static void
+gst_soup_http_src_cache_add (GstSoupHTTPSrc * src, guint64 offset,
+    GstBuffer * buffer)
+{
+  GstSoupHTTPSrcCacheEntry *entry;
+  gsize size;
+
+  size = gst_buffer_get_size (buffer);
+  if (size == 0 || size > src->cache_size)
+    return;
+
+  /* we keep the data we already have */
+  if (gst_soup_http_src_cache_lookup (src, offset, offset + size))
+    return;
+
+  entry = g_slice_new0 (GstSoupHTTPSrcCacheEntry);
+  entry->offset = offset;
+  entry->buffer = gst_buffer_ref (buffer);
+  entry->link.data = entry;
+  g_tree_insert (src->cache, &entry->offset, entry);
+  g_queue_push_head_link (&src->cache_lru, &entry->link);
+  src->cache_bytes += size;
+
+  while (src->cache_bytes > src->cache_size)
+    gst_soup_http_src_cache_remove (src, src->cache_lru.tail->data);
+}
+
+/* serves a read at request_position from the cache if possible */
+static gboolean
+gst_soup_http_src_cache_read (GstSoupHTTPSrc * src, GstBuffer ** outbuf)
+{
+  GstSoupHTTPSrcCacheEntry *entry;
+  guint64 pos, skip;
+  gsize size;
+
+  pos = src->request_position;
+  if (src->stop_position != -1 && pos >= src->stop_position)
+    return FALSE;
+
+  entry = gst_soup_http_src_cache_lookup (src, pos, pos + 1);
+  if (entry == NULL)
+    return FALSE;
+
+  size = gst_buffer_get_size (entry->buffer);
+  skip = pos - entry->offset;
+  if (src->stop_position != -1 && src->stop_position < entry->offset + size)
+    size = src->stop_position - entry->offset;
+
+  *outbuf = gst_buffer_copy_region (entry->buffer, GST_BUFFER_COPY_ALL, skip,
+      size - skip);
+  GST_BUFFER_OFFSET (*outbuf) = pos;
+  src->request_position = pos + size - skip;
+
+  g_queue_unlink (&src->cache_lru, &entry->link);
+  g_queue_push_head_link (&src->cache_lru, &entry->link);
+
+  GST_LOG_OBJECT (src, "served %" G_GSIZE_FORMAT " bytes at %" G_GUINT64_FORMAT
+      " from cache", (gsize) (size - skip), pos);
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_soup_http_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 {
   GstSoupHTTPSrc *src;
   GstFlowReturn ret;
+  guint64 position;
 
   src = GST_SOUP_HTTP_SRC (psrc);
 
   g_mutex_lock (&src->mutex);
   *outbuf = NULL;
+  position = src->request_position;
+  if (src->cache_size > 0) {
+    if (gst_soup_http_src_cache_read (src, outbuf)) {
+      GST_OBJECT_LOCK (src);
+      src->cache_hits++;
+      GST_OBJECT_UNLOCK (src);
+      ret = GST_FLOW_OK;
+      goto done;
+    }
+    if (position != src->read_position) {
+      GST_OBJECT_LOCK (src);
+      src->cache_misses++;
+      GST_OBJECT_UNLOCK (src);
+    }
+  }
+  /* switch to parallel ranges once we know the resource is seekable and how
+   * big it is */
+  if (src->parallel_requests > 1 && !src->parallel_failed &&
+      src->got_headers && src->have_size && src->seekable && !src->compress &&
+      src->src_caps == NULL) {
+    ret = gst_soup_http_src_parallel_create (src, outbuf);
+    if (ret != GST_FLOW_CUSTOM_SUCCESS)
+      goto got_data;
+  }
   ret = gst_soup_http_src_do_request (src, SOUP_METHOD_GET, outbuf);
+
+got_data:
+  if (ret == GST_FLOW_OK && *outbuf && src->cache_size > 0)
+    gst_soup_http_src_cache_add (src, position, *outbuf);
+
+done:
   g_mutex_unlock (&src->mutex);
   return ret;
 }
@@ -1575,6 +2331,7 @@ gst_soup_http_src_stop (GstBaseSrc * bsrc)
 
   src = GST_SOUP_HTTP_SRC (bsrc);
   GST_DEBUG_OBJECT (src, "stop()");
+  gst_soup_http_src_parallel_reset (src);
   if (src->keep_alive)
     gst_soup_http_src_cancel_message (src);
   else
@@ -87,6 +87,22 @@ struct _GstSoupHTTPSrc {
   gboolean ssl_strict;
   gchar *ssl_ca_file;
   gboolean ssl_use_system_ca_file;
+  gboolean share_session;      /* Use the process-wide session pool */
+
+  /* Parallel range downloading */
+  guint parallel_requests;
+  guint parallel_range_size;
+  GQueue ranges;               /* Ranges in flight, in stream order */
+  guint64 ranges_end;          /* End of the last requested range */
+  gboolean parallel_failed;    /* Server does not support it */
+
+  /* Seek cache */
+  guint cache_size;
+  GTree *cache;                /* Entries by offset */
+  GQueue cache_lru;            /* Entries, most recently used first */
+  guint64 cache_bytes;
+  guint64 cache_hits;          /* OBJECT_LOCK */
+  guint64 cache_misses;        /* OBJECT_LOCK */
 
   /* Shoutcast/icecast metadata extraction handling. */
   gboolean iradio_mode;
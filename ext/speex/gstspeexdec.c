@@ -139,6 +139,13 @@ gst_speex_dec_reset (GstSpeexDec * dec)
   dec->header = NULL;
   speex_bits_destroy (&dec->bits);
 
+  if (dec->pool) {
+    gst_buffer_pool_set_active (dec->pool, FALSE);
+    gst_object_unref (dec->pool);
+    dec->pool = NULL;
+  }
+  dec->packet_size = 0;
+
   gst_buffer_replace (&dec->streamheader, NULL);
   gst_buffer_replace (&dec->vorbiscomment, NULL);
 
@@ -245,6 +252,23 @@ gst_speex_dec_parse_header (GstSpeexDec * dec, GstBuffer * buf)
   if (!gst_audio_decoder_set_output_format (GST_AUDIO_DECODER (dec), &info))
     goto nego_failed;
 
+  /* all frames of a packet are decoded into one buffer, and as they all have
+   * the same size the buffers can come from a pool */
+  dec->packet_size = dec->frame_size * dec->header->nb_channels * 2 *
+      MAX (dec->header->frames_per_packet, 1);
+  dec->pool = gst_buffer_pool_new ();
+  {
+    GstStructure *config = gst_buffer_pool_get_config (dec->pool);
+
+    gst_buffer_pool_config_set_params (config, NULL, dec->packet_size, 0, 0);
+    if (!gst_buffer_pool_set_config (dec->pool, config) ||
+        !gst_buffer_pool_set_active (dec->pool, TRUE)) {
+      GST_WARNING_OBJECT (dec, "failed to set up buffer pool");
+      gst_object_unref (dec->pool);
+      dec->pool = NULL;
+    }
+  }
+
   return GST_FLOW_OK;
 
   /* ERRORS */
@@ -368,6 +392,8 @@ gst_speex_dec_parse_data (GstSpeexDec * dec, GstBuffer * buf)
   gint i, fpp;
   SpeexBits *bits;
   GstMapInfo map;
+  GstBuffer *outbuf = NULL;
+  gsize frame_bytes;
 
   if (!dec->frame_duration)
     goto not_negotiated;
@@ -391,33 +417,30 @@ gst_speex_dec_parse_data (GstSpeexDec * dec, GstBuffer * buf)
     bits = NULL;
   }
 
-  /* now decode each frame, catering for unknown number of them (e.g. rtp) */
+  if (fpp == 0)
+    return GST_FLOW_OK;
+
+  frame_bytes = dec->frame_size * dec->header->nb_channels * 2;
+
+  if (dec->pool == NULL || fpp * frame_bytes > dec->packet_size ||
+      gst_buffer_pool_acquire_buffer (dec->pool, &outbuf, NULL) != GST_FLOW_OK)
+    outbuf = gst_buffer_new_allocate (NULL, fpp * frame_bytes, NULL);
+  else
+    gst_buffer_set_size (outbuf, fpp * frame_bytes);
+
+  gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
+
+  /* now decode each frame into the output buffer; after a corrupted frame
+   * the rest of the packet can't be decoded either */
   for (i = 0; i < fpp; i++) {
-    GstBuffer *outbuf;
+    spx_int16_t *out = (spx_int16_t *) (map.data + i * frame_bytes);
     gboolean corrupted = FALSE;
     gint ret;
 
     GST_LOG_OBJECT (dec, "decoding frame %d/%d, %d bits remaining", i, fpp,
         bits ? speex_bits_remaining (bits) : -1);
-#if 0
-    res =
-        gst_pad_alloc_buffer_and_set_caps (GST_AUDIO_DECODER_SRC_PAD (dec),
-        GST_BUFFER_OFFSET_NONE, dec->frame_size * dec->header->nb_channels * 2,
-        GST_PAD_CAPS (GST_AUDIO_DECODER_SRC_PAD (dec)), &outbuf);
-
-    if (res != GST_FLOW_OK) {
-      GST_DEBUG_OBJECT (dec, "buf alloc flow: %s", gst_flow_get_name (res));
-      return res;
-    }
-#endif
-    /* FIXME, we can use a bufferpool because we have fixed size buffers. We
-     * could also use an allocator */
-    outbuf =
-        gst_buffer_new_allocate (NULL,
-        dec->frame_size * dec->header->nb_channels * 2, NULL);
 
-    gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-    ret = speex_decode_int (dec->state, bits, (spx_int16_t *) map.data);
+    ret = speex_decode_int (dec->state, bits, out);
 
     if (ret == -1) {
       /* uh? end of stream */
@@ -438,25 +461,26 @@ gst_speex_dec_parse_data (GstSpeexDec * dec, GstBuffer * buf)
       GST_WARNING_OBJECT (dec, "Decoding overflow: corrupted stream?");
       corrupted = TRUE;
     }
+    if (corrupted)
+      break;
+
     if (dec->header->nb_channels == 2)
-      speex_decode_stereo_int ((spx_int16_t *) map.data, dec->frame_size,
-          dec->stereo);
+      speex_decode_stereo_int (out, dec->frame_size, dec->stereo);
+  }
 
-    gst_buffer_unmap (outbuf, &map);
+  gst_buffer_unmap (outbuf, &map);
 
-    if (!corrupted) {
-      res = gst_audio_decoder_finish_frame (GST_AUDIO_DECODER (dec), outbuf, 1);
-    } else {
-      res = gst_audio_decoder_finish_frame (GST_AUDIO_DECODER (dec), NULL, 1);
-      gst_buffer_unref (outbuf);
-    }
-
-    if (res != GST_FLOW_OK) {
-      GST_DEBUG_OBJECT (dec, "flow: %s", gst_flow_get_name (res));
-      break;
-    }
+  if (i > 0) {
+    gst_buffer_set_size (outbuf, i * frame_bytes);
+    res = gst_audio_decoder_finish_frame (GST_AUDIO_DECODER (dec), outbuf, 1);
+  } else {
+    gst_buffer_unref (outbuf);
+    res = gst_audio_decoder_finish_frame (GST_AUDIO_DECODER (dec), NULL, 1);
   }
 
+  if (res != GST_FLOW_OK)
+    GST_DEBUG_OBJECT (dec, "flow: %s", gst_flow_get_name (res));
+
   return res;
 
   /* ERRORS */
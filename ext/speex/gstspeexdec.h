@@ -63,6 +63,8 @@ struct _GstSpeexDec {
 
   gint                  frame_size;
   GstClockTime          frame_duration;
+  GstBufferPool         *pool;          /* output buffers for one packet */
+  gsize                 packet_size;
   guint64               packetno;
 
   GstBuffer             *streamheader;
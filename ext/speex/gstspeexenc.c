@@ -557,9 +557,12 @@ gst_speex_enc_encode (GstSpeexEnc * enc, GstBuffer * buf)
 
   /* FIXME what about dropped samples if DTS enabled ?? */
 
-  while (size) {
-    GST_DEBUG_OBJECT (enc, "encoding %d samples (%d bytes)", frame_size, bytes);
+  GST_LOG_OBJECT (enc, "encoding %d frames of %d samples (%d bytes)",
+      (gint) (size / bytes), frame_size, bytes);
 
+  /* all frames of the packet go into the same bits, which are only reset
+   * once per packet */
+  while (size) {
     if (enc->channels == 2) {
       speex_encode_stereo_int ((gint16 *) data, frame_size, &enc->bits);
     }
@@ -79,6 +79,7 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
 
 G_DEFINE_TYPE (GstId3v2Mux, gst_id3v2_mux, GST_TYPE_TAG_MUX);
 
+static void gst_id3v2_mux_finalize (GObject * object);
 static GstBuffer *gst_id3v2_mux_render_tag (GstTagMux * mux,
     const GstTagList * taglist);
 static GstBuffer *gst_id3v2_mux_render_end_tag (GstTagMux * mux,
@@ -89,6 +90,8 @@ gst_id3v2_mux_class_init (GstId3v2MuxClass * klass)
 {
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
 
+  G_OBJECT_CLASS (klass)->finalize = gst_id3v2_mux_finalize;
+
   GST_TAG_MUX_CLASS (klass)->render_start_tag =
       GST_DEBUG_FUNCPTR (gst_id3v2_mux_render_tag);
   GST_TAG_MUX_CLASS (klass)->render_end_tag =
@@ -114,6 +117,19 @@ gst_id3v2_mux_init (GstId3v2Mux * id3v2mux)
   /* nothing to do */
 }
 
+static void gst_id3v2_mux_picture_free (gpointer data);
+
+static void
+gst_id3v2_mux_finalize (GObject * object)
+{
+  GstId3v2Mux *id3v2mux = GST_ID3V2_MUX (object);
+
+  g_list_free_full (id3v2mux->pictures, gst_id3v2_mux_picture_free);
+  id3v2mux->pictures = NULL;
+
+  G_OBJECT_CLASS (gst_id3v2_mux_parent_class)->finalize (object);
+}
+
 #if 0
 static void
 add_one_txxx_tag (ID3v2::Tag * id3v2tag, const gchar * key, const gchar * val)
@@ -400,89 +416,184 @@ add_id3v2frame_tag (ID3v2::Tag * id3v2tag, const GstTagList * list,
   }
 }
 
+/* rendered APIC frames are kept around for the next tags, so that files
+ * sharing the same artwork (e.g. the tracks of an album) reuse the frame
+ * memory instead of copying the picture through taglib again */
+#define MAX_CACHED_PICTURES 4
+
+typedef struct
+{
+  GstBuffer *image;
+  gchar *mime_type;
+  gchar *desc;
+  gint type;
+  GstMemory *frame;
+} GstId3v2MuxPicture;
+
 static void
-add_image_tag (ID3v2::Tag * id3v2tag, const GstTagList * list,
-    const gchar * tag, guint num_tags, const gchar * unused)
+gst_id3v2_mux_picture_free (gpointer data)
 {
-  guint n;
+  GstId3v2MuxPicture *picture = (GstId3v2MuxPicture *) data;
 
-  for (n = 0; n < num_tags; ++n) {
-    const GValue *val;
-    GstSample *sample;
-    GstBuffer *image;
+  gst_buffer_unref (picture->image);
+  g_free (picture->mime_type);
+  g_free (picture->desc);
+  gst_memory_unref (picture->frame);
+  g_slice_free (GstId3v2MuxPicture, picture);
+}
 
-    GST_DEBUG ("image %u/%u", n + 1, num_tags);
+static gboolean
+gst_id3v2_mux_picture_matches (GstId3v2MuxPicture * picture, GstBuffer * image,
+    const gchar * mime_type, const gchar * desc, gint type)
+{
+  gsize size;
 
-    val = gst_tag_list_get_value_index (list, tag, n);
-    sample = (GstSample *) g_value_get_boxed (val);
+  if (picture->type != type || strcmp (picture->mime_type, mime_type) != 0
+      || strcmp (picture->desc, desc) != 0)
+    return FALSE;
 
-    if (GST_IS_SAMPLE (sample) && (image = gst_sample_get_buffer (sample)) &&
-        GST_IS_BUFFER (image) && gst_buffer_get_size (image) > 0 &&
-        gst_sample_get_caps (sample) != NULL &&
-        !gst_caps_is_empty (gst_sample_get_caps (sample))) {
-      const gchar *mime_type;
-      GstStructure *s;
+  if (picture->image == image)
+    return TRUE;
 
-      s = gst_caps_get_structure (gst_sample_get_caps (sample), 0);
-      mime_type = gst_structure_get_name (s);
-      if (mime_type != NULL) {
-        ID3v2::AttachedPictureFrame * frame;
-        const gchar *desc = NULL;
-        GstMapInfo map;
-        const GstStructure *info_struct;
+  size = gst_buffer_get_size (image);
+  if (gst_buffer_get_size (picture->image) != size)
+    return FALSE;
+
+  /* comparing is still cheaper than copying and rendering the frame */
+  {
+    GstMapInfo map;
+    gboolean res;
+
+    gst_buffer_map (image, &map, GST_MAP_READ);
+    res = (gst_buffer_memcmp (picture->image, 0, map.data, size) == 0);
+    gst_buffer_unmap (image, &map);
 
-        info_struct = gst_sample_get_info (sample);
-        if (!info_struct
-            || !gst_structure_has_name (info_struct, "GstTagImageInfo"))
-          info_struct = NULL;
+    return res;
+  }
+}
 
-        if (strcmp (mime_type, "text/uri-list") == 0)
-          mime_type = "-->";
+static GstMemory *
+gst_id3v2_mux_render_picture (GstBuffer * image, const gchar * mime_type,
+    const gchar * desc, gint type)
+{
+  ID3v2::AttachedPictureFrame frame;
+  ByteVector rendered_frame;
+  GstMapInfo map;
+  gpointer data;
+  gsize size;
 
-        frame = new ID3v2::AttachedPictureFrame ();
+  gst_buffer_map (image, &map, GST_MAP_READ);
 
-        gst_buffer_map (image, &map, GST_MAP_READ);
+  GST_DEBUG ("Attaching picture of %" G_GSIZE_FORMAT " bytes and mime type %s",
+      map.size, mime_type);
 
-        GST_DEBUG ("Attaching picture of %" G_GSIZE_FORMAT " bytes and mime type %s",
-            map.size, mime_type);
+  frame.setPicture (ByteVector ((const char *) map.data, map.size));
+  frame.setTextEncoding (String::UTF8);
+  frame.setMimeType (mime_type);
 
-        id3v2tag->addFrame (frame);
-        frame->setPicture (ByteVector ((const char *) map.data, map.size));
-        frame->setTextEncoding (String::UTF8);
-        frame->setMimeType (mime_type);
+  gst_buffer_unmap (image, &map);
 
-        gst_buffer_unmap (image, &map);
+  frame.setDescription (desc);
+  frame.setType ((TagLib::ID3v2::AttachedPictureFrame::Type) type);
 
-        if (info_struct)
-          desc = gst_structure_get_string (info_struct, "image-description");
+  rendered_frame = frame.render ();
+  size = rendered_frame.size ();
+  data = g_memdup (rendered_frame.data (), size);
 
-        frame->setDescription ((desc) ? desc : "");
+  return gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, data, size, 0,
+      size, data, g_free);
+}
+
+/* returns a ref to the rendered APIC frame for image @n of @tag, or NULL */
+static GstMemory *
+gst_id3v2_mux_get_picture (GstId3v2Mux * mux, const GstTagList * list,
+    const gchar * tag, guint n)
+{
+  GstId3v2MuxPicture *picture;
+  const GValue *val;
+  GstSample *sample;
+  GstBuffer *image;
+  const gchar *mime_type;
+  const gchar *desc = NULL;
+  const GstStructure *info_struct;
+  GstStructure *s;
+  gint type;
+  GList *l;
+
+  val = gst_tag_list_get_value_index (list, tag, n);
+  sample = (GstSample *) g_value_get_boxed (val);
+
+  if (!GST_IS_SAMPLE (sample) || !(image = gst_sample_get_buffer (sample)) ||
+      !GST_IS_BUFFER (image) || gst_buffer_get_size (image) == 0 ||
+      gst_sample_get_caps (sample) == NULL ||
+      gst_caps_is_empty (gst_sample_get_caps (sample))) {
+    GST_WARNING ("NULL image or no caps on image sample (%p, caps=%"
+        GST_PTR_FORMAT ")", sample,
+        (sample) ? gst_sample_get_caps (sample) : NULL);
+    return NULL;
+  }
 
-        if (strcmp (tag, GST_TAG_PREVIEW_IMAGE) == 0) {
-          frame->setType (ID3v2::AttachedPictureFrame::FileIcon);
+  s = gst_caps_get_structure (gst_sample_get_caps (sample), 0);
+  mime_type = gst_structure_get_name (s);
+  if (mime_type == NULL)
+    return NULL;
+
+  info_struct = gst_sample_get_info (sample);
+  if (!info_struct || !gst_structure_has_name (info_struct, "GstTagImageInfo"))
+    info_struct = NULL;
+
+  if (strcmp (mime_type, "text/uri-list") == 0)
+    mime_type = "-->";
+
+  if (info_struct)
+    desc = gst_structure_get_string (info_struct, "image-description");
+  if (desc == NULL)
+    desc = "";
+
+  if (strcmp (tag, GST_TAG_PREVIEW_IMAGE) == 0) {
+    type = ID3v2::AttachedPictureFrame::FileIcon;
+  } else {
+    type = ID3v2::AttachedPictureFrame::Other;
+
+    if (info_struct) {
+      if (gst_structure_get (info_struct, "image-type",
+              GST_TYPE_TAG_IMAGE_TYPE, &type, NULL)) {
+        if (type > 0 && type <= 18) {
+          type += 2;
         } else {
-          int image_type = ID3v2::AttachedPictureFrame::Other;
-
-          if (info_struct) {
-            if (gst_structure_get (info_struct, "image-type",
-                    GST_TYPE_TAG_IMAGE_TYPE, &image_type, NULL)) {
-              if (image_type > 0 && image_type <= 18) {
-                image_type += 2;
-              } else {
-                image_type = ID3v2::AttachedPictureFrame::Other;
-              }
-            }
-          }
-
-          frame->setType ((TagLib::ID3v2::AttachedPictureFrame::Type) image_type);
+          type = ID3v2::AttachedPictureFrame::Other;
         }
       }
-    } else {
-      GST_WARNING ("NULL image or no caps on image sample (%p, caps=%"
-          GST_PTR_FORMAT ")", sample,
-          (sample) ? gst_sample_get_caps (sample) : NULL);
     }
   }
+
+  for (l = mux->pictures; l != NULL; l = l->next) {
+    picture = (GstId3v2MuxPicture *) l->data;
+
+    if (gst_id3v2_mux_picture_matches (picture, image, mime_type, desc, type)) {
+      GST_LOG_OBJECT (mux, "reusing rendered picture frame");
+      /* keep the most recently used pictures at the front */
+      mux->pictures = g_list_remove_link (mux->pictures, l);
+      mux->pictures = g_list_concat (l, mux->pictures);
+      return gst_memory_ref (picture->frame);
+    }
+  }
+
+  picture = g_slice_new (GstId3v2MuxPicture);
+  picture->image = gst_buffer_ref (image);
+  picture->mime_type = g_strdup (mime_type);
+  picture->desc = g_strdup (desc);
+  picture->type = type;
+  picture->frame = gst_id3v2_mux_render_picture (image, mime_type, desc, type);
+
+  mux->pictures = g_list_prepend (mux->pictures, picture);
+  if (g_list_length (mux->pictures) > MAX_CACHED_PICTURES) {
+    l = g_list_last (mux->pictures);
+    gst_id3v2_mux_picture_free (l->data);
+    mux->pictures = g_list_delete_link (mux->pictures, l);
+  }
+
+  return gst_memory_ref (picture->frame);
 }
 
 static void
@@ -703,8 +814,8 @@ static const struct
   GST_TAG_COMMENT, add_comment_tag, ""}, {
   GST_TAG_EXTENDED_COMMENT, add_comment_tag, ""}, {
   GST_TAG_DATE, add_date_tag, ""}, {
-  GST_TAG_IMAGE, add_image_tag, ""}, {
-  GST_TAG_PREVIEW_IMAGE, add_image_tag, ""}, {
+  GST_TAG_IMAGE, NULL, ""}, {
+  GST_TAG_PREVIEW_IMAGE, NULL, ""}, {
   GST_ID3_DEMUX_TAG_ID3V2_FRAME, add_id3v2frame_tag, ""}, {
   GST_TAG_MUSICBRAINZ_ARTISTID, add_musicbrainz_tag, "\000"}, {
   GST_TAG_MUSICBRAINZ_ALBUMID, add_musicbrainz_tag, "\001"}, {
@@ -750,7 +861,9 @@ foreach_add_tag (const GstTagList * list, const gchar * tag, gpointer userdata)
 
   for (i = 0; i < G_N_ELEMENTS (add_funcs); ++i) {
     if (strcmp (add_funcs[i].gst_tag, tag) == 0) {
-      add_funcs[i].func (id3v2tag, list, tag, num_tags, add_funcs[i].data);
+      /* images are rendered separately, see gst_id3v2_mux_get_picture() */
+      if (add_funcs[i].func != NULL)
+        add_funcs[i].func (id3v2tag, list, tag, num_tags, add_funcs[i].data);
       break;
     }
   }
@@ -760,13 +873,27 @@ foreach_add_tag (const GstTagList * list, const gchar * tag, gpointer userdata)
   }
 }
 
+static GstMemory *
+gst_id3v2_mux_wrap_bytes (const ByteVector & bytes)
+{
+  gsize size = bytes.size ();
+  gpointer data;
+
+  data = g_memdup (bytes.data (), size);
+  return gst_memory_new_wrapped ((GstMemoryFlags) 0, data, size, 0, size,
+      data, g_free);
+}
+
 static GstBuffer *
 gst_id3v2_mux_render_tag (GstTagMux * mux, const GstTagList * taglist)
 {
+  GstId3v2Mux *id3v2mux = GST_ID3V2_MUX (mux);
+  static const gchar *image_tags[] = { GST_TAG_IMAGE, GST_TAG_PREVIEW_IMAGE };
   ID3v2::Tag id3v2tag;
-  ByteVector rendered_tag;
+  ByteVector rendered_tag, header, body;
   GstBuffer *buf;
-  guint tag_size;
+  GstMemory *frame;
+  guint tag_size, frames_size, i, n, num_tags;
 
   /* write all strings as UTF-8 by default */
   TagLib::ID3v2::FrameFactory::instance ()->
@@ -788,13 +915,46 @@ gst_id3v2_mux_render_tag (GstTagMux * mux, const GstTagList * taglist)
 #endif
 
   rendered_tag = id3v2tag.render ();
-  tag_size = rendered_tag.size ();
 
-  GST_LOG_OBJECT (mux, "tag size = %d bytes", tag_size);
+  /* Put the picture frames in front of the other frames, sharing their
+   * memory with the cache, and fix up the tag size in the header */
+  buf = gst_buffer_new ();
+  frames_size = 0;
+
+  for (i = 0; i < G_N_ELEMENTS (image_tags); ++i) {
+    num_tags = gst_tag_list_get_tag_size (taglist, image_tags[i]);
+
+    for (n = 0; n < num_tags; ++n) {
+      GST_DEBUG ("image %u/%u", n + 1, num_tags);
+
+      frame = gst_id3v2_mux_get_picture (id3v2mux, taglist, image_tags[i], n);
+      if (frame != NULL) {
+        frames_size += gst_memory_get_sizes (frame, NULL, NULL);
+        gst_buffer_append_memory (buf, frame);
+      }
+    }
+  }
+
+  if (frames_size > 0) {
+    if (rendered_tag.size () >= 10) {
+      header = rendered_tag.mid (0, 6);
+      body = rendered_tag.mid (10);
+    } else {
+      /* ID3v2.4.0, no flags */
+      header = ByteVector ("ID3\004\000\000", 6);
+    }
+    header.append (ID3v2::SynchData::fromUInt (body.size () + frames_size));
 
-  /* Create buffer with tag */
-  buf = gst_buffer_new_and_alloc (tag_size);
-  gst_buffer_fill (buf, 0, rendered_tag.data (), tag_size);
+    gst_buffer_prepend_memory (buf, gst_id3v2_mux_wrap_bytes (header));
+    if (body.size () > 0)
+      gst_buffer_append_memory (buf, gst_id3v2_mux_wrap_bytes (body));
+  } else if (rendered_tag.size () > 0) {
+    gst_buffer_append_memory (buf, gst_id3v2_mux_wrap_bytes (rendered_tag));
+  }
+
+  tag_size = gst_buffer_get_size (buf);
+
+  GST_LOG_OBJECT (mux, "tag size = %d bytes", tag_size);
 
   return buf;
 }
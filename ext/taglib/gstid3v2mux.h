@@ -30,6 +30,9 @@ typedef struct _GstId3v2MuxClass GstId3v2MuxClass;
 
 struct _GstId3v2Mux {
   GstTagMux  tagmux;
+
+  /* rendered APIC frames of recently written images, most recent first */
+  GList     *pictures;
 };
 
 struct _GstId3v2MuxClass {
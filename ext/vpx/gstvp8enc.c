@@ -44,6 +44,16 @@
  * ]| This example pipeline will encode a test video source to VP8 muxed in an
  * WebM container.
  * </refsect2>
+ * <refsect2>
+ * <title>Encoding several renditions</title>
+ * |[
+ * gst-launch -v videotestsrc num-buffers=1000 ! tee name=t \
+ *   t. ! queue ! vp8enc target-bitrate=2000000 ! webmmux ! filesink location=high.webm \
+ *   t. ! queue ! videoscale ! video/x-raw,width=640,height=360 ! vp8enc target-bitrate=800000 ! webmmux ! filesink location=low.webm
+ * ]| Each rendition is encoded by its own vp8enc in its own thread. The
+ * input frames are shared by reference between the branches and handed to
+ * libvpx without copying them.
+ * </refsect2>
  */
 
 #ifdef HAVE_CONFIG_H
@@ -71,7 +81,6 @@ GST_DEBUG_CATEGORY_STATIC (gst_vp8enc_debug);
 
 typedef struct
 {
-  vpx_image_t *image;
   GList *invisible;
 } GstVP8EncUserData;
 
@@ -85,9 +94,6 @@ _gst_mini_object_unref0 (GstMiniObject * obj)
 static void
 gst_vp8_enc_user_data_free (GstVP8EncUserData * user_data)
 {
-  if (user_data->image)
-    g_slice_free (vpx_image_t, user_data->image);
-
   g_list_foreach (user_data->invisible, (GFunc) _gst_mini_object_unref0, NULL);
   g_list_free (user_data->invisible);
   g_slice_free (GstVP8EncUserData, user_data);
@@ -148,6 +154,7 @@ gst_vp8_enc_user_data_free (GstVP8EncUserData * user_data)
 #define DEFAULT_MAX_INTRA_BITRATE_PCT 0
 #define DEFAULT_TIMEBASE_N 0
 #define DEFAULT_TIMEBASE_D 1
+#define DEFAULT_STATS_INTERVAL 0
 
 enum
 {
@@ -195,7 +202,8 @@ enum
   PROP_TUNING,
   PROP_CQ_LEVEL,
   PROP_MAX_INTRA_BITRATE_PCT,
-  PROP_TIMEBASE
+  PROP_TIMEBASE,
+  PROP_STATS_INTERVAL
 };
 
 #define GST_VP8_ENC_END_USAGE_TYPE (gst_vp8_enc_end_usage_get_type())
@@ -708,6 +716,25 @@ gst_vp8_enc_class_init (GstVP8EncClass * klass)
           0, 1, G_MAXINT, 1, DEFAULT_TIMEBASE_N, DEFAULT_TIMEBASE_D,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstVP8Enc:stats-interval:
+   *
+   * Number of frames after which a "vpx-encoder-stats" element message is
+   * posted. It has the "frames" count, the "dropped" frames and the encoded
+   * "bytes", the minimum, mean, maximum and 50th/90th/99th percentile of the
+   * duration of the encode calls as "encode-time-*" and the minimum, mean
+   * and maximum "quantizer-*". The "timestamp" is the one of the last frame.
+   * Dropped frames are only detected with #GstVP8Enc:lag-in-frames set to 0.
+   * 0 disables the statistics.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS_INTERVAL,
+      g_param_spec_uint ("stats-interval", "Statistics interval",
+          "Number of frames between encoding statistics messages "
+          "(0 = disabled)", 0, G_MAXINT, DEFAULT_STATS_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (gst_vp8enc_debug, "vp8enc", 0, "VP8 Encoder");
 }
 
@@ -781,6 +808,9 @@ gst_vp8_enc_init (GstVP8Enc * gst_vp8_enc)
 
   gst_vp8_enc->cfg.g_profile = DEFAULT_PROFILE;
 
+  gst_vp8_enc->stats_interval = DEFAULT_STATS_INTERVAL;
+  gst_vpx_enc_stats_init (&gst_vp8_enc->stats);
+
   g_mutex_init (&gst_vp8_enc->encoder_lock);
 }
 
@@ -800,6 +830,8 @@ gst_vp8_enc_finalize (GObject * object)
   if (gst_vp8_enc->input_state)
     gst_video_codec_state_unref (gst_vp8_enc->input_state);
 
+  gst_vpx_enc_stats_clear (&gst_vp8_enc->stats);
+
   g_mutex_clear (&gst_vp8_enc->encoder_lock);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -1176,6 +1208,9 @@ gst_vp8_enc_set_property (GObject * object, guint prop_id,
       gst_vp8_enc->timebase_n = gst_value_get_fraction_numerator (value);
       gst_vp8_enc->timebase_d = gst_value_get_fraction_denominator (value);
       break;
+    case PROP_STATS_INTERVAL:
+      gst_vp8_enc->stats_interval = g_value_get_uint (value);
+      break;
     default:
       break;
   }
@@ -1397,6 +1432,9 @@ gst_vp8_enc_get_property (GObject * object, guint prop_id, GValue * value,
       gst_value_set_fraction (value, gst_vp8_enc->timebase_n,
           gst_vp8_enc->timebase_d);
       break;
+    case PROP_STATS_INTERVAL:
+      g_value_set_uint (value, gst_vp8_enc->stats_interval);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1448,6 +1486,9 @@ gst_vp8_enc_stop (GstVideoEncoder * video_encoder)
   }
   g_mutex_unlock (&encoder->encoder_lock);
 
+  gst_vpx_enc_stats_reset (&encoder->stats);
+  encoder->n_packets = 0;
+
   gst_tag_setter_reset_tags (GST_TAG_SETTER (encoder));
 
   return TRUE;
@@ -1845,9 +1886,8 @@ gst_vp8_enc_process (GstVP8Enc * encoder)
         gst_buffer_new_wrapped (g_memdup (pkt->data.frame.buf,
             pkt->data.frame.sz), pkt->data.frame.sz);
 
-    if (user_data->image)
-      g_slice_free (vpx_image_t, user_data->image);
-    user_data->image = NULL;
+    encoder->n_packets++;
+    encoder->stats.bytes += pkt->data.frame.sz;
 
     if (invisible) {
       user_data->invisible = g_list_append (user_data->invisible, buffer);
@@ -1906,11 +1946,13 @@ gst_vp8_enc_finish (GstVideoEncoder * video_encoder)
   return GST_FLOW_OK;
 }
 
-static vpx_image_t *
-gst_vp8_enc_buffer_to_image (GstVP8Enc * enc, GstVideoFrame * frame)
+/* wraps the planes of the mapped frame, libvpx copies the image into its
+ * lookahead queue while encoding so it only has to live during
+ * vpx_codec_encode() */
+static void
+gst_vp8_enc_buffer_to_image (GstVP8Enc * enc, GstVideoFrame * frame,
+    vpx_image_t * image)
 {
-  vpx_image_t *image = g_slice_new (vpx_image_t);
-
   memcpy (image, &enc->image, sizeof (*image));
 
   image->planes[VPX_PLANE_Y] = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
@@ -1920,8 +1962,27 @@ gst_vp8_enc_buffer_to_image (GstVP8Enc * enc, GstVideoFrame * frame)
   image->stride[VPX_PLANE_Y] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
   image->stride[VPX_PLANE_U] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 1);
   image->stride[VPX_PLANE_V] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 2);
+}
 
-  return image;
+/* accounts the encoding of one frame and posts the statistics message
+ * every stats-interval frames */
+static void
+gst_vp8_enc_update_stats (GstVP8Enc * encoder, GstClockTime encode_time,
+    gint quantizer, gboolean dropped, GstClockTime timestamp)
+{
+  GST_LOG_OBJECT (encoder, "encoded frame %" GST_TIME_FORMAT " in %"
+      GST_TIME_FORMAT ", quantizer %d%s", GST_TIME_ARGS (timestamp),
+      GST_TIME_ARGS (encode_time), quantizer, dropped ? ", dropped" : "");
+
+  gst_vpx_enc_stats_add_frame (&encoder->stats, encode_time, quantizer,
+      dropped, timestamp);
+
+  if (encoder->stats.encode_times->len >= encoder->stats_interval) {
+    gst_element_post_message (GST_ELEMENT_CAST (encoder),
+        gst_message_new_element (GST_OBJECT_CAST (encoder),
+            gst_vpx_enc_stats_to_structure (&encoder->stats)));
+    gst_vpx_enc_stats_reset (&encoder->stats);
+  }
 }
 
 static GstFlowReturn
@@ -1931,9 +1992,13 @@ gst_vp8_enc_handle_frame (GstVideoEncoder * video_encoder,
   GstVP8Enc *encoder;
   vpx_codec_err_t status;
   int flags = 0;
-  vpx_image_t *image;
+  vpx_image_t image;
   GstVP8EncUserData *user_data;
   GstVideoFrame vframe;
+  GstClockTime start, encode_time, timestamp;
+  gint quantizer = 0;
+  guint64 n_packets;
+  GstFlowReturn ret;
 
   GST_DEBUG_OBJECT (video_encoder, "handle_frame");
 
@@ -1947,10 +2012,9 @@ gst_vp8_enc_handle_frame (GstVideoEncoder * video_encoder,
 
   gst_video_frame_map (&vframe, &encoder->input_state->info,
       frame->input_buffer, GST_MAP_READ);
-  image = gst_vp8_enc_buffer_to_image (encoder, &vframe);
+  gst_vp8_enc_buffer_to_image (encoder, &vframe, &image);
 
   user_data = g_slice_new0 (GstVP8EncUserData);
-  user_data->image = image;
   gst_video_codec_frame_set_user_data (frame, user_data,
       (GDestroyNotify) gst_vp8_enc_user_data_free);
 
@@ -1958,9 +2022,17 @@ gst_vp8_enc_handle_frame (GstVideoEncoder * video_encoder,
     flags |= VPX_EFLAG_FORCE_KF;
   }
 
+  n_packets = encoder->n_packets;
+  timestamp = frame->pts;
+
   g_mutex_lock (&encoder->encoder_lock);
-  status = vpx_codec_encode (&encoder->encoder, image,
+  start = gst_util_get_timestamp ();
+  status = vpx_codec_encode (&encoder->encoder, &image,
       encoder->n_frames, 1, flags, encoder->deadline);
+  encode_time = gst_util_get_timestamp () - start;
+  if (encoder->stats_interval > 0 && status == VPX_CODEC_OK)
+    vpx_codec_control (&encoder->encoder, VP8E_GET_LAST_QUANTIZER_64,
+        &quantizer);
   g_mutex_unlock (&encoder->encoder_lock);
   gst_video_frame_unmap (&vframe);
 
@@ -1971,7 +2043,14 @@ gst_vp8_enc_handle_frame (GstVideoEncoder * video_encoder,
     return FALSE;
   }
   gst_video_codec_frame_unref (frame);
-  return gst_vp8_enc_process (encoder);
+  ret = gst_vp8_enc_process (encoder);
+
+  if (encoder->stats_interval > 0)
+    gst_vp8_enc_update_stats (encoder, encode_time, quantizer,
+        encoder->n_packets == n_packets && encoder->cfg.g_lag_in_frames == 0,
+        timestamp);
+
+  return ret;
 }
 
 static guint64
@@ -40,6 +40,8 @@
 #include <vpx/vpx_encoder.h>
 #include <vpx/vp8cx.h>
 
+#include "gstvp8utils.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_VP8_ENC \
@@ -106,6 +108,11 @@ struct _GstVP8Enc
   int keyframe_distance;
 
   GstVideoCodecState *input_state;
+
+  /* statistics */
+  guint stats_interval;
+  GstVPXEncStats stats;
+  guint64 n_packets;
 };
 
 struct _GstVP8EncClass
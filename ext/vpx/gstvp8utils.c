@@ -24,6 +24,9 @@
 #include "config.h"
 #endif
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <gst/gst.h>
 
 /* FIXME: Undef HAVE_CONFIG_H because vpx_codec.h uses it,
@@ -62,3 +65,93 @@ gst_vpx_error_name (vpx_codec_err_t status)
       return "unknown";
   }
 }
+
+void
+gst_vpx_enc_stats_init (GstVPXEncStats * stats)
+{
+  memset (stats, 0, sizeof (*stats));
+  stats->encode_times = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+  gst_vpx_enc_stats_reset (stats);
+}
+
+void
+gst_vpx_enc_stats_clear (GstVPXEncStats * stats)
+{
+  g_array_free (stats->encode_times, TRUE);
+  stats->encode_times = NULL;
+}
+
+void
+gst_vpx_enc_stats_reset (GstVPXEncStats * stats)
+{
+  g_array_set_size (stats->encode_times, 0);
+  stats->dropped = 0;
+  stats->bytes = 0;
+  stats->quantizer_sum = 0;
+  stats->quantizer_min = G_MAXINT;
+  stats->quantizer_max = G_MININT;
+  stats->timestamp = GST_CLOCK_TIME_NONE;
+}
+
+void
+gst_vpx_enc_stats_add_frame (GstVPXEncStats * stats,
+    GstClockTime encode_time, gint quantizer, gboolean dropped,
+    GstClockTime timestamp)
+{
+  g_array_append_val (stats->encode_times, encode_time);
+  if (dropped)
+    stats->dropped++;
+  stats->quantizer_sum += quantizer;
+  stats->quantizer_min = MIN (stats->quantizer_min, quantizer);
+  stats->quantizer_max = MAX (stats->quantizer_max, quantizer);
+  stats->timestamp = timestamp;
+}
+
+static gint
+compare_clock_time (gconstpointer a, gconstpointer b)
+{
+  GstClockTime ta = *(const GstClockTime *) a;
+  GstClockTime tb = *(const GstClockTime *) b;
+
+  return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+/* nearest rank percentile of the sorted times */
+static GstClockTime
+percentile (const GstClockTime * times, guint n, guint p)
+{
+  guint rank = (n * p + 99) / 100;
+
+  return times[MAX (rank, 1) - 1];
+}
+
+/* Builds the structure of the element message of the frames since the
+ * last reset. Times are the durations of the vpx_codec_encode() calls. */
+GstStructure *
+gst_vpx_enc_stats_to_structure (GstVPXEncStats * stats)
+{
+  GstClockTime *times = (GstClockTime *) stats->encode_times->data;
+  guint i, n = stats->encode_times->len;
+  GstClockTime total = 0;
+
+  g_return_val_if_fail (n > 0, NULL);
+
+  qsort (times, n, sizeof (GstClockTime), compare_clock_time);
+  for (i = 0; i < n; i++)
+    total += times[i];
+
+  return gst_structure_new ("vpx-encoder-stats",
+      "timestamp", G_TYPE_UINT64, stats->timestamp,
+      "frames", G_TYPE_UINT, n,
+      "dropped", G_TYPE_UINT, stats->dropped,
+      "bytes", G_TYPE_UINT64, stats->bytes,
+      "encode-time-min", G_TYPE_UINT64, times[0],
+      "encode-time-mean", G_TYPE_UINT64, total / n,
+      "encode-time-max", G_TYPE_UINT64, times[n - 1],
+      "encode-time-p50", G_TYPE_UINT64, percentile (times, n, 50),
+      "encode-time-p90", G_TYPE_UINT64, percentile (times, n, 90),
+      "encode-time-p99", G_TYPE_UINT64, percentile (times, n, 99),
+      "quantizer-min", G_TYPE_INT, stats->quantizer_min,
+      "quantizer-mean", G_TYPE_DOUBLE, (gdouble) stats->quantizer_sum / n,
+      "quantizer-max", G_TYPE_INT, stats->quantizer_max, NULL);
+}
@@ -44,4 +44,23 @@ G_BEGIN_DECLS
 
 const char * gst_vpx_error_name (vpx_codec_err_t status);
 
+/* encoding statistics of the frames since the last report */
+typedef struct
+{
+  GArray *encode_times;
+  guint dropped;
+  guint64 bytes;
+  gint64 quantizer_sum;
+  gint quantizer_min, quantizer_max;
+  GstClockTime timestamp;
+} GstVPXEncStats;
+
+void gst_vpx_enc_stats_init (GstVPXEncStats * stats);
+void gst_vpx_enc_stats_clear (GstVPXEncStats * stats);
+void gst_vpx_enc_stats_reset (GstVPXEncStats * stats);
+void gst_vpx_enc_stats_add_frame (GstVPXEncStats * stats,
+    GstClockTime encode_time, gint quantizer, gboolean dropped,
+    GstClockTime timestamp);
+GstStructure * gst_vpx_enc_stats_to_structure (GstVPXEncStats * stats);
+
 G_END_DECLS
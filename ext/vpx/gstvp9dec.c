@@ -59,6 +59,8 @@ GST_DEBUG_CATEGORY_STATIC (gst_vp9dec_debug);
 #define DEFAULT_DEBLOCKING_LEVEL 4
 #define DEFAULT_NOISE_LEVEL 0
 #define DEFAULT_THREADS 1
+#define DEFAULT_FRAME_PARALLEL FALSE
+#define DEFAULT_ROW_MT FALSE
 
 enum
 {
@@ -67,7 +69,9 @@ enum
   PROP_POST_PROCESSING_FLAGS,
   PROP_DEBLOCKING_LEVEL,
   PROP_NOISE_LEVEL,
-  PROP_THREADS
+  PROP_THREADS,
+  PROP_FRAME_PARALLEL,
+  PROP_ROW_MT
 };
 
 #define C_FLAGS(v) ((guint) v)
@@ -107,6 +111,7 @@ static gboolean gst_vp9_dec_stop (GstVideoDecoder * decoder);
 static gboolean gst_vp9_dec_set_format (GstVideoDecoder * decoder,
     GstVideoCodecState * state);
 static gboolean gst_vp9_dec_flush (GstVideoDecoder * decoder);
+static GstFlowReturn gst_vp9_dec_finish (GstVideoDecoder * decoder);
 static GstFlowReturn gst_vp9_dec_handle_frame (GstVideoDecoder * decoder,
     GstVideoCodecFrame * frame);
 static gboolean gst_vp9_dec_decide_allocation (GstVideoDecoder * decoder,
@@ -171,6 +176,36 @@ gst_vp9_dec_class_init (GstVP9DecClass * klass)
           "Maximum number of decoding threads",
           1, 16, DEFAULT_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstVP9Dec:frame-parallel:
+   *
+   * Decode up to #GstVP9Dec:threads frames in parallel. This scales a lot
+   * better with the number of threads than the tile based threading libvpx
+   * uses otherwise, but frames come out threads - 1 frames later, which is
+   * reported as latency. Not used together with post processing, and has
+   * no effect with versions of libvpx without frame threading.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_FRAME_PARALLEL,
+      g_param_spec_boolean ("frame-parallel", "Frame Parallel",
+          "Decode multiple frames in parallel, adds latency",
+          DEFAULT_FRAME_PARALLEL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVP9Dec:row-mt:
+   *
+   * Let the decoding threads work on rows of the same tile, so streams
+   * with few tile columns can use more threads as well. Has no effect with
+   * versions of libvpx without row based multithreading.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_ROW_MT,
+      g_param_spec_boolean ("row-mt", "Row Multithreading",
+          "Decode rows of a tile in parallel", DEFAULT_ROW_MT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&gst_vp9_dec_src_template));
   gst_element_class_add_pad_template (element_class,
@@ -185,6 +220,7 @@ gst_vp9_dec_class_init (GstVP9DecClass * klass)
   base_video_decoder_class->start = GST_DEBUG_FUNCPTR (gst_vp9_dec_start);
   base_video_decoder_class->stop = GST_DEBUG_FUNCPTR (gst_vp9_dec_stop);
   base_video_decoder_class->flush = GST_DEBUG_FUNCPTR (gst_vp9_dec_flush);
+  base_video_decoder_class->finish = GST_DEBUG_FUNCPTR (gst_vp9_dec_finish);
   base_video_decoder_class->set_format =
       GST_DEBUG_FUNCPTR (gst_vp9_dec_set_format);
   base_video_decoder_class->handle_frame =
@@ -205,6 +241,9 @@ gst_vp9_dec_init (GstVP9Dec * gst_vp9_dec)
   gst_vp9_dec->post_processing_flags = DEFAULT_POST_PROCESSING_FLAGS;
   gst_vp9_dec->deblocking_level = DEFAULT_DEBLOCKING_LEVEL;
   gst_vp9_dec->noise_level = DEFAULT_NOISE_LEVEL;
+  gst_vp9_dec->threads = DEFAULT_THREADS;
+  gst_vp9_dec->frame_parallel = DEFAULT_FRAME_PARALLEL;
+  gst_vp9_dec->row_mt = DEFAULT_ROW_MT;
 
   gst_video_decoder_set_needs_format (decoder, TRUE);
 }
@@ -235,6 +274,12 @@ gst_vp9_dec_set_property (GObject * object, guint prop_id,
     case PROP_THREADS:
       dec->threads = g_value_get_uint (value);
       break;
+    case PROP_FRAME_PARALLEL:
+      dec->frame_parallel = g_value_get_boolean (value);
+      break;
+    case PROP_ROW_MT:
+      dec->row_mt = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -266,6 +311,12 @@ gst_vp9_dec_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_THREADS:
       g_value_set_uint (value, dec->threads);
       break;
+    case PROP_FRAME_PARALLEL:
+      g_value_set_boolean (value, dec->frame_parallel);
+      break;
+    case PROP_ROW_MT:
+      g_value_set_boolean (value, dec->row_mt);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -304,6 +355,13 @@ gst_vp9_dec_stop (GstVideoDecoder * base_video_decoder)
     vpx_codec_destroy (&gst_vp9_dec->decoder);
   gst_vp9_dec->decoder_inited = FALSE;
 
+  if (gst_vp9_dec->pool) {
+    gst_buffer_pool_set_active (gst_vp9_dec->pool, FALSE);
+    gst_object_unref (gst_vp9_dec->pool);
+    gst_vp9_dec->pool = NULL;
+    gst_vp9_dec->buf_size = 0;
+  }
+
   return TRUE;
 }
 
@@ -359,6 +417,150 @@ gst_vp9_dec_send_tags (GstVP9Dec * dec)
       gst_event_new_tag (list));
 }
 
+#ifdef HAVE_VPX_FRAME_BUFFER_FUNCTIONS
+/* libvpx decodes into buffers from an internal pool, decoded images are
+ * pushed downstream as they are when downstream supports the video meta */
+struct Frame
+{
+  GstMapInfo info;
+  GstBuffer *buffer;
+};
+
+static int
+gst_vp9_dec_get_buffer_cb (gpointer priv, gsize min_size,
+    vpx_codec_frame_buffer_t * fb)
+{
+  GstVP9Dec *dec = priv;
+  GstBuffer *buffer = NULL;
+  struct Frame *frame;
+  GstFlowReturn ret;
+
+  if (!dec->pool || dec->buf_size != min_size) {
+    GstBufferPool *pool;
+    GstStructure *config;
+    GstCaps *caps;
+    GstAllocator *allocator;
+    GstAllocationParams params;
+
+    if (dec->pool) {
+      gst_buffer_pool_set_active (dec->pool, FALSE);
+      gst_object_unref (dec->pool);
+      dec->pool = NULL;
+      dec->buf_size = 0;
+    }
+
+    gst_video_decoder_get_allocator (GST_VIDEO_DECODER (dec), &allocator,
+        &params);
+
+    /* libvpx needs plain system memory it can write to */
+    if (allocator &&
+        GST_OBJECT_FLAG_IS_SET (allocator, GST_ALLOCATOR_FLAG_CUSTOM_ALLOC)) {
+      gst_object_unref (allocator);
+      allocator = NULL;
+    }
+
+    pool = gst_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_allocator (config, allocator, &params);
+    caps = gst_caps_from_string ("video/internal");
+    gst_buffer_pool_config_set_params (config, caps, min_size, 2, 0);
+    gst_caps_unref (caps);
+    gst_buffer_pool_set_config (pool, config);
+
+    if (allocator)
+      gst_object_unref (allocator);
+
+    if (!gst_buffer_pool_set_active (pool, TRUE)) {
+      GST_WARNING_OBJECT (dec, "Failed to create internal pool");
+      gst_object_unref (pool);
+      return -1;
+    }
+
+    dec->pool = pool;
+    dec->buf_size = min_size;
+  }
+
+  ret = gst_buffer_pool_acquire_buffer (dec->pool, &buffer, NULL);
+  if (ret != GST_FLOW_OK) {
+    GST_WARNING_OBJECT (dec, "Failed to acquire buffer from internal pool");
+    return -1;
+  }
+
+  /* add it now while the buffer is writable, it is filled in when the
+   * image is pushed */
+  if (!gst_buffer_get_video_meta (buffer))
+    gst_buffer_add_video_meta (buffer, GST_VIDEO_FRAME_FLAG_NONE,
+        GST_VIDEO_FORMAT_ENCODED, 0, 0);
+
+  frame = g_new0 (struct Frame, 1);
+  if (!gst_buffer_map (buffer, &frame->info, GST_MAP_READWRITE)) {
+    gst_buffer_unref (buffer);
+    g_free (frame);
+    GST_WARNING_OBJECT (dec, "Failed to map buffer from internal pool");
+    return -1;
+  }
+
+  fb->size = frame->info.size;
+  fb->data = frame->info.data;
+  frame->buffer = buffer;
+  fb->priv = frame;
+
+  GST_TRACE_OBJECT (dec, "allocated buffer %p of size %" G_GSIZE_FORMAT,
+      buffer, min_size);
+
+  return 0;
+}
+
+static int
+gst_vp9_dec_release_buffer_cb (gpointer priv, vpx_codec_frame_buffer_t * fb)
+{
+  struct Frame *frame = fb->priv;
+
+  g_assert (frame);
+
+  GST_TRACE_OBJECT (priv, "release buffer %p", frame->buffer);
+  gst_buffer_unmap (frame->buffer, &frame->info);
+  gst_buffer_unref (frame->buffer);
+  g_free (frame);
+
+  return 0;
+}
+
+/* returns a new reference to the buffer libvpx decoded img into, with the
+ * video meta describing the planes */
+static GstBuffer *
+gst_vp9_dec_prepare_image (GstVP9Dec * dec, const vpx_image_t * img)
+{
+  gint comp;
+  GstVideoMeta *vmeta;
+  GstBuffer *buffer;
+  struct Frame *frame = img->fb_priv;
+  GstVideoInfo *info = &dec->output_state->info;
+
+  buffer = gst_buffer_ref (frame->buffer);
+
+  vmeta = gst_buffer_get_video_meta (buffer);
+  vmeta->format = GST_VIDEO_INFO_FORMAT (info);
+  vmeta->width = GST_VIDEO_INFO_WIDTH (info);
+  vmeta->height = GST_VIDEO_INFO_HEIGHT (info);
+  vmeta->n_planes = GST_VIDEO_INFO_N_PLANES (info);
+
+  for (comp = 0; comp < 4; comp++) {
+    gint plane = comp;
+
+    /* the meta is indexed by plane, YV12 stores V before U */
+    if (vmeta->format == GST_VIDEO_FORMAT_YV12 && (comp == 1 || comp == 2))
+      plane = 3 - comp;
+
+    vmeta->stride[plane] = img->stride[comp];
+    vmeta->offset[plane] =
+        img->planes[comp] ? img->planes[comp] - frame->info.data : 0;
+  }
+
+  return buffer;
+}
+#endif
+
 static void
 gst_vp9_dec_image_to_buffer (GstVP9Dec * dec, const vpx_image_t * img,
     GstBuffer * buffer)
@@ -380,18 +582,45 @@ gst_vp9_dec_image_to_buffer (GstVP9Dec * dec, const vpx_image_t * img,
     deststride = GST_VIDEO_FRAME_COMP_STRIDE (&frame, comp);
     srcstride = img->stride[comp];
 
-    /* FIXME (Edward) : Do a plane memcpy is srcstride == deststride instead
-     * of copying line by line */
-    for (line = 0; line < height; line++) {
-      memcpy (dest, src, width);
-      dest += deststride;
-      src += srcstride;
+    if (srcstride == deststride) {
+      memcpy (dest, src, srcstride * (height - 1) + width);
+    } else {
+      for (line = 0; line < height; line++) {
+        memcpy (dest, src, width);
+        dest += deststride;
+        src += srcstride;
+      }
     }
   }
 
   gst_video_frame_unmap (&frame);
 }
 
+/* with frame threading libvpx only outputs a frame when the next
+ * threads - 1 frames are being decoded */
+static void
+gst_vp9_dec_update_latency (GstVP9Dec * dec)
+{
+  GstVideoInfo *info = &dec->input_state->info;
+  GstClockTime latency = 0;
+
+  if (dec->frame_threading && dec->threads > 1) {
+    gint fps_n = info->fps_n, fps_d = info->fps_d;
+
+    if (fps_n <= 0 || fps_d <= 0) {
+      GST_DEBUG_OBJECT (dec, "unknown framerate, assuming 25 fps");
+      fps_n = 25;
+      fps_d = 1;
+    }
+
+    latency = gst_util_uint64_scale_ceil ((dec->threads - 1) * GST_SECOND,
+        fps_d, fps_n);
+  }
+
+  GST_DEBUG_OBJECT (dec, "latency %" GST_TIME_FORMAT, GST_TIME_ARGS (latency));
+  gst_video_decoder_set_latency (GST_VIDEO_DECODER (dec), latency, latency);
+}
+
 static GstFlowReturn
 open_codec (GstVP9Dec * dec, GstVideoCodecFrame * frame)
 {
@@ -446,6 +675,23 @@ open_codec (GstVP9Dec * dec, GstVideoCodecFrame * frame)
     }
   }
 
+  dec->frame_threading = FALSE;
+  if (dec->frame_parallel) {
+#ifdef VPX_CODEC_USE_FRAME_THREADING
+    if (!(caps & VPX_CODEC_CAP_FRAME_THREADING)) {
+      GST_WARNING_OBJECT (dec, "Decoder does not support frame threading");
+    } else if (flags & VPX_CODEC_USE_POSTPROC) {
+      GST_WARNING_OBJECT (dec, "Not using frame threading with post "
+          "processing");
+    } else {
+      flags |= VPX_CODEC_USE_FRAME_THREADING;
+      dec->frame_threading = TRUE;
+    }
+#else
+    GST_WARNING_OBJECT (dec, "libvpx does not support frame threading");
+#endif
+  }
+
   status =
       vpx_codec_dec_init (&dec->decoder, &vpx_codec_vp9_dx_algo, &cfg, flags);
   if (status != VPX_CODEC_OK) {
@@ -455,6 +701,18 @@ open_codec (GstVP9Dec * dec, GstVideoCodecFrame * frame)
     return GST_FLOW_ERROR;
   }
 
+  if (dec->row_mt) {
+#ifdef VPX_CTRL_VP9D_SET_ROW_MT
+    status = vpx_codec_control (&dec->decoder, VP9D_SET_ROW_MT, 1);
+    if (status != VPX_CODEC_OK) {
+      GST_WARNING_OBJECT (dec, "Couldn't enable row multithreading: %s",
+          gst_vpx_error_name (status));
+    }
+#else
+    GST_WARNING_OBJECT (dec, "libvpx does not support row multithreading");
+#endif
+  }
+
   if ((caps & VPX_CODEC_CAP_POSTPROC) && dec->post_processing) {
     vp8_postproc_cfg_t pp_cfg = { 0, };
 
@@ -469,22 +727,178 @@ open_codec (GstVP9Dec * dec, GstVideoCodecFrame * frame)
     }
   }
 
+#ifdef HAVE_VPX_FRAME_BUFFER_FUNCTIONS
+  if (caps & VPX_CODEC_CAP_EXTERNAL_FRAME_BUFFER) {
+    status = vpx_codec_set_frame_buffer_functions (&dec->decoder,
+        gst_vp9_dec_get_buffer_cb, gst_vp9_dec_release_buffer_cb, dec);
+    if (status != VPX_CODEC_OK) {
+      GST_WARNING_OBJECT (dec, "Couldn't set frame buffer functions: %s",
+          gst_vpx_error_name (status));
+    }
+  }
+#endif
+
   dec->decoder_inited = TRUE;
+  gst_vp9_dec_update_latency (dec);
 
   return GST_FLOW_OK;
 }
 
+/* push the decoded @img of @frame downstream, takes ownership of @frame */
+static GstFlowReturn
+gst_vp9_dec_push_image (GstVP9Dec * dec, GstVideoCodecFrame * frame,
+    vpx_image_t * img)
+{
+  GstVideoDecoder *decoder = GST_VIDEO_DECODER (dec);
+  GstFlowReturn ret;
+  GstClockTimeDiff deadline;
+  GstVideoFormat fmt;
+
+  switch (img->fmt) {
+    case VPX_IMG_FMT_I420:
+      fmt = GST_VIDEO_FORMAT_I420;
+      break;
+    case VPX_IMG_FMT_YV12:
+      fmt = GST_VIDEO_FORMAT_YV12;
+      break;
+    case VPX_IMG_FMT_I422:
+      fmt = GST_VIDEO_FORMAT_Y42B;
+      break;
+    case VPX_IMG_FMT_I444:
+      fmt = GST_VIDEO_FORMAT_Y444;
+      break;
+    default:
+      gst_video_codec_frame_unref (frame);
+      GST_ELEMENT_ERROR (decoder, LIBRARY, ENCODE,
+          ("Failed to decode frame"), ("Unsupported color format %d",
+              img->fmt));
+      return GST_FLOW_ERROR;
+      break;
+  }
+
+  /* FIXME: Width/height in the img is wrong */
+  if (!dec->output_state || dec->output_state->info.finfo->format != fmt        /*||
+                                                                                   dec->output_state->info.width != img->w ||
+                                                                                   dec->output_state->info.height != img->h */ ) {
+    gboolean send_tags = !dec->output_state;
+
+    if (dec->output_state)
+      gst_video_codec_state_unref (dec->output_state);
+
+    /* FIXME: The width/height in the img is wrong */
+    dec->output_state =
+        gst_video_decoder_set_output_state (GST_VIDEO_DECODER (dec),
+        fmt, dec->input_state->info.width, dec->input_state->info.height,
+        dec->input_state);
+    gst_video_decoder_negotiate (GST_VIDEO_DECODER (dec));
+
+    if (send_tags)
+      gst_vp9_dec_send_tags (dec);
+  }
+
+  deadline = gst_video_decoder_get_max_decode_time (decoder, frame);
+  if (deadline < 0) {
+    GST_LOG_OBJECT (dec, "Skipping late frame (%f s past deadline)",
+        (double) -deadline / GST_SECOND);
+    ret = gst_video_decoder_drop_frame (decoder, frame);
+  } else {
+#ifdef HAVE_VPX_FRAME_BUFFER_FUNCTIONS
+    if (img->fb_priv && dec->have_video_meta) {
+      frame->output_buffer = gst_vp9_dec_prepare_image (dec, img);
+      ret = gst_video_decoder_finish_frame (decoder, frame);
+    } else
+#endif
+    {
+      ret = gst_video_decoder_allocate_output_frame (decoder, frame);
+
+      if (ret == GST_FLOW_OK) {
+        gst_vp9_dec_image_to_buffer (dec, img, frame->output_buffer);
+        ret = gst_video_decoder_finish_frame (decoder, frame);
+      } else {
+        gst_video_decoder_finish_frame (decoder, frame);
+      }
+    }
+  }
+
+  return ret;
+}
+
+/* frames older than @number that are still pending did not produce an
+ * image, they were invisible */
+static GstFlowReturn
+gst_vp9_dec_finish_invisible (GstVP9Dec * dec, guint32 number)
+{
+  GstVideoDecoder *decoder = GST_VIDEO_DECODER (dec);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GList *frames, *l;
+
+  frames = gst_video_decoder_get_frames (decoder);
+  for (l = frames; l; l = l->next) {
+    GstVideoCodecFrame *frame = l->data;
+
+    if (frame->system_frame_number < number) {
+      GstFlowReturn res;
+
+      GST_VIDEO_CODEC_FRAME_SET_DECODE_ONLY (frame);
+      res = gst_video_decoder_finish_frame (decoder,
+          gst_video_codec_frame_ref (frame));
+      if (ret == GST_FLOW_OK)
+        ret = res;
+    }
+  }
+  g_list_free_full (frames, (GDestroyNotify) gst_video_codec_frame_unref);
+
+  return ret;
+}
+
+/* push all images libvpx has ready. With frame threading these belong to
+ * frames that were passed to the decoder earlier. */
+static GstFlowReturn
+gst_vp9_dec_push_images (GstVP9Dec * dec)
+{
+  GstVideoDecoder *decoder = GST_VIDEO_DECODER (dec);
+  GstFlowReturn ret = GST_FLOW_OK;
+  vpx_codec_iter_t iter = NULL;
+  vpx_image_t *img;
+
+  while ((img = vpx_codec_get_frame (&dec->decoder, &iter))) {
+    GstVideoCodecFrame *frame;
+    GstFlowReturn res;
+
+    frame = gst_video_decoder_get_frame (decoder,
+        GPOINTER_TO_INT (img->user_priv));
+    if (frame == NULL) {
+      GST_WARNING_OBJECT (decoder, "Multiple decoded frames... dropping");
+      vpx_img_free (img);
+      continue;
+    }
+
+    if (dec->frame_threading) {
+      res = gst_vp9_dec_finish_invisible (dec, frame->system_frame_number);
+      if (ret == GST_FLOW_OK)
+        ret = res;
+    }
+
+    res = gst_vp9_dec_push_image (dec, frame, img);
+    if (ret == GST_FLOW_OK)
+      ret = res;
+
+    vpx_img_free (img);
+  }
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_vp9_dec_handle_frame (GstVideoDecoder * decoder, GstVideoCodecFrame * frame)
 {
   GstVP9Dec *dec;
   GstFlowReturn ret = GST_FLOW_OK;
   vpx_codec_err_t status;
-  vpx_codec_iter_t iter = NULL;
-  vpx_image_t *img;
   long decoder_deadline = 0;
   GstClockTimeDiff deadline;
   GstMapInfo minfo;
+  guint32 number;
 
   GST_DEBUG_OBJECT (decoder, "handle_frame");
 
@@ -512,10 +926,14 @@ gst_vp9_dec_handle_frame (GstVideoDecoder * decoder, GstVideoCodecFrame * frame)
     return GST_FLOW_ERROR;
   }
 
+  /* the images libvpx outputs carry the number of their frame, so they can
+   * be matched up again when they come out later */
+  number = frame->system_frame_number;
   status = vpx_codec_decode (&dec->decoder,
-      minfo.data, minfo.size, NULL, decoder_deadline);
+      minfo.data, minfo.size, GINT_TO_POINTER (number), decoder_deadline);
 
   gst_buffer_unmap (frame->input_buffer, &minfo);
+  gst_video_codec_frame_unref (frame);
 
   if (status) {
     GST_VIDEO_DECODER_ERROR (decoder, 1, LIBRARY, ENCODE,
@@ -523,85 +941,54 @@ gst_vp9_dec_handle_frame (GstVideoDecoder * decoder, GstVideoCodecFrame * frame)
     return ret;
   }
 
-  img = vpx_codec_get_frame (&dec->decoder, &iter);
-  if (img) {
-    GstVideoFormat fmt;
-
-    switch (img->fmt) {
-      case VPX_IMG_FMT_I420:
-        fmt = GST_VIDEO_FORMAT_I420;
-        break;
-      case VPX_IMG_FMT_YV12:
-        fmt = GST_VIDEO_FORMAT_YV12;
-        break;
-      case VPX_IMG_FMT_I422:
-        fmt = GST_VIDEO_FORMAT_Y42B;
-        break;
-      case VPX_IMG_FMT_I444:
-        fmt = GST_VIDEO_FORMAT_Y444;
-        break;
-      default:
-        vpx_img_free (img);
-        GST_ELEMENT_ERROR (decoder, LIBRARY, ENCODE,
-            ("Failed to decode frame"), ("Unsupported color format %d",
-                img->fmt));
-        return GST_FLOW_ERROR;
-        break;
-    }
+  ret = gst_vp9_dec_push_images (dec);
 
-    /* FIXME: Width/height in the img is wrong */
-    if (!dec->output_state || dec->output_state->info.finfo->format != fmt      /*||
-                                                                                   dec->output_state->info.width != img->w ||
-                                                                                   dec->output_state->info.height != img->h */ ) {
-      gboolean send_tags = !dec->output_state;
+  /* without frame threading the image of a frame comes out right away, a
+   * frame that is still pending now was invisible */
+  if (!dec->frame_threading
+      && (frame = gst_video_decoder_get_frame (decoder, number))) {
+    GstFlowReturn res;
 
-      if (dec->output_state)
-        gst_video_codec_state_unref (dec->output_state);
-
-      /* FIXME: The width/height in the img is wrong */
-      dec->output_state =
-          gst_video_decoder_set_output_state (GST_VIDEO_DECODER (dec),
-          fmt, dec->input_state->info.width, dec->input_state->info.height,
-          dec->input_state);
-      gst_video_decoder_negotiate (GST_VIDEO_DECODER (dec));
+    GST_VIDEO_CODEC_FRAME_SET_DECODE_ONLY (frame);
+    res = gst_video_decoder_finish_frame (decoder, frame);
+    if (ret == GST_FLOW_OK)
+      ret = res;
+  }
 
-      if (send_tags)
-        gst_vp9_dec_send_tags (dec);
-    }
+  return ret;
+}
 
-    if (deadline < 0) {
-      GST_LOG_OBJECT (dec, "Skipping late frame (%f s past deadline)",
-          (double) -deadline / GST_SECOND);
-      gst_video_decoder_drop_frame (decoder, frame);
-    } else {
-      ret = gst_video_decoder_allocate_output_frame (decoder, frame);
+static GstFlowReturn
+gst_vp9_dec_finish (GstVideoDecoder * decoder)
+{
+  GstVP9Dec *dec = GST_VP9_DEC (decoder);
+  vpx_codec_err_t status;
+  GstFlowReturn ret, res;
 
-      if (ret == GST_FLOW_OK) {
-        gst_vp9_dec_image_to_buffer (dec, img, frame->output_buffer);
-        ret = gst_video_decoder_finish_frame (decoder, frame);
-      } else {
-        gst_video_decoder_finish_frame (decoder, frame);
-      }
-    }
+  GST_DEBUG_OBJECT (decoder, "finish");
 
-    vpx_img_free (img);
+  if (!dec->decoder_inited || !dec->frame_threading)
+    return GST_FLOW_OK;
 
-    while ((img = vpx_codec_get_frame (&dec->decoder, &iter))) {
-      GST_WARNING_OBJECT (decoder, "Multiple decoded frames... dropping");
-      vpx_img_free (img);
-    }
-  } else {
-    /* Invisible frame */
-    GST_VIDEO_CODEC_FRAME_SET_DECODE_ONLY (frame);
-    gst_video_decoder_finish_frame (decoder, frame);
+  /* get the frames that are still being decoded by the other threads */
+  status = vpx_codec_decode (&dec->decoder, NULL, 0, NULL, 0);
+  if (status != VPX_CODEC_OK) {
+    GST_WARNING_OBJECT (dec, "Failed to drain decoder: %s",
+        gst_vpx_error_name (status));
   }
 
+  ret = gst_vp9_dec_push_images (dec);
+  res = gst_vp9_dec_finish_invisible (dec, G_MAXUINT32);
+  if (ret == GST_FLOW_OK)
+    ret = res;
+
   return ret;
 }
 
 static gboolean
 gst_vp9_dec_decide_allocation (GstVideoDecoder * bdec, GstQuery * query)
 {
+  GstVP9Dec *dec = GST_VP9_DEC (bdec);
   GstBufferPool *pool;
   GstStructure *config;
 
@@ -613,7 +1000,9 @@ gst_vp9_dec_decide_allocation (GstVideoDecoder * bdec, GstQuery * query)
   g_assert (pool != NULL);
 
   config = gst_buffer_pool_get_config (pool);
-  if (gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL)) {
+  dec->have_video_meta =
+      gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+  if (dec->have_video_meta) {
     gst_buffer_pool_config_add_option (config,
         GST_BUFFER_POOL_OPTION_VIDEO_META);
   }
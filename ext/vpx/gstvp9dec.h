@@ -66,6 +66,8 @@ struct _GstVP9Dec
 
   /* state */
   gboolean decoder_inited;
+  /* libvpx was opened with frame threading, output is delayed */
+  gboolean frame_threading;
 
   /* properties */
   gboolean post_processing;
@@ -73,9 +75,16 @@ struct _GstVP9Dec
   gint deblocking_level;
   gint noise_level;
   gint threads;
+  gboolean frame_parallel;
+  gboolean row_mt;
 
   GstVideoCodecState *input_state;
   GstVideoCodecState *output_state;
+
+  /* pool of the buffers libvpx decodes into */
+  GstBufferPool *pool;
+  gsize buf_size;
+  gboolean have_video_meta;
 };
 
 struct _GstVP9DecClass
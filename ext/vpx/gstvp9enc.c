@@ -124,6 +124,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_vp9enc_debug);
 #define DEFAULT_MAX_INTRA_BITRATE_PCT 0
 #define DEFAULT_TIMEBASE_N 0
 #define DEFAULT_TIMEBASE_D 1
+#define DEFAULT_STATS_INTERVAL 0
 
 enum
 {
@@ -171,7 +172,8 @@ enum
   PROP_TUNING,
   PROP_CQ_LEVEL,
   PROP_MAX_INTRA_BITRATE_PCT,
-  PROP_TIMEBASE
+  PROP_TIMEBASE,
+  PROP_STATS_INTERVAL
 };
 
 #define GST_VP9_ENC_END_USAGE_TYPE (gst_vp9_enc_end_usage_get_type())
@@ -683,6 +685,25 @@ gst_vp9_enc_class_init (GstVP9EncClass * klass)
           0, 1, G_MAXINT, 1, DEFAULT_TIMEBASE_N, DEFAULT_TIMEBASE_D,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstVP9Enc:stats-interval:
+   *
+   * Number of frames after which a "vpx-encoder-stats" element message is
+   * posted. It has the "frames" count, the "dropped" frames and the encoded
+   * "bytes", the minimum, mean, maximum and 50th/90th/99th percentile of the
+   * duration of the encode calls as "encode-time-*" and the minimum, mean
+   * and maximum "quantizer-*". The "timestamp" is the one of the last frame.
+   * Dropped frames are only detected with #GstVP9Enc:lag-in-frames set to 0.
+   * 0 disables the statistics.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS_INTERVAL,
+      g_param_spec_uint ("stats-interval", "Statistics interval",
+          "Number of frames between encoding statistics messages "
+          "(0 = disabled)", 0, G_MAXINT, DEFAULT_STATS_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (gst_vp9enc_debug, "vp9enc", 0, "VP9 Encoder");
 }
 
@@ -756,6 +777,9 @@ gst_vp9_enc_init (GstVP9Enc * gst_vp9_enc)
 
   gst_vp9_enc->cfg.g_profile = DEFAULT_PROFILE;
 
+  gst_vp9_enc->stats_interval = DEFAULT_STATS_INTERVAL;
+  gst_vpx_enc_stats_init (&gst_vp9_enc->stats);
+
   g_mutex_init (&gst_vp9_enc->encoder_lock);
 }
 
@@ -775,6 +799,8 @@ gst_vp9_enc_finalize (GObject * object)
   if (gst_vp9_enc->input_state)
     gst_video_codec_state_unref (gst_vp9_enc->input_state);
 
+  gst_vpx_enc_stats_clear (&gst_vp9_enc->stats);
+
   g_mutex_clear (&gst_vp9_enc->encoder_lock);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -1151,6 +1177,9 @@ gst_vp9_enc_set_property (GObject * object, guint prop_id,
       gst_vp9_enc->timebase_n = gst_value_get_fraction_numerator (value);
       gst_vp9_enc->timebase_d = gst_value_get_fraction_denominator (value);
       break;
+    case PROP_STATS_INTERVAL:
+      gst_vp9_enc->stats_interval = g_value_get_uint (value);
+      break;
     default:
       break;
   }
@@ -1372,6 +1401,9 @@ gst_vp9_enc_get_property (GObject * object, guint prop_id, GValue * value,
       gst_value_set_fraction (value, gst_vp9_enc->timebase_n,
           gst_vp9_enc->timebase_d);
       break;
+    case PROP_STATS_INTERVAL:
+      g_value_set_uint (value, gst_vp9_enc->stats_interval);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1423,6 +1455,9 @@ gst_vp9_enc_stop (GstVideoEncoder * video_encoder)
   }
   g_mutex_unlock (&encoder->encoder_lock);
 
+  gst_vpx_enc_stats_reset (&encoder->stats);
+  encoder->n_packets = 0;
+
   gst_tag_setter_reset_tags (GST_TAG_SETTER (encoder));
 
   return TRUE;
@@ -1784,6 +1819,9 @@ gst_vp9_enc_process (GstVP9Enc * encoder)
         gst_buffer_new_wrapped (g_memdup (pkt->data.frame.buf,
             pkt->data.frame.sz), pkt->data.frame.sz);
 
+    encoder->n_packets++;
+    encoder->stats.bytes += pkt->data.frame.sz;
+
     if (invisible) {
       g_mutex_unlock (&encoder->encoder_lock);
       ret = gst_pad_push (GST_VIDEO_ENCODER_SRC_PAD (encoder), buffer);
@@ -1843,11 +1881,12 @@ gst_vp9_enc_finish (GstVideoEncoder * video_encoder)
   return GST_FLOW_OK;
 }
 
-static vpx_image_t *
-gst_vp9_enc_buffer_to_image (GstVP9Enc * enc, GstVideoFrame * frame)
+/* wraps the planes of the mapped frame, libvpx copies the image while
+ * encoding so it only has to live during vpx_codec_encode() */
+static void
+gst_vp9_enc_buffer_to_image (GstVP9Enc * enc, GstVideoFrame * frame,
+    vpx_image_t * image)
 {
-  vpx_image_t *image = g_slice_new (vpx_image_t);
-
   memcpy (image, &enc->image, sizeof (*image));
 
   image->planes[VPX_PLANE_Y] = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
@@ -1857,8 +1896,27 @@ gst_vp9_enc_buffer_to_image (GstVP9Enc * enc, GstVideoFrame * frame)
   image->stride[VPX_PLANE_Y] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
   image->stride[VPX_PLANE_U] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 1);
   image->stride[VPX_PLANE_V] = GST_VIDEO_FRAME_COMP_STRIDE (frame, 2);
+}
 
-  return image;
+/* accounts the encoding of one frame and posts the statistics message
+ * every stats-interval frames */
+static void
+gst_vp9_enc_update_stats (GstVP9Enc * encoder, GstClockTime encode_time,
+    gint quantizer, gboolean dropped, GstClockTime timestamp)
+{
+  GST_LOG_OBJECT (encoder, "encoded frame %" GST_TIME_FORMAT " in %"
+      GST_TIME_FORMAT ", quantizer %d%s", GST_TIME_ARGS (timestamp),
+      GST_TIME_ARGS (encode_time), quantizer, dropped ? ", dropped" : "");
+
+  gst_vpx_enc_stats_add_frame (&encoder->stats, encode_time, quantizer,
+      dropped, timestamp);
+
+  if (encoder->stats.encode_times->len >= encoder->stats_interval) {
+    gst_element_post_message (GST_ELEMENT_CAST (encoder),
+        gst_message_new_element (GST_OBJECT_CAST (encoder),
+            gst_vpx_enc_stats_to_structure (&encoder->stats)));
+    gst_vpx_enc_stats_reset (&encoder->stats);
+  }
 }
 
 static GstFlowReturn
@@ -1868,8 +1926,12 @@ gst_vp9_enc_handle_frame (GstVideoEncoder * video_encoder,
   GstVP9Enc *encoder;
   vpx_codec_err_t status;
   int flags = 0;
-  vpx_image_t *image;
+  vpx_image_t image;
   GstVideoFrame vframe;
+  GstClockTime start, encode_time, timestamp;
+  gint quantizer = 0;
+  guint64 n_packets;
+  GstFlowReturn ret;
 
   GST_DEBUG_OBJECT (video_encoder, "handle_frame");
 
@@ -1883,15 +1945,23 @@ gst_vp9_enc_handle_frame (GstVideoEncoder * video_encoder,
 
   gst_video_frame_map (&vframe, &encoder->input_state->info,
       frame->input_buffer, GST_MAP_READ);
-  image = gst_vp9_enc_buffer_to_image (encoder, &vframe);
+  gst_vp9_enc_buffer_to_image (encoder, &vframe, &image);
 
   if (GST_VIDEO_CODEC_FRAME_IS_FORCE_KEYFRAME (frame)) {
     flags |= VPX_EFLAG_FORCE_KF;
   }
 
+  n_packets = encoder->n_packets;
+  timestamp = frame->pts;
+
   g_mutex_lock (&encoder->encoder_lock);
-  status = vpx_codec_encode (&encoder->encoder, image,
+  start = gst_util_get_timestamp ();
+  status = vpx_codec_encode (&encoder->encoder, &image,
       encoder->n_frames, 1, flags, encoder->deadline);
+  encode_time = gst_util_get_timestamp () - start;
+  if (encoder->stats_interval > 0 && status == VPX_CODEC_OK)
+    vpx_codec_control (&encoder->encoder, VP8E_GET_LAST_QUANTIZER_64,
+        &quantizer);
   g_mutex_unlock (&encoder->encoder_lock);
   gst_video_frame_unmap (&vframe);
 
@@ -1901,7 +1971,14 @@ gst_vp9_enc_handle_frame (GstVideoEncoder * video_encoder,
     return FALSE;
   }
   gst_video_codec_frame_unref (frame);
-  return gst_vp9_enc_process (encoder);
+  ret = gst_vp9_enc_process (encoder);
+
+  if (encoder->stats_interval > 0)
+    gst_vp9_enc_update_stats (encoder, encode_time, quantizer,
+        encoder->n_packets == n_packets && encoder->cfg.g_lag_in_frames == 0,
+        timestamp);
+
+  return ret;
 }
 
 static gboolean
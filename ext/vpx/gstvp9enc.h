@@ -40,6 +40,8 @@
 #include <vpx/vpx_encoder.h>
 #include <vpx/vp8cx.h>
 
+#include "gstvp8utils.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_VP9_ENC \
@@ -105,6 +107,11 @@ struct _GstVP9Enc
   int n_frames;
 
   GstVideoCodecState *input_state;
+
+  /* statistics */
+  guint stats_interval;
+  GstVPXEncStats stats;
+  guint64 n_packets;
 };
 
 struct _GstVP9EncClass
@@ -40,6 +40,11 @@
  * gst-launch-1.0 cdda://1 ! audioconvert ! wavpackenc bitrate=128000 ! filesink location=track1.wv
  * ]| This pipeline encodes audio from an audio CD into a Wavpack file using
  * lossy encoding at a certain bitrate (the file will be fairly small).
+ * |[
+ * gst-launch-1.0 filesrc location=master.wav ! wavparse ! audioconvert ! wavpackenc n-threads=0 ! filesink location=master.wv
+ * ]| This pipeline encodes a long recording using all processors. Every
+ * Wavpack block is encoded independently on one of the threads and the
+ * blocks are output in order.
  * </refsect2>
  */
 
@@ -66,6 +71,7 @@ static gboolean gst_wavpack_enc_sink_event (GstAudioEncoder * enc,
 
 static int gst_wavpack_enc_push_block (void *id, void *data, int32_t count);
 static GstFlowReturn gst_wavpack_enc_drain (GstWavpackEnc * enc);
+static void gst_wavpack_enc_finalize (GObject * object);
 
 static void gst_wavpack_enc_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -81,9 +87,12 @@ enum
   ARG_CORRECTION_MODE,
   ARG_MD5,
   ARG_EXTRA_PROCESSING,
-  ARG_JOINT_STEREO_MODE
+  ARG_JOINT_STEREO_MODE,
+  ARG_N_THREADS
 };
 
+#define DEFAULT_N_THREADS 1
+
 GST_DEBUG_CATEGORY_STATIC (gst_wavpack_enc_debug);
 #define GST_CAT_DEFAULT gst_wavpack_enc_debug
 
@@ -227,6 +236,7 @@ gst_wavpack_enc_class_init (GstWavpackEncClass * klass)
   /* set property handlers */
   gobject_class->set_property = gst_wavpack_enc_set_property;
   gobject_class->get_property = gst_wavpack_enc_get_property;
+  gobject_class->finalize = gst_wavpack_enc_finalize;
 
   base_class->start = GST_DEBUG_FUNCPTR (gst_wavpack_enc_start);
   base_class->stop = GST_DEBUG_FUNCPTR (gst_wavpack_enc_stop);
@@ -268,6 +278,51 @@ gst_wavpack_enc_class_init (GstWavpackEncClass * klass)
           "Use this joint-stereo mode.", GST_TYPE_WAVPACK_ENC_JOINT_STEREO_MODE,
           GST_WAVPACK_JS_MODE_AUTO,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstWavpackEnc:n-threads:
+   *
+   * Number of threads used to encode Wavpack blocks. With more than one
+   * thread every block is encoded by its own encoder instance, which
+   * adds a latency of a few blocks and slightly larger blocks since the
+   * encoder state is not carried over between blocks.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, ARG_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads used to encode blocks (0 = number of processors)",
+          0, G_MAXUINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_wavpack_enc_job_free (GstWavpackEncJob * job)
+{
+  g_free (job->samples);
+  g_byte_array_unref (job->wv);
+  if (job->wvc)
+    g_byte_array_unref (job->wvc);
+  g_slice_free (GstWavpackEncJob, job);
+}
+
+static void
+gst_wavpack_enc_stop_jobs (GstWavpackEnc * enc)
+{
+  GstWavpackEncJob *job;
+
+  /* wait for the running jobs, their output is dropped */
+  if (enc->job_pool) {
+    g_thread_pool_free (enc->job_pool, FALSE, TRUE);
+    enc->job_pool = NULL;
+  }
+  while ((job = g_queue_pop_head (&enc->jobs)))
+    gst_wavpack_enc_job_free (job);
+  if (enc->cur_job) {
+    gst_wavpack_enc_job_free (enc->cur_job);
+    enc->cur_job = NULL;
+  }
+  enc->next_index = 0;
 }
 
 static void
@@ -278,6 +333,7 @@ gst_wavpack_enc_reset (GstWavpackEnc * enc)
     WavpackCloseFile (enc->wp_context);
     enc->wp_context = NULL;
   }
+  gst_wavpack_enc_stop_jobs (enc);
   if (enc->wp_config) {
     g_free (enc->wp_config);
     enc->wp_config = NULL;
@@ -327,6 +383,9 @@ gst_wavpack_enc_init (GstWavpackEnc * enc)
   enc->wp_context = NULL;
   enc->first_block = NULL;
   enc->md5_context = NULL;
+  g_queue_init (&enc->jobs);
+  g_mutex_init (&enc->job_lock);
+  g_cond_init (&enc->job_cond);
   gst_wavpack_enc_reset (enc);
 
   enc->wv_id.correction = FALSE;
@@ -344,11 +403,24 @@ gst_wavpack_enc_init (GstWavpackEnc * enc)
   enc->md5 = FALSE;
   enc->extra_processing = 0;
   enc->joint_stereo_mode = GST_WAVPACK_JS_MODE_AUTO;
+  enc->n_threads = DEFAULT_N_THREADS;
 
   /* require perfect ts */
   gst_audio_encoder_set_perfect_timestamp (benc, TRUE);
 }
 
+static void
+gst_wavpack_enc_finalize (GObject * object)
+{
+  GstWavpackEnc *enc = GST_WAVPACK_ENC (object);
+
+  gst_wavpack_enc_reset (enc);
+  g_mutex_clear (&enc->job_lock);
+  g_cond_clear (&enc->job_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 
 static gboolean
 gst_wavpack_enc_start (GstAudioEncoder * enc)
@@ -671,6 +743,241 @@ gst_wavpack_enc_fix_channel_order (GstWavpackEnc * enc, gint32 * data,
   }
 }
 
+/* maps the last flow returns of the src pads after a failed push */
+static GstFlowReturn
+gst_wavpack_enc_get_flow_return (GstWavpackEnc * enc)
+{
+  if ((enc->srcpad_last_return == GST_FLOW_OK) ||
+      (enc->wvcsrcpad_last_return == GST_FLOW_OK)) {
+    return GST_FLOW_OK;
+  } else if ((enc->srcpad_last_return == GST_FLOW_NOT_LINKED) &&
+      (enc->wvcsrcpad_last_return == GST_FLOW_NOT_LINKED)) {
+    return GST_FLOW_NOT_LINKED;
+  } else if ((enc->srcpad_last_return == GST_FLOW_FLUSHING) &&
+      (enc->wvcsrcpad_last_return == GST_FLOW_FLUSHING)) {
+    return GST_FLOW_FLUSHING;
+  }
+
+  GST_ELEMENT_ERROR (enc, LIBRARY, ENCODE, (NULL),
+      ("encoding samples failed"));
+  return GST_FLOW_ERROR;
+}
+
+static int
+gst_wavpack_enc_job_write (void *id, void *data, int32_t count)
+{
+  g_byte_array_append ((GByteArray *) id, data, count);
+
+  return TRUE;
+}
+
+/* Encodes the samples of a job with a separate context, the output then
+ * holds complete blocks starting at block index 0 */
+static gboolean
+gst_wavpack_enc_encode_job (GstWavpackEnc * enc, GstWavpackEncJob * job,
+    guint8 * md5_digest)
+{
+  WavpackConfig config = *enc->wp_config;
+  WavpackContext *wpc;
+  gboolean ret;
+
+  wpc = WavpackOpenFileOutput (gst_wavpack_enc_job_write, job->wv, job->wvc);
+  if (!wpc)
+    return FALSE;
+
+  ret = WavpackSetConfiguration (wpc, &config, (uint32_t) (-1))
+      && WavpackPackInit (wpc);
+  if (ret && job->n_samples > 0)
+    ret = WavpackPackSamples (wpc, job->samples, job->n_samples);
+  if (ret)
+    ret = WavpackFlushSamples (wpc);
+  if (ret && md5_digest) {
+    WavpackStoreMD5Sum (wpc, md5_digest);
+    ret = WavpackFlushSamples (wpc);
+  }
+  WavpackCloseFile (wpc);
+
+  return ret;
+}
+
+static void
+gst_wavpack_enc_job_func (gpointer data, gpointer user_data)
+{
+  GstWavpackEncJob *job = data;
+  GstWavpackEnc *enc = job->enc;
+  gboolean ok;
+
+  ok = gst_wavpack_enc_encode_job (enc, job, NULL);
+
+  g_mutex_lock (&enc->job_lock);
+  job->ok = ok;
+  job->done = TRUE;
+  g_cond_broadcast (&enc->job_cond);
+  g_mutex_unlock (&enc->job_lock);
+}
+
+static GstWavpackEncJob *
+gst_wavpack_enc_job_new (GstWavpackEnc * enc)
+{
+  GstWavpackEncJob *job = g_slice_new0 (GstWavpackEncJob);
+
+  job->enc = enc;
+  job->samples = g_new (gint32, enc->job_samples * enc->channels);
+  job->wv = g_byte_array_new ();
+  if (enc->correction_mode > 0)
+    job->wvc = g_byte_array_new ();
+
+  return job;
+}
+
+/* pushes the blocks of one stream of a job, moved to the position of the
+ * job in the whole stream */
+static gboolean
+gst_wavpack_enc_push_job_blocks (GstWavpackEnc * enc,
+    GstWavpackEncWriteID * id, GByteArray * blocks, guint32 block_index)
+{
+  guint8 *data = blocks->data;
+  guint size = blocks->len;
+
+  while (size >= sizeof (WavpackHeader) && memcmp (data, "wvpk", 4) == 0) {
+    guint32 block_size = GST_READ_UINT32_LE (data + 4) + 8;
+
+    if (block_size > size)
+      break;
+
+    GST_WRITE_UINT32_LE (data + 16, GST_READ_UINT32_LE (data + 16) +
+        block_index);
+    if (!gst_wavpack_enc_push_block (id, data, block_size))
+      return FALSE;
+
+    data += block_size;
+    size -= block_size;
+  }
+
+  if (size > 0)
+    return gst_wavpack_enc_push_block (id, data, size);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_wavpack_enc_push_job (GstWavpackEnc * enc, GstWavpackEncJob * job)
+{
+  if (!job->ok) {
+    GST_ELEMENT_ERROR (enc, LIBRARY, ENCODE, (NULL),
+        ("encoding samples failed"));
+    return GST_FLOW_ERROR;
+  }
+
+  GST_LOG_OBJECT (enc, "pushing job at sample %u with %u samples",
+      job->block_index, job->n_samples);
+
+  if (!gst_wavpack_enc_push_job_blocks (enc, &enc->wv_id, job->wv,
+          job->block_index))
+    return gst_wavpack_enc_get_flow_return (enc);
+  if (job->wvc && !gst_wavpack_enc_push_job_blocks (enc, &enc->wvc_id,
+          job->wvc, job->block_index))
+    return gst_wavpack_enc_get_flow_return (enc);
+
+  return GST_FLOW_OK;
+}
+
+/* pushes finished jobs in order, waits until at most max_pending jobs
+ * are left */
+static GstFlowReturn
+gst_wavpack_enc_collect_jobs (GstWavpackEnc * enc, guint max_pending)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstWavpackEncJob *job;
+
+  g_mutex_lock (&enc->job_lock);
+  while ((job = g_queue_peek_head (&enc->jobs))) {
+    if (!job->done) {
+      if (g_queue_get_length (&enc->jobs) <= max_pending)
+        break;
+      g_cond_wait (&enc->job_cond, &enc->job_lock);
+      continue;
+    }
+
+    g_queue_pop_head (&enc->jobs);
+    g_mutex_unlock (&enc->job_lock);
+
+    if (ret == GST_FLOW_OK)
+      ret = gst_wavpack_enc_push_job (enc, job);
+    gst_wavpack_enc_job_free (job);
+
+    g_mutex_lock (&enc->job_lock);
+  }
+  g_mutex_unlock (&enc->job_lock);
+
+  return ret;
+}
+
+static void
+gst_wavpack_enc_start_jobs (GstWavpackEnc * enc, guint n_threads)
+{
+  GstClockTime latency;
+
+  if (!enc->wp_config)
+    gst_wavpack_enc_set_wp_config (enc);
+
+  /* one block of one second per job */
+  enc->job_samples = enc->samplerate;
+  enc->wp_config->block_samples = enc->job_samples;
+  enc->max_jobs = 2 * n_threads;
+  enc->next_index = 0;
+
+  enc->job_pool =
+      g_thread_pool_new (gst_wavpack_enc_job_func, NULL, n_threads, FALSE,
+      NULL);
+
+  latency = gst_util_uint64_scale (enc->job_samples * (enc->max_jobs + 1),
+      GST_SECOND, enc->samplerate);
+  gst_audio_encoder_set_latency (GST_AUDIO_ENCODER (enc), latency, latency);
+
+  GST_DEBUG_OBJECT (enc, "encoding blocks on %u threads", n_threads);
+}
+
+static GstFlowReturn
+gst_wavpack_enc_queue_samples (GstWavpackEnc * enc, const gint32 * data,
+    guint32 n_samples)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  while (n_samples > 0 && ret == GST_FLOW_OK) {
+    GstWavpackEncJob *job = enc->cur_job;
+    guint32 count;
+
+    if (!job)
+      job = enc->cur_job = gst_wavpack_enc_job_new (enc);
+
+    count = MIN (n_samples, enc->job_samples - job->n_samples);
+    memcpy (job->samples + job->n_samples * enc->channels, data,
+        count * enc->channels * sizeof (gint32));
+    job->n_samples += count;
+    data += count * enc->channels;
+    n_samples -= count;
+
+    if (job->n_samples == enc->job_samples) {
+      job->block_index = enc->next_index;
+      enc->next_index += job->n_samples;
+      enc->cur_job = NULL;
+
+      g_mutex_lock (&enc->job_lock);
+      g_queue_push_tail (&enc->jobs, job);
+      g_mutex_unlock (&enc->job_lock);
+      g_thread_pool_push (enc->job_pool, job, NULL);
+
+      ret = gst_wavpack_enc_collect_jobs (enc, enc->max_jobs);
+    }
+  }
+
+  if (ret == GST_FLOW_OK)
+    ret = gst_wavpack_enc_collect_jobs (enc, enc->max_jobs);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_wavpack_enc_handle_frame (GstAudioEncoder * benc, GstBuffer * buf)
 {
@@ -693,8 +1000,18 @@ gst_wavpack_enc_handle_frame (GstAudioEncoder * benc, GstBuffer * buf)
   sample_count = gst_buffer_get_size (buf) / 4;
   GST_DEBUG_OBJECT (enc, "got %u raw samples", sample_count);
 
+  /* encode independent blocks on a thread pool if requested */
+  if (!enc->wp_context && !enc->job_pool) {
+    guint n_threads = enc->n_threads;
+
+    if (n_threads == 0)
+      n_threads = g_get_num_processors ();
+    if (n_threads > 1)
+      gst_wavpack_enc_start_jobs (enc, n_threads);
+  }
+
   /* check if we already have a valid WavpackContext, otherwise make one */
-  if (!enc->wp_context) {
+  if (!enc->wp_context && !enc->job_pool) {
     /* create raw context */
     enc->wp_context =
         WavpackOpenFileOutput (gst_wavpack_enc_push_block, &enc->wv_id,
@@ -731,6 +1048,13 @@ gst_wavpack_enc_handle_frame (GstAudioEncoder * benc, GstBuffer * buf)
     g_checksum_update (enc->md5_context, map.data, map.size);
   }
 
+  if (enc->job_pool) {
+    ret = gst_wavpack_enc_queue_samples (enc, (gint32 *) map.data,
+        sample_count / enc->channels);
+    gst_buffer_unmap (buf, &map);
+    goto exit;
+  }
+
   /* encode and handle return values from encoding */
   if (WavpackPackSamples (enc->wp_context, (int32_t *) map.data,
           sample_count / enc->channels)) {
@@ -739,31 +1063,13 @@ gst_wavpack_enc_handle_frame (GstAudioEncoder * benc, GstBuffer * buf)
     ret = GST_FLOW_OK;
   } else {
     gst_buffer_unmap (buf, &map);
-    if ((enc->srcpad_last_return == GST_FLOW_OK) ||
-        (enc->wvcsrcpad_last_return == GST_FLOW_OK)) {
-      ret = GST_FLOW_OK;
-    } else if ((enc->srcpad_last_return == GST_FLOW_NOT_LINKED) &&
-        (enc->wvcsrcpad_last_return == GST_FLOW_NOT_LINKED)) {
-      ret = GST_FLOW_NOT_LINKED;
-    } else if ((enc->srcpad_last_return == GST_FLOW_FLUSHING) &&
-        (enc->wvcsrcpad_last_return == GST_FLOW_FLUSHING)) {
-      ret = GST_FLOW_FLUSHING;
-    } else {
-      goto encoding_failed;
-    }
+    ret = gst_wavpack_enc_get_flow_return (enc);
   }
 
 exit:
   return ret;
 
   /* ERRORS */
-encoding_failed:
-  {
-    GST_ELEMENT_ERROR (enc, LIBRARY, ENCODE, (NULL),
-        ("encoding samples failed"));
-    ret = GST_FLOW_ERROR;
-    goto exit;
-  }
 config_failed:
   {
     GST_ELEMENT_ERROR (enc, LIBRARY, SETTINGS, (NULL),
@@ -792,7 +1098,10 @@ gst_wavpack_enc_rewrite_first_block (GstWavpackEnc * enc)
   g_return_if_fail (enc->first_block);
 
   /* update the sample count in the first block */
-  WavpackUpdateNumSamples (enc->wp_context, enc->first_block);
+  if (enc->wp_context)
+    WavpackUpdateNumSamples (enc->wp_context, enc->first_block);
+  else
+    GST_WRITE_UINT32_LE ((guint8 *) enc->first_block + 12, enc->next_index);
 
   /* try to seek to the beginning of the output */
   query = gst_query_new_seeking (GST_FORMAT_BYTES);
@@ -830,9 +1139,63 @@ gst_wavpack_enc_rewrite_first_block (GstWavpackEnc * enc)
   }
 }
 
+static GstFlowReturn
+gst_wavpack_enc_drain_jobs (GstWavpackEnc * enc)
+{
+  GstWavpackEncJob *job;
+  GstFlowReturn ret;
+  guint8 md5_digest[16];
+  gboolean have_md5 = FALSE;
+
+  GST_DEBUG_OBJECT (enc, "draining jobs");
+
+  ret = gst_wavpack_enc_collect_jobs (enc, 0);
+
+  if ((enc->md5) && (enc->md5_context)) {
+    gsize digest_len = sizeof (md5_digest);
+
+    g_checksum_get_digest (enc->md5_context, md5_digest, &digest_len);
+    if (digest_len == sizeof (md5_digest))
+      have_md5 = TRUE;
+    else
+      GST_WARNING_OBJECT (enc, "Calculating MD5 digest failed");
+  }
+
+  /* the remaining samples and the MD5 sum are encoded here */
+  job = enc->cur_job;
+  enc->cur_job = NULL;
+  if (!job && have_md5)
+    job = gst_wavpack_enc_job_new (enc);
+  if (job) {
+    job->block_index = enc->next_index;
+    enc->next_index += job->n_samples;
+    job->ok = gst_wavpack_enc_encode_job (enc, job,
+        have_md5 ? md5_digest : NULL);
+    if (ret == GST_FLOW_OK)
+      ret = gst_wavpack_enc_push_job (enc, job);
+    gst_wavpack_enc_job_free (job);
+  }
+
+  if (enc->pending_buffer) {
+    gst_buffer_unref (enc->pending_buffer);
+    enc->pending_buffer = NULL;
+    enc->pending_offset = 0;
+  }
+
+  if (enc->first_block)
+    gst_wavpack_enc_rewrite_first_block (enc);
+
+  gst_wavpack_enc_stop_jobs (enc);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_wavpack_enc_drain (GstWavpackEnc * enc)
 {
+  if (enc->job_pool)
+    return gst_wavpack_enc_drain_jobs (enc);
+
   if (!enc->wp_context)
     return GST_FLOW_OK;
 
@@ -948,6 +1311,9 @@ gst_wavpack_enc_set_property (GObject * object, guint prop_id,
     case ARG_JOINT_STEREO_MODE:
       enc->joint_stereo_mode = g_value_get_enum (value);
       break;
+    case ARG_N_THREADS:
+      enc->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -990,6 +1356,9 @@ gst_wavpack_enc_get_property (GObject * object, guint prop_id, GValue * value,
     case ARG_JOINT_STEREO_MODE:
       g_value_set_enum (value, enc->joint_stereo_mode);
       break;
+    case ARG_N_THREADS:
+      g_value_set_uint (value, enc->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -48,6 +48,23 @@ typedef struct
   gboolean passthrough;
 } GstWavpackEncWriteID;
 
+typedef struct
+{
+  GstWavpackEnc *enc;
+
+  /* interleaved input samples, already in Wavpack channel order */
+  gint32 *samples;
+  guint32 n_samples;
+  guint32 block_index;
+
+  /* encoded blocks, with block indices relative to the job */
+  GByteArray *wv;
+  GByteArray *wvc;
+
+  gboolean done;
+  gboolean ok;
+} GstWavpackEncJob;
+
 
 struct _GstWavpackEnc
 {
@@ -90,6 +107,17 @@ struct _GstWavpackEnc
 
   GstClockTime timestamp_offset;
   GstClockTime next_ts;
+
+  /* parallel block encoding */
+  guint n_threads;
+  GThreadPool *job_pool;
+  GQueue jobs;
+  GMutex job_lock;
+  GCond job_cond;
+  GstWavpackEncJob *cur_job;
+  guint32 job_samples;
+  guint max_jobs;
+  guint32 next_index;
 };
 
 struct _GstWavpackEncClass
@@ -53,6 +53,14 @@
 #define M_PI  3.14159265358979323846
 #endif
 
+/* The SSE4.1 and AVX2 chroma keying kernels are built with function level
+ * target attributes and selected at runtime */
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define HAVE_ALPHA_SIMD 1
+#include <immintrin.h>
+#endif
+
 /* Generated by -bad/ext/cog/generate_tables */
 static const int cog_ycbcr_to_rgb_matrix_8bit_hdtv[] = {
   298, 0, 459, -63514,
@@ -107,6 +115,7 @@ enum
 #define DEFAULT_BLACK_SENSITIVITY 100
 #define DEFAULT_WHITE_SENSITIVITY 100
 #define DEFAULT_PREFER_PASSTHROUGH FALSE
+#define DEFAULT_N_THREADS 1
 
 enum
 {
@@ -121,6 +130,7 @@ enum
   PROP_BLACK_SENSITIVITY,
   PROP_WHITE_SENSITIVITY,
   PROP_PREFER_PASSTHROUGH,
+  PROP_N_THREADS,
   PROP_LAST
 };
 
@@ -266,6 +276,20 @@ gst_alpha_class_init (GstAlphaClass * klass)
           DEFAULT_PREFER_PASSTHROUGH,
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAlpha:n-threads:
+   *
+   * Number of threads used to process a frame, each one handles a slice of
+   * the rows. 0 uses one thread per processor.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+      PROP_N_THREADS, g_param_spec_uint ("n-threads", "Number of threads",
+          "Maximum number of threads used to process a frame "
+          "(0 = number of processors)", 0, G_MAXUINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "Alpha filter",
       "Filter/Effect/Video",
       "Adds an alpha channel to video - uniform or via chroma-keying",
@@ -285,6 +309,13 @@ gst_alpha_class_init (GstAlphaClass * klass)
   vfilter_class->set_info = GST_DEBUG_FUNCPTR (gst_alpha_set_info);
   vfilter_class->transform_frame =
       GST_DEBUG_FUNCPTR (gst_alpha_transform_frame);
+
+#ifdef HAVE_ALPHA_SIMD
+  if (__builtin_cpu_supports ("avx2"))
+    chroma_keying_yuv_line = chroma_keying_yuv_line_256;
+  else if (__builtin_cpu_supports ("sse4.1"))
+    chroma_keying_yuv_line = chroma_keying_yuv_line_128;
+#endif
 }
 
 static void
@@ -299,8 +330,11 @@ gst_alpha_init (GstAlpha * alpha)
   alpha->noise_level = DEFAULT_NOISE_LEVEL;
   alpha->black_sensitivity = DEFAULT_BLACK_SENSITIVITY;
   alpha->white_sensitivity = DEFAULT_WHITE_SENSITIVITY;
+  alpha->n_threads = DEFAULT_N_THREADS;
 
   g_mutex_init (&alpha->lock);
+  g_mutex_init (&alpha->slice_lock);
+  g_cond_init (&alpha->slice_cond);
 }
 
 static void
@@ -308,6 +342,10 @@ gst_alpha_finalize (GObject * object)
 {
   GstAlpha *alpha = GST_ALPHA (object);
 
+  if (alpha->slice_pool)
+    g_thread_pool_free (alpha->slice_pool, FALSE, TRUE);
+  g_mutex_clear (&alpha->slice_lock);
+  g_cond_clear (&alpha->slice_cond);
   g_mutex_clear (&alpha->lock);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -376,6 +414,9 @@ gst_alpha_set_property (GObject * object, guint prop_id,
       alpha->prefer_passthrough = prefer_passthrough;
       break;
     }
+    case PROP_N_THREADS:
+      alpha->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -424,6 +465,9 @@ gst_alpha_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_PREFER_PASSTHROUGH:
       g_value_set_boolean (value, alpha->prefer_passthrough);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, alpha->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -616,6 +660,153 @@ chroma_keying_yuv (gint a, gint * y, gint * u,
   return b_alpha;
 }
 
+static void
+chroma_keying_yuv_line_c (GstAlpha * alpha, gint16 * la, gint16 * ly,
+    gint16 * lu, gint16 * lv, gint n, gint smin, gint smax)
+{
+  gint i, y, u, v;
+
+  for (i = 0; i < n; i++) {
+    y = ly[i];
+    u = lu[i];
+    v = lv[i];
+
+    la[i] = chroma_keying_yuv (la[i], &y, &u, &v, alpha->cr, alpha->cb,
+        smin, smax, alpha->accept_angle_tg, alpha->accept_angle_ctg,
+        alpha->one_over_kc, alpha->kfgy_scale, alpha->kg,
+        alpha->noise_level2);
+
+    ly[i] = y;
+    lu[i] = u;
+    lv[i] = v;
+  }
+}
+
+/* The chroma keying of chroma_keying_yuv() fits into 16 bit lanes, except
+ * for the products with the key colour that are done with 32 bit
+ * multiply-adds. The SIMD variants work on lines of unpacked samples and
+ * give the same results as the scalar code. */
+#ifdef HAVE_ALPHA_SIMD
+
+#define ALPHA_SSE41_ATTR __attribute__ ((target ("sse4.1")))
+#define ALPHA_AVX2_ATTR __attribute__ ((target ("avx2")))
+
+/* two 16 bit multiply-add coefficients, lo for the even lane */
+#define PAIR16(lo,hi) ((gint) (((guint32) (guint16) (hi) << 16) | (guint16) (lo)))
+
+#define CHROMA_KEYING_KERNEL(T,P,L,ATTR)                                     \
+static ATTR void                                                             \
+chroma_keying_yuv_line_##L (GstAlpha * alpha, gint16 * la, gint16 * ly,     \
+    gint16 * lu, gint16 * lv, gint n, gint smin, gint smax)                  \
+{                                                                            \
+  const gint lanes = sizeof (T) / 2;                                         \
+  const T cb_cr = P##_set1_epi32 (PAIR16 (alpha->cb, alpha->cr));           \
+  const T mcr_cb = P##_set1_epi32 (PAIR16 (-alpha->cr, alpha->cb));         \
+  const T cb_mcr = P##_set1_epi32 (PAIR16 (alpha->cb, -alpha->cr));         \
+  const T cr_cb = P##_set1_epi32 (PAIR16 (alpha->cr, alpha->cb));           \
+  const T tg = P##_set1_epi16 (alpha->accept_angle_tg);                      \
+  const T ctg = P##_set1_epi16 (alpha->accept_angle_ctg);                    \
+  const T okc = P##_set1_epi16 (alpha->one_over_kc);                         \
+  const T kfgy = P##_set1_epi16 (alpha->kfgy_scale);                         \
+  const T kg = P##_set1_epi16 (alpha->kg);                                   \
+  const T nl = P##_set1_epi16 (MIN (alpha->noise_level2, 0x10000) - 1);      \
+  const T vsmin = P##_set1_epi16 (smin);                                     \
+  const T vsmax = P##_set1_epi16 (smax);                                     \
+  const T lo = P##_set1_epi16 (-128), hi = P##_set1_epi16 (127);             \
+  const T c255 = P##_set1_epi16 (255);                                       \
+  const T zero = P##_setzero_si##L ();                                       \
+  gboolean noise = alpha->noise_level2 > 0;                                  \
+  gint i;                                                                    \
+                                                                             \
+  for (i = 0; i + lanes <= n; i += lanes) {                                  \
+    T a = P##_loadu_si##L ((T *) (la + i));                                  \
+    T y = P##_loadu_si##L ((T *) (ly + i));                                  \
+    T u = P##_loadu_si##L ((T *) (lu + i));                                  \
+    T v = P##_loadu_si##L ((T *) (lv + i));                                  \
+    T uv_lo = P##_unpacklo_epi16 (u, v), uv_hi = P##_unpackhi_epi16 (u, v);  \
+    T x, z, t, keep, x1, tmp1, b, ys, nu, nv, d, xz_lo, xz_hi;               \
+                                                                             \
+    keep = P##_or_si##L (P##_cmpgt_epi16 (vsmin, y),                         \
+        P##_cmpgt_epi16 (y, vsmax));                                         \
+                                                                             \
+    /* x = (u * cb + v * cr) >> 7, z = (v * cb - u * cr) >> 7, clamped */    \
+    x = P##_packs_epi32 (                                                    \
+        P##_srai_epi32 (P##_madd_epi16 (uv_lo, cb_cr), 7),                    \
+        P##_srai_epi32 (P##_madd_epi16 (uv_hi, cb_cr), 7));                   \
+    x = P##_min_epi16 (P##_max_epi16 (x, lo), hi);                           \
+    z = P##_packs_epi32 (                                                    \
+        P##_srai_epi32 (P##_madd_epi16 (uv_lo, mcr_cb), 7),                   \
+        P##_srai_epi32 (P##_madd_epi16 (uv_hi, mcr_cb), 7));                  \
+    z = P##_min_epi16 (P##_max_epi16 (z, lo), hi);                           \
+                                                                             \
+    t = P##_min_epi16 (P##_srai_epi16 (P##_mullo_epi16 (x, tg), 4), hi);     \
+    keep = P##_or_si##L (keep, P##_cmpgt_epi16 (P##_abs_epi16 (z), t));      \
+                                                                             \
+    t = P##_srai_epi16 (P##_mullo_epi16 (z, ctg), 4);                        \
+    x1 = P##_abs_epi16 (P##_min_epi16 (P##_max_epi16 (t, lo), hi));          \
+    tmp1 = P##_max_epi16 (P##_sub_epi16 (x, x1), zero);                      \
+                                                                             \
+    /* all products below are positive and fit into 16 unsigned bits */      \
+    b = P##_min_epu16 (P##_srli_epi16 (P##_mullo_epi16 (tmp1, okc), 1),      \
+        c255);                                                               \
+    b = P##_srli_epi16 (P##_mullo_epi16 (a, P##_sub_epi16 (c255, b)), 8);    \
+    ys = P##_min_epu16 (P##_srli_epi16 (P##_mullo_epi16 (tmp1, kfgy), 4),    \
+        c255);                                                               \
+                                                                             \
+    xz_lo = P##_unpacklo_epi16 (x1, z);                                      \
+    xz_hi = P##_unpackhi_epi16 (x1, z);                                      \
+    nu = P##_packs_epi32 (                                                   \
+        P##_srai_epi32 (P##_madd_epi16 (xz_lo, cb_mcr), 7),                   \
+        P##_srai_epi32 (P##_madd_epi16 (xz_hi, cb_mcr), 7));                  \
+    nu = P##_min_epi16 (P##_max_epi16 (nu, lo), hi);                         \
+    nv = P##_packs_epi32 (                                                   \
+        P##_srai_epi32 (P##_madd_epi16 (xz_lo, cr_cb), 7),                    \
+        P##_srai_epi32 (P##_madd_epi16 (xz_hi, cr_cb), 7));                   \
+    nv = P##_min_epi16 (P##_max_epi16 (nv, lo), hi);                         \
+                                                                             \
+    if (noise) {                                                             \
+      d = P##_sub_epi16 (x, kg);                                             \
+      d = P##_adds_epu16 (P##_mullo_epi16 (z, z), P##_mullo_epi16 (d, d));   \
+      b = P##_andnot_si##L (P##_cmpeq_epi16 (P##_min_epu16 (d, nl), d), b);  \
+    }                                                                        \
+                                                                             \
+    P##_storeu_si##L ((T *) (la + i), P##_blendv_epi8 (b, a, keep));         \
+    P##_storeu_si##L ((T *) (ly + i),                                        \
+        P##_blendv_epi8 (P##_subs_epu16 (y, ys), y, keep));                  \
+    P##_storeu_si##L ((T *) (lu + i), P##_blendv_epi8 (nu, u, keep));        \
+    P##_storeu_si##L ((T *) (lv + i), P##_blendv_epi8 (nv, v, keep));        \
+  }                                                                          \
+                                                                             \
+  chroma_keying_yuv_line_c (alpha, la + i, ly + i, lu + i, lv + i, n - i,    \
+      smin, smax);                                                           \
+}
+
+CHROMA_KEYING_KERNEL (__m128i, _mm, 128, ALPHA_SSE41_ATTR);
+CHROMA_KEYING_KERNEL (__m256i, _mm256, 256, ALPHA_AVX2_ATTR);
+
+#undef CHROMA_KEYING_KERNEL
+#endif /* HAVE_ALPHA_SIMD */
+
+/* Keys @n pixels given as separate a, y, u and v lines, u and v without
+ * offset. Set to the best variant for the CPU in class_init */
+static void (*chroma_keying_yuv_line) (GstAlpha * alpha, gint16 * la,
+    gint16 * ly, gint16 * lu, gint16 * lv, gint n, gint smin, gint smax) =
+    chroma_keying_yuv_line_c;
+
+/* Allocates one block for the a, y, u and v lines of @width pixels, free it
+ * with the returned a line */
+static gint16 *
+gst_alpha_alloc_lines (gint width, gint16 ** ly, gint16 ** lu, gint16 ** lv)
+{
+  gint16 *la = g_new (gint16, 4 * width);
+
+  *ly = la + width;
+  *lu = *ly + width;
+  *lv = *lu + width;
+
+  return la;
+}
+
 #define APPLY_MATRIX(m,o,v1,v2,v3) ((m[o*4] * v1 + m[o*4+1] * v2 + m[o*4+2] * v3 + m[o*4+3]) >> 8)
 
 static void
@@ -672,17 +863,10 @@ gst_alpha_chroma_key_argb_ayuv (const GstVideoFrame * in_frame,
   guint8 *dest;
   gint width, height;
   gint i, j;
-  gint a, y, u, v;
   gint r, g, b;
   gint smin, smax;
   gint pa = CLAMP ((gint) (alpha->alpha * 256), 0, 256);
-  gint8 cb = alpha->cb, cr = alpha->cr;
-  gint8 kg = alpha->kg;
-  guint8 accept_angle_tg = alpha->accept_angle_tg;
-  guint8 accept_angle_ctg = alpha->accept_angle_ctg;
-  guint8 one_over_kc = alpha->one_over_kc;
-  guint8 kfgy_scale = alpha->kfgy_scale;
-  guint noise_level2 = alpha->noise_level2;
+  gint16 *la, *ly, *lu, *lv;
   gint matrix[12];
   gint o[4];
 
@@ -704,33 +888,35 @@ gst_alpha_chroma_key_argb_ayuv (const GstVideoFrame * in_frame,
       alpha->out_sdtv ? cog_rgb_to_ycbcr_matrix_8bit_sdtv :
       cog_rgb_to_ycbcr_matrix_8bit_hdtv, 12 * sizeof (gint));
 
+  la = gst_alpha_alloc_lines (width, &ly, &lu, &lv);
+
   for (i = 0; i < height; i++) {
     for (j = 0; j < width; j++) {
-      a = (src[o[0]] * pa) >> 8;
+      la[j] = (src[o[0]] * pa) >> 8;
       r = src[o[1]];
       g = src[o[2]];
       b = src[o[3]];
 
-      y = APPLY_MATRIX (matrix, 0, r, g, b);
-      u = APPLY_MATRIX (matrix, 1, r, g, b) - 128;
-      v = APPLY_MATRIX (matrix, 2, r, g, b) - 128;
+      ly[j] = APPLY_MATRIX (matrix, 0, r, g, b);
+      lu[j] = APPLY_MATRIX (matrix, 1, r, g, b) - 128;
+      lv[j] = APPLY_MATRIX (matrix, 2, r, g, b) - 128;
 
-      a = chroma_keying_yuv (a, &y, &u, &v, cr, cb,
-          smin, smax, accept_angle_tg, accept_angle_ctg,
-          one_over_kc, kfgy_scale, kg, noise_level2);
+      src += 4;
+    }
 
-      u += 128;
-      v += 128;
+    chroma_keying_yuv_line (alpha, la, ly, lu, lv, width, smin, smax);
 
-      dest[0] = a;
-      dest[1] = y;
-      dest[2] = u;
-      dest[3] = v;
+    for (j = 0; j < width; j++) {
+      dest[0] = la[j];
+      dest[1] = ly[j];
+      dest[2] = lu[j] + 128;
+      dest[3] = lv[j] + 128;
 
-      src += 4;
       dest += 4;
     }
   }
+
+  g_free (la);
 }
 
 static void
@@ -782,17 +968,11 @@ gst_alpha_chroma_key_argb_argb (const GstVideoFrame * in_frame,
   guint8 *dest;
   gint width, height;
   gint i, j;
-  gint a, y, u, v;
+  gint y, u, v;
   gint r, g, b;
   gint smin, smax;
   gint pa = CLAMP ((gint) (alpha->alpha * 256), 0, 256);
-  gint8 cb = alpha->cb, cr = alpha->cr;
-  gint8 kg = alpha->kg;
-  guint8 accept_angle_tg = alpha->accept_angle_tg;
-  guint8 accept_angle_ctg = alpha->accept_angle_ctg;
-  guint8 one_over_kc = alpha->one_over_kc;
-  guint8 kfgy_scale = alpha->kfgy_scale;
-  guint noise_level2 = alpha->noise_level2;
+  gint16 *la, *ly, *lu, *lv;
   gint matrix[12], matrix2[12];
   gint p[4], o[4];
 
@@ -818,37 +998,43 @@ gst_alpha_chroma_key_argb_argb (const GstVideoFrame * in_frame,
   memcpy (matrix, cog_rgb_to_ycbcr_matrix_8bit_sdtv, 12 * sizeof (gint));
   memcpy (matrix2, cog_ycbcr_to_rgb_matrix_8bit_sdtv, 12 * sizeof (gint));
 
+  la = gst_alpha_alloc_lines (width, &ly, &lu, &lv);
+
   for (i = 0; i < height; i++) {
     for (j = 0; j < width; j++) {
-      a = (src[o[0]] * pa) >> 8;
+      la[j] = (src[o[0]] * pa) >> 8;
       r = src[o[1]];
       g = src[o[2]];
       b = src[o[3]];
 
-      y = APPLY_MATRIX (matrix, 0, r, g, b);
-      u = APPLY_MATRIX (matrix, 1, r, g, b) - 128;
-      v = APPLY_MATRIX (matrix, 2, r, g, b) - 128;
+      ly[j] = APPLY_MATRIX (matrix, 0, r, g, b);
+      lu[j] = APPLY_MATRIX (matrix, 1, r, g, b) - 128;
+      lv[j] = APPLY_MATRIX (matrix, 2, r, g, b) - 128;
+
+      src += 4;
+    }
 
-      a = chroma_keying_yuv (a, &y, &u, &v, cr, cb,
-          smin, smax, accept_angle_tg, accept_angle_ctg,
-          one_over_kc, kfgy_scale, kg, noise_level2);
+    chroma_keying_yuv_line (alpha, la, ly, lu, lv, width, smin, smax);
 
-      u += 128;
-      v += 128;
+    for (j = 0; j < width; j++) {
+      y = ly[j];
+      u = lu[j] + 128;
+      v = lv[j] + 128;
 
       r = APPLY_MATRIX (matrix2, 0, y, u, v);
       g = APPLY_MATRIX (matrix2, 1, y, u, v);
       b = APPLY_MATRIX (matrix2, 2, y, u, v);
 
-      dest[p[0]] = a;
+      dest[p[0]] = la[j];
       dest[p[1]] = CLAMP (r, 0, 255);
       dest[p[2]] = CLAMP (g, 0, 255);
       dest[p[3]] = CLAMP (b, 0, 255);
 
-      src += 4;
       dest += 4;
     }
   }
+
+  g_free (la);
 }
 
 static void
@@ -905,17 +1091,11 @@ gst_alpha_chroma_key_ayuv_argb (const GstVideoFrame * in_frame,
   guint8 *dest;
   gint width, height;
   gint i, j;
-  gint a, y, u, v;
+  gint y, u, v;
   gint r, g, b;
   gint smin, smax;
   gint pa = CLAMP ((gint) (alpha->alpha * 256), 0, 256);
-  gint8 cb = alpha->cb, cr = alpha->cr;
-  gint8 kg = alpha->kg;
-  guint8 accept_angle_tg = alpha->accept_angle_tg;
-  guint8 accept_angle_ctg = alpha->accept_angle_ctg;
-  guint8 one_over_kc = alpha->one_over_kc;
-  guint8 kfgy_scale = alpha->kfgy_scale;
-  guint noise_level2 = alpha->noise_level2;
+  gint16 *la, *ly, *lu, *lv;
   gint matrix[12];
   gint p[4];
 
@@ -937,33 +1117,39 @@ gst_alpha_chroma_key_ayuv_argb (const GstVideoFrame * in_frame,
       alpha->in_sdtv ? cog_ycbcr_to_rgb_matrix_8bit_sdtv :
       cog_ycbcr_to_rgb_matrix_8bit_hdtv, 12 * sizeof (gint));
 
+  la = gst_alpha_alloc_lines (width, &ly, &lu, &lv);
+
   for (i = 0; i < height; i++) {
     for (j = 0; j < width; j++) {
-      a = (src[0] * pa) >> 8;
-      y = src[1];
-      u = src[2] - 128;
-      v = src[3] - 128;
+      la[j] = (src[0] * pa) >> 8;
+      ly[j] = src[1];
+      lu[j] = src[2] - 128;
+      lv[j] = src[3] - 128;
 
-      a = chroma_keying_yuv (a, &y, &u, &v, cr, cb,
-          smin, smax, accept_angle_tg, accept_angle_ctg,
-          one_over_kc, kfgy_scale, kg, noise_level2);
+      src += 4;
+    }
 
-      u += 128;
-      v += 128;
+    chroma_keying_yuv_line (alpha, la, ly, lu, lv, width, smin, smax);
+
+    for (j = 0; j < width; j++) {
+      y = ly[j];
+      u = lu[j] + 128;
+      v = lv[j] + 128;
 
       r = APPLY_MATRIX (matrix, 0, y, u, v);
       g = APPLY_MATRIX (matrix, 1, y, u, v);
       b = APPLY_MATRIX (matrix, 2, y, u, v);
 
-      dest[p[0]] = a;
+      dest[p[0]] = la[j];
       dest[p[1]] = CLAMP (r, 0, 255);
       dest[p[2]] = CLAMP (g, 0, 255);
       dest[p[3]] = CLAMP (b, 0, 255);
 
-      src += 4;
       dest += 4;
     }
   }
+
+  g_free (la);
 }
 
 static void
@@ -1023,16 +1209,11 @@ gst_alpha_chroma_key_ayuv_ayuv (const GstVideoFrame * in_frame,
   guint8 *dest;
   gint width, height;
   gint i, j;
-  gint a, y, u, v;
   gint smin, smax;
   gint pa = CLAMP ((gint) (alpha->alpha * 256), 0, 256);
-  gint8 cb = alpha->cb, cr = alpha->cr;
-  gint8 kg = alpha->kg;
-  guint8 accept_angle_tg = alpha->accept_angle_tg;
-  guint8 accept_angle_ctg = alpha->accept_angle_ctg;
-  guint8 one_over_kc = alpha->one_over_kc;
-  guint8 kfgy_scale = alpha->kfgy_scale;
-  guint noise_level2 = alpha->noise_level2;
+  gint16 *la, *ly, *lu, *lv;
+  gint matrix[12];
+  gboolean convert = alpha->in_sdtv != alpha->out_sdtv;
 
   src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
   dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
@@ -1043,61 +1224,46 @@ gst_alpha_chroma_key_ayuv_ayuv (const GstVideoFrame * in_frame,
   smin = 128 - alpha->black_sensitivity;
   smax = 128 + alpha->white_sensitivity;
 
-  if (alpha->in_sdtv == alpha->out_sdtv) {
-    for (i = 0; i < height; i++) {
-      for (j = 0; j < width; j++) {
-        a = (src[0] * pa) >> 8;
-        y = src[1];
-        u = src[2] - 128;
-        v = src[3] - 128;
-
-        a = chroma_keying_yuv (a, &y, &u, &v, cr, cb,
-            smin, smax, accept_angle_tg, accept_angle_ctg,
-            one_over_kc, kfgy_scale, kg, noise_level2);
+  memcpy (matrix,
+      alpha->out_sdtv ? cog_ycbcr_hdtv_to_ycbcr_sdtv_matrix_8bit :
+      cog_ycbcr_sdtv_to_ycbcr_hdtv_matrix_8bit, 12 * sizeof (gint));
 
-        u += 128;
-        v += 128;
+  la = gst_alpha_alloc_lines (width, &ly, &lu, &lv);
 
-        dest[0] = a;
-        dest[1] = y;
-        dest[2] = u;
-        dest[3] = v;
+  for (i = 0; i < height; i++) {
+    if (convert) {
+      for (j = 0; j < width; j++) {
+        la[j] = (src[0] * pa) >> 8;
+        ly[j] = APPLY_MATRIX (matrix, 0, src[1], src[2], src[3]);
+        lu[j] = APPLY_MATRIX (matrix, 1, src[1], src[2], src[3]) - 128;
+        lv[j] = APPLY_MATRIX (matrix, 2, src[1], src[2], src[3]) - 128;
 
         src += 4;
-        dest += 4;
       }
-    }
-  } else {
-    gint matrix[12];
-
-    memcpy (matrix,
-        alpha->out_sdtv ? cog_ycbcr_hdtv_to_ycbcr_sdtv_matrix_8bit :
-        cog_ycbcr_sdtv_to_ycbcr_hdtv_matrix_8bit, 12 * sizeof (gint));
-
-    for (i = 0; i < height; i++) {
+    } else {
       for (j = 0; j < width; j++) {
-        a = (src[0] * pa) >> 8;
-        y = APPLY_MATRIX (matrix, 0, src[1], src[2], src[3]);
-        u = APPLY_MATRIX (matrix, 1, src[1], src[2], src[3]) - 128;
-        v = APPLY_MATRIX (matrix, 2, src[1], src[2], src[3]) - 128;
+        la[j] = (src[0] * pa) >> 8;
+        ly[j] = src[1];
+        lu[j] = src[2] - 128;
+        lv[j] = src[3] - 128;
 
-        a = chroma_keying_yuv (a, &y, &u, &v, cr, cb,
-            smin, smax, accept_angle_tg, accept_angle_ctg,
-            one_over_kc, kfgy_scale, kg, noise_level2);
+        src += 4;
+      }
+    }
 
-        u += 128;
-        v += 128;
+    chroma_keying_yuv_line (alpha, la, ly, lu, lv, width, smin, smax);
 
-        dest[0] = a;
-        dest[1] = y;
-        dest[2] = u;
-        dest[3] = v;
+    for (j = 0; j < width; j++) {
+      dest[0] = la[j];
+      dest[1] = ly[j];
+      dest[2] = lu[j] + 128;
+      dest[3] = lv[j] + 128;
 
-        src += 4;
-        dest += 4;
-      }
+      dest += 4;
     }
   }
+
+  g_free (la);
 }
 
 static void
@@ -1155,17 +1321,10 @@ gst_alpha_chroma_key_rgb_ayuv (const GstVideoFrame * in_frame,
   guint8 *dest;
   gint width, height;
   gint i, j;
-  gint a, y, u, v;
   gint r, g, b;
   gint smin, smax;
   gint pa = CLAMP ((gint) (alpha->alpha * 255), 0, 255);
-  gint8 cb = alpha->cb, cr = alpha->cr;
-  gint8 kg = alpha->kg;
-  guint8 accept_angle_tg = alpha->accept_angle_tg;
-  guint8 accept_angle_ctg = alpha->accept_angle_ctg;
-  guint8 one_over_kc = alpha->one_over_kc;
-  guint8 kfgy_scale = alpha->kfgy_scale;
-  guint noise_level2 = alpha->noise_level2;
+  gint16 *la, *ly, *lu, *lv;
   gint matrix[12];
   gint o[3];
   gint bpp;
@@ -1189,33 +1348,35 @@ gst_alpha_chroma_key_rgb_ayuv (const GstVideoFrame * in_frame,
       alpha->out_sdtv ? cog_rgb_to_ycbcr_matrix_8bit_sdtv :
       cog_rgb_to_ycbcr_matrix_8bit_hdtv, 12 * sizeof (gint));
 
+  la = gst_alpha_alloc_lines (width, &ly, &lu, &lv);
+
   for (i = 0; i < height; i++) {
     for (j = 0; j < width; j++) {
-      a = pa;
+      la[j] = pa;
       r = src[o[0]];
       g = src[o[1]];
       b = src[o[2]];
 
-      y = APPLY_MATRIX (matrix, 0, r, g, b);
-      u = APPLY_MATRIX (matrix, 1, r, g, b) - 128;
-      v = APPLY_MATRIX (matrix, 2, r, g, b) - 128;
+      ly[j] = APPLY_MATRIX (matrix, 0, r, g, b);
+      lu[j] = APPLY_MATRIX (matrix, 1, r, g, b) - 128;
+      lv[j] = APPLY_MATRIX (matrix, 2, r, g, b) - 128;
 
-      a = chroma_keying_yuv (a, &y, &u, &v, cr, cb,
-          smin, smax, accept_angle_tg, accept_angle_ctg,
-          one_over_kc, kfgy_scale, kg, noise_level2);
+      src += bpp;
+    }
 
-      u += 128;
-      v += 128;
+    chroma_keying_yuv_line (alpha, la, ly, lu, lv, width, smin, smax);
 
-      dest[0] = a;
-      dest[1] = y;
-      dest[2] = u;
-      dest[3] = v;
+    for (j = 0; j < width; j++) {
+      dest[0] = la[j];
+      dest[1] = ly[j];
+      dest[2] = lu[j] + 128;
+      dest[3] = lv[j] + 128;
 
-      src += bpp;
       dest += 4;
     }
   }
+
+  g_free (la);
 }
 
 static void
@@ -1269,17 +1430,11 @@ gst_alpha_chroma_key_rgb_argb (const GstVideoFrame * in_frame,
   guint8 *dest;
   gint width, height;
   gint i, j;
-  gint a, y, u, v;
+  gint y, u, v;
   gint r, g, b;
   gint smin, smax;
   gint pa = CLAMP ((gint) (alpha->alpha * 255), 0, 255);
-  gint8 cb = alpha->cb, cr = alpha->cr;
-  gint8 kg = alpha->kg;
-  guint8 accept_angle_tg = alpha->accept_angle_tg;
-  guint8 accept_angle_ctg = alpha->accept_angle_ctg;
-  guint8 one_over_kc = alpha->one_over_kc;
-  guint8 kfgy_scale = alpha->kfgy_scale;
-  guint noise_level2 = alpha->noise_level2;
+  gint16 *la, *ly, *lu, *lv;
   gint matrix[12], matrix2[12];
   gint p[4], o[3];
   gint bpp;
@@ -1307,37 +1462,43 @@ gst_alpha_chroma_key_rgb_argb (const GstVideoFrame * in_frame,
   memcpy (matrix, cog_rgb_to_ycbcr_matrix_8bit_sdtv, 12 * sizeof (gint));
   memcpy (matrix2, cog_ycbcr_to_rgb_matrix_8bit_sdtv, 12 * sizeof (gint));
 
+  la = gst_alpha_alloc_lines (width, &ly, &lu, &lv);
+
   for (i = 0; i < height; i++) {
     for (j = 0; j < width; j++) {
-      a = pa;
+      la[j] = pa;
       r = src[o[0]];
       g = src[o[1]];
       b = src[o[2]];
 
-      y = APPLY_MATRIX (matrix, 0, r, g, b);
-      u = APPLY_MATRIX (matrix, 1, r, g, b) - 128;
-      v = APPLY_MATRIX (matrix, 2, r, g, b) - 128;
+      ly[j] = APPLY_MATRIX (matrix, 0, r, g, b);
+      lu[j] = APPLY_MATRIX (matrix, 1, r, g, b) - 128;
+      lv[j] = APPLY_MATRIX (matrix, 2, r, g, b) - 128;
 
-      a = chroma_keying_yuv (a, &y, &u, &v, cr, cb,
-          smin, smax, accept_angle_tg, accept_angle_ctg,
-          one_over_kc, kfgy_scale, kg, noise_level2);
+      src += bpp;
+    }
+
+    chroma_keying_yuv_line (alpha, la, ly, lu, lv, width, smin, smax);
 
-      u += 128;
-      v += 128;
+    for (j = 0; j < width; j++) {
+      y = ly[j];
+      u = lu[j] + 128;
+      v = lv[j] + 128;
 
       r = APPLY_MATRIX (matrix2, 0, y, u, v);
       g = APPLY_MATRIX (matrix2, 1, y, u, v);
       b = APPLY_MATRIX (matrix2, 2, y, u, v);
 
-      dest[p[0]] = a;
+      dest[p[0]] = la[j];
       dest[p[1]] = CLAMP (r, 0, 255);
       dest[p[2]] = CLAMP (g, 0, 255);
       dest[p[3]] = CLAMP (b, 0, 255);
 
-      src += bpp;
       dest += 4;
     }
   }
+
+  g_free (la);
 }
 
 static void
@@ -1463,18 +1624,13 @@ gst_alpha_chroma_key_planar_yuv_ayuv (const GstVideoFrame * in_frame,
   const guint8 *srcU, *srcU_tmp;
   const guint8 *srcV, *srcV_tmp;
   gint i, j;
-  gint a, y, u, v;
   gint y_stride, uv_stride;
   gint v_subs, h_subs;
   gint smin = 128 - alpha->black_sensitivity;
   gint smax = 128 + alpha->white_sensitivity;
-  gint8 cb = alpha->cb, cr = alpha->cr;
-  gint8 kg = alpha->kg;
-  guint8 accept_angle_tg = alpha->accept_angle_tg;
-  guint8 accept_angle_ctg = alpha->accept_angle_ctg;
-  guint8 one_over_kc = alpha->one_over_kc;
-  guint8 kfgy_scale = alpha->kfgy_scale;
-  guint noise_level2 = alpha->noise_level2;
+  gint16 *la, *ly, *lu, *lv;
+  gint matrix[12];
+  gboolean convert = alpha->in_sdtv != alpha->out_sdtv;
 
   dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
 
@@ -1509,84 +1665,54 @@ gst_alpha_chroma_key_planar_yuv_ayuv (const GstVideoFrame * in_frame,
       return;
   }
 
-  if (alpha->in_sdtv == alpha->out_sdtv) {
-    for (i = 0; i < height; i++) {
-      for (j = 0; j < width; j++) {
-        a = b_alpha;
-        y = srcY[0];
-        u = srcU[0] - 128;
-        v = srcV[0] - 128;
-
-        a = chroma_keying_yuv (a, &y, &u, &v, cr, cb, smin,
-            smax, accept_angle_tg, accept_angle_ctg,
-            one_over_kc, kfgy_scale, kg, noise_level2);
-
-        u += 128;
-        v += 128;
+  memcpy (matrix,
+      alpha->out_sdtv ? cog_ycbcr_hdtv_to_ycbcr_sdtv_matrix_8bit :
+      cog_ycbcr_sdtv_to_ycbcr_hdtv_matrix_8bit, 12 * sizeof (gint));
 
-        dest[0] = a;
-        dest[1] = y;
-        dest[2] = u;
-        dest[3] = v;
+  la = gst_alpha_alloc_lines (width, &ly, &lu, &lv);
 
-        dest += 4;
-        srcY++;
-        if ((j + 1) % h_subs == 0) {
-          srcU++;
-          srcV++;
-        }
+  for (i = 0; i < height; i++) {
+    for (j = 0; j < width; j++) {
+      la[j] = b_alpha;
+      if (convert) {
+        ly[j] = APPLY_MATRIX (matrix, 0, srcY[0], srcU[0], srcV[0]);
+        lu[j] = APPLY_MATRIX (matrix, 1, srcY[0], srcU[0], srcV[0]) - 128;
+        lv[j] = APPLY_MATRIX (matrix, 2, srcY[0], srcU[0], srcV[0]) - 128;
+      } else {
+        ly[j] = srcY[0];
+        lu[j] = srcU[0] - 128;
+        lv[j] = srcV[0] - 128;
       }
 
-      srcY_tmp = srcY = srcY_tmp + y_stride;
-      if ((i + 1) % v_subs == 0) {
-        srcU_tmp = srcU = srcU_tmp + uv_stride;
-        srcV_tmp = srcV = srcV_tmp + uv_stride;
-      } else {
-        srcU = srcU_tmp;
-        srcV = srcV_tmp;
+      srcY++;
+      if ((j + 1) % h_subs == 0) {
+        srcU++;
+        srcV++;
       }
     }
-  } else {
-    gint matrix[12];
 
-    memcpy (matrix,
-        alpha->out_sdtv ? cog_ycbcr_hdtv_to_ycbcr_sdtv_matrix_8bit :
-        cog_ycbcr_sdtv_to_ycbcr_hdtv_matrix_8bit, 12 * sizeof (gint));
+    chroma_keying_yuv_line (alpha, la, ly, lu, lv, width, smin, smax);
 
-    for (i = 0; i < height; i++) {
-      for (j = 0; j < width; j++) {
-        a = b_alpha;
-        y = APPLY_MATRIX (matrix, 0, srcY[0], srcU[0], srcV[0]);
-        u = APPLY_MATRIX (matrix, 1, srcY[0], srcU[0], srcV[0]) - 128;
-        v = APPLY_MATRIX (matrix, 2, srcY[0], srcU[0], srcV[0]) - 128;
-
-        a = chroma_keying_yuv (a, &y, &u, &v, cr, cb, smin,
-            smax, accept_angle_tg, accept_angle_ctg,
-            one_over_kc, kfgy_scale, kg, noise_level2);
-
-        dest[0] = a;
-        dest[1] = y;
-        dest[2] = u + 128;
-        dest[3] = v + 128;
+    for (j = 0; j < width; j++) {
+      dest[0] = la[j];
+      dest[1] = ly[j];
+      dest[2] = lu[j] + 128;
+      dest[3] = lv[j] + 128;
 
-        dest += 4;
-        srcY++;
-        if ((j + 1) % h_subs == 0) {
-          srcU++;
-          srcV++;
-        }
-      }
+      dest += 4;
+    }
 
-      srcY_tmp = srcY = srcY_tmp + y_stride;
-      if ((i + 1) % v_subs == 0) {
-        srcU_tmp = srcU = srcU_tmp + uv_stride;
-        srcV_tmp = srcV = srcV_tmp + uv_stride;
-      } else {
-        srcU = srcU_tmp;
-        srcV = srcV_tmp;
-      }
+    srcY_tmp = srcY = srcY_tmp + y_stride;
+    if ((i + 1) % v_subs == 0) {
+      srcU_tmp = srcU = srcU_tmp + uv_stride;
+      srcV_tmp = srcV = srcV_tmp + uv_stride;
+    } else {
+      srcU = srcU_tmp;
+      srcV = srcV_tmp;
     }
   }
+
+  g_free (la);
 }
 
 static void
@@ -1694,19 +1820,13 @@ gst_alpha_chroma_key_planar_yuv_argb (const GstVideoFrame * in_frame,
   const guint8 *srcU, *srcU_tmp;
   const guint8 *srcV, *srcV_tmp;
   gint i, j;
-  gint a, y, u, v;
+  gint y, u, v;
   gint r, g, b;
   gint y_stride, uv_stride;
   gint v_subs, h_subs;
   gint smin = 128 - alpha->black_sensitivity;
   gint smax = 128 + alpha->white_sensitivity;
-  gint8 cb = alpha->cb, cr = alpha->cr;
-  gint8 kg = alpha->kg;
-  guint8 accept_angle_tg = alpha->accept_angle_tg;
-  guint8 accept_angle_ctg = alpha->accept_angle_ctg;
-  guint8 one_over_kc = alpha->one_over_kc;
-  guint8 kfgy_scale = alpha->kfgy_scale;
-  guint noise_level2 = alpha->noise_level2;
+  gint16 *la, *ly, *lu, *lv;
   gint matrix[12];
   gint p[4];
 
@@ -1752,21 +1872,30 @@ gst_alpha_chroma_key_planar_yuv_argb (const GstVideoFrame * in_frame,
       alpha->in_sdtv ? cog_ycbcr_to_rgb_matrix_8bit_sdtv :
       cog_ycbcr_to_rgb_matrix_8bit_hdtv, 12 * sizeof (gint));
 
+  la = gst_alpha_alloc_lines (width, &ly, &lu, &lv);
+
   for (i = 0; i < height; i++) {
     for (j = 0; j < width; j++) {
-      a = b_alpha;
-      y = srcY[0];
-      u = srcU[0] - 128;
-      v = srcV[0] - 128;
+      la[j] = b_alpha;
+      ly[j] = srcY[0];
+      lu[j] = srcU[0] - 128;
+      lv[j] = srcV[0] - 128;
 
-      a = chroma_keying_yuv (a, &y, &u, &v, cr, cb, smin,
-          smax, accept_angle_tg, accept_angle_ctg,
-          one_over_kc, kfgy_scale, kg, noise_level2);
+      srcY++;
+      if ((j + 1) % h_subs == 0) {
+        srcU++;
+        srcV++;
+      }
+    }
 
-      u += 128;
-      v += 128;
+    chroma_keying_yuv_line (alpha, la, ly, lu, lv, width, smin, smax);
 
-      dest[p[0]] = a;
+    for (j = 0; j < width; j++) {
+      y = ly[j];
+      u = lu[j] + 128;
+      v = lv[j] + 128;
+
+      dest[p[0]] = la[j];
       r = APPLY_MATRIX (matrix, 0, y, u, v);
       g = APPLY_MATRIX (matrix, 1, y, u, v);
       b = APPLY_MATRIX (matrix, 2, y, u, v);
@@ -1775,11 +1904,6 @@ gst_alpha_chroma_key_planar_yuv_argb (const GstVideoFrame * in_frame,
       dest[p[3]] = CLAMP (b, 0, 255);
 
       dest += 4;
-      srcY++;
-      if ((j + 1) % h_subs == 0) {
-        srcU++;
-        srcV++;
-      }
     }
 
     srcY_tmp = srcY = srcY_tmp + y_stride;
@@ -1791,6 +1915,8 @@ gst_alpha_chroma_key_planar_yuv_argb (const GstVideoFrame * in_frame,
       srcV = srcV_tmp;
     }
   }
+
+  g_free (la);
 }
 
 static void
@@ -1923,19 +2049,15 @@ gst_alpha_chroma_key_packed_422_ayuv (const GstVideoFrame * in_frame,
   guint8 *dest;
   gint width, height;
   gint i, j;
-  gint a, y, u, v;
+  gint y;
   gint smin, smax;
   gint pa = CLAMP ((gint) (alpha->alpha * 255), 0, 255);
-  gint8 cb = alpha->cb, cr = alpha->cr;
-  gint8 kg = alpha->kg;
-  guint8 accept_angle_tg = alpha->accept_angle_tg;
-  guint8 accept_angle_ctg = alpha->accept_angle_ctg;
-  guint8 one_over_kc = alpha->one_over_kc;
-  guint8 kfgy_scale = alpha->kfgy_scale;
-  guint noise_level2 = alpha->noise_level2;
+  gint16 *la, *ly, *lu, *lv;
   gint p[4];                    /* Y U Y V */
   gint src_stride;
   const guint8 *src_tmp;
+  gint matrix[12];
+  gboolean convert = alpha->in_sdtv != alpha->out_sdtv;
 
   src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
   dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
@@ -1953,121 +2075,49 @@ gst_alpha_chroma_key_packed_422_ayuv (const GstVideoFrame * in_frame,
   smin = 128 - alpha->black_sensitivity;
   smax = 128 + alpha->white_sensitivity;
 
-  if (alpha->in_sdtv != alpha->out_sdtv) {
-    gint matrix[12];
-
-    memcpy (matrix,
-        alpha->in_sdtv ? cog_ycbcr_sdtv_to_ycbcr_hdtv_matrix_8bit :
-        cog_ycbcr_hdtv_to_ycbcr_sdtv_matrix_8bit, 12 * sizeof (gint));
-
-    for (i = 0; i < height; i++) {
-      src_tmp = src;
-
-      for (j = 0; j < width - 1; j += 2) {
-        y = APPLY_MATRIX (matrix, 0, src[p[0]], src[p[1]], src[p[3]]);
-        u = APPLY_MATRIX (matrix, 1, src[p[0]], src[p[1]], src[p[3]]) - 128;
-        v = APPLY_MATRIX (matrix, 2, src[p[0]], src[p[1]], src[p[3]]) - 128;
-
-        a = chroma_keying_yuv (pa, &y, &u, &v, cr, cb,
-            smin, smax, accept_angle_tg, accept_angle_ctg,
-            one_over_kc, kfgy_scale, kg, noise_level2);
-
-        dest[0] = a;
-        dest[1] = y;
-        dest[2] = u + 128;
-        dest[3] = v + 128;
-
-        y = APPLY_MATRIX (matrix, 0, src[p[2]], src[p[1]], src[p[3]]);
-        u = APPLY_MATRIX (matrix, 1, src[p[2]], src[p[1]], src[p[3]]) - 128;
-        v = APPLY_MATRIX (matrix, 2, src[p[2]], src[p[1]], src[p[3]]) - 128;
-
-        a = chroma_keying_yuv (pa, &y, &u, &v, cr, cb,
-            smin, smax, accept_angle_tg, accept_angle_ctg,
-            one_over_kc, kfgy_scale, kg, noise_level2);
-
-        dest[4] = a;
-        dest[5] = y;
-        dest[6] = u + 128;
-        dest[7] = v + 128;
-
-        dest += 8;
-        src += 4;
-      }
+  memcpy (matrix,
+      alpha->in_sdtv ? cog_ycbcr_sdtv_to_ycbcr_hdtv_matrix_8bit :
+      cog_ycbcr_hdtv_to_ycbcr_sdtv_matrix_8bit, 12 * sizeof (gint));
 
-      if (j == width - 1) {
-        y = APPLY_MATRIX (matrix, 0, src[p[0]], src[p[1]], src[p[3]]);
-        u = APPLY_MATRIX (matrix, 1, src[p[0]], src[p[1]], src[p[3]]) - 128;
-        v = APPLY_MATRIX (matrix, 2, src[p[0]], src[p[1]], src[p[3]]) - 128;
+  la = gst_alpha_alloc_lines (width, &ly, &lu, &lv);
 
-        a = chroma_keying_yuv (pa, &y, &u, &v, cr, cb,
-            smin, smax, accept_angle_tg, accept_angle_ctg,
-            one_over_kc, kfgy_scale, kg, noise_level2);
+  for (i = 0; i < height; i++) {
+    src_tmp = src;
 
-        dest[0] = a;
-        dest[1] = y;
-        dest[2] = u + 128;
-        dest[3] = v + 128;
+    /* even pixels take the first, odd pixels the second Y of a macropixel */
+    for (j = 0; j < width; j++) {
+      y = src[p[(j & 1) << 1]];
 
-        dest += 4;
+      la[j] = pa;
+      if (convert) {
+        ly[j] = APPLY_MATRIX (matrix, 0, y, src[p[1]], src[p[3]]);
+        lu[j] = APPLY_MATRIX (matrix, 1, y, src[p[1]], src[p[3]]) - 128;
+        lv[j] = APPLY_MATRIX (matrix, 2, y, src[p[1]], src[p[3]]) - 128;
+      } else {
+        ly[j] = y;
+        lu[j] = src[p[1]] - 128;
+        lv[j] = src[p[3]] - 128;
       }
 
-      src = src_tmp + src_stride;
-    }
-  } else {
-    for (i = 0; i < height; i++) {
-      src_tmp = src;
-
-      for (j = 0; j < width - 1; j += 2) {
-        y = src[p[0]];
-        u = src[p[1]] - 128;
-        v = src[p[3]] - 128;
-
-        a = chroma_keying_yuv (pa, &y, &u, &v, cr, cb,
-            smin, smax, accept_angle_tg, accept_angle_ctg,
-            one_over_kc, kfgy_scale, kg, noise_level2);
-
-        dest[0] = a;
-        dest[1] = y;
-        dest[2] = u + 128;
-        dest[3] = v + 128;
-
-        y = src[p[2]];
-        u = src[p[1]] - 128;
-        v = src[p[3]] - 128;
-
-        a = chroma_keying_yuv (pa, &y, &u, &v, cr, cb,
-            smin, smax, accept_angle_tg, accept_angle_ctg,
-            one_over_kc, kfgy_scale, kg, noise_level2);
-
-        dest[4] = a;
-        dest[5] = y;
-        dest[6] = u + 128;
-        dest[7] = v + 128;
-
-        dest += 8;
+      if (j & 1)
         src += 4;
-      }
-
-      if (j == width - 1) {
-        y = src[p[0]];
-        u = src[p[1]] - 128;
-        v = src[p[3]] - 128;
-
-        a = chroma_keying_yuv (pa, &y, &u, &v, cr, cb,
-            smin, smax, accept_angle_tg, accept_angle_ctg,
-            one_over_kc, kfgy_scale, kg, noise_level2);
+    }
 
-        dest[0] = a;
-        dest[1] = y;
-        dest[2] = u + 128;
-        dest[3] = v + 128;
+    chroma_keying_yuv_line (alpha, la, ly, lu, lv, width, smin, smax);
 
-        dest += 4;
-      }
+    for (j = 0; j < width; j++) {
+      dest[0] = la[j];
+      dest[1] = ly[j];
+      dest[2] = lu[j] + 128;
+      dest[3] = lv[j] + 128;
 
-      src = src_tmp + src_stride;
+      dest += 4;
     }
+
+    src = src_tmp + src_stride;
   }
+
+  g_free (la);
 }
 
 static void
@@ -2158,17 +2208,11 @@ gst_alpha_chroma_key_packed_422_argb (const GstVideoFrame * in_frame,
   guint8 *dest;
   gint width, height;
   gint i, j;
-  gint a, y, u, v;
+  gint y, u, v;
   gint r, g, b;
   gint smin, smax;
   gint pa = CLAMP ((gint) (alpha->alpha * 255), 0, 255);
-  gint8 cb = alpha->cb, cr = alpha->cr;
-  gint8 kg = alpha->kg;
-  guint8 accept_angle_tg = alpha->accept_angle_tg;
-  guint8 accept_angle_ctg = alpha->accept_angle_ctg;
-  guint8 one_over_kc = alpha->one_over_kc;
-  guint8 kfgy_scale = alpha->kfgy_scale;
-  guint noise_level2 = alpha->noise_level2;
+  gint16 *la, *ly, *lu, *lv;
   gint p[4], o[4];
   gint src_stride;
   const guint8 *src_tmp;
@@ -2199,68 +2243,34 @@ gst_alpha_chroma_key_packed_422_argb (const GstVideoFrame * in_frame,
   smin = 128 - alpha->black_sensitivity;
   smax = 128 + alpha->white_sensitivity;
 
+  la = gst_alpha_alloc_lines (width, &ly, &lu, &lv);
+
   for (i = 0; i < height; i++) {
     src_tmp = src;
 
-    for (j = 0; j < width - 1; j += 2) {
-      y = src[o[0]];
-      u = src[o[1]] - 128;
-      v = src[o[3]] - 128;
-
-      a = chroma_keying_yuv (pa, &y, &u, &v, cr, cb,
-          smin, smax, accept_angle_tg, accept_angle_ctg,
-          one_over_kc, kfgy_scale, kg, noise_level2);
-      u += 128;
-      v += 128;
-
-      r = APPLY_MATRIX (matrix, 0, y, u, v);
-      g = APPLY_MATRIX (matrix, 1, y, u, v);
-      b = APPLY_MATRIX (matrix, 2, y, u, v);
-
-      dest[p[0]] = a;
-      dest[p[1]] = CLAMP (r, 0, 255);
-      dest[p[2]] = CLAMP (g, 0, 255);
-      dest[p[3]] = CLAMP (b, 0, 255);
-
-      y = src[o[2]];
-      u = src[o[1]] - 128;
-      v = src[o[3]] - 128;
-
-      a = chroma_keying_yuv (pa, &y, &u, &v, cr, cb,
-          smin, smax, accept_angle_tg, accept_angle_ctg,
-          one_over_kc, kfgy_scale, kg, noise_level2);
-      u += 128;
-      v += 128;
-
-      r = APPLY_MATRIX (matrix, 0, y, u, v);
-      g = APPLY_MATRIX (matrix, 1, y, u, v);
-      b = APPLY_MATRIX (matrix, 2, y, u, v);
-
-      dest[4 + p[0]] = a;
-      dest[4 + p[1]] = CLAMP (r, 0, 255);
-      dest[4 + p[2]] = CLAMP (g, 0, 255);
-      dest[4 + p[3]] = CLAMP (b, 0, 255);
+    /* even pixels take the first, odd pixels the second Y of a macropixel */
+    for (j = 0; j < width; j++) {
+      la[j] = pa;
+      ly[j] = src[o[(j & 1) << 1]];
+      lu[j] = src[o[1]] - 128;
+      lv[j] = src[o[3]] - 128;
 
-      dest += 8;
-      src += 4;
+      if (j & 1)
+        src += 4;
     }
 
-    if (j == width - 1) {
-      y = src[o[0]];
-      u = src[o[1]] - 128;
-      v = src[o[3]] - 128;
+    chroma_keying_yuv_line (alpha, la, ly, lu, lv, width, smin, smax);
 
-      a = chroma_keying_yuv (pa, &y, &u, &v, cr, cb,
-          smin, smax, accept_angle_tg, accept_angle_ctg,
-          one_over_kc, kfgy_scale, kg, noise_level2);
-      u += 128;
-      v += 128;
+    for (j = 0; j < width; j++) {
+      y = ly[j];
+      u = lu[j] + 128;
+      v = lv[j] + 128;
 
       r = APPLY_MATRIX (matrix, 0, y, u, v);
       g = APPLY_MATRIX (matrix, 1, y, u, v);
       b = APPLY_MATRIX (matrix, 2, y, u, v);
 
-      dest[p[0]] = a;
+      dest[p[0]] = la[j];
       dest[p[1]] = CLAMP (r, 0, 255);
       dest[p[2]] = CLAMP (g, 0, 255);
       dest[p[3]] = CLAMP (b, 0, 255);
@@ -2270,6 +2280,8 @@ gst_alpha_chroma_key_packed_422_argb (const GstVideoFrame * in_frame,
 
     src = src_tmp + src_stride;
   }
+
+  g_free (la);
 }
 
 /* Protected with the alpha lock */
@@ -2576,6 +2588,111 @@ gst_alpha_before_transform (GstBaseTransform * btrans, GstBuffer * buf)
     gst_object_sync_values (GST_OBJECT (alpha), timestamp);
 }
 
+/* Slices start on a multiple of this many rows, so that the chroma rows of
+ * the subsampled formats are not split */
+#define SLICE_ALIGN 16
+
+typedef struct
+{
+  GstAlpha *alpha;
+  GstVideoFrame in_frame, out_frame;
+} GstAlphaSlice;
+
+/* Makes @sub a view of the rows @y_start to @y_end of @frame, the process
+ * functions then handle it like a frame of its own */
+static void
+gst_alpha_sub_frame (const GstVideoFrame * frame, GstVideoFrame * sub,
+    gint y_start, gint y_end)
+{
+  const GstVideoFormatInfo *finfo = frame->info.finfo;
+  guint i, c;
+
+  *sub = *frame;
+  sub->info.height = y_end - y_start;
+
+  for (i = 0; i < GST_VIDEO_FRAME_N_PLANES (frame); i++) {
+    /* first component of the plane, the others have the same layout */
+    for (c = 0; c < GST_VIDEO_FRAME_N_COMPONENTS (frame) - 1; c++)
+      if (GST_VIDEO_FORMAT_INFO_PLANE (finfo, c) == i)
+        break;
+
+    sub->data[i] = (guint8 *) frame->data[i] +
+        GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, c, y_start) *
+        GST_VIDEO_FRAME_PLANE_STRIDE (frame, i);
+  }
+}
+
+static void
+gst_alpha_slice_func (gpointer data, gpointer user_data)
+{
+  GstAlphaSlice *slice = data;
+  GstAlpha *alpha = slice->alpha;
+
+  alpha->process (&slice->in_frame, &slice->out_frame, alpha);
+
+  g_mutex_lock (&alpha->slice_lock);
+  if (--alpha->slice_pending == 0)
+    g_cond_signal (&alpha->slice_cond);
+  g_mutex_unlock (&alpha->slice_lock);
+}
+
+/* Splits the frames into slices of rows that are processed on up to
+ * n-threads threads, the calling thread takes the first slice.
+ * Protected with the alpha lock */
+static void
+gst_alpha_process_slices (GstAlpha * alpha, const GstVideoFrame * in_frame,
+    GstVideoFrame * out_frame)
+{
+  GstAlphaSlice *slices;
+  gint height = GST_VIDEO_FRAME_HEIGHT (in_frame);
+  guint n_threads, n_slices, i;
+  gint slice_rows, y_start, y_end;
+
+  n_threads = alpha->n_threads;
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  n_slices = MIN (n_threads, height / SLICE_ALIGN);
+  if (n_slices > 1 && alpha->slice_pool == NULL) {
+    alpha->slice_pool =
+        g_thread_pool_new (gst_alpha_slice_func, NULL, n_slices - 1, FALSE,
+        NULL);
+    if (alpha->slice_pool == NULL)
+      n_slices = 1;
+  } else if (n_slices > 1 &&
+      g_thread_pool_get_max_threads (alpha->slice_pool) < n_slices - 1) {
+    g_thread_pool_set_max_threads (alpha->slice_pool, n_slices - 1, NULL);
+  }
+
+  if (n_slices <= 1) {
+    alpha->process (in_frame, out_frame, alpha);
+    return;
+  }
+
+  slice_rows = GST_ROUND_UP_N ((height + n_slices - 1) / n_slices, SLICE_ALIGN);
+  n_slices = (height + slice_rows - 1) / slice_rows;
+  slices = g_newa (GstAlphaSlice, n_slices);
+  for (i = 0; i < n_slices; i++) {
+    y_start = i * slice_rows;
+    y_end = MIN (y_start + slice_rows, height);
+
+    slices[i].alpha = alpha;
+    gst_alpha_sub_frame (in_frame, &slices[i].in_frame, y_start, y_end);
+    gst_alpha_sub_frame (out_frame, &slices[i].out_frame, y_start, y_end);
+  }
+
+  alpha->slice_pending = n_slices - 1;
+  for (i = 1; i < n_slices; i++)
+    g_thread_pool_push (alpha->slice_pool, &slices[i], NULL);
+
+  alpha->process (&slices[0].in_frame, &slices[0].out_frame, alpha);
+
+  g_mutex_lock (&alpha->slice_lock);
+  while (alpha->slice_pending > 0)
+    g_cond_wait (&alpha->slice_cond, &alpha->slice_lock);
+  g_mutex_unlock (&alpha->slice_lock);
+}
+
 static GstFlowReturn
 gst_alpha_transform_frame (GstVideoFilter * filter, GstVideoFrame * in_frame,
     GstVideoFrame * out_frame)
@@ -2587,7 +2704,7 @@ gst_alpha_transform_frame (GstVideoFilter * filter, GstVideoFrame * in_frame,
   if (G_UNLIKELY (!alpha->process))
     goto not_negotiated;
 
-  alpha->process (in_frame, out_frame, alpha);
+  gst_alpha_process_slices (alpha, in_frame, out_frame);
 
   GST_ALPHA_UNLOCK (alpha);
 
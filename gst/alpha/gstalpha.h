@@ -89,6 +89,8 @@ struct _GstAlpha
 
   gboolean prefer_passthrough;
 
+  guint n_threads;
+
   /* processing function */
   void (*process) (const GstVideoFrame *in_frame, GstVideoFrame *out_frame, GstAlpha *alpha);
 
@@ -100,6 +102,12 @@ struct _GstAlpha
   guint8 one_over_kc;
   guint8 kfgy_scale;
   guint noise_level2;
+
+  /* slice threading */
+  GThreadPool *slice_pool;
+  GMutex slice_lock;
+  GCond slice_cond;
+  guint slice_pending;
 };
 
 struct _GstAlphaClass
@@ -199,6 +199,17 @@ ape_demux_parse_tags (const guint8 * data, gint size)
 
     /* read */
     tag = g_strndup ((gchar *) data + 8, n - 9);
+
+    /* Items without a matching GStreamer tag would only be dropped below, so
+     * don't copy their value first. These include binary items like cover
+     * art, which can easily be several megabytes. */
+    if (g_ascii_strcasecmp (tag, "media") != 0 &&
+        !ape_demux_get_gst_tag_from_tag (tag, &gst_tag, &gst_tag_type)) {
+      GST_LOG ("skipping tag [%s] with %u bytes", tag, len);
+      g_free (tag);
+      goto next_tag;
+    }
+
     val = g_strndup ((gchar *) data + n, len);
 
     GST_LOG ("tag [%s], val[%s]", tag, val);
@@ -436,12 +436,15 @@ generate_coefficients (GstAudioChebBand * filter, const GstAudioInfo * info)
   /* Calculate coefficients for the chebyshev filter */
   {
     gint np = filter->poles;
-    gdouble *a, *b;
+    gdouble *a, *b, *sections, *biquads, norm;
     gint i, p;
 
     a = g_new0 (gdouble, np + 5);
     b = g_new0 (gdouble, np + 5);
 
+    /* b0-b4 and a1-a4 of every fourth order section */
+    sections = g_new0 (gdouble, 9 * (np / 4));
+
     /* Calculate transfer function coefficients */
     a[4] = 1.0;
     b[4] = 1.0;
@@ -454,6 +457,16 @@ generate_coefficients (GstAudioChebBand * filter, const GstAudioInfo * info)
       generate_biquad_coefficients (filter, p, rate,
           &b0, &b1, &b2, &b3, &b4, &a1, &a2, &a3, &a4);
 
+      sections[9 * (p - 1) + 0] = b0;
+      sections[9 * (p - 1) + 1] = b1;
+      sections[9 * (p - 1) + 2] = b2;
+      sections[9 * (p - 1) + 3] = b3;
+      sections[9 * (p - 1) + 4] = b4;
+      sections[9 * (p - 1) + 5] = a1;
+      sections[9 * (p - 1) + 6] = a2;
+      sections[9 * (p - 1) + 7] = a3;
+      sections[9 * (p - 1) + 8] = a4;
+
       memcpy (ta, a, sizeof (gdouble) * (np + 5));
       memcpy (tb, b, sizeof (gdouble) * (np + 5));
 
@@ -494,6 +507,7 @@ generate_coefficients (GstAudioChebBand * filter, const GstAudioInfo * info)
           -1.0, 0.0);
 
       gain1 = sqrt (gain1 * gain2);
+      norm = gain1;
 
       for (i = 0; i <= np; i++) {
         b[i] /= gain1;
@@ -509,13 +523,41 @@ generate_coefficients (GstAudioChebBand * filter, const GstAudioInfo * info)
           gst_audio_fx_base_iir_filter_calculate_gain (a, np + 1, b, np + 1, zr,
           zi);
 
+      norm = gain;
+
       for (i = 0; i <= np; i++) {
         b[i] /= gain;
       }
     }
 
-    gst_audio_fx_base_iir_filter_set_coefficients (GST_AUDIO_FX_BASE_IIR_FILTER
-        (filter), a, np + 1, b, np + 1);
+    /* Run the filter as a cascade of second order sections, which is much
+     * more robust than the direct form for many poles. Every fourth order
+     * section is split into two by finding its roots. */
+    biquads = g_new0 (gdouble, 5 * (np / 2));
+    for (p = 0; p < np / 4; p++) {
+      gdouble *sec = sections + 9 * p;
+      gdouble sa[5] = { 1.0, -sec[5], -sec[6], -sec[7], -sec[8] };
+
+      if (!gst_audio_fx_base_iir_filter_factor_biquads (sa, sec, 4,
+              biquads + 10 * p))
+        break;
+    }
+    g_free (sections);
+
+    if (p == np / 4) {
+      for (i = 0; i < 3; i++)
+        biquads[i] /= norm;
+      gst_audio_fx_base_iir_filter_set_biquads (GST_AUDIO_FX_BASE_IIR_FILTER
+          (filter), biquads, np / 2);
+    } else {
+      GST_WARNING_OBJECT (filter, "failed to factor the filter, using the "
+          "direct form");
+      g_free (biquads);
+      gst_audio_fx_base_iir_filter_set_coefficients
+          (GST_AUDIO_FX_BASE_IIR_FILTER (filter), g_memdup (a,
+              sizeof (gdouble) * (np + 1)), np + 1, g_memdup (b,
+              sizeof (gdouble) * (np + 1)), np + 1);
+    }
 
     GST_LOG_OBJECT (filter,
         "Generated IIR coefficients for the Chebyshev filter");
@@ -554,6 +596,9 @@ generate_coefficients (GstAudioChebBand * filter, const GstAudioInfo * info)
     GST_LOG_OBJECT (filter, "%.2f dB gain @ %dHz",
         20.0 * log10 (gst_audio_fx_base_iir_filter_calculate_gain (a, np + 1, b,
                 np + 1, -1.0, 0.0)), rate / 2);
+
+    g_free (a);
+    g_free (b);
   }
 }
 
@@ -26,6 +26,14 @@
  * a expander does the same for all samples below a specific threshold. If
  * soft-knee mode is selected the ratio is applied smoothly.
  *
+ * By default every sample is shaped on its own, which distorts the waveform
+ * when the threshold is crossed within a period. With a non-zero
+ * #GstAudioDynamic:lookahead the peak of each block of that length is taken
+ * as the envelope instead, and the gain the transfer curve gives for it is
+ * applied to the whole block, ramping linearly between blocks. The ramp
+ * towards a lower gain already starts in the preceding block, so that peaks
+ * are anticipated; this is done within each buffer and adds no latency.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -65,9 +73,12 @@ enum
   PROP_CHARACTERISTICS,
   PROP_MODE,
   PROP_THRESHOLD,
-  PROP_RATIO
+  PROP_RATIO,
+  PROP_LOOKAHEAD
 };
 
+#define DEFAULT_LOOKAHEAD 0
+
 #define ALLOWED_CAPS \
     "audio/x-raw,"                                                \
     " format=(string) {"GST_AUDIO_NE(S16)","GST_AUDIO_NE(F32)"}," \
@@ -109,6 +120,11 @@ static void gst_audio_dynamic_transform_soft_knee_expander_int (GstAudioDynamic
 static void
 gst_audio_dynamic_transform_soft_knee_expander_float (GstAudioDynamic * filter,
     gfloat * data, guint num_samples);
+static void gst_audio_dynamic_transform_envelope_int (GstAudioDynamic * filter,
+    gint16 * data, guint num_samples);
+static void
+gst_audio_dynamic_transform_envelope_float (GstAudioDynamic * filter,
+    gfloat * data, guint num_samples);
 
 static GstAudioDynamicProcessFunc process_functions[] = {
   (GstAudioDynamicProcessFunc)
@@ -129,6 +145,13 @@ static GstAudioDynamicProcessFunc process_functions[] = {
   gst_audio_dynamic_transform_soft_knee_expander_float
 };
 
+static GstAudioDynamicProcessFunc envelope_functions[] = {
+  (GstAudioDynamicProcessFunc)
+      gst_audio_dynamic_transform_envelope_int,
+  (GstAudioDynamicProcessFunc)
+  gst_audio_dynamic_transform_envelope_float
+};
+
 enum
 {
   CHARACTERISTICS_HARD_KNEE = 0,
@@ -193,6 +216,11 @@ gst_audio_dynamic_set_process_function (GstAudioDynamic * filter,
   func_index += (filter->characteristics == CHARACTERISTICS_HARD_KNEE) ? 0 : 2;
   func_index += (GST_AUDIO_INFO_FORMAT (info) == GST_AUDIO_FORMAT_F32) ? 1 : 0;
 
+  if (filter->lookahead > 0) {
+    filter->process = envelope_functions[func_index % 2];
+    return TRUE;
+  }
+
   if (func_index >= 0 && func_index < 8) {
     filter->process = process_functions[func_index];
     return TRUE;
@@ -245,6 +273,20 @@ gst_audio_dynamic_class_init (GstAudioDynamicClass * klass)
           1.0,
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAudioDynamic:lookahead:
+   *
+   * Length of the blocks the envelope is taken over, in nanoseconds. With 0
+   * every sample is shaped on its own.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_LOOKAHEAD,
+      g_param_spec_uint64 ("lookahead", "Lookahead",
+          "Length of the blocks the envelope is taken over in ns "
+          "(0 = shape each sample)", 0, GST_SECOND, DEFAULT_LOOKAHEAD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "Dynamic range controller", "Filter/Effect/Audio",
       "Compressor and Expander", "Sebastian Dröge <slomo@circular-chaos.org>");
@@ -269,6 +311,8 @@ gst_audio_dynamic_init (GstAudioDynamic * filter)
   filter->threshold = 0.0;
   filter->characteristics = CHARACTERISTICS_HARD_KNEE;
   filter->mode = MODE_COMPRESSOR;
+  filter->lookahead = DEFAULT_LOOKAHEAD;
+  filter->env_gain = 1.0;
   gst_base_transform_set_in_place (GST_BASE_TRANSFORM (filter), TRUE);
   gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM (filter), TRUE);
 }
@@ -296,6 +340,11 @@ gst_audio_dynamic_set_property (GObject * object, guint prop_id,
     case PROP_RATIO:
       filter->ratio = g_value_get_float (value);
       break;
+    case PROP_LOOKAHEAD:
+      filter->lookahead = g_value_get_uint64 (value);
+      gst_audio_dynamic_set_process_function (filter,
+          GST_AUDIO_FILTER_INFO (filter));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -321,6 +370,9 @@ gst_audio_dynamic_get_property (GObject * object, guint prop_id,
     case PROP_RATIO:
       g_value_set_float (value, filter->ratio);
       break;
+    case PROP_LOOKAHEAD:
+      g_value_set_uint64 (value, filter->lookahead);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -336,6 +388,7 @@ gst_audio_dynamic_setup (GstAudioFilter * base, const GstAudioInfo * info)
   gboolean ret = TRUE;
 
   ret = gst_audio_dynamic_set_process_function (filter, info);
+  filter->env_gain = 1.0;
 
   return ret;
 }
@@ -344,9 +397,10 @@ static void
 gst_audio_dynamic_transform_hard_knee_compressor_int (GstAudioDynamic * filter,
     gint16 * data, guint num_samples)
 {
-  glong val;
-  glong thr_p = filter->threshold * G_MAXINT16;
-  glong thr_n = filter->threshold * G_MININT16;
+  gint val, knee;
+  gfloat ratio = filter->ratio;
+  gint thr_p = filter->threshold * G_MAXINT16;
+  gint thr_n = filter->threshold * G_MININT16;
 
   /* Nothing to do for us if ratio is 1.0 or if the threshold
    * equals 1.0. */
@@ -355,12 +409,10 @@ gst_audio_dynamic_transform_hard_knee_compressor_int (GstAudioDynamic * filter,
 
   for (; num_samples; num_samples--) {
     val = *data;
+    knee = CLAMP (val, thr_n, thr_p);
 
-    if (val > thr_p) {
-      val = thr_p + (val - thr_p) * filter->ratio;
-    } else if (val < thr_n) {
-      val = thr_n + (val - thr_n) * filter->ratio;
-    }
+    /* the part beyond the threshold is scaled, nothing happens below it */
+    val = knee + (val - knee) * ratio;
     *data++ = (gint16) CLAMP (val, G_MININT16, G_MAXINT16);
   }
 }
@@ -369,7 +421,8 @@ static void
 gst_audio_dynamic_transform_hard_knee_compressor_float (GstAudioDynamic *
     filter, gfloat * data, guint num_samples)
 {
-  gdouble val, threshold = filter->threshold;
+  gdouble val, knee, threshold = filter->threshold;
+  gfloat ratio = filter->ratio;
 
   /* Nothing to do for us if ratio == 1.0.
    * As float values can be above 1.0 we have to do something
@@ -379,12 +432,9 @@ gst_audio_dynamic_transform_hard_knee_compressor_float (GstAudioDynamic *
 
   for (; num_samples; num_samples--) {
     val = *data;
+    knee = CLAMP (val, -threshold, threshold);
 
-    if (val > threshold) {
-      val = threshold + (val - threshold) * filter->ratio;
-    } else if (val < -threshold) {
-      val = -threshold + (val + threshold) * filter->ratio;
-    }
+    val = knee + (val - knee) * ratio;
     *data++ = (gfloat) val;
   }
 }
@@ -393,11 +443,13 @@ static void
 gst_audio_dynamic_transform_soft_knee_compressor_int (GstAudioDynamic * filter,
     gint16 * data, guint num_samples)
 {
-  glong val;
-  glong thr_p = filter->threshold * G_MAXINT16;
-  glong thr_n = filter->threshold * G_MININT16;
+  gint val;
+  gint thr_p = filter->threshold * G_MAXINT16;
+  gint thr_n = filter->threshold * G_MININT16;
   gdouble a_p, b_p, c_p;
   gdouble a_n, b_n, c_n;
+  gdouble a, b, c;
+  gboolean above, below;
 
   /* Nothing to do for us if ratio is 1.0 or if the threshold
    * equals 1.0. */
@@ -427,14 +479,23 @@ gst_audio_dynamic_transform_soft_knee_compressor_int (GstAudioDynamic * filter,
   b_n = (filter->ratio * thr_n - G_MININT16) / (thr_n - G_MININT16);
   c_n = thr_n * (1 - b_n - a_n * thr_n);
 
+  /* The identity below the threshold is the polynomial with a = c = 0 and
+   * b = 1. Only the coefficients are picked per sample and the polynomial is
+   * always evaluated, which keeps the loop free of branches. The selects
+   * override the identity one region after the other, as nested ones get
+   * turned back into branches by the compiler. */
   for (; num_samples; num_samples--) {
     val = *data;
-
-    if (val > thr_p) {
-      val = a_p * val * val + b_p * val + c_p;
-    } else if (val < thr_n) {
-      val = a_n * val * val + b_n * val + c_n;
-    }
+    above = (val > thr_p);
+    below = (val < thr_n);
+    a = below ? a_n : 0.0;
+    b = below ? b_n : 1.0;
+    c = below ? c_n : 0.0;
+    a = above ? a_p : a;
+    b = above ? b_p : b;
+    c = above ? c_p : c;
+
+    val = a * val * val + b * val + c;
     *data++ = (gint16) CLAMP (val, G_MININT16, G_MAXINT16);
   }
 }
@@ -498,10 +559,13 @@ static void
 gst_audio_dynamic_transform_hard_knee_expander_int (GstAudioDynamic * filter,
     gint16 * data, guint num_samples)
 {
-  glong val;
-  glong thr_p = filter->threshold * G_MAXINT16;
-  glong thr_n = filter->threshold * G_MININT16;
+  gint val;
+  gfloat ratio = filter->ratio;
+  gint thr_p = filter->threshold * G_MAXINT16;
+  gint thr_n = filter->threshold * G_MININT16;
   gdouble zero_p, zero_n;
+  gfloat m, k, k_p, k_n;
+  gboolean in_p, in_n, in_zero;
 
   /* Nothing to do for us here if threshold equals 0.0
    * or ratio equals 1.0 */
@@ -521,16 +585,22 @@ gst_audio_dynamic_transform_hard_knee_expander_int (GstAudioDynamic * filter,
   if (zero_n > 0.0)
     zero_n = 0.0;
 
+  k_p = thr_p * (1 - ratio);
+  k_n = thr_n * (1 - ratio);
+
+  /* Every region is a line m * x + k, only the slope and offset are picked
+   * per sample */
   for (; num_samples; num_samples--) {
     val = *data;
-
-    if (val < thr_p && val > zero_p) {
-      val = filter->ratio * val + thr_p * (1 - filter->ratio);
-    } else if ((val <= zero_p && val > 0) || (val >= zero_n && val < 0)) {
-      val = 0;
-    } else if (val > thr_n && val < zero_n) {
-      val = filter->ratio * val + thr_n * (1 - filter->ratio);
-    }
+    in_p = (val < thr_p) & (val > zero_p);
+    in_n = (val > thr_n) & (val < zero_n);
+    in_zero = ((val <= zero_p) & (val > 0)) | ((val >= zero_n) & (val < 0));
+    m = in_zero ? 0.0f : 1.0f;
+    m = (in_p | in_n) ? ratio : m;
+    k = in_n ? k_n : 0.0f;
+    k = in_p ? k_p : k;
+
+    val = m * val + k;
     *data++ = (gint16) CLAMP (val, G_MININT16, G_MAXINT16);
   }
 }
@@ -540,6 +610,9 @@ gst_audio_dynamic_transform_hard_knee_expander_float (GstAudioDynamic * filter,
     gfloat * data, guint num_samples)
 {
   gdouble val, threshold = filter->threshold, zero;
+  gdouble ratio = filter->ratio;
+  gdouble m, k, k_p, k_n;
+  gboolean in_p, in_n, in_zero;
 
   /* Nothing to do for us here if threshold equals 0.0
    * or ratio equals 1.0 */
@@ -555,16 +628,20 @@ gst_audio_dynamic_transform_hard_knee_expander_float (GstAudioDynamic * filter,
   if (zero < 0.0)
     zero = 0.0;
 
+  k_p = threshold * (1.0 - ratio);
+  k_n = -threshold * (1.0 - ratio);
+
   for (; num_samples; num_samples--) {
     val = *data;
-
-    if (val < threshold && val > zero) {
-      val = filter->ratio * val + threshold * (1.0 - filter->ratio);
-    } else if ((val <= zero && val > 0.0) || (val >= -zero && val < 0.0)) {
-      val = 0.0;
-    } else if (val > -threshold && val < -zero) {
-      val = filter->ratio * val - threshold * (1.0 - filter->ratio);
-    }
+    in_p = (val < threshold) & (val > zero);
+    in_n = (val > -threshold) & (val < -zero);
+    in_zero = ((val <= zero) & (val > 0.0)) | ((val >= -zero) & (val < 0.0));
+    m = in_zero ? 0.0 : 1.0;
+    m = (in_p | in_n) ? ratio : m;
+    k = in_n ? k_n : 0.0;
+    k = in_p ? k_p : k;
+
+    val = m * val + k;
     *data++ = (gfloat) val;
   }
 }
@@ -573,13 +650,15 @@ static void
 gst_audio_dynamic_transform_soft_knee_expander_int (GstAudioDynamic * filter,
     gint16 * data, guint num_samples)
 {
-  glong val;
-  glong thr_p = filter->threshold * G_MAXINT16;
-  glong thr_n = filter->threshold * G_MININT16;
+  gint val;
+  gint thr_p = filter->threshold * G_MAXINT16;
+  gint thr_n = filter->threshold * G_MININT16;
   gdouble zero_p, zero_n;
   gdouble a_p, b_p, c_p;
   gdouble a_n, b_n, c_n;
+  gdouble a, b, c;
   gdouble r2;
+  gboolean in_p, in_n, in_zero;
 
   /* Nothing to do for us here if threshold equals 0.0
    * or ratio equals 1.0 */
@@ -617,16 +696,22 @@ gst_audio_dynamic_transform_soft_knee_expander_int (GstAudioDynamic * filter,
   b_n = (1.0 + r2) / 2.0;
   c_n = thr_n * (1.0 - b_n - a_n * thr_n);
 
+  /* As for the compressor the coefficients are picked per sample, with
+   * b = 0 below the zero crossing and b = 1 above the threshold */
   for (; num_samples; num_samples--) {
     val = *data;
-
-    if (val < thr_p && val > zero_p) {
-      val = a_p * val * val + b_p * val + c_p;
-    } else if ((val <= zero_p && val > 0) || (val >= zero_n && val < 0)) {
-      val = 0;
-    } else if (val > thr_n && val < zero_n) {
-      val = a_n * val * val + b_n * val + c_n;
-    }
+    in_p = (val < thr_p) & (val > zero_p);
+    in_n = (val > thr_n) & (val < zero_n);
+    in_zero = ((val <= zero_p) & (val > 0)) | ((val >= zero_n) & (val < 0));
+    a = in_n ? a_n : 0.0;
+    b = in_zero ? 0.0 : 1.0;
+    b = in_n ? b_n : b;
+    c = in_n ? c_n : 0.0;
+    a = in_p ? a_p : a;
+    b = in_p ? b_p : b;
+    c = in_p ? c_p : c;
+
+    val = a * val * val + b * val + c;
     *data++ = (gint16) CLAMP (val, G_MININT16, G_MAXINT16);
   }
 }
@@ -635,12 +720,14 @@ static void
 gst_audio_dynamic_transform_soft_knee_expander_float (GstAudioDynamic * filter,
     gfloat * data, guint num_samples)
 {
-  gdouble val;
+  gdouble val, mag;
   gdouble threshold = filter->threshold;
   gdouble zero;
   gdouble a_p, b_p, c_p;
   gdouble a_n, b_n, c_n;
+  gdouble a, b, c;
   gdouble r2;
+  gboolean neg, in_knee, in_zero;
 
   /* Nothing to do for us here if threshold equals 0.0
    * or ratio equals 1.0 */
@@ -674,20 +761,139 @@ gst_audio_dynamic_transform_soft_knee_expander_float (GstAudioDynamic * filter,
   b_n = (1.0 + r2) / 2.0;
   c_n = -threshold * (1.0 - b_n + a_n * threshold);
 
+  /* Evaluated on the magnitude, as the negative half of the curve is the
+   * positive one mirrored with exactly negated coefficients */
   for (; num_samples; num_samples--) {
     val = *data;
-
-    if (val < threshold && val > zero) {
-      val = a_p * val * val + b_p * val + c_p;
-    } else if ((val <= zero && val > 0.0) || (val >= -zero && val < 0.0)) {
-      val = 0.0;
-    } else if (val > -threshold && val < -zero) {
-      val = a_n * val * val + b_n * val + c_n;
-    }
+    neg = (val < 0.0);
+    mag = neg ? -val : val;
+    in_knee = (mag < threshold) & (mag > zero);
+    in_zero = (mag <= zero) & (mag > 0.0);
+    a = in_knee ? a_p : 0.0;
+    b = in_zero ? 0.0 : 1.0;
+    b = in_knee ? b_p : b;
+    c = in_knee ? c_p : 0.0;
+
+    mag = a * mag * mag + b * mag + c;
+    val = neg ? -mag : mag;
     *data++ = (gfloat) val;
   }
 }
 
+/* Gain the transfer curve gives for a peak level, in the float range */
+static gdouble
+gst_audio_dynamic_level_gain (GstAudioDynamic * filter, gdouble level)
+{
+  gint func_index;
+  gfloat val = level;
+
+  if (level <= 0.0)
+    return 1.0;
+
+  func_index = (filter->mode == MODE_COMPRESSOR) ? 0 : 4;
+  func_index += (filter->characteristics == CHARACTERISTICS_HARD_KNEE) ? 0 : 2;
+  process_functions[func_index + 1] (filter, (guint8 *) & val, 1);
+
+  return val / level;
+}
+
+static guint
+gst_audio_dynamic_block_frames (GstAudioDynamic * filter)
+{
+  guint64 frames = gst_util_uint64_scale_int (filter->lookahead,
+      GST_AUDIO_FILTER_RATE (filter), GST_SECOND);
+
+  return CLAMP (frames, 1, G_MAXUINT);
+}
+
+#define STORE_INT(val) ((gint16) CLAMP (val, G_MININT16, G_MAXINT16))
+#define STORE_FLOAT(val) ((gfloat) (val))
+
+/* The gain for each block is taken from its peak over all channels. Each
+ * block ramps from where the previous one ended to the lower of its own gain
+ * and that of the following block, if that one is in the same buffer. */
+#define DEFINE_ENVELOPE_FUNC(name, type, norm, store)                         \
+static gdouble                                                                \
+gst_audio_dynamic_block_peak_##name (const type * data, guint frames,        \
+    guint channels, guint fstride, guint cstride)                             \
+{                                                                             \
+  gdouble peak = 0.0, val;                                                    \
+  guint i, c;                                                                 \
+                                                                              \
+  for (c = 0; c < channels; c++) {                                            \
+    const type *d = data + c * cstride;                                       \
+                                                                              \
+    for (i = 0; i < frames; i++) {                                            \
+      val = ABS ((gdouble) d[i * fstride]);                                   \
+      peak = MAX (peak, val);                                                 \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  return peak / norm;                                                         \
+}                                                                             \
+                                                                              \
+static void                                                                   \
+gst_audio_dynamic_transform_envelope_##name (GstAudioDynamic * filter,       \
+    type * data, guint num_samples)                                           \
+{                                                                             \
+  guint channels = GST_AUDIO_FILTER_CHANNELS (filter);                        \
+  guint frames = num_samples / channels;                                      \
+  guint block, n, next_n, i, c, fstride, cstride;                             \
+  gdouble gain, next_gain, start, end, g, val;                                \
+  type *d;                                                                    \
+                                                                              \
+  if (frames == 0)                                                            \
+    return;                                                                   \
+                                                                              \
+  if (GST_AUDIO_INFO_LAYOUT (GST_AUDIO_FILTER_INFO (filter)) ==               \
+      GST_AUDIO_LAYOUT_NON_INTERLEAVED) {                                     \
+    fstride = 1;                                                              \
+    cstride = frames;                                                         \
+  } else {                                                                    \
+    fstride = channels;                                                       \
+    cstride = 1;                                                              \
+  }                                                                           \
+                                                                              \
+  block = gst_audio_dynamic_block_frames (filter);                            \
+  n = MIN (block, frames);                                                    \
+  next_gain = gst_audio_dynamic_level_gain (filter,                           \
+      gst_audio_dynamic_block_peak_##name (data, n, channels, fstride,       \
+          cstride));                                                          \
+                                                                              \
+  while (frames > 0) {                                                        \
+    gain = next_gain;                                                         \
+    start = MIN (filter->env_gain, gain);                                     \
+    end = gain;                                                               \
+                                                                              \
+    if (frames > n) {                                                         \
+      next_n = MIN (block, frames - n);                                       \
+      next_gain = gst_audio_dynamic_level_gain (filter,                       \
+          gst_audio_dynamic_block_peak_##name (data + n * fstride, next_n,   \
+              channels, fstride, cstride));                                   \
+      end = MIN (gain, next_gain);                                            \
+    } else {                                                                  \
+      next_n = 0;                                                             \
+    }                                                                         \
+                                                                              \
+    for (c = 0; c < channels; c++) {                                          \
+      d = data + c * cstride;                                                 \
+      for (i = 0; i < n; i++) {                                               \
+        g = start + (end - start) * i / n;                                    \
+        val = d[i * fstride] * g;                                             \
+        d[i * fstride] = store (val);                                         \
+      }                                                                       \
+    }                                                                         \
+                                                                              \
+    filter->env_gain = end;                                                   \
+    data += n * fstride;                                                      \
+    frames -= n;                                                              \
+    n = next_n;                                                               \
+  }                                                                           \
+}
+
+DEFINE_ENVELOPE_FUNC (int, gint16, G_MAXINT16, STORE_INT);
+DEFINE_ENVELOPE_FUNC (float, gfloat, 1.0, STORE_FLOAT);
+
 /* GstBaseTransform vmethod implementations */
 static GstFlowReturn
 gst_audio_dynamic_transform_ip (GstBaseTransform * base, GstBuffer * buf)
@@ -51,6 +51,10 @@ struct _GstAudioDynamic
   gint mode;
   gfloat threshold;
   gfloat ratio;
+  guint64 lookahead;
+
+  /* gain at the end of the last block in envelope mode */
+  gdouble env_gain;
 };
 
 struct _GstAudioDynamicClass
@@ -32,6 +32,11 @@
  * will be used. This can only be set before going to the PAUSED or PLAYING
  * state and will be set to the current delay by default.
  *
+ * Additional echoes can be added with the tap-delays and tap-intensities
+ * properties. They are read from the same delay line in the same pass, which
+ * is a lot cheaper than chaining several audioecho elements without
+ * feedback, each with its own copy of the delay line.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -41,6 +46,10 @@
  * </refsect2>
  */
 
+/* FIXME 0.11: suppress warnings for deprecated API such as GValueArray
+ * with newer GLib versions (>= 2.31.0) */
+#define GLIB_DISABLE_DEPRECATION_WARNINGS
+
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
@@ -61,7 +70,9 @@ enum
   PROP_DELAY,
   PROP_MAX_DELAY,
   PROP_INTENSITY,
-  PROP_FEEDBACK
+  PROP_FEEDBACK,
+  PROP_TAP_DELAYS,
+  PROP_TAP_INTENSITIES
 };
 
 #define ALLOWED_CAPS \
@@ -135,6 +146,40 @@ gst_audio_echo_class_init (GstAudioEchoClass * klass)
           0.0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS
           | GST_PARAM_CONTROLLABLE));
 
+  /**
+   * GstAudioEcho:tap-delays:
+   *
+   * Delays of additional echoes in nanoseconds, one for each value of
+   * #GstAudioEcho:tap-intensities. The taps are read from the delay line
+   * without feedback. In PAUSED or PLAYING state they are limited to
+   * #GstAudioEcho:max-delay, otherwise the maximum delay is raised to fit
+   * them.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_TAP_DELAYS,
+      g_param_spec_value_array ("tap-delays", "Tap Delays",
+          "Delays of additional echoes in nanoseconds",
+          g_param_spec_uint64 ("tap-delay", "Tap Delay",
+              "Delay of an additional echo in nanoseconds", 1, G_MAXUINT64,
+              1, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAudioEcho:tap-intensities:
+   *
+   * Intensities of the additional echoes set with #GstAudioEcho:tap-delays.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_TAP_INTENSITIES,
+      g_param_spec_value_array ("tap-intensities", "Tap Intensities",
+          "Intensities of additional echoes",
+          g_param_spec_float ("tap-intensity", "Tap Intensity",
+              "Intensity of an additional echo", 0.0, 1.0, 0.0,
+              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "Audio echo",
       "Filter/Effect/Audio",
       "Adds an echo or reverb effect to an audio stream",
@@ -172,11 +217,51 @@ gst_audio_echo_finalize (GObject * object)
   g_free (self->buffer);
   self->buffer = NULL;
 
+  if (self->tap_delays)
+    g_value_array_free (self->tap_delays);
+  self->tap_delays = NULL;
+  if (self->tap_intensities)
+    g_value_array_free (self->tap_intensities);
+  self->tap_intensities = NULL;
+  g_free (self->tap_frames);
+  self->tap_frames = NULL;
+  g_free (self->tap_gains);
+  self->tap_gains = NULL;
+
   g_mutex_clear (&self->lock);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+/* called with the lock */
+static void
+gst_audio_echo_update_taps (GstAudioEcho * self)
+{
+  guint rate = GST_AUDIO_FILTER_RATE (self);
+  guint i, n_taps = 0;
+
+  if (self->tap_delays && self->tap_intensities)
+    n_taps = MIN (self->tap_delays->n_values, self->tap_intensities->n_values);
+
+  if (n_taps != self->n_taps) {
+    g_free (self->tap_frames);
+    g_free (self->tap_gains);
+    self->tap_frames = g_new0 (guint, n_taps);
+    self->tap_gains = g_new0 (gdouble, n_taps);
+    self->n_taps = n_taps;
+  }
+
+  for (i = 0; i < n_taps; i++) {
+    guint64 delay;
+
+    delay = g_value_get_uint64 (g_value_array_get_nth (self->tap_delays, i));
+    self->tap_frames[i] =
+        MAX (gst_util_uint64_scale (delay, rate, GST_SECOND), 1);
+    self->tap_gains[i] =
+        g_value_get_float (g_value_array_get_nth (self->tap_intensities, i));
+  }
+}
+
 static void
 gst_audio_echo_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -238,6 +323,40 @@ gst_audio_echo_set_property (GObject * object, guint prop_id,
       g_mutex_unlock (&self->lock);
       break;
     }
+    case PROP_TAP_DELAYS:{
+      guint64 max_tap_delay = 0;
+      guint i;
+
+      g_mutex_lock (&self->lock);
+      if (self->tap_delays)
+        g_value_array_free (self->tap_delays);
+      self->tap_delays = g_value_dup_boxed (value);
+
+      for (i = 0; self->tap_delays && i < self->tap_delays->n_values; i++)
+        max_tap_delay = MAX (max_tap_delay,
+            g_value_get_uint64 (g_value_array_get_nth (self->tap_delays, i)));
+
+      if (max_tap_delay > self->max_delay) {
+        if (GST_STATE (self) > GST_STATE_READY)
+          GST_WARNING_OBJECT (self, "Tap delay (%" GST_TIME_FORMAT ") "
+              "is larger than maximum delay (%" GST_TIME_FORMAT ")",
+              GST_TIME_ARGS (max_tap_delay), GST_TIME_ARGS (self->max_delay));
+        else
+          self->max_delay = max_tap_delay;
+      }
+      gst_audio_echo_update_taps (self);
+      g_mutex_unlock (&self->lock);
+      break;
+    }
+    case PROP_TAP_INTENSITIES:{
+      g_mutex_lock (&self->lock);
+      if (self->tap_intensities)
+        g_value_array_free (self->tap_intensities);
+      self->tap_intensities = g_value_dup_boxed (value);
+      gst_audio_echo_update_taps (self);
+      g_mutex_unlock (&self->lock);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -271,6 +390,16 @@ gst_audio_echo_get_property (GObject * object, guint prop_id,
       g_value_set_float (value, self->feedback);
       g_mutex_unlock (&self->lock);
       break;
+    case PROP_TAP_DELAYS:
+      g_mutex_lock (&self->lock);
+      g_value_set_boxed (value, self->tap_delays);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_TAP_INTENSITIES:
+      g_mutex_lock (&self->lock);
+      g_value_set_boxed (value, self->tap_intensities);
+      g_mutex_unlock (&self->lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -322,40 +451,87 @@ gst_audio_echo_stop (GstBaseTransform * base)
   return TRUE;
 }
 
+/* Processing goes in spans of frames for which the write position, the two
+ * interpolated echo positions and all taps are contiguous in the ring, and
+ * which are short enough that nothing read in a span was written in the same
+ * span.  The inner loops are then plain array operations without any
+ * wrapping that the compiler can vectorize. */
 #define TRANSFORM_FUNC(name, type) \
 static void \
+gst_audio_echo_mix_##name (type * data, type * out, const type * echo0, \
+    const type * echo1, guint n, gdouble echo_off, gdouble intensity, \
+    gdouble feedback) \
+{ \
+  guint i; \
+  \
+  for (i = 0; i < n; i++) { \
+    gdouble in = data[i]; \
+    gdouble e0 = echo0[i]; \
+    gdouble echo = e0 + (echo1[i] - e0) * echo_off; \
+    \
+    data[i] = in + intensity * echo; \
+    out[i] = in + feedback * echo; \
+  } \
+} \
+\
+static void \
+gst_audio_echo_tap_##name (type * data, const type * tap, guint n, \
+    gdouble gain) \
+{ \
+  guint i; \
+  \
+  for (i = 0; i < n; i++) \
+    data[i] += gain * tap[i]; \
+} \
+\
+static void \
 gst_audio_echo_transform_##name (GstAudioEcho * self, \
     type * data, guint num_samples) \
 { \
   type *buffer = (type *) self->buffer; \
   guint channels = GST_AUDIO_FILTER_CHANNELS (self); \
   guint rate = GST_AUDIO_FILTER_RATE (self); \
-  guint i, j; \
-  guint echo_index = self->buffer_size_frames - self->delay_frames; \
+  guint size = self->buffer_size_frames; \
+  guint mask = size - 1; \
+  guint delay = CLAMP (self->delay_frames, 1, mask); \
+  guint max_span = MAX (delay - 1, 1); \
+  guint pos = self->buffer_pos; \
+  guint num_frames = num_samples / channels; \
+  guint i; \
   gdouble echo_off = ((((gdouble) self->delay) * rate) / GST_SECOND) - self->delay_frames; \
   \
   if (echo_off < 0.0) \
     echo_off = 0.0; \
   \
-  num_samples /= channels; \
+  for (i = 0; i < self->n_taps; i++) \
+    max_span = MIN (max_span, MIN (self->tap_frames[i], mask)); \
   \
-  for (i = 0; i < num_samples; i++) { \
-    guint echo0_index = ((echo_index + self->buffer_pos) % self->buffer_size_frames) * channels; \
-    guint echo1_index = ((echo_index + self->buffer_pos +1) % self->buffer_size_frames) * channels; \
-    guint rbout_index = (self->buffer_pos % self->buffer_size_frames) * channels; \
-    for (j = 0; j < channels; j++) { \
-      gdouble in = data[i*channels + j]; \
-      gdouble echo0 = buffer[echo0_index + j]; \
-      gdouble echo1 = buffer[echo1_index + j]; \
-      gdouble echo = echo0 + (echo1-echo0)*echo_off; \
-      type out = in + self->intensity * echo; \
+  while (num_frames > 0) { \
+    guint echo0_pos = (pos - delay) & mask; \
+    guint echo1_pos = (echo0_pos + 1) & mask; \
+    guint span = MIN (num_frames, max_span); \
+    \
+    span = MIN (span, size - pos); \
+    span = MIN (span, size - echo0_pos); \
+    span = MIN (span, size - echo1_pos); \
+    for (i = 0; i < self->n_taps; i++) \
+      span = MIN (span, size - ((pos - MIN (self->tap_frames[i], mask)) & mask)); \
+    \
+    gst_audio_echo_mix_##name (data, buffer + pos * channels, \
+        buffer + echo0_pos * channels, buffer + echo1_pos * channels, \
+        span * channels, echo_off, self->intensity, self->feedback); \
+    for (i = 0; i < self->n_taps; i++) { \
+      guint tap_pos = (pos - MIN (self->tap_frames[i], mask)) & mask; \
       \
-      data[i*channels + j] = out; \
-      \
-      buffer[rbout_index + j] = in + self->feedback * echo; \
+      gst_audio_echo_tap_##name (data, buffer + tap_pos * channels, \
+          span * channels, self->tap_gains[i]); \
     } \
-    self->buffer_pos = (self->buffer_pos + 1) % self->buffer_size_frames; \
+    \
+    data += span * channels; \
+    num_frames -= span; \
+    pos = (pos + span) & mask; \
   } \
+  self->buffer_pos = pos; \
 }
 
 TRANSFORM_FUNC (float, gfloat);
@@ -389,8 +565,11 @@ gst_audio_echo_transform_ip (GstBaseTransform * base, GstBuffer * buf)
 
     self->delay_frames =
         MAX (gst_util_uint64_scale (self->delay, rate, GST_SECOND), 1);
-    self->buffer_size_frames =
-        MAX (gst_util_uint64_scale (self->max_delay, rate, GST_SECOND), 1);
+    gst_audio_echo_update_taps (self);
+
+    /* one more than the maximum delay, rounded up to a power of two */
+    self->buffer_size_frames = 1 << g_bit_storage (MAX (gst_util_uint64_scale
+            (self->max_delay, rate, GST_SECOND), 1));
 
     self->buffer_size = self->buffer_size_frames * bpf;
     self->buffer = g_try_malloc0 (self->buffer_size);
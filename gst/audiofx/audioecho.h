@@ -48,14 +48,23 @@ struct _GstAudioEcho
   gfloat intensity;
   gfloat feedback;
 
+  GValueArray *tap_delays;
+  GValueArray *tap_intensities;
+
   /* < private > */
   GstAudioEchoProcessFunc process;
   guint delay_frames;
   guint8 *buffer;
   guint buffer_pos;
   guint buffer_size;
+  /* always a power of two, so that positions wrap with a mask */
   guint buffer_size_frames;
 
+  /* extra feed-forward taps on the delay line */
+  guint n_taps;
+  guint *tap_frames;
+  gdouble *tap_gains;
+
   GMutex lock;
 };
 
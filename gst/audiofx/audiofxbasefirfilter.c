@@ -50,11 +50,16 @@ enum
 {
   PROP_0 = 0,
   PROP_LOW_LATENCY,
-  PROP_DRAIN_ON_CHANGES
+  PROP_DRAIN_ON_CHANGES,
+  PROP_PARTITION_LENGTH,
+  PROP_N_THREADS
 };
 
 #define DEFAULT_LOW_LATENCY FALSE
 #define DEFAULT_DRAIN_ON_CHANGES TRUE
+#define DEFAULT_PARTITION_LENGTH 0
+#define MAX_PARTITION_LENGTH (1 << 20)
+#define DEFAULT_N_THREADS 1
 
 #define gst_audio_fx_base_fir_filter_parent_class parent_class
 G_DEFINE_TYPE (GstAudioFXBaseFIRFilter, gst_audio_fx_base_fir_filter,
@@ -224,7 +229,189 @@ DEFINE_PROCESS_FUNC_FIXED_CHANNELS (64, 2, double);
  *   (  N log N  )
  * O ( --------- ) compared to O (M) for the direct calculation.
  *   ( N - M + 1 )
+ *
+ * As N grows with M the latency of N - M + 1 samples gets large for
+ * long kernels. To keep it bounded the kernel can be split into K
+ * partitions h_k of P samples each (uniformly partitioned convolution):
+ *
+ * y = IFFT (\sum_{k=0}^{K-1} X_{t-k} * FFT(h_k))
+ *
+ * where X_{t-k} is the spectrum of the input window from k passes ago.
+ * The windows advance by P samples per pass, so summing the delayed
+ * spectra in the frequency domain gives the contribution of h[kP..kP+P-1]
+ * and only one FFT and one inverse FFT of size N >= 2P - 1 are needed per
+ * pass. The spectra are kept in a ring buffer, the frequency-domain delay
+ * line. The latency is P samples, independent of the kernel length.
+ *
+ * The unpartitioned case is handled by the same code with K = 1, P = M
+ * and N - M + 1 new samples per pass.
  */
+/* FFT state of a set of channels that are processed together on one
+ * thread. The first slice uses the FFT state of the filter itself, the
+ * others have their own as GstFFTF64 keeps scratch space */
+struct _GstAudioFXBaseFIRFilterSlice
+{
+  GstAudioFXBaseFIRFilter *self;
+  GstFFTF64 *fft;
+  GstFFTF64 *ifft;
+  GstFFTF64Complex *fft_buffer;
+  guint channels;
+  guint channel_start, channel_end;
+};
+
+/* Convolves the current input window of every channel of the slice, the
+ * result is put after the input windows of all channels */
+static void
+gst_audio_fx_base_fir_filter_fft_channels (GstAudioFXBaseFIRFilterSlice *
+    slice)
+{
+  GstAudioFXBaseFIRFilter *self = slice->self;
+  guint block_length = self->block_length;
+  guint chunk_length = self->chunk_length;
+  guint history_length = block_length - chunk_length;
+  guint n_partitions = self->n_partitions;
+  guint frequency_response_length = self->frequency_response_length;
+  guint fdl_pos = self->fdl_pos;
+  GstFFTF64Complex *fft_buffer = slice->fft_buffer;
+  guint i, j, k;
+
+  for (j = slice->channel_start; j < slice->channel_end; j++) {
+    GstFFTF64Complex *line =
+        self->fdl + frequency_response_length * n_partitions * j;
+    gdouble *window = self->buffer + block_length * j;
+    gdouble *out = self->buffer + block_length * (slice->channels + j);
+
+    /* Calculate FFT of the input window into the delay line */
+    gst_fft_f64_fft (slice->fft, window,
+        line + frequency_response_length * fdl_pos);
+
+    /* Complex multiplication of every delayed input spectrum with the
+     * spectrum of its kernel partition, summed up */
+    memset (fft_buffer, 0,
+        sizeof (GstFFTF64Complex) * frequency_response_length);
+    for (k = 0; k < n_partitions; k++) {
+      const GstFFTF64Complex *x = line + frequency_response_length *
+          ((fdl_pos + n_partitions - k) % n_partitions);
+      const GstFFTF64Complex *h =
+          self->frequency_response + frequency_response_length * k;
+
+      for (i = 0; i < frequency_response_length; i++) {
+        gdouble xr = x[i].r, xi = x[i].i, hr = h[i].r, hi = h[i].i;
+
+        fft_buffer[i].r += xr * hr - xi * hi;
+        fft_buffer[i].i += xr * hi + xi * hr;
+      }
+    }
+
+    /* Calculate inverse FFT of the result, only the last chunk_length
+     * samples are free of circular aliasing */
+    gst_fft_f64_inverse_fft (slice->ifft, fft_buffer, out);
+
+    /* Keep the last history_length samples for the next window */
+    memmove (window, window + chunk_length, history_length * sizeof (gdouble));
+  }
+}
+
+static void
+gst_audio_fx_base_fir_filter_slice_func (gpointer data, gpointer user_data)
+{
+  GstAudioFXBaseFIRFilterSlice *slice = data;
+  GstAudioFXBaseFIRFilter *self = slice->self;
+
+  gst_audio_fx_base_fir_filter_fft_channels (slice);
+
+  g_mutex_lock (&self->slice_lock);
+  if (--self->slice_pending == 0)
+    g_cond_signal (&self->slice_cond);
+  g_mutex_unlock (&self->slice_lock);
+}
+
+static void
+gst_audio_fx_base_fir_filter_free_slices (GstAudioFXBaseFIRFilter * self)
+{
+  guint i;
+
+  /* The first slice only borrows the FFT state of the filter */
+  for (i = 1; i < self->n_slices; i++) {
+    gst_fft_f64_free (self->slices[i].fft);
+    gst_fft_f64_free (self->slices[i].ifft);
+    g_free (self->slices[i].fft_buffer);
+  }
+  g_free (self->slices);
+  self->slices = NULL;
+  self->n_slices = 0;
+}
+
+/* Splits the channels into slices that are processed on up to n-threads
+ * threads, the calling thread takes the first slice */
+static void
+gst_audio_fx_base_fir_filter_process_channels (GstAudioFXBaseFIRFilter * self,
+    guint channels)
+{
+  guint n_threads, n_slices, i;
+
+  n_threads = self->n_threads;
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  n_slices = MIN (n_threads, channels);
+
+  if (n_slices > 1 && self->slice_pool == NULL) {
+    self->slice_pool =
+        g_thread_pool_new (gst_audio_fx_base_fir_filter_slice_func, NULL,
+        n_slices - 1, FALSE, NULL);
+    if (self->slice_pool == NULL)
+      n_slices = 1;
+  } else if (n_slices > 1 &&
+      g_thread_pool_get_max_threads (self->slice_pool) < n_slices - 1) {
+    g_thread_pool_set_max_threads (self->slice_pool, n_slices - 1, NULL);
+  }
+
+  if (!self->fft_buffer)
+    self->fft_buffer =
+        g_new (GstFFTF64Complex, self->frequency_response_length);
+
+  if (self->n_slices != n_slices || self->slices[0].channels != channels) {
+    gst_audio_fx_base_fir_filter_free_slices (self);
+
+    self->slices = g_new0 (GstAudioFXBaseFIRFilterSlice, n_slices);
+    self->n_slices = n_slices;
+    for (i = 0; i < n_slices; i++) {
+      GstAudioFXBaseFIRFilterSlice *slice = &self->slices[i];
+
+      slice->self = self;
+      slice->channels = channels;
+      slice->channel_start = (channels * i) / n_slices;
+      slice->channel_end = (channels * (i + 1)) / n_slices;
+      if (i == 0) {
+        slice->fft = self->fft;
+        slice->ifft = self->ifft;
+        slice->fft_buffer = self->fft_buffer;
+      } else {
+        slice->fft = gst_fft_f64_new (self->block_length, FALSE);
+        slice->ifft = gst_fft_f64_new (self->block_length, TRUE);
+        slice->fft_buffer =
+            g_new (GstFFTF64Complex, self->frequency_response_length);
+      }
+    }
+  }
+
+  if (n_slices <= 1) {
+    gst_audio_fx_base_fir_filter_fft_channels (&self->slices[0]);
+    return;
+  }
+
+  self->slice_pending = n_slices - 1;
+  for (i = 1; i < n_slices; i++)
+    g_thread_pool_push (self->slice_pool, &self->slices[i], NULL);
+
+  gst_audio_fx_base_fir_filter_fft_channels (&self->slices[0]);
+
+  g_mutex_lock (&self->slice_lock);
+  while (self->slice_pending > 0)
+    g_cond_wait (&self->slice_cond, &self->slice_lock);
+  g_mutex_unlock (&self->slice_lock);
+}
+
 #define DEFINE_FFT_PROCESS_FUNC(width,ctype) \
 static guint \
 process_fft_##width (GstAudioFXBaseFIRFilter * self, const g##ctype * src, \
@@ -245,51 +432,48 @@ process_fft_##channels##_##width (GstAudioFXBaseFIRFilter * self, const g##ctype
 #define FFT_CONVOLUTION_BODY(channels) G_STMT_START { \
   gint i, j; \
   guint pass; \
-  guint kernel_length = self->kernel_length; \
   guint block_length = self->block_length; \
-  guint buffer_length = self->buffer_length; \
-  guint real_buffer_length = buffer_length + kernel_length - 1; \
+  guint chunk_length = self->chunk_length; \
+  guint history_length = block_length - chunk_length; \
+  guint n_partitions = self->n_partitions; \
   guint buffer_fill = self->buffer_fill; \
-  GstFFTF64 *fft = self->fft; \
-  GstFFTF64 *ifft = self->ifft; \
-  GstFFTF64Complex *frequency_response = self->frequency_response; \
-  GstFFTF64Complex *fft_buffer = self->fft_buffer; \
+  GstFFTF64Complex *fdl = self->fdl; \
   guint frequency_response_length = self->frequency_response_length; \
   gdouble *buffer = self->buffer; \
+  gdouble *ifft_buffer; \
   guint generated = 0; \
-  gdouble re, im; \
   \
-  if (!fft_buffer) \
-    self->fft_buffer = fft_buffer = \
-        g_new (GstFFTF64Complex, frequency_response_length); \
-  \
-  /* Buffer contains the time domain samples of input data for one chunk \
-   * plus some more space for the inverse FFT below. \
-   * \
-   * The samples are put at offset kernel_length, the inverse FFT \
-   * overwrites everthing from offset 0 to length-kernel_length+1, keeping \
-   * the last kernel_length-1 samples for copying to the next processing \
-   * step. \
+  /* Buffer contains the current input window of block_length samples \
+   * for every channel, followed by the inverse FFT output of every \
+   * channel. New samples are put at offset history_length, after every \
+   * pass the window moves by chunk_length samples. \
    */ \
   if (!buffer) { \
-    self->buffer_length = buffer_length = block_length; \
-    real_buffer_length = buffer_length + kernel_length - 1; \
-    \
-    self->buffer = buffer = g_new0 (gdouble, real_buffer_length * channels); \
+    self->buffer_length = block_length; \
+    self->buffer = buffer = g_new0 (gdouble, block_length * channels * 2); \
+    self->buffer_fill = buffer_fill = 0; \
     \
-    /* Beginning has kernel_length-1 zeroes at the beginning */ \
-    self->buffer_fill = buffer_fill = kernel_length - 1; \
+    /* Start with silence in the delay line too */ \
+    g_free (self->fdl); \
+    self->fdl = fdl = NULL; \
+  } \
+  \
+  if (!fdl) { \
+    self->fdl = fdl = g_new0 (GstFFTF64Complex, \
+        frequency_response_length * n_partitions * channels); \
+    self->fdl_pos = 0; \
   } \
   \
   g_assert (self->buffer_length == block_length); \
+  ifft_buffer = buffer + block_length * channels; \
   \
   while (input_samples) { \
-    pass = MIN (buffer_length - buffer_fill, input_samples); \
+    pass = MIN (chunk_length - buffer_fill, input_samples); \
     \
     /* Deinterleave channels */ \
     for (i = 0; i < pass; i++) { \
       for (j = 0; j < channels; j++) { \
-        buffer[real_buffer_length * j + buffer_fill + kernel_length - 1 + i] = \
+        buffer[block_length * j + history_length + buffer_fill + i] = \
             src[i * channels + j]; \
       } \
     } \
@@ -297,50 +481,25 @@ process_fft_##channels##_##width (GstAudioFXBaseFIRFilter * self, const g##ctype
     src += channels * pass; \
     input_samples -= pass; \
     \
-    /* If we don't have a complete buffer go out */ \
-    if (buffer_fill < buffer_length) \
+    /* If we don't have a complete chunk go out */ \
+    if (buffer_fill < chunk_length) \
       break; \
     \
-    for (j = 0; j < channels; j++) { \
-      /* Calculate FFT of input block */ \
-      gst_fft_f64_fft (fft, \
-          buffer + real_buffer_length * j + kernel_length - 1, fft_buffer); \
-      \
-      /* Complex multiplication of input and filter spectrum */ \
-      for (i = 0; i < frequency_response_length; i++) { \
-	re = fft_buffer[i].r; \
-	im = fft_buffer[i].i; \
-        \
-        fft_buffer[i].r = \
-            re * frequency_response[i].r - \
-            im * frequency_response[i].i; \
-        fft_buffer[i].i = \
-            re * frequency_response[i].i + \
-            im * frequency_response[i].r; \
-      } \
-      \
-      /* Calculate inverse FFT of the result */ \
-      gst_fft_f64_inverse_fft (ifft, fft_buffer, \
-          buffer + real_buffer_length * j); \
-      \
-      /* Copy all except the first kernel_length-1 samples to the output */ \
-      for (i = 0; i < buffer_length - kernel_length + 1; i++) { \
-        dst[i * channels + j] = \
-            buffer[real_buffer_length * j + kernel_length - 1 + i]; \
-      } \
-      \
-      /* Copy the last kernel_length-1 samples to the beginning for the next block */ \
-      for (i = 0; i < kernel_length - 1; i++) { \
-        buffer[real_buffer_length * j + kernel_length - 1 + i] = \
-            buffer[real_buffer_length * j + buffer_length + i]; \
+    gst_audio_fx_base_fir_filter_process_channels (self, channels); \
+    \
+    /* Interleave the last chunk_length samples of every channel */ \
+    for (i = 0; i < chunk_length; i++) { \
+      for (j = 0; j < channels; j++) { \
+        dst[i * channels + j] = ifft_buffer[block_length * j + \
+            history_length + i]; \
       } \
     } \
     \
-    generated += buffer_length - kernel_length + 1; \
-    dst += channels * (buffer_length - kernel_length + 1); \
+    self->fdl_pos = (self->fdl_pos + 1) % n_partitions; \
     \
-    /* The the first kernel_length-1 samples are there already */ \
-    buffer_fill = kernel_length - 1; \
+    generated += chunk_length; \
+    dst += channels * chunk_length; \
+    buffer_fill = 0; \
   } \
   \
   /* Write back cached buffer_fill value */ \
@@ -375,30 +534,56 @@ static void
   self->frequency_response_length = 0;
   g_free (self->fft_buffer);
   self->fft_buffer = NULL;
+  g_free (self->fdl);
+  self->fdl = NULL;
+  gst_audio_fx_base_fir_filter_free_slices (self);
 
   if (self->kernel && self->kernel_length >= FFT_THRESHOLD
       && !self->low_latency) {
-    guint block_length, i;
+    guint block_length, partition_length, i, k;
     gdouble *kernel_tmp, *kernel = self->kernel;
 
-    /* We process 4 * kernel_length samples per pass in FFT mode */
-    block_length = 4 * self->kernel_length;
-    block_length = gst_fft_next_fast_length (block_length);
+    if (self->partition_length) {
+      /* Partitions of partition_length samples, the window needs at
+       * least 2 * partition_length - 1 samples */
+      partition_length = self->partition_length;
+      block_length = gst_fft_next_fast_length (2 * partition_length);
+      self->chunk_length = partition_length;
+    } else {
+      /* We process 4 * kernel_length samples per pass in FFT mode */
+      partition_length = self->kernel_length;
+      block_length = 4 * self->kernel_length;
+      block_length = gst_fft_next_fast_length (block_length);
+      self->chunk_length = block_length - self->kernel_length + 1;
+    }
     self->block_length = block_length;
+    self->n_partitions =
+        (self->kernel_length + partition_length - 1) / partition_length;
 
-    kernel_tmp = g_new0 (gdouble, block_length);
-    memcpy (kernel_tmp, kernel, self->kernel_length * sizeof (gdouble));
+    GST_DEBUG_OBJECT (self, "using %u partitions of %u samples, FFT length %u",
+        self->n_partitions, partition_length, block_length);
 
     self->fft = gst_fft_f64_new (block_length, FALSE);
     self->ifft = gst_fft_f64_new (block_length, TRUE);
     self->frequency_response_length = block_length / 2 + 1;
-    self->frequency_response =
-        g_new (GstFFTF64Complex, self->frequency_response_length);
-    gst_fft_f64_fft (self->fft, kernel_tmp, self->frequency_response);
+    self->frequency_response = g_new (GstFFTF64Complex,
+        self->frequency_response_length * self->n_partitions);
+
+    kernel_tmp = g_new (gdouble, block_length);
+    for (k = 0; k < self->n_partitions; k++) {
+      guint offset = k * partition_length;
+
+      memset (kernel_tmp, 0, block_length * sizeof (gdouble));
+      memcpy (kernel_tmp, kernel + offset,
+          MIN (partition_length,
+              self->kernel_length - offset) * sizeof (gdouble));
+      gst_fft_f64_fft (self->fft, kernel_tmp,
+          self->frequency_response + self->frequency_response_length * k);
+    }
     g_free (kernel_tmp);
 
     /* Normalize to make sure IFFT(FFT(x)) == x */
-    for (i = 0; i < self->frequency_response_length; i++) {
+    for (i = 0; i < self->frequency_response_length * self->n_partitions; i++) {
       self->frequency_response[i].r /= block_length;
       self->frequency_response[i].i /= block_length;
     }
@@ -462,6 +647,12 @@ gst_audio_fx_base_fir_filter_finalize (GObject * object)
   gst_fft_f64_free (self->ifft);
   g_free (self->frequency_response);
   g_free (self->fft_buffer);
+  g_free (self->fdl);
+  gst_audio_fx_base_fir_filter_free_slices (self);
+  if (self->slice_pool)
+    g_thread_pool_free (self->slice_pool, FALSE, TRUE);
+  g_mutex_clear (&self->slice_lock);
+  g_cond_clear (&self->slice_cond);
   g_mutex_clear (&self->lock);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -502,6 +693,34 @@ gst_audio_fx_base_fir_filter_set_property (GObject * object, guint prop_id,
       g_mutex_unlock (&self->lock);
       break;
     }
+    case PROP_PARTITION_LENGTH:{
+      guint partition_length;
+
+      if (GST_STATE (self) >= GST_STATE_PAUSED) {
+        g_warning ("Changing the \"partition-length\" property "
+            "is only allowed in states < PAUSED");
+        return;
+      }
+
+      g_mutex_lock (&self->lock);
+      partition_length = g_value_get_uint (value);
+
+      if (self->partition_length != partition_length) {
+        self->partition_length = partition_length;
+        g_free (self->buffer);
+        self->buffer = NULL;
+        self->buffer_fill = 0;
+        self->buffer_length = 0;
+        gst_audio_fx_base_fir_filter_calculate_frequency_response (self);
+      }
+      g_mutex_unlock (&self->lock);
+      break;
+    }
+    case PROP_N_THREADS:
+      g_mutex_lock (&self->lock);
+      self->n_threads = g_value_get_uint (value);
+      g_mutex_unlock (&self->lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -521,6 +740,12 @@ gst_audio_fx_base_fir_filter_get_property (GObject * object, guint prop_id,
     case PROP_DRAIN_ON_CHANGES:
       g_value_set_boolean (value, self->drain_on_changes);
       break;
+    case PROP_PARTITION_LENGTH:
+      g_value_set_uint (value, self->partition_length);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, self->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -569,6 +794,38 @@ gst_audio_fx_base_fir_filter_class_init (GstAudioFXBaseFIRFilterClass * klass)
           DEFAULT_DRAIN_ON_CHANGES,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAudioFXBaseFIRFilter:partition-length:
+   *
+   * Split long filter kernels into partitions of this many samples for
+   * FFT convolution. The latency is then the partition length instead of
+   * growing with the kernel length, at the cost of some more work per
+   * sample. 0 processes the kernel as a single block.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_PARTITION_LENGTH,
+      g_param_spec_uint ("partition-length", "Partition length",
+          "Length of the kernel partitions in samples for FFT convolution, "
+          "0 to not partition the kernel. "
+          "Can only be changed in states < PAUSED!", 0, MAX_PARTITION_LENGTH,
+          DEFAULT_PARTITION_LENGTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAudioFXBaseFIRFilter:n-threads:
+   *
+   * Number of threads used for FFT convolution, each one handles a share
+   * of the channels. 0 uses one thread per processor.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Maximum number of threads used for FFT convolution "
+          "(0 = number of processors)", 0, G_MAXUINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   caps = gst_caps_from_string (ALLOWED_CAPS);
   gst_audio_filter_class_add_pad_templates (GST_AUDIO_FILTER_CLASS (klass),
       caps);
@@ -600,8 +857,12 @@ gst_audio_fx_base_fir_filter_init (GstAudioFXBaseFIRFilter * self)
 
   self->low_latency = DEFAULT_LOW_LATENCY;
   self->drain_on_changes = DEFAULT_DRAIN_ON_CHANGES;
+  self->partition_length = DEFAULT_PARTITION_LENGTH;
+  self->n_threads = DEFAULT_N_THREADS;
 
   g_mutex_init (&self->lock);
+  g_mutex_init (&self->slice_lock);
+  g_cond_init (&self->slice_cond);
 }
 
 void
@@ -667,16 +928,16 @@ gst_audio_fx_base_fir_filter_push_residue (GstAudioFXBaseFIRFilter * self)
     gst_buffer_map (outbuf, &map, GST_MAP_READWRITE);
 
     while (gensamples < outsamples) {
-      guint step_insamples = self->block_length - self->buffer_fill;
+      guint step_insamples = self->chunk_length - self->buffer_fill;
       guint8 *zeroes = g_new0 (guint8, step_insamples * channels * bps);
-      guint8 *out = g_new (guint8, self->block_length * channels * bps);
+      guint8 *out = g_new (guint8, self->chunk_length * channels * bps);
       guint step_gensamples;
 
       step_gensamples = self->process (self, zeroes, out, step_insamples);
       g_free (zeroes);
 
-      memcpy (map.data + gensamples * bps, out, MIN (step_gensamples,
-              outsamples - gensamples) * bps);
+      memcpy (map.data + gensamples * channels * bps, out,
+          MIN (step_gensamples, outsamples - gensamples) * channels * bps);
       gensamples += MIN (step_gensamples, outsamples - gensamples);
 
       g_free (out);
@@ -775,7 +1036,7 @@ gst_audio_fx_base_fir_filter_transform_size (GstBaseTransform * base,
   bpf = GST_AUDIO_INFO_BPF (&info);
 
   size /= bpf;
-  blocklen = self->block_length - self->kernel_length + 1;
+  blocklen = self->chunk_length;
   *othersize = ((size + blocklen - 1) / blocklen) * blocklen;
   *othersize *= bpf;
 
@@ -971,7 +1232,7 @@ gst_audio_fx_base_fir_filter_query (GstBaseTransform * trans,
             GST_TIME_ARGS (min), GST_TIME_ARGS (max));
 
         if (self->fft && !self->low_latency)
-          latency = self->block_length - self->kernel_length + 1;
+          latency = self->chunk_length;
         else
           latency = self->latency;
 
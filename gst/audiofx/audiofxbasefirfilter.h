@@ -44,6 +44,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstAudioFXBaseFIRFilter GstAudioFXBaseFIRFilter;
 typedef struct _GstAudioFXBaseFIRFilterClass GstAudioFXBaseFIRFilterClass;
+typedef struct _GstAudioFXBaseFIRFilterSlice GstAudioFXBaseFIRFilterSlice;
 
 typedef guint (*GstAudioFXBaseFIRFilterProcessFunc) (GstAudioFXBaseFIRFilter *, const guint8 *, guint8 *, guint);
 
@@ -65,6 +66,11 @@ struct _GstAudioFXBaseFIRFilter {
   gboolean drain_on_changes;    /* If the filter should be drained when
                                  * coeficients change */
 
+  guint partition_length;       /* length of the kernel partitions for FFT
+                                 * convolution, 0 for no partitioning */
+  guint n_threads;              /* threads for FFT convolution, 0 for one
+                                 * per processor */
+
   /* < private > */
   GstAudioFXBaseFIRFilterProcessFunc process;
 
@@ -79,6 +85,18 @@ struct _GstAudioFXBaseFIRFilter {
   guint frequency_response_length;       /* length of filter kernel -- frequency domain */
   GstFFTF64Complex *fft_buffer;          /* FFT buffer, has the length of the frequency response */
   guint block_length;                    /* Length of the processing blocks -- time domain */
+  guint chunk_length;                    /* New input samples per block -- time domain */
+  guint n_partitions;                    /* Number of kernel partitions */
+  GstFFTF64Complex *fdl;                 /* Input spectra of the last n_partitions blocks */
+  guint fdl_pos;                         /* Position of the newest spectrum in fdl */
+
+  /* channels processed in parallel in FFT mode */
+  GstAudioFXBaseFIRFilterSlice *slices;
+  guint n_slices;
+  GThreadPool *slice_pool;
+  GMutex slice_lock;
+  GCond slice_cond;
+  guint slice_pending;
 
   GstClockTime start_ts;        /* start timestamp after a discont */
   guint64 start_off;            /* start offset after a discont */
@@ -58,6 +58,17 @@ static void process_64 (GstAudioFXBaseIIRFilter * filter,
     gdouble * data, guint num_samples);
 static void process_32 (GstAudioFXBaseIIRFilter * filter,
     gfloat * data, guint num_samples);
+static void process_biquads_64 (GstAudioFXBaseIIRFilter * filter,
+    gdouble * data, guint num_samples);
+static void process_biquads_32 (GstAudioFXBaseIIRFilter * filter,
+    gfloat * data, guint num_samples);
+
+/* Section states below this are flushed to zero after every buffer so that
+ * decaying filters don't end up calculating with denormals */
+#define DENORMAL_THRESHOLD 1e-20
+
+/* Maximum number of iterations for finding the roots of a section */
+#define MAX_ROOT_ITERATIONS 500
 
 /* GObject vmethod implementations */
 
@@ -89,6 +100,12 @@ gst_audio_fx_base_iir_filter_finalize (GObject * object)
     g_free (filter->channels);
     filter->channels = NULL;
   }
+
+  g_free (filter->biquads);
+  filter->biquads = NULL;
+  g_free (filter->biquad_state);
+  filter->biquad_state = NULL;
+
   g_mutex_clear (&filter->lock);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -131,6 +148,9 @@ gst_audio_fx_base_iir_filter_init (GstAudioFXBaseIIRFilter * filter)
   filter->nb = 0;
   filter->channels = NULL;
   filter->nchannels = 0;
+  filter->biquads = NULL;
+  filter->n_biquads = 0;
+  filter->biquad_state = NULL;
 
   g_mutex_init (&filter->lock);
 }
@@ -178,6 +198,198 @@ gst_audio_fx_base_iir_filter_calculate_gain (gdouble * a, guint na, gdouble * b,
   return (sqrt (gain_r * gain_r + gain_i * gain_i));
 }
 
+/* Evaluate the transfer function of a cascade of biquads (b0, b1, b2, a1, a2
+ * each, a0 is 1) at (zr + zi*I)^-1 and return the magnitude */
+gdouble
+gst_audio_fx_base_iir_filter_calculate_biquad_gain (gdouble * biquads,
+    guint n_biquads, gdouble zr, gdouble zi)
+{
+  gdouble gain = 1.0;
+  guint i;
+
+  for (i = 0; i < n_biquads; i++) {
+    gdouble *bq = biquads + 5 * i;
+    gdouble a[3] = { 1.0, bq[3], bq[4] };
+
+    gain *= gst_audio_fx_base_iir_filter_calculate_gain (a, 3, bq, 3, zr, zi);
+  }
+
+  return gain;
+}
+
+/* Finds the n roots of z^n + c[1] * z^(n-1) + ... + c[n] with the
+ * Durand-Kerner method */
+static gboolean
+find_roots (const gdouble * c, guint n, gdouble * re, gdouble * im)
+{
+  guint i, j, iter;
+
+  /* Start from powers of a complex number that is neither real nor a root
+   * of unity */
+  re[0] = 1.0;
+  im[0] = 0.0;
+  for (i = 1; i < n; i++) {
+    re[i] = re[i - 1] * 0.4 - im[i - 1] * 0.9;
+    im[i] = re[i - 1] * 0.9 + im[i - 1] * 0.4;
+  }
+
+  for (iter = 0; iter < MAX_ROOT_ITERATIONS; iter++) {
+    gdouble delta = 0.0;
+
+    for (i = 0; i < n; i++) {
+      gdouble pr = 1.0, pi = 0.0, qr = 1.0, qi = 0.0, tr, ti, d;
+
+      /* p = polynomial at the current guess, Horner's scheme */
+      for (j = 1; j <= n; j++) {
+        tr = pr * re[i] - pi * im[i] + c[j];
+        ti = pr * im[i] + pi * re[i];
+        pr = tr;
+        pi = ti;
+      }
+
+      /* q = product of the differences to all other guesses */
+      for (j = 0; j < n; j++) {
+        gdouble dr, di;
+
+        if (j == i)
+          continue;
+        dr = re[i] - re[j];
+        di = im[i] - im[j];
+        tr = qr * dr - qi * di;
+        ti = qr * di + qi * dr;
+        qr = tr;
+        qi = ti;
+      }
+
+      d = qr * qr + qi * qi;
+      if (d == 0.0)
+        return FALSE;
+
+      tr = (pr * qr + pi * qi) / d;
+      ti = (pi * qr - pr * qi) / d;
+      re[i] -= tr;
+      im[i] -= ti;
+      delta = MAX (delta, tr * tr + ti * ti);
+    }
+
+    if (delta < 1e-24)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* Sorts the roots so that complex conjugates and pairs of real roots are
+ * next to each other */
+static void
+pair_roots (gdouble * re, gdouble * im, guint n)
+{
+  guint i, j;
+
+  for (i = 0; i < n; i += 2) {
+    guint best = i + 1;
+    gdouble best_dist = G_MAXDOUBLE;
+
+    for (j = i + 1; j < n; j++) {
+      /* imaginary part of real roots is only numerical noise */
+      gdouble dist = fabs (re[j] - re[i]) + fabs (im[j] + im[i]);
+
+      if (fabs (im[i]) < 1e-9 && fabs (im[j]) < 1e-9)
+        dist = 0.0;
+      if (dist < best_dist) {
+        best_dist = dist;
+        best = j;
+      }
+    }
+
+    if (best != i + 1) {
+      gdouble t;
+
+      t = re[i + 1];
+      re[i + 1] = re[best];
+      re[best] = t;
+      t = im[i + 1];
+      im[i + 1] = im[best];
+      im[best] = t;
+    }
+  }
+}
+
+/* Factors the IIR filter given by the even order difference equation
+ * coefficients a and b (a[0] and b[0] not zero) into order / 2 biquads.
+ * Returns FALSE if the roots could not be found. */
+gboolean
+gst_audio_fx_base_iir_filter_factor_biquads (gdouble * a, gdouble * b,
+    guint order, gdouble * biquads)
+{
+  gdouble *c, *re, *im;
+  gboolean ret = FALSE;
+  guint i, k;
+
+  g_return_val_if_fail (order % 2 == 0, FALSE);
+
+  if (a[0] == 0.0 || b[0] == 0.0)
+    return FALSE;
+
+  c = g_new (gdouble, order + 1);
+  re = g_new (gdouble, order);
+  im = g_new (gdouble, order);
+
+  /* poles go to a1, a2 and zeros to b1, b2 of each biquad */
+  for (k = 0; k < 2; k++) {
+    gdouble *poly = (k == 0) ? a : b;
+
+    for (i = 0; i <= order; i++)
+      c[i] = poly[i] / poly[0];
+
+    if (!find_roots (c, order, re, im))
+      goto done;
+    pair_roots (re, im, order);
+
+    for (i = 0; i < order / 2; i++) {
+      gdouble sr = re[2 * i] + re[2 * i + 1];
+      gdouble pr = re[2 * i] * re[2 * i + 1] - im[2 * i] * im[2 * i + 1];
+
+      if (k == 0) {
+        biquads[5 * i + 3] = -sr;
+        biquads[5 * i + 4] = pr;
+      } else {
+        biquads[5 * i + 0] = 1.0;
+        biquads[5 * i + 1] = -sr;
+        biquads[5 * i + 2] = pr;
+      }
+    }
+  }
+
+  /* put the overall gain into the first section */
+  for (i = 0; i < 3; i++)
+    biquads[i] *= b[0] / a[0];
+
+  ret = TRUE;
+
+done:
+  g_free (c);
+  g_free (re);
+  g_free (im);
+
+  return ret;
+}
+
+/* Must be called with the lock */
+static void
+gst_audio_fx_base_iir_filter_alloc_biquad_state (GstAudioFXBaseIIRFilter *
+    filter)
+{
+  g_free (filter->biquad_state);
+  filter->biquad_state = NULL;
+
+  /* z1 and z2 of every section for all channels, followed by the current
+   * frame */
+  if (filter->biquads && filter->nchannels)
+    filter->biquad_state =
+        g_new0 (gdouble, (2 * filter->n_biquads + 1) * filter->nchannels);
+}
+
 void
 gst_audio_fx_base_iir_filter_set_coefficients (GstAudioFXBaseIIRFilter * filter,
     gdouble * a, guint na, gdouble * b, guint nb)
@@ -193,6 +405,12 @@ gst_audio_fx_base_iir_filter_set_coefficients (GstAudioFXBaseIIRFilter * filter,
 
   filter->a = filter->b = NULL;
 
+  g_free (filter->biquads);
+  filter->biquads = NULL;
+  filter->n_biquads = 0;
+  g_free (filter->biquad_state);
+  filter->biquad_state = NULL;
+
   if (filter->channels) {
     GstAudioFXBaseIIRFilterChannelCtx *ctx;
     gboolean free = (na != filter->na || nb != filter->nb);
@@ -237,6 +455,54 @@ gst_audio_fx_base_iir_filter_set_coefficients (GstAudioFXBaseIIRFilter * filter,
   g_mutex_unlock (&filter->lock);
 }
 
+/**
+ * gst_audio_fx_base_iir_filter_set_biquads:
+ * @filter: the filter
+ * @biquads: (transfer full): b0, b1, b2, a1, a2 of every section
+ * @n_biquads: number of sections
+ *
+ * Sets the filter to a cascade of second order sections with the
+ * difference equation y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2]
+ * - a1 y[n-1] - a2 y[n-2] each. This is much more robust than the direct
+ * form for high orders and processes all channels of a frame at once.
+ *
+ * The filter state is kept if the number of sections doesn't change.
+ */
+void
+gst_audio_fx_base_iir_filter_set_biquads (GstAudioFXBaseIIRFilter * filter,
+    gdouble * biquads, guint n_biquads)
+{
+  guint i;
+
+  g_return_if_fail (GST_IS_AUDIO_FX_BASE_IIR_FILTER (filter));
+  g_return_if_fail (biquads != NULL && n_biquads > 0);
+
+  g_mutex_lock (&filter->lock);
+
+  g_free (filter->a);
+  g_free (filter->b);
+  filter->a = filter->b = NULL;
+
+  if (filter->channels) {
+    for (i = 0; i < filter->nchannels; i++) {
+      g_free (filter->channels[i].x);
+      g_free (filter->channels[i].y);
+      filter->channels[i].x = filter->channels[i].y = NULL;
+      filter->channels[i].x_pos = filter->channels[i].y_pos = 0;
+    }
+  }
+  filter->na = filter->nb = 0;
+
+  g_free (filter->biquads);
+  filter->biquads = biquads;
+  if (filter->n_biquads != n_biquads || !filter->biquad_state) {
+    filter->n_biquads = n_biquads;
+    gst_audio_fx_base_iir_filter_alloc_biquad_state (filter);
+  }
+
+  g_mutex_unlock (&filter->lock);
+}
+
 /* GstAudioFilter vmethod implementations */
 
 static gboolean
@@ -252,10 +518,14 @@ gst_audio_fx_base_iir_filter_setup (GstAudioFilter * base,
     case GST_AUDIO_FORMAT_F32:
       filter->process = (GstAudioFXBaseIIRFilterProcessFunc)
           process_32;
+      filter->process_biquads = (GstAudioFXBaseIIRFilterProcessFunc)
+          process_biquads_32;
       break;
     case GST_AUDIO_FORMAT_F64:
       filter->process = (GstAudioFXBaseIIRFilterProcessFunc)
           process_64;
+      filter->process_biquads = (GstAudioFXBaseIIRFilterProcessFunc)
+          process_biquads_64;
       break;
     default:
       ret = FALSE;
@@ -286,6 +556,7 @@ gst_audio_fx_base_iir_filter_setup (GstAudioFilter * base,
       ctx->y = g_new0 (gdouble, filter->na);
     }
     filter->nchannels = channels;
+    gst_audio_fx_base_iir_filter_alloc_biquad_state (filter);
   }
   g_mutex_unlock (&filter->lock);
 
@@ -352,6 +623,56 @@ DEFINE_PROCESS_FUNC (64, double);
 
 #undef DEFINE_PROCESS_FUNC
 
+/* Runs every section over all channels of a frame before moving on to the
+ * next section, in transposed direct form II. The state of each section
+ * is stored per channel next to each other so that the inner loop over
+ * the channels can be vectorized by the compiler. */
+#define DEFINE_BIQUAD_PROCESS_FUNC(width,ctype) \
+static void \
+process_biquads_##width (GstAudioFXBaseIIRFilter * filter, \
+    g##ctype * data, guint num_samples) \
+{ \
+  guint i, j, k, channels = filter->nchannels; \
+  guint n_biquads = filter->n_biquads; \
+  gdouble *state = filter->biquad_state; \
+  gdouble *cur = state + 2 * n_biquads * channels; \
+  \
+  for (i = 0; i < num_samples / channels; i++) { \
+    for (j = 0; j < channels; j++) \
+      cur[j] = data[j]; \
+    \
+    for (k = 0; k < n_biquads; k++) { \
+      const gdouble *bq = filter->biquads + 5 * k; \
+      gdouble b0 = bq[0], b1 = bq[1], b2 = bq[2], a1 = bq[3], a2 = bq[4]; \
+      gdouble *z1 = state + 2 * k * channels; \
+      gdouble *z2 = z1 + channels; \
+      \
+      for (j = 0; j < channels; j++) { \
+        gdouble x = cur[j]; \
+        gdouble y = b0 * x + z1[j]; \
+        \
+        z1[j] = b1 * x - a1 * y + z2[j]; \
+        z2[j] = b2 * x - a2 * y; \
+        cur[j] = y; \
+      } \
+    } \
+    \
+    for (j = 0; j < channels; j++) \
+      data[j] = cur[j]; \
+    data += channels; \
+  } \
+  \
+  for (i = 0; i < 2 * n_biquads * channels; i++) { \
+    if (fabs (state[i]) < DENORMAL_THRESHOLD) \
+      state[i] = 0.0; \
+  } \
+}
+
+DEFINE_BIQUAD_PROCESS_FUNC (32, float);
+DEFINE_BIQUAD_PROCESS_FUNC (64, double);
+
+#undef DEFINE_BIQUAD_PROCESS_FUNC
+
 /* GstBaseTransform vmethod implementations */
 static GstFlowReturn
 gst_audio_fx_base_iir_filter_transform_ip (GstBaseTransform * base,
@@ -376,13 +697,16 @@ gst_audio_fx_base_iir_filter_transform_ip (GstBaseTransform * base,
   num_samples = map.size / GST_AUDIO_FILTER_BPS (filter);
 
   g_mutex_lock (&filter->lock);
-  if (filter->a == NULL || filter->b == NULL) {
+  if (filter->biquads) {
+    filter->process_biquads (filter, map.data, num_samples);
+  } else if (filter->a == NULL || filter->b == NULL) {
     g_warn_if_fail (filter->a != NULL && filter->b != NULL);
     gst_buffer_unmap (buf, &map);
     g_mutex_unlock (&filter->lock);
     return GST_FLOW_ERROR;
+  } else {
+    filter->process (filter, map.data, num_samples);
   }
-  filter->process (filter, map.data, num_samples);
   g_mutex_unlock (&filter->lock);
 
   gst_buffer_unmap (buf, &map);
@@ -412,5 +736,8 @@ gst_audio_fx_base_iir_filter_stop (GstBaseTransform * base)
   filter->channels = NULL;
   filter->nchannels = 0;
 
+  g_free (filter->biquad_state);
+  filter->biquad_state = NULL;
+
   return TRUE;
 }
@@ -62,6 +62,12 @@ struct _GstAudioFXBaseIIRFilter
   GstAudioFXBaseIIRFilterChannelCtx *channels;
   guint nchannels;
 
+  /* cascade of second order sections, used instead of a and b if set */
+  GstAudioFXBaseIIRFilterProcessFunc process_biquads;
+  gdouble *biquads;             /* b0, b1, b2, a1, a2 per section */
+  guint n_biquads;
+  gdouble *biquad_state;        /* z1 and z2 per section and channel */
+
   GMutex lock;
 };
 
@@ -73,6 +79,9 @@ struct _GstAudioFXBaseIIRFilterClass
 GType gst_audio_fx_base_iir_filter_get_type (void);
 void gst_audio_fx_base_iir_filter_set_coefficients (GstAudioFXBaseIIRFilter *filter, gdouble *a, guint na, gdouble *b, guint nb);
 gdouble gst_audio_fx_base_iir_filter_calculate_gain (gdouble *a, guint na, gdouble *b, guint nb, gdouble zr, gdouble zi);
+void gst_audio_fx_base_iir_filter_set_biquads (GstAudioFXBaseIIRFilter *filter, gdouble *biquads, guint n_biquads);
+gdouble gst_audio_fx_base_iir_filter_calculate_biquad_gain (gdouble *biquads, guint n_biquads, gdouble zr, gdouble zi);
+gboolean gst_audio_fx_base_iir_filter_factor_biquads (gdouble *a, gdouble *b, guint order, gdouble *biquads);
 
 G_END_DECLS
 
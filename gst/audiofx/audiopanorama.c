@@ -62,9 +62,12 @@ enum
 {
   PROP_0,
   PROP_PANORAMA,
-  PROP_METHOD
+  PROP_METHOD,
+  PROP_SMOOTHING
 };
 
+#define DEFAULT_SMOOTHING FALSE
+
 #define GST_TYPE_AUDIO_PANORAMA_METHOD (gst_audio_panorama_method_get_type ())
 static GType
 gst_audio_panorama_method_get_type (void)
@@ -134,6 +137,16 @@ static void gst_audio_panorama_m2s_float_simple (gfloat pan,
 static void gst_audio_panorama_s2s_float_simple (gfloat pan,
     gfloat * idata, gfloat * odata, guint num_samples);
 
+static void gst_audio_panorama_m2s_int_ramp (const gfloat * from,
+    const gfloat * to, gint16 * idata, gint16 * odata, guint num_samples);
+static void gst_audio_panorama_s2s_int_ramp (const gfloat * from,
+    const gfloat * to, gint16 * idata, gint16 * odata, guint num_samples);
+static void gst_audio_panorama_m2s_float_ramp (const gfloat * from,
+    const gfloat * to, gfloat * idata, gfloat * odata, guint num_samples);
+static void gst_audio_panorama_s2s_float_ramp (const gfloat * from,
+    const gfloat * to, gfloat * idata, gfloat * odata, guint num_samples);
+
+static gboolean gst_audio_panorama_start (GstBaseTransform * base);
 static GstFlowReturn gst_audio_panorama_transform (GstBaseTransform * base,
     GstBuffer * inbuf, GstBuffer * outbuf);
 
@@ -158,6 +171,16 @@ static GstAudioPanoramaProcessFunc panorama_process_functions[2][2][2] = {
       }
 };
 
+/* Table with smoothing functions: [channels][format] */
+static GstAudioPanoramaRampFunc panorama_ramp_functions[2][2] = {
+  {
+        (GstAudioPanoramaRampFunc) gst_audio_panorama_m2s_int_ramp,
+      (GstAudioPanoramaRampFunc) gst_audio_panorama_m2s_float_ramp},
+  {
+        (GstAudioPanoramaRampFunc) gst_audio_panorama_s2s_int_ramp,
+      (GstAudioPanoramaRampFunc) gst_audio_panorama_s2s_float_ramp}
+};
+
 /* GObject vmethod implementations */
 
 static void
@@ -193,6 +216,20 @@ gst_audio_panorama_class_init (GstAudioPanoramaClass * klass)
           "simple mode just controls volume of one channel.",
           GST_TYPE_AUDIO_PANORAMA_METHOD, METHOD_PSYCHOACOUSTIC,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstAudioPanorama:smoothing:
+   *
+   * When the panorama changes between two buffers, e.g. through a control
+   * source, fade the channel gains over the buffer from the previous to the
+   * new position instead of switching at the buffer start.  This avoids
+   * zipper noise with automation, without having to use small buffers.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_SMOOTHING,
+      g_param_spec_boolean ("smoothing", "Smoothing",
+          "Interpolate panorama changes over the buffer duration",
+          DEFAULT_SMOOTHING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_set_static_metadata (gstelement_class, "Stereo positioning",
       "Filter/Effect/Audio",
@@ -210,6 +247,8 @@ gst_audio_panorama_class_init (GstAudioPanoramaClass * klass)
       GST_DEBUG_FUNCPTR (gst_audio_panorama_transform_caps);
   GST_BASE_TRANSFORM_CLASS (klass)->set_caps =
       GST_DEBUG_FUNCPTR (gst_audio_panorama_set_caps);
+  GST_BASE_TRANSFORM_CLASS (klass)->start =
+      GST_DEBUG_FUNCPTR (gst_audio_panorama_start);
   GST_BASE_TRANSFORM_CLASS (klass)->transform =
       GST_DEBUG_FUNCPTR (gst_audio_panorama_transform);
 }
@@ -220,8 +259,11 @@ gst_audio_panorama_init (GstAudioPanorama * filter)
 
   filter->panorama = 0;
   filter->method = METHOD_PSYCHOACOUSTIC;
+  filter->smoothing = DEFAULT_SMOOTHING;
   gst_audio_info_init (&filter->info);
   filter->process = NULL;
+  filter->ramp = NULL;
+  filter->gains_valid = FALSE;
 
   gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM (filter), TRUE);
 }
@@ -245,6 +287,7 @@ gst_audio_panorama_set_process_function (GstAudioPanorama * filter,
 
   filter->process =
       panorama_process_functions[channel_index][format_index][method_index];
+  filter->ramp = panorama_ramp_functions[channel_index][format_index];
   return TRUE;
 }
 
@@ -262,6 +305,9 @@ gst_audio_panorama_set_property (GObject * object, guint prop_id,
       filter->method = g_value_get_enum (value);
       gst_audio_panorama_set_process_function (filter, &filter->info);
       break;
+    case PROP_SMOOTHING:
+      filter->smoothing = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -281,6 +327,9 @@ gst_audio_panorama_get_property (GObject * object, guint prop_id,
     case PROP_METHOD:
       g_value_set_enum (value, filter->method);
       break;
+    case PROP_SMOOTHING:
+      g_value_set_boolean (value, filter->smoothing);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -360,6 +409,7 @@ gst_audio_panorama_set_caps (GstBaseTransform * base, GstCaps * incaps,
     goto no_format;
 
   filter->info = info;
+  filter->gains_valid = FALSE;
 
   return TRUE;
 
@@ -496,6 +546,104 @@ gst_audio_panorama_s2s_float_simple (gfloat pan, gfloat * idata,
   }
 }
 
+/* smoothing functions
+ *
+ * The gains map the input channels to the output channels:
+ *   l' = l * gains[0] + r * gains[1]
+ *   r' = l * gains[2] + r * gains[3]
+ * with l = r for mono input.  They are faded linearly from the previous to
+ * the current values over the buffer.  The loops have no dependencies between
+ * frames, so the compiler can vectorize them.
+ */
+static void
+gst_audio_panorama_get_gains (GstAudioPanorama * filter, gfloat * gains)
+{
+  gfloat pan = filter->panorama;
+
+  gains[0] = 1.0;
+  gains[1] = 0.0;
+  gains[2] = 0.0;
+  gains[3] = 1.0;
+
+  if (GST_AUDIO_INFO_CHANNELS (&filter->info) == 1) {
+    gains[3] = 0.0;
+    if (filter->method == METHOD_PSYCHOACOUSTIC) {
+      gfloat r = (pan + 1.0) / 2.0;
+      gains[0] = 1.0 - r;
+      gains[2] = r;
+    } else {
+      gains[2] = 1.0;
+      if (pan > 0.0)
+        gains[0] = 1.0 - pan;
+      else
+        gains[2] = 1.0 + pan;
+    }
+  } else if (pan > 0.0) {
+    gains[0] = 1.0 - pan;
+    if (filter->method == METHOD_PSYCHOACOUSTIC)
+      gains[2] = pan;
+  } else if (pan < 0.0) {
+    gains[3] = 1.0 + pan;
+    if (filter->method == METHOD_PSYCHOACOUSTIC)
+      gains[1] = -pan;
+  }
+}
+
+static inline gint16
+gst_audio_panorama_clamp_s16 (gfloat val)
+{
+  gint ival = (gint) val;
+
+  return CLAMP (ival, G_MININT16, G_MAXINT16);
+}
+
+#define CONVERT_FLOAT(val) (val)
+
+#define DEFINE_RAMP_FUNC(name, type, channels, convert)                 \
+static void                                                             \
+gst_audio_panorama_##name##_ramp (const gfloat * from, const gfloat * to, \
+    type * idata, type * odata, guint n)                                \
+{                                                                       \
+  gfloat step[4];                                                       \
+  guint i, k;                                                           \
+                                                                        \
+  if (n == 0)                                                           \
+    return;                                                             \
+                                                                        \
+  for (k = 0; k < 4; k++)                                               \
+    step[k] = (to[k] - from[k]) / n;                                    \
+                                                                        \
+  for (i = 0; i < n; i++) {                                             \
+    gfloat t = i + 1;                                                   \
+    gfloat l = idata[i * channels];                                     \
+    gfloat r = idata[i * channels + channels - 1];                      \
+    gfloat out_l, out_r;                                                \
+                                                                        \
+    out_l = l * (from[0] + step[0] * t) + r * (from[1] + step[1] * t);  \
+    out_r = l * (from[2] + step[2] * t) + r * (from[3] + step[3] * t);  \
+    odata[2 * i] = convert (out_l);                                     \
+    odata[2 * i + 1] = convert (out_r);                                 \
+  }                                                                     \
+}
+
+DEFINE_RAMP_FUNC (m2s_int, gint16, 1, gst_audio_panorama_clamp_s16);
+DEFINE_RAMP_FUNC (s2s_int, gint16, 2, gst_audio_panorama_clamp_s16);
+DEFINE_RAMP_FUNC (m2s_float, gfloat, 1, CONVERT_FLOAT);
+DEFINE_RAMP_FUNC (s2s_float, gfloat, 2, CONVERT_FLOAT);
+
+#undef DEFINE_RAMP_FUNC
+#undef CONVERT_FLOAT
+
+static gboolean
+gst_audio_panorama_start (GstBaseTransform * base)
+{
+  GstAudioPanorama *filter = GST_AUDIO_PANORAMA (base);
+
+  filter->gains_valid = FALSE;
+
+  return TRUE;
+}
+
 /* this function does the actual processing
  */
 static GstFlowReturn
@@ -505,6 +653,7 @@ gst_audio_panorama_transform (GstBaseTransform * base, GstBuffer * inbuf,
   GstAudioPanorama *filter = GST_AUDIO_PANORAMA (base);
   GstClockTime ts;
   GstMapInfo inmap, outmap;
+  gfloat gains[4];
 
   ts = gst_segment_to_stream_time (&base->segment, GST_FORMAT_TIME,
       GST_BUFFER_TIMESTAMP (inbuf));
@@ -514,6 +663,8 @@ gst_audio_panorama_transform (GstBaseTransform * base, GstBuffer * inbuf,
     gst_object_sync_values (GST_OBJECT (filter), ts);
   }
 
+  gst_audio_panorama_get_gains (filter, gains);
+
   gst_buffer_map (outbuf, &outmap, GST_MAP_WRITE);
 
   if (G_UNLIKELY (GST_BUFFER_FLAG_IS_SET (inbuf, GST_BUFFER_FLAG_GAP))) {
@@ -525,11 +676,20 @@ gst_audio_panorama_transform (GstBaseTransform * base, GstBuffer * inbuf,
     guint num_samples = outmap.size / (2 * GST_AUDIO_INFO_BPS (&filter->info));
 
     gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
-    filter->process (filter->panorama, inmap.data, outmap.data, num_samples);
+    if (filter->smoothing && filter->gains_valid
+        && memcmp (filter->gains, gains, sizeof (gains)) != 0)
+      filter->ramp (filter->gains, gains, inmap.data, outmap.data,
+          num_samples);
+    else
+      filter->process (filter->panorama, inmap.data, outmap.data,
+          num_samples);
     gst_buffer_unmap (inbuf, &inmap);
   }
 
   gst_buffer_unmap (outbuf, &outmap);
 
+  memcpy (filter->gains, gains, sizeof (gains));
+  filter->gains_valid = TRUE;
+
   return GST_FLOW_OK;
 }
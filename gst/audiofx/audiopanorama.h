@@ -38,6 +38,7 @@ typedef struct _GstAudioPanorama      GstAudioPanorama;
 typedef struct _GstAudioPanoramaClass GstAudioPanoramaClass;
 
 typedef void (*GstAudioPanoramaProcessFunc)(gfloat, guint8*, guint8*, guint);
+typedef void (*GstAudioPanoramaRampFunc)(const gfloat*, const gfloat*, guint8*, guint8*, guint);
 
 typedef enum
 {
@@ -51,9 +52,14 @@ struct _GstAudioPanorama {
   /* properties */
   gfloat panorama;
   GstAudioPanoramaMethod method;
+  gboolean smoothing;
 
   /* < private > */
   GstAudioPanoramaProcessFunc process;
+  GstAudioPanoramaRampFunc ramp;
+  /* channel gains used for the previous buffer */
+  gfloat gains[4];
+  gboolean gains_valid;
   GstAudioInfo info;
 };
 
@@ -119,7 +119,7 @@ best_overlap_offset_float (GstScaletempo * st)
   gfloat *pw, *po, *ppc, *search_start;
   gfloat best_corr = G_MININT;
   guint best_off = 0;
-  gint i, off;
+  gint i, off, n;
 
   pw = st->table_window;
   po = st->buf_overlap;
@@ -129,14 +129,21 @@ best_overlap_offset_float (GstScaletempo * st)
     *ppc++ = *pw++ * *po++;
   }
 
+  /* independent sums so the compiler can vectorize the loop, the
+   * pre-correlation buffer is padded with zeroes to a multiple of 4 */
+  n = st->samples_overlap - st->samples_per_frame;
   search_start = (gfloat *) st->buf_queue + st->samples_per_frame;
+  ppc = st->buf_pre_corr;
   for (off = 0; off < st->frames_search; off++) {
-    gfloat corr = 0;
+    gfloat corr, corr0 = 0, corr1 = 0, corr2 = 0, corr3 = 0;
     gfloat *ps = search_start;
-    ppc = st->buf_pre_corr;
-    for (i = st->samples_per_frame; i < st->samples_overlap; i++) {
-      corr += *ppc++ * *ps++;
+    for (i = 0; i < n; i += 4) {
+      corr0 += ppc[i + 0] * ps[i + 0];
+      corr1 += ppc[i + 1] * ps[i + 1];
+      corr2 += ppc[i + 2] * ps[i + 2];
+      corr3 += ppc[i + 3] * ps[i + 3];
     }
+    corr = (corr0 + corr1) + (corr2 + corr3);
     if (corr > best_corr) {
       best_corr = corr;
       best_off = off;
@@ -192,6 +199,79 @@ best_overlap_offset_s16 (GstScaletempo * st)
   return best_off * st->bytes_per_frame;
 }
 
+/* For long search windows the correlation is calculated for all offsets at
+ * once in the frequency domain, summed up over all channels. The result is
+ * the same as above up to rounding errors. */
+static guint
+best_overlap_offset_fft (GstScaletempo * st)
+{
+  guint spf = st->samples_per_frame;
+  guint frames_pre_corr = st->samples_overlap / spf - 1;
+  guint frames_queue = st->frames_search + frames_pre_corr - 1;
+  guint nc = st->fft_length / 2 + 1;
+  gfloat *buf = st->fft_buffer;
+  GstFFTF32Complex *pre = st->fft_pre_corr;
+  GstFFTF32Complex *queue = st->fft_queue;
+  GstFFTF32Complex *corr = st->fft_corr;
+  gfloat best_corr = G_MININT;
+  guint best_off = 0;
+  guint c, i;
+
+  memset (corr, 0, nc * sizeof (GstFFTF32Complex));
+
+  for (c = 0; c < spf; c++) {
+    /* windowed overlap of this channel */
+    if (st->use_int) {
+      gint32 *pw = (gint32 *) st->table_window + c;
+      gint16 *po = (gint16 *) st->buf_overlap + spf + c;
+
+      for (i = 0; i < frames_pre_corr; i++)
+        buf[i] = (pw[i * spf] * po[i * spf]) >> 15;
+    } else {
+      gfloat *pw = (gfloat *) st->table_window + c;
+      gfloat *po = (gfloat *) st->buf_overlap + spf + c;
+
+      for (i = 0; i < frames_pre_corr; i++)
+        buf[i] = pw[i * spf] * po[i * spf];
+    }
+    memset (buf + frames_pre_corr, 0,
+        (st->fft_length - frames_pre_corr) * sizeof (gfloat));
+    gst_fft_f32_fft (st->fft, buf, pre);
+
+    /* all positions that are searched */
+    if (st->use_int) {
+      gint16 *ps = (gint16 *) st->buf_queue + spf + c;
+
+      for (i = 0; i < frames_queue; i++)
+        buf[i] = ps[i * spf];
+    } else {
+      gfloat *ps = (gfloat *) st->buf_queue + spf + c;
+
+      for (i = 0; i < frames_queue; i++)
+        buf[i] = ps[i * spf];
+    }
+    memset (buf + frames_queue, 0,
+        (st->fft_length - frames_queue) * sizeof (gfloat));
+    gst_fft_f32_fft (st->fft, buf, queue);
+
+    for (i = 0; i < nc; i++) {
+      corr[i].r += pre[i].r * queue[i].r + pre[i].i * queue[i].i;
+      corr[i].i += pre[i].r * queue[i].i - pre[i].i * queue[i].r;
+    }
+  }
+
+  gst_fft_f32_inverse_fft (st->ifft, corr, buf);
+
+  for (i = 0; i < st->frames_search; i++) {
+    if (buf[i] > best_corr) {
+      best_corr = buf[i];
+      best_off = i;
+    }
+  }
+
+  return best_off * st->bytes_per_frame;
+}
+
 static void
 output_overlap_float (GstScaletempo * st, gpointer buf_out, guint bytes_off)
 {
@@ -258,6 +338,50 @@ fill_queue (GstScaletempo * st, GstBuffer * buf_in, guint offset)
   return offset - offset_unchanged;
 }
 
+/* rough cost of a real FFT of length n in multiply-adds is
+ * FFT_COST * n * log2 (n) */
+#define FFT_COST 4
+
+static void
+reinit_fft (GstScaletempo * st, guint frames_overlap)
+{
+  guint spf = st->samples_per_frame;
+  guint frames_pre_corr = frames_overlap - 1;
+  guint64 direct_cost, fft_cost;
+  guint fft_length, nc;
+
+  fft_length =
+      gst_fft_next_fast_length (st->frames_search + frames_pre_corr - 1);
+
+  /* the direct correlation does one multiply-add per sample and offset,
+   * the FFT needs two transforms per channel and an inverse one */
+  direct_cost = (guint64) st->frames_search * frames_pre_corr * spf;
+  fft_cost = (guint64) (2 * spf + 1) * FFT_COST * fft_length *
+      g_bit_storage (fft_length);
+
+  if (fft_cost >= direct_cost)
+    return;
+
+  if (fft_length != st->fft_length) {
+    if (st->fft)
+      gst_fft_f32_free (st->fft);
+    if (st->ifft)
+      gst_fft_f32_free (st->ifft);
+    st->fft = gst_fft_f32_new (fft_length, FALSE);
+    st->ifft = gst_fft_f32_new (fft_length, TRUE);
+    st->fft_length = fft_length;
+
+    nc = fft_length / 2 + 1;
+    st->fft_buffer = g_renew (gfloat, st->fft_buffer, fft_length);
+    st->fft_pre_corr = g_renew (GstFFTF32Complex, st->fft_pre_corr, nc);
+    st->fft_queue = g_renew (GstFFTF32Complex, st->fft_queue, nc);
+    st->fft_corr = g_renew (GstFFTF32Complex, st->fft_corr, nc);
+  }
+
+  GST_DEBUG ("using FFT correlation of length %u", fft_length);
+  st->best_overlap_offset = best_overlap_offset_fft;
+}
+
 static void
 reinit_buffers (GstScaletempo * st)
 {
@@ -322,12 +446,12 @@ reinit_buffers (GstScaletempo * st)
     st->buf_pre_corr =
         g_realloc (st->buf_pre_corr, bytes_pre_corr + UNROLL_PADDING);
     st->table_window = g_realloc (st->table_window, bytes_pre_corr);
+    memset ((guint8 *) st->buf_pre_corr + bytes_pre_corr, 0, UNROLL_PADDING);
     if (st->use_int) {
       gint64 t = frames_overlap;
       gint32 n = 8589934588LL / (t * t);        /* 4 * (2^31 - 1) / t^2 */
       gint32 *pw;
 
-      memset ((guint8 *) st->buf_pre_corr + bytes_pre_corr, 0, UNROLL_PADDING);
       pw = st->table_window;
       for (i = 1; i < frames_overlap; i++) {
         gint32 v = (i * (t - i) * n) >> 15;
@@ -346,6 +470,7 @@ reinit_buffers (GstScaletempo * st)
       }
       st->best_overlap_offset = best_overlap_offset_float;
     }
+    reinit_fft (st, frames_overlap);
   }
 
   new_size =
@@ -681,6 +806,29 @@ gst_scaletempo_set_property (GObject * object,
   }
 }
 
+static void
+gst_scaletempo_finalize (GObject * object)
+{
+  GstScaletempo *scaletempo = GST_SCALETEMPO (object);
+
+  g_free (scaletempo->buf_queue);
+  g_free (scaletempo->buf_overlap);
+  g_free (scaletempo->table_blend);
+  g_free (scaletempo->buf_pre_corr);
+  g_free (scaletempo->table_window);
+
+  if (scaletempo->fft)
+    gst_fft_f32_free (scaletempo->fft);
+  if (scaletempo->ifft)
+    gst_fft_f32_free (scaletempo->ifft);
+  g_free (scaletempo->fft_buffer);
+  g_free (scaletempo->fft_pre_corr);
+  g_free (scaletempo->fft_queue);
+  g_free (scaletempo->fft_corr);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_scaletempo_class_init (GstScaletempoClass * klass)
 {
@@ -690,6 +838,7 @@ gst_scaletempo_class_init (GstScaletempoClass * klass)
 
   gobject_class->get_property = GST_DEBUG_FUNCPTR (gst_scaletempo_get_property);
   gobject_class->set_property = GST_DEBUG_FUNCPTR (gst_scaletempo_set_property);
+  gobject_class->finalize = gst_scaletempo_finalize;
 
   g_object_class_install_property (gobject_class, PROP_RATE,
       g_param_spec_double ("rate", "Playback Rate", "Current playback rate",
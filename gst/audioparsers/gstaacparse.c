@@ -47,6 +47,7 @@
 #include <gst/base/gstbitreader.h>
 #include <gst/pbutils/pbutils.h>
 #include "gstaacparse.h"
+#include "gstsyncscan.h"
 
 
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
@@ -75,6 +76,14 @@ GST_DEBUG_CATEGORY_STATIC (aacparse_debug);
 
 #define AAC_FRAME_DURATION(parse) (GST_SECOND/parse->frames_per_sec)
 
+#define DEFAULT_FRAME_INDEX_INTERVAL 0
+
+enum
+{
+  PROP_0,
+  PROP_FRAME_INDEX_INTERVAL
+};
+
 static const gint loas_sample_rate_table[32] = {
   96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050,
   16000, 12000, 11025, 8000, 7350, 0, 0, 0
@@ -85,6 +94,11 @@ static const gint loas_channels_table[32] = {
   0, 0, 0, 0, 0, 0, 0, 0
 };
 
+static void gst_aac_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_aac_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
 static gboolean gst_aac_parse_start (GstBaseParse * parse);
 static gboolean gst_aac_parse_stop (GstBaseParse * parse);
 
@@ -108,12 +122,32 @@ G_DEFINE_TYPE (GstAacParse, gst_aac_parse, GST_TYPE_BASE_PARSE);
 static void
 gst_aac_parse_class_init (GstAacParseClass * klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
   GstBaseParseClass *parse_class = GST_BASE_PARSE_CLASS (klass);
 
   GST_DEBUG_CATEGORY_INIT (aacparse_debug, "aacparse", 0,
       "AAC audio stream parser");
 
+  object_class->set_property = gst_aac_parse_set_property;
+  object_class->get_property = gst_aac_parse_get_property;
+
+  /**
+   * GstAacParse:frame-index-interval:
+   *
+   * When operating in pull mode on an ADTS stream, scan the frame headers
+   * in a background thread and add an index entry every so many frames,
+   * so that seeks land on the right frame without estimating the offset
+   * from the bitrate. 0 disables the scan.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (object_class, PROP_FRAME_INDEX_INTERVAL,
+      g_param_spec_uint ("frame-index-interval", "Frame index interval",
+          "Scan the file in the background and index every Nth frame "
+          "(0 = disabled)", 0, G_MAXUINT, DEFAULT_FRAME_INDEX_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&sink_template));
   gst_element_class_add_pad_template (element_class,
@@ -144,6 +178,40 @@ gst_aac_parse_init (GstAacParse * aacparse)
 {
   GST_DEBUG ("initialized");
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (aacparse));
+
+  aacparse->frame_index_interval = DEFAULT_FRAME_INDEX_INTERVAL;
+}
+
+static void
+gst_aac_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstAacParse *aacparse = GST_AAC_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_FRAME_INDEX_INTERVAL:
+      aacparse->frame_index_interval = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_aac_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstAacParse *aacparse = GST_AAC_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_FRAME_INDEX_INTERVAL:
+      g_value_set_uint (value, aacparse->frame_index_interval);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 
@@ -799,24 +867,39 @@ gst_aac_parse_detect_stream (GstAacParse * aacparse,
     return FALSE;
   }
 
-  for (i = 0; i < avail - 4; i++) {
-    if (((data[i] == 0xff) && ((data[i + 1] & 0xf6) == 0xf0)) ||
-        ((data[0] == 0x56) && ((data[1] & 0xe0) == 0xe0)) ||
-        strncmp ((char *) data + i, "ADIF", 4) == 0) {
-      GST_DEBUG_OBJECT (aacparse, "Found signature at offset %u", i);
+  if ((data[0] == 0x56) && ((data[1] & 0xe0) == 0xe0)) {
+    /* LOAS sync at the start */
+    found = TRUE;
+  } else {
+    /* ADTS sync word or "ADIF" */
+    static const guint32 masks[] = { 0xfff60000, 0xffffffff };
+    static const guint32 syncs[] = { 0xfff00000, 0x41444946 };
+    GstByteReader reader;
+    guint which;
+    gint off;
+
+    gst_byte_reader_init (&reader, data, avail);
+    off = gst_sync_scan_uint32_any (&reader, masks, syncs,
+        G_N_ELEMENTS (syncs), 0, avail - 1, &which);
+    if (off >= 0) {
       found = TRUE;
-
-      if (i) {
-        /* Trick: tell the parent class that we didn't find the frame yet,
-           but make it skip 'i' amount of bytes. Next time we arrive
-           here we have full frame in the beginning of the data. */
-        *skipsize = i;
-        return FALSE;
-      }
-      break;
+      i = off;
+    } else {
+      i = avail - 4;
     }
   }
-  if (!found) {
+
+  if (found) {
+    GST_DEBUG_OBJECT (aacparse, "Found signature at offset %u", i);
+
+    if (i) {
+      /* Trick: tell the parent class that we didn't find the frame yet,
+         but make it skip 'i' amount of bytes. Next time we arrive
+         here we have full frame in the beginning of the data. */
+      *skipsize = i;
+      return FALSE;
+    }
+  } else {
     if (i)
       *skipsize = i;
     return FALSE;
@@ -1176,6 +1259,27 @@ gst_aac_parse_prepend_adts_headers (GstAacParse * aacparse,
  *
  * Returns: a #GstFlowReturn.
  */
+/* #GstFrameIndexParseFunc for ADTS, @user_data points to the first 32 bits
+ * of the first frame; the fixed part of the header must not change */
+static guint
+gst_aac_parse_index_adts_frame (const guint8 * data, guint size,
+    guint * samples, gpointer user_data)
+{
+  guint32 first = *(guint32 *) user_data;
+  guint len;
+
+  if ((GST_READ_UINT32_BE (data) & 0xfffffff0) != (first & 0xfffffff0))
+    return 0;
+
+  len = ((data[3] & 0x03) << 11) | (data[4] << 3) | ((data[5] & 0xe0) >> 5);
+  if (len < ADTS_HEADERS_LENGTH)
+    return 0;
+
+  *samples = 1024 * ((data[6] & 0x03) + 1);
+
+  return len;
+}
+
 static GstFlowReturn
 gst_aac_parse_handle_frame (GstBaseParse * parse,
     GstBaseParseFrame * frame, gint * skipsize)
@@ -1262,6 +1366,14 @@ gst_aac_parse_handle_frame (GstBaseParse * parse,
       gst_base_parse_set_frame_rate (GST_BASE_PARSE (aacparse),
           aacparse->sample_rate, aacparse->frame_samples, 2, 2);
     }
+
+    if (G_UNLIKELY (aacparse->frame_index_interval > 0
+            && aacparse->frame_index == NULL)) {
+      aacparse->frame_index_header = GST_READ_UINT32_BE (map.data);
+      aacparse->frame_index = gst_frame_index_start (parse, frame->offset,
+          ADTS_HEADERS_LENGTH, rate, aacparse->frame_index_interval,
+          gst_aac_parse_index_adts_frame, &aacparse->frame_index_header);
+    }
   } else if (aacparse->header_type == DSPAAC_HEADER_LOAS) {
     gboolean setcaps = FALSE;
 
@@ -1396,7 +1508,13 @@ gst_aac_parse_start (GstBaseParse * parse)
 static gboolean
 gst_aac_parse_stop (GstBaseParse * parse)
 {
+  GstAacParse *aacparse = GST_AAC_PARSE (parse);
+
   GST_DEBUG ("stop");
+  if (aacparse->frame_index) {
+    gst_frame_index_stop (aacparse->frame_index);
+    aacparse->frame_index = NULL;
+  }
   return TRUE;
 }
 
@@ -25,6 +25,8 @@
 #include <gst/gst.h>
 #include <gst/base/gstbaseparse.h>
 
+#include "gstframeindex.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_AAC_PARSE \
@@ -83,6 +85,10 @@ struct _GstAacParse {
   GstAacHeaderType output_header_type;
 
   gboolean sent_codec_tag;
+
+  guint          frame_index_interval;
+  GstFrameIndex *frame_index;
+  guint32        frame_index_header;
 };
 
 /**
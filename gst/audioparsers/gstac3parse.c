@@ -46,6 +46,7 @@
 #include <string.h>
 
 #include "gstac3parse.h"
+#include "gstsyncscan.h"
 #include <gst/base/base.h>
 #include <gst/pbutils/pbutils.h>
 
@@ -140,6 +141,14 @@ static const guint fscod_rates[4] = { 48000, 44100, 32000, 0 };
 static const guint acmod_chans[8] = { 2, 1, 2, 3, 3, 4, 4, 5 };
 static const guint numblks[4] = { 1, 2, 3, 6 };
 
+#define DEFAULT_FRAME_INDEX_INTERVAL 0
+
+enum
+{
+  PROP_0,
+  PROP_FRAME_INDEX_INTERVAL
+};
+
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
@@ -157,6 +166,10 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
         "audio/x-private1-ac3"));
 
 static void gst_ac3_parse_finalize (GObject * object);
+static void gst_ac3_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_ac3_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static gboolean gst_ac3_parse_start (GstBaseParse * parse);
 static gboolean gst_ac3_parse_stop (GstBaseParse * parse);
@@ -185,6 +198,24 @@ gst_ac3_parse_class_init (GstAc3ParseClass * klass)
       "AC3 audio stream parser");
 
   object_class->finalize = gst_ac3_parse_finalize;
+  object_class->set_property = gst_ac3_parse_set_property;
+  object_class->get_property = gst_ac3_parse_get_property;
+
+  /**
+   * GstAc3Parse:frame-index-interval:
+   *
+   * When operating in pull mode, scan the frame headers in a background
+   * thread and add an index entry every so many frames, so that seeks land
+   * on the right frame without estimating the offset from the bitrate.
+   * 0 disables the scan.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (object_class, PROP_FRAME_INDEX_INTERVAL,
+      g_param_spec_uint ("frame-index-interval", "Frame index interval",
+          "Scan the file in the background and index every Nth frame "
+          "(0 = disabled)", 0, G_MAXUINT, DEFAULT_FRAME_INDEX_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&sink_template));
@@ -224,6 +255,7 @@ gst_ac3_parse_init (GstAc3Parse * ac3parse)
   ac3parse->baseparse_chainfunc =
       GST_BASE_PARSE_SINK_PAD (GST_BASE_PARSE (ac3parse))->chainfunc;
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (ac3parse));
+  ac3parse->frame_index_interval = DEFAULT_FRAME_INDEX_INTERVAL;
 }
 
 static void
@@ -232,6 +264,38 @@ gst_ac3_parse_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_ac3_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstAc3Parse *ac3parse = GST_AC3_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_FRAME_INDEX_INTERVAL:
+      ac3parse->frame_index_interval = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_ac3_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstAc3Parse *ac3parse = GST_AC3_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_FRAME_INDEX_INTERVAL:
+      g_value_set_uint (value, ac3parse->frame_index_interval);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static gboolean
 gst_ac3_parse_start (GstBaseParse * parse)
 {
@@ -247,8 +311,15 @@ gst_ac3_parse_start (GstBaseParse * parse)
 static gboolean
 gst_ac3_parse_stop (GstBaseParse * parse)
 {
+  GstAc3Parse *ac3parse = GST_AC3_PARSE (parse);
+
   GST_DEBUG_OBJECT (parse, "stopping");
 
+  if (ac3parse->frame_index) {
+    gst_frame_index_stop (ac3parse->frame_index);
+    ac3parse->frame_index = NULL;
+  }
+
   return TRUE;
 }
 
@@ -489,6 +560,44 @@ cleanup:
   return ret;
 }
 
+/* #GstFrameIndexParseFunc for (E-)AC-3, @user_data tells whether the stream
+ * is E-AC-3. Only frames of independent substream 0 advance the time. */
+static guint
+gst_ac3_parse_index_frame (const guint8 * data, guint size, guint * samples,
+    gpointer user_data)
+{
+  gboolean eac = GPOINTER_TO_INT (user_data);
+  guint8 bsid, fscod, frmsizcod, strmtyp, strmid;
+
+  if (GST_READ_UINT16_BE (data) != 0x0b77)
+    return 0;
+
+  bsid = data[5] >> 3;
+
+  if (!eac) {
+    if (bsid > 10)
+      return 0;
+    fscod = data[4] >> 6;
+    frmsizcod = data[4] & 0x3f;
+    if (fscod == 3 || frmsizcod >= G_N_ELEMENTS (frmsizcod_table))
+      return 0;
+    *samples = 6 * 256;
+    return frmsizcod_table[frmsizcod].frame_size[fscod] * 2;
+  }
+
+  if (bsid <= 10 || bsid > 16)
+    return 0;
+  strmtyp = data[2] >> 6;
+  strmid = (data[2] >> 3) & 0x7;
+  if (strmtyp == 3)
+    return 0;
+  if (strmtyp != 1 && strmid == 0) {
+    fscod = data[4] >> 6;
+    *samples = 256 * (fscod == 3 ? 6 : numblks[(data[4] >> 4) & 0x3]);
+  }
+  return ((((data[2] & 0x7) << 8) | data[3]) + 1) * 2;
+}
+
 static GstFlowReturn
 gst_ac3_parse_handle_frame (GstBaseParse * parse,
     GstBaseParseFrame * frame, gint * skipsize)
@@ -515,7 +624,7 @@ gst_ac3_parse_handle_frame (GstBaseParse * parse,
   }
 
   gst_byte_reader_init (&reader, map.data, map.size);
-  off = gst_byte_reader_masked_scan_uint32 (&reader, 0xffff0000, 0x0b770000,
+  off = gst_sync_scan_uint32 (&reader, 0xffff0000, 0x0b770000,
       0, map.size);
 
   GST_LOG_OBJECT (parse, "possible sync at buffer offset %d", off);
@@ -662,6 +771,12 @@ gst_ac3_parse_handle_frame (GstBaseParse * parse,
   if (G_UNLIKELY (update_rate))
     gst_base_parse_set_frame_rate (parse, rate, 256 * blocks, 2, 2);
 
+  if (G_UNLIKELY (ac3parse->frame_index_interval > 0
+          && ac3parse->frame_index == NULL && sid == 0))
+    ac3parse->frame_index = gst_frame_index_start (parse, frame->offset, 6,
+        rate, ac3parse->frame_index_interval, gst_ac3_parse_index_frame,
+        GINT_TO_POINTER (eac));
+
 cleanup:
   gst_buffer_unmap (buf, &map);
 
@@ -26,6 +26,8 @@
 #include <gst/gst.h>
 #include <gst/base/gstbaseparse.h>
 
+#include "gstframeindex.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_AC3_PARSE \
@@ -64,6 +66,9 @@ struct _GstAc3Parse {
   gboolean              sent_codec_tag;
   volatile gint         align;
   GstPadChainFunction   baseparse_chainfunc;
+
+  guint                 frame_index_interval;
+  GstFrameIndex        *frame_index;
 };
 
 /**
@@ -71,6 +71,19 @@ static const gint block_size_wb[16] =
 #define AMR_FRAME_DURATION (GST_SECOND/AMR_FRAMES_PER_SECOND)
 #define AMR_MIME_HEADER_SIZE 9
 
+#define DEFAULT_FRAME_INDEX_INTERVAL 0
+
+enum
+{
+  PROP_0,
+  PROP_FRAME_INDEX_INTERVAL
+};
+
+static void gst_amr_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_amr_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
 static gboolean gst_amr_parse_start (GstBaseParse * parse);
 static gboolean gst_amr_parse_stop (GstBaseParse * parse);
 
@@ -94,12 +107,32 @@ G_DEFINE_TYPE (GstAmrParse, gst_amr_parse, GST_TYPE_BASE_PARSE);
 static void
 gst_amr_parse_class_init (GstAmrParseClass * klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
   GstBaseParseClass *parse_class = GST_BASE_PARSE_CLASS (klass);
 
   GST_DEBUG_CATEGORY_INIT (amrparse_debug, "amrparse", 0,
       "AMR-NB audio stream parser");
 
+  object_class->set_property = gst_amr_parse_set_property;
+  object_class->get_property = gst_amr_parse_get_property;
+
+  /**
+   * GstAmrParse:frame-index-interval:
+   *
+   * When operating in pull mode, scan the frame headers in a background
+   * thread and add an index entry every so many frames, so that seeks land
+   * on the right frame without estimating the offset from the bitrate.
+   * 0 disables the scan.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (object_class, PROP_FRAME_INDEX_INTERVAL,
+      g_param_spec_uint ("frame-index-interval", "Frame index interval",
+          "Scan the file in the background and index every Nth frame "
+          "(0 = disabled)", 0, G_MAXUINT, DEFAULT_FRAME_INDEX_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&sink_template));
   gst_element_class_add_pad_template (element_class,
@@ -133,6 +166,39 @@ gst_amr_parse_init (GstAmrParse * amrparse)
   gst_base_parse_set_min_frame_size (GST_BASE_PARSE (amrparse), 62);
   GST_DEBUG ("initialized");
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (amrparse));
+  amrparse->frame_index_interval = DEFAULT_FRAME_INDEX_INTERVAL;
+}
+
+static void
+gst_amr_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstAmrParse *amrparse = GST_AMR_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_FRAME_INDEX_INTERVAL:
+      amrparse->frame_index_interval = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_amr_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstAmrParse *amrparse = GST_AMR_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_FRAME_INDEX_INTERVAL:
+      g_value_set_uint (value, amrparse->frame_index_interval);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 
@@ -253,6 +319,27 @@ gst_amr_parse_parse_header (GstAmrParse * amrparse,
  *
  * Returns: TRUE if the given data contains valid frame.
  */
+/* #GstFrameIndexParseFunc for AMR, @user_data is the block size table.
+ * The index runs at the frame rate, every frame is one "sample". */
+static guint
+gst_amr_parse_index_frame (const guint8 * data, guint size, guint * samples,
+    gpointer user_data)
+{
+  const gint *block_size = user_data;
+  gint fsize;
+
+  if ((data[0] & 0x83) != 0)
+    return 0;
+
+  fsize = block_size[(data[0] >> 3) & 0x0F] + 1;
+  if (fsize <= 0)
+    return 0;
+
+  *samples = 1;
+
+  return fsize;
+}
+
 static GstFlowReturn
 gst_amr_parse_handle_frame (GstBaseParse * parse,
     GstBaseParseFrame * frame, gint * skipsize)
@@ -277,6 +364,12 @@ gst_amr_parse_handle_frame (GstBaseParse * parse,
         gst_amr_parse_parse_header (amrparse, map.data, skipsize)) {
       amrparse->need_header = FALSE;
       gst_base_parse_set_frame_rate (GST_BASE_PARSE (amrparse), 50, 1, 2, 2);
+
+      if (amrparse->frame_index_interval > 0 && amrparse->frame_index == NULL)
+        amrparse->frame_index = gst_frame_index_start (parse,
+            frame->offset + *skipsize, 1, AMR_FRAMES_PER_SECOND,
+            amrparse->frame_index_interval, gst_amr_parse_index_frame,
+            (gpointer) amrparse->block_size);
     } else {
       GST_WARNING ("media doesn't look like a AMR format");
     }
@@ -364,6 +457,10 @@ gst_amr_parse_stop (GstBaseParse * parse)
   GST_DEBUG ("stop");
   amrparse->need_header = TRUE;
   amrparse->header = 0;
+  if (amrparse->frame_index) {
+    gst_frame_index_stop (amrparse->frame_index);
+    amrparse->frame_index = NULL;
+  }
   return TRUE;
 }
 
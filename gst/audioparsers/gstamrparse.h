@@ -26,6 +26,8 @@
 #include <gst/gst.h>
 #include <gst/base/gstbaseparse.h>
 
+#include "gstframeindex.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_AMR_PARSE \
@@ -64,6 +66,9 @@ struct _GstAmrParse {
   gboolean sent_codec_tag;
   gint header;
   gboolean wide;
+
+  guint frame_index_interval;
+  GstFrameIndex *frame_index;
 };
 
 /**
@@ -48,6 +48,7 @@
 #include <string.h>
 
 #include "gstdcaparse.h"
+#include "gstsyncscan.h"
 #include <gst/base/base.h>
 #include <gst/pbutils/pbutils.h>
 
@@ -265,52 +266,34 @@ static gint
 gst_dca_parse_find_sync (GstDcaParse * dcaparse, GstByteReader * reader,
     gsize bufsize, guint32 * sync)
 {
-  guint32 best_sync = 0;
-  guint best_offset = G_MAXUINT;
+  static const guint32 masks[] = {
+    0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff
+  };
+  static const guint32 syncs[] = {
+    /* Raw little endian */
+    0xfe7f0180,
+    /* Raw big endian */
+    0x7ffe8001,
+    /* FIXME: check next 2 bytes as well for 14-bit formats (but then don't
+     * forget to adjust the *skipsize= in _check_valid_frame() */
+    /* 14-bit little endian  */
+    0xff1f00e8,
+    /* 14-bit big endian  */
+    0x1fffe800
+  };
+  guint found = 0;
   gint off;
 
   /* FIXME: verify syncs via _parse_header() here already */
 
-  /* Raw little endian */
-  off = gst_byte_reader_masked_scan_uint32 (reader, 0xffffffff, 0xfe7f0180,
-      0, bufsize);
-  if (off >= 0 && off < best_offset) {
-    best_offset = off;
-    best_sync = 0xfe7f0180;
-  }
-
-  /* Raw big endian */
-  off = gst_byte_reader_masked_scan_uint32 (reader, 0xffffffff, 0x7ffe8001,
-      0, bufsize);
-  if (off >= 0 && off < best_offset) {
-    best_offset = off;
-    best_sync = 0x7ffe8001;
-  }
-
-  /* FIXME: check next 2 bytes as well for 14-bit formats (but then don't
-   * forget to adjust the *skipsize= in _check_valid_frame() */
-
-  /* 14-bit little endian  */
-  off = gst_byte_reader_masked_scan_uint32 (reader, 0xffffffff, 0xff1f00e8,
-      0, bufsize);
-  if (off >= 0 && off < best_offset) {
-    best_offset = off;
-    best_sync = 0xff1f00e8;
-  }
-
-  /* 14-bit big endian  */
-  off = gst_byte_reader_masked_scan_uint32 (reader, 0xffffffff, 0x1fffe800,
-      0, bufsize);
-  if (off >= 0 && off < best_offset) {
-    best_offset = off;
-    best_sync = 0x1fffe800;
-  }
-
-  if (best_offset == G_MAXUINT)
+  /* look for all sync words in one pass */
+  off = gst_sync_scan_uint32_any (reader, masks, syncs, G_N_ELEMENTS (syncs),
+      0, bufsize, &found);
+  if (off < 0)
     return -1;
 
-  *sync = best_sync;
-  return best_offset;
+  *sync = syncs[found];
+  return off;
 }
 
 static GstFlowReturn
@@ -343,8 +326,8 @@ gst_dca_parse_handle_frame (GstBaseParse * parse,
   gst_byte_reader_init (&r, map.data, map.size);
 
   if (G_LIKELY (parser_in_sync && dcaparse->last_sync != 0)) {
-    off = gst_byte_reader_masked_scan_uint32 (&r, 0xffffffff,
-        dcaparse->last_sync, 0, map.size);
+    off = gst_sync_scan_uint32 (&r, 0xffffffff, dcaparse->last_sync, 0,
+        map.size);
   }
 
   if (G_UNLIKELY (off < 0)) {
@@ -149,11 +149,42 @@ static const guint16 crc16_table[256] = {
   0x8213, 0x0216, 0x021c, 0x8219, 0x0208, 0x820d, 0x8207, 0x0202
 };
 
+/* crc16_slices[k][b] is the CRC-16 of byte b followed by k zero bytes,
+ * which allows processing 8 bytes per step (slicing-by-8) */
+static guint16 crc16_slices[8][256];
+
+static void
+gst_flac_init_crc16_slices (void)
+{
+  guint i, k;
+
+  for (i = 0; i < 256; i++)
+    crc16_slices[0][i] = crc16_table[i];
+
+  for (k = 1; k < 8; k++) {
+    for (i = 0; i < 256; i++) {
+      guint16 prev = crc16_slices[k - 1][i];
+
+      crc16_slices[k][i] = (prev << 8) ^ crc16_table[prev >> 8];
+    }
+  }
+}
+
 static guint16
 gst_flac_calculate_crc16 (const guint8 * data, guint length)
 {
   guint16 crc = 0;
 
+  while (length >= 8) {
+    crc = crc16_slices[7][data[0] ^ (crc >> 8)] ^
+        crc16_slices[6][data[1] ^ (crc & 0xff)] ^
+        crc16_slices[5][data[2]] ^ crc16_slices[4][data[3]] ^
+        crc16_slices[3][data[4]] ^ crc16_slices[2][data[5]] ^
+        crc16_slices[1][data[6]] ^ crc16_slices[0][data[7]];
+    data += 8;
+    length -= 8;
+  }
+
   while (length--) {
     crc = ((crc << 8) ^ crc16_table[(crc >> 8) ^ *data]) & 0xffff;
     data++;
@@ -218,6 +249,8 @@ gst_flac_parse_class_init (GstFlacParseClass * klass)
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
   GstBaseParseClass *baseparse_class = GST_BASE_PARSE_CLASS (klass);
 
+  gst_flac_init_crc16_slices ();
+
   GST_DEBUG_CATEGORY_INIT (flacparse_debug, "flacparse", 0,
       "Flac parser element");
 
@@ -679,6 +712,18 @@ gst_flac_parse_frame_is_valid (GstFlacParse * flacparse,
   remaining = map.size;
 
   for (i = search_start; i < search_end; i++, remaining--) {
+    const guint8 *sync;
+
+    /* jump to the next possible sync code */
+    sync = memchr (map.data + i, 0xff, search_end - i);
+    if (sync == NULL) {
+      remaining -= search_end - i;
+      i = search_end;
+      break;
+    }
+    remaining -= (sync - map.data) - i;
+    i = sync - map.data;
+
     if ((GST_READ_UINT16_BE (map.data + i) & 0xfffe) == 0xfff8) {
       GST_LOG_OBJECT (flacparse, "possible frame end at offset %d", i);
       suspect_end = FALSE;
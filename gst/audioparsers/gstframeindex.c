@@ -0,0 +1,188 @@
+/* GStreamer audio parsers
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Background frame index shared by the audio parsers.
+ *
+ * Raw elementary streams have no seek tables, so baseparse can only seek
+ * in them by estimating the offset from the bitrate and resyncing from
+ * there. When the parser works in pull mode, a thread pulls the file in
+ * large blocks from the first frame on, walks the frame headers with a
+ * parser specific function and adds an index entry to the base class
+ * every so many frames. Seeks that land in the scanned part of the file
+ * are then exact. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstframeindex.h"
+
+GST_DEBUG_CATEGORY_STATIC (frame_index_debug);
+#define GST_CAT_DEFAULT frame_index_debug
+
+/* size of the blocks pulled by the index thread */
+#define FRAME_INDEX_BLOCK_SIZE  (64 * 1024)
+
+struct _GstFrameIndex
+{
+  GstBaseParse *parse;
+  GThread *thread;
+  volatile gint stop;
+
+  guint64 offset;
+  guint header_size;
+  gint rate;
+  guint interval;
+  GstFrameIndexParseFunc func;
+  gpointer user_data;
+};
+
+static gpointer
+gst_frame_index_func (GstFrameIndex * index)
+{
+  GstBaseParse *parse = index->parse;
+  GstPad *sinkpad = GST_BASE_PARSE_SINK_PAD (parse);
+  GstBuffer *block = NULL;
+  GstMapInfo map = { 0, };
+  guint64 offset = index->offset, block_offset = 0;
+  guint64 frames = 0, samples = 0;
+  guint length, frame_samples;
+  GstFlowReturn ret;
+
+  GST_DEBUG_OBJECT (parse, "building frame index from offset %"
+      G_GUINT64_FORMAT, offset);
+
+  while (!g_atomic_int_get (&index->stop)) {
+    /* make sure the next header is in the current block */
+    if (!block || offset + index->header_size > block_offset + map.size) {
+      if (block) {
+        gst_buffer_unmap (block, &map);
+        gst_buffer_unref (block);
+        block = NULL;
+      }
+      ret = gst_pad_pull_range (sinkpad, offset, FRAME_INDEX_BLOCK_SIZE,
+          &block);
+      if (ret == GST_FLOW_FLUSHING) {
+        /* seeking, try again a bit later */
+        g_usleep (G_USEC_PER_SEC / 100);
+        continue;
+      } else if (ret != GST_FLOW_OK) {
+        break;
+      }
+      gst_buffer_map (block, &map, GST_MAP_READ);
+      block_offset = offset;
+      if (map.size < index->header_size)
+        break;
+    }
+
+    frame_samples = 0;
+    length = index->func (map.data + (offset - block_offset),
+        map.size - (offset - block_offset), &frame_samples, index->user_data);
+    if (length == 0)
+      break;
+
+    /* only frames that advance the time start a seek point */
+    if (frame_samples > 0) {
+      if (frames % index->interval == 0)
+        gst_base_parse_add_index_entry (parse, offset,
+            gst_util_uint64_scale (samples, GST_SECOND, index->rate), TRUE,
+            FALSE);
+      frames++;
+      samples += frame_samples;
+    }
+    offset += length;
+  }
+
+  if (block) {
+    gst_buffer_unmap (block, &map);
+    gst_buffer_unref (block);
+  }
+
+  GST_DEBUG_OBJECT (parse, "frame index done after %" G_GUINT64_FORMAT
+      " frames, at offset %" G_GUINT64_FORMAT, frames, offset);
+
+  return NULL;
+}
+
+/**
+ * gst_frame_index_start:
+ * @parse: the parser
+ * @offset: the offset of the first frame
+ * @header_size: the number of bytes @func needs to parse a header
+ * @rate: the sample rate of the stream
+ * @interval: add an index entry every @interval frames
+ * @func: the function parsing a frame header
+ * @user_data: user data for @func
+ *
+ * Start indexing the frames of the stream from @offset on in a background
+ * thread. This only works when @parse operates in pull mode.
+ *
+ * Returns: the new index scan, or NULL when no index can be built.
+ */
+GstFrameIndex *
+gst_frame_index_start (GstBaseParse * parse, guint64 offset,
+    guint header_size, gint rate, guint interval, GstFrameIndexParseFunc func,
+    gpointer user_data)
+{
+  GstFrameIndex *index;
+
+  g_return_val_if_fail (header_size > 0 && interval > 0, NULL);
+
+  if (GST_PAD_MODE (GST_BASE_PARSE_SINK_PAD (parse)) != GST_PAD_MODE_PULL ||
+      rate <= 0)
+    return NULL;
+
+  if (G_UNLIKELY (frame_index_debug == NULL))
+    GST_DEBUG_CATEGORY_INIT (frame_index_debug, "audioparseindex", 0,
+        "audio parsers frame index");
+
+  index = g_new0 (GstFrameIndex, 1);
+  index->parse = parse;
+  index->offset = offset;
+  index->header_size = header_size;
+  index->rate = rate;
+  index->interval = interval;
+  index->func = func;
+  index->user_data = user_data;
+
+  index->thread = g_thread_try_new ("audioparse-index",
+      (GThreadFunc) gst_frame_index_func, index, NULL);
+  if (!index->thread) {
+    GST_WARNING_OBJECT (parse, "could not start frame index thread");
+    g_free (index);
+    return NULL;
+  }
+
+  return index;
+}
+
+/**
+ * gst_frame_index_stop:
+ * @index: an index scan
+ *
+ * Stop the index scan and wait for its thread to finish. The entries added
+ * so far stay in the index of the parser.
+ */
+void
+gst_frame_index_stop (GstFrameIndex * index)
+{
+  g_atomic_int_set (&index->stop, 1);
+  g_thread_join (index->thread);
+  g_free (index);
+}
@@ -0,0 +1,57 @@
+/* GStreamer audio parsers
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_FRAME_INDEX_H__
+#define __GST_FRAME_INDEX_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbaseparse.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstFrameIndexParseFunc:
+ * @data: the start of a frame
+ * @size: the number of bytes available at @data, at least the header size
+ *     given to gst_frame_index_start()
+ * @samples: location for the number of samples in the frame, 0 for frames
+ *     that don't advance the time like dependent substreams
+ * @user_data: user data given to gst_frame_index_start()
+ *
+ * Parse the header of the frame at @data.
+ *
+ * Returns: the size of the frame in bytes, 0 when @data does not start a
+ * frame of the stream.
+ */
+typedef guint (*GstFrameIndexParseFunc) (const guint8 * data, guint size,
+    guint * samples, gpointer user_data);
+
+typedef struct _GstFrameIndex GstFrameIndex;
+
+GstFrameIndex * gst_frame_index_start (GstBaseParse * parse, guint64 offset,
+                                       guint header_size, gint rate,
+                                       guint interval,
+                                       GstFrameIndexParseFunc func,
+                                       gpointer user_data);
+
+void            gst_frame_index_stop  (GstFrameIndex * index);
+
+G_END_DECLS
+
+#endif /* __GST_FRAME_INDEX_H__ */
@@ -48,6 +48,7 @@
 #include <string.h>
 
 #include "gstmpegaudioparse.h"
+#include "gstsyncscan.h"
 #include <gst/base/gstbytereader.h>
 #include <gst/pbutils/pbutils.h>
 
@@ -71,6 +72,17 @@ GST_DEBUG_CATEGORY_STATIC (mpeg_audio_parse_debug);
 
 #define MIN_FRAME_SIZE       6
 
+/* size of the blocks pulled by the frame index thread */
+#define FRAME_INDEX_BLOCK_SIZE  (64 * 1024)
+
+#define DEFAULT_FRAME_INDEX_INTERVAL 0
+
+enum
+{
+  PROP_0,
+  PROP_FRAME_INDEX_INTERVAL
+};
+
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
@@ -89,6 +101,10 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     );
 
 static void gst_mpeg_audio_parse_finalize (GObject * object);
+static void gst_mpeg_audio_parse_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_mpeg_audio_parse_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
 
 static gboolean gst_mpeg_audio_parse_start (GstBaseParse * parse);
 static gboolean gst_mpeg_audio_parse_stop (GstBaseParse * parse);
@@ -103,7 +119,9 @@ static GstCaps *gst_mpeg_audio_parse_get_sink_caps (GstBaseParse * parse,
     GstCaps * filter);
 
 static void gst_mpeg_audio_parse_handle_first_frame (GstMpegAudioParse *
-    mp3parse, GstBuffer * buf);
+    mp3parse, GstBuffer * buf, guint64 offset);
+static void gst_mpeg_audio_parse_stop_frame_index (GstMpegAudioParse *
+    mp3parse);
 
 #define gst_mpeg_audio_parse_parent_class parent_class
 G_DEFINE_TYPE (GstMpegAudioParse, gst_mpeg_audio_parse, GST_TYPE_BASE_PARSE);
@@ -155,6 +173,24 @@ gst_mpeg_audio_parse_class_init (GstMpegAudioParseClass * klass)
       "MPEG1 audio stream parser");
 
   object_class->finalize = gst_mpeg_audio_parse_finalize;
+  object_class->set_property = gst_mpeg_audio_parse_set_property;
+  object_class->get_property = gst_mpeg_audio_parse_get_property;
+
+  /**
+   * GstMpegAudioParse:frame-index-interval:
+   *
+   * When operating in pull mode on a file without a Xing or VBRI seek
+   * table, scan the frame headers in a background thread and add an
+   * index entry every so many frames. Once the scan is done, seeking is
+   * exact even for VBR files. 0 disables the scan.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (object_class, PROP_FRAME_INDEX_INTERVAL,
+      g_param_spec_uint ("frame-index-interval", "Frame index interval",
+          "Scan the file in the background and index every Nth frame "
+          "(0 = disabled)", 0, G_MAXUINT, DEFAULT_FRAME_INDEX_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   parse_class->start = GST_DEBUG_FUNCPTR (gst_mpeg_audio_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_mpeg_audio_parse_stop);
@@ -225,6 +261,7 @@ gst_mpeg_audio_parse_reset (GstMpegAudioParse * mp3parse)
 static void
 gst_mpeg_audio_parse_init (GstMpegAudioParse * mp3parse)
 {
+  mp3parse->frame_index_interval = DEFAULT_FRAME_INDEX_INTERVAL;
   gst_mpeg_audio_parse_reset (mp3parse);
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (mp3parse));
 }
@@ -235,6 +272,38 @@ gst_mpeg_audio_parse_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_mpeg_audio_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstMpegAudioParse *mp3parse = GST_MPEG_AUDIO_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_FRAME_INDEX_INTERVAL:
+      mp3parse->frame_index_interval = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_mpeg_audio_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstMpegAudioParse *mp3parse = GST_MPEG_AUDIO_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_FRAME_INDEX_INTERVAL:
+      g_value_set_uint (value, mp3parse->frame_index_interval);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static gboolean
 gst_mpeg_audio_parse_start (GstBaseParse * parse)
 {
@@ -255,6 +324,7 @@ gst_mpeg_audio_parse_stop (GstBaseParse * parse)
 
   GST_DEBUG_OBJECT (parse, "stopping");
 
+  gst_mpeg_audio_parse_stop_frame_index (mp3parse);
   gst_mpeg_audio_parse_reset (mp3parse);
 
   return TRUE;
@@ -621,8 +691,7 @@ gst_mpeg_audio_parse_handle_frame (GstBaseParse * parse,
 
   gst_byte_reader_init (&reader, map.data, map.size);
 
-  off = gst_byte_reader_masked_scan_uint32 (&reader, 0xffe00000, 0xffe00000,
-      0, map.size);
+  off = gst_sync_scan_uint32 (&reader, 0xffe00000, 0xffe00000, 0, map.size);
 
   GST_LOG_OBJECT (parse, "possible sync at buffer offset %d", off);
 
@@ -757,7 +826,7 @@ gst_mpeg_audio_parse_handle_frame (GstBaseParse * parse,
   mp3parse->hdr_bitrate = bitrate;
 
   /* For first frame; check for seek tables and output a codec tag */
-  gst_mpeg_audio_parse_handle_first_frame (mp3parse, buf);
+  gst_mpeg_audio_parse_handle_first_frame (mp3parse, buf, frame->offset);
 
   /* store some frame info for later processing */
   mp3parse->last_crc = crc;
@@ -773,9 +842,142 @@ cleanup:
   return GST_FLOW_OK;
 }
 
+typedef struct
+{
+  GstMpegAudioParse *mp3parse;
+  guint64 offset;
+  guint32 header;
+  gint rate;
+  gint spf;
+  guint interval;
+} GstMpegAudioParseIndexData;
+
+/* walks all frame headers from the first frame on and adds an index entry
+ * to the base class every interval frames */
+static gpointer
+gst_mpeg_audio_parse_frame_index_func (GstMpegAudioParseIndexData * data)
+{
+  GstMpegAudioParse *mp3parse = data->mp3parse;
+  GstBaseParse *parse = GST_BASE_PARSE (mp3parse);
+  GstBuffer *block = NULL;
+  GstMapInfo map = { 0, };
+  guint64 offset = data->offset, block_offset = 0;
+  guint64 frames = 0;
+  guint32 header;
+  guint length;
+  GstFlowReturn ret;
+
+  GST_DEBUG_OBJECT (mp3parse, "building frame index from offset %"
+      G_GUINT64_FORMAT, offset);
+
+  while (!g_atomic_int_get (&mp3parse->frame_index_stop)) {
+    /* make sure the next header is in the current block */
+    if (!block || offset + 4 > block_offset + map.size) {
+      if (block) {
+        gst_buffer_unmap (block, &map);
+        gst_buffer_unref (block);
+        block = NULL;
+      }
+      ret = gst_pad_pull_range (GST_BASE_PARSE_SINK_PAD (parse), offset,
+          FRAME_INDEX_BLOCK_SIZE, &block);
+      if (ret == GST_FLOW_FLUSHING) {
+        /* seeking, try again a bit later */
+        g_usleep (G_USEC_PER_SEC / 100);
+        continue;
+      } else if (ret != GST_FLOW_OK) {
+        break;
+      }
+      gst_buffer_map (block, &map, GST_MAP_READ);
+      block_offset = offset;
+      if (map.size < 4)
+        break;
+    }
+
+    header = GST_READ_UINT32_BE (map.data + offset - block_offset);
+
+    /* stop at the first thing that is not a frame like the first one */
+    if ((header & 0xfffe0c00) != (data->header & 0xfffe0c00) ||
+        ((header >> 12) & 0xf) == 0xf)
+      break;
+    length = mp3_type_frame_length_from_header (mp3parse, header,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    if (length == 0)
+      break;
+
+    if (frames % data->interval == 0)
+      gst_base_parse_add_index_entry (parse, offset,
+          gst_util_uint64_scale (frames * data->spf, GST_SECOND, data->rate),
+          TRUE, FALSE);
+
+    offset += length;
+    frames++;
+  }
+
+  if (block) {
+    gst_buffer_unmap (block, &map);
+    gst_buffer_unref (block);
+  }
+
+  GST_DEBUG_OBJECT (mp3parse, "frame index done after %" G_GUINT64_FORMAT
+      " frames, at offset %" G_GUINT64_FORMAT, frames, offset);
+
+  g_free (data);
+  return NULL;
+}
+
+static void
+gst_mpeg_audio_parse_start_frame_index (GstMpegAudioParse * mp3parse,
+    GstBuffer * buf, guint64 offset)
+{
+  GstMpegAudioParseIndexData *data;
+  GstPad *sinkpad = GST_BASE_PARSE_SINK_PAD (mp3parse);
+
+  if (mp3parse->frame_index_interval == 0 || mp3parse->frame_index_thread)
+    return;
+
+  /* the tables already give an exact mapping */
+  if ((mp3parse->xing_flags & XING_TOC_FLAG) ||
+      (mp3parse->vbri_seek_table && mp3parse->vbri_valid))
+    return;
+
+  /* we need to be able to pull and frames of known sizes */
+  if (GST_PAD_MODE (sinkpad) != GST_PAD_MODE_PULL || mp3parse->freerate ||
+      mp3parse->rate <= 0 || mp3parse->spf <= 0 ||
+      gst_buffer_get_size (buf) < 4)
+    return;
+
+  data = g_new0 (GstMpegAudioParseIndexData, 1);
+  data->mp3parse = mp3parse;
+  data->offset = offset;
+  gst_buffer_extract (buf, 0, &data->header, 4);
+  data->header = GUINT32_FROM_BE (data->header);
+  data->rate = mp3parse->rate;
+  data->spf = mp3parse->spf;
+  data->interval = mp3parse->frame_index_interval;
+
+  g_atomic_int_set (&mp3parse->frame_index_stop, 0);
+  mp3parse->frame_index_thread = g_thread_try_new ("mpegaudioparse-index",
+      (GThreadFunc) gst_mpeg_audio_parse_frame_index_func, data, NULL);
+  if (!mp3parse->frame_index_thread) {
+    GST_WARNING_OBJECT (mp3parse, "could not start frame index thread");
+    g_free (data);
+  }
+}
+
+static void
+gst_mpeg_audio_parse_stop_frame_index (GstMpegAudioParse * mp3parse)
+{
+  if (!mp3parse->frame_index_thread)
+    return;
+
+  g_atomic_int_set (&mp3parse->frame_index_stop, 1);
+  g_thread_join (mp3parse->frame_index_thread);
+  mp3parse->frame_index_thread = NULL;
+}
+
 static void
 gst_mpeg_audio_parse_handle_first_frame (GstMpegAudioParse * mp3parse,
-    GstBuffer * buf)
+    GstBuffer * buf, guint64 offset)
 {
   const guint32 xing_id = 0x58696e67;   /* 'Xing' in hex */
   const guint32 info_id = 0x496e666f;   /* 'Info' in hex - found in LAME CBR files */
@@ -1170,6 +1372,9 @@ gst_mpeg_audio_parse_handle_first_frame (GstMpegAudioParse * mp3parse,
 
   gst_base_parse_set_average_bitrate (GST_BASE_PARSE (mp3parse), bitrate);
 
+  /* no exact seek table, build an index instead */
+  gst_mpeg_audio_parse_start_frame_index (mp3parse, buf, offset);
+
 cleanup:
   gst_buffer_unmap (buf, &map);
 }
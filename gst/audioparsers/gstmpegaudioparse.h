@@ -94,6 +94,11 @@ struct _GstMpegAudioParse {
   /* LAME info */
   guint32      encoder_delay;
   guint32      encoder_padding;
+
+  /* background frame index */
+  guint        frame_index_interval;
+  GThread     *frame_index_thread;
+  volatile gint frame_index_stop;
 };
 
 /**
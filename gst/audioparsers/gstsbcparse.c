@@ -45,6 +45,14 @@
 
 #define SBC_SYNCBYTE 0x9C
 
+#define DEFAULT_PACKET_SIZE 0
+
+enum
+{
+  PROP_0,
+  PROP_PACKET_SIZE
+};
+
 GST_DEBUG_CATEGORY_STATIC (sbcparse_debug);
 #define GST_CAT_DEFAULT sbcparse_debug
 
@@ -62,6 +70,11 @@ static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_STATIC_CAPS ("audio/x-sbc")
     );
 
+static void gst_sbc_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_sbc_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
 static gboolean gst_sbc_parse_start (GstBaseParse * parse);
 static gboolean gst_sbc_parse_stop (GstBaseParse * parse);
 static GstFlowReturn gst_sbc_parse_handle_frame (GstBaseParse * parse,
@@ -86,9 +99,29 @@ gst_sbc_parse_class_init (GstSbcParseClass * klass)
 {
   GstBaseParseClass *baseparse_class = GST_BASE_PARSE_CLASS (klass);
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 
   GST_DEBUG_CATEGORY_INIT (sbcparse_debug, "sbcparse", 0, "SBC audio parser");
 
+  gobject_class->set_property = gst_sbc_parse_set_property;
+  gobject_class->get_property = gst_sbc_parse_get_property;
+
+  /**
+   * GstSbcParse:packet-size:
+   *
+   * Pack as many frames as fit in this many bytes into each output buffer
+   * and wait for enough data to fill it, so that a payloader with the
+   * matching MTU can send each buffer as one packet. 0 packs whatever
+   * frames are available.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_PACKET_SIZE,
+      g_param_spec_uint ("packet-size", "Packet size",
+          "Pack frames into buffers of up to this many bytes "
+          "(0 = as many frames as are available)", 0, G_MAXUINT,
+          DEFAULT_PACKET_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   baseparse_class->start = GST_DEBUG_FUNCPTR (gst_sbc_parse_start);
   baseparse_class->stop = GST_DEBUG_FUNCPTR (gst_sbc_parse_stop);
   baseparse_class->pre_push_frame =
@@ -125,6 +158,39 @@ gst_sbc_parse_init (GstSbcParse * sbcparse)
 {
   gst_sbc_parse_reset (sbcparse);
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (sbcparse));
+  sbcparse->packet_size = DEFAULT_PACKET_SIZE;
+}
+
+static void
+gst_sbc_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstSbcParse *sbcparse = GST_SBC_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_PACKET_SIZE:
+      sbcparse->packet_size = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_sbc_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstSbcParse *sbcparse = GST_SBC_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_PACKET_SIZE:
+      g_value_set_uint (value, sbcparse->packet_size);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 static gboolean
@@ -189,7 +255,7 @@ gst_sbc_parse_handle_frame (GstBaseParse * parse, GstBaseParseFrame * frame,
   GstMapInfo map;
   guint rate = 0, n_blocks = 0, n_subbands = 0, bitpool = 0;
   gsize frame_len, next_len;
-  gint i, max_frames;
+  gint i, max_frames, target_frames = 0;
 
   gst_buffer_map (frame->buffer, &map, GST_MAP_READ);
 
@@ -246,9 +312,15 @@ gst_sbc_parse_handle_frame (GstBaseParse * parse, GstBaseParseFrame * frame,
   GST_BUFFER_OFFSET (frame->buffer) = GST_BUFFER_OFFSET_NONE;
   GST_BUFFER_OFFSET_END (frame->buffer) = GST_BUFFER_OFFSET_NONE;
 
-  /* completely arbitrary limit, we only process data we already have,
-   * so we aren't introducing latency here */
-  max_frames = MIN (map.size / frame_len, n_blocks * n_subbands * 5);
+  if (sbcparse->packet_size > 0) {
+    /* fill the target packet, at least one frame */
+    target_frames = MAX (sbcparse->packet_size / frame_len, 1);
+    max_frames = MIN (map.size / frame_len, target_frames);
+  } else {
+    /* completely arbitrary limit, we only process data we already have,
+     * so we aren't introducing latency here */
+    max_frames = MIN (map.size / frame_len, n_blocks * n_subbands * 5);
+  }
   GST_LOG_OBJECT (sbcparse, "parsing up to %d frames", max_frames);
 
   for (i = 1; i < max_frames; ++i) {
@@ -262,6 +334,14 @@ gst_sbc_parse_handle_frame (GstBaseParse * parse, GstBaseParseFrame * frame,
       break;
     }
   }
+
+  /* all frames matched but the packet isn't full yet, wait for the rest */
+  if (i < target_frames && i == max_frames
+      && !GST_BASE_PARSE_DRAINING (parse)) {
+    frame_len *= target_frames;
+    goto need_more_data;
+  }
+
   GST_LOG_OBJECT (sbcparse, "packing %d SBC frames into next output buffer", i);
 
   /* Note: local n_subbands and n_blocks variables might be tainted if we
@@ -63,6 +63,8 @@ struct _GstSbcParse {
   gint                    bitpool;
 
   gboolean                sent_codec_tag;
+
+  guint                   packet_size;
 };
 
 struct _GstSbcParseClass {
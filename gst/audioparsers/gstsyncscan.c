@@ -0,0 +1,174 @@
+/* GStreamer audio parsers
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Sync word scanning shared by the audio parsers.
+ *
+ * All sync patterns handled here have a fully significant first byte, so
+ * candidate positions are found by looking for that byte first: with
+ * memchr() for a single pattern, which the C library implements with
+ * vector instructions, and 8 bytes at a time for several patterns. Only
+ * candidates are then compared against the masked pattern. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstsyncscan.h"
+
+#define ONES  G_GUINT64_CONSTANT (0x0101010101010101)
+#define HIGHS G_GUINT64_CONSTANT (0x8080808080808080)
+
+/* non-zero if any byte of @w is 0 */
+#define HAS_ZERO_BYTE(w) (((w) - ONES) & ~(w) & HIGHS)
+
+static inline gboolean
+gst_sync_scan_check_params (const GstByteReader * reader, guint32 mask,
+    guint offset, guint size)
+{
+  return size >= 4 && (mask >> 24) == 0xff &&
+      offset + size <= reader->size - reader->byte;
+}
+
+/**
+ * gst_sync_scan_uint32:
+ * @reader: a #GstByteReader
+ * @mask: mask to apply to data before matching against @pattern
+ * @pattern: pattern to match (after mask is applied)
+ * @offset: offset from which to start scanning, relative to the current
+ *     position
+ * @size: number of bytes to scan from offset
+ *
+ * Drop-in replacement for gst_byte_reader_masked_scan_uint32() that is
+ * faster for patterns whose first byte is fully masked.
+ *
+ * Returns: offset of the first match, or -1 if no match was found.
+ */
+guint
+gst_sync_scan_uint32 (const GstByteReader * reader, guint32 mask,
+    guint32 pattern, guint offset, guint size)
+{
+  const guint8 *data, *p, *end;
+  guint8 first;
+
+  if (!gst_sync_scan_check_params (reader, mask, offset, size))
+    return gst_byte_reader_masked_scan_uint32 (reader, mask, pattern, offset,
+        size);
+
+  data = reader->data + reader->byte + offset;
+  /* one past the last position a pattern can start at */
+  end = data + size - 3;
+  first = pattern >> 24;
+
+  for (p = data; p < end; p++) {
+    p = memchr (p, first, end - p);
+    if (p == NULL)
+      break;
+    if ((GST_READ_UINT32_BE (p) & mask) == pattern)
+      return offset + (p - data);
+  }
+
+  return -1;
+}
+
+/**
+ * gst_sync_scan_uint32_any:
+ * @reader: a #GstByteReader
+ * @masks: masks to apply to data before matching against @patterns
+ * @patterns: patterns to match (after the mask is applied)
+ * @n_patterns: number of masks and patterns, at most 8
+ * @offset: offset from which to start scanning, relative to the current
+ *     position
+ * @size: number of bytes to scan from offset
+ * @found: (out): index of the pattern that matched
+ *
+ * Finds the first position where any of @patterns matches in a single
+ * pass over the data.
+ *
+ * Returns: offset of the first match, or -1 if no match was found.
+ */
+guint
+gst_sync_scan_uint32_any (const GstByteReader * reader, const guint32 * masks,
+    const guint32 * patterns, guint n_patterns, guint offset, guint size,
+    guint * found)
+{
+  guint64 firsts[8];
+  const guint8 *data;
+  guint i, j, pos, n_pos;
+
+  g_return_val_if_fail (n_patterns > 0 && n_patterns <= 8, -1);
+
+  for (j = 0; j < n_patterns; j++) {
+    if (!gst_sync_scan_check_params (reader, masks[j], offset, size))
+      goto fallback;
+    firsts[j] = ONES * (patterns[j] >> 24);
+  }
+
+  data = reader->data + reader->byte + offset;
+  n_pos = size - 3;
+
+  for (pos = 0; pos < n_pos;) {
+    guint n = MIN (8, n_pos - pos);
+
+    if (n == 8) {
+      guint64 w, any = 0;
+
+      /* skip words that contain none of the first bytes */
+      memcpy (&w, data + pos, 8);
+      for (j = 0; j < n_patterns; j++)
+        any |= HAS_ZERO_BYTE (w ^ firsts[j]);
+      if (!any) {
+        pos += 8;
+        continue;
+      }
+    }
+
+    for (i = pos; i < pos + n; i++) {
+      guint32 v = GST_READ_UINT32_BE (data + i);
+
+      for (j = 0; j < n_patterns; j++) {
+        if ((v & masks[j]) == patterns[j]) {
+          *found = j;
+          return offset + i;
+        }
+      }
+    }
+    pos += n;
+  }
+
+  return -1;
+
+fallback:
+  {
+    guint best = -1;
+
+    /* scan for each pattern separately */
+    for (j = 0; j < n_patterns; j++) {
+      guint off = gst_byte_reader_masked_scan_uint32 (reader, masks[j],
+          patterns[j], offset, size);
+
+      if (off != (guint) - 1 && (best == (guint) - 1 || off < best)) {
+        best = off;
+        *found = j;
+      }
+    }
+    return best;
+  }
+}
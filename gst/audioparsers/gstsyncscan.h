@@ -0,0 +1,39 @@
+/* GStreamer audio parsers
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_SYNC_SCAN_H__
+#define __GST_SYNC_SCAN_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbytereader.h>
+
+G_BEGIN_DECLS
+
+guint gst_sync_scan_uint32     (const GstByteReader * reader,
+                                guint32 mask, guint32 pattern,
+                                guint offset, guint size);
+
+guint gst_sync_scan_uint32_any (const GstByteReader * reader,
+                                const guint32 * masks,
+                                const guint32 * patterns, guint n_patterns,
+                                guint offset, guint size, guint * found);
+
+G_END_DECLS
+
+#endif /* __GST_SYNC_SCAN_H__ */
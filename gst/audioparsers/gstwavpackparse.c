@@ -63,7 +63,19 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS ("audio/x-wavpack"));
 
+#define DEFAULT_FRAME_INDEX_INTERVAL 0
+
+enum
+{
+  PROP_0,
+  PROP_FRAME_INDEX_INTERVAL
+};
+
 static void gst_wavpack_parse_finalize (GObject * object);
+static void gst_wavpack_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_wavpack_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static gboolean gst_wavpack_parse_start (GstBaseParse * parse);
 static gboolean gst_wavpack_parse_stop (GstBaseParse * parse);
@@ -88,6 +100,24 @@ gst_wavpack_parse_class_init (GstWavpackParseClass * klass)
       "Wavpack audio stream parser");
 
   object_class->finalize = gst_wavpack_parse_finalize;
+  object_class->set_property = gst_wavpack_parse_set_property;
+  object_class->get_property = gst_wavpack_parse_get_property;
+
+  /**
+   * GstWavpackParse:frame-index-interval:
+   *
+   * When operating in pull mode, walk the block headers of the file in a
+   * background thread, jumping from block to block, and add an index entry
+   * every so many blocks so that seeks land on the right block without
+   * scanning for the next sync. 0 disables the scan.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (object_class, PROP_FRAME_INDEX_INTERVAL,
+      g_param_spec_uint ("frame-index-interval", "Frame index interval",
+          "Scan the file in the background and index every Nth block "
+          "(0 = disabled)", 0, G_MAXUINT, DEFAULT_FRAME_INDEX_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   parse_class->start = GST_DEBUG_FUNCPTR (gst_wavpack_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_wavpack_parse_stop);
@@ -124,6 +154,7 @@ gst_wavpack_parse_init (GstWavpackParse * wvparse)
 {
   gst_wavpack_parse_reset (wvparse);
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (wvparse));
+  wvparse->frame_index_interval = DEFAULT_FRAME_INDEX_INTERVAL;
 }
 
 static void
@@ -132,6 +163,38 @@ gst_wavpack_parse_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_wavpack_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstWavpackParse *wvparse = GST_WAVPACK_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_FRAME_INDEX_INTERVAL:
+      wvparse->frame_index_interval = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_wavpack_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstWavpackParse *wvparse = GST_WAVPACK_PARSE (object);
+
+  switch (prop_id) {
+    case PROP_FRAME_INDEX_INTERVAL:
+      g_value_set_uint (value, wvparse->frame_index_interval);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static gboolean
 gst_wavpack_parse_start (GstBaseParse * parse)
 {
@@ -155,8 +218,15 @@ gst_wavpack_parse_start (GstBaseParse * parse)
 static gboolean
 gst_wavpack_parse_stop (GstBaseParse * parse)
 {
+  GstWavpackParse *wvparse = GST_WAVPACK_PARSE (parse);
+
   GST_DEBUG_OBJECT (parse, "stopping");
 
+  if (wvparse->frame_index) {
+    gst_frame_index_stop (wvparse->frame_index);
+    wvparse->frame_index = NULL;
+  }
+
   return TRUE;
 }
 
@@ -440,6 +510,41 @@ gst_wavpack_parse_frame_header (GstWavpackParse * parse, GstBuffer * buf,
   return TRUE;
 }
 
+/* #GstFrameIndexParseFunc for WavPack blocks. The next block is found by
+ * jumping over ckSize, and only the initial block of a block set starts a
+ * seek point. @user_data points to the block_index the next initial block
+ * must have, which keeps the index exact: the scan stops at any gap. */
+static guint
+gst_wavpack_parse_index_block (const guint8 * data, guint size,
+    guint * samples, gpointer user_data)
+{
+  guint32 *next = user_data;
+  guint32 ck_size, block_index, block_samples, flags;
+  guint16 version;
+
+  if (GST_READ_UINT32_BE (data) != 0x7776706b)
+    return 0;
+
+  ck_size = GST_READ_UINT32_LE (data + 4);
+  version = GST_READ_UINT16_LE (data + 8);
+  block_index = GST_READ_UINT32_LE (data + 16);
+  block_samples = GST_READ_UINT32_LE (data + 20);
+  flags = GST_READ_UINT32_LE (data + 24);
+
+  if (ck_size < sizeof (WavpackHeader) - 8 || version < 0x402
+      || version > 0x410)
+    return 0;
+
+  if ((flags & FLAG_INITIAL_BLOCK) && block_samples > 0) {
+    if (block_index != *next)
+      return 0;
+    *samples = block_samples;
+    *next = block_index + block_samples;
+  }
+
+  return ck_size + 8;
+}
+
 static GstFlowReturn
 gst_wavpack_parse_handle_frame (GstBaseParse * parse,
     GstBaseParseFrame * frame, gint * skipsize)
@@ -596,6 +701,16 @@ gst_wavpack_parse_handle_frame (GstBaseParse * parse,
     }
   }
 
+  /* the index times are counted from the start of the file */
+  if (G_UNLIKELY (wvparse->frame_index_interval > 0
+          && wvparse->frame_index == NULL && wph.block_index == 0
+          && !wpi.correction)) {
+    wvparse->frame_index_next = 0;
+    wvparse->frame_index = gst_frame_index_start (parse, frame->offset,
+        sizeof (WavpackHeader), rate, wvparse->frame_index_interval,
+        gst_wavpack_parse_index_block, &wvparse->frame_index_next);
+  }
+
   /* return to normal size */
   gst_base_parse_set_min_frame_size (parse, sizeof (WavpackHeader));
   gst_buffer_unmap (buf, &map);
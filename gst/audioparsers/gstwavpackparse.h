@@ -25,6 +25,8 @@
 #include <gst/gst.h>
 #include <gst/base/gstbaseparse.h>
 
+#include "gstframeindex.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_WAVPACK_PARSE \
@@ -67,6 +69,7 @@ G_BEGIN_DECLS
 #define ID_MD5_CHECKSUM         (ID_OPTIONAL_DATA | 0x6)
 #define ID_SAMPLE_RATE          (ID_OPTIONAL_DATA | 0x7)
 
+#define FLAG_INITIAL_BLOCK      (1 << 11)
 #define FLAG_FINAL_BLOCK        (1 << 12)
 
 typedef struct {
@@ -114,6 +117,10 @@ struct _GstWavpackParse {
   guint         total_samples;
 
   gboolean      sent_codec_tag;
+
+  guint          frame_index_interval;
+  GstFrameIndex *frame_index;
+  guint32        frame_index_next;
 };
 
 /**
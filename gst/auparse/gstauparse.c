@@ -22,6 +22,9 @@
  * SECTION:element-auparse
  *
  * Parses .au files mostly originating from sun os based computers.
+ *
+ * When upstream supports it, the file is read in pull mode in large blocks
+ * of whole frames which are pushed downstream without copying.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -99,6 +102,14 @@ static gboolean gst_au_parse_sink_event (GstPad * pad, GstObject * parent,
 static gboolean gst_au_parse_src_convert (GstAuParse * auparse,
     GstFormat src_format, gint64 srcval, GstFormat dest_format,
     gint64 * destval);
+static gboolean gst_au_parse_sink_activate (GstPad * sinkpad,
+    GstObject * parent);
+static gboolean gst_au_parse_sink_activate_mode (GstPad * sinkpad,
+    GstObject * parent, GstPadMode mode, gboolean active);
+static void gst_au_parse_loop (GstPad * pad);
+
+/* amount of data read at once in pull mode, rounded down to whole frames */
+#define AU_PULL_BLOCK_SIZE (64 * 1024)
 
 #define gst_au_parse_parent_class parent_class
 G_DEFINE_TYPE (GstAuParse, gst_au_parse, GST_TYPE_ELEMENT);
@@ -137,6 +148,10 @@ gst_au_parse_init (GstAuParse * auparse)
       GST_DEBUG_FUNCPTR (gst_au_parse_chain));
   gst_pad_set_event_function (auparse->sinkpad,
       GST_DEBUG_FUNCPTR (gst_au_parse_sink_event));
+  gst_pad_set_activate_function (auparse->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_au_parse_sink_activate));
+  gst_pad_set_activatemode_function (auparse->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_au_parse_sink_activate_mode));
   gst_element_add_pad (GST_ELEMENT (auparse), auparse->sinkpad);
 
   auparse->srcpad = gst_pad_new_from_static_template (&src_template, "src");
@@ -168,6 +183,7 @@ gst_au_parse_reset (GstAuParse * auparse)
 {
   auparse->offset = 0;
   auparse->buffer_offset = 0;
+  auparse->end_offset = -1;
   auparse->encoding = 0;
   auparse->samplerate = 0;
   auparse->channels = 0;
@@ -175,6 +191,7 @@ gst_au_parse_reset (GstAuParse * auparse)
   gst_adapter_clear (auparse->adapter);
 
   gst_caps_replace (&auparse->src_caps, NULL);
+  gst_event_replace (&auparse->pending_segment, NULL);
 
   /* gst_segment_init (&auparse->segment, GST_FORMAT_TIME); */
 }
@@ -412,15 +429,47 @@ unknown_format:
 
 #define AU_HEADER_SIZE 24
 
+/* timestamps @outbuf, which contains whole frames from the current position,
+ * and pushes it */
+static GstFlowReturn
+gst_au_parse_push_data (GstAuParse * auparse, GstBuffer * outbuf)
+{
+  gint64 timestamp;
+  gint64 duration;
+  gint64 offset;
+  gint64 pos;
+  gsize size;
+
+  outbuf = gst_buffer_make_writable (outbuf);
+  size = gst_buffer_get_size (outbuf);
+
+  pos = auparse->buffer_offset - auparse->offset;
+  pos = MAX (pos, 0);
+
+  if (auparse->sample_size > 0 && auparse->samplerate > 0) {
+    gst_au_parse_src_convert (auparse, GST_FORMAT_BYTES, pos,
+        GST_FORMAT_DEFAULT, &offset);
+    gst_au_parse_src_convert (auparse, GST_FORMAT_BYTES, pos,
+        GST_FORMAT_TIME, &timestamp);
+    gst_au_parse_src_convert (auparse, GST_FORMAT_BYTES,
+        size, GST_FORMAT_TIME, &duration);
+
+    GST_BUFFER_OFFSET (outbuf) = offset;
+    GST_BUFFER_TIMESTAMP (outbuf) = timestamp;
+    GST_BUFFER_DURATION (outbuf) = duration;
+  }
+
+  auparse->buffer_offset += size;
+
+  return gst_pad_push (auparse->srcpad, outbuf);
+}
+
 static GstFlowReturn
 gst_au_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
   GstFlowReturn ret = GST_FLOW_OK;
   GstAuParse *auparse;
   gint avail, sendnow = 0;
-  gint64 timestamp;
-  gint64 duration;
-  gint64 offset;
   GstSegment segment;
 
   auparse = GST_AU_PARSE (parent);
@@ -460,35 +509,145 @@ gst_au_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 
   if (sendnow > 0) {
     GstBuffer *outbuf;
-    gint64 pos;
 
+    /* this is a sub-buffer of the input unless a frame straddles two input
+     * buffers */
     outbuf = gst_adapter_take_buffer (auparse->adapter, sendnow);
-    outbuf = gst_buffer_make_writable (outbuf);
-
-    pos = auparse->buffer_offset - auparse->offset;
-    pos = MAX (pos, 0);
-
-    if (auparse->sample_size > 0 && auparse->samplerate > 0) {
-      gst_au_parse_src_convert (auparse, GST_FORMAT_BYTES, pos,
-          GST_FORMAT_DEFAULT, &offset);
-      gst_au_parse_src_convert (auparse, GST_FORMAT_BYTES, pos,
-          GST_FORMAT_TIME, &timestamp);
-      gst_au_parse_src_convert (auparse, GST_FORMAT_BYTES,
-          sendnow, GST_FORMAT_TIME, &duration);
-
-      GST_BUFFER_OFFSET (outbuf) = offset;
-      GST_BUFFER_TIMESTAMP (outbuf) = timestamp;
-      GST_BUFFER_DURATION (outbuf) = duration;
+    ret = gst_au_parse_push_data (auparse, outbuf);
+  }
+
+out:
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_au_parse_pull_header (GstAuParse * auparse)
+{
+  GstFlowReturn ret;
+  GstBuffer *buf = NULL;
+  GstMapInfo map;
+  guint32 size;
+
+  ret = gst_pad_pull_range (auparse->sinkpad, 0, AU_HEADER_SIZE, &buf);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  if (gst_buffer_get_size (buf) < AU_HEADER_SIZE) {
+    gst_buffer_unref (buf);
+    return GST_FLOW_EOS;
+  }
+
+  /* pull the complete header including any annotation */
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  size = GST_READ_UINT32_BE (map.data + 4);
+  gst_buffer_unmap (buf, &map);
+
+  if (size > AU_HEADER_SIZE) {
+    gst_buffer_unref (buf);
+    buf = NULL;
+    ret = gst_pad_pull_range (auparse->sinkpad, 0, size, &buf);
+    if (ret != GST_FLOW_OK)
+      return ret;
+    if (gst_buffer_get_size (buf) < size) {
+      gst_buffer_unref (buf);
+      return GST_FLOW_EOS;
     }
+  }
+
+  gst_adapter_push (auparse->adapter, buf);
+  ret = gst_au_parse_parse_header (auparse);
+  gst_adapter_clear (auparse->adapter);
+  if (ret != GST_FLOW_OK)
+    return ret;
 
-    auparse->buffer_offset += sendnow;
+  auparse->buffer_offset = auparse->offset;
+  if (auparse->pending_segment == NULL) {
+    GstSegment segment;
 
-    ret = gst_pad_push (auparse->srcpad, outbuf);
+    gst_segment_init (&segment, GST_FORMAT_TIME);
+    auparse->pending_segment = gst_event_new_segment (&segment);
   }
 
-out:
+  return GST_FLOW_OK;
+}
 
-  return ret;
+static void
+gst_au_parse_loop (GstPad * pad)
+{
+  GstAuParse *auparse = GST_AU_PARSE (GST_PAD_PARENT (pad));
+  GstFlowReturn ret;
+  GstBuffer *buf = NULL;
+  gint64 blocksize;
+  gsize size;
+
+  if (auparse->src_caps == NULL) {
+    ret = gst_au_parse_pull_header (auparse);
+    if (ret != GST_FLOW_OK)
+      goto pause;
+  }
+
+  if (auparse->pending_segment) {
+    gst_pad_push_event (auparse->srcpad, auparse->pending_segment);
+    auparse->pending_segment = NULL;
+  }
+
+  blocksize = AU_PULL_BLOCK_SIZE;
+  if (auparse->sample_size > 0)
+    blocksize = MAX (blocksize - blocksize % auparse->sample_size,
+        auparse->sample_size);
+  if (auparse->end_offset >= 0)
+    blocksize = MIN (blocksize, auparse->end_offset - auparse->buffer_offset);
+  if (blocksize <= 0) {
+    ret = GST_FLOW_EOS;
+    goto pause;
+  }
+
+  ret = gst_pad_pull_range (pad, auparse->buffer_offset, blocksize, &buf);
+  if (ret != GST_FLOW_OK)
+    goto pause;
+
+  /* drop a partial frame at the end of the file */
+  size = gst_buffer_get_size (buf);
+  if (auparse->sample_size > 0)
+    size -= size % auparse->sample_size;
+  if (size == 0) {
+    gst_buffer_unref (buf);
+    ret = GST_FLOW_EOS;
+    goto pause;
+  }
+  if (size != gst_buffer_get_size (buf)) {
+    buf = gst_buffer_make_writable (buf);
+    gst_buffer_resize (buf, 0, size);
+  }
+
+  ret = gst_au_parse_push_data (auparse, buf);
+  if (ret != GST_FLOW_OK)
+    goto pause;
+
+  return;
+
+  /* ERRORS */
+pause:
+  {
+    const gchar *reason = gst_flow_get_name (ret);
+
+    GST_DEBUG_OBJECT (auparse, "pausing task, reason %s", reason);
+    gst_pad_pause_task (pad);
+
+    if (ret == GST_FLOW_EOS) {
+      if (auparse->src_caps == NULL) {
+        GST_ELEMENT_ERROR (auparse, STREAM, WRONG_TYPE, (NULL),
+            ("No valid input found before end of stream"));
+      }
+      gst_pad_push_event (auparse->srcpad, gst_event_new_eos ());
+    } else if (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS) {
+      GST_ELEMENT_ERROR (auparse, STREAM, FAILED, (NULL),
+          ("streaming stopped, reason %s", reason));
+      gst_pad_push_event (auparse->srcpad, gst_event_new_eos ());
+    }
+    return;
+  }
 }
 
 static gboolean
@@ -600,8 +759,11 @@ gst_au_parse_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
       gint64 pos, val;
 
       gst_query_parse_position (query, &format, NULL);
-      if (!gst_pad_peer_query_position (auparse->sinkpad, GST_FORMAT_BYTES,
-              &pos)) {
+      if (GST_PAD_MODE (auparse->sinkpad) == GST_PAD_MODE_PULL) {
+        /* we know exactly where we are reading */
+        pos = auparse->buffer_offset;
+      } else if (!gst_pad_peer_query_position (auparse->sinkpad,
+              GST_FORMAT_BYTES, &pos)) {
         GST_DEBUG_OBJECT (auparse, "failed to query upstream position");
         break;
       }
@@ -636,6 +798,66 @@ gst_au_parse_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
   return ret;
 }
 
+/* seek to the byte positions @start and @stop within the sample data */
+static gboolean
+gst_au_parse_do_pull_seek (GstAuParse * auparse, gdouble rate,
+    GstSeekFlags flags, GstSeekType start_type, gint64 start,
+    GstSeekType stop_type, gint64 stop)
+{
+  GstSegment segment;
+  gboolean flush;
+  gint64 time;
+
+  if (rate <= 0.0 || auparse->sample_size == 0 ||
+      (start_type != GST_SEEK_TYPE_SET && start_type != GST_SEEK_TYPE_NONE)) {
+    GST_DEBUG_OBJECT (auparse, "unsupported seek");
+    return FALSE;
+  }
+
+  flush = ! !(flags & GST_SEEK_FLAG_FLUSH);
+
+  if (flush)
+    gst_pad_push_event (auparse->srcpad, gst_event_new_flush_start ());
+  else
+    gst_pad_pause_task (auparse->sinkpad);
+
+  GST_PAD_STREAM_LOCK (auparse->sinkpad);
+
+  if (flush)
+    gst_pad_push_event (auparse->srcpad, gst_event_new_flush_stop (TRUE));
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  segment.rate = rate;
+
+  if (start_type == GST_SEEK_TYPE_SET) {
+    start = MAX (start, 0);
+    start -= start % auparse->sample_size;
+    auparse->buffer_offset = auparse->offset + start;
+  }
+  if (gst_au_parse_src_convert (auparse, GST_FORMAT_BYTES,
+          auparse->buffer_offset - auparse->offset, GST_FORMAT_TIME, &time))
+    segment.start = segment.time = segment.position = time;
+
+  if (stop_type == GST_SEEK_TYPE_SET && stop >= 0) {
+    auparse->end_offset = auparse->offset + stop;
+    if (gst_au_parse_src_convert (auparse, GST_FORMAT_BYTES, stop,
+            GST_FORMAT_TIME, &time))
+      segment.stop = time;
+  } else if (stop_type == GST_SEEK_TYPE_SET) {
+    auparse->end_offset = -1;
+  }
+
+  gst_event_replace (&auparse->pending_segment, NULL);
+  auparse->pending_segment = gst_event_new_segment (&segment);
+
+  gst_pad_start_task (auparse->sinkpad, (GstTaskFunction) gst_au_parse_loop,
+      auparse->sinkpad, NULL);
+
+  GST_PAD_STREAM_UNLOCK (auparse->sinkpad);
+
+  return TRUE;
+}
+
 static gboolean
 gst_au_parse_handle_seek (GstAuParse * auparse, GstEvent * event)
 {
@@ -665,6 +887,10 @@ gst_au_parse_handle_seek (GstAuParse * auparse, GstEvent * event)
   GST_INFO_OBJECT (auparse,
       "seeking: %" G_GINT64_FORMAT " ... %" G_GINT64_FORMAT, start, stop);
 
+  if (GST_PAD_MODE (auparse->sinkpad) == GST_PAD_MODE_PULL)
+    return gst_au_parse_do_pull_seek (auparse, rate, flags, start_type, start,
+        stop_type, stop);
+
   event = gst_event_new_seek (rate, GST_FORMAT_BYTES, flags, start_type, start,
       stop_type, stop);
   res = gst_pad_push_event (auparse->sinkpad, event);
@@ -765,6 +991,61 @@ gst_au_parse_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
   return ret;
 }
 
+static gboolean
+gst_au_parse_sink_activate (GstPad * sinkpad, GstObject * parent)
+{
+  GstQuery *query;
+  gboolean pull_mode;
+
+  query = gst_query_new_scheduling ();
+
+  if (!gst_pad_peer_query (sinkpad, query)) {
+    gst_query_unref (query);
+    goto activate_push;
+  }
+
+  pull_mode = gst_query_has_scheduling_mode_with_flags (query,
+      GST_PAD_MODE_PULL, GST_SCHEDULING_FLAG_SEEKABLE);
+  gst_query_unref (query);
+
+  if (!pull_mode)
+    goto activate_push;
+
+  GST_DEBUG_OBJECT (sinkpad, "activating pull");
+  return gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PULL, TRUE);
+
+activate_push:
+  {
+    GST_DEBUG_OBJECT (sinkpad, "activating push");
+    return gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PUSH, TRUE);
+  }
+}
+
+static gboolean
+gst_au_parse_sink_activate_mode (GstPad * sinkpad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  gboolean res;
+
+  switch (mode) {
+    case GST_PAD_MODE_PUSH:
+      res = TRUE;
+      break;
+    case GST_PAD_MODE_PULL:
+      if (active) {
+        res = gst_pad_start_task (sinkpad, (GstTaskFunction) gst_au_parse_loop,
+            sinkpad, NULL);
+      } else {
+        res = gst_pad_stop_task (sinkpad);
+      }
+      break;
+    default:
+      res = FALSE;
+      break;
+  }
+  return res;
+}
+
 static GstStateChangeReturn
 gst_au_parse_change_state (GstElement * element, GstStateChange transition)
 {
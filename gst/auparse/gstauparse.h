@@ -57,6 +57,8 @@ struct _GstAuParse {
 
   gint64      offset;        /* where sample data starts */
   gint64      buffer_offset;
+  gint64      end_offset;    /* where sample data ends in pull mode, or -1 */
+  GstEvent   *pending_segment;
   guint       sample_size;
   guint       encoding;
   guint       samplerate;
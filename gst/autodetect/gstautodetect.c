@@ -36,6 +36,15 @@ GST_DEBUG_CATEGORY (autodetect_debug);
 
 #define DEFAULT_SYNC                TRUE
 
+/* factory that worked last for each kind of element and filter caps, shared
+ * in the process and optionally kept in the file named by
+ * GST_AUTODETECT_CACHE */
+G_LOCK_DEFINE_STATIC (choice_cache);
+static GKeyFile *choice_cache = NULL;
+static gchar *choice_cache_path = NULL;
+
+#define CHOICE_CACHE_GROUP "choices"
+
 /* Properties */
 enum
 {
@@ -239,6 +248,76 @@ create_element_with_pretty_name (GstAutoDetect * self,
   return element;
 }
 
+static gchar *
+gst_auto_detect_cache_key (GstAutoDetect * self)
+{
+  gchar *caps, *str, *key;
+
+  caps = self->filter_caps ? gst_caps_to_string (self->filter_caps) : NULL;
+  str = g_strdup_printf ("%s/%s/%s", self->media_klass, self->type_klass,
+      GST_STR_NULL (caps));
+  /* usable as key file key */
+  key = g_compute_checksum_for_string (G_CHECKSUM_SHA1, str, -1);
+  g_free (str);
+  g_free (caps);
+
+  return key;
+}
+
+static void
+gst_auto_detect_cache_init_unlocked (void)
+{
+  const gchar *path;
+
+  if (choice_cache)
+    return;
+
+  choice_cache = g_key_file_new ();
+  path = g_getenv ("GST_AUTODETECT_CACHE");
+  if (path && *path != '\0') {
+    choice_cache_path = g_strdup (path);
+    g_key_file_load_from_file (choice_cache, choice_cache_path,
+        G_KEY_FILE_NONE, NULL);
+  }
+}
+
+static gchar *
+gst_auto_detect_cache_lookup (const gchar * key)
+{
+  gchar *name;
+
+  G_LOCK (choice_cache);
+  gst_auto_detect_cache_init_unlocked ();
+  name = g_key_file_get_string (choice_cache, CHOICE_CACHE_GROUP, key, NULL);
+  G_UNLOCK (choice_cache);
+
+  return name;
+}
+
+static void
+gst_auto_detect_cache_store (const gchar * key, const gchar * name)
+{
+  G_LOCK (choice_cache);
+  gst_auto_detect_cache_init_unlocked ();
+  g_key_file_set_string (choice_cache, CHOICE_CACHE_GROUP, key, name);
+  if (choice_cache_path) {
+    gchar *data;
+    gsize len;
+
+    data = g_key_file_to_data (choice_cache, &len, NULL);
+    if (data && !g_file_set_contents (choice_cache_path, data, len, NULL))
+      GST_WARNING ("could not write %s", choice_cache_path);
+    g_free (data);
+  }
+  G_UNLOCK (choice_cache);
+}
+
+static gint
+gst_auto_detect_compare_name (GstPluginFeature * feature, const gchar * name)
+{
+  return strcmp (GST_OBJECT_NAME (feature), name);
+}
+
 static GstElement *
 gst_auto_detect_find_best (GstAutoDetect * self)
 {
@@ -250,6 +329,7 @@ gst_auto_detect_find_best (GstAutoDetect * self)
   GstPad *el_pad = NULL;
   GstCaps *el_caps = NULL;
   gboolean no_match = TRUE;
+  gchar *key, *cached;
 
   /* We don't treat sound server sinks special. Our policy is that sound
    * server sinks that have a rank must not auto-spawn a daemon under any
@@ -259,6 +339,20 @@ gst_auto_detect_find_best (GstAutoDetect * self)
   list =
       g_list_sort (list, (GCompareFunc) gst_plugin_feature_rank_compare_func);
 
+  /* try the element that worked last time first, so that the candidates
+   * ranked above it that failed then are not probed again */
+  key = gst_auto_detect_cache_key (self);
+  cached = gst_auto_detect_cache_lookup (key);
+  if (cached) {
+    item = g_list_find_custom (list, cached,
+        (GCompareFunc) gst_auto_detect_compare_name);
+    if (item && item != list) {
+      GST_DEBUG_OBJECT (self, "trying cached choice %s first", cached);
+      list = g_list_remove_link (list, item);
+      list = g_list_concat (item, list);
+    }
+  }
+
   GST_LOG_OBJECT (self, "Trying to find usable %s elements ...",
       self->media_klass_lc);
 
@@ -297,6 +391,8 @@ gst_auto_detect_find_best (GstAutoDetect * self)
       if (ret == GST_STATE_CHANGE_SUCCESS) {
         GST_DEBUG_OBJECT (self, "This worked!");
         choice = el;
+        if (g_strcmp0 (cached, GST_OBJECT_NAME (f)))
+          gst_auto_detect_cache_store (key, GST_OBJECT_NAME (f));
         break;
       }
 
@@ -337,6 +433,8 @@ gst_auto_detect_find_best (GstAutoDetect * self)
   }
   gst_object_unref (bus);
   gst_plugin_feature_list_free (list);
+  g_free (cached);
+  g_free (key);
   g_slist_foreach (errors, (GFunc) gst_mini_object_unref, NULL);
   g_slist_free (errors);
 
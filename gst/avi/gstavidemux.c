@@ -1230,6 +1230,8 @@ avih_too_small:
  * @locations: locations in the file (byte-offsets) that contain
  *             the actual indexes (see get_avi_demux_parse_subindex()).
  *             The array ends with GST_BUFFER_OFFSET_NONE.
+ * @n_entries: estimated total amount of entries in the subindexes, used
+ *             to allocate the stream index in one go.
  *
  * Reads superindex (openDML-2 spec stuff) from the provided data.
  *
@@ -1238,16 +1240,18 @@ avih_too_small:
  */
 static gboolean
 gst_avi_demux_parse_superindex (GstAviDemux * avi,
-    GstBuffer * buf, guint64 ** _indexes)
+    GstBuffer * buf, guint64 ** _indexes, guint * n_entries)
 {
   GstMapInfo map;
   guint8 *data;
   guint16 bpe = 16;
   guint32 num, i;
   guint64 *indexes;
+  guint64 entries = 0;
   gsize size;
 
   *_indexes = NULL;
+  *n_entries = 0;
 
   if (buf) {
     gst_buffer_map (buf, &map, GST_MAP_READ);
@@ -1286,10 +1290,21 @@ gst_avi_demux_parse_superindex (GstAviDemux * avi,
     if (size < 24 + bpe * (i + 1))
       break;
     indexes[i] = GST_READ_UINT64_LE (&data[24 + bpe * i]);
+    /* the subindex chunk size gives the amount of 8 byte entries after the
+     * chunk and index headers */
+    if (bpe >= 12) {
+      guint32 chunk_size = GST_READ_UINT32_LE (&data[24 + bpe * i + 8]);
+
+      if (chunk_size > 8 + 24)
+        entries += (chunk_size - 8 - 24) / 8;
+    }
     GST_DEBUG_OBJECT (avi, "index %d at %" G_GUINT64_FORMAT, i, indexes[i]);
   }
   indexes[i] = GST_BUFFER_OFFSET_NONE;
   *_indexes = indexes;
+  *n_entries = MIN (entries, G_MAXUINT32 / sizeof (GstAviIndexEntry));
+
+  GST_DEBUG_OBJECT (avi, "superindex announces about %u entries", *n_entries);
 
   gst_buffer_unmap (buf, &map);
   gst_buffer_unref (buf);
@@ -1318,6 +1333,46 @@ invalid_params:
   }
 }
 
+/* make sure the index of @stream has room for @idx_max entries */
+static gboolean
+gst_avi_demux_reserve_index (GstAviDemux * avi, GstAviStream * stream,
+    guint idx_max)
+{
+  GstAviIndexEntry *new_idx;
+
+  if (idx_max <= stream->idx_max)
+    return TRUE;
+
+  new_idx = g_try_renew (GstAviIndexEntry, stream->index, idx_max);
+  /* out of memory, if this fails stream->index is untouched. */
+  if (G_UNLIKELY (!new_idx))
+    return FALSE;
+
+  stream->index = new_idx;
+  stream->idx_max = idx_max;
+
+  return TRUE;
+}
+
+/* release the unused part of the index memory of @stream */
+static void
+gst_avi_demux_compact_index (GstAviDemux * avi, GstAviStream * stream)
+{
+  GstAviIndexEntry *new_idx;
+
+  if (stream->idx_n == 0 || stream->idx_n == stream->idx_max)
+    return;
+
+  new_idx = g_try_renew (GstAviIndexEntry, stream->index, stream->idx_n);
+  if (G_UNLIKELY (!new_idx))
+    return;
+
+  GST_DEBUG_OBJECT (avi, "compacted index of stream %u from %u to %u entries",
+      stream->num, stream->idx_max, stream->idx_n);
+  stream->index = new_idx;
+  stream->idx_max = stream->idx_n;
+}
+
 /* add an entry to the index of a stream. @num should be an estimate of the
  * total amount of index entries for all streams and is used to dynamically
  * allocate memory for the index entries. */
@@ -1336,7 +1391,10 @@ gst_avi_demux_add_index (GstAviDemux * avi, GstAviStream * stream,
        * overshoot with at least 8K */
       idx_max = (num / avi->num_streams) + (8192 / sizeof (GstAviIndexEntry));
     } else {
-      idx_max += 8192 / sizeof (GstAviIndexEntry);
+      /* grow by half of the current size so that building huge indexes
+       * does not copy them over and over, the slack is released again in
+       * gst_avi_demux_compact_index() */
+      idx_max += MAX (idx_max / 2, 8192 / sizeof (GstAviIndexEntry));
       GST_DEBUG_OBJECT (avi, "expanded index from %u to %u",
           stream->idx_max, idx_max);
     }
@@ -1467,6 +1525,8 @@ gst_avi_demux_do_index_stats (GstAviDemux * avi)
     if (G_UNLIKELY (!stream->index || stream->idx_n == 0))
       continue;
 
+    gst_avi_demux_compact_index (avi, stream);
+
     /* we interested in the end_ts of the last entry, which is the total
      * duration of this stream */
     gst_avi_demux_get_buffer_info (avi, stream, stream->idx_n - 1,
@@ -1559,6 +1619,11 @@ gst_avi_demux_parse_subindex (GstAviDemux * avi, GstAviStream * stream,
 
   GST_INFO_OBJECT (avi, "Parsing subindex, nr_entries = %6d", num);
 
+  /* allocate the complete index announced by the superindex at once */
+  if (stream->idx_max == 0 && stream->indexes_entries > 0 &&
+      !gst_avi_demux_reserve_index (avi, stream, stream->indexes_entries))
+    goto out_of_mem;
+
   for (i = 0; i < num; i++) {
     GstAviIndexEntry entry;
 
@@ -2236,7 +2301,8 @@ gst_avi_demux_parse_stream (GstAviDemux * avi, GstBuffer * buf)
             tag == GST_MAKE_FOURCC ('i', 'x', '0' + avi->num_streams / 10,
                 '0' + avi->num_streams % 10)) {
           g_free (stream->indexes);
-          gst_avi_demux_parse_superindex (avi, sub, &stream->indexes);
+          gst_avi_demux_parse_superindex (avi, sub, &stream->indexes,
+              &stream->indexes_entries);
           stream->superindex = TRUE;
           sub = NULL;
           break;
@@ -2690,6 +2756,133 @@ gst_avi_demux_stream_for_id (GstAviDemux * avi, guint32 id)
   return stream;
 }
 
+/* idx1 indexes with at least this many entries are parsed with one thread
+ * per stream */
+#define PARALLEL_INDEX_ENTRIES  (64 * 1024)
+
+typedef struct
+{
+  GstAviDemux *avi;
+  gst_riff_index_entry *index;
+  guint num;
+  /* position of the first valid entry */
+  guint first;
+  /* only add entries for this stream, NULL for all streams */
+  GstAviStream *stream;
+  gboolean res;
+} GstAviIndexParseData;
+
+/* adds the idx1 entries of @data to the stream indexes */
+static gpointer
+gst_avi_demux_parse_index_entries (GstAviIndexParseData * data)
+{
+  GstAviDemux *avi = data->avi;
+  gst_riff_index_entry *index = data->index;
+  GstAviStream *stream;
+  GstAviIndexEntry entry;
+  guint i;
+  guint32 id;
+
+  data->res = TRUE;
+
+  for (i = data->first; i < data->num; i++) {
+    id = GST_READ_UINT32_LE (&index[i].id);
+    entry.offset = GST_READ_UINT32_LE (&index[i].offset);
+
+    /* some sanity checks */
+    if (G_UNLIKELY (id == GST_RIFF_rec || id == 0 ||
+            (entry.offset == 0 && i > data->first)))
+      continue;
+
+    /* leave the entries of other streams to their own thread */
+    if (data->stream && CHUNKID_TO_STREAMNR (id) != data->stream->num)
+      continue;
+
+    /* get the stream for this entry */
+    stream = gst_avi_demux_stream_for_id (avi, id);
+    if (G_UNLIKELY (!stream))
+      continue;
+
+    /* handle offset and size */
+    entry.offset += avi->index_offset + 8;
+    entry.size = GST_READ_UINT32_LE (&index[i].size);
+
+    /* handle flags */
+    if (stream->strh->type == GST_RIFF_FCC_auds) {
+      /* all audio frames are keyframes */
+      ENTRY_SET_KEYFRAME (&entry);
+    } else if (stream->strh->type == GST_RIFF_FCC_vids &&
+        stream->strf.vids->compression == GST_RIFF_DXSB) {
+      /* all xsub frames are keyframes */
+      ENTRY_SET_KEYFRAME (&entry);
+    } else {
+      guint32 flags;
+      /* else read flags */
+      flags = GST_READ_UINT32_LE (&index[i].flags);
+      if (flags & GST_RIFF_IF_KEYFRAME) {
+        ENTRY_SET_KEYFRAME (&entry);
+      } else {
+        ENTRY_UNSET_KEYFRAME (&entry);
+      }
+    }
+
+    /* and add */
+    if (G_UNLIKELY (!gst_avi_demux_add_index (avi, stream, data->num,
+                &entry))) {
+      data->res = FALSE;
+      break;
+    }
+  }
+  return NULL;
+}
+
+/* parses the entries with a thread for each stream. Returns FALSE when the
+ * threads could not be started, in which case nothing was parsed. */
+static gboolean
+gst_avi_demux_parse_index_parallel (GstAviDemux * avi,
+    GstAviIndexParseData * data, gboolean * res)
+{
+  GstAviIndexParseData sdata[GST_AVI_DEMUX_MAX_STREAMS];
+  GThread *threads[GST_AVI_DEMUX_MAX_STREAMS];
+  guint i, n_threads = 0;
+
+  for (i = 0; i < avi->num_streams; i++) {
+    if (!avi->stream[i].strh)
+      continue;
+    sdata[n_threads] = *data;
+    sdata[n_threads].stream = &avi->stream[i];
+    threads[n_threads] = g_thread_try_new ("avidemux-index",
+        (GThreadFunc) gst_avi_demux_parse_index_entries, &sdata[n_threads],
+        NULL);
+    if (!threads[n_threads])
+      break;
+    n_threads++;
+  }
+
+  if (n_threads == 0)
+    return FALSE;
+
+  /* parse the remaining streams here if we could not start all threads */
+  for (; i < avi->num_streams; i++) {
+    GstAviIndexParseData rest = *data;
+
+    if (!avi->stream[i].strh)
+      continue;
+    rest.stream = &avi->stream[i];
+    gst_avi_demux_parse_index_entries (&rest);
+    *res &= rest.res;
+  }
+
+  for (i = 0; i < n_threads; i++) {
+    g_thread_join (threads[i]);
+    *res &= sdata[i].res;
+  }
+
+  GST_DEBUG_OBJECT (avi, "parsed index with %u threads", n_threads);
+
+  return TRUE;
+}
+
 /*
  * gst_avi_demux_parse_index:
  * @avi: calling element (used for debugging/errors).
@@ -2697,16 +2890,18 @@ gst_avi_demux_stream_for_id (GstAviDemux * avi, guint32 id)
  *
  * Read index entries from the provided buffer.
  * The buffer should contain a GST_RIFF_TAG_idx1 chunk.
+ * Large indexes are parsed with one thread per stream.
  */
 static gboolean
 gst_avi_demux_parse_index (GstAviDemux * avi, GstBuffer * buf)
 {
   GstMapInfo map;
-  guint i, num, n;
+  guint i, num;
   gst_riff_index_entry *index;
   GstClockTime stamp;
-  GstAviStream *stream;
-  GstAviIndexEntry entry;
+  GstAviIndexParseData data;
+  gboolean res = TRUE;
+  guint64 offset;
   guint32 id;
 
   if (!buf)
@@ -2726,8 +2921,8 @@ gst_avi_demux_parse_index (GstAviDemux * avi, GstBuffer * buf)
   index = (gst_riff_index_entry *) map.data;
 
   /* figure out if the index is 0 based or relative to the MOVI start */
-  entry.offset = GST_READ_UINT32_LE (&index[0].offset);
-  if (entry.offset < avi->offset) {
+  offset = GST_READ_UINT32_LE (&index[0].offset);
+  if (offset < avi->offset) {
     avi->index_offset = avi->offset + 8;
     GST_DEBUG ("index_offset = %" G_GUINT64_FORMAT, avi->index_offset);
   } else {
@@ -2735,49 +2930,31 @@ gst_avi_demux_parse_index (GstAviDemux * avi, GstBuffer * buf)
     GST_DEBUG ("index is 0 based");
   }
 
-  for (i = 0, n = 0; i < num; i++) {
+  /* find the first usable entry, only that one is allowed to have a 0
+   * offset */
+  for (i = 0; i < num; i++) {
     id = GST_READ_UINT32_LE (&index[i].id);
-    entry.offset = GST_READ_UINT32_LE (&index[i].offset);
-
-    /* some sanity checks */
-    if (G_UNLIKELY (id == GST_RIFF_rec || id == 0 ||
-            (entry.offset == 0 && n > 0)))
-      continue;
-
-    /* get the stream for this entry */
-    stream = gst_avi_demux_stream_for_id (avi, id);
-    if (G_UNLIKELY (!stream))
+    if (G_UNLIKELY (id == GST_RIFF_rec || id == 0))
       continue;
+    if (gst_avi_demux_stream_for_id (avi, id))
+      break;
+  }
 
-    /* handle offset and size */
-    entry.offset += avi->index_offset + 8;
-    entry.size = GST_READ_UINT32_LE (&index[i].size);
+  data.avi = avi;
+  data.index = index;
+  data.num = num;
+  data.first = i;
+  data.stream = NULL;
 
-    /* handle flags */
-    if (stream->strh->type == GST_RIFF_FCC_auds) {
-      /* all audio frames are keyframes */
-      ENTRY_SET_KEYFRAME (&entry);
-    } else if (stream->strh->type == GST_RIFF_FCC_vids &&
-        stream->strf.vids->compression == GST_RIFF_DXSB) {
-      /* all xsub frames are keyframes */
-      ENTRY_SET_KEYFRAME (&entry);
-    } else {
-      guint32 flags;
-      /* else read flags */
-      flags = GST_READ_UINT32_LE (&index[i].flags);
-      if (flags & GST_RIFF_IF_KEYFRAME) {
-        ENTRY_SET_KEYFRAME (&entry);
-      } else {
-        ENTRY_UNSET_KEYFRAME (&entry);
-      }
-    }
+  if (num - data.first < PARALLEL_INDEX_ENTRIES || avi->num_streams < 2 ||
+      !gst_avi_demux_parse_index_parallel (avi, &data, &res)) {
+    gst_avi_demux_parse_index_entries (&data);
+    res = data.res;
+  }
 
-    /* and add */
-    if (G_UNLIKELY (!gst_avi_demux_add_index (avi, stream, num, &entry)))
-      goto out_of_mem;
+  if (G_UNLIKELY (!res))
+    goto out_of_mem;
 
-    n++;
-  }
   gst_buffer_unmap (buf, &map);
   gst_buffer_unref (buf);
 
@@ -5460,9 +5637,11 @@ gst_avi_demux_stream_data (GstAviDemux * avi)
 
       if (saw_desired_kf) {
         gst_adapter_flush (avi->adapter, 8);
-        /* get buffer */
+        /* get buffer, combining the input memory without copying when the
+         * chunk spans several input buffers */
         if (size) {
-          buf = gst_adapter_take_buffer (avi->adapter, GST_ROUND_UP_2 (size));
+          buf = gst_adapter_take_buffer_fast (avi->adapter,
+              GST_ROUND_UP_2 (size));
           /* patch the size */
           gst_buffer_resize (buf, 0, size);
         } else {
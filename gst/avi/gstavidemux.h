@@ -110,6 +110,8 @@ typedef struct {
   /* openDML support (for files >4GB) */
   gboolean       superindex;
   guint64       *indexes;
+  /* number of entries announced by the superindex */
+  guint          indexes_entries;
 
   /* new indexes */
   GstAviIndexEntry *index;     /* array with index entries */
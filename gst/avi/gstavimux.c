@@ -77,10 +77,14 @@ GST_DEBUG_CATEGORY_STATIC (avimux_debug);
 enum
 {
   ARG_0,
-  ARG_BIGFILE
+  ARG_BIGFILE,
+  ARG_INDEX_ENTRIES,
+  ARG_AGGREGATE_SIZE
 };
 
 #define DEFAULT_BIGFILE TRUE
+#define DEFAULT_INDEX_ENTRIES 0
+#define DEFAULT_AGGREGATE_SIZE 0
 
 static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
@@ -246,6 +250,37 @@ gst_avi_mux_class_init (GstAviMuxClass * klass)
       g_param_spec_boolean ("bigfile", "Bigfile Support (>2GB)",
           "Support for openDML-2.0 (big) AVI files", DEFAULT_BIGFILE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstAviMux:index-entries:
+   *
+   * Write an openDML standard index chunk for all streams after this many
+   * chunks in the AVIX parts of a big file, instead of keeping the index of
+   * a whole part in memory until it is finished. This limits the memory used
+   * for long recordings. The first part still keeps its full index for the
+   * idx1 chunk. When set, room for 256 instead of 32 index chunks per stream
+   * is reserved in the header.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, ARG_INDEX_ENTRIES,
+      g_param_spec_uint ("index-entries", "Index Entries",
+          "Write an openDML index after this many chunks in big files "
+          "(0 = one index per part)", 0, G_MAXINT, DEFAULT_INDEX_ENTRIES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstAviMux:aggregate-size:
+   *
+   * Collect chunk headers, data and index chunks into a buffer list and
+   * push it when it holds at least this many bytes, or before any event.
+   * This makes for fewer and larger writes downstream.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, ARG_AGGREGATE_SIZE,
+      g_param_spec_uint ("aggregate-size", "Aggregate Size",
+          "Push data in buffer lists of at least this many bytes "
+          "(0 = push every buffer immediately)", 0, G_MAXUINT,
+          DEFAULT_AGGREGATE_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_avi_mux_request_new_pad);
@@ -357,6 +392,12 @@ gst_avi_mux_reset (GstAviMux * avimux)
   g_free (avimux->idx);
   avimux->idx = NULL;
 
+  if (avimux->pending) {
+    gst_buffer_list_unref (avimux->pending);
+    avimux->pending = NULL;
+  }
+  avimux->pending_size = 0;
+
   /* state info */
   avimux->write_header = TRUE;
 
@@ -373,6 +414,9 @@ gst_avi_mux_init (GstAviMux * avimux)
 
   /* property */
   avimux->enable_large_avi = DEFAULT_BIGFILE;
+  avimux->index_entries = DEFAULT_INDEX_ENTRIES;
+  avimux->aggregate_size = DEFAULT_AGGREGATE_SIZE;
+  avimux->superindex_size = GST_AVI_SUPERINDEX_COUNT;
 
   avimux->collect = gst_collect_pads_new ();
   gst_collect_pads_set_function (avimux->collect,
@@ -1336,7 +1380,7 @@ gst_avi_mux_riff_get_avi_header (GstAviMux * avimux)
     hdl &= gst_byte_writer_put_uint32_le (&bw, 0);      /* reserved */
     hdl &= gst_byte_writer_put_uint32_le (&bw, 0);      /* reserved */
     hdl &= gst_byte_writer_put_data (&bw, (guint8 *) avipad->idx,
-        GST_AVI_SUPERINDEX_COUNT * sizeof (gst_avi_superindex_entry));
+        avimux->superindex_size * sizeof (gst_avi_superindex_entry));
     gst_avi_mux_end_chunk (&bw, indx);
 
     /* end strl for this stream */
@@ -1439,6 +1483,52 @@ gst_avi_mux_riff_get_header (GstAviPad * avipad, guint32 video_frame_size)
   return buffer;
 }
 
+/* push the buffers collected so far */
+static GstFlowReturn
+gst_avi_mux_flush_pending (GstAviMux * avimux)
+{
+  GstBufferList *list = avimux->pending;
+
+  if (list == NULL)
+    return GST_FLOW_OK;
+
+  avimux->pending = NULL;
+  avimux->pending_size = 0;
+
+  GST_LOG_OBJECT (avimux, "pushing list of %u buffers",
+      gst_buffer_list_length (list));
+
+  return gst_pad_push_list (avimux->srcpad, list);
+}
+
+/* push @buffer downstream, or add it to the pending list when aggregating */
+static GstFlowReturn
+gst_avi_mux_push (GstAviMux * avimux, GstBuffer * buffer)
+{
+  if (avimux->aggregate_size == 0)
+    return gst_pad_push (avimux->srcpad, buffer);
+
+  if (avimux->pending == NULL)
+    avimux->pending = gst_buffer_list_new ();
+  avimux->pending_size += gst_buffer_get_size (buffer);
+  gst_buffer_list_add (avimux->pending, buffer);
+
+  if (avimux->pending_size >= avimux->aggregate_size)
+    return gst_avi_mux_flush_pending (avimux);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_avi_mux_push_event (GstAviMux * avimux, GstEvent * event)
+{
+  /* keep data in front of segment seeks and EOS. A flow error is returned
+   * again by the next push. */
+  gst_avi_mux_flush_pending (avimux);
+
+  return gst_pad_push_event (avimux->srcpad, event);
+}
+
 /* write an odml index chunk in the movi list */
 static GstFlowReturn
 gst_avi_mux_write_avix_index (GstAviMux * avimux, GstAviPad * avipad,
@@ -1508,11 +1598,11 @@ gst_avi_mux_write_avix_index (GstAviMux * avimux, GstAviPad * avipad,
   gst_buffer_resize (buffer, 0, size);
 
   /* send */
-  if ((res = gst_pad_push (avimux->srcpad, buffer)) != GST_FLOW_OK)
+  if ((res = gst_avi_mux_push (avimux, buffer)) != GST_FLOW_OK)
     return res;
 
   /* keep track of this in superindex (if room) ... */
-  if (*super_index_count < GST_AVI_SUPERINDEX_COUNT) {
+  if (*super_index_count < avimux->superindex_size) {
     i = *super_index_count;
     super_index[i].offset = GUINT64_TO_LE (avimux->total_data);
     super_index[i].size = GUINT32_TO_LE (size);
@@ -1528,6 +1618,7 @@ gst_avi_mux_write_avix_index (GstAviMux * avimux, GstAviPad * avipad,
 
   /* ... and in size */
   avimux->total_data += size;
+  avimux->idx_offset += size;
   if (avimux->is_bigfile)
     avimux->datax_size += size;
   else
@@ -1583,7 +1674,7 @@ gst_avi_mux_write_index (GstAviMux * avimux)
       avimux->idx_index * sizeof (gst_riff_index_entry));
   gst_buffer_unmap (buffer, &map);
 
-  res = gst_pad_push (avimux->srcpad, buffer);
+  res = gst_avi_mux_push (avimux, buffer);
   if (res != GST_FLOW_OK)
     return res;
 
@@ -1598,7 +1689,7 @@ gst_avi_mux_write_index (GstAviMux * avimux)
 
   avimux->total_data += size + 8;
 
-  res = gst_pad_push (avimux->srcpad, buffer);
+  res = gst_avi_mux_push (avimux, buffer);
   if (res != GST_FLOW_OK)
     return res;
 
@@ -1609,6 +1700,34 @@ gst_avi_mux_write_index (GstAviMux * avimux)
   return GST_FLOW_OK;
 }
 
+/* write the odml index of all streams collected so far in the current AVIX
+ * part and start over */
+static GstFlowReturn
+gst_avi_mux_write_odml_indexes (GstAviMux * avimux)
+{
+  GstFlowReturn res;
+  GSList *node;
+
+  GST_DEBUG_OBJECT (avimux, "writing odml indexes for %d entries",
+      avimux->idx_index);
+
+  for (node = avimux->sinkpads; node; node = node->next) {
+    GstAviPad *avipad = (GstAviPad *) node->data;
+
+    res = gst_avi_mux_write_avix_index (avimux, avipad, avipad->tag,
+        avipad->idx_tag, avipad->idx, &avipad->idx_index);
+    if (res != GST_FLOW_OK)
+      return res;
+
+    if (!avipad->is_video)
+      ((GstAviAudioPad *) avipad)->samples = 0;
+  }
+
+  avimux->idx_index = 0;
+
+  return GST_FLOW_OK;
+}
+
 static GstFlowReturn
 gst_avi_mux_bigfile (GstAviMux * avimux, gboolean last)
 {
@@ -1637,16 +1756,16 @@ gst_avi_mux_bigfile (GstAviMux * avimux, gboolean last)
     /* search back */
     segment.start = avimux->avix_start;
     segment.time = avimux->avix_start;
-    gst_pad_push_event (avimux->srcpad, gst_event_new_segment (&segment));
+    gst_avi_mux_push_event (avimux, gst_event_new_segment (&segment));
 
     /* rewrite AVIX header */
     header = gst_avi_mux_riff_get_avix_header (avimux->datax_size);
-    res = gst_pad_push (avimux->srcpad, header);
+    res = gst_avi_mux_push (avimux, header);
 
     /* go back to current location, at least try */
     segment.start = avimux->total_data;
     segment.time = avimux->total_data;
-    gst_pad_push_event (avimux->srcpad, gst_event_new_segment (&segment));
+    gst_avi_mux_push_event (avimux, gst_event_new_segment (&segment));
 
     if (res != GST_FLOW_OK)
       return res;
@@ -1682,7 +1801,7 @@ gst_avi_mux_bigfile (GstAviMux * avimux, gboolean last)
   /* avix_start is used as base offset for the odml index chunk */
   avimux->idx_offset = avimux->total_data - avimux->avix_start;
 
-  return gst_pad_push (avimux->srcpad, header);
+  return gst_avi_mux_push (avimux, header);
 }
 
 /* enough header blabla now, let's go on to actually writing the headers */
@@ -1704,6 +1823,9 @@ gst_avi_mux_start_file (GstAviMux * avimux)
   avimux->numx_frames = 0;
   avimux->avix_start = 0;
 
+  avimux->superindex_size = avimux->index_entries > 0 ?
+      GST_AVI_SUPERINDEX_MAX : GST_AVI_SUPERINDEX_COUNT;
+
   avimux->idx_index = 0;
   avimux->idx_offset = 0;       /* see 10 lines below */
   avimux->idx_size = 0;
@@ -1742,7 +1864,7 @@ gst_avi_mux_start_file (GstAviMux * avimux)
     gchar s_id[32];
 
     g_snprintf (s_id, sizeof (s_id), "avimux-%08x", g_random_int ());
-    gst_pad_push_event (avimux->srcpad, gst_event_new_stream_start (s_id));
+    gst_avi_mux_push_event (avimux, gst_event_new_stream_start (s_id));
   }
 
   caps = gst_pad_get_pad_template_caps (avimux->srcpad);
@@ -1751,7 +1873,7 @@ gst_avi_mux_start_file (GstAviMux * avimux)
 
   /* let downstream know we think in BYTES and expect to do seeking later on */
   gst_segment_init (&segment, GST_FORMAT_BYTES);
-  gst_pad_push_event (avimux->srcpad, gst_event_new_segment (&segment));
+  gst_avi_mux_push_event (avimux, gst_event_new_segment (&segment));
 
   /* header */
   avimux->avi_hdr.streams = g_slist_length (avimux->sinkpads);
@@ -1760,7 +1882,7 @@ gst_avi_mux_start_file (GstAviMux * avimux)
   header = gst_avi_mux_riff_get_avi_header (avimux);
   avimux->total_data += gst_buffer_get_size (header);
 
-  res = gst_pad_push (avimux->srcpad, header);
+  res = gst_avi_mux_push (avimux, header);
 
   avimux->idx_offset = avimux->total_data;
 
@@ -1837,18 +1959,18 @@ gst_avi_mux_stop_file (GstAviMux * avimux)
 
   /* seek and rewrite the header */
   gst_segment_init (&segment, GST_FORMAT_BYTES);
-  gst_pad_push_event (avimux->srcpad, gst_event_new_segment (&segment));
+  gst_avi_mux_push_event (avimux, gst_event_new_segment (&segment));
 
   /* the first error survives */
   header = gst_avi_mux_riff_get_avi_header (avimux);
   if (res == GST_FLOW_OK)
-    res = gst_pad_push (avimux->srcpad, header);
+    res = gst_avi_mux_push (avimux, header);
   else
-    gst_pad_push (avimux->srcpad, header);
+    gst_avi_mux_push (avimux, header);
 
   segment.start = avimux->total_data;
   segment.time = avimux->total_data;
-  gst_pad_push_event (avimux->srcpad, gst_event_new_segment (&segment));
+  gst_avi_mux_push_event (avimux, gst_event_new_segment (&segment));
 
   avimux->write_header = TRUE;
 
@@ -1863,7 +1985,7 @@ gst_avi_mux_restart_file (GstAviMux * avimux)
   if ((res = gst_avi_mux_stop_file (avimux)) != GST_FLOW_OK)
     return res;
 
-  gst_pad_push_event (avimux->srcpad, gst_event_new_eos ());
+  gst_avi_mux_push_event (avimux, gst_event_new_eos ());
 
   return gst_avi_mux_start_file (avimux);
 }
@@ -1932,7 +2054,7 @@ gst_avi_mux_send_pad_data (GstAviMux * avimux, gulong num_bytes)
   buffer = gst_buffer_new_and_alloc (num_bytes);
   gst_buffer_memset (buffer, 0, 0, num_bytes);
 
-  return gst_pad_push (avimux->srcpad, buffer);
+  return gst_avi_mux_push (avimux, buffer);
 }
 
 #define gst_avi_mux_is_uncompressed(fourcc)		\
@@ -2106,11 +2228,11 @@ gst_avi_mux_do_buffer (GstAviMux * avimux, GstAviPad * avipad)
   /* send buffers */
   GST_LOG_OBJECT (avimux, "pushing buffers: head, data");
 
-  if ((res = gst_pad_push (avimux->srcpad, header)) != GST_FLOW_OK)
+  if ((res = gst_avi_mux_push (avimux, header)) != GST_FLOW_OK)
     goto done;
 
   gst_buffer_ref (data);
-  if ((res = gst_pad_push (avimux->srcpad, data)) != GST_FLOW_OK)
+  if ((res = gst_avi_mux_push (avimux, data)) != GST_FLOW_OK)
     goto done;
 
   if (pad_bytes) {
@@ -2122,6 +2244,12 @@ gst_avi_mux_do_buffer (GstAviMux * avimux, GstAviPad * avipad)
   avimux->total_data += total_size;
   avimux->idx_offset += total_size;
 
+  /* the first part needs all entries for the idx1 index */
+  if (avimux->is_bigfile && avimux->index_entries > 0
+      && avimux->superindex_size == GST_AVI_SUPERINDEX_MAX
+      && avimux->idx_index >= avimux->index_entries)
+    res = gst_avi_mux_write_odml_indexes (avimux);
+
 done:
   gst_buffer_unref (data);
   return res;
@@ -2183,7 +2311,7 @@ gst_avi_mux_do_one_buffer (GstAviMux * avimux)
   } else {
     /* simply finish off the file and send EOS */
     gst_avi_mux_stop_file (avimux);
-    gst_pad_push_event (avimux->srcpad, gst_event_new_eos ());
+    gst_avi_mux_push_event (avimux, gst_event_new_eos ());
     return GST_FLOW_EOS;
   }
 
@@ -2215,6 +2343,12 @@ gst_avi_mux_get_property (GObject * object,
     case ARG_BIGFILE:
       g_value_set_boolean (value, avimux->enable_large_avi);
       break;
+    case ARG_INDEX_ENTRIES:
+      g_value_set_uint (value, avimux->index_entries);
+      break;
+    case ARG_AGGREGATE_SIZE:
+      g_value_set_uint (value, avimux->aggregate_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2233,6 +2367,12 @@ gst_avi_mux_set_property (GObject * object,
     case ARG_BIGFILE:
       avimux->enable_large_avi = g_value_get_boolean (value);
       break;
+    case ARG_INDEX_ENTRIES:
+      avimux->index_entries = g_value_get_uint (value);
+      break;
+    case ARG_AGGREGATE_SIZE:
+      avimux->aggregate_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -45,6 +45,8 @@ G_BEGIN_DECLS
 
 /* this allows indexing up to 64GB avi file */
 #define GST_AVI_SUPERINDEX_COUNT    32
+/* superindex size reserved when writing standard indexes periodically */
+#define GST_AVI_SUPERINDEX_MAX      256
 
 /* max size */
 #define GST_AVI_MAX_SIZE    0x40000000
@@ -87,7 +89,7 @@ struct _GstAviPad {
   gst_riff_strh hdr;
 
   /* odml super indexes */
-  gst_avi_superindex_entry idx[GST_AVI_SUPERINDEX_COUNT];
+  gst_avi_superindex_entry idx[GST_AVI_SUPERINDEX_MAX];
   gint idx_index;
   gchar *idx_tag;
 
@@ -184,6 +186,17 @@ struct _GstAviMux {
 
   /* whether to use "large AVI files" or just stick to small indexed files */
   gboolean enable_large_avi;
+
+  /* entries after which an odml index is written in AVIX segments, 0 for
+   * one index per segment */
+  guint index_entries;
+  /* superindex entries reserved in the header of the current file */
+  gint superindex_size;
+
+  /* buffers collected into a list before pushing */
+  guint aggregate_size;
+  GstBufferList *pending;
+  guint pending_size;
 };
 
 struct _GstAviMuxClass {
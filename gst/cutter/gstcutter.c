@@ -58,6 +58,11 @@
 #include "gstcutter.h"
 #include "math.h"
 
+#if defined(__SSE2__)
+#define HAVE_CUTTER_SSE2 1
+#include <emmintrin.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (cutter_debug);
 #define GST_CAT_DEFAULT cutter_debug
 
@@ -102,6 +107,8 @@ static void gst_cutter_set_property (GObject * object, guint prop_id,
 static void gst_cutter_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
+static void gst_cutter_finalize (GObject * object);
+
 static gboolean gst_cutter_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static GstFlowReturn gst_cutter_chain (GstPad * pad, GstObject * parent,
@@ -118,6 +125,7 @@ gst_cutter_class_init (GstCutterClass * klass)
 
   gobject_class->set_property = gst_cutter_set_property;
   gobject_class->get_property = gst_cutter_get_property;
+  gobject_class->finalize = gst_cutter_finalize;
 
   g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_THRESHOLD,
       g_param_spec_double ("threshold", "Threshold",
@@ -177,10 +185,23 @@ gst_cutter_init (GstCutter * filter)
 
   filter->pre_length = CUTTER_DEFAULT_PRE_LENGTH;
   filter->pre_run_length = 0 * GST_SECOND;
-  filter->pre_buffer = NULL;
+  g_queue_init (&filter->pre_buffer);
+  filter->pre_bytes = 0;
   filter->leaky = FALSE;
 }
 
+static void
+gst_cutter_finalize (GObject * object)
+{
+  GstCutter *filter = GST_CUTTER (object);
+  GstBuffer *prebuf;
+
+  while ((prebuf = g_queue_pop_head (&filter->pre_buffer)))
+    gst_buffer_unref (prebuf);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static GstMessage *
 gst_cutter_message_new (GstCutter * c, gboolean above, GstClockTime timestamp)
 {
@@ -194,34 +215,91 @@ gst_cutter_message_new (GstCutter * c, gboolean above, GstClockTime timestamp)
 }
 
 /* Calculate the Normalized Cumulative Square over a buffer of the given type
- * and over all channels combined */
-
-#define DEFINE_CUTTER_CALCULATOR(TYPE, RESOLUTION)                            \
-static void inline                                                            \
-gst_cutter_calculate_##TYPE (TYPE * in, guint num,                            \
-                            double *NCS)                                      \
-{                                                                             \
-  register int j;                                                             \
-  double squaresum = 0.0;           /* square sum of the integer samples */   \
-  register double square = 0.0;     /* Square */                              \
-  gdouble normalizer;               /* divisor to get a [-1.0, 1.0] range */  \
-                                                                              \
-  *NCS = 0.0;                       /* Normalized Cumulative Square */        \
-                                                                              \
-  normalizer = (double) (1 << (RESOLUTION * 2));                              \
-                                                                              \
-  for (j = 0; j < num; j++)                                                   \
-  {                                                                           \
-    square = ((double) in[j]) * in[j];                                        \
-    squaresum += square;                                                      \
-  }                                                                           \
-                                                                              \
-                                                                              \
-  *NCS = squaresum / normalizer;                                              \
+ * and over all channels combined. The squares are summed up as integers,
+ * which is exact and lets the sum be computed on whole vectors of samples */
+
+#ifdef HAVE_CUTTER_SSE2
+/* adds the four 32 bit squares sums in sq to the two 64 bit lanes of acc,
+ * sq is unsigned as two squares of -32768 only fit that way */
+static inline __m128i
+gst_cutter_accumulate_sse2 (__m128i acc, __m128i sq)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+
+  acc = _mm_add_epi64 (acc, _mm_unpacklo_epi32 (sq, zero));
+  return _mm_add_epi64 (acc, _mm_unpackhi_epi32 (sq, zero));
 }
 
-DEFINE_CUTTER_CALCULATOR (gint16, 15);
-DEFINE_CUTTER_CALCULATOR (gint8, 7);
+static inline guint64
+gst_cutter_sum_sse2 (__m128i acc)
+{
+  guint64 lanes[2];
+
+  _mm_storeu_si128 ((__m128i *) lanes, acc);
+  return lanes[0] + lanes[1];
+}
+#endif
+
+static inline void
+gst_cutter_calculate_gint16 (const gint16 * in, guint num, double *NCS)
+{
+  guint64 squaresum = 0;
+  guint j = 0;
+
+#ifdef HAVE_CUTTER_SSE2
+  __m128i acc = _mm_setzero_si128 ();
+
+  for (; j + 8 <= num; j += 8) {
+    __m128i v = _mm_loadu_si128 ((const __m128i *) (in + j));
+
+    acc = gst_cutter_accumulate_sse2 (acc, _mm_madd_epi16 (v, v));
+  }
+  squaresum = gst_cutter_sum_sse2 (acc);
+#endif
+
+  for (; j < num; j++)
+    squaresum += in[j] * in[j];
+
+  /* divide to get a [-1.0, 1.0] range */
+  *NCS = squaresum / (double) (1 << (15 * 2));
+}
+
+static inline void
+gst_cutter_calculate_gint8 (const gint8 * in, guint num, double *NCS)
+{
+  guint64 squaresum = 0;
+  guint j = 0;
+
+#ifdef HAVE_CUTTER_SSE2
+  __m128i acc = _mm_setzero_si128 ();
+
+  for (; j + 16 <= num; j += 16) {
+    __m128i v = _mm_loadu_si128 ((const __m128i *) (in + j));
+    /* sign extend to 16 bits */
+    __m128i lo = _mm_srai_epi16 (_mm_unpacklo_epi8 (v, v), 8);
+    __m128i hi = _mm_srai_epi16 (_mm_unpackhi_epi8 (v, v), 8);
+
+    acc = gst_cutter_accumulate_sse2 (acc,
+        _mm_add_epi32 (_mm_madd_epi16 (lo, lo), _mm_madd_epi16 (hi, hi)));
+  }
+  squaresum = gst_cutter_sum_sse2 (acc);
+#endif
+
+  for (; j < num; j++)
+    squaresum += in[j] * in[j];
+
+  *NCS = squaresum / (double) (1 << (7 * 2));
+}
+
+/* Durations of the pre-record buffer are derived from its size, so that
+ * they don't drift from adding and subtracting rounded buffer durations */
+static void
+gst_cutter_update_pre_run_length (GstCutter * filter, gint bpf, gint rate)
+{
+  filter->pre_run_length =
+      gst_guint64_to_gdouble (gst_util_uint64_scale (filter->pre_bytes / bpf,
+          GST_SECOND, rate));
+}
 
 static gboolean
 gst_cutter_setcaps (GstCutter * filter, GstCaps * caps)
@@ -354,34 +432,28 @@ gst_cutter_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
       GST_DEBUG_OBJECT (filter, "flushing buffer of length %" GST_TIME_FORMAT,
           GST_TIME_ARGS (filter->pre_run_length));
 
-      while (filter->pre_buffer) {
-        prebuf = (g_list_first (filter->pre_buffer))->data;
-        filter->pre_buffer = g_list_remove (filter->pre_buffer, prebuf);
+      while ((prebuf = g_queue_pop_head (&filter->pre_buffer))) {
         gst_pad_push (filter->srcpad, prebuf);
         ++count;
       }
       GST_DEBUG_OBJECT (filter, "flushed %d buffers", count);
+      filter->pre_bytes = 0;
       filter->pre_run_length = 0 * GST_SECOND;
     }
   }
   /* now check if we have to send the new buffer to the internal buffer cache
    * or to the srcpad */
   if (filter->silent) {
-    filter->pre_buffer = g_list_append (filter->pre_buffer, buf);
-    filter->pre_run_length += gst_guint64_to_gdouble (duration);
+    g_queue_push_tail (&filter->pre_buffer, buf);
+    filter->pre_bytes += in_size;
+    gst_cutter_update_pre_run_length (filter, bpf, rate);
 
     while (filter->pre_run_length > filter->pre_length) {
-      GstClockTime pduration;
-      gsize psize;
-
-      prebuf = (g_list_first (filter->pre_buffer))->data;
+      prebuf = g_queue_pop_head (&filter->pre_buffer);
       g_assert (GST_IS_BUFFER (prebuf));
 
-      psize = gst_buffer_get_size (prebuf);
-      pduration = gst_util_uint64_scale (psize / bpf, GST_SECOND, rate);
-
-      filter->pre_buffer = g_list_remove (filter->pre_buffer, prebuf);
-      filter->pre_run_length -= gst_guint64_to_gdouble (pduration);
+      filter->pre_bytes -= gst_buffer_get_size (prebuf);
+      gst_cutter_update_pre_run_length (filter, bpf, rate);
 
       /* only pass buffers if we don't leak */
       if (!filter->leaky)
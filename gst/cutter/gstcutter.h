@@ -60,7 +60,8 @@ struct _GstCutter
 
   double pre_length;            /* how long can the pre-record buffer be ? */
   double pre_run_length;        /* how long is it currently ? */
-  GList *pre_buffer;            /* list of GstBuffers in pre-record buffer */
+  GQueue pre_buffer;            /* GstBuffers in pre-record buffer */
+  guint64 pre_bytes;            /* total size of the pre-record buffer */
   gboolean leaky;               /* do we leak an overflowing prebuffer ? */
 
   GstAudioInfo info;
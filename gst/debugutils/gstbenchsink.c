@@ -0,0 +1,292 @@
+/* GStreamer Benchmark Sink Element
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:element-benchsink
+ * @see_also: benchsrc
+ *
+ * Counts the buffers and bytes it receives and posts a "bench-sink" element
+ * message with the throughput every #GstBenchSink:interval, and once more
+ * on EOS with the totals:
+ * <itemizedlist>
+ * <listitem>
+ *   <para>
+ *   #guint64
+ *   <classname>&quot;buffers&quot;</classname>,
+ *   <classname>&quot;bytes&quot;</classname>,
+ *   <classname>&quot;lists&quot;</classname>:
+ *   the number of buffers, bytes and buffer lists since the previous message.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #gdouble
+ *   <classname>&quot;buffer-rate&quot;</classname>,
+ *   <classname>&quot;byte-rate&quot;</classname>:
+ *   buffers and bytes per second since the previous message.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #guint64
+ *   <classname>&quot;total-buffers&quot;</classname>,
+ *   <classname>&quot;total-bytes&quot;</classname>:
+ *   the number of buffers and bytes since the start.
+ *   </para>
+ * </listitem>
+ * </itemizedlist>
+ *
+ * The rates are measured against the system clock, not the pipeline clock,
+ * and the element does not synchronise to the clock by default.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 -m benchsrc location=stream.pcap rate=0 loops=100 ! benchsink
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstbenchsink.h"
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+GST_DEBUG_CATEGORY_STATIC (gst_bench_sink_debug);
+#define GST_CAT_DEFAULT gst_bench_sink_debug
+
+#define DEFAULT_INTERVAL GST_SECOND
+
+enum
+{
+  PROP_0,
+  PROP_INTERVAL
+};
+
+static void gst_bench_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_bench_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static gboolean gst_bench_sink_start (GstBaseSink * basesink);
+static gboolean gst_bench_sink_event (GstBaseSink * basesink,
+    GstEvent * event);
+static GstFlowReturn gst_bench_sink_render (GstBaseSink * basesink,
+    GstBuffer * buffer);
+static GstFlowReturn gst_bench_sink_render_list (GstBaseSink * basesink,
+    GstBufferList * list);
+
+#define gst_bench_sink_parent_class parent_class
+G_DEFINE_TYPE (GstBenchSink, gst_bench_sink, GST_TYPE_BASE_SINK);
+
+static void
+gst_bench_sink_class_init (GstBenchSinkClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+  GstBaseSinkClass *basesink_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  element_class = GST_ELEMENT_CLASS (klass);
+  basesink_class = GST_BASE_SINK_CLASS (klass);
+
+  gobject_class->set_property = gst_bench_sink_set_property;
+  gobject_class->get_property = gst_bench_sink_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_INTERVAL,
+      g_param_spec_uint64 ("interval", "Interval",
+          "Interval in nanoseconds between bench-sink messages "
+          "(0 = only on EOS)", 0, G_MAXUINT64, DEFAULT_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_template));
+
+  gst_element_class_set_static_metadata (element_class, "Benchmark sink",
+      "Sink/Testing",
+      "Count the received data and report the throughput",
+      "GStreamer maintainers <gstreamer-devel@lists.sourceforge.net>");
+
+  basesink_class->start = GST_DEBUG_FUNCPTR (gst_bench_sink_start);
+  basesink_class->event = GST_DEBUG_FUNCPTR (gst_bench_sink_event);
+  basesink_class->render = GST_DEBUG_FUNCPTR (gst_bench_sink_render);
+  basesink_class->render_list = GST_DEBUG_FUNCPTR (gst_bench_sink_render_list);
+
+  GST_DEBUG_CATEGORY_INIT (gst_bench_sink_debug, "benchsink", 0,
+      "benchmark sink");
+}
+
+static void
+gst_bench_sink_init (GstBenchSink * sink)
+{
+  sink->interval = DEFAULT_INTERVAL;
+
+  gst_base_sink_set_sync (GST_BASE_SINK (sink), FALSE);
+}
+
+static void
+gst_bench_sink_reset_counters (GstBenchSink * sink)
+{
+  sink->buffers = 0;
+  sink->bytes = 0;
+  sink->lists = 0;
+}
+
+static gboolean
+gst_bench_sink_start (GstBaseSink * basesink)
+{
+  GstBenchSink *sink = GST_BENCH_SINK (basesink);
+
+  gst_bench_sink_reset_counters (sink);
+  sink->total_buffers = 0;
+  sink->total_bytes = 0;
+  sink->first = GST_CLOCK_TIME_NONE;
+  sink->last_report = GST_CLOCK_TIME_NONE;
+
+  return TRUE;
+}
+
+static void
+gst_bench_sink_report (GstBenchSink * sink, GstClockTime now)
+{
+  GstStructure *s;
+  gdouble elapsed;
+
+  elapsed = (gdouble) (now - sink->last_report) / GST_SECOND;
+  if (elapsed <= 0.0)
+    elapsed = 1e-9;
+
+  s = gst_structure_new ("bench-sink",
+      "buffers", G_TYPE_UINT64, sink->buffers,
+      "bytes", G_TYPE_UINT64, sink->bytes,
+      "lists", G_TYPE_UINT64, sink->lists,
+      "buffer-rate", G_TYPE_DOUBLE, sink->buffers / elapsed,
+      "byte-rate", G_TYPE_DOUBLE, sink->bytes / elapsed,
+      "total-buffers", G_TYPE_UINT64, sink->total_buffers,
+      "total-bytes", G_TYPE_UINT64, sink->total_bytes, NULL);
+
+  GST_DEBUG_OBJECT (sink, "posting %" GST_PTR_FORMAT, s);
+
+  gst_element_post_message (GST_ELEMENT_CAST (sink),
+      gst_message_new_element (GST_OBJECT_CAST (sink), s));
+
+  gst_bench_sink_reset_counters (sink);
+  sink->last_report = now;
+}
+
+static void
+gst_bench_sink_count (GstBenchSink * sink, guint buffers, gsize bytes)
+{
+  GstClockTime now;
+
+  now = gst_util_get_timestamp ();
+  if (!GST_CLOCK_TIME_IS_VALID (sink->first))
+    sink->first = sink->last_report = now;
+
+  sink->buffers += buffers;
+  sink->bytes += bytes;
+  sink->total_buffers += buffers;
+  sink->total_bytes += bytes;
+
+  if (sink->interval > 0 && now - sink->last_report >= sink->interval)
+    gst_bench_sink_report (sink, now);
+}
+
+static GstFlowReturn
+gst_bench_sink_render (GstBaseSink * basesink, GstBuffer * buffer)
+{
+  GstBenchSink *sink = GST_BENCH_SINK (basesink);
+
+  gst_bench_sink_count (sink, 1, gst_buffer_get_size (buffer));
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_bench_sink_render_list (GstBaseSink * basesink, GstBufferList * list)
+{
+  GstBenchSink *sink = GST_BENCH_SINK (basesink);
+  guint i, len;
+  gsize bytes = 0;
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len; i++)
+    bytes += gst_buffer_get_size (gst_buffer_list_get (list, i));
+
+  sink->lists++;
+  gst_bench_sink_count (sink, len, bytes);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_bench_sink_event (GstBaseSink * basesink, GstEvent * event)
+{
+  GstBenchSink *sink = GST_BENCH_SINK (basesink);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_EOS
+      && GST_CLOCK_TIME_IS_VALID (sink->first)) {
+    GstClockTime now = gst_util_get_timestamp ();
+
+    /* report what was counted since the last message */
+    gst_bench_sink_report (sink, now);
+    GST_INFO_OBJECT (sink, "%" G_GUINT64_FORMAT " buffers, %"
+        G_GUINT64_FORMAT " bytes in %" GST_TIME_FORMAT, sink->total_buffers,
+        sink->total_bytes, GST_TIME_ARGS (now - sink->first));
+  }
+
+  return GST_BASE_SINK_CLASS (parent_class)->event (basesink, event);
+}
+
+static void
+gst_bench_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstBenchSink *sink = GST_BENCH_SINK (object);
+
+  switch (prop_id) {
+    case PROP_INTERVAL:
+      sink->interval = g_value_get_uint64 (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_bench_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstBenchSink *sink = GST_BENCH_SINK (object);
+
+  switch (prop_id) {
+    case PROP_INTERVAL:
+      g_value_set_uint64 (value, sink->interval);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
@@ -0,0 +1,70 @@
+/* GStreamer Benchmark Sink Element
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_BENCH_SINK_H__
+#define __GST_BENCH_SINK_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasesink.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_BENCH_SINK \
+  (gst_bench_sink_get_type())
+#define GST_BENCH_SINK(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_BENCH_SINK,GstBenchSink))
+#define GST_BENCH_SINK_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_BENCH_SINK,GstBenchSinkClass))
+#define GST_IS_BENCH_SINK(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_BENCH_SINK))
+#define GST_IS_BENCH_SINK_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_BENCH_SINK))
+typedef struct _GstBenchSink GstBenchSink;
+typedef struct _GstBenchSinkClass GstBenchSinkClass;
+
+/**
+ * GstBenchSink:
+ *
+ * Opaque #GstBenchSink data structure
+ */
+struct _GstBenchSink
+{
+  GstBaseSink basesink;
+
+  /*< private > */
+  /* properties */
+  GstClockTime interval;
+
+  /* counters since the last report */
+  guint64 buffers, bytes, lists;
+  GstClockTime last_report;
+
+  /* counters since start */
+  guint64 total_buffers, total_bytes;
+  GstClockTime first;
+};
+
+struct _GstBenchSinkClass
+{
+  GstBaseSinkClass parent_class;
+};
+
+GType gst_bench_sink_get_type (void);
+
+G_END_DECLS
+#endif /* __GST_BENCH_SINK_H__ */
@@ -0,0 +1,943 @@
+/* GStreamer Benchmark Source Element
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:element-benchsrc
+ * @see_also: benchsink, latencyprobe
+ *
+ * Replays a file in a loop to generate a reproducible load for benchmarks.
+ * The file is read into memory when going to PAUSED, so disk I/O does not
+ * show up in the measurements.
+ *
+ * A pcap capture is replayed as the UDP payloads it contains, e.g. RTP
+ * packets, with the pacing of the capture scaled by #GstBenchSrc:rate. Any
+ * other file is split into chunks of #GstBenchSrc:blocksize bytes that are
+ * #GstBenchSrc:packet-interval apart. With a rate of 0 the packets are pushed
+ * as fast as downstream accepts them.
+ *
+ * When pacing, the element is a live source and waits on the pipeline clock
+ * for every packet. Packets that are due together are pushed as a
+ * #GstBufferList of up to #GstBenchSrc:buffer-list buffers, like a socket
+ * source reading several packets per wakeup would do.
+ *
+ * By default the buffers share the memory of the loaded file. A buffer pool
+ * of #GstBenchSrc:pool-size buffers makes the element copy every packet
+ * instead, which is closer to what a network source does.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 -m benchsrc location=stream.pcap port=5004 rate=0 loops=-1 buffer-list=32 caps="application/x-rtp,media=video,clock-rate=90000,encoding-name=H264" ! rtph264depay ! benchsink
+ * ]| Depayload the RTP packets of a capture as fast as possible and report
+ * the throughput.
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstbenchsrc.h"
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+GST_DEBUG_CATEGORY_STATIC (gst_bench_src_debug);
+#define GST_CAT_DEFAULT gst_bench_src_debug
+
+#define DEFAULT_LOCATION        NULL
+#define DEFAULT_FORMAT          GST_BENCH_SRC_FORMAT_AUTO
+#define DEFAULT_BLOCKSIZE       4096
+#define DEFAULT_PACKET_INTERVAL 0
+#define DEFAULT_PORT            0
+#define DEFAULT_LOOPS           1
+#define DEFAULT_RATE            1.0
+#define DEFAULT_BUFFER_LIST     1
+#define DEFAULT_POOL_SIZE       0
+
+enum
+{
+  PROP_0,
+  PROP_LOCATION,
+  PROP_FORMAT,
+  PROP_BLOCKSIZE,
+  PROP_PACKET_INTERVAL,
+  PROP_PORT,
+  PROP_LOOPS,
+  PROP_RATE,
+  PROP_BUFFER_LIST,
+  PROP_POOL_SIZE,
+  PROP_CAPS
+};
+
+/* pcap link layer types */
+#define LINKTYPE_NULL       0
+#define LINKTYPE_ETHERNET   1
+#define LINKTYPE_RAW_BSD    12
+#define LINKTYPE_RAW_OBSD   14
+#define LINKTYPE_RAW        101
+#define LINKTYPE_LINUX_SLL  113
+
+#define GST_TYPE_BENCH_SRC_FORMAT (gst_bench_src_format_get_type ())
+static GType
+gst_bench_src_format_get_type (void)
+{
+  static GType format_type = 0;
+  static const GEnumValue format_types[] = {
+    {GST_BENCH_SRC_FORMAT_AUTO, "Detect from the file", "auto"},
+    {GST_BENCH_SRC_FORMAT_RAW, "Fixed size chunks", "raw"},
+    {GST_BENCH_SRC_FORMAT_PCAP, "UDP payloads of a pcap capture", "pcap"},
+    {0, NULL, NULL},
+  };
+
+  if (!format_type) {
+    format_type = g_enum_register_static ("GstBenchSrcFormat", format_types);
+  }
+  return format_type;
+}
+
+static void gst_bench_src_finalize (GObject * object);
+static void gst_bench_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_bench_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static GstStateChangeReturn gst_bench_src_change_state (GstElement *
+    element, GstStateChange transition);
+
+static gboolean gst_bench_src_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active);
+static gboolean gst_bench_src_query (GstPad * pad, GstObject * parent,
+    GstQuery * query);
+static void gst_bench_src_loop (GstBenchSrc * src);
+
+#define gst_bench_src_parent_class parent_class
+G_DEFINE_TYPE (GstBenchSrc, gst_bench_src, GST_TYPE_ELEMENT);
+
+static void
+gst_bench_src_class_init (GstBenchSrcClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->finalize = gst_bench_src_finalize;
+  gobject_class->set_property = gst_bench_src_set_property;
+  gobject_class->get_property = gst_bench_src_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_LOCATION,
+      g_param_spec_string ("location", "File Location",
+          "Location of the file to replay", DEFAULT_LOCATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_FORMAT,
+      g_param_spec_enum ("format", "Format",
+          "How to split the file into buffers", GST_TYPE_BENCH_SRC_FORMAT,
+          DEFAULT_FORMAT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_BLOCKSIZE,
+      g_param_spec_uint ("blocksize", "Block size",
+          "Size in bytes of the buffers in raw format", 1, G_MAXUINT,
+          DEFAULT_BLOCKSIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_PACKET_INTERVAL,
+      g_param_spec_uint64 ("packet-interval", "Packet interval",
+          "Time in nanoseconds between the buffers in raw format", 0,
+          G_MAXUINT64, DEFAULT_PACKET_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_PORT,
+      g_param_spec_int ("port", "Port",
+          "Only replay UDP packets to this port in pcap format (0 = all)", 0,
+          G_MAXUINT16, DEFAULT_PORT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_LOOPS,
+      g_param_spec_int ("loops", "Loops",
+          "Number of times to replay the file (-1 = forever)", -1, G_MAXINT,
+          DEFAULT_LOOPS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_RATE,
+      g_param_spec_double ("rate", "Rate",
+          "Replay speed relative to realtime (0 = as fast as possible)", 0.0,
+          G_MAXDOUBLE, DEFAULT_RATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_BUFFER_LIST,
+      g_param_spec_uint ("buffer-list", "Buffer list",
+          "Maximum number of buffers pushed at once in a buffer list "
+          "(1 = no buffer lists)", 1, G_MAXUINT, DEFAULT_BUFFER_LIST,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_POOL_SIZE,
+      g_param_spec_uint ("pool-size", "Pool size",
+          "Number of buffers in the pool the packets are copied into "
+          "(0 = no copy)", 0, G_MAXUINT, DEFAULT_POOL_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CAPS,
+      g_param_spec_boxed ("caps", "Caps",
+          "The caps of the output", GST_TYPE_CAPS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_template));
+
+  gst_element_class_set_static_metadata (element_class, "Benchmark source",
+      "Source/Testing",
+      "Replay a file or pcap capture in a loop to generate load",
+      "GStreamer maintainers <gstreamer-devel@lists.sourceforge.net>");
+
+  element_class->change_state = GST_DEBUG_FUNCPTR (gst_bench_src_change_state);
+
+  GST_DEBUG_CATEGORY_INIT (gst_bench_src_debug, "benchsrc", 0,
+      "benchmark source");
+}
+
+static void
+gst_bench_src_init (GstBenchSrc * src)
+{
+  src->srcpad = gst_pad_new_from_static_template (&src_template, "src");
+  gst_pad_set_activatemode_function (src->srcpad,
+      GST_DEBUG_FUNCPTR (gst_bench_src_activate_mode));
+  gst_pad_set_query_function (src->srcpad,
+      GST_DEBUG_FUNCPTR (gst_bench_src_query));
+  gst_pad_use_fixed_caps (src->srcpad);
+  gst_element_add_pad (GST_ELEMENT (src), src->srcpad);
+
+  src->location = g_strdup (DEFAULT_LOCATION);
+  src->format = DEFAULT_FORMAT;
+  src->blocksize = DEFAULT_BLOCKSIZE;
+  src->packet_interval = DEFAULT_PACKET_INTERVAL;
+  src->port = DEFAULT_PORT;
+  src->loops = DEFAULT_LOOPS;
+  src->rate = DEFAULT_RATE;
+  src->buffer_list = DEFAULT_BUFFER_LIST;
+  src->pool_size = DEFAULT_POOL_SIZE;
+
+  src->packets = g_array_new (FALSE, FALSE, sizeof (GstBenchSrcPacket));
+
+  g_mutex_init (&src->lock);
+  g_cond_init (&src->cond);
+
+  GST_OBJECT_FLAG_SET (src, GST_ELEMENT_FLAG_SOURCE);
+}
+
+static void
+gst_bench_src_finalize (GObject * object)
+{
+  GstBenchSrc *src = GST_BENCH_SRC (object);
+
+  g_free (src->location);
+  if (src->caps)
+    gst_caps_unref (src->caps);
+  g_array_free (src->packets, TRUE);
+  g_mutex_clear (&src->lock);
+  g_cond_clear (&src->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_bench_src_add_packet (GstBenchSrc * src, gsize offset, gsize size,
+    GstClockTime time)
+{
+  GstBenchSrcPacket packet;
+
+  packet.offset = offset;
+  packet.size = size;
+  packet.time = time;
+  g_array_append_val (src->packets, packet);
+
+  src->max_packet_size = MAX (src->max_packet_size, size);
+}
+
+/* finds the UDP payload in a captured frame */
+static gboolean
+gst_bench_src_get_udp_payload (GstBenchSrc * src, guint32 linktype,
+    const guint8 * data, gsize len, gsize * offset, gsize * size)
+{
+  gsize pos;
+  guint ethertype, proto, ihl, udp_len;
+
+  switch (linktype) {
+    case LINKTYPE_NULL:
+      pos = 4;
+      break;
+    case LINKTYPE_ETHERNET:
+      if (len < 14)
+        return FALSE;
+      ethertype = GST_READ_UINT16_BE (data + 12);
+      pos = 14;
+      /* skip VLAN tags */
+      while (ethertype == 0x8100 && len >= pos + 4) {
+        ethertype = GST_READ_UINT16_BE (data + pos + 2);
+        pos += 4;
+      }
+      if (ethertype != 0x0800 && ethertype != 0x86dd)
+        return FALSE;
+      break;
+    case LINKTYPE_RAW:
+    case LINKTYPE_RAW_BSD:
+    case LINKTYPE_RAW_OBSD:
+      pos = 0;
+      break;
+    case LINKTYPE_LINUX_SLL:
+      pos = 16;
+      break;
+    default:
+      return FALSE;
+  }
+
+  if (len < pos + 1)
+    return FALSE;
+
+  switch (data[pos] >> 4) {
+    case 4:
+      ihl = (data[pos] & 0x0f) * 4;
+      if (ihl < 20 || len < pos + ihl)
+        return FALSE;
+      /* fragments are not reassembled */
+      if ((GST_READ_UINT16_BE (data + pos + 6) & 0x3fff) != 0)
+        return FALSE;
+      proto = data[pos + 9];
+      pos += ihl;
+      break;
+    case 6:
+      if (len < pos + 40)
+        return FALSE;
+      proto = data[pos + 6];
+      pos += 40;
+      break;
+    default:
+      return FALSE;
+  }
+
+  if (proto != 17 || len < pos + 8)
+    return FALSE;
+
+  if (src->port > 0 && GST_READ_UINT16_BE (data + pos + 2) != src->port)
+    return FALSE;
+
+  udp_len = GST_READ_UINT16_BE (data + pos + 4);
+  if (udp_len < 8 || len < pos + udp_len)
+    return FALSE;
+
+  *offset = pos + 8;
+  *size = udp_len - 8;
+
+  return TRUE;
+}
+
+static gboolean
+gst_bench_src_is_pcap (const guint8 * data, gsize size)
+{
+  guint32 magic;
+
+  if (size < 24)
+    return FALSE;
+
+  magic = GST_READ_UINT32_LE (data);
+
+  return magic == 0xa1b2c3d4 || magic == 0xd4c3b2a1 || magic == 0xa1b23c4d
+      || magic == 0x4d3cb2a1;
+}
+
+static gboolean
+gst_bench_src_parse_pcap (GstBenchSrc * src, const guint8 * data, gsize size)
+{
+  guint32 magic, linktype;
+  gboolean be, nsec;
+  GstClockTime first = GST_CLOCK_TIME_NONE;
+  gsize pos;
+
+#define READ_UINT32(p) (be ? GST_READ_UINT32_BE (p) : GST_READ_UINT32_LE (p))
+
+  magic = GST_READ_UINT32_LE (data);
+  be = magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1;
+  nsec = magic == 0xa1b23c4d || magic == 0x4d3cb2a1;
+  linktype = READ_UINT32 (data + 20);
+
+  GST_DEBUG_OBJECT (src, "pcap file, link type %u", linktype);
+
+  pos = 24;
+  while (pos + 16 <= size) {
+    guint32 sec, frac, incl_len;
+    gsize offset, len;
+    GstClockTime time;
+
+    sec = READ_UINT32 (data + pos);
+    frac = READ_UINT32 (data + pos + 4);
+    incl_len = READ_UINT32 (data + pos + 8);
+    pos += 16;
+
+    if (incl_len > size - pos) {
+      GST_WARNING_OBJECT (src, "truncated packet at offset %" G_GSIZE_FORMAT,
+          pos);
+      break;
+    }
+
+    if (gst_bench_src_get_udp_payload (src, linktype, data + pos, incl_len,
+            &offset, &len)) {
+      time = sec * GST_SECOND + (nsec ? frac : frac * GST_USECOND);
+      if (!GST_CLOCK_TIME_IS_VALID (first))
+        first = time;
+      /* don't go back in time if the capture is not ordered */
+      time = time > first ? time - first : 0;
+      if (src->packets->len > 0)
+        time = MAX (time, g_array_index (src->packets, GstBenchSrcPacket,
+                src->packets->len - 1).time);
+
+      gst_bench_src_add_packet (src, pos + offset, len, time);
+    }
+    pos += incl_len;
+  }
+
+#undef READ_UINT32
+
+  /* make the first packet of the next loop follow the last one by the
+   * average packet distance */
+  if (src->packets->len > 1) {
+    GstClockTime last = g_array_index (src->packets, GstBenchSrcPacket,
+        src->packets->len - 1).time;
+
+    src->loop_duration = last + last / (src->packets->len - 1);
+  }
+
+  return TRUE;
+}
+
+static void
+gst_bench_src_parse_raw (GstBenchSrc * src, gsize size)
+{
+  gsize pos;
+  guint i;
+
+  for (pos = 0, i = 0; pos < size; pos += src->blocksize, i++)
+    gst_bench_src_add_packet (src, pos, MIN (src->blocksize, size - pos),
+        i * src->packet_interval);
+
+  src->loop_duration = i * src->packet_interval;
+}
+
+static gboolean
+gst_bench_src_start (GstBenchSrc * src)
+{
+  GError *err = NULL;
+  gchar *contents;
+  gsize size;
+  GstBenchSrcFormat format;
+
+  if (src->location == NULL || src->location[0] == '\0')
+    goto no_location;
+
+  if (!g_file_get_contents (src->location, &contents, &size, &err))
+    goto read_failed;
+
+  src->data = gst_buffer_new_wrapped (contents, size);
+
+  g_array_set_size (src->packets, 0);
+  src->max_packet_size = 0;
+  src->loop_duration = 0;
+
+  format = src->format;
+  if (format == GST_BENCH_SRC_FORMAT_AUTO)
+    format = gst_bench_src_is_pcap ((guint8 *) contents, size) ?
+        GST_BENCH_SRC_FORMAT_PCAP : GST_BENCH_SRC_FORMAT_RAW;
+
+  if (format == GST_BENCH_SRC_FORMAT_PCAP) {
+    if (!gst_bench_src_is_pcap ((guint8 *) contents, size))
+      goto not_pcap;
+    gst_bench_src_parse_pcap (src, (guint8 *) contents, size);
+  } else {
+    gst_bench_src_parse_raw (src, size);
+  }
+
+  if (src->packets->len == 0)
+    goto no_packets;
+
+  GST_INFO_OBJECT (src, "replaying %u packets of up to %" G_GSIZE_FORMAT
+      " bytes, loop duration %" GST_TIME_FORMAT, src->packets->len,
+      src->max_packet_size, GST_TIME_ARGS (src->loop_duration));
+
+  if (src->pool_size > 0) {
+    GstStructure *config;
+
+    src->pool = gst_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (src->pool);
+    gst_buffer_pool_config_set_params (config, src->caps,
+        src->max_packet_size, src->pool_size, src->pool_size);
+    if (!gst_buffer_pool_set_config (src->pool, config)
+        || !gst_buffer_pool_set_active (src->pool, TRUE))
+      goto pool_failed;
+  }
+
+  src->next = 0;
+  src->loop = 0;
+  src->need_segment = TRUE;
+  src->live = src->rate > 0.0;
+
+  return TRUE;
+
+  /* ERRORS */
+no_location:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND,
+        ("No file name specified for reading."), (NULL));
+    return FALSE;
+  }
+read_failed:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ,
+        ("Could not open file \"%s\" for reading.", src->location),
+        ("%s", err->message));
+    g_error_free (err);
+    return FALSE;
+  }
+not_pcap:
+  {
+    GST_ELEMENT_ERROR (src, STREAM, WRONG_TYPE, (NULL),
+        ("\"%s\" is not a pcap file", src->location));
+    return FALSE;
+  }
+no_packets:
+  {
+    GST_ELEMENT_ERROR (src, STREAM, FAILED, (NULL),
+        ("No packets to replay in \"%s\"", src->location));
+    return FALSE;
+  }
+pool_failed:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS, (NULL),
+        ("Failed to set up a pool of %u buffers", src->pool_size));
+    return FALSE;
+  }
+}
+
+static void
+gst_bench_src_stop (GstBenchSrc * src)
+{
+  if (src->pool) {
+    gst_buffer_pool_set_active (src->pool, FALSE);
+    gst_object_unref (src->pool);
+    src->pool = NULL;
+  }
+  if (src->data) {
+    gst_buffer_unref (src->data);
+    src->data = NULL;
+  }
+  g_array_set_size (src->packets, 0);
+}
+
+static inline GstClockTime
+gst_bench_src_packet_time (GstBenchSrc * src, guint idx)
+{
+  GstClockTime time;
+
+  time = src->loop * src->loop_duration +
+      g_array_index (src->packets, GstBenchSrcPacket, idx).time;
+
+  if (src->live)
+    time = (GstClockTime) (time / src->rate);
+
+  return time;
+}
+
+/* waits until @running_time, returns the current running time or
+ * GST_CLOCK_TIME_NONE when interrupted */
+static GstClockTime
+gst_bench_src_wait (GstBenchSrc * src, GstClockTime running_time)
+{
+  GstClock *clock;
+  GstClockTime base_time, now;
+  GstClockID id;
+  GstClockReturn ret;
+
+  g_mutex_lock (&src->lock);
+  while (!src->playing && !src->flushing)
+    g_cond_wait (&src->cond, &src->lock);
+  if (src->flushing)
+    goto interrupted;
+
+  GST_OBJECT_LOCK (src);
+  if ((clock = GST_ELEMENT_CLOCK (src)))
+    gst_object_ref (clock);
+  base_time = GST_ELEMENT_CAST (src)->base_time;
+  GST_OBJECT_UNLOCK (src);
+
+  if (clock == NULL) {
+    g_mutex_unlock (&src->lock);
+    return running_time;
+  }
+
+  id = src->clock_id = gst_clock_new_single_shot_id (clock,
+      base_time + running_time);
+  g_mutex_unlock (&src->lock);
+
+  ret = gst_clock_id_wait (id, NULL);
+
+  g_mutex_lock (&src->lock);
+  src->clock_id = NULL;
+  g_mutex_unlock (&src->lock);
+  gst_clock_id_unref (id);
+
+  now = gst_clock_get_time (clock) - base_time;
+  gst_object_unref (clock);
+
+  if (ret == GST_CLOCK_UNSCHEDULED)
+    return GST_CLOCK_TIME_NONE;
+
+  return now;
+
+interrupted:
+  {
+    g_mutex_unlock (&src->lock);
+    return GST_CLOCK_TIME_NONE;
+  }
+}
+
+static GstFlowReturn
+gst_bench_src_get_buffer (GstBenchSrc * src, guint idx, GstBuffer ** buffer)
+{
+  GstBenchSrcPacket *packet;
+  GstFlowReturn ret;
+  GstMapInfo map;
+
+  packet = &g_array_index (src->packets, GstBenchSrcPacket, idx);
+
+  if (src->pool) {
+    ret = gst_buffer_pool_acquire_buffer (src->pool, buffer, NULL);
+    if (ret != GST_FLOW_OK)
+      return ret;
+
+    gst_buffer_set_size (*buffer, packet->size);
+    gst_buffer_map (*buffer, &map, GST_MAP_WRITE);
+    gst_buffer_extract (src->data, packet->offset, map.data, packet->size);
+    gst_buffer_unmap (*buffer, &map);
+  } else {
+    *buffer = gst_buffer_copy_region (src->data, GST_BUFFER_COPY_MEMORY,
+        packet->offset, packet->size);
+  }
+
+  GST_BUFFER_PTS (*buffer) = gst_bench_src_packet_time (src, idx);
+  GST_BUFFER_DTS (*buffer) = GST_CLOCK_TIME_NONE;
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_bench_src_loop (GstBenchSrc * src)
+{
+  GstFlowReturn ret;
+  GstBuffer *buffer = NULL;
+  GstBufferList *list = NULL;
+  GstClockTime now = GST_CLOCK_TIME_NONE;
+  guint n;
+
+  if (src->need_segment) {
+    GstSegment segment;
+    gchar *stream_id;
+
+    stream_id = gst_pad_create_stream_id (src->srcpad, GST_ELEMENT_CAST (src),
+        NULL);
+    gst_pad_push_event (src->srcpad, gst_event_new_stream_start (stream_id));
+    g_free (stream_id);
+
+    if (src->caps)
+      gst_pad_push_event (src->srcpad, gst_event_new_caps (src->caps));
+
+    gst_segment_init (&segment, GST_FORMAT_TIME);
+    gst_pad_push_event (src->srcpad, gst_event_new_segment (&segment));
+    src->need_segment = FALSE;
+  }
+
+  if (src->next == src->packets->len) {
+    src->next = 0;
+    src->loop++;
+  }
+  if (src->loops >= 0 && src->loop >= src->loops) {
+    ret = GST_FLOW_EOS;
+    goto pause;
+  }
+
+  if (src->live) {
+    now = gst_bench_src_wait (src,
+        gst_bench_src_packet_time (src, src->next));
+    if (!GST_CLOCK_TIME_IS_VALID (now))
+      goto interrupted;
+  }
+
+  /* push everything that is due, up to buffer-list buffers at once */
+  for (n = 0; n < src->buffer_list && src->next < src->packets->len; n++) {
+    if (n > 0 && src->live
+        && gst_bench_src_packet_time (src, src->next) > now)
+      break;
+
+    ret = gst_bench_src_get_buffer (src, src->next, &buffer);
+    if (ret != GST_FLOW_OK)
+      goto pause;
+
+    if (src->next == 0 && src->loop == 0)
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+    src->next++;
+
+    if (src->buffer_list > 1) {
+      if (list == NULL)
+        list = gst_buffer_list_new_sized (src->buffer_list);
+      gst_buffer_list_add (list, buffer);
+    }
+  }
+
+  if (list)
+    ret = gst_pad_push_list (src->srcpad, list);
+  else
+    ret = gst_pad_push (src->srcpad, buffer);
+
+  if (ret != GST_FLOW_OK)
+    goto pause;
+
+  return;
+
+  /* ERRORS */
+interrupted:
+  {
+    /* retry the same packet when we are back in PLAYING */
+    g_mutex_lock (&src->lock);
+    if (src->flushing) {
+      g_mutex_unlock (&src->lock);
+      ret = GST_FLOW_FLUSHING;
+      goto pause;
+    }
+    g_mutex_unlock (&src->lock);
+    return;
+  }
+pause:
+  {
+    if (list)
+      gst_buffer_list_unref (list);
+
+    GST_DEBUG_OBJECT (src, "pausing task, reason %s", gst_flow_get_name (ret));
+    gst_pad_pause_task (src->srcpad);
+    if (ret == GST_FLOW_EOS) {
+      gst_pad_push_event (src->srcpad, gst_event_new_eos ());
+    } else if (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS) {
+      GST_ELEMENT_ERROR (src, STREAM, FAILED,
+          ("Internal data stream error."),
+          ("streaming stopped, reason %s", gst_flow_get_name (ret)));
+      gst_pad_push_event (src->srcpad, gst_event_new_eos ());
+    }
+    return;
+  }
+}
+
+static gboolean
+gst_bench_src_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  GstBenchSrc *src = GST_BENCH_SRC (parent);
+  gboolean res;
+
+  switch (mode) {
+    case GST_PAD_MODE_PUSH:
+      if (active) {
+        g_mutex_lock (&src->lock);
+        src->flushing = FALSE;
+        g_mutex_unlock (&src->lock);
+
+        res = gst_pad_start_task (pad, (GstTaskFunction) gst_bench_src_loop,
+            src, NULL);
+      } else {
+        g_mutex_lock (&src->lock);
+        src->flushing = TRUE;
+        if (src->clock_id)
+          gst_clock_id_unschedule (src->clock_id);
+        g_cond_broadcast (&src->cond);
+        g_mutex_unlock (&src->lock);
+
+        /* unblock a pending acquire */
+        if (src->pool)
+          gst_buffer_pool_set_active (src->pool, FALSE);
+
+        res = gst_pad_stop_task (pad);
+      }
+      break;
+    default:
+      res = FALSE;
+      break;
+  }
+
+  return res;
+}
+
+static gboolean
+gst_bench_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  GstBenchSrc *src = GST_BENCH_SRC (parent);
+  gboolean res;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_LATENCY:
+      gst_query_set_latency (query, src->live, 0, GST_CLOCK_TIME_NONE);
+      res = TRUE;
+      break;
+    default:
+      res = gst_pad_query_default (pad, parent, query);
+      break;
+  }
+
+  return res;
+}
+
+static GstStateChangeReturn
+gst_bench_src_change_state (GstElement * element, GstStateChange transition)
+{
+  GstBenchSrc *src = GST_BENCH_SRC (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (!gst_bench_src_start (src)) {
+        gst_bench_src_stop (src);
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
+      g_mutex_lock (&src->lock);
+      src->playing = TRUE;
+      g_cond_broadcast (&src->cond);
+      g_mutex_unlock (&src->lock);
+      break;
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      g_mutex_lock (&src->lock);
+      src->playing = FALSE;
+      if (src->clock_id)
+        gst_clock_id_unschedule (src->clock_id);
+      g_mutex_unlock (&src->lock);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      if (src->live)
+        ret = GST_STATE_CHANGE_NO_PREROLL;
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_bench_src_stop (src);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static void
+gst_bench_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstBenchSrc *src = GST_BENCH_SRC (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      g_free (src->location);
+      src->location = g_value_dup_string (value);
+      break;
+    case PROP_FORMAT:
+      src->format = g_value_get_enum (value);
+      break;
+    case PROP_BLOCKSIZE:
+      src->blocksize = g_value_get_uint (value);
+      break;
+    case PROP_PACKET_INTERVAL:
+      src->packet_interval = g_value_get_uint64 (value);
+      break;
+    case PROP_PORT:
+      src->port = g_value_get_int (value);
+      break;
+    case PROP_LOOPS:
+      src->loops = g_value_get_int (value);
+      break;
+    case PROP_RATE:
+      src->rate = g_value_get_double (value);
+      break;
+    case PROP_BUFFER_LIST:
+      src->buffer_list = g_value_get_uint (value);
+      break;
+    case PROP_POOL_SIZE:
+      src->pool_size = g_value_get_uint (value);
+      break;
+    case PROP_CAPS:
+    {
+      const GstCaps *caps = gst_value_get_caps (value);
+
+      if (src->caps)
+        gst_caps_unref (src->caps);
+      src->caps = caps ? gst_caps_copy (caps) : NULL;
+      break;
+    }
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_bench_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstBenchSrc *src = GST_BENCH_SRC (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      g_value_set_string (value, src->location);
+      break;
+    case PROP_FORMAT:
+      g_value_set_enum (value, src->format);
+      break;
+    case PROP_BLOCKSIZE:
+      g_value_set_uint (value, src->blocksize);
+      break;
+    case PROP_PACKET_INTERVAL:
+      g_value_set_uint64 (value, src->packet_interval);
+      break;
+    case PROP_PORT:
+      g_value_set_int (value, src->port);
+      break;
+    case PROP_LOOPS:
+      g_value_set_int (value, src->loops);
+      break;
+    case PROP_RATE:
+      g_value_set_double (value, src->rate);
+      break;
+    case PROP_BUFFER_LIST:
+      g_value_set_uint (value, src->buffer_list);
+      break;
+    case PROP_POOL_SIZE:
+      g_value_set_uint (value, src->pool_size);
+      break;
+    case PROP_CAPS:
+      gst_value_set_caps (value, src->caps);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
@@ -0,0 +1,114 @@
+/* GStreamer Benchmark Source Element
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_BENCH_SRC_H__
+#define __GST_BENCH_SRC_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_BENCH_SRC \
+  (gst_bench_src_get_type())
+#define GST_BENCH_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_BENCH_SRC,GstBenchSrc))
+#define GST_BENCH_SRC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_BENCH_SRC,GstBenchSrcClass))
+#define GST_IS_BENCH_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_BENCH_SRC))
+#define GST_IS_BENCH_SRC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_BENCH_SRC))
+typedef struct _GstBenchSrc GstBenchSrc;
+typedef struct _GstBenchSrcClass GstBenchSrcClass;
+
+/**
+ * GstBenchSrcFormat:
+ * @GST_BENCH_SRC_FORMAT_AUTO: pcap if the file starts with a pcap header,
+ *     raw otherwise
+ * @GST_BENCH_SRC_FORMAT_RAW: fixed size chunks of the file
+ * @GST_BENCH_SRC_FORMAT_PCAP: UDP payloads of a pcap capture
+ *
+ * How the file is split into buffers.
+ */
+typedef enum
+{
+  GST_BENCH_SRC_FORMAT_AUTO,
+  GST_BENCH_SRC_FORMAT_RAW,
+  GST_BENCH_SRC_FORMAT_PCAP
+} GstBenchSrcFormat;
+
+typedef struct
+{
+  gsize offset;
+  gsize size;
+  GstClockTime time;
+} GstBenchSrcPacket;
+
+/**
+ * GstBenchSrc:
+ *
+ * Opaque #GstBenchSrc data structure
+ */
+struct _GstBenchSrc
+{
+  GstElement element;
+
+  /*< private > */
+  GstPad *srcpad;
+
+  /* properties */
+  gchar *location;
+  GstBenchSrcFormat format;
+  guint blocksize;
+  GstClockTime packet_interval;
+  gint port;
+  gint loops;
+  gdouble rate;
+  guint buffer_list;
+  guint pool_size;
+  GstCaps *caps;
+
+  /* the file and its packets, set up in READY->PAUSED */
+  GstBuffer *data;
+  GArray *packets;
+  gsize max_packet_size;
+  GstClockTime loop_duration;
+  GstBufferPool *pool;
+
+  /* streaming thread state */
+  guint next;
+  gint loop;
+  gboolean need_segment;
+
+  GMutex lock;
+  GCond cond;
+  gboolean live;
+  gboolean playing;
+  gboolean flushing;
+  GstClockID clock_id;
+};
+
+struct _GstBenchSrcClass
+{
+  GstElementClass parent_class;
+};
+
+GType gst_bench_src_get_type (void);
+
+G_END_DECLS
+#endif /* __GST_BENCH_SRC_H__ */
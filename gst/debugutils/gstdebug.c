@@ -36,6 +36,12 @@ GType gst_push_file_src_get_type (void);
 GType gst_gst_negotiation_get_type (void);
 */
 GType gst_cpu_report_get_type (void);
+GType gst_latency_probe_get_type (void);
+GType gst_bench_src_get_type (void);
+GType gst_bench_sink_get_type (void);
+#ifdef HAVE_MMAP
+GType gst_mmap_file_src_get_type (void);
+#endif
 
 static gboolean
 plugin_init (GstPlugin * plugin)
@@ -62,7 +68,17 @@ plugin_init (GstPlugin * plugin)
           gst_caps_debug_get_type ())
 #endif
       || !gst_element_register (plugin, "cpureport", GST_RANK_NONE,
-          gst_cpu_report_get_type ()))
+          gst_cpu_report_get_type ())
+      || !gst_element_register (plugin, "latencyprobe", GST_RANK_NONE,
+          gst_latency_probe_get_type ())
+      || !gst_element_register (plugin, "benchsrc", GST_RANK_NONE,
+          gst_bench_src_get_type ())
+#ifdef HAVE_MMAP
+      || !gst_element_register (plugin, "mmapfilesrc", GST_RANK_NONE,
+          gst_mmap_file_src_get_type ())
+#endif
+      || !gst_element_register (plugin, "benchsink", GST_RANK_NONE,
+          gst_bench_sink_get_type ()))
 
     return FALSE;
 
@@ -0,0 +1,553 @@
+/* GStreamer Latency Probe Element
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:element-latencyprobe
+ *
+ * Measures how long buffers take to get from one point in a pipeline to
+ * another. The element has two pairs of pads that pass data through
+ * unmodified: buffers going from sink to src mark the start point and
+ * buffers going from end_sink to end_src the end point. Buffers are matched
+ * by their timestamp (PTS, or DTS if there is no PTS), so the elements in
+ * between must keep it.
+ *
+ * The latencies are collected in a histogram with a relative precision of
+ * about 6% and a "latency-probe" element message is posted every
+ * #GstLatencyProbe:interval with the statistics since the previous one:
+ * <itemizedlist>
+ * <listitem>
+ *   <para>
+ *   #guint64
+ *   <classname>&quot;count&quot;</classname>:
+ *   the number of buffers measured.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #guint64
+ *   <classname>&quot;unmatched&quot;</classname>:
+ *   the number of buffers that were seen at the start point but not at the
+ *   end point, or the other way around.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #GstClockTime
+ *   <classname>&quot;min&quot;</classname>,
+ *   <classname>&quot;max&quot;</classname>,
+ *   <classname>&quot;mean&quot;</classname>:
+ *   the smallest, largest and average latency.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #GstClockTime
+ *   <classname>&quot;p50&quot;</classname>,
+ *   <classname>&quot;p90&quot;</classname>,
+ *   <classname>&quot;p99&quot;</classname>,
+ *   <classname>&quot;p999&quot;</classname>:
+ *   the 50th, 90th, 99th and 99.9th percentile of the latency.
+ *   </para>
+ * </listitem>
+ * </itemizedlist>
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 -m videotestsrc is-live=true ! latencyprobe name=p ! x264enc ! p.end_sink p.end_src ! fakesink
+ * ]| Print the latency of x264enc every second.
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstlatencyprobe.h"
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate end_sink_template =
+GST_STATIC_PAD_TEMPLATE ("end_sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate end_src_template =
+GST_STATIC_PAD_TEMPLATE ("end_src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+GST_DEBUG_CATEGORY_STATIC (gst_latency_probe_debug);
+#define GST_CAT_DEFAULT gst_latency_probe_debug
+
+#define DEFAULT_INTERVAL GST_SECOND
+
+enum
+{
+  PROP_0,
+  PROP_INTERVAL,
+  PROP_STATS
+};
+
+static void gst_latency_probe_finalize (GObject * object);
+static void gst_latency_probe_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_latency_probe_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static GstStateChangeReturn gst_latency_probe_change_state (GstElement *
+    element, GstStateChange transition);
+
+static GstFlowReturn gst_latency_probe_chain (GstPad * pad,
+    GstObject * parent, GstBuffer * buffer);
+static GstFlowReturn gst_latency_probe_end_chain (GstPad * pad,
+    GstObject * parent, GstBuffer * buffer);
+static gboolean gst_latency_probe_sink_event (GstPad * pad,
+    GstObject * parent, GstEvent * event);
+static GstIterator *gst_latency_probe_iterate_internal_links (GstPad * pad,
+    GstObject * parent);
+
+#define gst_latency_probe_parent_class parent_class
+G_DEFINE_TYPE (GstLatencyProbe, gst_latency_probe, GST_TYPE_ELEMENT);
+
+static void
+gst_latency_probe_class_init (GstLatencyProbeClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->finalize = gst_latency_probe_finalize;
+  gobject_class->set_property = gst_latency_probe_set_property;
+  gobject_class->get_property = gst_latency_probe_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_INTERVAL,
+      g_param_spec_uint64 ("interval", "Interval",
+          "Interval in nanoseconds between latency-probe messages "
+          "(0 = no messages)", 0, G_MAXUINT64, DEFAULT_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Latency statistics of the current interval, with the same fields "
+          "as the latency-probe message", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_template));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_template));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&end_sink_template));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&end_src_template));
+
+  gst_element_class_set_static_metadata (element_class, "Latency probe",
+      "Testing",
+      "Measure the latency of buffers between two points of a pipeline",
+      "GStreamer maintainers <gstreamer-devel@lists.sourceforge.net>");
+
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_latency_probe_change_state);
+
+  GST_DEBUG_CATEGORY_INIT (gst_latency_probe_debug, "latencyprobe", 0,
+      "latency probe element");
+}
+
+static GstPad *
+gst_latency_probe_add_pad (GstLatencyProbe * probe,
+    GstStaticPadTemplate * templ, GstPadChainFunction chain)
+{
+  GstPad *pad;
+
+  pad = gst_pad_new_from_static_template (templ, templ->name_template);
+  if (chain) {
+    gst_pad_set_chain_function (pad, chain);
+    gst_pad_set_event_function (pad,
+        GST_DEBUG_FUNCPTR (gst_latency_probe_sink_event));
+  }
+  gst_pad_set_iterate_internal_links_function (pad,
+      GST_DEBUG_FUNCPTR (gst_latency_probe_iterate_internal_links));
+  GST_PAD_SET_PROXY_CAPS (pad);
+  GST_PAD_SET_PROXY_ALLOCATION (pad);
+  GST_PAD_SET_PROXY_SCHEDULING (pad);
+  gst_element_add_pad (GST_ELEMENT (probe), pad);
+
+  return pad;
+}
+
+static void
+gst_latency_probe_reset_stats (GstLatencyProbe * probe)
+{
+  memset (probe->buckets, 0, sizeof (probe->buckets));
+  probe->count = 0;
+  probe->sum = 0;
+  probe->min = GST_CLOCK_TIME_NONE;
+  probe->max = 0;
+  probe->unmatched = 0;
+}
+
+static void
+gst_latency_probe_reset (GstLatencyProbe * probe)
+{
+  g_mutex_lock (&probe->lock);
+  probe->pending_head = probe->pending_tail = 0;
+  gst_latency_probe_reset_stats (probe);
+  probe->last_report = GST_CLOCK_TIME_NONE;
+  g_mutex_unlock (&probe->lock);
+}
+
+static void
+gst_latency_probe_init (GstLatencyProbe * probe)
+{
+  probe->sinkpad = gst_latency_probe_add_pad (probe, &sink_template,
+      GST_DEBUG_FUNCPTR (gst_latency_probe_chain));
+  probe->srcpad = gst_latency_probe_add_pad (probe, &src_template, NULL);
+  probe->end_sinkpad = gst_latency_probe_add_pad (probe, &end_sink_template,
+      GST_DEBUG_FUNCPTR (gst_latency_probe_end_chain));
+  probe->end_srcpad = gst_latency_probe_add_pad (probe, &end_src_template,
+      NULL);
+
+  probe->interval = DEFAULT_INTERVAL;
+
+  g_mutex_init (&probe->lock);
+  gst_latency_probe_reset (probe);
+}
+
+static void
+gst_latency_probe_finalize (GObject * object)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (object);
+
+  g_mutex_clear (&probe->lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+/* Buckets 0-31 hold their own value, above that every power of two is split
+ * into 16 buckets using the 4 bits after the most significant one */
+static inline guint
+gst_latency_probe_bucket (guint64 val)
+{
+  guint shift;
+
+  if (val < 32)
+    return val;
+
+  shift = g_bit_storage (val) - 5;
+
+  return 32 + (shift - 1) * 16 + ((val >> shift) - 16);
+}
+
+/* the largest value that ends up in @bucket */
+static guint64
+gst_latency_probe_bucket_max (guint bucket)
+{
+  guint shift;
+  guint64 m;
+
+  if (bucket < 32)
+    return bucket;
+
+  shift = (bucket - 32) / 16 + 1;
+  m = (bucket - 32) % 16 + 16;
+
+  return ((m + 1) << shift) - 1;
+}
+
+/* with the lock */
+static GstClockTime
+gst_latency_probe_percentile (GstLatencyProbe * probe, gdouble percentile)
+{
+  guint64 rank, seen = 0;
+  guint i;
+
+  if (probe->count == 0)
+    return GST_CLOCK_TIME_NONE;
+
+  rank = MAX (1, (guint64) (percentile * probe->count / 100.0 + 0.5));
+  for (i = 0; i < GST_LATENCY_PROBE_BUCKETS; i++) {
+    seen += probe->buckets[i];
+    if (seen >= rank)
+      return MIN (gst_latency_probe_bucket_max (i), probe->max);
+  }
+
+  return probe->max;
+}
+
+/* with the lock */
+static GstStructure *
+gst_latency_probe_create_stats (GstLatencyProbe * probe)
+{
+  return gst_structure_new ("latency-probe",
+      "count", G_TYPE_UINT64, probe->count,
+      "unmatched", G_TYPE_UINT64, probe->unmatched,
+      "min", G_TYPE_UINT64, probe->min,
+      "max", G_TYPE_UINT64, probe->count ? probe->max : GST_CLOCK_TIME_NONE,
+      "mean", G_TYPE_UINT64,
+      probe->count ? probe->sum / probe->count : GST_CLOCK_TIME_NONE,
+      "p50", G_TYPE_UINT64, gst_latency_probe_percentile (probe, 50.0),
+      "p90", G_TYPE_UINT64, gst_latency_probe_percentile (probe, 90.0),
+      "p99", G_TYPE_UINT64, gst_latency_probe_percentile (probe, 99.0),
+      "p999", G_TYPE_UINT64, gst_latency_probe_percentile (probe, 99.9),
+      NULL);
+}
+
+static void
+gst_latency_probe_post_stats (GstLatencyProbe * probe, GstStructure * s)
+{
+  GST_DEBUG_OBJECT (probe, "posting %" GST_PTR_FORMAT, s);
+
+  gst_element_post_message (GST_ELEMENT_CAST (probe),
+      gst_message_new_element (GST_OBJECT_CAST (probe), s));
+}
+
+static inline GstClockTime
+gst_latency_probe_buffer_ts (GstBuffer * buffer)
+{
+  if (GST_BUFFER_PTS_IS_VALID (buffer))
+    return GST_BUFFER_PTS (buffer);
+
+  return GST_BUFFER_DTS (buffer);
+}
+
+static GstFlowReturn
+gst_latency_probe_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (parent);
+  GstClockTime ts;
+
+  ts = gst_latency_probe_buffer_ts (buffer);
+
+  if (GST_CLOCK_TIME_IS_VALID (ts)) {
+    GstLatencyProbePending *p;
+
+    g_mutex_lock (&probe->lock);
+    if (probe->pending_head - probe->pending_tail == GST_LATENCY_PROBE_PENDING) {
+      /* never arrived at the end point */
+      if (GST_CLOCK_TIME_IS_VALID (probe->pending[probe->pending_tail %
+                  GST_LATENCY_PROBE_PENDING].time))
+        probe->unmatched++;
+      probe->pending_tail++;
+    }
+    p = &probe->pending[probe->pending_head++ % GST_LATENCY_PROBE_PENDING];
+    p->ts = ts;
+    p->time = gst_util_get_timestamp ();
+    g_mutex_unlock (&probe->lock);
+  }
+
+  return gst_pad_push (probe->srcpad, buffer);
+}
+
+static GstFlowReturn
+gst_latency_probe_end_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * buffer)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (parent);
+  GstStructure *report = NULL;
+  GstClockTime ts, now;
+
+  ts = gst_latency_probe_buffer_ts (buffer);
+  if (!GST_CLOCK_TIME_IS_VALID (ts))
+    goto done;
+
+  now = gst_util_get_timestamp ();
+
+  g_mutex_lock (&probe->lock);
+  {
+    GstClockTime latency = GST_CLOCK_TIME_NONE;
+    guint i;
+
+    /* buffers mostly arrive in order, so the match is usually the oldest
+     * entry. Elements in between can reorder though, e.g. decoders. */
+    for (i = probe->pending_tail; i != probe->pending_head; i++) {
+      GstLatencyProbePending *p = &probe->pending[i % GST_LATENCY_PROBE_PENDING];
+
+      if (p->ts == ts && GST_CLOCK_TIME_IS_VALID (p->time)) {
+        latency = now - p->time;
+        p->time = GST_CLOCK_TIME_NONE;
+        break;
+      }
+    }
+
+    /* drop matched entries at the tail */
+    while (probe->pending_tail != probe->pending_head
+        && !GST_CLOCK_TIME_IS_VALID (probe->pending[probe->pending_tail %
+                GST_LATENCY_PROBE_PENDING].time))
+      probe->pending_tail++;
+
+    if (GST_CLOCK_TIME_IS_VALID (latency)) {
+      probe->buckets[gst_latency_probe_bucket (latency)]++;
+      probe->count++;
+      probe->sum += latency;
+      probe->min = MIN (probe->min, latency);
+      probe->max = MAX (probe->max, latency);
+    } else {
+      probe->unmatched++;
+    }
+
+    if (!GST_CLOCK_TIME_IS_VALID (probe->last_report))
+      probe->last_report = now;
+
+    if (probe->interval > 0 && now - probe->last_report >= probe->interval) {
+      report = gst_latency_probe_create_stats (probe);
+      gst_latency_probe_reset_stats (probe);
+      probe->last_report = now;
+    }
+  }
+  g_mutex_unlock (&probe->lock);
+
+  if (report)
+    gst_latency_probe_post_stats (probe, report);
+
+done:
+  return gst_pad_push (probe->end_srcpad, buffer);
+}
+
+static gboolean
+gst_latency_probe_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (parent);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_STOP:
+      /* the flushed buffers won't arrive at the end point */
+      if (pad == probe->sinkpad) {
+        g_mutex_lock (&probe->lock);
+        probe->pending_head = probe->pending_tail = 0;
+        g_mutex_unlock (&probe->lock);
+      }
+      break;
+    case GST_EVENT_EOS:
+      /* report what was collected since the last message */
+      if (pad == probe->end_sinkpad && probe->interval > 0) {
+        GstStructure *report = NULL;
+
+        g_mutex_lock (&probe->lock);
+        if (probe->count > 0 || probe->unmatched > 0) {
+          report = gst_latency_probe_create_stats (probe);
+          gst_latency_probe_reset_stats (probe);
+        }
+        g_mutex_unlock (&probe->lock);
+
+        if (report)
+          gst_latency_probe_post_stats (probe, report);
+      }
+      break;
+    default:
+      break;
+  }
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+static GstIterator *
+gst_latency_probe_iterate_internal_links (GstPad * pad, GstObject * parent)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (parent);
+  GstIterator *it;
+  GstPad *otherpad;
+  GValue val = { 0, };
+
+  if (pad == probe->sinkpad)
+    otherpad = probe->srcpad;
+  else if (pad == probe->srcpad)
+    otherpad = probe->sinkpad;
+  else if (pad == probe->end_sinkpad)
+    otherpad = probe->end_srcpad;
+  else
+    otherpad = probe->end_sinkpad;
+
+  g_value_init (&val, GST_TYPE_PAD);
+  g_value_set_object (&val, otherpad);
+  it = gst_iterator_new_single (GST_TYPE_PAD, &val);
+  g_value_unset (&val);
+
+  return it;
+}
+
+static GstStateChangeReturn
+gst_latency_probe_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (element);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_latency_probe_reset (probe);
+      break;
+    default:
+      break;
+  }
+
+  return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+}
+
+static void
+gst_latency_probe_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (object);
+
+  switch (prop_id) {
+    case PROP_INTERVAL:
+      g_mutex_lock (&probe->lock);
+      probe->interval = g_value_get_uint64 (value);
+      g_mutex_unlock (&probe->lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_latency_probe_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstLatencyProbe *probe = GST_LATENCY_PROBE (object);
+
+  switch (prop_id) {
+    case PROP_INTERVAL:
+      g_mutex_lock (&probe->lock);
+      g_value_set_uint64 (value, probe->interval);
+      g_mutex_unlock (&probe->lock);
+      break;
+    case PROP_STATS:
+      g_mutex_lock (&probe->lock);
+      g_value_take_boxed (value, gst_latency_probe_create_stats (probe));
+      g_mutex_unlock (&probe->lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
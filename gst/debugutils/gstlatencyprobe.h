@@ -0,0 +1,90 @@
+/* GStreamer Latency Probe Element
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_LATENCY_PROBE_H__
+#define __GST_LATENCY_PROBE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_LATENCY_PROBE \
+  (gst_latency_probe_get_type())
+#define GST_LATENCY_PROBE(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_LATENCY_PROBE,GstLatencyProbe))
+#define GST_LATENCY_PROBE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_LATENCY_PROBE,GstLatencyProbeClass))
+#define GST_IS_LATENCY_PROBE(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_LATENCY_PROBE))
+#define GST_IS_LATENCY_PROBE_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_LATENCY_PROBE))
+typedef struct _GstLatencyProbe GstLatencyProbe;
+typedef struct _GstLatencyProbeClass GstLatencyProbeClass;
+
+/* number of buffers that can be in flight between the two points */
+#define GST_LATENCY_PROBE_PENDING 1024
+
+/* log-linear histogram buckets, 16 per power of two, covering all of
+ * guint64 */
+#define GST_LATENCY_PROBE_BUCKETS 976
+
+typedef struct
+{
+  GstClockTime ts;
+  GstClockTime time;
+} GstLatencyProbePending;
+
+/**
+ * GstLatencyProbe:
+ *
+ * Opaque #GstLatencyProbe data structure
+ */
+struct _GstLatencyProbe
+{
+  GstElement element;
+
+  /*< private > */
+  GstPad *sinkpad, *srcpad;
+  GstPad *end_sinkpad, *end_srcpad;
+
+  /* properties */
+  GstClockTime interval;
+
+  GMutex lock;
+
+  /* buffers that passed the start point, oldest at pending_tail */
+  GstLatencyProbePending pending[GST_LATENCY_PROBE_PENDING];
+  guint pending_head, pending_tail;
+
+  /* latencies in the current report interval */
+  guint64 buckets[GST_LATENCY_PROBE_BUCKETS];
+  guint64 count;
+  GstClockTime sum, min, max;
+  GstClockTime last_report;
+  guint64 unmatched;
+};
+
+struct _GstLatencyProbeClass
+{
+  GstElementClass parent_class;
+};
+
+GType gst_latency_probe_get_type (void);
+
+G_END_DECLS
+#endif /* __GST_LATENCY_PROBE_H__ */
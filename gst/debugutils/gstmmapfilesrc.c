@@ -0,0 +1,394 @@
+/* GStreamer mmap File Source
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-mmapfilesrc
+ * @see_also: filesrc, pushfilesrc
+ *
+ * Reads a local file like filesrc, but maps it into memory instead of
+ * reading it. Every buffer shares a read-only part of the mapping, so no
+ * data is copied and the cost of reading the file shows up as page faults
+ * instead of memcpy. The kernel is told that the file will be read
+ * sequentially and the next #GstMmapFileSrc:readahead bytes are requested
+ * in advance.
+ *
+ * This makes benchmarks of demuxers and parsers measure their own cost
+ * rather than the cost of copying the data. The file must not be truncated
+ * while it is mapped.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 mmapfilesrc location=movie.mkv ! matroskademux ! fakesink
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#include "gstmmapfilesrc.h"
+
+GST_DEBUG_CATEGORY_STATIC (mmapfilesrc_debug);
+#define GST_CAT_DEFAULT mmapfilesrc_debug
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+#define DEFAULT_LOCATION   NULL
+#define DEFAULT_READAHEAD  (4 * 1024 * 1024)
+
+enum
+{
+  PROP_0,
+  PROP_LOCATION,
+  PROP_READAHEAD
+};
+
+typedef struct
+{
+  gpointer data;
+  gsize size;
+} GstMmapFileSrcMapping;
+
+static void gst_mmap_file_src_finalize (GObject * object);
+static void gst_mmap_file_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_mmap_file_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static gboolean gst_mmap_file_src_start (GstBaseSrc * basesrc);
+static gboolean gst_mmap_file_src_stop (GstBaseSrc * basesrc);
+static gboolean gst_mmap_file_src_is_seekable (GstBaseSrc * basesrc);
+static gboolean gst_mmap_file_src_get_size (GstBaseSrc * basesrc,
+    guint64 * size);
+static GstFlowReturn gst_mmap_file_src_create (GstBaseSrc * basesrc,
+    guint64 offset, guint length, GstBuffer ** buffer);
+
+#define gst_mmap_file_src_parent_class parent_class
+G_DEFINE_TYPE (GstMmapFileSrc, gst_mmap_file_src, GST_TYPE_BASE_SRC);
+
+static void
+gst_mmap_file_src_class_init (GstMmapFileSrcClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+  GstBaseSrcClass *basesrc_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  element_class = GST_ELEMENT_CLASS (klass);
+  basesrc_class = GST_BASE_SRC_CLASS (klass);
+
+  GST_DEBUG_CATEGORY_INIT (mmapfilesrc_debug, "mmapfilesrc", 0,
+      "mmapfilesrc element");
+
+  gobject_class->finalize = gst_mmap_file_src_finalize;
+  gobject_class->set_property = gst_mmap_file_src_set_property;
+  gobject_class->get_property = gst_mmap_file_src_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_LOCATION,
+      g_param_spec_string ("location", "File Location",
+          "Location of the file to read", DEFAULT_LOCATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject_class, PROP_READAHEAD,
+      g_param_spec_uint64 ("readahead", "Readahead",
+          "Number of bytes to ask the kernel to read ahead (0 = disabled)", 0,
+          G_MAXUINT64, DEFAULT_READAHEAD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&srctemplate));
+
+  gst_element_class_set_static_metadata (element_class, "mmap File Source",
+      "Source/File",
+      "Read from a memory mapped file without copying",
+      "GStreamer maintainers <gstreamer-devel@lists.sourceforge.net>");
+
+  basesrc_class->start = GST_DEBUG_FUNCPTR (gst_mmap_file_src_start);
+  basesrc_class->stop = GST_DEBUG_FUNCPTR (gst_mmap_file_src_stop);
+  basesrc_class->is_seekable = GST_DEBUG_FUNCPTR (gst_mmap_file_src_is_seekable);
+  basesrc_class->get_size = GST_DEBUG_FUNCPTR (gst_mmap_file_src_get_size);
+  basesrc_class->create = GST_DEBUG_FUNCPTR (gst_mmap_file_src_create);
+}
+
+static void
+gst_mmap_file_src_init (GstMmapFileSrc * src)
+{
+  src->location = g_strdup (DEFAULT_LOCATION);
+  src->readahead = DEFAULT_READAHEAD;
+}
+
+static void
+gst_mmap_file_src_finalize (GObject * object)
+{
+  GstMmapFileSrc *src = GST_MMAP_FILE_SRC (object);
+
+  g_free (src->location);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_mmap_file_src_unmap (GstMmapFileSrcMapping * mapping)
+{
+  munmap (mapping->data, mapping->size);
+  g_slice_free (GstMmapFileSrcMapping, mapping);
+}
+
+static gboolean
+gst_mmap_file_src_start (GstBaseSrc * basesrc)
+{
+  GstMmapFileSrc *src = GST_MMAP_FILE_SRC (basesrc);
+  GstMmapFileSrcMapping *mapping;
+  struct stat st;
+  gpointer data;
+  gint fd;
+
+  if (src->location == NULL || src->location[0] == '\0')
+    goto no_filename;
+
+  fd = open (src->location, O_RDONLY);
+  if (fd < 0)
+    goto open_failed;
+
+  if (fstat (fd, &st) < 0)
+    goto stat_failed;
+
+  if (!S_ISREG (st.st_mode))
+    goto not_regular;
+
+  src->size = st.st_size;
+  src->readahead_end = 0;
+
+  /* an empty file can't be mapped, it ends right away */
+  if (src->size == 0) {
+    close (fd);
+    return TRUE;
+  }
+
+  if (src->size > G_MAXSIZE)
+    goto too_large;
+
+  data = mmap (NULL, src->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED)
+    goto mmap_failed;
+  close (fd);
+
+#ifdef MADV_SEQUENTIAL
+  madvise (data, src->size, MADV_SEQUENTIAL);
+#endif
+
+  src->data = data;
+
+  mapping = g_slice_new (GstMmapFileSrcMapping);
+  mapping->data = data;
+  mapping->size = src->size;
+
+  /* unmapped when the last buffer sharing it is gone */
+  src->mem = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, data,
+      src->size, 0, src->size, mapping,
+      (GDestroyNotify) gst_mmap_file_src_unmap);
+
+  GST_DEBUG_OBJECT (src, "mapped %" G_GUINT64_FORMAT " bytes of %s",
+      src->size, src->location);
+
+  return TRUE;
+
+  /* ERROR */
+no_filename:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND,
+        ("No file name specified for reading."), (NULL));
+    return FALSE;
+  }
+open_failed:
+  {
+    if (errno == ENOENT)
+      GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND,
+          ("No such file \"%s\"", src->location), GST_ERROR_SYSTEM);
+    else
+      GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ,
+          ("Could not open file \"%s\" for reading.", src->location),
+          GST_ERROR_SYSTEM);
+    return FALSE;
+  }
+stat_failed:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ,
+        ("Could not get info on \"%s\".", src->location), GST_ERROR_SYSTEM);
+    close (fd);
+    return FALSE;
+  }
+not_regular:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ,
+        ("\"%s\" is not a regular file.", src->location), (NULL));
+    close (fd);
+    return FALSE;
+  }
+too_large:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ,
+        ("\"%s\" is too large to be mapped.", src->location), (NULL));
+    close (fd);
+    return FALSE;
+  }
+mmap_failed:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ,
+        ("Could not map file \"%s\".", src->location), GST_ERROR_SYSTEM);
+    close (fd);
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_mmap_file_src_stop (GstBaseSrc * basesrc)
+{
+  GstMmapFileSrc *src = GST_MMAP_FILE_SRC (basesrc);
+
+  if (src->mem) {
+    gst_memory_unref (src->mem);
+    src->mem = NULL;
+  }
+  src->data = NULL;
+  src->size = 0;
+
+  return TRUE;
+}
+
+static gboolean
+gst_mmap_file_src_is_seekable (GstBaseSrc * basesrc)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_mmap_file_src_get_size (GstBaseSrc * basesrc, guint64 * size)
+{
+  GstMmapFileSrc *src = GST_MMAP_FILE_SRC (basesrc);
+
+  *size = src->size;
+
+  return TRUE;
+}
+
+/* asks for the next readahead bytes after @offset, but only once half of the
+ * previous window was consumed or after a seek */
+static void
+gst_mmap_file_src_readahead (GstMmapFileSrc * src, guint64 offset)
+{
+#ifdef MADV_WILLNEED
+  guint64 start, end;
+  gsize page_size;
+
+  if (src->readahead == 0)
+    return;
+
+  if (offset + src->readahead / 2 < src->readahead_end
+      && offset + src->readahead >= src->readahead_end)
+    return;
+
+  page_size = sysconf (_SC_PAGESIZE);
+  start = offset & ~((guint64) page_size - 1);
+  end = MIN (offset + src->readahead, src->size);
+  if (start >= end || end == src->readahead_end)
+    return;
+
+  GST_LOG_OBJECT (src, "readahead %" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT,
+      start, end);
+  madvise ((guint8 *) src->data + start, end - start, MADV_WILLNEED);
+  src->readahead_end = end;
+#endif
+}
+
+static GstFlowReturn
+gst_mmap_file_src_create (GstBaseSrc * basesrc, guint64 offset,
+    guint length, GstBuffer ** buffer)
+{
+  GstMmapFileSrc *src = GST_MMAP_FILE_SRC (basesrc);
+  GstBuffer *buf;
+
+  if (offset >= src->size)
+    return GST_FLOW_EOS;
+
+  length = MIN (length, src->size - offset);
+
+  gst_mmap_file_src_readahead (src, offset + length);
+
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, gst_memory_share (src->mem, offset, length));
+  GST_BUFFER_OFFSET (buf) = offset;
+  GST_BUFFER_OFFSET_END (buf) = offset + length;
+
+  *buffer = buf;
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_mmap_file_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstMmapFileSrc *src = GST_MMAP_FILE_SRC (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      g_free (src->location);
+      src->location = g_value_dup_string (value);
+      break;
+    case PROP_READAHEAD:
+      src->readahead = g_value_get_uint64 (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_mmap_file_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstMmapFileSrc *src = GST_MMAP_FILE_SRC (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      g_value_set_string (value, src->location);
+      break;
+    case PROP_READAHEAD:
+      g_value_set_uint64 (value, src->readahead);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
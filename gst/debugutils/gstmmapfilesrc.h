@@ -0,0 +1,71 @@
+/* GStreamer mmap File Source
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_MMAP_FILE_SRC_H__
+#define __GST_MMAP_FILE_SRC_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasesrc.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_MMAP_FILE_SRC \
+  (gst_mmap_file_src_get_type())
+#define GST_MMAP_FILE_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_MMAP_FILE_SRC,GstMmapFileSrc))
+#define GST_MMAP_FILE_SRC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_MMAP_FILE_SRC,GstMmapFileSrcClass))
+#define GST_IS_MMAP_FILE_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_MMAP_FILE_SRC))
+#define GST_IS_MMAP_FILE_SRC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_MMAP_FILE_SRC))
+typedef struct _GstMmapFileSrc GstMmapFileSrc;
+typedef struct _GstMmapFileSrcClass GstMmapFileSrcClass;
+
+/**
+ * GstMmapFileSrc:
+ *
+ * Opaque #GstMmapFileSrc data structure
+ */
+struct _GstMmapFileSrc
+{
+  GstBaseSrc basesrc;
+
+  /*< private > */
+  /* properties */
+  gchar *location;
+  guint64 readahead;
+
+  /* the whole file, buffers share parts of it */
+  GstMemory *mem;
+  guint8 *data;
+  guint64 size;
+
+  /* end of the range that was last advised to be read ahead */
+  guint64 readahead_end;
+};
+
+struct _GstMmapFileSrcClass
+{
+  GstBaseSrcClass parent_class;
+};
+
+GType gst_mmap_file_src_get_type (void);
+
+G_END_DECLS
+#endif /* __GST_MMAP_FILE_SRC_H__ */
@@ -35,6 +35,11 @@
  * ]| This plays back the given file using playbin, with the demuxer operating
  * push-based.
  * </refsect2>
+ *
+ * With #GstPushFileSrc:use-mmap the file is read by mmapfilesrc instead of
+ * filesrc. The buffers then share a memory mapping of the file instead of
+ * being copied into, so push-mode benchmarks of demuxers measure the
+ * parsing and not the reading.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -48,6 +53,14 @@
 GST_DEBUG_CATEGORY_STATIC (pushfilesrc_debug);
 #define GST_CAT_DEFAULT pushfilesrc_debug
 
+#define DEFAULT_USE_MMAP FALSE
+
+enum
+{
+  PROP_0,
+  PROP_USE_MMAP
+};
+
 static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
@@ -55,6 +68,10 @@ static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
 
 static void gst_push_file_src_uri_handler_init (gpointer g_iface,
     gpointer iface_data);
+static void gst_push_file_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_push_file_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 #define gst_push_file_src_parent_class parent_class
 G_DEFINE_TYPE_WITH_CODE (GstPushFileSrc, gst_push_file_src, GST_TYPE_BIN,
@@ -91,6 +108,24 @@ gst_push_file_src_class_init (GstPushFileSrcClass * g_class)
       "pushfilesrc element");
 
   gobject_class->dispose = gst_push_file_src_dispose;
+  gobject_class->set_property = gst_push_file_src_set_property;
+  gobject_class->get_property = gst_push_file_src_get_property;
+
+#ifdef HAVE_MMAP
+  /**
+   * GstPushFileSrc:use-mmap:
+   *
+   * Read the file with mmapfilesrc, which hands out parts of a memory
+   * mapping of the file instead of copying it.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_USE_MMAP,
+      g_param_spec_boolean ("use-mmap", "Use mmap",
+          "Map the file into memory instead of reading it",
+          DEFAULT_USE_MMAP, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+#endif
 
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&srctemplate));
@@ -140,6 +175,77 @@ gst_push_file_src_init (GstPushFileSrc * src)
   }
 }
 
+#ifdef HAVE_MMAP
+static void
+gst_push_file_src_set_use_mmap (GstPushFileSrc * src, gboolean use_mmap)
+{
+  GstElement *filesrc;
+  GstPad *pad;
+  gchar *location = NULL;
+
+  if (src->use_mmap == use_mmap || src->filesrc == NULL)
+    return;
+
+  filesrc = gst_element_factory_make (use_mmap ? "mmapfilesrc" : "filesrc",
+      NULL);
+  if (filesrc == NULL) {
+    GST_WARNING_OBJECT (src, "could not create %s",
+        use_mmap ? "mmapfilesrc" : "filesrc");
+    return;
+  }
+
+  GST_DEBUG_OBJECT (src, "switching to %s", GST_OBJECT_NAME (filesrc));
+
+  g_object_get (src->filesrc, "location", &location, NULL);
+  g_object_set (filesrc, "location", location, NULL);
+  g_free (location);
+
+  gst_bin_remove (GST_BIN (src), src->filesrc);
+  gst_object_set_name (GST_OBJECT (filesrc), "real-filesrc");
+  gst_bin_add (GST_BIN (src), filesrc);
+  src->filesrc = filesrc;
+
+  pad = gst_element_get_static_pad (filesrc, "src");
+  gst_ghost_pad_set_target (GST_GHOST_PAD (src->srcpad), pad);
+  gst_object_unref (pad);
+
+  src->use_mmap = use_mmap;
+}
+#endif
+
+static void
+gst_push_file_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  switch (prop_id) {
+#ifdef HAVE_MMAP
+    case PROP_USE_MMAP:
+      gst_push_file_src_set_use_mmap (GST_PUSH_FILE_SRC (object),
+          g_value_get_boolean (value));
+      break;
+#endif
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_push_file_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstPushFileSrc *src = GST_PUSH_FILE_SRC (object);
+
+  switch (prop_id) {
+    case PROP_USE_MMAP:
+      g_value_set_boolean (value, src->use_mmap);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 /*** GSTURIHANDLER INTERFACE *************************************************/
 
 static GstURIType
@@ -165,7 +271,18 @@ gst_push_file_src_uri_get_uri (GstURIHandler * handler)
   if (src->filesrc == NULL)
     return NULL;
 
-  fileuri = gst_uri_handler_get_uri (GST_URI_HANDLER (src->filesrc));;
+  /* mmapfilesrc has no URI handler */
+  if (src->use_mmap) {
+    gchar *location;
+
+    g_object_get (src->filesrc, "location", &location, NULL);
+    if (location == NULL)
+      return NULL;
+    fileuri = gst_filename_to_uri (location, NULL);
+    g_free (location);
+  } else {
+    fileuri = gst_uri_handler_get_uri (GST_URI_HANDLER (src->filesrc));
+  }
   if (fileuri == NULL)
     return NULL;
   pushfileuri = g_strconcat ("push", fileuri, NULL);
@@ -186,6 +303,19 @@ gst_push_file_src_uri_set_uri (GstURIHandler * handler, const gchar * uri,
     return FALSE;
   }
 
+  if (src->use_mmap) {
+    gchar *location;
+
+    /* skip 'push' bit */
+    location = g_filename_from_uri (uri + 4, NULL, error);
+    if (location == NULL)
+      return FALSE;
+    g_object_set (src->filesrc, "location", location, NULL);
+    g_free (location);
+
+    return TRUE;
+  }
+
   /* skip 'push' bit */
   return gst_uri_handler_set_uri (GST_URI_HANDLER (src->filesrc), uri + 4,
       error);
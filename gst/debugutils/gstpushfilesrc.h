@@ -43,6 +43,8 @@ struct _GstPushFileSrc
   /*< private > */
   GstElement *filesrc;
   GstPad *srcpad;
+
+  gboolean use_mmap;
 };
 
 struct _GstPushFileSrcClass
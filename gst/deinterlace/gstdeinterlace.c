@@ -65,6 +65,8 @@ GST_DEBUG_CATEGORY_STATIC (deinterlace_debug);
 #define DEFAULT_LOCKING         GST_DEINTERLACE_LOCKING_NONE
 #define DEFAULT_IGNORE_OBSCURE  TRUE
 #define DEFAULT_DROP_ORPHANS    TRUE
+#define DEFAULT_N_THREADS       1
+#define DEFAULT_CONTENT_ANALYSIS FALSE
 
 enum
 {
@@ -76,6 +78,8 @@ enum
   PROP_LOCKING,
   PROP_IGNORE_OBSCURE,
   PROP_DROP_ORPHANS,
+  PROP_N_THREADS,
+  PROP_CONTENT_ANALYSIS,
   PROP_LAST
 };
 
@@ -330,6 +334,13 @@ static void gst_deinterlace_read_qos (GstDeinterlace * self,
 
 #define IS_TELECINE(m) ((m) == GST_VIDEO_INTERLACE_MODE_MIXED && self->pattern > 1)
 
+/* interleaved input is classified from its content */
+#define GST_DEINTERLACE_ANALYSE_CONTENT(self) ((self)->content_analysis \
+    && (self)->locking != GST_DEINTERLACE_LOCKING_NONE \
+    && (self)->mode == GST_DEINTERLACE_MODE_AUTO \
+    && GST_VIDEO_INFO_INTERLACE_MODE (&(self)->vinfo) != \
+    GST_VIDEO_INTERLACE_MODE_PROGRESSIVE)
+
 /* FIXME: what's the point of the childproxy interface here? What can you
  * actually do with it? The method objects seem to have no properties */
 #if 0
@@ -428,6 +439,7 @@ gst_deinterlace_set_method (GstDeinterlace * self, GstDeinterlaceMethods method)
 
   self->method = g_object_new (method_type, "name", "method", NULL);
   self->method_id = method;
+  gst_deinterlace_method_set_n_threads (self->method, self->n_threads);
 
   gst_object_set_parent (GST_OBJECT (self->method), GST_OBJECT (self));
 #if 0
@@ -664,6 +676,40 @@ gst_deinterlace_class_init (GstDeinterlaceClass * klass)
           "active locking mode.", DEFAULT_DROP_ORPHANS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstDeinterlace:n-threads:
+   *
+   * Number of threads used to deinterlace a frame. The lines of the frame
+   * are split into bands that are processed in parallel by the greedyh
+   * method and the scanline based methods. 0 uses one thread per processor.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Maximum number of threads used to deinterlace a frame "
+          "(0 = number of processors)", 0, G_MAXUINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDeinterlace:content-analysis:
+   *
+   * Detect progressive, interlaced and telecined frames from the content
+   * instead of the buffer flags, for streams that are not flagged properly.
+   * Each frame is checked for combing and its fields are compared to those
+   * of the previous frame, on a subset of the lines. With that, pattern
+   * locking can lock onto 3:2 pulldown on its own, without fieldanalysis in
+   * front. Only used when #GstDeinterlace:locking is not none, and works
+   * best with the automatic #GstDeinterlace:field-layout.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_CONTENT_ANALYSIS,
+      g_param_spec_boolean ("content-analysis", "Content analysis",
+          "Detect the frame types from the content for pattern locking",
+          DEFAULT_CONTENT_ANALYSIS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   element_class->change_state =
       GST_DEBUG_FUNCPTR (gst_deinterlace_change_state);
 }
@@ -720,6 +766,7 @@ gst_deinterlace_init (GstDeinterlace * self)
 
   self->mode = DEFAULT_MODE;
   self->user_set_method_id = DEFAULT_METHOD;
+  self->n_threads = DEFAULT_N_THREADS;
   gst_video_info_init (&self->vinfo);
   gst_deinterlace_set_method (self, self->user_set_method_id);
   self->fields = DEFAULT_FIELDS;
@@ -727,6 +774,7 @@ gst_deinterlace_init (GstDeinterlace * self)
   self->locking = DEFAULT_LOCKING;
   self->ignore_obscure = DEFAULT_IGNORE_OBSCURE;
   self->drop_orphans = DEFAULT_DROP_ORPHANS;
+  self->content_analysis = DEFAULT_CONTENT_ANALYSIS;
 
   self->low_latency = -1;
   self->pattern = -1;
@@ -740,20 +788,45 @@ gst_deinterlace_init (GstDeinterlace * self)
   gst_deinterlace_reset (self);
 }
 
+/* Both fields of a buffer share one mapping in the field history, the frame
+ * is unmapped when the last field referencing it is dropped */
+typedef struct
+{
+  GstVideoFrame frame;
+  gint refcount;
+} GstDeinterlaceSharedFrame;
+
 static GstVideoFrame *
 gst_video_frame_new_and_map (GstVideoInfo * vinfo, GstBuffer * buffer,
     GstMapFlags flags)
 {
-  GstVideoFrame *frame = g_malloc0 (sizeof (GstVideoFrame));
-  gst_video_frame_map (frame, vinfo, buffer, flags);
+  GstDeinterlaceSharedFrame *shared = g_slice_new0 (GstDeinterlaceSharedFrame);
+
+  gst_video_frame_map (&shared->frame, vinfo, buffer, flags);
+  shared->refcount = 1;
+
+  return &shared->frame;
+}
+
+static GstVideoFrame *
+gst_deinterlace_frame_ref (GstVideoFrame * frame)
+{
+  GstDeinterlaceSharedFrame *shared = (GstDeinterlaceSharedFrame *) frame;
+
+  g_atomic_int_inc (&shared->refcount);
+
   return frame;
 }
 
 static void
-gst_video_frame_unmap_and_free (GstVideoFrame * frame)
+gst_deinterlace_frame_unref (GstVideoFrame * frame)
 {
-  gst_video_frame_unmap (frame);
-  g_free (frame);
+  GstDeinterlaceSharedFrame *shared = (GstDeinterlaceSharedFrame *) frame;
+
+  if (g_atomic_int_dec_and_test (&shared->refcount)) {
+    gst_video_frame_unmap (&shared->frame);
+    g_slice_free (GstDeinterlaceSharedFrame, shared);
+  }
 }
 
 static void
@@ -777,7 +850,7 @@ gst_deinterlace_reset_history (GstDeinterlace * self, gboolean drop_all)
 
     for (i = 0; i < self->history_count; i++) {
       if (self->field_history[i].frame) {
-        gst_video_frame_unmap_and_free (self->field_history[i].frame);
+        gst_deinterlace_frame_unref (self->field_history[i].frame);
         self->field_history[i].frame = NULL;
       }
     }
@@ -792,6 +865,7 @@ gst_deinterlace_reset_history (GstDeinterlace * self, gboolean drop_all)
   self->pattern_lock = FALSE;
   self->pattern_refresh = TRUE;
   self->cur_field_idx = -1;
+  self->analysis_pending = 0;
 
   if (!self->still_frame_mode && self->last_buffer) {
     gst_buffer_unref (self->last_buffer);
@@ -902,6 +976,14 @@ gst_deinterlace_set_property (GObject * object, guint prop_id,
     case PROP_DROP_ORPHANS:
       self->drop_orphans = g_value_get_boolean (value);
       break;
+    case PROP_N_THREADS:
+      self->n_threads = g_value_get_uint (value);
+      if (self->method)
+        gst_deinterlace_method_set_n_threads (self->method, self->n_threads);
+      break;
+    case PROP_CONTENT_ANALYSIS:
+      self->content_analysis = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
   }
@@ -938,6 +1020,12 @@ gst_deinterlace_get_property (GObject * object, guint prop_id,
     case PROP_DROP_ORPHANS:
       g_value_set_boolean (value, self->drop_orphans);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, self->n_threads);
+      break;
+    case PROP_CONTENT_ANALYSIS:
+      g_value_set_boolean (value, self->content_analysis);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
   }
@@ -1039,6 +1127,10 @@ gst_deinterlace_get_buffer_state (GstDeinterlace * self, GstVideoFrame * frame,
     return;
 
   interlacing_mode = GST_VIDEO_INFO_INTERLACE_MODE (&frame->info);
+  /* the flags set by the content analysis are only used for mixed content */
+  if (GST_DEINTERLACE_ANALYSE_CONTENT (self)
+      && interlacing_mode == GST_VIDEO_INTERLACE_MODE_INTERLEAVED)
+    interlacing_mode = GST_VIDEO_INTERLACE_MODE_MIXED;
   if (self->mode == GST_DEINTERLACE_MODE_INTERLACED)
     interlacing_mode = GST_VIDEO_INTERLACE_MODE_INTERLEAVED;
 
@@ -1151,7 +1243,7 @@ gst_deinterlace_push_history (GstDeinterlace * self, GstBuffer * buffer)
   }
 
   field1 = frame;
-  field2 = gst_video_frame_new_and_map (&self->vinfo, buffer, GST_MAP_READ);
+  field2 = gst_deinterlace_frame_ref (frame);
   if (field_layout == GST_DEINTERLACE_LAYOUT_TFF) {
     GST_DEBUG_OBJECT (self, "Top field first");
     field1_flags = PICTURE_INTERLACED_TOP;
@@ -1173,7 +1265,7 @@ gst_deinterlace_push_history (GstDeinterlace * self, GstBuffer * buffer)
     GST_DEBUG_OBJECT (self, "One field");
     self->field_history[0].frame = field1;
     self->field_history[0].flags = field1_flags;
-    gst_video_frame_unmap_and_free (field2);
+    gst_deinterlace_frame_unref (field2);
   }
 
   self->history_count += fields_to_push;
@@ -1565,7 +1657,7 @@ restart:
       if (flush_one && self->drop_orphans) {
         GST_DEBUG_OBJECT (self, "Dropping orphan first field");
         self->cur_field_idx--;
-        gst_video_frame_unmap_and_free (gst_deinterlace_pop_history (self));
+        gst_deinterlace_frame_unref (gst_deinterlace_pop_history (self));
         goto restart;
       }
     }
@@ -1629,11 +1721,11 @@ restart:
     field1_frame = gst_deinterlace_pop_history (self);
     field1_buffer = field1_frame->buffer;
     gst_buffer_ref (field1_buffer);
-    gst_video_frame_unmap_and_free (field1_frame);
+    gst_deinterlace_frame_unref (field1_frame);
     /* field2 is the same buffer as field1, but we need to remove it from the
      * history anyway */
     self->cur_field_idx--;
-    gst_video_frame_unmap_and_free (gst_deinterlace_pop_history (self));
+    gst_deinterlace_frame_unref (gst_deinterlace_pop_history (self));
     GST_DEBUG_OBJECT (self,
         "[OUT] ts %" GST_TIME_FORMAT ", dur %" GST_TIME_FORMAT ", end %"
         GST_TIME_FORMAT,
@@ -1760,14 +1852,14 @@ restart:
     /* Check if we need to drop the frame because of QoS */
     if (!gst_deinterlace_do_qos (self, buf)) {
       self->cur_field_idx--;
-      gst_video_frame_unmap_and_free (gst_deinterlace_pop_history (self));
+      gst_deinterlace_frame_unref (gst_deinterlace_pop_history (self));
       gst_buffer_unref (outbuf);
       outbuf = NULL;
       ret = GST_FLOW_OK;
     } else {
       if (self->cur_field_idx < 0 && flushing) {
         if (self->history_count == 1) {
-          gst_video_frame_unmap_and_free (gst_deinterlace_pop_history (self));
+          gst_deinterlace_frame_unref (gst_deinterlace_pop_history (self));
           goto need_more;
         }
         self->cur_field_idx++;
@@ -1789,7 +1881,7 @@ restart:
           self->field_history, self->history_count, outframe,
           self->cur_field_idx);
 
-      gst_video_frame_unmap_and_free (outframe);
+      gst_deinterlace_frame_unref (outframe);
 
       self->cur_field_idx--;
       /* need to remove the field in the telecine weaving case */
@@ -1798,7 +1890,7 @@ restart:
           || self->cur_field_idx + 1 +
           gst_deinterlace_method_get_latency (self->method) <
           self->history_count || flushing) {
-        gst_video_frame_unmap_and_free (gst_deinterlace_pop_history (self));
+        gst_deinterlace_frame_unref (gst_deinterlace_pop_history (self));
       }
 
       if (gst_deinterlace_clip_buffer (self, outbuf)) {
@@ -1823,7 +1915,7 @@ restart:
         GST_DEBUG_OBJECT (self, "Removing unused field (count: %d)",
             self->history_count);
         self->cur_field_idx--;
-        gst_video_frame_unmap_and_free (gst_deinterlace_pop_history (self));
+        gst_deinterlace_frame_unref (gst_deinterlace_pop_history (self));
         interlacing_mode = GST_VIDEO_INTERLACE_MODE_INTERLEAVED;
         return ret;
       }
@@ -1840,7 +1932,7 @@ restart:
           && !IS_TELECINE (interlacing_mode))) {
     GST_DEBUG_OBJECT (self, "Removing unused top field");
     self->cur_field_idx--;
-    gst_video_frame_unmap_and_free (gst_deinterlace_pop_history (self));
+    gst_deinterlace_frame_unref (gst_deinterlace_pop_history (self));
 
     if (flush_one && !self->drop_orphans) {
       GST_DEBUG_OBJECT (self, "Orphan field deinterlaced - reconfiguring");
@@ -1899,7 +1991,7 @@ restart:
     /* Check if we need to drop the frame because of QoS */
     if (!gst_deinterlace_do_qos (self, buf)) {
       self->cur_field_idx--;
-      gst_video_frame_unmap_and_free (gst_deinterlace_pop_history (self));
+      gst_deinterlace_frame_unref (gst_deinterlace_pop_history (self));
       gst_buffer_unref (outbuf);
       outbuf = NULL;
       ret = GST_FLOW_OK;
@@ -1914,7 +2006,7 @@ restart:
           self->field_history, self->history_count, outframe,
           self->cur_field_idx);
 
-      gst_video_frame_unmap_and_free (outframe);
+      gst_deinterlace_frame_unref (outframe);
 
       self->cur_field_idx--;
       /* need to remove the field in the telecine weaving case */
@@ -1923,7 +2015,7 @@ restart:
           || self->cur_field_idx + 1 +
           gst_deinterlace_method_get_latency (self->method) <
           self->history_count) {
-        gst_video_frame_unmap_and_free (gst_deinterlace_pop_history (self));
+        gst_deinterlace_frame_unref (gst_deinterlace_pop_history (self));
       }
 
       if (gst_deinterlace_clip_buffer (self, outbuf)) {
@@ -1948,7 +2040,7 @@ restart:
         GST_DEBUG_OBJECT (self, "Removing unused field (count: %d)",
             self->history_count);
         self->cur_field_idx--;
-        gst_video_frame_unmap_and_free (gst_deinterlace_pop_history (self));
+        gst_deinterlace_frame_unref (gst_deinterlace_pop_history (self));
         interlacing_mode = GST_VIDEO_INTERLACE_MODE_INTERLEAVED;
         return ret;
       }
@@ -1965,7 +2057,7 @@ restart:
           && !IS_TELECINE (interlacing_mode))) {
     GST_DEBUG_OBJECT (self, "Removing unused bottom field");
     self->cur_field_idx--;
-    gst_video_frame_unmap_and_free (gst_deinterlace_pop_history (self));
+    gst_deinterlace_frame_unref (gst_deinterlace_pop_history (self));
 
     if (flush_one && !self->drop_orphans) {
       GST_DEBUG_OBJECT (self, "Orphan field deinterlaced - reconfiguring");
@@ -2017,6 +2109,242 @@ gst_deinterlace_get_latency (GstDeinterlace * self)
   }
 }
 
+/* Content analysis for pattern locking on badly flagged streams.
+ *
+ * Only every ANALYSIS_LINE_STEP-th line of the first plane is looked at,
+ * all bytes of the line are used whatever the format is: for packed YUV
+ * the chroma bytes comb just as well. A buffer is combed when a band of
+ * lines stands out against the lines of the other field, and a field is a
+ * repeat of the same field of the previous buffer when it hardly differs
+ * from it while the other field does. */
+#define ANALYSIS_LINE_STEP 4
+/* sampled lines per band the comb metric is averaged over */
+#define ANALYSIS_BAND_LINES 4
+/* per byte differences below this are noise */
+#define COMB_NOISE 8
+/* average comb excess per byte over a band for a buffer to be combed */
+#define COMB_THRESHOLD 1.0
+/* average difference per byte up to which a field can be a repeat */
+#define REPEAT_THRESHOLD 2.0
+
+#if defined (__SSE2__)
+#define HAVE_ANALYSIS_SSE2 1
+#include <emmintrin.h>
+#elif defined (__ARM_NEON__) || defined (__ARM_NEON)
+#define HAVE_ANALYSIS_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* sum over @width bytes of how far each byte of @cur lies beyond both its
+ * neighbours from the other field, in the same direction, minus noise */
+static guint64
+gst_deinterlace_comb_line (const guint8 * above, const guint8 * cur,
+    const guint8 * below, gint width)
+{
+  guint64 sum = 0;
+  gint x = 0;
+
+#if defined (HAVE_ANALYSIS_SSE2)
+  {
+    const __m128i noise = _mm_set1_epi8 (COMB_NOISE);
+    __m128i acc = _mm_setzero_si128 ();
+
+    for (; x + 16 <= width; x += 16) {
+      __m128i a = _mm_loadu_si128 ((const __m128i *) (above + x));
+      __m128i c = _mm_loadu_si128 ((const __m128i *) (cur + x));
+      __m128i b = _mm_loadu_si128 ((const __m128i *) (below + x));
+      __m128i up, down, v;
+
+      up = _mm_min_epu8 (_mm_subs_epu8 (c, a), _mm_subs_epu8 (c, b));
+      down = _mm_min_epu8 (_mm_subs_epu8 (a, c), _mm_subs_epu8 (b, c));
+      v = _mm_subs_epu8 (_mm_or_si128 (up, down), noise);
+      acc = _mm_add_epi64 (acc, _mm_sad_epu8 (v, _mm_setzero_si128 ()));
+    }
+    sum = (guint64) _mm_cvtsi128_si32 (acc) +
+        (guint64) _mm_cvtsi128_si32 (_mm_srli_si128 (acc, 8));
+  }
+#elif defined (HAVE_ANALYSIS_NEON)
+  {
+    const uint8x16_t noise = vdupq_n_u8 (COMB_NOISE);
+    uint32x4_t acc = vdupq_n_u32 (0);
+
+    for (; x + 16 <= width; x += 16) {
+      uint8x16_t a = vld1q_u8 (above + x);
+      uint8x16_t c = vld1q_u8 (cur + x);
+      uint8x16_t b = vld1q_u8 (below + x);
+      uint8x16_t up, down, v;
+
+      up = vminq_u8 (vqsubq_u8 (c, a), vqsubq_u8 (c, b));
+      down = vminq_u8 (vqsubq_u8 (a, c), vqsubq_u8 (b, c));
+      v = vqsubq_u8 (vorrq_u8 (up, down), noise);
+      acc = vpadalq_u16 (acc, vpaddlq_u8 (v));
+    }
+    sum = (guint64) vgetq_lane_u32 (acc, 0) + vgetq_lane_u32 (acc, 1) +
+        vgetq_lane_u32 (acc, 2) + vgetq_lane_u32 (acc, 3);
+  }
+#endif
+
+  for (; x < width; x++) {
+    gint c = cur[x], a = above[x], b = below[x];
+    gint v = 0;
+
+    if (c > a && c > b)
+      v = MIN (c - a, c - b);
+    else if (c < a && c < b)
+      v = MIN (a - c, b - c);
+    if (v > COMB_NOISE)
+      sum += v - COMB_NOISE;
+  }
+
+  return sum;
+}
+
+/* sum of absolute differences of @width bytes */
+static guint64
+gst_deinterlace_diff_line (const guint8 * a, const guint8 * b, gint width)
+{
+  guint64 sum = 0;
+  gint x = 0;
+
+#if defined (HAVE_ANALYSIS_SSE2)
+  {
+    __m128i acc = _mm_setzero_si128 ();
+
+    for (; x + 16 <= width; x += 16) {
+      __m128i va = _mm_loadu_si128 ((const __m128i *) (a + x));
+      __m128i vb = _mm_loadu_si128 ((const __m128i *) (b + x));
+
+      acc = _mm_add_epi64 (acc, _mm_sad_epu8 (va, vb));
+    }
+    sum = (guint64) _mm_cvtsi128_si32 (acc) +
+        (guint64) _mm_cvtsi128_si32 (_mm_srli_si128 (acc, 8));
+  }
+#elif defined (HAVE_ANALYSIS_NEON)
+  {
+    uint32x4_t acc = vdupq_n_u32 (0);
+
+    for (; x + 16 <= width; x += 16) {
+      uint8x16_t d = vabdq_u8 (vld1q_u8 (a + x), vld1q_u8 (b + x));
+
+      acc = vpadalq_u16 (acc, vpaddlq_u8 (d));
+    }
+    sum = (guint64) vgetq_lane_u32 (acc, 0) + vgetq_lane_u32 (acc, 1) +
+        vgetq_lane_u32 (acc, 2) + vgetq_lane_u32 (acc, 3);
+  }
+#endif
+
+  for (; x < width; x++)
+    sum += ABS ((gint) a[x] - (gint) b[x]);
+
+  return sum;
+}
+
+/* Classify @buf from its content and set the video flags on it the way
+ * fieldanalysis would, so that the pattern locking can work with them.
+ * Two combed buffers of a 3:2 pulldown sequence become buffers with a
+ * single field each that are woven together later, the repeated fields
+ * are dropped that way. Returns the possibly new buffer. */
+static GstBuffer *
+gst_deinterlace_analyse_content (GstDeinterlace * self, GstBuffer * buf)
+{
+  GstVideoFrame cur, prev;
+  gboolean have_prev = FALSE, combed;
+  guint64 band = 0, band_max = 0, diff[2] = { 0, 0 };
+  gint y, width, height, stride, n_lines = 0, n_band = 0, n_diff = 0;
+  gdouble comb, same[2];
+  gint keep = 0;
+
+  if (!gst_video_frame_map (&cur, &self->vinfo, buf, GST_MAP_READ))
+    return buf;
+
+  if (self->last_buffer)
+    have_prev = gst_video_frame_map (&prev, &self->vinfo, self->last_buffer,
+        GST_MAP_READ);
+
+  width = GST_VIDEO_FRAME_COMP_WIDTH (&cur, 0) *
+      GST_VIDEO_FRAME_COMP_PSTRIDE (&cur, 0);
+  height = GST_VIDEO_FRAME_COMP_HEIGHT (&cur, 0);
+  stride = GST_VIDEO_FRAME_PLANE_STRIDE (&cur, 0);
+
+  /* y is a line of the top field, y + 1 of the bottom field */
+  for (y = 0; y + 2 < height; y += ANALYSIS_LINE_STEP) {
+    const guint8 *line = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (&cur,
+        0) + y * stride;
+
+    band += gst_deinterlace_comb_line (line, line + stride, line + 2 * stride,
+        width);
+    if (++n_band == ANALYSIS_BAND_LINES) {
+      band_max = MAX (band_max, band);
+      band = 0;
+      n_band = 0;
+    }
+    n_lines++;
+
+    if (have_prev) {
+      const guint8 *pline = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (&prev,
+          0) + y * GST_VIDEO_FRAME_PLANE_STRIDE (&prev, 0);
+
+      diff[0] += gst_deinterlace_diff_line (line, pline, width);
+      diff[1] += gst_deinterlace_diff_line (line + stride,
+          pline + GST_VIDEO_FRAME_PLANE_STRIDE (&prev, 0), width);
+      n_diff++;
+    }
+  }
+  if (n_band > 0)
+    band_max = MAX (band_max, band * ANALYSIS_BAND_LINES / n_band);
+
+  gst_video_frame_unmap (&cur);
+  if (have_prev)
+    gst_video_frame_unmap (&prev);
+
+  if (n_lines == 0 || width == 0)
+    return buf;
+
+  comb = (gdouble) band_max / (MIN (n_lines, ANALYSIS_BAND_LINES) * width);
+  combed = comb > COMB_THRESHOLD;
+  same[0] = n_diff ? (gdouble) diff[0] / (n_diff * width) : G_MAXDOUBLE;
+  same[1] = n_diff ? (gdouble) diff[1] / (n_diff * width) : G_MAXDOUBLE;
+
+  buf = gst_buffer_make_writable (buf);
+  GST_BUFFER_FLAG_UNSET (buf, GST_VIDEO_BUFFER_FLAG_RFF);
+  GST_BUFFER_FLAG_UNSET (buf, GST_VIDEO_BUFFER_FLAG_ONEFIELD);
+
+  if (!combed) {
+    GST_BUFFER_FLAG_UNSET (buf, GST_VIDEO_BUFFER_FLAG_INTERLACED);
+    self->analysis_pending = 0;
+  } else if (self->analysis_pending) {
+    /* the second half of a film frame split over two buffers */
+    keep = self->analysis_pending;
+    self->analysis_pending = 0;
+  } else if (same[0] < REPEAT_THRESHOLD && same[0] * 4 < same[1]) {
+    /* the top field repeats, the bottom field starts a new film frame */
+    keep = PICTURE_INTERLACED_BOTTOM;
+    self->analysis_pending = PICTURE_INTERLACED_TOP;
+  } else if (same[1] < REPEAT_THRESHOLD && same[1] * 4 < same[0]) {
+    keep = PICTURE_INTERLACED_TOP;
+    self->analysis_pending = PICTURE_INTERLACED_BOTTOM;
+  } else {
+    GST_BUFFER_FLAG_SET (buf, GST_VIDEO_BUFFER_FLAG_INTERLACED);
+  }
+
+  if (keep) {
+    GST_BUFFER_FLAG_SET (buf, GST_VIDEO_BUFFER_FLAG_INTERLACED);
+    GST_BUFFER_FLAG_SET (buf, GST_VIDEO_BUFFER_FLAG_ONEFIELD);
+    /* a single field buffer carries the top field when tff is set */
+    if (keep == PICTURE_INTERLACED_TOP)
+      GST_BUFFER_FLAG_SET (buf, GST_VIDEO_BUFFER_FLAG_TFF);
+    else
+      GST_BUFFER_FLAG_UNSET (buf, GST_VIDEO_BUFFER_FLAG_TFF);
+  }
+
+  GST_LOG_OBJECT (self, "comb %.2f, top diff %.2f, bottom diff %.2f: %s",
+      comb, same[0], same[1], !combed ? "progressive" :
+      keep == PICTURE_INTERLACED_TOP ? "top field" :
+      keep == PICTURE_INTERLACED_BOTTOM ? "bottom field" : "interlaced");
+
+  return buf;
+}
+
 static GstFlowReturn
 gst_deinterlace_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -2068,6 +2396,30 @@ gst_deinterlace_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
     gst_deinterlace_reset_history (self, FALSE);
   }
 
+  /* Progressive frames of mixed content would only be popped from the
+   * history again and pushed unchanged. Without pattern locking and with
+   * nothing queued, skip mapping them into the history. */
+  if (self->history_count == 0
+      && self->locking == GST_DEINTERLACE_LOCKING_NONE
+      && self->mode == GST_DEINTERLACE_MODE_AUTO
+      && GST_VIDEO_INFO_INTERLACE_MODE (&self->vinfo) ==
+      GST_VIDEO_INTERLACE_MODE_MIXED
+      && !GST_BUFFER_FLAG_IS_SET (buf, GST_VIDEO_BUFFER_FLAG_INTERLACED)
+      && !GST_BUFFER_FLAG_IS_SET (buf, GST_VIDEO_BUFFER_FLAG_RFF)
+      && !GST_BUFFER_FLAG_IS_SET (buf, GST_VIDEO_BUFFER_FLAG_ONEFIELD)) {
+    GST_DEBUG_OBJECT (self,
+        "Frame type: Progressive; pushing buffer using pass-through");
+
+    if (self->last_buffer)
+      gst_buffer_unref (self->last_buffer);
+    self->last_buffer = gst_buffer_ref (buf);
+
+    return gst_pad_push (self->srcpad, buf);
+  }
+
+  if (GST_DEINTERLACE_ANALYSE_CONTENT (self))
+    buf = gst_deinterlace_analyse_content (self, buf);
+
   gst_deinterlace_push_history (self, buf);
   buf = NULL;
 
@@ -176,6 +176,10 @@ struct _GstDeinterlace
   gint low_latency;
   gboolean drop_orphans;
   gboolean ignore_obscure;
+  guint n_threads;
+  gboolean content_analysis;
+  /* field the next combed buffer has to supply, or 0 */
+  gint analysis_pending;
   gboolean pattern_lock;
   gboolean pattern_refresh;
   GstDeinterlaceBufferState buf_states[GST_DEINTERLACE_MAX_BUFFER_STATE_HISTORY];
@@ -177,9 +177,26 @@ gst_deinterlace_method_setup_impl (GstDeinterlaceMethod * self,
   }
 }
 
+static void
+gst_deinterlace_method_finalize (GObject * object)
+{
+  GstDeinterlaceMethod *self = GST_DEINTERLACE_METHOD (object);
+
+  if (self->band_pool)
+    g_thread_pool_free (self->band_pool, FALSE, TRUE);
+  g_mutex_clear (&self->band_lock);
+  g_cond_clear (&self->band_cond);
+
+  G_OBJECT_CLASS (gst_deinterlace_method_parent_class)->finalize (object);
+}
+
 static void
 gst_deinterlace_method_class_init (GstDeinterlaceMethodClass * klass)
 {
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->finalize = gst_deinterlace_method_finalize;
+
   klass->setup = gst_deinterlace_method_setup_impl;
   klass->supported = gst_deinterlace_method_supported_impl;
 }
@@ -188,6 +205,9 @@ static void
 gst_deinterlace_method_init (GstDeinterlaceMethod * self)
 {
   self->vinfo = NULL;
+  self->n_threads = 1;
+  g_mutex_init (&self->band_lock);
+  g_cond_init (&self->band_cond);
 }
 
 void
@@ -216,6 +236,91 @@ gst_deinterlace_method_get_latency (GstDeinterlaceMethod * self)
   return klass->latency;
 }
 
+/* 0 uses one thread per processor */
+void
+gst_deinterlace_method_set_n_threads (GstDeinterlaceMethod * self,
+    guint n_threads)
+{
+  self->n_threads = n_threads;
+}
+
+typedef struct
+{
+  GstDeinterlaceMethodBandFunction func;
+  gpointer user_data;
+  gint start, end;
+} GstDeinterlaceMethodBand;
+
+static void
+gst_deinterlace_method_band_func (gpointer data, gpointer user_data)
+{
+  GstDeinterlaceMethodBand *band = data;
+  GstDeinterlaceMethod *self = user_data;
+
+  band->func (self, band->start, band->end, band->user_data);
+
+  g_mutex_lock (&self->band_lock);
+  if (--self->band_pending == 0)
+    g_cond_signal (&self->band_cond);
+  g_mutex_unlock (&self->band_lock);
+}
+
+/* Splits the lines [0, n_lines) into bands of at least min_band_lines lines
+ * each and calls func for every band, using up to n_threads threads. The
+ * calling thread processes the first band itself and this returns once all
+ * bands are done. Band boundaries are kept on even lines so that every band
+ * starts on a line of the same field. */
+void
+gst_deinterlace_method_process_bands (GstDeinterlaceMethod * self,
+    gint n_lines, gint min_band_lines, GstDeinterlaceMethodBandFunction func,
+    gpointer user_data)
+{
+  GstDeinterlaceMethodBand *bands;
+  guint n_threads, n_bands, i;
+  gint band_lines;
+
+  n_threads = self->n_threads;
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  n_bands = MIN (n_threads, n_lines / MAX (min_band_lines, 2));
+  if (n_bands > 1 && self->band_pool == NULL) {
+    self->band_pool = g_thread_pool_new (gst_deinterlace_method_band_func,
+        self, n_bands - 1, FALSE, NULL);
+    if (self->band_pool == NULL)
+      n_bands = 1;
+  } else if (n_bands > 1 &&
+      g_thread_pool_get_max_threads (self->band_pool) < n_bands - 1) {
+    g_thread_pool_set_max_threads (self->band_pool, n_bands - 1, NULL);
+  }
+
+  if (n_bands <= 1) {
+    func (self, 0, n_lines, user_data);
+    return;
+  }
+
+  band_lines = (n_lines / n_bands + 1) & ~1;
+  bands = g_newa (GstDeinterlaceMethodBand, n_bands);
+  for (i = 0; i < n_bands; i++) {
+    bands[i].func = func;
+    bands[i].user_data = user_data;
+    bands[i].start = MIN (i * band_lines, n_lines);
+    bands[i].end = (i == n_bands - 1) ? n_lines :
+        MIN ((i + 1) * band_lines, n_lines);
+  }
+
+  self->band_pending = n_bands - 1;
+  for (i = 1; i < n_bands; i++)
+    g_thread_pool_push (self->band_pool, &bands[i], NULL);
+
+  func (self, bands[0].start, bands[0].end, user_data);
+
+  g_mutex_lock (&self->band_lock);
+  while (self->band_pending > 0)
+    g_cond_wait (&self->band_cond, &self->band_lock);
+  g_mutex_unlock (&self->band_lock);
+}
+
 G_DEFINE_ABSTRACT_TYPE (GstDeinterlaceSimpleMethod,
     gst_deinterlace_simple_method, GST_TYPE_DEINTERLACE_METHOD);
 
@@ -304,56 +409,43 @@ gst_deinterlace_simple_method_copy_scanline_packed (GstDeinterlaceSimpleMethod *
   memcpy (out, scanlines->m0, stride);
 }
 
+/* Lines of a plane that are smaller than this are not split into bands */
+#define SIMPLE_METHOD_MIN_BAND_LINES 16
+
+typedef struct
+{
+  GstVideoFrame *dest;
+  const GstVideoFrame *frame0, *frame1, *frame2, *framep;
+  guint cur_field_flags;
+  gint plane;
+  gint frame_height, frame_width;
+  GstDeinterlaceSimpleMethodFunction copy_scanline;
+  GstDeinterlaceSimpleMethodFunction interpolate_scanline;
+} GstDeinterlaceSimpleMethodPlane;
+
 static void
-gst_deinterlace_simple_method_deinterlace_frame_packed (GstDeinterlaceMethod *
-    method, const GstDeinterlaceField * history, guint history_count,
-    GstVideoFrame * outframe, gint cur_field_idx)
+gst_deinterlace_simple_method_deinterlace_lines (GstDeinterlaceMethod * method,
+    gint start, gint end, gpointer user_data)
 {
   GstDeinterlaceSimpleMethod *self = GST_DEINTERLACE_SIMPLE_METHOD (method);
-  GstDeinterlaceMethodClass *dm_class = GST_DEINTERLACE_METHOD_GET_CLASS (self);
+  GstDeinterlaceSimpleMethodPlane *p = user_data;
   GstDeinterlaceScanlineData scanlines;
-  guint cur_field_flags;
+  GstVideoFrame *dest = p->dest;
+  const GstVideoFrame *frame0 = p->frame0, *frame1 = p->frame1;
+  const GstVideoFrame *frame2 = p->frame2, *framep = p->framep;
+  gint plane = p->plane;
+  gint frame_height = p->frame_height, frame_width = p->frame_width;
   gint i;
-  gint frame_height, frame_width;
-  GstVideoFrame *framep, *frame0, *frame1, *frame2;
-
-  g_assert (self->interpolate_scanline_packed != NULL);
-  g_assert (self->copy_scanline_packed != NULL);
-
-  frame_height = GST_VIDEO_FRAME_HEIGHT (outframe);
-  frame_width = GST_VIDEO_FRAME_PLANE_STRIDE (outframe, 0);
-
-  frame0 = history[cur_field_idx].frame;
-  frame_width = MIN (frame_width, GST_VIDEO_FRAME_PLANE_STRIDE (frame0, 0));
-  cur_field_flags = history[cur_field_idx].flags;
-
-  framep = (cur_field_idx > 0 ? history[cur_field_idx - 1].frame : NULL);
-  if (framep)
-    frame_width = MIN (frame_width, GST_VIDEO_FRAME_PLANE_STRIDE (framep, 0));
-
-  g_assert (dm_class->fields_required <= 4);
-
-  frame1 =
-      (cur_field_idx + 1 <
-      history_count ? history[cur_field_idx + 1].frame : NULL);
-  if (frame1)
-    frame_width = MIN (frame_width, GST_VIDEO_FRAME_PLANE_STRIDE (frame1, 0));
-
-  frame2 =
-      (cur_field_idx + 2 <
-      history_count ? history[cur_field_idx + 2].frame : NULL);
-  if (frame2)
-    frame_width = MIN (frame_width, GST_VIDEO_FRAME_PLANE_STRIDE (frame2, 0));
 
 #define CLAMP_LOW(i) (((i)<0) ? (i+2) : (i))
 #define CLAMP_HI(i) (((i)>=(frame_height)) ? (i-2) : (i))
-#define LINE(x,i) (((guint8*)GST_VIDEO_FRAME_PLANE_DATA((x),0)) + CLAMP_HI(CLAMP_LOW(i)) * \
-    GST_VIDEO_FRAME_PLANE_STRIDE((x),0))
+#define LINE(x,i) (((guint8*)GST_VIDEO_FRAME_PLANE_DATA((x),plane)) + CLAMP_HI(CLAMP_LOW(i)) * \
+    GST_VIDEO_FRAME_PLANE_STRIDE((x),plane))
 #define LINE2(x,i) ((x) ? LINE(x,i) : NULL)
 
-  for (i = 0; i < frame_height; i++) {
+  for (i = start; i < end; i++) {
     memset (&scanlines, 0, sizeof (scanlines));
-    scanlines.bottom_field = (cur_field_flags == PICTURE_INTERLACED_BOTTOM);
+    scanlines.bottom_field = (p->cur_field_flags == PICTURE_INTERLACED_BOTTOM);
 
     if (!((i & 1) ^ scanlines.bottom_field)) {
       /* copying */
@@ -371,8 +463,7 @@ gst_deinterlace_simple_method_deinterlace_frame_packed (GstDeinterlaceMethod *
       scanlines.m2 = LINE2 (frame2, i);
       scanlines.bb2 = LINE2 (frame2, (i + 2 < frame_height ? i + 2 : i));
 
-      self->copy_scanline_packed (self, LINE (outframe, i), &scanlines,
-          frame_width);
+      p->copy_scanline (self, LINE (dest, i), &scanlines, frame_width);
     } else {
       /* interpolating */
       scanlines.ttp = LINE2 (framep, (i - 2 >= 0) ? i - 2 : i);
@@ -389,12 +480,67 @@ gst_deinterlace_simple_method_deinterlace_frame_packed (GstDeinterlaceMethod *
       scanlines.t2 = LINE2 (frame2, i - 1);
       scanlines.b2 = LINE2 (frame2, i + 1);
 
-      self->interpolate_scanline_packed (self, LINE (outframe, i), &scanlines,
-          frame_width);
+      p->interpolate_scanline (self, LINE (dest, i), &scanlines, frame_width);
     }
+  }
 #undef LINE
 #undef LINE2
-  }
+#undef CLAMP_HI
+#undef CLAMP_LOW
+}
+
+static void
+gst_deinterlace_simple_method_deinterlace_frame_packed (GstDeinterlaceMethod *
+    method, const GstDeinterlaceField * history, guint history_count,
+    GstVideoFrame * outframe, gint cur_field_idx)
+{
+  GstDeinterlaceSimpleMethod *self = GST_DEINTERLACE_SIMPLE_METHOD (method);
+  GstDeinterlaceMethodClass *dm_class = GST_DEINTERLACE_METHOD_GET_CLASS (self);
+  GstDeinterlaceSimpleMethodPlane p;
+  gint frame_width;
+  GstVideoFrame *framep, *frame0, *frame1, *frame2;
+
+  g_assert (self->interpolate_scanline_packed != NULL);
+  g_assert (self->copy_scanline_packed != NULL);
+
+  frame_width = GST_VIDEO_FRAME_PLANE_STRIDE (outframe, 0);
+
+  frame0 = history[cur_field_idx].frame;
+  frame_width = MIN (frame_width, GST_VIDEO_FRAME_PLANE_STRIDE (frame0, 0));
+
+  framep = (cur_field_idx > 0 ? history[cur_field_idx - 1].frame : NULL);
+  if (framep)
+    frame_width = MIN (frame_width, GST_VIDEO_FRAME_PLANE_STRIDE (framep, 0));
+
+  g_assert (dm_class->fields_required <= 4);
+
+  frame1 =
+      (cur_field_idx + 1 <
+      history_count ? history[cur_field_idx + 1].frame : NULL);
+  if (frame1)
+    frame_width = MIN (frame_width, GST_VIDEO_FRAME_PLANE_STRIDE (frame1, 0));
+
+  frame2 =
+      (cur_field_idx + 2 <
+      history_count ? history[cur_field_idx + 2].frame : NULL);
+  if (frame2)
+    frame_width = MIN (frame_width, GST_VIDEO_FRAME_PLANE_STRIDE (frame2, 0));
+
+  p.dest = outframe;
+  p.frame0 = frame0;
+  p.frame1 = frame1;
+  p.frame2 = frame2;
+  p.framep = framep;
+  p.cur_field_flags = history[cur_field_idx].flags;
+  p.plane = 0;
+  p.frame_height = GST_VIDEO_FRAME_HEIGHT (outframe);
+  p.frame_width = frame_width;
+  p.copy_scanline = self->copy_scanline_packed;
+  p.interpolate_scanline = self->interpolate_scanline_packed;
+
+  gst_deinterlace_method_process_bands (method, p.frame_height,
+      SIMPLE_METHOD_MIN_BAND_LINES,
+      gst_deinterlace_simple_method_deinterlace_lines, &p);
 }
 
 static void
@@ -454,63 +600,27 @@ static void
     GstDeinterlaceSimpleMethodFunction copy_scanline,
     GstDeinterlaceSimpleMethodFunction interpolate_scanline)
 {
-  GstDeinterlaceScanlineData scanlines;
-  gint i;
-  gint frame_height, frame_width;
-
-  frame_height = GST_VIDEO_FRAME_COMP_HEIGHT (dest, plane);
-  frame_width = GST_VIDEO_FRAME_COMP_WIDTH (dest, plane) *
-      GST_VIDEO_FRAME_COMP_PSTRIDE (dest, plane);
+  GstDeinterlaceSimpleMethodPlane p;
 
   g_assert (interpolate_scanline != NULL);
   g_assert (copy_scanline != NULL);
 
-#define LINE(x,i) (((guint8*)GST_VIDEO_FRAME_PLANE_DATA((x),plane)) + CLAMP_HI(CLAMP_LOW(i)) * \
-    GST_VIDEO_FRAME_PLANE_STRIDE((x),plane))
-#define LINE2(x,i) ((x) ? LINE(x,i) : NULL)
-
-  for (i = 0; i < frame_height; i++) {
-    memset (&scanlines, 0, sizeof (scanlines));
-    scanlines.bottom_field = (cur_field_flags == PICTURE_INTERLACED_BOTTOM);
-
-    if (!((i & 1) ^ scanlines.bottom_field)) {
-      /* copying */
-      scanlines.tp = LINE2 (framep, i - 1);
-      scanlines.bp = LINE2 (framep, i + 1);
-
-      scanlines.tt0 = LINE2 (frame0, (i - 2 >= 0) ? i - 2 : i);
-      scanlines.m0 = LINE2 (frame0, i);
-      scanlines.bb0 = LINE2 (frame0, (i + 2 < frame_height ? i + 2 : i));
-
-      scanlines.t1 = LINE2 (frame1, i - 1);
-      scanlines.b1 = LINE2 (frame1, i + 1);
-
-      scanlines.tt2 = LINE2 (frame2, (i - 2 >= 0) ? i - 2 : i);
-      scanlines.m2 = LINE2 (frame2, i);
-      scanlines.bb2 = LINE2 (frame2, (i + 2 < frame_height ? i + 2 : i));
-
-      copy_scanline (self, LINE (dest, i), &scanlines, frame_width);
-    } else {
-      /* interpolating */
-      scanlines.ttp = LINE2 (framep, (i - 2 >= 0) ? i - 2 : i);
-      scanlines.mp = LINE2 (framep, i);
-      scanlines.bbp = LINE2 (framep, (i + 2 < frame_height ? i + 2 : i));
-
-      scanlines.t0 = LINE2 (frame0, i - 1);
-      scanlines.b0 = LINE2 (frame0, i + 1);
-
-      scanlines.tt1 = LINE2 (frame1, (i - 2 >= 0) ? i - 2 : i);
-      scanlines.m1 = LINE2 (frame1, i);
-      scanlines.bb1 = LINE2 (frame1, (i + 2 < frame_height ? i + 2 : i));
-
-      scanlines.t2 = LINE2 (frame2, i - 1);
-      scanlines.b2 = LINE2 (frame2, i + 1);
+  p.dest = dest;
+  p.frame0 = frame0;
+  p.frame1 = frame1;
+  p.frame2 = frame2;
+  p.framep = framep;
+  p.cur_field_flags = cur_field_flags;
+  p.plane = plane;
+  p.frame_height = GST_VIDEO_FRAME_COMP_HEIGHT (dest, plane);
+  p.frame_width = GST_VIDEO_FRAME_COMP_WIDTH (dest, plane) *
+      GST_VIDEO_FRAME_COMP_PSTRIDE (dest, plane);
+  p.copy_scanline = copy_scanline;
+  p.interpolate_scanline = interpolate_scanline;
 
-      interpolate_scanline (self, LINE (dest, i), &scanlines, frame_width);
-    }
-#undef LINE
-#undef LINE2
-  }
+  gst_deinterlace_method_process_bands (GST_DEINTERLACE_METHOD (self),
+      p.frame_height, SIMPLE_METHOD_MIN_BAND_LINES,
+      gst_deinterlace_simple_method_deinterlace_lines, &p);
 }
 
 static void
@@ -64,12 +64,27 @@ typedef void (*GstDeinterlaceMethodDeinterlaceFunction) (
     GstDeinterlaceMethod *self, const GstDeinterlaceField *history,
     guint history_count, GstVideoFrame *outframe, int cur_field_idx);
 
+/*
+ * Processes the lines [start, end) of one band of the output, see
+ * gst_deinterlace_method_process_bands(). Bands never overlap and can
+ * run concurrently.
+ */
+typedef void (*GstDeinterlaceMethodBandFunction) (GstDeinterlaceMethod *self,
+    gint start, gint end, gpointer user_data);
+
 struct _GstDeinterlaceMethod {
   GstObject parent;
 
   GstVideoInfo *vinfo;
 
   GstDeinterlaceMethodDeinterlaceFunction deinterlace_frame;
+
+  /* band-parallel processing */
+  guint n_threads;
+  GThreadPool *band_pool;
+  GMutex band_lock;
+  GCond band_cond;
+  guint band_pending;
 };
 
 struct _GstDeinterlaceMethodClass {
@@ -111,6 +126,9 @@ void gst_deinterlace_method_deinterlace_frame (GstDeinterlaceMethod * self, cons
     int cur_field_idx);
 gint gst_deinterlace_method_get_fields_required (GstDeinterlaceMethod * self);
 gint gst_deinterlace_method_get_latency (GstDeinterlaceMethod * self);
+void gst_deinterlace_method_set_n_threads (GstDeinterlaceMethod * self, guint n_threads);
+void gst_deinterlace_method_process_bands (GstDeinterlaceMethod * self, gint n_lines,
+    gint min_band_lines, GstDeinterlaceMethodBandFunction func, gpointer user_data);
 
 #define GST_TYPE_DEINTERLACE_SIMPLE_METHOD		(gst_deinterlace_simple_method_get_type ())
 #define GST_IS_DEINTERLACE_SIMPLE_METHOD(obj)		(G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_DEINTERLACE_SIMPLE_METHOD))
@@ -41,6 +41,20 @@
 #include <orc/orc.h>
 #endif
 
+/* The AVX2 kernels are built with a function level target attribute and
+ * selected at runtime, the NEON kernels are used whenever the compiler
+ * targets NEON */
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define HAVE_GREEDYH_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define HAVE_GREEDYH_NEON 1
+#include <arm_neon.h>
+#endif
+
 #define GST_TYPE_DEINTERLACE_METHOD_GREEDY_H	(gst_deinterlace_method_greedy_h_get_type ())
 #define GST_IS_DEINTERLACE_METHOD_GREEDY_H(obj)		(G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_DEINTERLACE_METHOD_GREEDY_H))
 #define GST_IS_DEINTERLACE_METHOD_GREEDY_H_CLASS(klass)	(G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_DEINTERLACE_METHOD_GREEDY_H))
@@ -716,6 +730,372 @@ greedyh_scanline_C_planar_uv (GstDeinterlaceMethodGreedyH * self,
 
 #endif
 
+#if defined(HAVE_GREEDYH_AVX2) || defined(HAVE_GREEDYH_NEON)
+
+/* Generic version of the C scanline functions above that works on single
+ * bytes. step is the distance in bytes to the same component of the
+ * neighbouring pixel and luma_mask has the bytes set that get motion
+ * compensation, repeated every 4 bytes. */
+static inline guint8
+greedyh_scanline_byte (const guint8 * L1, const guint8 * L2, const guint8 * L3,
+    const guint8 * L2P, gint i, gint width, gint step, guint32 luma_mask,
+    guint max_comb, guint motion_threshold, guint motion_sense)
+{
+  gint prev = (i >= step) ? i - step : i;
+  gint next = (i + step < width) ? i + step : i;
+  guint8 avg, avg_s, avg_sc, best, out, min, max;
+  guint8 l2_diff, lp2_diff;
+  guint16 mov;
+
+  avg = (L1[i] + L3[i]) / 2;
+  avg_s = ((L1[prev] + L3[prev]) / 2 + (L1[next] + L3[next]) / 2) / 2;
+  avg_sc = (avg + avg_s) / 2;
+
+  l2_diff = ABS (L2[i] - avg_sc);
+  lp2_diff = ABS (L2P[i] - avg_sc);
+  best = (l2_diff > lp2_diff) ? L2P[i] : L2[i];
+
+  max = MAX (L1[i], L3[i]);
+  min = MIN (L1[i], L3[i]);
+  max = (max < 256 - max_comb) ? max + max_comb : 255;
+  min = (min > max_comb) ? min - max_comb : 0;
+  out = CLAMP (best, min, max);
+
+  if ((luma_mask >> ((i & 3) * 8)) & 0xff) {
+    mov = ABS (L2[i] - L2P[i]);
+    mov = (mov > motion_threshold) ? mov - motion_threshold : 0;
+    mov = MIN (mov * motion_sense, 256);
+    out = (out * (256 - mov) + avg_sc * mov) / 256;
+  }
+
+  return out;
+}
+
+#define GREEDYH_LUMA_PLANAR_Y  0xffffffff
+#define GREEDYH_LUMA_PLANAR_UV 0x00000000
+#define GREEDYH_LUMA_YUY2      0x00ff00ff
+#define GREEDYH_LUMA_UYVY      0xff00ff00
+#define GREEDYH_LUMA_AYUV      0x0000ffff
+
+#endif
+
+#ifdef HAVE_GREEDYH_AVX2
+
+#define GREEDYH_AVX2_ATTR __attribute__ ((target ("avx2")))
+
+/* (a + b) / 2 rounded down, _mm256_avg_epu8() rounds up */
+#define AVG_FLOOR(a,b) _mm256_sub_epi8 (_mm256_avg_epu8 ((a), (b)), \
+    _mm256_and_si256 (_mm256_xor_si256 ((a), (b)), one))
+#define ABS_DIFF(a,b) _mm256_or_si256 (_mm256_subs_epu8 ((a), (b)), \
+    _mm256_subs_epu8 ((b), (a)))
+
+static GREEDYH_AVX2_ATTR void
+greedyh_scanline_AVX2 (GstDeinterlaceMethodGreedyH * self, const guint8 * L1,
+    const guint8 * L2, const guint8 * L3, const guint8 * L2P, guint8 * Dest,
+    gint width, gint step, guint32 luma_mask)
+{
+  const __m256i one = _mm256_set1_epi8 (1);
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i w256 = _mm256_set1_epi16 (256);
+  const __m256i comb = _mm256_set1_epi8 (self->max_comb);
+  const __m256i threshold = _mm256_set1_epi8 (self->motion_threshold);
+  const __m256i sense = _mm256_set1_epi16 (self->motion_sense);
+  const __m256i luma = _mm256_set1_epi32 (luma_mask);
+  gint i;
+
+  width = (width / step) * step;
+
+  /* the vector loop starts at a multiple of 4 so that luma stays aligned
+   * to the component layout, the first and last pixels need the clamped
+   * neighbours of the byte version */
+  for (i = 0; i < MIN (4, width); i++)
+    Dest[i] = greedyh_scanline_byte (L1, L2, L3, L2P, i, width, step,
+        luma_mask, self->max_comb, self->motion_threshold, self->motion_sense);
+
+  for (; i + 32 + step <= width; i += 32) {
+    __m256i l1, l3, l2, lp2, avg, avg_s, avg_sc, best, out, min, max, le;
+
+    l1 = _mm256_loadu_si256 ((const __m256i *) (L1 + i));
+    l3 = _mm256_loadu_si256 ((const __m256i *) (L3 + i));
+    l2 = _mm256_loadu_si256 ((const __m256i *) (L2 + i));
+    lp2 = _mm256_loadu_si256 ((const __m256i *) (L2P + i));
+
+    avg = AVG_FLOOR (l1, l3);
+    avg_s = AVG_FLOOR (AVG_FLOOR (_mm256_loadu_si256 ((const __m256i *) (L1 +
+                    i - step)), _mm256_loadu_si256 ((const __m256i *) (L3 +
+                    i - step))),
+        AVG_FLOOR (_mm256_loadu_si256 ((const __m256i *) (L1 + i + step)),
+            _mm256_loadu_si256 ((const __m256i *) (L3 + i + step))));
+    avg_sc = AVG_FLOOR (avg, avg_s);
+
+    /* best of L2 and L2P is the one closer to the average */
+    le = ABS_DIFF (l2, avg_sc);
+    le = _mm256_cmpeq_epi8 (_mm256_min_epu8 (le, ABS_DIFF (lp2, avg_sc)), le);
+    best = _mm256_blendv_epi8 (lp2, l2, le);
+
+    max = _mm256_adds_epu8 (_mm256_max_epu8 (l1, l3), comb);
+    min = _mm256_subs_epu8 (_mm256_min_epu8 (l1, l3), comb);
+    out = _mm256_min_epu8 (_mm256_max_epu8 (best, min), max);
+
+    if (luma_mask) {
+      __m256i mov, mov_lo, mov_hi, res_lo, res_hi;
+
+      mov = _mm256_subs_epu8 (ABS_DIFF (l2, lp2), threshold);
+      mov_lo = _mm256_min_epu16 (_mm256_mullo_epi16 (_mm256_unpacklo_epi8 (mov,
+                  zero), sense), w256);
+      mov_hi = _mm256_min_epu16 (_mm256_mullo_epi16 (_mm256_unpackhi_epi8 (mov,
+                  zero), sense), w256);
+
+      res_lo = _mm256_add_epi16 (_mm256_mullo_epi16 (_mm256_unpacklo_epi8 (out,
+                  zero), _mm256_sub_epi16 (w256, mov_lo)),
+          _mm256_mullo_epi16 (_mm256_unpacklo_epi8 (avg_sc, zero), mov_lo));
+      res_hi = _mm256_add_epi16 (_mm256_mullo_epi16 (_mm256_unpackhi_epi8 (out,
+                  zero), _mm256_sub_epi16 (w256, mov_hi)),
+          _mm256_mullo_epi16 (_mm256_unpackhi_epi8 (avg_sc, zero), mov_hi));
+
+      out = _mm256_blendv_epi8 (out,
+          _mm256_packus_epi16 (_mm256_srli_epi16 (res_lo, 8),
+              _mm256_srli_epi16 (res_hi, 8)), luma);
+    }
+
+    _mm256_storeu_si256 ((__m256i *) (Dest + i), out);
+  }
+
+  for (; i < width; i++)
+    Dest[i] = greedyh_scanline_byte (L1, L2, L3, L2P, i, width, step,
+        luma_mask, self->max_comb, self->motion_threshold, self->motion_sense);
+}
+
+#undef AVG_FLOOR
+#undef ABS_DIFF
+
+static GREEDYH_AVX2_ATTR void
+greedyh_scanline_AVX2_yuy2 (GstDeinterlaceMethodGreedyH * self,
+    const guint8 * L1, const guint8 * L2, const guint8 * L3, const guint8 * L2P,
+    guint8 * Dest, gint width)
+{
+  greedyh_scanline_AVX2 (self, L1, L2, L3, L2P, Dest, width, 2,
+      GREEDYH_LUMA_YUY2);
+}
+
+static GREEDYH_AVX2_ATTR void
+greedyh_scanline_AVX2_uyvy (GstDeinterlaceMethodGreedyH * self,
+    const guint8 * L1, const guint8 * L2, const guint8 * L3, const guint8 * L2P,
+    guint8 * Dest, gint width)
+{
+  greedyh_scanline_AVX2 (self, L1, L2, L3, L2P, Dest, width, 2,
+      GREEDYH_LUMA_UYVY);
+}
+
+static GREEDYH_AVX2_ATTR void
+greedyh_scanline_AVX2_ayuv (GstDeinterlaceMethodGreedyH * self,
+    const guint8 * L1, const guint8 * L2, const guint8 * L3, const guint8 * L2P,
+    guint8 * Dest, gint width)
+{
+  greedyh_scanline_AVX2 (self, L1, L2, L3, L2P, Dest, width, 4,
+      GREEDYH_LUMA_AYUV);
+}
+
+static GREEDYH_AVX2_ATTR void
+greedyh_scanline_AVX2_planar_y (GstDeinterlaceMethodGreedyH * self,
+    const guint8 * L1, const guint8 * L2, const guint8 * L3, const guint8 * L2P,
+    guint8 * Dest, gint width)
+{
+  greedyh_scanline_AVX2 (self, L1, L2, L3, L2P, Dest, width, 1,
+      GREEDYH_LUMA_PLANAR_Y);
+}
+
+static GREEDYH_AVX2_ATTR void
+greedyh_scanline_AVX2_planar_uv (GstDeinterlaceMethodGreedyH * self,
+    const guint8 * L1, const guint8 * L2, const guint8 * L3, const guint8 * L2P,
+    guint8 * Dest, gint width)
+{
+  greedyh_scanline_AVX2 (self, L1, L2, L3, L2P, Dest, width, 1,
+      GREEDYH_LUMA_PLANAR_UV);
+}
+
+#endif
+
+#ifdef HAVE_GREEDYH_NEON
+
+static void
+greedyh_scanline_NEON (GstDeinterlaceMethodGreedyH * self, const guint8 * L1,
+    const guint8 * L2, const guint8 * L3, const guint8 * L2P, guint8 * Dest,
+    gint width, gint step, guint32 luma_mask)
+{
+  const uint16x8_t w256 = vdupq_n_u16 (256);
+  const uint8x16_t comb = vdupq_n_u8 (self->max_comb);
+  const uint8x16_t threshold = vdupq_n_u8 (self->motion_threshold);
+  const uint8x8_t sense = vdup_n_u8 (self->motion_sense);
+  const uint8x16_t luma = vreinterpretq_u8_u32 (vdupq_n_u32 (luma_mask));
+  gint i;
+
+  width = (width / step) * step;
+
+  /* see greedyh_scanline_AVX2() */
+  for (i = 0; i < MIN (4, width); i++)
+    Dest[i] = greedyh_scanline_byte (L1, L2, L3, L2P, i, width, step,
+        luma_mask, self->max_comb, self->motion_threshold, self->motion_sense);
+
+  for (; i + 16 + step <= width; i += 16) {
+    uint8x16_t l1, l3, l2, lp2, avg, avg_s, avg_sc, best, out, min, max;
+
+    l1 = vld1q_u8 (L1 + i);
+    l3 = vld1q_u8 (L3 + i);
+    l2 = vld1q_u8 (L2 + i);
+    lp2 = vld1q_u8 (L2P + i);
+
+    /* vhaddq_u8() rounds down like the C version */
+    avg = vhaddq_u8 (l1, l3);
+    avg_s = vhaddq_u8 (vhaddq_u8 (vld1q_u8 (L1 + i - step),
+            vld1q_u8 (L3 + i - step)), vhaddq_u8 (vld1q_u8 (L1 + i + step),
+            vld1q_u8 (L3 + i + step)));
+    avg_sc = vhaddq_u8 (avg, avg_s);
+
+    best = vbslq_u8 (vcleq_u8 (vabdq_u8 (l2, avg_sc), vabdq_u8 (lp2, avg_sc)),
+        l2, lp2);
+
+    max = vqaddq_u8 (vmaxq_u8 (l1, l3), comb);
+    min = vqsubq_u8 (vminq_u8 (l1, l3), comb);
+    out = vminq_u8 (vmaxq_u8 (best, min), max);
+
+    if (luma_mask) {
+      uint8x16_t mov;
+      uint16x8_t mov_lo, mov_hi, res_lo, res_hi;
+
+      mov = vqsubq_u8 (vabdq_u8 (l2, lp2), threshold);
+      mov_lo = vminq_u16 (vmull_u8 (vget_low_u8 (mov), sense), w256);
+      mov_hi = vminq_u16 (vmull_u8 (vget_high_u8 (mov), sense), w256);
+
+      res_lo = vmlaq_u16 (vmulq_u16 (vmovl_u8 (vget_low_u8 (out)),
+              vsubq_u16 (w256, mov_lo)), vmovl_u8 (vget_low_u8 (avg_sc)),
+          mov_lo);
+      res_hi = vmlaq_u16 (vmulq_u16 (vmovl_u8 (vget_high_u8 (out)),
+              vsubq_u16 (w256, mov_hi)), vmovl_u8 (vget_high_u8 (avg_sc)),
+          mov_hi);
+
+      out = vbslq_u8 (luma, vcombine_u8 (vshrn_n_u16 (res_lo, 8),
+              vshrn_n_u16 (res_hi, 8)), out);
+    }
+
+    vst1q_u8 (Dest + i, out);
+  }
+
+  for (; i < width; i++)
+    Dest[i] = greedyh_scanline_byte (L1, L2, L3, L2P, i, width, step,
+        luma_mask, self->max_comb, self->motion_threshold, self->motion_sense);
+}
+
+static void
+greedyh_scanline_NEON_yuy2 (GstDeinterlaceMethodGreedyH * self,
+    const guint8 * L1, const guint8 * L2, const guint8 * L3, const guint8 * L2P,
+    guint8 * Dest, gint width)
+{
+  greedyh_scanline_NEON (self, L1, L2, L3, L2P, Dest, width, 2,
+      GREEDYH_LUMA_YUY2);
+}
+
+static void
+greedyh_scanline_NEON_uyvy (GstDeinterlaceMethodGreedyH * self,
+    const guint8 * L1, const guint8 * L2, const guint8 * L3, const guint8 * L2P,
+    guint8 * Dest, gint width)
+{
+  greedyh_scanline_NEON (self, L1, L2, L3, L2P, Dest, width, 2,
+      GREEDYH_LUMA_UYVY);
+}
+
+static void
+greedyh_scanline_NEON_ayuv (GstDeinterlaceMethodGreedyH * self,
+    const guint8 * L1, const guint8 * L2, const guint8 * L3, const guint8 * L2P,
+    guint8 * Dest, gint width)
+{
+  greedyh_scanline_NEON (self, L1, L2, L3, L2P, Dest, width, 4,
+      GREEDYH_LUMA_AYUV);
+}
+
+static void
+greedyh_scanline_NEON_planar_y (GstDeinterlaceMethodGreedyH * self,
+    const guint8 * L1, const guint8 * L2, const guint8 * L3, const guint8 * L2P,
+    guint8 * Dest, gint width)
+{
+  greedyh_scanline_NEON (self, L1, L2, L3, L2P, Dest, width, 1,
+      GREEDYH_LUMA_PLANAR_Y);
+}
+
+static void
+greedyh_scanline_NEON_planar_uv (GstDeinterlaceMethodGreedyH * self,
+    const guint8 * L1, const guint8 * L2, const guint8 * L3, const guint8 * L2P,
+    guint8 * Dest, gint width)
+{
+  greedyh_scanline_NEON (self, L1, L2, L3, L2P, Dest, width, 1,
+      GREEDYH_LUMA_PLANAR_UV);
+}
+
+#endif
+
+/* Lines of a field that are smaller than this are not split into bands */
+#define GREEDYH_MIN_BAND_LINES 8
+
+typedef struct
+{
+  const guint8 *L1, *L2, *L3, *L2P;
+  guint8 *Dest;
+  gint RowStride, Pitch;
+  ScanlineFunction scanline;
+} GreedyHLines;
+
+static void
+deinterlace_frame_di_greedyh_lines (GstDeinterlaceMethod * method, gint start,
+    gint end, gpointer user_data)
+{
+  GstDeinterlaceMethodGreedyH *self = GST_DEINTERLACE_METHOD_GREEDY_H (method);
+  GreedyHLines *lines = user_data;
+  gint RowStride = lines->RowStride;
+  gint Pitch = lines->Pitch;
+  const guint8 *L1 = lines->L1 + start * Pitch;
+  const guint8 *L2 = lines->L2 + start * Pitch;
+  const guint8 *L3 = lines->L3 + start * Pitch;
+  const guint8 *L2P = lines->L2P + start * Pitch;
+  guint8 *Dest = lines->Dest + start * Pitch;
+  gint Line;
+
+  for (Line = start; Line < end; ++Line) {
+    lines->scanline (self, L1, L2, L3, L2P, Dest, RowStride);
+    Dest += RowStride;
+    memcpy (Dest, L3, RowStride);
+    Dest += RowStride;
+
+    L1 += Pitch;
+    L2 += Pitch;
+    L3 += Pitch;
+    L2P += Pitch;
+  }
+}
+
+/* Every field line produces an interpolated and a copied output line and
+ * only depends on the input fields, so the field lines are split into bands
+ * that are processed in parallel */
+static void
+deinterlace_frame_di_greedyh_process_lines (GstDeinterlaceMethodGreedyH * self,
+    const guint8 * L1, const guint8 * L2, const guint8 * L3, const guint8 * L2P,
+    guint8 * Dest, gint RowStride, gint Pitch, gint Lines,
+    ScanlineFunction scanline)
+{
+  GreedyHLines lines;
+
+  lines.L1 = L1;
+  lines.L2 = L2;
+  lines.L3 = L3;
+  lines.L2P = L2P;
+  lines.Dest = Dest;
+  lines.RowStride = RowStride;
+  lines.Pitch = Pitch;
+  lines.scanline = scanline;
+
+  gst_deinterlace_method_process_bands (GST_DEINTERLACE_METHOD (self), Lines,
+      GREEDYH_MIN_BAND_LINES, deinterlace_frame_di_greedyh_lines, &lines);
+}
+
 static void
 deinterlace_frame_di_greedyh_packed (GstDeinterlaceMethod * method,
     const GstDeinterlaceField * history, guint history_count,
@@ -725,7 +1105,7 @@ deinterlace_frame_di_greedyh_packed (GstDeinterlaceMethod * method,
   GstDeinterlaceMethodGreedyHClass *klass =
       GST_DEINTERLACE_METHOD_GREEDY_H_GET_CLASS (self);
   gint InfoIsOdd = 0;
-  gint Line;
+  gint Lines;
   gint RowStride = GST_VIDEO_FRAME_COMP_STRIDE (outframe, 0);
   gint FieldHeight = GST_VIDEO_FRAME_HEIGHT (outframe) / 2;
   gint Pitch = RowStride * 2;
@@ -742,6 +1122,7 @@ deinterlace_frame_di_greedyh_packed (GstDeinterlaceMethod * method,
     backup_method = g_object_new (gst_deinterlace_method_linear_get_type (),
         NULL);
 
+    gst_deinterlace_method_set_n_threads (backup_method, method->n_threads);
     gst_deinterlace_method_setup (backup_method, method->vinfo);
     gst_deinterlace_method_deinterlace_frame (backup_method,
         history, history_count, outframe, cur_field_idx);
@@ -816,20 +1197,12 @@ deinterlace_frame_di_greedyh_packed (GstDeinterlaceMethod * method,
     Dest += RowStride;
   }
 
-  for (Line = 0; Line < (FieldHeight - 1); ++Line) {
-    scanline (self, L1, L2, L3, L2P, Dest, RowStride);
-    Dest += RowStride;
-    memcpy (Dest, L3, RowStride);
-    Dest += RowStride;
-
-    L1 += Pitch;
-    L2 += Pitch;
-    L3 += Pitch;
-    L2P += Pitch;
-  }
+  Lines = MAX (FieldHeight - 1, 0);
+  deinterlace_frame_di_greedyh_process_lines (self, L1, L2, L3, L2P, Dest,
+      RowStride, Pitch, Lines, scanline);
 
   if (InfoIsOdd) {
-    memcpy (Dest, L2, RowStride);
+    memcpy (Dest + Lines * Pitch, L2 + Lines * Pitch, RowStride);
   }
 }
 
@@ -839,7 +1212,7 @@ deinterlace_frame_di_greedyh_planar_plane (GstDeinterlaceMethodGreedyH * self,
     guint8 * Dest, gint RowStride, gint FieldHeight, gint Pitch, gint InfoIsOdd,
     ScanlineFunction scanline)
 {
-  gint Line;
+  gint Lines;
 
   // copy first even line no matter what, and the first odd line if we're
   // processing an EVEN field. (note diff from other deint rtns.)
@@ -857,20 +1230,12 @@ deinterlace_frame_di_greedyh_planar_plane (GstDeinterlaceMethodGreedyH * self,
     Dest += RowStride;
   }
 
-  for (Line = 0; Line < (FieldHeight - 1); ++Line) {
-    scanline (self, L1, L2, L3, L2P, Dest, RowStride);
-    Dest += RowStride;
-    memcpy (Dest, L3, RowStride);
-    Dest += RowStride;
-
-    L1 += Pitch;
-    L2 += Pitch;
-    L3 += Pitch;
-    L2P += Pitch;
-  }
+  Lines = MAX (FieldHeight - 1, 0);
+  deinterlace_frame_di_greedyh_process_lines (self, L1, L2, L3, L2P, Dest,
+      RowStride, Pitch, Lines, scanline);
 
   if (InfoIsOdd) {
-    memcpy (Dest, L2, RowStride);
+    memcpy (Dest + Lines * Pitch, L2 + Lines * Pitch, RowStride);
   }
 }
 
@@ -900,6 +1265,7 @@ deinterlace_frame_di_greedyh_planar (GstDeinterlaceMethod * method,
     backup_method = g_object_new (gst_deinterlace_method_linear_get_type (),
         NULL);
 
+    gst_deinterlace_method_set_n_threads (backup_method, method->n_threads);
     gst_deinterlace_method_setup (backup_method, method->vinfo);
     gst_deinterlace_method_deinterlace_frame (backup_method,
         history, history_count, outframe, cur_field_idx);
@@ -1065,6 +1431,23 @@ gst_deinterlace_method_greedy_h_class_init (GstDeinterlaceMethodGreedyHClass *
   klass->scanline_ayuv = greedyh_scanline_C_ayuv;
   klass->scanline_planar_y = greedyh_scanline_C_planar_y;
   klass->scanline_planar_uv = greedyh_scanline_C_planar_uv;
+
+#ifdef HAVE_GREEDYH_AVX2
+  if (__builtin_cpu_supports ("avx2")) {
+    klass->scanline_yuy2 = greedyh_scanline_AVX2_yuy2;
+    klass->scanline_uyvy = greedyh_scanline_AVX2_uyvy;
+    klass->scanline_ayuv = greedyh_scanline_AVX2_ayuv;
+    klass->scanline_planar_y = greedyh_scanline_AVX2_planar_y;
+    klass->scanline_planar_uv = greedyh_scanline_AVX2_planar_uv;
+  }
+#endif
+#ifdef HAVE_GREEDYH_NEON
+  klass->scanline_yuy2 = greedyh_scanline_NEON_yuy2;
+  klass->scanline_uyvy = greedyh_scanline_NEON_uyvy;
+  klass->scanline_ayuv = greedyh_scanline_NEON_ayuv;
+  klass->scanline_planar_y = greedyh_scanline_NEON_planar_y;
+  klass->scanline_planar_uv = greedyh_scanline_NEON_planar_uv;
+#endif
 }
 
 static void
@@ -557,14 +557,15 @@ gst_dtmf_src_generate_tone (GstDTMFSrcEvent * event, DTMF_KEY key,
   GstBuffer *buffer;
   GstMapInfo map;
   gint16 *p;
-  gint tone_size;
-  double i = 0;
-  double amplitude, f1, f2;
+  gint tone_size, n_samples, i;
+  double amplitude, f1, f2, f1_prev, f2_prev, tmp;
+  double w1, w2, c1, c2;
   double volume_factor;
   static GstAllocationParams params = { 0, 1, 0, 0, };
 
   /* Create a buffer for the tone */
   tone_size = ((duration / 1000) * sample_rate * SAMPLE_SIZE * CHANNELS) / 8;
+  n_samples = tone_size / (SAMPLE_SIZE / 8);
 
   buffer = gst_buffer_new_allocate (NULL, tone_size, &params);
 
@@ -574,16 +575,25 @@ gst_dtmf_src_generate_tone (GstDTMFSrcEvent * event, DTMF_KEY key,
   volume_factor = pow (10, (-event->volume) / 20);
 
   /*
-   * For each sample point we calculate 'x' as the
-   * the amplitude value.
+   * Instead of calling sin() for every sample, both frequencies are
+   * generated with a recursive oscillator:
+   *   sin (n w) = 2 cos (w) sin ((n - 1) w) - sin ((n - 2) w)
+   * It is seeded from the position in the tone at the start of every
+   * buffer, so rounding errors can't build up over long tones.
    */
-  for (i = 0; i < (tone_size / (SAMPLE_SIZE / 8)); i++) {
+  w1 = 2 * M_PI * key.low_frequency / sample_rate;
+  w2 = 2 * M_PI * key.high_frequency / sample_rate;
+  c1 = 2 * cos (w1);
+  c2 = 2 * cos (w2);
+  f1 = sin (w1 * event->sample);
+  f2 = sin (w2 * event->sample);
+  f1_prev = sin (w1 * (event->sample - 1));
+  f2_prev = sin (w2 * (event->sample - 1));
+
+  for (i = 0; i < n_samples; i++) {
     /*
      * We add the fundamental frequencies together.
      */
-    f1 = sin (2 * M_PI * key.low_frequency * (event->sample / sample_rate));
-    f2 = sin (2 * M_PI * key.high_frequency * (event->sample / sample_rate));
-
     amplitude = (f1 + f2) / 2;
 
     /* Adjust the volume */
@@ -595,16 +605,22 @@ gst_dtmf_src_generate_tone (GstDTMFSrcEvent * event, DTMF_KEY key,
     /* Store it in the data buffer */
     *(p++) = (gint16) amplitude;
 
-    (event->sample)++;
+    tmp = c1 * f1 - f1_prev;
+    f1_prev = f1;
+    f1 = tmp;
+    tmp = c2 * f2 - f2_prev;
+    f2_prev = f2;
+    f2 = tmp;
   }
 
+  event->sample += n_samples;
+
   gst_buffer_unmap (buffer, &map);
 
   return buffer;
 }
 
 
-
 static GstBuffer *
 gst_dtmf_src_create_next_tone_packet (GstDTMFSrc * dtmfsrc,
     GstDTMFSrcEvent * event)
@@ -319,6 +319,8 @@ gst_rtp_dtmf_src_finalize (GObject * object)
     dtmfsrc->event_queue = NULL;
   }
 
+  gst_buffer_replace (&dtmfsrc->redundant_packet, NULL);
+
 
   G_OBJECT_CLASS (gst_rtp_dtmf_src_parent_class)->finalize (object);
 }
@@ -592,11 +594,26 @@ gst_rtp_dtmf_src_create_next_rtp_packet (GstRTPDTMFSrc * dtmfsrc)
   GstRTPDTMFPayload *payload;
   GstRTPBuffer rtpbuffer = GST_RTP_BUFFER_INIT;
 
-  buf = gst_rtp_buffer_new_allocate (sizeof (GstRTPDTMFPayload), 0, 0);
+  if (dtmfsrc->redundant_packet) {
+    /* A redundant copy of the previous packet, which only differs in the
+     * sequence number and never carries the marker */
+    buf = gst_buffer_copy_region (dtmfsrc->redundant_packet,
+        GST_BUFFER_COPY_ALL | GST_BUFFER_COPY_DEEP, 0, -1);
+
+    gst_rtp_buffer_map (buf, GST_MAP_READWRITE, &rtpbuffer);
+    gst_rtp_buffer_set_marker (&rtpbuffer, FALSE);
+    dtmfsrc->seqnum++;
+    gst_rtp_buffer_set_seq (&rtpbuffer, dtmfsrc->seqnum);
+    payload = NULL;
+  } else {
+    buf = gst_rtp_buffer_new_allocate (sizeof (GstRTPDTMFPayload), 0, 0);
+
+    gst_rtp_buffer_map (buf, GST_MAP_READWRITE, &rtpbuffer);
 
-  gst_rtp_buffer_map (buf, GST_MAP_READWRITE, &rtpbuffer);
+    gst_rtp_dtmf_prepare_rtp_headers (dtmfsrc, &rtpbuffer);
 
-  gst_rtp_dtmf_prepare_rtp_headers (dtmfsrc, &rtpbuffer);
+    payload = (GstRTPDTMFPayload *) gst_rtp_buffer_get_payload (&rtpbuffer);
+  }
 
   /* timestamp and duration of GstBuffer */
   /* Redundant buffer have no duration ... */
@@ -606,12 +623,12 @@ gst_rtp_dtmf_src_create_next_rtp_packet (GstRTPDTMFSrc * dtmfsrc)
     GST_BUFFER_DURATION (buf) = dtmfsrc->ptime * GST_MSECOND;
   GST_BUFFER_PTS (buf) = dtmfsrc->timestamp;
 
-  payload = (GstRTPDTMFPayload *) gst_rtp_buffer_get_payload (&rtpbuffer);
+  if (payload) {
+    /* copy payload and convert to network-byte order */
+    memmove (payload, dtmfsrc->payload, sizeof (GstRTPDTMFPayload));
 
-  /* copy payload and convert to network-byte order */
-  memmove (payload, dtmfsrc->payload, sizeof (GstRTPDTMFPayload));
-
-  payload->duration = g_htons (payload->duration);
+    payload->duration = g_htons (payload->duration);
+  }
 
   if (dtmfsrc->redundancy_count <= 1 && dtmfsrc->last_packet) {
     GstClockTime inter_digit_interval = MIN_INTER_DIGIT_INTERVAL;
@@ -697,6 +714,19 @@ gst_rtp_dtmf_src_create (GstBaseSrc * basesrc, guint64 offset,
 
   dtmfsrc = GST_RTP_DTMF_SRC (basesrc);
 
+  /* Redundant packets follow the previous one with the same timestamp, so
+   * they are built from it and sent right away without looking at the
+   * event queue or waiting on the clock */
+  if (dtmfsrc->redundant_packet) {
+    GST_OBJECT_LOCK (dtmfsrc);
+    if (!dtmfsrc->paused && !dtmfsrc->dirty) {
+      GST_OBJECT_UNLOCK (dtmfsrc);
+      goto send_last;
+    }
+    GST_OBJECT_UNLOCK (dtmfsrc);
+    gst_buffer_replace (&dtmfsrc->redundant_packet, NULL);
+  }
+
   do {
 
     if (dtmfsrc->payload == NULL) {
@@ -836,6 +866,10 @@ send_last:
   if (dtmfsrc->redundancy_count)
     dtmfsrc->redundancy_count--;
 
+  /* Keep it as template for the redundant copies still to be sent */
+  gst_buffer_replace (&dtmfsrc->redundant_packet,
+      dtmfsrc->redundancy_count > 0 ? *buffer : NULL);
+
   /* Only the very first one has a marker */
   dtmfsrc->first_packet = FALSE;
 
@@ -856,6 +890,8 @@ paused_locked:
 
 paused:
 
+  gst_buffer_replace (&dtmfsrc->redundant_packet, NULL);
+
   if (dtmfsrc->payload) {
     dtmfsrc->first_packet = FALSE;
     dtmfsrc->last_packet = TRUE;
@@ -1089,6 +1125,8 @@ gst_rtp_dtmf_src_change_state (GstElement * element, GstStateChange transition)
       }
       dtmfsrc->last_event_was_start = FALSE;
 
+      gst_buffer_replace (&dtmfsrc->redundant_packet, NULL);
+
       /* Indicate that we don't do PRE_ROLL */
       break;
 
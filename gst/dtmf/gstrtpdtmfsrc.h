@@ -99,6 +99,9 @@ struct _GstRTPDTMFSrc
 
   gboolean dirty;
   guint16 redundancy_count;
+
+  /* last packet sent, while more redundant copies of it are due */
+  GstBuffer *redundant_packet;
 };
 
 struct _GstRTPDTMFSrcClass
@@ -61,6 +61,103 @@ static const struct _elements_entry _elements[] = {
   {NULL, 0},
 };
 
+/* Slices have at least this many rows, smaller ones are not worth the
+ * thread switch */
+#define SLICE_MIN_ROWS 16
+
+typedef struct
+{
+  GstEffectvSlices *slices;
+  GstEffectvSliceFunc func;
+  gpointer data;
+  gint y_start, y_end;
+} GstEffectvSlice;
+
+static void
+gst_effectv_slice_func (gpointer data, gpointer user_data)
+{
+  GstEffectvSlice *slice = data;
+  GstEffectvSlices *slices = slice->slices;
+
+  slice->func (slice->data, slice->y_start, slice->y_end);
+
+  g_mutex_lock (&slices->lock);
+  if (--slices->pending == 0)
+    g_cond_signal (&slices->cond);
+  g_mutex_unlock (&slices->lock);
+}
+
+void
+gst_effectv_slices_init (GstEffectvSlices * slices)
+{
+  slices->pool = NULL;
+  slices->pending = 0;
+  g_mutex_init (&slices->lock);
+  g_cond_init (&slices->cond);
+}
+
+void
+gst_effectv_slices_clear (GstEffectvSlices * slices)
+{
+  if (slices->pool)
+    g_thread_pool_free (slices->pool, FALSE, TRUE);
+  slices->pool = NULL;
+  g_mutex_clear (&slices->lock);
+  g_cond_clear (&slices->cond);
+}
+
+/* Calls func for the rows of a frame on up to n_threads threads (0 = one
+ * per processor), the calling thread takes the first slice and the function
+ * returns when all slices are done */
+void
+gst_effectv_slices_run (GstEffectvSlices * slices, guint n_threads, gint rows,
+    GstEffectvSliceFunc func, gpointer data)
+{
+  GstEffectvSlice *slice;
+  guint n_slices, i;
+  gint slice_rows;
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  n_slices = MIN (n_threads, rows / SLICE_MIN_ROWS);
+  if (n_slices > 1 && slices->pool == NULL) {
+    slices->pool = g_thread_pool_new (gst_effectv_slice_func, NULL,
+        n_slices - 1, FALSE, NULL);
+    if (slices->pool == NULL)
+      n_slices = 1;
+  } else if (n_slices > 1 &&
+      g_thread_pool_get_max_threads (slices->pool) < n_slices - 1) {
+    g_thread_pool_set_max_threads (slices->pool, n_slices - 1, NULL);
+  }
+
+  if (n_slices <= 1) {
+    func (data, 0, rows);
+    return;
+  }
+
+  slice_rows = (rows + n_slices - 1) / n_slices;
+  slice = g_newa (GstEffectvSlice, n_slices);
+  for (i = 0; i < n_slices; i++) {
+    slice[i].slices = slices;
+    slice[i].func = func;
+    slice[i].data = data;
+    slice[i].y_start = MIN (i * slice_rows, rows);
+    slice[i].y_end = MIN ((i + 1) * slice_rows, rows);
+  }
+
+  slices->pending = n_slices - 1;
+  for (i = 1; i < n_slices; i++)
+    g_thread_pool_push (slices->pool, &slice[i], NULL);
+
+  func (data, slice[0].y_start, slice[0].y_end);
+
+  g_mutex_lock (&slices->lock);
+  while (slices->pending > 0)
+    g_cond_wait (&slices->cond, &slices->lock);
+  g_mutex_unlock (&slices->lock);
+}
+
 static gboolean
 plugin_init (GstPlugin * plugin)
 {
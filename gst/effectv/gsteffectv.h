@@ -21,8 +21,13 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#ifndef __GST_EFFECTV_H__
+#define __GST_EFFECTV_H__
+
 #include <gst/gst.h>
 
+G_BEGIN_DECLS
+
 static inline guint
 fastrand (void)
 {
@@ -31,3 +36,25 @@ fastrand (void)
   return (fastrand_val = fastrand_val * 1103515245 + 12345);
 }
 
+/* Processes the rows from y_start to y_end of a frame */
+typedef void (*GstEffectvSliceFunc) (gpointer data, gint y_start, gint y_end);
+
+/* Splits the processing of a frame into slices of rows, each one handled
+ * by a thread of a pool that is kept for the element's lifetime */
+typedef struct
+{
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  guint pending;
+} GstEffectvSlices;
+
+void gst_effectv_slices_init (GstEffectvSlices * slices);
+void gst_effectv_slices_clear (GstEffectvSlices * slices);
+void gst_effectv_slices_run (GstEffectvSlices * slices, guint n_threads,
+    gint rows, GstEffectvSliceFunc func, gpointer data);
+
+G_END_DECLS
+
+#endif /* __GST_EFFECTV_H__ */
+
@@ -55,6 +55,11 @@
 #include "gstradioac.h"
 #include "gsteffectv.h"
 
+#if defined(__SSE2__)
+#define HAVE_RADIOACTV_SSE2 1
+#include <emmintrin.h>
+#endif
+
 enum
 {
   RADIOAC_NORMAL = 0,
@@ -115,6 +120,7 @@ gst_radioactv_color_get_type (void)
 #define DEFAULT_COLOR COLOR_WHITE
 #define DEFAULT_INTERVAL 3
 #define DEFAULT_TRIGGER FALSE
+#define DEFAULT_N_THREADS 1
 
 enum
 {
@@ -122,7 +128,8 @@ enum
   PROP_MODE,
   PROP_COLOR,
   PROP_INTERVAL,
-  PROP_TRIGGER
+  PROP_TRIGGER,
+  PROP_N_THREADS
 };
 
 #define COLORS 32
@@ -317,6 +324,82 @@ image_bgsubtract_update_y (guint32 * src, gint16 * background, guint8 * diff,
   }
 }
 
+typedef struct
+{
+  GstRadioacTV *filter;
+  const guint32 *src;
+  guint32 *dest;
+  const guint32 *palette;
+  gint width;
+} GstRadioacTVSliceData;
+
+static void
+gst_radioactv_bgsubtract_rows (gpointer data, gint y_start, gint y_end)
+{
+  GstRadioacTVSliceData *d = data;
+  gint offset = y_start * d->width;
+
+  image_bgsubtract_update_y ((guint32 *) d->src + offset,
+      d->filter->background + offset, d->filter->diff + offset,
+      (y_end - y_start) * d->width, MAGIC_THRESHOLD * 7);
+}
+
+/* Adds the palette color of the blurred and zoomed buffer to the pixels,
+ * saturating each component */
+static void
+gst_radioactv_draw_rows (gpointer data, gint y_start, gint y_end)
+{
+  GstRadioacTVSliceData *d = data;
+  GstRadioacTV *filter = d->filter;
+  const guint32 *src, *palette = d->palette;
+  guint32 *dest;
+  const guint8 *p;
+  guint32 a, b;
+  gint x, y;
+
+  src = d->src + y_start * d->width;
+  dest = d->dest + y_start * d->width;
+  p = filter->blurzoombuf + y_start * filter->buf_width;
+
+  for (y = y_start; y < y_end; y++) {
+    for (x = 0; x < filter->buf_margin_left; x++) {
+      *dest++ = *src++;
+    }
+    x = 0;
+#ifdef HAVE_RADIOACTV_SSE2
+    {
+      const __m128i mask = _mm_set1_epi32 (0xfefeff);
+      const __m128i carry = _mm_set1_epi32 (0x1010100);
+
+      for (; x + 4 <= filter->buf_width; x += 4) {
+        __m128i va, vb;
+
+        va = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) src), mask);
+        vb = _mm_set_epi32 (palette[p[3]], palette[p[2]], palette[p[1]],
+            palette[p[0]]);
+        va = _mm_add_epi32 (va, vb);
+        vb = _mm_and_si128 (va, carry);
+        va = _mm_or_si128 (va, _mm_sub_epi32 (vb, _mm_srli_epi32 (vb, 8)));
+        _mm_storeu_si128 ((__m128i *) dest, va);
+        src += 4;
+        dest += 4;
+        p += 4;
+      }
+    }
+#endif
+    for (; x < filter->buf_width; x++) {
+      a = *src++ & 0xfefeff;
+      b = palette[*p++];
+      a += b;
+      b = a & 0x1010100;
+      *dest++ = a | (b - (b >> 8));
+    }
+    for (x = 0; x < filter->buf_margin_right; x++) {
+      *dest++ = *src++;
+    }
+  }
+}
+
 static GstFlowReturn
 gst_radioactv_transform_frame (GstVideoFilter * vfilter,
     GstVideoFrame * in_frame, GstVideoFrame * out_frame)
@@ -325,9 +408,9 @@ gst_radioactv_transform_frame (GstVideoFilter * vfilter,
   guint32 *src, *dest;
   GstClockTime timestamp, stream_time;
   gint x, y, width, height;
-  guint32 a, b;
   guint8 *diff, *p;
   guint32 *palette;
+  GstRadioacTVSliceData data;
 
   timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
   stream_time =
@@ -367,9 +450,15 @@ gst_radioactv_transform_frame (GstVideoFilter * vfilter,
   else if (filter->mode == 3 && !filter->trigger)
     filter->snaptime = 1;
 
+  data.filter = filter;
+  data.src = src;
+  data.dest = dest;
+  data.palette = palette;
+  data.width = width;
+
   if (filter->mode != 2 || filter->snaptime <= 0) {
-    image_bgsubtract_update_y (src, filter->background, diff,
-        width * height, MAGIC_THRESHOLD * 7);
+    gst_effectv_slices_run (&filter->slices, filter->n_threads, height,
+        gst_radioactv_bgsubtract_rows, &data);
     if (filter->mode == 0 || filter->snaptime <= 0) {
       diff += filter->buf_margin_left;
       p = filter->blurzoombuf;
@@ -388,24 +477,10 @@ gst_radioactv_transform_frame (GstVideoFilter * vfilter,
   blurzoomcore (filter);
 
   if (filter->mode == 1 || filter->mode == 2) {
-    src = filter->snapframe;
-  }
-  p = filter->blurzoombuf;
-  for (y = 0; y < height; y++) {
-    for (x = 0; x < filter->buf_margin_left; x++) {
-      *dest++ = *src++;
-    }
-    for (x = 0; x < filter->buf_width; x++) {
-      a = *src++ & 0xfefeff;
-      b = palette[*p++];
-      a += b;
-      b = a & 0x1010100;
-      *dest++ = a | (b - (b >> 8));
-    }
-    for (x = 0; x < filter->buf_margin_right; x++) {
-      *dest++ = *src++;
-    }
+    data.src = filter->snapframe;
   }
+  gst_effectv_slices_run (&filter->slices, filter->n_threads, height,
+      gst_radioactv_draw_rows, &data);
 
   if (filter->mode == 1 || filter->mode == 2) {
     filter->snaptime--;
@@ -437,7 +512,7 @@ gst_radioactv_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
   filter->buf_area = filter->buf_height * filter->buf_width;
   filter->buf_margin_left = (width - filter->buf_width) / 2;
   filter->buf_margin_right =
-      height - filter->buf_width - filter->buf_margin_left;
+      width - filter->buf_width - filter->buf_margin_left;
 
   if (filter->blurzoombuf)
     g_free (filter->blurzoombuf);
@@ -514,6 +589,8 @@ gst_radioactv_finalize (GObject * object)
     g_free (filter->blurzoomy);
   filter->blurzoomy = NULL;
 
+  gst_effectv_slices_clear (&filter->slices);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -539,6 +616,9 @@ gst_radioactv_set_property (GObject * object, guint prop_id,
     case PROP_TRIGGER:
       filter->trigger = g_value_get_boolean (value);
       break;
+    case PROP_N_THREADS:
+      filter->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -565,6 +645,9 @@ gst_radioactv_get_property (GObject * object, guint prop_id,
     case PROP_TRIGGER:
       g_value_set_boolean (value, filter->trigger);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, filter->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -604,6 +687,20 @@ gst_radioactv_class_init (GstRadioacTVClass * klass)
           "Trigger (in trigger mode)", DEFAULT_TRIGGER,
           GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRadioacTV:n-threads:
+   *
+   * Number of threads used to process a frame, each one handles a slice of
+   * the rows. 0 uses one thread per processor.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Maximum number of threads used to process a frame "
+          "(0 = number of processors)", 0, G_MAXUINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "RadioacTV effect",
       "Filter/Effect/Video",
       "motion-enlightment effect",
@@ -631,4 +728,6 @@ gst_radioactv_init (GstRadioacTV * filter)
   filter->color = DEFAULT_COLOR;
   filter->interval = DEFAULT_INTERVAL;
   filter->trigger = DEFAULT_TRIGGER;
+  filter->n_threads = DEFAULT_N_THREADS;
+  gst_effectv_slices_init (&filter->slices);
 }
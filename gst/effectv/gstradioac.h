@@ -32,6 +32,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include "gsteffectv.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_RADIOACTV \
@@ -73,6 +75,9 @@ struct _GstRadioacTV
   gint buf_area;
   gint buf_margin_right;
   gint buf_margin_left;
+
+  guint n_threads;
+  GstEffectvSlices slices;
 };
 
 struct _GstRadioacTVClass
@@ -53,12 +53,14 @@
 #include "gsteffectv.h"
 
 #define DEFAULT_MODE 0
+#define DEFAULT_N_THREADS 1
 
 enum
 {
   PROP_0,
   PROP_RESET,
-  PROP_MODE
+  PROP_MODE,
+  PROP_N_THREADS
 };
 
 static gint sqrtable[256];
@@ -309,6 +311,60 @@ raindrop (GstRippleTV * filter)
   filter->period--;
 }
 
+typedef struct
+{
+  GstRippleTV *filter;
+  const guint32 *src;
+  guint32 *dest;
+  gint v_w, v_h;
+} GstRippleTVSliceData;
+
+/* Draws the refracted image for the pairs of rows from y_start to y_end,
+ * the vector table is stretched */
+static void
+gst_rippletv_draw_rows (gpointer data, gint y_start, gint y_end)
+{
+  GstRippleTVSliceData *d = data;
+  const guint32 *src = d->src;
+  guint32 *dest;
+  const gint8 *vp;
+  gint x, y, h, v, dx, dy, o_dx;
+  gint v_w = d->v_w, v_h = d->v_h, m_w = d->filter->map_w;
+  gint cols = (v_w + 1) / 2;
+
+  /* every pair of rows uses cols + 1 vectors and cols * 2 + v_w pixels */
+  vp = d->filter->vtable + y_start * (cols + 1) * 2;
+  dest = d->dest + y_start * (cols * 2 + v_w);
+
+  for (y = y_start * 2; y < y_end * 2; y += 2) {
+    for (x = 0; x < v_w; x += 2) {
+      h = (gint) vp[0];
+      v = (gint) vp[1];
+      dx = x + h;
+      dy = y + v;
+      dx = CLAMP (dx, 0, (v_w - 2));
+      dy = CLAMP (dy, 0, (v_h - 2));
+      dest[0] = src[dy * v_w + dx];
+
+      o_dx = dx;
+
+      dx = x + 1 + (h + (gint) vp[2]) / 2;
+      dx = CLAMP (dx, 0, (v_w - 2));
+      dest[1] = src[dy * v_w + dx];
+
+      dy = y + 1 + (v + (gint) vp[m_w * 2 + 1]) / 2;
+      dy = CLAMP (dy, 0, (v_h - 2));
+      dest[v_w] = src[dy * v_w + o_dx];
+
+      dest[v_w + 1] = src[dy * v_w + dx];
+      dest += 2;
+      vp += 2;
+    }
+    dest += v_w;
+    vp += 2;
+  }
+}
+
 static GstFlowReturn
 gst_rippletv_transform_frame (GstVideoFilter * vfilter,
     GstVideoFrame * in_frame, GstVideoFrame * out_frame)
@@ -316,11 +372,11 @@ gst_rippletv_transform_frame (GstVideoFilter * vfilter,
   GstRippleTV *filter = GST_RIPPLETV (vfilter);
   guint32 *src, *dest;
   gint x, y, i;
-  gint dx, dy, o_dx;
   gint h, v;
   gint m_w, m_h, v_w, v_h;
   gint *p, *q, *r;
   gint8 *vp;
+  GstRippleTVSliceData data;
   GstClockTime timestamp, stream_time;
 
   timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
@@ -409,36 +465,13 @@ gst_rippletv_transform_frame (GstVideoFilter * vfilter,
     vp += 2;
   }
 
-  vp = filter->vtable;
-
-  /* draw refracted image. The vector table is stretched. */
-  for (y = 0; y < v_h; y += 2) {
-    for (x = 0; x < v_w; x += 2) {
-      h = (gint) vp[0];
-      v = (gint) vp[1];
-      dx = x + h;
-      dy = y + v;
-      dx = CLAMP (dx, 0, (v_w - 2));
-      dy = CLAMP (dy, 0, (v_h - 2));
-      dest[0] = src[dy * v_w + dx];
-
-      o_dx = dx;
-
-      dx = x + 1 + (h + (gint) vp[2]) / 2;
-      dx = CLAMP (dx, 0, (v_w - 2));
-      dest[1] = src[dy * v_w + dx];
-
-      dy = y + 1 + (v + (gint) vp[m_w * 2 + 1]) / 2;
-      dy = CLAMP (dy, 0, (v_h - 2));
-      dest[v_w] = src[dy * v_w + o_dx];
-
-      dest[v_w + 1] = src[dy * v_w + dx];
-      dest += 2;
-      vp += 2;
-    }
-    dest += v_w;
-    vp += 2;
-  }
+  data.filter = filter;
+  data.src = src;
+  data.dest = dest;
+  data.v_w = v_w;
+  data.v_h = v_h;
+  gst_effectv_slices_run (&filter->slices, filter->n_threads, (v_h + 1) / 2,
+      gst_rippletv_draw_rows, &data);
   GST_OBJECT_UNLOCK (filter);
 
   return GST_FLOW_OK;
@@ -523,6 +556,8 @@ gst_rippletv_finalize (GObject * object)
     g_free (filter->diff);
   filter->diff = NULL;
 
+  gst_effectv_slices_clear (&filter->slices);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -542,6 +577,9 @@ gst_rippletv_set_property (GObject * object, guint prop_id,
     case PROP_MODE:
       filter->mode = g_value_get_enum (value);
       break;
+    case PROP_N_THREADS:
+      filter->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -559,6 +597,9 @@ gst_rippletv_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_MODE:
       g_value_set_enum (value, filter->mode);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, filter->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -588,6 +629,20 @@ gst_rippletv_class_init (GstRippleTVClass * klass)
           "Mode", GST_TYPE_RIPPLETV_MODE, DEFAULT_MODE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_CONTROLLABLE));
 
+  /**
+   * GstRippleTV:n-threads:
+   *
+   * Number of threads used to draw a frame, each one handles a slice of
+   * the rows. 0 uses one thread per processor.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Maximum number of threads used to process a frame "
+          "(0 = number of processors)", 0, G_MAXUINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "RippleTV effect",
       "Filter/Effect/Video",
       "RippleTV does ripple mark effect on the video input",
@@ -612,6 +667,8 @@ static void
 gst_rippletv_init (GstRippleTV * filter)
 {
   filter->mode = DEFAULT_MODE;
+  filter->n_threads = DEFAULT_N_THREADS;
+  gst_effectv_slices_init (&filter->slices);
 
   /* FIXME: remove this when memory corruption after resizes are fixed */
   gst_pad_use_fixed_caps (GST_BASE_TRANSFORM_SRC_PAD (filter));
@@ -32,6 +32,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include "gsteffectv.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_RIPPLETV \
@@ -72,6 +74,9 @@ struct _GstRippleTV
   gint drops_per_frame_max;
   gint drops_per_frame;
   gint drop_power;
+
+  guint n_threads;
+  GstEffectvSlices slices;
 };
 
 struct _GstRippleTVClass
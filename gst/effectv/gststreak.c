@@ -51,12 +51,19 @@
 #include "gststreak.h"
 #include "gsteffectv.h"
 
+#if defined(__SSE2__)
+#define HAVE_STREAKTV_SSE2 1
+#include <emmintrin.h>
+#endif
+
 #define DEFAULT_FEEDBACK FALSE
+#define DEFAULT_N_THREADS 1
 
 enum
 {
   PROP_0,
-  PROP_FEEDBACK
+  PROP_FEEDBACK,
+  PROP_N_THREADS
 };
 
 #define gst_streaktv_parent_class parent_class
@@ -77,65 +84,119 @@ GST_STATIC_PAD_TEMPLATE ("sink",
     );
 
 
-static GstFlowReturn
-gst_streaktv_transform_frame (GstVideoFilter * vfilter,
-    GstVideoFrame * in_frame, GstVideoFrame * out_frame)
+typedef struct
 {
-  GstStreakTV *filter = GST_STREAKTV (vfilter);
-  guint32 *src, *dest;
-  gint i, cf;
-  gint video_area, width, height;
-  guint32 **planetable = filter->planetable;
-  gint plane = filter->plane;
-  guint stride_mask, stride_shift, stride;
-
-  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
+  GstStreakTV *filter;
+  const guint32 *src;
+  guint32 *dest;
+  gint width;
+  gint plane;
+  gboolean feedback;
+} GstStreakTVSliceData;
 
-  width = GST_VIDEO_FRAME_WIDTH (in_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (in_frame);
-
-  video_area = width * height;
+static void
+gst_streaktv_process_rows (gpointer data, gint y_start, gint y_end)
+{
+  GstStreakTVSliceData *d = data;
+  guint32 **planetable = d->filter->planetable;
+  const guint32 *src;
+  guint32 *dest, *cur;
+  const guint32 *planes[8];
+  gint i, k, n, cf, start, end;
+  guint stride_mask, stride_shift, stride;
 
-  GST_OBJECT_LOCK (filter);
-  if (filter->feedback) {
+  if (d->feedback) {
     stride_mask = 0xfcfcfcfc;
     stride = 8;
     stride_shift = 2;
+    n = 4;
   } else {
     stride_mask = 0xf8f8f8f8;
     stride = 4;
     stride_shift = 3;
+    n = 8;
   }
 
-  for (i = 0; i < video_area; i++) {
-    planetable[plane][i] = (src[i] & stride_mask) >> stride_shift;
+  /* the planes of the older frames that are summed up, the current plane is
+   * one of them */
+  cf = d->plane & (stride - 1);
+  for (k = 0; k < n; k++)
+    planes[k] = planetable[cf + stride * k];
+
+  start = y_start * d->width;
+  end = y_end * d->width;
+  src = d->src;
+  dest = d->dest;
+  cur = planetable[d->plane];
+  i = start;
+
+#ifdef HAVE_STREAKTV_SSE2
+  {
+    const __m128i mask = _mm_set1_epi32 (stride_mask);
+    const __m128i shift = _mm_cvtsi32_si128 (stride_shift);
+
+    /* each component of the planes is small enough that the sum does not
+     * overflow into the next one */
+    for (; i + 4 <= end; i += 4) {
+      __m128i v, sum;
+
+      v = _mm_loadu_si128 ((const __m128i *) (src + i));
+      v = _mm_srl_epi32 (_mm_and_si128 (v, mask), shift);
+      _mm_storeu_si128 ((__m128i *) (cur + i), v);
+
+      sum = _mm_loadu_si128 ((const __m128i *) (planes[0] + i));
+      for (k = 1; k < n; k++)
+        sum = _mm_add_epi32 (sum,
+            _mm_loadu_si128 ((const __m128i *) (planes[k] + i)));
+      _mm_storeu_si128 ((__m128i *) (dest + i), sum);
+
+      if (d->feedback) {
+        v = _mm_srl_epi32 (_mm_and_si128 (sum, mask), shift);
+        _mm_storeu_si128 ((__m128i *) (cur + i), v);
+      }
+    }
   }
+#endif
 
-  cf = plane & (stride - 1);
-  if (filter->feedback) {
-    for (i = 0; i < video_area; i++) {
-      dest[i] = planetable[cf][i]
-          + planetable[cf + stride][i]
-          + planetable[cf + stride * 2][i]
-          + planetable[cf + stride * 3][i];
-      planetable[plane][i] = (dest[i] & stride_mask) >> stride_shift;
-    }
-  } else {
-    for (i = 0; i < video_area; i++) {
-      dest[i] = planetable[cf][i]
-          + planetable[cf + stride][i]
-          + planetable[cf + stride * 2][i]
-          + planetable[cf + stride * 3][i]
-          + planetable[cf + stride * 4][i]
-          + planetable[cf + stride * 5][i]
-          + planetable[cf + stride * 6][i]
-          + planetable[cf + stride * 7][i];
-    }
+  for (; i < end; i++) {
+    guint32 sum;
+
+    cur[i] = (src[i] & stride_mask) >> stride_shift;
+
+    sum = planes[0][i];
+    for (k = 1; k < n; k++)
+      sum += planes[k][i];
+    dest[i] = sum;
+
+    if (d->feedback)
+      cur[i] = (sum & stride_mask) >> stride_shift;
   }
+}
+
+static GstFlowReturn
+gst_streaktv_transform_frame (GstVideoFilter * vfilter,
+    GstVideoFrame * in_frame, GstVideoFrame * out_frame)
+{
+  GstStreakTV *filter = GST_STREAKTV (vfilter);
+  GstStreakTVSliceData data;
+  gint height;
+
+  data.filter = filter;
+  data.src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
+  data.dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
 
-  plane++;
-  filter->plane = plane & (PLANES - 1);
+  data.width = GST_VIDEO_FRAME_WIDTH (in_frame);
+  height = GST_VIDEO_FRAME_HEIGHT (in_frame);
+
+  GST_OBJECT_LOCK (filter);
+  data.plane = filter->plane;
+  data.feedback = filter->feedback;
+
+  /* every pixel only depends on the same pixel of the older frames */
+  gst_effectv_slices_run (&filter->slices, filter->n_threads, height,
+      gst_streaktv_process_rows, &data);
+
+  filter->plane = (filter->plane + 1) & (PLANES - 1);
   GST_OBJECT_UNLOCK (filter);
 
   return GST_FLOW_OK;
@@ -182,6 +243,8 @@ gst_streaktv_finalize (GObject * object)
     filter->planebuffer = NULL;
   }
 
+  gst_effectv_slices_clear (&filter->slices);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -201,6 +264,11 @@ gst_streaktv_set_property (GObject * object, guint prop_id,
 
       filter->feedback = g_value_get_boolean (value);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      filter->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -217,6 +285,9 @@ gst_streaktv_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_FEEDBACK:
       g_value_set_boolean (value, filter->feedback);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, filter->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -241,6 +312,20 @@ gst_streaktv_class_init (GstStreakTVClass * klass)
           "Feedback", DEFAULT_FEEDBACK,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstStreakTV:n-threads:
+   *
+   * Number of threads used to process a frame, each one handles a slice of
+   * the rows. 0 uses one thread per processor.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Maximum number of threads used to process a frame "
+          "(0 = number of processors)", 0, G_MAXUINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "StreakTV effect",
       "Filter/Effect/Video",
       "StreakTV makes after images of moving objects",
@@ -263,4 +348,6 @@ static void
 gst_streaktv_init (GstStreakTV * filter)
 {
   filter->feedback = DEFAULT_FEEDBACK;
+  filter->n_threads = DEFAULT_N_THREADS;
+  gst_effectv_slices_init (&filter->slices);
 }
@@ -32,6 +32,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include "gsteffectv.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_STREAKTV \
@@ -60,6 +62,9 @@ struct _GstStreakTV
   guint32 *planebuffer;
   guint32 *planetable[PLANES];
   gint plane;
+
+  guint n_threads;
+  GstEffectvSlices slices;
 };
 
 struct _GstStreakTVClass
@@ -43,6 +43,11 @@
 
 #include "gstvertigo.h"
 
+#if defined(__SSE2__)
+#define HAVE_VERTIGO_SSE2 1
+#include <emmintrin.h>
+#endif
+
 #define gst_vertigotv_parent_class parent_class
 G_DEFINE_TYPE (GstVertigoTV, gst_vertigotv, GST_TYPE_VIDEO_FILTER);
 
@@ -51,9 +56,12 @@ enum
 {
   PROP_0,
   PROP_SPEED,
-  PROP_ZOOM_SPEED
+  PROP_ZOOM_SPEED,
+  PROP_N_THREADS
 };
 
+#define DEFAULT_N_THREADS 1
+
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
 #define CAPS_STR GST_VIDEO_CAPS_MAKE ("{ RGBx, BGRx }")
 #else
@@ -151,14 +159,91 @@ gst_vertigotv_set_parms (GstVertigoTV * filter)
     filter->phase = 0;
 }
 
+typedef struct
+{
+  const guint32 *src;
+  guint32 *dest;
+  const guint32 *current;
+  guint32 *alt;
+  gint sstride, dstride;
+  gint width, height;
+  gint sx, sy, dx, dy;
+} GstVertigoTVSliceData;
+
+/* Each output row only depends on the input and on the previous output, so
+ * the rows can be done in parallel */
+static void
+gst_vertigotv_process_rows (gpointer data, gint y_start, gint y_end)
+{
+  GstVertigoTVSliceData *d = data;
+  const guint32 *src, *current = d->current;
+  guint32 *dest, *p;
+  guint32 v;
+  gint x, y, ox, oy, i, width = d->width, area = d->width * d->height;
+
+  src = d->src + y_start * d->sstride;
+  dest = d->dest + y_start * d->dstride;
+  p = d->alt + y_start * width;
+
+  for (y = y_start; y < y_end; y++) {
+    ox = d->sx - y * d->dy;
+    oy = d->sy + y * d->dx;
+    x = 0;
+
+#ifdef HAVE_VERTIGO_SSE2
+    {
+      const __m128i mask = _mm_set1_epi32 (0xfcfcff);
+
+      for (; x + 4 <= width; x += 4) {
+        guint32 c[4];
+        __m128i vc, vs;
+        gint k;
+
+        for (k = 0; k < 4; k++) {
+          i = (oy >> 16) * width + (ox >> 16);
+          i = CLAMP (i, 0, area - 1);
+          c[k] = current[i];
+          ox += d->dx;
+          oy += d->dy;
+        }
+
+        vc = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) c), mask);
+        vs = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (src + x)),
+            mask);
+        vc = _mm_add_epi32 (_mm_add_epi32 (_mm_slli_epi32 (vc, 1), vc), vs);
+        vc = _mm_srli_epi32 (vc, 2);
+        _mm_storeu_si128 ((__m128i *) (dest + x), vc);
+        _mm_storeu_si128 ((__m128i *) (p + x), vc);
+      }
+    }
+#endif
+
+    for (; x < width; x++) {
+      i = (oy >> 16) * width + (ox >> 16);
+      i = CLAMP (i, 0, area - 1);
+
+      v = current[i] & 0xfcfcff;
+      v = (v * 3) + (src[x] & 0xfcfcff);
+
+      p[x] = dest[x] = (v >> 2);
+      ox += d->dx;
+      oy += d->dy;
+    }
+
+    src += d->sstride;
+    dest += d->dstride;
+    p += width;
+  }
+}
+
 static GstFlowReturn
 gst_vertigotv_transform_frame (GstVideoFilter * vfilter,
     GstVideoFrame * in_frame, GstVideoFrame * out_frame)
 {
   GstVertigoTV *filter = GST_VERTIGOTV (vfilter);
-  guint32 *src, *dest, *p;
-  guint32 v;
-  gint x, y, ox, oy, i, width, height, area, sstride, dstride;
+  GstVertigoTVSliceData data;
+  guint32 *p;
+  guint n_threads;
   GstClockTime timestamp, stream_time;
 
   timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
@@ -172,46 +257,32 @@ gst_vertigotv_transform_frame (GstVideoFilter * vfilter,
   if (GST_CLOCK_TIME_IS_VALID (stream_time))
     gst_object_sync_values (GST_OBJECT (filter), stream_time);
 
-  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  sstride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0);
-  dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-  dstride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
+  data.src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
+  data.sstride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0) / 4;
+  data.dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
+  data.dstride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0) / 4;
 
-  width = GST_VIDEO_FRAME_WIDTH (in_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (in_frame);
-
-  area = width * height;
-
-  sstride /= 4;
-  dstride /= 4;
+  data.width = GST_VIDEO_FRAME_WIDTH (in_frame);
+  data.height = GST_VIDEO_FRAME_HEIGHT (in_frame);
 
   gst_vertigotv_set_parms (filter);
-  p = filter->alt_buffer;
-
-  for (y = 0; y < height; y++) {
-    ox = filter->sx;
-    oy = filter->sy;
 
-    for (x = 0; x < width; x++) {
-      i = (oy >> 16) * width + (ox >> 16);
-      if (i < 0)
-        i = 0;
-      if (i >= area)
-        i = area;
+  data.current = filter->current_buffer;
+  data.alt = filter->alt_buffer;
+  data.sx = filter->sx;
+  data.sy = filter->sy;
+  data.dx = filter->dx;
+  data.dy = filter->dy;
 
-      v = filter->current_buffer[i] & 0xfcfcff;
-      v = (v * 3) + (src[x] & 0xfcfcff);
+  GST_OBJECT_LOCK (filter);
+  n_threads = filter->n_threads;
+  GST_OBJECT_UNLOCK (filter);
 
-      *p++ = dest[x] = (v >> 2);
-      ox += filter->dx;
-      oy += filter->dy;
-    }
-    filter->sx -= filter->dy;
-    filter->sy += filter->dx;
+  gst_effectv_slices_run (&filter->slices, n_threads, data.height,
+      gst_vertigotv_process_rows, &data);
 
-    src += sstride;
-    dest += dstride;
-  }
+  filter->sx -= data.height * filter->dy;
+  filter->sy += data.height * filter->dx;
 
   p = filter->current_buffer;
   filter->current_buffer = filter->alt_buffer;
@@ -244,6 +315,9 @@ gst_vertigotv_set_property (GObject * object, guint prop_id,
     case PROP_ZOOM_SPEED:
       filter->zoomrate = g_value_get_float (value);
       break;
+    case PROP_N_THREADS:
+      filter->n_threads = g_value_get_uint (value);
+      break;
     default:
       break;
   }
@@ -263,6 +337,9 @@ gst_vertigotv_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_ZOOM_SPEED:
       g_value_set_float (value, filter->zoomrate);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, filter->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -277,6 +354,8 @@ gst_vertigotv_finalize (GObject * object)
   g_free (filter->buffer);
   filter->buffer = NULL;
 
+  gst_effectv_slices_clear (&filter->slices);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -300,6 +379,20 @@ gst_vertigotv_class_init (GstVertigoTVClass * klass)
           "Control the rate of zooming", 1.01, 1.1, 1.01,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstVertigoTV:n-threads:
+   *
+   * Number of threads used to process a frame, each one handles a slice of
+   * the rows. 0 uses one thread per processor.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Maximum number of threads used to process a frame "
+          "(0 = number of processors)", 0, G_MAXUINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "VertigoTV effect",
       "Filter/Effect/Video",
       "A loopback alpha blending effector with rotating and scaling",
@@ -324,4 +417,6 @@ gst_vertigotv_init (GstVertigoTV * filter)
   filter->phase = 0.0;
   filter->phase_increment = 0.02;
   filter->zoomrate = 1.01;
+  filter->n_threads = DEFAULT_N_THREADS;
+  gst_effectv_slices_init (&filter->slices);
 }
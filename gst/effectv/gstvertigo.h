@@ -29,6 +29,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include "gsteffectv.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_VERTIGOTV \
@@ -57,6 +59,9 @@ struct _GstVertigoTV
   gdouble phase;
   gdouble phase_increment;
   gdouble zoomrate;
+
+  guint n_threads;
+  GstEffectvSlices slices;
 };
 
 struct _GstVertigoTVClass
@@ -61,6 +61,14 @@
 #define M_PI    3.14159265358979323846
 #endif
 
+#define DEFAULT_N_THREADS 1
+
+enum
+{
+  PROP_0,
+  PROP_N_THREADS
+};
+
 #define gst_warptv_parent_class parent_class
 G_DEFINE_TYPE (GstWarpTV, gst_warptv, GST_TYPE_VIDEO_FILTER);
 
@@ -138,27 +146,73 @@ initDistTable (GstWarpTV * filter, gint width, gint height)
 #endif
 }
 
+typedef struct
+{
+  GstWarpTV *warptv;
+  const guint32 *src;
+  guint32 *dest;
+  gint sstride, dstride;
+  gint width, height;
+} GstWarpTVSliceData;
+
+static void
+gst_warptv_process_rows (gpointer data, gint y_start, gint y_end)
+{
+  GstWarpTVSliceData *d = data;
+  const gint32 *ctable = d->warptv->ctable;
+  const gint32 *distptr;
+  const guint32 *src = d->src;
+  guint32 *dest;
+  gint32 i, x, y, dx, dy, maxx, maxy;
+  gint width = d->width;
+
+  maxx = width - 2;
+  maxy = d->height - 2;
+
+  distptr = d->warptv->disttable + y_start * width;
+  dest = d->dest + y_start * d->dstride;
+
+  for (y = y_start; y < y_end; y++) {
+    for (x = 0; x < width; x++) {
+      i = *distptr++;
+      dx = ctable[i + 1] + x;
+      dy = ctable[i] + y;
+
+      if (dx < 0)
+        dx = 0;
+      else if (dx > maxx)
+        dx = maxx;
+
+      if (dy < 0)
+        dy = 0;
+      else if (dy > maxy)
+        dy = maxy;
+
+      dest[x] = src[dy * d->sstride + dx];
+    }
+    dest += d->dstride;
+  }
+}
+
 static GstFlowReturn
 gst_warptv_transform_frame (GstVideoFilter * filter, GstVideoFrame * in_frame,
     GstVideoFrame * out_frame)
 {
   GstWarpTV *warptv = GST_WARPTV (filter);
-  gint width, height;
+  GstWarpTVSliceData data;
   gint xw, yw, cw;
-  gint32 c, i, x, y, dx, dy, maxx, maxy;
-  gint32 *ctptr, *distptr;
-  gint32 *ctable;
-  guint32 *src, *dest;
-  gint sstride, dstride;
+  gint32 c, i, x;
+  gint32 *ctptr;
 
-  src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
+  data.warptv = warptv;
+  data.src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
+  data.dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
 
-  sstride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0);
-  dstride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
+  data.sstride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0) / 4;
+  data.dstride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0) / 4;
 
-  width = GST_VIDEO_FRAME_WIDTH (in_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (in_frame);
+  data.width = GST_VIDEO_FRAME_WIDTH (in_frame);
+  data.height = GST_VIDEO_FRAME_HEIGHT (in_frame);
 
   GST_OBJECT_LOCK (warptv);
   xw = (gint) (sin ((warptv->tval + 100) * M_PI / 128) * 30);
@@ -168,8 +222,6 @@ gst_warptv_transform_frame (GstVideoFilter * filter, GstVideoFrame * in_frame,
   yw += (gint) (sin ((warptv->tval + 30) * M_PI / 512) * 40);
 
   ctptr = warptv->ctable;
-  distptr = warptv->disttable;
-  ctable = warptv->ctable;
 
   c = 0;
 
@@ -179,29 +231,11 @@ gst_warptv_transform_frame (GstVideoFilter * filter, GstVideoFrame * in_frame,
     *ctptr++ = ((sintable[i + 256] * xw) >> 15);
     c += cw;
   }
-  maxx = width - 2;
-  maxy = height - 2;
-
-  for (y = 0; y < height - 1; y++) {
-    for (x = 0; x < width; x++) {
-      i = *distptr++;
-      dx = ctable[i + 1] + x;
-      dy = ctable[i] + y;
-
-      if (dx < 0)
-        dx = 0;
-      else if (dx > maxx)
-        dx = maxx;
 
-      if (dy < 0)
-        dy = 0;
-      else if (dy > maxy)
-        dy = maxy;
-
-      dest[x] = src[dy * sstride / 4 + dx];
-    }
-    dest += dstride / 4;
-  }
+  /* the rows only read the input and the tables, so they can be done in
+   * parallel */
+  gst_effectv_slices_run (&warptv->slices, warptv->n_threads,
+      data.height - 1, gst_warptv_process_rows, &data);
 
   warptv->tval = (warptv->tval + 1) & 511;
   GST_OBJECT_UNLOCK (warptv);
@@ -227,9 +261,47 @@ gst_warptv_finalize (GObject * object)
   g_free (warptv->disttable);
   warptv->disttable = NULL;
 
+  gst_effectv_slices_clear (&warptv->slices);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_warptv_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstWarpTV *warptv = GST_WARPTV (object);
+
+  GST_OBJECT_LOCK (warptv);
+  switch (prop_id) {
+    case PROP_N_THREADS:
+      warptv->n_threads = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (warptv);
+}
+
+static void
+gst_warptv_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstWarpTV *warptv = GST_WARPTV (object);
+
+  GST_OBJECT_LOCK (warptv);
+  switch (prop_id) {
+    case PROP_N_THREADS:
+      g_value_set_uint (value, warptv->n_threads);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (warptv);
+}
+
 static void
 gst_warptv_class_init (GstWarpTVClass * klass)
 {
@@ -238,8 +310,24 @@ gst_warptv_class_init (GstWarpTVClass * klass)
   GstBaseTransformClass *trans_class = (GstBaseTransformClass *) klass;
   GstVideoFilterClass *vfilter_class = (GstVideoFilterClass *) klass;
 
+  gobject_class->set_property = gst_warptv_set_property;
+  gobject_class->get_property = gst_warptv_get_property;
   gobject_class->finalize = gst_warptv_finalize;
 
+  /**
+   * GstWarpTV:n-threads:
+   *
+   * Number of threads used to process a frame, each one handles a slice of
+   * the rows. 0 uses one thread per processor.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Maximum number of threads used to process a frame "
+          "(0 = number of processors)", 0, G_MAXUINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "WarpTV effect",
       "Filter/Effect/Video",
       "WarpTV does realtime goo'ing of the video input",
@@ -262,5 +350,6 @@ gst_warptv_class_init (GstWarpTVClass * klass)
 static void
 gst_warptv_init (GstWarpTV * warptv)
 {
-  /* nothing to do */
+  warptv->n_threads = DEFAULT_N_THREADS;
+  gst_effectv_slices_init (&warptv->slices);
 }
@@ -29,6 +29,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include "gsteffectv.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_WARPTV \
@@ -53,6 +55,9 @@ struct _GstWarpTV
   gint32 *disttable;
   gint32 ctable[1024];
   gint tval;
+
+  guint n_threads;
+  GstEffectvSlices slices;
 };
 
 struct _GstWarpTVClass
@@ -132,6 +132,18 @@ struct _GstIirEqualizerBand
   /* second order iir filter */
   gdouble b1, b2;               /* IIR coefficients for outputs */
   gdouble a0, a1, a2;           /* IIR coefficients for inputs */
+
+  /* coefficients before the last change, the next buffer interpolates
+   * from them to the new ones */
+  gdouble prev_b1, prev_b2;
+  gdouble prev_a0, prev_a1, prev_a2;
+  gboolean interpolate;
+
+  /* the filter doesn't change the signal and is skipped */
+  gboolean identity;
+
+  /* properties changed since the coefficients were calculated */
+  gboolean changed;
 };
 
 struct _GstIirEqualizerBandClass
@@ -158,6 +170,7 @@ gst_iir_equalizer_band_set_property (GObject * object, guint prop_id,
       if (gain != band->gain) {
         BANDS_LOCK (equ);
         equ->need_new_coefficients = TRUE;
+        band->changed = TRUE;
         band->gain = gain;
         BANDS_UNLOCK (equ);
         GST_DEBUG_OBJECT (band, "changed gain = %lf ", band->gain);
@@ -172,6 +185,7 @@ gst_iir_equalizer_band_set_property (GObject * object, guint prop_id,
       if (freq != band->freq) {
         BANDS_LOCK (equ);
         equ->need_new_coefficients = TRUE;
+        band->changed = TRUE;
         band->freq = freq;
         BANDS_UNLOCK (equ);
         GST_DEBUG_OBJECT (band, "changed freq = %lf ", band->freq);
@@ -186,6 +200,7 @@ gst_iir_equalizer_band_set_property (GObject * object, guint prop_id,
       if (width != band->width) {
         BANDS_LOCK (equ);
         equ->need_new_coefficients = TRUE;
+        band->changed = TRUE;
         band->width = width;
         BANDS_UNLOCK (equ);
         GST_DEBUG_OBJECT (band, "changed width = %lf ", band->width);
@@ -200,6 +215,7 @@ gst_iir_equalizer_band_set_property (GObject * object, guint prop_id,
       if (type != band->type) {
         BANDS_LOCK (equ);
         equ->need_new_coefficients = TRUE;
+        band->changed = TRUE;
         band->type = type;
         BANDS_UNLOCK (equ);
         GST_DEBUG_OBJECT (band, "changed type = %d ", band->type);
@@ -280,6 +296,10 @@ gst_iir_equalizer_band_init (GstIirEqualizerBand * band,
   band->gain = 0.0;
   band->width = 1.0;
   band->type = BAND_TYPE_PEAK;
+
+  band->a0 = 1.0;
+  band->identity = TRUE;
+  band->changed = TRUE;
 }
 
 static GType
@@ -390,6 +410,7 @@ gst_iir_equalizer_finalize (GObject * object)
 
   g_free (equ->bands);
   g_free (equ->history);
+  g_free (equ->scratch);
 
   g_mutex_clear (&equ->bands_lock);
 
@@ -599,26 +620,56 @@ update_coefficients (GstIirEqualizer * equ)
   gint i, n = equ->freq_band_count;
 
   for (i = 0; i < n; i++) {
-    if (equ->bands[i]->type == BAND_TYPE_PEAK)
-      setup_peak_filter (equ, equ->bands[i]);
-    else if (equ->bands[i]->type == BAND_TYPE_LOW_SHELF)
-      setup_low_shelf_filter (equ, equ->bands[i]);
+    GstIirEqualizerBand *band = equ->bands[i];
+
+    if (!band->changed)
+      continue;
+
+    band->prev_a0 = band->a0;
+    band->prev_a1 = band->a1;
+    band->prev_a2 = band->a2;
+    band->prev_b1 = band->b1;
+    band->prev_b2 = band->b2;
+
+    if (band->type == BAND_TYPE_PEAK)
+      setup_peak_filter (equ, band);
+    else if (band->type == BAND_TYPE_LOW_SHELF)
+      setup_low_shelf_filter (equ, band);
     else
-      setup_high_shelf_filter (equ, equ->bands[i]);
+      setup_high_shelf_filter (equ, band);
+
+    /* the filters are exactly the identity for 0 dB gain or no width */
+    band->identity = (band->a0 == 1.0 && band->a1 == -band->b1 &&
+        band->a2 == -band->b2);
+    band->interpolate = equ->interpolate &&
+        (band->a0 != band->prev_a0 || band->a1 != band->prev_a1 ||
+        band->a2 != band->prev_a2 || band->b1 != band->prev_b1 ||
+        band->b2 != band->prev_b2);
+    band->changed = FALSE;
   }
 
+  equ->interpolate = TRUE;
   equ->need_new_coefficients = FALSE;
 }
 
-/* Must be called with transform lock! */
+/* Must be called with bands_lock and transform lock! */
 static void
 alloc_history (GstIirEqualizer * equ, const GstAudioInfo * info)
 {
+  guint i;
+
   /* free + alloc = no memcpy */
   g_free (equ->history);
   equ->history =
       g_malloc0 (equ->history_size * GST_AUDIO_INFO_CHANNELS (info) *
       equ->freq_band_count);
+
+  /* the rate might have changed and there's nothing to interpolate
+   * from with a cleared history */
+  for (i = 0; i < equ->freq_band_count; i++)
+    equ->bands[i]->changed = TRUE;
+  equ->need_new_coefficients = TRUE;
+  equ->interpolate = FALSE;
 }
 
 void
@@ -711,109 +762,172 @@ gst_iir_equalizer_compute_frequencies (GstIirEqualizer * equ, guint new_count)
 
 /* start of code that is type specific */
 
-#define CREATE_OPTIMIZED_FUNCTIONS_INT(TYPE,BIG_TYPE,MIN_VAL,MAX_VAL)   \
+/* History values below this are flushed to zero after every buffer */
+#define DENORMAL_THRESHOLD 1e-20
+
+/* The history is stored per band for all channels. Every band is run over
+ * the whole buffer before the next one so its coefficients stay in
+ * registers and the inner loop over the channels can be vectorized by the
+ * compiler.
+ *
+ * Bands that don't change the signal are skipped, their history is set to
+ * what an identity filter would have seen so that they can start again
+ * without a click. Changed coefficients are interpolated linearly over
+ * the first buffer they are used for to avoid zipper noise. */
+
+#define CREATE_OPTIMIZED_FUNCTIONS(TYPE)                                \
 typedef struct {                                                        \
-  BIG_TYPE x1, x2;          /* history of input values for a filter */  \
-  BIG_TYPE y1, y2;          /* history of output values for a filter */ \
+  TYPE x1, x2;          /* history of input values for a filter */      \
+  TYPE y1, y2;          /* history of output values for a filter */     \
 } SecondOrderHistory ## TYPE;                                           \
                                                                         \
-static inline BIG_TYPE                                                  \
-one_step_ ## TYPE (GstIirEqualizerBand *filter,                         \
-    SecondOrderHistory ## TYPE *history, BIG_TYPE input)                \
+static const guint                                                      \
+history_size_ ## TYPE = sizeof (SecondOrderHistory ## TYPE);            \
+                                                                        \
+/* decaying filters would otherwise calculate with denormals */         \
+static void                                                             \
+flush_denormals_ ## TYPE (gpointer data, guint n)                       \
 {                                                                       \
-  /* calculate output */                                                \
-  BIG_TYPE output = filter->a0 * input +                                \
-      filter->a1 * history->x1 + filter->a2 * history->x2 +             \
-      filter->b1 * history->y1 + filter->b2 * history->y2;              \
-  /* update history */                                                  \
-  history->y2 = history->y1;                                            \
-  history->y1 = output;                                                 \
-  history->x2 = history->x1;                                            \
-  history->x1 = input;                                                  \
+  SecondOrderHistory ## TYPE *history = data;                           \
+  guint i;                                                              \
                                                                         \
-  return output;                                                        \
+  for (i = 0; i < n; i++) {                                             \
+    if (fabs (history[i].x1) < DENORMAL_THRESHOLD)                      \
+      history[i].x1 = 0;                                                \
+    if (fabs (history[i].x2) < DENORMAL_THRESHOLD)                      \
+      history[i].x2 = 0;                                                \
+    if (fabs (history[i].y1) < DENORMAL_THRESHOLD)                      \
+      history[i].y1 = 0;                                                \
+    if (fabs (history[i].y2) < DENORMAL_THRESHOLD)                      \
+      history[i].y2 = 0;                                                \
+  }                                                                     \
 }                                                                       \
                                                                         \
-static const guint                                                      \
-history_size_ ## TYPE = sizeof (SecondOrderHistory ## TYPE);            \
+static void                                                             \
+skip_band_ ## TYPE (SecondOrderHistory ## TYPE *history,                \
+    const TYPE *samples, guint frames, guint channels)                  \
+{                                                                       \
+  const TYPE *last = samples + (frames - 1) * channels;                 \
+  const TYPE *prev = last - channels;                                   \
+  guint c;                                                              \
+                                                                        \
+  for (c = 0; c < channels; c++) {                                      \
+    if (frames > 1)                                                     \
+      history[c].x2 = history[c].y2 = prev[c];                          \
+    else                                                                \
+      history[c].x2 = history[c].y2 = history[c].y1;                    \
+    history[c].x1 = history[c].y1 = last[c];                            \
+  }                                                                     \
+}                                                                       \
                                                                         \
 static void                                                             \
-gst_iir_equ_process_ ## TYPE (GstIirEqualizer *equ, guint8 *data,       \
-guint size, guint channels)                                             \
+gst_iir_equ_process_bands_ ## TYPE (GstIirEqualizer *equ,              \
+    TYPE *samples, guint frames, guint channels)                        \
 {                                                                       \
-  guint frames = size / channels / sizeof (TYPE);                       \
   guint i, c, f, nf = equ->freq_band_count;                             \
-  BIG_TYPE cur;                                                         \
-  GstIirEqualizerBand **filters = equ->bands;                           \
                                                                         \
-  for (i = 0; i < frames; i++) {                                        \
-    SecondOrderHistory ## TYPE *history = equ->history;                 \
-    for (c = 0; c < channels; c++) {                                    \
-      cur = *((TYPE *) data);                                           \
-      for (f = 0; f < nf; f++) {                                        \
-        cur = one_step_ ## TYPE (filters[f], history, cur);             \
-        history++;                                                      \
+  if (frames == 0)                                                      \
+    return;                                                             \
+                                                                        \
+  for (f = 0; f < nf; f++) {                                            \
+    GstIirEqualizerBand *band = equ->bands[f];                          \
+    SecondOrderHistory ## TYPE *history =                               \
+        (SecondOrderHistory ## TYPE *) equ->history + f * channels;     \
+    gdouble a0 = band->a0, a1 = band->a1, a2 = band->a2;                \
+    gdouble b1 = band->b1, b2 = band->b2;                               \
+    gdouble da0 = 0.0, da1 = 0.0, da2 = 0.0, db1 = 0.0, db2 = 0.0;      \
+    TYPE *s = samples;                                                  \
+                                                                        \
+    if (band->identity && !band->interpolate) {                         \
+      skip_band_ ## TYPE (history, samples, frames, channels);          \
+      continue;                                                         \
+    }                                                                   \
+                                                                        \
+    if (band->interpolate) {                                            \
+      /* reach the new coefficients with the last frame */              \
+      da0 = (band->a0 - band->prev_a0) / frames;                        \
+      da1 = (band->a1 - band->prev_a1) / frames;                        \
+      da2 = (band->a2 - band->prev_a2) / frames;                        \
+      db1 = (band->b1 - band->prev_b1) / frames;                        \
+      db2 = (band->b2 - band->prev_b2) / frames;                        \
+      a0 = band->prev_a0 + da0;                                         \
+      a1 = band->prev_a1 + da1;                                         \
+      a2 = band->prev_a2 + da2;                                         \
+      b1 = band->prev_b1 + db1;                                         \
+      b2 = band->prev_b2 + db2;                                         \
+      band->interpolate = FALSE;                                        \
+    }                                                                   \
+                                                                        \
+    for (i = 0; i < frames; i++) {                                      \
+      for (c = 0; c < channels; c++) {                                  \
+        SecondOrderHistory ## TYPE *h = &history[c];                    \
+        TYPE input = s[c];                                              \
+        TYPE output = a0 * input + a1 * h->x1 + a2 * h->x2 +            \
+            b1 * h->y1 + b2 * h->y2;                                    \
+                                                                        \
+        h->y2 = h->y1;                                                  \
+        h->y1 = output;                                                 \
+        h->x2 = h->x1;                                                  \
+        h->x1 = input;                                                  \
+        s[c] = output;                                                  \
       }                                                                 \
-      cur = CLAMP (cur, MIN_VAL, MAX_VAL);                              \
-      *((TYPE *) data) = (TYPE) floor (cur);                            \
-      data += sizeof (TYPE);                                            \
+      a0 += da0;                                                        \
+      a1 += da1;                                                        \
+      a2 += da2;                                                        \
+      b1 += db1;                                                        \
+      b2 += db2;                                                        \
+      s += channels;                                                    \
     }                                                                   \
   }                                                                     \
-}
-
-#define CREATE_OPTIMIZED_FUNCTIONS(TYPE)                                \
-typedef struct {                                                        \
-  TYPE x1, x2;          /* history of input values for a filter */  \
-  TYPE y1, y2;          /* history of output values for a filter */ \
-} SecondOrderHistory ## TYPE;                                           \
                                                                         \
-static inline TYPE                                                      \
-one_step_ ## TYPE (GstIirEqualizerBand *filter,                         \
-    SecondOrderHistory ## TYPE *history, TYPE input)                    \
-{                                                                       \
-  /* calculate output */                                                \
-  TYPE output = filter->a0 * input + filter->a1 * history->x1 +         \
-      filter->a2 * history->x2 + filter->b1 * history->y1 +             \
-      filter->b2 * history->y2;                                         \
-  /* update history */                                                  \
-  history->y2 = history->y1;                                            \
-  history->y1 = output;                                                 \
-  history->x2 = history->x1;                                            \
-  history->x1 = input;                                                  \
-                                                                        \
-  return output;                                                        \
+  flush_denormals_ ## TYPE (equ->history, nf * channels);               \
 }                                                                       \
                                                                         \
-static const guint                                                      \
-history_size_ ## TYPE = sizeof (SecondOrderHistory ## TYPE);            \
-                                                                        \
 static void                                                             \
 gst_iir_equ_process_ ## TYPE (GstIirEqualizer *equ, guint8 *data,       \
 guint size, guint channels)                                             \
 {                                                                       \
   guint frames = size / channels / sizeof (TYPE);                       \
-  guint i, c, f, nf = equ->freq_band_count;                             \
-  TYPE cur;                                                             \
-  GstIirEqualizerBand **filters = equ->bands;                           \
                                                                         \
-  for (i = 0; i < frames; i++) {                                        \
-    SecondOrderHistory ## TYPE *history = equ->history;                 \
-    for (c = 0; c < channels; c++) {                                    \
-      cur = *((TYPE *) data);                                           \
-      for (f = 0; f < nf; f++) {                                        \
-        cur = one_step_ ## TYPE (filters[f], history, cur);             \
-        history++;                                                      \
-      }                                                                 \
-      *((TYPE *) data) = (TYPE) cur;                                    \
-      data += sizeof (TYPE);                                            \
-    }                                                                   \
-  }                                                                     \
+  gst_iir_equ_process_bands_ ## TYPE (equ, (TYPE *) data, frames,       \
+      channels);                                                        \
 }
 
-CREATE_OPTIMIZED_FUNCTIONS_INT (gint16, gfloat, -32768.0, 32767.0);
 CREATE_OPTIMIZED_FUNCTIONS (gfloat);
 CREATE_OPTIMIZED_FUNCTIONS (gdouble);
 
+/* integer samples are filtered in float precision and only clamped and
+ * rounded after the last band */
+static const guint history_size_gint16 = sizeof (SecondOrderHistorygfloat);
+
+static void
+gst_iir_equ_process_gint16 (GstIirEqualizer * equ, guint8 * data,
+    guint size, guint channels)
+{
+  guint frames = size / channels / sizeof (gint16);
+  guint i, n = frames * channels;
+  gint16 *samples = (gint16 *) data;
+  gfloat *scratch;
+
+  if (equ->scratch_size < n) {
+    g_free (equ->scratch);
+    equ->scratch = g_new (gfloat, n);
+    equ->scratch_size = n;
+  }
+  scratch = equ->scratch;
+
+  for (i = 0; i < n; i++)
+    scratch[i] = samples[i];
+
+  gst_iir_equ_process_bands_gfloat (equ, scratch, frames, channels);
+
+  for (i = 0; i < n; i++) {
+    gfloat cur = CLAMP (scratch[i], -32768.0, 32767.0);
+
+    samples[i] = (gint16) floor (cur);
+  }
+}
+
 static GstFlowReturn
 gst_iir_equalizer_transform_ip (GstBaseTransform * btrans, GstBuffer * buf)
 {
@@ -822,18 +936,13 @@ gst_iir_equalizer_transform_ip (GstBaseTransform * btrans, GstBuffer * buf)
   GstClockTime timestamp;
   GstMapInfo map;
   gint channels = GST_AUDIO_FILTER_CHANNELS (filter);
-  gboolean need_new_coefficients;
+  gboolean passthrough;
 
   if (G_UNLIKELY (channels < 1 || equ->process == NULL))
     return GST_FLOW_NOT_NEGOTIATED;
 
-  BANDS_LOCK (equ);
-  need_new_coefficients = equ->need_new_coefficients;
-  BANDS_UNLOCK (equ);
-
-  if (!need_new_coefficients && gst_base_transform_is_passthrough (btrans))
-    return GST_FLOW_OK;
-
+  /* sync controlled values first so that automation is also picked up
+   * in passthrough mode */
   timestamp = GST_BUFFER_TIMESTAMP (buf);
   timestamp =
       gst_segment_to_stream_time (&btrans->segment, GST_FORMAT_TIME, timestamp);
@@ -852,12 +961,20 @@ gst_iir_equalizer_transform_ip (GstBaseTransform * btrans, GstBuffer * buf)
   }
 
   BANDS_LOCK (equ);
-  if (need_new_coefficients) {
+  if (equ->need_new_coefficients) {
+    /* the buffer that interpolates to the new coefficients is
+     * processed even when they are all the identity */
+    passthrough = FALSE;
     update_coefficients (equ);
     set_passthrough (equ);
+  } else {
+    passthrough = gst_base_transform_is_passthrough (btrans);
   }
   BANDS_UNLOCK (equ);
 
+  if (passthrough)
+    return GST_FLOW_OK;
+
   gst_buffer_map (buf, &map, GST_MAP_READWRITE);
   equ->process (equ, map.data, map.size, channels);
   gst_buffer_unmap (buf, &map);
@@ -887,7 +1004,9 @@ gst_iir_equalizer_setup (GstAudioFilter * audio, const GstAudioInfo * info)
       return FALSE;
   }
 
+  BANDS_LOCK (equ);
   alloc_history (equ, info);
+  BANDS_UNLOCK (equ);
   return TRUE;
 }
 
@@ -59,7 +59,13 @@ struct _GstIirEqualizer
   gpointer history;
   guint history_size;
 
+  /* float copy of integer samples */
+  gfloat *scratch;
+  guint scratch_size;
+
   gboolean need_new_coefficients;
+  /* interpolate changed coefficients, unset while the history is clear */
+  gboolean interpolate;
 
   ProcessFunc process;
 };
@@ -96,6 +96,14 @@ G_DEFINE_TYPE (GstFlvDemux, gst_flv_demux, GST_TYPE_ELEMENT);
 /* two seconds - consider pts are resynced to another base if this different */
 #define RESYNC_THRESHOLD 2000
 
+#define DEFAULT_INDEX_SAMPLE_INTERVAL 1
+
+enum
+{
+  PROP_0,
+  PROP_INDEX_SAMPLE_INTERVAL
+};
+
 static gboolean flv_demux_handle_seek_push (GstFlvDemux * demux,
     GstEvent * event);
 static gboolean gst_flv_demux_handle_seek_pull (GstFlvDemux * demux,
@@ -108,6 +116,88 @@ static gboolean gst_flv_demux_src_event (GstPad * pad, GstObject * parent,
 
 static GstIndex *gst_flv_demux_get_index (GstElement * element);
 
+static void gst_flv_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_flv_demux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static gint
+gst_flv_demux_keyframe_compare_time (GstFlvDemuxKeyframe * kf,
+    GstClockTime * time)
+{
+  if (kf->time < *time)
+    return -1;
+  else if (kf->time > *time)
+    return 1;
+  return 0;
+}
+
+static gint
+gst_flv_demux_keyframe_compare_pos (GstFlvDemuxKeyframe * kf, guint64 * pos)
+{
+  if (kf->pos < *pos)
+    return -1;
+  else if (kf->pos > *pos)
+    return 1;
+  return 0;
+}
+
+/* find the last keyframe at or before @value, which is a time or a byte
+ * position depending on @format */
+static GstFlvDemuxKeyframe *
+gst_flv_demux_find_keyframe (GstFlvDemux * demux, GstFormat format,
+    guint64 value)
+{
+  GCompareDataFunc func;
+
+  if (demux->keyframes->len == 0)
+    return NULL;
+
+  if (format == GST_FORMAT_TIME)
+    func = (GCompareDataFunc) gst_flv_demux_keyframe_compare_time;
+  else
+    func = (GCompareDataFunc) gst_flv_demux_keyframe_compare_pos;
+
+  return gst_util_array_binary_search (demux->keyframes->data,
+      demux->keyframes->len, sizeof (GstFlvDemuxKeyframe), func,
+      GST_SEARCH_MODE_BEFORE, &value, NULL);
+}
+
+/* add a keyframe to the seek index. When only every Nth keyframe is kept,
+ * this is only done for keyframes after the last one in the index as
+ * keyframes seen again after a seek can not be counted reliably. */
+static void
+gst_flv_demux_add_keyframe (GstFlvDemux * demux, GstClockTime ts, guint64 pos)
+{
+  GstFlvDemuxKeyframe kf, *last, *prev;
+  guint len = demux->keyframes->len;
+
+  kf.time = ts;
+  kf.pos = pos;
+
+  last = len ? &g_array_index (demux->keyframes, GstFlvDemuxKeyframe,
+      len - 1) : NULL;
+
+  if (!last || (ts > last->time && pos > last->pos)) {
+    if (demux->keyframes_seen++ % demux->index_sample_interval == 0)
+      g_array_append_val (demux->keyframes, kf);
+    return;
+  }
+
+  if (demux->index_sample_interval > 1)
+    return;
+
+  prev = gst_flv_demux_find_keyframe (demux, GST_FORMAT_TIME, ts);
+  if (prev && prev->time == ts) {
+    GST_LOG_OBJECT (demux, "keyframe already in index");
+    return;
+  }
+
+  g_array_insert_val (demux->keyframes,
+      prev ? prev - (GstFlvDemuxKeyframe *) demux->keyframes->data + 1 : 0,
+      kf);
+}
+
 static void
 gst_flv_demux_parse_and_add_index_entry (GstFlvDemux * demux, GstClockTime ts,
     guint64 pos, gboolean keyframe)
@@ -124,6 +214,18 @@ gst_flv_demux_parse_and_add_index_entry (GstFlvDemux * demux, GstClockTime ts,
   if (!demux->upstream_seekable)
     return;
 
+  if (pos > demux->index_max_pos)
+    demux->index_max_pos = pos;
+  if (ts > demux->index_max_time)
+    demux->index_max_time = ts;
+
+  if (keyframe)
+    gst_flv_demux_add_keyframe (demux, ts, pos);
+
+  /* the full association index is not kept when sampling the seek index */
+  if (demux->index_sample_interval > 1)
+    return;
+
   index = gst_flv_demux_get_index (GST_ELEMENT (demux));
 
   if (!index)
@@ -160,11 +262,6 @@ gst_flv_demux_parse_and_add_index_entry (GstFlvDemux * demux, GstClockTime ts,
       GST_ASSOCIATION_FLAG_DELTA_UNIT, 2,
       (const GstIndexAssociation *) &associations);
 
-  if (pos > demux->index_max_pos)
-    demux->index_max_pos = pos;
-  if (ts > demux->index_max_time)
-    demux->index_max_time = ts;
-
   gst_object_unref (index);
 }
 
@@ -909,9 +1006,8 @@ gst_flv_demux_parse_tag_audio (GstFlvDemux * demux, GstBuffer * buffer)
   guint32 pts = 0, codec_tag = 0, rate = 5512, width = 8, channels = 1;
   guint32 codec_data = 0, pts_ext = 0;
   guint8 flags = 0;
-  GstMapInfo map;
   GstBuffer *outbuf;
-  guint8 *data;
+  guint8 data[12];
 
   GST_LOG_OBJECT (demux, "parsing an audio tag");
 
@@ -931,8 +1027,10 @@ gst_flv_demux_parse_tag_audio (GstFlvDemux * demux, GstBuffer * buffer)
     return GST_FLOW_ERROR;
   }
 
-  gst_buffer_map (buffer, &map, GST_MAP_READ);
-  data = map.data;
+  /* only the tag header is needed, the payload is shared with the output
+   * buffer so don't map (and possibly merge) the whole tag */
+  memset (data, 0, sizeof (data));
+  gst_buffer_extract (buffer, 0, data, sizeof (data));
 
   /* Grab information about audio tag */
   pts = GST_READ_UINT24_BE (data);
@@ -948,7 +1046,7 @@ gst_flv_demux_parse_tag_audio (GstFlvDemux * demux, GstBuffer * buffer)
   flags = GST_READ_UINT8 (data + 7);
 
   /* Silently skip buffers with no data */
-  if (map.size == 11)
+  if (gst_buffer_get_size (buffer) == 11)
     goto beach;
 
   /* Channels */
@@ -1193,8 +1291,6 @@ gst_flv_demux_parse_tag_audio (GstFlvDemux * demux, GstBuffer * buffer)
   demux->audio_linked = TRUE;
 
 beach:
-  gst_buffer_unmap (buffer, &map);
-
   return ret;
 }
 
@@ -1310,8 +1406,7 @@ gst_flv_demux_parse_tag_video (GstFlvDemux * demux, GstBuffer * buffer)
   gboolean keyframe = FALSE;
   guint8 flags = 0, codec_tag = 0;
   GstBuffer *outbuf;
-  GstMapInfo map;
-  guint8 *data;
+  guint8 data[12];
 
   g_return_val_if_fail (gst_buffer_get_size (buffer) == demux->tag_size,
       GST_FLOW_ERROR);
@@ -1329,8 +1424,10 @@ gst_flv_demux_parse_tag_video (GstFlvDemux * demux, GstBuffer * buffer)
     return GST_FLOW_ERROR;
   }
 
-  gst_buffer_map (buffer, &map, GST_MAP_READ);
-  data = map.data;
+  /* only the tag header is needed, the payload is shared with the output
+   * buffer so don't map (and possibly merge) the whole tag */
+  memset (data, 0, sizeof (data));
+  gst_buffer_extract (buffer, 0, data, sizeof (data));
 
   /* Grab information about video tag */
   pts = GST_READ_UINT24_BE (data);
@@ -1587,7 +1684,6 @@ gst_flv_demux_parse_tag_video (GstFlvDemux * demux, GstBuffer * buffer)
   demux->video_linked = TRUE;
 
 beach:
-  gst_buffer_unmap (buffer, &map);
   return ret;
 }
 
@@ -1826,6 +1922,9 @@ gst_flv_demux_cleanup (GstFlvDemux * demux)
   demux->index_max_pos = 0;
   demux->index_max_time = 0;
 
+  g_array_set_size (demux->keyframes, 0);
+  demux->keyframes_seen = 0;
+
   demux->audio_start = demux->video_start = GST_CLOCK_TIME_NONE;
   demux->last_audio_pts = demux->last_video_pts = 0;
   demux->audio_time_offset = demux->video_time_offset = 0;
@@ -2010,7 +2109,8 @@ parse:
       if (gst_adapter_available (demux->adapter) >= demux->tag_size) {
         GstBuffer *buffer;
 
-        buffer = gst_adapter_take_buffer (demux->adapter, demux->tag_size);
+        buffer = gst_adapter_take_buffer_fast (demux->adapter,
+            demux->tag_size);
 
         ret = gst_flv_demux_parse_tag_video (demux, buffer);
 
@@ -2028,7 +2128,8 @@ parse:
       if (gst_adapter_available (demux->adapter) >= demux->tag_size) {
         GstBuffer *buffer;
 
-        buffer = gst_adapter_take_buffer (demux->adapter, demux->tag_size);
+        buffer = gst_adapter_take_buffer_fast (demux->adapter,
+            demux->tag_size);
 
         ret = gst_flv_demux_parse_tag_audio (demux, buffer);
 
@@ -2299,8 +2400,7 @@ static GstFlowReturn
 gst_flv_demux_seek_to_prev_keyframe (GstFlvDemux * demux)
 {
   GstFlowReturn ret = GST_FLOW_EOS;
-  GstIndex *index;
-  GstIndexEntry *entry = NULL;
+  GstFlvDemuxKeyframe *kf;
 
   GST_DEBUG_OBJECT (demux,
       "terminated section started at offset %" G_GINT64_FORMAT,
@@ -2318,31 +2418,19 @@ gst_flv_demux_seek_to_prev_keyframe (GstFlvDemux * demux)
 
   GST_DEBUG_OBJECT (demux, "locating previous position");
 
-  index = gst_flv_demux_get_index (GST_ELEMENT (demux));
-
   /* locate index entry before previous start position */
-  if (index) {
-    entry = gst_index_get_assoc_entry (index, demux->index_id,
-        GST_INDEX_LOOKUP_BEFORE, GST_ASSOCIATION_FLAG_KEY_UNIT,
-        GST_FORMAT_BYTES, demux->from_offset - 1);
-
-    if (entry) {
-      gint64 bytes = 0, time = 0;
-
-      gst_index_entry_assoc_map (entry, GST_FORMAT_BYTES, &bytes);
-      gst_index_entry_assoc_map (entry, GST_FORMAT_TIME, &time);
+  kf = gst_flv_demux_find_keyframe (demux, GST_FORMAT_BYTES,
+      demux->from_offset - 1);
 
-      GST_DEBUG_OBJECT (demux, "found index entry for %" G_GINT64_FORMAT
-          " at %" GST_TIME_FORMAT ", seeking to %" G_GINT64_FORMAT,
-          demux->offset - 1, GST_TIME_ARGS (time), bytes);
-
-      /* setup for next section */
-      demux->to_offset = demux->from_offset;
-      gst_flv_demux_move_to_offset (demux, bytes, FALSE);
-      ret = GST_FLOW_OK;
-    }
+  if (kf) {
+    GST_DEBUG_OBJECT (demux, "found index entry for %" G_GINT64_FORMAT
+        " at %" GST_TIME_FORMAT ", seeking to %" G_GUINT64_FORMAT,
+        demux->offset - 1, GST_TIME_ARGS (kf->time), kf->pos);
 
-    gst_object_unref (index);
+    /* setup for next section */
+    demux->to_offset = demux->from_offset;
+    gst_flv_demux_move_to_offset (demux, kf->pos, FALSE);
+    ret = GST_FLOW_OK;
   }
 
 
@@ -2607,45 +2695,35 @@ pause:
 static guint64
 gst_flv_demux_find_offset (GstFlvDemux * demux, GstSegment * segment)
 {
-  gint64 bytes = 0;
-  gint64 time = 0;
-  GstIndex *index;
-  GstIndexEntry *entry;
+  guint64 bytes = 0;
+  GstClockTime time;
+  GstFlvDemuxKeyframe *kf;
 
   g_return_val_if_fail (segment != NULL, 0);
 
-  time = segment->position;
+  /* Let's check if we have an index entry for that seek time */
+  kf = gst_flv_demux_find_keyframe (demux, GST_FORMAT_TIME,
+      segment->position);
 
-  index = gst_flv_demux_get_index (GST_ELEMENT (demux));
+  if (kf) {
+    bytes = kf->pos;
+    time = kf->time;
 
-  if (index) {
-    /* Let's check if we have an index entry for that seek time */
-    entry = gst_index_get_assoc_entry (index, demux->index_id,
-        GST_INDEX_LOOKUP_BEFORE, GST_ASSOCIATION_FLAG_KEY_UNIT,
-        GST_FORMAT_TIME, time);
-
-    if (entry) {
-      gst_index_entry_assoc_map (entry, GST_FORMAT_BYTES, &bytes);
-      gst_index_entry_assoc_map (entry, GST_FORMAT_TIME, &time);
-
-      GST_DEBUG_OBJECT (demux, "found index entry for %" GST_TIME_FORMAT
-          " at %" GST_TIME_FORMAT ", seeking to %" G_GINT64_FORMAT,
-          GST_TIME_ARGS (segment->position), GST_TIME_ARGS (time), bytes);
-
-      /* Key frame seeking */
-      if (segment->flags & GST_SEEK_FLAG_KEY_UNIT) {
-        /* Adjust the segment so that the keyframe fits in */
-        if (time < segment->start) {
-          segment->start = segment->time = time;
-        }
-        segment->position = time;
+    GST_DEBUG_OBJECT (demux, "found index entry for %" GST_TIME_FORMAT
+        " at %" GST_TIME_FORMAT ", seeking to %" G_GUINT64_FORMAT,
+        GST_TIME_ARGS (segment->position), GST_TIME_ARGS (time), bytes);
+
+    /* Key frame seeking */
+    if (segment->flags & GST_SEEK_FLAG_KEY_UNIT) {
+      /* Adjust the segment so that the keyframe fits in */
+      if (time < segment->start) {
+        segment->start = segment->time = time;
       }
-    } else {
-      GST_DEBUG_OBJECT (demux, "no index entry found for %" GST_TIME_FORMAT,
-          GST_TIME_ARGS (segment->start));
+      segment->position = time;
     }
-
-    gst_object_unref (index);
+  } else {
+    GST_DEBUG_OBJECT (demux, "no index entry found for %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (segment->start));
   }
 
   return bytes;
@@ -3411,9 +3489,50 @@ gst_flv_demux_dispose (GObject * object)
     demux->filepositions = NULL;
   }
 
+  if (demux->keyframes) {
+    g_array_free (demux->keyframes, TRUE);
+    demux->keyframes = NULL;
+  }
+
   GST_CALL_PARENT (G_OBJECT_CLASS, dispose, (object));
 }
 
+static void
+gst_flv_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstFlvDemux *demux = GST_FLV_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_INDEX_SAMPLE_INTERVAL:
+      GST_OBJECT_LOCK (demux);
+      demux->index_sample_interval = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_flv_demux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstFlvDemux *demux = GST_FLV_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_INDEX_SAMPLE_INTERVAL:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_uint (value, demux->index_sample_interval);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_flv_demux_class_init (GstFlvDemuxClass * klass)
 {
@@ -3421,6 +3540,23 @@ gst_flv_demux_class_init (GstFlvDemuxClass * klass)
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 
   gobject_class->dispose = gst_flv_demux_dispose;
+  gobject_class->set_property = gst_flv_demux_set_property;
+  gobject_class->get_property = gst_flv_demux_get_property;
+
+  /**
+   * GstFlvDemux:index-sample-interval:
+   *
+   * Only keep every Nth keyframe in the seek index, which bounds the
+   * memory used for long recordings at the cost of less precise seeking.
+   * With the default of 1 every keyframe is indexed.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_INDEX_SAMPLE_INTERVAL,
+      g_param_spec_uint ("index-sample-interval", "Index sample interval",
+          "Only keep every Nth keyframe in the seek index", 1, G_MAXUINT,
+          DEFAULT_INDEX_SAMPLE_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_flv_demux_change_state);
@@ -3465,6 +3601,9 @@ gst_flv_demux_init (GstFlvDemux * demux)
 
   demux->own_index = FALSE;
 
+  demux->keyframes = g_array_new (FALSE, FALSE, sizeof (GstFlvDemuxKeyframe));
+  demux->index_sample_interval = DEFAULT_INDEX_SAMPLE_INTERVAL;
+
   GST_OBJECT_FLAG_SET (demux, GST_ELEMENT_FLAG_INDEXABLE);
 
   gst_flv_demux_cleanup (demux);
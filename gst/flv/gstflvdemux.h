@@ -38,6 +38,13 @@ G_BEGIN_DECLS
 typedef struct _GstFlvDemux GstFlvDemux;
 typedef struct _GstFlvDemuxClass GstFlvDemuxClass;
 
+/* keyframe in the seek index, sorted on both fields */
+typedef struct
+{
+  GstClockTime time;
+  guint64 pos;
+} GstFlvDemuxKeyframe;
+
 typedef enum
 {
   FLV_STATE_HEADER,
@@ -71,6 +78,11 @@ struct _GstFlvDemux
   GArray * times;
   GArray * filepositions;
 
+  /* flat seek index of GstFlvDemuxKeyframe */
+  GArray * keyframes;
+  guint keyframes_seen;
+  guint index_sample_interval;
+
   GstAdapter *adapter;
 
   GstSegment segment;
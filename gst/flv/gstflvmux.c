@@ -993,42 +993,45 @@ exit:
   return script_tag;
 }
 
+/* tag header (11 bytes), audio/video tag header (up to 5 bytes) and the
+ * previous tag size trailer are allocated together */
+#define FLV_TAG_FRAMING_SIZE (11 + 5 + 4)
+
 static GstBuffer *
 gst_flv_mux_buffer_to_tag_internal (GstFlvMux * mux, GstBuffer * buffer,
     GstFlvPad * cpad, gboolean is_codec_data)
 {
   GstBuffer *tag;
+  GstMemory *framing;
   GstMapInfo map;
-  guint size;
+  guint size, header_size;
   guint32 timestamp =
       (GST_BUFFER_TIMESTAMP_IS_VALID (buffer)) ? GST_BUFFER_TIMESTAMP (buffer) /
       GST_MSECOND : cpad->last_timestamp / GST_MSECOND;
-  guint8 *data, *bdata;
+  guint8 *data;
   gsize bsize;
 
-  gst_buffer_map (buffer, &map, GST_MAP_READ);
-  bdata = map.data;
-  bsize = map.size;
+  bsize = gst_buffer_get_size (buffer);
 
-  size = 11;
+  header_size = 11;
   if (cpad->video) {
-    size += 1;
+    header_size += 1;
     if (cpad->video_codec == 7)
-      size += 4 + bsize;
-    else
-      size += bsize;
+      header_size += 4;
   } else {
-    size += 1;
+    header_size += 1;
     if (cpad->audio_codec == 10)
-      size += 1 + bsize;
-    else
-      size += bsize;
+      header_size += 1;
   }
-  size += 4;
+  size = header_size + bsize + 4;
 
-  _gst_buffer_new_and_alloc (size, &tag, &data);
-  GST_BUFFER_TIMESTAMP (tag) = timestamp * GST_MSECOND;
-  memset (data, 0, size);
+  /* the payload is not copied: the tag is made of a header memory, the
+   * memories of @buffer and a trailer memory. Header and trailer share one
+   * small allocation, which the default allocator takes from its slab. */
+  framing = gst_allocator_alloc (NULL, FLV_TAG_FRAMING_SIZE, NULL);
+  gst_memory_map (framing, &map, GST_MAP_WRITE);
+  data = map.data;
+  memset (data, 0, FLV_TAG_FRAMING_SIZE);
 
   data[0] = (cpad->video) ? 9 : 8;
 
@@ -1058,10 +1061,6 @@ gst_flv_mux_buffer_to_tag_internal (GstFlvMux * mux, GstBuffer * buffer,
 
       /* FIXME: what to do about composition time */
       data[13] = data[14] = data[15] = 0;
-
-      memcpy (data + 11 + 1 + 4, bdata, bsize);
-    } else {
-      memcpy (data + 11 + 1, bdata, bsize);
     }
   } else {
     data[11] |= (cpad->audio_codec << 4) & 0xf0;
@@ -1071,16 +1070,19 @@ gst_flv_mux_buffer_to_tag_internal (GstFlvMux * mux, GstBuffer * buffer,
 
     if (cpad->audio_codec == 10) {
       data[12] = is_codec_data ? 0 : 1;
-
-      memcpy (data + 11 + 1 + 1, bdata, bsize);
-    } else {
-      memcpy (data + 11 + 1, bdata, bsize);
     }
   }
 
-  gst_buffer_unmap (buffer, &map);
+  GST_WRITE_UINT32_BE (data + FLV_TAG_FRAMING_SIZE - 4, size - 4);
+
+  gst_memory_unmap (framing, &map);
 
-  GST_WRITE_UINT32_BE (data + size - 4, size - 4);
+  tag = gst_buffer_new ();
+  gst_buffer_append_memory (tag, gst_memory_share (framing, 0, header_size));
+  gst_buffer_copy_into (tag, buffer, GST_BUFFER_COPY_MEMORY, 0, bsize);
+  gst_buffer_append_memory (tag,
+      gst_memory_share (framing, FLV_TAG_FRAMING_SIZE - 4, 4));
+  gst_memory_unref (framing);
 
   GST_BUFFER_TIMESTAMP (tag) = GST_BUFFER_TIMESTAMP (buffer);
   GST_BUFFER_DURATION (tag) = GST_BUFFER_DURATION (buffer);
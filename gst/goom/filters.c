@@ -52,6 +52,10 @@
 #include "goom_fx.h"
 #include "v3d.h"
 
+#ifdef HAVE_ZOOM_FILTER_SSE2
+#include <emmintrin.h>
+#endif
+
 /* TODO : MOVE THIS AWAY !!! */
 /* jeko: j'ai essayer de le virer, mais si on veut les laisser inline c'est un peu lourdo... */
 static inline void
@@ -121,6 +125,18 @@ zoom_filter_c (int sizeX, int sizeY, Pixel * src, Pixel * dest, int *brutS,
 static void generatePrecalCoef (int precalCoef[BUFFPOINTNB][BUFFPOINTNB]);
 
 
+/* Everything zoomVector () depends on, to find out if a new transform buffer
+ * would be the same as the current one */
+typedef struct _ZOOM_VECTOR_PARAMS
+{
+  float general_speed;
+  char theMode;
+  int hypercosEffect;
+  int vPlaneEffect;
+  int hPlaneEffect;
+  int middleX, middleY;
+} ZoomVectorParams;
+
 typedef struct _ZOOM_FILTER_FX_WRAPPER_DATA
 {
 
@@ -150,6 +166,12 @@ typedef struct _ZOOM_FILTER_FX_WRAPPER_DATA
   int mustInitBuffers;
   int interlace_start;
 
+  /* parameters brutD was computed with and brutT is being computed with,
+   * brutT is copied from brutD when they are the same */
+  ZoomVectorParams brutD_params;
+  ZoomVectorParams brutT_params;
+  int brutT_copy;
+
     /** modif by jeko : fixedpoint : buffration = (16:16) (donc 0<=buffration<=2^16) */
   int buffratio;
   int *firedec;
@@ -166,6 +188,28 @@ typedef struct _ZOOM_FILTER_FX_WRAPPER_DATA
 
 
 
+static void
+zoomVectorParamsGet (ZoomFilterFXWrapperData * data, ZoomVectorParams * params)
+{
+  params->general_speed = data->general_speed;
+  params->theMode = data->theMode;
+  params->hypercosEffect = data->hypercosEffect;
+  params->vPlaneEffect = data->vPlaneEffect;
+  params->hPlaneEffect = data->hPlaneEffect;
+  params->middleX = data->middleX;
+  params->middleY = data->middleY;
+}
+
+static int
+zoomVectorParamsEqual (const ZoomVectorParams * a, const ZoomVectorParams * b)
+{
+  return a->general_speed == b->general_speed && a->theMode == b->theMode &&
+      a->hypercosEffect == b->hypercosEffect &&
+      a->vPlaneEffect == b->vPlaneEffect &&
+      a->hPlaneEffect == b->hPlaneEffect &&
+      a->middleX == b->middleX && a->middleY == b->middleY;
+}
+
 static inline void
 zoomVector (v2g * vecteur, ZoomFilterFXWrapperData * data, float X, float Y)
 {
@@ -284,8 +328,21 @@ makeZoomBufferStripe (ZoomFilterFXWrapperData * data, int INTERLACE_INCR)
   if (maxEnd > (data->interlace_start + INTERLACE_INCR))
     maxEnd = (data->interlace_start + INTERLACE_INCR);
 
-  for (y = data->interlace_start;
-      (y < data->prevY) && ((signed int) y < maxEnd); y++) {
+  y = data->interlace_start;
+
+  /* the vectors would be the same as the ones of brutD, the noise is the
+   * only random part and is excluded from this */
+  if (data->brutT_copy) {
+    if ((signed int) y < maxEnd) {
+      memcpy (data->brutT + y * data->prevX * 2,
+          data->brutD + y * data->prevX * 2,
+          (maxEnd - y) * data->prevX * 2 * sizeof (int));
+      y = maxEnd;
+    }
+    maxEnd = y;
+  }
+
+  for (; (y < data->prevY) && ((signed int) y < maxEnd); y++) {
     Uint premul_y_prevX = y * data->prevX * 2;
     float X = -((float) data->middleX) * ratio;
 
@@ -509,6 +566,71 @@ c_zoom (Pixel * expix1, Pixel * expix2, unsigned int prevX, unsigned int prevY,
   }
 }
 
+#ifdef HAVE_ZOOM_FILTER_SSE2
+/* Same as c_zoom, the 4 source pixels are weighted in 16 bit lanes. The
+ * weights sum up to at most 256, so the sums fit and the result is
+ * identical */
+void
+zoom_filter_sse2 (int prevX, int prevY, Pixel * expix1, Pixel * expix2,
+    int *brutS, int *brutD, int buffratio, int precalCoef[16][16])
+{
+  unsigned int ax = (prevX - 1) << PERTEDEC, ay = (prevY - 1) << PERTEDEC;
+  int bufsize = prevX * prevY;
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i five = _mm_set1_epi16 (5);
+  Pixel alpha;
+  int loop;
+
+  /* c_zoom leaves the alpha channel of the destination untouched */
+  alpha.val = 0;
+  alpha.channels.a = 0xff;
+
+  expix1[0].val = expix1[prevX - 1].val = expix1[prevX * prevY - 1].val =
+      expix1[prevX * prevY - prevX].val = 0;
+
+  for (loop = 0; loop < bufsize; loop++) {
+    int px, py, pos, coeffs;
+    int myPos = loop << 1, myPos2 = myPos + 1;
+    int brutSmypos = brutS[myPos];
+    __m128i top, bottom, c, c12, c34;
+
+    px = brutSmypos + (((brutD[myPos] -
+                brutSmypos) * buffratio) >> BUFFPOINTNB);
+    brutSmypos = brutS[myPos2];
+    py = brutSmypos + (((brutD[myPos2] -
+                brutSmypos) * buffratio) >> BUFFPOINTNB);
+
+    if ((py >= ay) || (px >= ax)) {
+      pos = coeffs = 0;
+    } else {
+      pos = ((px >> PERTEDEC) + prevX * (py >> PERTEDEC));
+      coeffs = precalCoef[px & PERTEMASK][py & PERTEMASK];
+    }
+
+    /* c1 c1 c1 c1 c2 c2 c2 c2 c3 c3 c3 c3 c4 c4 c4 c4 */
+    c = _mm_cvtsi32_si128 (coeffs);
+    c = _mm_unpacklo_epi8 (c, c);
+    c = _mm_unpacklo_epi8 (c, c);
+    c12 = _mm_unpacklo_epi8 (c, zero);
+    c34 = _mm_unpackhi_epi8 (c, zero);
+
+    top = _mm_loadl_epi64 ((const __m128i *) (expix1 + pos));
+    bottom = _mm_loadl_epi64 ((const __m128i *) (expix1 + pos + prevX));
+    top = _mm_mullo_epi16 (_mm_unpacklo_epi8 (top, zero), c12);
+    bottom = _mm_mullo_epi16 (_mm_unpacklo_epi8 (bottom, zero), c34);
+    top = _mm_add_epi16 (top, bottom);
+    top = _mm_add_epi16 (top, _mm_srli_si128 (top, 8));
+
+    /* (sum > 5 ? sum - 5 : sum) >> 8 */
+    top = _mm_srli_epi16 (_mm_subs_epu16 (top, five), 8);
+    top = _mm_packus_epi16 (top, top);
+
+    expix2[loop].val = (_mm_cvtsi128_si32 (top) & ~alpha.val) |
+        (expix2[loop].val & alpha.val);
+  }
+}
+#endif
+
 /** generate the water fx horizontal direction buffer */
 static void
 generateTheWaterFXHorizontalDirectionBuffer (PluginInfo * goomInfo,
@@ -624,6 +746,10 @@ zoomFilterFastRGB (PluginInfo * goomInfo, Pixel * pix1, Pixel * pix2,
     data->hypercosEffect = zf->hypercosEffect;
     data->noisify = zf->noisify;
     data->interlace_start = 0;
+
+    zoomVectorParamsGet (data, &data->brutT_params);
+    data->brutT_copy = !data->noisify &&
+        zoomVectorParamsEqual (&data->brutT_params, &data->brutD_params);
   }
 
 
@@ -651,11 +777,15 @@ zoomFilterFastRGB (PluginInfo * goomInfo, Pixel * pix1, Pixel * pix2,
     generateTheWaterFXHorizontalDirectionBuffer (goomInfo, data);
 
     data->interlace_start = 0;
+    data->brutT_copy = 0;
     makeZoomBufferStripe (data, resy);
 
     /* Copy the data from temp to dest and source */
     memcpy (data->brutS, data->brutT, resx * resy * 2 * sizeof (int));
     memcpy (data->brutD, data->brutT, resx * resy * 2 * sizeof (int));
+
+    zoomVectorParamsGet (data, &data->brutD_params);
+    data->brutT_params = data->brutD_params;
   }
 
   /* generation du buffer de trans */
@@ -688,6 +818,7 @@ zoomFilterFastRGB (PluginInfo * goomInfo, Pixel * pix1, Pixel * pix2,
     tmp = data->freebrutD;
     data->freebrutD = data->freebrutT;
     data->freebrutT = tmp;
+    data->brutD_params = data->brutT_params;
     data->interlace_start = -2;
   }
 
@@ -776,6 +907,9 @@ zoomFilterVisualFXWrapper_init (struct _VISUAL_FX *_this, PluginInfo * info)
 
   data->mustInitBuffers = 1;
   data->interlace_start = -2;
+  memset (&data->brutD_params, 0, sizeof (ZoomVectorParams));
+  memset (&data->brutT_params, 0, sizeof (ZoomVectorParams));
+  data->brutT_copy = 0;
 
   data->general_speed = 0.0f;
   data->reverse = 0;
@@ -27,4 +27,9 @@ void flying_star_create (VisualFX *vfx);
 
 void zoom_filter_c(int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16]);
 
+#if defined(__SSE2__)
+#define HAVE_ZOOM_FILTER_SSE2 1
+void zoom_filter_sse2(int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16]);
+#endif
+
 #endif
@@ -56,6 +56,7 @@ GST_DEBUG_CATEGORY (goom_debug);
 #define DEFAULT_HEIGHT 240
 #define DEFAULT_FPS_N  25
 #define DEFAULT_FPS_D  1
+#define DEFAULT_RENDER_SCALE 1
 
 /* signals and args */
 enum
@@ -66,8 +67,8 @@ enum
 
 enum
 {
-  ARG_0
-      /* FILL ME */
+  PROP_0,
+  PROP_RENDER_SCALE
 };
 
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
@@ -97,6 +98,10 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
 
 
 static void gst_goom_finalize (GObject * object);
+static void gst_goom_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_goom_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static GstStateChangeReturn gst_goom_change_state (GstElement * element,
     GstStateChange transition);
@@ -126,6 +131,23 @@ gst_goom_class_init (GstGoomClass * klass)
   gstelement_class = (GstElementClass *) klass;
 
   gobject_class->finalize = gst_goom_finalize;
+  gobject_class->set_property = gst_goom_set_property;
+  gobject_class->get_property = gst_goom_get_property;
+
+  /**
+   * GstGoom:render-scale:
+   *
+   * Divisor applied to the output width and height to get the resolution
+   * the visualization is rendered at. The rendered picture is scaled up to
+   * the output size, which makes the effects a lot cheaper on large outputs.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_RENDER_SCALE,
+      g_param_spec_uint ("render-scale", "Render scale",
+          "Render at the output size divided by this and scale up",
+          1, 8, DEFAULT_RENDER_SCALE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_set_static_metadata (gstelement_class, "GOOM: what a GOOM!",
       "Visualization",
@@ -167,6 +189,12 @@ gst_goom_init (GstGoom * goom)
   goom->rate = 0;
   goom->duration = 0;
 
+  goom->render_scale = DEFAULT_RENDER_SCALE;
+  goom->cur_render_scale = DEFAULT_RENDER_SCALE;
+  goom->render_width = goom->width;
+  goom->render_height = goom->height;
+  goom->render_xmap = NULL;
+
   goom->plugin = goom_init (goom->width, goom->height);
 }
 
@@ -182,9 +210,99 @@ gst_goom_finalize (GObject * object)
   if (goom->pool)
     gst_object_unref (goom->pool);
 
+  g_free (goom->render_xmap);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_goom_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGoom *goom = GST_GOOM (object);
+
+  switch (prop_id) {
+    case PROP_RENDER_SCALE:
+      GST_OBJECT_LOCK (goom);
+      goom->render_scale = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (goom);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_goom_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGoom *goom = GST_GOOM (object);
+
+  switch (prop_id) {
+    case PROP_RENDER_SCALE:
+      GST_OBJECT_LOCK (goom);
+      g_value_set_uint (value, goom->render_scale);
+      GST_OBJECT_UNLOCK (goom);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* sets the goom resolution from the output size and the render scale */
+static void
+gst_goom_update_resolution (GstGoom * goom, guint scale)
+{
+  gint x;
+
+  goom->cur_render_scale = scale;
+  goom->render_width = MIN (goom->width, MAX (goom->width / (gint) scale, 16));
+  goom->render_height =
+      MIN (goom->height, MAX (goom->height / (gint) scale, 16));
+
+  goom_set_resolution (goom->plugin, goom->render_width, goom->render_height);
+
+  g_free (goom->render_xmap);
+  goom->render_xmap = NULL;
+
+  if (goom->render_width == goom->width &&
+      goom->render_height == goom->height)
+    return;
+
+  /* source column of every output column */
+  goom->render_xmap = g_new (guint, goom->width);
+  for (x = 0; x < goom->width; x++)
+    goom->render_xmap[x] = x * goom->render_width / goom->width;
+
+  GST_DEBUG_OBJECT (goom, "rendering at %dx%d", goom->render_width,
+      goom->render_height);
+}
+
+/* nearest neighbour upscaling of the goom output, rows that come from the
+ * same source row are copied from the previous output row */
+static void
+gst_goom_upscale (GstGoom * goom, const guint32 * src, guint32 * dest)
+{
+  gint x, y, sy, prev_sy = -1;
+
+  for (y = 0; y < goom->height; y++) {
+    sy = y * goom->render_height / goom->height;
+
+    if (sy == prev_sy) {
+      memcpy (dest, dest - goom->width, goom->width * 4);
+    } else {
+      const guint32 *s = src + sy * goom->render_width;
+
+      for (x = 0; x < goom->width; x++)
+        dest[x] = s[goom->render_xmap[x]];
+      prev_sy = sy;
+    }
+    dest += goom->width;
+  }
+}
+
 static void
 gst_goom_reset (GstGoom * goom)
 {
@@ -217,6 +335,7 @@ gst_goom_src_setcaps (GstGoom * goom, GstCaps * caps)
 {
   GstStructure *structure;
   gboolean res;
+  guint scale;
 
   structure = gst_caps_get_structure (caps, 0);
   if (!gst_structure_get_int (structure, "width", &goom->width) ||
@@ -225,7 +344,11 @@ gst_goom_src_setcaps (GstGoom * goom, GstCaps * caps)
           &goom->fps_d))
     goto error;
 
-  goom_set_resolution (goom->plugin, goom->width, goom->height);
+  GST_OBJECT_LOCK (goom);
+  scale = goom->render_scale;
+  GST_OBJECT_UNLOCK (goom);
+
+  gst_goom_update_resolution (goom, scale);
 
   /* size of the output buffer in bytes, depth is always 4 bytes */
   goom->outsize = goom->width * goom->height * 4;
@@ -523,7 +646,7 @@ gst_goom_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     const guint16 *data;
     guchar *out_frame;
     gint i;
-    guint avail, to_flush;
+    guint avail, to_flush, scale;
     guint64 dist, timestamp;
 
     avail = gst_adapter_available (goom->adapter);
@@ -598,8 +721,24 @@ gst_goom_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     GST_BUFFER_TIMESTAMP (outbuf) = timestamp;
     GST_BUFFER_DURATION (outbuf) = goom->duration;
 
+    GST_OBJECT_LOCK (goom);
+    scale = goom->render_scale;
+    GST_OBJECT_UNLOCK (goom);
+
+    if (scale != goom->cur_render_scale)
+      gst_goom_update_resolution (goom, scale);
+
     out_frame = (guchar *) goom_update (goom->plugin, goom->datain, 0, 0);
-    gst_buffer_fill (outbuf, 0, out_frame, goom->outsize);
+    if (goom->render_xmap == NULL) {
+      gst_buffer_fill (outbuf, 0, out_frame, goom->outsize);
+    } else {
+      GstMapInfo map;
+
+      gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
+      gst_goom_upscale (goom, (const guint32 *) out_frame,
+          (guint32 *) map.data);
+      gst_buffer_unmap (outbuf, &map);
+    }
 
     gst_adapter_unmap (goom->adapter);
 
@@ -59,6 +59,13 @@ struct _GstGoom
   guint outsize;
   GstBufferPool *pool;
 
+  /* reduced resolution rendering */
+  guint render_scale;           /* with LOCK */
+  guint cur_render_scale;
+  gint render_width;
+  gint render_height;
+  guint *render_xmap;
+
   /* samples per frame */
   guint spf;
   /* bytes per frame */
@@ -64,6 +64,13 @@ setOptimizedMethods (PluginInfo * p)
   p->methods.zoom_filter = zoom_filter_c;
 /*    p->methods.create_output_with_brightness = create_output_with_brightness;*/
 
+#ifdef HAVE_ZOOM_FILTER_SSE2
+  /* SSE2 is always there when the compiler targets it, the MMX versions
+   * below are only used on i386 */
+  GST_INFO ("Using the SSE2 zoom filter");
+  p->methods.zoom_filter = zoom_filter_sse2;
+#endif
+
   GST_INFO ("orc cpu flags: 0x%08x", cpuFlavour);
 
 /* FIXME: what about HAVE_CPU_X86_64 ? */
@@ -153,6 +153,10 @@ gst_icydemux_reset (GstICYDemux * icydemux)
     icydemux->typefind_buf = NULL;
   }
 
+  g_free (icydemux->last_meta);
+  icydemux->last_meta = NULL;
+  icydemux->last_meta_size = 0;
+
   if (icydemux->content_type) {
     g_free (icydemux->content_type);
     icydemux->content_type = NULL;
@@ -332,6 +336,20 @@ gst_icydemux_parse_and_send_tags (GstICYDemux * icydemux)
 
   data = gst_adapter_map (icydemux->meta_adapter, length);
 
+  /* Nothing changed if it's the same block as last time, which would only
+   * result in the same tags again */
+  if (icydemux->last_meta && length == icydemux->last_meta_size &&
+      memcmp (data, icydemux->last_meta, length) == 0) {
+    GST_LOG_OBJECT (icydemux, "metadata unchanged");
+    gst_adapter_unmap (icydemux->meta_adapter);
+    gst_adapter_flush (icydemux->meta_adapter, length);
+    return;
+  }
+
+  g_free (icydemux->last_meta);
+  icydemux->last_meta = g_memdup (data, length);
+  icydemux->last_meta_size = length;
+
   /* Now, copy this to a buffer where we can NULL-terminate it to make things
    * a bit easier, then do that parsing. */
   buffer = g_strndup ((const gchar *) data, length);
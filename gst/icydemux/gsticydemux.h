@@ -69,6 +69,10 @@ struct _GstICYDemux
 
   GstAdapter *meta_adapter;
 
+  /* Last metadata block, servers tend to repeat it until the title changes */
+  guint8 *last_meta;
+  gint last_meta_size;
+
   GstBuffer *typefind_buf;
 
   /* upstream HTTP Content-Type */
@@ -36,6 +36,14 @@
  * This id3demux element replaced an older element with the same name which
  * relied on libid3tag from the MAD project.
  *
+ * Attached pictures and encapsulated objects can make up almost all of an
+ * ID3v2 tag. With #GstID3Demux:skip-binary-frames they are not parsed and
+ * don't end up in the tag list. Instead an element message named
+ * "id3demux-skipped-frame" is posted for each of them, with the frame ID
+ * ("frame-id", string), the byte offset of the frame header in the stream
+ * ("offset", guint64) and the size of the frame including its header ("size",
+ * guint), so that applications can read them later if needed.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -59,10 +67,12 @@
 enum
 {
   ARG_0,
-  ARG_PREFER_V1
+  ARG_PREFER_V1,
+  ARG_SKIP_BINARY_FRAMES
 };
 
 #define DEFAULT_PREFER_V1  FALSE
+#define DEFAULT_SKIP_BINARY_FRAMES FALSE
 
 GST_DEBUG_CATEGORY (id3demux_debug);
 #define GST_CAT_DEFAULT (id3demux_debug)
@@ -108,6 +118,21 @@ gst_id3demux_class_init (GstID3DemuxClass * klass)
           "and ID3v2 tags are present", DEFAULT_PREFER_V1,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstID3Demux:skip-binary-frames:
+   *
+   * Skip attached picture (APIC) and general encapsulated object (GEOB)
+   * frames in ID3v2 tags instead of parsing them into the tag list. An
+   * element message is posted with the location of every skipped frame.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, ARG_SKIP_BINARY_FRAMES,
+      g_param_spec_boolean ("skip-binary-frames", "Skip binary frames",
+          "Don't parse attached pictures and encapsulated objects in ID3v2 "
+          "tags, only post their location", DEFAULT_SKIP_BINARY_FRAMES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&sink_factory));
 
@@ -128,6 +153,7 @@ static void
 gst_id3demux_init (GstID3Demux * id3demux)
 {
   id3demux->prefer_v1 = DEFAULT_PREFER_V1;
+  id3demux->skip_binary_frames = DEFAULT_SKIP_BINARY_FRAMES;
 }
 
 static gboolean
@@ -173,13 +199,193 @@ gst_id3demux_add_container_format (GstTagList * tags)
   gst_caps_unref (sink_caps);
 }
 
+static gboolean
+gst_id3demux_is_binary_frame (const guint8 * id, guint id_len)
+{
+  if (id_len == 3)
+    return memcmp (id, "PIC", 3) == 0 || memcmp (id, "GEO", 3) == 0;
+
+  return memcmp (id, "APIC", 4) == 0 || memcmp (id, "GEOB", 4) == 0;
+}
+
+static guint32
+gst_id3demux_read_syncsafe (const guint8 * data)
+{
+  return (data[0] << 21) | (data[1] << 14) | (data[2] << 7) | data[3];
+}
+
+static void
+gst_id3demux_write_syncsafe (guint8 * data, guint32 val)
+{
+  data[0] = (val >> 21) & 0x7f;
+  data[1] = (val >> 14) & 0x7f;
+  data[2] = (val >> 7) & 0x7f;
+  data[3] = val & 0x7f;
+}
+
+/* Returns a copy of the ID3v2 tag in @buffer without the binary frames, or
+ * NULL if there were none or the tag can't be walked without the full
+ * parser. The kept frames are shared with @buffer, not copied. */
+static GstBuffer *
+gst_id3demux_strip_binary_frames (GstID3Demux * id3demux, GstBuffer * buffer,
+    guint tag_size)
+{
+  GstBuffer *out = NULL;
+  GstMapInfo map;
+  const guint8 *data;
+  guint8 *hdr;
+  guint size, pos, hdr_size, frame_hdr_size, id_len;
+  guint run_start, kept = 0, n_skipped = 0;
+  guint8 version, flags;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  data = map.data;
+  size = MIN (map.size, tag_size);
+
+  if (size < ID3V2_HDR_SIZE)
+    goto done;
+
+  version = data[3];
+  flags = data[5];
+
+  /* before 2.4 unsynchronisation applies to the frame headers as well, and
+   * in 2.2 the 0x40 flag means the whole tag is compressed */
+  if (version < 2 || version > 4 || ((flags & 0x80) && version < 4) ||
+      ((flags & 0x40) && version == 2))
+    goto done;
+
+  /* the footer is not part of the frames */
+  if ((flags & 0x10) && version == 4) {
+    if (size < 2 * ID3V2_HDR_SIZE)
+      goto done;
+    size -= ID3V2_HDR_SIZE;
+  }
+
+  hdr_size = ID3V2_HDR_SIZE;
+  if (flags & 0x40) {
+    guint ext_size;
+
+    if (size < ID3V2_HDR_SIZE + 4)
+      goto done;
+    /* the size of the extended header includes its size field only in 2.4 */
+    if (version == 3)
+      ext_size = GST_READ_UINT32_BE (data + ID3V2_HDR_SIZE);
+    else
+      ext_size = gst_id3demux_read_syncsafe (data + ID3V2_HDR_SIZE) - 4;
+    if (ext_size > size - ID3V2_HDR_SIZE - 4)
+      goto done;
+    hdr_size += ext_size + 4;
+  }
+
+  id_len = (version == 2) ? 3 : 4;
+  frame_hdr_size = (version == 2) ? 6 : 10;
+
+  pos = run_start = hdr_size;
+  while (pos + frame_hdr_size <= size && data[pos] != 0) {
+    const guint8 *f = data + pos;
+    guint frame_size;
+
+    if (version == 2) {
+      frame_size = GST_READ_UINT24_BE (f + 3);
+    } else if (version == 3) {
+      frame_size = GST_READ_UINT32_BE (f + 4);
+    } else {
+      if ((f[4] | f[5] | f[6] | f[7]) & 0x80)
+        goto failed;
+      frame_size = gst_id3demux_read_syncsafe (f + 4);
+    }
+
+    if (frame_size > size - pos - frame_hdr_size)
+      goto failed;
+    frame_size += frame_hdr_size;
+
+    if (gst_id3demux_is_binary_frame (f, id_len)) {
+      gchar id[5] = { 0, };
+
+      if (out == NULL)
+        out = gst_buffer_new ();
+      if (pos > run_start) {
+        gst_buffer_append (out, gst_buffer_copy_region (buffer,
+                GST_BUFFER_COPY_MEMORY, run_start, pos - run_start));
+        kept += pos - run_start;
+      }
+      run_start = pos + frame_size;
+
+      memcpy (id, f, id_len);
+      GST_DEBUG_OBJECT (id3demux, "skipping %s frame of %u bytes at offset %u",
+          id, frame_size, pos);
+      gst_element_post_message (GST_ELEMENT_CAST (id3demux),
+          gst_message_new_element (GST_OBJECT_CAST (id3demux),
+              gst_structure_new ("id3demux-skipped-frame",
+                  "frame-id", G_TYPE_STRING, id,
+                  "offset", G_TYPE_UINT64, (guint64) pos,
+                  "size", G_TYPE_UINT, frame_size, NULL)));
+      n_skipped++;
+    }
+
+    pos += frame_size;
+  }
+
+  if (out == NULL)
+    goto done;
+
+  /* the rest of the frames, padding is dropped */
+  if (pos > run_start) {
+    gst_buffer_append (out, gst_buffer_copy_region (buffer,
+            GST_BUFFER_COPY_MEMORY, run_start, pos - run_start));
+    kept += pos - run_start;
+  }
+
+  /* header with the new size, and without footer as that's gone now */
+  hdr = g_memdup (data, hdr_size);
+  hdr[5] &= ~0x10;
+  gst_id3demux_write_syncsafe (hdr + 6, hdr_size - ID3V2_HDR_SIZE + kept);
+  out = gst_buffer_append (gst_buffer_new_wrapped (hdr, hdr_size), out);
+
+  GST_INFO_OBJECT (id3demux, "skipped %u binary frames, parsing %u of %u "
+      "bytes", n_skipped, hdr_size + kept, size);
+
+done:
+  gst_buffer_unmap (buffer, &map);
+
+  return out;
+
+failed:
+  {
+    GST_DEBUG_OBJECT (id3demux, "can't walk frames at offset %u, parsing "
+        "the whole tag", pos);
+    if (out)
+      gst_buffer_unref (out);
+    out = NULL;
+    goto done;
+  }
+}
+
 static GstTagDemuxResult
 gst_id3demux_parse_tag (GstTagDemux * demux, GstBuffer * buffer,
     gboolean start_tag, guint * tag_size, GstTagList ** tags)
 {
   if (start_tag) {
+    GstID3Demux *id3demux = GST_ID3DEMUX (demux);
+    GstBuffer *stripped = NULL;
+    gboolean skip_binary_frames;
+
+    GST_OBJECT_LOCK (id3demux);
+    skip_binary_frames = id3demux->skip_binary_frames;
+    GST_OBJECT_UNLOCK (id3demux);
+
     *tag_size = gst_tag_get_id3v2_tag_size (buffer);
-    *tags = gst_tag_list_from_id3v2_tag (buffer);
+
+    if (skip_binary_frames)
+      stripped = gst_id3demux_strip_binary_frames (id3demux, buffer,
+          *tag_size);
+
+    if (stripped) {
+      *tags = gst_tag_list_from_id3v2_tag (stripped);
+      gst_buffer_unref (stripped);
+    } else {
+      *tags = gst_tag_list_from_id3v2_tag (buffer);
+    }
 
     if (G_LIKELY (*tags != NULL)) {
       gst_id3demux_add_container_format (*tags);
@@ -245,6 +451,12 @@ gst_id3demux_set_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (id3demux);
       break;
     }
+    case ARG_SKIP_BINARY_FRAMES:{
+      GST_OBJECT_LOCK (id3demux);
+      id3demux->skip_binary_frames = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (id3demux);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -265,6 +477,11 @@ gst_id3demux_get_property (GObject * object, guint prop_id,
       g_value_set_boolean (value, id3demux->prefer_v1);
       GST_OBJECT_UNLOCK (id3demux);
       break;
+    case ARG_SKIP_BINARY_FRAMES:
+      GST_OBJECT_LOCK (id3demux);
+      g_value_set_boolean (value, id3demux->skip_binary_frames);
+      GST_OBJECT_UNLOCK (id3demux);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
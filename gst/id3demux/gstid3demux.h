@@ -44,6 +44,7 @@ struct _GstID3Demux
   GstTagDemux tagdemux;
 
   gboolean prefer_v1;     /* prefer ID3v1 tags over ID3v2 tags? */
+  gboolean skip_binary_frames;  /* drop APIC/GEOB frames before parsing? */
 };
 
 struct _GstID3DemuxClass 
@@ -662,6 +662,20 @@ gst_image_freeze_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
   return ret;
 }
 
+static gboolean
+gst_image_freeze_buffer_needs_copy (GstBuffer * buffer)
+{
+  guint i, n = gst_buffer_n_memory (buffer);
+
+  for (i = 0; i < n; i++) {
+    if (GST_MEMORY_FLAG_IS_SET (gst_buffer_peek_memory (buffer, i),
+            GST_MEMORY_FLAG_NO_SHARE))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
 static GstFlowReturn
 gst_image_freeze_sink_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer)
@@ -676,7 +690,18 @@ gst_image_freeze_sink_chain (GstPad * pad, GstObject * parent,
     return GST_FLOW_EOS;
   }
 
-  self->buffer = buffer;
+  /* Every output buffer shares the memory of the stored one. Memory that
+   * can't be shared would be copied for every frame, so copy it once here.
+   * This also gives the upstream buffer, that might belong to a pool, back
+   * right away */
+  if (gst_image_freeze_buffer_needs_copy (buffer)) {
+    GST_DEBUG_OBJECT (pad, "Copying buffer with unshareable memory");
+    self->buffer = gst_buffer_copy_region (buffer,
+        GST_BUFFER_COPY_ALL | GST_BUFFER_COPY_DEEP, 0, -1);
+    gst_buffer_unref (buffer);
+  } else {
+    self->buffer = buffer;
+  }
 
   gst_pad_start_task (self->srcpad, (GstTaskFunction) gst_image_freeze_src_loop,
       self->srcpad, NULL);
@@ -701,8 +726,10 @@ gst_image_freeze_src_loop (GstPad * pad)
     gst_pad_pause_task (self->srcpad);
     return;
   }
-  buffer = gst_buffer_ref (self->buffer);
-  buffer = gst_buffer_make_writable (buffer);
+  /* only the metadata is copied, the timestamps are replaced below */
+  buffer = gst_buffer_copy_region (self->buffer,
+      GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_META | GST_BUFFER_COPY_MEMORY,
+      0, -1);
   g_mutex_unlock (&self->lock);
 
   if (self->need_segment) {
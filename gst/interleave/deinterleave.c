@@ -85,15 +85,56 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
         "rate = (int) [ 1, MAX ], "
         "channels = (int) [ 1, MAX ], layout = (string) interleaved"));
 
+/* All outputs are filled in one go. For the common channel counts the frame
+ * loop is instantiated with a constant number of channels so the compiler
+ * can unroll the channel loop and use vector shuffles, for other counts the
+ * input is read in blocks of frames that stay in the cache while all
+ * outputs are written. */
+#define DEINTERLEAVE_BLOCK 64
+
 #define MAKE_FUNC(type) \
-static void deinterleave_##type (guint##type *out, guint##type *in, \
-    guint stride, guint nframes) \
+static inline void deinterleave_frames_##type (guint##type **out, \
+    guint##type *in, guint channels, guint nframes) \
 { \
-  gint i; \
+  guint i, c; \
   \
   for (i = 0; i < nframes; i++) { \
-    out[i] = *in; \
-    in += stride; \
+    for (c = 0; c < channels; c++) \
+      out[c][i] = in[c]; \
+    in += channels; \
+  } \
+} \
+\
+static void deinterleave_##type (guint##type **out, guint##type *in, \
+    guint channels, guint nframes) \
+{ \
+  guint i, j, c, n; \
+  \
+  switch (channels) { \
+    case 2: \
+      deinterleave_frames_##type (out, in, 2, nframes); \
+      break; \
+    case 6: \
+      deinterleave_frames_##type (out, in, 6, nframes); \
+      break; \
+    case 8: \
+      deinterleave_frames_##type (out, in, 8, nframes); \
+      break; \
+    case 16: \
+      deinterleave_frames_##type (out, in, 16, nframes); \
+      break; \
+    default: \
+      for (i = 0; i < nframes; i += DEINTERLEAVE_BLOCK) { \
+        n = MIN (DEINTERLEAVE_BLOCK, nframes - i); \
+        for (c = 0; c < channels; c++) { \
+          guint##type *src = in + i * channels + c; \
+          guint##type *dst = out[c] + i; \
+          \
+          for (j = 0; j < n; j++) \
+            dst[j] = src[j * channels]; \
+        } \
+      } \
+      break; \
   } \
 }
 
@@ -103,14 +144,15 @@ MAKE_FUNC (32);
 MAKE_FUNC (64);
 
 static void
-deinterleave_24 (guint8 * out, guint8 * in, guint stride, guint nframes)
+deinterleave_24 (guint8 ** out, guint8 * in, guint channels, guint nframes)
 {
-  gint i;
+  guint i, c;
 
   for (i = 0; i < nframes; i++) {
-    memcpy (out, in, 3);
-    out += 3;
-    in += stride * 3;
+    for (c = 0; c < channels; c++) {
+      memcpy (out[c] + i * 3, in, 3);
+      in += 3;
+    }
   }
 }
 
@@ -682,8 +724,9 @@ gst_deinterleave_process (GstDeinterleave * self, GstBuffer * buf)
   guint bufsize = nframes * (GST_AUDIO_INFO_WIDTH (&self->audio_info) / 8);
   guint i;
   GList *srcs;
-  GstBuffer **buffers_out = g_new0 (GstBuffer *, channels);
-  guint8 *in, *out;
+  GstBuffer **buffers_out;
+  GstMapInfo *write_info;
+  gpointer *out;
   GstMapInfo read_info;
   GList *pending_events, *l;
 
@@ -706,6 +749,17 @@ gst_deinterleave_process (GstDeinterleave * self, GstBuffer * buf)
     g_list_free (pending_events);
   }
 
+  /* a single channel is already deinterleaved, pass it on as is */
+  if (channels == 1 && self->srcpads) {
+    GST_LOG_OBJECT (self, "passing through single channel buffer");
+    ret = gst_pad_push (GST_PAD (self->srcpads->data), buf);
+    return ret;
+  }
+
+  buffers_out = g_new0 (GstBuffer *, channels);
+  write_info = g_newa (GstMapInfo, channels);
+  out = g_newa (gpointer, channels);
+
   gst_buffer_map (buf, &read_info, GST_MAP_READ);
 
   /* Allocate buffers */
@@ -734,19 +788,25 @@ gst_deinterleave_process (GstDeinterleave * self, GstBuffer * buf)
     goto done;
   }
 
-  /* deinterleave */
+  /* every channel needs its output */
+  if (buffers_allocated != channels) {
+    ret = GST_FLOW_NOT_NEGOTIATED;
+    goto clean_buffers;
+  }
+
+  /* deinterleave all channels at once */
+  for (i = 0; i < channels; i++) {
+    gst_buffer_map (buffers_out[i], &write_info[i], GST_MAP_WRITE);
+    out[i] = write_info[i].data;
+  }
+  self->func (out, read_info.data, channels, nframes);
+  for (i = 0; i < channels; i++)
+    gst_buffer_unmap (buffers_out[i], &write_info[i]);
+
   for (srcs = self->srcpads, i = 0; srcs; srcs = srcs->next, i++) {
     GstPad *pad = (GstPad *) srcs->data;
-    GstMapInfo write_info;
 
-    in = (guint8 *) read_info.data;
-    in += i * (GST_AUDIO_INFO_WIDTH (&self->audio_info) / 8);
     if (buffers_out[i]) {
-      gst_buffer_map (buffers_out[i], &write_info, GST_MAP_WRITE);
-      out = (guint8 *) write_info.data;
-      self->func (out, in, channels, nframes);
-      gst_buffer_unmap (buffers_out[i], &write_info);
-
       ret = gst_pad_push (pad, buffers_out[i]);
       buffers_out[i] = NULL;
       if (ret == GST_FLOW_OK)
@@ -95,15 +95,56 @@ static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
         "layout = (string) interleaved")
     );
 
+/* All inputs are interleaved in one go. For the common channel counts the
+ * frame loop is instantiated with a constant number of channels so the
+ * compiler can unroll the channel loop and use vector shuffles, for other
+ * counts the output is written in blocks of frames that stay in the cache
+ * while all inputs are walked. */
+#define INTERLEAVE_BLOCK 64
+
 #define MAKE_FUNC(type) \
-static void interleave_##type (guint##type *out, guint##type *in, \
-    guint stride, guint nframes) \
+static inline void interleave_frames_##type (guint##type *out, \
+    guint##type **in, guint channels, guint nframes) \
 { \
-  gint i; \
+  guint i, c; \
   \
   for (i = 0; i < nframes; i++) { \
-    *out = in[i]; \
-    out += stride; \
+    for (c = 0; c < channels; c++) \
+      out[c] = in[c][i]; \
+    out += channels; \
+  } \
+} \
+\
+static void interleave_##type (guint##type *out, guint##type **in, \
+    guint channels, guint nframes) \
+{ \
+  guint i, j, c, n; \
+  \
+  switch (channels) { \
+    case 2: \
+      interleave_frames_##type (out, in, 2, nframes); \
+      break; \
+    case 6: \
+      interleave_frames_##type (out, in, 6, nframes); \
+      break; \
+    case 8: \
+      interleave_frames_##type (out, in, 8, nframes); \
+      break; \
+    case 16: \
+      interleave_frames_##type (out, in, 16, nframes); \
+      break; \
+    default: \
+      for (i = 0; i < nframes; i += INTERLEAVE_BLOCK) { \
+        n = MIN (INTERLEAVE_BLOCK, nframes - i); \
+        for (c = 0; c < channels; c++) { \
+          guint##type *src = in[c] + i; \
+          guint##type *dst = out + i * channels + c; \
+          \
+          for (j = 0; j < n; j++) \
+            dst[j * channels] = src[j]; \
+        } \
+      } \
+      break; \
   } \
 }
 
@@ -113,14 +154,15 @@ MAKE_FUNC (32);
 MAKE_FUNC (64);
 
 static void
-interleave_24 (guint8 * out, guint8 * in, guint stride, guint nframes)
+interleave_24 (guint8 * out, guint8 ** in, guint channels, guint nframes)
 {
-  gint i;
+  guint i, c;
 
   for (i = 0; i < nframes; i++) {
-    memcpy (out, in, 3);
-    out += stride * 3;
-    in += 3;
+    for (c = 0; c < channels; c++) {
+      memcpy (out, in[c] + i * 3, 3);
+      out += 3;
+    }
   }
 }
 
@@ -1221,53 +1263,96 @@ gst_interleave_collected (GstCollectPads * pads, GstInterleave * self)
 
   nsamples = size / width;
 
-  outbuf = gst_buffer_new_allocate (NULL, size * self->channels, NULL);
+  if (self->channels == 1) {
+    GstCollectData *cdata = (GstCollectData *) pads->data->data;
 
-  if (outbuf == NULL || gst_buffer_get_size (outbuf) < size * self->channels) {
-    gst_buffer_unref (outbuf);
-    return GST_FLOW_NOT_NEGOTIATED;
-  }
+    /* a single input is already interleaved, only the metadata changes
+     * and the memory is shared */
+    outbuf = gst_collect_pads_take_buffer (pads, cdata, size);
+    if (outbuf == NULL)
+      goto eos;
 
-  gst_buffer_map (outbuf, &write_info, GST_MAP_WRITE);
-  memset (write_info.data, 0, size * self->channels);
+    timestamp = GST_BUFFER_TIMESTAMP (outbuf);
+    outbuf = gst_buffer_make_writable (outbuf);
+    empty = GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP);
+  } else {
+    GstBuffer **inbufs = g_newa (GstBuffer *, self->channels);
+    GstMapInfo *input_info = g_newa (GstMapInfo, self->channels);
+    gpointer *indata = g_newa (gpointer, self->channels);
+    guint8 *silence = NULL;
+    guint c;
+
+    memset (inbufs, 0, self->channels * sizeof (GstBuffer *));
+    memset (indata, 0, self->channels * sizeof (gpointer));
+
+    for (collected = pads->data; collected != NULL;
+        collected = collected->next) {
+      GstCollectData *cdata;
+      GstBuffer *inbuf;
+      guint channel;
 
-  for (collected = pads->data; collected != NULL; collected = collected->next) {
-    GstCollectData *cdata;
-    GstBuffer *inbuf;
-    guint8 *outdata;
-    GstMapInfo input_info;
+      cdata = (GstCollectData *) collected->data;
+      channel = GST_INTERLEAVE_PAD_CAST (cdata->pad)->channel;
 
-    cdata = (GstCollectData *) collected->data;
+      inbuf = gst_collect_pads_take_buffer (pads, cdata, size);
+      if (inbuf == NULL) {
+        GST_DEBUG_OBJECT (cdata->pad, "No buffer available");
+        continue;
+      }
+      ncollected++;
 
-    inbuf = gst_collect_pads_take_buffer (pads, cdata, size);
-    if (inbuf == NULL) {
-      GST_DEBUG_OBJECT (cdata->pad, "No buffer available");
-      goto next;
-    }
-    ncollected++;
-    gst_buffer_map (inbuf, &input_info, GST_MAP_READ);
+      if (timestamp == -1)
+        timestamp = GST_BUFFER_TIMESTAMP (inbuf);
 
-    if (timestamp == -1)
-      timestamp = GST_BUFFER_TIMESTAMP (inbuf);
+      if (GST_BUFFER_FLAG_IS_SET (inbuf, GST_BUFFER_FLAG_GAP)
+          || channel >= self->channels) {
+        gst_buffer_unref (inbuf);
+        continue;
+      }
 
-    if (GST_BUFFER_FLAG_IS_SET (inbuf, GST_BUFFER_FLAG_GAP))
-      goto next;
+      empty = FALSE;
+      gst_buffer_map (inbuf, &input_info[channel], GST_MAP_READ);
+      inbufs[channel] = inbuf;
+      indata[channel] = input_info[channel].data;
+    }
 
-    empty = FALSE;
-    outdata =
-        write_info.data + width * GST_INTERLEAVE_PAD_CAST (cdata->pad)->channel;
+    if (ncollected == 0)
+      goto eos;
 
-    self->func (outdata, input_info.data, self->channels, nsamples);
-    gst_buffer_unmap (inbuf, &input_info);
+    outbuf = gst_buffer_new_allocate (NULL, size * self->channels, NULL);
 
-  next:
-    if (inbuf)
-      gst_buffer_unref (inbuf);
-  }
+    if (outbuf == NULL || gst_buffer_get_size (outbuf) < size * self->channels) {
+      gst_buffer_unref (outbuf);
+      outbuf = NULL;
+      ret = GST_FLOW_NOT_NEGOTIATED;
+    } else {
+      gst_buffer_map (outbuf, &write_info, GST_MAP_WRITE);
+      if (empty) {
+        memset (write_info.data, 0, size * self->channels);
+      } else {
+        /* missing and gap inputs are read from silence */
+        for (c = 0; c < self->channels; c++) {
+          if (indata[c] == NULL) {
+            if (silence == NULL)
+              silence = g_malloc0 (size);
+            indata[c] = silence;
+          }
+        }
+        self->func (write_info.data, indata, self->channels, nsamples);
+      }
+      gst_buffer_unmap (outbuf, &write_info);
+    }
 
-  if (ncollected == 0) {
-    gst_buffer_unmap (outbuf, &write_info);
-    goto eos;
+    for (c = 0; c < self->channels; c++) {
+      if (inbufs[c]) {
+        gst_buffer_unmap (inbufs[c], &input_info[c]);
+        gst_buffer_unref (inbufs[c]);
+      }
+    }
+    g_free (silence);
+
+    if (outbuf == NULL)
+      return ret;
   }
 
   GST_OBJECT_LOCK (self);
@@ -1340,8 +1425,6 @@ gst_interleave_collected (GstCollectPads * pads, GstInterleave * self)
   if (empty)
     GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_GAP);
 
-  gst_buffer_unmap (outbuf, &write_info);
-
   GST_LOG_OBJECT (self, "pushing outbuf, timestamp %" GST_TIME_FORMAT,
       GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (outbuf)));
   ret = gst_pad_push (self->src, outbuf);
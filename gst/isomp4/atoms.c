@@ -69,6 +69,62 @@ atoms_context_free (AtomsContext * context)
   g_free (context);
 }
 
+/* -- sample table spilling -- */
+
+/* in-memory entries a table holds before they are spilled to disk */
+#define ATOM_SPILL_ENTRIES 65536
+/* entries read back at a time when serializing */
+#define ATOM_SPILL_READ_ENTRIES 4096
+
+static void
+atom_spill_clear (AtomSpill * spill)
+{
+  if (spill->file)
+    fclose (spill->file);
+  spill->file = NULL;
+  spill->n_entries = 0;
+  spill->failed = FALSE;
+}
+
+/* appends @n serialized entries of @entry_size bytes; on failure spilling is
+ * disabled for this table and the caller keeps its entries in memory */
+static gboolean
+atom_spill_write (AtomSpill * spill, gconstpointer data, guint n,
+    guint entry_size)
+{
+  if (spill->failed)
+    return FALSE;
+
+  if (spill->file == NULL) {
+    spill->file = tmpfile ();
+    if (spill->file == NULL)
+      goto failed;
+  }
+  if (fseek (spill->file, 0, SEEK_END) != 0)
+    goto failed;
+  if (fwrite (data, entry_size, n, spill->file) != n)
+    goto failed;
+
+  spill->n_entries += n;
+  return TRUE;
+
+failed:
+  {
+    GST_WARNING ("Failed to spill sample table to disk, keeping it in memory");
+    spill->failed = TRUE;
+    return FALSE;
+  }
+}
+
+static gboolean
+atom_spill_read (AtomSpill * spill, guint32 index, gpointer data, guint n,
+    guint entry_size)
+{
+  if (fseek (spill->file, (long) index * entry_size, SEEK_SET) != 0)
+    return FALSE;
+  return fread (data, entry_size, n, spill->file) == n;
+}
+
 /* -- creation, initialization, clear and free functions -- */
 
 #define SECS_PER_DAY (24 * 60 * 60)
@@ -619,6 +675,8 @@ atom_stsz_init (AtomSTSZ * stsz)
   atom_array_init (&stsz->entries, 1024);
   stsz->sample_size = 0;
   stsz->table_size = 0;
+  stsz->run_size = 0;
+  memset (&stsz->spill, 0, sizeof (AtomSpill));
 }
 
 static void
@@ -626,7 +684,9 @@ atom_stsz_clear (AtomSTSZ * stsz)
 {
   atom_full_clear (&stsz->header);
   atom_array_clear (&stsz->entries);
+  atom_spill_clear (&stsz->spill);
   stsz->table_size = 0;
+  stsz->run_size = 0;
 }
 
 static void
@@ -652,6 +712,8 @@ atom_co64_init (AtomSTCO64 * co64)
 
   atom_full_init (&co64->header, FOURCC_stco, 0, 0, 0, flags);
   atom_array_init (&co64->entries, 256);
+  memset (&co64->spill, 0, sizeof (AtomSpill));
+  co64->spill_offset = 0;
 }
 
 static void
@@ -659,6 +721,8 @@ atom_stco64_clear (AtomSTCO64 * stco64)
 {
   atom_full_clear (&stco64->header);
   atom_array_clear (&stco64->entries);
+  atom_spill_clear (&stco64->spill);
+  stco64->spill_offset = 0;
 }
 
 static void
@@ -1883,13 +1947,27 @@ atom_stsz_copy_data (AtomSTSZ * stsz, guint8 ** buffer, guint64 * size,
     return 0;
   }
 
-  prop_copy_uint32 (stsz->sample_size, buffer, size, offset);
+  /* samples that all turned out to have the same size need no table */
+  if (stsz->sample_size == 0 && stsz->table_size &&
+      atom_array_get_len (&stsz->entries) == 0 && stsz->spill.n_entries == 0)
+    prop_copy_uint32 (stsz->run_size, buffer, size, offset);
+  else
+    prop_copy_uint32 (stsz->sample_size, buffer, size, offset);
   prop_copy_uint32 (stsz->table_size, buffer, size, offset);
-  if (stsz->sample_size == 0) {
+  if (stsz->sample_size == 0 && (atom_array_get_len (&stsz->entries) ||
+          stsz->spill.n_entries)) {
     /* minimize realloc */
     prop_copy_ensure_buffer (buffer, size, offset, 4 * stsz->table_size);
     /* entry count must match sample count */
-    g_assert (atom_array_get_len (&stsz->entries) == stsz->table_size);
+    g_assert (stsz->spill.n_entries + atom_array_get_len (&stsz->entries) ==
+        stsz->table_size);
+    /* spilled entries are stored serialized already */
+    if (stsz->spill.n_entries) {
+      if (buffer && !atom_spill_read (&stsz->spill, 0, *buffer + *offset,
+              stsz->spill.n_entries, 4))
+        return 0;
+      *offset += 4 * (guint64) stsz->spill.n_entries;
+    }
     for (i = 0; i < atom_array_get_len (&stsz->entries); i++) {
       prop_copy_uint32 (atom_array_index (&stsz->entries, i), buffer, size,
           offset);
@@ -1966,12 +2044,44 @@ atom_stco64_copy_data (AtomSTCO64 * stco64, guint8 ** buffer, guint64 * size,
     return 0;
   }
 
-  prop_copy_uint32 (atom_array_get_len (&stco64->entries), buffer, size,
-      offset);
+  prop_copy_uint32 (stco64->spill.n_entries +
+      atom_array_get_len (&stco64->entries), buffer, size, offset);
 
   /* minimize realloc */
   prop_copy_ensure_buffer (buffer, size, offset,
-      8 * atom_array_get_len (&stco64->entries));
+      8 * ((guint64) stco64->spill.n_entries +
+          atom_array_get_len (&stco64->entries)));
+
+  /* spilled entries are read back in blocks and still need any offset
+   * added since, and possibly truncating */
+  if (stco64->spill.n_entries) {
+    if (buffer) {
+      guint64 *block;
+      guint32 n, j;
+
+      block = g_new (guint64, ATOM_SPILL_READ_ENTRIES);
+      for (i = 0; i < stco64->spill.n_entries; i += n) {
+        n = MIN (ATOM_SPILL_READ_ENTRIES, stco64->spill.n_entries - i);
+        if (!atom_spill_read (&stco64->spill, i, block, n, 8)) {
+          g_free (block);
+          return 0;
+        }
+        for (j = 0; j < n; j++) {
+          guint64 value = GUINT64_FROM_BE (block[j]) + stco64->spill_offset;
+
+          if (trunc_to_32) {
+            prop_copy_uint32 ((guint32) value, buffer, size, offset);
+          } else {
+            prop_copy_uint64 (value, buffer, size, offset);
+          }
+        }
+      }
+      g_free (block);
+    } else {
+      *offset += (trunc_to_32 ? 4 : 8) * (guint64) stco64->spill.n_entries;
+    }
+  }
+
   for (i = 0; i < atom_array_get_len (&stco64->entries); i++) {
     guint64 *value = &atom_array_index (&stco64->entries, i);
 
@@ -2587,30 +2697,87 @@ atom_stts_add_entry (AtomSTTS * stts, guint32 sample_count, gint32 sample_delta)
   }
 }
 
+static void
+atom_stsz_spill (AtomSTSZ * stsz)
+{
+  guint i, len = atom_array_get_len (&stsz->entries);
+
+  for (i = 0; i < len; i++)
+    stsz->entries.data[i] = GUINT32_TO_BE (stsz->entries.data[i]);
+
+  if (atom_spill_write (&stsz->spill, stsz->entries.data, len, 4)) {
+    stsz->entries.len = 0;
+  } else {
+    for (i = 0; i < len; i++)
+      stsz->entries.data[i] = GUINT32_FROM_BE (stsz->entries.data[i]);
+  }
+}
+
+static void
+atom_stsz_append (AtomSTSZ * stsz, guint32 size)
+{
+  if (G_UNLIKELY (atom_array_get_len (&stsz->entries) >= ATOM_SPILL_ENTRIES))
+    atom_stsz_spill (stsz);
+  atom_array_append (&stsz->entries, size, 1024);
+}
+
 static void
 atom_stsz_add_entry (AtomSTSZ * stsz, guint32 nsamples, guint32 size)
 {
   guint32 i;
 
-  stsz->table_size += nsamples;
   if (stsz->sample_size != 0) {
     /* it is constant size, we don't need entries */
+    stsz->table_size += nsamples;
     return;
   }
+  if (atom_array_get_len (&stsz->entries) == 0 && stsz->spill.n_entries == 0) {
+    /* still a single run of identically sized samples */
+    if (stsz->table_size == 0 || stsz->run_size == size) {
+      stsz->run_size = size;
+      stsz->table_size += nsamples;
+      return;
+    }
+    /* no longer constant, so the run needs its entries after all */
+    for (i = 0; i < stsz->table_size; i++)
+      atom_stsz_append (stsz, stsz->run_size);
+  }
+  stsz->table_size += nsamples;
   for (i = 0; i < nsamples; i++) {
-    atom_array_append (&stsz->entries, size, 1024);
+    atom_stsz_append (stsz, size);
   }
 }
 
 static guint32
 atom_stco64_get_entry_count (AtomSTCO64 * stco64)
 {
-  return atom_array_get_len (&stco64->entries);
+  return stco64->spill.n_entries + atom_array_get_len (&stco64->entries);
+}
+
+static void
+atom_stco64_spill (AtomSTCO64 * stco64)
+{
+  guint i, len = atom_array_get_len (&stco64->entries);
+
+  for (i = 0; i < len; i++)
+    stco64->entries.data[i] = GUINT64_TO_BE (stco64->entries.data[i]);
+
+  if (atom_spill_write (&stco64->spill, stco64->entries.data, len, 8)) {
+    stco64->entries.len = 0;
+  } else {
+    for (i = 0; i < len; i++)
+      stco64->entries.data[i] = GUINT64_FROM_BE (stco64->entries.data[i]);
+  }
 }
 
 static void
 atom_stco64_add_entry (AtomSTCO64 * stco64, guint64 entry)
 {
+  /* spilled entries all need the same offset added later on, so stop
+   * spilling once some offset has been applied */
+  if (G_UNLIKELY (atom_array_get_len (&stco64->entries) >= ATOM_SPILL_ENTRIES
+          && stco64->spill_offset == 0))
+    atom_stco64_spill (stco64);
   atom_array_append (&stco64->entries, entry, 256);
   if (entry > G_MAXUINT32)
     stco64->header.header.type = FOURCC_co64;
@@ -2818,6 +2985,8 @@ atom_stco64_chunks_add_offset (AtomSTCO64 * stco64, guint32 offset)
 
     *value += offset;
   }
+  if (stco64->spill.n_entries)
+    stco64->spill_offset += offset;
 }
 
 void
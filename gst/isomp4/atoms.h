@@ -44,6 +44,7 @@
 #define __ATOMS_H__
 
 #include <glib.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "descriptors.h"
@@ -90,6 +91,16 @@ G_STMT_START {                                                                \
   (array)->data = NULL;                                                       \
 } G_STMT_END
 
+/* sample table entries moved out to an anonymous scratch file, already in
+ * their serialized (big endian) form, so long recordings do not keep
+ * growing in memory */
+typedef struct _AtomSpill
+{
+  FILE *file;
+  guint32 n_entries;
+  gboolean failed;
+} AtomSpill;
+
 /* light-weight context that may influence header atom tree construction */
 typedef enum _AtomsTreeFlavor
 {
@@ -453,7 +464,12 @@ typedef struct _AtomSTSZ
   /* need the size here because when sample_size is constant,
    * the list is empty */
   guint32 table_size;
+  /* size of all samples so far, while they happen to be identical and
+   * no entries are stored yet */
+  guint32 run_size;
   ATOM_ARRAY (guint32) entries;
+  /* entries preceding the in-memory ones */
+  AtomSpill spill;
 } AtomSTSZ;
 
 typedef struct _STSCEntry
@@ -480,6 +496,10 @@ typedef struct _AtomSTCO64
   AtomFull header;
 
   ATOM_ARRAY (guint64) entries;
+  /* entries preceding the in-memory ones, and the offset still to be
+   * added to them */
+  AtomSpill spill;
+  guint32 spill_offset;
 } AtomSTCO64;
 
 typedef struct _CTTSEntry
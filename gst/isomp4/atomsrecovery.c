@@ -77,6 +77,8 @@
  *   - gboolean  sync;
  *   - gboolean  do_pts;
  *   - guint64   pts_offset; (always present, ignored if do_pts is false)
+ *    qtmux batches entries in memory and appends them in blocks, so after a
+ *    crash the file may end in a partially written entry, which is ignored.
  *
  * The mdat file might contain ftyp and then mdat, in case this is the faststart
  * temporary file there is no ftyp and no mdat header, only the buffers data.
@@ -86,8 +88,22 @@
  * IMPORTANT: this is still at a experimental state.
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include "atomsrecovery.h"
 
+#ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+#endif
+#ifdef G_OS_WIN32
+#include <io.h>                 /* _commit */
+#endif
+
+/* number of buffer entries read at once when recovering */
+#define RECOV_ENTRIES_PER_READ 1024
+
 #define ATOMS_RECOV_OUTPUT_WRITE_ERROR(err) \
     g_set_error (err, ATOMS_RECOV_QUARK, ATOMS_RECOV_ERR_FILE, \
         "Failed to write to output file: %s", g_strerror (errno))
@@ -199,15 +215,20 @@ atoms_recov_write_trak_info (FILE * f, AtomTRAK * trak)
   return atom_size > 0 && writen == atom_size;
 }
 
-gboolean
-atoms_recov_write_trak_samples (FILE * f, AtomTRAK * trak, guint32 nsamples,
-    guint32 delta, guint32 size, guint64 chunk_offset, gboolean sync,
-    gboolean do_pts, gint64 pts_offset)
+/**
+ * Appends a TrakBufferEntryInfo to @entries. Entries are only batched in
+ * memory here, atoms_recov_flush_trak_samples() writes them out.
+ */
+void
+atoms_recov_write_trak_samples (GByteArray * entries, AtomTRAK * trak,
+    guint32 nsamples, guint32 delta, guint32 size, guint64 chunk_offset,
+    gboolean sync, gboolean do_pts, gint64 pts_offset)
 {
-  guint8 data[TRAK_BUFFER_ENTRY_INFO_SIZE];
-  /*
-   * We have to write a TrakBufferEntryInfo
-   */
+  guint8 *data;
+
+  g_byte_array_set_size (entries, entries->len + TRAK_BUFFER_ENTRY_INFO_SIZE);
+  data = entries->data + entries->len - TRAK_BUFFER_ENTRY_INFO_SIZE;
+
   GST_WRITE_UINT32_BE (data + 0, trak->tkhd.track_ID);
   GST_WRITE_UINT32_BE (data + 4, nsamples);
   GST_WRITE_UINT32_BE (data + 8, delta);
@@ -224,9 +245,38 @@ atoms_recov_write_trak_samples (FILE * f, AtomTRAK * trak, guint32 nsamples,
     GST_WRITE_UINT8 (data + 25, 0);
     GST_WRITE_UINT64_BE (data + 26, 0);
   }
+}
+
+/**
+ * Writes out all the batched entries in @entries with a single write and
+ * empties it. If @sync is TRUE the file data is also committed to disk.
+ */
+gboolean
+atoms_recov_flush_trak_samples (FILE * f, GByteArray * entries, gboolean sync)
+{
+  if (entries->len > 0) {
+    if (fwrite (entries->data, 1, entries->len, f) != entries->len)
+      return FALSE;
+    g_byte_array_set_size (entries, 0);
+  }
+
+  if (fflush (f) != 0)
+    return FALSE;
 
-  return fwrite (data, 1, TRAK_BUFFER_ENTRY_INFO_SIZE, f) ==
-      TRAK_BUFFER_ENTRY_INFO_SIZE;
+  if (sync) {
+#if defined (HAVE_FDATASYNC)
+    if (fdatasync (fileno (f)) < 0)
+      return FALSE;
+#elif defined (HAVE_FSYNC)
+    if (fsync (fileno (f)) < 0)
+      return FALSE;
+#elif defined (G_OS_WIN32)
+    if (_commit (fileno (f)) < 0)
+      return FALSE;
+#endif
+  }
+
+  return TRUE;
 }
 
 gboolean
@@ -726,16 +776,9 @@ moov_recov_file_free (MoovRecovFile * moovrf)
   g_free (moovrf);
 }
 
-static gboolean
-moov_recov_parse_buffer_entry (MoovRecovFile * moovrf, TrakBufferEntryInfo * b)
+static void
+moov_recov_parse_buffer_entry (const guint8 * data, TrakBufferEntryInfo * b)
 {
-  guint8 data[TRAK_BUFFER_ENTRY_INFO_SIZE];
-  gint read;
-
-  read = fread (data, 1, TRAK_BUFFER_ENTRY_INFO_SIZE, moovrf->file);
-  if (read != TRAK_BUFFER_ENTRY_INFO_SIZE)
-    return FALSE;
-
   b->track_id = GST_READ_UINT32_BE (data);
   b->nsamples = GST_READ_UINT32_BE (data + 4);
   b->delta = GST_READ_UINT32_BE (data + 8);
@@ -744,7 +787,6 @@ moov_recov_parse_buffer_entry (MoovRecovFile * moovrf, TrakBufferEntryInfo * b)
   b->sync = data[24] != 0;
   b->do_pts = data[25] != 0;
   b->pts_offset = GST_READ_UINT64_BE (data + 26);
-  return TRUE;
 }
 
 static gboolean
@@ -789,22 +831,40 @@ moov_recov_parse_buffers (MoovRecovFile * moovrf, MdatRecovFile * mdatrf,
 {
   TrakBufferEntryInfo entry;
   TrakRecovData *trak;
+  guint8 *data;
+  gsize n, i;
+  gboolean ret = TRUE;
+
+  data = g_malloc (TRAK_BUFFER_ENTRY_INFO_SIZE * RECOV_ENTRIES_PER_READ);
 
   /* we assume both moovrf and mdatrf are at the starting points of their
-   * data reading */
-  while (moov_recov_parse_buffer_entry (moovrf, &entry)) {
-    /* be sure we still have this data in mdat */
-    trak = moov_recov_get_trak (moovrf, entry.track_id);
-    if (trak == NULL) {
-      g_set_error (err, ATOMS_RECOV_QUARK, ATOMS_RECOV_ERR_PARSING,
-          "Invalid trak id found in buffer entry");
-      return FALSE;
+   * data reading. Entries are read in blocks, a truncated entry at the end
+   * (from a crash in the middle of a write) is ignored */
+  do {
+    n = fread (data, TRAK_BUFFER_ENTRY_INFO_SIZE, RECOV_ENTRIES_PER_READ,
+        moovrf->file);
+
+    for (i = 0; i < n; i++) {
+      moov_recov_parse_buffer_entry (data + i * TRAK_BUFFER_ENTRY_INFO_SIZE,
+          &entry);
+
+      /* be sure we still have this data in mdat */
+      trak = moov_recov_get_trak (moovrf, entry.track_id);
+      if (trak == NULL) {
+        g_set_error (err, ATOMS_RECOV_QUARK, ATOMS_RECOV_ERR_PARSING,
+            "Invalid trak id found in buffer entry");
+        ret = FALSE;
+        goto done;
+      }
+      if (!mdat_recov_add_sample (mdatrf, entry.size))
+        goto done;
+      trak_recov_data_add_sample (trak, &entry);
     }
-    if (!mdat_recov_add_sample (mdatrf, entry.size))
-      break;
-    trak_recov_data_add_sample (trak, &entry);
-  }
-  return TRUE;
+  } while (n == RECOV_ENTRIES_PER_READ);
+
+done:
+  g_free (data);
+  return ret;
 }
 
 static guint32
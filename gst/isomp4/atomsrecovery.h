@@ -138,11 +138,14 @@ gboolean atoms_recov_write_headers        (FILE * f, AtomFTYP * ftyp,
                                            GstBuffer * prefix, AtomMOOV * moov,
                                            guint32 timescale,
                                            guint32 traks_number);
-gboolean atoms_recov_write_trak_samples   (FILE * f, AtomTRAK * trak,
+void     atoms_recov_write_trak_samples   (GByteArray * entries,
+                                           AtomTRAK * trak,
                                            guint32 nsamples, guint32 delta,
                                            guint32 size, guint64 chunk_offset,
                                            gboolean sync, gboolean do_pts,
                                            gint64 pts_offset);
+gboolean atoms_recov_flush_trak_samples   (FILE * f, GByteArray * entries,
+                                           gboolean sync);
 
 MdatRecovFile * mdat_recov_file_create   (FILE * file, gboolean datafile,
                                           GError ** err);
@@ -79,6 +79,10 @@
  * If such fragmented layout is intended for streaming purposes, then
  * #GstQTMux:streamable allows foregoing to add index metadata (at the end of
  * file).
+ * When the maximum duration of the recording is known in advance,
+ * #GstQTMux:reserved-max-duration provides a faststart-like layout without
+ * the temporary file: space for the moov is reserved ahead of the media data
+ * and the moov is written into it at the end, provided it fits.
  *
  * <refsect2>
  * <title>Example pipelines</title>
@@ -182,19 +186,32 @@ enum
   PROP_DTS_METHOD,
 #endif
   PROP_DO_CTTS,
+  PROP_RESERVED_MAX_DURATION,
+  PROP_RESERVED_BYTES_PER_SEC,
+  PROP_MOOV_RECOV_FLUSH_INTERVAL,
+  PROP_MOOV_RECOV_FLUSH_BYTES,
+  PROP_MOOV_RECOV_SYNC,
 };
 
 /* some spare for header size as well */
 #define MDAT_LARGE_FILE_LIMIT           ((guint64) 1024 * 1024 * 1024 * 2)
 
+/* spare room in a moov reservation for tags and other late additions */
+#define RESERVED_MOOV_EXTRA_SIZE        4096
+
 #define DEFAULT_MOVIE_TIMESCALE         1000
 #define DEFAULT_TRAK_TIMESCALE          0
 #define DEFAULT_DO_CTTS                 TRUE
 #define DEFAULT_FAST_START              FALSE
 #define DEFAULT_FAST_START_TEMP_FILE    NULL
 #define DEFAULT_MOOV_RECOV_FILE         NULL
+#define DEFAULT_MOOV_RECOV_FLUSH_INTERVAL GST_SECOND
+#define DEFAULT_MOOV_RECOV_FLUSH_BYTES  (32 * 1024)
+#define DEFAULT_MOOV_RECOV_SYNC         FALSE
 #define DEFAULT_FRAGMENT_DURATION       0
 #define DEFAULT_STREAMABLE              TRUE
+#define DEFAULT_RESERVED_MAX_DURATION   GST_CLOCK_TIME_NONE
+#define DEFAULT_RESERVED_BYTES_PER_SEC  100
 #ifndef GST_REMOVE_DEPRECATED
 #define DEFAULT_DTS_METHOD              DTS_METHOD_REORDER
 #endif
@@ -358,6 +375,89 @@ gst_qt_mux_class_init (GstQTMuxClass * klass)
       g_param_spec_boolean ("streamable", "Streamable", streamable_desc,
           streamable,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstQTMux:reserved-max-duration
+   *
+   * Expected maximum duration of the recording. When set (and
+   * #GstQTMux:faststart is disabled), space for the moov is reserved at
+   * the start of the file and the moov is written into it on EOS, padded
+   * with a free atom. If the moov turns out not to fit, it is written at
+   * the end of the file as usual and the reserved space is left as a free
+   * atom.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_RESERVED_MAX_DURATION,
+      g_param_spec_uint64 ("reserved-max-duration",
+          "Reserved maximum file duration (ns)",
+          "When set, space for the headers is reserved at the start of the "
+          "file for a recording of at most this duration "
+          "(GST_CLOCK_TIME_NONE = disabled)",
+          0, G_MAXUINT64, DEFAULT_RESERVED_MAX_DURATION,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstQTMux:reserved-bytes-per-sec
+   *
+   * Estimated number of moov bytes needed per second of media and per
+   * stream, used together with #GstQTMux:reserved-max-duration to size the
+   * reserved header space.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_RESERVED_BYTES_PER_SEC,
+      g_param_spec_uint ("reserved-bytes-per-sec",
+          "Reserved bytes per second, per stream",
+          "Estimated header bytes needed per second of media in each stream "
+          "when reserving header space",
+          0, G_MAXUINT32, DEFAULT_RESERVED_BYTES_PER_SEC,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstQTMux:moov-recovery-flush-interval
+   *
+   * Sample entries for the #GstQTMux:moov-recovery-file are batched in
+   * memory and written out at most this long after the oldest pending one
+   * was added, or earlier when #GstQTMux:moov-recovery-flush-bytes is
+   * reached. Samples muxed since the last write are lost on a crash.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_MOOV_RECOV_FLUSH_INTERVAL,
+      g_param_spec_uint64 ("moov-recovery-flush-interval",
+          "Moov recovery flush interval (ns)",
+          "Maximum time to keep sample information for the moov recovery file "
+          "in memory before writing it out (0 = write every sample)",
+          0, G_MAXUINT64, DEFAULT_MOOV_RECOV_FLUSH_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstQTMux:moov-recovery-flush-bytes
+   *
+   * Amount of pending sample information after which it is written out to
+   * the #GstQTMux:moov-recovery-file regardless of
+   * #GstQTMux:moov-recovery-flush-interval.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_MOOV_RECOV_FLUSH_BYTES,
+      g_param_spec_uint ("moov-recovery-flush-bytes",
+          "Moov recovery flush bytes",
+          "Maximum number of bytes of sample information to keep in memory "
+          "before writing it to the moov recovery file (0 = write every sample)",
+          0, G_MAXUINT, DEFAULT_MOOV_RECOV_FLUSH_BYTES,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstQTMux:moov-recovery-sync
+   *
+   * Commit the #GstQTMux:moov-recovery-file to disk after each write, so
+   * that the recovery data also survives a system crash or power loss.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_MOOV_RECOV_SYNC,
+      g_param_spec_boolean ("moov-recovery-sync", "Moov recovery sync",
+          "Sync the moov recovery file to disk after each write",
+          DEFAULT_MOOV_RECOV_SYNC,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_qt_mux_request_new_pad);
@@ -404,6 +504,23 @@ gst_qt_mux_pad_reset (GstQTPad * qtpad)
 /*
  * Takes GstQTMux back to its initial state
  */
+static void
+gst_qt_mux_close_moov_recov_file (GstQTMux * qtmux)
+{
+  if (qtmux->moov_recov_file) {
+    if (!atoms_recov_flush_trak_samples (qtmux->moov_recov_file,
+            qtmux->moov_recov_entries, qtmux->moov_recov_sync))
+      GST_WARNING_OBJECT (qtmux, "Failed to write sample information to "
+          "recovery file");
+    fclose (qtmux->moov_recov_file);
+    qtmux->moov_recov_file = NULL;
+  }
+  if (qtmux->moov_recov_entries) {
+    g_byte_array_free (qtmux->moov_recov_entries, TRUE);
+    qtmux->moov_recov_entries = NULL;
+  }
+}
+
 static void
 gst_qt_mux_reset (GstQTMux * qtmux, gboolean alloc)
 {
@@ -413,6 +530,8 @@ gst_qt_mux_reset (GstQTMux * qtmux, gboolean alloc)
   qtmux->header_size = 0;
   qtmux->mdat_size = 0;
   qtmux->mdat_pos = 0;
+  qtmux->reserved_moov_pos = 0;
+  qtmux->reserved_moov_size = 0;
   qtmux->longest_chunk = GST_CLOCK_TIME_NONE;
   qtmux->video_pads = 0;
   qtmux->audio_pads = 0;
@@ -435,10 +554,7 @@ gst_qt_mux_reset (GstQTMux * qtmux, gboolean alloc)
     g_remove (qtmux->fast_start_file_path);
     qtmux->fast_start_file = NULL;
   }
-  if (qtmux->moov_recov_file) {
-    fclose (qtmux->moov_recov_file);
-    qtmux->moov_recov_file = NULL;
-  }
+  gst_qt_mux_close_moov_recov_file (qtmux);
   for (walk = qtmux->extra_atoms; walk; walk = g_slist_next (walk)) {
     AtomInfo *ainfo = (AtomInfo *) walk->data;
     ainfo->free_func (ainfo->atom);
@@ -1370,15 +1486,35 @@ fail:
   }
 }
 
+static GstFlowReturn
+gst_qt_mux_send_buffer_list (GstQTMux * qtmux, GstBufferList * list,
+    guint64 * offset)
+{
+  GstFlowReturn res;
+  gsize size = 0;
+  guint i, len;
+
+  g_return_val_if_fail (list != NULL, GST_FLOW_ERROR);
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len; i++)
+    size += gst_buffer_get_size (gst_buffer_list_get (list, i));
+  GST_LOG_OBJECT (qtmux, "sending buffer list of %u buffers, size %"
+      G_GSIZE_FORMAT, len, size);
+
+  res = gst_pad_push_list (qtmux->srcpad, list);
+
+  if (G_LIKELY (offset))
+    *offset += size;
+
+  return res;
+}
+
 /*
- * Sends the initial mdat atom fields (size fields and fourcc type),
- * the subsequent buffers are considered part of it's data.
- * As we can't predict the amount of data that we are going to place in mdat
- * we need to record the position of the size field in the stream so we can
- * seek back to it later and update when the streams have finished.
+ * Creates the initial mdat atom fields (size fields and fourcc type)
  */
-static GstFlowReturn
-gst_qt_mux_send_mdat_header (GstQTMux * qtmux, guint64 * off, guint64 size,
+static GstBuffer *
+gst_qt_mux_create_mdat_header (GstQTMux * qtmux, guint64 size,
     gboolean extended)
 {
   Atom *node_header;
@@ -1386,9 +1522,6 @@ gst_qt_mux_send_mdat_header (GstQTMux * qtmux, guint64 * off, guint64 size,
   guint8 *data = NULL;
   guint64 offset = 0;
 
-  GST_DEBUG_OBJECT (qtmux, "Sending mdat's atom header, "
-      "size %" G_GUINT64_FORMAT, size);
-
   node_header = g_malloc0 (sizeof (Atom));
   node_header->type = FOURCC_mdat;
   if (extended) {
@@ -1402,12 +1535,38 @@ gst_qt_mux_send_mdat_header (GstQTMux * qtmux, guint64 * off, guint64 size,
   }
 
   size = offset = 0;
-  if (atom_copy_data (node_header, &data, &size, &offset) == 0)
-    goto serialize_error;
+  if (atom_copy_data (node_header, &data, &size, &offset) == 0) {
+    g_free (node_header);
+    g_free (data);
+    return NULL;
+  }
 
   buf = _gst_buffer_new_take_data (data, offset);
   g_free (node_header);
 
+  return buf;
+}
+
+/*
+ * Sends the initial mdat atom fields (size fields and fourcc type),
+ * the subsequent buffers are considered part of it's data.
+ * As we can't predict the amount of data that we are going to place in mdat
+ * we need to record the position of the size field in the stream so we can
+ * seek back to it later and update when the streams have finished.
+ */
+static GstFlowReturn
+gst_qt_mux_send_mdat_header (GstQTMux * qtmux, guint64 * off, guint64 size,
+    gboolean extended)
+{
+  GstBuffer *buf;
+
+  GST_DEBUG_OBJECT (qtmux, "Sending mdat's atom header, "
+      "size %" G_GUINT64_FORMAT, size);
+
+  buf = gst_qt_mux_create_mdat_header (qtmux, size, extended);
+  if (buf == NULL)
+    goto serialize_error;
+
   GST_LOG_OBJECT (qtmux, "Pushing mdat start");
   return gst_qt_mux_send_buffer (qtmux, buf, off, FALSE);
 
@@ -1460,6 +1619,30 @@ gst_qt_mux_update_mdat_size (GstQTMux * qtmux, guint64 mdat_pos,
   return gst_qt_mux_send_buffer (qtmux, buf, offset, FALSE);
 }
 
+/*
+ * Sends a free atom spanning @size bytes (header included), used to
+ * reserve space for the moov and to pad whatever is left of it
+ */
+static GstFlowReturn
+gst_qt_mux_send_free_atom (GstQTMux * qtmux, guint64 * off, guint32 size)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  g_return_val_if_fail (size >= 8, GST_FLOW_ERROR);
+
+  GST_DEBUG_OBJECT (qtmux, "Sending free atom of size %u", size);
+
+  buf = gst_buffer_new_and_alloc (size);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  memset (map.data, 0, size);
+  GST_WRITE_UINT32_BE (map.data, size);
+  GST_WRITE_UINT32_LE (map.data + 4, FOURCC_free);
+  gst_buffer_unmap (buf, &map);
+
+  return gst_qt_mux_send_buffer (qtmux, buf, off, FALSE);
+}
+
 static GstFlowReturn
 gst_qt_mux_send_ftyp (GstQTMux * qtmux, guint64 * off)
 {
@@ -1662,6 +1845,33 @@ serialize_error:
   }
 }
 
+/*
+ * Estimates the space the moov will need at the end of a recording of
+ * #GstQTMux:reserved-max-duration: the sample-less moov as configured now,
+ * plus the per-stream sample table growth and some spare for tags
+ */
+static guint64
+gst_qt_mux_estimate_moov_size (GstQTMux * qtmux)
+{
+  guint64 size = 0, offset = 0, per_trak;
+  guint n_traks;
+
+  gst_qt_mux_configure_moov (qtmux, NULL);
+  if (!atom_moov_copy_data (qtmux->moov, NULL, &size, &offset))
+    return 0;
+
+  n_traks = g_slist_length (qtmux->sinkpads);
+  per_trak = gst_util_uint64_scale_ceil (qtmux->reserved_max_duration,
+      qtmux->reserved_bytes_per_sec, GST_SECOND);
+
+  size = offset + RESERVED_MOOV_EXTRA_SIZE + n_traks * per_trak;
+  GST_DEBUG_OBJECT (qtmux, "estimated moov size %" G_GUINT64_FORMAT
+      " for %u streams of %" GST_TIME_FORMAT, size, n_traks,
+      GST_TIME_ARGS (qtmux->reserved_max_duration));
+
+  return MIN (size, G_MAXUINT32);
+}
+
 static GstFlowReturn
 gst_qt_mux_start_file (GstQTMux * qtmux)
 {
@@ -1762,12 +1972,20 @@ gst_qt_mux_start_file (GstQTMux * qtmux)
               "file");
         }
       }
+      /* get the headers out before the first sample entries */
+      if (!fail && fflush (qtmux->moov_recov_file) != 0)
+        fail = TRUE;
       if (fail) {
         /* cleanup */
         fclose (qtmux->moov_recov_file);
         qtmux->moov_recov_file = NULL;
         GST_WARNING_OBJECT (qtmux, "An error was detected while writing to "
             "recover file, moov recovery won't work");
+      } else {
+        qtmux->moov_recov_entries =
+            g_byte_array_sized_new (MIN (qtmux->moov_recov_flush_bytes,
+                64 * 1024) + TRAK_BUFFER_ENTRY_INFO_SIZE);
+        qtmux->moov_recov_last_flush = gst_util_get_timestamp ();
       }
     }
   }
@@ -1820,6 +2038,22 @@ gst_qt_mux_start_file (GstQTMux * qtmux)
       if (!qtmux->streamable)
         qtmux->mfra = atom_mfra_new (qtmux->context);
     } else {
+      if (GST_CLOCK_TIME_IS_VALID (qtmux->reserved_max_duration) &&
+          !qtmux->streamable) {
+        /* keep room for the moov ahead of the media data, so it can be
+         * written in place at the end rather than after the mdat */
+        qtmux->reserved_moov_size = gst_qt_mux_estimate_moov_size (qtmux);
+        if (qtmux->reserved_moov_size >= 8) {
+          qtmux->reserved_moov_pos = qtmux->header_size;
+          ret = gst_qt_mux_send_free_atom (qtmux, &qtmux->header_size,
+              qtmux->reserved_moov_size);
+          if (ret != GST_FLOW_OK)
+            goto exit;
+          qtmux->mdat_pos = qtmux->header_size;
+        } else {
+          qtmux->reserved_moov_size = 0;
+        }
+      }
       /* extended to ensure some spare space */
       ret = gst_qt_mux_send_mdat_header (qtmux, &qtmux->header_size, 0, TRUE);
     }
@@ -2038,6 +2272,53 @@ gst_qt_mux_stop_file (GstQTMux * qtmux)
   }
   atom_moov_chunks_add_offset (qtmux->moov, offset);
 
+  /* if header space was reserved, write the moov into it if it fits */
+  if (qtmux->reserved_moov_size) {
+    guint64 moov_size = 0;
+    GstSegment segment;
+
+    size = 0;
+    if (!atom_moov_copy_data (qtmux->moov, NULL, &size, &moov_size))
+      goto serialize_error;
+    ret = gst_qt_mux_send_extra_atoms (qtmux, FALSE, &moov_size, FALSE);
+    if (ret != GST_FLOW_OK)
+      return ret;
+
+    GST_DEBUG_OBJECT (qtmux, "moov needs %" G_GUINT64_FORMAT " bytes, "
+        "reserved %" G_GUINT64_FORMAT, moov_size, qtmux->reserved_moov_size);
+
+    /* what is left over must still make up a valid free atom */
+    if (moov_size == qtmux->reserved_moov_size ||
+        moov_size + 8 <= qtmux->reserved_moov_size) {
+      gst_segment_init (&segment, GST_FORMAT_BYTES);
+      segment.start = qtmux->reserved_moov_pos;
+      gst_pad_push_event (qtmux->srcpad, gst_event_new_segment (&segment));
+
+      ret = gst_qt_mux_send_moov (qtmux, NULL, FALSE);
+      if (ret != GST_FLOW_OK)
+        return ret;
+      ret = gst_qt_mux_send_extra_atoms (qtmux, TRUE, NULL, FALSE);
+      if (ret != GST_FLOW_OK)
+        return ret;
+      if (moov_size < qtmux->reserved_moov_size) {
+        ret = gst_qt_mux_send_free_atom (qtmux, NULL,
+            qtmux->reserved_moov_size - moov_size);
+        if (ret != GST_FLOW_OK)
+          return ret;
+      }
+
+      GST_DEBUG_OBJECT (qtmux, "updating mdat size");
+      return gst_qt_mux_update_mdat_size (qtmux, qtmux->mdat_pos,
+          qtmux->mdat_size, NULL);
+    }
+
+    GST_ELEMENT_WARNING (qtmux, STREAM, MUX,
+        ("Not enough space was reserved for the headers"),
+        ("moov needs %" G_GUINT64_FORMAT " bytes, only %" G_GUINT64_FORMAT
+            " were reserved; writing it at the end of the file", moov_size,
+            qtmux->reserved_moov_size));
+  }
+
   /* moov */
   /* note: as of this point, we no longer care about tracking written data size,
    * since there is no more use for it anyway */
@@ -2105,6 +2386,7 @@ flush:
     guint64 size = 0, offset = 0;
     guint8 *data = NULL;
     GstBuffer *buffer;
+    GstBufferList *list;
     guint i, total_size;
 
     /* now we know where moof ends up, update offset in tfra */
@@ -2119,7 +2401,12 @@ flush:
     buffer = _gst_buffer_new_take_data (data, offset);
     GST_LOG_OBJECT (qtmux, "writing moof size %" G_GSIZE_FORMAT,
         gst_buffer_get_size (buffer));
-    ret = gst_qt_mux_send_buffer (qtmux, buffer, &qtmux->header_size, FALSE);
+
+    /* the whole fragment goes out in one go: moof, mdat header and
+     * the (uncopied) sample buffers */
+    list = gst_buffer_list_new_sized (2 +
+        atom_array_get_len (&pad->fragment_buffers));
+    gst_buffer_list_add (list, buffer);
 
     /* and actual data */
     total_size = 0;
@@ -2130,18 +2417,23 @@ flush:
 
     GST_LOG_OBJECT (qtmux, "writing %d buffers, total_size %d",
         atom_array_get_len (&pad->fragment_buffers), total_size);
-    if (ret == GST_FLOW_OK)
-      ret = gst_qt_mux_send_mdat_header (qtmux, &qtmux->header_size, total_size,
-          FALSE);
+    buffer = gst_qt_mux_create_mdat_header (qtmux, total_size, FALSE);
+    if (G_UNLIKELY (buffer == NULL)) {
+      GST_ELEMENT_ERROR (qtmux, STREAM, MUX, (NULL),
+          ("Failed to serialize mdat"));
+      ret = GST_FLOW_ERROR;
+    } else {
+      gst_buffer_list_add (list, buffer);
+    }
     for (i = 0; i < atom_array_get_len (&pad->fragment_buffers); i++) {
-      if (G_LIKELY (ret == GST_FLOW_OK))
-        ret = gst_qt_mux_send_buffer (qtmux,
-            atom_array_index (&pad->fragment_buffers, i), &qtmux->header_size,
-            FALSE);
-      else
-        gst_buffer_unref (atom_array_index (&pad->fragment_buffers, i));
+      gst_buffer_list_add (list, atom_array_index (&pad->fragment_buffers, i));
     }
 
+    if (G_LIKELY (ret == GST_FLOW_OK))
+      ret = gst_qt_mux_send_buffer_list (qtmux, list, &qtmux->header_size);
+    else
+      gst_buffer_list_unref (list);
+
     atom_array_clear (&pad->fragment_buffers);
     atom_moof_free (moof);
     qtmux->fragment_sequence++;
@@ -2206,13 +2498,27 @@ gst_qt_mux_register_and_push_sample (GstQTMux * qtmux, GstQTPad * pad,
 
   /* note that a new chunk is started each time (not fancy but works) */
   if (qtmux->moov_recov_file) {
-    if (!atoms_recov_write_trak_samples (qtmux->moov_recov_file, pad->trak,
-            nsamples, (gint32) scaled_duration, sample_size, chunk_offset, sync,
-            do_pts, pts_offset)) {
-      GST_WARNING_OBJECT (qtmux, "Failed to write sample information to "
-          "recovery file, disabling recovery");
-      fclose (qtmux->moov_recov_file);
-      qtmux->moov_recov_file = NULL;
+    GstClockTime now;
+
+    atoms_recov_write_trak_samples (qtmux->moov_recov_entries, pad->trak,
+        nsamples, (gint32) scaled_duration, sample_size, chunk_offset, sync,
+        do_pts, pts_offset);
+
+    /* batch the entries and only write them out once enough accumulated */
+    now = gst_util_get_timestamp ();
+    if (qtmux->moov_recov_entries->len >= qtmux->moov_recov_flush_bytes
+        || now - qtmux->moov_recov_last_flush >=
+        qtmux->moov_recov_flush_interval) {
+      qtmux->moov_recov_last_flush = now;
+      if (!atoms_recov_flush_trak_samples (qtmux->moov_recov_file,
+              qtmux->moov_recov_entries, qtmux->moov_recov_sync)) {
+        GST_WARNING_OBJECT (qtmux, "Failed to write sample information to "
+            "recovery file, disabling recovery");
+        fclose (qtmux->moov_recov_file);
+        qtmux->moov_recov_file = NULL;
+        g_byte_array_free (qtmux->moov_recov_entries, TRUE);
+        qtmux->moov_recov_entries = NULL;
+      }
     }
   }
 
@@ -3558,6 +3864,21 @@ gst_qt_mux_get_property (GObject * object,
     case PROP_STREAMABLE:
       g_value_set_boolean (value, qtmux->streamable);
       break;
+    case PROP_RESERVED_MAX_DURATION:
+      g_value_set_uint64 (value, qtmux->reserved_max_duration);
+      break;
+    case PROP_RESERVED_BYTES_PER_SEC:
+      g_value_set_uint (value, qtmux->reserved_bytes_per_sec);
+      break;
+    case PROP_MOOV_RECOV_FLUSH_INTERVAL:
+      g_value_set_uint64 (value, qtmux->moov_recov_flush_interval);
+      break;
+    case PROP_MOOV_RECOV_FLUSH_BYTES:
+      g_value_set_uint (value, qtmux->moov_recov_flush_bytes);
+      break;
+    case PROP_MOOV_RECOV_SYNC:
+      g_value_set_boolean (value, qtmux->moov_recov_sync);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3626,6 +3947,21 @@ gst_qt_mux_set_property (GObject * object,
       }
       break;
     }
+    case PROP_RESERVED_MAX_DURATION:
+      qtmux->reserved_max_duration = g_value_get_uint64 (value);
+      break;
+    case PROP_RESERVED_BYTES_PER_SEC:
+      qtmux->reserved_bytes_per_sec = g_value_get_uint (value);
+      break;
+    case PROP_MOOV_RECOV_FLUSH_INTERVAL:
+      qtmux->moov_recov_flush_interval = g_value_get_uint64 (value);
+      break;
+    case PROP_MOOV_RECOV_FLUSH_BYTES:
+      qtmux->moov_recov_flush_bytes = g_value_get_uint (value);
+      break;
+    case PROP_MOOV_RECOV_SYNC:
+      qtmux->moov_recov_sync = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -159,6 +159,9 @@ struct _GstQTMux
   guint64 mdat_size;
   /* position of mdat atom (for later updating) */
   guint64 mdat_pos;
+  /* position and size of the free atom holding space for the moov */
+  guint64 reserved_moov_pos;
+  guint64 reserved_moov_size;
 
   /* keep track of the largest chunk to fine-tune brands */
   GstClockTime longest_chunk;
@@ -178,6 +181,8 @@ struct _GstQTMux
 
   /* moov recovery */
   FILE *moov_recov_file;
+  GByteArray *moov_recov_entries;       /* entries not yet written out */
+  GstClockTime moov_recov_last_flush;
 
   /* fragment sequence */
   guint32 fragment_sequence;
@@ -193,8 +198,13 @@ struct _GstQTMux
 #endif
   gchar *fast_start_file_path;
   gchar *moov_recov_file_path;
+  GstClockTime moov_recov_flush_interval;
+  guint moov_recov_flush_bytes;
+  gboolean moov_recov_sync;
   guint32 fragment_duration;
   gboolean streamable;
+  GstClockTime reserved_max_duration;
+  guint32 reserved_bytes_per_sec;
 
   /* for request pad naming */
   guint video_pads, audio_pads, subtitle_pads;
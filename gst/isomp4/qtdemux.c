@@ -51,6 +51,7 @@
 #include "gst/gst-i18n-plugin.h"
 
 #include <glib/gprintf.h>
+#include <glib/gstdio.h>
 #include <gst/tag/tag.h>
 #include <gst/audio/audio.h>
 #include <gst/video/video.h>
@@ -72,6 +73,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 
 #include <math.h>
 #include <gst/math-compat.h>
@@ -129,6 +131,20 @@ struct _QtDemuxSample
 
 #define QTSAMPLE_KEYFRAME(stream,sample) ((stream)->all_keyframe || (sample)->keyframe)
 
+/* files in the index cache have this header, followed by the samples */
+typedef struct
+{
+  guint32 magic;
+  guint32 version;
+  guint32 sample_size;
+  guint32 n_samples;
+  guint32 all_keyframe;
+  guint32 reserved;
+} QtDemuxIndexCacheHeader;
+
+#define QTDEMUX_INDEX_CACHE_MAGIC   GST_MAKE_FOURCC ('q','t','i','x')
+#define QTDEMUX_INDEX_CACHE_VERSION 1
+
 /*
  * Quicktime has tracks and segments. A track is a continuous piece of
  * multimedia content. The track is not always played from start to finish but
@@ -234,6 +250,8 @@ struct _QtDemuxStream
   /* our samples */
   guint32 n_samples;
   QtDemuxSample *samples;
+  guint32 n_samples_allocated;  /* size of samples, can be more than n_samples
+                                 * for fragmented files */
   gboolean all_keyframe;        /* TRUE when all samples are keyframes (no stss) */
   guint32 min_duration;         /* duration in timescale of first sample, used for figuring out
                                    the framerate, in timescale units */
@@ -377,6 +395,15 @@ enum QtDemuxState
   QTDEMUX_STATE_BUFFER_MDAT     /* Buffering the mdat atom */
 };
 
+enum
+{
+  PROP_0,
+  PROP_INDEX_CACHE_DIR,
+  PROP_DVR_WINDOW
+};
+
+#define DEFAULT_DVR_WINDOW 0
+
 static GNode *qtdemux_tree_get_child_by_type (GNode * node, guint32 fourcc);
 static GNode *qtdemux_tree_get_child_by_type_full (GNode * node,
     guint32 fourcc, GstByteReader * parser);
@@ -414,6 +441,11 @@ GST_STATIC_PAD_TEMPLATE ("subtitle_%u",
 G_DEFINE_TYPE (GstQTDemux, gst_qtdemux, GST_TYPE_ELEMENT);
 
 static void gst_qtdemux_dispose (GObject * object);
+static void gst_qtdemux_finalize (GObject * object);
+static void gst_qtdemux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_qtdemux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static guint32
 gst_qtdemux_find_index_linear (GstQTDemux * qtdemux, QtDemuxStream * str,
@@ -487,6 +519,41 @@ gst_qtdemux_class_init (GstQTDemuxClass * klass)
   parent_class = g_type_class_peek_parent (klass);
 
   gobject_class->dispose = gst_qtdemux_dispose;
+  gobject_class->finalize = gst_qtdemux_finalize;
+  gobject_class->set_property = gst_qtdemux_set_property;
+  gobject_class->get_property = gst_qtdemux_get_property;
+
+  /**
+   * GstQTDemux:index-cache-dir:
+   *
+   * Directory where the sample tables of local files are stored after they
+   * have been built completely. When the same file, with the same size,
+   * modification time and moov atom, is opened again, the tables are loaded
+   * from there instead of being parsed.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_INDEX_CACHE_DIR,
+      g_param_spec_string ("index-cache-dir", "Index cache directory",
+          "Directory to cache sample tables in (NULL = disabled)", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstQTDemux:dvr-window:
+   *
+   * When playing a fragmented stream in push mode, only keep the samples
+   * of the last so many nanoseconds before the playback position in the
+   * sample table. This keeps the memory used by live streams that play
+   * for a long time bounded; seeking back further than the window is not
+   * possible anymore. 0 keeps all samples.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_DVR_WINDOW,
+      g_param_spec_uint64 ("dvr-window", "DVR window",
+          "Duration of already played fragmented samples to keep, "
+          "in nanoseconds (0 = all)", 0, G_MAXUINT64, DEFAULT_DVR_WINDOW,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_qtdemux_change_state);
 #if 0
@@ -528,6 +595,7 @@ gst_qtdemux_init (GstQTDemux * qtdemux)
   qtdemux->state = QTDEMUX_STATE_INITIAL;
   qtdemux->pullbased = FALSE;
   qtdemux->posted_redirect = FALSE;
+  qtdemux->dvr_window = DEFAULT_DVR_WINDOW;
   qtdemux->neededbytes = 16;
   qtdemux->todrop = 0;
   qtdemux->adapter = gst_adapter_new ();
@@ -565,6 +633,64 @@ gst_qtdemux_dispose (GObject * object)
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
+static void
+gst_qtdemux_finalize (GObject * object)
+{
+  GstQTDemux *qtdemux = GST_QTDEMUX (object);
+
+  g_free (qtdemux->index_cache_dir);
+  g_free (qtdemux->index_cache_key);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_qtdemux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstQTDemux *qtdemux = GST_QTDEMUX (object);
+
+  switch (prop_id) {
+    case PROP_INDEX_CACHE_DIR:
+      GST_OBJECT_LOCK (qtdemux);
+      g_free (qtdemux->index_cache_dir);
+      qtdemux->index_cache_dir = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (qtdemux);
+      break;
+    case PROP_DVR_WINDOW:
+      GST_OBJECT_LOCK (qtdemux);
+      qtdemux->dvr_window = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (qtdemux);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_qtdemux_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstQTDemux *qtdemux = GST_QTDEMUX (object);
+
+  switch (prop_id) {
+    case PROP_INDEX_CACHE_DIR:
+      GST_OBJECT_LOCK (qtdemux);
+      g_value_set_string (value, qtdemux->index_cache_dir);
+      GST_OBJECT_UNLOCK (qtdemux);
+      break;
+    case PROP_DVR_WINDOW:
+      GST_OBJECT_LOCK (qtdemux);
+      g_value_set_uint64 (value, qtdemux->dvr_window);
+      GST_OBJECT_UNLOCK (qtdemux);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_qtdemux_post_no_playable_stream_error (GstQTDemux * qtdemux)
 {
@@ -997,9 +1123,53 @@ parse_failed:
   }
 }
 
+/* find the index of the sample that includes the data for @mov_time with the
+ * run-length encoded stts table, without parsing the samples.
+ *
+ * Returns the index of the sample or -1 when the table can't be used.
+ */
+static guint32
+qtdemux_stts_find_index (QtDemuxStream * str, guint64 mov_time)
+{
+  GstByteReader stts;
+  guint64 time = 0;
+  guint32 index = 0;
+  guint32 i;
+
+  /* timestamps of chunks come from the stsc table */
+  if (str->chunks_are_samples || str->stts.data == NULL)
+    return -1;
+
+  /* skip version + flags and the number of entries */
+  gst_byte_reader_init (&stts, str->stts.data, str->stts.size);
+  if (!gst_byte_reader_skip (&stts, 1 + 3 + 4))
+    return -1;
+
+  for (i = 0; i < str->n_sample_times && index < str->n_samples; i++) {
+    guint32 stts_samples, stts_duration;
+
+    stts_samples = gst_byte_reader_get_uint32_be_unchecked (&stts);
+    stts_duration = gst_byte_reader_get_uint32_be_unchecked (&stts);
+
+    /* 'negative' durations make the timestamps non-monotonic */
+    if (G_UNLIKELY (stts_duration > G_MAXINT32))
+      return -1;
+
+    if (stts_duration > 0 &&
+        mov_time < time + (guint64) stts_samples * stts_duration) {
+      index += (mov_time - time) / stts_duration;
+      break;
+    }
+    time += (guint64) stts_samples * stts_duration;
+    index += stts_samples;
+  }
+  return MIN (index, str->n_samples - 1);
+}
+
 /* find the index of the sample that includes the data for @media_time using a
  * linear search, and keeping in mind that not all samples may have been parsed
- * yet.  If possible, it will delegate to binary search.
+ * yet.  If possible, it will delegate to binary search or get the index
+ * from the stts table.
  *
  * Returns the index of the sample.
  */
@@ -1022,6 +1192,15 @@ gst_qtdemux_find_index_linear (GstQTDemux * qtdemux, QtDemuxStream * str,
       mov_time <= str->samples[str->stbl_index].timestamp)
     return gst_qtdemux_find_index (qtdemux, str, media_time);
 
+  /* else parse all samples up to the one we need at once */
+  index = qtdemux_stts_find_index (str, mov_time);
+  if (index != -1) {
+    if (!qtdemux_parse_samples (qtdemux, str, index))
+      goto parse_failed;
+    return index;
+  }
+
+  index = 0;
   while (index < str->n_samples - 1) {
     if (!qtdemux_parse_samples (qtdemux, str, index + 1))
       goto parse_failed;
@@ -1829,6 +2008,8 @@ gst_qtdemux_reset (GstQTDemux * qtdemux, gboolean hard)
       g_node_destroy (qtdemux->moov_node);
     qtdemux->moov_node = NULL;
     qtdemux->moov_node_compressed = NULL;
+    g_free (qtdemux->index_cache_key);
+    qtdemux->index_cache_key = NULL;
     if (qtdemux->tag_list)
       gst_mini_object_unref (GST_MINI_OBJECT_CAST (qtdemux->tag_list));
     qtdemux->tag_list = NULL;
@@ -2141,6 +2322,7 @@ gst_qtdemux_stream_clear (QtDemuxStream * stream)
   }
   g_free (stream->samples);
   stream->samples = NULL;
+  stream->n_samples_allocated = 0;
   g_free (stream->segments);
   stream->segments = NULL;
   if (stream->pending_tags)
@@ -2430,6 +2612,65 @@ qtdemux_parse_trex (GstQTDemux * qtdemux, QtDemuxStream * stream,
   return TRUE;
 }
 
+/* drop the samples of @stream that are older than the DVR window before the
+ * current sample. Samples are only dropped once at least half of the table
+ * can go, so that the cost of moving the remaining ones stays amortized. */
+static void
+qtdemux_stream_drop_old_samples (GstQTDemux * qtdemux, QtDemuxStream * stream)
+{
+  QtDemuxSample *last;
+  guint64 window, end, limit;
+  guint32 drop, max_drop;
+
+  if (qtdemux->dvr_window == 0 || qtdemux->pullbased)
+    return;
+
+  /* samples of the moov are still being parsed from the sample table */
+  if (stream->stsz.data || stream->n_samples == 0)
+    return;
+
+  /* not playing yet */
+  if (stream->sample_index == -1 || stream->sample_index < 2)
+    return;
+
+  last = &stream->samples[stream->n_samples - 1];
+  window = gst_util_uint64_scale (qtdemux->dvr_window, stream->timescale,
+      GST_SECOND);
+  end = last->timestamp + last->duration;
+  if (end <= window)
+    return;
+  limit = end - window;
+
+  /* never drop the current sample, nor what comes after it */
+  max_drop = MIN (stream->sample_index, stream->n_samples - 1);
+  for (drop = 0; drop < max_drop; drop++)
+    if (stream->samples[drop].timestamp >= limit)
+      break;
+
+  /* keep the window starting on a keyframe */
+  if (!stream->all_keyframe) {
+    while (drop > 0 && !stream->samples[drop].keyframe)
+      drop--;
+  }
+
+  if (drop < stream->n_samples / 2)
+    return;
+
+  GST_DEBUG_OBJECT (qtdemux, "track %u: dropping %u of %u samples",
+      stream->track_id, drop, stream->n_samples);
+
+  memmove (stream->samples, stream->samples + drop,
+      (stream->n_samples - drop) * sizeof (QtDemuxSample));
+  stream->n_samples -= drop;
+  stream->sample_index -= drop;
+  stream->from_sample = stream->from_sample > drop ?
+      stream->from_sample - drop : 0;
+  if (stream->to_sample != G_MAXUINT32)
+    stream->to_sample = stream->to_sample > drop ?
+        stream->to_sample - drop : 0;
+  stream->stbl_index = MAX (stream->stbl_index - (gint64) drop, -1);
+}
+
 static gboolean
 qtdemux_parse_trun (GstQTDemux * qtdemux, GstByteReader * trun,
     QtDemuxStream * stream, guint32 d_sample_duration, guint32 d_sample_size,
@@ -2535,23 +2776,33 @@ qtdemux_parse_trun (GstQTDemux * qtdemux, GstByteReader * trun,
     goto fail;
   data = (guint8 *) gst_byte_reader_peek_data_unchecked (trun);
 
+  qtdemux_stream_drop_old_samples (qtdemux, stream);
+
   if (stream->n_samples >=
       QTDEMUX_MAX_SAMPLE_INDEX_SIZE / sizeof (QtDemuxSample))
     goto index_too_big;
 
-  GST_DEBUG_OBJECT (qtdemux, "allocating n_samples %u * %u (%.2f MB)",
-      stream->n_samples, (guint) sizeof (QtDemuxSample),
-      stream->n_samples * sizeof (QtDemuxSample) / (1024.0 * 1024.0));
+  /* make room for the new samples. The array grows by at least half its size
+   * so that adding fragments does not copy the whole array each time. */
+  if (stream->n_samples + samples_count > stream->n_samples_allocated) {
+    guint32 n_alloc;
 
-  /* create a new array of samples if it's the first sample parsed */
-  if (stream->n_samples == 0)
-    stream->samples = g_try_new0 (QtDemuxSample, samples_count);
-  /* or try to reallocate it with space enough to insert the new samples */
-  else
-    stream->samples = g_try_renew (QtDemuxSample, stream->samples,
-        stream->n_samples + samples_count);
-  if (stream->samples == NULL)
-    goto out_of_memory;
+    n_alloc = MAX (stream->n_samples + samples_count,
+        stream->n_samples_allocated + stream->n_samples_allocated / 2);
+    n_alloc = MIN (n_alloc,
+        QTDEMUX_MAX_SAMPLE_INDEX_SIZE / sizeof (QtDemuxSample));
+    if (n_alloc < stream->n_samples + samples_count)
+      goto index_too_big;
+
+    GST_DEBUG_OBJECT (qtdemux, "allocating n_samples %u * %u (%.2f MB)",
+        n_alloc, (guint) sizeof (QtDemuxSample),
+        n_alloc * sizeof (QtDemuxSample) / (1024.0 * 1024.0));
+
+    stream->samples = g_try_renew (QtDemuxSample, stream->samples, n_alloc);
+    if (stream->samples == NULL)
+      goto out_of_memory;
+    stream->n_samples_allocated = n_alloc;
+  }
 
   if (qtdemux->fragment_start != -1) {
     timestamp = gst_util_uint64_scale_int (qtdemux->fragment_start,
@@ -4915,7 +5166,8 @@ gst_qtdemux_process_adapter (GstQTDemux * demux, gboolean force)
           if (remaining_data_size > 0) {
             g_assert (demux->restoredata_buffer == NULL);
             demux->restoredata_buffer =
-                gst_adapter_take_buffer (demux->adapter, remaining_data_size);
+                gst_adapter_take_buffer_fast (demux->adapter,
+                remaining_data_size);
             demux->restoredata_offset = demux->offset + demux->neededbytes;
             GST_DEBUG_OBJECT (demux,
                 "Stored %" G_GSIZE_FORMAT " post mdat bytes at offset %"
@@ -4960,7 +5212,8 @@ gst_qtdemux_process_adapter (GstQTDemux * demux, gboolean force)
 
         GST_DEBUG_OBJECT (demux, "Got our buffer at offset %" G_GUINT64_FORMAT,
             demux->offset);
-        buf = gst_adapter_take_buffer (demux->adapter, demux->neededbytes);
+        /* avoid flattening a possibly large mdat into one allocation */
+        buf = gst_adapter_take_buffer_fast (demux->adapter, demux->neededbytes);
         gst_buffer_extract (buf, 0, fourcc, 4);
         GST_DEBUG_OBJECT (demux, "mdatbuffer starts with %" GST_FOURCC_FORMAT,
             GST_FOURCC_ARGS (QT_FOURCC (fourcc)));
@@ -5074,7 +5327,11 @@ gst_qtdemux_process_adapter (GstQTDemux * demux, gboolean force)
         sample = &stream->samples[stream->sample_index];
 
         if (G_LIKELY (!(STREAM_IS_EOS (stream)))) {
-          outbuf = gst_adapter_take_buffer (demux->adapter, demux->neededbytes);
+          /* samples inside a single upstream buffer come out as a shared
+           * sub-buffer, samples spanning several are built from their
+           * memories instead of being copied into a new one */
+          outbuf =
+              gst_adapter_take_buffer_fast (demux->adapter, demux->neededbytes);
           GST_DEBUG_OBJECT (demux, "stream : %" GST_FOURCC_FORMAT,
               GST_FOURCC_ARGS (stream->fourcc));
 
@@ -5253,42 +5510,258 @@ qtdemux_zfree (void *opaque, void *addr)
   g_free (addr);
 }
 
+/* inflates into a buffer of the uncompressed size given in the cmvd atom in
+ * a single pass; on return @length is set to the size actually produced */
 static void *
-qtdemux_inflate (void *z_buffer, guint z_length, guint length)
+qtdemux_inflate (void *z_buffer, guint z_length, guint * length)
 {
   guint8 *buffer;
-  z_stream *z;
+  z_stream z = { 0, };
   int ret;
 
-  z = g_new0 (z_stream, 1);
-  z->zalloc = qtdemux_zalloc;
-  z->zfree = qtdemux_zfree;
-  z->opaque = NULL;
+  z.zalloc = qtdemux_zalloc;
+  z.zfree = qtdemux_zfree;
+  z.opaque = NULL;
+
+  z.next_in = z_buffer;
+  z.avail_in = z_length;
+
+  if (inflateInit (&z) != Z_OK)
+    return NULL;
+
+  buffer = (guint8 *) g_malloc (*length);
+  z.next_out = buffer;
+  z.avail_out = *length;
+
+  ret = inflate (&z, Z_FINISH);
+  if (ret != Z_STREAM_END)
+    GST_WARNING ("inflate() returned %d, header might be incomplete", ret);
+
+  *length = z.total_out;
+  inflateEnd (&z);
+
+  return buffer;
+}
+#endif /* HAVE_ZLIB */
+
+/* make the key of the file in the index cache from the identity of the
+ * upstream file and the contents of the moov atom */
+static void
+qtdemux_index_cache_init_key (GstQTDemux * qtdemux, const guint8 * buffer,
+    guint length)
+{
+  GstQuery *query;
+  gchar *uri = NULL, *filename = NULL;
+  GStatBuf st;
+  GChecksum *checksum;
+  guint64 id[2];
+
+  g_free (qtdemux->index_cache_key);
+  qtdemux->index_cache_key = NULL;
+
+  GST_OBJECT_LOCK (qtdemux);
+  if (qtdemux->index_cache_dir == NULL) {
+    GST_OBJECT_UNLOCK (qtdemux);
+    return;
+  }
+  GST_OBJECT_UNLOCK (qtdemux);
+
+  query = gst_query_new_uri ();
+  if (gst_pad_peer_query (qtdemux->sinkpad, query))
+    gst_query_parse_uri (query, &uri);
+  gst_query_unref (query);
+
+  if (uri)
+    filename = g_filename_from_uri (uri, NULL, NULL);
+  if (filename == NULL || g_stat (filename, &st) != 0) {
+    GST_DEBUG_OBJECT (qtdemux, "no local file for %s, not using index cache",
+        GST_STR_NULL (uri));
+    goto done;
+  }
+
+  id[0] = st.st_size;
+  id[1] = st.st_mtime;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA1);
+  g_checksum_update (checksum, (const guchar *) id, sizeof (id));
+  g_checksum_update (checksum, buffer, length);
+  qtdemux->index_cache_key = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+
+  GST_DEBUG_OBJECT (qtdemux, "index cache key of %s is %s", filename,
+      qtdemux->index_cache_key);
+
+done:
+  g_free (filename);
+  g_free (uri);
+}
+
+static gchar *
+qtdemux_index_cache_path (GstQTDemux * qtdemux, QtDemuxStream * stream)
+{
+  gchar *name, *path;
 
-  z->next_in = z_buffer;
-  z->avail_in = z_length;
+  name = g_strdup_printf ("%s-%u.idx", qtdemux->index_cache_key,
+      stream->track_id);
+  GST_OBJECT_LOCK (qtdemux);
+  path = g_build_filename (qtdemux->index_cache_dir, name, NULL);
+  GST_OBJECT_UNLOCK (qtdemux);
+  g_free (name);
+
+  return path;
+}
+
+/* fill the sample table of @stream from the index cache */
+static gboolean
+qtdemux_index_cache_load (GstQTDemux * qtdemux, QtDemuxStream * stream)
+{
+  const QtDemuxIndexCacheHeader *header;
+  GMappedFile *file;
+  gchar *path;
+  gsize size;
+
+  path = qtdemux_index_cache_path (qtdemux, stream);
+  file = g_mapped_file_new (path, FALSE, NULL);
+  if (file == NULL) {
+    GST_DEBUG_OBJECT (qtdemux, "no cached index at %s", path);
+    g_free (path);
+    return FALSE;
+  }
+
+  size = g_mapped_file_get_length (file);
+  header = (const QtDemuxIndexCacheHeader *) g_mapped_file_get_contents (file);
+  if (size < sizeof (QtDemuxIndexCacheHeader) ||
+      header->magic != QTDEMUX_INDEX_CACHE_MAGIC ||
+      header->version != QTDEMUX_INDEX_CACHE_VERSION ||
+      header->sample_size != sizeof (QtDemuxSample) ||
+      header->n_samples != stream->n_samples ||
+      size != sizeof (QtDemuxIndexCacheHeader) +
+      (gsize) header->n_samples * sizeof (QtDemuxSample))
+    goto invalid;
+
+  memcpy (stream->samples, header + 1,
+      (gsize) stream->n_samples * sizeof (QtDemuxSample));
+  stream->all_keyframe = header->all_keyframe;
+  stream->stbl_index = stream->n_samples - 1;
+  gst_qtdemux_stbl_free (stream);
+
+  GST_DEBUG_OBJECT (qtdemux, "loaded %u samples from %s", stream->n_samples,
+      path);
+  g_mapped_file_unref (file);
+  g_free (path);
+
+  return TRUE;
 
-  buffer = (guint8 *) g_malloc (length);
-  ret = inflateInit (z);
-  while (z->avail_in > 0) {
-    if (z->avail_out == 0) {
-      length += 1024;
-      buffer = (guint8 *) g_realloc (buffer, length);
-      z->next_out = buffer + z->total_out;
-      z->avail_out = 1024;
+  /* ERRORS */
+invalid:
+  {
+    GST_WARNING_OBJECT (qtdemux, "ignoring invalid cached index %s", path);
+    g_mapped_file_unref (file);
+    g_free (path);
+    return FALSE;
+  }
+}
+
+/* store the complete sample table of @stream in the index cache */
+static void
+qtdemux_index_cache_save (GstQTDemux * qtdemux, QtDemuxStream * stream)
+{
+  QtDemuxIndexCacheHeader header = { 0, };
+  gchar *path, *tmp;
+  gboolean res;
+  FILE *f;
+
+  header.magic = QTDEMUX_INDEX_CACHE_MAGIC;
+  header.version = QTDEMUX_INDEX_CACHE_VERSION;
+  header.sample_size = sizeof (QtDemuxSample);
+  header.n_samples = stream->n_samples;
+  header.all_keyframe = stream->all_keyframe;
+
+  path = qtdemux_index_cache_path (qtdemux, stream);
+  /* write to a temporary file and rename, others may be reading the old one */
+  tmp = g_strdup_printf ("%s.%08x", path, g_random_int ());
+
+  if (!(f = g_fopen (tmp, "wb")))
+    goto open_failed;
+
+  res = fwrite (&header, sizeof (header), 1, f) == 1 &&
+      fwrite (stream->samples, sizeof (QtDemuxSample), stream->n_samples,
+      f) == stream->n_samples;
+  res = fclose (f) == 0 && res;
+
+  if (!res || g_rename (tmp, path) != 0)
+    goto write_failed;
+
+  GST_DEBUG_OBJECT (qtdemux, "stored %u samples in %s", stream->n_samples,
+      path);
+
+done:
+  g_free (tmp);
+  g_free (path);
+  return;
+
+  /* ERRORS */
+open_failed:
+  {
+    GST_WARNING_OBJECT (qtdemux, "could not create %s: %s", tmp,
+        g_strerror (errno));
+    goto done;
+  }
+write_failed:
+  {
+    GST_WARNING_OBJECT (qtdemux, "could not write %s", path);
+    g_unlink (tmp);
+    goto done;
+  }
+}
+
+static void
+qtdemux_index_cache_load_func (gpointer data, gpointer user_data)
+{
+  qtdemux_index_cache_load (GST_QTDEMUX_CAST (user_data),
+      (QtDemuxStream *) data);
+}
+
+/* load the cached indexes of all streams. Only the file I/O and the copy
+ * into each stream's own sample table happen here, so the streams are
+ * independent of each other and are loaded in parallel */
+static void
+qtdemux_index_cache_load_streams (GstQTDemux * qtdemux)
+{
+  GThreadPool *pool = NULL;
+  guint n_threads;
+  gint i;
+
+  if (qtdemux->index_cache_key == NULL || qtdemux->fragmented)
+    return;
+
+  n_threads = MIN (g_get_num_processors (), (guint) qtdemux->n_streams);
+  if (n_threads > 1) {
+    GError *err = NULL;
+
+    pool = g_thread_pool_new (qtdemux_index_cache_load_func, qtdemux,
+        n_threads, FALSE, &err);
+    if (pool == NULL) {
+      GST_WARNING_OBJECT (qtdemux, "failed to create index threads: %s",
+          err->message);
+      g_clear_error (&err);
     }
-    ret = inflate (z, Z_SYNC_FLUSH);
-    if (ret != Z_OK)
-      break;
   }
-  if (ret != Z_STREAM_END) {
-    g_warning ("inflate() returned %d", ret);
+
+  for (i = 0; i < qtdemux->n_streams; i++) {
+    QtDemuxStream *stream = qtdemux->streams[i];
+
+    if (!stream->n_samples || !stream->samples)
+      continue;
+
+    if (pool == NULL || !g_thread_pool_push (pool, stream, NULL))
+      qtdemux_index_cache_load (qtdemux, stream);
   }
 
-  g_free (z);
-  return buffer;
+  /* wait for all of them */
+  if (pool)
+    g_thread_pool_free (pool, FALSE, TRUE);
 }
-#endif /* HAVE_ZLIB */
 
 static gboolean
 qtdemux_parse_moov (GstQTDemux * qtdemux, const guint8 * buffer, guint length)
@@ -5297,6 +5770,8 @@ qtdemux_parse_moov (GstQTDemux * qtdemux, const guint8 * buffer, guint length)
 
   qtdemux->moov_node = g_node_new ((guint8 *) buffer);
 
+  qtdemux_index_cache_init_key (qtdemux, buffer, length);
+
   /* counts as header data */
   qtdemux->header_size += length;
 
@@ -5322,13 +5797,23 @@ qtdemux_parse_moov (GstQTDemux * qtdemux, const guint8 * buffer, guint length)
         guint compressed_length;
         guint8 *buf;
 
+        if (QT_UINT32 ((guint8 *) cmvd->data) < 12)
+          goto invalid_compression;
         uncompressed_length = QT_UINT32 ((guint8 *) cmvd->data + 8);
-        compressed_length = QT_UINT32 ((guint8 *) cmvd->data + 4) - 12;
+        compressed_length = QT_UINT32 ((guint8 *) cmvd->data) - 12;
         GST_LOG ("length = %u", uncompressed_length);
 
+        /* deflate can't expand by more than about 1:1032, don't let a bogus
+         * length make us allocate more than that */
+        if (uncompressed_length == 0 ||
+            uncompressed_length / 1032 > compressed_length)
+          goto invalid_compression;
+
         buf =
             (guint8 *) qtdemux_inflate ((guint8 *) cmvd->data + 12,
-            compressed_length, uncompressed_length);
+            compressed_length, &uncompressed_length);
+        if (buf == NULL)
+          goto invalid_compression;
 
         qtdemux->moov_node_compressed = qtdemux->moov_node;
         qtdemux->moov_node = g_node_new (buf);
@@ -6319,6 +6804,7 @@ qtdemux_stbl_init (GstQTDemux * qtdemux, QtDemuxStream * stream, GNode * stbl)
         stream->n_samples);
     return FALSE;
   }
+  stream->n_samples_allocated = stream->n_samples;
 
 
   /* composition time-to-sample */
@@ -6744,6 +7230,8 @@ done:
   stream->stbl_index = n;
   /* if index has been completely parsed, free data that is no-longer needed */
   if (n + 1 == stream->n_samples) {
+    if (qtdemux->index_cache_key && !qtdemux->fragmented && stream->stsz.data)
+      qtdemux_index_cache_save (qtdemux, stream);
     gst_qtdemux_stbl_free (stream);
     GST_DEBUG_OBJECT (qtdemux,
         "parsed all available samples; checking for more");
@@ -8539,7 +9027,8 @@ qtdemux_parse_trak (GstQTDemux * qtdemux, GNode * trak)
     stream->sampled = TRUE;
   }
 
-  /* collect sample information */
+  /* collect sample information; a cached index is loaded for all streams
+   * at once by qtdemux_index_cache_load_streams() */
   if (!qtdemux_stbl_init (qtdemux, stream, stbl))
     goto samples_failed;
 
@@ -10150,6 +10639,8 @@ qtdemux_parse_tree (GstQTDemux * qtdemux)
     trak = qtdemux_tree_get_sibling_by_type (trak, FOURCC_trak);
   }
 
+  qtdemux_index_cache_load_streams (qtdemux);
+
   /* set duration in the segment info */
   gst_qtdemux_get_duration (qtdemux, &duration);
   if (duration) {
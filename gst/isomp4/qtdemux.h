@@ -145,6 +145,15 @@ struct _GstQTDemux {
   guint64 fragment_start_offset;
     
   gint64 chapters_track_id;
+
+  /* directory of the sample index cache and the key of the current file in
+   * it, NULL when not used */
+  gchar *index_cache_dir;
+  gchar *index_cache_key;
+
+  /* in push mode, how much of already played fragmented samples to keep,
+   * 0 keeps all of them */
+  GstClockTime dvr_window;
 };
 
 struct _GstQTDemuxClass {
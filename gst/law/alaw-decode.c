@@ -20,6 +20,9 @@
  * SECTION:element-alawdec
  *
  * This element decodes alaw audio. Alaw coding is also known as G.711.
+ *
+ * If downstream only accepts mu-law the A-law input is converted to it
+ * directly with a lookup table, without going through linear audio.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -27,6 +30,7 @@
 #endif
 
 #include "alaw-decode.h"
+#include "mulaw-conversion.h"
 
 extern GstStaticPadTemplate alaw_dec_src_factory;
 extern GstStaticPadTemplate alaw_dec_sink_factory;
@@ -134,11 +138,30 @@ gst_alaw_dec_setcaps (GstALawDec * alawdec, GstCaps * caps)
   gst_audio_info_set_format (&info, GST_AUDIO_FORMAT_S16, rate, channels, NULL);
 
   outcaps = gst_audio_info_to_caps (&info);
+  alawdec->transcode = FALSE;
+
+  /* prefer linear output, but go to mu-law directly if that is all
+   * downstream takes */
+  if (!gst_pad_peer_query_accept_caps (alawdec->srcpad, outcaps)) {
+    GstCaps *mulaw_caps;
+
+    mulaw_caps = gst_caps_new_simple ("audio/x-mulaw",
+        "rate", G_TYPE_INT, rate, "channels", G_TYPE_INT, channels, NULL);
+    if (gst_pad_peer_query_accept_caps (alawdec->srcpad, mulaw_caps)) {
+      gst_caps_unref (outcaps);
+      outcaps = mulaw_caps;
+      alawdec->transcode = TRUE;
+    } else {
+      gst_caps_unref (mulaw_caps);
+    }
+  }
+
   ret = gst_pad_set_caps (alawdec->srcpad, outcaps);
   gst_caps_unref (outcaps);
 
   if (ret) {
-    GST_DEBUG_OBJECT (alawdec, "rate=%d, channels=%d", rate, channels);
+    GST_DEBUG_OBJECT (alawdec, "rate=%d, channels=%d, transcode=%d", rate,
+        channels, alawdec->transcode);
     alawdec->info = info;
   }
   return ret;
@@ -192,6 +215,20 @@ gst_alaw_dec_getcaps (GstPad * pad, GstCaps * filter)
             GST_AUDIO_NE (S16), "layout", G_TYPE_STRING, "interleaved", NULL);
       }
     }
+    if (pad == alawdec->srcpad) {
+      GstCaps *mulaw;
+
+      /* we can also produce mu-law in the same rates and channels */
+      mulaw = gst_caps_copy (othercaps);
+      for (i = 0; i < gst_caps_get_size (mulaw); i++) {
+        GstStructure *structure;
+
+        structure = gst_caps_get_structure (mulaw, i);
+        gst_structure_set_name (structure, "audio/x-mulaw");
+        gst_structure_remove_fields (structure, "format", "layout", NULL);
+      }
+      gst_caps_append (othercaps, mulaw);
+    }
     /* filter against the allowed caps of the pad to return our result */
     result = gst_caps_intersect (othercaps, templ);
     gst_caps_unref (othercaps);
@@ -273,6 +310,8 @@ gst_alaw_dec_init (GstALawDec * alawdec)
   gst_pad_set_query_function (alawdec->srcpad,
       GST_DEBUG_FUNCPTR (gst_alaw_dec_query));
   gst_element_add_pad (GST_ELEMENT (alawdec), alawdec->srcpad);
+
+  alawdec->transcode = FALSE;
 }
 
 static gboolean
@@ -326,7 +365,10 @@ gst_alaw_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   alaw_data = inmap.data;
   alaw_size = inmap.size;
 
-  linear_size = alaw_size * 2;
+  if (alawdec->transcode)
+    linear_size = alaw_size;
+  else
+    linear_size = alaw_size * 2;
 
   outbuf = gst_buffer_new_allocate (NULL, linear_size, NULL);
 
@@ -342,12 +384,16 @@ gst_alaw_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     GST_BUFFER_DURATION (outbuf) = GST_BUFFER_DURATION (buffer);
   } else {
     GST_BUFFER_DURATION (outbuf) = gst_util_uint64_scale_int (GST_SECOND,
-        linear_size, GST_AUDIO_INFO_RATE (&alawdec->info) *
-        GST_AUDIO_INFO_BPF (&alawdec->info));
+        alaw_size, GST_AUDIO_INFO_RATE (&alawdec->info) *
+        GST_AUDIO_INFO_CHANNELS (&alawdec->info));
   }
 
-  for (i = 0; i < alaw_size; i++) {
-    linear_data[i] = alaw_to_s16 (alaw_data[i]);
+  if (alawdec->transcode) {
+    alaw_to_mulaw (alaw_data, outmap.data, alaw_size);
+  } else {
+    for (i = 0; i < alaw_size; i++) {
+      linear_data[i] = alaw_to_s16 (alaw_data[i]);
+    }
   }
 
   gst_buffer_unmap (outbuf, &outmap);
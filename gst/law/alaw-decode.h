@@ -44,6 +44,9 @@ struct _GstALawDec {
 
   GstPad *sinkpad,*srcpad;
   GstAudioInfo info;
+
+  /* output is mu-law, converted from A-law directly */
+  gboolean transcode;
 };
 
 struct _GstALawDecClass {
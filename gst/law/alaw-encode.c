@@ -20,6 +20,10 @@
  * SECTION:element-alawenc
  *
  * This element encode alaw audio. Alaw coding is also known as G.711.
+ *
+ * Besides 16 bit linear audio the element also accepts mu-law input, which
+ * is then converted to A-law directly with a lookup table, as needed when
+ * bridging G.711 calls between the two companding laws.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -28,6 +32,7 @@
 
 #include <gst/audio/audio.h>
 #include "alaw-encode.h"
+#include "mulaw-conversion.h"
 
 GST_DEBUG_CATEGORY_STATIC (alaw_enc_debug);
 #define GST_CAT_DEFAULT alaw_enc_debug
@@ -348,6 +353,20 @@ gst_alaw_enc_getcaps (GstPad * pad, GstCaps * filter)
             GST_AUDIO_NE (S16), NULL);
       }
     }
+    if (pad == alawenc->sinkpad) {
+      GstCaps *mulaw;
+
+      /* we can also take mu-law in the same rates and channels */
+      mulaw = gst_caps_copy (othercaps);
+      for (i = 0; i < gst_caps_get_size (mulaw); i++) {
+        GstStructure *structure;
+
+        structure = gst_caps_get_structure (mulaw, i);
+        gst_structure_set_name (structure, "audio/x-mulaw");
+        gst_structure_remove_fields (structure, "format", "layout", NULL);
+      }
+      gst_caps_append (othercaps, mulaw);
+    }
     /* filter against the allowed caps of the pad to return our result */
     result = gst_caps_intersect (othercaps, templ);
     gst_caps_unref (templ);
@@ -402,6 +421,7 @@ gst_alaw_enc_setcaps (GstALawEnc * alawenc, GstCaps * caps)
   structure = gst_caps_get_structure (caps, 0);
   gst_structure_get_int (structure, "channels", &alawenc->channels);
   gst_structure_get_int (structure, "rate", &alawenc->rate);
+  alawenc->transcode = gst_structure_has_name (structure, "audio/x-mulaw");
 
   base_caps = gst_pad_get_pad_template_caps (alawenc->srcpad);
   base_caps = gst_caps_make_writable (base_caps);
@@ -410,8 +430,8 @@ gst_alaw_enc_setcaps (GstALawEnc * alawenc, GstCaps * caps)
   gst_structure_set (structure, "channels", G_TYPE_INT, alawenc->channels,
       NULL);
 
-  GST_DEBUG_OBJECT (alawenc, "rate=%d, channels=%d", alawenc->rate,
-      alawenc->channels);
+  GST_DEBUG_OBJECT (alawenc, "rate=%d, channels=%d, transcode=%d",
+      alawenc->rate, alawenc->channels, alawenc->transcode);
 
   ret = gst_pad_set_caps (alawenc->srcpad, base_caps);
 
@@ -461,6 +481,7 @@ gst_alaw_enc_init (GstALawEnc * alawenc)
   /* init rest */
   alawenc->channels = 0;
   alawenc->rate = 0;
+  alawenc->transcode = FALSE;
 }
 
 static gboolean
@@ -513,7 +534,10 @@ gst_alaw_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   linear_data = (gint16 *) inmap.data;
   linear_size = inmap.size;
 
-  alaw_size = linear_size / 2;
+  if (alawenc->transcode)
+    alaw_size = linear_size;
+  else
+    alaw_size = linear_size / 2;
 
   timestamp = GST_BUFFER_TIMESTAMP (buffer);
   duration = GST_BUFFER_DURATION (buffer);
@@ -539,8 +563,12 @@ gst_alaw_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   GST_BUFFER_TIMESTAMP (outbuf) = timestamp;
   GST_BUFFER_DURATION (outbuf) = duration;
 
-  for (i = 0; i < alaw_size; i++) {
-    alaw_data[i] = s16_to_alaw (linear_data[i]);
+  if (alawenc->transcode) {
+    mulaw_to_alaw (inmap.data, alaw_data, alaw_size);
+  } else {
+    for (i = 0; i < alaw_size; i++) {
+      alaw_data[i] = s16_to_alaw (linear_data[i]);
+    }
   }
 
   gst_buffer_unmap (outbuf, &outmap);
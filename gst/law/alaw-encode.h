@@ -46,6 +46,9 @@ struct _GstALawEnc {
 
   gint channels;
   gint rate;
+
+  /* input is mu-law, converted to A-law directly */
+  gboolean transcode;
 };
 
 struct _GstALawEncClass {
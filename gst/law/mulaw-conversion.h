@@ -7,6 +7,10 @@ void
 mulaw_encode(gint16* in, guint8* out, gint numsamples);
 void
 mulaw_decode(guint8* in,gint16* out,gint numsamples);
+void
+mulaw_to_alaw(const guint8* in,guint8* out,gint numsamples);
+void
+alaw_to_mulaw(const guint8* in,guint8* out,gint numsamples);
 
 #endif /* _GST_ULAW_CONVERSION_H */
 
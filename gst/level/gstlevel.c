@@ -91,6 +91,11 @@
  * </listitem>
  * </itemizedlist>
  *
+ * If the #GstLevel:packed-messages property is %TRUE, the "peak", "decay"
+ * and "rms" fields are replaced by one #GBytes field named
+ * <classname>&quot;levels&quot;</classname> with the RMS, peak and decaying
+ * peak level of each channel as consecutive doubles.
+ *
  * <refsect2>
  * <title>Example application</title>
  * <informalexample><programlisting language="C">
@@ -148,7 +153,8 @@ enum
   PROP_MESSAGE,
   PROP_INTERVAL,
   PROP_PEAK_TTL,
-  PROP_PEAK_FALLOFF
+  PROP_PEAK_FALLOFF,
+  PROP_PACKED_MESSAGES
 };
 
 #define gst_level_parent_class parent_class
@@ -218,6 +224,21 @@ gst_level_class_init (GstLevelClass * klass)
       g_param_spec_double ("peak-falloff", "Peak Falloff",
           "Decay rate of decay peak after TTL (in dB/sec)",
           0.0, G_MAXDOUBLE, 10.0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstLevel:packed-messages
+   *
+   * Post the levels of all channels as one #GBytes field named
+   * <classname>&quot;levels&quot;</classname> instead of the "rms", "peak"
+   * and "decay" #GValueArray fields. It contains the RMS, peak and decaying
+   * peak level in dB as native endian doubles for each channel, in this
+   * order. This is a lot cheaper to create and parse at short intervals.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_PACKED_MESSAGES,
+      g_param_spec_boolean ("packed-messages", "Packed Messages",
+          "Post the levels of all channels as one binary field",
+          FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   GST_DEBUG_CATEGORY_INIT (level_debug, "level", 0, "Level calculation");
 
@@ -254,6 +275,7 @@ gst_level_init (GstLevel * filter)
   filter->decay_peak_falloff = 10.0;    /* dB falloff (/sec) */
 
   filter->post_messages = TRUE;
+  filter->packed_messages = FALSE;
 
   filter->process = NULL;
 
@@ -309,6 +331,9 @@ gst_level_set_property (GObject * object, guint prop_id,
     case PROP_PEAK_FALLOFF:
       filter->decay_peak_falloff = g_value_get_double (value);
       break;
+    case PROP_PACKED_MESSAGES:
+      filter->packed_messages = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -336,6 +361,9 @@ gst_level_get_property (GObject * object, guint prop_id,
     case PROP_PEAK_FALLOFF:
       g_value_set_double (value, filter->decay_peak_falloff);
       break;
+    case PROP_PACKED_MESSAGES:
+      g_value_set_boolean (value, filter->packed_messages);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -343,91 +371,106 @@ gst_level_get_property (GObject * object, guint prop_id,
 }
 
 
-/* process one (interleaved) channel of incoming samples
+/* process all (interleaved) channels of incoming samples
  * calculate square sum of samples
  * normalize and average over number of samples
- * returns a normalized cumulative square value, which can be averaged
- * to return the average power as a double between 0 and 1
+ * adds a normalized cumulative square value per channel to NCS, which can be
+ * averaged to return the average power as a double between 0 and 1
  * also returns the normalized peak power (square of the highest amplitude)
+ * per channel in NPS
  *
- * caller must assure num is a multiple of channels
+ * num is the number of frames
  * samples for multiple channels are interleaved
  * input sample data enters in *in_data and is not modified
  * this filter only accepts signed audio data, so mid level is always 0
  *
+ * the channels are processed in groups with the sums kept in small local
+ * arrays, so all channels are done in one pass over the data and the inner
+ * loop over the channels is contiguous and can be vectorized by the compiler.
+ * 8 and 16 bit squares are summed exactly in 64 bit integers.
+ *
  * for integers, this code considers the non-existant positive max value to be
  * full-scale; so max-1 will not map to 1.0
  */
 
-#define DEFINE_INT_LEVEL_CALCULATOR(TYPE, RESOLUTION)                         \
+#define CHANNEL_GROUP 8
+
+#define DEFINE_INT_LEVEL_CALCULATOR(TYPE, RESOLUTION, ACC_TYPE)               \
 static void inline                                                            \
 gst_level_calculate_##TYPE (gpointer data, guint num, guint channels,         \
                             gdouble *NCS, gdouble *NPS)                       \
 {                                                                             \
   TYPE * in = (TYPE *)data;                                                   \
-  register guint j;                                                           \
-  gdouble squaresum = 0.0;           /* square sum of the input samples */    \
-  register gdouble square = 0.0;     /* Square */                             \
-  register gdouble peaksquare = 0.0; /* Peak Square Sample */                 \
-  gdouble normalizer;                /* divisor to get a [-1.0, 1.0] range */ \
+  guint c, j, k, n;                                                           \
+  ACC_TYPE squaresum[CHANNEL_GROUP];  /* square sum of the input samples */   \
+  ACC_TYPE peaksquare[CHANNEL_GROUP]; /* Peak Square Sample */                \
+  gdouble normalizer;                 /* divisor to get a [-1.0, 1.0] range */\
                                                                               \
-  /* *NCS = 0.0; Normalized Cumulative Square */                              \
-  /* *NPS = 0.0; Normalized Peak Square */                                    \
+  normalizer = (gdouble) (G_GINT64_CONSTANT(1) << (RESOLUTION * 2));          \
                                                                               \
-  for (j = 0; j < num; j += channels) {                                       \
-    square = ((gdouble) in[j]) * in[j];                                       \
-    if (square > peaksquare) peaksquare = square;                             \
-    squaresum += square;                                                      \
-  }                                                                           \
+  for (c = 0; c < channels; c += n) {                                         \
+    const TYPE *p = in + c;                                                   \
                                                                               \
-  normalizer = (gdouble) (G_GINT64_CONSTANT(1) << (RESOLUTION * 2));          \
-  *NCS = squaresum / normalizer;                                              \
-  *NPS = peaksquare / normalizer;                                             \
+    n = MIN (channels - c, CHANNEL_GROUP);                                    \
+    for (k = 0; k < n; k++)                                                   \
+      squaresum[k] = peaksquare[k] = 0;                                       \
+                                                                              \
+    for (j = 0; j < num; j++) {                                               \
+      for (k = 0; k < n; k++) {                                               \
+        ACC_TYPE square = ((ACC_TYPE) p[k]) * p[k];                           \
+        squaresum[k] += square;                                               \
+        if (square > peaksquare[k]) peaksquare[k] = square;                   \
+      }                                                                       \
+      p += channels;                                                          \
+    }                                                                         \
+                                                                              \
+    for (k = 0; k < n; k++) {                                                 \
+      NCS[c + k] += squaresum[k] / normalizer;                                \
+      NPS[c + k] = peaksquare[k] / normalizer;                                \
+    }                                                                         \
+  }                                                                           \
 }
 
-DEFINE_INT_LEVEL_CALCULATOR (gint32, 31);
-DEFINE_INT_LEVEL_CALCULATOR (gint16, 15);
-DEFINE_INT_LEVEL_CALCULATOR (gint8, 7);
+DEFINE_INT_LEVEL_CALCULATOR (gint32, 31, gdouble);
+DEFINE_INT_LEVEL_CALCULATOR (gint16, 15, gint64);
+DEFINE_INT_LEVEL_CALCULATOR (gint8, 7, gint64);
 
-/* FIXME: use orc to calculate squaresums? */
 #define DEFINE_FLOAT_LEVEL_CALCULATOR(TYPE)                                   \
 static void inline                                                            \
 gst_level_calculate_##TYPE (gpointer data, guint num, guint channels,         \
                             gdouble *NCS, gdouble *NPS)                       \
 {                                                                             \
   TYPE * in = (TYPE *)data;                                                   \
-  register guint j;                                                           \
-  gdouble squaresum = 0.0;           /* square sum of the input samples */    \
-  register gdouble square = 0.0;     /* Square */                             \
-  register gdouble peaksquare = 0.0; /* Peak Square Sample */                 \
+  guint c, j, k, n;                                                           \
+  gdouble squaresum[CHANNEL_GROUP];  /* square sum of the input samples */    \
+  gdouble peaksquare[CHANNEL_GROUP]; /* Peak Square Sample */                 \
                                                                               \
-  /* *NCS = 0.0; Normalized Cumulative Square */                              \
-  /* *NPS = 0.0; Normalized Peak Square */                                    \
+  for (c = 0; c < channels; c += n) {                                         \
+    const TYPE *p = in + c;                                                   \
                                                                               \
-  /* orc_level_squaresum_f64(&squaresum,in,num); */                           \
-  for (j = 0; j < num; j += channels) {                                       \
-    square = ((gdouble) in[j]) * in[j];                                       \
-    if (square > peaksquare) peaksquare = square;                             \
-    squaresum += square;                                                      \
-  }                                                                           \
+    n = MIN (channels - c, CHANNEL_GROUP);                                    \
+    for (k = 0; k < n; k++)                                                   \
+      squaresum[k] = peaksquare[k] = 0.0;                                     \
                                                                               \
-  *NCS = squaresum;                                                           \
-  *NPS = peaksquare;                                                          \
+    for (j = 0; j < num; j++) {                                               \
+      for (k = 0; k < n; k++) {                                               \
+        gdouble square = ((gdouble) p[k]) * p[k];                             \
+        squaresum[k] += square;                                               \
+        if (square > peaksquare[k]) peaksquare[k] = square;                   \
+      }                                                                       \
+      p += channels;                                                          \
+    }                                                                         \
+                                                                              \
+    for (k = 0; k < n; k++) {                                                 \
+      NCS[c + k] += squaresum[k];                                             \
+      NPS[c + k] = peaksquare[k];                                             \
+    }                                                                         \
+  }                                                                           \
 }
 
 DEFINE_FLOAT_LEVEL_CALCULATOR (gfloat);
 DEFINE_FLOAT_LEVEL_CALCULATOR (gdouble);
 
-/* we would need stride to deinterleave also
-static void inline
-gst_level_calculate_gdouble (gpointer data, guint num, guint channels,
-                            gdouble *NCS, gdouble *NPS)
-{
-  orc_level_squaresum_f64(NCS,(gdouble *)data,num);
-  *NPS = 0.0;
-}
-*/
-
 
 static gboolean
 gst_level_set_caps (GstBaseTransform * trans, GstCaps * in, GstCaps * out)
@@ -525,6 +568,10 @@ gst_level_message_new (GstLevel * level, GstClockTime timestamp,
       "running-time", G_TYPE_UINT64, running_time,
       "duration", G_TYPE_UINT64, duration, NULL);
 
+  /* the levels are added as one field when posting */
+  if (level->packed_messages)
+    return gst_message_new_element (GST_OBJECT (level), s);
+
   g_value_init (&v, G_TYPE_VALUE_ARRAY);
   g_value_take_boxed (&v, g_value_array_new (0));
   gst_structure_take_value (s, "rms", &v);
@@ -578,7 +625,6 @@ gst_level_transform_ip (GstBaseTransform * trans, GstBuffer * in)
   GstMapInfo map;
   guint8 *in_data;
   gsize in_size;
-  gdouble CS;
   guint i;
   guint num_frames;
   guint num_int_samples = 0;    /* number of interleaved samples
@@ -619,18 +665,18 @@ gst_level_transform_ip (GstBaseTransform * trans, GstBuffer * in)
     block_size = MIN (block_size, num_frames);
     block_int_size = block_size * channels;
 
-    for (i = 0; i < channels; ++i) {
-      if (!GST_BUFFER_FLAG_IS_SET (in, GST_BUFFER_FLAG_GAP)) {
-        filter->process (in_data, block_int_size, channels, &CS,
-            &filter->peak[i]);
-        GST_LOG_OBJECT (filter,
-            "[%d]: cumulative squares %lf, over %d samples/%d channels",
-            i, CS, block_int_size, channels);
-        filter->CS[i] += CS;
-      } else {
+    if (!GST_BUFFER_FLAG_IS_SET (in, GST_BUFFER_FLAG_GAP)) {
+      filter->process (in_data, block_size, channels, filter->CS,
+          filter->peak);
+    } else {
+      for (i = 0; i < channels; ++i)
         filter->peak[i] = 0.0;
-      }
-      in_data += bps;
+    }
+
+    for (i = 0; i < channels; ++i) {
+      GST_LOG_OBJECT (filter,
+          "[%d]: cumulative squares %lf, over %d samples/%d channels",
+          i, filter->CS[i], block_int_size, channels);
 
       filter->decay_peak_age[i] += GST_FRAMES_TO_CLOCK_TIME (num_frames, rate);
       GST_LOG_OBJECT (filter,
@@ -677,7 +723,7 @@ gst_level_transform_ip (GstBaseTransform * trans, GstBuffer * in)
         filter->decay_peak_age[i] = G_GINT64_CONSTANT (0);
       }
     }
-    in_data += ((block_int_size * bps) - bps);
+    in_data += block_int_size * bps;
 
     filter->num_frames += block_size;
     num_frames -= block_size;
@@ -707,6 +753,10 @@ gst_level_post_message (GstLevel * filter)
   if (filter->post_messages) {
     GstMessage *m =
         gst_level_message_new (filter, filter->message_ts, duration);
+    gdouble *levels = NULL;
+
+    if (filter->packed_messages)
+      levels = g_new (gdouble, 3 * channels);
 
     GST_LOG_OBJECT (filter,
         "message: ts %" GST_TIME_FORMAT ", duration %" GST_TIME_FORMAT
@@ -741,13 +791,28 @@ gst_level_post_message (GstLevel * filter)
           "message: RMS %f dB, peak %f dB, decay %f dB",
           RMSdB, peakdB, decaydB);
 
-      gst_level_message_append_channel (m, RMSdB, peakdB, decaydB);
+      if (levels) {
+        levels[3 * i] = RMSdB;
+        levels[3 * i + 1] = peakdB;
+        levels[3 * i + 2] = decaydB;
+      } else {
+        gst_level_message_append_channel (m, RMSdB, peakdB, decaydB);
+      }
 
       /* reset cumulative and normal peak */
       filter->CS[i] = 0.0;
       filter->last_peak[i] = 0.0;
     }
 
+    if (levels) {
+      GstStructure *s = (GstStructure *) gst_message_get_structure (m);
+      GBytes *bytes =
+          g_bytes_new_take (levels, 3 * channels * sizeof (gdouble));
+
+      gst_structure_set (s, "levels", G_TYPE_BYTES, bytes, NULL);
+      g_bytes_unref (bytes);
+    }
+
     gst_element_post_message (GST_ELEMENT (filter), m);
 
   }
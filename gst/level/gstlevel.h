@@ -61,6 +61,7 @@ struct _GstLevel {
   guint64 interval;             /* how many nanoseconds between emits */
   gdouble decay_peak_ttl;       /* time to live for peak in nanoseconds */
   gdouble decay_peak_falloff;   /* falloff in dB/sec */
+  gboolean packed_messages;     /* post all levels as one GBytes field */
 
   GstAudioInfo info;
   gint num_frames;              /* frame count (1 sample per channel)
@@ -57,6 +57,9 @@ gst_ebml_write_init (GstEbmlWrite * ebml)
   ebml->last_pos = G_MAXUINT64; /* force segment event */
 
   ebml->cache = NULL;
+  ebml->flush_size = 0;
+  ebml->pending = NULL;
+  ebml->pending_size = 0;
   ebml->streamheader = NULL;
   ebml->streamheader_pos = 0;
   ebml->writing_streamheader = FALSE;
@@ -75,6 +78,11 @@ gst_ebml_write_finalize (GObject * object)
     ebml->cache = NULL;
   }
 
+  if (ebml->pending) {
+    gst_buffer_list_unref (ebml->pending);
+    ebml->pending = NULL;
+  }
+
   if (ebml->streamheader) {
     gst_byte_writer_free (ebml->streamheader);
     ebml->streamheader = NULL;
@@ -129,6 +137,12 @@ gst_ebml_write_reset (GstEbmlWrite * ebml)
     ebml->cache = NULL;
   }
 
+  if (ebml->pending) {
+    gst_buffer_list_unref (ebml->pending);
+    ebml->pending = NULL;
+  }
+  ebml->pending_size = 0;
+
   if (ebml->caps) {
     gst_caps_unref (ebml->caps);
     ebml->caps = NULL;
@@ -228,6 +242,80 @@ gst_ebml_writer_send_segment_event (GstEbmlWrite * ebml, guint64 new_pos)
   return res;
 }
 
+/**
+ * gst_ebml_write_set_flush_size:
+ * @ebml: a #GstEbmlWrite.
+ * @size: number of bytes to collect before pushing, 0 to disable.
+ *
+ * Enable write aggregation. Rather than pushing every element header
+ * and payload buffer on its own, they are collected (payloads by
+ * reference) and pushed downstream as a single #GstBufferList, so sinks
+ * see far fewer and larger writes.
+ */
+void
+gst_ebml_write_set_flush_size (GstEbmlWrite * ebml, guint size)
+{
+  if (size == 0)
+    gst_ebml_write_flush (ebml);
+  ebml->flush_size = size;
+}
+
+/**
+ * gst_ebml_write_flush:
+ * @ebml: a #GstEbmlWrite.
+ *
+ * Push any buffers collected by write aggregation.
+ */
+void
+gst_ebml_write_flush (GstEbmlWrite * ebml)
+{
+  GstBufferList *list;
+
+  if (!ebml->pending)
+    return;
+
+  list = ebml->pending;
+  ebml->pending = NULL;
+  GST_DEBUG ("Flushing %u aggregated buffers of size %" G_GSIZE_FORMAT,
+      gst_buffer_list_length (list), ebml->pending_size);
+  ebml->pending_size = 0;
+
+  if (ebml->last_write_result == GST_FLOW_OK)
+    ebml->last_write_result = gst_pad_push_list (ebml->srcpad, list);
+  else
+    gst_buffer_list_unref (list);
+}
+
+/* sends @buf downstream, announcing a new position first if needed */
+static void
+gst_ebml_write_push_buffer (GstEbmlWrite * ebml, GstBuffer * buf)
+{
+  if (GST_BUFFER_OFFSET (buf) != ebml->last_pos) {
+    /* whatever was collected goes before the segment event */
+    gst_ebml_write_flush (ebml);
+    gst_ebml_writer_send_segment_event (ebml, GST_BUFFER_OFFSET (buf));
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+  }
+  ebml->last_pos = GST_BUFFER_OFFSET_END (buf);
+
+  if (ebml->flush_size == 0 || ebml->writing_streamheader) {
+    gst_ebml_write_flush (ebml);
+    if (ebml->last_write_result == GST_FLOW_OK)
+      ebml->last_write_result = gst_pad_push (ebml->srcpad, buf);
+    else
+      gst_buffer_unref (buf);
+    return;
+  }
+
+  if (!ebml->pending)
+    ebml->pending = gst_buffer_list_new ();
+  ebml->pending_size += gst_buffer_get_size (buf);
+  gst_buffer_list_add (ebml->pending, buf);
+
+  if (ebml->pending_size >= ebml->flush_size)
+    gst_ebml_write_flush (ebml);
+}
+
 /**
  * gst_ebml_write_flush_cache:
  * @ebml:      a #GstEbmlWrite.
@@ -252,18 +340,13 @@ gst_ebml_write_flush_cache (GstEbmlWrite * ebml, gboolean is_keyframe,
   GST_BUFFER_OFFSET (buffer) = ebml->pos - gst_buffer_get_size (buffer);
   GST_BUFFER_OFFSET_END (buffer) = ebml->pos;
   if (ebml->last_write_result == GST_FLOW_OK) {
-    if (GST_BUFFER_OFFSET (buffer) != ebml->last_pos) {
-      gst_ebml_writer_send_segment_event (ebml, GST_BUFFER_OFFSET (buffer));
-      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
-    }
     if (ebml->writing_streamheader) {
       GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_HEADER);
     }
     if (!is_keyframe) {
       GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
     }
-    ebml->last_pos = ebml->pos;
-    ebml->last_write_result = gst_pad_push (ebml->srcpad, buffer);
+    gst_ebml_write_push_buffer (ebml, buffer);
   } else {
     gst_buffer_unref (buffer);
   }
@@ -455,12 +538,7 @@ gst_ebml_write_element_push (GstEbmlWrite * ebml, GstBuffer * buf,
     }
     GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
 
-    if (GST_BUFFER_OFFSET (buf) != ebml->last_pos) {
-      gst_ebml_writer_send_segment_event (ebml, GST_BUFFER_OFFSET (buf));
-      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
-    }
-    ebml->last_pos = ebml->pos;
-    ebml->last_write_result = gst_pad_push (ebml->srcpad, buf);
+    gst_ebml_write_push_buffer (ebml, buf);
   } else {
     gst_buffer_unref (buf);
   }
@@ -55,6 +55,11 @@ typedef struct _GstEbmlWrite {
 
   GstFlowReturn last_write_result;
 
+  /* write aggregation: buffers pushed together as one list */
+  guint flush_size;
+  GstBufferList *pending;
+  gsize pending_size;
+
   gboolean writing_streamheader;
   GstByteWriter *streamheader;
   guint64 streamheader_pos;
@@ -87,6 +92,15 @@ void    gst_ebml_write_flush_cache   (GstEbmlWrite *ebml,
                                       gboolean is_keyframe,
                                       GstClockTime timestamp);
 
+/*
+ * Aggregation means that outgoing buffers (payloads by reference) are
+ * collected and pushed as one buffer list once @size bytes are pending,
+ * at discontinuities or on an explicit flush. 0 disables it.
+ */
+void    gst_ebml_write_set_flush_size (GstEbmlWrite *ebml,
+                                      guint         size);
+void    gst_ebml_write_flush         (GstEbmlWrite *ebml);
+
 /*
  * Seeking.
  */
@@ -83,10 +83,22 @@ enum
   ARG_0,
   ARG_METADATA,
   ARG_STREAMINFO,
-  ARG_MAX_GAP_TIME
+  ARG_MAX_GAP_TIME,
+  ARG_CLUSTER_INDEX
 };
 
 #define  DEFAULT_MAX_GAP_TIME      (2 * GST_SECOND)
+#define  DEFAULT_CLUSTER_INDEX     FALSE
+
+/* clusters up to this size are pulled in one go in pull mode */
+#define  MAX_CLUSTER_PREFETCH      (8 * 1024 * 1024)
+
+/* entry of the background scanned cluster index */
+typedef struct
+{
+  guint64 offset;
+  GstClockTime time;
+} GstMatroskaClusterIndexEntry;
 
 static GstStaticPadTemplate sink_templ = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -171,6 +183,7 @@ static GstCaps
 
 /* stream methods */
 static void gst_matroska_demux_reset (GstElement * element);
+static void gst_matroska_demux_stop_cluster_index (GstMatroskaDemux * demux);
 static gboolean perform_seek_to_offset (GstMatroskaDemux * demux,
     gdouble rate, guint64 offset, guint32 seqnum);
 
@@ -213,6 +226,20 @@ gst_matroska_demux_class_init (GstMatroskaDemuxClass * klass)
           "gaps longer than this (0 = disabled).", 0, G_MAXUINT64,
           DEFAULT_MAX_GAP_TIME, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMatroskaDemux:cluster-index
+   *
+   * When a file has no Cues, scan the cluster headers once in a
+   * background thread (pull mode only) and use the resulting index for
+   * seeking instead of bisecting through the file on every seek.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, ARG_CLUSTER_INDEX,
+      g_param_spec_boolean ("cluster-index", "Cluster index",
+          "Build a cluster index in the background for files without cues",
+          DEFAULT_CLUSTER_INDEX, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_matroska_demux_change_state);
   gstelement_class->send_event =
@@ -261,6 +288,7 @@ gst_matroska_demux_init (GstMatroskaDemux * demux)
 
   /* property defaults */
   demux->max_gap_time = DEFAULT_MAX_GAP_TIME;
+  demux->cluster_index_enabled = DEFAULT_CLUSTER_INDEX;
 
   GST_OBJECT_FLAG_SET (demux, GST_ELEMENT_FLAG_INDEXABLE);
 
@@ -330,6 +358,13 @@ gst_matroska_demux_reset (GstElement * element)
     demux->clusters = NULL;
   }
 
+  gst_matroska_demux_stop_cluster_index (demux);
+  if (demux->cluster_index) {
+    g_array_free (demux->cluster_index, TRUE);
+    demux->cluster_index = NULL;
+  }
+  demux->cluster_index_done = FALSE;
+
   g_list_foreach (demux->seek_parsed,
       (GFunc) gst_matroska_read_common_free_parsed_el, NULL);
   g_list_free (demux->seek_parsed);
@@ -1686,6 +1721,217 @@ exit:
   return ret;
 }
 
+typedef struct
+{
+  const guint8 *data;
+  guint size;
+} GstMatroskaScanData;
+
+static GstFlowReturn
+gst_matroska_demux_scan_peek (GstMatroskaScanData * scan, guint peek,
+    const guint8 ** data)
+{
+  if (peek > scan->size)
+    return GST_FLOW_EOS;
+  *data = scan->data;
+  return GST_FLOW_OK;
+}
+
+/* parses the timecode of the cluster header at the start of @data,
+ * returns FALSE if @data does not hold a cluster header with timecode;
+ * @length and @needed are filled in for whatever element is found */
+static gboolean
+gst_matroska_demux_scan_cluster_header (GstMatroskaDemux * demux,
+    const guint8 * data, guint size, guint64 offset, guint32 * id,
+    guint64 * length, guint * needed, guint64 * timecode)
+{
+  GstMatroskaScanData scan;
+  guint32 cid;
+  guint64 clength;
+  guint cneeded, pos;
+
+  scan.data = data;
+  scan.size = size;
+  if (gst_ebml_peek_id_length (id, length, needed,
+          (GstPeekData) gst_matroska_demux_scan_peek, (gpointer) & scan,
+          GST_ELEMENT_CAST (demux), offset) != GST_FLOW_OK)
+    return FALSE;
+  if (*id != GST_MATROSKA_ID_CLUSTER)
+    return FALSE;
+
+  /* the timecode should come first, but CRC-32 or Void may precede it */
+  pos = *needed;
+  while (pos < size) {
+    scan.data = data + pos;
+    scan.size = size - pos;
+    if (gst_ebml_peek_id_length (&cid, &clength, &cneeded,
+            (GstPeekData) gst_matroska_demux_scan_peek, (gpointer) & scan,
+            GST_ELEMENT_CAST (demux), offset + pos) != GST_FLOW_OK)
+      return FALSE;
+    if (cid == GST_MATROSKA_ID_CLUSTERTIMECODE) {
+      guint i;
+
+      if (clength > 8 || pos + cneeded + clength > size)
+        return FALSE;
+      *timecode = 0;
+      for (i = 0; i < clength; i++)
+        *timecode = (*timecode << 8) | data[pos + cneeded + i];
+      return TRUE;
+    }
+    if (cid != GST_EBML_ID_CRC32 && cid != GST_EBML_ID_VOID)
+      return FALSE;
+    pos += cneeded + clength;
+  }
+
+  return FALSE;
+}
+
+/* reads only the header of each cluster, one after another, and records
+ * their offset and time; runs alongside the streaming thread */
+static gpointer
+gst_matroska_demux_cluster_index_func (GstMatroskaDemux * demux)
+{
+  const guint chunk = 64;
+  guint64 offset, length, timecode;
+  guint32 id;
+  guint needed;
+  guint n_entries = 0;
+
+  GST_OBJECT_LOCK (demux);
+  offset = demux->first_cluster_offset;
+  GST_OBJECT_UNLOCK (demux);
+
+  GST_DEBUG_OBJECT (demux, "building cluster index from offset %"
+      G_GUINT64_FORMAT, offset);
+
+  while (!g_atomic_int_get (&demux->cluster_index_stop)) {
+    GstBuffer *buf = NULL;
+    GstFlowReturn ret;
+    GstMapInfo map;
+    gboolean have_time;
+
+    ret = gst_pad_pull_range (demux->common.sinkpad, offset, chunk, &buf);
+    if (ret == GST_FLOW_FLUSHING) {
+      /* a flushing seek is going on, retry once it is done */
+      g_usleep (10 * 1000);
+      continue;
+    } else if (ret != GST_FLOW_OK) {
+      break;
+    }
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    have_time = gst_matroska_demux_scan_cluster_header (demux, map.data,
+        map.size, offset, &id, &length, &needed, &timecode);
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_unref (buf);
+
+    if (id == (guint32) GST_EBML_SIZE_UNKNOWN ||
+        length == GST_EBML_SIZE_UNKNOWN || length == G_MAXUINT64) {
+      /* cannot skip what we do not know the size of */
+      GST_DEBUG_OBJECT (demux, "element of unknown size at offset %"
+          G_GUINT64_FORMAT ", stopping", offset);
+      break;
+    }
+
+    if (have_time) {
+      GstMatroskaClusterIndexEntry entry;
+
+      entry.offset = offset;
+      GST_OBJECT_LOCK (demux);
+      entry.time = timecode * demux->common.time_scale;
+      g_array_append_val (demux->cluster_index, entry);
+      GST_OBJECT_UNLOCK (demux);
+      n_entries++;
+    }
+
+    offset += needed + length;
+  }
+
+  GST_DEBUG_OBJECT (demux, "cluster index done, %u entries", n_entries);
+  GST_OBJECT_LOCK (demux);
+  demux->cluster_index_done = TRUE;
+  GST_OBJECT_UNLOCK (demux);
+
+  return NULL;
+}
+
+static void
+gst_matroska_demux_start_cluster_index (GstMatroskaDemux * demux)
+{
+  GError *err = NULL;
+
+  if (demux->cluster_index_thread || demux->cluster_index)
+    return;
+
+  demux->cluster_index = g_array_sized_new (FALSE, FALSE,
+      sizeof (GstMatroskaClusterIndexEntry), 1024);
+  demux->cluster_index_done = FALSE;
+  g_atomic_int_set (&demux->cluster_index_stop, 0);
+  demux->cluster_index_thread = g_thread_try_new ("matroska-cluster-index",
+      (GThreadFunc) gst_matroska_demux_cluster_index_func, demux, &err);
+  if (!demux->cluster_index_thread) {
+    GST_WARNING_OBJECT (demux, "could not start cluster index thread: %s",
+        err->message);
+    g_clear_error (&err);
+    g_array_free (demux->cluster_index, TRUE);
+    demux->cluster_index = NULL;
+  }
+}
+
+static void
+gst_matroska_demux_stop_cluster_index (GstMatroskaDemux * demux)
+{
+  if (demux->cluster_index_thread) {
+    g_atomic_int_set (&demux->cluster_index_stop, 1);
+    g_thread_join (demux->cluster_index_thread);
+    demux->cluster_index_thread = NULL;
+  }
+}
+
+/* looks up the cluster starting at or before @time in the cluster index,
+ * if the index already covers @time */
+static GstMatroskaIndex *
+gst_matroska_demux_cluster_index_lookup (GstMatroskaDemux * demux,
+    GstClockTime time)
+{
+  GstMatroskaClusterIndexEntry *entry;
+  GstMatroskaIndex *result = NULL;
+  guint lo, hi, len;
+
+  GST_OBJECT_LOCK (demux);
+  if (!demux->cluster_index || !(len = demux->cluster_index->len))
+    goto done;
+  entry = &g_array_index (demux->cluster_index,
+      GstMatroskaClusterIndexEntry, len - 1);
+  if (entry->time < time && !demux->cluster_index_done)
+    goto done;
+
+  /* last entry with time <= @time, or the first one */
+  lo = 0;
+  hi = len;
+  while (hi - lo > 1) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (demux->cluster_index, GstMatroskaClusterIndexEntry,
+            mid).time <= time)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  entry = &g_array_index (demux->cluster_index,
+      GstMatroskaClusterIndexEntry, lo);
+
+  result = g_new0 (GstMatroskaIndex, 1);
+  result->time = entry->time;
+  result->pos = entry->offset - demux->common.ebml_segment_start;
+  GST_DEBUG_OBJECT (demux, "cluster index entry; time %" GST_TIME_FORMAT
+      ", pos %" G_GUINT64_FORMAT, GST_TIME_ARGS (result->time), result->pos);
+
+done:
+  GST_OBJECT_UNLOCK (demux);
+  return result;
+}
+
 /* bisect and scan through file for cluster starting before @time,
  * returns fake index entry with corresponding info on cluster */
 static GstMatroskaIndex *
@@ -1702,6 +1948,11 @@ gst_matroska_demux_search_pos (GstMatroskaDemux * demux, GstClockTime time)
   guint32 id;
   guint needed;
 
+  /* a scanned cluster index needs no bisecting */
+  if ((entry = gst_matroska_demux_cluster_index_lookup (demux,
+              MAX (time, demux->stream_start_time))))
+    return entry;
+
   /* (under)estimate new position, resync using cluster ebml id,
    * and scan forward to appropriate cluster
    * (and re-estimate if need to go backward) */
@@ -3046,6 +3297,10 @@ gst_matroska_demux_align_buffer (GstMatroskaDemux * demux,
 {
   GstMapInfo map;
 
+  /* nothing to check, leave the sub-buffer alone */
+  if (alignment <= 1)
+    return buffer;
+
   gst_buffer_map (buffer, &map, GST_MAP_READ);
 
   if (map.size < sizeof (guintptr)) {
@@ -4223,7 +4478,12 @@ gst_matroska_demux_parse_id (GstMatroskaDemux * demux, guint32 id,
           if (G_UNLIKELY (demux->common.state
                   == GST_MATROSKA_READ_STATE_HEADER)) {
             demux->common.state = GST_MATROSKA_READ_STATE_DATA;
+            GST_OBJECT_LOCK (demux);
             demux->first_cluster_offset = demux->common.offset;
+            GST_OBJECT_UNLOCK (demux);
+            if (!demux->streaming && !demux->common.index &&
+                demux->cluster_index_enabled)
+              gst_matroska_demux_start_cluster_index (demux);
             GST_DEBUG_OBJECT (demux, "signaling no more pads");
             gst_element_no_more_pads (GST_ELEMENT (demux));
             /* send initial segment - we wait till we know the first
@@ -4245,6 +4505,14 @@ gst_matroska_demux_parse_id (GstMatroskaDemux * demux, guint32 id,
             demux->next_cluster_offset = demux->cluster_offset + read;
           /* eat cluster prefix */
           gst_matroska_demux_flush (demux, needed);
+          /* pull the whole cluster at once, so its blocks are all taken as
+           * sub-buffers of a single read rather than of many small ones */
+          if (!demux->streaming &&
+              demux->common.state == GST_MATROSKA_READ_STATE_DATA &&
+              length != G_MAXUINT64 && length > 64 * 1024 &&
+              length <= MAX_CLUSTER_PREFETCH)
+            gst_matroska_read_common_peek_bytes (&demux->common,
+                demux->common.offset, length, NULL, NULL);
           break;
         case GST_MATROSKA_ID_CLUSTERTIMECODE:
         {
@@ -4774,6 +5042,7 @@ gst_matroska_demux_sink_activate_mode (GstPad * sinkpad, GstObject * parent,
             sinkpad, NULL);
       } else {
         gst_pad_stop_task (sinkpad);
+        gst_matroska_demux_stop_cluster_index (GST_MATROSKA_DEMUX (parent));
       }
       return TRUE;
     case GST_PAD_MODE_PUSH:
@@ -5699,6 +5968,11 @@ gst_matroska_demux_set_property (GObject * object,
       demux->max_gap_time = g_value_get_uint64 (value);
       GST_OBJECT_UNLOCK (demux);
       break;
+    case ARG_CLUSTER_INDEX:
+      GST_OBJECT_LOCK (demux);
+      demux->cluster_index_enabled = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (demux);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -5720,6 +5994,11 @@ gst_matroska_demux_get_property (GObject * object,
       g_value_set_uint64 (value, demux->max_gap_time);
       GST_OBJECT_UNLOCK (demux);
       break;
+    case ARG_CLUSTER_INDEX:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_boolean (value, demux->cluster_index_enabled);
+      GST_OBJECT_UNLOCK (demux);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -71,6 +71,14 @@ typedef struct _GstMatroskaDemux {
   /* cluster positions (optional) */
   GArray                  *clusters;
 
+  /* cluster offset/time index scanned in the background for files
+   * without cues; index protected by the object lock */
+  gboolean                 cluster_index_enabled;
+  GThread                 *cluster_index_thread;
+  GArray                  *cluster_index;
+  gboolean                 cluster_index_done;
+  volatile gint            cluster_index_stop;
+
   /* keeping track of playback position */
   GstClockTime             last_stop_end;
   GstClockTime             stream_start_time;
@@ -68,13 +68,15 @@ enum
   ARG_WRITING_APP,
   ARG_DOCTYPE_VERSION,
   ARG_MIN_INDEX_INTERVAL,
-  ARG_STREAMABLE
+  ARG_STREAMABLE,
+  ARG_FLUSH_SIZE
 };
 
 #define  DEFAULT_DOCTYPE_VERSION         2
 #define  DEFAULT_WRITING_APP             "GStreamer Matroska muxer"
 #define  DEFAULT_MIN_INDEX_INTERVAL      0
 #define  DEFAULT_STREAMABLE              FALSE
+#define  DEFAULT_FLUSH_SIZE              0
 
 /* WAVEFORMATEX is gst_riff_strf_auds + an extra guint16 extension size */
 #define WAVEFORMATEX_SIZE  (2 + sizeof (gst_riff_strf_auds))
@@ -328,6 +330,21 @@ gst_matroska_mux_class_init (GstMatroskaMuxClass * klass)
           "to be streamed and hence no indexes written or duration written.",
           DEFAULT_STREAMABLE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstMatroskaMux:flush-size:
+   *
+   * Collect this many bytes of output before pushing them downstream as
+   * a single buffer list, instead of pushing every element separately.
+   * Pending data is also pushed at the end of each cluster. 0 disables
+   * aggregation.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, ARG_FLUSH_SIZE,
+      g_param_spec_uint ("flush-size", "Flush size",
+          "Aggregate output into writes of this many bytes (0 = disabled)",
+          0, G_MAXUINT, DEFAULT_FLUSH_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_matroska_mux_change_state);
@@ -466,9 +483,10 @@ gst_matroska_mux_init (GstMatroskaMux * mux, gpointer g_class)
   mux->writing_app = g_strdup (DEFAULT_WRITING_APP);
   mux->min_index_interval = DEFAULT_MIN_INDEX_INTERVAL;
   mux->streamable = DEFAULT_STREAMABLE;
+  mux->flush_size = DEFAULT_FLUSH_SIZE;
 
   /* initialize internal variables */
-  mux->index = NULL;
+  mux->cues = NULL;
   mux->num_streams = 0;
   mux->num_a_streams = 0;
   mux->num_t_streams = 0;
@@ -502,6 +520,9 @@ gst_matroska_mux_finalize (GObject * object)
 
   g_array_free (mux->used_uids, TRUE);
 
+  if (mux->cues)
+    g_byte_array_free (mux->cues, TRUE);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -603,6 +624,7 @@ gst_matroska_pad_reset (GstMatroskaPad * collect_pad, gboolean full)
     collect_pad->duration = 0;
     collect_pad->start_ts = GST_CLOCK_TIME_NONE;
     collect_pad->end_ts = GST_CLOCK_TIME_NONE;
+    collect_pad->last_index_time = GST_CLOCK_TIME_NONE;
   }
 }
 
@@ -650,8 +672,12 @@ gst_matroska_mux_reset (GstElement * element)
 
   /* reset indexes */
   mux->num_indexes = 0;
-  g_free (mux->index);
-  mux->index = NULL;
+  if (mux->cues) {
+    g_byte_array_free (mux->cues, TRUE);
+    mux->cues = NULL;
+  }
+  mux->cues_last_pos = 0;
+  mux->cues_last_time = 0;
 
   /* reset timers */
   mux->time_scale = GST_MSECOND;
@@ -2533,6 +2559,8 @@ gst_matroska_mux_start (GstMatroskaMux * mux)
   GstToc *toc;
 #endif
 
+  gst_ebml_write_set_flush_size (ebml, mux->flush_size);
+
   /* if not streaming, check if downstream is seekable */
   if (!mux->streamable) {
     gboolean seekable;
@@ -2866,6 +2894,64 @@ gst_matroska_mux_write_toc_entry_tags (GstMatroskaMux * mux,
 }
 #endif
 
+/* Cue points are collected as a byte stream of varints instead of an array
+ * of GstMatroskaIndex. Every entry is the cluster position delta, the zigzag
+ * encoded time delta and the track number, which takes about a quarter of
+ * the memory for long recordings. */
+static void
+gst_matroska_mux_cues_put_varint (GByteArray * cues, guint64 val)
+{
+  guint8 data[10];
+  guint len = 0;
+
+  do {
+    data[len] = val & 0x7f;
+    val >>= 7;
+    if (val)
+      data[len] |= 0x80;
+    len++;
+  } while (val);
+
+  g_byte_array_append (cues, data, len);
+}
+
+static guint64
+gst_matroska_mux_cues_get_varint (const guint8 ** data)
+{
+  const guint8 *p = *data;
+  guint64 val = 0;
+  guint shift = 0;
+
+  do {
+    val |= (guint64) (*p & 0x7f) << shift;
+    shift += 7;
+  } while (*p++ & 0x80);
+
+  *data = p;
+
+  return val;
+}
+
+static void
+gst_matroska_mux_add_cue (GstMatroskaMux * mux, guint64 pos,
+    GstClockTime time, guint track)
+{
+  /* times of different tracks need not be increasing */
+  gint64 diff = (gint64) (time - mux->cues_last_time);
+
+  if (mux->cues == NULL)
+    mux->cues = g_byte_array_new ();
+
+  gst_matroska_mux_cues_put_varint (mux->cues, pos - mux->cues_last_pos);
+  gst_matroska_mux_cues_put_varint (mux->cues,
+      ((guint64) diff << 1) ^ (guint64) (diff >> 63));
+  gst_matroska_mux_cues_put_varint (mux->cues, track);
+
+  mux->cues_last_pos = pos;
+  mux->cues_last_time = time;
+  mux->num_indexes++;
+}
+
 /**
  * gst_matroska_mux_finish:
  * @mux: #GstMatroskaMux
@@ -2887,7 +2973,10 @@ gst_matroska_mux_finish (GstMatroskaMux * mux)
   }
 
   /* cues */
-  if (mux->index != NULL) {
+  if (mux->cues != NULL) {
+    const guint8 *data = mux->cues->data;
+    guint64 pos = 0;
+    GstClockTime time = 0;
     guint n;
     guint64 master, pointentry_master, trackpos_master;
 
@@ -2896,17 +2985,22 @@ gst_matroska_mux_finish (GstMatroskaMux * mux)
     master = gst_ebml_write_master_start (ebml, GST_MATROSKA_ID_CUES);
 
     for (n = 0; n < mux->num_indexes; n++) {
-      GstMatroskaIndex *idx = &mux->index[n];
+      guint64 diff, track;
+
+      pos += gst_matroska_mux_cues_get_varint (&data);
+      diff = gst_matroska_mux_cues_get_varint (&data);
+      time += (GstClockTime) ((gint64) (diff >> 1) ^ -(gint64) (diff & 1));
+      track = gst_matroska_mux_cues_get_varint (&data);
 
       pointentry_master = gst_ebml_write_master_start (ebml,
           GST_MATROSKA_ID_POINTENTRY);
       gst_ebml_write_uint (ebml, GST_MATROSKA_ID_CUETIME,
-          idx->time / mux->time_scale);
+          time / mux->time_scale);
       trackpos_master = gst_ebml_write_master_start (ebml,
           GST_MATROSKA_ID_CUETRACKPOSITIONS);
-      gst_ebml_write_uint (ebml, GST_MATROSKA_ID_CUETRACK, idx->track);
+      gst_ebml_write_uint (ebml, GST_MATROSKA_ID_CUETRACK, track);
       gst_ebml_write_uint (ebml, GST_MATROSKA_ID_CUECLUSTERPOSITION,
-          idx->pos - mux->segment_master);
+          pos - mux->segment_master);
       gst_ebml_write_master_finish (ebml, trackpos_master);
       gst_ebml_write_master_finish (ebml, pointentry_master);
     }
@@ -2987,7 +3081,7 @@ gst_matroska_mux_finish (GstMatroskaMux * mux)
     gst_ebml_write_buffer_header (ebml, GST_EBML_ID_VOID, 26);
     gst_ebml_write_seek (ebml, my_pos);
   }
-  if (mux->index != NULL) {
+  if (mux->cues != NULL) {
     gst_ebml_replace_uint (ebml, mux->seekhead_pos + 116,
         mux->cues_pos - mux->segment_master);
   } else {
@@ -3291,6 +3385,9 @@ gst_matroska_mux_write_data (GstMatroskaMux * mux, GstMatroskaPad * collect_pad,
       if (!mux->streamable)
         gst_ebml_write_master_finish (ebml, mux->cluster);
 
+      /* push out what was collected for the finished cluster */
+      gst_ebml_write_flush (ebml);
+
       /* Forward the GstForceKeyUnit event after finishing the cluster */
       if (mux->force_key_unit_event) {
         gst_pad_push_event (mux->srcpad, mux->force_key_unit_event);
@@ -3341,29 +3438,13 @@ gst_matroska_mux_write_data (GstMatroskaMux * mux, GstMatroskaPad * collect_pad,
       (is_video_keyframe ||
           ((collect_pad->track->type == GST_MATROSKA_TRACK_TYPE_AUDIO) &&
               (mux->num_streams == 1)))) {
-    gint last_idx = -1;
-
-    if (mux->min_index_interval != 0) {
-      for (last_idx = mux->num_indexes - 1; last_idx >= 0; last_idx--) {
-        if (mux->index[last_idx].track == collect_pad->track->num)
-          break;
-      }
-    }
-
-    if (last_idx < 0 || mux->min_index_interval == 0 ||
-        (GST_CLOCK_DIFF (mux->index[last_idx].time, GST_BUFFER_TIMESTAMP (buf))
-            >= mux->min_index_interval)) {
-      GstMatroskaIndex *idx;
-
-      if (mux->num_indexes % 32 == 0) {
-        mux->index = g_renew (GstMatroskaIndex, mux->index,
-            mux->num_indexes + 32);
-      }
-      idx = &mux->index[mux->num_indexes++];
-
-      idx->pos = mux->cluster_pos;
-      idx->time = GST_BUFFER_TIMESTAMP (buf);
-      idx->track = collect_pad->track->num;
+    if (!GST_CLOCK_TIME_IS_VALID (collect_pad->last_index_time) ||
+        mux->min_index_interval == 0 ||
+        (GST_CLOCK_DIFF (collect_pad->last_index_time,
+                GST_BUFFER_TIMESTAMP (buf)) >= mux->min_index_interval)) {
+      gst_matroska_mux_add_cue (mux, mux->cluster_pos,
+          GST_BUFFER_TIMESTAMP (buf), collect_pad->track->num);
+      collect_pad->last_index_time = GST_BUFFER_TIMESTAMP (buf);
     }
   }
 
@@ -3483,6 +3564,7 @@ gst_matroska_mux_handle_buffer (GstCollectPads * pads, GstCollectData * data,
     } else {
       GST_DEBUG_OBJECT (mux, "... but streamable, nothing to finish");
     }
+    gst_ebml_write_flush (ebml);
     gst_pad_push_event (mux->srcpad, gst_event_new_eos ());
     ret = GST_FLOW_EOS;
     goto exit;
@@ -3597,6 +3679,9 @@ gst_matroska_mux_set_property (GObject * object,
     case ARG_STREAMABLE:
       mux->streamable = g_value_get_boolean (value);
       break;
+    case ARG_FLUSH_SIZE:
+      mux->flush_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3625,6 +3710,9 @@ gst_matroska_mux_get_property (GObject * object,
     case ARG_STREAMABLE:
       g_value_set_boolean (value, mux->streamable);
       break;
+    case ARG_FLUSH_SIZE:
+      g_value_set_uint (value, mux->flush_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -66,6 +66,7 @@ typedef struct
   GstClockTime start_ts;
   GstClockTime end_ts;    /* last timestamp + (if available) duration */
   guint64 default_duration_scaled;
+  GstClockTime last_index_time;
 }
 GstMatroskaPad;
 
@@ -95,11 +96,14 @@ typedef struct _GstMatroskaMux {
   /* state */
   GstMatroskaMuxState state;
 
-  /* a cue (index) table */
-  GstMatroskaIndex *index;
+  /* a cue (index) table, as varint deltas to the previous entry */
+  GByteArray    *cues;
   guint          num_indexes;
+  guint64        cues_last_pos;
+  GstClockTime   cues_last_time;
   GstClockTimeDiff min_index_interval;
   gboolean       streamable;
+  guint          flush_size;
  
   /* timescale in the file */
   guint64        time_scale;
@@ -62,6 +62,7 @@
 #include <gst/tag/tag.h>
 
 #include <gst/pbutils/pbutils.h>
+#include <gst/base/gstbytewriter.h>
 
 #include "matroska-parse.h"
 #include "matroska-ids.h"
@@ -81,9 +82,21 @@ enum
 {
   ARG_0,
   ARG_METADATA,
-  ARG_STREAMINFO
+  ARG_STREAMINFO,
+  ARG_BUILD_CUES
 };
 
+#define DEFAULT_BUILD_CUES FALSE
+
+/* one CuePoint, times in timecode scale units and positions relative to
+ * the segment start */
+typedef struct
+{
+  guint64 time;
+  guint64 track;
+  guint64 cluster_position;
+} GstMatroskaParseCue;
+
 static GstStaticPadTemplate sink_templ = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -133,6 +146,10 @@ static GstIndex *gst_matroska_parse_get_index (GstElement * element);
 
 /* stream methods */
 static void gst_matroska_parse_reset (GstElement * element);
+static void gst_matroska_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_matroska_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 static gboolean perform_seek_to_offset (GstMatroskaParse * parse,
     guint64 offset);
 static GstCaps *gst_matroska_parse_forge_caps (gboolean is_webm,
@@ -148,6 +165,7 @@ gst_matroska_parse_finalize (GObject * object)
   GstMatroskaParse *parse = GST_MATROSKA_PARSE (object);
 
   gst_matroska_read_common_finalize (&parse->common);
+  g_array_free (parse->cues, TRUE);
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -161,6 +179,24 @@ gst_matroska_parse_class_init (GstMatroskaParseClass * klass)
       "Matroska parser");
 
   gobject_class->finalize = gst_matroska_parse_finalize;
+  gobject_class->set_property = gst_matroska_parse_set_property;
+  gobject_class->get_property = gst_matroska_parse_get_property;
+
+  /**
+   * GstMatroskaParse:build-cues:
+   *
+   * Remember the cluster of every video keyframe (or of the first block of
+   * each cluster for streams without video) while passing the stream
+   * through, and write a Cues element with them at EOS if the stream did
+   * not contain one. This turns a live stream into a seekable file without
+   * remuxing it.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, ARG_BUILD_CUES,
+      g_param_spec_boolean ("build-cues", "Build Cues",
+          "Write a Cues element for the passed through clusters at EOS",
+          DEFAULT_BUILD_CUES, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_matroska_parse_change_state);
@@ -212,6 +248,9 @@ gst_matroska_parse_init (GstMatroskaParse * parse)
 
   GST_OBJECT_FLAG_SET (parse, GST_ELEMENT_FLAG_INDEXABLE);
 
+  parse->build_cues = DEFAULT_BUILD_CUES;
+  parse->cues = g_array_new (FALSE, FALSE, sizeof (GstMatroskaParseCue));
+
   /* finish off */
   gst_matroska_parse_reset (GST_ELEMENT (parse));
 }
@@ -268,6 +307,41 @@ gst_matroska_parse_reset (GstElement * element)
     gst_buffer_unref (parse->streamheader);
     parse->streamheader = NULL;
   }
+
+  g_array_set_size (parse->cues, 0);
+  parse->last_cue_cluster = G_MAXUINT64;
+}
+
+static void
+gst_matroska_parse_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstMatroskaParse *parse = GST_MATROSKA_PARSE (object);
+
+  switch (prop_id) {
+    case ARG_BUILD_CUES:
+      parse->build_cues = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_matroska_parse_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstMatroskaParse *parse = GST_MATROSKA_PARSE (object);
+
+  switch (prop_id) {
+    case ARG_BUILD_CUES:
+      g_value_set_boolean (value, parse->build_cues);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 static GstFlowReturn
@@ -1789,6 +1863,21 @@ gst_matroska_parse_parse_blockgroup_or_simpleblock (GstMatroskaParse * parse,
     delta_unit = stream->type == GST_MATROSKA_TRACK_TYPE_VIDEO &&
         ((is_simpleblock && !(flags & 0x80)) || referenceblock);
 
+    /* the first video keyframe of a cluster becomes a cue point, or the
+     * first block of the first track if there is no video */
+    if (parse->build_cues && !delta_unit && cluster_time != GST_CLOCK_TIME_NONE
+        && parse->last_cue_cluster != cluster_offset
+        && (parse->common.has_video ?
+            stream->type == GST_MATROSKA_TRACK_TYPE_VIDEO : stream_num == 0)) {
+      GstMatroskaParseCue cue;
+
+      cue.time = (time < 0 && (-time) > cluster_time) ? 0 : cluster_time + time;
+      cue.track = stream->num;
+      cue.cluster_position = cluster_offset - parse->common.ebml_segment_start;
+      g_array_append_val (parse->cues, cue);
+      parse->last_cue_cluster = cluster_offset;
+    }
+
     if (delta_unit && stream->set_discont) {
       /* When doing seeks or such, we need to restart on key frames or
        * decoders might choke. */
@@ -2468,6 +2557,104 @@ gst_matroska_parse_output (GstMatroskaParse * parse, GstBuffer * buffer,
   return ret;
 }
 
+static void
+gst_matroska_parse_write_id (GstByteWriter * bw, guint32 id)
+{
+  if (id > 0xffffff)
+    gst_byte_writer_put_uint32_be (bw, id);
+  else if (id > 0xffff)
+    gst_byte_writer_put_uint24_be (bw, id);
+  else if (id > 0xff)
+    gst_byte_writer_put_uint16_be (bw, id);
+  else
+    gst_byte_writer_put_uint8 (bw, id);
+}
+
+static void
+gst_matroska_parse_write_size (GstByteWriter * bw, guint64 size)
+{
+  if (size < 0x7f) {
+    gst_byte_writer_put_uint8 (bw, 0x80 | size);
+  } else {
+    /* 8 byte size, the largest there is */
+    gst_byte_writer_put_uint64_be (bw, (G_GUINT64_CONSTANT (1) << 56) | size);
+  }
+}
+
+static guint
+gst_matroska_parse_uint_size (guint64 num)
+{
+  guint n = 1;
+
+  while (n < 8 && (num >> (8 * n)))
+    n++;
+
+  return n;
+}
+
+static void
+gst_matroska_parse_write_uint (GstByteWriter * bw, guint32 id, guint64 num)
+{
+  guint n = gst_matroska_parse_uint_size (num);
+
+  gst_matroska_parse_write_id (bw, id);
+  gst_matroska_parse_write_size (bw, n);
+  while (n--)
+    gst_byte_writer_put_uint8 (bw, (num >> (8 * n)) & 0xff);
+}
+
+/* serialize the collected cue points into a Cues element */
+static GstBuffer *
+gst_matroska_parse_build_cues (GstMatroskaParse * parse)
+{
+  GstByteWriter points, pos, bw;
+  GstBuffer *buffer;
+  guint i;
+
+  gst_byte_writer_init (&points);
+  gst_byte_writer_init (&pos);
+
+  for (i = 0; i < parse->cues->len; i++) {
+    GstMatroskaParseCue *cue =
+        &g_array_index (parse->cues, GstMatroskaParseCue, i);
+    guint pos_size, point_size;
+
+    gst_byte_writer_reset (&pos);
+    gst_matroska_parse_write_uint (&pos, GST_MATROSKA_ID_CUETRACK, cue->track);
+    gst_matroska_parse_write_uint (&pos, GST_MATROSKA_ID_CUECLUSTERPOSITION,
+        cue->cluster_position);
+    pos_size = gst_byte_writer_get_pos (&pos);
+
+    point_size = 2 + gst_matroska_parse_uint_size (cue->time) + 1 +
+        (pos_size < 0x7f ? 1 : 8) + pos_size;
+
+    gst_matroska_parse_write_id (&points, GST_MATROSKA_ID_POINTENTRY);
+    gst_matroska_parse_write_size (&points, point_size);
+    gst_matroska_parse_write_uint (&points, GST_MATROSKA_ID_CUETIME, cue->time);
+    gst_matroska_parse_write_id (&points, GST_MATROSKA_ID_CUETRACKPOSITIONS);
+    gst_matroska_parse_write_size (&points, pos_size);
+    gst_byte_writer_put_data (&points, gst_byte_writer_get_data (&pos),
+        pos_size);
+  }
+  gst_byte_writer_reset (&pos);
+
+  gst_byte_writer_init (&bw);
+  gst_matroska_parse_write_id (&bw, GST_MATROSKA_ID_CUES);
+  gst_matroska_parse_write_size (&bw, gst_byte_writer_get_pos (&points));
+  gst_byte_writer_put_data (&bw, gst_byte_writer_get_data (&points),
+      gst_byte_writer_get_pos (&points));
+  gst_byte_writer_reset (&points);
+
+  buffer = gst_byte_writer_reset_and_get_buffer (&bw);
+  GST_BUFFER_TIMESTAMP (buffer) = parse->last_timestamp;
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  GST_DEBUG_OBJECT (parse, "built Cues of %u points, %" G_GSIZE_FORMAT
+      " bytes", parse->cues->len, gst_buffer_get_size (buffer));
+
+  return buffer;
+}
+
 static GstFlowReturn
 gst_matroska_parse_parse_id (GstMatroskaParse * parse, guint32 id,
     guint64 length, guint needed)
@@ -3061,6 +3248,9 @@ gst_matroska_parse_handle_sink_event (GstPad * pad, GstObject * parent,
         GST_ELEMENT_ERROR (parse, STREAM, DEMUX,
             (NULL), ("got eos but no streams (yet)"));
       } else {
+        if (parse->build_cues && parse->cues->len > 0
+            && !parse->common.index_parsed && parse->pushed_headers)
+          gst_pad_push (parse->srcpad, gst_matroska_parse_build_cues (parse));
         gst_matroska_parse_send_event (parse, event);
       }
       break;
@@ -93,6 +93,11 @@ typedef struct _GstMatroskaParse {
   /* reverse playback */
   GArray                  *seek_index;
   gint                     seek_entry;
+
+  /* Cues built from the keyframes that passed through, written at EOS */
+  gboolean                 build_cues;
+  GArray                  *cues;
+  guint64                  last_cue_cluster;
 } GstMatroskaParse;
 
 typedef struct _GstMatroskaParseClass {
@@ -70,25 +70,37 @@ typedef struct
 } TargetTypeContext;
 
 
+/* Matroska does not store the decompressed size of a block, so the output
+ * buffer starts at the size the previous block of the track decompressed
+ * to, which is usually close, and is doubled whenever it runs full. */
+static gsize
+gst_matroska_decompress_initial_size (GstMatroskaTrackEncoding * enc,
+    gsize size)
+{
+  if (enc->size_hint > 0)
+    return enc->size_hint + enc->size_hint / 8;
+
+  return MAX (4096, size * 2);
+}
+
 static gboolean
 gst_matroska_decompress_data (GstMatroskaTrackEncoding * enc,
     gpointer * data_out, gsize * size_out,
     GstMatroskaTrackCompressionAlgorithm algo)
 {
   guint8 *new_data = NULL;
-  guint new_size = 0;
+  gsize new_size = 0;
   guint8 *data = *data_out;
-  guint size = *size_out;
+  gsize size = *size_out;
   gboolean ret = TRUE;
 
   if (algo == GST_MATROSKA_TRACK_COMPRESSION_ALGORITHM_ZLIB) {
 #ifdef HAVE_ZLIB
     /* zlib encoded data */
     z_stream zstream;
-    guint orig_size;
+    gsize alloc_size;
     int result;
 
-    orig_size = size;
     zstream.zalloc = (alloc_func) 0;
     zstream.zfree = (free_func) 0;
     zstream.opaque = (voidpf) 0;
@@ -97,33 +109,36 @@ gst_matroska_decompress_data (GstMatroskaTrackEncoding * enc,
       ret = FALSE;
       goto out;
     }
+    alloc_size = gst_matroska_decompress_initial_size (enc, size);
+    new_data = g_malloc (alloc_size);
     zstream.next_in = (Bytef *) data;
-    zstream.avail_in = orig_size;
-    new_size = orig_size;
-    new_data = g_malloc (new_size);
-    zstream.avail_out = new_size;
+    zstream.avail_in = size;
     zstream.next_out = (Bytef *) new_data;
+    zstream.avail_out = alloc_size;
 
-    do {
-      result = inflate (&zstream, Z_NO_FLUSH);
-      if (result != Z_OK && result != Z_STREAM_END) {
-        GST_WARNING ("zlib decompression failed.");
-        g_free (new_data);
-        inflateEnd (&zstream);
-        break;
+    while ((result = inflate (&zstream, Z_NO_FLUSH)) == Z_OK) {
+      if (zstream.avail_out > 0) {
+        /* all input used without reaching the end of the stream */
+        if (zstream.avail_in == 0)
+          break;
+        continue;
       }
-      new_size += 4000;
-      new_data = g_realloc (new_data, new_size);
+      if (alloc_size >= G_MAXUINT / 2)
+        break;
+      new_data = g_realloc (new_data, alloc_size * 2);
       zstream.next_out = (Bytef *) (new_data + zstream.total_out);
-      zstream.avail_out += 4000;
-    } while (zstream.avail_in != 0 && result != Z_STREAM_END);
+      zstream.avail_out = alloc_size;
+      alloc_size *= 2;
+    }
+
+    new_size = zstream.total_out;
+    inflateEnd (&zstream);
 
     if (result != Z_STREAM_END) {
+      GST_WARNING ("zlib decompression failed.");
+      g_free (new_data);
       ret = FALSE;
       goto out;
-    } else {
-      new_size = zstream.total_out;
-      inflateEnd (&zstream);
     }
 #else
     GST_WARNING ("zlib encoded tracks not supported.");
@@ -134,13 +149,12 @@ gst_matroska_decompress_data (GstMatroskaTrackEncoding * enc,
 #ifdef HAVE_BZ2
     /* bzip2 encoded data */
     bz_stream bzstream;
-    guint orig_size;
+    gsize alloc_size;
     int result;
 
     bzstream.bzalloc = NULL;
     bzstream.bzfree = NULL;
     bzstream.opaque = NULL;
-    orig_size = size;
 
     if (BZ2_bzDecompressInit (&bzstream, 0, 0) != BZ_OK) {
       GST_WARNING ("bzip2 initialization failed.");
@@ -148,33 +162,36 @@ gst_matroska_decompress_data (GstMatroskaTrackEncoding * enc,
       goto out;
     }
 
+    alloc_size = gst_matroska_decompress_initial_size (enc, size);
+    new_data = g_malloc (alloc_size);
     bzstream.next_in = (char *) data;
-    bzstream.avail_in = orig_size;
-    new_size = orig_size;
-    new_data = g_malloc (new_size);
-    bzstream.avail_out = new_size;
+    bzstream.avail_in = size;
     bzstream.next_out = (char *) new_data;
+    bzstream.avail_out = alloc_size;
 
-    do {
-      result = BZ2_bzDecompress (&bzstream);
-      if (result != BZ_OK && result != BZ_STREAM_END) {
-        GST_WARNING ("bzip2 decompression failed.");
-        g_free (new_data);
-        BZ2_bzDecompressEnd (&bzstream);
-        break;
+    while ((result = BZ2_bzDecompress (&bzstream)) == BZ_OK) {
+      if (bzstream.avail_out > 0) {
+        /* all input used without reaching the end of the stream */
+        if (bzstream.avail_in == 0)
+          break;
+        continue;
       }
-      new_size += 4000;
-      new_data = g_realloc (new_data, new_size);
+      if (alloc_size >= G_MAXUINT / 2)
+        break;
+      new_data = g_realloc (new_data, alloc_size * 2);
       bzstream.next_out = (char *) (new_data + bzstream.total_out_lo32);
-      bzstream.avail_out += 4000;
-    } while (bzstream.avail_in != 0 && result != BZ_STREAM_END);
+      bzstream.avail_out = alloc_size;
+      alloc_size *= 2;
+    }
+
+    new_size = bzstream.total_out_lo32;
+    BZ2_bzDecompressEnd (&bzstream);
 
     if (result != BZ_STREAM_END) {
+      GST_WARNING ("bzip2 decompression failed.");
+      g_free (new_data);
       ret = FALSE;
       goto out;
-    } else {
-      new_size = bzstream.total_out_lo32;
-      BZ2_bzDecompressEnd (&bzstream);
     }
 #else
     GST_WARNING ("bzip2 encoded tracks not supported.");
@@ -184,28 +201,28 @@ gst_matroska_decompress_data (GstMatroskaTrackEncoding * enc,
   } else if (algo == GST_MATROSKA_TRACK_COMPRESSION_ALGORITHM_LZO1X) {
     /* lzo encoded data */
     int result;
-    int orig_size, out_size;
+    int in_left, out_left;
 
-    orig_size = size;
-    out_size = size;
-    new_size = size;
+    /* the decoder can't be resumed, it starts over with a buffer twice as
+     * large when the output does not fit */
+    new_size = gst_matroska_decompress_initial_size (enc, size);
     new_data = g_malloc (new_size);
 
-    do {
-      orig_size = size;
-      out_size = new_size;
+    while (TRUE) {
+      in_left = size;
+      out_left = new_size;
 
-      result = lzo1x_decode (new_data, &out_size, data, &orig_size);
+      result = lzo1x_decode (new_data, &out_left, data, &in_left);
 
-      if (orig_size > 0) {
-        new_size += 4000;
-        new_data = g_realloc (new_data, new_size);
-      }
-    } while (orig_size > 0 && result == LZO_OUTPUT_FULL);
+      if (result != LZO_OUTPUT_FULL || new_size >= G_MAXINT / 2)
+        break;
 
-    new_size -= out_size;
+      new_size *= 2;
+      g_free (new_data);
+      new_data = g_malloc (new_size);
+    }
 
-    if (result != LZO_OUTPUT_FULL) {
+    if (result != 0) {
       GST_WARNING ("lzo decompression failed");
       g_free (new_data);
 
@@ -213,6 +230,8 @@ gst_matroska_decompress_data (GstMatroskaTrackEncoding * enc,
       goto out;
     }
 
+    new_size -= out_left;
+
   } else if (algo == GST_MATROSKA_TRACK_COMPRESSION_ALGORITHM_HEADERSTRIP) {
     /* header stripped encoded data */
     if (enc->comp_settings_length > 0) {
@@ -227,6 +246,9 @@ gst_matroska_decompress_data (GstMatroskaTrackEncoding * enc,
     ret = FALSE;
   }
 
+  if (ret && algo != GST_MATROSKA_TRACK_COMPRESSION_ALGORITHM_HEADERSTRIP)
+    enc->size_hint = new_size;
+
 out:
 
   if (!ret) {
@@ -129,6 +129,8 @@ GST_DEBUG_CATEGORY_STATIC (gst_multi_file_sink_debug);
 #define DEFAULT_NEXT_FILE GST_MULTI_FILE_SINK_NEXT_BUFFER
 #define DEFAULT_MAX_FILES 0
 #define DEFAULT_MAX_FILE_SIZE G_GUINT64_CONSTANT(2*1024*1024*1024)
+#define DEFAULT_ASYNC_WRITE FALSE
+#define DEFAULT_MAX_QUEUED_BYTES (8 * 1024 * 1024)
 
 enum
 {
@@ -139,6 +141,8 @@ enum
   PROP_NEXT_FILE,
   PROP_MAX_FILES,
   PROP_MAX_FILE_SIZE,
+  PROP_ASYNC_WRITE,
+  PROP_MAX_QUEUED_BYTES,
   PROP_LAST
 };
 
@@ -150,6 +154,8 @@ static void gst_multi_file_sink_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
 static gboolean gst_multi_file_sink_stop (GstBaseSink * sink);
+static gboolean gst_multi_file_sink_unlock (GstBaseSink * sink);
+static gboolean gst_multi_file_sink_unlock_stop (GstBaseSink * sink);
 static GstFlowReturn gst_multi_file_sink_render (GstBaseSink * sink,
     GstBuffer * buffer);
 static GstFlowReturn gst_multi_file_sink_render_list (GstBaseSink * sink,
@@ -165,6 +171,27 @@ static void gst_multi_file_sink_ensure_max_files (GstMultiFileSink *
 static gboolean gst_multi_file_sink_event (GstBaseSink * sink,
     GstEvent * event);
 
+typedef enum
+{
+  GST_MULTI_FILE_SINK_JOB_WRITE,
+  GST_MULTI_FILE_SINK_JOB_CLOSE,
+  GST_MULTI_FILE_SINK_JOB_CONTENTS,
+  GST_MULTI_FILE_SINK_JOB_PREOPEN
+} GstMultiFileSinkJobType;
+
+/* a unit of work for the writer thread in async-write mode */
+typedef struct
+{
+  GstMultiFileSinkJobType type;
+  FILE *file;
+  GstBuffer *buffer;
+  gchar *filename;
+} GstMultiFileSinkJob;
+
+/* once the writer thread runs, all I/O has to go through it to keep the
+ * order, even if async-write was switched off in the meantime */
+#define IS_ASYNC(sink) ((sink)->async_write || (sink)->writer_thread != NULL)
+
 #define GST_TYPE_MULTI_FILE_SINK_NEXT (gst_multi_file_sink_next_get_type ())
 static GType
 gst_multi_file_sink_next_get_type (void)
@@ -261,9 +288,41 @@ gst_multi_file_sink_class_init (GstMultiFileSinkClass * klass)
           0, G_MAXUINT64, DEFAULT_MAX_FILE_SIZE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMultiFileSink:async-write:
+   *
+   * Hand all file I/O (writing, closing and opening of new files) to a
+   * separate writer thread so that slow storage does not stall the streaming
+   * thread. The file of the next index is opened ahead of time so that
+   * switching to a new file does not block either.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_ASYNC_WRITE,
+      g_param_spec_boolean ("async-write", "Async Write",
+          "Write files from a separate thread",
+          DEFAULT_ASYNC_WRITE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstMultiFileSink:max-queued-bytes:
+   *
+   * Maximum amount of data waiting for the writer thread in async-write mode
+   * before the streaming thread blocks.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_QUEUED_BYTES,
+      g_param_spec_uint64 ("max-queued-bytes", "Max Queued Bytes",
+          "Maximum number of bytes queued for the writer thread in "
+          "async-write mode", 0, G_MAXUINT64, DEFAULT_MAX_QUEUED_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gobject_class->finalize = gst_multi_file_sink_finalize;
 
   gstbasesink_class->stop = GST_DEBUG_FUNCPTR (gst_multi_file_sink_stop);
+  gstbasesink_class->unlock = GST_DEBUG_FUNCPTR (gst_multi_file_sink_unlock);
+  gstbasesink_class->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_multi_file_sink_unlock_stop);
   gstbasesink_class->render = GST_DEBUG_FUNCPTR (gst_multi_file_sink_render);
   gstbasesink_class->render_list =
       GST_DEBUG_FUNCPTR (gst_multi_file_sink_render_list);
@@ -292,6 +351,12 @@ gst_multi_file_sink_init (GstMultiFileSink * multifilesink)
   multifilesink->max_file_size = DEFAULT_MAX_FILE_SIZE;
   multifilesink->files = NULL;
   multifilesink->n_files = 0;
+  multifilesink->async_write = DEFAULT_ASYNC_WRITE;
+  multifilesink->max_queued_bytes = DEFAULT_MAX_QUEUED_BYTES;
+
+  g_mutex_init (&multifilesink->writer_lock);
+  g_cond_init (&multifilesink->writer_cond);
+  g_queue_init (&multifilesink->writer_queue);
 
   gst_base_sink_set_sync (GST_BASE_SINK (multifilesink), FALSE);
 
@@ -307,6 +372,8 @@ gst_multi_file_sink_finalize (GObject * object)
   g_free (sink->filename);
   g_slist_foreach (sink->files, (GFunc) g_free, NULL);
   g_slist_free (sink->files);
+  g_mutex_clear (&sink->writer_lock);
+  g_cond_clear (&sink->writer_cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -347,6 +414,12 @@ gst_multi_file_sink_set_property (GObject * object, guint prop_id,
     case PROP_MAX_FILE_SIZE:
       sink->max_file_size = g_value_get_uint64 (value);
       break;
+    case PROP_ASYNC_WRITE:
+      sink->async_write = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_QUEUED_BYTES:
+      sink->max_queued_bytes = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -378,12 +451,264 @@ gst_multi_file_sink_get_property (GObject * object, guint prop_id,
     case PROP_MAX_FILE_SIZE:
       g_value_set_uint64 (value, sink->max_file_size);
       break;
+    case PROP_ASYNC_WRITE:
+      g_value_set_boolean (value, sink->async_write);
+      break;
+    case PROP_MAX_QUEUED_BYTES:
+      g_value_set_uint64 (value, sink->max_queued_bytes);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_multi_file_sink_job_free (GstMultiFileSinkJob * job)
+{
+  if (job->buffer)
+    gst_buffer_unref (job->buffer);
+  g_free (job->filename);
+  g_slice_free (GstMultiFileSinkJob, job);
+}
+
+/* runs a job, returns 0 or the errno of the failed operation */
+static gint
+gst_multi_file_sink_run_job (GstMultiFileSink * sink, GstMultiFileSinkJob * job)
+{
+  GstMapInfo map;
+  GError *error = NULL;
+  gint err = 0;
+
+  switch (job->type) {
+    case GST_MULTI_FILE_SINK_JOB_WRITE:
+      gst_buffer_map (job->buffer, &map, GST_MAP_READ);
+      if (map.size > 0 && fwrite (map.data, map.size, 1, job->file) != 1)
+        err = errno;
+      gst_buffer_unmap (job->buffer, &map);
+      break;
+    case GST_MULTI_FILE_SINK_JOB_CLOSE:
+      if (fclose (job->file) != 0)
+        err = errno;
+      break;
+    case GST_MULTI_FILE_SINK_JOB_CONTENTS:
+      gst_buffer_map (job->buffer, &map, GST_MAP_READ);
+      if (!g_file_set_contents (job->filename, (char *) map.data, map.size,
+              &error)) {
+        GST_WARNING_OBJECT (sink, "failed to write %s: %s", job->filename,
+            error->message);
+        err = (error->code == G_FILE_ERROR_NOSPC) ? ENOSPC : EIO;
+        g_error_free (error);
+      }
+      gst_buffer_unmap (job->buffer, &map);
+      break;
+    case GST_MULTI_FILE_SINK_JOB_PREOPEN:
+      /* hold the lock so the streaming thread cannot cancel the preopen
+       * while we are creating the file */
+      g_mutex_lock (&sink->writer_lock);
+      if (sink->preopen_file == NULL &&
+          g_strcmp0 (job->filename, sink->preopen_filename) == 0) {
+        GST_DEBUG_OBJECT (sink, "preopening file %s", job->filename);
+        sink->preopen_file = g_fopen (job->filename, "wb");
+      }
+      g_mutex_unlock (&sink->writer_lock);
+      break;
+  }
+
+  return err;
+}
+
+static gpointer
+gst_multi_file_sink_writer_func (GstMultiFileSink * sink)
+{
+  GstMultiFileSinkJob *job;
+  gint err;
+
+  g_mutex_lock (&sink->writer_lock);
+  while (TRUE) {
+    job = g_queue_pop_head (&sink->writer_queue);
+    if (job == NULL) {
+      if (sink->writer_stop)
+        break;
+      g_cond_wait (&sink->writer_cond, &sink->writer_lock);
+      continue;
+    }
+    g_mutex_unlock (&sink->writer_lock);
+
+    err = gst_multi_file_sink_run_job (sink, job);
+
+    g_mutex_lock (&sink->writer_lock);
+    if (err != 0 && sink->writer_errno == 0)
+      sink->writer_errno = err;
+    if (job->buffer)
+      sink->queued_bytes -= gst_buffer_get_size (job->buffer);
+    g_cond_broadcast (&sink->writer_cond);
+    g_mutex_unlock (&sink->writer_lock);
+
+    gst_multi_file_sink_job_free (job);
+    g_mutex_lock (&sink->writer_lock);
+  }
+  g_mutex_unlock (&sink->writer_lock);
+
+  return NULL;
+}
+
+/* takes ownership of @job. Jobs are executed in order by the writer thread,
+ * or synchronously if the thread could not be started. Returns FALSE with
+ * errno set if an earlier write failed. */
+static gboolean
+gst_multi_file_sink_push_job (GstMultiFileSink * sink,
+    GstMultiFileSinkJobType type, FILE * file, GstBuffer * buffer,
+    gchar * filename)
+{
+  GstMultiFileSinkJob *job;
+  GError *error = NULL;
+  gint err;
+
+  job = g_slice_new (GstMultiFileSinkJob);
+  job->type = type;
+  job->file = file;
+  job->buffer = buffer;
+  job->filename = filename;
+
+  g_mutex_lock (&sink->writer_lock);
+  if (sink->writer_thread == NULL && !sink->writer_failed) {
+    sink->writer_stop = FALSE;
+    sink->writer_thread = g_thread_try_new ("multifilesink-writer",
+        (GThreadFunc) gst_multi_file_sink_writer_func, sink, &error);
+    if (sink->writer_thread == NULL) {
+      GST_WARNING_OBJECT (sink, "failed to start writer thread: %s",
+          error->message);
+      g_error_free (error);
+      sink->writer_failed = TRUE;
+    }
+  }
+  if (sink->writer_thread == NULL) {
+    g_mutex_unlock (&sink->writer_lock);
+    err = gst_multi_file_sink_run_job (sink, job);
+    gst_multi_file_sink_job_free (job);
+    if (err != 0) {
+      errno = err;
+      return FALSE;
+    }
+    return TRUE;
+  }
+
+  if (buffer)
+    sink->queued_bytes += gst_buffer_get_size (buffer);
+  g_queue_push_tail (&sink->writer_queue, job);
+  g_cond_broadcast (&sink->writer_cond);
+  err = sink->writer_errno;
+  g_mutex_unlock (&sink->writer_lock);
+
+  if (err != 0) {
+    errno = err;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* blocks until there is room in the writer queue. Returns GST_FLOW_FLUSHING
+ * when unlocked, GST_FLOW_ERROR with errno set when the writer failed */
+static GstFlowReturn
+gst_multi_file_sink_wait_queue (GstMultiFileSink * sink)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  g_mutex_lock (&sink->writer_lock);
+  while (sink->writer_thread != NULL && !sink->writer_flushing &&
+      sink->writer_errno == 0 && sink->queued_bytes > 0 &&
+      sink->queued_bytes >= sink->max_queued_bytes) {
+    GST_LOG_OBJECT (sink, "waiting for writer, %" G_GUINT64_FORMAT
+        " bytes queued", sink->queued_bytes);
+    g_cond_wait (&sink->writer_cond, &sink->writer_lock);
+  }
+  if (sink->writer_errno != 0) {
+    errno = sink->writer_errno;
+    ret = GST_FLOW_ERROR;
+  } else if (sink->writer_flushing) {
+    ret = GST_FLOW_FLUSHING;
+  }
+  g_mutex_unlock (&sink->writer_lock);
+
+  return ret;
+}
+
+/* closes or discards the file that was opened ahead of time */
+static void
+gst_multi_file_sink_cancel_preopen (GstMultiFileSink * sink)
+{
+  g_mutex_lock (&sink->writer_lock);
+  if (sink->preopen_file) {
+    GST_DEBUG_OBJECT (sink, "discarding preopened file %s",
+        sink->preopen_filename);
+    fclose (sink->preopen_file);
+    g_remove (sink->preopen_filename);
+    sink->preopen_file = NULL;
+  }
+  g_free (sink->preopen_filename);
+  sink->preopen_filename = NULL;
+  g_mutex_unlock (&sink->writer_lock);
+}
+
+static void
+gst_multi_file_sink_stop_writer (GstMultiFileSink * sink)
+{
+  g_mutex_lock (&sink->writer_lock);
+  sink->writer_stop = TRUE;
+  g_cond_broadcast (&sink->writer_cond);
+  g_mutex_unlock (&sink->writer_lock);
+
+  /* the writer drains the queue before it exits */
+  if (sink->writer_thread) {
+    g_thread_join (sink->writer_thread);
+    sink->writer_thread = NULL;
+  }
+
+  gst_multi_file_sink_cancel_preopen (sink);
+
+  sink->writer_stop = FALSE;
+  sink->writer_failed = FALSE;
+  sink->writer_errno = 0;
+  sink->queued_bytes = 0;
+}
+
+static gboolean
+gst_multi_file_sink_write_buffer (GstMultiFileSink * sink, GstBuffer * buffer,
+    GstMapInfo * map)
+{
+  if (IS_ASYNC (sink))
+    return gst_multi_file_sink_push_job (sink, GST_MULTI_FILE_SINK_JOB_WRITE,
+        sink->file, gst_buffer_ref (buffer), NULL);
+
+  return fwrite (map->data, map->size, 1, sink->file) == 1;
+}
+
+static gboolean
+gst_multi_file_sink_unlock (GstBaseSink * sink)
+{
+  GstMultiFileSink *multifilesink = GST_MULTI_FILE_SINK (sink);
+
+  g_mutex_lock (&multifilesink->writer_lock);
+  multifilesink->writer_flushing = TRUE;
+  g_cond_broadcast (&multifilesink->writer_cond);
+  g_mutex_unlock (&multifilesink->writer_lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_multi_file_sink_unlock_stop (GstBaseSink * sink)
+{
+  GstMultiFileSink *multifilesink = GST_MULTI_FILE_SINK (sink);
+
+  g_mutex_lock (&multifilesink->writer_lock);
+  multifilesink->writer_flushing = FALSE;
+  g_mutex_unlock (&multifilesink->writer_lock);
+
+  return TRUE;
+}
+
 static gboolean
 gst_multi_file_sink_stop (GstBaseSink * sink)
 {
@@ -393,9 +718,14 @@ gst_multi_file_sink_stop (GstBaseSink * sink)
   multifilesink = GST_MULTI_FILE_SINK (sink);
 
   if (multifilesink->file != NULL) {
-    fclose (multifilesink->file);
+    if (multifilesink->writer_thread)
+      gst_multi_file_sink_push_job (multifilesink,
+          GST_MULTI_FILE_SINK_JOB_CLOSE, multifilesink->file, NULL, NULL);
+    else
+      fclose (multifilesink->file);
     multifilesink->file = NULL;
   }
+  gst_multi_file_sink_stop_writer (multifilesink);
 
   if (multifilesink->streamheaders) {
     for (i = 0; i < multifilesink->n_streamheaders; i++) {
@@ -479,14 +809,14 @@ gst_multi_file_sink_write_stream_headers (GstMultiFileSink * sink)
   for (i = 0; i < sink->n_streamheaders; i++) {
     GstBuffer *hdr;
     GstMapInfo map;
-    int ret;
+    gboolean ret;
 
     hdr = sink->streamheaders[i];
     gst_buffer_map (hdr, &map, GST_MAP_READ);
-    ret = fwrite (map.data, map.size, 1, sink->file);
+    ret = gst_multi_file_sink_write_buffer (sink, hdr, &map);
     gst_buffer_unmap (hdr, &map);
 
-    if (ret != 1)
+    if (!ret)
       return FALSE;
 
     sink->cur_file_size += map.size;
@@ -504,10 +834,20 @@ gst_multi_file_sink_render (GstBaseSink * sink, GstBuffer * buffer)
   gboolean ret;
   GError *error = NULL;
   gboolean first_file = TRUE;
+  GstFlowReturn flow = GST_FLOW_OK;
+
+  multifilesink = GST_MULTI_FILE_SINK (sink);
+
+  if (IS_ASYNC (multifilesink)) {
+    flow = gst_multi_file_sink_wait_queue (multifilesink);
+    if (flow == GST_FLOW_FLUSHING)
+      return flow;
+  }
 
   gst_buffer_map (buffer, &map, GST_MAP_READ);
 
-  multifilesink = GST_MULTI_FILE_SINK (sink);
+  if (flow != GST_FLOW_OK)
+    goto stdio_write_error;
 
   switch (multifilesink->next_file) {
     case GST_MULTI_FILE_SINK_NEXT_BUFFER:
@@ -515,9 +855,19 @@ gst_multi_file_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 
       filename = g_strdup_printf (multifilesink->filename,
           multifilesink->index);
-      ret = g_file_set_contents (filename, (char *) map.data, map.size, &error);
-      if (!ret)
-        goto write_error;
+      if (IS_ASYNC (multifilesink)) {
+        if (!gst_multi_file_sink_push_job (multifilesink,
+                GST_MULTI_FILE_SINK_JOB_CONTENTS, NULL, gst_buffer_ref (buffer),
+                g_strdup (filename))) {
+          g_free (filename);
+          goto stdio_write_error;
+        }
+      } else {
+        ret = g_file_set_contents (filename, (char *) map.data, map.size,
+            &error);
+        if (!ret)
+          goto write_error;
+      }
 
       multifilesink->files = g_slist_append (multifilesink->files, filename);
       multifilesink->n_files += 1;
@@ -537,8 +887,7 @@ gst_multi_file_sink_render (GstBaseSink * sink, GstBuffer * buffer)
           goto stdio_write_error;
       }
 
-      ret = fwrite (map.data, map.size, 1, multifilesink->file);
-      if (ret != 1)
+      if (!gst_multi_file_sink_write_buffer (multifilesink, buffer, &map))
         goto stdio_write_error;
 
       break;
@@ -568,8 +917,7 @@ gst_multi_file_sink_render (GstBaseSink * sink, GstBuffer * buffer)
           gst_multi_file_sink_write_stream_headers (multifilesink);
       }
 
-      ret = fwrite (map.data, map.size, 1, multifilesink->file);
-      if (ret != 1)
+      if (!gst_multi_file_sink_write_buffer (multifilesink, buffer, &map))
         goto stdio_write_error;
 
       break;
@@ -584,9 +932,7 @@ gst_multi_file_sink_render (GstBaseSink * sink, GstBuffer * buffer)
          */
       }
 
-      ret = fwrite (map.data, map.size, 1, multifilesink->file);
-
-      if (ret != 1)
+      if (!gst_multi_file_sink_write_buffer (multifilesink, buffer, &map))
         goto stdio_write_error;
 
       break;
@@ -615,9 +961,7 @@ gst_multi_file_sink_render (GstBaseSink * sink, GstBuffer * buffer)
           gst_multi_file_sink_write_stream_headers (multifilesink);
       }
 
-      ret = fwrite (map.data, map.size, 1, multifilesink->file);
-
-      if (ret != 1)
+      if (!gst_multi_file_sink_write_buffer (multifilesink, buffer, &map))
         goto stdio_write_error;
 
       multifilesink->cur_file_size += map.size;
@@ -854,7 +1198,24 @@ gst_multi_file_sink_open_next_file (GstMultiFileSink * multifilesink)
 
   gst_multi_file_sink_ensure_max_files (multifilesink);
   filename = g_strdup_printf (multifilesink->filename, multifilesink->index);
-  multifilesink->file = g_fopen (filename, "wb");
+
+  if (multifilesink->async_write) {
+    /* use the file the writer thread opened ahead of time, if any */
+    g_mutex_lock (&multifilesink->writer_lock);
+    if (multifilesink->preopen_file &&
+        g_strcmp0 (filename, multifilesink->preopen_filename) == 0) {
+      multifilesink->file = multifilesink->preopen_file;
+      multifilesink->preopen_file = NULL;
+      g_free (multifilesink->preopen_filename);
+      multifilesink->preopen_filename = NULL;
+    }
+    g_mutex_unlock (&multifilesink->writer_lock);
+    if (multifilesink->file == NULL)
+      gst_multi_file_sink_cancel_preopen (multifilesink);
+  }
+
+  if (multifilesink->file == NULL)
+    multifilesink->file = g_fopen (filename, "wb");
   if (multifilesink->file == NULL) {
     g_free (filename);
     return FALSE;
@@ -865,6 +1226,24 @@ gst_multi_file_sink_open_next_file (GstMultiFileSink * multifilesink)
   multifilesink->n_files += 1;
 
   multifilesink->cur_file_size = 0;
+
+  if (multifilesink->async_write) {
+    gchar *next;
+
+    next = g_strdup_printf (multifilesink->filename, multifilesink->index + 1);
+    /* with one buffer per file or a constant location there is nothing to
+     * open ahead of time */
+    if (g_strcmp0 (next, filename) != 0) {
+      g_mutex_lock (&multifilesink->writer_lock);
+      multifilesink->preopen_filename = g_strdup (next);
+      g_mutex_unlock (&multifilesink->writer_lock);
+      gst_multi_file_sink_push_job (multifilesink,
+          GST_MULTI_FILE_SINK_JOB_PREOPEN, NULL, NULL, next);
+    } else {
+      g_free (next);
+    }
+  }
+
   return TRUE;
 }
 
@@ -874,7 +1253,11 @@ gst_multi_file_sink_close_file (GstMultiFileSink * multifilesink,
 {
   char *filename;
 
-  fclose (multifilesink->file);
+  if (IS_ASYNC (multifilesink))
+    gst_multi_file_sink_push_job (multifilesink, GST_MULTI_FILE_SINK_JOB_CLOSE,
+        multifilesink->file, NULL, NULL);
+  else
+    fclose (multifilesink->file);
   multifilesink->file = NULL;
 
   if (buffer) {
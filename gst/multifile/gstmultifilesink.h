@@ -94,6 +94,22 @@ struct _GstMultiFileSink
 
   guint64 cur_file_size;
   guint64 max_file_size;
+
+  /* async-write mode */
+  gboolean async_write;
+  guint64 max_queued_bytes;
+  GThread *writer_thread;
+  GMutex writer_lock;
+  GCond writer_cond;
+  GQueue writer_queue;
+  guint64 queued_bytes;
+  gboolean writer_stop;
+  gboolean writer_failed;
+  gboolean writer_flushing;
+  gint writer_errno;
+  /* next file, opened ahead of time by the writer thread */
+  FILE *preopen_file;
+  gchar *preopen_filename;
 };
 
 struct _GstMultiFileSinkClass
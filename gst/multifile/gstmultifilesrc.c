@@ -39,6 +39,10 @@
  * ]| This pipeline creates a video file "images.ogg" by joining multiple PNG
  * files named img.0000.png, img.0001.png, etc.
  * </refsect2>
+ *
+ * With #GstMultiFileSrc:prefetch the next files are read in parallel from a
+ * pool of threads while the current one is pushed downstream, which hides
+ * the latency of network storage for large image sequences.
 */
 
 #ifdef HAVE_CONFIG_H
@@ -59,6 +63,7 @@ static void gst_multi_file_src_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 static GstCaps *gst_multi_file_src_getcaps (GstBaseSrc * src, GstCaps * filter);
 static gboolean gst_multi_file_src_query (GstBaseSrc * src, GstQuery * query);
+static gboolean gst_multi_file_src_stop (GstBaseSrc * src);
 
 
 static GstStaticPadTemplate gst_multi_file_src_pad_template =
@@ -79,12 +84,26 @@ enum
   ARG_STOP_INDEX,
   ARG_CAPS,
   ARG_LOOP,
-  ARG_FILENAMES
+  ARG_FILENAMES,
+  ARG_PREFETCH
 };
 
 #define DEFAULT_LOCATION "%05d"
 #define DEFAULT_INDEX 0
 #define DEFAULT_FILENAMES 0
+#define DEFAULT_PREFETCH 0
+
+/* one file read by the prefetch pool */
+typedef struct
+{
+  gchar *filename;
+  gchar *data;
+  gsize size;
+  GError *error;
+  gboolean done;
+  /* no longer wanted, the worker frees it */
+  gboolean abandoned;
+} GstMultiFileSrcPrefetch;
 
 #define gst_multi_file_src_parent_class parent_class
 G_DEFINE_TYPE (GstMultiFileSrc, gst_multi_file_src, GST_TYPE_PUSH_SRC);
@@ -181,6 +200,19 @@ gst_multi_file_src_class_init (GstMultiFileSrcClass * klass)
       g_param_spec_object ("filenames", "File names GPtrArray",
           "GPtrArray containing the filenames", DEFAULT_FILENAMES,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstMultiFileSrc:prefetch:
+   *
+   * Number of files after the current one that are read ahead in parallel,
+   * each by its own thread. 0 reads every file when it is needed. Changes
+   * take effect the next time the element is started.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, ARG_PREFETCH,
+      g_param_spec_uint ("prefetch", "Prefetch",
+          "Number of files to read ahead in parallel (0 = disabled)",
+          0, 64, DEFAULT_PREFETCH, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gobject_class->dispose = gst_multi_file_src_dispose;
 
@@ -188,6 +220,7 @@ gst_multi_file_src_class_init (GstMultiFileSrcClass * klass)
   gstbasesrc_class->query = gst_multi_file_src_query;
   gstbasesrc_class->is_seekable = is_seekable;
   gstbasesrc_class->do_seek = do_seek;
+  gstbasesrc_class->stop = gst_multi_file_src_stop;
 
   gstpushsrc_class->create = gst_multi_file_src_create;
 
@@ -212,6 +245,10 @@ gst_multi_file_src_init (GstMultiFileSrc * multifilesrc)
   multifilesrc->successful_read = FALSE;
   multifilesrc->fps_n = multifilesrc->fps_d = -1;
   multifilesrc->filenames = g_ptr_array_new ();
+  multifilesrc->prefetch = DEFAULT_PREFETCH;
+  multifilesrc->prefetch_items = g_hash_table_new (NULL, NULL);
+  g_mutex_init (&multifilesrc->prefetch_lock);
+  g_cond_init (&multifilesrc->prefetch_cond);
 }
 
 static void
@@ -223,6 +260,13 @@ gst_multi_file_src_dispose (GObject * object)
   src->filename = NULL;
   if (src->caps)
     gst_caps_unref (src->caps);
+  src->caps = NULL;
+  if (src->prefetch_items) {
+    g_hash_table_unref (src->prefetch_items);
+    g_mutex_clear (&src->prefetch_lock);
+    g_cond_clear (&src->prefetch_cond);
+    src->prefetch_items = NULL;
+  }
 
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
@@ -386,6 +430,9 @@ gst_multi_file_src_set_property (GObject * object, guint prop_id,
       src->start_index = 0;
       src->stop_index = src->filenames->len;
       break;
+    case ARG_PREFETCH:
+      src->prefetch = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -419,6 +466,10 @@ gst_multi_file_src_get_property (GObject * object, guint prop_id,
       break;
     case ARG_FILENAMES:
       g_value_set_object (value, src->filenames);
+      break;
+    case ARG_PREFETCH:
+      g_value_set_uint (value, src->prefetch);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -426,19 +477,175 @@ gst_multi_file_src_get_property (GObject * object, guint prop_id,
 }
 
 static gchar *
-gst_multi_file_src_get_filename (GstMultiFileSrc * multifilesrc)
+gst_multi_file_src_get_filename_for_index (GstMultiFileSrc * multifilesrc,
+    gint index)
 {
   gchar *filename;
 
   if (!multifilesrc->extension) {
-    GST_DEBUG ("%d", multifilesrc->index);
-    filename = g_strdup_printf (multifilesrc->filename, multifilesrc->index);
+    GST_DEBUG ("%d", index);
+    filename = g_strdup_printf (multifilesrc->filename, index);
+  } else if ((guint) index < multifilesrc->filenames->len) {
+    filename = g_strdup (g_ptr_array_index (multifilesrc->filenames, index));
   } else {
-    filename = g_ptr_array_index (multifilesrc->filenames, multifilesrc->index);
+    filename = NULL;
   }
   return filename;
 }
 
+static gchar *
+gst_multi_file_src_get_filename (GstMultiFileSrc * multifilesrc)
+{
+  return gst_multi_file_src_get_filename_for_index (multifilesrc,
+      multifilesrc->index);
+}
+
+static void
+gst_multi_file_src_prefetch_free (GstMultiFileSrcPrefetch * item)
+{
+  g_free (item->filename);
+  g_free (item->data);
+  if (item->error)
+    g_error_free (item->error);
+  g_slice_free (GstMultiFileSrcPrefetch, item);
+}
+
+static void
+gst_multi_file_src_prefetch_func (GstMultiFileSrcPrefetch * item,
+    GstMultiFileSrc * src)
+{
+  gchar *data = NULL;
+  gsize size = 0;
+  GError *error = NULL;
+  gboolean abandoned;
+
+  g_mutex_lock (&src->prefetch_lock);
+  abandoned = item->abandoned;
+  g_mutex_unlock (&src->prefetch_lock);
+
+  if (!abandoned) {
+    GST_LOG_OBJECT (src, "prefetching file \"%s\".",
+        GST_STR_NULL (item->filename));
+    if (item->filename)
+      g_file_get_contents (item->filename, &data, &size, &error);
+    else
+      g_set_error_literal (&error, G_FILE_ERROR, G_FILE_ERROR_NOENT,
+          "No more files");
+  }
+
+  g_mutex_lock (&src->prefetch_lock);
+  item->data = data;
+  item->size = size;
+  item->error = error;
+  item->done = TRUE;
+  if (item->abandoned)
+    gst_multi_file_src_prefetch_free (item);
+  else
+    g_cond_broadcast (&src->prefetch_cond);
+  g_mutex_unlock (&src->prefetch_lock);
+}
+
+static gboolean
+gst_multi_file_src_prefetch_abandon (gpointer key, gpointer value,
+    gpointer user_data)
+{
+  GstMultiFileSrcPrefetch *item = value;
+
+  if (item->done)
+    gst_multi_file_src_prefetch_free (item);
+  else
+    item->abandoned = TRUE;
+
+  return TRUE;
+}
+
+/* get the file at the current index from the prefetch pool and queue the
+ * reads of the files after it */
+static gboolean
+gst_multi_file_src_read_prefetched (GstMultiFileSrc * src, gchar ** data,
+    gsize * size, GError ** error)
+{
+  GstMultiFileSrcPrefetch *item;
+  gpointer key = GINT_TO_POINTER (src->index);
+  gint last;
+  gboolean ret;
+
+  if (src->prefetch_pool == NULL) {
+    src->prefetch_pool =
+        g_thread_pool_new ((GFunc) gst_multi_file_src_prefetch_func, src,
+        src->prefetch, FALSE, NULL);
+    src->prefetch_next = src->index;
+  }
+
+  g_mutex_lock (&src->prefetch_lock);
+  /* after a seek or a loop nothing that was read ahead is useful */
+  if (!g_hash_table_contains (src->prefetch_items, key)) {
+    g_hash_table_foreach_remove (src->prefetch_items,
+        gst_multi_file_src_prefetch_abandon, NULL);
+    src->prefetch_next = src->index;
+  }
+
+  last = src->index + src->prefetch;
+  if (src->stop_index != -1)
+    last = MIN (last, src->stop_index);
+  for (; src->prefetch_next <= last; src->prefetch_next++) {
+    item = g_slice_new0 (GstMultiFileSrcPrefetch);
+    item->filename =
+        gst_multi_file_src_get_filename_for_index (src, src->prefetch_next);
+    g_hash_table_insert (src->prefetch_items,
+        GINT_TO_POINTER (src->prefetch_next), item);
+    g_thread_pool_push (src->prefetch_pool, item, NULL);
+  }
+
+  item = g_hash_table_lookup (src->prefetch_items, key);
+  while (!item->done)
+    g_cond_wait (&src->prefetch_cond, &src->prefetch_lock);
+  g_hash_table_remove (src->prefetch_items, key);
+  g_mutex_unlock (&src->prefetch_lock);
+
+  ret = item->error == NULL;
+  if (ret) {
+    *data = item->data;
+    *size = item->size;
+    item->data = NULL;
+  } else {
+    g_propagate_error (error, item->error);
+    item->error = NULL;
+  }
+  gst_multi_file_src_prefetch_free (item);
+
+  return ret;
+}
+
+static gboolean
+gst_multi_file_src_read (GstMultiFileSrc * src, const gchar * filename,
+    gchar ** data, gsize * size, GError ** error)
+{
+  if (src->prefetch > 0)
+    return gst_multi_file_src_read_prefetched (src, data, size, error);
+
+  return g_file_get_contents (filename, data, size, error);
+}
+
+static gboolean
+gst_multi_file_src_stop (GstBaseSrc * src)
+{
+  GstMultiFileSrc *multifilesrc = GST_MULTI_FILE_SRC (src);
+
+  if (multifilesrc->prefetch_pool) {
+    g_mutex_lock (&multifilesrc->prefetch_lock);
+    g_hash_table_foreach_remove (multifilesrc->prefetch_items,
+        gst_multi_file_src_prefetch_abandon, NULL);
+    g_mutex_unlock (&multifilesrc->prefetch_lock);
+
+    /* let the queued reads run, they free themselves without reading */
+    g_thread_pool_free (multifilesrc->prefetch_pool, FALSE, TRUE);
+    multifilesrc->prefetch_pool = NULL;
+  }
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_multi_file_src_create (GstPushSrc * src, GstBuffer ** buffer)
 {
@@ -469,7 +676,7 @@ gst_multi_file_src_create (GstPushSrc * src, GstBuffer ** buffer)
 
   GST_DEBUG_OBJECT (multifilesrc, "reading from file \"%s\".", filename);
 
-  ret = g_file_get_contents (filename, &data, &size, &error);
+  ret = gst_multi_file_src_read (multifilesrc, filename, &data, &size, &error);
   if (!ret) {
     if (multifilesrc->successful_read) {
       /* If we've read at least one buffer successfully, not finding the
@@ -483,7 +690,8 @@ gst_multi_file_src_create (GstPushSrc * src, GstBuffer ** buffer)
         multifilesrc->index = multifilesrc->start_index;
 
         filename = gst_multi_file_src_get_filename (multifilesrc);
-        ret = g_file_get_contents (filename, &data, &size, &error);
+        ret = gst_multi_file_src_read (multifilesrc, filename, &data, &size,
+            &error);
         if (!ret) {
           g_free (filename);
           if (error != NULL)
@@ -61,6 +61,14 @@ struct _GstMultiFileSrc
 
   GPtrArray *filenames;
   gchar *extension;
+
+  /* read-ahead */
+  guint prefetch;
+  GThreadPool *prefetch_pool;
+  GHashTable *prefetch_items;
+  gint prefetch_next;
+  GMutex prefetch_lock;
+  GCond prefetch_cond;
 };
 
 struct _GstMultiFileSrcClass
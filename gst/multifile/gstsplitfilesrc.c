@@ -37,6 +37,9 @@
  * |[
  * gst-launch-1.0 playbin uri="splitfile://path/to/foo.avi.*"
  * ]| Plays the different parts as if they were one single AVI file.
+ * |[
+ * gst-launch-1.0 splitfilesrc location="/path/to/cam-*.ts" prefetch-size=4194304 ! tsdemux ! ...
+ * ]| Reads ahead up to 4MB from a separate thread, across file part boundaries.
  * </refsect2>
  */
 
@@ -57,10 +60,15 @@
 
 enum
 {
-  PROP_LOCATION = 1
+  PROP_LOCATION = 1,
+  PROP_PREFETCH_SIZE
 };
 
 #define DEFAULT_LOCATION NULL
+#define DEFAULT_PREFETCH_SIZE 0
+
+/* size of the reads done by the prefetch thread */
+#define PREFETCH_CHUNK_SIZE (64 * 1024)
 
 static void gst_split_file_src_uri_handler_init (gpointer g_iface,
     gpointer iface_data);
@@ -75,6 +83,7 @@ static gboolean gst_split_file_src_stop (GstBaseSrc * basesrc);
 static gboolean gst_split_file_src_can_seek (GstBaseSrc * basesrc);
 static gboolean gst_split_file_src_get_size (GstBaseSrc * basesrc, guint64 * s);
 static gboolean gst_split_file_src_unlock (GstBaseSrc * basesrc);
+static gboolean gst_split_file_src_unlock_stop (GstBaseSrc * basesrc);
 static GstFlowReturn gst_split_file_src_create (GstBaseSrc * basesrc,
     guint64 offset, guint size, GstBuffer ** buffer);
 
@@ -117,11 +126,28 @@ gst_split_file_src_class_init (GstSplitFileSrcClass * klass)
           "matching. The results will be sorted." WIN32_BLURB,
           DEFAULT_LOCATION, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstSplitFileSrc:prefetch-size:
+   *
+   * Amount of data to read ahead from a separate thread. The prefetch thread
+   * reads sequentially across file part boundaries, so switching to the next
+   * part does not stall the streaming thread. 0 disables prefetching.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_SIZE,
+      g_param_spec_uint ("prefetch-size", "Prefetch Size",
+          "Number of bytes to read ahead from a separate thread (0 = disabled)",
+          0, G_MAXUINT, DEFAULT_PREFETCH_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstbasesrc_class->start = GST_DEBUG_FUNCPTR (gst_split_file_src_start);
   gstbasesrc_class->stop = GST_DEBUG_FUNCPTR (gst_split_file_src_stop);
   gstbasesrc_class->create = GST_DEBUG_FUNCPTR (gst_split_file_src_create);
   gstbasesrc_class->get_size = GST_DEBUG_FUNCPTR (gst_split_file_src_get_size);
   gstbasesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_split_file_src_unlock);
+  gstbasesrc_class->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_split_file_src_unlock_stop);
   gstbasesrc_class->is_seekable =
       GST_DEBUG_FUNCPTR (gst_split_file_src_can_seek);
 
@@ -140,6 +166,10 @@ gst_split_file_src_class_init (GstSplitFileSrcClass * klass)
 static void
 gst_split_file_src_init (GstSplitFileSrc * splitfilesrc)
 {
+  splitfilesrc->prefetch_size = DEFAULT_PREFETCH_SIZE;
+  g_mutex_init (&splitfilesrc->prefetch_lock);
+  g_cond_init (&splitfilesrc->prefetch_cond);
+  g_queue_init (&splitfilesrc->prefetch_chunks);
 }
 
 static void
@@ -149,6 +179,8 @@ gst_split_file_src_finalize (GObject * obj)
 
   g_free (src->location);
   src->location = NULL;
+  g_mutex_clear (&src->prefetch_lock);
+  g_cond_clear (&src->prefetch_cond);
 
   G_OBJECT_CLASS (gst_split_file_src_parent_class)->finalize (obj);
 }
@@ -162,16 +194,34 @@ gst_split_file_src_can_seek (GstBaseSrc * basesrc)
 static gboolean
 gst_split_file_src_unlock (GstBaseSrc * basesrc)
 {
-  /* This is not actually that useful, since all normal file
-   * operations are fully blocking anyway */
-#if 0
   GstSplitFileSrc *src = GST_SPLIT_FILE_SRC (basesrc);
 
+  /* Cancelling is not actually that useful, since all normal file
+   * operations are fully blocking anyway */
+#if 0
   GST_DEBUG_OBJECT (src, "cancelling pending I/O operation if there is one");
   /* g_cancellable_cancel (src->cancellable); */
   GST_DEBUG_OBJECT (src, "done");
 #endif
 
+  /* wake up create() if it is waiting for the prefetch thread */
+  g_mutex_lock (&src->prefetch_lock);
+  src->prefetch_flushing = TRUE;
+  g_cond_broadcast (&src->prefetch_cond);
+  g_mutex_unlock (&src->prefetch_lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_split_file_src_unlock_stop (GstBaseSrc * basesrc)
+{
+  GstSplitFileSrc *src = GST_SPLIT_FILE_SRC (basesrc);
+
+  g_mutex_lock (&src->prefetch_lock);
+  src->prefetch_flushing = FALSE;
+  g_mutex_unlock (&src->prefetch_lock);
+
   return TRUE;
 }
 
@@ -213,6 +263,9 @@ gst_split_file_src_set_property (GObject * object, guint prop_id,
     case PROP_LOCATION:
       gst_split_file_src_set_location (src, g_value_get_string (value));
       break;
+    case PROP_PREFETCH_SIZE:
+      src->prefetch_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -231,6 +284,9 @@ gst_split_file_src_get_property (GObject * object, guint prop_id,
       g_value_set_string (value, src->location);
       GST_OBJECT_UNLOCK (src);
       break;
+    case PROP_PREFETCH_SIZE:
+      g_value_set_uint (value, src->prefetch_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -315,6 +371,9 @@ no_matches:
   }
 }
 
+static void gst_split_file_src_start_prefetch (GstSplitFileSrc * src);
+static void gst_split_file_src_stop_prefetch (GstSplitFileSrc * src);
+
 static gboolean
 gst_split_file_src_start (GstBaseSrc * basesrc)
 {
@@ -385,6 +444,9 @@ gst_split_file_src_start (GstBaseSrc * basesrc)
 
   src->cancellable = g_cancellable_new ();
 
+  if (src->prefetch_size > 0)
+    gst_split_file_src_start_prefetch (src);
+
   ret = TRUE;
 
 done:
@@ -437,6 +499,8 @@ gst_split_file_src_stop (GstBaseSrc * basesrc)
   GstSplitFileSrc *src = GST_SPLIT_FILE_SRC (basesrc);
   guint i;
 
+  gst_split_file_src_stop_prefetch (src);
+
   for (i = 0; i < src->num_parts; ++i) {
     if (src->parts[i].stream != NULL)
       g_object_unref (src->parts[i].stream);
@@ -472,6 +536,283 @@ gst_split_file_src_find_part_for_offset (GstSplitFileSrc * src, guint64 offset,
   return FALSE;
 }
 
+/* drops all prefetched data and restarts reading ahead at @offset.
+ * Must be called with the prefetch lock */
+static void
+gst_split_file_src_reset_prefetch (GstSplitFileSrc * src, guint64 offset)
+{
+  GstBuffer *chunk;
+
+  GST_DEBUG_OBJECT (src, "restarting prefetch at offset %" G_GUINT64_FORMAT,
+      offset);
+
+  while ((chunk = g_queue_pop_head (&src->prefetch_chunks)))
+    gst_buffer_unref (chunk);
+
+  src->prefetch_queued = 0;
+  src->prefetch_start = offset;
+  src->prefetch_end = offset;
+  src->prefetch_eos = FALSE;
+  src->prefetch_failed = FALSE;
+  src->prefetch_generation++;
+  g_cond_broadcast (&src->prefetch_cond);
+}
+
+/* reads the next chunk at @offset in the prefetch thread, using its own
+ * streams so the streaming thread can keep using the part streams. Returns
+ * NULL at the end of the last part or on error */
+static GstBuffer *
+gst_split_file_src_prefetch_chunk (GstSplitFileSrc * src, guint64 offset,
+    guint size, gboolean * error)
+{
+  GstFilePart *part;
+  GstBuffer *chunk;
+  GstMapInfo map;
+  GError *err = NULL;
+  guint64 read_offset;
+  gsize read = 0;
+  guint part_num;
+
+  *error = FALSE;
+
+  if (offset > src->parts[src->num_parts - 1].stop)
+    return NULL;
+
+  part_num = src->prefetch_part;
+  if (src->prefetch_stream == NULL || offset < src->parts[part_num].start ||
+      offset > src->parts[part_num].stop) {
+    GFile *file;
+
+    if (!gst_split_file_src_find_part_for_offset (src, offset, &part_num))
+      return NULL;
+
+    if (src->prefetch_stream)
+      g_object_unref (src->prefetch_stream);
+
+    GST_DEBUG_OBJECT (src, "prefetch thread opening part %u (%s)", part_num,
+        src->parts[part_num].path);
+    file = g_file_new_for_path (src->parts[part_num].path);
+    src->prefetch_stream = g_file_read (file, NULL, &err);
+    g_object_unref (file);
+    src->prefetch_part = part_num;
+    if (src->prefetch_stream == NULL)
+      goto failed;
+  }
+
+  part = &src->parts[part_num];
+  read_offset = offset - part->start;
+  size = MIN (size, part->stop + 1 - offset);
+
+  if (g_seekable_tell (G_SEEKABLE (src->prefetch_stream)) != read_offset &&
+      !g_seekable_seek (G_SEEKABLE (src->prefetch_stream), read_offset,
+          G_SEEK_SET, NULL, &err))
+    goto failed;
+
+  chunk = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_map (chunk, &map, GST_MAP_WRITE);
+  if (!g_input_stream_read_all (G_INPUT_STREAM (src->prefetch_stream),
+          map.data, size, &read, NULL, &err)) {
+    gst_buffer_unmap (chunk, &map);
+    gst_buffer_unref (chunk);
+    goto failed;
+  }
+  gst_buffer_unmap (chunk, &map);
+
+  /* a short read means the part changed on disk, let the streaming thread
+   * read (and report) it directly */
+  if (read < size) {
+    gst_buffer_unref (chunk);
+    *error = TRUE;
+    return NULL;
+  }
+
+  GST_BUFFER_OFFSET (chunk) = offset;
+  GST_BUFFER_OFFSET_END (chunk) = offset + size;
+
+  return chunk;
+
+failed:
+  {
+    GST_WARNING_OBJECT (src, "prefetch at offset %" G_GUINT64_FORMAT
+        " failed: %s", offset, err ? err->message : "unknown error");
+    g_clear_error (&err);
+    if (src->prefetch_stream) {
+      g_object_unref (src->prefetch_stream);
+      src->prefetch_stream = NULL;
+    }
+    *error = TRUE;
+    return NULL;
+  }
+}
+
+static gpointer
+gst_split_file_src_prefetch_func (GstSplitFileSrc * src)
+{
+  GstBuffer *chunk;
+  gboolean error;
+  guint64 offset;
+  guint size, generation;
+
+  g_mutex_lock (&src->prefetch_lock);
+  while (!src->prefetch_stop) {
+    /* keep reading while the window is not full or create() is waiting for
+     * more than the window can hold */
+    if (src->prefetch_eos || src->prefetch_failed ||
+        (src->prefetch_queued >= src->prefetch_size &&
+            src->prefetch_end >= src->prefetch_want)) {
+      g_cond_wait (&src->prefetch_cond, &src->prefetch_lock);
+      continue;
+    }
+
+    offset = src->prefetch_end;
+    generation = src->prefetch_generation;
+    size = MIN (PREFETCH_CHUNK_SIZE, src->prefetch_size);
+    g_mutex_unlock (&src->prefetch_lock);
+
+    chunk = gst_split_file_src_prefetch_chunk (src, offset, size, &error);
+
+    g_mutex_lock (&src->prefetch_lock);
+    if (generation != src->prefetch_generation) {
+      /* window was moved while we were reading */
+      if (chunk)
+        gst_buffer_unref (chunk);
+      continue;
+    }
+
+    if (chunk == NULL) {
+      if (error)
+        src->prefetch_failed = TRUE;
+      else
+        src->prefetch_eos = TRUE;
+    } else {
+      g_queue_push_tail (&src->prefetch_chunks, chunk);
+      src->prefetch_queued += gst_buffer_get_size (chunk);
+      src->prefetch_end = GST_BUFFER_OFFSET_END (chunk);
+    }
+    g_cond_broadcast (&src->prefetch_cond);
+  }
+  g_mutex_unlock (&src->prefetch_lock);
+
+  return NULL;
+}
+
+static void
+gst_split_file_src_start_prefetch (GstSplitFileSrc * src)
+{
+  GError *err = NULL;
+
+  src->prefetch_stop = FALSE;
+  src->prefetch_want = 0;
+  src->prefetch_stream = NULL;
+  src->prefetch_part = 0;
+  gst_split_file_src_reset_prefetch (src, 0);
+
+  src->prefetch_thread = g_thread_try_new ("splitfilesrc-prefetch",
+      (GThreadFunc) gst_split_file_src_prefetch_func, src, &err);
+  if (src->prefetch_thread == NULL) {
+    GST_WARNING_OBJECT (src, "failed to start prefetch thread: %s",
+        err->message);
+    g_error_free (err);
+  }
+}
+
+static void
+gst_split_file_src_stop_prefetch (GstSplitFileSrc * src)
+{
+  if (src->prefetch_thread == NULL)
+    return;
+
+  g_mutex_lock (&src->prefetch_lock);
+  src->prefetch_stop = TRUE;
+  g_cond_broadcast (&src->prefetch_cond);
+  g_mutex_unlock (&src->prefetch_lock);
+
+  g_thread_join (src->prefetch_thread);
+  src->prefetch_thread = NULL;
+
+  gst_split_file_src_reset_prefetch (src, 0);
+  if (src->prefetch_stream) {
+    g_object_unref (src->prefetch_stream);
+    src->prefetch_stream = NULL;
+  }
+}
+
+/* serves a read from the prefetched chunks. Returns GST_FLOW_CUSTOM_SUCCESS
+ * if the data has to be read directly instead */
+static GstFlowReturn
+gst_split_file_src_create_prefetched (GstSplitFileSrc * src, guint64 offset,
+    guint size, GstBuffer ** buffer)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *chunk, *buf;
+  guint64 end, chunk_start, chunk_end;
+  GList *l;
+
+  end = offset + size;
+
+  g_mutex_lock (&src->prefetch_lock);
+  if (offset < src->prefetch_start || offset > src->prefetch_end)
+    gst_split_file_src_reset_prefetch (src, offset);
+
+  /* data before the requested offset is not needed anymore */
+  while ((chunk = g_queue_peek_head (&src->prefetch_chunks)) &&
+      GST_BUFFER_OFFSET_END (chunk) <= offset) {
+    g_queue_pop_head (&src->prefetch_chunks);
+    src->prefetch_queued -= gst_buffer_get_size (chunk);
+    src->prefetch_start = GST_BUFFER_OFFSET_END (chunk);
+    gst_buffer_unref (chunk);
+  }
+  src->prefetch_want = end;
+  g_cond_broadcast (&src->prefetch_cond);
+
+  while (src->prefetch_end < end && !src->prefetch_eos &&
+      !src->prefetch_failed && !src->prefetch_flushing) {
+    GST_LOG_OBJECT (src, "waiting for prefetch thread");
+    g_cond_wait (&src->prefetch_cond, &src->prefetch_lock);
+  }
+
+  if (src->prefetch_flushing) {
+    ret = GST_FLOW_FLUSHING;
+    goto done;
+  }
+  if (src->prefetch_end < end && src->prefetch_failed) {
+    ret = GST_FLOW_CUSTOM_SUCCESS;
+    goto done;
+  }
+  if (offset >= src->prefetch_end) {
+    ret = GST_FLOW_EOS;
+    goto done;
+  }
+
+  /* assemble the buffer from the chunks without copying */
+  end = MIN (end, src->prefetch_end);
+  buf = gst_buffer_new ();
+  for (l = src->prefetch_chunks.head; l != NULL; l = l->next) {
+    chunk = l->data;
+    chunk_start = GST_BUFFER_OFFSET (chunk);
+    chunk_end = GST_BUFFER_OFFSET_END (chunk);
+
+    if (chunk_end <= offset)
+      continue;
+    if (chunk_start >= end)
+      break;
+
+    gst_buffer_copy_into (buf, chunk, GST_BUFFER_COPY_MEMORY,
+        MAX (offset, chunk_start) - chunk_start,
+        MIN (end, chunk_end) - MAX (offset, chunk_start));
+  }
+  GST_BUFFER_OFFSET (buf) = offset;
+  GST_BUFFER_OFFSET_END (buf) = end;
+  *buffer = buf;
+
+  GST_LOG_OBJECT (src, "served %" G_GSIZE_FORMAT " bytes at offset %"
+      G_GUINT64_FORMAT " from prefetch", gst_buffer_get_size (buf), offset);
+
+done:
+  g_mutex_unlock (&src->prefetch_lock);
+  return ret;
+}
+
 static GstFlowReturn
 gst_split_file_src_create (GstBaseSrc * basesrc, guint64 offset, guint size,
     GstBuffer ** buffer)
@@ -488,6 +829,14 @@ gst_split_file_src_create (GstBaseSrc * basesrc, guint64 offset, guint size,
   guint8 *data;
   guint to_read;
 
+  if (src->prefetch_thread != NULL) {
+    GstFlowReturn ret;
+
+    ret = gst_split_file_src_create_prefetched (src, offset, size, buffer);
+    if (ret != GST_FLOW_CUSTOM_SUCCESS)
+      return ret;
+  }
+
   cur_part = src->parts[src->cur_part];
   if (offset < cur_part.start || offset > cur_part.stop) {
     if (!gst_split_file_src_find_part_for_offset (src, offset, &src->cur_part))
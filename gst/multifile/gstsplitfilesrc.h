@@ -60,6 +60,26 @@ struct _GstSplitFileSrc
   guint        cur_part;  /* part used last (likely also to be used next) */
 
   GCancellable *cancellable; /* so we can interrupt blocking operations */
+
+  /* read-ahead */
+  guint         prefetch_size;
+  GThread      *prefetch_thread;
+  GMutex        prefetch_lock;
+  GCond         prefetch_cond;
+  GQueue        prefetch_chunks;  /* GstBuffers with offsets, in order */
+  guint64       prefetch_queued;  /* bytes in prefetch_chunks */
+  guint64       prefetch_start;   /* offset of the first prefetched byte */
+  guint64       prefetch_end;     /* offset the thread reads next */
+  guint64       prefetch_want;    /* end of the data create() waits for */
+  guint         prefetch_generation;
+  gboolean      prefetch_eos;
+  gboolean      prefetch_failed;
+  gboolean      prefetch_stop;
+  gboolean      prefetch_flushing;
+
+  /* only used by the prefetch thread */
+  GFileInputStream *prefetch_stream;
+  guint         prefetch_part;
 };
 
 struct _GstSplitFileSrcClass
@@ -486,24 +486,28 @@ static gint
 multipart_find_boundary (GstMultipartDemux * multipart, gint * datalen)
 {
   /* Adaptor is positioned at the start of the data */
-  const guint8 *data, *pos;
-  const guint8 *dataend;
+  GstAdapter *adapter = multipart->adapter;
+  guint8 nl[2], *boundary;
+  guint32 mask, pattern;
+  gssize pos;
+  gsize avail, offset;
   gint len;
 
   if (multipart->content_length >= 0) {
     /* fast path, known content length :) */
     len = multipart->content_length;
-    if (gst_adapter_available (multipart->adapter) >= len + 2) {
+    if (gst_adapter_available (adapter) >= len + 2) {
       *datalen = len;
-      data = gst_adapter_map (multipart->adapter, len + 1);
+      /* only peek at the byte following the data, mapping would merge the
+       * whole body into one chunk */
+      gst_adapter_copy (adapter, nl, len, 1);
 
       /* If data[len] contains \r then assume a newline is \r\n */
-      if (data[len] == '\r')
+      if (nl[0] == '\r')
         len += 2;
-      else if (data[len] == '\n')
+      else if (nl[0] == '\n')
         len += 1;
 
-      gst_adapter_unmap (multipart->adapter);
       /* Don't check if boundary is actually there, but let the header parsing
        * bail out if it isn't */
       return len;
@@ -513,32 +517,62 @@ multipart_find_boundary (GstMultipartDemux * multipart, gint * datalen)
     }
   }
 
-  len = gst_adapter_available (multipart->adapter);
-  if (len == 0)
+  avail = gst_adapter_available (adapter);
+  if (avail < multipart->boundary_len + 2)
     return MULTIPART_NEED_MORE_DATA;
-  data = gst_adapter_map (multipart->adapter, len);
-  dataend = data + len;
-
-  for (pos = data + multipart->scanpos;
-      pos <= dataend - multipart->boundary_len - 2; pos++) {
-    if (*pos == '-' && pos[1] == '-' &&
-        !strncmp ((gchar *) pos + 2,
-            multipart->boundary, multipart->boundary_len)) {
+
+  /* scan for "--" followed by the first boundary bytes chunk by chunk, without
+   * flattening the adapter, and only compare the full boundary for candidates */
+  pattern = ('-' << 24) | ('-' << 16) | (multipart->boundary[0] << 8);
+  mask = 0xffffff00;
+  if (multipart->boundary_len > 1) {
+    pattern |= (guint8) multipart->boundary[1];
+    mask = 0xffffffff;
+  }
+
+  boundary = g_malloc (multipart->boundary_len);
+  offset = multipart->scanpos;
+  while (offset + 4 <= avail) {
+    pos = gst_adapter_masked_scan_uint32 (adapter, mask, pattern, offset,
+        avail - offset);
+    if (pos < 0)
+      break;
+
+    if (pos + 2 + multipart->boundary_len > avail) {
+      /* candidate is not complete yet, check again when we have more data */
+      offset = pos;
+      goto need_more_data;
+    }
+
+    gst_adapter_copy (adapter, boundary, pos + 2, multipart->boundary_len);
+    if (!memcmp (boundary, multipart->boundary, multipart->boundary_len)) {
       /* Found the boundary! Check if there was a newline before the boundary */
-      len = pos - data;
-      if (pos - 2 > data && pos[-2] == '\r')
-        len -= 2;
-      else if (pos - 1 > data && pos[-1] == '\n')
-        len -= 1;
+      len = pos;
+      if (pos > 2) {
+        gst_adapter_copy (adapter, nl, pos - 2, 2);
+        if (nl[0] == '\r')
+          len -= 2;
+        else if (nl[1] == '\n')
+          len -= 1;
+      } else if (pos > 1) {
+        gst_adapter_copy (adapter, nl, pos - 1, 1);
+        if (nl[0] == '\n')
+          len -= 1;
+      }
       *datalen = len;
 
-      gst_adapter_unmap (multipart->adapter);
+      g_free (boundary);
       multipart->scanpos = 0;
-      return pos - data;
+      return pos;
     }
+    offset = pos + 1;
   }
-  gst_adapter_unmap (multipart->adapter);
-  multipart->scanpos = pos - data;
+  /* all positions that had 4 bytes available have been checked */
+  offset = MAX (offset, avail - 3);
+
+need_more_data:
+  g_free (boundary);
+  multipart->scanpos = offset;
   return MULTIPART_NEED_MORE_DATA;
 }
 
@@ -600,7 +634,9 @@ gst_multipart_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
           multipart->mime_type, &created);
 
       ts = gst_adapter_prev_pts (adapter, NULL);
-      outbuf = gst_adapter_take_buffer (adapter, datalen);
+      /* the body may span several input buffers, keep their memory instead
+       * of merging it */
+      outbuf = gst_adapter_take_buffer_fast (adapter, datalen);
       gst_adapter_flush (adapter, size - datalen);
 
       if (created) {
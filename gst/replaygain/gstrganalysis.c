@@ -42,6 +42,9 @@
  * needed for album processing (see #GstRgAnalysis:num-tracks property) since
  * the album gain and peak values need to be associated with all tracks of an
  * album, not just the last one.
+ *
+ * To analyze the tracks of an album in parallel, for example one pipeline per
+ * track, give all involved elements the same #GstRgAnalysis:album-id.
  * 
  * <refsect2>
  * <title>Example launch lines</title>
@@ -90,6 +93,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_rg_analysis_debug);
 /* Default property value. */
 #define FORCED_DEFAULT TRUE
 #define DEFAULT_MESSAGE FALSE
+#define DEFAULT_ALBUM_ID NULL
 
 enum
 {
@@ -97,9 +101,21 @@ enum
   PROP_NUM_TRACKS,
   PROP_FORCED,
   PROP_REFERENCE_LEVEL,
-  PROP_MESSAGE
+  PROP_MESSAGE,
+  PROP_ALBUM_ID
 };
 
+/* Album accumulator shared by all elements with the same album-id. */
+typedef struct
+{
+  RgAnalysisCtx *ctx;
+  guint remaining;
+} GstRgAnalysisAlbum;
+
+/* Maps album-id to GstRgAnalysisAlbum. */
+static GHashTable *albums = NULL;
+G_LOCK_DEFINE_STATIC (albums);
+
 /* The ReplayGain algorithm is intended for use with mono and stereo
  * audio.  The used implementation has filter coefficients for the
  * "usual" sample rates in the 8000 to 48000 Hz range. */
@@ -130,6 +146,7 @@ static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
 #define gst_rg_analysis_parent_class parent_class
 G_DEFINE_TYPE (GstRgAnalysis, gst_rg_analysis, GST_TYPE_BASE_TRANSFORM);
 
+static void gst_rg_analysis_finalize (GObject * object);
 static void gst_rg_analysis_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_rg_analysis_get_property (GObject * object, guint prop_id,
@@ -147,10 +164,11 @@ static gboolean gst_rg_analysis_stop (GstBaseTransform * base);
 static void gst_rg_analysis_handle_tags (GstRgAnalysis * filter,
     const GstTagList * tag_list);
 static void gst_rg_analysis_handle_eos (GstRgAnalysis * filter);
+static void gst_rg_analysis_handle_eos_shared (GstRgAnalysis * filter);
 static gboolean gst_rg_analysis_track_result (GstRgAnalysis * filter,
     GstTagList ** tag_list);
 static gboolean gst_rg_analysis_album_result (GstRgAnalysis * filter,
-    GstTagList ** tag_list);
+    RgAnalysisCtx * ctx, GstTagList ** tag_list);
 
 static void
 gst_rg_analysis_class_init (GstRgAnalysisClass * klass)
@@ -162,6 +180,7 @@ gst_rg_analysis_class_init (GstRgAnalysisClass * klass)
   gobject_class = (GObjectClass *) klass;
   element_class = (GstElementClass *) klass;
 
+  gobject_class->finalize = gst_rg_analysis_finalize;
   gobject_class->set_property = gst_rg_analysis_set_property;
   gobject_class->get_property = gst_rg_analysis_get_property;
 
@@ -258,6 +277,31 @@ gst_rg_analysis_class_init (GstRgAnalysisClass * klass)
           "Post statics messages",
           DEFAULT_MESSAGE,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstRgAnalysis:album-id:
+   *
+   * Identifier of the album that is analyzed in parallel.
+   *
+   * <link linkend="GstRgAnalysis--num-tracks">Album processing</link>
+   * normally requires all tracks to pass one element sequentially.  To analyze
+   * the tracks of an album at the same time instead, e.g. in one pipeline per
+   * track, set this property to the same string on all elements involved and
+   * set #GstRgAnalysis:num-tracks on each of them to the total number of album
+   * tracks.  The elements then share one album result: all tracks are added to
+   * it as they finish, and the element that finishes the last track adds the
+   * album tags to its tag list.  After each EOS event, num-tracks is set to the
+   * number of album tracks that are still being analyzed.
+   *
+   * Because it is not known whether the other tracks carry complete tags,
+   * existing tags never cause tracks to be skipped in this mode, regardless of
+   * the #GstRgAnalysis:forced property.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_ALBUM_ID,
+      g_param_spec_string ("album-id", "Album ID",
+          "Share the album result with all elements using the same ID",
+          DEFAULT_ALBUM_ID, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   trans_class = (GstBaseTransformClass *) klass;
   trans_class->start = GST_DEBUG_FUNCPTR (gst_rg_analysis_start);
@@ -291,11 +335,22 @@ gst_rg_analysis_init (GstRgAnalysis * filter)
   filter->forced = FORCED_DEFAULT;
   filter->message = DEFAULT_MESSAGE;
   filter->reference_level = RG_REFERENCE_LEVEL;
+  filter->album_id = g_strdup (DEFAULT_ALBUM_ID);
 
   filter->ctx = NULL;
   filter->analyze = NULL;
 }
 
+static void
+gst_rg_analysis_finalize (GObject * object)
+{
+  GstRgAnalysis *filter = GST_RG_ANALYSIS (object);
+
+  g_free (filter->album_id);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_rg_analysis_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -316,6 +371,10 @@ gst_rg_analysis_set_property (GObject * object, guint prop_id,
     case PROP_MESSAGE:
       filter->message = g_value_get_boolean (value);
       break;
+    case PROP_ALBUM_ID:
+      g_free (filter->album_id);
+      filter->album_id = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -343,6 +402,9 @@ gst_rg_analysis_get_property (GObject * object, guint prop_id,
     case PROP_MESSAGE:
       g_value_set_boolean (value, filter->message);
       break;
+    case PROP_ALBUM_ID:
+      g_value_set_string (value, filter->album_id);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -543,6 +605,11 @@ gst_rg_analysis_handle_tags (GstRgAnalysis * filter,
   if (!album_processing)
     filter->ignore_tags = FALSE;
 
+  if (album_processing && filter->album_id != NULL) {
+    GST_DEBUG_OBJECT (filter, "ignoring tag event: album shared by id");
+    return;
+  }
+
   if (filter->skip && album_processing) {
     GST_DEBUG_OBJECT (filter, "ignoring tag event: skipping album");
     return;
@@ -591,6 +658,17 @@ gst_rg_analysis_handle_tags (GstRgAnalysis * filter,
   }
 }
 
+static void
+gst_rg_analysis_push_results (GstRgAnalysis * filter, GstTagList * tag_list)
+{
+  GST_LOG_OBJECT (filter, "posting tag list with results");
+  gst_tag_list_add (tag_list, GST_TAG_MERGE_APPEND,
+      GST_TAG_REFERENCE_LEVEL, filter->reference_level, NULL);
+  /* This takes ownership of our reference to the list */
+  gst_pad_push_event (GST_BASE_TRANSFORM_SRC_PAD (filter),
+      gst_event_new_tag (tag_list));
+}
+
 static void
 gst_rg_analysis_handle_eos (GstRgAnalysis * filter)
 {
@@ -598,6 +676,11 @@ gst_rg_analysis_handle_eos (GstRgAnalysis * filter)
   gboolean album_finished = (filter->num_tracks == 1);
   gboolean album_skipping = album_processing && filter->skip;
 
+  if (album_processing && filter->album_id != NULL) {
+    gst_rg_analysis_handle_eos_shared (filter);
+    return;
+  }
+
   filter->has_track_gain = FALSE;
   filter->has_track_peak = FALSE;
 
@@ -625,19 +708,13 @@ gst_rg_analysis_handle_eos (GstRgAnalysis * filter)
     track_success = gst_rg_analysis_track_result (filter, &tag_list);
 
     if (album_finished)
-      album_success = gst_rg_analysis_album_result (filter, &tag_list);
+      album_success = gst_rg_analysis_album_result (filter, filter->ctx,
+          &tag_list);
     else if (!album_processing)
       rg_analysis_reset_album (filter->ctx);
 
-    if (track_success || album_success) {
-      GST_LOG_OBJECT (filter, "posting tag list with results");
-      gst_tag_list_add (tag_list, GST_TAG_MERGE_APPEND,
-          GST_TAG_REFERENCE_LEVEL, filter->reference_level, NULL);
-      /* This takes ownership of our reference to the list */
-      gst_pad_push_event (GST_BASE_TRANSFORM_SRC_PAD (filter),
-          gst_event_new_tag (tag_list));
-      tag_list = NULL;
-    }
+    if (track_success || album_success)
+      gst_rg_analysis_push_results (filter, tag_list);
   }
 
   if (album_processing) {
@@ -655,6 +732,74 @@ gst_rg_analysis_handle_eos (GstRgAnalysis * filter)
     g_object_notify (G_OBJECT (filter), "num-tracks");
 }
 
+/* Album processing with the album accumulator shared between all elements of
+ * the same album-id, which may be analyzing their tracks concurrently.  The
+ * track result goes into the shared accumulator and whoever finishes the last
+ * track of the album obtains the album result. */
+static void
+gst_rg_analysis_handle_eos_shared (GstRgAnalysis * filter)
+{
+  GstRgAnalysisAlbum *album;
+  GstTagList *tag_list = NULL;
+  gboolean track_success;
+  gboolean album_success = FALSE;
+  gchar *album_id;
+  guint remaining;
+
+  filter->has_track_gain = FALSE;
+  filter->has_track_peak = FALSE;
+  filter->has_album_gain = FALSE;
+  filter->has_album_peak = FALSE;
+  filter->ignore_tags = FALSE;
+  filter->skip = FALSE;
+
+  GST_OBJECT_LOCK (filter);
+  album_id = g_strdup (filter->album_id);
+  GST_OBJECT_UNLOCK (filter);
+
+  track_success = gst_rg_analysis_track_result (filter, &tag_list);
+
+  G_LOCK (albums);
+  if (albums == NULL)
+    albums = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  album = g_hash_table_lookup (albums, album_id);
+  if (album == NULL) {
+    album = g_slice_new (GstRgAnalysisAlbum);
+    album->ctx = rg_analysis_new ();
+    album->remaining = filter->num_tracks;
+    g_hash_table_insert (albums, g_strdup (album_id), album);
+  }
+
+  rg_analysis_merge_album (album->ctx, filter->ctx);
+  remaining = --album->remaining;
+
+  if (remaining == 0) {
+    album_success = gst_rg_analysis_album_result (filter, album->ctx,
+        &tag_list);
+    g_hash_table_remove (albums, album_id);
+    rg_analysis_destroy (album->ctx);
+    g_slice_free (GstRgAnalysisAlbum, album);
+  }
+  G_UNLOCK (albums);
+
+  if (track_success || album_success)
+    gst_rg_analysis_push_results (filter, tag_list);
+
+  filter->num_tracks = remaining;
+
+  if (remaining > 0) {
+    GST_DEBUG_OBJECT (filter, "album %s not finished yet (%u tracks left)",
+        album_id, remaining);
+  } else {
+    GST_DEBUG_OBJECT (filter, "album %s finished", album_id);
+  }
+
+  g_free (album_id);
+
+  g_object_notify (G_OBJECT (filter), "num-tracks");
+}
+
 /* FIXME: return tag list (lists?) based on input tags.. */
 static gboolean
 gst_rg_analysis_track_result (GstRgAnalysis * filter, GstTagList ** tag_list)
@@ -684,12 +829,13 @@ gst_rg_analysis_track_result (GstRgAnalysis * filter, GstTagList ** tag_list)
 }
 
 static gboolean
-gst_rg_analysis_album_result (GstRgAnalysis * filter, GstTagList ** tag_list)
+gst_rg_analysis_album_result (GstRgAnalysis * filter, RgAnalysisCtx * ctx,
+    GstTagList ** tag_list)
 {
   gboolean album_success;
   gdouble album_gain, album_peak;
 
-  album_success = rg_analysis_album_result (filter->ctx, &album_gain,
+  album_success = rg_analysis_album_result (ctx, &album_gain,
       &album_peak);
 
   if (album_success) {
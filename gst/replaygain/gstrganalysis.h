@@ -64,6 +64,7 @@ struct _GstRgAnalysis
   gdouble reference_level;
   gboolean forced;
   gboolean message;
+  gchar *album_id;
 
   /* State machinery for skipping. */
   gboolean ignore_tags;
@@ -83,20 +83,15 @@ typedef struct _RgAnalysisAcc RgAnalysisAcc;
 
 struct _RgAnalysisCtx
 {
-  /* Filter buffers for left channel. */
-  gfloat inprebuf_l[MAX_ORDER * 2];
-  gfloat *inpre_l;
-  gfloat stepbuf_l[MAX_SAMPLE_WINDOW + MAX_ORDER];
-  gfloat *step_l;
-  gfloat outbuf_l[MAX_SAMPLE_WINDOW + MAX_ORDER];
-  gfloat *out_l;
-  /* Filter buffers for right channel. */
-  gfloat inprebuf_r[MAX_ORDER * 2];
-  gfloat *inpre_r;
-  gfloat stepbuf_r[MAX_SAMPLE_WINDOW + MAX_ORDER];
-  gfloat *step_r;
-  gfloat outbuf_r[MAX_SAMPLE_WINDOW + MAX_ORDER];
-  gfloat *out_r;
+  /* Filter buffers.  The left and right channel are stored as
+   * interleaved pairs, so that both channels of a frame are filtered
+   * with the same vector instructions. */
+  gfloat inbuf[(MAX_SAMPLE_WINDOW + MAX_ORDER) * 2];
+  gfloat *in;
+  gfloat stepbuf[(MAX_SAMPLE_WINDOW + MAX_ORDER) * 2];
+  gfloat *step;
+  gfloat outbuf[(MAX_SAMPLE_WINDOW + MAX_ORDER) * 2];
+  gfloat *out;
 
   /* Number of samples to reach duration of the RMS window: */
   guint window_n_samples;
@@ -228,7 +223,9 @@ static const gfloat BButter[9][3] = {
 #endif
 
 /* Filter functions.  These access elements with negative indices of
- * the input and output arrays (up to the filter's order). */
+ * the input and output arrays (up to the filter's order).  Input and
+ * output are interleaved stereo pairs, so the history of a channel is
+ * found at a stride of 2. */
 
 /* For much better performance, the function below has been
  * implemented by unrolling the inner loop for our two use cases. */
@@ -250,56 +247,72 @@ static const gfloat BButter[9][3] = {
  * }
  */
 
+/* Each tap below is written as a loop over the two channels of the
+ * pair.  The compiler turns these into single vector operations; the
+ * arithmetic of every channel is exactly the same as when filtering
+ * it on its own. */
+
+#define FILTER_TAP(k)                                                   \
+  for (c = 0; c < 2; c++)                                               \
+    y[c] = y[c] + input[c - 2 * k] * b[k] - output[c - 2 * k] * a[k];
+
 static inline void
 yule_filter (const gfloat * input, gfloat * output,
     const gfloat * a, const gfloat * b)
 {
+  gdouble y[2];
+  gint c;
+
   /* 1e-10 is added below to avoid running into denormals when operating on
    * near silence. */
 
-  output[0] = 1e-10 + input[0] * b[0]
-      + input[-1] * b[1] - output[-1] * a[1]
-      + input[-2] * b[2] - output[-2] * a[2]
-      + input[-3] * b[3] - output[-3] * a[3]
-      + input[-4] * b[4] - output[-4] * a[4]
-      + input[-5] * b[5] - output[-5] * a[5]
-      + input[-6] * b[6] - output[-6] * a[6]
-      + input[-7] * b[7] - output[-7] * a[7]
-      + input[-8] * b[8] - output[-8] * a[8]
-      + input[-9] * b[9] - output[-9] * a[9]
-      + input[-10] * b[10] - output[-10] * a[10];
+  for (c = 0; c < 2; c++)
+    y[c] = 1e-10 + input[c] * b[0];
+  FILTER_TAP (1);
+  FILTER_TAP (2);
+  FILTER_TAP (3);
+  FILTER_TAP (4);
+  FILTER_TAP (5);
+  FILTER_TAP (6);
+  FILTER_TAP (7);
+  FILTER_TAP (8);
+  FILTER_TAP (9);
+  FILTER_TAP (10);
+  for (c = 0; c < 2; c++)
+    output[c] = y[c];
 }
 
 static inline void
 butter_filter (const gfloat * input, gfloat * output,
     const gfloat * a, const gfloat * b)
 {
-  output[0] = input[0] * b[0]
-      + input[-1] * b[1] - output[-1] * a[1]
-      + input[-2] * b[2] - output[-2] * a[2];
+  gint c;
+
+  for (c = 0; c < 2; c++)
+    output[c] = input[c] * b[0]
+        + input[c - 2] * b[1] - output[c - 2] * a[1]
+        + input[c - 4] * b[2] - output[c - 4] * a[2];
 }
 
+#undef FILTER_TAP
+
 /* Because butter_filter and yule_filter are inlined, this function is
  * a bit blown-up (code-size wise), but not inlining gives a ca. 40%
  * performance penalty. */
 
 static inline void
-apply_filters (const RgAnalysisCtx * ctx, const gfloat * input_l,
-    const gfloat * input_r, guint n_samples)
+apply_filters (const RgAnalysisCtx * ctx, guint n_samples)
 {
   const gfloat *ayule = AYule[ctx->sample_rate_index];
   const gfloat *byule = BYule[ctx->sample_rate_index];
   const gfloat *abutter = AButter[ctx->sample_rate_index];
   const gfloat *bbutter = BButter[ctx->sample_rate_index];
-  gint pos = ctx->window_n_samples_done;
+  gint pos = ctx->window_n_samples_done * 2;
   gint i;
 
-  for (i = 0; i < n_samples; i++, pos++) {
-    yule_filter (input_l + i, ctx->step_l + pos, ayule, byule);
-    butter_filter (ctx->step_l + pos, ctx->out_l + pos, abutter, bbutter);
-
-    yule_filter (input_r + i, ctx->step_r + pos, ayule, byule);
-    butter_filter (ctx->step_r + pos, ctx->out_r + pos, abutter, bbutter);
+  for (i = 0; i < n_samples; i++, pos += 2) {
+    yule_filter (ctx->in + pos, ctx->step + pos, ayule, byule);
+    butter_filter (ctx->step + pos, ctx->out + pos, abutter, bbutter);
   }
 }
 
@@ -310,15 +323,10 @@ reset_filters (RgAnalysisCtx * ctx)
 {
   gint i;
 
-  for (i = 0; i < MAX_ORDER; i++) {
-
-    ctx->inprebuf_l[i] = 0.;
-    ctx->stepbuf_l[i] = 0.;
-    ctx->outbuf_l[i] = 0.;
-
-    ctx->inprebuf_r[i] = 0.;
-    ctx->stepbuf_r[i] = 0.;
-    ctx->outbuf_r[i] = 0.;
+  for (i = 0; i < MAX_ORDER * 2; i++) {
+    ctx->inbuf[i] = 0.;
+    ctx->stepbuf[i] = 0.;
+    ctx->outbuf[i] = 0.;
   }
 
   ctx->window_square_sum = 0.;
@@ -398,13 +406,9 @@ rg_analysis_new (void)
 
   ctx = g_new (RgAnalysisCtx, 1);
 
-  ctx->inpre_l = ctx->inprebuf_l + MAX_ORDER;
-  ctx->step_l = ctx->stepbuf_l + MAX_ORDER;
-  ctx->out_l = ctx->outbuf_l + MAX_ORDER;
-
-  ctx->inpre_r = ctx->inprebuf_r + MAX_ORDER;
-  ctx->step_r = ctx->stepbuf_r + MAX_ORDER;
-  ctx->out_r = ctx->outbuf_r + MAX_ORDER;
+  ctx->in = ctx->inbuf + MAX_ORDER * 2;
+  ctx->step = ctx->stepbuf + MAX_ORDER * 2;
+  ctx->out = ctx->outbuf + MAX_ORDER * 2;
 
   ctx->sample_rate = 0;
 
@@ -652,7 +656,6 @@ void
 rg_analysis_analyze (RgAnalysisCtx * ctx, const gfloat * samples_l,
     const gfloat * samples_r, guint n_samples)
 {
-  const gfloat *input_l, *input_r;
   guint n_samples_done;
   gint i;
 
@@ -667,35 +670,27 @@ rg_analysis_analyze (RgAnalysisCtx * ctx, const gfloat * samples_l,
     /* Mono. */
     samples_r = samples_l;
 
-  memcpy (ctx->inpre_l, samples_l,
-      MIN (n_samples, MAX_ORDER) * sizeof (gfloat));
-  memcpy (ctx->inpre_r, samples_r,
-      MIN (n_samples, MAX_ORDER) * sizeof (gfloat));
-
   n_samples_done = 0;
   while (n_samples_done < n_samples) {
     /* Limit number of samples to be processed in this iteration to
      * the number needed to complete the next window: */
     guint n_samples_current = MIN (n_samples - n_samples_done,
         ctx->window_n_samples - ctx->window_n_samples_done);
+    gfloat *in = ctx->in + ctx->window_n_samples_done * 2;
+    const gfloat *out = ctx->out + ctx->window_n_samples_done * 2;
 
-    if (n_samples_done < MAX_ORDER) {
-      input_l = ctx->inpre_l + n_samples_done;
-      input_r = ctx->inpre_r + n_samples_done;
-      n_samples_current = MIN (n_samples_current, MAX_ORDER - n_samples_done);
-    } else {
-      input_l = samples_l + n_samples_done;
-      input_r = samples_r + n_samples_done;
+    /* Interleave the input behind the filter history. */
+    for (i = 0; i < n_samples_current; i++) {
+      in[2 * i] = samples_l[n_samples_done + i];
+      in[2 * i + 1] = samples_r[n_samples_done + i];
     }
 
-    apply_filters (ctx, input_l, input_r, n_samples_current);
+    apply_filters (ctx, n_samples_current);
 
     /* Update the square sum. */
     for (i = 0; i < n_samples_current; i++)
-      ctx->window_square_sum += ctx->out_l[ctx->window_n_samples_done + i]
-          * ctx->out_l[ctx->window_n_samples_done + i]
-          + ctx->out_r[ctx->window_n_samples_done + i]
-          * ctx->out_r[ctx->window_n_samples_done + i];
+      ctx->window_square_sum += out[2 * i] * out[2 * i]
+          + out[2 * i + 1] * out[2 * i + 1];
 
     ctx->window_n_samples_done += n_samples_current;
     ctx->buffer_n_samples_done += n_samples_current;
@@ -728,41 +723,16 @@ rg_analysis_analyze (RgAnalysisCtx * ctx, const gfloat * samples_l,
        * the smallest sample rate, the number of samples needed for
        * the window is greater than MAX_ORDER. */
 
-      memcpy (ctx->stepbuf_l, ctx->stepbuf_l + ctx->window_n_samples,
-          MAX_ORDER * sizeof (gfloat));
-      memcpy (ctx->outbuf_l, ctx->outbuf_l + ctx->window_n_samples,
-          MAX_ORDER * sizeof (gfloat));
-
-      memcpy (ctx->stepbuf_r, ctx->stepbuf_r + ctx->window_n_samples,
-          MAX_ORDER * sizeof (gfloat));
-      memcpy (ctx->outbuf_r, ctx->outbuf_r + ctx->window_n_samples,
-          MAX_ORDER * sizeof (gfloat));
+      memcpy (ctx->inbuf, ctx->inbuf + ctx->window_n_samples * 2,
+          MAX_ORDER * 2 * sizeof (gfloat));
+      memcpy (ctx->stepbuf, ctx->stepbuf + ctx->window_n_samples * 2,
+          MAX_ORDER * 2 * sizeof (gfloat));
+      memcpy (ctx->outbuf, ctx->outbuf + ctx->window_n_samples * 2,
+          MAX_ORDER * 2 * sizeof (gfloat));
     }
 
     n_samples_done += n_samples_current;
   }
-
-  if (n_samples >= MAX_ORDER) {
-
-    memcpy (ctx->inprebuf_l, samples_l + n_samples - MAX_ORDER,
-        MAX_ORDER * sizeof (gfloat));
-
-    memcpy (ctx->inprebuf_r, samples_r + n_samples - MAX_ORDER,
-        MAX_ORDER * sizeof (gfloat));
-
-  } else {
-
-    memmove (ctx->inprebuf_l, ctx->inprebuf_l + n_samples,
-        (MAX_ORDER - n_samples) * sizeof (gfloat));
-    memcpy (ctx->inprebuf_l + MAX_ORDER - n_samples, samples_l,
-        n_samples * sizeof (gfloat));
-
-    memmove (ctx->inprebuf_r, ctx->inprebuf_r + n_samples,
-        (MAX_ORDER - n_samples) * sizeof (gfloat));
-    memcpy (ctx->inprebuf_r + MAX_ORDER - n_samples, samples_r,
-        n_samples * sizeof (gfloat));
-
-  }
 }
 
 /* Obtain track gain and peak.  Returns TRUE on success.  Can fail if
@@ -803,6 +773,23 @@ rg_analysis_album_result (RgAnalysisCtx * ctx, gdouble * gain, gdouble * peak)
   return result;
 }
 
+/* Add the album accumulator of another context to the one of ctx and
+ * reset the former.  This allows analyzing the tracks of an album in
+ * several contexts at the same time (even from different threads, if
+ * calls are serialized by the caller) and obtaining the album result
+ * from ctx afterwards; the outcome is the same as when analyzing all
+ * tracks sequentially in one context. */
+
+void
+rg_analysis_merge_album (RgAnalysisCtx * ctx, RgAnalysisCtx * other)
+{
+  g_return_if_fail (ctx != NULL);
+  g_return_if_fail (other != NULL);
+
+  accumulator_add (&ctx->album, &other->album);
+  accumulator_clear (&other->album);
+}
+
 void
 rg_analysis_reset_album (RgAnalysisCtx * ctx)
 {
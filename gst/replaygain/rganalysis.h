@@ -54,6 +54,7 @@ void rg_analysis_init_silence_detection (
     gpointer analysis);
 void rg_analysis_start_buffer (RgAnalysisCtx * ctx,
                                GstClockTime buffer_timestamp);
+void rg_analysis_merge_album (RgAnalysisCtx * ctx, RgAnalysisCtx * other);
 void rg_analysis_reset_album (RgAnalysisCtx * ctx);
 void rg_analysis_reset (RgAnalysisCtx * ctx);
 void rg_analysis_destroy (RgAnalysisCtx * ctx);
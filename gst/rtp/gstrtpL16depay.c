@@ -211,6 +211,9 @@ gst_rtp_L16_depay_setcaps (GstRTPBaseDepayload * depayload, GstCaps * caps)
     /* create default NONE layout */
     gst_rtp_channels_create_default (channels, info->position);
   }
+  rtpL16depay->reorder = order &&
+      gst_rtp_channels_get_reorder_map (channels, info->position, order->pos,
+      rtpL16depay->reorder_map);
 
   srccaps = gst_audio_info_to_caps (info);
   res = gst_pad_set_caps (depayload->srcpad, srccaps);
@@ -253,12 +256,12 @@ gst_rtp_L16_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
     GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_RESYNC);
   }
 
-  outbuf = gst_buffer_make_writable (outbuf);
-  if (rtpL16depay->order &&
-      !gst_audio_buffer_reorder_channels (outbuf,
-          rtpL16depay->info.finfo->format, rtpL16depay->info.channels,
-          rtpL16depay->info.position, rtpL16depay->order->pos)) {
-    goto reorder_failed;
+  if (rtpL16depay->reorder) {
+    outbuf = gst_rtp_channels_reorder_buffer (outbuf,
+        GST_AUDIO_INFO_BPS (&rtpL16depay->info), rtpL16depay->info.channels,
+        rtpL16depay->reorder_map);
+    if (outbuf == NULL)
+      goto reorder_failed;
   }
 
   gst_rtp_buffer_unmap (&rtp);
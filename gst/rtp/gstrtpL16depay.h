@@ -50,6 +50,8 @@ struct _GstRtpL16Depay
 
   GstAudioInfo info;
   const GstRTPChannelOrder *order;
+  gboolean reorder;
+  gint reorder_map[64];
 };
 
 /* Standard definition defining a class for this element. */
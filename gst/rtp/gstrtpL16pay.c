@@ -151,6 +151,9 @@ gst_rtp_L16_pay_setcaps (GstRTPBasePayload * basepayload, GstCaps * caps)
 
   order = gst_rtp_channels_get_by_pos (info->channels, info->position);
   rtpL16pay->order = order;
+  rtpL16pay->reorder = order &&
+      gst_rtp_channels_get_reorder_map (info->channels, info->position,
+      order->pos, rtpL16pay->reorder_map);
 
   gst_rtp_base_payload_set_options (basepayload, "audio", TRUE, "L16",
       info->rate);
@@ -244,13 +247,13 @@ gst_rtp_L16_pay_handle_buffer (GstRTPBasePayload * basepayload,
   GstRtpL16Pay *rtpL16pay;
 
   rtpL16pay = GST_RTP_L16_PAY (basepayload);
-  buffer = gst_buffer_make_writable (buffer);
 
-  if (rtpL16pay->order &&
-      !gst_audio_buffer_reorder_channels (buffer, rtpL16pay->info.finfo->format,
-          rtpL16pay->info.channels, rtpL16pay->info.position,
-          rtpL16pay->order->pos)) {
-    return GST_FLOW_ERROR;
+  if (rtpL16pay->reorder) {
+    buffer = gst_rtp_channels_reorder_buffer (buffer,
+        GST_AUDIO_INFO_BPS (&rtpL16pay->info), rtpL16pay->info.channels,
+        rtpL16pay->reorder_map);
+    if (buffer == NULL)
+      return GST_FLOW_ERROR;
   }
 
   return GST_RTP_BASE_PAYLOAD_CLASS (parent_class)->handle_buffer (basepayload,
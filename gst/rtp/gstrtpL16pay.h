@@ -47,6 +47,8 @@ struct _GstRtpL16Pay
 
   GstAudioInfo info;
   const GstRTPChannelOrder *order;
+  gboolean reorder;
+  gint reorder_map[64];
 };
 
 struct _GstRtpL16PayClass
@@ -187,6 +187,9 @@ gst_rtp_L24_depay_setcaps (GstRTPBaseDepayload * depayload, GstCaps * caps)
     /* create default NONE layout */
     gst_rtp_channels_create_default (channels, info->position);
   }
+  rtpL24depay->reorder = order &&
+      gst_rtp_channels_get_reorder_map (channels, info->position, order->pos,
+      rtpL24depay->reorder_map);
 
   srccaps = gst_audio_info_to_caps (info);
   res = gst_pad_set_caps (depayload->srcpad, srccaps);
@@ -229,12 +232,12 @@ gst_rtp_L24_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
     GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_RESYNC);
   }
 
-  outbuf = gst_buffer_make_writable (outbuf);
-  if (rtpL24depay->order &&
-      !gst_audio_buffer_reorder_channels (outbuf,
-          rtpL24depay->info.finfo->format, rtpL24depay->info.channels,
-          rtpL24depay->info.position, rtpL24depay->order->pos)) {
-    goto reorder_failed;
+  if (rtpL24depay->reorder) {
+    outbuf = gst_rtp_channels_reorder_buffer (outbuf,
+        GST_AUDIO_INFO_BPS (&rtpL24depay->info), rtpL24depay->info.channels,
+        rtpL24depay->reorder_map);
+    if (outbuf == NULL)
+      goto reorder_failed;
   }
 
   gst_rtp_buffer_unmap (&rtp);
@@ -139,6 +139,9 @@ gst_rtp_L24_pay_setcaps (GstRTPBasePayload * basepayload, GstCaps * caps)
 
   order = gst_rtp_channels_get_by_pos (info->channels, info->position);
   rtpL24pay->order = order;
+  rtpL24pay->reorder = order &&
+      gst_rtp_channels_get_reorder_map (info->channels, info->position,
+      order->pos, rtpL24pay->reorder_map);
 
   gst_rtp_base_payload_set_options (basepayload, "audio", TRUE, "L24",
       info->rate);
@@ -223,13 +226,13 @@ gst_rtp_L24_pay_handle_buffer (GstRTPBasePayload * basepayload,
   GstRtpL24Pay *rtpL24pay;
 
   rtpL24pay = GST_RTP_L24_PAY (basepayload);
-  buffer = gst_buffer_make_writable (buffer);
 
-  if (rtpL24pay->order &&
-      !gst_audio_buffer_reorder_channels (buffer, rtpL24pay->info.finfo->format,
-          rtpL24pay->info.channels, rtpL24pay->info.position,
-          rtpL24pay->order->pos)) {
-    return GST_FLOW_ERROR;
+  if (rtpL24pay->reorder) {
+    buffer = gst_rtp_channels_reorder_buffer (buffer,
+        GST_AUDIO_INFO_BPS (&rtpL24pay->info), rtpL24pay->info.channels,
+        rtpL24pay->reorder_map);
+    if (buffer == NULL)
+      return GST_FLOW_ERROR;
   }
 
   return GST_RTP_BASE_PAYLOAD_CLASS (parent_class)->handle_buffer (basepayload,
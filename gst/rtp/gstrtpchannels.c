@@ -162,3 +162,120 @@ gst_rtp_channels_create_default (gint channels, GstAudioChannelPosition * posn)
   for (i = 0; i < channels; i++)
     posn[i] = GST_AUDIO_CHANNEL_POSITION_NONE;
 }
+
+/**
+ * gst_rtp_channels_get_reorder_map:
+ * @channels: the amount of channels
+ * @from: the channel layout of the samples
+ * @to: the wanted channel layout
+ * @reorder_map: location for @channels destination channel indexes
+ *
+ * Calculate how to move the channels of samples in layout @from to layout @to
+ * for gst_rtp_channels_reorder_buffer().
+ *
+ * Returns: %TRUE when the samples need reordering, FALSE when the layouts are
+ * the same or can't be mapped onto each other.
+ */
+gboolean
+gst_rtp_channels_get_reorder_map (gint channels,
+    const GstAudioChannelPosition * from, const GstAudioChannelPosition * to,
+    gint * reorder_map)
+{
+  g_return_val_if_fail (channels > 0 && channels <= 64, FALSE);
+
+  if (memcmp (from, to, channels * sizeof (from[0])) == 0)
+    return FALSE;
+
+  return gst_audio_get_channel_reorder_map (channels, from, to, reorder_map);
+}
+
+/**
+ * gst_rtp_channels_reorder_buffer:
+ * @buffer: (transfer full): a buffer with interleaved samples
+ * @width: the size of a sample in bytes
+ * @channels: the amount of channels
+ * @reorder_map: the reorder map from gst_rtp_channels_get_reorder_map()
+ *
+ * Copy the samples of @buffer into a new buffer, moving channel i of every
+ * frame to channel @reorder_map[i] along the way. This does the copy that
+ * reordering a shared buffer in place needs anyway and the reordering in one
+ * pass.
+ *
+ * Returns: (transfer full): the reordered buffer or NULL when @buffer could
+ * not be mapped.
+ */
+GstBuffer *
+gst_rtp_channels_reorder_buffer (GstBuffer * buffer, gint width,
+    gint channels, const gint * reorder_map)
+{
+  GstBuffer *outbuf;
+  GstMapInfo inmap, outmap;
+  const guint8 *s;
+  guint8 *d;
+  gsize bpf, frames, i;
+  gint c, offsets[64];
+
+  g_return_val_if_fail (channels > 0 && channels <= 64, NULL);
+
+  if (!gst_buffer_map (buffer, &inmap, GST_MAP_READ)) {
+    gst_buffer_unref (buffer);
+    return NULL;
+  }
+
+  outbuf = gst_buffer_new_allocate (NULL, inmap.size, NULL);
+  gst_buffer_copy_into (outbuf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
+  gst_buffer_map (outbuf, &outmap, GST_MAP_WRITE);
+
+  for (c = 0; c < channels; c++)
+    offsets[c] = reorder_map[c] * width;
+
+  bpf = width * channels;
+  frames = inmap.size / bpf;
+  s = inmap.data;
+  d = outmap.data;
+
+  switch (width) {
+    case 2:
+      for (i = 0; i < frames; i++) {
+        for (c = 0; c < channels; c++) {
+          guint8 *o = d + offsets[c];
+
+          o[0] = s[0];
+          o[1] = s[1];
+          s += 2;
+        }
+        d += bpf;
+      }
+      break;
+    case 3:
+      for (i = 0; i < frames; i++) {
+        for (c = 0; c < channels; c++) {
+          guint8 *o = d + offsets[c];
+
+          o[0] = s[0];
+          o[1] = s[1];
+          o[2] = s[2];
+          s += 3;
+        }
+        d += bpf;
+      }
+      break;
+    default:
+      for (i = 0; i < frames; i++) {
+        for (c = 0; c < channels; c++) {
+          memcpy (d + offsets[c], s, width);
+          s += width;
+        }
+        d += bpf;
+      }
+      break;
+  }
+  /* a trailing partial frame is kept as it is */
+  memcpy (d, s, inmap.size - frames * bpf);
+
+  gst_buffer_unmap (outbuf, &outmap);
+  gst_buffer_unmap (buffer, &inmap);
+  gst_buffer_unref (buffer);
+
+  return outbuf;
+}
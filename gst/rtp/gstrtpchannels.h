@@ -187,4 +187,11 @@ const GstRTPChannelOrder *   gst_rtp_channels_get_by_index   (gint channels, gui
 
 void                         gst_rtp_channels_create_default (gint channels, GstAudioChannelPosition *pos);
 
+gboolean                     gst_rtp_channels_get_reorder_map (gint channels,
+                                                              const GstAudioChannelPosition *from,
+                                                              const GstAudioChannelPosition *to,
+                                                              gint *reorder_map);
+GstBuffer *                  gst_rtp_channels_reorder_buffer  (GstBuffer *buffer, gint width,
+                                                              gint channels, const gint *reorder_map);
+
 #endif /* __GST_RTP_CHANNELS_H__ */
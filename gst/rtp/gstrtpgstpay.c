@@ -174,6 +174,7 @@ gst_rtp_gst_pay_reset (GstRtpGSTPay * rtpgstpay, gboolean full)
     if (rtpgstpay->stream_id)
       g_free (rtpgstpay->stream_id);
     rtpgstpay->stream_id = NULL;
+    gst_caps_replace (&rtpgstpay->current_caps, NULL);
     rtpgstpay->current_CV = 0;
     rtpgstpay->next_CV = 0;
   }
@@ -280,8 +281,7 @@ gst_rtp_gst_pay_create_from_adapter (GstRtpGSTPay * rtpgstpay,
     guint packet_len;
     GstBuffer *outbuf;
     GstRTPBuffer rtp = { NULL };
-    GstBuffer *paybuf;
-
+    GList *paybufs, *walk;
 
     /* this will be the total lenght of the packet */
     packet_len = gst_rtp_buffer_calc_packet_len (8 + avail, 0, 0);
@@ -329,12 +329,16 @@ gst_rtp_gst_pay_create_from_adapter (GstRtpGSTPay * rtpgstpay,
 
     gst_rtp_buffer_unmap (&rtp);
 
-    /* create a new buf to hold the payload */
+    /* take the payload as sub-buffers of what is in the adapter, so that a
+     * fragment spanning the caps or event data and the buffer data is not
+     * copied */
     GST_DEBUG_OBJECT (rtpgstpay, "take %u bytes from adapter", payload_len);
-    paybuf = gst_adapter_take_buffer_fast (rtpgstpay->adapter, payload_len);
+    paybufs = gst_adapter_take_list (rtpgstpay->adapter, payload_len);
 
     /* create a new group to hold the rtp header and the payload */
-    gst_buffer_append (outbuf, paybuf);
+    for (walk = paybufs; walk; walk = g_list_next (walk))
+      outbuf = gst_buffer_append (outbuf, walk->data);
+    g_list_free (paybufs);
 
     GST_BUFFER_TIMESTAMP (outbuf) = timestamp;
 
@@ -440,6 +444,16 @@ gst_rtp_gst_pay_setcaps (GstRTPBasePayload * payload, GstCaps * caps)
 
   rtpgstpay = GST_RTP_GST_PAY (payload);
 
+  /* the receiver already has these caps as the current caps version, don't
+   * send them again; the config-interval still refreshes them */
+  if (rtpgstpay->current_caps && gst_caps_is_equal (rtpgstpay->current_caps,
+          caps)) {
+    GST_DEBUG_OBJECT (payload, "caps unchanged, keeping version %d",
+        rtpgstpay->current_CV);
+    return TRUE;
+  }
+  gst_caps_replace (&rtpgstpay->current_caps, caps);
+
   capsstr = gst_caps_to_string (caps);
   capslen = strlen (capsstr);
 
@@ -515,6 +529,13 @@ gst_rtp_gst_pay_sink_event (GstRTPBasePayload * payload, GstEvent * event)
       if (gst_tag_list_get_scope (tags) == GST_TAG_SCOPE_STREAM) {
         GstTagList *old;
 
+        /* nothing new to tell the receiver */
+        if (rtpgstpay->taglist && gst_tag_list_is_equal (rtpgstpay->taglist,
+                tags)) {
+          GST_DEBUG_OBJECT (rtpgstpay, "stream tags unchanged");
+          break;
+        }
+
         GST_DEBUG_OBJECT (rtpgstpay, "storing stream tags %" GST_PTR_FORMAT,
             tags);
         if ((old = rtpgstpay->taglist))
@@ -533,11 +554,18 @@ gst_rtp_gst_pay_sink_event (GstRTPBasePayload * payload, GstEvent * event)
     case GST_EVENT_STREAM_START:{
       const gchar *stream_id = NULL;
 
+      gst_event_parse_stream_start (event, &stream_id);
+
+      /* the same stream again, keep the tags and don't resend */
+      if (stream_id && g_strcmp0 (stream_id, rtpgstpay->stream_id) == 0) {
+        GST_DEBUG_OBJECT (rtpgstpay, "stream-start unchanged");
+        break;
+      }
+
       if (rtpgstpay->taglist)
         gst_tag_list_unref (rtpgstpay->taglist);
       rtpgstpay->taglist = NULL;
 
-      gst_event_parse_stream_start (event, &stream_id);
       if (stream_id) {
         if (rtpgstpay->stream_id)
           g_free (rtpgstpay->stream_id);
@@ -52,6 +52,7 @@ struct _GstRtpGSTPay
   guint8 current_CV; /* CV field of incoming caps*/
   guint8 next_CV;
 
+  GstCaps *current_caps; /* caps sent as current_CV */
   gchar *stream_id;
   GstTagList *taglist;
   guint config_interval;
@@ -137,8 +137,10 @@ static void
 gst_rtp_h264_depay_reset (GstRtpH264Depay * rtph264depay)
 {
   gst_adapter_clear (rtph264depay->adapter);
+  rtph264depay->adapter_n_mem = 0;
   rtph264depay->wait_start = TRUE;
   gst_adapter_clear (rtph264depay->picture_adapter);
+  rtph264depay->picture_n_mem = 0;
   rtph264depay->picture_start = FALSE;
   rtph264depay->last_keyframe = FALSE;
   rtph264depay->last_ts = 0;
@@ -634,17 +636,81 @@ incomplete_caps:
   }
 }
 
+/* the NALs are assembled from pieces that point into the RTP packets, these
+ * helpers keep track of how many memory blocks that will give */
+static void
+gst_rtp_h264_depay_push_chained (GstAdapter * adapter, guint * n_mem,
+    GstBuffer * buf)
+{
+  *n_mem += gst_buffer_n_memory (buf);
+  gst_adapter_push (adapter, buf);
+}
+
+/* take everything from @adapter as one buffer that refers to the memory of
+ * the queued buffers. Only when there are more pieces than a buffer can hold
+ * they are copied into one block, appending would merge them anyway. */
+static GstBuffer *
+gst_rtp_h264_depay_take_chained (GstAdapter * adapter, guint * n_mem,
+    GstBuffer * prefix)
+{
+  GstBuffer *outbuf = prefix;
+  guint size, total_mem;
+
+  size = gst_adapter_available (adapter);
+  total_mem = *n_mem + (prefix ? gst_buffer_n_memory (prefix) : 0);
+  *n_mem = 0;
+
+  if (total_mem <= gst_buffer_get_max_memory ()) {
+    GList *list, *walk;
+
+    list = gst_adapter_take_list (adapter, size);
+    for (walk = list; walk; walk = g_list_next (walk)) {
+      if (outbuf)
+        outbuf = gst_buffer_append (outbuf, walk->data);
+      else
+        outbuf = walk->data;
+    }
+    g_list_free (list);
+  } else {
+    GstBuffer *data = gst_adapter_take_buffer (adapter, size);
+
+    outbuf = prefix ? gst_buffer_append (prefix, data) : data;
+  }
+
+  return outbuf;
+}
+
+/* the start code or the length in front of a NAL in the output */
+static GstBuffer *
+gst_rtp_h264_depay_new_prefix (GstRtpH264Depay * rtph264depay, guint nal_size)
+{
+  GstBuffer *prefix;
+  guint8 data[4];
+
+  if (rtph264depay->byte_stream) {
+    memcpy (data, sync_bytes, sizeof (sync_bytes));
+  } else {
+    data[0] = (nal_size >> 24);
+    data[1] = (nal_size >> 16);
+    data[2] = (nal_size >> 8);
+    data[3] = (nal_size);
+  }
+  prefix = gst_buffer_new_allocate (NULL, sizeof (data), NULL);
+  gst_buffer_fill (prefix, 0, data, sizeof (data));
+
+  return prefix;
+}
+
 static GstBuffer *
 gst_rtp_h264_complete_au (GstRtpH264Depay * rtph264depay,
     GstClockTime * out_timestamp, gboolean * out_keyframe)
 {
-  guint outsize;
   GstBuffer *outbuf;
 
   /* we had a picture in the adapter and we completed it */
   GST_DEBUG_OBJECT (rtph264depay, "taking completed AU");
-  outsize = gst_adapter_available (rtph264depay->picture_adapter);
-  outbuf = gst_adapter_take_buffer (rtph264depay->picture_adapter, outsize);
+  outbuf = gst_rtp_h264_depay_take_chained (rtph264depay->picture_adapter,
+      &rtph264depay->picture_n_mem, NULL);
 
   *out_timestamp = rtph264depay->last_ts;
   *out_keyframe = rtph264depay->last_keyframe;
@@ -665,16 +731,17 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
 {
   GstRTPBaseDepayload *depayload = GST_RTP_BASE_DEPAYLOAD (rtph264depay);
   gint nal_type;
-  GstMapInfo map;
+  guint8 header[6] = { 0, };
   GstBuffer *outbuf = NULL;
   GstClockTime out_timestamp;
   gboolean keyframe, out_keyframe;
 
-  gst_buffer_map (nal, &map, GST_MAP_READ);
-  if (G_UNLIKELY (map.size < 5))
+  /* the NAL usually consists of several memory blocks, don't map it, that
+   * would merge them */
+  if (G_UNLIKELY (gst_buffer_extract (nal, 0, header, sizeof (header)) < 5))
     goto short_nal;
 
-  nal_type = map.data[4] & 0x1f;
+  nal_type = header[4] & 0x1f;
   GST_DEBUG_OBJECT (rtph264depay, "handle NAL type %d", nal_type);
 
   keyframe = NAL_TYPE_IS_KEY (nal_type);
@@ -687,7 +754,6 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
       gst_rtp_h264_depay_add_sps_pps (rtph264depay,
           gst_buffer_copy_region (nal, GST_BUFFER_COPY_ALL,
               4, gst_buffer_get_size (nal) - 4));
-      gst_buffer_unmap (nal, &map);
       gst_buffer_unref (nal);
       return NULL;
     } else if (rtph264depay->sps->len == 0 || rtph264depay->pps->len == 0) {
@@ -698,7 +764,6 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
           gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
               gst_structure_new ("GstForceKeyUnit",
                   "all-headers", G_TYPE_BOOLEAN, TRUE, NULL)));
-      gst_buffer_unmap (nal, &map);
       gst_buffer_unref (nal);
       return NULL;
     }
@@ -721,7 +786,7 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
     if (nal_type == 1 || nal_type == 2 || nal_type == 5) {
       /* we have a picture start */
       start = TRUE;
-      if (map.data[5] & 0x80) {
+      if (header[5] & 0x80) {
         /* first_mb_in_slice == 0 completes a picture */
         complete = TRUE;
       }
@@ -736,10 +801,9 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
           &out_keyframe);
 
     /* add to adapter */
-    gst_buffer_unmap (nal, &map);
-
     GST_DEBUG_OBJECT (depayload, "adding NAL to picture adapter");
-    gst_adapter_push (rtph264depay->picture_adapter, nal);
+    gst_rtp_h264_depay_push_chained (rtph264depay->picture_adapter,
+        &rtph264depay->picture_n_mem, nal);
     rtph264depay->last_ts = in_timestamp;
     rtph264depay->last_keyframe |= keyframe;
     rtph264depay->picture_start |= start;
@@ -751,7 +815,6 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
     /* no merge, output is input nal */
     GST_DEBUG_OBJECT (depayload, "using NAL as output");
     outbuf = nal;
-    gst_buffer_unmap (nal, &map);
   }
 
   if (outbuf) {
@@ -778,7 +841,6 @@ gst_rtp_h264_depay_handle_nal (GstRtpH264Depay * rtph264depay, GstBuffer * nal,
 short_nal:
   {
     GST_WARNING_OBJECT (depayload, "dropping short NAL");
-    gst_buffer_unmap (nal, &map);
     gst_buffer_unref (nal);
     return NULL;
   }
@@ -789,25 +851,16 @@ gst_rtp_h264_push_fragmentation_unit (GstRtpH264Depay * rtph264depay,
     gboolean send)
 {
   guint outsize;
-  GstMapInfo map;
   GstBuffer *outbuf;
 
+  /* the adapter has the NAL header followed by the FU payloads */
   outsize = gst_adapter_available (rtph264depay->adapter);
-  outbuf = gst_adapter_take_buffer (rtph264depay->adapter, outsize);
+  GST_DEBUG_OBJECT (rtph264depay, "output %d bytes",
+      outsize + (guint) sizeof (sync_bytes));
 
-  gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-  GST_DEBUG_OBJECT (rtph264depay, "output %d bytes", outsize);
-
-  if (rtph264depay->byte_stream) {
-    memcpy (map.data, sync_bytes, sizeof (sync_bytes));
-  } else {
-    outsize -= 4;
-    map.data[0] = (outsize >> 24);
-    map.data[1] = (outsize >> 16);
-    map.data[2] = (outsize >> 8);
-    map.data[3] = (outsize);
-  }
-  gst_buffer_unmap (outbuf, &map);
+  outbuf = gst_rtp_h264_depay_take_chained (rtph264depay->adapter,
+      &rtph264depay->adapter_n_mem,
+      gst_rtp_h264_depay_new_prefix (rtph264depay, outsize));
 
   rtph264depay->current_fu_type = 0;
 
@@ -834,6 +887,7 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
   /* flush remaining data on discont */
   if (GST_BUFFER_IS_DISCONT (buf)) {
     gst_adapter_clear (rtph264depay->adapter);
+    rtph264depay->adapter_n_mem = 0;
     rtph264depay->wait_start = TRUE;
     rtph264depay->current_fu_type = 0;
   }
@@ -843,8 +897,7 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
     guint8 *payload;
     guint header_len;
     guint8 nal_ref_idc;
-    GstMapInfo map;
-    guint outsize, nalu_size;
+    guint offset, nalu_size;
     GstClockTime timestamp;
     gboolean marker;
 
@@ -901,6 +954,7 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
         /* strip headers */
         payload += header_len;
         payload_len -= header_len;
+        offset = header_len;
 
         rtph264depay->wait_start = FALSE;
 
@@ -919,33 +973,28 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
           if (nalu_size > (payload_len - 2))
             nalu_size = payload_len - 2;
 
-          outsize = nalu_size + sizeof (sync_bytes);
-          outbuf = gst_buffer_new_and_alloc (outsize);
-
-          gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-          if (rtph264depay->byte_stream) {
-            memcpy (map.data, sync_bytes, sizeof (sync_bytes));
-          } else {
-            map.data[0] = map.data[1] = 0;
-            map.data[2] = payload[0];
-            map.data[3] = payload[1];
-          }
+          gst_rtp_h264_depay_push_chained (rtph264depay->adapter,
+              &rtph264depay->adapter_n_mem,
+              gst_rtp_h264_depay_new_prefix (rtph264depay, nalu_size));
 
           /* strip NALU size */
           payload += 2;
           payload_len -= 2;
+          offset += 2;
 
-          memcpy (map.data + sizeof (sync_bytes), payload, nalu_size);
-          gst_buffer_unmap (outbuf, &map);
-
-          gst_adapter_push (rtph264depay->adapter, outbuf);
+          if (nalu_size > 0)
+            gst_rtp_h264_depay_push_chained (rtph264depay->adapter,
+                &rtph264depay->adapter_n_mem,
+                gst_rtp_buffer_get_payload_subbuffer (&rtp, offset,
+                    nalu_size));
 
           payload += nalu_size;
           payload_len -= nalu_size;
+          offset += nalu_size;
         }
 
-        outsize = gst_adapter_available (rtph264depay->adapter);
-        outbuf = gst_adapter_take_buffer (rtph264depay->adapter, outsize);
+        outbuf = gst_rtp_h264_depay_take_chained (rtph264depay->adapter,
+            &rtph264depay->adapter_n_mem, NULL);
 
         outbuf = gst_rtp_h264_depay_handle_nal (rtph264depay, outbuf, timestamp,
             marker);
@@ -975,6 +1024,9 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
          *
          * R is reserved and always 0
          */
+        if (G_UNLIKELY (payload_len < 2))
+          goto empty_packet;
+
         S = (payload[1] & 0x80) == 0x80;
         E = (payload[1] & 0x40) == 0x40;
 
@@ -986,6 +1038,7 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
         if (S) {
           /* NAL unit starts here */
           guint8 nal_header;
+          GstBuffer *hdrbuf;
 
           /* If a new FU unit started, while still processing an older one.
            * Assume that the remote payloader is buggy (doesn't set the end
@@ -998,41 +1051,26 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
 
           rtph264depay->wait_start = FALSE;
 
-          /* reconstruct NAL header */
+          /* reconstruct NAL header, the start code or length is added when
+           * the NAL is complete */
           nal_header = (payload[0] & 0xe0) | (payload[1] & 0x1f);
 
-          /* strip type header, keep FU header, we'll reuse it to reconstruct
-           * the NAL header. */
-          payload += 1;
-          payload_len -= 1;
-
-          nalu_size = payload_len;
-          outsize = nalu_size + sizeof (sync_bytes);
-          outbuf = gst_buffer_new_and_alloc (outsize);
-
-          gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-          memcpy (map.data + sizeof (sync_bytes), payload, nalu_size);
-          map.data[sizeof (sync_bytes)] = nal_header;
-          gst_buffer_unmap (outbuf, &map);
-
-          GST_DEBUG_OBJECT (rtph264depay, "queueing %d bytes", outsize);
-
-          /* and assemble in the adapter */
-          gst_adapter_push (rtph264depay->adapter, outbuf);
-        } else {
-          /* strip off FU indicator and FU header bytes */
-          payload += 2;
-          payload_len -= 2;
-
-          outsize = payload_len;
-          outbuf = gst_buffer_new_and_alloc (outsize);
-          gst_buffer_fill (outbuf, 0, payload, outsize);
+          hdrbuf = gst_buffer_new_allocate (NULL, 1, NULL);
+          gst_buffer_fill (hdrbuf, 0, &nal_header, 1);
+          gst_rtp_h264_depay_push_chained (rtph264depay->adapter,
+              &rtph264depay->adapter_n_mem, hdrbuf);
+        }
 
-          GST_DEBUG_OBJECT (rtph264depay, "queueing %d bytes", outsize);
+        /* strip off FU indicator and FU header bytes, the rest refers to the
+         * memory of the packet */
+        nalu_size = payload_len - 2;
+        GST_DEBUG_OBJECT (rtph264depay, "queueing %d bytes", nalu_size);
 
-          /* and assemble in the adapter */
-          gst_adapter_push (rtph264depay->adapter, outbuf);
-        }
+        /* and assemble in the adapter */
+        if (nalu_size > 0)
+          gst_rtp_h264_depay_push_chained (rtph264depay->adapter,
+              &rtph264depay->adapter_n_mem,
+              gst_rtp_buffer_get_payload_subbuffer (&rtp, 2, nalu_size));
 
         outbuf = NULL;
         rtph264depay->fu_marker = marker;
@@ -1049,19 +1087,9 @@ gst_rtp_h264_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
         /* 1-23   NAL unit  Single NAL unit packet per H.264   5.6 */
         /* the entire payload is the output buffer */
         nalu_size = payload_len;
-        outsize = nalu_size + sizeof (sync_bytes);
-        outbuf = gst_buffer_new_and_alloc (outsize);
-
-        gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-        if (rtph264depay->byte_stream) {
-          memcpy (map.data, sync_bytes, sizeof (sync_bytes));
-        } else {
-          map.data[0] = map.data[1] = 0;
-          map.data[2] = nalu_size >> 8;
-          map.data[3] = nalu_size & 0xff;
-        }
-        memcpy (map.data + sizeof (sync_bytes), payload, nalu_size);
-        gst_buffer_unmap (outbuf, &map);
+        outbuf = gst_buffer_append (gst_rtp_h264_depay_new_prefix (rtph264depay,
+                nalu_size), gst_rtp_buffer_get_payload_subbuffer (&rtp, 0,
+                nalu_size));
 
         outbuf = gst_rtp_h264_depay_handle_nal (rtph264depay, outbuf, timestamp,
             marker);
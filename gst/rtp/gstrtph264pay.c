@@ -67,12 +67,20 @@ GST_STATIC_PAD_TEMPLATE ("src",
 
 #define DEFAULT_SPROP_PARAMETER_SETS    NULL
 #define DEFAULT_CONFIG_INTERVAL		      0
+#define DEFAULT_AGGREGATE               FALSE
+
+#define STAP_A_TYPE_ID  24
+/* an aggregated packet uses one memory block for the RTP header and STAP-A
+ * indicator and two for every NAL, stay below GST_BUFFER_MAX_MEMORY so the
+ * NALs are never merged (copied) */
+#define STAP_A_MAX_NALS 7
 
 enum
 {
   PROP_0,
   PROP_SPROP_PARAMETER_SETS,
   PROP_CONFIG_INTERVAL,
+  PROP_AGGREGATE,
   PROP_LAST
 };
 
@@ -131,6 +139,21 @@ gst_rtp_h264_pay_class_init (GstRtpH264PayClass * klass)
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)
       );
 
+  /**
+   * GstRtpH264Pay:aggregate:
+   *
+   * Pack consecutive NAL units of the same input buffer that fit in the MTU
+   * together into STAP-A packets instead of sending each in its own packet.
+   * This mostly helps with SPS, PPS, SEI and small slices at low bitrates.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+      PROP_AGGREGATE,
+      g_param_spec_boolean ("aggregate", "Aggregate",
+          "Aggregate small NAL units into STAP-A packets",
+          DEFAULT_AGGREGATE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gobject_class->finalize = gst_rtp_h264_pay_finalize;
 
   gst_element_class_add_pad_template (gstelement_class,
@@ -166,10 +189,19 @@ gst_rtp_h264_pay_init (GstRtpH264Pay * rtph264pay)
       (GDestroyNotify) gst_buffer_unref);
   rtph264pay->last_spspps = -1;
   rtph264pay->spspps_interval = DEFAULT_CONFIG_INTERVAL;
+  rtph264pay->aggregate = DEFAULT_AGGREGATE;
+  rtph264pay->stap_nals = g_ptr_array_new ();
 
   rtph264pay->adapter = gst_adapter_new ();
 }
 
+static void
+gst_rtp_h264_pay_clear_stap (GstRtpH264Pay * rtph264pay)
+{
+  g_ptr_array_foreach (rtph264pay->stap_nals, (GFunc) gst_buffer_unref, NULL);
+  g_ptr_array_set_size (rtph264pay->stap_nals, 0);
+}
+
 static void
 gst_rtp_h264_pay_clear_sps_pps (GstRtpH264Pay * rtph264pay)
 {
@@ -189,6 +221,9 @@ gst_rtp_h264_pay_finalize (GObject * object)
   g_ptr_array_free (rtph264pay->sps, TRUE);
   g_ptr_array_free (rtph264pay->pps, TRUE);
 
+  gst_rtp_h264_pay_clear_stap (rtph264pay);
+  g_ptr_array_free (rtph264pay->stap_nals, TRUE);
+
   g_free (rtph264pay->sprop_parameter_sets);
 
   g_object_unref (rtph264pay->adapter);
@@ -749,6 +784,143 @@ gst_rtp_h264_pay_send_sps_pps (GstRTPBasePayload * basepayload,
   return ret;
 }
 
+/* put a NAL that fits in the MTU in its own packet */
+static GstFlowReturn
+gst_rtp_h264_pay_push_single_nal (GstRTPBasePayload * basepayload,
+    GstBuffer * paybuf, GstClockTime dts, GstClockTime pts, gboolean marker)
+{
+  GstBuffer *outbuf;
+  GstBufferList *list;
+  GstRTPBuffer rtp = { NULL };
+
+  /* use buffer lists
+   * create buffer without payload containing only the RTP header
+   * (memory block at index 0) */
+  outbuf = gst_rtp_buffer_new_allocate (0, 0, 0);
+
+  gst_rtp_buffer_map (outbuf, GST_MAP_WRITE, &rtp);
+
+  /* only set the marker bit on packets containing access units */
+  if (marker)
+    gst_rtp_buffer_set_marker (&rtp, 1);
+
+  gst_rtp_buffer_unmap (&rtp);
+
+  /* timestamp the outbuffer */
+  GST_BUFFER_PTS (outbuf) = pts;
+  GST_BUFFER_DTS (outbuf) = dts;
+
+  /* insert payload memory block */
+  outbuf = gst_buffer_append (outbuf, paybuf);
+
+  list = gst_buffer_list_new ();
+
+  /* add the buffer to the buffer list */
+  gst_buffer_list_add (list, outbuf);
+
+  /* push the list to the next element in the pipe */
+  return gst_rtp_base_payload_push_list (basepayload, list);
+}
+
+/* send the pending aggregated NALs, as a STAP-A packet when there is more
+ * than one */
+static GstFlowReturn
+gst_rtp_h264_pay_flush_stap (GstRTPBasePayload * basepayload)
+{
+  GstRtpH264Pay *rtph264pay = GST_RTP_H264_PAY (basepayload);
+  GPtrArray *nals = rtph264pay->stap_nals;
+  GstBuffer *outbuf, *hdr;
+  GstBufferList *list;
+  GstRTPBuffer rtp = { NULL };
+  guint8 indicator = 0, nri = 0, nal_header, *payload;
+  guint8 size_bytes[2];
+  guint i;
+
+  if (nals->len == 0)
+    return GST_FLOW_OK;
+
+  if (nals->len == 1) {
+    outbuf = g_ptr_array_index (nals, 0);
+    g_ptr_array_set_size (nals, 0);
+    return gst_rtp_h264_pay_push_single_nal (basepayload, outbuf,
+        rtph264pay->stap_dts, rtph264pay->stap_pts, rtph264pay->stap_marker);
+  }
+
+  GST_DEBUG_OBJECT (basepayload, "aggregating %u NAL units", nals->len);
+
+  /* RTP header and the STAP-A indicator, the NALs are appended as memory */
+  outbuf = gst_rtp_buffer_new_allocate (1, 0, 0);
+  GST_BUFFER_PTS (outbuf) = rtph264pay->stap_pts;
+  GST_BUFFER_DTS (outbuf) = rtph264pay->stap_dts;
+
+  for (i = 0; i < nals->len; i++) {
+    GstBuffer *nal = g_ptr_array_index (nals, i);
+    gsize size = gst_buffer_get_size (nal);
+
+    /* the F bit is set when any NAL has it, NRI is the highest of all */
+    gst_buffer_extract (nal, 0, &nal_header, 1);
+    indicator |= nal_header & 0x80;
+    nri = MAX (nri, nal_header & 0x60);
+
+    size_bytes[0] = size >> 8;
+    size_bytes[1] = size & 0xff;
+    hdr = gst_buffer_new_allocate (NULL, 2, NULL);
+    gst_buffer_fill (hdr, 0, size_bytes, 2);
+
+    outbuf = gst_buffer_append (outbuf, hdr);
+    outbuf = gst_buffer_append (outbuf, nal);
+  }
+  g_ptr_array_set_size (nals, 0);
+
+  gst_rtp_buffer_map (outbuf, GST_MAP_WRITE, &rtp);
+  payload = gst_rtp_buffer_get_payload (&rtp);
+  payload[0] = indicator | nri | STAP_A_TYPE_ID;
+  if (rtph264pay->stap_marker)
+    gst_rtp_buffer_set_marker (&rtp, 1);
+  gst_rtp_buffer_unmap (&rtp);
+
+  list = gst_buffer_list_new ();
+  gst_buffer_list_add (list, outbuf);
+
+  return gst_rtp_base_payload_push_list (basepayload, list);
+}
+
+/* add a NAL that fits in the MTU to the pending STAP-A */
+static GstFlowReturn
+gst_rtp_h264_pay_aggregate_nal (GstRTPBasePayload * basepayload,
+    GstBuffer * paybuf, GstClockTime dts, GstClockTime pts, gboolean marker,
+    gboolean end_of_au)
+{
+  GstRtpH264Pay *rtph264pay = GST_RTP_H264_PAY (basepayload);
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint size = gst_buffer_get_size (paybuf);
+
+  /* NALs of another access unit or that don't fit anymore go in the next
+   * packet */
+  if (rtph264pay->stap_nals->len > 0 &&
+      (rtph264pay->stap_pts != pts || rtph264pay->stap_dts != dts ||
+          rtph264pay->stap_nals->len == STAP_A_MAX_NALS ||
+          gst_rtp_buffer_calc_packet_len (rtph264pay->stap_size + 2 + size, 0,
+              0) >= GST_RTP_BASE_PAYLOAD_MTU (basepayload))) {
+    ret = gst_rtp_h264_pay_flush_stap (basepayload);
+  }
+
+  if (rtph264pay->stap_nals->len == 0) {
+    /* the STAP-A NAL header */
+    rtph264pay->stap_size = 1;
+    rtph264pay->stap_pts = pts;
+    rtph264pay->stap_dts = dts;
+  }
+  g_ptr_array_add (rtph264pay->stap_nals, paybuf);
+  rtph264pay->stap_size += 2 + size;
+  rtph264pay->stap_marker = marker;
+
+  if (end_of_au && ret == GST_FLOW_OK)
+    ret = gst_rtp_h264_pay_flush_stap (basepayload);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_rtp_h264_pay_payload_nal (GstRTPBasePayload * basepayload,
     GstBuffer * paybuf, GstClockTime dts, GstClockTime pts, gboolean end_of_au)
@@ -761,7 +933,7 @@ gst_rtp_h264_pay_payload_nal (GstRTPBasePayload * basepayload,
   GstBuffer *outbuf;
   guint8 *payload;
   GstBufferList *list = NULL;
-  gboolean send_spspps;
+  gboolean send_spspps, marker;
   GstRTPBuffer rtp = { NULL };
   guint size = gst_buffer_get_size (paybuf);
 
@@ -822,40 +994,21 @@ gst_rtp_h264_pay_payload_nal (GstRTPBasePayload * basepayload,
   }
 
   packet_len = gst_rtp_buffer_calc_packet_len (size, 0, 0);
+  /* only set the marker bit on packets containing access units */
+  marker = IS_ACCESS_UNIT (nalType) && end_of_au;
 
-  if (packet_len < mtu) {
+  if (packet_len < mtu && rtph264pay->aggregate) {
+    GST_DEBUG_OBJECT (basepayload,
+        "NAL Unit fit in one packet datasize=%d mtu=%d, aggregating", size,
+        mtu);
+    ret = gst_rtp_h264_pay_aggregate_nal (basepayload, paybuf, dts, pts,
+        marker, end_of_au);
+  } else if (packet_len < mtu) {
     GST_DEBUG_OBJECT (basepayload,
         "NAL Unit fit in one packet datasize=%d mtu=%d", size, mtu);
     /* will fit in one packet */
-
-    /* use buffer lists
-     * create buffer without payload containing only the RTP header
-     * (memory block at index 0) */
-    outbuf = gst_rtp_buffer_new_allocate (0, 0, 0);
-
-    gst_rtp_buffer_map (outbuf, GST_MAP_WRITE, &rtp);
-
-    /* only set the marker bit on packets containing access units */
-    if (IS_ACCESS_UNIT (nalType) && end_of_au) {
-      gst_rtp_buffer_set_marker (&rtp, 1);
-    }
-
-    /* timestamp the outbuffer */
-    GST_BUFFER_PTS (outbuf) = pts;
-    GST_BUFFER_DTS (outbuf) = dts;
-
-    /* insert payload memory block */
-    outbuf = gst_buffer_append (outbuf, paybuf);
-
-    list = gst_buffer_list_new ();
-
-    /* add the buffer to the buffer list */
-    gst_buffer_list_add (list, outbuf);
-
-    gst_rtp_buffer_unmap (&rtp);
-
-    /* push the list to the next element in the pipe */
-    ret = gst_rtp_base_payload_push_list (basepayload, list);
+    ret = gst_rtp_h264_pay_push_single_nal (basepayload, paybuf, dts, pts,
+        marker);
   } else {
     /* fragmentation Units FU-A */
     guint limitedSize;
@@ -864,11 +1017,16 @@ gst_rtp_h264_pay_payload_nal (GstRTPBasePayload * basepayload,
     GST_DEBUG_OBJECT (basepayload,
         "NAL Unit DOES NOT fit in one packet datasize=%d mtu=%d", size, mtu);
 
+    /* the aggregated NALs before this one go out first */
+    ret = gst_rtp_h264_pay_flush_stap (basepayload);
+    if (ret != GST_FLOW_OK) {
+      gst_buffer_unref (paybuf);
+      return ret;
+    }
+
     pos++;
     size--;
 
-    ret = GST_FLOW_OK;
-
     GST_DEBUG_OBJECT (basepayload, "Using FU-A fragmentation for data size=%d",
         size);
 
@@ -1174,6 +1332,13 @@ gst_rtp_h264_pay_handle_buffer (GstRTPBasePayload * basepayload,
   }
 
 done:
+  /* aggregated NALs are not kept across input buffers, that would add
+   * latency */
+  if (ret == GST_FLOW_OK)
+    ret = gst_rtp_h264_pay_flush_stap (basepayload);
+  else
+    gst_rtp_h264_pay_clear_stap (rtph264pay);
+
   if (avc) {
     gst_buffer_unmap (buffer, &map);
     gst_buffer_unref (buffer);
@@ -1202,6 +1367,7 @@ gst_rtp_h264_pay_sink_event (GstRTPBasePayload * payload, GstEvent * event)
   switch (GST_EVENT_TYPE (event)) {
     case GST_EVENT_FLUSH_STOP:
       gst_adapter_clear (rtph264pay->adapter);
+      gst_rtp_h264_pay_clear_stap (rtph264pay);
       break;
     case GST_EVENT_CUSTOM_DOWNSTREAM:
       s = gst_event_get_structure (event);
@@ -1244,6 +1410,7 @@ gst_rtp_h264_pay_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       rtph264pay->send_spspps = FALSE;
       gst_adapter_clear (rtph264pay->adapter);
+      gst_rtp_h264_pay_clear_stap (rtph264pay);
       break;
     default:
       break;
@@ -1271,6 +1438,9 @@ gst_rtp_h264_pay_set_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       rtph264pay->spspps_interval = g_value_get_uint (value);
       break;
+    case PROP_AGGREGATE:
+      rtph264pay->aggregate = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1292,6 +1462,9 @@ gst_rtp_h264_pay_get_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       g_value_set_uint (value, rtph264pay->spspps_interval);
       break;
+    case PROP_AGGREGATE:
+      g_value_set_boolean (value, rtph264pay->aggregate);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -74,6 +74,13 @@ struct _GstRtpH264Pay
   guint spspps_interval;
   gboolean send_spspps;
   GstClockTime last_spspps;
+
+  /* STAP-A aggregation */
+  gboolean aggregate;
+  GPtrArray *stap_nals;
+  guint stap_size;
+  GstClockTime stap_pts, stap_dts;
+  gboolean stap_marker;
 };
 
 struct _GstRtpH264PayClass
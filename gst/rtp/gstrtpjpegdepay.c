@@ -137,6 +137,11 @@ gst_rtp_jpeg_depay_reset (GstRtpJPEGDepay * depay)
     depay->qtables[i] = NULL;
   }
 
+  if (depay->header) {
+    gst_buffer_unref (depay->header);
+    depay->header = NULL;
+  }
+
   gst_adapter_clear (depay->adapter);
 }
 
@@ -423,6 +428,48 @@ MakeHeaders (guint8 * p, int type, int width, int height, guint8 * qt,
   return (p - start);
 };
 
+/* get the JFIF header for the frame, the last one is reused when nothing
+ * changed, which is the common case for a stream */
+static GstBuffer *
+gst_rtp_jpeg_depay_get_header (GstRtpJPEGDepay * rtpjpegdepay, guint type,
+    guint width, guint height, guint8 * qtable, guint precision, guint16 dri)
+{
+  GstBuffer *header;
+  GstMapInfo map;
+  guint size, qtable_size;
+
+  qtable_size = ((precision & 1) ? 128 : 64) + ((precision & 2) ? 128 : 64);
+
+  if (rtpjpegdepay->header && rtpjpegdepay->header_type == type &&
+      rtpjpegdepay->header_width == width &&
+      rtpjpegdepay->header_height == height &&
+      rtpjpegdepay->header_precision == precision &&
+      rtpjpegdepay->header_dri == dri &&
+      memcmp (rtpjpegdepay->header_qtable, qtable, qtable_size) == 0) {
+    GST_LOG_OBJECT (rtpjpegdepay, "reusing header");
+    return gst_buffer_ref (rtpjpegdepay->header);
+  }
+
+  /* max header length, should be big enough */
+  header = gst_buffer_new_and_alloc (1000);
+  gst_buffer_map (header, &map, GST_MAP_WRITE);
+  size = MakeHeaders (map.data, type, width, height, qtable, precision, dri);
+  gst_buffer_unmap (header, &map);
+  gst_buffer_resize (header, 0, size);
+
+  if (rtpjpegdepay->header)
+    gst_buffer_unref (rtpjpegdepay->header);
+  rtpjpegdepay->header = gst_buffer_ref (header);
+  rtpjpegdepay->header_type = type;
+  rtpjpegdepay->header_width = width;
+  rtpjpegdepay->header_height = height;
+  rtpjpegdepay->header_precision = precision;
+  rtpjpegdepay->header_dri = dri;
+  memcpy (rtpjpegdepay->header_qtable, qtable, qtable_size);
+
+  return header;
+}
+
 static gboolean
 gst_rtp_jpeg_depay_setcaps (GstRTPBaseDepayload * depayload, GstCaps * caps)
 {
@@ -609,10 +656,18 @@ gst_rtp_jpeg_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
     if (length > payload_len)
       goto empty_packet;
 
-    if (length > 0)
+    if (length > 0) {
       qtable = payload;
-    else
+      /* tables for Q 128-254 are static and can be left out of the next
+       * frames, keep them. 255 means they change every frame. */
+      if (Q < 255 && length <= 256) {
+        if (!rtpjpegdepay->qtables[Q])
+          rtpjpegdepay->qtables[Q] = g_new0 (guint8, 256);
+        memcpy (rtpjpegdepay->qtables[Q], payload, length);
+      }
+    } else {
       qtable = rtpjpegdepay->qtables[Q];
+    }
 
     payload += length;
     header_len += length;
@@ -624,8 +679,6 @@ gst_rtp_jpeg_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
   }
 
   if (frag_offset == 0) {
-    GstMapInfo map;
-    guint size;
 
     if (rtpjpegdepay->width != width || rtpjpegdepay->height != height) {
       GstCaps *outcaps;
@@ -665,14 +718,11 @@ gst_rtp_jpeg_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
           goto no_qtable;
       }
     }
-    /* max header length, should be big enough */
-    outbuf = gst_buffer_new_and_alloc (1000);
-    gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-    size = MakeHeaders (map.data, type, width, height, qtable, precision, dri);
-    gst_buffer_unmap (outbuf, &map);
-    gst_buffer_resize (outbuf, 0, size);
-
-    GST_DEBUG_OBJECT (rtpjpegdepay, "pushing %u bytes of header", size);
+    outbuf = gst_rtp_jpeg_depay_get_header (rtpjpegdepay, type, width, height,
+        qtable, precision, dri);
+
+    GST_DEBUG_OBJECT (rtpjpegdepay, "pushing %" G_GSIZE_FORMAT
+        " bytes of header", gst_buffer_get_size (outbuf));
 
     gst_adapter_push (rtpjpegdepay->adapter, outbuf);
   }
@@ -49,6 +49,13 @@ struct _GstRtpJPEGDepay
 
   /* cached quant tables */
   guint8 * qtables[255];
+
+  /* last generated JFIF header and what it was made from */
+  GstBuffer *header;
+  guint header_type, header_width, header_height, header_precision;
+  guint16 header_dri;
+  guint8 header_qtable[256];
+
   gint frate_num;
   gint frate_denom;
   gint media_width;
@@ -109,12 +109,18 @@ enum _RtpJpegMarker
 
 #define DEFAULT_JPEG_QUALITY  255
 #define DEFAULT_JPEG_TYPE     1
+#define DEFAULT_QTABLE_INTERVAL 0
+
+/* Q values 128-254 allow sending the tables only once, 255 doesn't */
+#define CACHED_Q_MIN          128
+#define CACHED_Q_MAX          254
 
 enum
 {
   PROP_0,
   PROP_JPEG_QUALITY,
   PROP_JPEG_TYPE,
+  PROP_QTABLE_INTERVAL,
   PROP_LAST
 };
 
@@ -272,6 +278,25 @@ gst_rtp_jpeg_pay_class_init (GstRtpJPEGPayClass * klass)
           "Default JPEG Type, overwritten by SOF when present", 0, 255,
           DEFAULT_JPEG_TYPE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRtpJPEGPay:qtable-interval:
+   *
+   * When not 0, the quantization tables are only sent when they change and
+   * then at most every this many frames so that new receivers pick them up.
+   * The frames in between refer to the previously sent tables with a Q value
+   * between 128 and 254 and an empty table, as allowed by RFC 2435. A new Q
+   * value is used whenever the tables change. When 0, the tables are sent
+   * with every frame using Q 255.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+      PROP_QTABLE_INTERVAL, g_param_spec_uint ("qtable-interval",
+          "Quantization table interval",
+          "Send unchanged quantization tables only every this many frames "
+          "(0 = send with every frame)", 0, G_MAXUINT, DEFAULT_QTABLE_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (rtpjpegpay_debug, "rtpjpegpay", 0,
       "Motion JPEG RTP Payloader");
 }
@@ -284,6 +309,44 @@ gst_rtp_jpeg_pay_init (GstRtpJPEGPay * pay)
   pay->type = DEFAULT_JPEG_TYPE;
   pay->width = -1;
   pay->height = -1;
+  pay->qtable_interval = DEFAULT_QTABLE_INTERVAL;
+  pay->cached_q = CACHED_Q_MAX;
+  pay->cached_qtables_size = 0;
+}
+
+/* check if the tables of this frame need to be sent, picks a new Q value when
+ * they changed */
+static gboolean
+gst_rtp_jpeg_pay_update_qtables (GstRtpJPEGPay * pay, RtpQuantTable * tables,
+    CompInfo * info)
+{
+  guint8 qtables[256];
+  guint i, size = 0;
+
+  for (i = 0; i < 2; i++) {
+    const RtpQuantTable *table = &tables[info[i].qt];
+
+    memcpy (qtables + size, table->data, table->size);
+    size += table->size;
+  }
+
+  if (size != pay->cached_qtables_size ||
+      memcmp (qtables, pay->cached_qtables, size) != 0) {
+    memcpy (pay->cached_qtables, qtables, size);
+    pay->cached_qtables_size = size;
+    if (++pay->cached_q > CACHED_Q_MAX)
+      pay->cached_q = CACHED_Q_MIN;
+    pay->qtable_frames = 0;
+    GST_DEBUG_OBJECT (pay, "quant tables changed, now using Q %u",
+        pay->cached_q);
+    return TRUE;
+  }
+
+  if (++pay->qtable_frames >= pay->qtable_interval) {
+    pay->qtable_frames = 0;
+    return TRUE;
+  }
+  return FALSE;
 }
 
 static gboolean
@@ -684,6 +747,7 @@ gst_rtp_jpeg_pay_handle_buffer (GstRTPBasePayload * basepayload,
   guint offset;
   gboolean frame_done;
   gboolean sos_found, sof_found, dqt_found, dri_found;
+  gboolean send_qtables;
   gint i;
   GstBufferList *list = NULL;
 
@@ -777,6 +841,7 @@ gst_rtp_jpeg_pay_handle_buffer (GstRTPBasePayload * basepayload,
   quant_header.precision = 0;
   quant_header.length = 0;
   quant_data_size = 0;
+  send_qtables = FALSE;
 
   if (pay->quant > 127) {
     /* for the Y and U component, look up the quant table and its size. quant
@@ -796,6 +861,15 @@ gst_rtp_jpeg_pay_handle_buffer (GstRTPBasePayload * basepayload,
       quant_header.precision |= (qsize == 64 ? 0 : (1 << i));
       quant_data_size += qsize;
     }
+    send_qtables = TRUE;
+
+    if (pay->qtable_interval > 0) {
+      send_qtables = gst_rtp_jpeg_pay_update_qtables (pay, tables, info);
+      jpeg_header.q = pay->cached_q;
+      /* the receiver uses the tables it got before for this Q */
+      if (!send_qtables)
+        quant_data_size = 0;
+    }
     quant_header.length = g_htons (quant_data_size);
     quant_data_size += sizeof (quant_header);
   }
@@ -863,7 +937,7 @@ gst_rtp_jpeg_pay_handle_buffer (GstRTPBasePayload * basepayload,
       payload += sizeof (quant_header);
 
       /* copy the quant tables for luma and chrominance */
-      for (i = 0; i < 2; i++) {
+      for (i = 0; send_qtables && i < 2; i++) {
         guint qsize;
         guint qt;
 
@@ -957,6 +1031,9 @@ gst_rtp_jpeg_pay_set_property (GObject * object, guint prop_id,
       rtpjpegpay->type = g_value_get_int (value);
       GST_DEBUG_OBJECT (object, "type = %d", rtpjpegpay->type);
       break;
+    case PROP_QTABLE_INTERVAL:
+      rtpjpegpay->qtable_interval = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -978,6 +1055,9 @@ gst_rtp_jpeg_pay_get_property (GObject * object, guint prop_id,
     case PROP_JPEG_TYPE:
       g_value_set_int (value, rtpjpegpay->type);
       break;
+    case PROP_QTABLE_INTERVAL:
+      g_value_set_uint (value, rtpjpegpay->qtable_interval);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
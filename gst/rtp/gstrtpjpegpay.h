@@ -48,6 +48,13 @@ struct _GstRtpJPEGPay
   gint width;
 
   guint8 quant;
+
+  /* quant tables sent with cached_q, see qtable-interval */
+  guint qtable_interval;
+  guint qtable_frames;
+  guint8 cached_q;
+  guint8 cached_qtables[256];
+  guint cached_qtables_size;
 };
 
 struct _GstRtpJPEGPayClass
@@ -34,11 +34,15 @@ enum
 };
 
 #define DEFAULT_SKIP_FIRST_BYTES	0
+#define DEFAULT_AGGREGATE_PACKETS	1
+#define DEFAULT_AGGREGATE_TIME		0
 
 enum
 {
   PROP_0,
-  PROP_SKIP_FIRST_BYTES
+  PROP_SKIP_FIRST_BYTES,
+  PROP_AGGREGATE_PACKETS,
+  PROP_AGGREGATE_TIME
 };
 
 static GstStaticPadTemplate gst_rtp_mp2t_depay_src_template =
@@ -75,6 +79,10 @@ static gboolean gst_rtp_mp2t_depay_setcaps (GstRTPBaseDepayload * depayload,
     GstCaps * caps);
 static GstBuffer *gst_rtp_mp2t_depay_process (GstRTPBaseDepayload * depayload,
     GstBuffer * buf);
+static gboolean gst_rtp_mp2t_depay_handle_event (GstRTPBaseDepayload *
+    depayload, GstEvent * event);
+static GstStateChangeReturn gst_rtp_mp2t_depay_change_state (GstElement *
+    element, GstStateChange transition);
 
 static void gst_rtp_mp2t_depay_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -94,6 +102,9 @@ gst_rtp_mp2t_depay_class_init (GstRtpMP2TDepayClass * klass)
 
   gstrtpbasedepayload_class->process = gst_rtp_mp2t_depay_process;
   gstrtpbasedepayload_class->set_caps = gst_rtp_mp2t_depay_setcaps;
+  gstrtpbasedepayload_class->handle_event = gst_rtp_mp2t_depay_handle_event;
+
+  gstelement_class->change_state = gst_rtp_mp2t_depay_change_state;
 
   gobject_class->set_property = gst_rtp_mp2t_depay_set_property;
   gobject_class->get_property = gst_rtp_mp2t_depay_get_property;
@@ -115,12 +126,66 @@ gst_rtp_mp2t_depay_class_init (GstRtpMP2TDepayClass * klass)
           "The amount of bytes that need to be skipped at the beginning of the payload",
           0, G_MAXUINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRtpMP2TDepay:aggregate-packets:
+   *
+   * Push the payloads of this many consecutive RTP packets as one buffer.
+   * The buffer references the memory of the RTP packets, so fewer packets
+   * are aggregated when the buffer would otherwise have too many memory
+   * blocks.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_AGGREGATE_PACKETS,
+      g_param_spec_uint ("aggregate-packets", "Aggregate packets",
+          "Maximum number of RTP packets to push as one buffer "
+          "(1 = no aggregation)", 1, G_MAXUINT, DEFAULT_AGGREGATE_PACKETS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpMP2TDepay:aggregate-time:
+   *
+   * Push the aggregated payloads once the RTP packets span this amount of
+   * time, even if #GstRtpMP2TDepay:aggregate-packets was not reached.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_AGGREGATE_TIME,
+      g_param_spec_uint64 ("aggregate-time", "Aggregate time",
+          "Maximum time in nanoseconds spanned by the RTP packets pushed as "
+          "one buffer (0 = no limit)", 0, G_MAXUINT64, DEFAULT_AGGREGATE_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_rtp_mp2t_depay_init (GstRtpMP2TDepay * rtpmp2tdepay)
 {
   rtpmp2tdepay->skip_first_bytes = DEFAULT_SKIP_FIRST_BYTES;
+  rtpmp2tdepay->aggregate_packets = DEFAULT_AGGREGATE_PACKETS;
+  rtpmp2tdepay->aggregate_time = DEFAULT_AGGREGATE_TIME;
+}
+
+static void
+gst_rtp_mp2t_depay_reset (GstRtpMP2TDepay * rtpmp2tdepay)
+{
+  gst_buffer_replace (&rtpmp2tdepay->pending, NULL);
+  rtpmp2tdepay->pending_packets = 0;
+}
+
+/* hands out the aggregated payloads, or NULL when nothing is pending */
+static GstBuffer *
+gst_rtp_mp2t_depay_take_pending (GstRtpMP2TDepay * rtpmp2tdepay)
+{
+  GstBuffer *outbuf = rtpmp2tdepay->pending;
+
+  if (outbuf)
+    GST_DEBUG_OBJECT (rtpmp2tdepay, "pushing %u packets, %" G_GSIZE_FORMAT
+        " bytes", rtpmp2tdepay->pending_packets, gst_buffer_get_size (outbuf));
+
+  rtpmp2tdepay->pending = NULL;
+  rtpmp2tdepay->pending_packets = 0;
+
+  return outbuf;
 }
 
 static gboolean
@@ -145,6 +210,53 @@ gst_rtp_mp2t_depay_setcaps (GstRTPBaseDepayload * depayload, GstCaps * caps)
   return res;
 }
 
+/* appends the payload @outbuf to the pending aggregate. The payloads are
+ * whole TS packets so the aggregate stays 188 byte aligned. Returns the
+ * aggregate once it is complete. */
+static GstBuffer *
+gst_rtp_mp2t_depay_aggregate (GstRtpMP2TDepay * rtpmp2tdepay,
+    GstBuffer * outbuf)
+{
+  GstRTPBaseDepayload *depayload = GST_RTP_BASE_DEPAYLOAD (rtpmp2tdepay);
+  GstBuffer *pending = rtpmp2tdepay->pending;
+  GstClockTime pts;
+
+  if (outbuf == NULL)
+    return NULL;
+
+  pts = GST_BUFFER_PTS (outbuf);
+
+  if (pending) {
+    /* push what we have first if this payload follows a gap, or when
+     * appending would make the buffer merge, and thus copy, its memory */
+    if (GST_BUFFER_IS_DISCONT (outbuf) ||
+        gst_buffer_n_memory (pending) + gst_buffer_n_memory (outbuf) >
+        gst_buffer_get_max_memory ()) {
+      gst_rtp_base_depayload_push (depayload,
+          gst_rtp_mp2t_depay_take_pending (rtpmp2tdepay));
+      pending = NULL;
+    }
+  }
+
+  if (pending) {
+    rtpmp2tdepay->pending = gst_buffer_append (pending, outbuf);
+  } else {
+    rtpmp2tdepay->pending = outbuf;
+    rtpmp2tdepay->pending_pts = pts;
+  }
+  rtpmp2tdepay->pending_packets++;
+
+  if (rtpmp2tdepay->pending_packets >= rtpmp2tdepay->aggregate_packets)
+    return gst_rtp_mp2t_depay_take_pending (rtpmp2tdepay);
+
+  if (rtpmp2tdepay->aggregate_time > 0 && GST_CLOCK_TIME_IS_VALID (pts) &&
+      GST_CLOCK_TIME_IS_VALID (rtpmp2tdepay->pending_pts) &&
+      pts >= rtpmp2tdepay->pending_pts + rtpmp2tdepay->aggregate_time)
+    return gst_rtp_mp2t_depay_take_pending (rtpmp2tdepay);
+
+  return NULL;
+}
+
 static GstBuffer *
 gst_rtp_mp2t_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
 {
@@ -183,6 +295,10 @@ gst_rtp_mp2t_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
       rtpmp2tdepay->skip_first_bytes, payload_len);
 
   gst_rtp_buffer_unmap (&rtp);
+
+  if (rtpmp2tdepay->aggregate_packets > 1 || rtpmp2tdepay->aggregate_time > 0)
+    return gst_rtp_mp2t_depay_aggregate (rtpmp2tdepay, outbuf);
+
   if (outbuf)
     GST_DEBUG ("gst_rtp_mp2t_depay_chain: pushing buffer of size %"
         G_GSIZE_FORMAT, gst_buffer_get_size (outbuf));
@@ -199,6 +315,59 @@ empty_packet:
   }
 }
 
+static gboolean
+gst_rtp_mp2t_depay_handle_event (GstRTPBaseDepayload * depayload,
+    GstEvent * event)
+{
+  GstRtpMP2TDepay *rtpmp2tdepay;
+
+  rtpmp2tdepay = GST_RTP_MP2T_DEPAY (depayload);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_STOP:
+      gst_rtp_mp2t_depay_reset (rtpmp2tdepay);
+      break;
+    case GST_EVENT_EOS:
+    {
+      GstBuffer *outbuf;
+
+      /* push the last partial aggregate */
+      if ((outbuf = gst_rtp_mp2t_depay_take_pending (rtpmp2tdepay)))
+        gst_rtp_base_depayload_push (depayload, outbuf);
+      break;
+    }
+    default:
+      break;
+  }
+
+  return
+      GST_RTP_BASE_DEPAYLOAD_CLASS (gst_rtp_mp2t_depay_parent_class)->
+      handle_event (depayload, event);
+}
+
+static GstStateChangeReturn
+gst_rtp_mp2t_depay_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstRtpMP2TDepay *rtpmp2tdepay;
+  GstStateChangeReturn ret;
+
+  rtpmp2tdepay = GST_RTP_MP2T_DEPAY (element);
+
+  ret =
+      GST_ELEMENT_CLASS (gst_rtp_mp2t_depay_parent_class)->change_state
+      (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_rtp_mp2t_depay_reset (rtpmp2tdepay);
+      break;
+    default:
+      break;
+  }
+  return ret;
+}
+
 static void
 gst_rtp_mp2t_depay_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -211,6 +380,12 @@ gst_rtp_mp2t_depay_set_property (GObject * object, guint prop_id,
     case PROP_SKIP_FIRST_BYTES:
       rtpmp2tdepay->skip_first_bytes = g_value_get_uint (value);
       break;
+    case PROP_AGGREGATE_PACKETS:
+      rtpmp2tdepay->aggregate_packets = g_value_get_uint (value);
+      break;
+    case PROP_AGGREGATE_TIME:
+      rtpmp2tdepay->aggregate_time = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -229,6 +404,12 @@ gst_rtp_mp2t_depay_get_property (GObject * object, guint prop_id,
     case PROP_SKIP_FIRST_BYTES:
       g_value_set_uint (value, rtpmp2tdepay->skip_first_bytes);
       break;
+    case PROP_AGGREGATE_PACKETS:
+      g_value_set_uint (value, rtpmp2tdepay->aggregate_packets);
+      break;
+    case PROP_AGGREGATE_TIME:
+      g_value_set_uint64 (value, rtpmp2tdepay->aggregate_time);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
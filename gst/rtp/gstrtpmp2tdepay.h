@@ -44,6 +44,14 @@ struct _GstRtpMP2TDepay
   GstRTPBaseDepayload depayload;
 
   guint8 skip_first_bytes;
+
+  guint aggregate_packets;
+  GstClockTime aggregate_time;
+
+  /* payloads waiting to be pushed as one buffer */
+  GstBuffer *pending;
+  GstClockTime pending_pts;
+  guint pending_packets;
 };
 
 struct _GstRtpMP2TDepayClass
@@ -120,16 +120,17 @@ gst_rtp_mp2t_pay_flush (GstRTPMP2TPay * rtpmp2tpay)
   guint avail, mtu;
   GstFlowReturn ret = GST_FLOW_OK;
   GstBuffer *outbuf;
+  GstBufferList *list = NULL;
 
   avail = gst_adapter_available (rtpmp2tpay->adapter);
 
   mtu = GST_RTP_BASE_PAYLOAD_MTU (rtpmp2tpay);
 
-  while (avail > 0 && (ret == GST_FLOW_OK)) {
+  while (avail > 0) {
     guint towrite;
     guint payload_len;
     guint packet_len;
-    GstBuffer *paybuf;
+    GList *paybufs, *walk;
 
     /* this will be the total length of the packet */
     packet_len = gst_rtp_buffer_calc_packet_len (avail, 0, 0);
@@ -148,18 +149,31 @@ gst_rtp_mp2t_pay_flush (GstRTPMP2TPay * rtpmp2tpay)
     /* create buffer to hold the payload */
     outbuf = gst_rtp_buffer_new_allocate (0, 0, 0);
 
-    /* get payload */
-    paybuf = gst_adapter_take_buffer_fast (rtpmp2tpay->adapter, payload_len);
-    outbuf = gst_buffer_append (outbuf, paybuf);
+    /* get payload, appending the memory of the input buffers instead of
+     * copying when the payload spans several of them */
+    paybufs = gst_adapter_take_list (rtpmp2tpay->adapter, payload_len);
+    for (walk = paybufs; walk; walk = g_list_next (walk))
+      outbuf = gst_buffer_append (outbuf, walk->data);
+    g_list_free (paybufs);
     avail -= payload_len;
 
     GST_BUFFER_TIMESTAMP (outbuf) = rtpmp2tpay->first_ts;
     GST_BUFFER_DURATION (outbuf) = rtpmp2tpay->duration;
 
-    GST_DEBUG_OBJECT (rtpmp2tpay, "pushing buffer of size %u",
+    GST_DEBUG_OBJECT (rtpmp2tpay, "queueing buffer of size %u",
         (guint) gst_buffer_get_size (outbuf));
 
-    ret = gst_rtp_base_payload_push (GST_RTP_BASE_PAYLOAD (rtpmp2tpay), outbuf);
+    if (list == NULL)
+      list = gst_buffer_list_new_sized (avail / payload_len + 1);
+    gst_buffer_list_add (list, outbuf);
+  }
+
+  /* all packets share the timestamp of the first data, push them at once */
+  if (list) {
+    GST_DEBUG_OBJECT (rtpmp2tpay, "pushing list of %u buffers",
+        gst_buffer_list_length (list));
+    ret = gst_rtp_base_payload_push_list (GST_RTP_BASE_PAYLOAD (rtpmp2tpay),
+        list);
   }
 
   return ret;
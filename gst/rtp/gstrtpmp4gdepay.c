@@ -270,6 +270,9 @@ gst_rtp_mp4g_depay_setcaps (GstRTPBaseDepayload * depayload, GstCaps * caps)
       gst_rtp_mp4g_depay_parse_int (structure, "constantduration", 0);
   rtpmp4gdepay->maxDisplacement =
       gst_rtp_mp4g_depay_parse_int (structure, "maxdisplacement", 0);
+  /* only an interleaving sender needs the reorder queue. Senders that don't
+   * signal it are switched over when they turn out to use index deltas */
+  rtpmp4gdepay->interleaved = rtpmp4gdepay->maxDisplacement > 0;
 
 
   /* get config string */
@@ -615,6 +618,12 @@ gst_rtp_mp4g_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
           AU_index_delta =
               gst_bs_parse_read (&bs, rtpmp4gdepay->indexdeltalength);
           AU_index += AU_index_delta + 1;
+
+          if (G_UNLIKELY (AU_index_delta != 0 && !rtpmp4gdepay->interleaved)) {
+            GST_DEBUG_OBJECT (rtpmp4gdepay, "AU index delta %u, interleaving",
+                AU_index_delta);
+            rtpmp4gdepay->interleaved = TRUE;
+          }
         }
         /* keep track of highest AU_index */
         if (rtpmp4gdepay->max_AU_index == -1
@@ -647,19 +656,22 @@ gst_rtp_mp4g_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
         if (AU_size > payload_AU_size)
           AU_size = payload_AU_size;
 
-        /* collect stuff in the adapter, strip header from payload and push in
-         * the adapter */
+        /* strip header from payload */
         outbuf =
             gst_rtp_buffer_get_payload_subbuffer (&rtp, payload_AU, AU_size);
-        gst_adapter_push (rtpmp4gdepay->adapter, outbuf);
 
         if (M) {
           guint avail;
 
-          /* packet is complete, flush */
+          /* packet is complete. A complete AU in this RTP packet is pushed as
+           * it is, fragments collected in the adapter are appended without
+           * copying */
           avail = gst_adapter_available (rtpmp4gdepay->adapter);
-
-          outbuf = gst_adapter_take_buffer (rtpmp4gdepay->adapter, avail);
+          if (avail > 0) {
+            gst_adapter_push (rtpmp4gdepay->adapter, outbuf);
+            outbuf = gst_adapter_take_buffer_fast (rtpmp4gdepay->adapter,
+                avail + AU_size);
+          }
 
           /* copy some of the fields we calculated above on the buffer. We also
            * copy the AU_index so that we can sort the packets in our queue. */
@@ -674,8 +686,16 @@ gst_rtp_mp4g_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
               "pushing buffer of size %" G_GSIZE_FORMAT,
               gst_buffer_get_size (outbuf));
 
-          gst_rtp_mp4g_depay_queue (rtpmp4gdepay, outbuf);
-
+          if (rtpmp4gdepay->interleaved) {
+            gst_rtp_mp4g_depay_queue (rtpmp4gdepay, outbuf);
+          } else {
+            /* AUs arrive in order, nothing to reorder */
+            gst_rtp_base_depayload_push (depayload, outbuf);
+            rtpmp4gdepay->next_AU_index = AU_index + 1;
+          }
+        } else {
+          /* collect fragments in the adapter */
+          gst_adapter_push (rtpmp4gdepay->adapter, outbuf);
         }
         payload_AU += AU_size;
         payload_AU_size -= AU_size;
@@ -67,6 +67,7 @@ struct _GstRtpMP4GDepay
   guint32 prev_rtptime;
   guint prev_AU_num;
 
+  gboolean interleaved;
   GQueue *packets;
   
   GstAdapter *adapter;
@@ -30,6 +30,8 @@
 #define RTP_SBC_PAYLOAD_HEADER_SIZE 1
 #define DEFAULT_MIN_FRAMES 0
 #define RTP_SBC_HEADER_TOTAL (12 + RTP_SBC_PAYLOAD_HEADER_SIZE)
+/* the frame count in the payload header has 4 bits */
+#define RTP_SBC_MAX_FRAMES 15
 
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
 
@@ -165,6 +167,7 @@ gst_rtp_sbc_pay_flush_buffers (GstRtpSBCPay * sbcpay)
   guint frame_count;
   guint payload_length;
   struct rtp_payload *payload;
+  GList *paybufs, *walk;
 
   if (sbcpay->frame_length == 0) {
     GST_ERROR_OBJECT (sbcpay, "Frame length is 0");
@@ -179,30 +182,32 @@ gst_rtp_sbc_pay_flush_buffers (GstRtpSBCPay * sbcpay)
 
   max_payload = MIN (max_payload, available);
   frame_count = max_payload / sbcpay->frame_length;
+  frame_count = MIN (frame_count, RTP_SBC_MAX_FRAMES);
   payload_length = frame_count * sbcpay->frame_length;
   if (payload_length == 0)      /* Nothing to send */
     return GST_FLOW_OK;
 
-  outbuf = gst_rtp_buffer_new_allocate (payload_length +
-      RTP_SBC_PAYLOAD_HEADER_SIZE, 0, 0);
+  outbuf = gst_rtp_buffer_new_allocate (RTP_SBC_PAYLOAD_HEADER_SIZE, 0, 0);
 
   /* get payload */
   gst_rtp_buffer_map (outbuf, GST_MAP_WRITE, &rtp);
 
   gst_rtp_buffer_set_payload_type (&rtp, GST_RTP_BASE_PAYLOAD_PT (sbcpay));
 
-  /* write header and copy data into payload */
+  /* write header */
   payload_data = gst_rtp_buffer_get_payload (&rtp);
   payload = (struct rtp_payload *) payload_data;
   memset (payload, 0, sizeof (struct rtp_payload));
   payload->frame_count = frame_count;
 
-  gst_adapter_copy (sbcpay->adapter, payload_data +
-      RTP_SBC_PAYLOAD_HEADER_SIZE, 0, payload_length);
-
   gst_rtp_buffer_unmap (&rtp);
 
-  gst_adapter_flush (sbcpay->adapter, payload_length);
+  /* append the frames without copying them, multi-frame buffers from
+   * sbcparse usually make up the whole payload */
+  paybufs = gst_adapter_take_list (sbcpay->adapter, payload_length);
+  for (walk = paybufs; walk; walk = g_list_next (walk))
+    outbuf = gst_buffer_append (outbuf, walk->data);
+  g_list_free (paybufs);
 
   /* FIXME: what about duration? */
   GST_BUFFER_TIMESTAMP (outbuf) = sbcpay->timestamp;
@@ -215,7 +220,8 @@ static GstFlowReturn
 gst_rtp_sbc_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
 {
   GstRtpSBCPay *sbcpay;
-  guint available;
+  guint available, prev;
+  GstFlowReturn ret = GST_FLOW_OK;
 
   /* FIXME check for negotiation */
 
@@ -224,13 +230,19 @@ gst_rtp_sbc_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
 
   gst_adapter_push (sbcpay->adapter, buffer);
 
+  /* a multi-frame input buffer can fill several packets */
   available = gst_adapter_available (sbcpay->adapter);
-  if (available + RTP_SBC_HEADER_TOTAL >=
-      GST_RTP_BASE_PAYLOAD_MTU (sbcpay) ||
-      (available > (sbcpay->min_frames * sbcpay->frame_length)))
-    return gst_rtp_sbc_pay_flush_buffers (sbcpay);
+  while (ret == GST_FLOW_OK && (available + RTP_SBC_HEADER_TOTAL >=
+          GST_RTP_BASE_PAYLOAD_MTU (sbcpay) ||
+          (available > (sbcpay->min_frames * sbcpay->frame_length)))) {
+    prev = available;
+    ret = gst_rtp_sbc_pay_flush_buffers (sbcpay);
+    available = gst_adapter_available (sbcpay->adapter);
+    if (available == prev)
+      break;
+  }
 
-  return GST_FLOW_OK;
+  return ret;
 }
 
 static gboolean
@@ -432,6 +432,19 @@ gst_rtp_theora_pay_finish_headers (GstRTPBasePayload * basepayload)
     gst_buffer_unmap (buf, &map);
   }
 
+  /* the same headers as before, the packed configuration and the caps made
+   * from it are still valid */
+  if (rtptheorapay->config_data &&
+      rtptheorapay->payload_ident == fnv1_hash_32_to_24 (ident) &&
+      rtptheorapay->config_size == size + length - 4 - 3 - 2) {
+    GST_DEBUG_OBJECT (rtptheorapay, "headers unchanged, ident 0x%08x",
+        rtptheorapay->payload_ident);
+    g_list_free_full (rtptheorapay->headers, (GDestroyNotify) gst_buffer_unref);
+    rtptheorapay->headers = NULL;
+    rtptheorapay->need_headers = FALSE;
+    return TRUE;
+  }
+
   /* packet length is header size + packet length */
   configlen = size + length;
   config = data = g_malloc (configlen);
@@ -425,6 +425,19 @@ gst_rtp_vorbis_pay_finish_headers (GstRTPBasePayload * basepayload)
     gst_buffer_unmap (buf, &map);
   }
 
+  /* the same headers as before, the packed configuration and the caps made
+   * from it are still valid */
+  if (rtpvorbispay->config_data &&
+      rtpvorbispay->payload_ident == fnv1_hash_32_to_24 (ident) &&
+      rtpvorbispay->config_size == size + length - 4 - 3 - 2) {
+    GST_DEBUG_OBJECT (rtpvorbispay, "headers unchanged, ident 0x%08x",
+        rtpvorbispay->payload_ident);
+    g_list_free_full (rtpvorbispay->headers, (GDestroyNotify) gst_buffer_unref);
+    rtpvorbispay->headers = NULL;
+    rtpvorbispay->need_headers = FALSE;
+    return TRUE;
+  }
+
   /* packet length is header size + packet length */
   configlen = size + length;
   config = data = g_malloc (configlen);
@@ -27,6 +27,11 @@
 #include <stdlib.h>
 #include "gstrtpvrawdepay.h"
 
+#if defined(__SSE2__)
+#define HAVE_RTP_VRAW_DEPAY_SSE2 1
+#include <emmintrin.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (rtpvrawdepay_debug);
 #define GST_CAT_DEFAULT (rtpvrawdepay_debug)
 
@@ -99,6 +104,7 @@ static void
 gst_rtp_vraw_depay_reset (GstRtpVRawDepay * rtpvrawdepay)
 {
   if (rtpvrawdepay->outbuf) {
+    gst_video_frame_unmap (&rtpvrawdepay->frame);
     gst_buffer_unref (rtpvrawdepay->outbuf);
     rtpvrawdepay->outbuf = NULL;
   }
@@ -305,6 +311,63 @@ no_bufferpool:
   }
 }
 
+/* unpacks @groups 4:2:0 pgroups Y00-Y01-Y10-Y11-Cb00-Cr00 into two luma
+ * lines and the chroma lines */
+static void
+gst_rtp_vraw_depay_unpack_i420 (const guint8 * p, guint8 * y1, guint8 * y2,
+    guint8 * u, guint8 * v, guint groups)
+{
+  guint i = 0;
+
+#ifdef HAVE_RTP_VRAW_DEPAY_SSE2
+  /* 8 pgroups per iteration. Each pgroup is read with an 8 byte load that
+   * reaches 2 bytes into the next pgroup, so the last pgroup is always left
+   * to the scalar loop */
+  for (; i + 8 < groups; i += 8) {
+    __m128i g01, g23, g45, g67, lo, hi, c;
+    const __m128i mask = _mm_set1_epi16 (0x00ff);
+    const guint8 *q = p + 6 * i;
+
+    /* 16 bit words of Y00-Y01, Y10-Y11 and Cb-Cr of two pgroups each */
+    g01 = _mm_unpacklo_epi16 (_mm_loadl_epi64 ((const __m128i *) q),
+        _mm_loadl_epi64 ((const __m128i *) (q + 6)));
+    g23 = _mm_unpacklo_epi16 (_mm_loadl_epi64 ((const __m128i *) (q + 12)),
+        _mm_loadl_epi64 ((const __m128i *) (q + 18)));
+    g45 = _mm_unpacklo_epi16 (_mm_loadl_epi64 ((const __m128i *) (q + 24)),
+        _mm_loadl_epi64 ((const __m128i *) (q + 30)));
+    g67 = _mm_unpacklo_epi16 (_mm_loadl_epi64 ((const __m128i *) (q + 36)),
+        _mm_loadl_epi64 ((const __m128i *) (q + 42)));
+
+    lo = _mm_unpacklo_epi32 (g01, g23);
+    hi = _mm_unpacklo_epi32 (g45, g67);
+    _mm_storeu_si128 ((__m128i *) (y1 + 2 * i), _mm_unpacklo_epi64 (lo, hi));
+    _mm_storeu_si128 ((__m128i *) (y2 + 2 * i), _mm_unpackhi_epi64 (lo, hi));
+
+    c = _mm_unpacklo_epi64 (_mm_unpackhi_epi32 (g01, g23),
+        _mm_unpackhi_epi32 (g45, g67));
+    lo = _mm_and_si128 (c, mask);
+    hi = _mm_srli_epi16 (c, 8);
+    _mm_storel_epi64 ((__m128i *) (u + i), _mm_packus_epi16 (lo, lo));
+    _mm_storel_epi64 ((__m128i *) (v + i), _mm_packus_epi16 (hi, hi));
+  }
+#endif
+
+  p += 6 * i;
+  y1 += 2 * i;
+  y2 += 2 * i;
+  u += i;
+  v += i;
+  for (; i < groups; i++) {
+    *y1++ = p[0];
+    *y1++ = p[1];
+    *y2++ = p[2];
+    *y2++ = p[3];
+    *u++ = p[4];
+    *v++ = p[5];
+    p += 6;
+  }
+}
+
 static GstBuffer *
 gst_rtp_vraw_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
 {
@@ -314,7 +377,7 @@ gst_rtp_vraw_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
   guint cont, ystride, uvstride, pgroup, payload_len;
   gint width, height, xinc, yinc;
   GstRTPBuffer rtp = { NULL };
-  GstVideoFrame frame;
+  GstVideoFrame *frame;
   gboolean marker;
   GstBuffer *outbuf = NULL;
 
@@ -331,6 +394,7 @@ gst_rtp_vraw_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
     GST_LOG_OBJECT (depayload, "new frame with timestamp %u", timestamp);
     /* new timestamp, flush old buffer and create new output buffer */
     if (rtpvrawdepay->outbuf) {
+      gst_video_frame_unmap (&rtpvrawdepay->frame);
       gst_rtp_base_depayload_push (depayload, rtpvrawdepay->outbuf);
       rtpvrawdepay->outbuf = NULL;
     }
@@ -352,21 +416,27 @@ gst_rtp_vraw_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
     /* clear timestamp from alloc... */
     GST_BUFFER_TIMESTAMP (outbuf) = -1;
 
+    /* the frame stays mapped until it is complete so that the planes don't
+     * need to be looked up again for every packet */
+    if (!gst_video_frame_map (&rtpvrawdepay->frame, &rtpvrawdepay->vinfo,
+            outbuf, GST_MAP_WRITE)) {
+      gst_buffer_unref (outbuf);
+      goto invalid_frame;
+    }
+
     rtpvrawdepay->outbuf = outbuf;
     rtpvrawdepay->timestamp = timestamp;
   }
 
-  if (!gst_video_frame_map (&frame, &rtpvrawdepay->vinfo, rtpvrawdepay->outbuf,
-          GST_MAP_WRITE))
-    goto invalid_frame;
+  frame = &rtpvrawdepay->frame;
 
   /* get pointer and strides of the planes */
-  yp = GST_VIDEO_FRAME_COMP_DATA (&frame, 0);
-  up = GST_VIDEO_FRAME_COMP_DATA (&frame, 1);
-  vp = GST_VIDEO_FRAME_COMP_DATA (&frame, 2);
+  yp = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  up = GST_VIDEO_FRAME_COMP_DATA (frame, 1);
+  vp = GST_VIDEO_FRAME_COMP_DATA (frame, 2);
 
-  ystride = GST_VIDEO_FRAME_COMP_STRIDE (&frame, 0);
-  uvstride = GST_VIDEO_FRAME_COMP_STRIDE (&frame, 1);
+  ystride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+  uvstride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 1);
 
   pgroup = rtpvrawdepay->pgroup;
   width = GST_VIDEO_INFO_WIDTH (&rtpvrawdepay->vinfo);
@@ -477,28 +547,15 @@ gst_rtp_vraw_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
       }
       case GST_VIDEO_FORMAT_I420:
       {
-        gint i;
         guint uvoff;
-        guint8 *yd1p, *yd2p, *udp, *vdp, *p;
+        guint8 *yd1p;
 
         yd1p = yp + (line * ystride) + (offs);
-        yd2p = yd1p + ystride;
         uvoff = (line / yinc * uvstride) + (offs / xinc);
 
-        udp = up + uvoff;
-        vdp = vp + uvoff;
-        p = payload;
-
         /* line 0/1: Y00-Y01-Y10-Y11-Cb00-Cr00 Y02-Y03-Y12-Y13-Cb01-Cr01 ...  */
-        for (i = 0; i < plen; i += pgroup) {
-          *yd1p++ = p[0];
-          *yd1p++ = p[1];
-          *yd2p++ = p[2];
-          *yd2p++ = p[3];
-          *udp++ = p[4];
-          *vdp++ = p[5];
-          p += pgroup;
-        }
+        gst_rtp_vraw_depay_unpack_i420 (payload, yd1p, yd1p + ystride,
+            up + uvoff, vp + uvoff, plen / pgroup);
         break;
       }
       case GST_VIDEO_FORMAT_Y41B:
@@ -539,12 +596,12 @@ gst_rtp_vraw_depay_process (GstRTPBaseDepayload * depayload, GstBuffer * buf)
     payload_len -= length;
   }
 
-  gst_video_frame_unmap (&frame);
   marker = gst_rtp_buffer_get_marker (&rtp);
   gst_rtp_buffer_unmap (&rtp);
 
   if (marker) {
     GST_LOG_OBJECT (depayload, "marker, flushing frame");
+    gst_video_frame_unmap (&rtpvrawdepay->frame);
     outbuf = rtpvrawdepay->outbuf;
     rtpvrawdepay->outbuf = NULL;
     rtpvrawdepay->timestamp = -1;
@@ -556,7 +613,6 @@ unknown_sampling:
   {
     GST_ELEMENT_ERROR (depayload, STREAM, FORMAT,
         (NULL), ("unimplemented sampling"));
-    gst_video_frame_unmap (&frame);
     gst_rtp_buffer_unmap (&rtp);
     return NULL;
   }
@@ -575,14 +631,12 @@ invalid_frame:
 wrong_length:
   {
     GST_WARNING_OBJECT (depayload, "length not multiple of pgroup");
-    gst_video_frame_unmap (&frame);
     gst_rtp_buffer_unmap (&rtp);
     return NULL;
   }
 short_packet:
   {
     GST_WARNING_OBJECT (depayload, "short packet");
-    gst_video_frame_unmap (&frame);
     gst_rtp_buffer_unmap (&rtp);
     return NULL;
   }
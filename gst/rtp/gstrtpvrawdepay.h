@@ -50,6 +50,7 @@ struct _GstRtpVRawDepay
   GstVideoInfo vinfo;
 
   GstBuffer *outbuf;
+  GstVideoFrame frame;
   guint32 timestamp;
   guint outsize;
 
@@ -27,9 +27,22 @@
 
 #include "gstrtpvrawpay.h"
 
+#if defined(__SSE2__)
+#define HAVE_RTP_VRAW_PAY_SSE2 1
+#include <emmintrin.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (rtpvrawpay_debug);
 #define GST_CAT_DEFAULT (rtpvrawpay_debug)
 
+enum
+{
+  PROP_0,
+  PROP_N_THREADS
+};
+
+#define DEFAULT_N_THREADS 1
+
 static GstStaticPadTemplate gst_rtp_vraw_pay_sink_template =
     GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -70,6 +83,11 @@ static gboolean gst_rtp_vraw_pay_setcaps (GstRTPBasePayload * payload,
     GstCaps * caps);
 static GstFlowReturn gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload *
     payload, GstBuffer * buffer);
+static void gst_rtp_vraw_pay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_rtp_vraw_pay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static void gst_rtp_vraw_pay_finalize (GObject * object);
 
 G_DEFINE_TYPE (GstRtpVRawPay, gst_rtp_vraw_pay, GST_TYPE_RTP_BASE_PAYLOAD)
 
@@ -77,10 +95,31 @@ G_DEFINE_TYPE (GstRtpVRawPay, gst_rtp_vraw_pay, GST_TYPE_RTP_BASE_PAYLOAD)
 {
   GstRTPBasePayloadClass *gstrtpbasepayload_class;
   GstElementClass *gstelement_class;
+  GObjectClass *gobject_class;
 
+  gobject_class = (GObjectClass *) klass;
   gstelement_class = (GstElementClass *) klass;
   gstrtpbasepayload_class = (GstRTPBasePayloadClass *) klass;
 
+  gobject_class->set_property = gst_rtp_vraw_pay_set_property;
+  gobject_class->get_property = gst_rtp_vraw_pay_get_property;
+  gobject_class->finalize = gst_rtp_vraw_pay_finalize;
+
+  /**
+   * GstRtpVRawPay:n-threads:
+   *
+   * Maximum number of threads used to fill the packets of a frame, 0 for
+   * one per processor. The packets of each field are pushed downstream as
+   * one buffer list.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Maximum number of threads used to packetize a frame "
+          "(0 = number of processors)", 0, G_MAXUINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstrtpbasepayload_class->set_caps = gst_rtp_vraw_pay_setcaps;
   gstrtpbasepayload_class->handle_buffer = gst_rtp_vraw_pay_handle_buffer;
 
@@ -101,6 +140,54 @@ G_DEFINE_TYPE (GstRtpVRawPay, gst_rtp_vraw_pay, GST_TYPE_RTP_BASE_PAYLOAD)
 static void
 gst_rtp_vraw_pay_init (GstRtpVRawPay * rtpvrawpay)
 {
+  rtpvrawpay->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&rtpvrawpay->slice_lock);
+  g_cond_init (&rtpvrawpay->slice_cond);
+}
+
+static void
+gst_rtp_vraw_pay_finalize (GObject * object)
+{
+  GstRtpVRawPay *rtpvrawpay = GST_RTP_VRAW_PAY (object);
+
+  if (rtpvrawpay->slice_pool)
+    g_thread_pool_free (rtpvrawpay->slice_pool, FALSE, TRUE);
+  g_mutex_clear (&rtpvrawpay->slice_lock);
+  g_cond_clear (&rtpvrawpay->slice_cond);
+
+  G_OBJECT_CLASS (gst_rtp_vraw_pay_parent_class)->finalize (object);
+}
+
+static void
+gst_rtp_vraw_pay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtpVRawPay *rtpvrawpay = GST_RTP_VRAW_PAY (object);
+
+  switch (prop_id) {
+    case PROP_N_THREADS:
+      rtpvrawpay->n_threads = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtp_vraw_pay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtpVRawPay *rtpvrawpay = GST_RTP_VRAW_PAY (object);
+
+  switch (prop_id) {
+    case PROP_N_THREADS:
+      g_value_set_uint (value, rtpvrawpay->n_threads);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 static gboolean
@@ -234,14 +321,268 @@ unknown_format:
   }
 }
 
+/* packs @groups 4:2:0 pgroups Y00-Y01-Y10-Y11-Cb00-Cr00 from two luma lines
+ * and the chroma lines */
+static void
+gst_rtp_vraw_pay_pack_i420 (guint8 * out, const guint8 * y1,
+    const guint8 * y2, const guint8 * u, const guint8 * v, guint groups)
+{
+  guint i = 0;
+
+#ifdef HAVE_RTP_VRAW_PAY_SSE2
+  /* 8 pgroups per iteration. Each pgroup is written with an 8 byte store of
+   * which the last 2 bytes are overwritten by the next pgroup, so the last
+   * pgroup is always left to the scalar loop */
+  for (; i + 8 < groups; i += 8) {
+    __m128i a, b, c, ab, cz, q;
+    const __m128i zero = _mm_setzero_si128 ();
+    guint8 *o = out + 6 * i;
+
+    a = _mm_loadu_si128 ((const __m128i *) (y1 + 2 * i));
+    b = _mm_loadu_si128 ((const __m128i *) (y2 + 2 * i));
+    c = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *) (u + i)),
+        _mm_loadl_epi64 ((const __m128i *) (v + i)));
+
+    /* pairs of Y00-Y01, Y10-Y11 and Cb-Cr as 16 bit words */
+    ab = _mm_unpacklo_epi16 (a, b);
+    cz = _mm_unpacklo_epi16 (c, zero);
+    q = _mm_unpacklo_epi32 (ab, cz);
+    _mm_storel_epi64 ((__m128i *) o, q);
+    _mm_storel_epi64 ((__m128i *) (o + 6), _mm_unpackhi_epi64 (q, q));
+    q = _mm_unpackhi_epi32 (ab, cz);
+    _mm_storel_epi64 ((__m128i *) (o + 12), q);
+    _mm_storel_epi64 ((__m128i *) (o + 18), _mm_unpackhi_epi64 (q, q));
+
+    ab = _mm_unpackhi_epi16 (a, b);
+    cz = _mm_unpackhi_epi16 (c, zero);
+    q = _mm_unpacklo_epi32 (ab, cz);
+    _mm_storel_epi64 ((__m128i *) (o + 24), q);
+    _mm_storel_epi64 ((__m128i *) (o + 30), _mm_unpackhi_epi64 (q, q));
+    q = _mm_unpackhi_epi32 (ab, cz);
+    _mm_storel_epi64 ((__m128i *) (o + 36), q);
+    _mm_storel_epi64 ((__m128i *) (o + 42), _mm_unpackhi_epi64 (q, q));
+  }
+#endif
+
+  y1 += 2 * i;
+  y2 += 2 * i;
+  u += i;
+  v += i;
+  out += 6 * i;
+  for (; i < groups; i++) {
+    *out++ = *y1++;
+    *out++ = *y1++;
+    *out++ = *y2++;
+    *out++ = *y2++;
+    *out++ = *u++;
+    *out++ = *v++;
+  }
+}
+
+/* fills the video data of the RTP packet @out, of which the headers were
+ * already written */
+static void
+gst_rtp_vraw_pay_fill_packet (GstRtpVRawPay * rtpvrawpay,
+    GstVideoFrame * frame, GstBuffer * out)
+{
+  GstRTPBuffer rtp = { NULL, };
+  guint8 *yp, *up, *vp;
+  guint ystride, uvstride;
+  guint8 *outdata, *headers;
+  guint pgroup = rtpvrawpay->pgroup;
+  guint length, cont, pixels;
+
+  yp = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  up = GST_VIDEO_FRAME_COMP_DATA (frame, 1);
+  vp = GST_VIDEO_FRAME_COMP_DATA (frame, 2);
+
+  ystride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+  uvstride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 1);
+
+  gst_rtp_buffer_map (out, GST_MAP_WRITE, &rtp);
+
+  /* skip the extended sequence number and find the data after the headers */
+  headers = (guint8 *) gst_rtp_buffer_get_payload (&rtp) + 2;
+  outdata = headers;
+  do {
+    cont = outdata[4] & 0x80;
+    outdata += 6;
+  } while (cont);
+
+  /* read headers and write the data */
+  while (TRUE) {
+    guint offs, lin;
+
+    /* read length and cont */
+    length = (headers[0] << 8) | headers[1];
+    lin = ((headers[2] & 0x7f) << 8) | headers[3];
+    offs = ((headers[4] & 0x7f) << 8) | headers[5];
+    cont = headers[4] & 0x80;
+    pixels = length / pgroup;
+    headers += 6;
+
+    GST_LOG_OBJECT (rtpvrawpay,
+        "writing length %u, line %u, offset %u, cont %d", length, lin, offs,
+        cont);
+
+    switch (GST_VIDEO_INFO_FORMAT (&rtpvrawpay->vinfo)) {
+      case GST_VIDEO_FORMAT_RGB:
+      case GST_VIDEO_FORMAT_RGBA:
+      case GST_VIDEO_FORMAT_BGR:
+      case GST_VIDEO_FORMAT_BGRA:
+      case GST_VIDEO_FORMAT_UYVY:
+      case GST_VIDEO_FORMAT_UYVP:
+        offs /= rtpvrawpay->xinc;
+        memcpy (outdata, yp + (lin * ystride) + (offs * pgroup), length);
+        outdata += length;
+        break;
+      case GST_VIDEO_FORMAT_AYUV:
+      {
+        gint i;
+        guint8 *datap;
+
+        datap = yp + (lin * ystride) + (offs * 4);
+
+        for (i = 0; i < pixels; i++) {
+          *outdata++ = datap[2];
+          *outdata++ = datap[1];
+          *outdata++ = datap[3];
+          datap += 4;
+        }
+        break;
+      }
+      case GST_VIDEO_FORMAT_I420:
+      {
+        guint uvoff;
+        guint8 *yd1p;
+
+        yd1p = yp + (lin * ystride) + (offs);
+        uvoff = (lin / rtpvrawpay->yinc * uvstride) + (offs / rtpvrawpay->xinc);
+
+        gst_rtp_vraw_pay_pack_i420 (outdata, yd1p, yd1p + ystride, up + uvoff,
+            vp + uvoff, pixels);
+        outdata += length;
+        break;
+      }
+      case GST_VIDEO_FORMAT_Y41B:
+      {
+        gint i;
+        guint uvoff;
+        guint8 *ydp, *udp, *vdp;
+
+        ydp = yp + (lin * ystride) + offs;
+        uvoff = (lin / rtpvrawpay->yinc * uvstride) + (offs / rtpvrawpay->xinc);
+        udp = up + uvoff;
+        vdp = vp + uvoff;
+
+        for (i = 0; i < pixels; i++) {
+          *outdata++ = *udp++;
+          *outdata++ = *ydp++;
+          *outdata++ = *ydp++;
+          *outdata++ = *vdp++;
+          *outdata++ = *ydp++;
+          *outdata++ = *ydp++;
+        }
+        break;
+      }
+      default:
+        g_assert_not_reached ();
+        break;
+    }
+
+    if (!cont)
+      break;
+  }
+
+  gst_rtp_buffer_unmap (&rtp);
+}
+
+typedef struct
+{
+  GstRtpVRawPay *rtpvrawpay;
+  GstVideoFrame *frame;
+  GstBuffer **packets;
+  guint start, end;
+} GstRtpVRawPaySlice;
+
+static void
+gst_rtp_vraw_pay_fill_packets (GstRtpVRawPaySlice * slice)
+{
+  guint i;
+
+  for (i = slice->start; i < slice->end; i++)
+    gst_rtp_vraw_pay_fill_packet (slice->rtpvrawpay, slice->frame,
+        slice->packets[i]);
+}
+
+static void
+gst_rtp_vraw_pay_slice_func (gpointer data, gpointer user_data)
+{
+  GstRtpVRawPaySlice *slice = data;
+  GstRtpVRawPay *rtpvrawpay = slice->rtpvrawpay;
+
+  gst_rtp_vraw_pay_fill_packets (slice);
+
+  g_mutex_lock (&rtpvrawpay->slice_lock);
+  if (--rtpvrawpay->slice_pending == 0)
+    g_cond_signal (&rtpvrawpay->slice_cond);
+  g_mutex_unlock (&rtpvrawpay->slice_lock);
+}
+
+/* fills the data of all @n_packets packets, split over up to n-threads
+ * threads; the calling thread takes the first slice */
+static void
+gst_rtp_vraw_pay_fill (GstRtpVRawPay * rtpvrawpay, GstVideoFrame * frame,
+    GstBuffer ** packets, guint n_packets)
+{
+  GstRtpVRawPaySlice *slices;
+  guint n_threads, n_slices, per_slice, i;
+
+  n_threads = rtpvrawpay->n_threads;
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  /* don't bother splitting up less than a few packets */
+  n_slices = MIN (n_threads, n_packets / 16);
+  if (n_slices > 1 && rtpvrawpay->slice_pool == NULL) {
+    rtpvrawpay->slice_pool = g_thread_pool_new (gst_rtp_vraw_pay_slice_func,
+        NULL, n_slices - 1, FALSE, NULL);
+    if (rtpvrawpay->slice_pool == NULL)
+      n_slices = 1;
+  } else if (n_slices > 1 &&
+      g_thread_pool_get_max_threads (rtpvrawpay->slice_pool) < n_slices - 1) {
+    g_thread_pool_set_max_threads (rtpvrawpay->slice_pool, n_slices - 1, NULL);
+  }
+  n_slices = MAX (n_slices, 1);
+
+  per_slice = (n_packets + n_slices - 1) / n_slices;
+  slices = g_newa (GstRtpVRawPaySlice, n_slices);
+  for (i = 0; i < n_slices; i++) {
+    slices[i].rtpvrawpay = rtpvrawpay;
+    slices[i].frame = frame;
+    slices[i].packets = packets;
+    slices[i].start = MIN (i * per_slice, n_packets);
+    slices[i].end = MIN ((i + 1) * per_slice, n_packets);
+  }
+
+  rtpvrawpay->slice_pending = n_slices - 1;
+  for (i = 1; i < n_slices; i++)
+    g_thread_pool_push (rtpvrawpay->slice_pool, &slices[i], NULL);
+
+  gst_rtp_vraw_pay_fill_packets (&slices[0]);
+
+  g_mutex_lock (&rtpvrawpay->slice_lock);
+  while (rtpvrawpay->slice_pending > 0)
+    g_cond_wait (&rtpvrawpay->slice_cond, &rtpvrawpay->slice_lock);
+  g_mutex_unlock (&rtpvrawpay->slice_lock);
+}
+
 static GstFlowReturn
 gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
 {
   GstRtpVRawPay *rtpvrawpay;
   GstFlowReturn ret = GST_FLOW_OK;
   guint line, offset;
-  guint8 *yp, *up, *vp;
-  guint ystride, uvstride;
   guint pgroup;
   guint mtu;
   guint width, height;
@@ -249,22 +590,30 @@ gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
   GstVideoFrame frame;
   gint interlaced;
   GstRTPBuffer rtp = { NULL, };
+  GPtrArray *packets;
 
   rtpvrawpay = GST_RTP_VRAW_PAY (payload);
 
+  switch (GST_VIDEO_INFO_FORMAT (&rtpvrawpay->vinfo)) {
+    case GST_VIDEO_FORMAT_RGB:
+    case GST_VIDEO_FORMAT_RGBA:
+    case GST_VIDEO_FORMAT_BGR:
+    case GST_VIDEO_FORMAT_BGRA:
+    case GST_VIDEO_FORMAT_UYVY:
+    case GST_VIDEO_FORMAT_UYVP:
+    case GST_VIDEO_FORMAT_AYUV:
+    case GST_VIDEO_FORMAT_I420:
+    case GST_VIDEO_FORMAT_Y41B:
+      break;
+    default:
+      goto unknown_sampling;
+  }
+
   gst_video_frame_map (&frame, &rtpvrawpay->vinfo, buffer, GST_MAP_READ);
 
   GST_LOG_OBJECT (rtpvrawpay, "new frame of %" G_GSIZE_FORMAT " bytes",
       gst_buffer_get_size (buffer));
 
-  /* get pointer and strides of the planes */
-  yp = GST_VIDEO_FRAME_COMP_DATA (&frame, 0);
-  up = GST_VIDEO_FRAME_COMP_DATA (&frame, 1);
-  vp = GST_VIDEO_FRAME_COMP_DATA (&frame, 2);
-
-  ystride = GST_VIDEO_FRAME_COMP_STRIDE (&frame, 0);
-  uvstride = GST_VIDEO_FRAME_COMP_STRIDE (&frame, 1);
-
   mtu = GST_RTP_BASE_PAYLOAD_MTU (payload);
 
   /* amount of bytes for one pixel */
@@ -274,12 +623,18 @@ gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
 
   interlaced = GST_VIDEO_INFO_IS_INTERLACED (&rtpvrawpay->vinfo);
 
+  packets = g_ptr_array_new ();
+
   /* start with line 0, offset 0 */
-  for (field = 0; field < 1 + interlaced; field++) {
+  for (field = 0; field < 1 + interlaced && ret == GST_FLOW_OK; field++) {
+    GstBufferList *list;
+    guint i;
+
     line = field;
     offset = 0;
 
-    /* write all lines */
+    /* lay out all packets of the field and write their headers; the video
+     * data is filled in afterwards */
     while (line < height) {
       guint left;
       GstBuffer *out;
@@ -388,103 +743,6 @@ gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
       GST_LOG_OBJECT (rtpvrawpay, "consumed %u bytes",
           (guint) (outdata - headers));
 
-      /* second pass, read headers and write the data */
-      while (TRUE) {
-        guint offs, lin;
-
-        /* read length and cont */
-        length = (headers[0] << 8) | headers[1];
-        lin = ((headers[2] & 0x7f) << 8) | headers[3];
-        offs = ((headers[4] & 0x7f) << 8) | headers[5];
-        cont = headers[4] & 0x80;
-        pixels = length / pgroup;
-        headers += 6;
-
-        GST_LOG_OBJECT (payload,
-            "writing length %u, line %u, offset %u, cont %d", length, lin, offs,
-            cont);
-
-        switch (GST_VIDEO_INFO_FORMAT (&rtpvrawpay->vinfo)) {
-          case GST_VIDEO_FORMAT_RGB:
-          case GST_VIDEO_FORMAT_RGBA:
-          case GST_VIDEO_FORMAT_BGR:
-          case GST_VIDEO_FORMAT_BGRA:
-          case GST_VIDEO_FORMAT_UYVY:
-          case GST_VIDEO_FORMAT_UYVP:
-            offs /= rtpvrawpay->xinc;
-            memcpy (outdata, yp + (lin * ystride) + (offs * pgroup), length);
-            outdata += length;
-            break;
-          case GST_VIDEO_FORMAT_AYUV:
-          {
-            gint i;
-            guint8 *datap;
-
-            datap = yp + (lin * ystride) + (offs * 4);
-
-            for (i = 0; i < pixels; i++) {
-              *outdata++ = datap[2];
-              *outdata++ = datap[1];
-              *outdata++ = datap[3];
-              datap += 4;
-            }
-            break;
-          }
-          case GST_VIDEO_FORMAT_I420:
-          {
-            gint i;
-            guint uvoff;
-            guint8 *yd1p, *yd2p, *udp, *vdp;
-
-            yd1p = yp + (lin * ystride) + (offs);
-            yd2p = yd1p + ystride;
-            uvoff =
-                (lin / rtpvrawpay->yinc * uvstride) + (offs / rtpvrawpay->xinc);
-            udp = up + uvoff;
-            vdp = vp + uvoff;
-
-            for (i = 0; i < pixels; i++) {
-              *outdata++ = *yd1p++;
-              *outdata++ = *yd1p++;
-              *outdata++ = *yd2p++;
-              *outdata++ = *yd2p++;
-              *outdata++ = *udp++;
-              *outdata++ = *vdp++;
-            }
-            break;
-          }
-          case GST_VIDEO_FORMAT_Y41B:
-          {
-            gint i;
-            guint uvoff;
-            guint8 *ydp, *udp, *vdp;
-
-            ydp = yp + (lin * ystride) + offs;
-            uvoff =
-                (lin / rtpvrawpay->yinc * uvstride) + (offs / rtpvrawpay->xinc);
-            udp = up + uvoff;
-            vdp = vp + uvoff;
-
-            for (i = 0; i < pixels; i++) {
-              *outdata++ = *udp++;
-              *outdata++ = *ydp++;
-              *outdata++ = *ydp++;
-              *outdata++ = *vdp++;
-              *outdata++ = *ydp++;
-              *outdata++ = *ydp++;
-            }
-            break;
-          }
-          default:
-            gst_rtp_buffer_unmap (&rtp);
-            gst_buffer_unref (out);
-            goto unknown_sampling;
-        }
-
-        if (!cont)
-          break;
-      }
-
       if (line >= height) {
         GST_LOG_OBJECT (rtpvrawpay, "field/frame complete, set marker");
         gst_rtp_buffer_set_marker (&rtp, TRUE);
@@ -495,12 +753,23 @@ gst_rtp_vraw_pay_handle_buffer (GstRTPBasePayload * payload, GstBuffer * buffer)
         gst_buffer_resize (out, 0, gst_buffer_get_size (out) - left);
       }
 
-      /* push buffer */
-      ret = gst_rtp_base_payload_push (payload, out);
+      g_ptr_array_add (packets, out);
     }
 
+    /* the packets don't depend on each other, fill them in parallel */
+    gst_rtp_vraw_pay_fill (rtpvrawpay, &frame, (GstBuffer **) packets->pdata,
+        packets->len);
+
+    /* push the field as one list */
+    list = gst_buffer_list_new_sized (packets->len);
+    for (i = 0; i < packets->len; i++)
+      gst_buffer_list_add (list, g_ptr_array_index (packets, i));
+    g_ptr_array_set_size (packets, 0);
+
+    ret = gst_rtp_base_payload_push_list (payload, list);
   }
 
+  g_ptr_array_free (packets, TRUE);
   gst_video_frame_unmap (&frame);
   gst_buffer_unref (buffer);
 
@@ -511,7 +780,6 @@ unknown_sampling:
   {
     GST_ELEMENT_ERROR (payload, STREAM, FORMAT,
         (NULL), ("unimplemented sampling"));
-    gst_video_frame_unmap (&frame);
     gst_buffer_unref (buffer);
     return GST_FLOW_NOT_SUPPORTED;
   }
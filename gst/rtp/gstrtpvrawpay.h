@@ -53,6 +53,13 @@ struct _GstRtpVRawPay
 //   gint uvstride;
 //   gboolean interlaced;
   gint depth;
+
+  /* packetization threads */
+  guint n_threads;
+  GThreadPool *slice_pool;
+  GMutex slice_lock;
+  GCond slice_cond;
+  guint slice_pending;
 };
 
 struct _GstRtpVRawPayClass
@@ -242,6 +242,9 @@ struct _GstRtpBinPrivate
 
   /* list of extra elements */
   GList *elements;
+
+  /* pool handling the received RTP of the sessions */
+  GThreadPool *session_pool;
 };
 
 /* signals and args */
@@ -290,6 +293,9 @@ enum
 #define DEFAULT_RTCP_SYNC_INTERVAL   0
 #define DEFAULT_DO_SYNC_EVENT        FALSE
 #define DEFAULT_DO_RETRANSMISSION    FALSE
+#define DEFAULT_SHARED_TIMERS        FALSE
+#define DEFAULT_SESSION_THREADS      0
+#define DEFAULT_RTCP_MUX             FALSE
 
 enum
 {
@@ -307,6 +313,9 @@ enum
   PROP_USE_PIPELINE_CLOCK,
   PROP_DO_SYNC_EVENT,
   PROP_DO_RETRANSMISSION,
+  PROP_SHARED_TIMERS,
+  PROP_SESSION_THREADS,
+  PROP_RTCP_MUX,
   PROP_LAST
 };
 
@@ -631,9 +640,17 @@ create_session (GstRtpBin * rtpbin, gint id)
   /* configure SDES items */
   GST_OBJECT_LOCK (rtpbin);
   g_object_set (session, "sdes", rtpbin->sdes, "use-pipeline-clock",
-      rtpbin->use_pipeline_clock, NULL);
+      rtpbin->use_pipeline_clock, "rtcp-mux", rtpbin->rtcp_mux, NULL);
   GST_OBJECT_UNLOCK (rtpbin);
 
+  if (rtpbin->session_threads > 0) {
+    if (rtpbin->priv->session_pool == NULL)
+      rtpbin->priv->session_pool =
+          gst_rtp_session_worker_pool_new (rtpbin->session_threads);
+    gst_rtp_session_set_worker_pool (GST_RTP_SESSION_CAST (session),
+        rtpbin->priv->session_pool);
+  }
+
   /* provide clock_rate to the session manager when needed */
   g_signal_connect (session, "request-pt-map",
       (GCallback) pt_map_requested, sess);
@@ -1532,6 +1549,7 @@ create_stream (GstRtpBinSession * session, guint32 ssrc)
   g_object_set (buffer, "do-lost", rtpbin->do_lost, NULL);
   g_object_set (buffer, "mode", rtpbin->buffer_mode, NULL);
   g_object_set (buffer, "do-retransmission", rtpbin->do_retransmission, NULL);
+  g_object_set (buffer, "shared-timers", rtpbin->shared_timers, NULL);
 
   g_signal_emit (rtpbin, gst_rtp_bin_signals[SIGNAL_NEW_JITTERBUFFER], 0,
       buffer, session->id, ssrc);
@@ -2127,6 +2145,54 @@ gst_rtp_bin_class_init (GstRtpBinClass * klass)
           DEFAULT_DO_RETRANSMISSION,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRtpBin:shared-timers:
+   *
+   * Let the jitterbuffers handle their timers in a thread pool shared by all
+   * jitterbuffers instead of with a thread each. This keeps the number of
+   * threads down when there are many sessions. Only affects jitterbuffers that
+   * are not yet PAUSED.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_SHARED_TIMERS,
+      g_param_spec_boolean ("shared-timers", "Shared Timers",
+          "Handle jitterbuffer timers in a shared thread pool",
+          DEFAULT_SHARED_TIMERS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpBin:session-threads:
+   *
+   * Handle the received RTP of all sessions in a pool of this many threads
+   * instead of in the upstream streaming threads. Each session is queued
+   * separately and handled by one pool thread at a time, so that many
+   * sessions are spread over the available cores. 0 disables the pool.
+   * Only affects sessions that are created after the pool was enabled.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_SESSION_THREADS,
+      g_param_spec_uint ("session-threads", "Session Threads",
+          "Number of threads handling received RTP of the sessions "
+          "(0 = use the upstream threads)", 0, G_MAXINT,
+          DEFAULT_SESSION_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtpBin:rtcp-mux:
+   *
+   * Receive RTP and RTCP of a session on the recv_rtp_sink pad, as described
+   * in RFC 5761, so that a single socket and receive thread serves both. The
+   * SR packets are used for synchronisation as if they arrived on a
+   * recv_rtcp_sink pad, which does not need to be requested. Only affects
+   * sessions that are created after it is set.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_RTCP_MUX,
+      g_param_spec_boolean ("rtcp-mux", "RTCP mux",
+          "Receive RTCP multiplexed with the RTP on the RTP sink pads",
+          DEFAULT_RTCP_MUX, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_rtp_bin_change_state);
   gstelement_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_rtp_bin_request_new_pad);
@@ -2189,6 +2255,9 @@ gst_rtp_bin_init (GstRtpBin * rtpbin)
   rtpbin->use_pipeline_clock = DEFAULT_USE_PIPELINE_CLOCK;
   rtpbin->send_sync_event = DEFAULT_DO_SYNC_EVENT;
   rtpbin->do_retransmission = DEFAULT_DO_RETRANSMISSION;
+  rtpbin->shared_timers = DEFAULT_SHARED_TIMERS;
+  rtpbin->session_threads = DEFAULT_SESSION_THREADS;
+  rtpbin->rtcp_mux = DEFAULT_RTCP_MUX;
 
   /* some default SDES entries */
   cname = g_strdup_printf ("user%u@host-%x", g_random_int (), g_random_int ());
@@ -2224,6 +2293,10 @@ gst_rtp_bin_finalize (GObject * object)
   if (rtpbin->sdes)
     gst_structure_free (rtpbin->sdes);
 
+  /* the sessions are gone, wait for their last jobs */
+  if (rtpbin->priv->session_pool)
+    g_thread_pool_free (rtpbin->priv->session_pool, FALSE, TRUE);
+
   g_mutex_clear (&rtpbin->priv->bin_lock);
   g_mutex_clear (&rtpbin->priv->dyn_lock);
 
@@ -2349,6 +2422,27 @@ gst_rtp_bin_set_property (GObject * object, guint prop_id,
       gst_rtp_bin_propagate_property_to_jitterbuffer (rtpbin,
           "do-retransmission", value);
       break;
+    case PROP_SHARED_TIMERS:
+      GST_RTP_BIN_LOCK (rtpbin);
+      rtpbin->shared_timers = g_value_get_boolean (value);
+      GST_RTP_BIN_UNLOCK (rtpbin);
+      gst_rtp_bin_propagate_property_to_jitterbuffer (rtpbin,
+          "shared-timers", value);
+      break;
+    case PROP_SESSION_THREADS:
+      GST_RTP_BIN_LOCK (rtpbin);
+      rtpbin->session_threads = g_value_get_uint (value);
+      /* sessions already using the pool keep it, never shrink it to nothing */
+      if (rtpbin->priv->session_pool && rtpbin->session_threads > 0)
+        g_thread_pool_set_max_threads (rtpbin->priv->session_pool,
+            rtpbin->session_threads, NULL);
+      GST_RTP_BIN_UNLOCK (rtpbin);
+      break;
+    case PROP_RTCP_MUX:
+      GST_RTP_BIN_LOCK (rtpbin);
+      rtpbin->rtcp_mux = g_value_get_boolean (value);
+      GST_RTP_BIN_UNLOCK (rtpbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2411,6 +2505,21 @@ gst_rtp_bin_get_property (GObject * object, guint prop_id,
       g_value_set_boolean (value, rtpbin->do_retransmission);
       GST_RTP_BIN_UNLOCK (rtpbin);
       break;
+    case PROP_SHARED_TIMERS:
+      GST_RTP_BIN_LOCK (rtpbin);
+      g_value_set_boolean (value, rtpbin->shared_timers);
+      GST_RTP_BIN_UNLOCK (rtpbin);
+      break;
+    case PROP_SESSION_THREADS:
+      GST_RTP_BIN_LOCK (rtpbin);
+      g_value_set_uint (value, rtpbin->session_threads);
+      GST_RTP_BIN_UNLOCK (rtpbin);
+      break;
+    case PROP_RTCP_MUX:
+      GST_RTP_BIN_LOCK (rtpbin);
+      g_value_set_boolean (value, rtpbin->rtcp_mux);
+      GST_RTP_BIN_UNLOCK (rtpbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3017,6 +3126,40 @@ dec_link_failed:
   }
 }
 
+/* request the RTCP sink pad of the session to get its sync_src pad and link
+ * that to the SSRC demuxer, without exposing the RTCP sink pad */
+static gboolean
+link_muxed_rtcp (GstRtpBin * rtpbin, GstRtpBinSession * session)
+{
+  GstPad *sinkdpad;
+
+  GST_DEBUG_OBJECT (rtpbin, "setting up rtcp-mux for session %d",
+      session->id);
+
+  session->recv_rtcp_sink =
+      gst_element_get_request_pad (session->session, "recv_rtcp_sink");
+  if (session->recv_rtcp_sink == NULL)
+    goto pad_failed;
+
+  session->sync_src = gst_element_get_static_pad (session->session, "sync_src");
+  if (session->sync_src == NULL)
+    goto pad_failed;
+
+  sinkdpad = gst_element_get_static_pad (session->demux, "rtcp_sink");
+  gst_pad_link_full (session->sync_src, sinkdpad, GST_PAD_LINK_CHECK_NOTHING);
+  gst_object_unref (sinkdpad);
+
+  return TRUE;
+
+  /* ERRORS */
+pad_failed:
+  {
+    g_warning ("rtpbin: failed to set up rtcp-mux for session %d",
+        session->id);
+    return FALSE;
+  }
+}
+
 /* Create a pad for receiving RTP for the session in @name. Must be called with
  * RTP_BIN_LOCK.
  */
@@ -3103,6 +3246,12 @@ create_recv_rtp (GstRtpBin * rtpbin, GstPadTemplate * templ, const gchar * name)
     session->demux_padremoved_sig = g_signal_connect (session->demux,
         "removed-ssrc-pad", (GCallback) ssrc_demux_pad_removed, session);
   }
+
+  /* with rtcp-mux the session finds the RTCP on the RTP pad, we only need
+   * its sync_src pad for the SR packets */
+  if (rtpbin->rtcp_mux && session->sync_src == NULL)
+    link_muxed_rtcp (rtpbin, session);
+
   return session->recv_rtp_sink_ghost;
 
   /* ERRORS */
@@ -3164,6 +3313,9 @@ remove_recv_rtp (GstRtpBin * rtpbin, GstRtpBinSession * session)
         session->recv_rtp_sink_ghost);
     session->recv_rtp_sink_ghost = NULL;
   }
+  /* the RTCP sink pad that was only set up for rtcp-mux */
+  if (session->sync_src && session->recv_rtcp_sink_ghost == NULL)
+    remove_recv_rtcp (rtpbin, session);
 }
 
 /* Create a pad for receiving RTCP for the session in @name. Must be called with
@@ -3198,6 +3350,13 @@ create_recv_rtcp (GstRtpBin * rtpbin, GstPadTemplate * templ,
   if (session->recv_rtcp_sink_ghost != NULL)
     return session->recv_rtcp_sink_ghost;
 
+  /* with rtcp-mux the RTCP sink pad of the session is already set up,
+   * expose it for RTCP that arrives separately anyway */
+  if (session->sync_src != NULL) {
+    decsink = gst_object_ref (session->recv_rtcp_sink);
+    goto expose;
+  }
+
   /* get recv_rtp pad and store */
   GST_DEBUG_OBJECT (rtpbin, "getting RTCP sink pad");
   session->recv_rtcp_sink =
@@ -3242,6 +3401,7 @@ create_recv_rtcp (GstRtpBin * rtpbin, GstPadTemplate * templ,
   gst_pad_link_full (session->sync_src, sinkdpad, GST_PAD_LINK_CHECK_NOTHING);
   gst_object_unref (sinkdpad);
 
+expose:
   session->recv_rtcp_sink_ghost =
       gst_ghost_pad_new_from_template (name, decsink, templ);
   gst_object_unref (decsink);
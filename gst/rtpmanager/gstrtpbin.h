@@ -59,6 +59,9 @@ struct _GstRtpBin {
   gboolean        send_sync_event;
   GstClockTime    buffer_start;
   gboolean        do_retransmission;
+  gboolean        shared_timers;
+  guint           session_threads;
+  gboolean        rtcp_mux;
   /* a list of session */
   GSList         *sessions;
 
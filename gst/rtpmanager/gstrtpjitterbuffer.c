@@ -134,10 +134,27 @@ enum
 #define DEFAULT_RTX_DELAY_REORDER   3
 #define DEFAULT_RTX_RETRY_TIMEOUT   -1
 #define DEFAULT_RTX_RETRY_PERIOD    -1
+#define DEFAULT_SHARED_TIMERS       FALSE
+#define DEFAULT_ADAPTIVE_LATENCY    FALSE
+#define DEFAULT_MIN_LATENCY_MS      20
+#define DEFAULT_MAX_LATENCY_MS      2000
+
+/* maximum number of threads handling the shared timers */
+#define SHARED_TIMER_THREADS 4
+
+/* maximum number of buffers pushed in one buffer list */
+#define MAX_PUSH_LIST_LENGTH 64
 
 #define DEFAULT_AUTO_RTX_DELAY (20 * GST_MSECOND)
 #define DEFAULT_AUTO_RTX_TIMEOUT (40 * GST_MSECOND)
 
+/* adaptive latency: number of transit times the percentile is taken from,
+ * how often the latency is updated, in packets, and the headroom added */
+#define ADAPT_WINDOW 512
+#define ADAPT_INTERVAL 64
+#define ADAPT_PERCENTILE 95
+#define ADAPT_MARGIN (10 * GST_MSECOND)
+
 enum
 {
   PROP_0,
@@ -153,6 +170,10 @@ enum
   PROP_RTX_RETRY_TIMEOUT,
   PROP_RTX_RETRY_PERIOD,
   PROP_STATS,
+  PROP_SHARED_TIMERS,
+  PROP_ADAPTIVE_LATENCY,
+  PROP_MIN_LATENCY,
+  PROP_MAX_LATENCY,
   PROP_LAST
 };
 
@@ -234,6 +255,11 @@ struct _GstRtpJitterBufferPrivate
 
   gboolean timer_running;
   GThread *timer_thread;
+  /* when the timers are handled by the shared thread pool, whether we are
+   * queued in the pool or being handled by one of its threads */
+  gboolean timer_shared;
+  gboolean timer_queued;
+  gboolean timer_busy;
 
   /* properties */
   guint latency_ms;
@@ -246,6 +272,10 @@ struct _GstRtpJitterBufferPrivate
   gint rtx_delay_reorder;
   gint rtx_retry_timeout;
   gint rtx_retry_period;
+  gboolean shared_timers;
+  gboolean adaptive_latency;
+  guint min_latency_ms;
+  guint max_latency_ms;
 
   /* the last seqnum we pushed out */
   guint32 last_popped_seqnum;
@@ -263,7 +293,19 @@ struct _GstRtpJitterBufferPrivate
   guint32 last_in_seqnum;
   guint32 next_in_seqnum;
 
-  GArray *timers;
+  /* all timers, owned */
+  GPtrArray *timers;
+  /* timers by type and seqnum, and the number of timers that are not in the
+   * table because another one has the same type and seqnum */
+  GHashTable *timer_index;
+  guint timer_dups;
+  /* min-heaps on timeout, one for the EXPECTED timers and one for the others,
+   * see get_timeout() */
+  GPtrArray *expected_heap;
+  GPtrArray *timer_heap;
+  /* EXPECTED timers that did not request a retransmission yet and are not
+   * due, in the order they were scheduled */
+  GQueue fresh_timers;
 
   /* start and stop ranges */
   GstClockTime npt_start;
@@ -310,6 +352,13 @@ struct _GstRtpJitterBufferPrivate
   GstClockTime last_dts;
   guint64 last_rtptime;
   GstClockTime avg_jitter;
+
+  /* for the adaptive latency, the last transit times of the packets relative
+   * to the first one */
+  GstClockTimeDiff adapt_transit[ADAPT_WINDOW];
+  guint adapt_count;
+  GstClockTimeDiff adapt_rtp_ns;
+  gboolean adapt_post;
 };
 
 typedef enum
@@ -323,6 +372,8 @@ typedef enum
 typedef struct
 {
   guint idx;
+  guint heap_idx;
+  GList fresh_link;
   guint16 seqnum;
   guint num;
   TimerType type;
@@ -428,6 +479,7 @@ static void unschedule_current_timer (GstRtpJitterBuffer * jitterbuffer);
 static void remove_all_timers (GstRtpJitterBuffer * jitterbuffer);
 
 static void wait_next_timeout (GstRtpJitterBuffer * jitterbuffer);
+static void queue_shared_timer (GstRtpJitterBuffer * jitterbuffer);
 
 static GstStructure *gst_rtp_jitter_buffer_create_stats (GstRtpJitterBuffer *
     jitterbuffer);
@@ -585,6 +637,59 @@ gst_rtp_jitter_buffer_class_init (GstRtpJitterBufferClass * klass)
           "Try to get a retransmission for this many ms "
           "(-1 automatic)", -1, G_MAXINT, DEFAULT_RTX_RETRY_PERIOD,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstRtpJitterBuffer:shared-timers:
+   *
+   * Handle the timers with a thread pool that is shared by all jitterbuffers
+   * in the process instead of with a thread for each jitterbuffer. The
+   * property is used when going from READY to PAUSED.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_SHARED_TIMERS,
+      g_param_spec_boolean ("shared-timers", "Shared Timers",
+          "Handle timers in a thread pool shared with other jitterbuffers",
+          DEFAULT_SHARED_TIMERS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstRtpJitterBuffer:adaptive-latency:
+   *
+   * Let the latency follow the measured network jitter instead of keeping
+   * it at #GstRtpJitterBuffer:latency. The latency is set to the 95th
+   * percentile of the variation of the packet transit times, which also
+   * covers reordered packets, plus a small margin, within
+   * #GstRtpJitterBuffer:min-latency and #GstRtpJitterBuffer:max-latency.
+   * It grows at once and shrinks by at most a tenth at every update, and a
+   * latency message is posted whenever it changes.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_ADAPTIVE_LATENCY,
+      g_param_spec_boolean ("adaptive-latency", "Adaptive latency",
+          "Adapt the latency to the measured jitter",
+          DEFAULT_ADAPTIVE_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstRtpJitterBuffer:min-latency:
+   *
+   * The lowest latency in ms used with #GstRtpJitterBuffer:adaptive-latency.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_MIN_LATENCY,
+      g_param_spec_uint ("min-latency", "Minimum latency in ms",
+          "Minimum latency in adaptive mode", 0, G_MAXUINT,
+          DEFAULT_MIN_LATENCY_MS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstRtpJitterBuffer:max-latency:
+   *
+   * The highest latency in ms used with #GstRtpJitterBuffer:adaptive-latency.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_LATENCY,
+      g_param_spec_uint ("max-latency", "Maximum latency in ms",
+          "Maximum latency in adaptive mode", 0, G_MAXUINT,
+          DEFAULT_MAX_LATENCY_MS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
   /**
    * GstRtpJitterBuffer:stats:
    *
@@ -716,11 +821,19 @@ gst_rtp_jitter_buffer_init (GstRtpJitterBuffer * jitterbuffer)
   priv->rtx_delay_reorder = DEFAULT_RTX_DELAY_REORDER;
   priv->rtx_retry_timeout = DEFAULT_RTX_RETRY_TIMEOUT;
   priv->rtx_retry_period = DEFAULT_RTX_RETRY_PERIOD;
+  priv->shared_timers = DEFAULT_SHARED_TIMERS;
+  priv->adaptive_latency = DEFAULT_ADAPTIVE_LATENCY;
+  priv->min_latency_ms = DEFAULT_MIN_LATENCY_MS;
+  priv->max_latency_ms = DEFAULT_MAX_LATENCY_MS;
 
   priv->last_dts = -1;
   priv->last_rtptime = -1;
   priv->avg_jitter = 0;
-  priv->timers = g_array_new (FALSE, TRUE, sizeof (TimerData));
+  priv->timers = g_ptr_array_new ();
+  priv->timer_index = g_hash_table_new (g_direct_hash, g_direct_equal);
+  priv->expected_heap = g_ptr_array_new ();
+  priv->timer_heap = g_ptr_array_new ();
+  g_queue_init (&priv->fresh_timers);
   priv->jbuf = rtp_jitter_buffer_new ();
   g_mutex_init (&priv->jbuf_lock);
   g_cond_init (&priv->jbuf_timer);
@@ -805,7 +918,11 @@ gst_rtp_jitter_buffer_finalize (GObject * object)
   jitterbuffer = GST_RTP_JITTER_BUFFER (object);
   priv = jitterbuffer->priv;
 
-  g_array_free (priv->timers, TRUE);
+  remove_all_timers (jitterbuffer);
+  g_ptr_array_free (priv->timers, TRUE);
+  g_hash_table_destroy (priv->timer_index);
+  g_ptr_array_free (priv->expected_heap, TRUE);
+  g_ptr_array_free (priv->timer_heap, TRUE);
   g_mutex_clear (&priv->jbuf_lock);
   g_cond_clear (&priv->jbuf_timer);
   g_cond_clear (&priv->jbuf_event);
@@ -1181,6 +1298,7 @@ gst_rtp_jitter_buffer_flush_stop (GstRtpJitterBuffer * jitterbuffer)
   priv->avg_jitter = 0;
   priv->last_dts = -1;
   priv->last_rtptime = -1;
+  priv->adapt_count = 0;
   GST_DEBUG_OBJECT (jitterbuffer, "flush and reset jitterbuffer");
   rtp_jitter_buffer_flush (priv->jbuf, (GFunc) free_item, NULL);
   rtp_jitter_buffer_reset_skew (priv->jbuf);
@@ -1248,8 +1366,11 @@ gst_rtp_jitter_buffer_change_state (GstElement * element,
       /* block until we go to PLAYING */
       priv->blocked = TRUE;
       priv->timer_running = TRUE;
-      priv->timer_thread =
-          g_thread_new ("timer", (GThreadFunc) wait_next_timeout, jitterbuffer);
+      priv->timer_shared = priv->shared_timers;
+      if (!priv->timer_shared)
+        priv->timer_thread =
+            g_thread_new ("timer", (GThreadFunc) wait_next_timeout,
+            jitterbuffer);
       JBUF_UNLOCK (priv);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
@@ -1258,6 +1379,8 @@ gst_rtp_jitter_buffer_change_state (GstElement * element,
       priv->blocked = FALSE;
       JBUF_SIGNAL_EVENT (priv);
       JBUF_SIGNAL_TIMER (priv);
+      if (priv->timer_shared)
+        queue_shared_timer (jitterbuffer);
       JBUF_UNLOCK (priv);
       break;
     default:
@@ -1289,9 +1412,14 @@ gst_rtp_jitter_buffer_change_state (GstElement * element,
       unschedule_current_timer (jitterbuffer);
       JBUF_SIGNAL_TIMER (priv);
       JBUF_SIGNAL_QUERY (priv, FALSE);
+      /* wait for the shared timer thread that is handling us */
+      while (priv->timer_busy)
+        JBUF_WAIT_TIMER (priv);
       JBUF_UNLOCK (priv);
-      g_thread_join (priv->timer_thread);
-      priv->timer_thread = NULL;
+      if (priv->timer_thread) {
+        g_thread_join (priv->timer_thread);
+        priv->timer_thread = NULL;
+      }
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
@@ -1610,22 +1738,179 @@ apply_offset (GstRtpJitterBuffer * jitterbuffer, GstClockTime timestamp)
   return timestamp;
 }
 
-static TimerData *
-find_timer (GstRtpJitterBuffer * jitterbuffer, TimerType type, guint16 seqnum)
+#define TIMER_KEY(type,seqnum) GUINT_TO_POINTER (((type) << 16) | (seqnum))
+#define TIMER_HEAP(priv,timer) ((timer)->type == TIMER_TYPE_EXPECTED ? \
+    (priv)->expected_heap : (priv)->timer_heap)
+
+/* check if a timer with timeout @ta and @sa should fire before a timer with
+ * timeout @tb and seqnum @sb. A timeout of -1 means that the timer should fire
+ * immediately. */
+static inline gboolean
+timer_earlier (GstClockTime ta, guint16 sa, GstClockTime tb, guint16 sb)
 {
-  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
-  TimerData *timer = NULL;
-  gint i, len;
+  if (ta != tb) {
+    if (ta == -1)
+      return TRUE;
+    if (tb == -1)
+      return FALSE;
+    return ta < tb;
+  }
+  return gst_rtp_buffer_compare_seqnum (sa, sb) > 0;
+}
 
-  len = priv->timers->len;
-  for (i = 0; i < len; i++) {
-    TimerData *test = &g_array_index (priv->timers, TimerData, i);
-    if (test->seqnum == seqnum && test->type == type) {
-      timer = test;
+static inline void
+timer_heap_swap (GPtrArray * heap, guint i, guint j)
+{
+  TimerData *ti = g_ptr_array_index (heap, i);
+  TimerData *tj = g_ptr_array_index (heap, j);
+
+  g_ptr_array_index (heap, i) = tj;
+  tj->heap_idx = i;
+  g_ptr_array_index (heap, j) = ti;
+  ti->heap_idx = j;
+}
+
+static inline gboolean
+timer_heap_less (GPtrArray * heap, guint i, guint j)
+{
+  TimerData *ti = g_ptr_array_index (heap, i);
+  TimerData *tj = g_ptr_array_index (heap, j);
+
+  return timer_earlier (ti->timeout, ti->seqnum, tj->timeout, tj->seqnum);
+}
+
+static void
+timer_heap_sift_up (GPtrArray * heap, guint i)
+{
+  while (i > 0) {
+    guint parent = (i - 1) / 2;
+
+    if (!timer_heap_less (heap, i, parent))
+      break;
+    timer_heap_swap (heap, i, parent);
+    i = parent;
+  }
+}
+
+static void
+timer_heap_sift_down (GPtrArray * heap, guint i)
+{
+  guint len = heap->len;
+
+  while (TRUE) {
+    guint left = 2 * i + 1, right = left + 1, best = i;
+
+    if (left < len && timer_heap_less (heap, left, best))
+      best = left;
+    if (right < len && timer_heap_less (heap, right, best))
+      best = right;
+    if (best == i)
       break;
+    timer_heap_swap (heap, i, best);
+    i = best;
+  }
+}
+
+static void
+timer_heap_push (GPtrArray * heap, TimerData * timer)
+{
+  timer->heap_idx = heap->len;
+  g_ptr_array_add (heap, timer);
+  timer_heap_sift_up (heap, timer->heap_idx);
+}
+
+static void
+timer_heap_remove (GPtrArray * heap, TimerData * timer)
+{
+  guint idx = timer->heap_idx, last = heap->len - 1;
+
+  if (idx != last)
+    timer_heap_swap (heap, idx, last);
+  g_ptr_array_remove_index (heap, last);
+  if (idx < heap->len) {
+    timer_heap_sift_down (heap, idx);
+    timer_heap_sift_up (heap, idx);
+  }
+}
+
+/* add @timer to the lookup table, the heaps and the fresh queue. Must be
+ * called again after changing the type, seqnum, timeout or num_rtx_retry of
+ * a timer that was removed with timer_index_remove(). */
+static void
+timer_index_add (GstRtpJitterBufferPrivate * priv, TimerData * timer)
+{
+  gpointer key = TIMER_KEY (timer->type, timer->seqnum);
+
+  if (g_hash_table_lookup (priv->timer_index, key))
+    priv->timer_dups++;
+  else
+    g_hash_table_insert (priv->timer_index, key, timer);
+
+  timer_heap_push (TIMER_HEAP (priv, timer), timer);
+
+  if (timer->type == TIMER_TYPE_EXPECTED && timer->num_rtx_retry == 0
+      && timer->timeout != -1) {
+    timer->fresh_link.data = timer;
+    g_queue_push_tail_link (&priv->fresh_timers, &timer->fresh_link);
+  }
+}
+
+static void
+timer_index_remove (GstRtpJitterBufferPrivate * priv, TimerData * timer)
+{
+  gpointer key = TIMER_KEY (timer->type, timer->seqnum);
+
+  if (g_hash_table_lookup (priv->timer_index, key) == timer) {
+    g_hash_table_remove (priv->timer_index, key);
+
+    if (priv->timer_dups > 0) {
+      guint i;
+
+      /* there might be another timer with the same type and seqnum */
+      for (i = 0; i < priv->timers->len; i++) {
+        TimerData *test = g_ptr_array_index (priv->timers, i);
+
+        if (test != timer && test->type == timer->type
+            && test->seqnum == timer->seqnum) {
+          g_hash_table_insert (priv->timer_index, key, test);
+          priv->timer_dups--;
+          break;
+        }
+      }
     }
+  } else if (priv->timer_dups > 0) {
+    priv->timer_dups--;
   }
-  return timer;
+
+  timer_heap_remove (TIMER_HEAP (priv, timer), timer);
+
+  if (timer->fresh_link.data) {
+    g_queue_unlink (&priv->fresh_timers, &timer->fresh_link);
+    timer->fresh_link.data = NULL;
+  }
+}
+
+static TimerData *
+find_timer (GstRtpJitterBuffer * jitterbuffer, TimerType type, guint16 seqnum)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+
+  return g_hash_table_lookup (priv->timer_index, TIMER_KEY (type, seqnum));
+}
+
+/* find a timer of any type for @seqnum */
+static TimerData *
+find_any_timer (GstRtpJitterBuffer * jitterbuffer, guint16 seqnum)
+{
+  TimerData *timer;
+
+  if ((timer = find_timer (jitterbuffer, TIMER_TYPE_EXPECTED, seqnum)))
+    return timer;
+  if ((timer = find_timer (jitterbuffer, TIMER_TYPE_LOST, seqnum)))
+    return timer;
+  if ((timer = find_timer (jitterbuffer, TIMER_TYPE_DEADLINE, seqnum)))
+    return timer;
+  return find_timer (jitterbuffer, TIMER_TYPE_EOS, seqnum);
 }
 
 static void
@@ -1636,6 +1921,11 @@ unschedule_current_timer (GstRtpJitterBuffer * jitterbuffer)
   if (priv->clock_id) {
     GST_DEBUG_OBJECT (jitterbuffer, "unschedule current timer");
     gst_clock_id_unschedule (priv->clock_id);
+    if (priv->timer_shared) {
+      /* nobody is waiting on the id, look for the next timer again */
+      gst_clock_id_unref (priv->clock_id);
+      queue_shared_timer (jitterbuffer);
+    }
     priv->clock_id = NULL;
   }
 }
@@ -1680,16 +1970,14 @@ add_timer (GstRtpJitterBuffer * jitterbuffer, TimerType type,
 {
   GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
   TimerData *timer;
-  gint len;
 
   GST_DEBUG_OBJECT (jitterbuffer,
       "add timer for seqnum %d to %" GST_TIME_FORMAT ", delay %"
       GST_TIME_FORMAT, seqnum, GST_TIME_ARGS (timeout), GST_TIME_ARGS (delay));
 
-  len = priv->timers->len;
-  g_array_set_size (priv->timers, len + 1);
-  timer = &g_array_index (priv->timers, TimerData, len);
-  timer->idx = len;
+  timer = g_slice_new0 (TimerData);
+  timer->idx = priv->timers->len;
+  g_ptr_array_add (priv->timers, timer);
   timer->type = type;
   timer->seqnum = seqnum;
   timer->num = num;
@@ -1701,8 +1989,11 @@ add_timer (GstRtpJitterBuffer * jitterbuffer, TimerType type,
     timer->rtx_retry = 0;
   }
   timer->num_rtx_retry = 0;
+  timer_index_add (priv, timer);
   recalculate_timer (jitterbuffer, timer);
   JBUF_SIGNAL_TIMER (priv);
+  if (priv->timer_shared && !priv->clock_id)
+    queue_shared_timer (jitterbuffer);
 
   return timer;
 }
@@ -1727,6 +2018,7 @@ reschedule_timer (GstRtpJitterBuffer * jitterbuffer, TimerData * timer,
       "replace timer for seqnum %d->%d to %" GST_TIME_FORMAT,
       oldseq, seqnum, GST_TIME_ARGS (timeout + delay));
 
+  timer_index_remove (priv, timer);
   timer->timeout = timeout + delay;
   timer->seqnum = seqnum;
   if (reset) {
@@ -1736,6 +2028,7 @@ reschedule_timer (GstRtpJitterBuffer * jitterbuffer, TimerData * timer,
   }
   if (seqchange)
     timer->num_rtx_retry = 0;
+  timer_index_add (priv, timer);
 
   if (priv->clock_id) {
     /* we changed the seqnum and there is a timer currently waiting with this
@@ -1774,18 +2067,32 @@ remove_timer (GstRtpJitterBuffer * jitterbuffer, TimerData * timer)
   if (priv->clock_id && priv->timer_seqnum == timer->seqnum)
     unschedule_current_timer (jitterbuffer);
 
+  timer_index_remove (priv, timer);
+
   idx = timer->idx;
   GST_DEBUG_OBJECT (jitterbuffer, "removed index %d", idx);
-  g_array_remove_index_fast (priv->timers, idx);
-  timer->idx = idx;
+  g_ptr_array_remove_index_fast (priv->timers, idx);
+  if (idx < priv->timers->len)
+    ((TimerData *) g_ptr_array_index (priv->timers, idx))->idx = idx;
+  g_slice_free (TimerData, timer);
 }
 
 static void
 remove_all_timers (GstRtpJitterBuffer * jitterbuffer)
 {
   GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  guint i;
+
   GST_DEBUG_OBJECT (jitterbuffer, "removed all timers");
-  g_array_set_size (priv->timers, 0);
+  for (i = 0; i < priv->timers->len; i++)
+    g_slice_free (TimerData, g_ptr_array_index (priv->timers, i));
+  g_ptr_array_set_size (priv->timers, 0);
+  g_hash_table_remove_all (priv->timer_index);
+  priv->timer_dups = 0;
+  g_ptr_array_set_size (priv->expected_heap, 0);
+  g_ptr_array_set_size (priv->timer_heap, 0);
+  /* the links are part of the freed timers */
+  g_queue_init (&priv->fresh_timers);
   unschedule_current_timer (jitterbuffer);
 }
 
@@ -1805,32 +2112,35 @@ update_timers (GstRtpJitterBuffer * jitterbuffer, guint16 seqnum,
 {
   GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
   TimerData *timer = NULL;
-  gint i, len;
+  GList *walk, *next;
 
-  /* go through all timers and unschedule the ones with a large gap, also find
-   * the timer for the seqnum */
-  len = priv->timers->len;
-  for (i = 0; i < len; i++) {
-    TimerData *test = &g_array_index (priv->timers, TimerData, i);
+  /* go through the EXPECTED timers that did not request a retransmission yet,
+   * oldest first, and unschedule the ones with a large gap */
+  for (walk = priv->fresh_timers.head; walk; walk = next) {
+    TimerData *test = walk->data;
     gint gap;
 
+    next = walk->next;
     gap = gst_rtp_buffer_compare_seqnum (test->seqnum, seqnum);
 
-    GST_DEBUG_OBJECT (jitterbuffer, "%d, #%d<->#%d gap %d", i,
-        test->seqnum, seqnum, gap);
+    GST_DEBUG_OBJECT (jitterbuffer, "#%d<->#%d gap %d", test->seqnum,
+        seqnum, gap);
 
-    if (gap == 0) {
-      GST_DEBUG ("found timer for current seqnum");
-      /* the timer for the current seqnum */
-      timer = test;
-    } else if (gap > priv->rtx_delay_reorder) {
-      /* max gap, we exceeded the max reorder distance and we don't expect the
-       * missing packet to be this reordered */
-      if (test->num_rtx_retry == 0 && test->type == TIMER_TYPE_EXPECTED)
-        reschedule_timer (jitterbuffer, test, test->seqnum, -1, 0, FALSE);
-    }
+    if (gap == 0)
+      continue;
+    if (gap <= priv->rtx_delay_reorder)
+      break;
+
+    /* max gap, we exceeded the max reorder distance and we don't expect the
+     * missing packet to be this reordered. This removes the timer from the
+     * fresh queue. */
+    reschedule_timer (jitterbuffer, test, test->seqnum, -1, 0, FALSE);
   }
 
+  /* find the timer for the seqnum */
+  if ((timer = find_any_timer (jitterbuffer, seqnum)))
+    GST_DEBUG ("found timer for current seqnum");
+
   do_next_seqnum = do_next_seqnum && priv->packet_spacing > 0
       && priv->do_retransmission;
 
@@ -2015,6 +2325,53 @@ calculate_expected (GstRtpJitterBuffer * jitterbuffer, guint32 expected,
   }
 }
 
+static gint
+compare_clock_time_diff (gconstpointer a, gconstpointer b)
+{
+  GstClockTimeDiff da = *(const GstClockTimeDiff *) a;
+  GstClockTimeDiff db = *(const GstClockTimeDiff *) b;
+
+  return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+/* set the latency to a percentile of the transit time variation */
+static void
+update_adaptive_latency (GstRtpJitterBuffer * jitterbuffer)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  GstClockTimeDiff sorted[ADAPT_WINDOW];
+  GstClockTime target, min, max;
+  guint n, latency_ms;
+
+  n = MIN (priv->adapt_count, ADAPT_WINDOW);
+  memcpy (sorted, priv->adapt_transit, n * sizeof (GstClockTimeDiff));
+  qsort (sorted, n, sizeof (GstClockTimeDiff), compare_clock_time_diff);
+
+  target = sorted[n * ADAPT_PERCENTILE / 100] - sorted[0];
+  target += MAX (priv->packet_spacing, ADAPT_MARGIN);
+
+  min = priv->min_latency_ms * GST_MSECOND;
+  max = MAX (priv->max_latency_ms * GST_MSECOND, min);
+  target = CLAMP (target, min, max);
+
+  /* grow at once to avoid losses, shrink slowly so that the output is only
+   * sped up a little */
+  if (target < priv->latency_ns)
+    target = MAX (target, priv->latency_ns - priv->latency_ns / 10);
+
+  latency_ms = (target + GST_MSECOND - 1) / GST_MSECOND;
+  if (latency_ms == priv->latency_ms)
+    return;
+
+  GST_DEBUG_OBJECT (jitterbuffer, "adapting latency from %u to %u ms",
+      priv->latency_ms, latency_ms);
+
+  priv->latency_ms = latency_ms;
+  priv->latency_ns = latency_ms * GST_MSECOND;
+  rtp_jitter_buffer_set_delay (priv->jbuf, priv->latency_ns);
+  priv->adapt_post = TRUE;
+}
+
 static void
 calculate_jitter (GstRtpJitterBuffer * jitterbuffer, GstClockTime dts,
     guint rtptime)
@@ -2053,6 +2410,26 @@ calculate_jitter (GstRtpJitterBuffer * jitterbuffer, GstClockTime dts,
   /* jitter is stored in nanoseconds */
   priv->avg_jitter = (diff + (15 * priv->avg_jitter)) >> 4;
 
+  if (priv->adaptive_latency) {
+    /* a jump larger than the maximum latency is a discontinuity of the
+     * sender, start measuring again */
+    if (diff > (GstClockTimeDiff) (priv->max_latency_ms * GST_MSECOND))
+      priv->adapt_count = 0;
+
+    /* the transit time relative to the first packet, late and reordered
+     * packets have a larger one */
+    if (priv->adapt_count == 0)
+      priv->adapt_rtp_ns = 0;
+    else
+      priv->adapt_rtp_ns += rtpdiffns;
+    priv->adapt_transit[priv->adapt_count % ADAPT_WINDOW] =
+        (GstClockTimeDiff) dts - priv->adapt_rtp_ns;
+    priv->adapt_count++;
+
+    if (priv->adapt_count % ADAPT_INTERVAL == 0)
+      update_adaptive_latency (jitterbuffer);
+  }
+
   GST_LOG ("dtsdiff %" GST_TIME_FORMAT " rtptime %" GST_TIME_FORMAT
       ", clock-rate %d, diff %" GST_TIME_FORMAT ", jitter: %" GST_TIME_FORMAT,
       GST_TIME_ARGS (dtsdiff), GST_TIME_ARGS (rtpdiffns), priv->clock_rate,
@@ -2084,6 +2461,7 @@ gst_rtp_jitter_buffer_chain (GstPad * pad, GstObject * parent,
   guint8 pt;
   GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
   gboolean do_next_seqnum = FALSE;
+  gboolean post_latency;
   RTPJitterBufferItem *item;
 
   jitterbuffer = GST_RTP_JITTER_BUFFER (parent);
@@ -2295,11 +2673,18 @@ gst_rtp_jitter_buffer_chain (GstPad * pad, GstObject * parent,
   check_buffering_percent (jitterbuffer, &percent);
 
 finished:
+  post_latency = priv->adapt_post;
+  priv->adapt_post = FALSE;
   JBUF_UNLOCK (priv);
 
   if (percent != -1)
     post_buffering_percent (jitterbuffer, percent);
 
+  /* the pipeline has to reconfigure its latency */
+  if (post_latency)
+    gst_element_post_message (GST_ELEMENT_CAST (jitterbuffer),
+        gst_message_new_latency (GST_OBJECT_CAST (jitterbuffer)));
+
   return ret;
 
   /* ERRORS */
@@ -2424,7 +2809,84 @@ update_estimated_eos (GstRtpJitterBuffer * jitterbuffer,
   }
 }
 
-/* take a buffer from the queue and push it */
+/* take the buffer of @item and prepare it for pushing */
+static GstBuffer *
+prepare_output_buffer (GstRtpJitterBuffer * jitterbuffer,
+    RTPJitterBufferItem * item)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  GstBuffer *outbuf;
+  GstClockTime dts, pts;
+
+  /* we need to make writable to change the flags and timestamps */
+  outbuf = gst_buffer_make_writable (item->data);
+  item->data = NULL;
+
+  if (G_UNLIKELY (priv->discont)) {
+    /* set DISCONT flag when we missed a packet. We pushed the buffer writable
+     * into the jitterbuffer so we can modify now. */
+    GST_DEBUG_OBJECT (jitterbuffer, "mark output buffer discont");
+    GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
+    priv->discont = FALSE;
+  }
+  if (G_UNLIKELY (priv->ts_discont)) {
+    GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_RESYNC);
+    priv->ts_discont = FALSE;
+  }
+
+  dts = gst_segment_to_position (&priv->segment, GST_FORMAT_TIME, item->dts);
+  pts = gst_segment_to_position (&priv->segment, GST_FORMAT_TIME, item->pts);
+
+  /* apply timestamp with offset to buffer now */
+  GST_BUFFER_DTS (outbuf) = apply_offset (jitterbuffer, dts);
+  GST_BUFFER_PTS (outbuf) = apply_offset (jitterbuffer, pts);
+
+  /* update the elapsed time when we need to check against the npt stop time. */
+  update_estimated_eos (jitterbuffer, item);
+
+  priv->last_out_time = GST_BUFFER_PTS (outbuf);
+
+  return outbuf;
+}
+
+/* pop the buffers that directly follow @seqnum and can be pushed together
+ * with @first. Returns %NULL when there are none, else a list starting with
+ * @first. @seqnum is updated to the last popped seqnum. */
+static GstBufferList *
+pop_next_buffers (GstRtpJitterBuffer * jitterbuffer, GstBuffer * first,
+    guint * seqnum)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  GstBufferList *list = NULL;
+  RTPJitterBufferItem *item;
+  guint next_seqnum;
+
+  /* in buffering mode every pop can change the buffering percent */
+  if (rtp_jitter_buffer_get_mode (priv->jbuf) == RTP_JITTER_BUFFER_MODE_BUFFER)
+    return NULL;
+
+  next_seqnum = (*seqnum + 1) & 0xffff;
+  while ((item = rtp_jitter_buffer_peek (priv->jbuf))) {
+    if (item->type != ITEM_TYPE_BUFFER || item->seqnum != next_seqnum)
+      break;
+
+    if (list == NULL) {
+      list = gst_buffer_list_new ();
+      gst_buffer_list_add (list, first);
+    } else if (gst_buffer_list_length (list) >= MAX_PUSH_LIST_LENGTH)
+      break;
+
+    item = rtp_jitter_buffer_pop (priv->jbuf, NULL);
+    gst_buffer_list_add (list, prepare_output_buffer (jitterbuffer, item));
+    *seqnum = item->seqnum;
+    next_seqnum = (item->seqnum + 1) & 0xffff;
+    free_item (item);
+  }
+  return list;
+}
+
+/* take a buffer from the queue and push it. Buffers that directly follow it
+ * are pushed along in a buffer list. */
 static GstFlowReturn
 pop_and_push_next (GstRtpJitterBuffer * jitterbuffer, guint seqnum)
 {
@@ -2432,9 +2894,9 @@ pop_and_push_next (GstRtpJitterBuffer * jitterbuffer, guint seqnum)
   GstFlowReturn result = GST_FLOW_OK;
   RTPJitterBufferItem *item;
   GstBuffer *outbuf = NULL;
+  GstBufferList *outlist = NULL;
   GstEvent *outevent = NULL;
   GstQuery *outquery = NULL;
-  GstClockTime dts, pts;
   gint percent = -1;
   gboolean do_push = TRUE;
   guint type;
@@ -2447,34 +2909,8 @@ pop_and_push_next (GstRtpJitterBuffer * jitterbuffer, guint seqnum)
     case ITEM_TYPE_BUFFER:
       check_buffering_percent (jitterbuffer, &percent);
 
-      /* we need to make writable to change the flags and timestamps */
-      outbuf = gst_buffer_make_writable (item->data);
-
-      if (G_UNLIKELY (priv->discont)) {
-        /* set DISCONT flag when we missed a packet. We pushed the buffer writable
-         * into the jitterbuffer so we can modify now. */
-        GST_DEBUG_OBJECT (jitterbuffer, "mark output buffer discont");
-        GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
-        priv->discont = FALSE;
-      }
-      if (G_UNLIKELY (priv->ts_discont)) {
-        GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_RESYNC);
-        priv->ts_discont = FALSE;
-      }
-
-      dts =
-          gst_segment_to_position (&priv->segment, GST_FORMAT_TIME, item->dts);
-      pts =
-          gst_segment_to_position (&priv->segment, GST_FORMAT_TIME, item->pts);
-
-      /* apply timestamp with offset to buffer now */
-      GST_BUFFER_DTS (outbuf) = apply_offset (jitterbuffer, dts);
-      GST_BUFFER_PTS (outbuf) = apply_offset (jitterbuffer, pts);
-
-      /* update the elapsed time when we need to check against the npt stop time. */
-      update_estimated_eos (jitterbuffer, item);
-
-      priv->last_out_time = GST_BUFFER_PTS (outbuf);
+      outbuf = prepare_output_buffer (jitterbuffer, item);
+      outlist = pop_next_buffers (jitterbuffer, outbuf, &seqnum);
       break;
     case ITEM_TYPE_LOST:
       priv->discont = TRUE;
@@ -2506,11 +2942,17 @@ pop_and_push_next (GstRtpJitterBuffer * jitterbuffer, guint seqnum)
       if (percent != -1)
         post_buffering_percent (jitterbuffer, percent);
 
-      GST_DEBUG_OBJECT (jitterbuffer,
-          "Pushing buffer %d, dts %" GST_TIME_FORMAT ", pts %" GST_TIME_FORMAT,
-          seqnum, GST_TIME_ARGS (GST_BUFFER_DTS (outbuf)),
-          GST_TIME_ARGS (GST_BUFFER_PTS (outbuf)));
-      result = gst_pad_push (priv->srcpad, outbuf);
+      if (outlist) {
+        GST_DEBUG_OBJECT (jitterbuffer, "Pushing list of %u buffers up to %d",
+            gst_buffer_list_length (outlist), seqnum);
+        result = gst_pad_push_list (priv->srcpad, outlist);
+      } else {
+        GST_DEBUG_OBJECT (jitterbuffer,
+            "Pushing buffer %d, dts %" GST_TIME_FORMAT ", pts %"
+            GST_TIME_FORMAT, seqnum, GST_TIME_ARGS (GST_BUFFER_DTS (outbuf)),
+            GST_TIME_ARGS (GST_BUFFER_PTS (outbuf)));
+        result = gst_pad_push (priv->srcpad, outbuf);
+      }
 
       JBUF_LOCK_CHECK (priv, out_flushing);
       break;
@@ -2686,6 +3128,7 @@ do_expected_timeout (GstRtpJitterBuffer * jitterbuffer, TimerData * timer,
           NULL));
 
   priv->num_rtx_requests++;
+  timer_index_remove (priv, timer);
   timer->num_rtx_retry++;
 
   GST_OBJECT_LOCK (jitterbuffer);
@@ -2712,6 +3155,7 @@ do_expected_timeout (GstRtpJitterBuffer * jitterbuffer, TimerData * timer,
     timer->rtx_delay = 0;
     timer->rtx_retry = 0;
   }
+  timer_index_add (priv, timer);
   reschedule_timer (jitterbuffer, timer, timer->seqnum,
       timer->rtx_base + timer->rtx_retry, timer->rtx_delay, FALSE);
 
@@ -2823,10 +3267,42 @@ do_timeout (GstRtpJitterBuffer * jitterbuffer, TimerData * timer,
   return removed;
 }
 
+/* get the timer that expires first and its timeout */
+static TimerData *
+get_next_timer (GstRtpJitterBuffer * jitterbuffer, GstClockTime * timeout)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+  TimerData *timer = NULL;
+  GstClockTime timer_timeout = -1;
+
+  /* the earliest timer is at the top of one of the heaps */
+  if (priv->expected_heap->len > 0) {
+    timer = g_ptr_array_index (priv->expected_heap, 0);
+    timer_timeout = get_timeout (jitterbuffer, timer);
+  }
+  if (priv->timer_heap->len > 0) {
+    TimerData *test = g_ptr_array_index (priv->timer_heap, 0);
+    GstClockTime test_timeout = get_timeout (jitterbuffer, test);
+
+    if (timer == NULL || timer_earlier (test_timeout, test->seqnum,
+            timer_timeout, timer->seqnum)) {
+      timer = test;
+      timer_timeout = test_timeout;
+    }
+  }
+  if (timer) {
+    GST_DEBUG_OBJECT (jitterbuffer, "best %d, %d, %" GST_TIME_FORMAT,
+        timer->type, timer->seqnum, GST_TIME_ARGS (timer_timeout));
+  }
+
+  *timeout = timer_timeout;
+  return timer;
+}
+
 /* called when we need to wait for the next timeout.
  *
- * We loop over the array of recorded timeouts and wait for the earliest one.
- * When it timed out, do the logic associated with the timer.
+ * We take the earliest of the recorded timeouts from the heaps and wait for
+ * it. When it timed out, do the logic associated with the timer.
  *
  * If there are no timers, we wait on a gcond until something new happens.
  */
@@ -2838,50 +3314,14 @@ wait_next_timeout (GstRtpJitterBuffer * jitterbuffer)
 
   JBUF_LOCK (priv);
   while (priv->timer_running) {
-    TimerData *timer = NULL;
-    GstClockTime timer_timeout = -1;
-    gint i, len;
+    TimerData *timer;
+    GstClockTime timer_timeout;
 
     GST_DEBUG_OBJECT (jitterbuffer, "now %" GST_TIME_FORMAT,
         GST_TIME_ARGS (now));
 
-    len = priv->timers->len;
-    for (i = 0; i < len; i++) {
-      TimerData *test = &g_array_index (priv->timers, TimerData, i);
-      GstClockTime test_timeout = get_timeout (jitterbuffer, test);
-      gboolean save_best = FALSE;
-
-      GST_DEBUG_OBJECT (jitterbuffer, "%d, %d, %d, %" GST_TIME_FORMAT,
-          i, test->type, test->seqnum, GST_TIME_ARGS (test_timeout));
-
-      /* find the smallest timeout */
-      if (timer == NULL) {
-        save_best = TRUE;
-      } else if (timer_timeout == -1) {
-        /* we already have an immediate timeout, the new timer must be an
-         * immediate timer with smaller seqnum to become the best */
-        if (test_timeout == -1
-            && (gst_rtp_buffer_compare_seqnum (test->seqnum,
-                    timer->seqnum) > 0))
-          save_best = TRUE;
-      } else if (test_timeout == -1) {
-        /* first immediate timer */
-        save_best = TRUE;
-      } else if (test_timeout < timer_timeout) {
-        /* earlier timer */
-        save_best = TRUE;
-      } else if (test_timeout == timer_timeout
-          && (gst_rtp_buffer_compare_seqnum (test->seqnum,
-                  timer->seqnum) > 0)) {
-        /* same timer, smaller seqnum */
-        save_best = TRUE;
-      }
-      if (save_best) {
-        GST_DEBUG_OBJECT (jitterbuffer, "new best %d", i);
-        timer = test;
-        timer_timeout = test_timeout;
-      }
-    }
+    timer = get_next_timer (jitterbuffer, &timer_timeout);
+
     if (timer && !priv->blocked) {
       GstClock *clock;
       GstClockTime sync_time;
@@ -2952,6 +3392,128 @@ wait_next_timeout (GstRtpJitterBuffer * jitterbuffer)
   return;
 }
 
+static void handle_shared_timer (GstRtpJitterBuffer * jitterbuffer,
+    gpointer user_data);
+
+static GThreadPool *
+get_shared_timer_pool (void)
+{
+  static gsize pool = 0;
+
+  if (g_once_init_enter (&pool)) {
+    GThreadPool *p;
+
+    p = g_thread_pool_new ((GFunc) handle_shared_timer, NULL,
+        SHARED_TIMER_THREADS, FALSE, NULL);
+    g_once_init_leave (&pool, (gsize) p);
+  }
+  return (GThreadPool *) pool;
+}
+
+/* let a thread of the shared pool handle our timers, must be called with the
+ * JBUF_LOCK */
+static void
+queue_shared_timer (GstRtpJitterBuffer * jitterbuffer)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+
+  /* a busy thread looks for the next timer by itself when it is done */
+  if (!priv->timer_running || priv->timer_queued || priv->timer_busy)
+    return;
+
+  priv->timer_queued = TRUE;
+  g_thread_pool_push (get_shared_timer_pool (), gst_object_ref (jitterbuffer),
+      NULL);
+}
+
+/* called from the clock thread when the scheduled timer expired */
+static gboolean
+shared_timer_expired (GstClock * clock, GstClockTime time, GstClockID id,
+    gpointer user_data)
+{
+  GstRtpJitterBuffer *jitterbuffer = user_data;
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+
+  JBUF_LOCK (priv);
+  if (priv->clock_id == id) {
+    gst_clock_id_unref (priv->clock_id);
+    priv->clock_id = NULL;
+    queue_shared_timer (jitterbuffer);
+  }
+  JBUF_UNLOCK (priv);
+
+  return TRUE;
+}
+
+/* called from the shared pool. Handle the timers that expired and schedule an
+ * async wait on the clock for the next one. */
+static void
+handle_shared_timer (GstRtpJitterBuffer * jitterbuffer, gpointer user_data)
+{
+  GstRtpJitterBufferPrivate *priv = jitterbuffer->priv;
+
+  JBUF_LOCK (priv);
+  priv->timer_queued = FALSE;
+  priv->timer_busy = TRUE;
+  while (priv->timer_running && !priv->blocked) {
+    TimerData *timer;
+    GstClockTime timer_timeout, sync_time, now;
+    GstClock *clock;
+    GstClockID id;
+
+    timer = get_next_timer (jitterbuffer, &timer_timeout);
+    if (timer == NULL)
+      break;
+
+    GST_OBJECT_LOCK (jitterbuffer);
+    clock = GST_ELEMENT_CLOCK (jitterbuffer);
+    /* timer timeouts are in running time of the input */
+    sync_time = GST_ELEMENT_CAST (jitterbuffer)->base_time + priv->peer_latency;
+    if (clock) {
+      now = gst_clock_get_time (clock);
+      now = now > sync_time ? now - sync_time : 0;
+    } else {
+      /* let's just push if there is no clock */
+      now = timer_timeout;
+    }
+
+    if (timer_timeout == -1 || timer_timeout <= now) {
+      GST_OBJECT_UNLOCK (jitterbuffer);
+      do_timeout (jitterbuffer, timer, now);
+      continue;
+    }
+
+    /* the clock is already waiting for this timer */
+    if (priv->clock_id && priv->timer_timeout == timer_timeout &&
+        priv->timer_seqnum == timer->seqnum) {
+      GST_OBJECT_UNLOCK (jitterbuffer);
+      break;
+    }
+
+    id = gst_clock_new_single_shot_id (clock, sync_time + timer_timeout);
+    GST_OBJECT_UNLOCK (jitterbuffer);
+
+    if (priv->clock_id) {
+      gst_clock_id_unschedule (priv->clock_id);
+      gst_clock_id_unref (priv->clock_id);
+    }
+    priv->clock_id = id;
+    priv->timer_timeout = timer_timeout;
+    priv->timer_seqnum = timer->seqnum;
+
+    GST_DEBUG_OBJECT (jitterbuffer, "sync to timestamp %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (timer_timeout));
+    gst_clock_id_wait_async (id, shared_timer_expired,
+        gst_object_ref (jitterbuffer), (GDestroyNotify) gst_object_unref);
+    break;
+  }
+  priv->timer_busy = FALSE;
+  JBUF_SIGNAL_TIMER (priv);
+  JBUF_UNLOCK (priv);
+
+  gst_object_unref (jitterbuffer);
+}
+
 /*
  * This funcion implements the main pushing loop on the source pad.
  *
@@ -3394,6 +3956,27 @@ gst_rtp_jitter_buffer_set_property (GObject * object,
       priv->rtx_retry_period = g_value_get_int (value);
       JBUF_UNLOCK (priv);
       break;
+    case PROP_SHARED_TIMERS:
+      JBUF_LOCK (priv);
+      priv->shared_timers = g_value_get_boolean (value);
+      JBUF_UNLOCK (priv);
+      break;
+    case PROP_ADAPTIVE_LATENCY:
+      JBUF_LOCK (priv);
+      priv->adaptive_latency = g_value_get_boolean (value);
+      priv->adapt_count = 0;
+      JBUF_UNLOCK (priv);
+      break;
+    case PROP_MIN_LATENCY:
+      JBUF_LOCK (priv);
+      priv->min_latency_ms = g_value_get_uint (value);
+      JBUF_UNLOCK (priv);
+      break;
+    case PROP_MAX_LATENCY:
+      JBUF_LOCK (priv);
+      priv->max_latency_ms = g_value_get_uint (value);
+      JBUF_UNLOCK (priv);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3475,6 +4058,26 @@ gst_rtp_jitter_buffer_get_property (GObject * object,
       g_value_set_int (value, priv->rtx_retry_period);
       JBUF_UNLOCK (priv);
       break;
+    case PROP_SHARED_TIMERS:
+      JBUF_LOCK (priv);
+      g_value_set_boolean (value, priv->shared_timers);
+      JBUF_UNLOCK (priv);
+      break;
+    case PROP_ADAPTIVE_LATENCY:
+      JBUF_LOCK (priv);
+      g_value_set_boolean (value, priv->adaptive_latency);
+      JBUF_UNLOCK (priv);
+      break;
+    case PROP_MIN_LATENCY:
+      JBUF_LOCK (priv);
+      g_value_set_uint (value, priv->min_latency_ms);
+      JBUF_UNLOCK (priv);
+      break;
+    case PROP_MAX_LATENCY:
+      JBUF_LOCK (priv);
+      g_value_set_uint (value, priv->max_latency_ms);
+      JBUF_UNLOCK (priv);
+      break;
     case PROP_STATS:
       g_value_take_boxed (value,
           gst_rtp_jitter_buffer_create_stats (jitterbuffer));
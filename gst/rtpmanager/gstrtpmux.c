@@ -371,11 +371,28 @@ process_buffer_locked (GstRTPMux * rtp_mux, GstRTPMuxPadPrivate * padpriv,
   return TRUE;
 }
 
+static gboolean
+resend_events (GstPad * pad, GstEvent ** event, gpointer user_data)
+{
+  GstRTPMux *rtp_mux = user_data;
+
+  if (GST_EVENT_TYPE (*event) == GST_EVENT_CAPS) {
+    GstCaps *caps;
+
+    gst_event_parse_caps (*event, &caps);
+    gst_rtp_mux_setcaps (pad, rtp_mux, caps);
+  } else {
+    gst_pad_push_event (rtp_mux->srcpad, gst_event_ref (*event));
+  }
+
+  return TRUE;
+}
+
 struct BufferListData
 {
   GstRTPMux *rtp_mux;
   GstRTPMuxPadPrivate *padpriv;
-  gboolean drop;
+  guint n_pushed;
 };
 
 static gboolean
@@ -383,17 +400,28 @@ process_list_item (GstBuffer ** buffer, guint idx, gpointer user_data)
 {
   struct BufferListData *bd = user_data;
   GstRTPBuffer rtpbuffer = GST_RTP_BUFFER_INIT;
+  gboolean drop;
 
+  /* the headers are rewritten in place, this only copies if the buffer is
+   * shared */
   *buffer = gst_buffer_make_writable (*buffer);
 
-  gst_rtp_buffer_map (*buffer, GST_MAP_READWRITE, &rtpbuffer);
+  if (!gst_rtp_buffer_map (*buffer, GST_MAP_READWRITE, &rtpbuffer)) {
+    GST_WARNING_OBJECT (bd->rtp_mux, "Invalid RTP buffer in list, dropping");
+    drop = TRUE;
+  } else {
+    drop = !process_buffer_locked (bd->rtp_mux, bd->padpriv, &rtpbuffer);
+    gst_rtp_buffer_unmap (&rtpbuffer);
+  }
 
-  bd->drop = !process_buffer_locked (bd->rtp_mux, bd->padpriv, &rtpbuffer);
+  if (drop) {
+    /* remove it from the list and go on with the others */
+    gst_buffer_unref (*buffer);
+    *buffer = NULL;
+    return TRUE;
+  }
 
-  gst_rtp_buffer_unmap (&rtpbuffer);
-
-  if (bd->drop)
-    return FALSE;
+  bd->n_pushed++;
 
   if (GST_BUFFER_DURATION_IS_VALID (*buffer) &&
       GST_BUFFER_TIMESTAMP_IS_VALID (*buffer))
@@ -412,11 +440,12 @@ gst_rtp_mux_chain_list (GstPad * pad, GstObject * parent,
   GstRTPMux *rtp_mux;
   GstFlowReturn ret;
   GstRTPMuxPadPrivate *padpriv;
-  gboolean drop = TRUE;
+  gboolean changed = FALSE;
   struct BufferListData bd;
 
   rtp_mux = GST_RTP_MUX (parent);
 
+  /* all buffers of the list are handled with a single lock */
   GST_OBJECT_LOCK (rtp_mux);
 
   padpriv = gst_pad_get_element_private (pad);
@@ -429,14 +458,23 @@ gst_rtp_mux_chain_list (GstPad * pad, GstObject * parent,
 
   bd.rtp_mux = rtp_mux;
   bd.padpriv = padpriv;
-  bd.drop = FALSE;
+  bd.n_pushed = 0;
 
   bufferlist = gst_buffer_list_make_writable (bufferlist);
   gst_buffer_list_foreach (bufferlist, process_list_item, &bd);
 
+  if (bd.n_pushed > 0 && pad != rtp_mux->last_pad) {
+    changed = TRUE;
+    g_clear_object (&rtp_mux->last_pad);
+    rtp_mux->last_pad = g_object_ref (pad);
+  }
+
   GST_OBJECT_UNLOCK (rtp_mux);
 
-  if (drop) {
+  if (changed)
+    gst_pad_sticky_events_foreach (pad, resend_events, rtp_mux);
+
+  if (bd.n_pushed == 0) {
     gst_buffer_list_unref (bufferlist);
     ret = GST_FLOW_OK;
   } else {
@@ -448,23 +486,6 @@ out:
   return ret;
 }
 
-static gboolean
-resend_events (GstPad * pad, GstEvent ** event, gpointer user_data)
-{
-  GstRTPMux *rtp_mux = user_data;
-
-  if (GST_EVENT_TYPE (*event) == GST_EVENT_CAPS) {
-    GstCaps *caps;
-
-    gst_event_parse_caps (*event, &caps);
-    gst_rtp_mux_setcaps (pad, rtp_mux, caps);
-  } else {
-    gst_pad_push_event (rtp_mux->srcpad, gst_event_ref (*event));
-  }
-
-  return TRUE;
-}
-
 static GstFlowReturn
 gst_rtp_mux_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
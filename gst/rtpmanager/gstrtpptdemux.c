@@ -128,6 +128,8 @@ static gboolean gst_rtp_pt_demux_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static GstFlowReturn gst_rtp_pt_demux_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buf);
+static GstFlowReturn gst_rtp_pt_demux_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static GstStateChangeReturn gst_rtp_pt_demux_change_state (GstElement * element,
     GstStateChange transition);
 static void gst_rtp_pt_demux_clear_pt_map (GstRtpPtDemux * rtpdemux);
@@ -233,6 +235,7 @@ gst_rtp_pt_demux_init (GstRtpPtDemux * ptdemux)
   g_assert (ptdemux->sink != NULL);
 
   gst_pad_set_chain_function (ptdemux->sink, gst_rtp_pt_demux_chain);
+  gst_pad_set_chain_list_function (ptdemux->sink, gst_rtp_pt_demux_chain_list);
   gst_pad_set_event_function (ptdemux->sink, gst_rtp_pt_demux_sink_event);
 
   gst_element_add_pad (GST_ELEMENT (ptdemux), ptdemux->sink);
@@ -296,17 +299,11 @@ gst_rtp_pt_demux_clear_pt_map (GstRtpPtDemux * rtpdemux)
 static gboolean
 need_caps_for_pt (GstRtpPtDemux * rtpdemux, guint8 pt)
 {
-  GSList *walk;
   gboolean ret = FALSE;
 
   GST_OBJECT_LOCK (rtpdemux);
-  for (walk = rtpdemux->srcpads; walk; walk = g_slist_next (walk)) {
-    GstRtpPtDemuxPad *pad = walk->data;
-
-    if (pad->pt == pt) {
-      ret = pad->newcaps;
-    }
-  }
+  if (rtpdemux->pt_pads[pt & 0x7f])
+    ret = rtpdemux->pt_pads[pt & 0x7f]->newcaps;
   GST_OBJECT_UNLOCK (rtpdemux);
 
   return ret;
@@ -316,17 +313,9 @@ need_caps_for_pt (GstRtpPtDemux * rtpdemux, guint8 pt)
 static void
 clear_newcaps_for_pt (GstRtpPtDemux * rtpdemux, guint8 pt)
 {
-  GSList *walk;
-
   GST_OBJECT_LOCK (rtpdemux);
-  for (walk = rtpdemux->srcpads; walk; walk = g_slist_next (walk)) {
-    GstRtpPtDemuxPad *pad = walk->data;
-
-    if (pad->pt == pt) {
-      pad->newcaps = FALSE;
-      break;
-    }
-  }
+  if (rtpdemux->pt_pads[pt & 0x7f])
+    rtpdemux->pt_pads[pt & 0x7f]->newcaps = FALSE;
   GST_OBJECT_UNLOCK (rtpdemux);
 }
 
@@ -342,25 +331,13 @@ forward_sticky_events (GstPad * pad, GstEvent ** event, gpointer user_data)
   return TRUE;
 }
 
-static GstFlowReturn
-gst_rtp_pt_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+/* Returns the srcpad for @pt, creating it and updating its caps if needed,
+ * or NULL if there are no caps for @pt */
+static GstPad *
+gst_rtp_pt_demux_get_src_pad (GstRtpPtDemux * rtpdemux, guint8 pt)
 {
-  GstFlowReturn ret = GST_FLOW_OK;
-  GstRtpPtDemux *rtpdemux;
-  guint8 pt;
   GstPad *srcpad;
   GstCaps *caps;
-  GstRTPBuffer rtp = { NULL };
-
-  rtpdemux = GST_RTP_PT_DEMUX (parent);
-
-  if (!gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp))
-    goto invalid_buffer;
-
-  pt = gst_rtp_buffer_get_payload_type (&rtp);
-  gst_rtp_buffer_unmap (&rtp);
-
-  GST_DEBUG_OBJECT (rtpdemux, "received buffer for pt %d", pt);
 
   srcpad = find_pad_for_pt (rtpdemux, pt);
   if (srcpad == NULL) {
@@ -390,6 +367,7 @@ gst_rtp_pt_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
     gst_object_ref (srcpad);
     GST_OBJECT_LOCK (rtpdemux);
     rtpdemux->srcpads = g_slist_append (rtpdemux->srcpads, rtpdemuxpad);
+    rtpdemux->pt_pads[pt] = rtpdemuxpad;
     GST_OBJECT_UNLOCK (rtpdemux);
 
     gst_pad_set_active (srcpad, TRUE);
@@ -440,6 +418,44 @@ gst_rtp_pt_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
     gst_caps_unref (caps);
   }
 
+  return srcpad;
+
+  /* ERRORS */
+no_caps:
+  {
+    GST_ELEMENT_ERROR (rtpdemux, STREAM, DECODE, (NULL),
+        ("Could not get caps for payload"));
+    if (srcpad)
+      gst_object_unref (srcpad);
+    return NULL;
+  }
+}
+
+static GstFlowReturn
+gst_rtp_pt_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstRtpPtDemux *rtpdemux;
+  guint8 pt;
+  GstPad *srcpad;
+  GstRTPBuffer rtp = { NULL };
+
+  rtpdemux = GST_RTP_PT_DEMUX (parent);
+
+  if (!gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp))
+    goto invalid_buffer;
+
+  pt = gst_rtp_buffer_get_payload_type (&rtp);
+  gst_rtp_buffer_unmap (&rtp);
+
+  GST_DEBUG_OBJECT (rtpdemux, "received buffer for pt %d", pt);
+
+  srcpad = gst_rtp_pt_demux_get_src_pad (rtpdemux, pt);
+  if (srcpad == NULL) {
+    gst_buffer_unref (buf);
+    return GST_FLOW_ERROR;
+  }
+
   /* push to srcpad */
   ret = gst_pad_push (srcpad, buf);
 
@@ -456,32 +472,86 @@ invalid_buffer:
     gst_buffer_unref (buf);
     return GST_FLOW_ERROR;
   }
-no_caps:
-  {
-    GST_ELEMENT_ERROR (rtpdemux, STREAM, DECODE, (NULL),
-        ("Could not get caps for payload"));
-    gst_buffer_unref (buf);
-    if (srcpad)
-      gst_object_unref (srcpad);
+}
+
+/* pushes @list, all with payload type @pt */
+static GstFlowReturn
+gst_rtp_pt_demux_push_list (GstRtpPtDemux * rtpdemux, guint8 pt,
+    GstBufferList * list)
+{
+  GstFlowReturn ret;
+  GstPad *srcpad;
+
+  srcpad = gst_rtp_pt_demux_get_src_pad (rtpdemux, pt);
+  if (srcpad == NULL) {
+    gst_buffer_list_unref (list);
     return GST_FLOW_ERROR;
   }
+
+  ret = gst_pad_push_list (srcpad, list);
+  gst_object_unref (srcpad);
+
+  return ret;
 }
 
-static GstPad *
-find_pad_for_pt (GstRtpPtDemux * rtpdemux, guint8 pt)
+/* Consecutive buffers with the same payload type, usually all of them, are
+ * pushed together as a list */
+static GstFlowReturn
+gst_rtp_pt_demux_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
 {
-  GstPad *respad = NULL;
-  GSList *walk;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstRtpPtDemux *rtpdemux;
+  GstBufferList *run = NULL;
+  guint8 pt, run_pt = 0;
+  guint i, len;
 
-  GST_OBJECT_LOCK (rtpdemux);
-  for (walk = rtpdemux->srcpads; walk; walk = g_slist_next (walk)) {
-    GstRtpPtDemuxPad *pad = walk->data;
+  rtpdemux = GST_RTP_PT_DEMUX (parent);
 
-    if (pad->pt == pt) {
-      respad = gst_object_ref (pad->pad);
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len && ret == GST_FLOW_OK; i++) {
+    GstBuffer *buf = gst_buffer_list_get (list, i);
+    GstRTPBuffer rtp = { NULL };
+
+    if (!gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp)) {
+      GST_ELEMENT_ERROR (rtpdemux, STREAM, DECODE, (NULL),
+          ("Dropping invalid RTP payload"));
+      ret = GST_FLOW_ERROR;
       break;
     }
+    pt = gst_rtp_buffer_get_payload_type (&rtp);
+    gst_rtp_buffer_unmap (&rtp);
+
+    if (run && pt != run_pt) {
+      ret = gst_rtp_pt_demux_push_list (rtpdemux, run_pt, run);
+      run = NULL;
+    }
+    if (run == NULL) {
+      run = gst_buffer_list_new_sized (len - i);
+      run_pt = pt;
+    }
+    gst_buffer_list_add (run, gst_buffer_ref (buf));
+  }
+
+  if (run) {
+    if (ret == GST_FLOW_OK)
+      ret = gst_rtp_pt_demux_push_list (rtpdemux, run_pt, run);
+    else
+      gst_buffer_list_unref (run);
   }
+  gst_buffer_list_unref (list);
+
+  return ret;
+}
+
+static GstPad *
+find_pad_for_pt (GstRtpPtDemux * rtpdemux, guint8 pt)
+{
+  GstPad *respad = NULL;
+
+  GST_OBJECT_LOCK (rtpdemux);
+  if (rtpdemux->pt_pads[pt & 0x7f])
+    respad = gst_object_ref (rtpdemux->pt_pads[pt & 0x7f]->pad);
   GST_OBJECT_UNLOCK (rtpdemux);
 
   return respad;
@@ -583,6 +653,7 @@ static gboolean
 gst_rtp_pt_demux_setup (GstRtpPtDemux * ptdemux)
 {
   ptdemux->srcpads = NULL;
+  memset (ptdemux->pt_pads, 0, sizeof (ptdemux->pt_pads));
   ptdemux->last_pt = 0xFFFF;
 
   return TRUE;
@@ -600,6 +671,7 @@ gst_rtp_pt_demux_release (GstRtpPtDemux * ptdemux)
   GST_OBJECT_LOCK (ptdemux);
   tmppads = ptdemux->srcpads;
   ptdemux->srcpads = NULL;
+  memset (ptdemux->pt_pads, 0, sizeof (ptdemux->pt_pads));
   GST_OBJECT_UNLOCK (ptdemux);
 
   for (walk = tmppads; walk; walk = g_slist_next (walk)) {
@@ -213,12 +213,69 @@ gst_rtp_rtx_receive_class_init (GstRtpRtxReceiveClass * klass)
       GST_DEBUG_FUNCPTR (gst_rtp_rtx_receive_change_state);
 }
 
+/* slots that are searched for a seqnum in the pending requests table */
+#define PENDING_PROBES 8
+/* pending requests are forgotten after this many us */
+#define PENDING_TIMEOUT (10 * G_USEC_PER_SEC)
+
+static GstRtpRtxPendingRequest *
+gst_rtp_rtx_receive_pending_lookup (GstRtpRtxReceive * rtx, guint16 seqnum,
+    gint64 now)
+{
+  GstRtpRtxPendingRequest *req;
+  guint i;
+
+  for (i = 0; i < PENDING_PROBES; i++) {
+    req = &rtx->pending[(seqnum + i) & (GST_RTP_RTX_RECEIVE_PENDING_SIZE - 1)];
+    if (!req->used)
+      continue;
+    if (now - req->time > PENDING_TIMEOUT) {
+      GST_LOG_OBJECT (rtx, "request for seqnum %" G_GUINT16_FORMAT
+          " expired", req->seqnum);
+      req->used = FALSE;
+      continue;
+    }
+    if (req->seqnum == seqnum)
+      return req;
+  }
+
+  return NULL;
+}
+
+/* takes a free or expired slot, or replaces the oldest request */
+static void
+gst_rtp_rtx_receive_pending_insert (GstRtpRtxReceive * rtx, guint16 seqnum,
+    guint32 ssrc, gint64 now)
+{
+  GstRtpRtxPendingRequest *req, *oldest = NULL;
+  guint i;
+
+  for (i = 0; i < PENDING_PROBES; i++) {
+    req = &rtx->pending[(seqnum + i) & (GST_RTP_RTX_RECEIVE_PENDING_SIZE - 1)];
+    if (!req->used || now - req->time > PENDING_TIMEOUT) {
+      oldest = req;
+      break;
+    }
+    if (oldest == NULL || req->time < oldest->time)
+      oldest = req;
+  }
+
+  if (oldest->used && now - oldest->time <= PENDING_TIMEOUT)
+    GST_DEBUG_OBJECT (rtx, "too many pending requests, forgetting seqnum %"
+        G_GUINT16_FORMAT, oldest->seqnum);
+
+  oldest->seqnum = seqnum;
+  oldest->ssrc = ssrc;
+  oldest->time = now;
+  oldest->used = TRUE;
+}
+
 static void
 gst_rtp_rtx_receive_reset (GstRtpRtxReceive * rtx)
 {
   GST_OBJECT_LOCK (rtx);
   g_hash_table_remove_all (rtx->ssrc2_ssrc1_map);
-  g_hash_table_remove_all (rtx->seqnum_ssrc1_map);
+  memset (rtx->pending, 0, sizeof (rtx->pending));
   rtx->num_rtx_requests = 0;
   rtx->num_rtx_packets = 0;
   rtx->num_rtx_assoc_packets = 0;
@@ -231,7 +288,6 @@ gst_rtp_rtx_receive_finalize (GObject * object)
   GstRtpRtxReceive *rtx = GST_RTP_RTX_RECEIVE (object);
 
   g_hash_table_unref (rtx->ssrc2_ssrc1_map);
-  g_hash_table_unref (rtx->seqnum_ssrc1_map);
   g_hash_table_unref (rtx->rtx_pt_map);
   if (rtx->rtx_pt_map_structure)
     gst_structure_free (rtx->rtx_pt_map_structure);
@@ -263,7 +319,6 @@ gst_rtp_rtx_receive_init (GstRtpRtxReceive * rtx)
   gst_element_add_pad (GST_ELEMENT (rtx), rtx->sinkpad);
 
   rtx->ssrc2_ssrc1_map = g_hash_table_new (g_direct_hash, g_direct_equal);
-  rtx->seqnum_ssrc1_map = g_hash_table_new (g_direct_hash, g_direct_equal);
 
   rtx->rtx_pt_map = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
@@ -284,8 +339,9 @@ gst_rtp_rtx_receive_src_event (GstPad * pad, GstObject * parent,
       if (gst_structure_has_name (s, "GstRTPRetransmissionRequest")) {
         guint seqnum = 0;
         guint ssrc = 0;
-        gpointer ssrc1 = 0;
         gpointer ssrc2 = 0;
+        GstRtpRtxPendingRequest *req;
+        gint64 now = g_get_monotonic_time ();
 
         /* retrieve seqnum of the packet that need to be restransmisted */
         if (!gst_structure_get_uint (s, "seqnum", &seqnum))
@@ -319,9 +375,9 @@ gst_rtp_rtx_receive_src_event (GstPad * pad, GstObject * parent,
           /* not already associated but also we have to check that we have not
            * already considered this request.
            */
-          if (g_hash_table_lookup_extended (rtx->seqnum_ssrc1_map,
-                  GUINT_TO_POINTER (seqnum), NULL, &ssrc1)) {
-            if (GPOINTER_TO_UINT (ssrc1) == ssrc) {
+          req = gst_rtp_rtx_receive_pending_lookup (rtx, seqnum, now);
+          if (req) {
+            if (req->ssrc == ssrc) {
               /* do nothing because we have already considered this request
                * The jitter may be too impatient of the rtx packet has been
                * lost too.
@@ -343,8 +399,7 @@ gst_rtp_rtx_receive_src_event (GstPad * pad, GstObject * parent,
               res = TRUE;
 
               /* remove seqnum in order to reuse the spot */
-              g_hash_table_remove (rtx->seqnum_ssrc1_map,
-                  GUINT_TO_POINTER (seqnum));
+              req->used = FALSE;
 
               /* do not forward the event as we are rejecting this request */
               GST_OBJECT_UNLOCK (rtx);
@@ -357,8 +412,7 @@ gst_rtp_rtx_receive_src_event (GstPad * pad, GstObject * parent,
             GST_DEBUG_OBJECT (rtx,
                 "packet number %" G_GUINT32_FORMAT " of master stream %"
                 G_GUINT32_FORMAT " needs to be retransmited", seqnum, ssrc);
-            g_hash_table_insert (rtx->seqnum_ssrc1_map,
-                GUINT_TO_POINTER (seqnum), GUINT_TO_POINTER (ssrc));
+            gst_rtp_rtx_receive_pending_insert (rtx, seqnum, ssrc, now);
           }
         }
 
@@ -490,11 +544,15 @@ gst_rtp_rtx_receive_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
           GPOINTER_TO_UINT (ssrc1));
       ssrc2 = ssrc;
     } else {
+      GstRtpRtxPendingRequest *req;
+
       /* the current retransmisted packet has its rtx stream not already
        * associated to a master stream, so retrieve it from our request
        * history */
-      if (g_hash_table_lookup_extended (rtx->seqnum_ssrc1_map,
-              GUINT_TO_POINTER (orign_seqnum), NULL, &ssrc1)) {
+      req = gst_rtp_rtx_receive_pending_lookup (rtx, orign_seqnum,
+          g_get_monotonic_time ());
+      if (req) {
+        ssrc1 = GUINT_TO_POINTER (req->ssrc);
         GST_DEBUG_OBJECT (rtx,
             "associate retransmisted stream %" G_GUINT32_FORMAT
             " to master stream %" G_GUINT32_FORMAT " thanks to packet %"
@@ -503,8 +561,7 @@ gst_rtp_rtx_receive_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
         /* free the spot so that this seqnum can be used to do another
          * association */
-        g_hash_table_remove (rtx->seqnum_ssrc1_map,
-            GUINT_TO_POINTER (orign_seqnum));
+        req->used = FALSE;
 
         /* actually do the association between rtx stream and master stream */
         g_hash_table_insert (rtx->ssrc2_ssrc1_map, GUINT_TO_POINTER (ssrc2),
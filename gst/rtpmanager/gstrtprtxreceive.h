@@ -37,6 +37,19 @@ G_BEGIN_DECLS
 typedef struct _GstRtpRtxReceive GstRtpRtxReceive;
 typedef struct _GstRtpRtxReceiveClass GstRtpRtxReceiveClass;
 
+/* number of retransmission requests that can be pending at the same time,
+ * must be a power of two */
+#define GST_RTP_RTX_RECEIVE_PENDING_SIZE 1024
+
+typedef struct
+{
+  guint16 seqnum;
+  gboolean used;
+  guint32 ssrc;
+  /* monotonic time of the request in us */
+  gint64 time;
+} GstRtpRtxPendingRequest;
+
 struct _GstRtpRtxReceive
 {
   GstElement element;
@@ -51,8 +64,9 @@ struct _GstRtpRtxReceive
   GHashTable *ssrc2_ssrc1_map;
 
   /* contains seqnum of request packets of whom their ssrc have
-   * not been associated to a rtx stream yet */
-  GHashTable *seqnum_ssrc1_map;
+   * not been associated to a rtx stream yet, an open addressing table
+   * indexed by seqnum. Requests that are not answered expire. */
+  GstRtpRtxPendingRequest pending[GST_RTP_RTX_RECEIVE_PENDING_SIZE];
 
   /* rtx pt (uint) -> origin pt (uint) */
   GHashTable *rtx_pt_map;
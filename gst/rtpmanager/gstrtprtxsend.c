@@ -109,12 +109,10 @@ typedef struct
   GstBuffer *buffer;
 } BufferQueueItem;
 
-static void
-buffer_queue_item_free (BufferQueueItem * item)
-{
-  gst_buffer_unref (item->buffer);
-  g_slice_free (BufferQueueItem, item);
-}
+/* initial and maximum number of slots in the history, the history never
+ * spans more than half of the seqnum space so that seqnum order is clear */
+#define HISTORY_MIN_SIZE 64
+#define HISTORY_MAX_SIZE 32768
 
 typedef struct
 {
@@ -122,8 +120,15 @@ typedef struct
   guint16 next_seqnum;
   gint clock_rate;
 
-  /* history of rtp packets */
-  GSequence *queue;
+  /* history of rtp packets, a ring indexed by seqnum & (history_size - 1).
+   * It covers the seqnums from history_tail to history_head, and history_len
+   * is their number, or 0 if it is empty. Slots outside of that range are
+   * always empty and history_tail and history_head are always set. */
+  BufferQueueItem *history;
+  guint history_size;
+  guint history_len;
+  guint16 history_head;
+  guint16 history_tail;
 } SSRCRtxData;
 
 static SSRCRtxData *
@@ -133,15 +138,127 @@ ssrc_rtx_data_new (guint32 rtx_ssrc)
 
   data->rtx_ssrc = rtx_ssrc;
   data->next_seqnum = g_random_int_range (0, G_MAXUINT16);
-  data->queue = g_sequence_new ((GDestroyNotify) buffer_queue_item_free);
+  data->history_size = HISTORY_MIN_SIZE;
+  data->history = g_new0 (BufferQueueItem, data->history_size);
 
   return data;
 }
 
+static inline BufferQueueItem *
+ssrc_rtx_data_slot (SSRCRtxData * data, guint16 seqnum)
+{
+  return &data->history[seqnum & (data->history_size - 1)];
+}
+
+/* removes the oldest packet and any missing seqnums after it */
+static void
+ssrc_rtx_data_pop_oldest (SSRCRtxData * data)
+{
+  BufferQueueItem *item;
+
+  do {
+    item = ssrc_rtx_data_slot (data, data->history_tail);
+    if (item->buffer) {
+      gst_buffer_unref (item->buffer);
+      item->buffer = NULL;
+    }
+    data->history_tail++;
+    data->history_len--;
+  } while (data->history_len > 0 &&
+      ssrc_rtx_data_slot (data, data->history_tail)->buffer == NULL);
+}
+
+static void
+ssrc_rtx_data_grow (SSRCRtxData * data, guint size)
+{
+  BufferQueueItem *history;
+  guint i;
+
+  history = g_new0 (BufferQueueItem, size);
+  for (i = 0; i < data->history_size; i++) {
+    if (data->history[i].buffer)
+      history[data->history[i].seqnum & (size - 1)] = data->history[i];
+  }
+  g_free (data->history);
+  data->history = history;
+  data->history_size = size;
+}
+
+/* stores @buffer in the history, keeping at most @max_len seqnums */
+static void
+ssrc_rtx_data_insert (SSRCRtxData * data, guint16 seqnum, guint32 timestamp,
+    GstBuffer * buffer, guint max_len)
+{
+  BufferQueueItem *item;
+  gint diff;
+  guint len;
+
+  if (data->history_len == 0) {
+    data->history_head = data->history_tail = seqnum;
+    data->history_len = 1;
+  } else {
+    diff = gst_rtp_buffer_compare_seqnum (data->history_head, seqnum);
+
+    if (diff > 0) {
+      /* newer packet, make room by dropping the oldest ones */
+      while (data->history_len > 0 && data->history_len + diff > max_len)
+        ssrc_rtx_data_pop_oldest (data);
+
+      if (data->history_len == 0) {
+        data->history_tail = seqnum;
+        len = 1;
+      } else {
+        len = data->history_len + diff;
+      }
+
+      if (len > data->history_size) {
+        guint size = data->history_size;
+
+        while (size < len)
+          size <<= 1;
+        ssrc_rtx_data_grow (data, size);
+      }
+
+      data->history_head = seqnum;
+      data->history_len = len;
+    } else if (-diff >= (gint) max_len) {
+      /* seqnum jumped back, start over */
+      while (data->history_len > 0)
+        ssrc_rtx_data_pop_oldest (data);
+      data->history_head = data->history_tail = seqnum;
+      data->history_len = 1;
+    } else if (gst_rtp_buffer_compare_seqnum (data->history_tail, seqnum) < 0) {
+      /* too old, already expired */
+      gst_buffer_unref (buffer);
+      return;
+    }
+  }
+
+  item = ssrc_rtx_data_slot (data, seqnum);
+  if (item->buffer)
+    gst_buffer_unref (item->buffer);
+  item->seqnum = seqnum;
+  item->timestamp = timestamp;
+  item->buffer = buffer;
+}
+
+static BufferQueueItem *
+ssrc_rtx_data_lookup (SSRCRtxData * data, guint16 seqnum)
+{
+  BufferQueueItem *item = ssrc_rtx_data_slot (data, seqnum);
+
+  if (item->buffer == NULL || item->seqnum != seqnum)
+    return NULL;
+
+  return item;
+}
+
 static void
 ssrc_rtx_data_free (SSRCRtxData * data)
 {
-  g_sequence_free (data->queue);
+  while (data->history_len > 0)
+    ssrc_rtx_data_pop_oldest (data);
+  g_free (data->history);
   g_slice_free (SSRCRtxData, data);
 }
 
@@ -429,16 +546,6 @@ gst_rtp_rtx_buffer_new (GstRtpRtxSend * rtx, GstBuffer * buffer)
   return new_buffer;
 }
 
-static gint
-buffer_queue_items_cmp (BufferQueueItem * a, BufferQueueItem * b,
-    gpointer user_data)
-{
-  /* gst_rtp_buffer_compare_seqnum returns the opposite of what we want,
-   * it returns negative when seqnum1 > seqnum2 and we want negative
-   * when b > a, i.e. a is smaller, so it comes first in the sequence */
-  return gst_rtp_buffer_compare_seqnum (b->seqnum, a->seqnum);
-}
-
 static gboolean
 gst_rtp_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -472,19 +579,15 @@ gst_rtp_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
         /* check if request is for us */
         if (g_hash_table_contains (rtx->ssrc_data, GUINT_TO_POINTER (ssrc))) {
           SSRCRtxData *data;
-          GSequenceIter *iter;
-          BufferQueueItem search_item;
+          BufferQueueItem *item;
 
           /* update statistics */
           ++rtx->num_rtx_requests;
 
           data = gst_rtp_rtx_send_get_ssrc_data (rtx, ssrc);
 
-          search_item.seqnum = seqnum;
-          iter = g_sequence_lookup (data->queue, &search_item,
-              (GCompareDataFunc) buffer_queue_items_cmp, NULL);
-          if (iter) {
-            BufferQueueItem *item = g_sequence_get (iter);
+          item = ssrc_rtx_data_lookup (data, seqnum);
+          if (item) {
             GST_DEBUG_OBJECT (rtx, "found %" G_GUINT16_FORMAT, item->seqnum);
             rtx_buf = gst_rtp_rtx_buffer_new (rtx, item->buffer);
           }
@@ -617,14 +720,12 @@ gst_rtp_rtx_send_get_ts_diff (SSRCRtxData * data)
   BufferQueueItem *high_buf, *low_buf;
   guint32 result;
 
-  high_buf =
-      g_sequence_get (g_sequence_iter_prev (g_sequence_get_end_iter
-          (data->queue)));
-  low_buf = g_sequence_get (g_sequence_get_begin_iter (data->queue));
-
-  if (!high_buf || !low_buf || high_buf == low_buf)
+  if (data->history_len < 2)
     return 0;
 
+  high_buf = ssrc_rtx_data_slot (data, data->history_head);
+  low_buf = ssrc_rtx_data_slot (data, data->history_tail);
+
   high_ts = high_buf->timestamp;
   low_ts = low_buf->timestamp;
 
@@ -645,7 +746,6 @@ gst_rtp_rtx_send_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   GstRtpRtxSend *rtx = GST_RTP_RTX_SEND (parent);
   GstFlowReturn ret = GST_FLOW_ERROR;
   GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
-  BufferQueueItem *item;
   SSRCRtxData *data;
   guint16 seqnum;
   guint8 payload_type;
@@ -665,21 +765,14 @@ gst_rtp_rtx_send_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   if (g_hash_table_contains (rtx->rtx_pt_map, GUINT_TO_POINTER (payload_type))) {
     data = gst_rtp_rtx_send_get_ssrc_data (rtx, ssrc);
 
-    /* add current rtp buffer to queue history */
-    item = g_slice_new0 (BufferQueueItem);
-    item->seqnum = seqnum;
-    item->timestamp = rtptime;
-    item->buffer = gst_buffer_ref (buffer);
-    g_sequence_append (data->queue, item);
-
-    /* remove oldest packets from history if they are too many */
-    if (rtx->max_size_packets) {
-      while (g_sequence_get_length (data->queue) > rtx->max_size_packets)
-        g_sequence_remove (g_sequence_get_begin_iter (data->queue));
-    }
+    /* add current rtp buffer to queue history, this also removes the
+     * oldest packets from history if they are too many */
+    ssrc_rtx_data_insert (data, seqnum, rtptime, gst_buffer_ref (buffer),
+        rtx->max_size_packets ? rtx->max_size_packets : HISTORY_MAX_SIZE);
+
     if (rtx->max_size_time) {
       while (gst_rtp_rtx_send_get_ts_diff (data) > rtx->max_size_time)
-        g_sequence_remove (g_sequence_get_begin_iter (data->queue));
+        ssrc_rtx_data_pop_oldest (data);
     }
   }
 
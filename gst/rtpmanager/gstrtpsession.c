@@ -62,6 +62,11 @@
  * the other participants. SR packets will be forwarded on the sync_src pad
  * so that they can be used to perform inter-stream synchronisation when needed.
  *
+ * With #GstRtpSession:rtcp-mux, RTP and RTCP share the recv_rtp_sink pad as
+ * described in RFC 5761. RTCP packets are told apart by their packet type and
+ * handled as if they had arrived on the recv_rtcp_sink pad, so a single
+ * socket and receive thread is enough for both.
+ *
  * If you want the session manager to generate and send RTCP packets, request
  * the send_rtcp_src pad. Packet pushed on this pad contain SR/RR RTCP reports
  * that should be sent to all participants in the session.
@@ -203,6 +208,13 @@ enum
 #define DEFAULT_USE_PIPELINE_CLOCK   FALSE
 #define DEFAULT_RTCP_MIN_INTERVAL    (RTP_STATS_MIN_INTERVAL * GST_SECOND)
 #define DEFAULT_PROBATION            RTP_DEFAULT_PROBATION
+#define DEFAULT_RTCP_MUX             FALSE
+
+/* max number of buffers and events queued for a worker */
+#define WORKER_QUEUE_MAX_ITEMS       256
+/* max number of items a worker handles before it requeues the session so
+ * that other sessions get their turn */
+#define WORKER_BATCH_ITEMS           32
 
 enum
 {
@@ -219,6 +231,7 @@ enum
   PROP_RTCP_MIN_INTERVAL,
   PROP_PROBATION,
   PROP_STATS,
+  PROP_RTCP_MUX,
   PROP_LAST
 };
 
@@ -252,8 +265,19 @@ struct _GstRtpSessionPrivate
   GstClockTime send_latency;
 
   gboolean use_pipeline_clock;
+  gboolean rtcp_mux;
 
   guint rtx_count;
+
+  /* when set, received RTP is handled by this pool instead of the upstream
+   * thread */
+  GThreadPool *worker_pool;
+  GMutex worker_lock;
+  GCond worker_cond;
+  GQueue worker_queue;
+  gboolean worker_scheduled;
+  gboolean worker_flushing;
+  GstFlowReturn worker_ret;
 };
 
 /* callbacks to handle actions from the session manager */
@@ -308,6 +332,12 @@ static gboolean gst_rtp_session_setcaps_send_rtp (GstPad * pad,
 
 static void gst_rtp_session_clear_pt_map (GstRtpSession * rtpsession);
 
+static GstFlowReturn gst_rtp_session_worker_queue (GstRtpSession * rtpsession,
+    GstMiniObject * obj);
+static void gst_rtp_session_worker_set_flushing (GstRtpSession * rtpsession,
+    gboolean flushing);
+static void gst_rtp_session_worker_wait_idle (GstRtpSession * rtpsession);
+
 static GstStructure *gst_rtp_session_create_stats (GstRtpSession * rtpsession);
 
 static guint gst_rtp_session_signals[LAST_SIGNAL] = { 0 };
@@ -646,6 +676,21 @@ gst_rtp_session_class_init (GstRtpSessionClass * klass)
           "Various statistics", GST_TYPE_STRUCTURE,
           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRtpSession::rtcp-mux:
+   *
+   * Expect RTCP multiplexed with the RTP on the recv_rtp_sink pad, as
+   * described in RFC 5761. Packets with an RTCP packet type from 192 to 223
+   * are handled as RTCP and the SR packets are forwarded on the sync_src pad
+   * when there is one.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_RTCP_MUX,
+      g_param_spec_boolean ("rtcp-mux", "RTCP mux",
+          "Receive RTCP multiplexed with the RTP on the RTP sink pad",
+          DEFAULT_RTCP_MUX, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_rtp_session_change_state);
   gstelement_class->request_new_pad =
@@ -690,6 +735,7 @@ gst_rtp_session_init (GstRtpSession * rtpsession)
   rtpsession->priv->sysclock = gst_system_clock_obtain ();
   rtpsession->priv->session = rtp_session_new ();
   rtpsession->priv->use_pipeline_clock = DEFAULT_USE_PIPELINE_CLOCK;
+  rtpsession->priv->rtcp_mux = DEFAULT_RTCP_MUX;
 
   /* configure callbacks */
   rtp_session_set_callbacks (rtpsession->priv->session, &callbacks, rtpsession);
@@ -721,6 +767,12 @@ gst_rtp_session_init (GstRtpSession * rtpsession)
   rtpsession->priv->thread_stopped = TRUE;
 
   rtpsession->priv->rtx_count = 0;
+
+  g_mutex_init (&rtpsession->priv->worker_lock);
+  g_cond_init (&rtpsession->priv->worker_cond);
+  g_queue_init (&rtpsession->priv->worker_queue);
+  rtpsession->priv->worker_flushing = TRUE;
+  rtpsession->priv->worker_ret = GST_FLOW_FLUSHING;
 }
 
 static void
@@ -733,6 +785,8 @@ gst_rtp_session_finalize (GObject * object)
   g_hash_table_destroy (rtpsession->priv->ptmap);
   g_mutex_clear (&rtpsession->priv->lock);
   g_cond_clear (&rtpsession->priv->cond);
+  g_mutex_clear (&rtpsession->priv->worker_lock);
+  g_cond_clear (&rtpsession->priv->worker_cond);
   g_object_unref (rtpsession->priv->sysclock);
   g_object_unref (rtpsession->priv->session);
 
@@ -777,6 +831,9 @@ gst_rtp_session_set_property (GObject * object, guint prop_id,
     case PROP_PROBATION:
       g_object_set_property (G_OBJECT (priv->session), "probation", value);
       break;
+    case PROP_RTCP_MUX:
+      priv->rtcp_mux = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -834,6 +891,9 @@ gst_rtp_session_get_property (GObject * object, guint prop_id,
     case PROP_STATS:
       g_value_take_boxed (value, gst_rtp_session_create_stats (rtpsession));
       break;
+    case PROP_RTCP_MUX:
+      g_value_set_boolean (value, priv->rtcp_mux);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1057,16 +1117,20 @@ gst_rtp_session_change_state (GstElement * element, GstStateChange transition)
       if (rtpsession->send_rtp_src)
         rtpsession->priv->wait_send = TRUE;
       GST_RTP_SESSION_UNLOCK (rtpsession);
+      gst_rtp_session_worker_set_flushing (rtpsession, FALSE);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       break;
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
-    case GST_STATE_CHANGE_PAUSED_TO_READY:
       /* no need to join yet, we might want to continue later. Also, the
        * dataflow could block downstream so that a join could just block
        * forever. */
       stop_rtcp_thread (rtpsession);
       break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      stop_rtcp_thread (rtpsession);
+      gst_rtp_session_worker_set_flushing (rtpsession, TRUE);
+      break;
     default:
       break;
   }
@@ -1083,6 +1147,7 @@ gst_rtp_session_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       /* downstream is now releasing the dataflow and we can join. */
       join_rtcp_thread (rtpsession);
+      gst_rtp_session_worker_wait_idle (rtpsession);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
@@ -1450,17 +1515,11 @@ gst_rtp_session_reconsider (RTPSession * sess, gpointer user_data)
 }
 
 static gboolean
-gst_rtp_session_event_recv_rtp_sink (GstPad * pad, GstObject * parent,
-    GstEvent * event)
+gst_rtp_session_handle_recv_rtp_event (GstRtpSession * rtpsession,
+    GstPad * pad, GstEvent * event)
 {
-  GstRtpSession *rtpsession;
   gboolean ret = FALSE;
 
-  rtpsession = GST_RTP_SESSION (parent);
-
-  GST_DEBUG_OBJECT (rtpsession, "received event %s",
-      GST_EVENT_TYPE_NAME (event));
-
   switch (GST_EVENT_TYPE (event)) {
     case GST_EVENT_CAPS:
     {
@@ -1526,6 +1585,39 @@ gst_rtp_session_event_recv_rtp_sink (GstPad * pad, GstObject * parent,
 
 }
 
+static gboolean
+gst_rtp_session_event_recv_rtp_sink (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstRtpSession *rtpsession;
+
+  rtpsession = GST_RTP_SESSION (parent);
+
+  GST_DEBUG_OBJECT (rtpsession, "received event %s",
+      GST_EVENT_TYPE_NAME (event));
+
+  if (rtpsession->priv->worker_pool) {
+    switch (GST_EVENT_TYPE (event)) {
+      case GST_EVENT_FLUSH_START:
+        gst_rtp_session_worker_set_flushing (rtpsession, TRUE);
+        break;
+      case GST_EVENT_FLUSH_STOP:
+        /* make sure the worker is done with the old data before we reset */
+        gst_rtp_session_worker_wait_idle (rtpsession);
+        gst_rtp_session_worker_set_flushing (rtpsession, FALSE);
+        break;
+      default:
+        /* keep serialized events in order with the queued buffers */
+        if (GST_EVENT_IS_SERIALIZED (event))
+          return gst_rtp_session_worker_queue (rtpsession,
+              GST_MINI_OBJECT_CAST (event)) != GST_FLOW_FLUSHING;
+        break;
+    }
+  }
+
+  return gst_rtp_session_handle_recv_rtp_event (rtpsession, pad, event);
+}
+
 static gboolean
 gst_rtp_session_request_remote_key_unit (GstRtpSession * rtpsession,
     guint32 ssrc, guint payload, gboolean all_headers, gint count)
@@ -1692,25 +1784,21 @@ gst_rtp_session_sink_setcaps (GstPad * pad, GstRtpSession * rtpsession,
   return TRUE;
 }
 
-/* receive a packet from a sender, send it to the RTP session manager and
- * forward the packet on the rtp_src pad
+/* send a received packet to the RTP session manager, which will forward it
+ * on the rtp_src pad
  */
 static GstFlowReturn
-gst_rtp_session_chain_recv_rtp (GstPad * pad, GstObject * parent,
+gst_rtp_session_process_recv_rtp (GstRtpSession * rtpsession,
     GstBuffer * buffer)
 {
-  GstRtpSession *rtpsession;
   GstRtpSessionPrivate *priv;
   GstFlowReturn ret;
   GstClockTime current_time, running_time;
   GstClockTime timestamp;
   guint64 ntpnstime;
 
-  rtpsession = GST_RTP_SESSION (parent);
   priv = rtpsession->priv;
 
-  GST_LOG_OBJECT (rtpsession, "received RTP packet");
-
   /* get NTP time when this packet was captured, this depends on the timestamp. */
   timestamp = GST_BUFFER_TIMESTAMP (buffer);
   if (GST_CLOCK_TIME_IS_VALID (timestamp)) {
@@ -1742,6 +1830,221 @@ push_error:
   }
 }
 
+/* runs in the worker pool and handles the queued items of a session */
+static void
+gst_rtp_session_worker_func (GstRtpSession * rtpsession, gpointer user_data)
+{
+  GstRtpSessionPrivate *priv = rtpsession->priv;
+  GstMiniObject *obj;
+  GstFlowReturn ret;
+  guint n;
+
+  g_mutex_lock (&priv->worker_lock);
+  for (n = 0; n < WORKER_BATCH_ITEMS; n++) {
+    if (!(obj = g_queue_pop_head (&priv->worker_queue)))
+      break;
+    /* there is room in the queue again */
+    g_cond_broadcast (&priv->worker_cond);
+    g_mutex_unlock (&priv->worker_lock);
+
+    if (GST_IS_BUFFER (obj)) {
+      ret = gst_rtp_session_process_recv_rtp (rtpsession, GST_BUFFER_CAST (obj));
+    } else {
+      gst_rtp_session_handle_recv_rtp_event (rtpsession,
+          rtpsession->recv_rtp_sink, GST_EVENT_CAST (obj));
+      ret = GST_FLOW_OK;
+    }
+
+    g_mutex_lock (&priv->worker_lock);
+    if (!priv->worker_flushing && GST_IS_BUFFER (obj))
+      priv->worker_ret = ret;
+  }
+
+  if (!priv->worker_flushing && !g_queue_is_empty (&priv->worker_queue)) {
+    /* let the other sessions run first, our ref goes to the new job */
+    g_thread_pool_push (priv->worker_pool, rtpsession, NULL);
+    g_mutex_unlock (&priv->worker_lock);
+    return;
+  }
+  priv->worker_scheduled = FALSE;
+  g_cond_broadcast (&priv->worker_cond);
+  g_mutex_unlock (&priv->worker_lock);
+
+  gst_object_unref (rtpsession);
+}
+
+/* queue a buffer or serialized event for the worker pool, blocks while the
+ * queue is full */
+static GstFlowReturn
+gst_rtp_session_worker_queue (GstRtpSession * rtpsession, GstMiniObject * obj)
+{
+  GstRtpSessionPrivate *priv = rtpsession->priv;
+  GstFlowReturn ret;
+
+  g_mutex_lock (&priv->worker_lock);
+  while (!priv->worker_flushing &&
+      g_queue_get_length (&priv->worker_queue) >= WORKER_QUEUE_MAX_ITEMS)
+    g_cond_wait (&priv->worker_cond, &priv->worker_lock);
+
+  ret = priv->worker_flushing ? GST_FLOW_FLUSHING : priv->worker_ret;
+  /* like queue, keep going when downstream is not linked */
+  if (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED)
+    goto refused;
+
+  g_queue_push_tail (&priv->worker_queue, obj);
+  if (!priv->worker_scheduled) {
+    priv->worker_scheduled = TRUE;
+    g_thread_pool_push (priv->worker_pool, gst_object_ref (rtpsession), NULL);
+  }
+  g_mutex_unlock (&priv->worker_lock);
+
+  return ret;
+
+  /* ERRORS */
+refused:
+  {
+    g_mutex_unlock (&priv->worker_lock);
+    GST_DEBUG_OBJECT (rtpsession, "refusing item, %s", gst_flow_get_name (ret));
+    gst_mini_object_unref (obj);
+    return ret;
+  }
+}
+
+static void
+gst_rtp_session_worker_set_flushing (GstRtpSession * rtpsession,
+    gboolean flushing)
+{
+  GstRtpSessionPrivate *priv = rtpsession->priv;
+  GstMiniObject *obj;
+
+  g_mutex_lock (&priv->worker_lock);
+  priv->worker_flushing = flushing;
+  priv->worker_ret = flushing ? GST_FLOW_FLUSHING : GST_FLOW_OK;
+  while ((obj = g_queue_pop_head (&priv->worker_queue)))
+    gst_mini_object_unref (obj);
+  g_cond_broadcast (&priv->worker_cond);
+  g_mutex_unlock (&priv->worker_lock);
+}
+
+/* wait until no worker is handling this session */
+static void
+gst_rtp_session_worker_wait_idle (GstRtpSession * rtpsession)
+{
+  GstRtpSessionPrivate *priv = rtpsession->priv;
+
+  g_mutex_lock (&priv->worker_lock);
+  while (priv->worker_scheduled)
+    g_cond_wait (&priv->worker_cond, &priv->worker_lock);
+  g_mutex_unlock (&priv->worker_lock);
+}
+
+static GstFlowReturn gst_rtp_session_chain_recv_rtcp (GstPad * pad,
+    GstObject * parent, GstBuffer * buffer);
+
+/* RFC 5761: the second byte of RTCP is a packet type from 192 to 223, which
+ * as RTP would be a payload type from 64 to 95 that is not used for RTP */
+static gboolean
+gst_rtp_session_is_muxed_rtcp (GstBuffer * buffer)
+{
+  guint8 header[2];
+
+  if (gst_buffer_extract (buffer, 0, header, 2) != 2)
+    return FALSE;
+
+  return (header[0] >> 6) == 2 && header[1] >= 192 && header[1] <= 223;
+}
+
+/* the sync_src pad normally gets its events from the RTCP sink pad, with
+ * rtcp-mux it needs its own before the first SR is forwarded */
+static void
+gst_rtp_session_mux_sync_events (GstRtpSession * rtpsession)
+{
+  GstPad *sync_src;
+  GstSegment segment;
+  gchar *stream_id;
+
+  GST_RTP_SESSION_LOCK (rtpsession);
+  if ((sync_src = rtpsession->sync_src))
+    gst_object_ref (sync_src);
+  GST_RTP_SESSION_UNLOCK (rtpsession);
+
+  if (sync_src == NULL)
+    return;
+
+  if (!gst_pad_has_current_caps (sync_src)) {
+    GST_DEBUG_OBJECT (rtpsession, "sending events on sync_src for rtcp-mux");
+
+    stream_id = gst_pad_create_stream_id (sync_src,
+        GST_ELEMENT_CAST (rtpsession), "rtcp");
+    gst_pad_push_event (sync_src, gst_event_new_stream_start (stream_id));
+    g_free (stream_id);
+
+    gst_pad_push_event (sync_src,
+        gst_event_new_caps (gst_caps_new_empty_simple ("application/x-rtcp")));
+
+    gst_segment_init (&segment, GST_FORMAT_TIME);
+    gst_pad_push_event (sync_src, gst_event_new_segment (&segment));
+  }
+  gst_object_unref (sync_src);
+}
+
+/* receive a packet from a sender, send it to the RTP session manager and
+ * forward the packet on the rtp_src pad
+ */
+static GstFlowReturn
+gst_rtp_session_chain_recv_rtp (GstPad * pad, GstObject * parent,
+    GstBuffer * buffer)
+{
+  GstRtpSession *rtpsession;
+
+  rtpsession = GST_RTP_SESSION (parent);
+
+  /* RTCP is handled right away, also when the RTP goes to the worker pool */
+  if (rtpsession->priv->rtcp_mux && gst_rtp_session_is_muxed_rtcp (buffer)) {
+    gst_rtp_session_mux_sync_events (rtpsession);
+    return gst_rtp_session_chain_recv_rtcp (pad, parent, buffer);
+  }
+
+  GST_LOG_OBJECT (rtpsession, "received RTP packet");
+
+  if (rtpsession->priv->worker_pool)
+    return gst_rtp_session_worker_queue (rtpsession,
+        GST_MINI_OBJECT_CAST (buffer));
+
+  return gst_rtp_session_process_recv_rtp (rtpsession, buffer);
+}
+
+/**
+ * gst_rtp_session_worker_pool_new:
+ * @max_threads: the maximum number of threads
+ *
+ * Create a thread pool that can be shared by several #GstRtpSession elements
+ * with gst_rtp_session_set_worker_pool(). Free with g_thread_pool_free() after
+ * all sessions using it are gone.
+ *
+ * Returns: a new #GThreadPool
+ */
+GThreadPool *
+gst_rtp_session_worker_pool_new (guint max_threads)
+{
+  return g_thread_pool_new ((GFunc) gst_rtp_session_worker_func, NULL,
+      max_threads, FALSE, NULL);
+}
+
+/**
+ * gst_rtp_session_set_worker_pool:
+ * @rtpsession: a #GstRtpSession
+ * @pool: a pool from gst_rtp_session_worker_pool_new() or %NULL
+ *
+ * Handle the RTP received on @rtpsession in @pool instead of in the upstream
+ * streaming thread. This must be called before any data flows.
+ */
+void
+gst_rtp_session_set_worker_pool (GstRtpSession * rtpsession, GThreadPool * pool)
+{
+  rtpsession->priv->worker_pool = pool;
+}
+
 static gboolean
 gst_rtp_session_event_recv_rtcp_sink (GstPad * pad, GstObject * parent,
     GstEvent * event)
@@ -2152,6 +2455,10 @@ remove_recv_rtp_sink (GstRtpSession * rtpsession)
   gst_pad_set_active (rtpsession->recv_rtp_src, FALSE);
   gst_pad_set_active (rtpsession->recv_rtp_sink, FALSE);
 
+  /* a worker might still be pushing on the pads */
+  gst_rtp_session_worker_set_flushing (rtpsession, TRUE);
+  gst_rtp_session_worker_wait_idle (rtpsession);
+
   /* remove pads */
   gst_element_remove_pad (GST_ELEMENT_CAST (rtpsession),
       rtpsession->recv_rtp_sink);
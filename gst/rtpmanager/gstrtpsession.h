@@ -76,4 +76,8 @@ struct _GstRtpSessionClass {
 
 GType gst_rtp_session_get_type (void);
 
+GThreadPool * gst_rtp_session_worker_pool_new (guint max_threads);
+void          gst_rtp_session_set_worker_pool (GstRtpSession *rtpsession,
+                                               GThreadPool *pool);
+
 #endif /* __GST_RTP_SESSION_H__ */
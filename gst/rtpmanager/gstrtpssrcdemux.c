@@ -97,6 +97,7 @@ enum
   SIGNAL_NEW_SSRC_PAD,
   SIGNAL_REMOVED_SSRC_PAD,
   SIGNAL_CLEAR_SSRC,
+  SIGNAL_PREPARE_SSRC,
   LAST_SIGNAL
 };
 
@@ -113,6 +114,8 @@ static GstStateChangeReturn gst_rtp_ssrc_demux_change_state (GstElement *
 
 static void gst_rtp_ssrc_demux_clear_ssrc (GstRtpSsrcDemux * demux,
     guint32 ssrc);
+static void gst_rtp_ssrc_demux_prepare_ssrc (GstRtpSsrcDemux * demux,
+    guint32 ssrc);
 
 /* sinkpad stuff */
 static GstFlowReturn gst_rtp_ssrc_demux_chain (GstPad * pad, GstObject * parent,
@@ -154,15 +157,7 @@ struct _GstRtpSsrcDemuxPad
 static GstRtpSsrcDemuxPad *
 find_demux_pad_for_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc)
 {
-  GSList *walk;
-
-  for (walk = demux->srcpads; walk; walk = g_slist_next (walk)) {
-    GstRtpSsrcDemuxPad *pad = (GstRtpSsrcDemuxPad *) walk->data;
-
-    if (pad->ssrc == ssrc)
-      return pad;
-  }
-  return NULL;
+  return g_hash_table_lookup (demux->ssrcpads, GUINT_TO_POINTER (ssrc));
 }
 
 static GstEvent *
@@ -300,6 +295,7 @@ find_or_create_demux_pad_for_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc,
   gst_pad_set_element_private (rtcp_pad, demuxpad);
 
   demux->srcpads = g_slist_prepend (demux->srcpads, demuxpad);
+  g_hash_table_insert (demux->ssrcpads, GUINT_TO_POINTER (ssrc), demuxpad);
 
   gst_pad_set_query_function (rtp_pad, gst_rtp_ssrc_demux_src_query);
   gst_pad_set_iterate_internal_links_function (rtp_pad,
@@ -418,10 +414,30 @@ gst_rtp_ssrc_demux_class_init (GstRtpSsrcDemuxClass * klass)
       G_STRUCT_OFFSET (GstRtpSsrcDemuxClass, clear_ssrc),
       NULL, NULL, g_cclosure_marshal_generic, G_TYPE_NONE, 1, G_TYPE_UINT);
 
+  /**
+   * GstRtpSsrcDemux::prepare-ssrc:
+   * @demux: the object which received the signal
+   * @ssrc: the SSRC of the pad
+   *
+   * Action signal to create the pads for SSRC before its first packet
+   * arrives, for example when the SSRC is announced in the signaling. This
+   * way the new-ssrc-pad handlers and the linking of the new pads do not
+   * delay the first packets of the SSRC.
+   *
+   * Since: 1.4
+   */
+  gst_rtp_ssrc_demux_signals[SIGNAL_PREPARE_SSRC] =
+      g_signal_new ("prepare-ssrc",
+      G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstRtpSsrcDemuxClass, prepare_ssrc),
+      NULL, NULL, g_cclosure_marshal_generic, G_TYPE_NONE, 1, G_TYPE_UINT);
+
   gstelement_klass->change_state =
       GST_DEBUG_FUNCPTR (gst_rtp_ssrc_demux_change_state);
   gstrtpssrcdemux_klass->clear_ssrc =
       GST_DEBUG_FUNCPTR (gst_rtp_ssrc_demux_clear_ssrc);
+  gstrtpssrcdemux_klass->prepare_ssrc =
+      GST_DEBUG_FUNCPTR (gst_rtp_ssrc_demux_prepare_ssrc);
 
   gst_element_class_add_pad_template (gstelement_klass,
       gst_static_pad_template_get (&rtp_ssrc_demux_sink_template));
@@ -465,6 +481,7 @@ gst_rtp_ssrc_demux_init (GstRtpSsrcDemux * demux)
   gst_element_add_pad (GST_ELEMENT_CAST (demux), demux->rtcp_sink);
 
   g_rec_mutex_init (&demux->padlock);
+  demux->ssrcpads = g_hash_table_new (NULL, NULL);
 }
 
 static void
@@ -484,6 +501,7 @@ gst_rtp_ssrc_demux_reset (GstRtpSsrcDemux * demux)
   }
   g_slist_free (demux->srcpads);
   demux->srcpads = NULL;
+  g_hash_table_remove_all (demux->ssrcpads);
 }
 
 static void
@@ -505,6 +523,7 @@ gst_rtp_ssrc_demux_finalize (GObject * object)
 
   demux = GST_RTP_SSRC_DEMUX (object);
   g_rec_mutex_clear (&demux->padlock);
+  g_hash_table_destroy (demux->ssrcpads);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -524,6 +543,7 @@ gst_rtp_ssrc_demux_clear_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc)
   GST_DEBUG_OBJECT (demux, "clearing pad for SSRC %08x", ssrc);
 
   demux->srcpads = g_slist_remove (demux->srcpads, dpad);
+  g_hash_table_remove (demux->ssrcpads, GUINT_TO_POINTER (ssrc));
   GST_PAD_UNLOCK (demux);
 
   gst_pad_set_active (dpad->rtp_pad, FALSE);
@@ -548,6 +568,21 @@ unknown_pad:
   }
 }
 
+static void
+gst_rtp_ssrc_demux_prepare_ssrc (GstRtpSsrcDemux * demux, guint32 ssrc)
+{
+  GstPad *pad;
+
+  GST_DEBUG_OBJECT (demux, "preparing pads for SSRC %08x", ssrc);
+
+  /* creates both pads and pushes the sticky events we have so far, later
+   * sticky events are forwarded to all pads anyway */
+  if ((pad = find_or_create_demux_pad_for_ssrc (demux, ssrc, RTP_PAD)))
+    gst_object_unref (pad);
+  if ((pad = find_or_create_demux_pad_for_ssrc (demux, ssrc, RTCP_PAD)))
+    gst_object_unref (pad);
+}
+
 struct ForwardEventData
 {
   GstRtpSsrcDemux *demux;
@@ -41,6 +41,8 @@ struct _GstRtpSsrcDemux
 
   GRecMutex padlock;
   GSList *srcpads;
+  /* SSRC -> GstRtpSsrcDemuxPad, for the lookup of every packet */
+  GHashTable *ssrcpads;
 };
 
 struct _GstRtpSsrcDemuxClass
@@ -53,6 +55,7 @@ struct _GstRtpSsrcDemuxClass
 
   /* actions */
   void (*clear_ssrc)       (GstRtpSsrcDemux *demux, guint32 ssrc);
+  void (*prepare_ssrc)     (GstRtpSsrcDemux *demux, guint32 ssrc);
 };
 
 GType gst_rtp_ssrc_demux_get_type (void);
@@ -88,6 +88,8 @@ rtp_jitter_buffer_init (RTPJitterBuffer * jbuf)
   jbuf->packets = g_queue_new ();
   jbuf->mode = RTP_JITTER_BUFFER_MODE_SLAVE;
 
+  rtp_jitter_buffer_set_index_size (jbuf, RTP_JITTER_BUFFER_DEFAULT_INDEX_SIZE);
+
   rtp_jitter_buffer_reset_skew (jbuf);
 }
 
@@ -99,6 +101,7 @@ rtp_jitter_buffer_finalize (GObject * object)
   jbuf = RTP_JITTER_BUFFER_CAST (object);
 
   g_queue_free (jbuf->packets);
+  g_free (jbuf->index);
 
   G_OBJECT_CLASS (rtp_jitter_buffer_parent_class)->finalize (object);
 }
@@ -603,6 +606,158 @@ no_skew:
   return out_time;
 }
 
+/* rebuild the index with @size slots from the packets queue. Returns %FALSE
+ * when two packets map to the same slot. */
+static gboolean
+index_rebuild (RTPJitterBuffer * jbuf, guint size)
+{
+  GList *list;
+
+  g_free (jbuf->index);
+  jbuf->index = g_new0 (RTPJitterBufferItem *, size);
+  jbuf->index_size = size;
+  jbuf->index_count = 0;
+
+  for (list = jbuf->packets->head; list; list = g_list_next (list)) {
+    RTPJitterBufferItem *item = (RTPJitterBufferItem *) list;
+    RTPJitterBufferItem **slot;
+
+    if (item->seqnum == -1)
+      continue;
+
+    slot = &jbuf->index[item->seqnum & (size - 1)];
+    if (*slot)
+      return FALSE;
+    *slot = item;
+
+    if (jbuf->index_count == 0
+        || gst_rtp_buffer_compare_seqnum (jbuf->index_high, item->seqnum) > 0)
+      jbuf->index_high = item->seqnum;
+    jbuf->index_count++;
+  }
+  return TRUE;
+}
+
+static void
+index_reset (RTPJitterBuffer * jbuf)
+{
+  if (jbuf->index)
+    memset (jbuf->index, 0, jbuf->index_size * sizeof (RTPJitterBufferItem *));
+  jbuf->index_count = 0;
+  jbuf->index_valid = jbuf->index != NULL;
+}
+
+static inline RTPJitterBufferItem *
+index_lookup (RTPJitterBuffer * jbuf, guint16 seqnum)
+{
+  RTPJitterBufferItem *item;
+
+  item = jbuf->index[seqnum & (jbuf->index_size - 1)];
+  if (item && item->seqnum == seqnum)
+    return item;
+  return NULL;
+}
+
+/* add @item, which is already in the packets queue, to the index */
+static void
+index_add (RTPJitterBuffer * jbuf, RTPJitterBufferItem * item)
+{
+  RTPJitterBufferItem **slot;
+  guint size;
+
+  if (!jbuf->index_valid || item->seqnum == -1)
+    return;
+
+  slot = &jbuf->index[item->seqnum & (jbuf->index_size - 1)];
+  if (G_LIKELY (*slot == NULL)) {
+    *slot = item;
+    if (jbuf->index_count == 0
+        || gst_rtp_buffer_compare_seqnum (jbuf->index_high, item->seqnum) > 0)
+      jbuf->index_high = item->seqnum;
+    jbuf->index_count++;
+    return;
+  }
+
+  /* the packets span more seqnums than the index, try to grow it. If that is
+   * not possible, we fall back to walking the queue until it is empty */
+  jbuf->index_valid = FALSE;
+  for (size = jbuf->index_size * 2; size <= RTP_JITTER_BUFFER_MAX_INDEX_SIZE;
+      size *= 2) {
+    if (index_rebuild (jbuf, size)) {
+      GST_DEBUG ("grew seqnum index to %u", size);
+      jbuf->index_valid = TRUE;
+      return;
+    }
+  }
+  GST_DEBUG ("too many seqnums for the index, disabling it");
+}
+
+static void
+index_remove (RTPJitterBuffer * jbuf, RTPJitterBufferItem * item)
+{
+  RTPJitterBufferItem **slot;
+
+  if (!jbuf->index_valid) {
+    /* start over when the queue becomes empty */
+    if (jbuf->packets->length == 0)
+      index_reset (jbuf);
+    return;
+  }
+
+  if (item->seqnum == -1)
+    return;
+
+  slot = &jbuf->index[item->seqnum & (jbuf->index_size - 1)];
+  if (*slot == item) {
+    *slot = NULL;
+    jbuf->index_count--;
+  }
+}
+
+/* find the position for a packet with @seqnum using the index. Returns %FALSE
+ * when the index can't be used and the queue needs to be walked. */
+static gboolean
+index_find_position (RTPJitterBuffer * jbuf, guint16 seqnum, GList ** list,
+    gboolean * duplicate)
+{
+  gint gap;
+  guint16 dist, i;
+
+  if (!jbuf->index_valid)
+    return FALSE;
+
+  *duplicate = FALSE;
+  *list = NULL;
+
+  if (index_lookup (jbuf, seqnum)) {
+    *duplicate = TRUE;
+    return TRUE;
+  }
+
+  /* newer than all packets, append */
+  if (jbuf->index_count == 0)
+    return TRUE;
+  gap = gst_rtp_buffer_compare_seqnum (jbuf->index_high, seqnum);
+  if (G_LIKELY (gap > 0))
+    return TRUE;
+
+  /* we need the first packet with a higher seqnum, which is in the index when
+   * the distance to the highest seqnum fits in it */
+  dist = jbuf->index_high - seqnum;
+  if (dist >= jbuf->index_size)
+    return FALSE;
+
+  for (i = 1; i <= dist; i++) {
+    RTPJitterBufferItem *next = index_lookup (jbuf, seqnum + i);
+
+    if (next) {
+      *list = (GList *) next;
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
 static void
 queue_do_insert (RTPJitterBuffer * jbuf, GList * list, GList * item)
 {
@@ -626,6 +781,36 @@ queue_do_insert (RTPJitterBuffer * jbuf, GList * list, GList * item)
       queue->head = queue->tail;
   }
   queue->length++;
+
+  index_add (jbuf, (RTPJitterBufferItem *) item);
+}
+
+/**
+ * rtp_jitter_buffer_set_index_size:
+ * @jbuf: an #RTPJitterBuffer
+ * @size: number of slots, a power of 2, or 0
+ *
+ * Configure the size of the seqnum index of @jbuf. Packets are looked up in
+ * the index by their seqnum modulo @size to detect duplicates and find
+ * their position in constant time. The index grows when the packets span
+ * more seqnums, up to %RTP_JITTER_BUFFER_MAX_INDEX_SIZE. A @size of 0
+ * disables the index.
+ */
+void
+rtp_jitter_buffer_set_index_size (RTPJitterBuffer * jbuf, guint size)
+{
+  g_return_if_fail (jbuf != NULL);
+  g_return_if_fail (size <= RTP_JITTER_BUFFER_MAX_INDEX_SIZE);
+  g_return_if_fail ((size & (size - 1)) == 0);
+
+  g_free (jbuf->index);
+  jbuf->index = NULL;
+  jbuf->index_size = 0;
+  jbuf->index_count = 0;
+  jbuf->index_valid = FALSE;
+
+  if (size > 0)
+    jbuf->index_valid = index_rebuild (jbuf, size);
 }
 
 /**
@@ -649,6 +834,7 @@ rtp_jitter_buffer_insert (RTPJitterBuffer * jbuf, RTPJitterBufferItem * item,
   guint32 rtptime;
   guint16 seqnum;
   GstClockTime dts;
+  gboolean duplicate;
 
   g_return_val_if_fail (jbuf != NULL, FALSE);
   g_return_val_if_fail (item != NULL, FALSE);
@@ -660,6 +846,12 @@ rtp_jitter_buffer_insert (RTPJitterBuffer * jbuf, RTPJitterBufferItem * item,
 
   seqnum = item->seqnum;
 
+  if (index_find_position (jbuf, seqnum, &list, &duplicate)) {
+    if (G_UNLIKELY (duplicate))
+      goto duplicate;
+    goto found;
+  }
+
   /* loop the list to skip strictly smaller seqnum buffers */
   for (list = jbuf->packets->head; list; list = g_list_next (list)) {
     guint16 qseq;
@@ -683,6 +875,7 @@ rtp_jitter_buffer_insert (RTPJitterBuffer * jbuf, RTPJitterBufferItem * item,
       break;
   }
 
+found:
   dts = item->dts;
   if (item->rtptime == -1)
     goto append;
@@ -788,6 +981,8 @@ rtp_jitter_buffer_pop (RTPJitterBuffer * jbuf, gint * percent)
     else
       queue->tail = NULL;
     queue->length--;
+
+    index_remove (jbuf, (RTPJitterBufferItem *) item);
   }
 
   /* buffering mode, update buffer stats */
@@ -836,6 +1031,8 @@ rtp_jitter_buffer_flush (RTPJitterBuffer * jbuf, GFunc free_func,
 
   while ((item = g_queue_pop_head_link (jbuf->packets)))
     free_func ((RTPJitterBufferItem *) item, user_data);
+
+  index_reset (jbuf);
 }
 
 /**
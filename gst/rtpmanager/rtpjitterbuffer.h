@@ -66,6 +66,9 @@ typedef enum {
 GType rtp_jitter_buffer_mode_get_type (void);
 
 #define RTP_JITTER_BUFFER_MAX_WINDOW 512
+
+#define RTP_JITTER_BUFFER_DEFAULT_INDEX_SIZE 1024
+#define RTP_JITTER_BUFFER_MAX_INDEX_SIZE     32768
 /**
  * RTPJitterBuffer:
  *
@@ -76,6 +79,14 @@ struct _RTPJitterBuffer {
 
   GQueue        *packets;
 
+  /* ring of the items in packets indexed by seqnum, used to find duplicates
+   * and the insert position without walking packets */
+  RTPJitterBufferItem **index;
+  guint          index_size;
+  guint          index_count;
+  guint16        index_high;
+  gboolean       index_valid;
+
   RTPJitterBufferMode mode;
 
   GstClockTime   delay;
@@ -150,6 +161,8 @@ guint32               rtp_jitter_buffer_get_clock_rate   (RTPJitterBuffer *jbuf)
 
 void                  rtp_jitter_buffer_reset_skew       (RTPJitterBuffer *jbuf);
 
+void                  rtp_jitter_buffer_set_index_size   (RTPJitterBuffer *jbuf, guint size);
+
 gboolean              rtp_jitter_buffer_insert           (RTPJitterBuffer *jbuf,
                                                           RTPJitterBufferItem *item,
                                                           gboolean *tail, gint *percent);
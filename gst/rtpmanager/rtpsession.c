@@ -65,6 +65,7 @@ enum
 #define DEFAULT_RTCP_MIN_INTERVAL    (RTP_STATS_MIN_INTERVAL * GST_SECOND)
 #define DEFAULT_RTCP_FEEDBACK_RETENTION_WINDOW (2 * GST_SECOND)
 #define DEFAULT_RTCP_IMMEDIATE_FEEDBACK_THRESHOLD (3)
+#define DEFAULT_RTCP_FEEDBACK_COALESCE_TIME (0)
 #define DEFAULT_PROBATION            RTP_DEFAULT_PROBATION
 
 enum
@@ -85,8 +86,10 @@ enum
   PROP_RTCP_MIN_INTERVAL,
   PROP_RTCP_FEEDBACK_RETENTION_WINDOW,
   PROP_RTCP_IMMEDIATE_FEEDBACK_THRESHOLD,
+  PROP_RTCP_FEEDBACK_COALESCE_TIME,
   PROP_PROBATION,
   PROP_STATS,
+  PROP_SOURCES_STATS_RECORDS,
   PROP_LAST
 };
 
@@ -437,6 +440,24 @@ rtp_session_class_init (RTPSessionClass * klass)
           0, G_MAXUINT, DEFAULT_RTCP_IMMEDIATE_FEEDBACK_THRESHOLD,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * RTPSession::rtcp-feedback-coalesce-time:
+   *
+   * Minimum time to wait before sending early RTCP feedback, so that NACKs
+   * and key unit requests that follow shortly after each other go out in
+   * the same compound packet. It is never longer than the maximum delay
+   * of the request. 0 sends the feedback as soon as allowed.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_RTCP_FEEDBACK_COALESCE_TIME,
+      g_param_spec_uint64 ("rtcp-feedback-coalesce-time",
+          "RTCP Feedback coalesce time",
+          "Minimum time to collect early RTCP feedback before sending it "
+          "(in ns)", 0, G_MAXUINT64, DEFAULT_RTCP_FEEDBACK_COALESCE_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (gobject_class, PROP_PROBATION,
       g_param_spec_uint ("probation", "Number of probations",
           "Consecutive packet sequence numbers to accept the source",
@@ -461,6 +482,22 @@ rtp_session_class_init (RTPSessionClass * klass)
           "Various statistics", GST_TYPE_STRUCTURE,
           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * RTPSession::sources-stats-records:
+   *
+   * The counters of all sources in the session as a #GBytes containing an
+   * array of #RTPSourceStatsRecord, in host byte order. Meant for
+   * monitoring many sources often: it is made with one allocation and the
+   * session lock is only held to copy the counters, unlike building the
+   * "stats" structure of every #RTPSource.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_SOURCES_STATS_RECORDS,
+      g_param_spec_boxed ("sources-stats-records", "Sources stats records",
+          "Array of RTPSourceStatsRecord for all sources", G_TYPE_BYTES,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   klass->get_source_by_ssrc =
       GST_DEBUG_FUNCPTR (rtp_session_get_source_by_ssrc);
   klass->send_rtcp = GST_DEBUG_FUNCPTR (rtp_session_send_rtcp);
@@ -530,6 +567,7 @@ rtp_session_init (RTPSession * sess)
   sess->rtcp_feedback_retention_window = DEFAULT_RTCP_FEEDBACK_RETENTION_WINDOW;
   sess->rtcp_immediate_feedback_threshold =
       DEFAULT_RTCP_IMMEDIATE_FEEDBACK_THRESHOLD;
+  sess->rtcp_feedback_coalesce_time = DEFAULT_RTCP_FEEDBACK_COALESCE_TIME;
 
   sess->last_keyframe_request = GST_CLOCK_TIME_NONE;
 
@@ -565,6 +603,31 @@ copy_source (gpointer key, RTPSource * source, GValueArray * arr)
   g_value_array_append (arr, &value);
 }
 
+static void
+copy_source_stats_record (gpointer key, RTPSource * source,
+    RTPSourceStatsRecord ** record)
+{
+  rtp_source_get_stats_record (source, *record);
+  (*record)++;
+}
+
+static GBytes *
+rtp_session_create_sources_stats_records (RTPSession * sess)
+{
+  RTPSourceStatsRecord *records, *record;
+  guint size;
+
+  RTP_SESSION_LOCK (sess);
+  size = g_hash_table_size (sess->ssrcs[sess->mask_idx]);
+  records = g_new (RTPSourceStatsRecord, size);
+  record = records;
+  g_hash_table_foreach (sess->ssrcs[sess->mask_idx],
+      (GHFunc) copy_source_stats_record, &record);
+  RTP_SESSION_UNLOCK (sess);
+
+  return g_bytes_new_take (records, size * sizeof (RTPSourceStatsRecord));
+}
+
 static GValueArray *
 rtp_session_create_sources (RTPSession * sess)
 {
@@ -657,6 +720,9 @@ rtp_session_set_property (GObject * object, guint prop_id,
     case PROP_RTCP_IMMEDIATE_FEEDBACK_THRESHOLD:
       sess->rtcp_immediate_feedback_threshold = g_value_get_uint (value);
       break;
+    case PROP_RTCP_FEEDBACK_COALESCE_TIME:
+      sess->rtcp_feedback_coalesce_time = g_value_get_uint64 (value);
+      break;
     case PROP_PROBATION:
       sess->probation = g_value_get_uint (value);
       break;
@@ -718,12 +784,19 @@ rtp_session_get_property (GObject * object, guint prop_id,
     case PROP_RTCP_IMMEDIATE_FEEDBACK_THRESHOLD:
       g_value_set_uint (value, sess->rtcp_immediate_feedback_threshold);
       break;
+    case PROP_RTCP_FEEDBACK_COALESCE_TIME:
+      g_value_set_uint64 (value, sess->rtcp_feedback_coalesce_time);
+      break;
     case PROP_PROBATION:
       g_value_set_uint (value, sess->probation);
       break;
     case PROP_STATS:
       g_value_take_boxed (value, rtp_session_create_stats (sess));
       break;
+    case PROP_SOURCES_STATS_RECORDS:
+      g_value_take_boxed (value,
+          rtp_session_create_sources_stats_records (sess));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1422,8 +1495,18 @@ add_source (RTPSession * sess, RTPSource * src)
 static RTPSource *
 find_source (RTPSession * sess, guint32 ssrc)
 {
-  return g_hash_table_lookup (sess->ssrcs[sess->mask_idx],
+  RTPSource *source = sess->last_source;
+
+  /* consecutive packets usually come from the same source */
+  if (G_LIKELY (source && source->ssrc == ssrc))
+    return source;
+
+  source = g_hash_table_lookup (sess->ssrcs[sess->mask_idx],
       GINT_TO_POINTER (ssrc));
+  if (source)
+    sess->last_source = source;
+
+  return source;
 }
 
 /* must be called with the session lock, the returned source needs to be
@@ -3461,17 +3544,20 @@ early:
 }
 
 static void
-clone_ssrcs_hashtable (gchar * key, RTPSource * source, GHashTable * hash_table)
+clone_ssrcs_array (gchar * key, RTPSource * source, GPtrArray * array)
 {
-  g_hash_table_insert (hash_table, key, g_object_ref (source));
+  g_ptr_array_add (array, g_object_ref (source));
 }
 
 static gboolean
 remove_closing_sources (const gchar * key, RTPSource * source,
     ReportData * data)
 {
-  if (source->closing)
+  if (source->closing) {
+    if (data->sess->last_source == source)
+      data->sess->last_source = NULL;
     return TRUE;
+  }
 
   if (source->send_fir)
     data->have_fir = TRUE;
@@ -3583,8 +3669,9 @@ rtp_session_on_timeout (RTPSession * sess, GstClockTime current_time,
 {
   GstFlowReturn result = GST_FLOW_OK;
   ReportData data = { GST_RTCP_BUFFER_INIT };
-  GHashTable *table_copy;
+  GPtrArray *sources;
   ReportOutput *output;
+  guint i;
 
   g_return_val_if_fail (RTP_IS_SESSION (sess), GST_FLOW_ERROR);
 
@@ -3616,17 +3703,18 @@ rtp_session_on_timeout (RTPSession * sess, GstClockTime current_time,
     g_object_unref (source);
   }
 
-  /* Make a local copy of the hashtable. We need to do this because the
+  /* Make a local copy of the sources. We need to do this because the
    * cleanup stage below releases the session lock. */
-  table_copy = g_hash_table_new_full (NULL, NULL, NULL,
+  sources = g_ptr_array_new_full (sess->total_sources,
       (GDestroyNotify) g_object_unref);
   g_hash_table_foreach (sess->ssrcs[sess->mask_idx],
-      (GHFunc) clone_ssrcs_hashtable, table_copy);
+      (GHFunc) clone_ssrcs_array, sources);
 
   /* Clean up the session, mark the source for removing, this might release the
    * session lock. */
-  g_hash_table_foreach (table_copy, (GHFunc) session_cleanup, &data);
-  g_hash_table_destroy (table_copy);
+  for (i = 0; i < sources->len; i++)
+    session_cleanup (NULL, g_ptr_array_index (sources, i), &data);
+  g_ptr_array_free (sources, TRUE);
 
   /* Now remove the marked sources */
   g_hash_table_foreach_remove (sess->ssrcs[sess->mask_idx],
@@ -3774,6 +3862,17 @@ rtp_session_request_early_rtcp (RTPSession * sess, GstClockTime current_time,
     sess->next_early_rtcp_time = current_time;
   }
 
+  /* give other feedback a chance to join this packet, all requests until
+   * then only add to it */
+  if (sess->rtcp_feedback_coalesce_time) {
+    GstClockTime earliest;
+
+    earliest = current_time + MIN (sess->rtcp_feedback_coalesce_time,
+        max_delay);
+    if (sess->next_early_rtcp_time < earliest)
+      sess->next_early_rtcp_time = earliest;
+  }
+
   GST_LOG_OBJECT (sess, "next early RTCP time %" GST_TIME_FORMAT,
       GST_TIME_ARGS (sess->next_early_rtcp_time));
   RTP_SESSION_UNLOCK (sess);
@@ -221,6 +221,8 @@ struct _RTPSession {
   guint32       mask_idx;
   guint32       mask;
   GHashTable   *ssrcs[32];
+  /* source of the last lookup, not reffed */
+  RTPSource    *last_source;
   guint         total_sources;
 
   guint16       generation;
@@ -251,6 +253,7 @@ struct _RTPSession {
   gboolean      favor_new;
   GstClockTime  rtcp_feedback_retention_window;
   guint         rtcp_immediate_feedback_threshold;
+  GstClockTime  rtcp_feedback_coalesce_time;
 
   GstClockTime last_keyframe_request;
   gboolean     last_keyframe_all_headers;
@@ -1728,6 +1728,42 @@ rtp_source_has_retained (RTPSource * src, GCompareFunc func, gconstpointer data)
     return FALSE;
 }
 
+/**
+ * rtp_source_get_stats_record:
+ * @src: The #RTPSource
+ * @record: the record to fill
+ *
+ * Copy the counters of @src into @record, without the allocations of
+ * the "stats" property.
+ */
+void
+rtp_source_get_stats_record (RTPSource * src, RTPSourceStatsRecord * record)
+{
+  RTPReceiverReport *rr;
+
+  record->ssrc = src->ssrc;
+  record->flags = 0;
+  if (src->internal)
+    record->flags |= RTP_SOURCE_STATS_RECORD_INTERNAL;
+  if (src->is_sender)
+    record->flags |= RTP_SOURCE_STATS_RECORD_SENDER;
+  if (src->validated)
+    record->flags |= RTP_SOURCE_STATS_RECORD_VALIDATED;
+  if (src->marked_bye)
+    record->flags |= RTP_SOURCE_STATS_RECORD_BYE;
+
+  record->packets_received = src->stats.packets_received;
+  record->octets_received = src->stats.octets_received;
+  record->bytes_received = src->stats.bytes_received;
+  record->packets_sent = src->stats.packets_sent;
+  record->octets_sent = src->stats.octets_sent;
+  record->packets_lost = rtp_stats_get_packets_lost (&src->stats);
+  record->jitter = src->stats.jitter >> 4;
+
+  rr = &src->stats.rr[src->stats.curr_rr];
+  record->round_trip = rr->is_valid ? rr->round_trip : 0;
+}
+
 /**
  * @src: The #RTPSource
  * @seqnum: a seqnum
@@ -1756,11 +1792,23 @@ rtp_source_register_nack (RTPSource * src, guint16 seqnum)
   /* we already have this seqnum */
   if (diff == 0)
     return;
-  /* it comes before the recorded seqnum, FIXME, we could merge it
-   * if not to far away */
+  /* it comes before the recorded seqnum */
   if (diff < 0) {
-    GST_DEBUG ("insert NACK #%u at %u", seqnum, i);
-    g_array_insert_val (src->nacks, i, dword);
+    guint32 tdword = g_array_index (src->nacks, guint32, i);
+    guint shift = -diff;
+    guint16 blp = tdword & 0xffff;
+
+    /* make it the PID of the recorded one if the BLP can still hold all
+     * the seqnums that one covered */
+    if (shift <= 16 && (blp >> (16 - shift)) == 0) {
+      dword |= (((guint32) blp << shift) | (1 << (shift - 1))) & 0xffff;
+      GST_DEBUG ("merge NACK #%u at %u with following NACK #%u -> 0x%08x",
+          seqnum, i, tdword >> 16, dword);
+      g_array_index (src->nacks, guint32, i) = dword;
+    } else {
+      GST_DEBUG ("insert NACK #%u at %u", seqnum, i);
+      g_array_insert_val (src->nacks, i, dword);
+    }
   } else if (diff < 16) {
     /* we can merge it */
     dword = g_array_index (src->nacks, guint32, i);
@@ -278,6 +278,9 @@ gboolean        rtp_source_has_retained        (RTPSource * src,
                                                 GCompareFunc func,
                                                 gconstpointer data);
 
+void            rtp_source_get_stats_record    (RTPSource * src,
+                                                RTPSourceStatsRecord * record);
+
 void            rtp_source_register_nack       (RTPSource * src,
                                                 guint16 seqnum);
 guint32 *       rtp_source_get_nacks           (RTPSource * src, guint *n_nacks);
@@ -148,6 +148,51 @@ typedef struct {
   RTPSenderReport   sr[2];
 } RTPSourceStats;
 
+/**
+ * RTPSourceStatsRecordFlags:
+ * @RTP_SOURCE_STATS_RECORD_INTERNAL: the source is one of ours
+ * @RTP_SOURCE_STATS_RECORD_SENDER: the source is sending data
+ * @RTP_SOURCE_STATS_RECORD_VALIDATED: the source is validated
+ * @RTP_SOURCE_STATS_RECORD_BYE: the source has sent or was marked for a BYE
+ */
+typedef enum {
+  RTP_SOURCE_STATS_RECORD_INTERNAL  = (1 << 0),
+  RTP_SOURCE_STATS_RECORD_SENDER    = (1 << 1),
+  RTP_SOURCE_STATS_RECORD_VALIDATED = (1 << 2),
+  RTP_SOURCE_STATS_RECORD_BYE       = (1 << 3)
+} RTPSourceStatsRecordFlags;
+
+/**
+ * RTPSourceStatsRecord:
+ * @ssrc: the SSRC of the source
+ * @flags: #RTPSourceStatsRecordFlags
+ * @packets_received: number of received packets in total
+ * @octets_received: number of payload bytes received
+ * @bytes_received: number of total bytes received including headers and
+ *                  lower protocol level overhead
+ * @packets_sent: number of sent packets
+ * @octets_sent: number of payload bytes sent
+ * @packets_lost: cumulative number of packets lost
+ * @jitter: current jitter in RTP time units
+ * @round_trip: round trip time from the last receiver report, in 16.16
+ *              fixed point seconds
+ *
+ * Plain copy of the counters of a source, see the session's
+ * "sources-stats-records" property.
+ */
+typedef struct {
+  guint32      ssrc;
+  guint32      flags;
+  guint64      packets_received;
+  guint64      octets_received;
+  guint64      bytes_received;
+  guint64      packets_sent;
+  guint64      octets_sent;
+  gint64       packets_lost;
+  guint32      jitter;
+  guint32      round_trip;
+} RTPSourceStatsRecord;
+
 #define RTP_STATS_BANDWIDTH           64000
 #define RTP_STATS_RTCP_FRACTION       0.05
 /*
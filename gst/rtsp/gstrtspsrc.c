@@ -192,6 +192,8 @@ gst_rtsp_src_buffer_mode_get_type (void)
 #define DEFAULT_USE_PIPELINE_CLOCK       FALSE
 #define DEFAULT_TLS_VALIDATION_FLAGS     G_TLS_CERTIFICATE_VALIDATE_ALL
 #define DEFAULT_TLS_DATABASE     NULL
+#define DEFAULT_TCP_BATCH_SIZE   1
+#define DEFAULT_SDP_CACHE_TTL    0
 
 enum
 {
@@ -226,6 +228,8 @@ enum
   PROP_SDES,
   PROP_TLS_VALIDATION_FLAGS,
   PROP_TLS_DATABASE,
+  PROP_TCP_BATCH_SIZE,
+  PROP_SDP_CACHE_TTL,
   PROP_LAST
 };
 
@@ -608,6 +612,38 @@ gst_rtspsrc_class_init (GstRTSPSrcClass * klass)
           "TLS database with anchor certificate authorities used to validate the server certificate",
           G_TYPE_TLS_DATABASE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRTSPSrc::tcp-batch-size:
+   *
+   * Maximum number of RTP packets received over interleaved TCP that are
+   * collected in a buffer list before they are pushed. Packets are only
+   * collected while more data is already waiting on the socket, so batching
+   * does not add latency. 1 pushes every packet on its own.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_TCP_BATCH_SIZE,
+      g_param_spec_uint ("tcp-batch-size", "TCP batch size",
+          "Maximum number of interleaved RTP packets to push as one buffer list",
+          1, 1024, DEFAULT_TCP_BATCH_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRTSPSrc::sdp-cache-ttl:
+   *
+   * Time in milliseconds for which the result of the OPTIONS and DESCRIBE
+   * requests is kept in a process-wide cache. Other rtspsrc instances
+   * opening the same location with the same credentials within that time
+   * go straight to SETUP, saving two round trips. 0 disables the cache.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_SDP_CACHE_TTL,
+      g_param_spec_uint ("sdp-cache-ttl", "SDP cache TTL",
+          "Time in ms to cache the SDP of a location for other instances "
+          "(0 = disabled)", 0, G_MAXUINT, DEFAULT_SDP_CACHE_TTL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstRTSPSrc::handle-request:
    * @rtspsrc: a #GstRTSPSrc
@@ -736,6 +772,8 @@ gst_rtspsrc_init (GstRTSPSrc * src)
   src->sdes = NULL;
   src->tls_validation_flags = DEFAULT_TLS_VALIDATION_FLAGS;
   src->tls_database = DEFAULT_TLS_DATABASE;
+  src->tcp_batch_size = DEFAULT_TCP_BATCH_SIZE;
+  src->sdp_cache_ttl = DEFAULT_SDP_CACHE_TTL;
 
   /* get a list of all extensions */
   src->extensions = gst_rtsp_ext_list_get ();
@@ -1000,6 +1038,12 @@ gst_rtspsrc_set_property (GObject * object, guint prop_id, const GValue * value,
       g_clear_object (&rtspsrc->tls_database);
       rtspsrc->tls_database = g_value_dup_object (value);
       break;
+    case PROP_TCP_BATCH_SIZE:
+      rtspsrc->tcp_batch_size = g_value_get_uint (value);
+      break;
+    case PROP_SDP_CACHE_TTL:
+      rtspsrc->sdp_cache_ttl = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1131,6 +1175,12 @@ gst_rtspsrc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_TLS_DATABASE:
       g_value_set_object (value, rtspsrc->tls_database);
       break;
+    case PROP_TCP_BATCH_SIZE:
+      g_value_set_uint (value, rtspsrc->tcp_batch_size);
+      break;
+    case PROP_SDP_CACHE_TTL:
+      g_value_set_uint (value, rtspsrc->sdp_cache_ttl);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1508,6 +1558,8 @@ gst_rtspsrc_stream_free (GstRTSPSrc * src, GstRTSPStream * stream)
   g_free (stream->destination);
   g_free (stream->control_url);
   g_free (stream->conninfo.location);
+  if (stream->pending)
+    gst_buffer_list_unref (stream->pending);
 
   for (i = 0; i < 2; i++) {
     if (stream->udpsrc[i]) {
@@ -4248,10 +4300,12 @@ send_error:
   }
 }
 
-static GstFlowReturn
-gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message)
+/* Takes the body of a data message and does the stream activation and
+ * timestamping for it. Returns NULL if the data is to be ignored. */
+static GstBuffer *
+gst_rtspsrc_prepare_data (GstRTSPSrc * src, GstRTSPMessage * message,
+    GstRTSPStream ** p_stream, GstPad ** p_outpad, gboolean * p_is_rtcp)
 {
-  GstFlowReturn ret = GST_FLOW_OK;
   gint channel;
   GstRTSPStream *stream;
   GstPad *outpad = NULL;
@@ -4379,32 +4433,126 @@ gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message)
     GST_BUFFER_TIMESTAMP (buf) = src->base_time;
   }
 
-  /* chain to the peer pad */
-  if (GST_PAD_IS_SINK (outpad))
-    ret = gst_pad_chain (outpad, buf);
-  else
-    ret = gst_pad_push (outpad, buf);
+  *p_stream = stream;
+  *p_outpad = outpad;
+  *p_is_rtcp = is_rtcp;
 
-  if (!is_rtcp) {
-    /* combine all stream flows for the data transport */
-    ret = gst_rtspsrc_combine_flows (src, stream, ret);
-  }
-  return ret;
+  return buf;
 
   /* ERRORS */
 unknown_stream:
   {
     GST_DEBUG_OBJECT (src, "unknown stream on channel %d, ignored", channel);
     gst_rtsp_message_unset (message);
-    return GST_FLOW_OK;
+    return NULL;
   }
 invalid_length:
   {
     GST_ELEMENT_WARNING (src, RESOURCE, READ, (NULL),
         ("Short message received, ignoring."));
     gst_rtsp_message_unset (message);
+    return NULL;
+  }
+}
+
+static GstFlowReturn
+gst_rtspsrc_push_data (GstRTSPSrc * src, GstRTSPStream * stream,
+    GstPad * outpad, gboolean is_rtcp, GstBuffer * buf)
+{
+  GstFlowReturn ret;
+
+  /* chain to the peer pad */
+  if (GST_PAD_IS_SINK (outpad))
+    ret = gst_pad_chain (outpad, buf);
+  else
+    ret = gst_pad_push (outpad, buf);
+
+  if (!is_rtcp) {
+    /* combine all stream flows for the data transport */
+    ret = gst_rtspsrc_combine_flows (src, stream, ret);
+  }
+  return ret;
+}
+
+static GstFlowReturn
+gst_rtspsrc_handle_data (GstRTSPSrc * src, GstRTSPMessage * message)
+{
+  GstRTSPStream *stream;
+  GstPad *outpad;
+  gboolean is_rtcp;
+  GstBuffer *buf;
+
+  buf = gst_rtspsrc_prepare_data (src, message, &stream, &outpad, &is_rtcp);
+  if (buf == NULL)
     return GST_FLOW_OK;
+
+  return gst_rtspsrc_push_data (src, stream, outpad, is_rtcp, buf);
+}
+
+/* pushes the RTP packets collected for all streams */
+static GstFlowReturn
+gst_rtspsrc_flush_pending_data (GstRTSPSrc * src)
+{
+  GstFlowReturn ret = GST_FLOW_OK, res;
+  GList *walk;
+
+  for (walk = src->streams; walk; walk = g_list_next (walk)) {
+    GstRTSPStream *stream = (GstRTSPStream *) walk->data;
+    GstBufferList *list;
+    GstPad *outpad;
+
+    if ((list = stream->pending) == NULL)
+      continue;
+    stream->pending = NULL;
+
+    outpad = stream->channelpad[0];
+    GST_DEBUG_OBJECT (src, "pushing list of %u packets on channel %d",
+        gst_buffer_list_length (list), stream->channel[0]);
+
+    if (GST_PAD_IS_SINK (outpad))
+      res = gst_pad_chain_list (outpad, list);
+    else
+      res = gst_pad_push_list (outpad, list);
+
+    res = gst_rtspsrc_combine_flows (src, stream, res);
+    if (ret == GST_FLOW_OK)
+      ret = res;
   }
+  return ret;
+}
+
+/* Collects RTP packets into a buffer list per stream while more data is
+ * waiting on the socket, so that bursts from the server are pushed with one
+ * call per stream instead of one per packet */
+static GstFlowReturn
+gst_rtspsrc_handle_data_batched (GstRTSPSrc * src, GstRTSPMessage * message)
+{
+  GstRTSPStream *stream;
+  GstPad *outpad;
+  gboolean is_rtcp;
+  GstBuffer *buf;
+  GSocket *socket;
+
+  buf = gst_rtspsrc_prepare_data (src, message, &stream, &outpad, &is_rtcp);
+  if (buf == NULL)
+    return GST_FLOW_OK;
+
+  /* RTCP is rare, just push it */
+  if (is_rtcp || outpad != stream->channelpad[0])
+    return gst_rtspsrc_push_data (src, stream, outpad, is_rtcp, buf);
+
+  if (stream->pending == NULL)
+    stream->pending = gst_buffer_list_new_sized (src->tcp_batch_size);
+  gst_buffer_list_add (stream->pending, buf);
+
+  if (gst_buffer_list_length (stream->pending) >= src->tcp_batch_size)
+    return gst_rtspsrc_flush_pending_data (src);
+
+  socket = gst_rtsp_connection_get_read_socket (src->conninfo.connection);
+  if (socket == NULL || !g_socket_condition_check (socket, G_IO_IN))
+    return gst_rtspsrc_flush_pending_data (src);
+
+  return GST_FLOW_OK;
 }
 
 static GstFlowReturn
@@ -4439,6 +4587,13 @@ gst_rtspsrc_loop_interleaved (GstRTSPSrc * src)
         gst_rtspsrc_connection_receive (src, src->conninfo.connection,
         &message, src->ptcp_timeout);
 
+    /* anything but more data ends the current batch */
+    if (res != GST_RTSP_OK || message.type != GST_RTSP_MESSAGE_DATA) {
+      ret = gst_rtspsrc_flush_pending_data (src);
+      if (ret != GST_FLOW_OK)
+        goto handle_data_failed;
+    }
+
     switch (res) {
       case GST_RTSP_OK:
         GST_DEBUG_OBJECT (src, "we received a server message");
@@ -4478,7 +4633,10 @@ gst_rtspsrc_loop_interleaved (GstRTSPSrc * src)
         break;
       case GST_RTSP_MESSAGE_DATA:
         GST_DEBUG_OBJECT (src, "got data message");
-        ret = gst_rtspsrc_handle_data (src, &message);
+        if (src->tcp_batch_size > 1)
+          ret = gst_rtspsrc_handle_data_batched (src, &message);
+        else
+          ret = gst_rtspsrc_handle_data (src, &message);
         if (ret != GST_FLOW_OK)
           goto handle_data_failed;
         break;
@@ -6441,6 +6599,102 @@ setup_failed:
   }
 }
 
+/* Process-wide cache of the OPTIONS and DESCRIBE results, see the
+ * sdp-cache-ttl property */
+typedef struct
+{
+  gchar *sdp;
+  GstRTSPMethod methods;
+  gchar *content_base;
+  gint64 expires;               /* monotonic time in usec */
+} GstRTSPSrcSdpCacheEntry;
+
+static GMutex sdp_cache_lock;
+static GHashTable *sdp_cache;
+
+static void
+gst_rtspsrc_sdp_cache_entry_free (GstRTSPSrcSdpCacheEntry * entry)
+{
+  g_free (entry->sdp);
+  g_free (entry->content_base);
+  g_slice_free (GstRTSPSrcSdpCacheEntry, entry);
+}
+
+/* the credentials are part of the key, but should not be kept in the clear */
+static gchar *
+gst_rtspsrc_sdp_cache_key (GstRTSPSrc * src)
+{
+  gchar *str, *key;
+
+  str = g_strdup_printf ("%s\n%s\n%s", src->conninfo.location,
+      GST_STR_NULL (src->user_id), GST_STR_NULL (src->user_pw));
+  key = g_compute_checksum_for_string (G_CHECKSUM_SHA256, str, -1);
+  g_free (str);
+
+  return key;
+}
+
+static gboolean
+gst_rtspsrc_sdp_cache_lookup (GstRTSPSrc * src, const gchar * key,
+    GstSDPMessage ** sdp)
+{
+  GstRTSPSrcSdpCacheEntry *entry;
+  gboolean found = FALSE;
+
+  g_mutex_lock (&sdp_cache_lock);
+  if (sdp_cache && (entry = g_hash_table_lookup (sdp_cache, key))) {
+    if (entry->expires > g_get_monotonic_time ()) {
+      gst_sdp_message_new (sdp);
+      gst_sdp_message_parse_buffer ((const guint8 *) entry->sdp,
+          strlen (entry->sdp), *sdp);
+      src->methods = entry->methods;
+      g_free (src->content_base);
+      src->content_base = g_strdup (entry->content_base);
+      found = TRUE;
+    } else {
+      g_hash_table_remove (sdp_cache, key);
+    }
+  }
+  g_mutex_unlock (&sdp_cache_lock);
+
+  return found;
+}
+
+static void
+gst_rtspsrc_sdp_cache_store (GstRTSPSrc * src, const gchar * key,
+    GstSDPMessage * sdp)
+{
+  GstRTSPSrcSdpCacheEntry *entry;
+
+  entry = g_slice_new (GstRTSPSrcSdpCacheEntry);
+  entry->sdp = gst_sdp_message_as_text (sdp);
+  entry->methods = src->methods;
+  entry->content_base = g_strdup (src->content_base);
+  entry->expires = g_get_monotonic_time () +
+      (gint64) src->sdp_cache_ttl * 1000;
+
+  g_mutex_lock (&sdp_cache_lock);
+  if (sdp_cache == NULL)
+    sdp_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) gst_rtspsrc_sdp_cache_entry_free);
+  g_hash_table_replace (sdp_cache, g_strdup (key), entry);
+  g_mutex_unlock (&sdp_cache_lock);
+}
+
+/* called when the cached SDP did not work out */
+static void
+gst_rtspsrc_sdp_cache_invalidate (GstRTSPSrc * src)
+{
+  gchar *key;
+
+  key = gst_rtspsrc_sdp_cache_key (src);
+  g_mutex_lock (&sdp_cache_lock);
+  if (sdp_cache)
+    g_hash_table_remove (sdp_cache, key);
+  g_mutex_unlock (&sdp_cache_lock);
+  g_free (key);
+}
+
 static GstRTSPResult
 gst_rtspsrc_retrieve_sdp (GstRTSPSrc * src, GstSDPMessage ** sdp,
     gboolean async)
@@ -6451,6 +6705,11 @@ gst_rtspsrc_retrieve_sdp (GstRTSPSrc * src, GstSDPMessage ** sdp,
   guint8 *data;
   guint size;
   gchar *respcont = NULL;
+  gchar *cache_key = NULL;
+
+  src->sdp_from_cache = FALSE;
+  if (src->sdp_cache_ttl > 0 && src->conninfo.location != NULL)
+    cache_key = gst_rtspsrc_sdp_cache_key (src);
 
 restart:
   src->need_redirect = FALSE;
@@ -6465,6 +6724,13 @@ restart:
   if ((res = gst_rtsp_conninfo_connect (src, &src->conninfo, async)) < 0)
     goto connect_failed;
 
+  if (cache_key && gst_rtspsrc_sdp_cache_lookup (src, cache_key, sdp)) {
+    GST_DEBUG_OBJECT (src, "using cached SDP, skipping OPTIONS and DESCRIBE");
+    src->sdp_from_cache = TRUE;
+    g_free (cache_key);
+    return GST_RTSP_OK;
+  }
+
   /* create OPTIONS */
   GST_DEBUG_OBJECT (src, "create options...");
   res =
@@ -6520,7 +6786,9 @@ restart:
     gst_rtsp_message_unset (&request);
     gst_rtsp_message_unset (&response);
 
-    /* and now retry */
+    /* and now retry, the result is not cached for the original location */
+    g_free (cache_key);
+    cache_key = NULL;
     goto restart;
   }
 
@@ -6547,6 +6815,11 @@ restart:
   gst_sdp_message_new (sdp);
   gst_sdp_message_parse_buffer (data, size, *sdp);
 
+  if (cache_key) {
+    gst_rtspsrc_sdp_cache_store (src, cache_key, *sdp);
+    g_free (cache_key);
+  }
+
   /* clean up any messages */
   gst_rtsp_message_unset (&request);
   gst_rtsp_message_unset (&response);
@@ -6616,6 +6889,7 @@ cleanup_error:
     }
     gst_rtsp_message_unset (&request);
     gst_rtsp_message_unset (&response);
+    g_free (cache_key);
     return res;
   }
 }
@@ -6652,6 +6926,8 @@ no_sdp:
 open_failed:
   {
     GST_WARNING_OBJECT (src, "can't setup streaming from sdp");
+    if (src->sdp_from_cache)
+      gst_rtspsrc_sdp_cache_invalidate (src);
     src->open_error = TRUE;
     goto done;
   }
@@ -110,6 +110,7 @@ struct _GstRTSPStream {
   /* for interleaved mode */
   guint8        channel[2];
   GstPad       *channelpad[2];
+  GstBufferList *pending;   /* RTP packets not pushed yet */
 
   /* our udp sources */
   GstElement   *udpsrc[2];
@@ -233,6 +234,9 @@ struct _GstRTSPSrc {
   GstStructure     *sdes;
   GTlsCertificateFlags tls_validation_flags;
   GTlsDatabase     *tls_database;
+  guint             tcp_batch_size;
+  guint             sdp_cache_ttl;
+  gboolean          sdp_from_cache;
 
   /* state */
   GstRTSPState       state;
@@ -55,6 +55,7 @@ static void gst_shape_wipe_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 
 static void gst_shape_wipe_reset (GstShapeWipe * self);
+static void gst_shape_wipe_free_mask_index (GstShapeWipe * self);
 static void gst_shape_wipe_update_qos (GstShapeWipe * self, gdouble proportion,
     GstClockTimeDiff diff, GstClockTime time);
 static void gst_shape_wipe_reset_qos (GstShapeWipe * self);
@@ -268,6 +269,8 @@ gst_shape_wipe_reset (GstShapeWipe * self)
     gst_buffer_unref (self->mask);
   self->mask = NULL;
 
+  gst_shape_wipe_free_mask_index (self);
+
   g_mutex_lock (&self->mask_mutex);
   g_cond_signal (&self->mask_cond);
   g_mutex_unlock (&self->mask_mutex);
@@ -752,23 +755,110 @@ gst_shape_wipe_do_qos (GstShapeWipe * self, GstClockTime timestamp)
   return TRUE;
 }
 
-#define CREATE_ARGB_FUNCTIONS(depth, name, shift, a, r, g, b) \
+/* Number of pixels of a row that share one entry of the mask index */
+#define MASK_SPAN 16
+
+static void
+gst_shape_wipe_free_mask_index (GstShapeWipe * self)
+{
+  gst_buffer_replace (&self->index_mask, NULL);
+
+  g_free (self->index_spans);
+  self->index_spans = NULL;
+  g_free (self->index_level_start);
+  self->index_level_start = NULL;
+  g_free (self->index_span_max);
+  self->index_span_max = NULL;
+  g_free (self->index_alpha);
+  self->index_alpha = NULL;
+  self->index_levels = 0;
+}
+
+/* The mask is static over the transition, so its spans of MASK_SPAN pixels
+ * are sorted once by their minimum value. For every frame the spans that
+ * have no mask value below the upper end of the border keep their alpha and
+ * are not touched at all, they are all at the end of the index */
+static void
+gst_shape_wipe_update_mask_index (GstShapeWipe * self, GstBuffer * mask,
+    GstVideoFrame * maskframe)
+{
+  const guint8 *data = GST_VIDEO_FRAME_PLANE_DATA (maskframe, 0);
+  gint stride = GST_VIDEO_FRAME_PLANE_STRIDE (maskframe, 0);
+  guint width = GST_VIDEO_FRAME_WIDTH (maskframe);
+  guint height = GST_VIDEO_FRAME_HEIGHT (maskframe);
+  guint levels = (self->mask_bpp == 16) ? 65536 : 256;
+  guint spans_per_row = (width + MASK_SPAN - 1) / MASK_SPAN;
+  guint n_spans = spans_per_row * height;
+  guint16 *span_min;
+  guint32 *start;
+  guint i, j, k, l;
+
+  GST_DEBUG_OBJECT (self, "Building index of %u mask spans", n_spans);
+
+  gst_shape_wipe_free_mask_index (self);
+
+  self->index_mask = gst_buffer_ref (mask);
+  self->index_levels = levels;
+  self->index_width = width;
+  self->index_spans_per_row = spans_per_row;
+  self->index_spans = g_new (guint32, n_spans);
+  self->index_level_start = start = g_new0 (guint32, levels + 1);
+  self->index_span_max = g_new (guint16, n_spans);
+  self->index_alpha = g_new (guint32, levels);
+
+  span_min = g_new (guint16, n_spans);
+
+  for (i = 0, k = 0; i < height; i++) {
+    const guint8 *row8 = data + i * stride;
+    const guint16 *row16 = (const guint16 *) row8;
+
+    for (j = 0; j < width; j += MASK_SPAN, k++) {
+      guint end = MIN (j + MASK_SPAN, width);
+      guint min = G_MAXUINT16, max = 0;
+
+      for (l = j; l < end; l++) {
+        guint v = (self->mask_bpp == 16) ? row16[l] : row8[l];
+
+        min = MIN (min, v);
+        max = MAX (max, v);
+      }
+
+      span_min[k] = min;
+      self->index_span_max[k] = max;
+      start[min + 1]++;
+    }
+  }
+
+  /* counting sort, start[l] becomes the number of spans with a minimum
+   * below l */
+  for (l = 1; l <= levels; l++)
+    start[l] += start[l - 1];
+  for (k = 0; k < n_spans; k++)
+    self->index_spans[start[span_min[k]]++] = k;
+  for (l = levels; l > 0; l--)
+    start[l] = start[l - 1];
+  start[0] = 0;
+
+  g_free (span_min);
+}
+
+#define CREATE_ARGB_FUNCTIONS(depth, name, shift, a) \
 static void \
-gst_shape_wipe_blend_##name##_##depth (GstShapeWipe * self, GstVideoFrame * inframe, \
-    GstVideoFrame * maskframe, GstVideoFrame * outframe) \
+gst_shape_wipe_blend_##name##_##depth (GstShapeWipe * self, GstVideoFrame * frame, \
+    GstVideoFrame * maskframe) \
 { \
-  const guint##depth *mask = (const guint##depth *) GST_VIDEO_FRAME_PLANE_DATA (maskframe, 0); \
-  const guint8 *input = (const guint8 *) GST_VIDEO_FRAME_PLANE_DATA (inframe, 0); \
-  guint8 *output = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (outframe, 0); \
-  guint i, j; \
-  gint width = GST_VIDEO_FRAME_WIDTH (inframe); \
-  gint height = GST_VIDEO_FRAME_HEIGHT (inframe); \
-  guint mask_increment = ((depth == 16) ? GST_ROUND_UP_2 (width) : \
-                           GST_ROUND_UP_4 (width)) - width; \
+  const guint8 *mask = (const guint8 *) GST_VIDEO_FRAME_PLANE_DATA (maskframe, 0); \
+  gint mask_stride = GST_VIDEO_FRAME_PLANE_STRIDE (maskframe, 0); \
+  guint8 *data = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 0); \
+  gint stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0); \
+  guint spans_per_row = self->index_spans_per_row; \
+  guint32 *alpha = self->index_alpha; \
   gfloat position = self->mask_position; \
   gfloat low = position - (self->mask_border / 2.0f); \
   gfloat high = position + (self->mask_border / 2.0f); \
   guint32 low_i, high_i, round_i; \
+  guint low_level, high_level, level; \
+  guint i, j, n; \
   \
   if (low < 0.0f) { \
     high = 0.0f; \
@@ -784,45 +874,48 @@ gst_shape_wipe_blend_##name##_##depth (GstShapeWipe * self, GstVideoFrame * infr
   high_i = high * 65536; \
   round_i = (high_i - low_i) >> 1; \
   \
-  for (i = 0; i < height; i++) { \
-    for (j = 0; j < width; j++) { \
-      guint32 in = *mask << shift; \
+  /* mask values below low_level are transparent, the ones from high_level \
+   * on keep the alpha of the frame */ \
+  low_level = (low_i + (1 << shift) - 1) >> shift; \
+  high_level = (high_i + (1 << shift) - 1) >> shift; \
+  \
+  for (level = low_level; level < high_level; level++) { \
+    /* Note: This will never overflow or be larger than 255! */ \
+    alpha[level] = ((((level << shift) - low_i) << 16) + round_i) / \
+        (high_i - low_i); \
+  } \
+  \
+  n = self->index_level_start[high_level]; \
+  for (i = 0; i < n; i++) { \
+    guint span = self->index_spans[i]; \
+    guint y = span / spans_per_row; \
+    guint x = (span % spans_per_row) * MASK_SPAN; \
+    guint end = MIN (x + MASK_SPAN, self->index_width); \
+    guint8 *out = data + y * stride + x * 4 + a; \
+    \
+    if (self->index_span_max[span] < low_level) { \
+      for (j = x; j < end; j++, out += 4) \
+        *out = 0x00; \
+    } else { \
+      const guint##depth *m = (const guint##depth *) (mask + y * mask_stride); \
       \
-      if (in < low_i) { \
-        output[a] = 0x00;       /* A */ \
-        output[r] = input[r];   /* R */ \
-        output[g] = input[g];   /* G */ \
-        output[b] = input[b];   /* B */ \
-      } else if (in >= high_i) { \
-        output[a] = input[a];   /* A */ \
-        output[r] = input[r];   /* R */ \
-        output[g] = input[g];   /* G */ \
-        output[b] = input[b];   /* B */ \
-      } else { \
-        guint32 val; \
-        /* Note: This will never overflow or be larger than 255! */ \
-        val = (((in - low_i) << 16) + round_i) / (high_i - low_i); \
-        val = (val * input[a] + 32768) >> 16; \
+      for (j = x; j < end; j++, out += 4) { \
+        level = m[j]; \
         \
-        output[a] = val;        /* A */ \
-        output[r] = input[r];   /* R */ \
-        output[g] = input[g];   /* G */ \
-        output[b] = input[b];   /* B */ \
+        if (level < low_level) \
+          *out = 0x00; \
+        else if (level < high_level) \
+          *out = (alpha[level] * *out + 32768) >> 16; \
       } \
-      \
-      mask++; \
-      input += 4; \
-      output += 4; \
     } \
-    mask += mask_increment; \
   } \
 }
 
-CREATE_ARGB_FUNCTIONS (16, argb, 0, 0, 1, 2, 3);
-CREATE_ARGB_FUNCTIONS (8, argb, 8, 0, 1, 2, 3);
+CREATE_ARGB_FUNCTIONS (16, argb, 0, 0);
+CREATE_ARGB_FUNCTIONS (8, argb, 8, 0);
 
-CREATE_ARGB_FUNCTIONS (16, bgra, 0, 3, 2, 1, 0);
-CREATE_ARGB_FUNCTIONS (8, bgra, 8, 3, 2, 1, 0);
+CREATE_ARGB_FUNCTIONS (16, bgra, 0, 3);
+CREATE_ARGB_FUNCTIONS (8, bgra, 8, 3);
 
 static GstFlowReturn
 gst_shape_wipe_video_sink_chain (GstPad * pad, GstObject * parent,
@@ -832,7 +925,7 @@ gst_shape_wipe_video_sink_chain (GstPad * pad, GstObject * parent,
   GstFlowReturn ret = GST_FLOW_OK;
   GstBuffer *mask = NULL, *outbuf = NULL;
   GstClockTime timestamp;
-  GstVideoFrame inframe, outframe, maskframe;
+  GstVideoFrame frame, maskframe;
 
   if (G_UNLIKELY (GST_VIDEO_INFO_FORMAT (&self->vinfo) ==
           GST_VIDEO_FORMAT_UNKNOWN))
@@ -866,36 +959,38 @@ gst_shape_wipe_video_sink_chain (GstPad * pad, GstObject * parent,
   if (!gst_shape_wipe_do_qos (self, GST_BUFFER_TIMESTAMP (buffer)))
     goto qos;
 
-  /* Will blend inplace if buffer is writable */
+  /* Blends inplace, only the alpha channel of the buffer is changed */
   outbuf = gst_buffer_make_writable (buffer);
-  gst_video_frame_map (&outframe, &self->vinfo, outbuf, GST_MAP_READWRITE);
-  gst_video_frame_map (&inframe, &self->vinfo, outbuf, GST_MAP_READ);
+  gst_video_frame_map (&frame, &self->vinfo, outbuf, GST_MAP_READWRITE);
 
   gst_video_frame_map (&maskframe, &self->minfo, mask, GST_MAP_READ);
 
+  if (mask != self->index_mask ||
+      self->index_levels != (self->mask_bpp == 16 ? 65536 : 256))
+    gst_shape_wipe_update_mask_index (self, mask, &maskframe);
+
   switch (GST_VIDEO_INFO_FORMAT (&self->vinfo)) {
     case GST_VIDEO_FORMAT_AYUV:
     case GST_VIDEO_FORMAT_ARGB:
     case GST_VIDEO_FORMAT_ABGR:
       if (self->mask_bpp == 16)
-        gst_shape_wipe_blend_argb_16 (self, &inframe, &maskframe, &outframe);
+        gst_shape_wipe_blend_argb_16 (self, &frame, &maskframe);
       else
-        gst_shape_wipe_blend_argb_8 (self, &inframe, &maskframe, &outframe);
+        gst_shape_wipe_blend_argb_8 (self, &frame, &maskframe);
       break;
     case GST_VIDEO_FORMAT_BGRA:
     case GST_VIDEO_FORMAT_RGBA:
       if (self->mask_bpp == 16)
-        gst_shape_wipe_blend_bgra_16 (self, &inframe, &maskframe, &outframe);
+        gst_shape_wipe_blend_bgra_16 (self, &frame, &maskframe);
       else
-        gst_shape_wipe_blend_bgra_8 (self, &inframe, &maskframe, &outframe);
+        gst_shape_wipe_blend_bgra_8 (self, &frame, &maskframe);
       break;
     default:
       g_assert_not_reached ();
       break;
   }
 
-  gst_video_frame_unmap (&outframe);
-  gst_video_frame_unmap (&inframe);
+  gst_video_frame_unmap (&frame);
 
   gst_video_frame_unmap (&maskframe);
 
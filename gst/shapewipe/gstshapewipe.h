@@ -59,6 +59,17 @@ struct _GstShapeWipe
   GCond mask_cond;
   gint mask_bpp;
 
+  /* spans of the mask sorted by their minimum value, built once for every
+   * new mask, see gst_shape_wipe_update_mask_index() */
+  GstBuffer *index_mask;
+  guint index_levels;
+  guint index_width;
+  guint index_spans_per_row;
+  guint32 *index_spans;
+  guint32 *index_level_start;
+  guint16 *index_span_max;
+  guint32 *index_alpha;
+
   GstVideoInfo vinfo;
   GstVideoInfo minfo;
 
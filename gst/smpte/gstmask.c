@@ -26,6 +26,14 @@
 
 static GList *masks = NULL;
 
+/* Generated masks are shared by all elements of the process, most recently
+ * used first. Masks that are not used anymore are kept for the next element
+ * that asks for one, up to this many */
+#define MASK_CACHE_UNUSED 4
+
+G_LOCK_DEFINE_STATIC (mask_cache);
+static GList *mask_cache = NULL;
+
 void
 _gst_mask_init (void)
 {
@@ -68,17 +76,57 @@ gst_mask_find_definition (gint type)
   return NULL;
 }
 
+/* Destroys the unused masks beyond the first MASK_CACHE_UNUSED ones, with
+ * the cache lock held */
+static void
+gst_mask_cache_trim (void)
+{
+  GList *walk = mask_cache;
+  guint unused = 0;
+
+  while (walk) {
+    GstMask *mask = walk->data;
+    GList *next = g_list_next (walk);
+
+    if (mask->refcount == 0 && ++unused > MASK_CACHE_UNUSED) {
+      mask_cache = g_list_delete_link (mask_cache, walk);
+      if (mask->destroy_func)
+        mask->destroy_func (mask);
+    }
+    walk = next;
+  }
+}
+
+/* Returns a shared, read-only mask, release it with gst_mask_destroy() */
 GstMask *
 gst_mask_factory_new (gint type, gboolean invert, gint bpp, gint width,
     gint height)
 {
   GstMaskDefinition *definition;
   GstMask *mask = NULL;
+  GList *walk;
+
+  G_LOCK (mask_cache);
+  for (walk = mask_cache; walk; walk = g_list_next (walk)) {
+    mask = walk->data;
+
+    if (mask->type == type && mask->invert == (! !invert) &&
+        mask->bpp == bpp && mask->width == width && mask->height == height) {
+      mask->refcount++;
+      mask_cache = g_list_remove_link (mask_cache, walk);
+      mask_cache = g_list_concat (walk, mask_cache);
+      G_UNLOCK (mask_cache);
+      return mask;
+    }
+  }
+  mask = NULL;
 
   definition = gst_mask_find_definition (type);
   if (definition) {
     mask = g_new0 (GstMask, 1);
 
+    mask->refcount = 1;
+    mask->invert = ! !invert;
     mask->type = definition->type;
     mask->bpp = bpp;
     mask->width = width;
@@ -101,7 +149,10 @@ gst_mask_factory_new (gint type, gboolean invert, gint bpp, gint width,
         }
       }
     }
+
+    mask_cache = g_list_prepend (mask_cache, mask);
   }
+  G_UNLOCK (mask_cache);
 
   return mask;
 }
@@ -113,9 +164,14 @@ _gst_mask_default_destroy (GstMask * mask)
   g_free (mask);
 }
 
+/* Releases a mask returned by gst_mask_factory_new(), it stays in the cache
+ * for a while */
 void
 gst_mask_destroy (GstMask * mask)
 {
-  if (mask->destroy_func)
-    mask->destroy_func (mask);
+  G_LOCK (mask_cache);
+  g_assert (mask->refcount > 0);
+  if (--mask->refcount == 0)
+    gst_mask_cache_trim ();
+  G_UNLOCK (mask_cache);
 }
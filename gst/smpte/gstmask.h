@@ -39,6 +39,10 @@ struct _GstMaskDefinition {
 };
 
 struct _GstMask {
+  /* <private> */
+  gint                   refcount;
+  gboolean               invert;
+
   gint                   type;
   guint32               *data;
   gconstpointer          user_data;
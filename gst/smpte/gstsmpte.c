@@ -46,6 +46,11 @@
 #include "gstsmpte.h"
 #include "paint.h"
 
+#if defined(__SSE2__)
+#define HAVE_SMPTE_SSE2 1
+#include <emmintrin.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (gst_smpte_debug);
 #define GST_CAT_DEFAULT gst_smpte_debug
 
@@ -376,6 +381,10 @@ gst_smpte_finalize (GstSMPTE * smpte)
   if (smpte->collect) {
     gst_object_unref (smpte->collect);
   }
+  if (smpte->mask) {
+    gst_mask_destroy (smpte->mask);
+    smpte->mask = NULL;
+  }
 
   G_OBJECT_CLASS (parent_class)->finalize ((GObject *) smpte);
 }
@@ -390,25 +399,103 @@ gst_smpte_reset (GstSMPTE * smpte)
   smpte->send_stream_start = TRUE;
 }
 
+/* Converts a row of mask values to blend weights between 0 and 256 */
+static void
+gst_smpte_mask_weights (const guint32 * maskp, guint16 * weights, gint width,
+    gint min, gint border)
+{
+  gint max = min + border;
+  gint j = 0;
+
+#ifdef HAVE_SMPTE_SSE2
+  {
+    const __m128i vmin = _mm_set1_epi32 (min);
+    const __m128i vmax = _mm_set1_epi32 (max);
+    const __m128d vscale = _mm_set1_pd (256.0);
+    const __m128d vborder = _mm_set1_pd (border);
+
+    /* c * 256 / border is at most 256 and at least 1 / border away from the
+     * next integer when it is not one, so the double division truncates to
+     * the same value as the integer division */
+    for (; j + 4 <= width; j += 4) {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (maskp + j));
+      __m128i m, q;
+      __m128d lo, hi;
+
+      m = _mm_cmpgt_epi32 (vmin, v);
+      v = _mm_or_si128 (_mm_and_si128 (m, vmin), _mm_andnot_si128 (m, v));
+      m = _mm_cmpgt_epi32 (v, vmax);
+      v = _mm_or_si128 (_mm_and_si128 (m, vmax), _mm_andnot_si128 (m, v));
+      v = _mm_sub_epi32 (v, vmin);
+
+      lo = _mm_cvtepi32_pd (v);
+      hi = _mm_cvtepi32_pd (_mm_shuffle_epi32 (v, _MM_SHUFFLE (1, 0, 3, 2)));
+      lo = _mm_div_pd (_mm_mul_pd (lo, vscale), vborder);
+      hi = _mm_div_pd (_mm_mul_pd (hi, vscale), vborder);
+      q = _mm_unpacklo_epi64 (_mm_cvttpd_epi32 (lo), _mm_cvttpd_epi32 (hi));
+      q = _mm_packs_epi32 (q, q);
+      _mm_storel_epi64 ((__m128i *) (weights + j), q);
+    }
+  }
+#endif
+
+  for (; j < width; j++) {
+    gint value = maskp[j];
+
+    weights[j] = (((gint64) (CLAMP (value, min, max) - min)) << 8) / border;
+  }
+}
+
+/* out = (in1 * weight + in2 * (256 - weight)) >> 8 */
+static void
+gst_smpte_blend_line (guint8 * out, const guint8 * in1, const guint8 * in2,
+    const guint16 * weights, gint width)
+{
+  gint j = 0;
+
+#ifdef HAVE_SMPTE_SSE2
+  {
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i full = _mm_set1_epi16 (256);
+
+    /* both products sum up to at most 255 * 256, so 16 bits are enough */
+    for (; j + 8 <= width; j += 8) {
+      __m128i w = _mm_loadu_si128 ((const __m128i *) (weights + j));
+      __m128i a = _mm_loadl_epi64 ((const __m128i *) (in1 + j));
+      __m128i b = _mm_loadl_epi64 ((const __m128i *) (in2 + j));
+
+      a = _mm_mullo_epi16 (_mm_unpacklo_epi8 (a, zero), w);
+      b = _mm_mullo_epi16 (_mm_unpacklo_epi8 (b, zero),
+          _mm_sub_epi16 (full, w));
+      a = _mm_srli_epi16 (_mm_add_epi16 (a, b), 8);
+      _mm_storel_epi64 ((__m128i *) (out + j), _mm_packus_epi16 (a, a));
+    }
+  }
+#endif
+
+  for (; j < width; j++)
+    out[j] = ((in1[j] * weights[j]) + (in2[j] * (256 - weights[j]))) >> 8;
+}
+
 static void
 gst_smpte_blend_i420 (GstVideoFrame * frame1, GstVideoFrame * frame2,
     GstVideoFrame * oframe, GstMask * mask, gint border, gint pos)
 {
-  guint32 *maskp;
-  gint value;
+  const guint32 *maskp;
+  guint16 *weights, *cweights;
   gint i, j;
-  gint min, max;
+  gint min;
   guint8 *in1, *in2, *out, *in1u, *in1v, *in2u, *in2v, *outu, *outv;
-  gint width, height;
+  gint width, height, cwidth;
 
   if (border == 0)
     border++;
 
   min = pos - border;
-  max = pos;
 
   width = GST_VIDEO_FRAME_WIDTH (frame1);
   height = GST_VIDEO_FRAME_HEIGHT (frame1);
+  cwidth = (width + 1) / 2;
 
   in1 = GST_VIDEO_FRAME_COMP_DATA (frame1, 0);
   in2 = GST_VIDEO_FRAME_COMP_DATA (frame2, 0);
@@ -421,20 +508,24 @@ gst_smpte_blend_i420 (GstVideoFrame * frame1, GstVideoFrame * frame2,
   outu = GST_VIDEO_FRAME_COMP_DATA (oframe, 1);
   outv = GST_VIDEO_FRAME_COMP_DATA (oframe, 2);
 
+  weights = g_new (guint16, width + cwidth);
+  cweights = weights + width;
+
   maskp = mask->data;
 
   for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      value = *maskp++;
-      value = ((CLAMP (value, min, max) - min) << 8) / border;
-
-      out[j] = ((in1[j] * value) + (in2[j] * (256 - value))) >> 8;
-      if (!(i & 1) && !(j & 1)) {
-        outu[j / 2] =
-            ((in1u[j / 2] * value) + (in2u[j / 2] * (256 - value))) >> 8;
-        outv[j / 2] =
-            ((in1v[j / 2] * value) + (in2v[j / 2] * (256 - value))) >> 8;
-      }
+    gst_smpte_mask_weights (maskp, weights, width, min, border);
+    maskp += width;
+
+    gst_smpte_blend_line (out, in1, in2, weights, width);
+
+    /* the chroma of even rows uses the weights of the even pixels */
+    if (!(i & 1)) {
+      for (j = 0; j < cwidth; j++)
+        cweights[j] = weights[2 * j];
+
+      gst_smpte_blend_line (outu, in1u, in2u, cweights, cwidth);
+      gst_smpte_blend_line (outv, in1v, in2v, cweights, cwidth);
     }
 
     in1 += GST_VIDEO_FRAME_COMP_STRIDE (frame1, 0);
@@ -445,11 +536,13 @@ gst_smpte_blend_i420 (GstVideoFrame * frame1, GstVideoFrame * frame2,
       in1u += GST_VIDEO_FRAME_COMP_STRIDE (frame1, 1);
       in2u += GST_VIDEO_FRAME_COMP_STRIDE (frame2, 1);
       in1v += GST_VIDEO_FRAME_COMP_STRIDE (frame1, 2);
-      in2v += GST_VIDEO_FRAME_COMP_STRIDE (frame1, 2);
+      in2v += GST_VIDEO_FRAME_COMP_STRIDE (frame2, 2);
       outu += GST_VIDEO_FRAME_COMP_STRIDE (oframe, 1);
       outv += GST_VIDEO_FRAME_COMP_STRIDE (oframe, 2);
     }
   }
+
+  g_free (weights);
 }
 
 static GstFlowReturn
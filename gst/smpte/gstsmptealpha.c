@@ -56,6 +56,11 @@
 #include "gstsmptealpha.h"
 #include "paint.h"
 
+#if defined(__SSE2__)
+#define HAVE_SMPTE_ALPHA_SSE2 1
+#include <emmintrin.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (gst_smpte_alpha_debug);
 #define GST_CAT_DEFAULT gst_smpte_alpha_debug
 
@@ -272,26 +277,82 @@ gst_smpte_alpha_init (GstSMPTEAlpha * smpte)
   smpte->invert = DEFAULT_PROP_INVERT;
 }
 
-#define CREATE_ARGB_FUNC(name, A, R, G, B) \
+/* Copies a row of 4 byte pixels and scales the alpha byte at offset A with
+ * the mask, alpha = alpha * (CLAMP (mask, min, max) - min) / border */
+static void
+gst_smpte_alpha_scale_line (guint8 * out, const guint8 * in,
+    const guint32 * maskp, gint width, gint A, gint min, gint border)
+{
+  gint max = min + border;
+  gint j = 0;
+
+#ifdef HAVE_SMPTE_ALPHA_SSE2
+  {
+    const __m128i vmin = _mm_set1_epi32 (min);
+    const __m128i vmax = _mm_set1_epi32 (max);
+    const __m128i amask = _mm_set1_epi32 (0xff << (A * 8));
+    const __m128d vborder = _mm_set1_pd (border);
+    const __m128i shift = _mm_cvtsi32_si128 (A * 8);
+
+    /* the product fits in a double exactly and the quotient is at most 255
+     * and at least 1 / border away from the next integer when it is not one,
+     * so truncating it gives the same value as the integer division */
+    for (; j + 4 <= width; j += 4) {
+      __m128i px = _mm_loadu_si128 ((const __m128i *) (in + 4 * j));
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (maskp + j));
+      __m128i a, m, q;
+      __m128d lo, hi;
+
+      m = _mm_cmpgt_epi32 (vmin, v);
+      v = _mm_or_si128 (_mm_and_si128 (m, vmin), _mm_andnot_si128 (m, v));
+      m = _mm_cmpgt_epi32 (v, vmax);
+      v = _mm_or_si128 (_mm_and_si128 (m, vmax), _mm_andnot_si128 (m, v));
+      v = _mm_sub_epi32 (v, vmin);
+
+      a = _mm_srl_epi32 (_mm_and_si128 (px, amask), shift);
+
+      lo = _mm_mul_pd (_mm_cvtepi32_pd (v), _mm_cvtepi32_pd (a));
+      hi = _mm_mul_pd (_mm_cvtepi32_pd (_mm_shuffle_epi32 (v,
+                  _MM_SHUFFLE (1, 0, 3, 2))),
+          _mm_cvtepi32_pd (_mm_shuffle_epi32 (a, _MM_SHUFFLE (1, 0, 3, 2))));
+      lo = _mm_div_pd (lo, vborder);
+      hi = _mm_div_pd (hi, vborder);
+      q = _mm_unpacklo_epi64 (_mm_cvttpd_epi32 (lo), _mm_cvttpd_epi32 (hi));
+      q = _mm_sll_epi32 (q, shift);
+
+      px = _mm_or_si128 (_mm_andnot_si128 (amask, px), q);
+      _mm_storeu_si128 ((__m128i *) (out + 4 * j), px);
+    }
+  }
+#endif
+
+  for (; j < width; j++) {
+    gint value = maskp[j];
+
+    memcpy (out + 4 * j, in + 4 * j, 4);
+    out[4 * j + A] = ((guint64) in[4 * j + A] *
+        (CLAMP (value, min, max) - min)) / border;
+  }
+}
+
+#define CREATE_ARGB_FUNC(name, A) \
 static void \
 gst_smpte_alpha_process_##name##_##name (GstSMPTEAlpha * smpte, \
     const GstVideoFrame * in_frame, GstVideoFrame * out_frame, GstMask * mask, \
     gint border, gint pos) \
 { \
-  gint i, j; \
+  gint i; \
   const guint32 *maskp; \
-  gint value; \
-  gint min, max; \
+  gint min; \
   gint width, height; \
   guint8 *in, *out; \
-  gint src_wrap, dest_wrap; \
+  gint src_stride, dest_stride; \
   \
   if (border == 0) \
     border++; \
   \
   min = pos - border; \
-  max = pos; \
-  GST_DEBUG_OBJECT (smpte, "pos %d, min %d, max %d, border %d", pos, min, max, \
+  GST_DEBUG_OBJECT (smpte, "pos %d, min %d, max %d, border %d", pos, min, pos, \
       border); \
   \
   maskp = mask->data; \
@@ -301,76 +362,24 @@ gst_smpte_alpha_process_##name##_##name (GstSMPTEAlpha * smpte, \
   \
   in = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0); \
   out = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0); \
-  src_wrap = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0) - (width << 2); \
-  dest_wrap = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0) - (width << 2); \
+  src_stride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0); \
+  dest_stride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0); \
   \
   /* we basically copy the source to dest but we scale the alpha channel with \
    * the mask */ \
   for (i = 0; i < height; i++) { \
-    for (j = 0; j < width; j++) { \
-      value = *maskp++; \
-      out[A] = (in[A] * ((CLAMP (value, min, max) - min) << 8) / border) >> 8; \
-      out[R] = in[R]; \
-      out[G] = in[G]; \
-      out[B] = in[B]; \
-      out += 4; \
-      in += 4; \
-    } \
-    in += src_wrap; \
-    out += dest_wrap; \
+    gst_smpte_alpha_scale_line (out, in, maskp, width, A, min, border); \
+    maskp += width; \
+    in += src_stride; \
+    out += dest_stride; \
   } \
 }
 
-CREATE_ARGB_FUNC (argb, 0, 1, 2, 3);
-CREATE_ARGB_FUNC (bgra, 3, 2, 1, 0);
-CREATE_ARGB_FUNC (abgr, 0, 3, 2, 1);
-CREATE_ARGB_FUNC (rgba, 3, 0, 1, 2);
-
-static void
-gst_smpte_alpha_process_ayuv_ayuv (GstSMPTEAlpha * smpte,
-    const GstVideoFrame * in_frame, GstVideoFrame * out_frame, GstMask * mask,
-    gint border, gint pos)
-{
-  gint i, j;
-  const guint32 *maskp;
-  gint value;
-  gint min, max;
-  gint width, height;
-  guint8 *in, *out;
-  gint src_wrap, dest_wrap;
-
-  if (border == 0)
-    border++;
-
-  min = pos - border;
-  max = pos;
-  GST_DEBUG_OBJECT (smpte, "pos %d, min %d, max %d, border %d", pos, min, max,
-      border);
-
-  maskp = mask->data;
-
-  width = GST_VIDEO_FRAME_WIDTH (out_frame);
-  height = GST_VIDEO_FRAME_HEIGHT (out_frame);
-
-  in = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  out = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-  src_wrap = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0) - (width << 2);
-  dest_wrap = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0) - (width << 2);
-
-  /* we basically copy the source to dest but we scale the alpha channel with
-   * the mask */
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      value = *maskp++;
-      *out++ = (*in++ * ((CLAMP (value, min, max) - min) << 8) / border) >> 8;
-      *out++ = *in++;
-      *out++ = *in++;
-      *out++ = *in++;
-    }
-    in += src_wrap;
-    out += dest_wrap;
-  }
-}
+CREATE_ARGB_FUNC (argb, 0);
+CREATE_ARGB_FUNC (bgra, 3);
+CREATE_ARGB_FUNC (abgr, 0);
+CREATE_ARGB_FUNC (rgba, 3);
+CREATE_ARGB_FUNC (ayuv, 0);
 
 static void
 gst_smpte_alpha_process_i420_ayuv (GstSMPTEAlpha * smpte,
@@ -128,6 +128,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_spectrum_debug);
 #define DEFAULT_BANDS			128
 #define DEFAULT_THRESHOLD		-60
 #define DEFAULT_MULTI_CHANNEL		FALSE
+#define DEFAULT_HOP_SIZE		0
 
 enum
 {
@@ -138,7 +139,8 @@ enum
   PROP_INTERVAL,
   PROP_BANDS,
   PROP_THRESHOLD,
-  PROP_MULTI_CHANNEL
+  PROP_MULTI_CHANNEL,
+  PROP_HOP_SIZE
 };
 
 #define gst_spectrum_parent_class parent_class
@@ -217,6 +219,21 @@ gst_spectrum_class_init (GstSpectrumClass * klass)
           "Send separate results for each channel",
           DEFAULT_MULTI_CHANNEL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstSpectrum:hop-size:
+   *
+   * Number of frames between the start of two FFTs. Values smaller than the
+   * FFT length of 2 * #GstSpectrum:bands - 2 frames make consecutive FFTs
+   * overlap, 0 or larger values run them back to back.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_HOP_SIZE,
+      g_param_spec_uint ("hop-size", "Hop size",
+          "Number of frames between two FFTs (0 = FFT length, no overlap)",
+          0, G_MAXUINT, DEFAULT_HOP_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (gst_spectrum_debug, "spectrum", 0,
       "audio spectrum analyser element");
 
@@ -241,6 +258,7 @@ gst_spectrum_init (GstSpectrum * spectrum)
   spectrum->interval = DEFAULT_INTERVAL;
   spectrum->bands = DEFAULT_BANDS;
   spectrum->threshold = DEFAULT_THRESHOLD;
+  spectrum->hop_size = DEFAULT_HOP_SIZE;
 
   g_mutex_init (&spectrum->lock);
 }
@@ -261,6 +279,11 @@ gst_spectrum_alloc_channel_data (GstSpectrum * spectrum)
   GST_DEBUG_OBJECT (spectrum, "allocating data for %d channels",
       spectrum->num_channels);
 
+  /* same as GST_FFT_WINDOW_HAMMING, but only calculated once */
+  spectrum->window = g_new (gfloat, nfft);
+  for (i = 0; i < nfft; i++)
+    spectrum->window[i] = 0.53836 - 0.46164 * cos (2.0 * G_PI * i / nfft);
+
   spectrum->channel_data = g_new (GstSpectrumChannel, spectrum->num_channels);
   for (i = 0; i < spectrum->num_channels; i++) {
     cd = &spectrum->channel_data[i];
@@ -295,6 +318,8 @@ gst_spectrum_free_channel_data (GstSpectrum * spectrum)
     }
     g_free (spectrum->channel_data);
     spectrum->channel_data = NULL;
+    g_free (spectrum->window);
+    spectrum->window = NULL;
   }
 }
 
@@ -376,6 +401,16 @@ gst_spectrum_set_property (GObject * object, guint prop_id,
       g_mutex_unlock (&filter->lock);
       break;
     }
+    case PROP_HOP_SIZE:{
+      guint hop_size = g_value_get_uint (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->hop_size != hop_size) {
+        filter->hop_size = hop_size;
+        gst_spectrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -410,6 +445,9 @@ gst_spectrum_get_property (GObject * object, guint prop_id,
     case PROP_MULTI_CHANNEL:
       g_value_set_boolean (value, filter->multi_channel);
       break;
+    case PROP_HOP_SIZE:
+      g_value_set_uint (value, filter->hop_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -436,67 +474,50 @@ gst_spectrum_stop (GstBaseTransform * trans)
   return TRUE;
 }
 
-/* mixing data readers */
-
-static void
-input_data_mixed_float (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
-{
-  guint i, j, ip = 0;
-  gfloat v;
-  gfloat *in = (gfloat *) _in;
-
-  for (j = 0; j < len; j++) {
-    v = in[ip++];
-    for (i = 1; i < channels; i++)
-      v += in[ip++];
-    out[op] = v / channels;
-    op = (op + 1) % nfft;
-  }
-}
-
-static void
-input_data_mixed_double (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
-{
-  guint i, j, ip = 0;
-  gfloat v;
-  gdouble *in = (gdouble *) _in;
-
-  for (j = 0; j < len; j++) {
-    v = in[ip++];
-    for (i = 1; i < channels; i++)
-      v += in[ip++];
-    out[op] = v / channels;
-    op = (op + 1) % nfft;
-  }
+/* mixing data readers, they write len frames to out without wrapping around
+ * and are written so that the compiler can vectorize them for the common
+ * channel counts */
+
+#define DEFINE_INPUT_DATA_MIXED(name,TYPE,SCALE)                        \
+static void                                                             \
+input_data_mixed_##name (const guint8 * _in, gfloat * out, guint len,   \
+    guint channels, gfloat max_value)                                   \
+{                                                                       \
+  guint i, j, ip = 0;                                                   \
+  const TYPE *in = (const TYPE *) _in;                                  \
+  gfloat scale = (SCALE) / channels;                                    \
+                                                                        \
+  if (channels == 1) {                                                  \
+    for (j = 0; j < len; j++)                                           \
+      out[j] = in[j] * scale;                                           \
+  } else if (channels == 2) {                                           \
+    for (j = 0; j < len; j++)                                           \
+      out[j] = ((gfloat) in[2 * j] + (gfloat) in[2 * j + 1]) * scale;   \
+  } else {                                                              \
+    for (j = 0; j < len; j++) {                                         \
+      gfloat v = in[ip++];                                              \
+      for (i = 1; i < channels; i++)                                    \
+        v += in[ip++];                                                  \
+      out[j] = v * scale;                                               \
+    }                                                                   \
+  }                                                                     \
 }
 
-static void
-input_data_mixed_int32_max (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
-{
-  guint i, j, ip = 0;
-  gint32 *in = (gint32 *) _in;
-  gfloat v;
-
-  for (j = 0; j < len; j++) {
-    v = in[ip++] / max_value;
-    for (i = 1; i < channels; i++)
-      v += in[ip++] / max_value;
-    out[op] = v / channels;
-    op = (op + 1) % nfft;
-  }
-}
+DEFINE_INPUT_DATA_MIXED (float, gfloat, 1.0f);
+DEFINE_INPUT_DATA_MIXED (double, gdouble, 1.0f);
+DEFINE_INPUT_DATA_MIXED (int32_max, gint32, 1.0f / max_value);
+DEFINE_INPUT_DATA_MIXED (int16_max, gint16, 1.0f / max_value);
 
 static void
 input_data_mixed_int24_max (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
+    guint channels, gfloat max_value)
 {
   guint i, j;
-  gfloat v = 0.0;
+  gfloat scale = 1.0f / (max_value * channels);
 
   for (j = 0; j < len; j++) {
+    gfloat v = 0.0;
+
     for (i = 0; i < channels; i++) {
 #if G_BYTE_ORDER == G_BIG_ENDIAN
       gint32 value = GST_READ_UINT24_BE (_in);
@@ -505,77 +526,39 @@ input_data_mixed_int24_max (const guint8 * _in, gfloat * out, guint len,
 #endif
       if (value & 0x00800000)
         value |= 0xff000000;
-      v += value / max_value;
+      v += value;
       _in += 3;
     }
-    out[op] = v / channels;
-    op = (op + 1) % nfft;
-  }
-}
-
-static void
-input_data_mixed_int16_max (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
-{
-  guint i, j, ip = 0;
-  gint16 *in = (gint16 *) _in;
-  gfloat v;
-
-  for (j = 0; j < len; j++) {
-    v = in[ip++] / max_value;
-    for (i = 1; i < channels; i++)
-      v += in[ip++] / max_value;
-    out[op] = v / channels;
-    op = (op + 1) % nfft;
+    out[j] = v * scale;
   }
 }
 
 /* non mixing data readers */
 
-static void
-input_data_float (const guint8 * _in, gfloat * out, guint len, guint channels,
-    gfloat max_value, guint op, guint nfft)
-{
-  guint j, ip;
-  gfloat *in = (gfloat *) _in;
-
-  for (j = 0, ip = 0; j < len; j++, ip += channels) {
-    out[op] = in[ip];
-    op = (op + 1) % nfft;
-  }
-}
-
-static void
-input_data_double (const guint8 * _in, gfloat * out, guint len, guint channels,
-    gfloat max_value, guint op, guint nfft)
-{
-  guint j, ip;
-  gdouble *in = (gdouble *) _in;
-
-  for (j = 0, ip = 0; j < len; j++, ip += channels) {
-    out[op] = in[ip];
-    op = (op + 1) % nfft;
-  }
+#define DEFINE_INPUT_DATA(name,TYPE,SCALE)                              \
+static void                                                             \
+input_data_##name (const guint8 * _in, gfloat * out, guint len,         \
+    guint channels, gfloat max_value)                                   \
+{                                                                       \
+  guint j;                                                              \
+  const TYPE *in = (const TYPE *) _in;                                  \
+  gfloat scale = (SCALE);                                               \
+                                                                        \
+  for (j = 0; j < len; j++)                                             \
+    out[j] = in[j * channels] * scale;                                  \
 }
 
-static void
-input_data_int32_max (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
-{
-  guint j, ip;
-  gint32 *in = (gint32 *) _in;
-
-  for (j = 0, ip = 0; j < len; j++, ip += channels) {
-    out[op] = in[ip] / max_value;
-    op = (op + 1) % nfft;
-  }
-}
+DEFINE_INPUT_DATA (float, gfloat, 1.0f);
+DEFINE_INPUT_DATA (double, gdouble, 1.0f);
+DEFINE_INPUT_DATA (int32_max, gint32, 1.0f / max_value);
+DEFINE_INPUT_DATA (int16_max, gint16, 1.0f / max_value);
 
 static void
 input_data_int24_max (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
+    guint channels, gfloat max_value)
 {
   guint j;
+  gfloat scale = 1.0f / max_value;
 
   for (j = 0; j < len; j++) {
 #if G_BYTE_ORDER == G_BIG_ENDIAN
@@ -586,21 +569,7 @@ input_data_int24_max (const guint8 * _in, gfloat * out, guint len,
     if (v & 0x00800000)
       v |= 0xff000000;
     _in += 3 * channels;
-    out[op] = v / max_value;
-    op = (op + 1) % nfft;
-  }
-}
-
-static void
-input_data_int16_max (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
-{
-  guint j, ip;
-  gint16 *in = (gint16 *) _in;
-
-  for (j = 0, ip = 0; j < len; j++, ip += channels) {
-    out[op] = in[ip] / max_value;
-    op = (op + 1) % nfft;
+    out[j] = v * scale;
   }
 }
 
@@ -756,6 +725,37 @@ gst_spectrum_message_new (GstSpectrum * spectrum, GstClockTime timestamp,
   return gst_message_new_element (GST_OBJECT (spectrum), s);
 }
 
+/* log10 (x) for positive, normal x with an absolute error below 1e-5.
+ * The mantissa is reduced to [sqrt(1/2), sqrt(2)) and the series of
+ * ln (m) = 2 * atanh ((m - 1) / (m + 1)) converges quickly there. */
+static inline gfloat
+fast_log10 (gfloat x)
+{
+  union
+  {
+    gfloat f;
+    guint32 i;
+  } u;
+  gint e;
+  gfloat m, z, z2, ln_m;
+
+  u.f = x;
+  e = (gint) ((u.i >> 23) & 0xff) - 127;
+  u.i = (u.i & 0x007fffff) | 0x3f800000;
+  m = u.f;
+  if (m > G_SQRT2) {
+    m *= 0.5f;
+    e++;
+  }
+
+  z = (m - 1.0f) / (m + 1.0f);
+  z2 = z * z;
+  ln_m = 2.0f * z * (1.0f + z2 * (1.0f / 3.0f + z2 * (1.0f / 5.0f +
+              z2 * (1.0f / 7.0f))));
+
+  return (e * (gfloat) G_LN2 + ln_m) * (gfloat) (1.0 / G_LN10);
+}
+
 static void
 gst_spectrum_run_fft (GstSpectrum * spectrum, GstSpectrumChannel * cd,
     guint input_pos)
@@ -768,27 +768,35 @@ gst_spectrum_run_fft (GstSpectrum * spectrum, GstSpectrumChannel * cd,
   gfloat *input_tmp = cd->input_tmp;
   gfloat *spect_magnitude = cd->spect_magnitude;
   gfloat *spect_phase = cd->spect_phase;
+  gfloat *window = spectrum->window;
   GstFFTF32Complex *freqdata = cd->freqdata;
   GstFFTF32 *fft_ctx = cd->fft_ctx;
+  guint wrap = nfft - input_pos;
 
-  for (i = 0; i < nfft; i++)
-    input_tmp[i] = input[(input_pos + i) % nfft];
-
-  gst_fft_f32_window (fft_ctx, input_tmp, GST_FFT_WINDOW_HAMMING);
+  /* unroll the ringbuffer and apply the window in one go */
+  for (i = 0; i < wrap; i++)
+    input_tmp[i] = input[input_pos + i] * window[i];
+  for (i = wrap; i < nfft; i++)
+    input_tmp[i] = input[i - wrap] * window[i];
 
   gst_fft_f32_fft (fft_ctx, input_tmp, freqdata);
 
   if (spectrum->message_magnitude) {
-    gdouble val;
+    /* the input is not needed anymore and has room for all bands */
+    gfloat *power = input_tmp;
+    /* everything below the threshold is clipped without taking the log */
+    gfloat min_power = pow (10.0, threshold / 10.0) * nfft * nfft;
+    gfloat offset = 20.0 * log10 (nfft);
+
+    for (i = 0; i < bands; i++)
+      power[i] = freqdata[i].r * freqdata[i].r + freqdata[i].i * freqdata[i].i;
+
     /* Calculate magnitude in db */
     for (i = 0; i < bands; i++) {
-      val = freqdata[i].r * freqdata[i].r;
-      val += freqdata[i].i * freqdata[i].i;
-      val /= nfft * nfft;
-      val = 10.0 * log10 (val);
-      if (val < threshold)
-        val = threshold;
-      spect_magnitude[i] += val;
+      if (power[i] > min_power)
+        spect_magnitude[i] += 10.0f * fast_log10 (power[i]) - offset;
+      else
+        spect_magnitude[i] += threshold;
     }
   }
 
@@ -846,7 +854,9 @@ gst_spectrum_transform_ip (GstBaseTransform * trans, GstBuffer * buffer)
   gfloat max_value = (1UL << ((bps << 3) - 1)) - 1;
   guint bands = spectrum->bands;
   guint nfft = 2 * bands - 2;
-  guint input_pos;
+  guint hop = (spectrum->hop_size && spectrum->hop_size < nfft) ?
+      spectrum->hop_size : nfft;
+  guint input_pos, wrap;
   gfloat *input;
   GstMapInfo map;
   const guint8 *data;
@@ -905,7 +915,7 @@ gst_spectrum_transform_ip (GstBaseTransform * trans, GstBuffer * buffer)
 
   while (size >= bpf) {
     /* run input_data for a chunk of data */
-    fft_todo = nfft - (spectrum->num_frames % nfft);
+    fft_todo = hop - (spectrum->num_frames % hop);
     msg_todo = spectrum->frames_todo - spectrum->num_frames;
     GST_LOG_OBJECT (spectrum,
         "message frames todo: %u, fft frames todo: %u, input frames %"
@@ -916,12 +926,16 @@ gst_spectrum_transform_ip (GstBaseTransform * trans, GstBuffer * buffer)
     if (block_size > fft_todo)
       block_size = fft_todo;
 
+    wrap = MIN (block_size, nfft - input_pos);
     for (c = 0; c < output_channels; c++) {
       cd = &spectrum->channel_data[c];
       input = cd->input;
       /* Move the current frames into our ringbuffers */
-      input_data (data + c * bps, input, block_size, channels, max_value,
-          input_pos, nfft);
+      input_data (data + c * bps, input + input_pos, wrap, channels,
+          max_value);
+      if (wrap < block_size)
+        input_data (data + c * bps + wrap * bpf, input, block_size - wrap,
+            channels, max_value);
     }
     data += block_size * bpf;
     size -= block_size * bpf;
@@ -932,11 +946,11 @@ gst_spectrum_transform_ip (GstBaseTransform * trans, GstBuffer * buffer)
 
     GST_LOG_OBJECT (spectrum,
         "size: %" G_GSIZE_FORMAT ", do-fft = %d, do-message = %d", size,
-        (spectrum->num_frames % nfft == 0), have_full_interval);
+        (spectrum->num_frames % hop == 0), have_full_interval);
 
-    /* If we have enough frames for an FFT or we have all frames required for
-     * the interval and we haven't run a FFT, then run an FFT */
-    if ((spectrum->num_frames % nfft == 0) ||
+    /* If we have enough new frames for an FFT or we have all frames required
+     * for the interval and we haven't run a FFT, then run an FFT */
+    if ((spectrum->num_frames % hop == 0) ||
         (have_full_interval && !spectrum->num_fft)) {
       for (c = 0; c < output_channels; c++) {
         cd = &spectrum->channel_data[c];
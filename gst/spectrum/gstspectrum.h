@@ -38,7 +38,7 @@ typedef struct _GstSpectrumClass GstSpectrumClass;
 typedef struct _GstSpectrumChannel GstSpectrumChannel;
 
 typedef void (*GstSpectrumInputData)(const guint8 * in, gfloat * out,
-    guint len, guint channels, gfloat max_value, guint op, guint nfft);
+    guint len, guint channels, gfloat max_value);
 
 struct _GstSpectrumChannel
 {
@@ -64,6 +64,7 @@ struct _GstSpectrum
   guint bands;                  /* number of spectrum bands */
   gint threshold;               /* energy level treshold */
   gboolean multi_channel;       /* send separate channel results */
+  guint hop_size;               /* frames between FFTs, 0 = nfft */
 
   guint64 num_frames;           /* frame count (1 sample per channel)
                                  * since last emit */
@@ -73,6 +74,7 @@ struct _GstSpectrum
   /* <private> */
   GstSpectrumChannel *channel_data;
   guint num_channels;
+  gfloat *window;               /* hamming window for nfft frames */
 
   guint input_pos;
   guint64 error_per_interval;
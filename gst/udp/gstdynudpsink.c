@@ -28,10 +28,25 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
+
+#ifdef HAVE_SENDMMSG
+/* for sendmmsg() and struct mmsghdr */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
+
 #include "gstdynudpsink.h"
 
 #include <gst/net/gstnetaddressmeta.h>
 
+#ifdef HAVE_SENDMMSG
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <errno.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (dynudpsink_debug);
 #define GST_CAT_DEFAULT (dynudpsink_debug)
 
@@ -71,6 +86,13 @@ static void gst_dynudpsink_finalize (GObject * object);
 
 static GstFlowReturn gst_dynudpsink_render (GstBaseSink * sink,
     GstBuffer * buffer);
+#ifdef HAVE_SENDMMSG
+static GstFlowReturn gst_dynudpsink_render_list (GstBaseSink * bsink,
+    GstBufferList * list);
+static GstDynUDPSinkBatch *gst_dynudpsink_batch_new (void);
+static void gst_dynudpsink_batch_free (GstDynUDPSinkBatch * batch);
+static void gst_dynudpsink_batch_clear_dests (GstDynUDPSinkBatch * batch);
+#endif
 static gboolean gst_dynudpsink_stop (GstBaseSink * bsink);
 static gboolean gst_dynudpsink_start (GstBaseSink * bsink);
 static gboolean gst_dynudpsink_unlock (GstBaseSink * bsink);
@@ -143,6 +165,9 @@ gst_dynudpsink_class_init (GstDynUDPSinkClass * klass)
       "Philippe Khalaf <burger@speedy.org>");
 
   gstbasesink_class->render = gst_dynudpsink_render;
+#ifdef HAVE_SENDMMSG
+  gstbasesink_class->render_list = gst_dynudpsink_render_list;
+#endif
   gstbasesink_class->start = gst_dynudpsink_start;
   gstbasesink_class->stop = gst_dynudpsink_stop;
   gstbasesink_class->unlock = gst_dynudpsink_unlock;
@@ -166,6 +191,10 @@ gst_dynudpsink_init (GstDynUDPSink * sink)
   sink->used_socket = NULL;
   sink->used_socket_v6 = NULL;
   sink->cancellable = g_cancellable_new ();
+
+#ifdef HAVE_SENDMMSG
+  sink->batch = gst_dynudpsink_batch_new ();
+#endif
 }
 
 static void
@@ -198,9 +227,320 @@ gst_dynudpsink_finalize (GObject * object)
   g_free (sink->bind_address);
   sink->bind_address = NULL;
 
+#ifdef HAVE_SENDMMSG
+  gst_dynudpsink_batch_free (sink->batch);
+  sink->batch = NULL;
+#endif
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+#ifdef HAVE_SENDMMSG
+#define DEST_CACHE_SIZE 16
+
+/* a destination with its address already converted for sendmmsg() */
+typedef struct
+{
+  GSocketAddress *addr;
+  GSocket *socket;
+  struct sockaddr_storage native;
+  socklen_t native_len;
+} GstDynUDPSinkDest;
+
+struct _GstDynUDPSinkBatch
+{
+  /* recently used destinations, replaced round-robin */
+  GstDynUDPSinkDest dests[DEST_CACHE_SIZE];
+  guint n_dests;
+  guint next_dest;
+  guint last_dest;
+
+  /* mapped memory of all buffers of one render call */
+  GstMapInfo *maps;
+  struct iovec *iov;
+  guint n_maps;
+  guint iov_alloc;
+
+  /* one message per buffer and the socket to send it from */
+  struct mmsghdr *msgs;
+  GSocket **msg_sockets;
+  guint msgs_alloc;
+};
+
+static GstDynUDPSinkBatch *
+gst_dynudpsink_batch_new (void)
+{
+  return g_slice_new0 (GstDynUDPSinkBatch);
+}
+
+static void
+gst_dynudpsink_batch_clear_dests (GstDynUDPSinkBatch * batch)
+{
+  guint i;
+
+  for (i = 0; i < batch->n_dests; i++)
+    g_object_unref (batch->dests[i].addr);
+  batch->n_dests = 0;
+  batch->next_dest = 0;
+  batch->last_dest = 0;
+}
+
+static void
+gst_dynudpsink_batch_free (GstDynUDPSinkBatch * batch)
+{
+  gst_dynudpsink_batch_clear_dests (batch);
+  g_free (batch->maps);
+  g_free (batch->iov);
+  g_free (batch->msgs);
+  g_free (batch->msg_sockets);
+  g_slice_free (GstDynUDPSinkBatch, batch);
+}
+
+/* Returns the cached destination for @addr, adding it if needed, or NULL if
+ * we can't send to it */
+static GstDynUDPSinkDest *
+gst_dynudpsink_lookup_dest (GstDynUDPSink * sink, GSocketAddress * addr)
+{
+  GstDynUDPSinkBatch *batch = sink->batch;
+  GstDynUDPSinkDest *dest;
+  struct sockaddr_storage native;
+  GSocketFamily family;
+  gssize len;
+  guint i;
+
+  /* consecutive packets mostly go to the same destination, often with the
+   * same address object. The cache holds a ref so the pointer can't be
+   * reused for another address. */
+  if (batch->n_dests > 0 && batch->dests[batch->last_dest].addr == addr)
+    return &batch->dests[batch->last_dest];
+
+  for (i = 0; i < batch->n_dests; i++) {
+    if (batch->dests[i].addr == addr) {
+      batch->last_dest = i;
+      return &batch->dests[i];
+    }
+  }
+
+  len = g_socket_address_get_native_size (addr);
+  if (len <= 0 || (gsize) len > sizeof (native)
+      || !g_socket_address_to_native (addr, &native, len, NULL))
+    goto invalid_address;
+
+  /* a new object for a destination we already know */
+  for (i = 0; i < batch->n_dests; i++) {
+    dest = &batch->dests[i];
+
+    if (dest->native_len == (socklen_t) len && memcmp (&dest->native, &native, len) == 0) {
+      g_object_unref (dest->addr);
+      dest->addr = g_object_ref (addr);
+      batch->last_dest = i;
+      return dest;
+    }
+  }
+
+  family = g_socket_address_get_family (addr);
+  if (family == G_SOCKET_FAMILY_IPV6 && !sink->used_socket_v6)
+    goto invalid_family;
+
+  if (batch->n_dests < DEST_CACHE_SIZE) {
+    i = batch->n_dests++;
+  } else {
+    i = batch->next_dest;
+    batch->next_dest = (i + 1) % DEST_CACHE_SIZE;
+    g_object_unref (batch->dests[i].addr);
+  }
+
+  dest = &batch->dests[i];
+  dest->addr = g_object_ref (addr);
+  memcpy (&dest->native, &native, len);
+  dest->native_len = len;
+
+  /* Select socket to send from for this address */
+  if (family == G_SOCKET_FAMILY_IPV6 || !sink->used_socket)
+    dest->socket = sink->used_socket_v6;
+  else
+    dest->socket = sink->used_socket;
+
+  batch->last_dest = i;
+
+  return dest;
+
+invalid_address:
+  {
+    GST_DEBUG ("could not convert destination address");
+    return NULL;
+  }
+invalid_family:
+  {
+    GST_DEBUG ("invalid address family (got %d)", family);
+    return NULL;
+  }
+}
+
+static void
+gst_dynudpsink_batch_unmap (GstDynUDPSinkBatch * batch)
+{
+  guint i;
+
+  for (i = 0; i < batch->n_maps; i++)
+    gst_memory_unmap (batch->maps[i].memory, &batch->maps[i]);
+  batch->n_maps = 0;
+}
+
+/* send msgs [first, first + n_msgs) on @socket */
+static GstFlowReturn
+gst_dynudpsink_batch_send (GstDynUDPSink * sink, GSocket * socket,
+    guint first, guint n_msgs)
+{
+  GstDynUDPSinkBatch *batch = sink->batch;
+  guint i, end;
+  gint fd, ret;
+
+  fd = g_socket_get_fd (socket);
+  end = first + n_msgs;
+  i = first;
+
+  while (i < end) {
+    if (g_cancellable_is_cancelled (sink->cancellable))
+      goto flushing;
+
+    ret = sendmmsg (fd, &batch->msgs[i], end - i, 0);
+
+    if (G_UNLIKELY (ret < 0)) {
+      GError *err = NULL;
+
+      if (errno == EINTR)
+        continue;
+
+      /* GSocket puts the fd in non-blocking mode, wait until the kernel
+       * buffer has room again */
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        if (g_socket_condition_wait (socket, G_IO_OUT, sink->cancellable,
+                &err))
+          continue;
+
+        if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+          g_clear_error (&err);
+          goto flushing;
+        }
+        GST_DEBUG ("got send error %s", err->message);
+        g_clear_error (&err);
+      } else {
+        GST_DEBUG ("got send error %s", g_strerror (errno));
+      }
+      return GST_FLOW_ERROR;
+    }
+
+    GST_LOG ("sent %d messages", ret);
+    i += ret;
+  }
+
+  return GST_FLOW_OK;
+
+flushing:
+  {
+    GST_DEBUG ("we are flushing");
+    return GST_FLOW_FLUSHING;
+  }
+}
+
+/* send @buffer, or all buffers of @list, with one sendmmsg() call for each
+ * run of packets that go out on the same socket */
+static GstFlowReturn
+gst_dynudpsink_render_batch (GstDynUDPSink * sink, GstBuffer * buffer,
+    GstBufferList * list)
+{
+  GstDynUDPSinkBatch *batch = sink->batch;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint n_buffers, n_msgs, n_iov, i, j, first;
+
+  n_buffers = list ? gst_buffer_list_length (list) : 1;
+
+  n_iov = 0;
+  for (i = 0; i < n_buffers; i++) {
+    GstBuffer *buf = list ? gst_buffer_list_get (list, i) : buffer;
+
+    n_iov += gst_buffer_n_memory (buf);
+  }
+
+  if (n_iov > batch->iov_alloc) {
+    batch->iov_alloc = MAX (n_iov, batch->iov_alloc * 2);
+    batch->iov = g_renew (struct iovec, batch->iov, batch->iov_alloc);
+    batch->maps = g_renew (GstMapInfo, batch->maps, batch->iov_alloc);
+  }
+  if (n_buffers > batch->msgs_alloc) {
+    batch->msgs_alloc = MAX (n_buffers, batch->msgs_alloc * 2);
+    batch->msgs = g_renew (struct mmsghdr, batch->msgs, batch->msgs_alloc);
+    batch->msg_sockets =
+        g_renew (GSocket *, batch->msg_sockets, batch->msgs_alloc);
+  }
+
+  n_msgs = 0;
+  for (i = 0; i < n_buffers; i++) {
+    GstBuffer *buf = list ? gst_buffer_list_get (list, i) : buffer;
+    GstNetAddressMeta *meta;
+    GstDynUDPSinkDest *dest;
+    struct mmsghdr *msg;
+    guint n_mem;
+
+    meta = gst_buffer_get_net_address_meta (buf);
+    if (meta == NULL) {
+      GST_DEBUG ("Received buffer without GstNetAddressMeta, skipping");
+      continue;
+    }
+
+    dest = gst_dynudpsink_lookup_dest (sink, meta->addr);
+    if (dest == NULL) {
+      ret = GST_FLOW_ERROR;
+      goto done;
+    }
+
+    msg = &batch->msgs[n_msgs];
+    memset (msg, 0, sizeof (struct mmsghdr));
+    msg->msg_hdr.msg_name = &dest->native;
+    msg->msg_hdr.msg_namelen = dest->native_len;
+    msg->msg_hdr.msg_iov = &batch->iov[batch->n_maps];
+
+    n_mem = gst_buffer_n_memory (buf);
+    for (j = 0; j < n_mem; j++) {
+      GstMapInfo *map = &batch->maps[batch->n_maps];
+
+      gst_memory_map (gst_buffer_peek_memory (buf, j), map, GST_MAP_READ);
+      batch->iov[batch->n_maps].iov_base = map->data;
+      batch->iov[batch->n_maps].iov_len = map->size;
+      batch->n_maps++;
+    }
+    msg->msg_hdr.msg_iovlen = n_mem;
+
+    batch->msg_sockets[n_msgs] = dest->socket;
+    n_msgs++;
+  }
+
+  GST_LOG ("about to send %u packets", n_msgs);
+
+  /* keep the order of the packets, only group runs for the same socket */
+  first = 0;
+  for (i = 1; i <= n_msgs && ret == GST_FLOW_OK; i++) {
+    if (i == n_msgs || batch->msg_sockets[i] != batch->msg_sockets[first]) {
+      ret = gst_dynudpsink_batch_send (sink, batch->msg_sockets[first],
+          first, i - first);
+      first = i;
+    }
+  }
+
+done:
+  gst_dynudpsink_batch_unmap (batch);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_dynudpsink_render_list (GstBaseSink * bsink, GstBufferList * list)
+{
+  return gst_dynudpsink_render_batch (GST_DYNUDPSINK (bsink), NULL, list);
+}
+#endif
+
 static GstFlowReturn
 gst_dynudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
 {
@@ -213,6 +553,10 @@ gst_dynudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
   GSocketFamily family;
   GSocket *socket;
 
+#ifdef HAVE_SENDMMSG
+  return gst_dynudpsink_render_batch (GST_DYNUDPSINK (bsink), buffer, NULL);
+#endif
+
   meta = gst_buffer_get_net_address_meta (buffer);
 
   if (meta == NULL) {
@@ -546,6 +890,11 @@ gst_dynudpsink_stop (GstBaseSink * bsink)
     udpsink->used_socket_v6 = NULL;
   }
 
+#ifdef HAVE_SENDMMSG
+  /* the cached entries point to the sockets */
+  gst_dynudpsink_batch_clear_dests (udpsink->batch);
+#endif
+
   return TRUE;
 }
 
@@ -36,6 +36,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstDynUDPSink GstDynUDPSink;
 typedef struct _GstDynUDPSinkClass GstDynUDPSinkClass;
+typedef struct _GstDynUDPSinkBatch GstDynUDPSinkBatch;
 
 
 /* sends udp packets to host/port pairs contained in the GstNetBuffer received.
@@ -53,6 +54,9 @@ struct _GstDynUDPSink {
   GSocket *used_socket, *used_socket_v6;
   gboolean external_socket;
   GCancellable *cancellable;
+
+  /* destination cache and scratch space for sendmmsg(), if available */
+  GstDynUDPSinkBatch *batch;
 };
 
 struct _GstDynUDPSinkClass {
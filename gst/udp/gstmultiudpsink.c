@@ -36,6 +36,14 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
+
+#ifdef HAVE_SENDMMSG
+/* for sendmmsg() and struct mmsghdr */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
+
 #include "gstmultiudpsink.h"
 
 #include <string.h>
@@ -43,6 +51,31 @@
 #include <sys/socket.h>
 #endif
 
+#ifdef HAVE_SENDMMSG
+#include <sys/uio.h>
+#include <errno.h>
+#endif
+
+#if defined (HAVE_SENDMMSG) && defined (__linux__)
+#define HAVE_UDP_GSO 1
+#include <netinet/udp.h>
+
+/* older C libraries don't know about the socket option yet */
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+/* limits of the kernel for a single segmented send */
+#define UDP_GSO_MAX_SEGMENTS 64
+#define UDP_GSO_MAX_IOV 1024
+
+/* control message space per message for the segment size */
+#define UDP_GSO_CONTROL_SIZE (CMSG_SPACE (sizeof (guint16)))
+#endif
+
 #ifndef G_OS_WIN32
 #include <netinet/in.h>
 #endif
@@ -94,6 +127,7 @@ enum
 #define DEFAULT_BUFFER_SIZE        0
 #define DEFAULT_BIND_ADDRESS       NULL
 #define DEFAULT_BIND_PORT          0
+#define DEFAULT_GSO                FALSE
 
 enum
 {
@@ -117,6 +151,7 @@ enum
   PROP_BUFFER_SIZE,
   PROP_BIND_ADDRESS,
   PROP_BIND_PORT,
+  PROP_GSO,
   PROP_LAST
 };
 
@@ -124,6 +159,12 @@ static void gst_multiudpsink_finalize (GObject * object);
 
 static GstFlowReturn gst_multiudpsink_render (GstBaseSink * sink,
     GstBuffer * buffer);
+#ifdef HAVE_SENDMMSG
+static GstFlowReturn gst_multiudpsink_render_list (GstBaseSink * bsink,
+    GstBufferList * list);
+static GstMultiUDPSinkBatch *gst_multiudpsink_batch_new (void);
+static void gst_multiudpsink_batch_free (GstMultiUDPSinkBatch * batch);
+#endif
 
 static gboolean gst_multiudpsink_start (GstBaseSink * bsink);
 static gboolean gst_multiudpsink_stop (GstBaseSink * bsink);
@@ -350,6 +391,27 @@ gst_multiudpsink_class_init (GstMultiUDPSinkClass * klass)
       g_param_spec_int ("bind-port", "Bind Port",
           "Port to bind the socket to", 0, G_MAXUINT16,
           DEFAULT_BIND_PORT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstMultiUDPSink:gso:
+   *
+   * Use UDP generic segmentation offload. Consecutive packets of the same
+   * size in a buffer list, of which only the last one may be shorter, are
+   * then handed to the kernel as one large message per client, and the
+   * kernel or the network card splits it into the original packets again.
+   * This saves a lot of per-packet overhead when sending high bitrate
+   * streams to many clients.
+   *
+   * Falls back to sending the packets one by one with sendmmsg() on kernels
+   * without UDP GSO support (before Linux 4.18) and has no effect on other
+   * systems.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_GSO,
+      g_param_spec_boolean ("gso", "GSO",
+          "Send runs of equal sized packets as one message and let the "
+          "kernel split them", DEFAULT_GSO,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&sink_template));
@@ -360,6 +422,9 @@ gst_multiudpsink_class_init (GstMultiUDPSinkClass * klass)
       "Wim Taymans <wim.taymans@gmail.com>");
 
   gstbasesink_class->render = gst_multiudpsink_render;
+#ifdef HAVE_SENDMMSG
+  gstbasesink_class->render_list = gst_multiudpsink_render_list;
+#endif
   gstbasesink_class->start = gst_multiudpsink_start;
   gstbasesink_class->stop = gst_multiudpsink_stop;
   gstbasesink_class->unlock = gst_multiudpsink_unlock;
@@ -379,6 +444,7 @@ gst_multiudpsink_init (GstMultiUDPSink * sink)
   guint max_mem;
 
   g_mutex_init (&sink->client_lock);
+  gst_multiudpsink_update_clients_snapshot (sink);
   sink->socket = DEFAULT_SOCKET;
   sink->socket_v6 = DEFAULT_SOCKET;
   sink->used_socket = DEFAULT_USED_SOCKET;
@@ -393,6 +459,7 @@ gst_multiudpsink_init (GstMultiUDPSink * sink)
   sink->qos_dscp = DEFAULT_QOS_DSCP;
   sink->send_duplicates = DEFAULT_SEND_DUPLICATES;
   sink->multi_iface = g_strdup (DEFAULT_MULTICAST_IFACE);
+  sink->gso = DEFAULT_GSO;
 
   sink->cancellable = g_cancellable_new ();
 
@@ -403,8 +470,24 @@ gst_multiudpsink_init (GstMultiUDPSink * sink)
 
   sink->vec = g_new (GOutputVector, max_mem);
   sink->map = g_new (GstMapInfo, max_mem);
+
+#ifdef HAVE_SENDMMSG
+  sink->batch = gst_multiudpsink_batch_new ();
+#endif
 }
 
+/* immutable list of clients, used by the streaming thread so that clients
+ * can be added and removed without blocking it */
+struct _GstMultiUDPSinkClients
+{
+  gint refcount;
+
+  guint n_clients;
+  GstUDPClient **clients;
+  /* refcount of each client at the time the snapshot was made */
+  gint *counts;
+};
+
 static GstUDPClient *
 create_client (GstMultiUDPSink * sink, const gchar * host, gint port)
 {
@@ -438,11 +521,20 @@ create_client (GstMultiUDPSink * sink, const gchar * host, gint port)
 
   client = g_slice_new0 (GstUDPClient);
   client->refcount = 1;
+  client->users = 1;
   client->host = g_strdup (host);
   client->port = port;
   client->addr = g_inet_socket_address_new (addr, port);
   g_object_unref (addr);
 
+  client->native_addr_len = g_socket_address_get_native_size (client->addr);
+  client->native_addr = g_malloc0 (client->native_addr_len);
+  if (!g_socket_address_to_native (client->addr, client->native_addr,
+          client->native_addr_len, &err)) {
+    GST_WARNING_OBJECT (sink, "could not convert address: %s", err->message);
+    g_clear_error (&err);
+  }
+
   return client;
 
 name_resolve:
@@ -456,11 +548,79 @@ name_resolve:
 static void
 free_client (GstUDPClient * client)
 {
+  if (!g_atomic_int_dec_and_test (&client->users))
+    return;
+
   g_object_unref (client->addr);
+  g_free (client->native_addr);
   g_free (client->host);
   g_slice_free (GstUDPClient, client);
 }
 
+static void
+clients_snapshot_unref (GstMultiUDPSinkClients * snapshot)
+{
+  guint i;
+
+  if (!g_atomic_int_dec_and_test (&snapshot->refcount))
+    return;
+
+  for (i = 0; i < snapshot->n_clients; i++)
+    free_client (snapshot->clients[i]);
+  g_free (snapshot->clients);
+  g_free (snapshot->counts);
+  g_slice_free (GstMultiUDPSinkClients, snapshot);
+}
+
+/* get the current clients for sending, the object lock is only held for
+ * taking a reference */
+static GstMultiUDPSinkClients *
+gst_multiudpsink_get_clients_snapshot (GstMultiUDPSink * sink)
+{
+  GstMultiUDPSinkClients *snapshot;
+
+  GST_OBJECT_LOCK (sink);
+  snapshot = sink->clients_snapshot;
+  g_atomic_int_inc (&snapshot->refcount);
+  GST_OBJECT_UNLOCK (sink);
+
+  return snapshot;
+}
+
+/* replace the snapshot with a copy of the current client list. Must be called
+ * with the client lock after every change to the list or to the refcount of
+ * one of its clients. */
+static void
+gst_multiudpsink_update_clients_snapshot (GstMultiUDPSink * sink)
+{
+  GstMultiUDPSinkClients *snapshot, *old;
+  GList *clients;
+  guint i;
+
+  snapshot = g_slice_new0 (GstMultiUDPSinkClients);
+  snapshot->refcount = 1;
+  snapshot->n_clients = g_list_length (sink->clients);
+  snapshot->clients = g_new (GstUDPClient *, snapshot->n_clients);
+  snapshot->counts = g_new (gint, snapshot->n_clients);
+
+  for (clients = sink->clients, i = 0; clients;
+      clients = g_list_next (clients), i++) {
+    GstUDPClient *client = (GstUDPClient *) clients->data;
+
+    g_atomic_int_inc (&client->users);
+    snapshot->clients[i] = client;
+    snapshot->counts[i] = client->refcount;
+  }
+
+  GST_OBJECT_LOCK (sink);
+  old = sink->clients_snapshot;
+  sink->clients_snapshot = snapshot;
+  GST_OBJECT_UNLOCK (sink);
+
+  if (old)
+    clients_snapshot_unref (old);
+}
+
 static gint
 client_compare (GstUDPClient * a, GstUDPClient * b)
 {
@@ -480,6 +640,9 @@ gst_multiudpsink_finalize (GObject * object)
   g_list_foreach (sink->clients, (GFunc) free_client, NULL);
   g_list_free (sink->clients);
 
+  clients_snapshot_unref (sink->clients_snapshot);
+  sink->clients_snapshot = NULL;
+
   if (sink->socket)
     g_object_unref (sink->socket);
   sink->socket = NULL;
@@ -508,6 +671,11 @@ gst_multiudpsink_finalize (GObject * object)
   g_free (sink->map);
   sink->map = NULL;
 
+#ifdef HAVE_SENDMMSG
+  gst_multiudpsink_batch_free (sink->batch);
+  sink->batch = NULL;
+#endif
+
   g_free (sink->bind_address);
   sink->bind_address = NULL;
 
@@ -516,14 +684,517 @@ gst_multiudpsink_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_multiudpsink_post_send_warning (GstMultiUDPSink * sink, gsize size,
+    const gchar * reason)
+{
+  if (reason == NULL)
+    reason = "unknown reason";
+
+  if (size > UDP_MAX_SIZE) {
+    GST_ELEMENT_WARNING (sink, RESOURCE, WRITE,
+        ("Attempting to send a UDP packet larger than maximum size "
+            "(%" G_GSIZE_FORMAT " > %d)", size, UDP_MAX_SIZE),
+        ("Reason: %s", reason));
+  } else {
+    GST_ELEMENT_WARNING (sink, RESOURCE, WRITE,
+        ("Error sending UDP packet"), ("Reason: %s", reason));
+  }
+}
+
+#ifdef HAVE_SENDMMSG
+/* a buffer to send, as a slice of the batch iovec array */
+typedef struct
+{
+  guint iov_offset;
+  guint n_iov;
+  gsize size;
+} GstMultiUDPSinkPacket;
+
+/* consecutive packets sent as one message, with GSO all of segsize bytes
+ * except for the last one */
+typedef struct
+{
+  guint packet;
+  guint n_packets;
+  guint iov_offset;
+  guint n_iov;
+  gsize size;
+  guint16 segsize;
+} GstMultiUDPSinkRun;
+
+struct _GstMultiUDPSinkBatch
+{
+  /* mapped memory of all buffers of one render call */
+  GstMapInfo *maps;
+  struct iovec *iov;
+  guint iov_alloc;
+
+  GstMultiUDPSinkPacket *packets;
+  guint packets_alloc;
+
+  /* a single packet each, unless gso is set */
+  GstMultiUDPSinkRun *runs;
+  guint runs_alloc;
+  /* UDP_SEGMENT control message of each run */
+  guint8 *control;
+
+  /* one message per run per client, and for each message the client and
+   * packets it belongs to so we can update the stats afterwards */
+  struct mmsghdr *msgs;
+  GstUDPClient **msg_clients;
+  guint *msg_packets;
+  guint *msg_n_packets;
+  guint msgs_alloc;
+
+  /* the sockets support UDP_SEGMENT */
+  gboolean gso;
+};
+
+static GstMultiUDPSinkBatch *
+gst_multiudpsink_batch_new (void)
+{
+  return g_slice_new0 (GstMultiUDPSinkBatch);
+}
+
+static void
+gst_multiudpsink_batch_free (GstMultiUDPSinkBatch * batch)
+{
+  g_free (batch->maps);
+  g_free (batch->iov);
+  g_free (batch->packets);
+  g_free (batch->runs);
+  g_free (batch->control);
+  g_free (batch->msgs);
+  g_free (batch->msg_clients);
+  g_free (batch->msg_packets);
+  g_free (batch->msg_n_packets);
+  g_slice_free (GstMultiUDPSinkBatch, batch);
+}
+
+static void
+gst_multiudpsink_batch_ensure_msgs (GstMultiUDPSinkBatch * batch, guint n)
+{
+  if (G_LIKELY (n <= batch->msgs_alloc))
+    return;
+
+  batch->msgs_alloc = MAX (n, batch->msgs_alloc * 2);
+  batch->msgs = g_renew (struct mmsghdr, batch->msgs, batch->msgs_alloc);
+  batch->msg_clients =
+      g_renew (GstUDPClient *, batch->msg_clients, batch->msgs_alloc);
+  batch->msg_packets = g_renew (guint, batch->msg_packets, batch->msgs_alloc);
+  batch->msg_n_packets =
+      g_renew (guint, batch->msg_n_packets, batch->msgs_alloc);
+}
+
+/* check if the sockets support UDP_SEGMENT, called from start */
+static void
+gst_multiudpsink_setup_gso (GstMultiUDPSink * sink)
+{
+  GstMultiUDPSinkBatch *batch = sink->batch;
+
+  batch->gso = FALSE;
+
+  if (!sink->gso)
+    return;
+
+#ifdef HAVE_UDP_GSO
+  {
+    GSocket *sockets[2] = { sink->used_socket, sink->used_socket_v6 };
+    guint i;
+
+    batch->gso = TRUE;
+    for (i = 0; i < 2; i++) {
+      gint val;
+      socklen_t len = sizeof (val);
+
+      if (sockets[i] == NULL)
+        continue;
+
+      if (getsockopt (g_socket_get_fd (sockets[i]), SOL_UDP, UDP_SEGMENT,
+              (void *) &val, &len) != 0) {
+        GST_WARNING_OBJECT (sink, "UDP GSO not supported: %s",
+            g_strerror (errno));
+        batch->gso = FALSE;
+      }
+    }
+  }
+#else
+  GST_WARNING_OBJECT (sink, "UDP GSO is not supported on this platform");
+#endif
+
+  GST_DEBUG_OBJECT (sink, "GSO %s", batch->gso ? "enabled" : "disabled");
+}
+
+/* group the mapped packets into the runs that are sent as one message */
+static guint
+gst_multiudpsink_batch_make_runs (GstMultiUDPSinkBatch * batch,
+    guint n_packets)
+{
+  GstMultiUDPSinkRun *run = NULL;
+  guint i, n_runs = 0;
+
+  if (n_packets > batch->runs_alloc) {
+    batch->runs_alloc = MAX (n_packets, batch->runs_alloc * 2);
+    batch->runs = g_renew (GstMultiUDPSinkRun, batch->runs, batch->runs_alloc);
+#ifdef HAVE_UDP_GSO
+    g_free (batch->control);
+    batch->control = g_malloc0 (batch->runs_alloc * UDP_GSO_CONTROL_SIZE);
+#endif
+  }
+
+  for (i = 0; i < n_packets; i++) {
+    GstMultiUDPSinkPacket *packet = &batch->packets[i];
+
+    if (packet->n_iov == 0) {
+      run = NULL;
+      continue;
+    }
+#ifdef HAVE_UDP_GSO
+    /* extend the current run as long as all its packets are of the same
+     * size, the packet added last can be shorter */
+    if (batch->gso && run != NULL && run->n_packets < UDP_GSO_MAX_SEGMENTS
+        && run->size == run->n_packets * run->segsize
+        && packet->size <= run->segsize
+        && run->size + packet->size <= UDP_MAX_SIZE
+        && run->n_iov + packet->n_iov <= UDP_GSO_MAX_IOV) {
+      run->n_packets++;
+      run->n_iov += packet->n_iov;
+      run->size += packet->size;
+      continue;
+    }
+#endif
+
+    run = &batch->runs[n_runs++];
+    run->packet = i;
+    run->n_packets = 1;
+    run->iov_offset = packet->iov_offset;
+    run->n_iov = packet->n_iov;
+    run->size = packet->size;
+    run->segsize = MIN (packet->size, G_MAXUINT16);
+  }
+
+#ifdef HAVE_UDP_GSO
+  for (i = 0; i < n_runs; i++) {
+    struct cmsghdr *cmsg;
+
+    if (batch->runs[i].n_packets == 1)
+      continue;
+
+    cmsg = (struct cmsghdr *) (batch->control + i * UDP_GSO_CONTROL_SIZE);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN (sizeof (guint16));
+    memcpy (CMSG_DATA (cmsg), &batch->runs[i].segsize, sizeof (guint16));
+  }
+#endif
+
+  return n_runs;
+}
+
+#ifdef HAVE_UDP_GSO
+/* the kernel refused a segmented message after all. Replace the messages
+ * in [first, *end) by one message per packet, from the back so that no
+ * message is overwritten before it was moved. */
+static void
+gst_multiudpsink_batch_unsegment (GstMultiUDPSinkBatch * batch, guint first,
+    guint * end)
+{
+  guint i, j, n_new = 0, dst;
+
+  for (i = first; i < *end; i++)
+    n_new += batch->msg_n_packets[i];
+
+  gst_multiudpsink_batch_ensure_msgs (batch, first + n_new);
+
+  dst = first + n_new;
+  for (i = *end; i > first; i--) {
+    gpointer name = batch->msgs[i - 1].msg_hdr.msg_name;
+    socklen_t namelen = batch->msgs[i - 1].msg_hdr.msg_namelen;
+    GstUDPClient *client = batch->msg_clients[i - 1];
+    guint packet = batch->msg_packets[i - 1];
+    guint n = batch->msg_n_packets[i - 1];
+
+    for (j = n; j > 0; j--) {
+      GstMultiUDPSinkPacket *p = &batch->packets[packet + j - 1];
+      struct mmsghdr *msg = &batch->msgs[--dst];
+
+      memset (msg, 0, sizeof (struct mmsghdr));
+      msg->msg_hdr.msg_name = name;
+      msg->msg_hdr.msg_namelen = namelen;
+      msg->msg_hdr.msg_iov = &batch->iov[p->iov_offset];
+      msg->msg_hdr.msg_iovlen = p->n_iov;
+      batch->msg_clients[dst] = client;
+      batch->msg_packets[dst] = packet + j - 1;
+      batch->msg_n_packets[dst] = 1;
+    }
+  }
+
+  *end = first + n_new;
+}
+#endif
+
+/* map all memory of the packets to send. Called without the client lock. */
+static void
+gst_multiudpsink_batch_map (GstMultiUDPSinkBatch * batch, GstBuffer * buffer,
+    GstBufferList * list, guint n_packets)
+{
+  guint i, j, n_iov;
+
+  if (n_packets > batch->packets_alloc) {
+    batch->packets_alloc = MAX (n_packets, batch->packets_alloc * 2);
+    batch->packets =
+        g_renew (GstMultiUDPSinkPacket, batch->packets, batch->packets_alloc);
+  }
+
+  n_iov = 0;
+  for (i = 0; i < n_packets; i++) {
+    GstBuffer *buf = list ? gst_buffer_list_get (list, i) : buffer;
+
+    n_iov += gst_buffer_n_memory (buf);
+  }
+
+  if (n_iov > batch->iov_alloc) {
+    batch->iov_alloc = MAX (n_iov, batch->iov_alloc * 2);
+    batch->iov = g_renew (struct iovec, batch->iov, batch->iov_alloc);
+    batch->maps = g_renew (GstMapInfo, batch->maps, batch->iov_alloc);
+  }
+
+  n_iov = 0;
+  for (i = 0; i < n_packets; i++) {
+    GstBuffer *buf = list ? gst_buffer_list_get (list, i) : buffer;
+    GstMultiUDPSinkPacket *packet = &batch->packets[i];
+    guint n_mem = gst_buffer_n_memory (buf);
+
+    packet->iov_offset = n_iov;
+    packet->n_iov = n_mem;
+    packet->size = 0;
+
+    for (j = 0; j < n_mem; j++) {
+      GstMapInfo *map = &batch->maps[n_iov];
+
+      gst_memory_map (gst_buffer_peek_memory (buf, j), map, GST_MAP_READ);
+      batch->iov[n_iov].iov_base = map->data;
+      batch->iov[n_iov].iov_len = map->size;
+      packet->size += map->size;
+      n_iov++;
+    }
+  }
+}
+
+static void
+gst_multiudpsink_batch_unmap (GstMultiUDPSinkBatch * batch, guint n_packets)
+{
+  guint i, j;
+
+  for (i = 0; i < n_packets; i++) {
+    GstMultiUDPSinkPacket *packet = &batch->packets[i];
+
+    for (j = 0; j < packet->n_iov; j++) {
+      GstMapInfo *map = &batch->maps[packet->iov_offset + j];
+
+      gst_memory_unmap (map->memory, map);
+    }
+  }
+}
+
+/* send msgs [first, first + n_msgs) on @socket, continuing after messages
+ * that fail */
+static GstFlowReturn
+gst_multiudpsink_batch_send (GstMultiUDPSink * sink, GSocket * socket,
+    guint first, guint n_msgs, gint * num)
+{
+  GstMultiUDPSinkBatch *batch = sink->batch;
+  guint i, end, k;
+  gint fd, ret;
+
+  fd = g_socket_get_fd (socket);
+  end = first + n_msgs;
+  i = first;
+
+  while (i < end) {
+    if (g_cancellable_is_cancelled (sink->cancellable))
+      goto flushing;
+
+    ret = sendmmsg (fd, &batch->msgs[i], end - i, 0);
+
+    if (G_UNLIKELY (ret < 0)) {
+      GError *err = NULL;
+      gsize size = 0;
+
+      if (errno == EINTR)
+        continue;
+
+      /* GSocket puts the fd in non-blocking mode, wait until the kernel
+       * buffer has room again */
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        if (g_socket_condition_wait (socket, G_IO_OUT, sink->cancellable,
+                &err))
+          continue;
+
+        if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+          g_clear_error (&err);
+          goto flushing;
+        }
+      }
+
+#ifdef HAVE_UDP_GSO
+      /* GSO is not usable for the route or device after all, send the
+       * packets one by one from now on */
+      if (batch->msg_n_packets[i] > 1 && err == NULL && (errno == EIO
+              || errno == EINVAL || errno == ENOPROTOOPT)) {
+        GST_WARNING_OBJECT (sink, "segmented send failed: %s, disabling GSO",
+            g_strerror (errno));
+        batch->gso = FALSE;
+        gst_multiudpsink_batch_unsegment (batch, i, &end);
+        continue;
+      }
+#endif
+
+      /* message i could not be sent, we continue after posting a warning,
+       * the next ones might be ok again */
+      for (k = 0; k < batch->msg_n_packets[i]; k++)
+        size += batch->packets[batch->msg_packets[i] + k].size;
+      gst_multiudpsink_post_send_warning (sink, size,
+          err ? err->message : g_strerror (errno));
+      g_clear_error (&err);
+      i++;
+      continue;
+    }
+
+    for (k = 0; k < (guint) ret; k++) {
+      GstUDPClient *client = batch->msg_clients[i + k];
+      guint len = batch->msgs[i + k].msg_len;
+
+      client->bytes_sent += len;
+      client->packets_sent += batch->msg_n_packets[i + k];
+      sink->bytes_served += len;
+    }
+    *num += ret;
+    i += ret;
+  }
+
+  return GST_FLOW_OK;
+
+flushing:
+  {
+    GST_DEBUG ("we are flushing");
+    return GST_FLOW_FLUSHING;
+  }
+}
+
+/* send @buffer, or all buffers of @list, to all clients with at most one
+ * sendmmsg() call per socket */
+static GstFlowReturn
+gst_multiudpsink_render_batch (GstMultiUDPSink * sink, GstBuffer * buffer,
+    GstBufferList * list)
+{
+  GstMultiUDPSinkBatch *batch = sink->batch;
+  GstMultiUDPSinkClients *snapshot;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GSocket *sockets[2];
+  guint n_packets, n_runs, n_msgs, i, c, s;
+  gint num, no_clients;
+
+  n_packets = list ? gst_buffer_list_length (list) : 1;
+  if (n_packets == 0)
+    return GST_FLOW_OK;
+
+  gst_multiudpsink_batch_map (batch, buffer, list, n_packets);
+  n_runs = gst_multiudpsink_batch_make_runs (batch, n_packets);
+
+  for (i = 0; i < n_packets; i++)
+    sink->bytes_to_serve += batch->packets[i].size;
+
+  snapshot = gst_multiudpsink_get_clients_snapshot (sink);
+  GST_LOG_OBJECT (sink, "about to send %u packets in %u messages per client",
+      n_packets, n_runs);
+
+  no_clients = snapshot->n_clients;
+  num = 0;
+
+  sockets[0] = sink->used_socket;
+  sockets[1] =
+      (sink->used_socket_v6 != sink->used_socket) ? sink->used_socket_v6 : NULL;
+
+  for (s = 0; s < 2 && ret == GST_FLOW_OK; s++) {
+    if (sockets[s] == NULL)
+      continue;
+
+    n_msgs = 0;
+    for (i = 0; i < n_runs; i++) {
+      GstMultiUDPSinkRun *run = &batch->runs[i];
+
+      for (c = 0; c < snapshot->n_clients; c++) {
+        GstUDPClient *client = snapshot->clients[c];
+        GSocketFamily family;
+        GSocket *socket;
+        gint count;
+
+        family = g_socket_address_get_family (G_SOCKET_ADDRESS (client->addr));
+        /* Select socket to send from for this address */
+        if (family == G_SOCKET_FAMILY_IPV6 || !sink->used_socket)
+          socket = sink->used_socket_v6;
+        else
+          socket = sink->used_socket;
+
+        if (socket != sockets[s])
+          continue;
+
+        count = sink->send_duplicates ? snapshot->counts[c] : 1;
+        gst_multiudpsink_batch_ensure_msgs (batch, n_msgs + count);
+
+        while (count--) {
+          struct mmsghdr *msg = &batch->msgs[n_msgs];
+
+          memset (msg, 0, sizeof (struct mmsghdr));
+          msg->msg_hdr.msg_name = client->native_addr;
+          msg->msg_hdr.msg_namelen = client->native_addr_len;
+          msg->msg_hdr.msg_iov = &batch->iov[run->iov_offset];
+          msg->msg_hdr.msg_iovlen = run->n_iov;
+#ifdef HAVE_UDP_GSO
+          if (run->n_packets > 1) {
+            msg->msg_hdr.msg_control =
+                batch->control + i * UDP_GSO_CONTROL_SIZE;
+            msg->msg_hdr.msg_controllen = UDP_GSO_CONTROL_SIZE;
+          }
+#endif
+          batch->msg_clients[n_msgs] = client;
+          batch->msg_packets[n_msgs] = run->packet;
+          batch->msg_n_packets[n_msgs] = run->n_packets;
+          n_msgs++;
+        }
+      }
+    }
+
+    if (n_msgs > 0)
+      ret = gst_multiudpsink_batch_send (sink, sockets[s], 0, n_msgs, &num);
+  }
+  clients_snapshot_unref (snapshot);
+
+  gst_multiudpsink_batch_unmap (batch, n_packets);
+
+  GST_LOG_OBJECT (sink, "sent %d messages for %u packets to %d clients",
+      num, n_packets, no_clients);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_multiudpsink_render_list (GstBaseSink * bsink, GstBufferList * list)
+{
+  return gst_multiudpsink_render_batch (GST_MULTIUDPSINK (bsink), NULL, list);
+}
+#endif
+
 static GstFlowReturn
 gst_multiudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
 {
   GstMultiUDPSink *sink;
-  GList *clients;
+  GstMultiUDPSinkClients *snapshot;
   GOutputVector *vec;
   GstMapInfo *map;
-  guint n_mem, i;
+  guint n_mem, i, c;
   gsize size;
   GstMemory *mem;
   gint num, no_clients;
@@ -531,6 +1202,10 @@ gst_multiudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
 
   sink = GST_MULTIUDPSINK (bsink);
 
+#ifdef HAVE_SENDMMSG
+  return gst_multiudpsink_render_batch (sink, buffer, NULL);
+#endif
+
   n_mem = gst_buffer_n_memory (buffer);
   if (n_mem == 0)
     goto no_data;
@@ -553,21 +1228,21 @@ gst_multiudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
 
   sink->bytes_to_serve += size;
 
-  /* grab lock while iterating and sending to clients, this should be
-   * fast as UDP never blocks */
-  g_mutex_lock (&sink->client_lock);
+  /* no need to hold the client lock while sending, clients added or removed
+   * meanwhile will only be picked up for the next buffer */
+  snapshot = gst_multiudpsink_get_clients_snapshot (sink);
   GST_LOG_OBJECT (bsink, "about to send %" G_GSIZE_FORMAT " bytes in %u blocks",
       size, n_mem);
 
   no_clients = 0;
   num = 0;
-  for (clients = sink->clients; clients; clients = g_list_next (clients)) {
+  for (c = 0; c < snapshot->n_clients; c++) {
     GstUDPClient *client;
     GSocket *socket;
     GSocketFamily family;
     gint count;
 
-    client = (GstUDPClient *) clients->data;
+    client = snapshot->clients[c];
     no_clients++;
     GST_LOG_OBJECT (sink, "sending %" G_GSIZE_FORMAT " bytes to client %p",
         size, client);
@@ -579,7 +1254,7 @@ gst_multiudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
     else
       socket = sink->used_socket;
 
-    count = sink->send_duplicates ? client->refcount : 1;
+    count = sink->send_duplicates ? snapshot->counts[c] : 1;
 
     while (count--) {
       gssize ret;
@@ -594,16 +1269,8 @@ gst_multiudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
 
         /* we continue after posting a warning, next packets might be ok
          * again */
-        if (size > UDP_MAX_SIZE) {
-          GST_ELEMENT_WARNING (sink, RESOURCE, WRITE,
-              ("Attempting to send a UDP packet larger than maximum size "
-                  "(%" G_GSIZE_FORMAT " > %d)", size, UDP_MAX_SIZE),
-              ("Reason: %s", err ? err->message : "unknown reason"));
-        } else {
-          GST_ELEMENT_WARNING (sink, RESOURCE, WRITE,
-              ("Error sending UDP packet"), ("Reason: %s",
-                  err ? err->message : "unknown reason"));
-        }
+        gst_multiudpsink_post_send_warning (sink, size,
+            err ? err->message : NULL);
         g_clear_error (&err);
       } else {
         num++;
@@ -613,7 +1280,7 @@ gst_multiudpsink_render (GstBaseSink * bsink, GstBuffer * buffer)
       }
     }
   }
-  g_mutex_unlock (&sink->client_lock);
+  clients_snapshot_unref (snapshot);
 
   /* unmap all memory again */
   for (i = 0; i < n_mem; i++) {
@@ -633,7 +1300,7 @@ no_data:
 flushing:
   {
     GST_DEBUG ("we are flushing");
-    g_mutex_unlock (&sink->client_lock);
+    clients_snapshot_unref (snapshot);
     g_clear_error (&err);
 
     /* unmap all memory */
@@ -828,6 +1495,9 @@ gst_multiudpsink_set_property (GObject * object, guint prop_id,
     case PROP_BIND_PORT:
       udpsink->bind_port = g_value_get_int (value);
       break;
+    case PROP_GSO:
+      udpsink->gso = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -901,6 +1571,9 @@ gst_multiudpsink_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_BIND_PORT:
       g_value_set_int (value, udpsink->bind_port);
       break;
+    case PROP_GSO:
+      g_value_set_boolean (value, udpsink->gso);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1160,6 +1833,10 @@ gst_multiudpsink_start (GstBaseSink * bsink)
   gst_multiudpsink_setup_qos_dscp (sink, sink->used_socket);
   gst_multiudpsink_setup_qos_dscp (sink, sink->used_socket_v6);
 
+#ifdef HAVE_SENDMMSG
+  gst_multiudpsink_setup_gso (sink);
+#endif
+
   /* look for multicast clients and join multicast groups appropriately
      set also ttl and multicast loopback delivery appropriately  */
   for (clients = sink->clients; clients; clients = g_list_next (clients)) {
@@ -1258,6 +1935,7 @@ gst_multiudpsink_add_internal (GstMultiUDPSink * sink, const gchar * host,
     GST_DEBUG_OBJECT (sink, "found %d existing clients with host %s, port %d",
         client->refcount, host, port);
     client->refcount++;
+    gst_multiudpsink_update_clients_snapshot (sink);
   } else {
     client = create_client (sink, host, port);
     if (!client)
@@ -1271,6 +1949,7 @@ gst_multiudpsink_add_internal (GstMultiUDPSink * sink, const gchar * host,
 
     GST_DEBUG_OBJECT (sink, "add client with host %s, port %d", host, port);
     sink->clients = g_list_prepend (sink->clients, client);
+    gst_multiudpsink_update_clients_snapshot (sink);
   }
 
   if (lock)
@@ -1362,6 +2041,7 @@ gst_multiudpsink_remove (GstMultiUDPSink * sink, const gchar * host, gint port)
 
     free_client (client);
   }
+  gst_multiudpsink_update_clients_snapshot (sink);
   g_mutex_unlock (&sink->client_lock);
 
   return;
@@ -1387,6 +2067,7 @@ gst_multiudpsink_clear_internal (GstMultiUDPSink * sink, gboolean lock)
   g_list_foreach (sink->clients, (GFunc) free_client, sink);
   g_list_free (sink->clients);
   sink->clients = NULL;
+  gst_multiudpsink_update_clients_snapshot (sink);
   if (lock)
     g_mutex_unlock (&sink->client_lock);
 }
@@ -36,14 +36,24 @@ G_BEGIN_DECLS
 
 typedef struct _GstMultiUDPSink GstMultiUDPSink;
 typedef struct _GstMultiUDPSinkClass GstMultiUDPSinkClass;
+typedef struct _GstMultiUDPSinkBatch GstMultiUDPSinkBatch;
+typedef struct _GstMultiUDPSinkClients GstMultiUDPSinkClients;
 
 typedef struct {
+  /* number of times the client was added */
   gint refcount;
+  /* memory refcount, held by the client list and by every snapshot
+   * containing the client */
+  gint users;
 
   GSocketAddress *addr;
   gchar *host;
   gint port;
 
+  /* addr in native form, for sending without going through GSocket */
+  gpointer native_addr;
+  gsize native_addr_len;
+
   /* Per-client stats */
   guint64 bytes_sent;
   guint64 packets_sent;
@@ -61,10 +71,16 @@ struct _GstMultiUDPSink {
 
   GMutex         client_lock;
   GList         *clients;
+  /* copy of clients for the streaming thread, replaced as a whole when the
+   * list changes. Protected by the object lock. */
+  GstMultiUDPSinkClients *clients_snapshot;
 
   GOutputVector *vec;
   GstMapInfo *map;
 
+  /* state for sending all packets of a render call with sendmmsg() */
+  GstMultiUDPSinkBatch *batch;
+
   /* properties */
   guint64        bytes_to_serve;
   guint64        bytes_served;
@@ -85,6 +101,7 @@ struct _GstMultiUDPSink {
   gint           buffer_size;
   gchar         *bind_address;
   gint           bind_port;
+  gboolean       gso;
 };
 
 struct _GstMultiUDPSinkClass {
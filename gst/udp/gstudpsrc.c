@@ -99,6 +99,9 @@
  * |[
  * gst-launch-1.0 -v udpsrc port=0 ! fakesink
  * ]| read udp packets from a free port.
+ * |[
+ * gst-launch-1.0 -v udpsrc port=5004 batch-size=32 mtu=1500 ! fakesink
+ * ]| read up to 32 packets of at most 1500 bytes per wakeup.
  * </refsect2>
  *
  * Last reviewed on 2007-09-20 (0.10.7)
@@ -107,6 +110,13 @@
 #include "config.h"
 #endif
 
+#if defined (HAVE_RECVMMSG) || defined (HAVE_SCHED_SETAFFINITY)
+/* for recvmmsg(), struct mmsghdr and sched_setaffinity() */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
+
 #include "gstudpsrc.h"
 
 #include <gst/net/gstnetaddressmeta.h>
@@ -130,9 +140,61 @@
 #endif
 #endif
 
+#ifdef HAVE_RECVMMSG
+#include <sys/socket.h>
+#include <string.h>
+#include <errno.h>
+#endif
+
+#ifdef HAVE_SCHED_SETAFFINITY
+#include <sched.h>
+#endif
+
+#if defined (HAVE_RECVMMSG) && defined (SO_TIMESTAMPNS)
+#define HAVE_KERNEL_TIMESTAMPS 1
+#include <time.h>
+
+/* control message space per packet for the receive timestamp */
+#define KERNEL_TIMESTAMP_CONTROL_SIZE (CMSG_SPACE (sizeof (struct timespec)))
+#endif
+
+#if defined (HAVE_RECVMMSG) && defined (__linux__)
+#define HAVE_UDP_GRO 1
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+/* older C libraries don't know about the socket option yet */
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+/* control message space per packet for the GRO segment size */
+#define UDP_GRO_CONTROL_SIZE (CMSG_SPACE (sizeof (gint)))
+
+/* size of the buffers coalesced packets are read into */
+#define UDP_GRO_BUFFER_SIZE 65536
+#endif
+
+#if defined (SO_REUSEPORT) && !defined (G_OS_WIN32)
+#define HAVE_REUSEPORT_READERS 1
+#include <errno.h>
+#endif
+
 /* not 100% correct, but a good upper bound for memory allocation purposes */
 #define MAX_IPV4_UDP_PACKET_SIZE (65536 - 8)
 
+/* upper bound for the number of packets read with a single recvmmsg() */
+#define MAX_BATCH_SIZE 1024
+
+/* upper bound for the number of SO_REUSEPORT reader threads */
+#define MAX_READER_THREADS 64
+
+/* packets queued by the reader threads before new ones are dropped */
+#define MAX_QUEUED_PACKETS 4096
+
 GST_DEBUG_CATEGORY_STATIC (udpsrc_debug);
 #define GST_CAT_DEFAULT (udpsrc_debug)
 
@@ -154,6 +216,12 @@ static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
 #define UDP_DEFAULT_USED_SOCKET        NULL
 #define UDP_DEFAULT_AUTO_MULTICAST     TRUE
 #define UDP_DEFAULT_REUSE              TRUE
+#define UDP_DEFAULT_BATCH_SIZE         1
+#define UDP_DEFAULT_MTU                1500
+#define UDP_DEFAULT_READER_THREADS     1
+#define UDP_DEFAULT_PIN_THREADS        FALSE
+#define UDP_DEFAULT_KERNEL_TIMESTAMPS  FALSE
+#define UDP_DEFAULT_GRO                FALSE
 
 enum
 {
@@ -173,6 +241,12 @@ enum
   PROP_AUTO_MULTICAST,
   PROP_REUSE,
   PROP_ADDRESS,
+  PROP_BATCH_SIZE,
+  PROP_MTU,
+  PROP_READER_THREADS,
+  PROP_PIN_THREADS,
+  PROP_KERNEL_TIMESTAMPS,
+  PROP_GRO,
 
   PROP_LAST
 };
@@ -281,6 +355,104 @@ gst_udpsrc_class_init (GstUDPSrcClass * klass)
           "Address to receive packets for. This is equivalent to the "
           "multicast-group property for now", UDP_DEFAULT_MULTICAST_GROUP,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstUDPSrc:batch-size:
+   *
+   * Maximum number of packets to read from the socket per wakeup. When larger
+   * than 1, packets are received with a single recvmmsg() call into buffers
+   * of #GstUDPSrc:mtu bytes taken from a preallocated buffer pool, and are
+   * then pushed one by one. Has no effect on systems without recvmmsg().
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_BATCH_SIZE,
+      g_param_spec_uint ("batch-size", "Batch Size",
+          "Maximum number of packets to read per wakeup (1 = no batching)", 1,
+          MAX_BATCH_SIZE, UDP_DEFAULT_BATCH_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstUDPSrc:mtu:
+   *
+   * Size of the buffers used for batched reception. Packets larger than this
+   * are dropped.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_MTU,
+      g_param_spec_uint ("mtu", "MTU",
+          "Maximum packet size in bytes when reading in batches", 1,
+          MAX_IPV4_UDP_PACKET_SIZE, UDP_DEFAULT_MTU,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstUDPSrc:reader-threads:
+   *
+   * Number of sockets to open on the same port with SO_REUSEPORT, each read
+   * by its own thread. The kernel distributes incoming packets over the
+   * sockets by hashing the source and destination addresses and ports, so
+   * packets from one sender always go to the same socket and stay in order.
+   * Only used when udpsrc allocates the socket itself.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_READER_THREADS,
+      g_param_spec_uint ("reader-threads", "Reader Threads",
+          "Number of SO_REUSEPORT sockets and threads reading them "
+          "(1 = read the socket from the streaming thread)", 1,
+          MAX_READER_THREADS, UDP_DEFAULT_READER_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstUDPSrc:pin-threads:
+   *
+   * Pin each reader thread to its own CPU. Only used when
+   * #GstUDPSrc:reader-threads is larger than 1.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_PIN_THREADS,
+      g_param_spec_boolean ("pin-threads", "Pin Threads",
+          "Pin each reader thread to a different CPU",
+          UDP_DEFAULT_PIN_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstUDPSrc:kernel-timestamps:
+   *
+   * Timestamp packets with the time the kernel received them instead of the
+   * time they were read from the socket, so that scheduling delays don't show
+   * up as network jitter. The receive times are read with SO_TIMESTAMPNS and
+   * converted to running time of the pipeline clock.
+   *
+   * This uses the recvmmsg() reader, so packets larger than #GstUDPSrc:mtu
+   * are dropped even when #GstUDPSrc:batch-size is 1. It is not used
+   * together with #GstUDPSrc:reader-threads and has no effect on systems
+   * without SO_TIMESTAMPNS and recvmmsg().
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_KERNEL_TIMESTAMPS,
+      g_param_spec_boolean ("kernel-timestamps", "Kernel Timestamps",
+          "Timestamp packets with their kernel receive time",
+          UDP_DEFAULT_KERNEL_TIMESTAMPS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstUDPSrc:gro:
+   *
+   * Enable UDP generic receive offload. The kernel then coalesces
+   * consecutive packets of the same size from one sender and hands them out
+   * with a single read, which saves a lot of per-packet overhead at high
+   * packet rates. udpsrc splits the coalesced data back into one buffer per
+   * packet again, without copying, so downstream sees the same packets as
+   * without offload.
+   *
+   * This uses the recvmmsg() reader with 64 KiB buffers instead of
+   * #GstUDPSrc:mtu sized ones. It is not used together with
+   * #GstUDPSrc:reader-threads and has no effect on kernels without UDP GRO
+   * support (before Linux 5.0) or on other systems.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_GRO,
+      g_param_spec_boolean ("gro", "GRO",
+          "Let the kernel coalesce packets and split them again after reading",
+          UDP_DEFAULT_GRO, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&src_template));
@@ -319,6 +491,16 @@ gst_udpsrc_init (GstUDPSrc * udpsrc)
   udpsrc->auto_multicast = UDP_DEFAULT_AUTO_MULTICAST;
   udpsrc->used_socket = UDP_DEFAULT_USED_SOCKET;
   udpsrc->reuse = UDP_DEFAULT_REUSE;
+  udpsrc->batch_size = UDP_DEFAULT_BATCH_SIZE;
+  udpsrc->mtu = UDP_DEFAULT_MTU;
+  udpsrc->reader_threads = UDP_DEFAULT_READER_THREADS;
+  udpsrc->pin_threads = UDP_DEFAULT_PIN_THREADS;
+  udpsrc->kernel_timestamps = UDP_DEFAULT_KERNEL_TIMESTAMPS;
+  udpsrc->gro = UDP_DEFAULT_GRO;
+
+  g_mutex_init (&udpsrc->queue_lock);
+  g_cond_init (&udpsrc->queue_cond);
+  g_queue_init (&udpsrc->queue);
 
   udpsrc->cancellable = g_cancellable_new ();
 
@@ -363,6 +545,9 @@ gst_udpsrc_finalize (GObject * object)
     g_object_unref (udpsrc->cancellable);
   udpsrc->cancellable = NULL;
 
+  g_mutex_clear (&udpsrc->queue_lock);
+  g_cond_clear (&udpsrc->queue_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -392,28 +577,14 @@ gst_udpsrc_getcaps (GstBaseSrc * src, GstCaps * filter)
   return result;
 }
 
+/* wait until the socket becomes readable, posting a timeout message every
+ * time the configured timeout expires */
 static GstFlowReturn
-gst_udpsrc_create (GstPushSrc * psrc, GstBuffer ** buf)
+gst_udpsrc_wait (GstUDPSrc * udpsrc)
 {
-  GstFlowReturn ret;
-  GstUDPSrc *udpsrc;
-  GstBuffer *outbuf = NULL;
-  GstMapInfo info;
-  GSocketAddress *saddr = NULL;
-  gsize offset;
-  gssize readsize;
-  gssize res;
   gboolean try_again;
   GError *err = NULL;
 
-  udpsrc = GST_UDPSRC_CAST (psrc);
-
-retry:
-  /* quick check, avoid going in select when we already have data */
-  readsize = g_socket_get_available_bytes (udpsrc->used_socket);
-  if (readsize > 0)
-    goto no_select;
-
   do {
     gint64 timeout;
 
@@ -447,6 +618,839 @@ retry:
     }
   } while (G_UNLIKELY (try_again));
 
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+select_error:
+  {
+    GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
+        ("select error: %s", err->message));
+    g_clear_error (&err);
+    return GST_FLOW_ERROR;
+  }
+stopped:
+  {
+    GST_DEBUG ("stop called");
+    g_clear_error (&err);
+    return GST_FLOW_FLUSHING;
+  }
+}
+
+#ifdef HAVE_RECVMMSG
+struct _GstUDPSrcBatch
+{
+  guint size;
+
+  /* packets received but not pushed yet */
+  GQueue queue;
+
+  /* sender address of the last packet, most streams have a single sender so
+   * this avoids creating a GSocketAddress for every packet */
+  GSocketAddress *last_saddr;
+  struct sockaddr_storage last_addr;
+  socklen_t last_addrlen;
+
+  /* recvmmsg() state, allocated once for size packets */
+  struct mmsghdr *msgs;
+  struct iovec *iov;
+  struct sockaddr_storage *addrs;
+  GstBuffer **bufs;
+  GstMapInfo *maps;
+
+  /* control message space for the kernel receive timestamps and the GRO
+   * segment sizes, control_size bytes per packet, or NULL */
+  guint8 *control;
+  gsize control_size;
+
+  /* the socket adds receive timestamps and hands out coalesced packets */
+  gboolean timestamps;
+  gboolean gro;
+};
+
+static gboolean
+gst_udpsrc_batch_setup (GstUDPSrc * src)
+{
+  GstUDPSrcBatch *batch;
+  GstStructure *config;
+  gboolean gro = FALSE;
+  guint bufsize;
+
+#ifdef HAVE_UDP_GRO
+  if (src->gro) {
+    gint val = 1;
+
+    if (setsockopt (g_socket_get_fd (src->used_socket), SOL_UDP, UDP_GRO,
+            (void *) &val, sizeof (val)) == 0) {
+      gro = TRUE;
+    } else {
+      GST_WARNING_OBJECT (src, "could not enable GRO: %s", g_strerror (errno));
+    }
+  }
+#else
+  if (src->gro)
+    GST_WARNING_OBJECT (src, "GRO is not supported on this platform");
+#endif
+
+  /* a coalesced read can be a lot larger than a single packet */
+#ifdef HAVE_UDP_GRO
+  bufsize = gro ? MAX (src->mtu, UDP_GRO_BUFFER_SIZE) : src->mtu;
+#else
+  bufsize = src->mtu;
+#endif
+
+  src->pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (src->pool);
+  gst_buffer_pool_config_set_params (config, NULL, bufsize, src->batch_size,
+      0);
+  if (!gst_buffer_pool_set_config (src->pool, config))
+    goto pool_failed;
+  if (!gst_buffer_pool_set_active (src->pool, TRUE))
+    goto pool_failed;
+
+  batch = g_slice_new0 (GstUDPSrcBatch);
+  batch->size = src->batch_size;
+  g_queue_init (&batch->queue);
+  batch->msgs = g_new0 (struct mmsghdr, batch->size);
+  batch->iov = g_new0 (struct iovec, batch->size);
+  batch->addrs = g_new0 (struct sockaddr_storage, batch->size);
+  batch->bufs = g_new0 (GstBuffer *, batch->size);
+  batch->maps = g_new0 (GstMapInfo, batch->size);
+  batch->gro = gro;
+  src->batch = batch;
+
+#ifdef HAVE_KERNEL_TIMESTAMPS
+  if (src->kernel_timestamps) {
+    gint val = 1;
+
+    if (setsockopt (g_socket_get_fd (src->used_socket), SOL_SOCKET,
+            SO_TIMESTAMPNS, (void *) &val, sizeof (val)) == 0) {
+      batch->control_size += KERNEL_TIMESTAMP_CONTROL_SIZE;
+      batch->timestamps = TRUE;
+    } else {
+      GST_WARNING_OBJECT (src, "could not enable kernel timestamps: %s",
+          g_strerror (errno));
+    }
+  }
+#endif
+#ifdef HAVE_UDP_GRO
+  if (gro)
+    batch->control_size += UDP_GRO_CONTROL_SIZE;
+#endif
+  if (batch->control_size > 0)
+    batch->control = g_malloc0 (batch->size * batch->control_size);
+
+  GST_DEBUG_OBJECT (src, "reading up to %u packets of %u bytes per wakeup%s",
+      src->batch_size, bufsize, gro ? " with GRO" : "");
+
+  return TRUE;
+
+  /* ERRORS */
+pool_failed:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS, (NULL),
+        ("failed to configure buffer pool for batched reception"));
+    gst_object_unref (src->pool);
+    src->pool = NULL;
+    return FALSE;
+  }
+}
+
+static void
+gst_udpsrc_batch_free (GstUDPSrc * src)
+{
+  GstUDPSrcBatch *batch = src->batch;
+
+  if (batch) {
+    g_queue_foreach (&batch->queue, (GFunc) gst_buffer_unref, NULL);
+    g_queue_clear (&batch->queue);
+    if (batch->last_saddr)
+      g_object_unref (batch->last_saddr);
+    g_free (batch->msgs);
+    g_free (batch->iov);
+    g_free (batch->addrs);
+    g_free (batch->bufs);
+    g_free (batch->maps);
+    g_free (batch->control);
+    g_slice_free (GstUDPSrcBatch, batch);
+    src->batch = NULL;
+  }
+
+  if (src->pool) {
+    gst_buffer_pool_set_active (src->pool, FALSE);
+    gst_object_unref (src->pool);
+    src->pool = NULL;
+  }
+}
+
+/* returns a borrowed reference to an address object for @addr */
+static GSocketAddress *
+gst_udpsrc_batch_get_address (GstUDPSrcBatch * batch,
+    struct sockaddr_storage *addr, socklen_t addrlen)
+{
+  if (addrlen == 0)
+    return NULL;
+
+  if (batch->last_saddr == NULL || batch->last_addrlen != addrlen
+      || memcmp (&batch->last_addr, addr, addrlen) != 0) {
+    if (batch->last_saddr)
+      g_object_unref (batch->last_saddr);
+    batch->last_saddr = g_socket_address_new_from_native (addr, addrlen);
+    if (batch->last_saddr == NULL) {
+      batch->last_addrlen = 0;
+      return NULL;
+    }
+    memcpy (&batch->last_addr, addr, addrlen);
+    batch->last_addrlen = addrlen;
+  }
+
+  return batch->last_saddr;
+}
+
+#ifdef HAVE_KERNEL_TIMESTAMPS
+/* get the offset that converts kernel receive times, which are in
+ * CLOCK_REALTIME, to running time. @real is set to the current realtime. */
+static gboolean
+gst_udpsrc_get_kernel_time_offset (GstUDPSrc * src, gint64 * offset,
+    GstClockTime * real)
+{
+  GstClock *clock;
+  GstClockTime base_time, now;
+  struct timespec ts;
+
+  GST_OBJECT_LOCK (src);
+  if ((clock = GST_ELEMENT_CLOCK (src)))
+    gst_object_ref (clock);
+  base_time = GST_ELEMENT_CAST (src)->base_time;
+  GST_OBJECT_UNLOCK (src);
+
+  if (clock == NULL)
+    return FALSE;
+
+  now = gst_clock_get_time (clock);
+  clock_gettime (CLOCK_REALTIME, &ts);
+  gst_object_unref (clock);
+
+  *real = GST_TIMESPEC_TO_TIME (ts);
+  *offset = (gint64) now - (gint64) base_time - (gint64) (*real);
+
+  return TRUE;
+}
+
+/* the kernel receive time of the packet in @hdr, in CLOCK_REALTIME */
+static GstClockTime
+gst_udpsrc_get_kernel_time (struct msghdr *hdr)
+{
+  struct cmsghdr *cmsg;
+
+  for (cmsg = CMSG_FIRSTHDR (hdr); cmsg; cmsg = CMSG_NXTHDR (hdr, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+      struct timespec ts;
+
+      memcpy (&ts, CMSG_DATA (cmsg), sizeof (ts));
+      return GST_TIMESPEC_TO_TIME (ts);
+    }
+  }
+
+  return GST_CLOCK_TIME_NONE;
+}
+#endif
+
+#ifdef HAVE_UDP_GRO
+/* the size of the packets coalesced in @hdr, or 0 if it holds just one */
+static gsize
+gst_udpsrc_get_gro_segment_size (struct msghdr *hdr)
+{
+  struct cmsghdr *cmsg;
+
+  for (cmsg = CMSG_FIRSTHDR (hdr); cmsg; cmsg = CMSG_NXTHDR (hdr, cmsg)) {
+    if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+      gint segsize;
+
+      memcpy (&segsize, CMSG_DATA (cmsg), sizeof (segsize));
+      return segsize > 0 ? segsize : 0;
+    }
+  }
+
+  return 0;
+}
+#endif
+
+/* read as many packets as are available, up to the batch size, and queue
+ * them */
+static GstFlowReturn
+gst_udpsrc_batch_receive (GstUDPSrc * udpsrc)
+{
+  GstUDPSrcBatch *batch = udpsrc->batch;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gint fd, res;
+  guint i, n;
+#ifdef HAVE_KERNEL_TIMESTAMPS
+  gboolean have_offset = FALSE;
+  GstClockTime real = 0;
+  gint64 time_offset = 0;
+#endif
+
+  fd = g_socket_get_fd (udpsrc->used_socket);
+
+  for (n = 0; n < batch->size; n++) {
+    GstBuffer *outbuf = NULL;
+    gsize offset, maxsize;
+
+    ret = gst_buffer_pool_acquire_buffer (udpsrc->pool, &outbuf, NULL);
+    if (ret != GST_FLOW_OK)
+      goto alloc_failed;
+
+    /* undo the resize of a previous use of this buffer */
+    gst_buffer_get_sizes (outbuf, &offset, &maxsize);
+    gst_buffer_resize (outbuf, -(gssize) offset, maxsize);
+
+    gst_buffer_map (outbuf, &batch->maps[n], GST_MAP_WRITE);
+    batch->bufs[n] = outbuf;
+
+    batch->iov[n].iov_base = batch->maps[n].data;
+    batch->iov[n].iov_len = batch->maps[n].size;
+    memset (&batch->msgs[n], 0, sizeof (struct mmsghdr));
+    batch->msgs[n].msg_hdr.msg_iov = &batch->iov[n];
+    batch->msgs[n].msg_hdr.msg_iovlen = 1;
+    batch->msgs[n].msg_hdr.msg_name = &batch->addrs[n];
+    batch->msgs[n].msg_hdr.msg_namelen = sizeof (struct sockaddr_storage);
+    if (batch->control) {
+      batch->msgs[n].msg_hdr.msg_control =
+          batch->control + n * batch->control_size;
+      batch->msgs[n].msg_hdr.msg_controllen = batch->control_size;
+    }
+  }
+
+  do {
+    res = recvmmsg (fd, batch->msgs, n, MSG_DONTWAIT, NULL);
+  } while (G_UNLIKELY (res < 0 && errno == EINTR));
+
+  if (G_UNLIKELY (res < 0)) {
+    /* spurious wakeup, or an ICMP "port unreachable" for a packet sent with
+     * udpsink from this socket. Both are harmless. */
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNREFUSED
+        || errno == EHOSTUNREACH) {
+      res = 0;
+    } else {
+      GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
+          ("receive error: %s", g_strerror (errno)));
+      ret = GST_FLOW_ERROR;
+      res = 0;
+    }
+  }
+
+  GST_LOG_OBJECT (udpsrc, "received %d packets in one batch", res);
+
+#ifdef HAVE_KERNEL_TIMESTAMPS
+  /* one clock reading for the whole batch */
+  if (batch->timestamps && res > 0)
+    have_offset =
+        gst_udpsrc_get_kernel_time_offset (udpsrc, &time_offset, &real);
+#endif
+
+  for (i = 0; i < n; i++) {
+    GstBuffer *outbuf = batch->bufs[i];
+    struct mmsghdr *msg = &batch->msgs[i];
+    GSocketAddress *saddr;
+    GstClockTime pts = GST_CLOCK_TIME_NONE;
+    gsize pos, size, segsize;
+
+    gst_buffer_unmap (outbuf, &batch->maps[i]);
+    batch->bufs[i] = NULL;
+
+    if (i >= res || ret != GST_FLOW_OK) {
+      gst_buffer_unref (outbuf);
+      continue;
+    }
+
+    size = msg->msg_len;
+
+    if (G_UNLIKELY (msg->msg_hdr.msg_flags & MSG_TRUNC)) {
+      GST_WARNING_OBJECT (udpsrc, "dropping packet larger than mtu %u",
+          udpsrc->mtu);
+      gst_buffer_unref (outbuf);
+      continue;
+    }
+
+    /* like in the unbatched case, empty packets are ignored */
+    if (G_UNLIKELY (size == 0)) {
+      gst_buffer_unref (outbuf);
+      continue;
+    }
+
+    saddr = gst_udpsrc_batch_get_address (batch, &batch->addrs[i],
+        msg->msg_hdr.msg_namelen);
+
+#ifdef HAVE_KERNEL_TIMESTAMPS
+    if (have_offset) {
+      GstClockTime ktime = gst_udpsrc_get_kernel_time (&msg->msg_hdr);
+
+      /* otherwise basesrc timestamps the buffer as usual */
+      if (GST_CLOCK_TIME_IS_VALID (ktime)) {
+        gint64 running;
+
+        /* the realtime clock could have been stepped back since */
+        running = (gint64) MIN (ktime, real) + time_offset;
+        pts = MAX (running, 0);
+      }
+    }
+#endif
+
+    /* a coalesced read holds packets of segsize bytes, only the last one can
+     * be shorter */
+    segsize = size;
+#ifdef HAVE_UDP_GRO
+    if (batch->gro) {
+      segsize = gst_udpsrc_get_gro_segment_size (&msg->msg_hdr);
+      if (segsize == 0 || segsize > size)
+        segsize = size;
+      else if (segsize < size)
+        GST_LOG_OBJECT (udpsrc, "splitting %" G_GSIZE_FORMAT " bytes into "
+            "packets of %" G_GSIZE_FORMAT, size, segsize);
+    }
+#endif
+
+    for (pos = 0; pos < size; pos += segsize) {
+      GstBuffer *packet;
+      gsize offset = pos, len = MIN (segsize, size - pos);
+
+      /* patch offset and size when stripping off the headers */
+      if (G_UNLIKELY (udpsrc->skip_first_bytes != 0)) {
+        if (G_UNLIKELY (len < (gsize) udpsrc->skip_first_bytes)) {
+          GST_ELEMENT_ERROR (udpsrc, STREAM, DECODE, (NULL),
+              ("UDP buffer to small to skip header"));
+          ret = GST_FLOW_ERROR;
+          break;
+        }
+
+        offset += udpsrc->skip_first_bytes;
+        len -= udpsrc->skip_first_bytes;
+      }
+
+      if (segsize == size) {
+        gst_buffer_resize (outbuf, offset, len);
+        packet = outbuf;
+        outbuf = NULL;
+      } else {
+        /* shares the memory. When the pool hands out the buffer again,
+         * mapping it for writing makes it get new memory, so the data of
+         * these packets stays intact. */
+        packet = gst_buffer_copy_region (outbuf, GST_BUFFER_COPY_MEMORY,
+            offset, len);
+      }
+
+      if (saddr)
+        gst_buffer_add_net_address_meta (packet, saddr);
+      GST_BUFFER_PTS (packet) = GST_BUFFER_DTS (packet) = pts;
+
+      g_queue_push_tail (&batch->queue, packet);
+    }
+
+    if (outbuf)
+      gst_buffer_unref (outbuf);
+  }
+
+  return ret;
+
+  /* ERRORS */
+alloc_failed:
+  {
+    GST_DEBUG_OBJECT (udpsrc, "Allocation failed: %s", gst_flow_get_name (ret));
+    for (i = 0; i < n; i++) {
+      gst_buffer_unmap (batch->bufs[i], &batch->maps[i]);
+      gst_buffer_unref (batch->bufs[i]);
+      batch->bufs[i] = NULL;
+    }
+    return ret;
+  }
+}
+
+static GstFlowReturn
+gst_udpsrc_create_batched (GstUDPSrc * udpsrc, GstBuffer ** buf)
+{
+  GstUDPSrcBatch *batch = udpsrc->batch;
+  GstFlowReturn ret;
+
+  while (g_queue_is_empty (&batch->queue)) {
+    if ((ret = gst_udpsrc_wait (udpsrc)) != GST_FLOW_OK)
+      return ret;
+
+    if ((ret = gst_udpsrc_batch_receive (udpsrc)) != GST_FLOW_OK)
+      return ret;
+  }
+
+  *buf = g_queue_pop_head (&batch->queue);
+
+  return GST_FLOW_OK;
+}
+#endif
+
+#ifdef HAVE_REUSEPORT_READERS
+struct _GstUDPSrcWorker
+{
+  GstUDPSrc *src;
+  guint index;
+  GSocket *socket;
+  GCancellable *cancellable;
+  GThread *thread;
+};
+
+/* receive one packet from the socket of @worker, returns NULL when the
+ * packet should be skipped */
+static GstBuffer *
+gst_udpsrc_worker_receive (GstUDPSrcWorker * worker, GError ** err)
+{
+  GstUDPSrc *src = worker->src;
+  GSocketAddress *saddr = NULL;
+  GstBuffer *outbuf;
+  GstMapInfo info;
+  gssize readsize, res;
+  gsize offset = 0;
+
+  readsize = g_socket_get_available_bytes (worker->socket);
+  if (G_UNLIKELY (readsize <= 0)) {
+    /* read and ignore empty packets, see gst_udpsrc_create() */
+    res = g_socket_receive_from (worker->socket, NULL, NULL, 0,
+        worker->cancellable, err);
+    return NULL;
+  }
+
+  if (g_socket_get_family (worker->socket) == G_SOCKET_FAMILY_IPV4)
+    readsize = MIN (MAX_IPV4_UDP_PACKET_SIZE, readsize);
+
+  outbuf = gst_buffer_new_allocate (NULL, readsize, NULL);
+  gst_buffer_map (outbuf, &info, GST_MAP_WRITE);
+  res = g_socket_receive_from (worker->socket, &saddr, (gchar *) info.data,
+      info.size, worker->cancellable, err);
+  gst_buffer_unmap (outbuf, &info);
+
+  if (G_UNLIKELY (res < 0)) {
+    gst_buffer_unref (outbuf);
+    return NULL;
+  }
+
+  if (G_UNLIKELY (src->skip_first_bytes != 0)) {
+    if (G_UNLIKELY (res < src->skip_first_bytes)) {
+      GST_WARNING_OBJECT (src, "UDP buffer to small to skip header");
+      gst_buffer_unref (outbuf);
+      if (saddr)
+        g_object_unref (saddr);
+      return NULL;
+    }
+    offset += src->skip_first_bytes;
+    res -= src->skip_first_bytes;
+  }
+
+  gst_buffer_resize (outbuf, offset, res);
+
+  if (saddr) {
+    gst_buffer_add_net_address_meta (outbuf, saddr);
+    g_object_unref (saddr);
+  }
+
+  return outbuf;
+}
+
+static gpointer
+gst_udpsrc_worker_thread (GstUDPSrcWorker * worker)
+{
+  GstUDPSrc *src = worker->src;
+
+#if defined (HAVE_SCHED_SETAFFINITY) && GLIB_CHECK_VERSION (2, 36, 0)
+  if (src->pin_threads) {
+    cpu_set_t set;
+    guint cpu = worker->index % g_get_num_processors ();
+
+    CPU_ZERO (&set);
+    CPU_SET (cpu, &set);
+    if (sched_setaffinity (0, sizeof (set), &set) != 0)
+      GST_WARNING_OBJECT (src, "could not pin reader thread %u to cpu %u: %s",
+          worker->index, cpu, g_strerror (errno));
+    else
+      GST_DEBUG_OBJECT (src, "pinned reader thread %u to cpu %u",
+          worker->index, cpu);
+  }
+#endif
+
+  while (TRUE) {
+    GstBuffer *outbuf;
+    GError *err = NULL;
+
+    if (!g_socket_condition_wait (worker->socket, G_IO_IN | G_IO_PRI,
+            worker->cancellable, &err))
+      goto stopped;
+
+    outbuf = gst_udpsrc_worker_receive (worker, &err);
+    if (err) {
+      if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        goto stopped;
+
+      /* same as in gst_udpsrc_create(), port unreachable is not fatal */
+      if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_HOST_UNREACHABLE))
+        goto receive_error;
+
+      g_clear_error (&err);
+    }
+
+    if (outbuf == NULL)
+      continue;
+
+    g_mutex_lock (&src->queue_lock);
+    if (G_LIKELY (src->queue.length < MAX_QUEUED_PACKETS)) {
+      g_queue_push_tail (&src->queue, outbuf);
+      g_cond_signal (&src->queue_cond);
+    } else {
+      GST_DEBUG_OBJECT (src, "queue full, dropping packet");
+      gst_buffer_unref (outbuf);
+    }
+    g_mutex_unlock (&src->queue_lock);
+  }
+
+  /* ERRORS */
+stopped:
+  {
+    GST_DEBUG_OBJECT (src, "reader thread %u stopped", worker->index);
+    return NULL;
+  }
+receive_error:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+        ("receive error: %s", err->message));
+    g_clear_error (&err);
+    return NULL;
+  }
+}
+
+static GSocket *
+gst_udpsrc_open_reuseport_socket (GstUDPSrc * src, GError ** err)
+{
+  GSocketAddress *bind_saddr;
+  GInetAddress *addr;
+  GSocket *socket;
+  gint val = 1;
+
+  addr = g_inet_socket_address_get_address (src->addr);
+
+  socket = g_socket_new (g_inet_address_get_family (addr),
+      G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, err);
+  if (socket == NULL)
+    return NULL;
+
+  if (setsockopt (g_socket_get_fd (socket), SOL_SOCKET, SO_REUSEPORT,
+          (void *) &val, sizeof (val)) != 0)
+    goto failed;
+
+  bind_saddr = g_inet_socket_address_new (addr, src->port);
+  if (!g_socket_bind (socket, bind_saddr, src->reuse, err)) {
+    g_object_unref (bind_saddr);
+    g_object_unref (socket);
+    return NULL;
+  }
+  g_object_unref (bind_saddr);
+
+  if (src->buffer_size != 0) {
+    val = src->buffer_size;
+    if (setsockopt (g_socket_get_fd (socket), SOL_SOCKET, SO_RCVBUF,
+            (void *) &val, sizeof (val)) != 0)
+      GST_WARNING_OBJECT (src, "could not set udp buffer of %d bytes: %s",
+          src->buffer_size, g_strerror (errno));
+  }
+
+  g_socket_set_broadcast (socket, TRUE);
+
+  if (src->auto_multicast && g_inet_address_get_is_multicast (addr)) {
+    if (!g_socket_join_multicast_group (socket, addr, FALSE, src->multi_iface,
+            err)) {
+      g_object_unref (socket);
+      return NULL;
+    }
+  }
+
+  return socket;
+
+failed:
+  {
+    g_set_error (err, G_IO_ERROR, g_io_error_from_errno (errno),
+        "could not set SO_REUSEPORT: %s", g_strerror (errno));
+    g_object_unref (socket);
+    return NULL;
+  }
+}
+
+static void
+gst_udpsrc_worker_free (GstUDPSrcWorker * worker)
+{
+  GstUDPSrc *src = worker->src;
+
+  g_cancellable_cancel (worker->cancellable);
+  if (worker->thread)
+    g_thread_join (worker->thread);
+
+  if (worker->socket != src->used_socket) {
+    if (src->auto_multicast
+        && g_inet_address_get_is_multicast (g_inet_socket_address_get_address
+            (src->addr)))
+      g_socket_leave_multicast_group (worker->socket,
+          g_inet_socket_address_get_address (src->addr), FALSE,
+          src->multi_iface, NULL);
+    g_socket_close (worker->socket, NULL);
+  }
+  g_object_unref (worker->socket);
+  g_object_unref (worker->cancellable);
+  g_slice_free (GstUDPSrcWorker, worker);
+}
+
+/* open reader_threads - 1 more sockets on the port of used_socket and start
+ * a reader thread for each of them and for used_socket */
+static gboolean
+gst_udpsrc_start_workers (GstUDPSrc * src)
+{
+  GError *err = NULL;
+  guint i;
+
+  src->workers = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_udpsrc_worker_free);
+  src->queue_flushing = FALSE;
+
+  for (i = 0; i < src->reader_threads; i++) {
+    GstUDPSrcWorker *worker;
+    GSocket *socket;
+    gchar *name;
+
+    if (i == 0) {
+      socket = g_object_ref (src->used_socket);
+    } else {
+      socket = gst_udpsrc_open_reuseport_socket (src, &err);
+      if (socket == NULL)
+        goto socket_failed;
+    }
+
+    worker = g_slice_new0 (GstUDPSrcWorker);
+    worker->src = src;
+    worker->index = i;
+    worker->socket = socket;
+    worker->cancellable = g_cancellable_new ();
+    g_ptr_array_add (src->workers, worker);
+
+    name = g_strdup_printf ("udpsrc-reader-%u", i);
+    worker->thread = g_thread_try_new (name,
+        (GThreadFunc) gst_udpsrc_worker_thread, worker, &err);
+    g_free (name);
+    if (worker->thread == NULL)
+      goto thread_failed;
+  }
+
+  GST_DEBUG_OBJECT (src, "started %u reader threads on port %d",
+      src->reader_threads, src->port);
+
+  return TRUE;
+
+  /* ERRORS */
+socket_failed:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, SETTINGS, (NULL),
+        ("could not open reader socket %u: %s", i, err->message));
+    g_clear_error (&err);
+    return FALSE;
+  }
+thread_failed:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, FAILED, (NULL),
+        ("could not start reader thread %u: %s", i, err->message));
+    g_clear_error (&err);
+    return FALSE;
+  }
+}
+
+static void
+gst_udpsrc_stop_workers (GstUDPSrc * src)
+{
+  if (src->workers) {
+    g_ptr_array_free (src->workers, TRUE);
+    src->workers = NULL;
+  }
+
+  g_mutex_lock (&src->queue_lock);
+  g_queue_foreach (&src->queue, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&src->queue);
+  g_mutex_unlock (&src->queue_lock);
+}
+
+/* pop the next packet queued by the reader threads */
+static GstFlowReturn
+gst_udpsrc_create_from_workers (GstUDPSrc * udpsrc, GstBuffer ** buf)
+{
+  g_mutex_lock (&udpsrc->queue_lock);
+  while (g_queue_is_empty (&udpsrc->queue)) {
+    if (udpsrc->queue_flushing)
+      goto flushing;
+
+    if (udpsrc->timeout) {
+      gint64 end_time = g_get_monotonic_time () + udpsrc->timeout / 1000;
+
+      if (!g_cond_wait_until (&udpsrc->queue_cond, &udpsrc->queue_lock,
+              end_time) && g_queue_is_empty (&udpsrc->queue)
+          && !udpsrc->queue_flushing) {
+        g_mutex_unlock (&udpsrc->queue_lock);
+        /* timeout, post element message */
+        gst_element_post_message (GST_ELEMENT_CAST (udpsrc),
+            gst_message_new_element (GST_OBJECT_CAST (udpsrc),
+                gst_structure_new ("GstUDPSrcTimeout",
+                    "timeout", G_TYPE_UINT64, udpsrc->timeout, NULL)));
+        g_mutex_lock (&udpsrc->queue_lock);
+      }
+    } else {
+      g_cond_wait (&udpsrc->queue_cond, &udpsrc->queue_lock);
+    }
+  }
+  *buf = g_queue_pop_head (&udpsrc->queue);
+  g_mutex_unlock (&udpsrc->queue_lock);
+
+  return GST_FLOW_OK;
+
+flushing:
+  {
+    GST_DEBUG_OBJECT (udpsrc, "we are flushing");
+    g_mutex_unlock (&udpsrc->queue_lock);
+    return GST_FLOW_FLUSHING;
+  }
+}
+#endif
+
+static GstFlowReturn
+gst_udpsrc_create (GstPushSrc * psrc, GstBuffer ** buf)
+{
+  GstFlowReturn ret;
+  GstUDPSrc *udpsrc;
+  GstBuffer *outbuf = NULL;
+  GstMapInfo info;
+  GSocketAddress *saddr = NULL;
+  gsize offset;
+  gssize readsize;
+  gssize res;
+  GError *err = NULL;
+
+  udpsrc = GST_UDPSRC_CAST (psrc);
+
+#ifdef HAVE_REUSEPORT_READERS
+  if (udpsrc->workers != NULL)
+    return gst_udpsrc_create_from_workers (udpsrc, buf);
+#endif
+
+#ifdef HAVE_RECVMMSG
+  if (udpsrc->batch != NULL)
+    return gst_udpsrc_create_batched (udpsrc, buf);
+#endif
+
+retry:
+  /* quick check, avoid going in select when we already have data */
+  readsize = g_socket_get_available_bytes (udpsrc->used_socket);
+  if (readsize > 0)
+    goto no_select;
+
+  if ((ret = gst_udpsrc_wait (udpsrc)) != GST_FLOW_OK)
+    return ret;
+
   /* ask how much is available for reading on the socket, this should be exactly
    * one UDP packet. We will check the return value, though, because in some
    * case it can return 0 and we don't want a 0 sized buffer. */
@@ -536,19 +1540,6 @@ no_select:
   return ret;
 
   /* ERRORS */
-select_error:
-  {
-    GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
-        ("select error: %s", err->message));
-    g_clear_error (&err);
-    return GST_FLOW_ERROR;
-  }
-stopped:
-  {
-    GST_DEBUG ("stop called");
-    g_clear_error (&err);
-    return GST_FLOW_FLUSHING;
-  }
 get_available_error:
   {
     GST_ELEMENT_ERROR (udpsrc, RESOURCE, READ, (NULL),
@@ -717,6 +1708,24 @@ gst_udpsrc_set_property (GObject * object, guint prop_id, const GValue * value,
     case PROP_REUSE:
       udpsrc->reuse = g_value_get_boolean (value);
       break;
+    case PROP_BATCH_SIZE:
+      udpsrc->batch_size = g_value_get_uint (value);
+      break;
+    case PROP_MTU:
+      udpsrc->mtu = g_value_get_uint (value);
+      break;
+    case PROP_READER_THREADS:
+      udpsrc->reader_threads = g_value_get_uint (value);
+      break;
+    case PROP_PIN_THREADS:
+      udpsrc->pin_threads = g_value_get_boolean (value);
+      break;
+    case PROP_KERNEL_TIMESTAMPS:
+      udpsrc->kernel_timestamps = g_value_get_boolean (value);
+      break;
+    case PROP_GRO:
+      udpsrc->gro = g_value_get_boolean (value);
+      break;
     default:
       break;
   }
@@ -771,6 +1780,24 @@ gst_udpsrc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_REUSE:
       g_value_set_boolean (value, udpsrc->reuse);
       break;
+    case PROP_BATCH_SIZE:
+      g_value_set_uint (value, udpsrc->batch_size);
+      break;
+    case PROP_MTU:
+      g_value_set_uint (value, udpsrc->mtu);
+      break;
+    case PROP_READER_THREADS:
+      g_value_set_uint (value, udpsrc->reader_threads);
+      break;
+    case PROP_PIN_THREADS:
+      g_value_set_boolean (value, udpsrc->pin_threads);
+      break;
+    case PROP_KERNEL_TIMESTAMPS:
+      g_value_set_boolean (value, udpsrc->kernel_timestamps);
+      break;
+    case PROP_GRO:
+      g_value_set_boolean (value, udpsrc->gro);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -872,6 +1899,17 @@ gst_udpsrc_open (GstUDPSrc * src)
 
     bind_saddr = g_inet_socket_address_new (bind_addr, src->port);
     g_object_unref (bind_addr);
+#ifdef HAVE_REUSEPORT_READERS
+    if (src->reader_threads > 1) {
+      gint val = 1;
+
+      /* all reader sockets need SO_REUSEPORT before binding */
+      if (setsockopt (g_socket_get_fd (src->used_socket), SOL_SOCKET,
+              SO_REUSEPORT, (void *) &val, sizeof (val)) != 0)
+        GST_WARNING_OBJECT (src, "could not set SO_REUSEPORT: %s",
+            g_strerror (errno));
+    }
+#endif
     if (!g_socket_bind (src->used_socket, bind_saddr, src->reuse, &err))
       goto bind_error;
 
@@ -1000,6 +2038,41 @@ gst_udpsrc_open (GstUDPSrc * src)
     g_object_unref (addr);
   }
 
+  if (src->reader_threads > 1) {
+#ifdef HAVE_REUSEPORT_READERS
+    if (src->external_socket) {
+      GST_WARNING_OBJECT (src, "not starting reader threads for a provided "
+          "socket");
+    } else {
+      if (src->kernel_timestamps)
+        GST_WARNING_OBJECT (src, "kernel timestamps are not used with "
+            "reader threads");
+      if (src->gro)
+        GST_WARNING_OBJECT (src, "GRO is not used with reader threads");
+      if (!gst_udpsrc_start_workers (src)) {
+        gst_udpsrc_close (src);
+        return FALSE;
+      }
+      return TRUE;
+    }
+#else
+    GST_WARNING_OBJECT (src, "SO_REUSEPORT is not supported on this platform");
+#endif
+  }
+
+  /* kernel timestamps and GRO are only handled by the recvmmsg() reader */
+  if (src->batch_size > 1 || src->kernel_timestamps || src->gro) {
+#ifdef HAVE_RECVMMSG
+    if (!gst_udpsrc_batch_setup (src)) {
+      gst_udpsrc_close (src);
+      return FALSE;
+    }
+#else
+    GST_WARNING_OBJECT (src, "batched reception is not supported on this "
+        "platform, reading packets one by one");
+#endif
+  }
+
   return TRUE;
 
   /* ERRORS */
@@ -1052,6 +2125,11 @@ gst_udpsrc_unlock (GstBaseSrc * bsrc)
   GST_LOG_OBJECT (src, "Flushing");
   g_cancellable_cancel (src->cancellable);
 
+  g_mutex_lock (&src->queue_lock);
+  src->queue_flushing = TRUE;
+  g_cond_broadcast (&src->queue_cond);
+  g_mutex_unlock (&src->queue_lock);
+
   return TRUE;
 }
 
@@ -1065,6 +2143,10 @@ gst_udpsrc_unlock_stop (GstBaseSrc * bsrc)
   GST_LOG_OBJECT (src, "No longer flushing");
   g_cancellable_reset (src->cancellable);
 
+  g_mutex_lock (&src->queue_lock);
+  src->queue_flushing = FALSE;
+  g_mutex_unlock (&src->queue_lock);
+
   return TRUE;
 }
 
@@ -1073,6 +2155,14 @@ gst_udpsrc_close (GstUDPSrc * src)
 {
   GST_DEBUG ("closing sockets");
 
+#ifdef HAVE_REUSEPORT_READERS
+  gst_udpsrc_stop_workers (src);
+#endif
+
+#ifdef HAVE_RECVMMSG
+  gst_udpsrc_batch_free (src);
+#endif
+
   if (src->used_socket) {
     if (src->auto_multicast
         &&
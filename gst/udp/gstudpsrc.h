@@ -43,6 +43,8 @@ G_BEGIN_DECLS
 
 typedef struct _GstUDPSrc GstUDPSrc;
 typedef struct _GstUDPSrcClass GstUDPSrcClass;
+typedef struct _GstUDPSrcBatch GstUDPSrcBatch;
+typedef struct _GstUDPSrcWorker GstUDPSrcWorker;
 
 struct _GstUDPSrc {
   GstPushSrc parent;
@@ -60,6 +62,12 @@ struct _GstUDPSrc {
   gboolean   close_socket;
   gboolean   auto_multicast;
   gboolean   reuse;
+  guint      batch_size;
+  guint      mtu;
+  guint      reader_threads;
+  gboolean   pin_threads;
+  gboolean   kernel_timestamps;
+  gboolean   gro;
 
   /* our sockets */
   GSocket   *used_socket;
@@ -67,6 +75,18 @@ struct _GstUDPSrc {
   GInetSocketAddress *addr;
   gboolean   external_socket;
 
+  /* batched reception, NULL when reading packets one by one */
+  GstBufferPool  *pool;
+  GstUDPSrcBatch *batch;
+
+  /* SO_REUSEPORT reader threads, each with its own socket, pushing into a
+   * shared queue that create() pops from */
+  GPtrArray *workers;
+  GMutex     queue_lock;
+  GCond      queue_cond;
+  GQueue     queue;
+  gboolean   queue_flushing;
+
   gchar     *uri;
 };
 
@@ -46,6 +46,10 @@
  * If you use autocrop there is little point in setting the other
  * properties manually because they will be overriden if the caps change,
  * but nothing stops you from doing so.
+ *
+ * If the element only crops, without changing the format or the alpha
+ * value, and downstream supports #GstVideoMeta and #GstVideoCropMeta, the
+ * input buffers are passed on with a crop meta instead of being copied.
  * 
  * Sample pipeline:
  * |[
@@ -2423,6 +2427,10 @@ static gboolean gst_video_box_set_info (GstVideoFilter * vfilter, GstCaps * in,
     GstVideoInfo * in_info, GstCaps * out, GstVideoInfo * out_info);
 static GstFlowReturn gst_video_box_transform_frame (GstVideoFilter * vfilter,
     GstVideoFrame * in_frame, GstVideoFrame * out_frame);
+static gboolean gst_video_box_decide_allocation (GstBaseTransform * trans,
+    GstQuery * query);
+static GstFlowReturn gst_video_box_transform_ip (GstBaseTransform * trans,
+    GstBuffer * buf);
 
 #define GST_TYPE_VIDEO_BOX_FILL (gst_video_box_fill_get_type())
 static GType
@@ -2515,11 +2523,16 @@ gst_video_box_class_init (GstVideoBoxClass * klass)
   trans_class->transform_caps =
       GST_DEBUG_FUNCPTR (gst_video_box_transform_caps);
   trans_class->src_event = GST_DEBUG_FUNCPTR (gst_video_box_src_event);
+  trans_class->decide_allocation =
+      GST_DEBUG_FUNCPTR (gst_video_box_decide_allocation);
 
   vfilter_class->set_info = GST_DEBUG_FUNCPTR (gst_video_box_set_info);
   vfilter_class->transform_frame =
       GST_DEBUG_FUNCPTR (gst_video_box_transform_frame);
 
+  /* only used when cropping with metas, set after the video filter's */
+  trans_class->transform_ip = GST_DEBUG_FUNCPTR (gst_video_box_transform_ip);
+
   gst_element_class_set_static_metadata (element_class, "Video box filter",
       "Filter/Effect/Video",
       "Resizes a video by adding borders or cropping",
@@ -3164,6 +3177,9 @@ gst_video_box_set_info (GstVideoFilter * vfilter, GstCaps * in,
 
   if (ret)
     ret = gst_video_box_select_processing_functions (video_box);
+
+  /* copy until decide_allocation found out downstream supports crop meta */
+  gst_base_transform_set_in_place (GST_BASE_TRANSFORM_CAST (video_box), FALSE);
   g_mutex_unlock (&video_box->mutex);
 
   return ret;
@@ -3321,6 +3337,89 @@ gst_video_box_transform_frame (GstVideoFilter * vfilter,
   return GST_FLOW_OK;
 }
 
+/* Whether the output is just a region of the input, which can be described
+ * with a crop meta */
+static gboolean
+gst_video_box_is_pure_crop (GstVideoBox * video_box)
+{
+  const GstVideoFormatInfo *finfo;
+
+  if (video_box->in_format != video_box->out_format ||
+      video_box->in_sdtv != video_box->out_sdtv)
+    return FALSE;
+
+  if (video_box->box_left < 0 || video_box->box_right < 0 ||
+      video_box->box_top < 0 || video_box->box_bottom < 0)
+    return FALSE;
+
+  if (video_box->box_left + video_box->box_right >= video_box->in_width ||
+      video_box->box_top + video_box->box_bottom >= video_box->in_height)
+    return FALSE;
+
+  finfo = gst_video_format_get_info (video_box->in_format);
+  return video_box->alpha >= 1.0 || !GST_VIDEO_FORMAT_INFO_HAS_ALPHA (finfo);
+}
+
+static gboolean
+gst_video_box_decide_allocation (GstBaseTransform * trans, GstQuery * query)
+{
+  GstVideoBox *video_box = GST_VIDEO_BOX (trans);
+  gboolean pure_crop;
+
+  g_mutex_lock (&video_box->mutex);
+  pure_crop = gst_video_box_is_pure_crop (video_box);
+  g_mutex_unlock (&video_box->mutex);
+
+  if (pure_crop &&
+      gst_query_find_allocation_meta (query, GST_VIDEO_CROP_META_API_TYPE,
+          NULL)
+      && gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE,
+          NULL)) {
+    GST_INFO_OBJECT (video_box, "downstream supports crop meta, not copying");
+    gst_base_transform_set_in_place (trans, TRUE);
+
+    /* the input buffers are pushed, don't allocate any */
+    while (gst_query_get_n_allocation_pools (query) > 0)
+      gst_query_remove_nth_allocation_pool (query, 0);
+
+    return TRUE;
+  }
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->decide_allocation (trans,
+      query);
+}
+
+/* Crops without touching the data, see gst_video_box_decide_allocation() */
+static GstFlowReturn
+gst_video_box_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
+{
+  GstVideoBox *video_box = GST_VIDEO_BOX (trans);
+  GstVideoFilter *vfilter = GST_VIDEO_FILTER (trans);
+  GstVideoInfo *info = &vfilter->in_info;
+  GstVideoCropMeta *crop_meta;
+
+  if (!gst_buffer_get_video_meta (buf)) {
+    gst_buffer_add_video_meta_full (buf, GST_VIDEO_FRAME_FLAG_NONE,
+        GST_VIDEO_INFO_FORMAT (info), GST_VIDEO_INFO_WIDTH (info),
+        GST_VIDEO_INFO_HEIGHT (info), GST_VIDEO_INFO_N_PLANES (info),
+        info->offset, info->stride);
+  }
+
+  /* upstream might have cropped already, ours is relative to that */
+  crop_meta = gst_buffer_get_video_crop_meta (buf);
+  if (!crop_meta)
+    crop_meta = gst_buffer_add_video_crop_meta (buf);
+
+  g_mutex_lock (&video_box->mutex);
+  crop_meta->x += video_box->box_left;
+  crop_meta->y += video_box->box_top;
+  crop_meta->width = video_box->out_width;
+  crop_meta->height = video_box->out_height;
+  g_mutex_unlock (&video_box->mutex);
+
+  return GST_FLOW_OK;
+}
+
 /* FIXME: 0.11 merge with videocrop plugin */
 static gboolean
 plugin_init (GstPlugin * plugin)
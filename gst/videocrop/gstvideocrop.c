@@ -33,6 +33,11 @@
  *
  * If there is nothing to crop, the element will operate in pass-through mode.
  *
+ * If downstream supports #GstVideoMeta and #GstVideoCropMeta, the picture is
+ * not copied at all. The input buffers are pushed with a crop meta that
+ * describes the visible region instead. A copy is only made if downstream
+ * can not handle these metas.
+ *
  * Note that no special efforts are made to handle chroma-subsampled formats
  * in the case of odd-valued cropping and compensate for sub-unit chroma plane
  * shifts for such formats in the case where the #GstVideoCrop:left or
@@ -47,12 +52,6 @@
  * </refsect2>
  */
 
-/* TODO:
- *  - for packed formats, we could avoid memcpy() in case crop_left
- *    and crop_right are 0 and just create a sub-buffer of the input
- *    buffer
- */
-
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
@@ -115,6 +114,10 @@ static gboolean gst_video_crop_set_info (GstVideoFilter * vfilter, GstCaps * in,
     GstVideoInfo * in_info, GstCaps * out, GstVideoInfo * out_info);
 static GstFlowReturn gst_video_crop_transform_frame (GstVideoFilter * vfilter,
     GstVideoFrame * in_frame, GstVideoFrame * out_frame);
+static gboolean gst_video_crop_decide_allocation (GstBaseTransform * trans,
+    GstQuery * query);
+static GstFlowReturn gst_video_crop_transform_ip (GstBaseTransform * trans,
+    GstBuffer * buf);
 
 static gboolean
 gst_video_crop_src_event (GstBaseTransform * trans, GstEvent * event)
@@ -209,10 +212,16 @@ gst_video_crop_class_init (GstVideoCropClass * klass)
   basetransform_class->transform_caps =
       GST_DEBUG_FUNCPTR (gst_video_crop_transform_caps);
   basetransform_class->src_event = GST_DEBUG_FUNCPTR (gst_video_crop_src_event);
+  basetransform_class->decide_allocation =
+      GST_DEBUG_FUNCPTR (gst_video_crop_decide_allocation);
 
   vfilter_class->set_info = GST_DEBUG_FUNCPTR (gst_video_crop_set_info);
   vfilter_class->transform_frame =
       GST_DEBUG_FUNCPTR (gst_video_crop_transform_frame);
+
+  /* only used when cropping with metas, set after the video filter's */
+  basetransform_class->transform_ip =
+      GST_DEBUG_FUNCPTR (gst_video_crop_transform_ip);
 }
 
 static void
@@ -444,6 +453,65 @@ gst_video_crop_transform_frame (GstVideoFilter * vfilter,
   return GST_FLOW_OK;
 }
 
+/* Crops without touching the data: the input buffer is passed on with a
+ * video meta describing the full input frame and a crop meta selecting the
+ * output region of it */
+static GstFlowReturn
+gst_video_crop_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
+{
+  GstVideoCrop *vcrop = GST_VIDEO_CROP (trans);
+  GstVideoFilter *vfilter = GST_VIDEO_FILTER (trans);
+  GstVideoInfo *info = &vfilter->in_info;
+  GstVideoCropMeta *crop_meta;
+
+  if (!gst_buffer_get_video_meta (buf)) {
+    gst_buffer_add_video_meta_full (buf, GST_VIDEO_FRAME_FLAG_NONE,
+        GST_VIDEO_INFO_FORMAT (info), GST_VIDEO_INFO_WIDTH (info),
+        GST_VIDEO_INFO_HEIGHT (info), GST_VIDEO_INFO_N_PLANES (info),
+        info->offset, info->stride);
+  }
+
+  /* upstream might have cropped already, ours is relative to that */
+  crop_meta = gst_buffer_get_video_crop_meta (buf);
+  if (!crop_meta)
+    crop_meta = gst_buffer_add_video_crop_meta (buf);
+
+  g_mutex_lock (&vcrop->lock);
+  crop_meta->x += vcrop->crop_left;
+  crop_meta->y += vcrop->crop_top;
+  crop_meta->width = GST_VIDEO_INFO_WIDTH (&vfilter->out_info);
+  crop_meta->height = GST_VIDEO_INFO_HEIGHT (&vfilter->out_info);
+  g_mutex_unlock (&vcrop->lock);
+
+  GST_LOG_OBJECT (vcrop, "cropping to %ux%u at %u,%u", crop_meta->width,
+      crop_meta->height, crop_meta->x, crop_meta->y);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_video_crop_decide_allocation (GstBaseTransform * trans, GstQuery * query)
+{
+  GstVideoCrop *crop = GST_VIDEO_CROP (trans);
+
+  if (gst_query_find_allocation_meta (query, GST_VIDEO_CROP_META_API_TYPE,
+          NULL)
+      && gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE,
+          NULL)) {
+    GST_INFO_OBJECT (crop, "downstream supports crop meta, not copying");
+    gst_base_transform_set_in_place (trans, TRUE);
+
+    /* the input buffers are pushed, don't allocate any */
+    while (gst_query_get_n_allocation_pools (query) > 0)
+      gst_query_remove_nth_allocation_pool (query, 0);
+
+    return TRUE;
+  }
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->decide_allocation (trans,
+      query);
+}
+
 static gint
 gst_video_crop_transform_dimension (gint val, gint delta)
 {
@@ -675,6 +743,8 @@ gst_video_crop_set_info (GstVideoFilter * vfilter, GstCaps * in,
     GST_LOG_OBJECT (crop, "we are not using passthrough");
     gst_base_transform_set_passthrough (GST_BASE_TRANSFORM (crop), FALSE);
   }
+  /* copy until decide_allocation found out downstream supports crop meta */
+  gst_base_transform_set_in_place (GST_BASE_TRANSFORM (crop), FALSE);
 
   if (GST_VIDEO_INFO_IS_RGB (in_info)
       || GST_VIDEO_INFO_IS_GRAY (in_info)) {
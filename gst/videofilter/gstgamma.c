@@ -51,6 +51,7 @@
 #endif
 
 #include "gstgamma.h"
+#include "gstvideolut.h"
 #include <string.h>
 #include <math.h>
 
@@ -101,8 +102,12 @@ static GstFlowReturn gst_gamma_transform_frame_ip (GstVideoFilter * vfilter,
 static void gst_gamma_before_transform (GstBaseTransform * transform,
     GstBuffer * buf);
 
+static gboolean gst_gamma_propose_allocation (GstBaseTransform * trans,
+    GstQuery * decide_query, GstQuery * query);
+
 static void gst_gamma_calculate_tables (GstGamma * gamma);
 
+#define gst_gamma_parent_class parent_class
 G_DEFINE_TYPE (GstGamma, gst_gamma, GST_TYPE_VIDEO_FILTER);
 
 static void
@@ -135,6 +140,8 @@ gst_gamma_class_init (GstGammaClass * g_class)
   trans_class->before_transform =
       GST_DEBUG_FUNCPTR (gst_gamma_before_transform);
   trans_class->transform_ip_on_passthrough = FALSE;
+  trans_class->propose_allocation =
+      GST_DEBUG_FUNCPTR (gst_gamma_propose_allocation);
 
   vfilter_class->set_info = GST_DEBUG_FUNCPTR (gst_gamma_set_info);
   vfilter_class->transform_frame_ip =
@@ -197,17 +204,18 @@ gst_gamma_calculate_tables (GstGamma * gamma)
   gdouble exp;
   gboolean passthrough = FALSE;
 
+  /* the table is also needed for passthrough, to apply the luma tables of
+   * upstream that our downstream can not take */
   GST_OBJECT_LOCK (gamma);
-  if (gamma->gamma == 1.0) {
+  if (gamma->gamma == 1.0)
     passthrough = TRUE;
-  } else {
-    exp = 1.0 / gamma->gamma;
-    for (n = 0; n < 256; n++) {
-      val = n / 255.0;
-      val = pow (val, exp);
-      val = 255.0 * val;
-      gamma->gamma_table[n] = (guint8) floor (val + 0.5);
-    }
+
+  exp = 1.0 / gamma->gamma;
+  for (n = 0; n < 256; n++) {
+    val = n / 255.0;
+    val = pow (val, exp);
+    val = 255.0 * val;
+    gamma->gamma_table[n] = (guint8) floor (val + 0.5);
   }
   GST_OBJECT_UNLOCK (gamma);
 
@@ -215,11 +223,11 @@ gst_gamma_calculate_tables (GstGamma * gamma)
 }
 
 static void
-gst_gamma_planar_yuv_ip (GstGamma * gamma, GstVideoFrame * frame)
+gst_gamma_planar_yuv_ip (GstGamma * gamma, const guint8 * table,
+    GstVideoFrame * frame)
 {
   gint i, j, height;
   gint width, stride, row_wrap;
-  const guint8 *table = gamma->gamma_table;
   guint8 *data;
 
   data = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
@@ -238,12 +246,12 @@ gst_gamma_planar_yuv_ip (GstGamma * gamma, GstVideoFrame * frame)
 }
 
 static void
-gst_gamma_packed_yuv_ip (GstGamma * gamma, GstVideoFrame * frame)
+gst_gamma_packed_yuv_ip (GstGamma * gamma, const guint8 * table,
+    GstVideoFrame * frame)
 {
   gint i, j, height;
   gint width, stride, row_wrap;
   gint pixel_stride;
-  const guint8 *table = gamma->gamma_table;
   guint8 *data;
 
   data = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
@@ -277,12 +285,12 @@ static const gint cog_rgb_to_ycbcr_matrix_8bit_sdtv[] = {
 #define APPLY_MATRIX(m,o,v1,v2,v3) ((m[o*4] * v1 + m[o*4+1] * v2 + m[o*4+2] * v3 + m[o*4+3]) >> 8)
 
 static void
-gst_gamma_packed_rgb_ip (GstGamma * gamma, GstVideoFrame * frame)
+gst_gamma_packed_rgb_ip (GstGamma * gamma, const guint8 * table,
+    GstVideoFrame * frame)
 {
   gint i, j, height;
   gint width, stride, row_wrap;
   gint pixel_stride;
-  const guint8 *table = gamma->gamma_table;
   gint offsets[3];
   gint r, g, b;
   gint y, u, v;
@@ -366,6 +374,10 @@ gst_gamma_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
       goto invalid_caps;
       break;
   }
+
+  gamma->lut_downstream = FALSE;
+  gamma->lut_query_pending = TRUE;
+
   return TRUE;
 
   /* ERRORS */
@@ -391,18 +403,56 @@ gst_gamma_before_transform (GstBaseTransform * base, GstBuffer * outbuf)
 
   if (GST_CLOCK_TIME_IS_VALID (stream_time))
     gst_object_sync_values (GST_OBJECT (gamma), stream_time);
+
+  /* downstream is only asked once it got our caps */
+  if (gamma->lut_query_pending) {
+    gamma->lut_downstream = gst_video_luma_lut_query_downstream (base);
+    gamma->lut_query_pending = FALSE;
+  }
+
+  /* a luma table of upstream has to be applied by us if downstream can not
+   * take it */
+  if (gst_base_transform_is_passthrough (base) && !gamma->lut_downstream
+      && gst_buffer_get_video_luma_lut_meta (outbuf))
+    gst_base_transform_set_passthrough (base, FALSE);
+  else if (!gst_base_transform_is_passthrough (base) && gamma->gamma == 1.0
+      && (gamma->lut_downstream
+          || !gst_buffer_get_video_luma_lut_meta (outbuf)))
+    gst_base_transform_set_passthrough (base, TRUE);
+}
+
+static gboolean
+gst_gamma_propose_allocation (GstBaseTransform * trans,
+    GstQuery * decide_query, GstQuery * query)
+{
+  if (!GST_BASE_TRANSFORM_CLASS (parent_class)->propose_allocation (trans,
+          decide_query, query))
+    return FALSE;
+
+  gst_video_luma_lut_propose (query);
+
+  return TRUE;
 }
 
 static GstFlowReturn
 gst_gamma_transform_frame_ip (GstVideoFilter * vfilter, GstVideoFrame * frame)
 {
   GstGamma *gamma = GST_GAMMA (vfilter);
+  const guint8 *table;
 
   if (!gamma->process)
     goto not_negotiated;
 
   GST_OBJECT_LOCK (gamma);
-  gamma->process (gamma, frame);
+  table = gamma->gamma_table;
+  if (gamma->process != gst_gamma_packed_rgb_ip && gamma->lut_downstream) {
+    /* only a luma table, leave it to downstream */
+    gst_video_luma_lut_defer (frame->buffer, table);
+  } else {
+    if (gst_video_luma_lut_take (frame->buffer, table, gamma->fused_table))
+      table = gamma->fused_table;
+    gamma->process (gamma, table, frame);
+  }
   GST_OBJECT_UNLOCK (gamma);
 
   return GST_FLOW_OK;
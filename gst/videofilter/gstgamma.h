@@ -59,8 +59,13 @@ struct _GstGamma
 
   /* tables */
   guint8 gamma_table[256];
+  guint8 fused_table[256];
 
-  void (*process) (GstGamma *gamma, GstVideoFrame *frame);
+  /* the next element composes the table instead of us applying it */
+  gboolean lut_downstream;
+  gboolean lut_query_pending;
+
+  void (*process) (GstGamma *gamma, const guint8 *table, GstVideoFrame *frame);
 };
 
 struct _GstGammaClass
@@ -47,10 +47,16 @@
 #include <gst/math-compat.h>
 
 #include "gstvideobalance.h"
+#include "gstvideolut.h"
 #include <string.h>
 
 #include <gst/video/colorbalance.h>
 
+#if defined(__SSE2__)
+#define HAVE_VIDEO_BALANCE_SSE2 1
+#include <emmintrin.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (videobalance_debug);
 #define GST_CAT_DEFAULT videobalance_debug
 
@@ -59,6 +65,7 @@ GST_DEBUG_CATEGORY_STATIC (videobalance_debug);
 #define DEFAULT_PROP_BRIGHTNESS		0.0
 #define DEFAULT_PROP_HUE		0.0
 #define DEFAULT_PROP_SATURATION		1.0
+#define DEFAULT_PROP_N_THREADS		1
 
 enum
 {
@@ -66,7 +73,8 @@ enum
   PROP_CONTRAST,
   PROP_BRIGHTNESS,
   PROP_HUE,
-  PROP_SATURATION
+  PROP_SATURATION,
+  PROP_N_THREADS
 };
 
 static GstStaticPadTemplate gst_video_balance_src_template =
@@ -96,6 +104,8 @@ static void gst_video_balance_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_video_balance_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
+static gboolean gst_video_balance_propose_allocation (GstBaseTransform *
+    trans, GstQuery * decide_query, GstQuery * query);
 
 #define gst_video_balance_parent_class parent_class
 G_DEFINE_TYPE_WITH_CODE (GstVideoBalance, gst_video_balance,
@@ -105,44 +115,35 @@ G_DEFINE_TYPE_WITH_CODE (GstVideoBalance, gst_video_balance,
 
 /*
  * look-up tables (LUT).
+ *
+ * Luma is mapped with a table, which is computed with the same fixed point
+ * arithmetic that the SIMD code uses. Chroma is transformed with a 2x2
+ * matrix in 4.12 fixed point.
  */
 static void
 gst_video_balance_update_tables (GstVideoBalance * vb)
 {
-  gint i, j;
-  gdouble y, u, v, hue_cos, hue_sin;
+  gint i, y;
+  gdouble hue_cos, hue_sin;
 
   /* Y */
+  vb->ymul = rint (vb->contrast * 8192);
+  vb->yadd = rint ((16 + vb->brightness * 255) * 16) + 8;
   for (i = 0; i < 256; i++) {
-    y = 16 + ((i - 16) * vb->contrast + vb->brightness * 255);
-    if (y < 0)
-      y = 0;
-    else if (y > 255)
-      y = 255;
-    vb->tabley[i] = rint (y);
+    y = (((((i - 16) * 128) * vb->ymul) >> 16) + vb->yadd) >> 4;
+    vb->tabley[i] = CLAMP (y, 0, 255);
   }
 
   hue_cos = cos (G_PI * vb->hue);
   hue_sin = sin (G_PI * vb->hue);
 
-  /* U/V lookup tables are 2D, since we need both U/V for each table
-   * separately. */
-  for (i = -128; i < 128; i++) {
-    for (j = -128; j < 128; j++) {
-      u = 128 + ((i * hue_cos + j * hue_sin) * vb->saturation);
-      v = 128 + ((-i * hue_sin + j * hue_cos) * vb->saturation);
-      if (u < 0)
-        u = 0;
-      else if (u > 255)
-        u = 255;
-      if (v < 0)
-        v = 0;
-      else if (v > 255)
-        v = 255;
-      vb->tableu[i + 128][j + 128] = rint (u);
-      vb->tablev[i + 128][j + 128] = rint (v);
-    }
-  }
+  /* U/V */
+  vb->uv_coeff[0] = rint (hue_cos * vb->saturation * 4096);
+  vb->uv_coeff[1] = rint (hue_sin * vb->saturation * 4096);
+  vb->uv_coeff[2] = -vb->uv_coeff[1];
+  vb->uv_coeff[3] = vb->uv_coeff[0];
+
+  vb->luma_only = vb->hue == 0.0 && vb->saturation == 1.0;
 }
 
 static gboolean
@@ -159,148 +160,331 @@ gst_video_balance_update_properties (GstVideoBalance * videobalance)
   gboolean passthrough;
   GstBaseTransform *base = GST_BASE_TRANSFORM (videobalance);
 
+  /* the tables are also needed for passthrough, to apply the luma tables
+   * of upstream that our downstream can not take */
   GST_OBJECT_LOCK (videobalance);
   passthrough = gst_video_balance_is_passthrough (videobalance);
-  if (!passthrough)
-    gst_video_balance_update_tables (videobalance);
+  gst_video_balance_update_tables (videobalance);
   GST_OBJECT_UNLOCK (videobalance);
 
   gst_base_transform_set_passthrough (base, passthrough);
 }
 
+#ifdef HAVE_VIDEO_BALANCE_SSE2
+/* multipliers of the first and second sample of the chroma pairs */
+#define CHROMA_COEFFS(a,b) _mm_setr_epi16 (a, b, a, b, a, b, a, b)
+
+static inline __m128i
+gst_video_balance_luma_sse2 (__m128i y, __m128i ymul, __m128i yadd)
+{
+  /* y holds 8 luma values as 16 bit words */
+  y = _mm_slli_epi16 (_mm_sub_epi16 (y, _mm_set1_epi16 (16)), 7);
+  y = _mm_add_epi16 (_mm_mulhi_epi16 (y, ymul), yadd);
+  return _mm_srai_epi16 (y, 4);
+}
+
+static inline __m128i
+gst_video_balance_chroma_sse2 (__m128i c, __m128i coeff1, __m128i coeff2)
+{
+  /* c holds 4 chroma pairs as 16 bit words, the result the 4 transformed
+   * pairs in the same order */
+  const __m128i offset = _mm_set1_epi32 ((128 << 12) + (1 << 11));
+  __m128i first, second, res;
+
+  c = _mm_sub_epi16 (c, _mm_set1_epi16 (128));
+  first = _mm_srai_epi32 (_mm_add_epi32 (_mm_madd_epi16 (c, coeff1), offset),
+      12);
+  second = _mm_srai_epi32 (_mm_add_epi32 (_mm_madd_epi16 (c, coeff2), offset),
+      12);
+  res = _mm_packs_epi32 (first, second);
+
+  return _mm_unpacklo_epi16 (res, _mm_unpackhi_epi64 (res, res));
+}
+#endif
+
+/* Applies the luma table to n consecutive bytes */
+static void
+gst_video_balance_luma_line (GstVideoBalance * vb, guint8 * y, gint n)
+{
+  const guint8 *tabley = vb->ytable;
+  gint x = 0;
+
+#ifdef HAVE_VIDEO_BALANCE_SSE2
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i ymul = _mm_set1_epi16 (vb->ymul);
+  const __m128i yadd = _mm_set1_epi16 (vb->yadd);
+  /* the SIMD code computes tabley, a fused table has to be looked up */
+  gint n_simd = tabley == vb->tabley ? n : 0;
+
+  for (; x + 16 <= n_simd; x += 16) {
+    __m128i v = _mm_loadu_si128 ((__m128i *) (y + x));
+    __m128i lo = gst_video_balance_luma_sse2 (_mm_unpacklo_epi8 (v, zero),
+        ymul, yadd);
+    __m128i hi = gst_video_balance_luma_sse2 (_mm_unpackhi_epi8 (v, zero),
+        ymul, yadd);
+
+    _mm_storeu_si128 ((__m128i *) (y + x), _mm_packus_epi16 (lo, hi));
+  }
+#endif
+
+  for (; x < n; x++)
+    y[x] = tabley[y[x]];
+}
+
+static inline void
+gst_video_balance_chroma (GstVideoBalance * vb, guint8 * u, guint8 * v)
+{
+  gint du = *u - 128, dv = *v - 128;
+  gint nu, nv;
+
+  nu = ((vb->uv_coeff[0] * du + vb->uv_coeff[1] * dv + (1 << 11)) >> 12) + 128;
+  nv = ((vb->uv_coeff[2] * du + vb->uv_coeff[3] * dv + (1 << 11)) >> 12) + 128;
+
+  *u = CLAMP (nu, 0, 255);
+  *v = CLAMP (nv, 0, 255);
+}
+
+/* Transforms n pairs of separate U and V samples */
+static void
+gst_video_balance_chroma_line (GstVideoBalance * vb, guint8 * u, guint8 * v,
+    gint n)
+{
+  gint x = 0;
+
+#ifdef HAVE_VIDEO_BALANCE_SSE2
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i mask = _mm_set1_epi16 (0xff);
+  const gint16 *c = vb->uv_coeff;
+  const __m128i coeff1 = CHROMA_COEFFS (c[0], c[1]);
+  const __m128i coeff2 = CHROMA_COEFFS (c[2], c[3]);
+
+  for (; x + 8 <= n; x += 8) {
+    __m128i uv = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((__m128i *) (u + x)),
+        _mm_loadl_epi64 ((__m128i *) (v + x)));
+    __m128i lo = gst_video_balance_chroma_sse2 (_mm_unpacklo_epi8 (uv, zero),
+        coeff1, coeff2);
+    __m128i hi = gst_video_balance_chroma_sse2 (_mm_unpackhi_epi8 (uv, zero),
+        coeff1, coeff2);
+
+    uv = _mm_packus_epi16 (lo, hi);
+    lo = _mm_and_si128 (uv, mask);
+    hi = _mm_srli_epi16 (uv, 8);
+    _mm_storel_epi64 ((__m128i *) (u + x), _mm_packus_epi16 (lo, lo));
+    _mm_storel_epi64 ((__m128i *) (v + x), _mm_packus_epi16 (hi, hi));
+  }
+#endif
+
+  for (; x < n; x++)
+    gst_video_balance_chroma (vb, u + x, v + x);
+}
+
+/* Transforms n interleaved chroma pairs, U first if swap is FALSE */
+static void
+gst_video_balance_chroma_pairs_line (GstVideoBalance * vb, guint8 * uv,
+    gint n, gboolean swap)
+{
+  gint upos = swap ? 1 : 0, vpos = swap ? 0 : 1;
+  gint x = 0;
+
+#ifdef HAVE_VIDEO_BALANCE_SSE2
+  const gint16 *c = vb->uv_coeff;
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i coeff1 = swap ?
+      CHROMA_COEFFS (c[3], c[2]) : CHROMA_COEFFS (c[0], c[1]);
+  const __m128i coeff2 = swap ?
+      CHROMA_COEFFS (c[1], c[0]) : CHROMA_COEFFS (c[2], c[3]);
+
+  for (; x + 8 <= n; x += 8) {
+    __m128i v = _mm_loadu_si128 ((__m128i *) (uv + 2 * x));
+    __m128i lo = gst_video_balance_chroma_sse2 (_mm_unpacklo_epi8 (v, zero),
+        coeff1, coeff2);
+    __m128i hi = gst_video_balance_chroma_sse2 (_mm_unpackhi_epi8 (v, zero),
+        coeff1, coeff2);
+
+    _mm_storeu_si128 ((__m128i *) (uv + 2 * x), _mm_packus_epi16 (lo, hi));
+  }
+#endif
+
+  for (; x < n; x++)
+    gst_video_balance_chroma (vb, uv + 2 * x + upos, uv + 2 * x + vpos);
+}
+
+/* Transforms a line of n pixels of YUY2, UYVY or YVYU. y_first is set if
+ * the luma is in the even bytes, swap if V comes before U */
+static void
+gst_video_balance_y422_line (GstVideoBalance * vb, guint8 * data, gint n,
+    gboolean y_first, gboolean swap, gboolean luma_only)
+{
+  const guint8 *tabley = vb->ytable;
+  gint yoff = y_first ? 0 : 1, coff = y_first ? 1 : 0;
+  gint upos = swap ? 2 : 0, vpos = swap ? 0 : 2;
+  gint x = 0;
+
+#ifdef HAVE_VIDEO_BALANCE_SSE2
+  const gint16 *c = vb->uv_coeff;
+  const __m128i mask = _mm_set1_epi16 (0xff);
+  const __m128i ymul = _mm_set1_epi16 (vb->ymul);
+  const __m128i yadd = _mm_set1_epi16 (vb->yadd);
+  const __m128i coeff1 = swap ?
+      CHROMA_COEFFS (c[3], c[2]) : CHROMA_COEFFS (c[0], c[1]);
+  const __m128i coeff2 = swap ?
+      CHROMA_COEFFS (c[1], c[0]) : CHROMA_COEFFS (c[2], c[3]);
+  const __m128i max = _mm_set1_epi16 (255);
+  const __m128i zero = _mm_setzero_si128 ();
+  gint n_simd = tabley == vb->tabley ? n : 0;
+
+  for (; x + 8 <= n_simd; x += 8) {
+    __m128i v = _mm_loadu_si128 ((__m128i *) (data + 2 * x));
+    __m128i ys, cs;
+
+    if (y_first) {
+      ys = _mm_and_si128 (v, mask);
+      cs = _mm_srli_epi16 (v, 8);
+    } else {
+      ys = _mm_srli_epi16 (v, 8);
+      cs = _mm_and_si128 (v, mask);
+    }
+
+    ys = gst_video_balance_luma_sse2 (ys, ymul, yadd);
+    ys = _mm_min_epi16 (_mm_max_epi16 (ys, zero), max);
+
+    if (!luma_only) {
+      cs = gst_video_balance_chroma_sse2 (cs, coeff1, coeff2);
+      cs = _mm_min_epi16 (_mm_max_epi16 (cs, zero), max);
+    }
+
+    if (y_first)
+      v = _mm_or_si128 (ys, _mm_slli_epi16 (cs, 8));
+    else
+      v = _mm_or_si128 (cs, _mm_slli_epi16 (ys, 8));
+    _mm_storeu_si128 ((__m128i *) (data + 2 * x), v);
+  }
+#endif
+
+  for (; x < n; x++) {
+    guint8 *p = data + 2 * x;
+
+    p[yoff] = tabley[p[yoff]];
+    if (!luma_only && (x & 1) == 0)
+      gst_video_balance_chroma (vb, p + coff + upos, p + coff + vpos);
+  }
+}
+
 static void
 gst_video_balance_planar_yuv (GstVideoBalance * videobalance,
-    GstVideoFrame * frame)
+    GstVideoFrame * frame, gint y_start, gint y_end)
 {
-  gint x, y;
+  const GstVideoFormatInfo *finfo = frame->info.finfo;
+  gint y;
   guint8 *ydata;
   guint8 *udata, *vdata;
   gint ystride, ustride, vstride;
-  gint width, height;
-  gint width2, height2;
-  guint8 *tabley = videobalance->tabley;
-  guint8 **tableu = videobalance->tableu;
-  guint8 **tablev = videobalance->tablev;
+  gint width;
+  gint width2;
 
   width = GST_VIDEO_FRAME_WIDTH (frame);
-  height = GST_VIDEO_FRAME_HEIGHT (frame);
 
   ydata = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
   ystride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
 
-  for (y = 0; y < height; y++) {
-    guint8 *yptr;
+  for (y = y_start; y < y_end; y++)
+    gst_video_balance_luma_line (videobalance, ydata + y * ystride, width);
 
-    yptr = ydata + y * ystride;
-    for (x = 0; x < width; x++) {
-      *yptr = tabley[*yptr];
-      yptr++;
-    }
-  }
+  if (videobalance->luma_only)
+    return;
 
   width2 = GST_VIDEO_FRAME_COMP_WIDTH (frame, 1);
-  height2 = GST_VIDEO_FRAME_COMP_HEIGHT (frame, 1);
 
   udata = GST_VIDEO_FRAME_PLANE_DATA (frame, 1);
   vdata = GST_VIDEO_FRAME_PLANE_DATA (frame, 2);
   ustride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 1);
   vstride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 2);
 
-  for (y = 0; y < height2; y++) {
-    guint8 *uptr, *vptr;
-    guint8 u1, v1;
-
-    uptr = udata + y * ustride;
-    vptr = vdata + y * vstride;
-
-    for (x = 0; x < width2; x++) {
-      u1 = *uptr;
-      v1 = *vptr;
-
-      *uptr++ = tableu[u1][v1];
-      *vptr++ = tablev[u1][v1];
-    }
-  }
+  y_end = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, 1, y_end);
+  for (y = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, 1, y_start); y < y_end;
+      y++)
+    gst_video_balance_chroma_line (videobalance, udata + y * ustride,
+        vdata + y * vstride, width2);
 }
 
 static void
 gst_video_balance_semiplanar_yuv (GstVideoBalance * videobalance,
-    GstVideoFrame * frame)
+    GstVideoFrame * frame, gint y_start, gint y_end)
 {
-  gint x, y;
+  const GstVideoFormatInfo *finfo = frame->info.finfo;
+  gint y;
   guint8 *ydata;
   guint8 *uvdata;
   gint ystride, uvstride;
-  gint width, height;
-  gint width2, height2;
-  guint8 *tabley = videobalance->tabley;
-  guint8 **tableu = videobalance->tableu;
-  guint8 **tablev = videobalance->tablev;
-  gint upos, vpos;
+  gint width;
+  gint width2;
+  gboolean swap;
 
   width = GST_VIDEO_FRAME_WIDTH (frame);
-  height = GST_VIDEO_FRAME_HEIGHT (frame);
 
   ydata = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
   ystride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
 
-  for (y = 0; y < height; y++) {
-    guint8 *yptr;
+  for (y = y_start; y < y_end; y++)
+    gst_video_balance_luma_line (videobalance, ydata + y * ystride, width);
 
-    yptr = ydata + y * ystride;
-    for (x = 0; x < width; x++) {
-      *yptr = tabley[*yptr];
-      yptr++;
-    }
-  }
+  if (videobalance->luma_only)
+    return;
 
   width2 = GST_VIDEO_FRAME_COMP_WIDTH (frame, 1);
-  height2 = GST_VIDEO_FRAME_COMP_HEIGHT (frame, 1);
 
   uvdata = GST_VIDEO_FRAME_PLANE_DATA (frame, 1);
   uvstride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 1);
 
-  upos = GST_VIDEO_INFO_FORMAT (&frame->info) == GST_VIDEO_FORMAT_NV12 ? 0 : 1;
-  vpos = GST_VIDEO_INFO_FORMAT (&frame->info) == GST_VIDEO_FORMAT_NV12 ? 1 : 0;
+  swap = GST_VIDEO_INFO_FORMAT (&frame->info) == GST_VIDEO_FORMAT_NV21;
+
+  y_end = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, 1, y_end);
+  for (y = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, 1, y_start); y < y_end;
+      y++)
+    gst_video_balance_chroma_pairs_line (videobalance, uvdata + y * uvstride,
+        width2, swap);
+}
+
+static void
+gst_video_balance_y422 (GstVideoBalance * videobalance,
+    GstVideoFrame * frame, gint y_start, gint y_end)
+{
+  gint y, stride;
+  guint8 *data;
+  gint width;
+  gboolean y_first, swap;
 
-  for (y = 0; y < height2; y++) {
-    guint8 *uvptr;
-    guint8 u1, v1;
+  width = GST_VIDEO_FRAME_WIDTH (frame);
 
-    uvptr = uvdata + y * uvstride;
+  data = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+  stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
 
-    for (x = 0; x < width2; x++) {
-      u1 = uvptr[upos];
-      v1 = uvptr[vpos];
+  y_first = GST_VIDEO_FRAME_COMP_OFFSET (frame, 0) == 0;
+  swap = GST_VIDEO_FRAME_COMP_OFFSET (frame, 2) <
+      GST_VIDEO_FRAME_COMP_OFFSET (frame, 1);
 
-      uvptr[upos] = tableu[u1][v1];
-      uvptr[vpos] = tablev[u1][v1];
-      uvptr += 2;
-    }
-  }
+  for (y = y_start; y < y_end; y++)
+    gst_video_balance_y422_line (videobalance, data + y * stride, width,
+        y_first, swap, videobalance->luma_only);
 }
 
 static void
 gst_video_balance_packed_yuv (GstVideoBalance * videobalance,
-    GstVideoFrame * frame)
+    GstVideoFrame * frame, gint y_start, gint y_end)
 {
   gint x, y, stride;
   guint8 *ydata, *udata, *vdata;
   gint yoff, uoff, voff;
-  gint width, height;
-  gint width2, height2;
-  guint8 *tabley = videobalance->tabley;
-  guint8 **tableu = videobalance->tableu;
-  guint8 **tablev = videobalance->tablev;
+  gint width;
+  const guint8 *tabley = videobalance->ytable;
 
   width = GST_VIDEO_FRAME_WIDTH (frame);
-  height = GST_VIDEO_FRAME_HEIGHT (frame);
 
   stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
   ydata = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
   yoff = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 0);
 
-  for (y = 0; y < height; y++) {
+  for (y = y_start; y < y_end; y++) {
     guint8 *yptr;
 
     yptr = ydata + y * stride;
@@ -310,27 +494,22 @@ gst_video_balance_packed_yuv (GstVideoBalance * videobalance,
     }
   }
 
-  width2 = GST_VIDEO_FRAME_COMP_WIDTH (frame, 1);
-  height2 = GST_VIDEO_FRAME_COMP_HEIGHT (frame, 1);
+  if (videobalance->luma_only)
+    return;
 
   udata = GST_VIDEO_FRAME_COMP_DATA (frame, 1);
   vdata = GST_VIDEO_FRAME_COMP_DATA (frame, 2);
   uoff = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 1);
   voff = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 2);
 
-  for (y = 0; y < height2; y++) {
+  for (y = y_start; y < y_end; y++) {
     guint8 *uptr, *vptr;
-    guint8 u1, v1;
 
     uptr = udata + y * stride;
     vptr = vdata + y * stride;
 
-    for (x = 0; x < width2; x++) {
-      u1 = *uptr;
-      v1 = *vptr;
-
-      *uptr = tableu[u1][v1];
-      *vptr = tablev[u1][v1];
+    for (x = 0; x < width; x++) {
+      gst_video_balance_chroma (videobalance, uptr, vptr);
 
       uptr += uoff;
       vptr += voff;
@@ -354,34 +533,33 @@ static const gint cog_rgb_to_ycbcr_matrix_8bit_sdtv[] = {
 
 static void
 gst_video_balance_packed_rgb (GstVideoBalance * videobalance,
-    GstVideoFrame * frame)
+    GstVideoFrame * frame, gint y_start, gint y_end)
 {
-  gint i, j, height;
+  gint i, j;
   gint width, stride, row_wrap;
   gint pixel_stride;
   guint8 *data;
   gint offsets[3];
   gint r, g, b;
-  gint y, u, v;
+  gint y;
   gint u_tmp, v_tmp;
+  guint8 u, v;
   guint8 *tabley = videobalance->tabley;
-  guint8 **tableu = videobalance->tableu;
-  guint8 **tablev = videobalance->tablev;
+  gboolean luma_only = videobalance->luma_only;
 
   width = GST_VIDEO_FRAME_WIDTH (frame);
-  height = GST_VIDEO_FRAME_HEIGHT (frame);
 
   offsets[0] = GST_VIDEO_FRAME_COMP_OFFSET (frame, 0);
   offsets[1] = GST_VIDEO_FRAME_COMP_OFFSET (frame, 1);
   offsets[2] = GST_VIDEO_FRAME_COMP_OFFSET (frame, 2);
 
-  data = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
   stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+  data = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 0) + y_start * stride;
 
   pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 0);
   row_wrap = stride - pixel_stride * width;
 
-  for (i = 0; i < height; i++) {
+  for (i = y_start; i < y_end; i++) {
     for (j = 0; j < width; j++) {
       r = data[offsets[0]];
       g = data[offsets[1]];
@@ -396,8 +574,10 @@ gst_video_balance_packed_rgb (GstVideoBalance * videobalance,
       v_tmp = CLAMP (v_tmp, 0, 255);
 
       y = tabley[y];
-      u = tableu[u_tmp][v_tmp];
-      v = tablev[u_tmp][v_tmp];
+      u = u_tmp;
+      v = v_tmp;
+      if (!luma_only)
+        gst_video_balance_chroma (videobalance, &u, &v);
 
       r = APPLY_MATRIX (cog_ycbcr_to_rgb_matrix_8bit_sdtv, 0, y, u, v);
       g = APPLY_MATRIX (cog_ycbcr_to_rgb_matrix_8bit_sdtv, 1, y, u, v);
@@ -412,6 +592,87 @@ gst_video_balance_packed_rgb (GstVideoBalance * videobalance,
   }
 }
 
+/* Slices start on a multiple of this many rows, so that the chroma rows of
+ * the subsampled formats are not split */
+#define SLICE_ALIGN 16
+
+typedef struct
+{
+  GstVideoBalance *videobalance;
+  GstVideoFrame *frame;
+  gint y_start, y_end;
+} GstVideoBalanceSlice;
+
+static void
+gst_video_balance_slice_func (gpointer data, gpointer user_data)
+{
+  GstVideoBalanceSlice *slice = data;
+  GstVideoBalance *videobalance = slice->videobalance;
+
+  videobalance->process (videobalance, slice->frame, slice->y_start,
+      slice->y_end);
+
+  g_mutex_lock (&videobalance->slice_lock);
+  if (--videobalance->slice_pending == 0)
+    g_cond_signal (&videobalance->slice_cond);
+  g_mutex_unlock (&videobalance->slice_lock);
+}
+
+/* Splits the frame into slices of rows that are processed on up to
+ * n-threads threads, the calling thread takes the first slice */
+static void
+gst_video_balance_process_slices (GstVideoBalance * videobalance,
+    GstVideoFrame * frame)
+{
+  GstVideoBalanceSlice *slices;
+  gint height = GST_VIDEO_FRAME_HEIGHT (frame);
+  guint n_threads, n_slices, i;
+  gint slice_rows;
+
+  n_threads = videobalance->n_threads;
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  n_slices = MIN (n_threads, height / SLICE_ALIGN);
+  if (n_slices > 1 && videobalance->slice_pool == NULL) {
+    videobalance->slice_pool =
+        g_thread_pool_new (gst_video_balance_slice_func, NULL, n_slices - 1,
+        FALSE, NULL);
+    if (videobalance->slice_pool == NULL)
+      n_slices = 1;
+  } else if (n_slices > 1 &&
+      g_thread_pool_get_max_threads (videobalance->slice_pool) < n_slices - 1) {
+    g_thread_pool_set_max_threads (videobalance->slice_pool, n_slices - 1,
+        NULL);
+  }
+
+  if (n_slices <= 1) {
+    videobalance->process (videobalance, frame, 0, height);
+    return;
+  }
+
+  slice_rows = GST_ROUND_UP_N ((height + n_slices - 1) / n_slices, SLICE_ALIGN);
+  slices = g_newa (GstVideoBalanceSlice, n_slices);
+  for (i = 0; i < n_slices; i++) {
+    slices[i].videobalance = videobalance;
+    slices[i].frame = frame;
+    slices[i].y_start = MIN (i * slice_rows, height);
+    slices[i].y_end = MIN ((i + 1) * slice_rows, height);
+  }
+
+  videobalance->slice_pending = n_slices - 1;
+  for (i = 1; i < n_slices; i++)
+    g_thread_pool_push (videobalance->slice_pool, &slices[i], NULL);
+
+  videobalance->process (videobalance, frame, slices[0].y_start,
+      slices[0].y_end);
+
+  g_mutex_lock (&videobalance->slice_lock);
+  while (videobalance->slice_pending > 0)
+    g_cond_wait (&videobalance->slice_cond, &videobalance->slice_lock);
+  g_mutex_unlock (&videobalance->slice_lock);
+}
+
 /* get notified of caps and plug in the correct process function */
 static gboolean
 gst_video_balance_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
@@ -434,8 +695,10 @@ gst_video_balance_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
       break;
     case GST_VIDEO_FORMAT_YUY2:
     case GST_VIDEO_FORMAT_UYVY:
-    case GST_VIDEO_FORMAT_AYUV:
     case GST_VIDEO_FORMAT_YVYU:
+      videobalance->process = gst_video_balance_y422;
+      break;
+    case GST_VIDEO_FORMAT_AYUV:
       videobalance->process = gst_video_balance_packed_yuv;
       break;
     case GST_VIDEO_FORMAT_NV12:
@@ -459,6 +722,9 @@ gst_video_balance_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
       break;
   }
 
+  videobalance->lut_downstream = FALSE;
+  videobalance->lut_query_pending = TRUE;
+
   return TRUE;
 
   /* ERRORS */
@@ -474,6 +740,7 @@ gst_video_balance_before_transform (GstBaseTransform * base, GstBuffer * buf)
 {
   GstVideoBalance *balance = GST_VIDEO_BALANCE (base);
   GstClockTime timestamp, stream_time;
+  gboolean passthrough;
 
   timestamp = GST_BUFFER_TIMESTAMP (buf);
   stream_time =
@@ -484,6 +751,37 @@ gst_video_balance_before_transform (GstBaseTransform * base, GstBuffer * buf)
 
   if (GST_CLOCK_TIME_IS_VALID (stream_time))
     gst_object_sync_values (GST_OBJECT (balance), stream_time);
+
+  /* downstream is only asked once it got our caps */
+  if (balance->lut_query_pending) {
+    balance->lut_downstream = gst_video_luma_lut_query_downstream (base);
+    balance->lut_query_pending = FALSE;
+  }
+
+  /* a luma table of upstream has to be applied by us if downstream can not
+   * take it */
+  GST_OBJECT_LOCK (balance);
+  passthrough = gst_video_balance_is_passthrough (balance);
+  GST_OBJECT_UNLOCK (balance);
+  if (passthrough && !balance->lut_downstream
+      && gst_buffer_get_video_luma_lut_meta (buf))
+    passthrough = FALSE;
+
+  if (passthrough != gst_base_transform_is_passthrough (base))
+    gst_base_transform_set_passthrough (base, passthrough);
+}
+
+static gboolean
+gst_video_balance_propose_allocation (GstBaseTransform * trans,
+    GstQuery * decide_query, GstQuery * query)
+{
+  if (!GST_BASE_TRANSFORM_CLASS (parent_class)->propose_allocation (trans,
+          decide_query, query))
+    return FALSE;
+
+  gst_video_luma_lut_propose (query);
+
+  return TRUE;
 }
 
 static GstFlowReturn
@@ -496,7 +794,17 @@ gst_video_balance_transform_frame_ip (GstVideoFilter * vfilter,
     goto not_negotiated;
 
   GST_OBJECT_LOCK (videobalance);
-  videobalance->process (videobalance, frame);
+  if (videobalance->luma_only && videobalance->lut_downstream
+      && videobalance->process != gst_video_balance_packed_rgb) {
+    /* only a luma table, leave it to downstream */
+    gst_video_luma_lut_defer (frame->buffer, videobalance->tabley);
+  } else {
+    videobalance->ytable = videobalance->tabley;
+    if (gst_video_luma_lut_take (frame->buffer, videobalance->tabley,
+            videobalance->fused_tabley))
+      videobalance->ytable = videobalance->fused_tabley;
+    gst_video_balance_process_slices (videobalance, frame);
+  }
   GST_OBJECT_UNLOCK (videobalance);
 
   return GST_FLOW_OK;
@@ -515,7 +823,10 @@ gst_video_balance_finalize (GObject * object)
   GList *channels = NULL;
   GstVideoBalance *balance = GST_VIDEO_BALANCE (object);
 
-  g_free (balance->tableu[0]);
+  if (balance->slice_pool)
+    g_thread_pool_free (balance->slice_pool, FALSE, TRUE);
+  g_mutex_clear (&balance->slice_lock);
+  g_cond_clear (&balance->slice_cond);
 
   channels = balance->channels;
   while (channels) {
@@ -563,6 +874,20 @@ gst_video_balance_class_init (GstVideoBalanceClass * klass)
           DEFAULT_PROP_SATURATION,
           GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstVideoBalance:n-threads:
+   *
+   * Number of threads used to process a frame, each one handles a slice of
+   * the rows. 0 uses one thread per processor.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Maximum number of threads used to process a frame "
+          "(0 = number of processors)", 0, G_MAXUINT, DEFAULT_PROP_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "Video balance",
       "Filter/Effect/Video",
       "Adjusts brightness, contrast, hue, saturation on a video stream",
@@ -576,6 +901,8 @@ gst_video_balance_class_init (GstVideoBalanceClass * klass)
   trans_class->before_transform =
       GST_DEBUG_FUNCPTR (gst_video_balance_before_transform);
   trans_class->transform_ip_on_passthrough = FALSE;
+  trans_class->propose_allocation =
+      GST_DEBUG_FUNCPTR (gst_video_balance_propose_allocation);
 
   vfilter_class->set_info = GST_DEBUG_FUNCPTR (gst_video_balance_set_info);
   vfilter_class->transform_frame_ip =
@@ -595,15 +922,11 @@ gst_video_balance_init (GstVideoBalance * videobalance)
   videobalance->brightness = DEFAULT_PROP_BRIGHTNESS;
   videobalance->hue = DEFAULT_PROP_HUE;
   videobalance->saturation = DEFAULT_PROP_SATURATION;
+  videobalance->n_threads = DEFAULT_PROP_N_THREADS;
+  videobalance->ytable = videobalance->tabley;
 
-  videobalance->tableu[0] = g_new (guint8, 256 * 256 * 2);
-  for (i = 0; i < 256; i++) {
-    videobalance->tableu[i] =
-        videobalance->tableu[0] + i * 256 * sizeof (guint8);
-    videobalance->tablev[i] =
-        videobalance->tableu[0] + 256 * 256 * sizeof (guint8) +
-        i * 256 * sizeof (guint8);
-  }
+  g_mutex_init (&videobalance->slice_lock);
+  g_cond_init (&videobalance->slice_cond);
 
   gst_video_balance_update_properties (videobalance);
 
@@ -768,6 +1091,9 @@ gst_video_balance_set_property (GObject * object, guint prop_id,
         label = "SATURATION";
       balance->saturation = d;
       break;
+    case PROP_N_THREADS:
+      balance->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -803,6 +1129,11 @@ gst_video_balance_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_SATURATION:
       g_value_set_double (value, balance->saturation);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (balance);
+      g_value_set_uint (value, balance->n_threads);
+      GST_OBJECT_UNLOCK (balance);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -60,12 +60,30 @@ struct _GstVideoBalance {
   gdouble hue;
   gdouble saturation;
 
+  guint n_threads;
+
   /* tables */
   guint8 tabley[256];
-  guint8 *tableu[256];
-  guint8 *tablev[256];
-
-  void (*process) (GstVideoBalance *balance, GstVideoFrame *frame);
+  gint16 ymul, yadd;
+  gint16 uv_coeff[4];
+  gboolean luma_only;
+
+  /* luma table of the current frame, tabley or tabley composed with a
+   * table upstream left to us */
+  const guint8 *ytable;
+  guint8 fused_tabley[256];
+
+  /* the next element composes luma tables instead of us applying them */
+  gboolean lut_downstream;
+  gboolean lut_query_pending;
+
+  void (*process) (GstVideoBalance *balance, GstVideoFrame *frame, gint y_start, gint y_end);
+
+  /* slice threading */
+  GThreadPool *slice_pool;
+  GMutex slice_lock;
+  GCond slice_cond;
+  guint slice_pending;
 };
 
 struct _GstVideoBalanceClass {
@@ -50,15 +50,22 @@
 #include <gst/gst.h>
 #include <gst/video/video.h>
 
+#if defined(__SSE2__)
+#define HAVE_VIDEO_FLIP_SSE2 1
+#include <emmintrin.h>
+#endif
+
 /* GstVideoFlip properties */
 enum
 {
   PROP_0,
-  PROP_METHOD
+  PROP_METHOD,
+  PROP_N_THREADS
       /* FILL ME */
 };
 
 #define PROP_METHOD_DEFAULT GST_VIDEO_FLIP_METHOD_IDENTITY
+#define PROP_N_THREADS_DEFAULT 1
 
 GST_DEBUG_CATEGORY_STATIC (video_flip_debug);
 #define GST_CAT_DEFAULT video_flip_debug
@@ -184,6 +191,358 @@ gst_video_flip_transform_caps (GstBaseTransform * trans,
   return ret;
 }
 
+/* Rotations and transpositions are done in square tiles of the output, so
+ * that the input rows a tile reads from stay in the cache */
+#define TRANSPOSE_TILE 16
+
+#ifdef HAVE_VIDEO_FLIP_SSE2
+/* dest row j of a n x n block is column j of the input block, whose rows
+ * start at s + i * src_step. With reverse set the input rows are read
+ * backwards, i.e. dest row j is input column n - 1 - j. */
+static void
+gst_video_flip_transpose_block_8x8_u8 (guint8 * d, gint dest_stride,
+    const guint8 * s, gint src_step, gboolean reverse)
+{
+  __m128i a0, a1, a2, a3, a4, a5, a6, a7;
+  __m128i t0, t1, t2, t3, u0, u1, u2, u3, v[4];
+  gint k;
+
+  if (reverse)
+    s -= 7;
+
+  a0 = _mm_loadl_epi64 ((const __m128i *) (s));
+  a1 = _mm_loadl_epi64 ((const __m128i *) (s + src_step));
+  a2 = _mm_loadl_epi64 ((const __m128i *) (s + 2 * src_step));
+  a3 = _mm_loadl_epi64 ((const __m128i *) (s + 3 * src_step));
+  a4 = _mm_loadl_epi64 ((const __m128i *) (s + 4 * src_step));
+  a5 = _mm_loadl_epi64 ((const __m128i *) (s + 5 * src_step));
+  a6 = _mm_loadl_epi64 ((const __m128i *) (s + 6 * src_step));
+  a7 = _mm_loadl_epi64 ((const __m128i *) (s + 7 * src_step));
+
+  t0 = _mm_unpacklo_epi8 (a0, a1);
+  t1 = _mm_unpacklo_epi8 (a2, a3);
+  t2 = _mm_unpacklo_epi8 (a4, a5);
+  t3 = _mm_unpacklo_epi8 (a6, a7);
+  u0 = _mm_unpacklo_epi16 (t0, t1);
+  u1 = _mm_unpackhi_epi16 (t0, t1);
+  u2 = _mm_unpacklo_epi16 (t2, t3);
+  u3 = _mm_unpackhi_epi16 (t2, t3);
+  v[0] = _mm_unpacklo_epi32 (u0, u2);
+  v[1] = _mm_unpackhi_epi32 (u0, u2);
+  v[2] = _mm_unpacklo_epi32 (u1, u3);
+  v[3] = _mm_unpackhi_epi32 (u1, u3);
+
+  for (k = 0; k < 4; k++) {
+    gint j0 = reverse ? 7 - 2 * k : 2 * k;
+    gint j1 = reverse ? 6 - 2 * k : 2 * k + 1;
+
+    _mm_storel_epi64 ((__m128i *) (d + j0 * dest_stride), v[k]);
+    _mm_storel_epi64 ((__m128i *) (d + j1 * dest_stride),
+        _mm_srli_si128 (v[k], 8));
+  }
+}
+
+static void
+gst_video_flip_transpose_block_8x8_u16 (guint8 * d, gint dest_stride,
+    const guint8 * s, gint src_step, gboolean reverse)
+{
+  __m128i a0, a1, a2, a3, a4, a5, a6, a7;
+  __m128i t0, t1, t2, t3, t4, t5, t6, t7, u0, u1, u2, u3, u4, u5, u6, u7;
+  __m128i v[8];
+  gint k;
+
+  if (reverse)
+    s -= 14;
+
+  a0 = _mm_loadu_si128 ((const __m128i *) (s));
+  a1 = _mm_loadu_si128 ((const __m128i *) (s + src_step));
+  a2 = _mm_loadu_si128 ((const __m128i *) (s + 2 * src_step));
+  a3 = _mm_loadu_si128 ((const __m128i *) (s + 3 * src_step));
+  a4 = _mm_loadu_si128 ((const __m128i *) (s + 4 * src_step));
+  a5 = _mm_loadu_si128 ((const __m128i *) (s + 5 * src_step));
+  a6 = _mm_loadu_si128 ((const __m128i *) (s + 6 * src_step));
+  a7 = _mm_loadu_si128 ((const __m128i *) (s + 7 * src_step));
+
+  t0 = _mm_unpacklo_epi16 (a0, a1);
+  t1 = _mm_unpackhi_epi16 (a0, a1);
+  t2 = _mm_unpacklo_epi16 (a2, a3);
+  t3 = _mm_unpackhi_epi16 (a2, a3);
+  t4 = _mm_unpacklo_epi16 (a4, a5);
+  t5 = _mm_unpackhi_epi16 (a4, a5);
+  t6 = _mm_unpacklo_epi16 (a6, a7);
+  t7 = _mm_unpackhi_epi16 (a6, a7);
+  u0 = _mm_unpacklo_epi32 (t0, t2);
+  u1 = _mm_unpackhi_epi32 (t0, t2);
+  u2 = _mm_unpacklo_epi32 (t1, t3);
+  u3 = _mm_unpackhi_epi32 (t1, t3);
+  u4 = _mm_unpacklo_epi32 (t4, t6);
+  u5 = _mm_unpackhi_epi32 (t4, t6);
+  u6 = _mm_unpacklo_epi32 (t5, t7);
+  u7 = _mm_unpackhi_epi32 (t5, t7);
+  v[0] = _mm_unpacklo_epi64 (u0, u4);
+  v[1] = _mm_unpackhi_epi64 (u0, u4);
+  v[2] = _mm_unpacklo_epi64 (u1, u5);
+  v[3] = _mm_unpackhi_epi64 (u1, u5);
+  v[4] = _mm_unpacklo_epi64 (u2, u6);
+  v[5] = _mm_unpackhi_epi64 (u2, u6);
+  v[6] = _mm_unpacklo_epi64 (u3, u7);
+  v[7] = _mm_unpackhi_epi64 (u3, u7);
+
+  for (k = 0; k < 8; k++)
+    _mm_storeu_si128 ((__m128i *) (d + (reverse ? 7 - k : k) * dest_stride),
+        v[k]);
+}
+
+static void
+gst_video_flip_transpose_block_4x4_u32 (guint8 * d, gint dest_stride,
+    const guint8 * s, gint src_step, gboolean reverse)
+{
+  __m128i a0, a1, a2, a3, t0, t1, t2, t3, v[4];
+  gint k;
+
+  if (reverse)
+    s -= 12;
+
+  a0 = _mm_loadu_si128 ((const __m128i *) (s));
+  a1 = _mm_loadu_si128 ((const __m128i *) (s + src_step));
+  a2 = _mm_loadu_si128 ((const __m128i *) (s + 2 * src_step));
+  a3 = _mm_loadu_si128 ((const __m128i *) (s + 3 * src_step));
+
+  t0 = _mm_unpacklo_epi32 (a0, a1);
+  t1 = _mm_unpackhi_epi32 (a0, a1);
+  t2 = _mm_unpacklo_epi32 (a2, a3);
+  t3 = _mm_unpackhi_epi32 (a2, a3);
+  v[0] = _mm_unpacklo_epi64 (t0, t2);
+  v[1] = _mm_unpackhi_epi64 (t0, t2);
+  v[2] = _mm_unpacklo_epi64 (t1, t3);
+  v[3] = _mm_unpackhi_epi64 (t1, t3);
+
+  for (k = 0; k < 4; k++)
+    _mm_storeu_si128 ((__m128i *) (d + (reverse ? 3 - k : k) * dest_stride),
+        v[k]);
+}
+#endif
+
+#define TRANSPOSE_TILE_LOOP(bpp) G_STMT_START {                  \
+  for (y = 0; y < th; y++) {                                     \
+    guint8 *dp = d + (ty + y) * dest_stride + tx * (bpp);        \
+    const guint8 *sp = s + origin + tx * x_step + (ty + y) * y_step; \
+    for (x = 0; x < tw; x++) {                                   \
+      memcpy (dp, sp, (bpp));                                    \
+      dp += (bpp);                                               \
+      sp += x_step;                                              \
+    }                                                            \
+  }                                                              \
+} G_STMT_END
+
+/* Writes the output rows [y_start, y_end) of a plane for one of the
+ * transposing methods. sw and sh are the size of the input plane in
+ * pixels, bpp the size of a pixel in bytes. */
+static void
+gst_video_flip_transpose_plane (GstVideoFlipMethod method, guint8 * d,
+    gint dest_stride, const guint8 * s, gint src_stride, gint sw, gint sh,
+    gint bpp, gint y_start, gint y_end)
+{
+  gint x, y, tx, ty, tw, th;
+  gint dw = sh;
+  gint origin, x_step, y_step;
+#ifdef HAVE_VIDEO_FLIP_SSE2
+  gint block = (bpp == 4) ? 4 : 8;
+#endif
+
+  /* offset of the input pixel of output pixel 0,0 and the input offset
+   * between neighbouring output pixels in a row and in a column */
+  switch (method) {
+    case GST_VIDEO_FLIP_METHOD_90R:
+      origin = (sh - 1) * src_stride;
+      x_step = -src_stride;
+      y_step = bpp;
+      break;
+    case GST_VIDEO_FLIP_METHOD_90L:
+      origin = (sw - 1) * bpp;
+      x_step = src_stride;
+      y_step = -bpp;
+      break;
+    case GST_VIDEO_FLIP_METHOD_TRANS:
+      origin = 0;
+      x_step = src_stride;
+      y_step = bpp;
+      break;
+    case GST_VIDEO_FLIP_METHOD_OTHER:
+      origin = (sh - 1) * src_stride + (sw - 1) * bpp;
+      x_step = -src_stride;
+      y_step = -bpp;
+      break;
+    default:
+      g_assert_not_reached ();
+      return;
+  }
+
+  for (ty = y_start; ty < y_end; ty += TRANSPOSE_TILE) {
+    th = MIN (TRANSPOSE_TILE, y_end - ty);
+
+    for (tx = 0; tx < dw; tx += TRANSPOSE_TILE) {
+      tw = MIN (TRANSPOSE_TILE, dw - tx);
+
+#ifdef HAVE_VIDEO_FLIP_SSE2
+      if (tw == TRANSPOSE_TILE && th == TRANSPOSE_TILE && bpp != 3) {
+        gint bx, by;
+
+        for (by = 0; by < TRANSPOSE_TILE; by += block) {
+          for (bx = 0; bx < TRANSPOSE_TILE; bx += block) {
+            guint8 *dp = d + (ty + by) * dest_stride + (tx + bx) * bpp;
+            const guint8 *sp =
+                s + origin + (tx + bx) * x_step + (ty + by) * y_step;
+
+            if (bpp == 1)
+              gst_video_flip_transpose_block_8x8_u8 (dp, dest_stride, sp,
+                  x_step, y_step < 0);
+            else if (bpp == 2)
+              gst_video_flip_transpose_block_8x8_u16 (dp, dest_stride, sp,
+                  x_step, y_step < 0);
+            else
+              gst_video_flip_transpose_block_4x4_u32 (dp, dest_stride, sp,
+                  x_step, y_step < 0);
+          }
+        }
+        continue;
+      }
+#endif
+
+      switch (bpp) {
+        case 1:
+          TRANSPOSE_TILE_LOOP (1);
+          break;
+        case 2:
+          TRANSPOSE_TILE_LOOP (2);
+          break;
+        case 3:
+          TRANSPOSE_TILE_LOOP (3);
+          break;
+        case 4:
+          TRANSPOSE_TILE_LOOP (4);
+          break;
+        default:
+          g_assert_not_reached ();
+          break;
+      }
+    }
+  }
+}
+
+#undef TRANSPOSE_TILE_LOOP
+
+static void
+gst_video_flip_transpose_rows (GstVideoFlip * videoflip, GstVideoFrame * dest,
+    const GstVideoFrame * src, gint y_start, gint y_end)
+{
+  const GstVideoFormatInfo *finfo = dest->info.finfo;
+  gint height = GST_VIDEO_FRAME_HEIGHT (dest);
+  gint i, c, plane_height;
+
+  for (i = 0; i < GST_VIDEO_FRAME_N_PLANES (dest); i++) {
+    /* first component of the plane, the others have the same layout */
+    for (c = 0; c < GST_VIDEO_FRAME_N_COMPONENTS (dest) - 1; c++)
+      if (GST_VIDEO_FORMAT_INFO_PLANE (finfo, c) == i)
+        break;
+
+    plane_height = GST_VIDEO_FRAME_COMP_HEIGHT (dest, c);
+
+    gst_video_flip_transpose_plane (videoflip->active_method,
+        GST_VIDEO_FRAME_PLANE_DATA (dest, i),
+        GST_VIDEO_FRAME_PLANE_STRIDE (dest, i),
+        GST_VIDEO_FRAME_PLANE_DATA (src, i),
+        GST_VIDEO_FRAME_PLANE_STRIDE (src, i),
+        GST_VIDEO_FRAME_COMP_WIDTH (src, c),
+        GST_VIDEO_FRAME_COMP_HEIGHT (src, c),
+        GST_VIDEO_FRAME_COMP_PSTRIDE (src, c),
+        (gint64) y_start * plane_height / height,
+        (gint64) y_end * plane_height / height);
+  }
+}
+
+/* Slices start on a multiple of this many output rows, so that subsampled
+ * planes are split on full tiles too */
+#define SLICE_ALIGN (2 * TRANSPOSE_TILE)
+
+typedef struct
+{
+  GstVideoFlip *videoflip;
+  GstVideoFrame *dest;
+  const GstVideoFrame *src;
+  gint y_start, y_end;
+} GstVideoFlipSlice;
+
+static void
+gst_video_flip_slice_func (gpointer data, gpointer user_data)
+{
+  GstVideoFlipSlice *slice = data;
+  GstVideoFlip *videoflip = slice->videoflip;
+
+  gst_video_flip_transpose_rows (videoflip, slice->dest, slice->src,
+      slice->y_start, slice->y_end);
+
+  g_mutex_lock (&videoflip->slice_lock);
+  if (--videoflip->slice_pending == 0)
+    g_cond_signal (&videoflip->slice_cond);
+  g_mutex_unlock (&videoflip->slice_lock);
+}
+
+/* Handles the rotations and transpositions of all formats but the 4:2:2
+ * packed ones. The output rows are split into slices that are processed
+ * on up to n-threads threads, the calling thread takes the first slice. */
+static void
+gst_video_flip_transpose (GstVideoFlip * videoflip, GstVideoFrame * dest,
+    const GstVideoFrame * src)
+{
+  GstVideoFlipSlice *slices;
+  gint height = GST_VIDEO_FRAME_HEIGHT (dest);
+  guint n_threads, n_slices, i;
+  gint slice_rows;
+
+  n_threads = videoflip->n_threads;
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  n_slices = MIN (n_threads, height / SLICE_ALIGN);
+  if (n_slices > 1 && videoflip->slice_pool == NULL) {
+    videoflip->slice_pool = g_thread_pool_new (gst_video_flip_slice_func,
+        NULL, n_slices - 1, FALSE, NULL);
+    if (videoflip->slice_pool == NULL)
+      n_slices = 1;
+  } else if (n_slices > 1 &&
+      g_thread_pool_get_max_threads (videoflip->slice_pool) < n_slices - 1) {
+    g_thread_pool_set_max_threads (videoflip->slice_pool, n_slices - 1, NULL);
+  }
+
+  if (n_slices <= 1) {
+    gst_video_flip_transpose_rows (videoflip, dest, src, 0, height);
+    return;
+  }
+
+  slice_rows = GST_ROUND_UP_N ((height + n_slices - 1) / n_slices, SLICE_ALIGN);
+  slices = g_newa (GstVideoFlipSlice, n_slices);
+  for (i = 0; i < n_slices; i++) {
+    slices[i].videoflip = videoflip;
+    slices[i].dest = dest;
+    slices[i].src = src;
+    slices[i].y_start = MIN (i * slice_rows, height);
+    slices[i].y_end = MIN ((i + 1) * slice_rows, height);
+  }
+
+  videoflip->slice_pending = n_slices - 1;
+  for (i = 1; i < n_slices; i++)
+    g_thread_pool_push (videoflip->slice_pool, &slices[i], NULL);
+
+  gst_video_flip_transpose_rows (videoflip, dest, src, slices[0].y_start,
+      slices[0].y_end);
+
+  g_mutex_lock (&videoflip->slice_lock);
+  while (videoflip->slice_pending > 0)
+    g_cond_wait (&videoflip->slice_cond, &videoflip->slice_lock);
+  g_mutex_unlock (&videoflip->slice_lock);
+}
+
 static void
 gst_video_flip_planar_yuv (GstVideoFlip * videoflip, GstVideoFrame * dest,
     const GstVideoFrame * src)
@@ -223,64 +582,6 @@ gst_video_flip_planar_yuv (GstVideoFlip * videoflip, GstVideoFrame * dest,
   dest_v_height = GST_VIDEO_FRAME_COMP_HEIGHT (dest, 2);
 
   switch (videoflip->active_method) {
-    case GST_VIDEO_FLIP_METHOD_90R:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[(src_y_height - 1 - x) * src_y_stride + y];
-        }
-      }
-      /* Flip U */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_u_height; y++) {
-        for (x = 0; x < dest_u_width; x++) {
-          d[y * dest_u_stride + x] =
-              s[(src_u_height - 1 - x) * src_u_stride + y];
-        }
-      }
-      /* Flip V */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 2);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 2);
-      for (y = 0; y < dest_v_height; y++) {
-        for (x = 0; x < dest_v_width; x++) {
-          d[y * dest_v_stride + x] =
-              s[(src_v_height - 1 - x) * src_v_stride + y];
-        }
-      }
-      break;
-    case GST_VIDEO_FLIP_METHOD_90L:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[x * src_y_stride + (src_y_width - 1 - y)];
-        }
-      }
-      /* Flip U */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_u_height; y++) {
-        for (x = 0; x < dest_u_width; x++) {
-          d[y * dest_u_stride + x] =
-              s[x * src_u_stride + (src_u_width - 1 - y)];
-        }
-      }
-      /* Flip V */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 2);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 2);
-      for (y = 0; y < dest_v_height; y++) {
-        for (x = 0; x < dest_v_width; x++) {
-          d[y * dest_v_stride + x] =
-              s[x * src_v_stride + (src_v_width - 1 - y)];
-        }
-      }
-      break;
     case GST_VIDEO_FLIP_METHOD_180:
       /* Flip Y */
       s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
@@ -368,61 +669,6 @@ gst_video_flip_planar_yuv (GstVideoFlip * videoflip, GstVideoFrame * dest,
         }
       }
       break;
-    case GST_VIDEO_FLIP_METHOD_TRANS:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] = s[x * src_y_stride + y];
-        }
-      }
-      /* Flip U */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_u_height; y++) {
-        for (x = 0; x < dest_u_width; x++) {
-          d[y * dest_u_stride + x] = s[x * src_u_stride + y];
-        }
-      }
-      /* Flip V */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 2);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 2);
-      for (y = 0; y < dest_u_height; y++) {
-        for (x = 0; x < dest_u_width; x++) {
-          d[y * dest_v_stride + x] = s[x * src_v_stride + y];
-        }
-      }
-      break;
-    case GST_VIDEO_FLIP_METHOD_OTHER:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[(src_y_height - 1 - x) * src_y_stride + (src_y_width - 1 - y)];
-        }
-      }
-      /* Flip U */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_u_height; y++) {
-        for (x = 0; x < dest_u_width; x++) {
-          d[y * dest_u_stride + x] =
-              s[(src_u_height - 1 - x) * src_u_stride + (src_u_width - 1 - y)];
-        }
-      }
-      /* Flip V */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 2);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 2);
-      for (y = 0; y < dest_v_height; y++) {
-        for (x = 0; x < dest_v_width; x++) {
-          d[y * dest_v_stride + x] =
-              s[(src_v_height - 1 - x) * src_v_stride + (src_v_width - 1 - y)];
-        }
-      }
-      break;
     case GST_VIDEO_FLIP_METHOD_IDENTITY:
       g_assert_not_reached ();
       break;
@@ -467,50 +713,6 @@ gst_video_flip_semi_planar_yuv (GstVideoFlip * videoflip, GstVideoFrame * dest,
   dest_uv_height = GST_VIDEO_FRAME_COMP_HEIGHT (dest, 1);
 
   switch (videoflip->active_method) {
-    case GST_VIDEO_FLIP_METHOD_90R:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[(src_y_height - 1 - x) * src_y_stride + y];
-        }
-      }
-      /* Flip UV */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_uv_height; y++) {
-        for (x = 0; x < dest_uv_width; x++) {
-          d_off = y * dest_uv_stride + x * 2;
-          s_off = (src_uv_height - 1 - x) * src_uv_stride + y * 2;
-          d[d_off] = s[s_off];
-          d[d_off + 1] = s[s_off + 1];
-        }
-      }
-      break;
-    case GST_VIDEO_FLIP_METHOD_90L:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[x * src_y_stride + (src_y_width - 1 - y)];
-        }
-      }
-      /* Flip UV */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_uv_height; y++) {
-        for (x = 0; x < dest_uv_width; x++) {
-          d_off = y * dest_uv_stride + x * 2;
-          s_off = x * src_uv_stride + (src_uv_width - 1 - y) * 2;
-          d[d_off] = s[s_off];
-          d[d_off + 1] = s[s_off + 1];
-        }
-      }
-      break;
     case GST_VIDEO_FLIP_METHOD_180:
       /* Flip Y */
       s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
@@ -578,49 +780,6 @@ gst_video_flip_semi_planar_yuv (GstVideoFlip * videoflip, GstVideoFrame * dest,
         }
       }
       break;
-    case GST_VIDEO_FLIP_METHOD_TRANS:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] = s[x * src_y_stride + y];
-        }
-      }
-      /* Flip UV */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_uv_height; y++) {
-        for (x = 0; x < dest_uv_width; x++) {
-          d_off = y * dest_uv_stride + x * 2;
-          s_off = x * src_uv_stride + y * 2;
-          d[d_off] = s[s_off];
-          d[d_off + 1] = s[s_off + 1];
-        }
-      }
-    case GST_VIDEO_FLIP_METHOD_OTHER:
-      /* Flip Y */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 0);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 0);
-      for (y = 0; y < dest_y_height; y++) {
-        for (x = 0; x < dest_y_width; x++) {
-          d[y * dest_y_stride + x] =
-              s[(src_y_height - 1 - x) * src_y_stride + (src_y_width - 1 - y)];
-        }
-      }
-      /* Flip UV */
-      s = GST_VIDEO_FRAME_PLANE_DATA (src, 1);
-      d = GST_VIDEO_FRAME_PLANE_DATA (dest, 1);
-      for (y = 0; y < dest_uv_height; y++) {
-        for (x = 0; x < dest_uv_width; x++) {
-          d_off = y * dest_uv_stride + x * 2;
-          s_off = (src_uv_height - 1 - x) * src_uv_stride + (src_uv_width - 1 -
-              y) * 2;
-          d[d_off] = s[s_off];
-          d[d_off + 1] = s[s_off + 1];
-        }
-      }
-      break;
     case GST_VIDEO_FLIP_METHOD_IDENTITY:
       g_assert_not_reached ();
       break;
@@ -653,26 +812,6 @@ gst_video_flip_packed_simple (GstVideoFlip * videoflip, GstVideoFrame * dest,
   bpp = GST_VIDEO_FRAME_COMP_PSTRIDE (src, 0);
 
   switch (videoflip->active_method) {
-    case GST_VIDEO_FLIP_METHOD_90R:
-      for (y = 0; y < dh; y++) {
-        for (x = 0; x < dw; x++) {
-          for (z = 0; z < bpp; z++) {
-            d[y * dest_stride + x * bpp + z] =
-                s[(sh - 1 - x) * src_stride + y * bpp + z];
-          }
-        }
-      }
-      break;
-    case GST_VIDEO_FLIP_METHOD_90L:
-      for (y = 0; y < dh; y++) {
-        for (x = 0; x < dw; x++) {
-          for (z = 0; z < bpp; z++) {
-            d[y * dest_stride + x * bpp + z] =
-                s[x * src_stride + (sw - 1 - y) * bpp + z];
-          }
-        }
-      }
-      break;
     case GST_VIDEO_FLIP_METHOD_180:
       for (y = 0; y < dh; y++) {
         for (x = 0; x < dw; x++) {
@@ -703,25 +842,6 @@ gst_video_flip_packed_simple (GstVideoFlip * videoflip, GstVideoFrame * dest,
         }
       }
       break;
-    case GST_VIDEO_FLIP_METHOD_TRANS:
-      for (y = 0; y < dh; y++) {
-        for (x = 0; x < dw; x++) {
-          for (z = 0; z < bpp; z++) {
-            d[y * dest_stride + x * bpp + z] = s[x * src_stride + y * bpp + z];
-          }
-        }
-      }
-      break;
-    case GST_VIDEO_FLIP_METHOD_OTHER:
-      for (y = 0; y < dh; y++) {
-        for (x = 0; x < dw; x++) {
-          for (z = 0; z < bpp; z++) {
-            d[y * dest_stride + x * bpp + z] =
-                s[(sh - 1 - x) * src_stride + (sw - 1 - y) * bpp + z];
-          }
-        }
-      }
-      break;
     case GST_VIDEO_FLIP_METHOD_IDENTITY:
       g_assert_not_reached ();
       break;
@@ -1106,7 +1226,20 @@ gst_video_flip_transform_frame (GstVideoFilter * vfilter,
       video_flip_methods[videoflip->active_method].value_nick);
 
   GST_OBJECT_LOCK (videoflip);
-  videoflip->process (videoflip, out_frame, in_frame);
+  switch (videoflip->active_method) {
+    case GST_VIDEO_FLIP_METHOD_90R:
+    case GST_VIDEO_FLIP_METHOD_90L:
+    case GST_VIDEO_FLIP_METHOD_TRANS:
+    case GST_VIDEO_FLIP_METHOD_OTHER:
+      if (videoflip->process != gst_video_flip_y422) {
+        gst_video_flip_transpose (videoflip, out_frame, in_frame);
+        break;
+      }
+      /* fall through */
+    default:
+      videoflip->process (videoflip, out_frame, in_frame);
+      break;
+  }
   GST_OBJECT_UNLOCK (videoflip);
 
   return GST_FLOW_OK;
@@ -1240,6 +1373,11 @@ gst_video_flip_set_property (GObject * object, guint prop_id,
     case PROP_METHOD:
       gst_video_flip_set_method (videoflip, g_value_get_enum (value), FALSE);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (videoflip);
+      videoflip->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (videoflip);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1256,12 +1394,30 @@ gst_video_flip_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_METHOD:
       g_value_set_enum (value, videoflip->method);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (videoflip);
+      g_value_set_uint (value, videoflip->n_threads);
+      GST_OBJECT_UNLOCK (videoflip);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_video_flip_finalize (GObject * object)
+{
+  GstVideoFlip *videoflip = GST_VIDEO_FLIP (object);
+
+  if (videoflip->slice_pool)
+    g_thread_pool_free (videoflip->slice_pool, FALSE, TRUE);
+  g_mutex_clear (&videoflip->slice_lock);
+  g_cond_clear (&videoflip->slice_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_video_flip_class_init (GstVideoFlipClass * klass)
 {
@@ -1274,6 +1430,7 @@ gst_video_flip_class_init (GstVideoFlipClass * klass)
 
   gobject_class->set_property = gst_video_flip_set_property;
   gobject_class->get_property = gst_video_flip_get_property;
+  gobject_class->finalize = gst_video_flip_finalize;
 
   g_object_class_install_property (gobject_class, PROP_METHOD,
       g_param_spec_enum ("method", "method", "method",
@@ -1281,6 +1438,21 @@ gst_video_flip_class_init (GstVideoFlipClass * klass)
           GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_CONSTRUCT |
           G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstVideoFlip:n-threads:
+   *
+   * Number of threads used for the rotations and transpositions. The output
+   * rows are split into slices that are processed in parallel, 0 uses one
+   * thread per processor.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Maximum number of threads used to rotate a frame "
+          "(0 = number of processors)", 0, G_MAXUINT, PROP_N_THREADS_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class, "Video flipper",
       "Filter/Effect/Video",
       "Flips and rotates video", "David Schleef <ds@schleef.org>");
@@ -1308,4 +1480,8 @@ gst_video_flip_init (GstVideoFlip * videoflip)
   /* AUTO is not valid for active method, this is just to ensure we setup the
    * method in gst_video_flip_set_method() */
   videoflip->active_method = GST_VIDEO_FLIP_METHOD_AUTO;
+
+  videoflip->n_threads = PROP_N_THREADS_DEFAULT;
+  g_mutex_init (&videoflip->slice_lock);
+  g_cond_init (&videoflip->slice_cond);
 }
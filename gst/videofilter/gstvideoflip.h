@@ -79,6 +79,12 @@ struct _GstVideoFlip {
   GstVideoFlipMethod tag_method;
   GstVideoFlipMethod active_method;
   void (*process) (GstVideoFlip *videoflip, GstVideoFrame *dest, const GstVideoFrame *src);
+
+  guint n_threads;
+  GThreadPool *slice_pool;
+  GMutex slice_lock;
+  GCond slice_cond;
+  guint slice_pending;
 };
 
 struct _GstVideoFlipClass {
@@ -0,0 +1,170 @@
+/* GStreamer
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Fusing of consecutive luma LUT filters (gamma, videobalance).
+ *
+ * An element that supports the fusing adds the meta API to the allocation
+ * queries it receives. An element whose operation is a pure luma table
+ * checks whether its downstream does so, and if it does, it does not touch
+ * the frame but composes its table into a GstVideoLumaLutMeta on the
+ * buffer. The first element that can not defer composes the pending table
+ * with its own one, removes the meta and does a single pass over the
+ * frame.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <gst/video/video.h>
+
+#include "gstvideolut.h"
+
+static gboolean
+gst_video_luma_lut_meta_transform (GstBuffer * dest, GstMeta * meta,
+    GstBuffer * buffer, GQuark type, gpointer data)
+{
+  GstVideoLumaLutMeta *lmeta = (GstVideoLumaLutMeta *) meta;
+
+  /* the table is only valid for the complete frame */
+  if (GST_META_TRANSFORM_IS_COPY (type)) {
+    GstMetaTransformCopy *copy = data;
+
+    if (!copy->region)
+      gst_video_luma_lut_defer (dest, lmeta->table);
+  }
+
+  return TRUE;
+}
+
+GType
+gst_video_luma_lut_meta_api_get_type (void)
+{
+  static volatile GType type;
+  static const gchar *tags[] = { "video", "colorspace", NULL };
+
+  if (g_once_init_enter (&type)) {
+    GType _type = gst_meta_api_type_register ("GstVideoLumaLutMetaAPI", tags);
+    g_once_init_leave (&type, _type);
+  }
+  return type;
+}
+
+const GstMetaInfo *
+gst_video_luma_lut_meta_get_info (void)
+{
+  static const GstMetaInfo *meta_info = NULL;
+
+  if (g_once_init_enter (&meta_info)) {
+    const GstMetaInfo *meta =
+        gst_meta_register (GST_VIDEO_LUMA_LUT_META_API_TYPE,
+        "GstVideoLumaLutMeta", sizeof (GstVideoLumaLutMeta),
+        (GstMetaInitFunction) NULL, (GstMetaFreeFunction) NULL,
+        gst_video_luma_lut_meta_transform);
+    g_once_init_leave (&meta_info, meta);
+  }
+  return meta_info;
+}
+
+/* Leaves applying @table to the downstream element. It is composed after
+ * the table that is already pending on @buffer, if any */
+void
+gst_video_luma_lut_defer (GstBuffer * buffer, const guint8 * table)
+{
+  GstVideoLumaLutMeta *meta;
+  gint i;
+
+  meta = gst_buffer_get_video_luma_lut_meta (buffer);
+  if (meta) {
+    for (i = 0; i < 256; i++)
+      meta->table[i] = table[meta->table[i]];
+  } else {
+    meta = (GstVideoLumaLutMeta *) gst_buffer_add_meta (buffer,
+        gst_video_luma_lut_meta_get_info (), NULL);
+    memcpy (meta->table, table, 256);
+  }
+}
+
+/* If a table is pending on @buffer, removes it and stores the composition
+ * of it and @table in @fused. Returns TRUE if @fused has to be applied
+ * instead of @table */
+gboolean
+gst_video_luma_lut_take (GstBuffer * buffer, const guint8 * table,
+    guint8 * fused)
+{
+  GstVideoLumaLutMeta *meta;
+  gint i;
+
+  meta = gst_buffer_get_video_luma_lut_meta (buffer);
+  if (!meta)
+    return FALSE;
+
+  for (i = 0; i < 256; i++)
+    fused[i] = table[meta->table[i]];
+  gst_buffer_remove_meta (buffer, (GstMeta *) meta);
+
+  return TRUE;
+}
+
+/* Advertises support for pending tables in an allocation @query the
+ * element received on its sink pad */
+void
+gst_video_luma_lut_propose (GstQuery * query)
+{
+  GstCaps *caps;
+  GstVideoInfo info;
+
+  gst_query_parse_allocation (query, &caps, NULL);
+  if (caps == NULL || !gst_video_info_from_caps (&info, caps))
+    return;
+
+  if (GST_VIDEO_INFO_IS_YUV (&info) &&
+      !gst_query_find_allocation_meta (query, GST_VIDEO_LUMA_LUT_META_API_TYPE,
+          NULL))
+    gst_query_add_allocation_meta (query, GST_VIDEO_LUMA_LUT_META_API_TYPE,
+        NULL);
+}
+
+/* Returns TRUE if the downstream element of @trans applies pending tables
+ * for the current caps */
+gboolean
+gst_video_luma_lut_query_downstream (GstBaseTransform * trans)
+{
+  GstCaps *caps;
+  GstQuery *query;
+  gboolean res = FALSE;
+
+  caps = gst_pad_get_current_caps (GST_BASE_TRANSFORM_SRC_PAD (trans));
+  if (caps == NULL)
+    return FALSE;
+
+  query = gst_query_new_allocation (caps, FALSE);
+  if (gst_pad_peer_query (GST_BASE_TRANSFORM_SRC_PAD (trans), query))
+    res = gst_query_find_allocation_meta (query,
+        GST_VIDEO_LUMA_LUT_META_API_TYPE, NULL);
+  gst_query_unref (query);
+  gst_caps_unref (caps);
+
+  GST_DEBUG_OBJECT (trans, "downstream %s luma tables",
+      res ? "applies" : "does not apply");
+
+  return res;
+}
@@ -0,0 +1,66 @@
+/* GStreamer
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_VIDEO_LUT_H__
+#define __GST_VIDEO_LUT_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstVideoLumaLutMeta GstVideoLumaLutMeta;
+
+/*
+ * GstVideoLumaLutMeta:
+ *
+ * A luma lookup table that still has to be applied to the Y component of
+ * the buffer. Consecutive LUT filters of this plugin attach and compose it
+ * instead of processing the frame, and the last one of the chain applies
+ * the combined table in a single pass.
+ *
+ * It is only attached when the downstream element advertised
+ * GST_VIDEO_LUMA_LUT_META_API_TYPE in the allocation query, and only for
+ * 8 bit YUV formats.
+ */
+struct _GstVideoLumaLutMeta
+{
+  GstMeta meta;
+
+  guint8 table[256];
+};
+
+GType gst_video_luma_lut_meta_api_get_type (void);
+#define GST_VIDEO_LUMA_LUT_META_API_TYPE (gst_video_luma_lut_meta_api_get_type())
+const GstMetaInfo *gst_video_luma_lut_meta_get_info (void);
+
+#define gst_buffer_get_video_luma_lut_meta(b) \
+  ((GstVideoLumaLutMeta *) gst_buffer_get_meta ((b), \
+      GST_VIDEO_LUMA_LUT_META_API_TYPE))
+
+void gst_video_luma_lut_defer (GstBuffer * buffer, const guint8 * table);
+gboolean gst_video_luma_lut_take (GstBuffer * buffer, const guint8 * table,
+    guint8 * fused);
+
+void gst_video_luma_lut_propose (GstQuery * query);
+gboolean gst_video_luma_lut_query_downstream (GstBaseTransform * trans);
+
+G_END_DECLS
+
+#endif /* __GST_VIDEO_LUT_H__ */
@@ -23,6 +23,11 @@
 #include <string.h>
 #include "gstvideomedian.h"
 
+#if defined(__SSE2__)
+#define HAVE_VIDEO_MEDIAN_SSE2 1
+#include <emmintrin.h>
+#endif
+
 static GstStaticPadTemplate video_median_src_factory =
 GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
@@ -59,6 +64,9 @@ enum
 static const GEnumValue video_median_sizes[] = {
   {GST_VIDEO_MEDIAN_SIZE_5, "Median of 5 neighbour pixels", "5"},
   {GST_VIDEO_MEDIAN_SIZE_9, "Median of 9 neighbour pixels", "9"},
+  {GST_VIDEO_MEDIAN_SIZE_25, "Median of 25 neighbour pixels", "25"},
+  {GST_VIDEO_MEDIAN_SIZE_49, "Median of 49 neighbour pixels", "49"},
+  {GST_VIDEO_MEDIAN_SIZE_81, "Median of 81 neighbour pixels", "81"},
   {0, NULL, NULL},
 };
 
@@ -80,6 +88,7 @@ G_DEFINE_TYPE (GstVideoMedian, gst_video_median, GST_TYPE_VIDEO_FILTER);
 static GstFlowReturn gst_video_median_transform_frame (GstVideoFilter * filter,
     GstVideoFrame * in_frame, GstVideoFrame * out_frame);
 
+static void gst_video_median_finalize (GObject * object);
 static void gst_video_median_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_video_median_get_property (GObject * object, guint prop_id,
@@ -96,9 +105,18 @@ gst_video_median_class_init (GstVideoMedianClass * klass)
   gstelement_class = (GstElementClass *) klass;
   vfilter_class = (GstVideoFilterClass *) klass;
 
+  gobject_class->finalize = gst_video_median_finalize;
   gobject_class->set_property = gst_video_median_set_property;
   gobject_class->get_property = gst_video_median_get_property;
 
+  /**
+   * GstVideoMedian:filtersize:
+   *
+   * The number of pixels the median is taken from. 5 uses the pixel and its
+   * horizontal and vertical neighbours, the other sizes use a square window
+   * around the pixel: 3x3, 5x5, 7x7 and 9x9. The square windows larger than
+   * 3x3 are available since 1.4.
+   */
   g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_FILTERSIZE,
       g_param_spec_enum ("filtersize", "Filtersize", "The size of the filter",
           GST_TYPE_VIDEO_MEDIAN_SIZE, DEFAULT_FILTERSIZE,
@@ -129,21 +147,126 @@ gst_video_median_init (GstVideoMedian * median)
   median->lum_only = DEFAULT_LUM_ONLY;
 }
 
+static void
+gst_video_median_finalize (GObject * object)
+{
+  GstVideoMedian *median = GST_VIDEO_MEDIAN (object);
+
+  g_free (median->hist);
+  median->hist = NULL;
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 #define PIX_SORT(a,b) { if ((a)>(b)) PIX_SWAP((a),(b)); }
 #define PIX_SWAP(a,b) { unsigned char temp=(a);(a)=(b);(b)=temp; }
 
+/* the sorting networks, p[2] and p[4] are the medians. The SIMD versions
+ * run the same networks with min/max on 16 pixels at a time */
+#define MEDIAN_5_NETWORK(p,SORT) { \
+  SORT (p[0], p[1]); SORT (p[3], p[4]); SORT (p[0], p[3]); \
+  SORT (p[1], p[4]); SORT (p[1], p[2]); SORT (p[2], p[3]); \
+  SORT (p[1], p[2]); \
+}
+
+#define MEDIAN_9_NETWORK(p,SORT) { \
+  SORT (p[1], p[2]); SORT (p[4], p[5]); SORT (p[7], p[8]); \
+  SORT (p[0], p[1]); SORT (p[3], p[4]); SORT (p[6], p[7]); \
+  SORT (p[1], p[2]); SORT (p[4], p[5]); SORT (p[7], p[8]); \
+  SORT (p[0], p[3]); SORT (p[5], p[8]); SORT (p[4], p[7]); \
+  SORT (p[3], p[6]); SORT (p[1], p[4]); SORT (p[2], p[5]); \
+  SORT (p[4], p[7]); SORT (p[4], p[2]); SORT (p[6], p[4]); \
+  SORT (p[4], p[2]); \
+}
+
+#ifdef HAVE_VIDEO_MEDIAN_SSE2
+#define VEC_SORT(a,b) { __m128i temp = _mm_min_epu8 ((a), (b)); \
+  (b) = _mm_max_epu8 ((a), (b)); (a) = temp; }
+#define LOAD(p) _mm_loadu_si128 ((const __m128i *) (p))
+#endif
+
+/* computes dest[1] to dest[width - 2] from the rows above, at and below */
+static void
+median_5_row (guint8 * dest, const guint8 * above, const guint8 * src,
+    const guint8 * below, gint width)
+{
+  unsigned char p[5];
+  gint i = 1;
+
+#ifdef HAVE_VIDEO_MEDIAN_SSE2
+  for (; i + 16 < width; i += 16) {
+    __m128i v[5];
+
+    v[0] = LOAD (above + i);
+    v[1] = LOAD (src + i - 1);
+    v[2] = LOAD (src + i);
+    v[3] = LOAD (src + i + 1);
+    v[4] = LOAD (below + i);
+    MEDIAN_5_NETWORK (v, VEC_SORT);
+    _mm_storeu_si128 ((__m128i *) (dest + i), v[2]);
+  }
+#endif
+
+  for (; i < width - 1; i++) {
+    p[0] = above[i];
+    p[1] = src[i - 1];
+    p[2] = src[i];
+    p[3] = src[i + 1];
+    p[4] = below[i];
+    MEDIAN_5_NETWORK (p, PIX_SORT);
+    dest[i] = p[2];
+  }
+}
+
+static void
+median_9_row (guint8 * dest, const guint8 * above, const guint8 * src,
+    const guint8 * below, gint width)
+{
+  unsigned char p[9];
+  gint i = 1;
+
+#ifdef HAVE_VIDEO_MEDIAN_SSE2
+  for (; i + 16 < width; i += 16) {
+    __m128i v[9];
+
+    v[0] = LOAD (above + i - 1);
+    v[1] = LOAD (above + i);
+    v[2] = LOAD (above + i + 1);
+    v[3] = LOAD (src + i - 1);
+    v[4] = LOAD (src + i);
+    v[5] = LOAD (src + i + 1);
+    v[6] = LOAD (below + i - 1);
+    v[7] = LOAD (below + i);
+    v[8] = LOAD (below + i + 1);
+    MEDIAN_9_NETWORK (v, VEC_SORT);
+    _mm_storeu_si128 ((__m128i *) (dest + i), v[4]);
+  }
+#endif
+
+  for (; i < width - 1; i++) {
+    p[0] = above[i - 1];
+    p[1] = above[i];
+    p[2] = above[i + 1];
+    p[3] = src[i - 1];
+    p[4] = src[i];
+    p[5] = src[i + 1];
+    p[6] = below[i - 1];
+    p[7] = below[i];
+    p[8] = below[i + 1];
+    MEDIAN_9_NETWORK (p, PIX_SORT);
+    dest[i] = p[4];
+  }
+}
+
 static void
 median_5 (guint8 * dest, gint dstride, const guint8 * src, gint sstride,
     gint width, gint height)
 {
-  unsigned char p[5];
-  int i, j, k;
+  gint k;
 
   /* copy the top and bottom rows into the result array */
-  for (i = 0; i < width; i++) {
-    dest[i] = src[i];
-    dest[(height - 1) * dstride + i] = src[(height - 1) * sstride + i];
-  }
+  memcpy (dest, src, width);
+  memcpy (dest + (height - 1) * dstride, src + (height - 1) * sstride, width);
 
   /* process the interior pixels */
   for (k = 2; k < height; k++) {
@@ -151,22 +274,8 @@ median_5 (guint8 * dest, gint dstride, const guint8 * src, gint sstride,
     src += sstride;
 
     dest[0] = src[0];
-    for (j = 2, i = 1; j < width; j++, i++) {
-      p[0] = src[i - sstride];
-      p[1] = src[i - 1];
-      p[2] = src[i];
-      p[3] = src[i + 1];
-      p[4] = src[i + sstride];
-      PIX_SORT (p[0], p[1]);
-      PIX_SORT (p[3], p[4]);
-      PIX_SORT (p[0], p[3]);
-      PIX_SORT (p[1], p[4]);
-      PIX_SORT (p[1], p[2]);
-      PIX_SORT (p[2], p[3]);
-      PIX_SORT (p[1], p[2]);
-      dest[i] = p[2];
-    }
-    dest[i] = src[i];
+    median_5_row (dest, src - sstride, src, src + sstride, width);
+    dest[width - 1] = src[width - 1];
   }
 }
 
@@ -174,52 +283,171 @@ static void
 median_9 (guint8 * dest, gint dstride, const guint8 * src, gint sstride,
     gint width, gint height)
 {
-  unsigned char p[9];
-  int i, j, k;
+  gint k;
 
   /*copy the top and bottom rows into the result array */
-  for (i = 0; i < width; i++) {
-    dest[i] = src[i];
-    dest[(height - 1) * dstride + i] = src[(height - 1) * sstride + i];
-  }
+  memcpy (dest, src, width);
+  memcpy (dest + (height - 1) * dstride, src + (height - 1) * sstride, width);
+
   /* process the interior pixels */
   for (k = 2; k < height; k++) {
     dest += dstride;
     src += sstride;
 
     dest[0] = src[0];
-    for (j = 2, i = 1; j < width; j++, i++) {
-      p[0] = src[i - sstride - 1];
-      p[1] = src[i - sstride];
-      p[2] = src[i - sstride + 1];
-      p[3] = src[i - 1];
-      p[4] = src[i];
-      p[5] = src[i + 1];
-      p[6] = src[i + sstride - 1];
-      p[7] = src[i + sstride];
-      p[8] = src[i + sstride + 1];
-      PIX_SORT (p[1], p[2]);
-      PIX_SORT (p[4], p[5]);
-      PIX_SORT (p[7], p[8]);
-      PIX_SORT (p[0], p[1]);
-      PIX_SORT (p[3], p[4]);
-      PIX_SORT (p[6], p[7]);
-      PIX_SORT (p[1], p[2]);
-      PIX_SORT (p[4], p[5]);
-      PIX_SORT (p[7], p[8]);
-      PIX_SORT (p[0], p[3]);
-      PIX_SORT (p[5], p[8]);
-      PIX_SORT (p[4], p[7]);
-      PIX_SORT (p[3], p[6]);
-      PIX_SORT (p[1], p[4]);
-      PIX_SORT (p[2], p[5]);
-      PIX_SORT (p[4], p[7]);
-      PIX_SORT (p[4], p[2]);
-      PIX_SORT (p[6], p[4]);
-      PIX_SORT (p[4], p[2]);
-      dest[i] = p[4];
+    median_9_row (dest, src - sstride, src, src + sstride, width);
+    dest[width - 1] = src[width - 1];
+  }
+}
+
+/* the histograms have 16 coarse bins for the high nibble followed by the
+ * 256 fine bins */
+#define HIST_COARSE 16
+#define HIST_BINS (HIST_COARSE + 256)
+
+static inline void
+hist_add (guint16 * dest, const guint16 * src)
+{
+  gint i;
+
+#ifdef HAVE_VIDEO_MEDIAN_SSE2
+  for (i = 0; i < HIST_BINS; i += 8)
+    _mm_storeu_si128 ((__m128i *) (dest + i),
+        _mm_add_epi16 (LOAD (dest + i), LOAD (src + i)));
+#else
+  for (i = 0; i < HIST_BINS; i++)
+    dest[i] += src[i];
+#endif
+}
+
+static inline void
+hist_sub (guint16 * dest, const guint16 * src)
+{
+  gint i;
+
+#ifdef HAVE_VIDEO_MEDIAN_SSE2
+  for (i = 0; i < HIST_BINS; i += 8)
+    _mm_storeu_si128 ((__m128i *) (dest + i),
+        _mm_sub_epi16 (LOAD (dest + i), LOAD (src + i)));
+#else
+  for (i = 0; i < HIST_BINS; i++)
+    dest[i] -= src[i];
+#endif
+}
+
+static inline void
+hist_update_row (guint16 * hist, const guint8 * src, gint width, gint delta)
+{
+  gint x;
+
+  for (x = 0; x < width; x++, hist += HIST_BINS) {
+    hist[src[x] >> 4] += delta;
+    hist[HIST_COARSE + src[x]] += delta;
+  }
+}
+
+/* Median of a square window of radius r in constant time per pixel: every
+ * column keeps the histogram of the 2r+1 pixels around the current row, the
+ * window histogram is moved along the row by adding and removing a column
+ * histogram. The median is found by walking the coarse bins first. */
+static void
+median_hist (GstVideoMedian * median, guint8 * dest, gint dstride,
+    const guint8 * src, gint sstride, gint width, gint height, gint r)
+{
+  guint16 kernel[HIST_BINS];
+  guint16 *hist;
+  gint x, y, k, half = (2 * r + 1) * (2 * r + 1) / 2;
+  gsize size = (gsize) width * HIST_BINS * sizeof (guint16);
+
+  if (width < 2 * r + 1 || height < 2 * r + 1) {
+    for (y = 0; y < height; y++)
+      memcpy (dest + y * dstride, src + y * sstride, width);
+    return;
+  }
+
+  if (median->hist_size < size) {
+    g_free (median->hist);
+    median->hist = g_malloc (size);
+    median->hist_size = size;
+  }
+  hist = median->hist;
+  memset (hist, 0, size);
+
+  /* the pixels closer than r to the edges are copied */
+  for (y = 0; y < r; y++) {
+    memcpy (dest + y * dstride, src + y * sstride, width);
+    memcpy (dest + (height - 1 - y) * dstride,
+        src + (height - 1 - y) * sstride, width);
+  }
+
+  for (y = 0; y < 2 * r + 1; y++)
+    hist_update_row (hist, src + y * sstride, width, 1);
+
+  for (y = r; y < height - r; y++) {
+    const guint8 *s = src + y * sstride;
+    guint8 *d = dest + y * dstride;
+
+    if (y > r) {
+      hist_update_row (hist, src + (y - r - 1) * sstride, width, -1);
+      hist_update_row (hist, src + (y + r) * sstride, width, 1);
+    }
+
+    memcpy (d, s, r);
+    memcpy (d + width - r, s + width - r, r);
+
+    memset (kernel, 0, sizeof (kernel));
+    for (x = 0; x < 2 * r + 1; x++)
+      hist_add (kernel, hist + x * HIST_BINS);
+
+    for (x = r; x < width - r; x++) {
+      gint count = 0, c;
+
+      if (x > r) {
+        hist_sub (kernel, hist + (x - r - 1) * HIST_BINS);
+        hist_add (kernel, hist + (x + r) * HIST_BINS);
+      }
+
+      /* the median is the value with more than half of the pixels below
+       * or at it */
+      for (c = 0; count + kernel[c] <= half; c++)
+        count += kernel[c];
+      for (k = c * 16;; k++) {
+        count += kernel[HIST_COARSE + k];
+        if (count > half)
+          break;
+      }
+      d[x] = k;
     }
-    dest[i] = src[i];
+  }
+}
+
+static void
+gst_video_median_plane (GstVideoMedian * median, GstVideoFrame * in_frame,
+    GstVideoFrame * out_frame, gint plane)
+{
+  guint8 *dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, plane);
+  gint dstride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, plane);
+  const guint8 *src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, plane);
+  gint sstride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, plane);
+  gint width = GST_VIDEO_FRAME_COMP_WIDTH (in_frame, plane);
+  gint height = GST_VIDEO_FRAME_COMP_HEIGHT (in_frame, plane);
+
+  switch (median->filtersize) {
+    case GST_VIDEO_MEDIAN_SIZE_5:
+      median_5 (dest, dstride, src, sstride, width, height);
+      break;
+    case GST_VIDEO_MEDIAN_SIZE_9:
+      median_9 (dest, dstride, src, sstride, width, height);
+      break;
+    case GST_VIDEO_MEDIAN_SIZE_25:
+      median_hist (median, dest, dstride, src, sstride, width, height, 2);
+      break;
+    case GST_VIDEO_MEDIAN_SIZE_49:
+      median_hist (median, dest, dstride, src, sstride, width, height, 3);
+      break;
+    case GST_VIDEO_MEDIAN_SIZE_81:
+      median_hist (median, dest, dstride, src, sstride, width, height, 4);
+      break;
   }
 }
 
@@ -229,54 +457,14 @@ gst_video_median_transform_frame (GstVideoFilter * filter,
 {
   GstVideoMedian *median = GST_VIDEO_MEDIAN (filter);
 
-  if (median->filtersize == 5) {
-    median_5 (GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0),
-        GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0),
-        GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0),
-        GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0),
-        GST_VIDEO_FRAME_WIDTH (in_frame), GST_VIDEO_FRAME_HEIGHT (in_frame));
-
-    if (median->lum_only) {
-      gst_video_frame_copy_plane (out_frame, in_frame, 1);
-      gst_video_frame_copy_plane (out_frame, in_frame, 2);
-    } else {
-      median_5 (GST_VIDEO_FRAME_PLANE_DATA (out_frame, 1),
-          GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 1),
-          GST_VIDEO_FRAME_PLANE_DATA (in_frame, 1),
-          GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 1),
-          GST_VIDEO_FRAME_WIDTH (in_frame) / 2,
-          GST_VIDEO_FRAME_HEIGHT (in_frame) / 2);
-      median_5 (GST_VIDEO_FRAME_PLANE_DATA (out_frame, 2),
-          GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 2),
-          GST_VIDEO_FRAME_PLANE_DATA (in_frame, 2),
-          GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 2),
-          GST_VIDEO_FRAME_WIDTH (in_frame) / 2,
-          GST_VIDEO_FRAME_HEIGHT (in_frame) / 2);
-    }
+  gst_video_median_plane (median, in_frame, out_frame, 0);
+
+  if (median->lum_only) {
+    gst_video_frame_copy_plane (out_frame, in_frame, 1);
+    gst_video_frame_copy_plane (out_frame, in_frame, 2);
   } else {
-    median_9 (GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0),
-        GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0),
-        GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0),
-        GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0),
-        GST_VIDEO_FRAME_WIDTH (in_frame), GST_VIDEO_FRAME_HEIGHT (in_frame));
-
-    if (median->lum_only) {
-      gst_video_frame_copy_plane (out_frame, in_frame, 1);
-      gst_video_frame_copy_plane (out_frame, in_frame, 2);
-    } else {
-      median_9 (GST_VIDEO_FRAME_PLANE_DATA (out_frame, 1),
-          GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 1),
-          GST_VIDEO_FRAME_PLANE_DATA (in_frame, 1),
-          GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 1),
-          GST_VIDEO_FRAME_WIDTH (in_frame) / 2,
-          GST_VIDEO_FRAME_HEIGHT (in_frame) / 2);
-      median_9 (GST_VIDEO_FRAME_PLANE_DATA (out_frame, 2),
-          GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 2),
-          GST_VIDEO_FRAME_PLANE_DATA (in_frame, 2),
-          GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 2),
-          GST_VIDEO_FRAME_WIDTH (in_frame) / 2,
-          GST_VIDEO_FRAME_HEIGHT (in_frame) / 2);
-    }
+    gst_video_median_plane (median, in_frame, out_frame, 1);
+    gst_video_median_plane (median, in_frame, out_frame, 2);
   }
 
   return GST_FLOW_OK;
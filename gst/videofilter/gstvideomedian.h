@@ -45,7 +45,10 @@ typedef struct _GstVideoMedianClass GstVideoMedianClass;
 typedef enum
 {
   GST_VIDEO_MEDIAN_SIZE_5 = 5,
-  GST_VIDEO_MEDIAN_SIZE_9 = 9
+  GST_VIDEO_MEDIAN_SIZE_9 = 9,
+  GST_VIDEO_MEDIAN_SIZE_25 = 25,
+  GST_VIDEO_MEDIAN_SIZE_49 = 49,
+  GST_VIDEO_MEDIAN_SIZE_81 = 81
 } GstVideoMedianSize;
 
 struct _GstVideoMedian {
@@ -53,6 +56,10 @@ struct _GstVideoMedian {
 
   GstVideoMedianSize filtersize;
   gboolean lum_only;
+
+  /* column histograms for the larger window sizes */
+  guint16 *hist;
+  gsize hist_size;
 };
 
 struct _GstVideoMedianClass {
@@ -134,58 +134,50 @@ videomixer_videoconvert_convert_convert (VideoConvert * convert,
 #define SCALE    (8)
 #define SCALE_F  ((float) (1 << SCALE))
 
+/* The matrix is applied to one unpacked line at a time. The coefficients
+ * are copied to locals first so that the compiler knows they don't alias
+ * the pixels and can keep them in registers; the loop bodies then have no
+ * loads besides the pixel itself and vectorize. */
+#define MATRIX_LINE(type,max)                                         \
+G_STMT_START {                                                        \
+  const gint m00 = convert->cmatrix[0][0], m01 = convert->cmatrix[0][1]; \
+  const gint m02 = convert->cmatrix[0][2], m03 = convert->cmatrix[0][3]; \
+  const gint m10 = convert->cmatrix[1][0], m11 = convert->cmatrix[1][1]; \
+  const gint m12 = convert->cmatrix[1][2], m13 = convert->cmatrix[1][3]; \
+  const gint m20 = convert->cmatrix[2][0], m21 = convert->cmatrix[2][1]; \
+  const gint m22 = convert->cmatrix[2][2], m23 = convert->cmatrix[2][3]; \
+  const gint width = convert->width;                                  \
+  type *p = pixels;                                                   \
+  gint i;                                                             \
+                                                                      \
+  for (i = 0; i < width; i++, p += 4) {                               \
+    gint r = p[1], g = p[2], b = p[3];                                \
+    gint y, u, v;                                                     \
+                                                                      \
+    y = (m00 * r + m01 * g + m02 * b + m03) >> SCALE;                 \
+    u = (m10 * r + m11 * g + m12 * b + m13) >> SCALE;                 \
+    v = (m20 * r + m21 * g + m22 * b + m23) >> SCALE;                 \
+                                                                      \
+    p[1] = CLAMP (y, 0, max);                                         \
+    p[2] = CLAMP (u, 0, max);                                         \
+    p[3] = CLAMP (v, 0, max);                                         \
+  }                                                                   \
+} G_STMT_END
+
 static void
 videomixer_videoconvert_convert_matrix8 (VideoConvert * convert,
     gpointer pixels)
 {
-  int i;
-  int r, g, b;
-  int y, u, v;
-  guint8 *p = pixels;
-
-  for (i = 0; i < convert->width; i++) {
-    r = p[i * 4 + 1];
-    g = p[i * 4 + 2];
-    b = p[i * 4 + 3];
-
-    y = (convert->cmatrix[0][0] * r + convert->cmatrix[0][1] * g +
-        convert->cmatrix[0][2] * b + convert->cmatrix[0][3]) >> SCALE;
-    u = (convert->cmatrix[1][0] * r + convert->cmatrix[1][1] * g +
-        convert->cmatrix[1][2] * b + convert->cmatrix[1][3]) >> SCALE;
-    v = (convert->cmatrix[2][0] * r + convert->cmatrix[2][1] * g +
-        convert->cmatrix[2][2] * b + convert->cmatrix[2][3]) >> SCALE;
-
-    p[i * 4 + 1] = CLAMP (y, 0, 255);
-    p[i * 4 + 2] = CLAMP (u, 0, 255);
-    p[i * 4 + 3] = CLAMP (v, 0, 255);
-  }
+  MATRIX_LINE (guint8, 255);
 }
 
 static void
 videomixer_videoconvert_convert_matrix16 (VideoConvert * convert,
     gpointer pixels)
 {
-  int i;
-  int r, g, b;
-  int y, u, v;
-  guint16 *p = pixels;
-
-  for (i = 0; i < convert->width; i++) {
-    r = p[i * 4 + 1];
-    g = p[i * 4 + 2];
-    b = p[i * 4 + 3];
-
-    y = (convert->cmatrix[0][0] * r + convert->cmatrix[0][1] * g +
-        convert->cmatrix[0][2] * b + convert->cmatrix[0][3]) >> SCALE;
-    u = (convert->cmatrix[1][0] * r + convert->cmatrix[1][1] * g +
-        convert->cmatrix[1][2] * b + convert->cmatrix[1][3]) >> SCALE;
-    v = (convert->cmatrix[2][0] * r + convert->cmatrix[2][1] * g +
-        convert->cmatrix[2][2] * b + convert->cmatrix[2][3]) >> SCALE;
-
-    p[i * 4 + 1] = CLAMP (y, 0, 65535);
-    p[i * 4 + 2] = CLAMP (u, 0, 65535);
-    p[i * 4 + 3] = CLAMP (v, 0, 65535);
-  }
+  /* 16 bit components times 8.8 fixed point coefficients still fit an int
+   * for the coefficients a colour matrix can produce */
+  MATRIX_LINE (guint16, 65535);
 }
 
 static gboolean
@@ -170,6 +170,13 @@ gst_videomixer2_collect_free (GstCollectData * data)
   gst_buffer_replace (&cdata->buffer, NULL);
 }
 
+static void
+gst_videomixer2_pad_clear_converted (GstVideoMixer2Pad * pad)
+{
+  gst_buffer_replace (&pad->converted_buffer, NULL);
+  gst_buffer_replace (&pad->converted_source, NULL);
+}
+
 static gboolean gst_videomixer2_src_setcaps (GstPad * pad, GstVideoMixer2 * mix,
     GstCaps * caps);
 
@@ -419,6 +426,7 @@ gst_videomixer2_update_converters (GstVideoMixer2 * mix)
       videomixer_videoconvert_convert_free (pad->convert);
 
     pad->convert = NULL;
+    gst_videomixer2_pad_clear_converted (pad);
 
     colorimetry = gst_video_colorimetry_to_string (&(pad->info.colorimetry));
     chroma = gst_video_chroma_to_string (pad->info.chroma_site);
@@ -740,10 +748,12 @@ gst_videomixer2_pad_init (GstVideoMixer2Pad * mixerpad)
 
 /* GstVideoMixer2 */
 #define DEFAULT_BACKGROUND VIDEO_MIXER2_BACKGROUND_CHECKER
+#define DEFAULT_N_THREADS 1
 enum
 {
   PROP_0,
-  PROP_BACKGROUND
+  PROP_BACKGROUND,
+  PROP_N_THREADS
 };
 
 #define GST_TYPE_VIDEO_MIXER2_BACKGROUND (gst_videomixer2_background_get_type())
@@ -815,6 +825,22 @@ gst_videomixer2_read_qos (GstVideoMixer2 * mix, gdouble * proportion,
   GST_OBJECT_UNLOCK (mix);
 }
 
+static void
+gst_videomixer2_set_pool (GstVideoMixer2 * mix, GstBufferPool * pool)
+{
+  GstBufferPool *old;
+
+  GST_VIDEO_MIXER2_LOCK (mix);
+  old = mix->pool;
+  mix->pool = pool;
+  GST_VIDEO_MIXER2_UNLOCK (mix);
+
+  if (old) {
+    gst_buffer_pool_set_active (old, FALSE);
+    gst_object_unref (old);
+  }
+}
+
 static void
 gst_videomixer2_reset (GstVideoMixer2 * mix)
 {
@@ -829,6 +855,9 @@ gst_videomixer2_reset (GstVideoMixer2 * mix)
 
   gst_videomixer2_reset_qos (mix);
 
+  gst_videomixer2_set_pool (mix, NULL);
+  gst_buffer_replace (&mix->background_buf, NULL);
+
   for (l = mix->sinkpads; l; l = l->next) {
     GstVideoMixer2Pad *p = l->data;
     GstVideoMixer2Collect *mixcol = p->mixcol;
@@ -836,6 +865,7 @@ gst_videomixer2_reset (GstVideoMixer2 * mix)
     gst_buffer_replace (&mixcol->buffer, NULL);
     mixcol->start_time = -1;
     mixcol->end_time = -1;
+    gst_videomixer2_pad_clear_converted (p);
 
     gst_video_info_init (&p->info);
   }
@@ -843,14 +873,90 @@ gst_videomixer2_reset (GstVideoMixer2 * mix)
   mix->newseg_pending = TRUE;
 }
 
+/* A QoS event for the upstream of one sink pad, pushed once the mixer lock
+ * is released */
+typedef struct
+{
+  GstPad *pad;
+  GstEvent *event;
+} GstVideoMixer2PadQoS;
+
+/* Input buffers of @pad are dropped because they end before @earliest, the
+ * QoS earliest time of the output. Tell upstream about it so it can skip
+ * producing them. @timestamp and @earliest are in output running time */
+static void
+gst_videomixer2_queue_pad_qos (GstVideoMixer2 * mix, GstVideoMixer2Pad * pad,
+    GstClockTime timestamp, GstClockTime earliest, GSList ** qos_events)
+{
+  GstVideoMixer2PadQoS *qos = NULL;
+  GstClockTime unused;
+  GstClockTimeDiff jitter;
+  gdouble proportion;
+  GSList *l;
+
+  /* convert back to the running time of the input */
+  if (ABS (mix->segment.rate) != 1.0) {
+    timestamp /= ABS (mix->segment.rate);
+    earliest /= ABS (mix->segment.rate);
+  }
+
+  jitter = GST_CLOCK_DIFF (timestamp, earliest);
+  if (jitter <= 0)
+    return;
+
+  gst_videomixer2_read_qos (mix, &proportion, &unused);
+
+  GST_DEBUG_OBJECT (pad, "input is late by %" GST_TIME_FORMAT
+      " at %" GST_TIME_FORMAT, GST_TIME_ARGS (jitter),
+      GST_TIME_ARGS (timestamp));
+
+  /* only the latest observation of a pad is worth sending */
+  for (l = *qos_events; l; l = l->next) {
+    if (((GstVideoMixer2PadQoS *) l->data)->pad == GST_PAD_CAST (pad)) {
+      qos = l->data;
+      gst_event_unref (qos->event);
+      break;
+    }
+  }
+  if (!qos) {
+    qos = g_slice_new (GstVideoMixer2PadQoS);
+    qos->pad = gst_object_ref (pad);
+    *qos_events = g_slist_prepend (*qos_events, qos);
+  }
+
+  qos->event =
+      gst_event_new_qos (GST_QOS_TYPE_UNDERFLOW, proportion, jitter,
+      timestamp);
+}
+
+static void
+gst_videomixer2_push_pad_qos (GSList * qos_events)
+{
+  GSList *l;
+
+  for (l = qos_events; l; l = l->next) {
+    GstVideoMixer2PadQoS *qos = l->data;
+
+    gst_pad_push_event (qos->pad, qos->event);
+    gst_object_unref (qos->pad);
+    g_slice_free (GstVideoMixer2PadQoS, qos);
+  }
+  g_slist_free (qos_events);
+}
+
 /*  1 == OK
  *  0 == need more data
  * -1 == EOS
  * -2 == error
+ *
+ * If @late_until is valid all output frames before it are going to be
+ * dropped, input buffers that end before it are then discarded right away
+ * instead of being taken for a frame that is never blended.
  */
 static gint
 gst_videomixer2_fill_queues (GstVideoMixer2 * mix,
-    GstClockTime output_start_time, GstClockTime output_end_time)
+    GstClockTime output_start_time, GstClockTime output_end_time,
+    GstClockTime late_until, GSList ** qos_events)
 {
   GSList *l;
   gboolean eos = TRUE;
@@ -959,6 +1065,24 @@ gst_videomixer2_fill_queues (GstVideoMixer2 * mix,
         continue;
       }
 
+      if (GST_CLOCK_TIME_IS_VALID (late_until) && end_time < late_until) {
+        GST_DEBUG_OBJECT (pad, "Buffer ends before the QoS earliest time %"
+            GST_TIME_FORMAT " -- dropping", GST_TIME_ARGS (late_until));
+        gst_videomixer2_queue_pad_qos (mix, pad, start_time, late_until,
+            qos_events);
+        if (buf == mixcol->queued) {
+          gst_buffer_unref (buf);
+          gst_buffer_replace (&mixcol->queued, NULL);
+        } else {
+          gst_buffer_unref (buf);
+          buf = gst_collect_pads_pop (mix->collect, &mixcol->collect);
+          gst_buffer_unref (buf);
+        }
+
+        need_more_data = TRUE;
+        continue;
+      }
+
       if (end_time >= output_start_time && start_time < output_end_time) {
         GST_DEBUG_OBJECT (pad,
             "Taking new buffer with start time %" GST_TIME_FORMAT,
@@ -1020,73 +1144,362 @@ gst_videomixer2_fill_queues (GstVideoMixer2 * mix,
   return 1;
 }
 
-static GstFlowReturn
-gst_videomixer2_blend_buffers (GstVideoMixer2 * mix,
-    GstClockTime output_start_time, GstClockTime output_end_time,
-    GstBuffer ** outbuf)
+/* One input of the frame being blended, already converted to the output
+ * format */
+typedef struct
 {
-  GSList *l;
-  guint outsize;
+  GstVideoFrame frame;
+  gint xpos, ypos;
+  gdouble alpha;
+  /* covers the full width of the output and hides the background */
+  gboolean opaque;
+} GstVideoMixer2BlendInput;
+
+typedef struct
+{
+  GstVideoMixer2 *mix;
+  GstVideoFrame *outframe;
+  /* pre-rendered background, NULL for a transparent background */
+  GstVideoFrame *background;
+  GstVideoMixer2BlendInput *inputs;
+  guint n_inputs;
   BlendFunction composite;
+  gint pending;
+} GstVideoMixer2BlendJob;
+
+typedef struct
+{
+  GstVideoMixer2BlendJob *job;
+  gint y, height;
+} GstVideoMixer2BlendBand;
+
+/* bands start on a multiple of this, it keeps the chroma planes of all
+ * subsampled formats and the checker pattern aligned */
+#define BAND_ALIGN 16
+
+/* make @band a view on the lines [@y, @y + @height) of @frame */
+static void
+gst_videomixer2_frame_band (GstVideoFrame * frame, gint y, gint height,
+    GstVideoFrame * band)
+{
+  const GstVideoFormatInfo *finfo = frame->info.finfo;
+  guint plane, comp;
+
+  *band = *frame;
+  band->info.height = height;
+
+  if (y == 0)
+    return;
+
+  for (plane = 0; plane < GST_VIDEO_FRAME_N_PLANES (frame); plane++) {
+    for (comp = 0; comp < GST_VIDEO_FRAME_N_COMPONENTS (frame); comp++) {
+      if (GST_VIDEO_FORMAT_INFO_PLANE (finfo, comp) == plane)
+        break;
+    }
+    band->data[plane] = (guint8 *) frame->data[plane] +
+        GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (finfo, comp, y) *
+        GST_VIDEO_FRAME_PLANE_STRIDE (frame, plane);
+  }
+}
+
+/* Number of lines of @plane in @frame */
+static gint
+gst_videomixer2_plane_height (GstVideoFrame * frame, guint plane)
+{
+  const GstVideoFormatInfo *finfo = frame->info.finfo;
+  guint comp;
+
+  for (comp = 0; comp < GST_VIDEO_FRAME_N_COMPONENTS (frame); comp++) {
+    if (GST_VIDEO_FORMAT_INFO_PLANE (finfo, comp) == plane)
+      break;
+  }
+
+  return GST_VIDEO_FRAME_COMP_HEIGHT (frame, comp);
+}
+
+/* Fill the lines [@y, @y + @height) of the output with the background */
+static void
+gst_videomixer2_fill_band (GstVideoMixer2BlendJob * job, gint y, gint height)
+{
   GstVideoFrame outframe;
-  static GstAllocationParams params = { 0, 15, 0, 0, };
+  guint plane, num_planes;
+
+  gst_videomixer2_frame_band (job->outframe, y, height, &outframe);
+  num_planes = GST_VIDEO_FRAME_N_PLANES (&outframe);
+
+  if (job->background) {
+    GstVideoFrame bgframe;
+
+    /* copy from the pre-rendered background, it has the same layout as the
+     * output so every band of a plane is one contiguous block */
+    gst_videomixer2_frame_band (job->background, y, height, &bgframe);
+    for (plane = 0; plane < num_planes; ++plane) {
+      memcpy (GST_VIDEO_FRAME_PLANE_DATA (&outframe, plane),
+          GST_VIDEO_FRAME_PLANE_DATA (&bgframe, plane),
+          GST_VIDEO_FRAME_PLANE_STRIDE (&outframe, plane) *
+          gst_videomixer2_plane_height (&outframe, plane));
+    }
+  } else {
+    guint i, comp_height;
+
+    for (plane = 0; plane < num_planes; ++plane) {
+      guint8 *pdata;
+      gsize rowsize, plane_stride;
+
+      pdata = GST_VIDEO_FRAME_PLANE_DATA (&outframe, plane);
+      plane_stride = GST_VIDEO_FRAME_PLANE_STRIDE (&outframe, plane);
+      rowsize = GST_VIDEO_FRAME_COMP_WIDTH (&outframe, plane)
+          * GST_VIDEO_FRAME_COMP_PSTRIDE (&outframe, plane);
+      comp_height = GST_VIDEO_FRAME_COMP_HEIGHT (&outframe, plane);
+      for (i = 0; i < comp_height; ++i) {
+        memset (pdata, 0, rowsize);
+        pdata += plane_stride;
+      }
+    }
+  }
+}
 
-  outsize = GST_VIDEO_INFO_SIZE (&mix->info);
+/* Returns the end of the run of lines starting at @y that are completely
+ * hidden by opaque inputs, @y if the line is visible */
+static gint
+gst_videomixer2_covered_until (GstVideoMixer2BlendJob * job, gint y)
+{
+  gboolean found;
+  guint i;
 
-  *outbuf = gst_buffer_new_allocate (NULL, outsize, &params);
-  GST_BUFFER_TIMESTAMP (*outbuf) = output_start_time;
-  GST_BUFFER_DURATION (*outbuf) = output_end_time - output_start_time;
+  do {
+    found = FALSE;
+    for (i = 0; i < job->n_inputs; i++) {
+      GstVideoMixer2BlendInput *input = &job->inputs[i];
+      gint end;
 
-  gst_video_frame_map (&outframe, &mix->info, *outbuf, GST_MAP_READWRITE);
+      if (!input->opaque)
+        continue;
 
-  /* default to blending */
-  composite = mix->blend;
+      end = input->ypos + GST_VIDEO_FRAME_HEIGHT (&input->frame);
+      if (input->ypos <= y && end > y) {
+        y = end;
+        found = TRUE;
+      }
+    }
+  } while (found);
+
+  return y;
+}
+
+/* Returns the first line after @y that is hidden by an opaque input or
+ * @end */
+static gint
+gst_videomixer2_visible_until (GstVideoMixer2BlendJob * job, gint y, gint end)
+{
+  guint i;
+
+  for (i = 0; i < job->n_inputs; i++) {
+    GstVideoMixer2BlendInput *input = &job->inputs[i];
+
+    if (input->opaque && input->ypos > y && input->ypos < end)
+      end = input->ypos;
+  }
+
+  return end;
+}
+
+static void
+gst_videomixer2_blend_band (GstVideoMixer2BlendJob * job, gint y, gint height)
+{
+  GstVideoFrame outframe;
+  gint line, end;
+  guint i;
+
+  /* paint the background only where no opaque input hides it. The visible
+   * runs are widened to BAND_ALIGN so the fill functions stay aligned, the
+   * extra lines are painted over by the inputs afterwards. */
+  end = y + height;
+  line = y;
+  while (line < end) {
+    gint start, stop;
+
+    line = gst_videomixer2_covered_until (job, line);
+    if (line >= end)
+      break;
+
+    stop = gst_videomixer2_visible_until (job, line, end);
+    start = line & ~(BAND_ALIGN - 1);
+    gst_videomixer2_fill_band (job, start,
+        MIN ((stop + BAND_ALIGN - 1) & ~(BAND_ALIGN - 1), end) - start);
+    line = stop;
+  }
+
+  gst_videomixer2_frame_band (job->outframe, y, height, &outframe);
+
+  for (i = 0; i < job->n_inputs; i++) {
+    GstVideoMixer2BlendInput *input = &job->inputs[i];
+
+    /* skip inputs that don't cover this band */
+    if (input->ypos >= y + height ||
+        input->ypos + GST_VIDEO_FRAME_HEIGHT (&input->frame) <= y)
+      continue;
+
+    job->composite (&input->frame, input->xpos, input->ypos - y,
+        input->alpha, &outframe);
+  }
+}
+
+static void
+gst_videomixer2_blend_band_func (GstVideoMixer2BlendBand * band,
+    GstVideoMixer2 * mix)
+{
+  GstVideoMixer2BlendJob *job = band->job;
+
+  gst_videomixer2_blend_band (job, band->y, band->height);
+
+  g_mutex_lock (&mix->blend_lock);
+  if (--job->pending == 0)
+    g_cond_signal (&mix->blend_cond);
+  g_mutex_unlock (&mix->blend_lock);
+}
+
+/* Number of bands the output frame is split into */
+static guint
+gst_videomixer2_get_n_bands (GstVideoMixer2 * mix, gint height)
+{
+  guint n_threads, n_bands;
+
+  n_threads = mix->n_threads;
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  n_bands = MIN (n_threads, (height + BAND_ALIGN - 1) / BAND_ALIGN);
+  if (n_bands <= 1)
+    return 1;
+
+  if (mix->blend_pool == NULL) {
+    GError *err = NULL;
+
+    mix->blend_pool =
+        g_thread_pool_new ((GFunc) gst_videomixer2_blend_band_func, mix,
+        n_bands - 1, FALSE, &err);
+    if (mix->blend_pool == NULL) {
+      GST_WARNING_OBJECT (mix, "failed to create blend threads: %s",
+          err->message);
+      g_clear_error (&err);
+      return 1;
+    }
+  } else if (g_thread_pool_get_max_threads (mix->blend_pool) != n_bands - 1) {
+    g_thread_pool_set_max_threads (mix->blend_pool, n_bands - 1, NULL);
+  }
+
+  return n_bands;
+}
+
+/* Returns the background rendered for the current output format, it is only
+ * redrawn when the format or the background type change. NULL for a
+ * transparent background. Must be called with the mixer lock. */
+static GstBuffer *
+gst_videomixer2_get_background (GstVideoMixer2 * mix)
+{
+  GstVideoFrame frame;
+  static GstAllocationParams params = { 0, 15, 0, 0, };
+
+  if (mix->background == VIDEO_MIXER2_BACKGROUND_TRANSPARENT)
+    return NULL;
+
+  if (mix->background_buf != NULL &&
+      mix->background_buf_type == mix->background &&
+      GST_VIDEO_INFO_FORMAT (&mix->background_buf_info) ==
+      GST_VIDEO_INFO_FORMAT (&mix->info) &&
+      GST_VIDEO_INFO_WIDTH (&mix->background_buf_info) ==
+      GST_VIDEO_INFO_WIDTH (&mix->info) &&
+      GST_VIDEO_INFO_HEIGHT (&mix->background_buf_info) ==
+      GST_VIDEO_INFO_HEIGHT (&mix->info))
+    return mix->background_buf;
+
+  GST_DEBUG_OBJECT (mix, "rendering background");
+
+  gst_buffer_replace (&mix->background_buf, NULL);
+  mix->background_buf = gst_buffer_new_allocate (NULL,
+      GST_VIDEO_INFO_SIZE (&mix->info), &params);
+  mix->background_buf_type = mix->background;
+  mix->background_buf_info = mix->info;
+
+  gst_video_frame_map (&frame, &mix->info, mix->background_buf,
+      GST_MAP_WRITE);
   switch (mix->background) {
     case VIDEO_MIXER2_BACKGROUND_CHECKER:
-      mix->fill_checker (&outframe);
+      mix->fill_checker (&frame);
       break;
     case VIDEO_MIXER2_BACKGROUND_BLACK:
-      mix->fill_color (&outframe, 16, 128, 128);
+      mix->fill_color (&frame, 16, 128, 128);
       break;
     case VIDEO_MIXER2_BACKGROUND_WHITE:
-      mix->fill_color (&outframe, 240, 128, 128);
+      mix->fill_color (&frame, 240, 128, 128);
       break;
-    case VIDEO_MIXER2_BACKGROUND_TRANSPARENT:
-    {
-      guint i, plane, num_planes, height;
-
-      num_planes = GST_VIDEO_FRAME_N_PLANES (&outframe);
-      for (plane = 0; plane < num_planes; ++plane) {
-        guint8 *pdata;
-        gsize rowsize, plane_stride;
-
-        pdata = GST_VIDEO_FRAME_PLANE_DATA (&outframe, plane);
-        plane_stride = GST_VIDEO_FRAME_PLANE_STRIDE (&outframe, plane);
-        rowsize = GST_VIDEO_FRAME_COMP_WIDTH (&outframe, plane)
-            * GST_VIDEO_FRAME_COMP_PSTRIDE (&outframe, plane);
-        height = GST_VIDEO_FRAME_COMP_HEIGHT (&outframe, plane);
-        for (i = 0; i < height; ++i) {
-          memset (pdata, 0, rowsize);
-          pdata += plane_stride;
-        }
-      }
-
-      /* use overlay to keep background transparent */
-      composite = mix->overlay;
+    default:
+      g_assert_not_reached ();
       break;
-    }
   }
+  gst_video_frame_unmap (&frame);
+
+  return mix->background_buf;
+}
+
+static GstFlowReturn
+gst_videomixer2_blend_buffers (GstVideoMixer2 * mix,
+    GstClockTime output_start_time, GstClockTime output_end_time,
+    GstBuffer ** outbuf)
+{
+  GSList *l;
+  guint outsize;
+  GstVideoFrame outframe, bgframe;
+  GstVideoMixer2BlendJob job;
+  GstBuffer *background;
+  guint i, n_bands;
+  gint width, height;
+  static GstAllocationParams params = { 0, 15, 0, 0, };
+
+  outsize = GST_VIDEO_INFO_SIZE (&mix->info);
+
+  *outbuf = NULL;
+  if (mix->pool && gst_buffer_pool_acquire_buffer (mix->pool, outbuf,
+          NULL) != GST_FLOW_OK)
+    *outbuf = NULL;
+  if (*outbuf == NULL)
+    *outbuf = gst_buffer_new_allocate (NULL, outsize, &params);
+  GST_BUFFER_TIMESTAMP (*outbuf) = output_start_time;
+  GST_BUFFER_DURATION (*outbuf) = output_end_time - output_start_time;
+
+  gst_video_frame_map (&outframe, &mix->info, *outbuf, GST_MAP_READWRITE);
+  width = GST_VIDEO_FRAME_WIDTH (&outframe);
+  height = GST_VIDEO_FRAME_HEIGHT (&outframe);
+
+  job.mix = mix;
+  job.outframe = &outframe;
+  job.background = NULL;
+  background = gst_videomixer2_get_background (mix);
+  if (background) {
+    gst_video_frame_map (&bgframe, &mix->info, background, GST_MAP_READ);
+    job.background = &bgframe;
+  }
+  job.inputs = g_newa (GstVideoMixer2BlendInput, mix->numpads);
+  job.n_inputs = 0;
+  /* use overlay to keep a transparent background transparent, default to
+   * blending */
+  if (mix->background == VIDEO_MIXER2_BACKGROUND_TRANSPARENT)
+    job.composite = mix->overlay;
+  else
+    job.composite = mix->blend;
 
+  /* property sync and conversion are done here, only the blending itself is
+   * spread over the bands */
   for (l = mix->sinkpads; l; l = l->next) {
     GstVideoMixer2Pad *pad = l->data;
     GstVideoMixer2Collect *mixcol = pad->mixcol;
 
     if (mixcol->buffer != NULL) {
+      GstVideoMixer2BlendInput *input = &job.inputs[job.n_inputs];
       GstClockTime timestamp;
       gint64 stream_time;
       GstSegment *seg;
-      GstVideoFrame converted_frame;
-      GstBuffer *converted_buf = NULL;
       GstVideoFrame frame;
 
       seg = &mixcol->collect.segment;
@@ -1100,12 +1513,7 @@ gst_videomixer2_blend_buffers (GstVideoMixer2 * mix,
       if (GST_CLOCK_TIME_IS_VALID (stream_time))
         gst_object_sync_values (GST_OBJECT (pad), stream_time);
 
-      gst_video_frame_map (&frame, &mixcol->buffer_vinfo, mixcol->buffer,
-          GST_MAP_READ);
-
       if (pad->convert) {
-        gint converted_size;
-
         /* We wait until here to set the conversion infos, in case mix->info changed */
         if (pad->need_conversion_update) {
           pad->conversion_info = mix->info;
@@ -1113,29 +1521,93 @@ gst_videomixer2_blend_buffers (GstVideoMixer2 * mix,
               GST_VIDEO_INFO_FORMAT (&mix->info), pad->info.width,
               pad->info.height);
           pad->need_conversion_update = FALSE;
+          gst_videomixer2_pad_clear_converted (pad);
         }
 
-        converted_size = pad->conversion_info.size;
-        converted_size = converted_size > outsize ? converted_size : outsize;
-        converted_buf = gst_buffer_new_allocate (NULL, converted_size, &params);
+        /* a repeated input buffer reuses the frame converted last time */
+        if (pad->converted_buffer == NULL
+            || pad->converted_source != mixcol->buffer) {
+          GstVideoFrame converted_frame;
+          GstBuffer *converted_buf;
+          gint converted_size;
+
+          converted_size = pad->conversion_info.size;
+          converted_size = converted_size > outsize ? converted_size : outsize;
+          converted_buf =
+              gst_buffer_new_allocate (NULL, converted_size, &params);
+
+          gst_video_frame_map (&frame, &mixcol->buffer_vinfo, mixcol->buffer,
+              GST_MAP_READ);
+          gst_video_frame_map (&converted_frame, &(pad->conversion_info),
+              converted_buf, GST_MAP_WRITE);
+          videomixer_videoconvert_convert_convert (pad->convert,
+              &converted_frame, &frame);
+          gst_video_frame_unmap (&converted_frame);
+          gst_video_frame_unmap (&frame);
+
+          gst_videomixer2_pad_clear_converted (pad);
+          /* keep the source alive so its address can't be reused by
+           * another buffer while it is the key of the cache */
+          pad->converted_source = gst_buffer_ref (mixcol->buffer);
+          pad->converted_buffer = converted_buf;
+        } else {
+          GST_LOG_OBJECT (pad, "reusing converted frame");
+        }
 
-        gst_video_frame_map (&converted_frame, &(pad->conversion_info),
-            converted_buf, GST_MAP_READWRITE);
-        videomixer_videoconvert_convert_convert (pad->convert, &converted_frame,
-            &frame);
-        gst_video_frame_unmap (&frame);
+        gst_video_frame_map (&input->frame, &(pad->conversion_info),
+            pad->converted_buffer, GST_MAP_READ);
       } else {
-        converted_frame = frame;
+        gst_video_frame_map (&input->frame, &mixcol->buffer_vinfo,
+            mixcol->buffer, GST_MAP_READ);
       }
 
-      composite (&converted_frame, pad->xpos, pad->ypos, pad->alpha, &outframe);
+      input->xpos = pad->xpos;
+      input->ypos = pad->ypos;
+      input->alpha = pad->alpha;
+      /* blending at alpha 1.0 is a plain copy when the output has no alpha
+       * channel, so a full width input hides the background completely */
+      input->opaque = pad->alpha == 1.0
+          && !GST_VIDEO_INFO_HAS_ALPHA (&mix->info) && pad->xpos <= 0
+          && pad->xpos + GST_VIDEO_FRAME_WIDTH (&input->frame) >= width;
+      job.n_inputs++;
+    }
+  }
 
-      if (pad->convert)
-        gst_buffer_unref (converted_buf);
+  n_bands = gst_videomixer2_get_n_bands (mix, height);
 
-      gst_video_frame_unmap (&converted_frame);
+  if (n_bands == 1) {
+    gst_videomixer2_blend_band (&job, 0, height);
+  } else {
+    GstVideoMixer2BlendBand *bands;
+    gint band_height;
+
+    band_height = (height + n_bands - 1) / n_bands;
+    band_height = (band_height + BAND_ALIGN - 1) & ~(BAND_ALIGN - 1);
+    n_bands = (height + band_height - 1) / band_height;
+
+    bands = g_newa (GstVideoMixer2BlendBand, n_bands);
+    job.pending = n_bands - 1;
+
+    for (i = 0; i < n_bands; i++) {
+      bands[i].job = &job;
+      bands[i].y = i * band_height;
+      bands[i].height = MIN (band_height, height - bands[i].y);
+      /* the first band is blended by this thread */
+      if (i > 0)
+        g_thread_pool_push (mix->blend_pool, &bands[i], NULL);
     }
+    gst_videomixer2_blend_band (&job, bands[0].y, bands[0].height);
+
+    g_mutex_lock (&mix->blend_lock);
+    while (job.pending > 0)
+      g_cond_wait (&mix->blend_cond, &mix->blend_lock);
+    g_mutex_unlock (&mix->blend_lock);
   }
+
+  for (i = 0; i < job.n_inputs; i++)
+    gst_video_frame_unmap (&job.inputs[i].frame);
+  if (job.background)
+    gst_video_frame_unmap (&bgframe);
   gst_video_frame_unmap (&outframe);
 
   return GST_FLOW_OK;
@@ -1183,14 +1655,73 @@ gst_videomixer2_do_qos (GstVideoMixer2 * mix, GstClockTime timestamp)
   return jitter;
 }
 
+/* Negotiate a buffer pool for the output frames with downstream, falling
+ * back to a pool of our own */
+static void
+gst_videomixer2_decide_allocation (GstVideoMixer2 * mix, GstCaps * caps)
+{
+  GstQuery *query;
+  GstBufferPool *pool = NULL;
+  GstAllocator *allocator = NULL;
+  GstAllocationParams params;
+  GstStructure *config;
+  GstVideoInfo info;
+  guint size, min, max;
+
+  if (!gst_video_info_from_caps (&info, caps))
+    return;
+
+  query = gst_query_new_allocation (caps, TRUE);
+  if (!gst_pad_peer_query (mix->srcpad, query))
+    GST_DEBUG_OBJECT (mix, "ALLOCATION query failed");
+
+  if (gst_query_get_n_allocation_params (query) > 0) {
+    gst_query_parse_nth_allocation_param (query, 0, &allocator, &params);
+  } else {
+    gst_allocation_params_init (&params);
+  }
+  /* the blend functions like 16 byte aligned lines */
+  params.align = MAX (params.align, 15);
+
+  if (gst_query_get_n_allocation_pools (query) > 0) {
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+    size = MAX (size, info.size);
+  } else {
+    size = info.size;
+    min = max = 0;
+  }
+  gst_query_unref (query);
+
+  if (pool == NULL)
+    pool = gst_video_buffer_pool_new ();
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps, size, min, max);
+  gst_buffer_pool_config_set_allocator (config, allocator, &params);
+  if (allocator)
+    gst_object_unref (allocator);
+
+  if (!gst_buffer_pool_set_config (pool, config) ||
+      !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (mix, "failed to configure buffer pool");
+    gst_object_unref (pool);
+    pool = NULL;
+  }
+
+  GST_DEBUG_OBJECT (mix, "using buffer pool %" GST_PTR_FORMAT, pool);
+  gst_videomixer2_set_pool (mix, pool);
+}
+
 static GstFlowReturn
 gst_videomixer2_collected (GstCollectPads * pads, GstVideoMixer2 * mix)
 {
   GstFlowReturn ret;
-  GstClockTime output_start_time, output_end_time;
+  GstClockTime output_start_time, output_end_time, late_until;
   GstBuffer *outbuf = NULL;
+  GSList *qos_events = NULL;
   gint res;
   gint64 jitter;
+  gboolean reconfigure;
 
   /* If we're not negotiated yet... */
   if (GST_VIDEO_INFO_FORMAT (&mix->info) == GST_VIDEO_FORMAT_UNKNOWN)
@@ -1207,7 +1738,8 @@ gst_videomixer2_collected (GstCollectPads * pads, GstVideoMixer2 * mix)
     mix->send_stream_start = FALSE;
   }
 
-  if (gst_pad_check_reconfigure (mix->srcpad))
+  reconfigure = gst_pad_check_reconfigure (mix->srcpad);
+  if (reconfigure)
     gst_videomixer2_update_src_caps (mix);
 
   if (mix->send_caps) {
@@ -1216,8 +1748,12 @@ gst_videomixer2_collected (GstCollectPads * pads, GstVideoMixer2 * mix)
       GST_WARNING_OBJECT (mix->srcpad, "Sending caps event failed");
     }
     mix->send_caps = FALSE;
+    reconfigure = TRUE;
   }
 
+  if (reconfigure && mix->current_caps)
+    gst_videomixer2_decide_allocation (mix, mix->current_caps);
+
   GST_VIDEO_MIXER2_LOCK (mix);
 
   if (mix->newseg_pending) {
@@ -1261,7 +1797,16 @@ gst_videomixer2_collected (GstCollectPads * pads, GstVideoMixer2 * mix)
   if (mix->segment.stop != -1)
     output_end_time = MIN (output_end_time, mix->segment.stop);
 
-  res = gst_videomixer2_fill_queues (mix, output_start_time, output_end_time);
+  /* when the next output frame is going to be dropped, input buffers that
+   * are superseded before the QoS earliest time are not needed either */
+  jitter = gst_videomixer2_do_qos (mix, output_start_time);
+  if (jitter > 0)
+    late_until = output_start_time + jitter;
+  else
+    late_until = GST_CLOCK_TIME_NONE;
+
+  res = gst_videomixer2_fill_queues (mix, output_start_time, output_end_time,
+      late_until, &qos_events);
 
   if (res == 0) {
     GST_DEBUG_OBJECT (mix, "Need more data for decisions");
@@ -1279,7 +1824,6 @@ gst_videomixer2_collected (GstCollectPads * pads, GstVideoMixer2 * mix)
     goto done;
   }
 
-  jitter = gst_videomixer2_do_qos (mix, output_start_time);
   if (jitter <= 0) {
     ret =
         gst_videomixer2_blend_buffers (mix, output_start_time,
@@ -1322,6 +1866,9 @@ done:
   GST_VIDEO_MIXER2_UNLOCK (mix);
 
 done_unlocked:
+  if (qos_events)
+    gst_videomixer2_push_pad_qos (qos_events);
+
   return ret;
 }
 
@@ -2113,6 +2660,7 @@ gst_videomixer2_release_pad (GstElement * element, GstPad * pad)
 
   if (mixpad->convert)
     videomixer_videoconvert_convert_free (mixpad->convert);
+  gst_videomixer2_pad_clear_converted (mixpad);
 
   mix->sinkpads = g_slist_remove (mix->sinkpads, pad);
   gst_child_proxy_child_removed (GST_CHILD_PROXY (mix), G_OBJECT (mixpad),
@@ -2144,8 +2692,12 @@ gst_videomixer2_finalize (GObject * o)
   GstVideoMixer2 *mix = GST_VIDEO_MIXER2 (o);
 
   gst_object_unref (mix->collect);
+  if (mix->blend_pool)
+    g_thread_pool_free (mix->blend_pool, FALSE, TRUE);
   g_mutex_clear (&mix->lock);
   g_mutex_clear (&mix->setcaps_lock);
+  g_mutex_clear (&mix->blend_lock);
+  g_cond_clear (&mix->blend_cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (o);
 }
@@ -2161,6 +2713,7 @@ gst_videomixer2_dispose (GObject * o)
 
     if (mixpad->convert)
       videomixer_videoconvert_convert_free (mixpad->convert);
+    gst_videomixer2_pad_clear_converted (mixpad);
   }
 
   if (mix->pending_tags) {
@@ -2181,6 +2734,9 @@ gst_videomixer2_get_property (GObject * object,
     case PROP_BACKGROUND:
       g_value_set_enum (value, mix->background);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, mix->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2197,6 +2753,9 @@ gst_videomixer2_set_property (GObject * object,
     case PROP_BACKGROUND:
       mix->background = g_value_get_enum (value);
       break;
+    case PROP_N_THREADS:
+      mix->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2258,6 +2817,19 @@ gst_videomixer2_class_init (GstVideoMixer2Class * klass)
       g_param_spec_enum ("background", "Background", "Background type",
           GST_TYPE_VIDEO_MIXER2_BACKGROUND,
           DEFAULT_BACKGROUND, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstVideoMixer2:n-threads:
+   *
+   * Split the output frame into horizontal bands and blend them on this
+   * many threads. 0 uses one thread per processor.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads used for blending (0 = number of processors)",
+          0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_videomixer2_request_new_pad);
@@ -2298,6 +2870,7 @@ gst_videomixer2_init (GstVideoMixer2 * mix)
   gst_collect_pads_set_flush_function (mix->collect,
       (GstCollectPadsFlushFunction) gst_videomixer2_flush, mix);
   mix->background = DEFAULT_BACKGROUND;
+  mix->n_threads = DEFAULT_N_THREADS;
   mix->current_caps = NULL;
   mix->pending_tags = NULL;
 
@@ -2313,6 +2886,8 @@ gst_videomixer2_init (GstVideoMixer2 * mix)
 
   g_mutex_init (&mix->lock);
   g_mutex_init (&mix->setcaps_lock);
+  g_mutex_init (&mix->blend_lock);
+  g_cond_init (&mix->blend_cond);
   /* initialize variables */
   gst_videomixer2_reset (mix);
 }
@@ -117,6 +117,20 @@ struct _GstVideoMixer2
   gboolean send_stream_start;
 
   GstTagList *pending_tags;
+
+  /* slice-parallel blending */
+  guint n_threads;
+  GThreadPool *blend_pool;
+  GMutex blend_lock;
+  GCond blend_cond;
+
+  /* output buffer pool */
+  GstBufferPool *pool;
+
+  /* pre-rendered background */
+  GstBuffer *background_buf;
+  GstVideoMixer2Background background_buf_type;
+  GstVideoInfo background_buf_info;
 };
 
 struct _GstVideoMixer2Class
@@ -32,6 +32,10 @@
  * |[
  * gst-launch-1.0 cdparanoiasrc track=5 ! queue ! audioconvert ! wavenc ! filesink location=track5.wav
  * ]| Rip track 5 of an audio CD into a single wav file containing unencoded raw audio samples.
+ * |[
+ * gst-launch-1.0 audiotestsrc ! wavenc block-size=65536 ! fdsink fd=1 | aplay
+ * ]| Stream a wav file through a pipe. The header sizes can't be fixed up at
+ * the end on a non-seekable output, so they are marked as unknown instead.
  * </refsect2>
  *
  */
@@ -49,6 +53,19 @@
 GST_DEBUG_CATEGORY_STATIC (wavenc_debug);
 #define GST_CAT_DEFAULT wavenc_debug
 
+enum
+{
+  PROP_0,
+  PROP_STREAMABLE,
+  PROP_BLOCK_SIZE
+};
+
+#define DEFAULT_STREAMABLE  FALSE
+#define DEFAULT_BLOCK_SIZE  0
+
+/* RIFF and data chunk size of a stream of unknown length */
+#define WAV_UNKNOWN_SIZE    0xFFFFFFFF
+
 struct riff_struct
 {
   guint8 id[4];                 /* RIFF */
@@ -162,14 +179,56 @@ static gboolean gst_wavenc_event (GstPad * pad, GstObject * parent,
 static GstStateChangeReturn gst_wavenc_change_state (GstElement * element,
     GstStateChange transition);
 static gboolean gst_wavenc_sink_setcaps (GstPad * pad, GstCaps * caps);
+static void gst_wavenc_finalize (GObject * object);
+static void gst_wavenc_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_wavenc_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static void
 gst_wavenc_class_init (GstWavEncClass * klass)
 {
+  GObjectClass *gobject_class;
   GstElementClass *element_class;
 
+  gobject_class = (GObjectClass *) klass;
   element_class = (GstElementClass *) klass;
 
+  gobject_class->finalize = gst_wavenc_finalize;
+  gobject_class->set_property = gst_wavenc_set_property;
+  gobject_class->get_property = gst_wavenc_get_property;
+
+  /**
+   * GstWavEnc:streamable:
+   *
+   * Write a header with unknown RIFF and data chunk sizes and never seek
+   * back to update it, so that the output can go to a pipe or a network
+   * sink. This is also done automatically if downstream reports that it
+   * can't seek. Tags and the TOC are not written in this mode, as readers
+   * would take them for audio data.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_STREAMABLE,
+      g_param_spec_boolean ("streamable", "Streamable",
+          "Write a header with unknown sizes instead of rewriting it at EOS",
+          DEFAULT_STREAMABLE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstWavEnc:block-size:
+   *
+   * Collect the audio data into output buffers of this many bytes, aligned
+   * to multiples of it from the start of the file, so the sink needs fewer
+   * and larger writes. 0 pushes the input buffers as they are.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_BLOCK_SIZE,
+      g_param_spec_uint ("block-size", "Block size",
+          "Size of the output buffers in bytes (0 = same as input)",
+          0, G_MAXINT, DEFAULT_BLOCK_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   element_class->change_state = GST_DEBUG_FUNCPTR (gst_wavenc_change_state);
 
   gst_element_class_set_static_metadata (element_class, "WAV audio muxer",
@@ -200,6 +259,58 @@ gst_wavenc_init (GstWavEnc * wavenc)
   gst_pad_set_caps (wavenc->srcpad,
       gst_static_pad_template_get_caps (&src_factory));
   gst_element_add_pad (GST_ELEMENT (wavenc), wavenc->srcpad);
+
+  wavenc->streamable = DEFAULT_STREAMABLE;
+  wavenc->block_size = DEFAULT_BLOCK_SIZE;
+  wavenc->adapter = gst_adapter_new ();
+}
+
+static void
+gst_wavenc_finalize (GObject * object)
+{
+  GstWavEnc *wavenc = GST_WAVENC (object);
+
+  g_object_unref (wavenc->adapter);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_wavenc_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstWavEnc *wavenc = GST_WAVENC (object);
+
+  switch (prop_id) {
+    case PROP_STREAMABLE:
+      wavenc->streamable = g_value_get_boolean (value);
+      break;
+    case PROP_BLOCK_SIZE:
+      wavenc->block_size = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_wavenc_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstWavEnc *wavenc = GST_WAVENC (object);
+
+  switch (prop_id) {
+    case PROP_STREAMABLE:
+      g_value_set_boolean (value, wavenc->streamable);
+      break;
+    case PROP_BLOCK_SIZE:
+      g_value_set_uint (value, wavenc->block_size);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 #define WAV_HEADER_LEN 44
@@ -218,8 +329,11 @@ gst_wavenc_create_header_buf (GstWavEnc * wavenc)
   memset (header, 0, WAV_HEADER_LEN);
 
   memcpy (wave.riff.id, "RIFF", 4);
-  wave.riff.len =
-      wavenc->meta_length + wavenc->audio_length + WAV_HEADER_LEN - 8;
+  if (wavenc->streaming)
+    wave.riff.len = WAV_UNKNOWN_SIZE;
+  else
+    wave.riff.len =
+        wavenc->meta_length + wavenc->audio_length + WAV_HEADER_LEN - 8;
   memcpy (wave.riff.wav_id, "WAVE", 4);
 
   memcpy (wave.format.id, "fmt ", 4);
@@ -234,7 +348,7 @@ gst_wavenc_create_header_buf (GstWavEnc * wavenc)
       wave.common.wBlockAlign * wave.common.dwSamplesPerSec;
 
   memcpy (wave.data.id, "data", 4);
-  wave.data.len = wavenc->audio_length;
+  wave.data.len = wavenc->streaming ? WAV_UNKNOWN_SIZE : wavenc->audio_length;
 
   memcpy (header, (char *) wave.riff.id, 4);
   GST_WRITE_UINT32_LE (header + 4, wave.riff.len);
@@ -282,6 +396,56 @@ gst_wavenc_push_header (GstWavEnc * wavenc)
   return ret;
 }
 
+/* Checks if the header can be rewritten at EOS. If downstream doesn't
+ * answer the seeking query we assume it can, as before. */
+static gboolean
+gst_wavenc_downstream_is_seekable (GstWavEnc * wavenc)
+{
+  GstQuery *query;
+  gboolean seekable = TRUE;
+
+  query = gst_query_new_seeking (GST_FORMAT_BYTES);
+  if (gst_pad_peer_query (wavenc->srcpad, query))
+    gst_query_parse_seeking (query, NULL, &seekable, NULL, NULL);
+  gst_query_unref (query);
+
+  return seekable;
+}
+
+/* Pushes the collected audio data in block_size buffers. The first block
+ * is made shorter by the header size, so that all following ones start at
+ * a multiple of block_size in the file. With @drain the rest is pushed
+ * too. */
+static GstFlowReturn
+gst_wavenc_push_blocks (GstWavEnc * wavenc, gboolean drain)
+{
+  GstFlowReturn flow = GST_FLOW_OK;
+  GstBuffer *outbuf;
+  gsize avail, len;
+
+  avail = gst_adapter_available (wavenc->adapter);
+  while (avail > 0 && flow == GST_FLOW_OK) {
+    len = wavenc->block_size - (wavenc->out_offset % wavenc->block_size);
+    if (avail < len) {
+      if (!drain)
+        break;
+      len = avail;
+    }
+
+    outbuf = gst_adapter_take_buffer (wavenc->adapter, len);
+    outbuf = gst_buffer_make_writable (outbuf);
+    GST_BUFFER_OFFSET (outbuf) = wavenc->out_offset;
+    GST_BUFFER_OFFSET_END (outbuf) = GST_BUFFER_OFFSET_NONE;
+    wavenc->out_offset += len;
+    avail -= len;
+
+    GST_LOG_OBJECT (wavenc, "pushing block of %" G_GSIZE_FORMAT " bytes", len);
+    flow = gst_pad_push (wavenc->srcpad, outbuf);
+  }
+
+  return flow;
+}
+
 static gboolean
 gst_wavenc_sink_setcaps (GstPad * pad, GstCaps * caps)
 {
@@ -784,6 +948,23 @@ gst_wavenc_event (GstPad * pad, GstObject * parent, GstEvent * event)
       GstFlowReturn flow;
       GST_DEBUG_OBJECT (wavenc, "got EOS");
 
+      if (wavenc->block_size > 0) {
+        flow = gst_wavenc_push_blocks (wavenc, TRUE);
+        if (flow != GST_FLOW_OK) {
+          GST_WARNING_OBJECT (wavenc, "error pushing audio data: %s",
+              gst_flow_get_name (flow));
+        }
+      }
+
+      if (wavenc->streaming) {
+        /* sizes stay unknown, and anything after the data chunk would be
+         * read as audio */
+        GST_DEBUG_OBJECT (wavenc, "streaming, not writing tags and header");
+        wavenc->finished_properly = TRUE;
+        res = gst_pad_event_default (pad, parent, event);
+        break;
+      }
+
       flow = gst_wavenc_write_toc (wavenc);
       if (flow != GST_FLOW_OK) {
         GST_WARNING_OBJECT (wavenc, "error pushing toc: %s",
@@ -805,6 +986,10 @@ gst_wavenc_event (GstPad * pad, GstObject * parent, GstEvent * event)
       res = gst_pad_event_default (pad, parent, event);
       break;
     }
+    case GST_EVENT_FLUSH_STOP:
+      gst_adapter_clear (wavenc->adapter);
+      res = gst_pad_event_default (pad, parent, event);
+      break;
     case GST_EVENT_SEGMENT:
       /* Just drop it, it's probably in TIME format
        * anyway. We'll send our own newsegment event */
@@ -854,6 +1039,12 @@ gst_wavenc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
     /* starting a file, means we have to finish it properly */
     wavenc->finished_properly = FALSE;
 
+    wavenc->streaming = wavenc->streamable;
+    if (!wavenc->streaming && !gst_wavenc_downstream_is_seekable (wavenc)) {
+      GST_INFO_OBJECT (wavenc, "downstream is not seekable, streaming");
+      wavenc->streaming = TRUE;
+    }
+
     /* push initial bogus header, it will be updated on EOS */
     flow = gst_wavenc_push_header (wavenc);
     if (flow != GST_FLOW_OK) {
@@ -863,9 +1054,16 @@ gst_wavenc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
     }
     GST_DEBUG_OBJECT (wavenc, "wrote dummy header");
     wavenc->audio_length = 0;
+    wavenc->out_offset = WAV_HEADER_LEN;
     wavenc->sent_header = TRUE;
   }
 
+  if (wavenc->block_size > 0) {
+    wavenc->audio_length += gst_buffer_get_size (buf);
+    gst_adapter_push (wavenc->adapter, buf);
+    return gst_wavenc_push_blocks (wavenc, FALSE);
+  }
+
   GST_LOG_OBJECT (wavenc,
       "pushing %" G_GSIZE_FORMAT " bytes raw audio, ts=%" GST_TIME_FORMAT,
       gst_buffer_get_size (buf), GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)));
@@ -899,6 +1097,7 @@ gst_wavenc_change_state (GstElement * element, GstStateChange transition)
       wavenc->audio_length = 0x7FFF0000;
       wavenc->meta_length = 0;
       wavenc->sent_header = FALSE;
+      wavenc->streaming = FALSE;
       /* its true because we haven't writen anything */
       wavenc->finished_properly = TRUE;
       break;
@@ -918,6 +1117,7 @@ gst_wavenc_change_state (GstElement * element, GstStateChange transition)
             ("Wav stream not finished properly, no EOS received "
                 "before shutdown"));
       }
+      gst_adapter_clear (wavenc->adapter);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       GST_DEBUG_OBJECT (wavenc, "tags: %p", wavenc->tags);
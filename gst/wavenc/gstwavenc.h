@@ -23,6 +23,7 @@
 
 
 #include <gst/gst.h>
+#include <gst/base/gstadapter.h>
 
 G_BEGIN_DECLS
 
@@ -64,6 +65,17 @@ struct _GstWavEnc {
 
   gboolean   sent_header;
   gboolean   finished_properly;
+
+  /* properties */
+  gboolean   streamable;
+  guint      block_size;
+
+  /* header sizes are unknown and never rewritten */
+  gboolean   streaming;
+
+  /* collects small input buffers into block_size output buffers */
+  GstAdapter *adapter;
+  guint64    out_offset;
 };
 
 struct _GstWavEncClass {
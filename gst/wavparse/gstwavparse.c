@@ -98,11 +98,13 @@ static void gst_wavparse_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
 #define DEFAULT_IGNORE_LENGTH FALSE
+#define DEFAULT_PULL_BLOCK_SIZE 0
 
 enum
 {
   PROP_0,
   PROP_IGNORE_LENGTH,
+  PROP_PULL_BLOCK_SIZE,
 };
 
 static GstStaticPadTemplate sink_template_factory =
@@ -180,6 +182,22 @@ gst_wavparse_class_init (GstWavParseClass * klass)
           DEFAULT_IGNORE_LENGTH, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)
       );
 
+  /**
+   * GstWavParse:pull-block-size:
+   *
+   * In pull mode, read the data chunk in blocks of this many bytes and
+   * push sample-aligned sub-buffers of each block without copying. Big
+   * blocks avoid many small reads on slow or network storage. 0 pulls
+   * every output buffer separately.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (object_class, PROP_PULL_BLOCK_SIZE,
+      g_param_spec_uint ("pull-block-size", "Pull block size",
+          "Size of the blocks read in pull mode (0 = one read per buffer)",
+          0, G_MAXUINT, DEFAULT_PULL_BLOCK_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_wavparse_change_state;
   gstelement_class->send_event = gst_wavparse_send_event;
 
@@ -245,6 +263,10 @@ gst_wavparse_reset (GstWavParse * wav)
   if (wav->start_segment)
     gst_event_unref (wav->start_segment);
   wav->start_segment = NULL;
+  if (wav->block)
+    gst_buffer_unref (wav->block);
+  wav->block = NULL;
+  wav->block_offset = 0;
 }
 
 static void
@@ -261,6 +283,8 @@ gst_wavparse_dispose (GObject * object)
 static void
 gst_wavparse_init (GstWavParse * wavparse)
 {
+  wavparse->pull_block_size = DEFAULT_PULL_BLOCK_SIZE;
+
   gst_wavparse_reset (wavparse);
 
   /* sink */
@@ -1823,6 +1847,52 @@ gst_wavparse_add_src_pad (GstWavParse * wav, GstBuffer * buf)
   }
 }
 
+/* pull @size bytes of sample data at the current offset. With a block size
+ * configured, the data is a sub-buffer of a large block that is pulled in
+ * one go. */
+static GstFlowReturn
+gst_wavparse_pull_data (GstWavParse * wav, guint64 size, GstBuffer ** buf)
+{
+  GstFlowReturn res;
+  guint64 block_size, offset;
+
+  if (wav->pull_block_size == 0 || size >= wav->pull_block_size)
+    return gst_pad_pull_range (wav->sinkpad, wav->offset, size, buf);
+
+  /* drop the block if it does not contain all of the requested data */
+  if (wav->block && (wav->offset < wav->block_offset ||
+          wav->offset + size >
+          wav->block_offset + gst_buffer_get_size (wav->block))) {
+    gst_buffer_unref (wav->block);
+    wav->block = NULL;
+  }
+
+  if (wav->block == NULL) {
+    /* no need to read past the data chunk */
+    block_size = MAX (size, MIN (wav->pull_block_size, wav->dataleft));
+    if (wav->blockalign > 0 && block_size > wav->blockalign)
+      block_size -= (block_size % wav->blockalign);
+
+    GST_LOG_OBJECT (wav, "pulling block of %" G_GUINT64_FORMAT " bytes at %"
+        G_GUINT64_FORMAT, block_size, wav->offset);
+
+    if ((res = gst_pad_pull_range (wav->sinkpad, wav->offset, block_size,
+                &wav->block)) != GST_FLOW_OK)
+      return res;
+    wav->block_offset = wav->offset;
+  }
+
+  /* a block at the end of the file may be short */
+  offset = wav->offset - wav->block_offset;
+  size = MIN (size, gst_buffer_get_size (wav->block) - offset);
+  if (size == 0)
+    return GST_FLOW_EOS;
+
+  *buf = gst_buffer_copy_region (wav->block, GST_BUFFER_COPY_ALL, offset, size);
+
+  return GST_FLOW_OK;
+}
+
 static GstFlowReturn
 gst_wavparse_stream_data (GstWavParse * wav)
 {
@@ -1889,8 +1959,7 @@ iterate_adapter:
 
     buf = gst_adapter_take_buffer (wav->adapter, desired);
   } else {
-    if ((res = gst_pad_pull_range (wav->sinkpad, wav->offset,
-                desired, &buf)) != GST_FLOW_OK)
+    if ((res = gst_wavparse_pull_data (wav, desired, &buf)) != GST_FLOW_OK)
       goto pull_error;
 
     /* we may get a short buffer at the end of the file */
@@ -2759,6 +2828,9 @@ gst_wavparse_set_property (GObject * object, guint prop_id,
     case PROP_IGNORE_LENGTH:
       self->ignore_length = g_value_get_boolean (value);
       break;
+    case PROP_PULL_BLOCK_SIZE:
+      self->pull_block_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
   }
@@ -2778,6 +2850,9 @@ gst_wavparse_get_property (GObject * object, guint prop_id,
     case PROP_IGNORE_LENGTH:
       g_value_set_boolean (value, self->ignore_length);
       break;
+    case PROP_PULL_BLOCK_SIZE:
+      g_value_set_uint (value, self->pull_block_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
   }
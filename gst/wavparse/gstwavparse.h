@@ -122,6 +122,11 @@ struct _GstWavParse {
   gboolean discont;
 
   gboolean ignore_length;
+
+  /* pull mode block reading */
+  guint pull_block_size;
+  GstBuffer *block;
+  guint64 block_offset;
 };
 
 struct _GstWavParseClass {
@@ -139,6 +139,8 @@ gst_y4m_encode_setcaps (GstPad * pad, GstCaps * vscaps)
   gboolean ret;
   GstY4mEncode *filter;
   GstVideoInfo info;
+  gsize offset;
+  guint i;
 
   filter = GST_Y4M_ENCODE (GST_PAD_PARENT (pad));
 
@@ -164,6 +166,16 @@ gst_y4m_encode_setcaps (GstPad * pad, GstCaps * vscaps)
 
   filter->info = info;
 
+  /* y4m has no padding between lines or planes, unlike the default layout
+   * for widths that aren't a multiple of 8 */
+  offset = 0;
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (&info); i++) {
+    filter->packed_offset[i] = offset;
+    filter->packed_stride[i] = GST_VIDEO_INFO_COMP_WIDTH (&info, i);
+    offset += filter->packed_stride[i] * GST_VIDEO_INFO_COMP_HEIGHT (&info, i);
+  }
+  filter->packed_size = offset;
+
   /* the template caps will do for the src pad, should always accept */
   ret = gst_pad_set_caps (filter->srcpad,
       gst_static_pad_template_get_caps (&y4mencode_src_factory));
@@ -238,20 +250,93 @@ gst_y4m_encode_get_stream_header (GstY4mEncode * filter, gboolean tff)
 static inline GstBuffer *
 gst_y4m_encode_get_frame_header (GstY4mEncode * filter)
 {
-  gpointer header;
+  static const gchar header[] = "FRAME\n";
   GstBuffer *buf;
-  gsize len;
-
-  header = g_strdup_printf ("FRAME\n");
-  len = strlen (header);
+  gsize len = sizeof (header) - 1;
 
   buf = gst_buffer_new ();
   gst_buffer_append_memory (buf,
-      gst_memory_new_wrapped (0, header, len, 0, len, header, g_free));
+      gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, (gpointer) header,
+          len, 0, len, NULL, NULL));
 
   return buf;
 }
 
+/* Returns the picture in @buf in the packed y4m layout. This only needs a
+ * copy if the planes are padded or in a different place, otherwise the
+ * memory of @buf is reused. Takes ownership of @buf. */
+static GstBuffer *
+gst_y4m_encode_get_frame_data (GstY4mEncode * filter, GstBuffer * buf)
+{
+  GstVideoInfo *info = &filter->info;
+  GstVideoMeta *meta;
+  GstVideoFrame frame;
+  GstBuffer *outbuf;
+  GstMapInfo map;
+  gboolean packed = TRUE;
+  guint8 *src, *dest;
+  gint i, j, h, w;
+
+  meta = gst_buffer_get_video_meta (buf);
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (info); i++) {
+    gsize offset;
+    gint stride;
+
+    if (meta) {
+      offset = meta->offset[i];
+      stride = meta->stride[i];
+    } else {
+      offset = GST_VIDEO_INFO_PLANE_OFFSET (info, i);
+      stride = GST_VIDEO_INFO_PLANE_STRIDE (info, i);
+    }
+    if (offset != filter->packed_offset[i] ||
+        stride != filter->packed_stride[i]) {
+      packed = FALSE;
+      break;
+    }
+  }
+
+  if (packed && gst_buffer_get_size (buf) >= filter->packed_size) {
+    if (gst_buffer_get_size (buf) == filter->packed_size)
+      return buf;
+
+    /* drop the trailing padding, still sharing the memory */
+    outbuf = gst_buffer_copy_region (buf, GST_BUFFER_COPY_MEMORY, 0,
+        filter->packed_size);
+    gst_buffer_unref (buf);
+    return outbuf;
+  }
+
+  GST_LOG_OBJECT (filter, "repacking frame");
+
+  if (!gst_video_frame_map (&frame, info, buf, GST_MAP_READ)) {
+    gst_buffer_unref (buf);
+    return NULL;
+  }
+
+  outbuf = gst_buffer_new_allocate (NULL, filter->packed_size, NULL);
+  gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
+  for (i = 0; i < GST_VIDEO_FRAME_N_PLANES (&frame); i++) {
+    src = GST_VIDEO_FRAME_PLANE_DATA (&frame, i);
+    dest = map.data + filter->packed_offset[i];
+    w = filter->packed_stride[i];
+    h = GST_VIDEO_FRAME_COMP_HEIGHT (&frame, i);
+
+    for (j = 0; j < h; j++) {
+      memcpy (dest, src, w);
+      src += GST_VIDEO_FRAME_PLANE_STRIDE (&frame, i);
+      dest += w;
+    }
+  }
+  gst_buffer_unmap (outbuf, &map);
+  gst_video_frame_unmap (&frame);
+  gst_buffer_copy_into (outbuf, buf,
+      GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+  gst_buffer_unref (buf);
+
+  return outbuf;
+}
+
 static GstFlowReturn
 gst_y4m_encode_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -265,6 +350,10 @@ gst_y4m_encode_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 
   timestamp = GST_BUFFER_TIMESTAMP (buf);
 
+  buf = gst_y4m_encode_get_frame_data (filter, buf);
+  if (buf == NULL)
+    goto invalid_frame;
+
   if (G_UNLIKELY (!filter->header)) {
     gboolean tff = FALSE;
 
@@ -278,7 +367,7 @@ gst_y4m_encode_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   } else {
     outbuf = gst_y4m_encode_get_frame_header (filter);
   }
-  /* join with data, FIXME, strides are all wrong etc */
+  /* join with data, the picture memory is only referenced */
   outbuf = gst_buffer_append (outbuf, buf);
   /* decorate */
   outbuf = gst_buffer_make_writable (outbuf);
@@ -295,6 +384,12 @@ not_negotiated:
     gst_buffer_unref (buf);
     return GST_FLOW_NOT_NEGOTIATED;
   }
+invalid_frame:
+  {
+    GST_ELEMENT_ERROR (filter, STREAM, FORMAT, (NULL),
+        ("could not map video frame"));
+    return GST_FLOW_ERROR;
+  }
 }
 
 static GstStateChangeReturn
@@ -52,6 +52,10 @@ struct _GstY4mEncode {
   gboolean negotiated;
 
   const gchar *colorspace;
+  /* tightly packed plane layout of the y4m frames */
+  gsize packed_offset[GST_VIDEO_MAX_PLANES];
+  gint packed_stride[GST_VIDEO_MAX_PLANES];
+  gsize packed_size;
   /* state information */
   gboolean header;
 };
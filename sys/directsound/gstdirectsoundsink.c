@@ -66,6 +66,12 @@
 #endif
 
 #define DEFAULT_MUTE FALSE
+#define DEFAULT_EVENT_DRIVEN FALSE
+
+/* not taken from dxguid, which we don't link to */
+static const GUID gst_directsound_iid_notify = { 0xb0210783, 0x89cd, 0x11d0,
+  {0xaf, 0x08, 0x00, 0xa0, 0xc9, 0x25, 0xcd, 0x16}
+};
 
 GST_DEBUG_CATEGORY_STATIC (directsoundsink_debug);
 #define GST_CAT_DEFAULT directsoundsink_debug
@@ -124,7 +130,8 @@ enum
 {
   PROP_0,
   PROP_VOLUME,
-  PROP_MUTE
+  PROP_MUTE,
+  PROP_EVENT_DRIVEN
 };
 
 #define gst_directsound_sink_parent_class parent_class
@@ -189,6 +196,22 @@ gst_directsound_sink_class_init (GstDirectSoundSinkClass * klass)
           "Mute state of this stream", DEFAULT_MUTE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstDirectSoundSink:event-driven:
+   *
+   * Let DirectSound signal each time the playback enters a new segment
+   * and write as soon as that happens, instead of sleeping and polling
+   * the buffer status. The DirectSound buffer is #GstAudioBaseSink:buffer-time
+   * long, set it and #GstAudioBaseSink:latency-time low for low latency.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_EVENT_DRIVEN,
+      g_param_spec_boolean ("event-driven", "Event driven",
+          "Wait for position notifications instead of polling",
+          DEFAULT_EVENT_DRIVEN, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (element_class,
       "Direct Sound Audio Sink", "Sink/Audio",
       "Output to a sound card via Direct Sound",
@@ -211,6 +234,8 @@ gst_directsound_sink_init (GstDirectSoundSink * dsoundsink)
   dsoundsink->volume = 100;
   g_mutex_init (&dsoundsink->dsound_lock);
   dsoundsink->first_buffer_after_reset = FALSE;
+  dsoundsink->event_driven = DEFAULT_EVENT_DRIVEN;
+  dsoundsink->notify_event = NULL;
 }
 
 static void
@@ -226,6 +251,9 @@ gst_directsound_sink_set_property (GObject * object,
     case PROP_MUTE:
       gst_directsound_sink_set_mute (sink, g_value_get_boolean (value));
       break;
+    case PROP_EVENT_DRIVEN:
+      sink->event_driven = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -245,6 +273,9 @@ gst_directsound_sink_get_property (GObject * object,
     case PROP_MUTE:
       g_value_set_boolean (value, gst_directsound_sink_get_mute (sink));
       break;
+    case PROP_EVENT_DRIVEN:
+      g_value_set_boolean (value, sink->event_driven);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -412,6 +443,59 @@ gst_directsound_sink_is_spdif_format (GstAudioRingBufferSpec * spec)
       spec->type == GST_AUDIO_RING_BUFFER_FORMAT_TYPE_DTS;
 }
 
+/* Sets up a notification at the start of every segment, the buffer must be
+ * stopped. Returns FALSE if notifications can't be used */
+static gboolean
+gst_directsound_sink_setup_notify (GstDirectSoundSink * dsoundsink,
+    GstAudioRingBufferSpec * spec, DWORD bytes_per_sec)
+{
+  LPDIRECTSOUNDNOTIFY pDSNotify = NULL;
+  DSBPOSITIONNOTIFY *positions;
+  HRESULT hRes;
+  gint i;
+
+  hRes = IDirectSoundBuffer_QueryInterface (dsoundsink->pDSBSecondary,
+      &gst_directsound_iid_notify, (LPVOID *) & pDSNotify);
+  if (FAILED (hRes)) {
+    GST_WARNING_OBJECT (dsoundsink, "no IDirectSoundNotify: %s",
+        DXGetErrorString9 (hRes));
+    return FALSE;
+  }
+
+  dsoundsink->notify_event = CreateEvent (NULL, FALSE, FALSE, NULL);
+  if (dsoundsink->notify_event == NULL) {
+    IDirectSoundNotify_Release (pDSNotify);
+    return FALSE;
+  }
+
+  positions = g_new (DSBPOSITIONNOTIFY, spec->segtotal);
+  for (i = 0; i < spec->segtotal; i++) {
+    positions[i].dwOffset = i * spec->segsize;
+    positions[i].hEventNotify = dsoundsink->notify_event;
+  }
+
+  hRes = IDirectSoundNotify_SetNotificationPositions (pDSNotify,
+      spec->segtotal, positions);
+  g_free (positions);
+  IDirectSoundNotify_Release (pDSNotify);
+
+  if (FAILED (hRes)) {
+    GST_WARNING_OBJECT (dsoundsink, "SetNotificationPositions failed: %s",
+        DXGetErrorString9 (hRes));
+    CloseHandle (dsoundsink->notify_event);
+    dsoundsink->notify_event = NULL;
+    return FALSE;
+  }
+
+  /* two segments, in case a notification got lost */
+  dsoundsink->notify_timeout = MAX (1,
+      gst_util_uint64_scale_int (2 * spec->segsize, 1000, bytes_per_sec));
+
+  GST_INFO_OBJECT (dsoundsink, "notifying every %d bytes", spec->segsize);
+
+  return TRUE;
+}
+
 static gboolean
 gst_directsound_sink_prepare (GstAudioSink * asink,
     GstAudioRingBufferSpec * spec)
@@ -484,6 +568,8 @@ gst_directsound_sink_prepare (GstAudioSink * asink,
   descSecondary.dwFlags = DSBCAPS_GETCURRENTPOSITION2 | DSBCAPS_GLOBALFOCUS;
   if (!gst_directsound_sink_is_spdif_format (spec))
     descSecondary.dwFlags |= DSBCAPS_CTRLVOLUME;
+  if (dsoundsink->event_driven)
+    descSecondary.dwFlags |= DSBCAPS_CTRLPOSITIONNOTIFY;
 
   descSecondary.dwBufferBytes = dsoundsink->buffer_size;
   descSecondary.lpwfxFormat = (WAVEFORMATEX *) & wfx;
@@ -499,6 +585,11 @@ gst_directsound_sink_prepare (GstAudioSink * asink,
 
   gst_directsound_sink_set_volume (dsoundsink, dsoundsink->volume, FALSE);
 
+  if (dsoundsink->event_driven &&
+      !gst_directsound_sink_setup_notify (dsoundsink, spec,
+          wfx.nAvgBytesPerSec))
+    GST_WARNING_OBJECT (dsoundsink, "falling back to polling");
+
   return TRUE;
 }
 
@@ -509,6 +600,11 @@ gst_directsound_sink_unprepare (GstAudioSink * asink)
 
   dsoundsink = GST_DIRECTSOUND_SINK (asink);
 
+  if (dsoundsink->notify_event) {
+    CloseHandle (dsoundsink->notify_event);
+    dsoundsink->notify_event = NULL;
+  }
+
   /* release secondary DirectSound buffer */
   if (dsoundsink->pDSBSecondary) {
     IDirectSoundBuffer_Release (dsoundsink->pDSBSecondary);
@@ -570,7 +666,16 @@ gst_directsound_sink_write (GstAudioSink * asink, gpointer data, guint length)
           dwCurrentPlayCursor - dsoundsink->current_circular_offset;
 
     if (length >= dwFreeBufferSize) {
-      Sleep (100);
+      if (dsoundsink->notify_event) {
+        /* the next segment boundary frees up space, don't block resets
+         * while waiting for it */
+        GST_DSOUND_UNLOCK (dsoundsink);
+        WaitForSingleObject (dsoundsink->notify_event,
+            dsoundsink->notify_timeout);
+        GST_DSOUND_LOCK (dsoundsink);
+      } else {
+        Sleep (100);
+      }
       hRes = IDirectSoundBuffer_GetCurrentPosition (dsoundsink->pDSBSecondary,
           &dwCurrentPlayCursor, NULL);
 
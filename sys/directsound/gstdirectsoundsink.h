@@ -82,6 +82,13 @@ struct _GstDirectSoundSink
   gboolean first_buffer_after_reset;
 
   GstAudioRingBufferFormatType type;
+
+  /* wait for position notifications instead of polling */
+  gboolean event_driven;
+  /* signalled each time playback enters a new segment, NULL when polling */
+  HANDLE notify_event;
+  /* how long to wait for a notification, in ms */
+  DWORD notify_timeout;
 };
 
 struct _GstDirectSoundSinkClass
@@ -47,6 +47,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <unistd.h>
@@ -90,6 +91,7 @@ static void gst_oss4_sink_reset (GstAudioSink * asink);
 #define DEFAULT_MUTE        FALSE
 #define DEFAULT_VOLUME      1.0
 #define MAX_VOLUME          10.0
+#define DEFAULT_MMAP        FALSE
 
 enum
 {
@@ -98,6 +100,7 @@ enum
   PROP_DEVICE_NAME,
   PROP_VOLUME,
   PROP_MUTE,
+  PROP_MMAP,
   PROP_LAST
 };
 
@@ -155,6 +158,23 @@ gst_oss4_sink_class_init (GstOss4SinkClass * klass)
           "Mute state of this stream", DEFAULT_MUTE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstOss4Sink:mmap:
+   *
+   * Write the samples directly into the memory mapped DMA buffer of the
+   * device instead of using write(). Only the amount of data configured
+   * with #GstAudioBaseSink:latency-time is kept queued in the hardware
+   * buffer, which allows for much lower latencies than the fragments of
+   * the driver, and the delay is read from the DMA pointer. Falls back to
+   * write() if the device does not support mmap.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_MMAP,
+      g_param_spec_boolean ("mmap", "mmap",
+          "Write to the memory mapped DMA buffer of the device",
+          DEFAULT_MMAP, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   basesink_class->get_caps = GST_DEBUG_FUNCPTR (gst_oss4_sink_getcaps);
 
   audiosink_class->open = GST_DEBUG_FUNCPTR (gst_oss4_sink_open_func);
@@ -189,6 +209,8 @@ gst_oss4_sink_init (GstOss4Sink * osssink)
   osssink->probed_caps = NULL;
   osssink->device_name = NULL;
   osssink->mute_volume = 100 | (100 << 8);
+  osssink->mmap = DEFAULT_MMAP;
+  osssink->mmap_data = NULL;
 }
 
 static void
@@ -322,6 +344,11 @@ gst_oss4_sink_set_property (GObject * object, guint prop_id,
     case PROP_MUTE:
       gst_oss4_sink_set_mute (oss, g_value_get_boolean (value));
       break;
+    case PROP_MMAP:
+      GST_OBJECT_LOCK (oss);
+      oss->mmap = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (oss);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -366,6 +393,11 @@ gst_oss4_sink_get_property (GObject * object, guint prop_id,
     case PROP_MUTE:
       g_value_set_boolean (value, gst_oss4_sink_get_mute (oss));
       break;
+    case PROP_MMAP:
+      GST_OBJECT_LOCK (oss);
+      g_value_set_boolean (value, oss->mmap);
+      GST_OBJECT_UNLOCK (oss);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -557,6 +589,11 @@ gst_oss4_sink_close (GstAudioSink * asink)
 {
   GstOss4Sink *oss = GST_OSS4_SINK (asink);
 
+  if (oss->mmap_data) {
+    munmap (oss->mmap_data, oss->mmap_size);
+    oss->mmap_data = NULL;
+  }
+
   if (oss->fd != -1) {
     GST_DEBUG_OBJECT (oss, "closing device");
     close (oss->fd);
@@ -580,13 +617,70 @@ gst_oss4_sink_close (GstAudioSink * asink)
   return TRUE;
 }
 
+/* Maps the DMA buffer of the device, with output stopped until it got
+ * some data. Returns FALSE if the device can't do mmap */
+static gboolean
+gst_oss4_sink_prepare_mmap (GstOss4Sink * oss, gint segsize)
+{
+  audio_buf_info info;
+  int caps, trigger;
+  gpointer data;
+
+  if (ioctl (oss->fd, SNDCTL_DSP_GETCAPS, &caps) == -1 ||
+      (caps & (PCM_CAP_MMAP | PCM_CAP_TRIGGER)) !=
+      (PCM_CAP_MMAP | PCM_CAP_TRIGGER)) {
+    GST_WARNING_OBJECT (oss, "device does not support mmap");
+    return FALSE;
+  }
+
+  trigger = 0;
+  if (ioctl (oss->fd, SNDCTL_DSP_SETTRIGGER, &trigger) == -1 ||
+      ioctl (oss->fd, SNDCTL_DSP_GETOSPACE, &info) == -1) {
+    GST_WARNING_OBJECT (oss, "failed to set up mmap: %s", g_strerror (errno));
+    return FALSE;
+  }
+
+  oss->mmap_size = info.fragstotal * info.fragsize;
+  data = mmap (NULL, oss->mmap_size, PROT_WRITE, MAP_SHARED, oss->fd, 0);
+  if (data == MAP_FAILED) {
+    GST_WARNING_OBJECT (oss, "mmap failed: %s", g_strerror (errno));
+    /* keep write() working */
+    trigger = PCM_ENABLE_OUTPUT;
+    ioctl (oss->fd, SNDCTL_DSP_SETTRIGGER, &trigger);
+    return FALSE;
+  }
+
+  oss->mmap_data = data;
+  gst_audio_format_fill_silence (oss->finfo, oss->mmap_data, oss->mmap_size);
+
+  /* queue two segments at most, but leave one fragment to the device */
+  oss->mmap_fill = MIN (2 * segsize, oss->mmap_size - info.fragsize);
+  oss->mmap_fill -= oss->mmap_fill % oss->bytes_per_sample;
+  oss->mmap_fill = MAX (oss->mmap_fill, oss->bytes_per_sample);
+
+  oss->mmap_written = oss->mmap_played = 0;
+  oss->mmap_last_bytes = 0;
+  oss->mmap_started = FALSE;
+
+  GST_INFO_OBJECT (oss, "mapped %d bytes DMA buffer, keeping %d bytes queued",
+      oss->mmap_size, oss->mmap_fill);
+
+  return TRUE;
+}
+
 static gboolean
 gst_oss4_sink_prepare (GstAudioSink * asink, GstAudioRingBufferSpec * spec)
 {
   GstOss4Sink *oss;
+  gint segsize, segtotal;
+  gboolean use_mmap;
 
   oss = GST_OSS4_SINK (asink);
 
+  /* what was asked for, set_format uses the fragments of the driver */
+  segsize = spec->segsize;
+  segtotal = spec->segtotal;
+
   if (!gst_oss4_audio_set_format (GST_OBJECT_CAST (oss), oss->fd, spec)) {
     GST_WARNING_OBJECT (oss, "Couldn't set requested format %" GST_PTR_FORMAT,
         spec->caps);
@@ -594,6 +688,19 @@ gst_oss4_sink_prepare (GstAudioSink * asink, GstAudioRingBufferSpec * spec)
   }
 
   oss->bytes_per_sample = GST_AUDIO_INFO_BPF (&spec->info);
+  oss->rate = GST_AUDIO_INFO_RATE (&spec->info);
+  oss->finfo = spec->info.finfo;
+
+  GST_OBJECT_LOCK (oss);
+  use_mmap = oss->mmap;
+  GST_OBJECT_UNLOCK (oss);
+
+  /* the hardware buffer is filled in segments of our own size, so the
+   * latency is not bound to the fragment size of the driver */
+  if (use_mmap && gst_oss4_sink_prepare_mmap (oss, segsize)) {
+    spec->segsize = segsize;
+    spec->segtotal = segtotal;
+  }
 
   return TRUE;
 }
@@ -625,6 +732,108 @@ couldnt_reopen:
   }
 }
 
+/* Fills the DMA buffer between off and off + len with silence */
+static void
+gst_oss4_sink_mmap_clear (GstOss4Sink * oss, guint64 off, guint64 len)
+{
+  gint pos, first;
+
+  len = MIN (len, oss->mmap_size);
+  pos = off % oss->mmap_size;
+  first = MIN (len, oss->mmap_size - pos);
+
+  gst_audio_format_fill_silence (oss->finfo, oss->mmap_data + pos, first);
+  if (len > first)
+    gst_audio_format_fill_silence (oss->finfo, oss->mmap_data, len - first);
+}
+
+/* Updates how much the device played, call with the object lock */
+static void
+gst_oss4_sink_mmap_update (GstOss4Sink * oss)
+{
+  count_info info;
+  guint64 played;
+
+  if (ioctl (oss->fd, SNDCTL_DSP_GETOPTR, &info) == -1) {
+    GST_LOG_OBJECT (oss, "GETOPTR failed");
+    return;
+  }
+
+  /* the byte counter wraps around */
+  played = oss->mmap_played + (guint) (info.bytes - oss->mmap_last_bytes);
+  oss->mmap_last_bytes = info.bytes;
+
+  /* the device loops over the buffer, it must only find silence where we
+   * did not write new samples yet */
+  gst_oss4_sink_mmap_clear (oss, oss->mmap_played, played - oss->mmap_played);
+  oss->mmap_played = played;
+
+  if (G_UNLIKELY (oss->mmap_played > oss->mmap_written)) {
+    GST_DEBUG_OBJECT (oss, "underrun of %" G_GUINT64_FORMAT " bytes",
+        oss->mmap_played - oss->mmap_written);
+    oss->mmap_written = oss->mmap_played;
+  }
+}
+
+static gint
+gst_oss4_sink_write_mmap (GstOss4Sink * oss, guint8 * data, guint length)
+{
+  guint64 queued;
+  gint avail, pos, first, n;
+
+  GST_OBJECT_LOCK (oss);
+  while (TRUE) {
+    gst_oss4_sink_mmap_update (oss);
+
+    queued = oss->mmap_written - oss->mmap_played;
+    avail = oss->mmap_fill - queued;
+    if (avail >= oss->bytes_per_sample)
+      break;
+
+    if (!oss->mmap_started) {
+      int trigger = PCM_ENABLE_OUTPUT;
+
+      GST_DEBUG_OBJECT (oss, "starting output");
+      if (ioctl (oss->fd, SNDCTL_DSP_SETTRIGGER, &trigger) == -1)
+        goto trigger_failed;
+      oss->mmap_started = TRUE;
+    }
+
+    GST_OBJECT_UNLOCK (oss);
+    /* wait until there is room for the data or half of the queue */
+    n = MAX ((gint) MIN (length, oss->mmap_fill / 2) - avail, 0);
+    g_usleep (MAX (gst_util_uint64_scale_int (n / oss->bytes_per_sample,
+                G_USEC_PER_SEC, oss->rate), 500));
+    GST_OBJECT_LOCK (oss);
+  }
+
+  n = MIN (length, avail);
+  n -= n % oss->bytes_per_sample;
+
+  pos = oss->mmap_written % oss->mmap_size;
+  first = MIN (n, oss->mmap_size - pos);
+  memcpy (oss->mmap_data + pos, data, first);
+  if (n > first)
+    memcpy (oss->mmap_data, data + first, n - first);
+  oss->mmap_written += n;
+  GST_OBJECT_UNLOCK (oss);
+
+  GST_LOG_OBJECT (oss, "wrote %d/%d samples, %" G_GUINT64_FORMAT " queued",
+      n / oss->bytes_per_sample, length / oss->bytes_per_sample,
+      (queued + n) / oss->bytes_per_sample);
+
+  return n;
+
+  /* ERRORS */
+trigger_failed:
+  {
+    GST_OBJECT_UNLOCK (oss);
+    GST_ELEMENT_ERROR (oss, RESOURCE, WRITE, (_("Audio playback error.")),
+        ("SETTRIGGER: %s (device: %s)", g_strerror (errno), oss->open_device));
+    return -1;
+  }
+}
+
 static gint
 gst_oss4_sink_write (GstAudioSink * asink, gpointer data, guint length)
 {
@@ -633,6 +842,9 @@ gst_oss4_sink_write (GstAudioSink * asink, gpointer data, guint length)
 
   oss = GST_OSS4_SINK_CAST (asink);
 
+  if (oss->mmap_data)
+    return gst_oss4_sink_write_mmap (oss, data, length);
+
   n = write (oss->fd, data, length);
   GST_LOG_OBJECT (asink, "wrote %d/%d samples, %d bytes",
       n / oss->bytes_per_sample, length / oss->bytes_per_sample, n);
@@ -669,7 +881,11 @@ gst_oss4_sink_delay (GstAudioSink * asink)
   oss = GST_OSS4_SINK_CAST (asink);
 
   GST_OBJECT_LOCK (oss);
-  if (ioctl (oss->fd, SNDCTL_DSP_GETODELAY, &delay) < 0 || delay < 0) {
+  if (oss->mmap_data) {
+    /* the exact position of the DMA pointer */
+    gst_oss4_sink_mmap_update (oss);
+    delay = oss->mmap_written - oss->mmap_played;
+  } else if (ioctl (oss->fd, SNDCTL_DSP_GETODELAY, &delay) < 0 || delay < 0) {
     GST_LOG_OBJECT (oss, "GETODELAY failed");
   }
   GST_OBJECT_UNLOCK (oss);
@@ -683,7 +899,19 @@ gst_oss4_sink_delay (GstAudioSink * asink)
 static void
 gst_oss4_sink_reset (GstAudioSink * asink)
 {
+  GstOss4Sink *oss = GST_OSS4_SINK_CAST (asink);
+
   /* There's nothing we can do here really: OSS can't handle access to the
    * same device/fd from multiple threads and might deadlock or blow up in
    * other ways if we try an ioctl SNDCTL_DSP_HALT or similar */
+
+  /* in mmap mode we can at least silence what is queued */
+  GST_OBJECT_LOCK (oss);
+  if (oss->mmap_data) {
+    gst_oss4_sink_mmap_update (oss);
+    gst_oss4_sink_mmap_clear (oss, oss->mmap_played,
+        oss->mmap_written - oss->mmap_played);
+    oss->mmap_written = oss->mmap_played;
+  }
+  GST_OBJECT_UNLOCK (oss);
 }
@@ -46,6 +46,18 @@ struct _GstOss4Sink {
   gint          bytes_per_sample;
   gint          mute_volume;
 
+  /* mmap output, mmap_data is NULL when writing with write() */
+  gboolean      mmap;               /* property                          */
+  guint8      * mmap_data;          /* the mapped DMA buffer             */
+  gint          mmap_size;
+  gint          mmap_fill;          /* max bytes queued in the buffer    */
+  guint64       mmap_written;       /* bytes written since prepare       */
+  guint64       mmap_played;        /* bytes played since prepare        */
+  guint         mmap_last_bytes;    /* last count_info.bytes             */
+  gboolean      mmap_started;       /* output was triggered              */
+  gint          rate;
+  const GstAudioFormatInfo * finfo;
+
   GstCaps     * probed_caps;
 };
 
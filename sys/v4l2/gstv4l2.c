@@ -33,7 +33,10 @@
 #include "gstv4l2src.h"
 #include "gstv4l2sink.h"
 #include "gstv4l2radio.h"
+#include "gstv4l2multisrc.h"
 #include "gstv4l2videodec.h"
+#include "gstv4l2videoenc.h"
+#include "gstv4l2transform.h"
 #include "gstv4l2devicemonitor.h"
 /* #include "gstv4l2jpegsrc.h" */
 /* #include "gstv4l2mjpegsrc.h" */
@@ -53,7 +56,11 @@ plugin_init (GstPlugin * plugin)
           GST_TYPE_V4L2SINK) ||
       !gst_element_register (plugin, "v4l2radio", GST_RANK_NONE,
           GST_TYPE_V4L2RADIO) ||
+      !gst_element_register (plugin, "v4l2multisrc", GST_RANK_NONE,
+          GST_TYPE_V4L2_MULTI_SRC) ||
       !gst_v4l2_video_dec_register (plugin) ||
+      !gst_v4l2_video_enc_register (plugin) ||
+      !gst_v4l2_transform_register (plugin) ||
       !gst_device_monitor_register (plugin, "v4l2monitor",
           GST_RANK_PRIMARY, GST_TYPE_V4L2_DEVICE_MONITOR) ||
       /*       !gst_element_register (plugin, "v4l2jpegsrc", */
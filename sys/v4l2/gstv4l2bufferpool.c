@@ -101,6 +101,7 @@ gst_v4l2_buffer_pool_free_buffer (GstBufferPool * bpool, GstBuffer * buffer)
   switch (obj->mode) {
     case GST_V4L2_IO_RW:
     case GST_V4L2_IO_DMABUF:
+    case GST_V4L2_IO_DMABUF_IMPORT:
       break;
     case GST_V4L2_IO_MMAP:
     {
@@ -156,13 +157,14 @@ gst_v4l2_buffer_pool_alloc_buffer (GstBufferPool * bpool, GstBuffer ** buffer,
     }
     case GST_V4L2_IO_MMAP:
     case GST_V4L2_IO_DMABUF:
+    case GST_V4L2_IO_DMABUF_IMPORT:
     {
       if (pool->num_allocated == pool->num_buffers) {
         struct v4l2_create_buffers create_bufs;
 
         memset (&create_bufs, 0, sizeof (struct v4l2_create_buffers));
         create_bufs.count = 1;
-        create_bufs.memory = V4L2_MEMORY_MMAP;
+        create_bufs.memory = pool->memory;
         create_bufs.format.type = obj->type;
 
         if (v4l2_ioctl (pool->video_fd, VIDIOC_G_FMT, &create_bufs.format) < 0)
@@ -189,7 +191,7 @@ gst_v4l2_buffer_pool_alloc_buffer (GstBufferPool * bpool, GstBuffer ** buffer,
       memset (&meta->vbuffer, 0x0, sizeof (struct v4l2_buffer));
       meta->vbuffer.index = index;
       meta->vbuffer.type = obj->type;
-      meta->vbuffer.memory = V4L2_MEMORY_MMAP;
+      meta->vbuffer.memory = pool->memory;
 
       /* main information */
       meta->n_planes = obj->n_v4l2_planes;
@@ -254,6 +256,16 @@ gst_v4l2_buffer_pool_alloc_buffer (GstBufferPool * bpool, GstBuffer ** buffer,
         }
       }
 
+      if (obj->mode == GST_V4L2_IO_DMABUF_IMPORT) {
+        /* the planes get their memory when upstream buffers are imported,
+         * see gst_v4l2_buffer_pool_import_dmabuf() */
+        for (i = 0; i < meta->n_planes; i++)
+          meta->vplanes[i].m.fd = -1;
+
+        if (!V4L2_TYPE_IS_MULTIPLANAR (obj->type))
+          meta->vbuffer.m.fd = -1;
+      }
+
       if (obj->mode == GST_V4L2_IO_DMABUF) {
         struct v4l2_exportbuffer expbuf;
 
@@ -283,7 +295,8 @@ gst_v4l2_buffer_pool_alloc_buffer (GstBufferPool * bpool, GstBuffer ** buffer,
       }
 
       /* add metadata to raw video buffers */
-      if (pool->add_videometa && info->finfo) {
+      if (pool->add_videometa && info->finfo &&
+          obj->mode != GST_V4L2_IO_DMABUF_IMPORT) {
         const GstVideoFormatInfo *finfo = info->finfo;
         gsize offset[GST_VIDEO_MAX_PLANES];
         gint width, height, n_gst_planes, offs, i, stride[GST_VIDEO_MAX_PLANES];
@@ -484,6 +497,35 @@ wrong_config:
   }
 }
 
+/* CREATE_BUFS with a count of 0 only checks whether the driver implements
+ * it for this memory type */
+static gboolean
+gst_v4l2_buffer_pool_can_create_bufs (GstV4l2BufferPool * pool)
+{
+  GstV4l2Object *obj = pool->obj;
+  struct v4l2_create_buffers create_bufs;
+
+  memset (&create_bufs, 0, sizeof (struct v4l2_create_buffers));
+  create_bufs.count = 0;
+  create_bufs.memory = pool->memory;
+  create_bufs.format.type = obj->type;
+
+  if (v4l2_ioctl (pool->video_fd, VIDIOC_G_FMT, &create_bufs.format) < 0)
+    goto failed;
+
+  if (v4l2_ioctl (pool->video_fd, VIDIOC_CREATE_BUFS, &create_bufs) < 0)
+    goto failed;
+
+  return TRUE;
+
+failed:
+  {
+    GST_DEBUG_OBJECT (pool, "driver can't add buffers: %s",
+        g_strerror (errno));
+    return FALSE;
+  }
+}
+
 static gboolean
 start_streaming (GstV4l2BufferPool * pool)
 {
@@ -495,6 +537,7 @@ start_streaming (GstV4l2BufferPool * pool)
     case GST_V4L2_IO_MMAP:
     case GST_V4L2_IO_USERPTR:
     case GST_V4L2_IO_DMABUF:
+    case GST_V4L2_IO_DMABUF_IMPORT:
       GST_DEBUG_OBJECT (pool, "STREAMON");
       if (v4l2_ioctl (pool->video_fd, VIDIOC_STREAMON, &obj->type) < 0)
         goto start_failed;
@@ -541,22 +584,28 @@ gst_v4l2_buffer_pool_start (GstBufferPool * bpool)
       break;
     case GST_V4L2_IO_DMABUF:
     case GST_V4L2_IO_MMAP:
+    case GST_V4L2_IO_DMABUF_IMPORT:
     {
       /* request a reasonable number of buffers when no max specified. We will
        * copy when we run out of buffers */
       if (max_buffers == 0)
-        num_buffers = MAX (4, min_buffers);
+        num_buffers = MAX (GST_V4L2_DEFAULT_BUFFERS, min_buffers);
       else
         num_buffers = max_buffers;
 
       /* first, lets request buffers, and see how many we can get: */
-      GST_DEBUG_OBJECT (pool, "starting, requesting %d MMAP buffers",
-          num_buffers);
+      if (obj->mode == GST_V4L2_IO_DMABUF_IMPORT)
+        pool->memory = V4L2_MEMORY_DMABUF;
+      else
+        pool->memory = V4L2_MEMORY_MMAP;
+
+      GST_DEBUG_OBJECT (pool, "starting, requesting %d %s buffers",
+          num_buffers, pool->memory == V4L2_MEMORY_MMAP ? "MMAP" : "DMABUF");
 
       memset (&breq, 0, sizeof (struct v4l2_requestbuffers));
       breq.type = obj->type;
       breq.count = num_buffers;
-      breq.memory = V4L2_MEMORY_MMAP;
+      breq.memory = pool->memory;
 
       if (v4l2_ioctl (pool->video_fd, VIDIOC_REQBUFS, &breq) < 0)
         goto reqbufs_failed;
@@ -587,8 +636,12 @@ gst_v4l2_buffer_pool_start (GstBufferPool * bpool)
         copy_threshold = 0;
       }
 
-      /* FIXME try to call CREATEBUFS with count 0 to check if max shall
-       * remain 0 */
+      /* rather than copying, grow the pool up to the configured maximum
+       * when the driver can add buffers while streaming */
+      pool->max_buffers = max_buffers ? max_buffers : GST_V4L2_MAX_BUFFERS;
+      pool->can_alloc = copy_threshold > 0 &&
+          num_buffers < pool->max_buffers &&
+          gst_v4l2_buffer_pool_can_create_bufs (pool);
       break;
     }
     case GST_V4L2_IO_USERPTR:
@@ -602,6 +655,8 @@ gst_v4l2_buffer_pool_start (GstBufferPool * bpool)
   pool->size = size;
   pool->num_buffers = num_buffers;
   pool->copy_threshold = copy_threshold;
+  pool->num_copies = 0;
+  pool->copying = FALSE;
 
   gst_buffer_pool_config_set_params (config, caps, size, min_buffers,
       max_buffers);
@@ -659,7 +714,7 @@ gst_v4l2_buffer_pool_free_buffers (GstV4l2BufferPool * pool)
     memset (&breq, 0, sizeof (struct v4l2_requestbuffers));
     breq.type = pool->obj->type;
     breq.count = 0;
-    breq.memory = V4L2_MEMORY_MMAP;
+    breq.memory = pool->memory;
     if (v4l2_ioctl (pool->video_fd, VIDIOC_REQBUFS, &breq) < 0) {
       GST_ERROR_OBJECT (pool, "error releasing buffers: %s",
           g_strerror (errno));
@@ -690,6 +745,7 @@ stop_streaming (GstV4l2BufferPool * pool)
     case GST_V4L2_IO_MMAP:
     case GST_V4L2_IO_USERPTR:
     case GST_V4L2_IO_DMABUF:
+    case GST_V4L2_IO_DMABUF_IMPORT:
       GST_DEBUG_OBJECT (pool, "STREAMOFF");
       if (v4l2_ioctl (pool->video_fd, VIDIOC_STREAMOFF, &obj->type) < 0)
         goto stop_failed;
@@ -731,6 +787,7 @@ gst_v4l2_buffer_pool_stop (GstBufferPool * bpool)
       case GST_V4L2_IO_MMAP:
       case GST_V4L2_IO_USERPTR:
       case GST_V4L2_IO_DMABUF:
+      case GST_V4L2_IO_DMABUF_IMPORT:
         /* we actually need to sync on all queued buffers but not
          * on the non-queued ones */
         GST_DEBUG_OBJECT (pool, "STREAMOFF");
@@ -827,8 +884,17 @@ gst_v4l2_buffer_pool_qbuf (GstV4l2BufferPool * pool, GstBuffer * buf)
   meta->vbuffer.bytesused = gst_buffer_get_size (buf);
 
   for (i = 0; i < meta->n_planes; i++) {
-    meta->vplanes[i].bytesused =
-        gst_buffer_get_sizes_range (buf, i, 1, NULL, NULL);
+    if ((guint) i < gst_buffer_n_memory (buf))
+      meta->vplanes[i].bytesused =
+          gst_buffer_get_sizes_range (buf, i, 1, NULL, NULL);
+    else
+      meta->vplanes[i].bytesused = 0;
+
+    /* imported planes start at data_offset inside the dmabuf and bytesused
+     * accounts for it */
+    if (pool->obj->mode == GST_V4L2_IO_DMABUF_IMPORT &&
+        meta->vplanes[i].bytesused > 0)
+      meta->vplanes[i].bytesused += meta->vplanes[i].data_offset;
 
     GST_LOG_OBJECT (pool,
         "enqueue buffer %p, index:%d, queued:%d, flags:%08x mem:%p used:%d, plane:%d",
@@ -881,7 +947,8 @@ gst_v4l2_buffer_pool_dqbuf (GstV4l2BufferPool * pool, GstBuffer ** buffer)
   memset (&vbuffer, 0x00, sizeof (vbuffer));
   vbuffer.type = obj->type;
 
-  if (obj->mode == GST_V4L2_IO_DMABUF)
+  if (obj->mode == GST_V4L2_IO_DMABUF ||
+      obj->mode == GST_V4L2_IO_DMABUF_IMPORT)
     vbuffer.memory = V4L2_MEMORY_DMABUF;
   else
     vbuffer.memory = V4L2_MEMORY_MMAP;
@@ -975,8 +1042,9 @@ gst_v4l2_buffer_pool_dqbuf (GstV4l2BufferPool * pool, GstBuffer ** buffer)
    * element, so just put back the original one. We always set it as
    * no share, so if it's not there, it's not used at all.
    */
-  if (obj->type == V4L2_BUF_TYPE_VIDEO_CAPTURE
-      || obj->type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE) {
+  if (obj->mode == GST_V4L2_IO_MMAP && (obj->type ==
+          V4L2_BUF_TYPE_VIDEO_CAPTURE
+          || obj->type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)) {
     gst_buffer_remove_all_memory (outbuf);
     for (i = 0; i < meta->n_planes; i++) {
       gst_buffer_append_memory (outbuf,
@@ -985,6 +1053,20 @@ gst_v4l2_buffer_pool_dqbuf (GstV4l2BufferPool * pool, GstBuffer ** buffer)
               meta->vplanes[i].data_offset,
               meta->vplanes[i].bytesused, NULL, NULL));
     }
+  } else if (obj->mode == GST_V4L2_IO_DMABUF && (obj->type ==
+          V4L2_BUF_TYPE_VIDEO_CAPTURE
+          || obj->type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)) {
+    /* there is no mapping to wrap, the exported dmabufs stay attached to the
+     * buffer, only adjust them to what the driver filled */
+    for (i = 0; i < meta->n_planes && (guint) i < gst_buffer_n_memory (outbuf);
+        i++) {
+      GstMemory *mem = gst_buffer_peek_memory (outbuf, i);
+      gsize size = MIN (meta->vplanes[i].bytesused,
+          mem->maxsize - meta->vplanes[i].data_offset);
+
+      gst_memory_resize (mem, (gssize) meta->vplanes[i].data_offset -
+          (gssize) mem->offset, size);
+    }
   }
 
   GST_BUFFER_TIMESTAMP (outbuf) = timestamp;
@@ -1055,6 +1137,28 @@ no_buffer:
   }
 }
 
+/* Tell the application that frames get copied because downstream holds on to
+ * too many buffers, posted once each time the pool starts copying. The
+ * "v4l2-buffer-pool-copy" element message carries the pool size, the number
+ * of buffers still queued and the total number of copies so far. */
+static void
+gst_v4l2_buffer_pool_post_copy_message (GstV4l2BufferPool * pool)
+{
+  GstV4l2Object *obj = pool->obj;
+  GstStructure *s;
+
+  GST_INFO_OBJECT (pool, "running low on buffers (%u queued of %u), copying",
+      pool->num_queued, pool->num_buffers);
+
+  s = gst_structure_new ("v4l2-buffer-pool-copy",
+      "num-buffers", G_TYPE_UINT, pool->num_buffers,
+      "num-queued", G_TYPE_UINT, pool->num_queued,
+      "copies", G_TYPE_UINT64, pool->num_copies, NULL);
+
+  gst_element_post_message (obj->element,
+      gst_message_new_element (GST_OBJECT_CAST (obj->element), s));
+}
+
 static GstFlowReturn
 gst_v4l2_buffer_pool_acquire_buffer (GstBufferPool * bpool, GstBuffer ** buffer,
     GstBufferPoolAcquireParams * params)
@@ -1091,9 +1195,13 @@ gst_v4l2_buffer_pool_acquire_buffer (GstBufferPool * bpool, GstBuffer ** buffer,
           if (pool->num_queued < pool->copy_threshold) {
             GstBuffer *copy;
 
-            if (pool->can_alloc) {
+            /* first try to add a buffer to the device queue, this goes
+             * through CREATE_BUFS in _alloc_buffer() */
+            if (pool->can_alloc && pool->num_buffers < pool->max_buffers) {
               if (GST_BUFFER_POOL_CLASS (parent_class)->acquire_buffer (bpool,
                       &copy, params) == GST_FLOW_OK) {
+                GST_DEBUG_OBJECT (pool, "grew pool to %u buffers",
+                    pool->num_buffers);
                 gst_v4l2_buffer_pool_release_buffer (bpool, copy);
                 break;
               } else {
@@ -1101,6 +1209,12 @@ gst_v4l2_buffer_pool_acquire_buffer (GstBufferPool * bpool, GstBuffer ** buffer,
               }
             }
 
+            pool->num_copies++;
+            if (!pool->copying) {
+              pool->copying = TRUE;
+              gst_v4l2_buffer_pool_post_copy_message (pool);
+            }
+
             /* copy the buffer */
             copy = gst_buffer_copy_region (*buffer,
                 GST_BUFFER_COPY_ALL | GST_BUFFER_COPY_DEEP, 0, -1);
@@ -1109,6 +1223,8 @@ gst_v4l2_buffer_pool_acquire_buffer (GstBufferPool * bpool, GstBuffer ** buffer,
             /* and requeue so that we can continue capturing */
             ret = gst_v4l2_buffer_pool_qbuf (pool, *buffer);
             *buffer = copy;
+          } else {
+            pool->copying = FALSE;
           }
           break;
 
@@ -1131,6 +1247,7 @@ gst_v4l2_buffer_pool_acquire_buffer (GstBufferPool * bpool, GstBuffer ** buffer,
           break;
 
         case GST_V4L2_IO_MMAP:
+        case GST_V4L2_IO_DMABUF_IMPORT:
           /* get a free unqueued buffer */
           ret = GST_BUFFER_POOL_CLASS (parent_class)->acquire_buffer (bpool,
               buffer, params);
@@ -1247,6 +1364,30 @@ gst_v4l2_buffer_pool_release_buffer (GstBufferPool * bpool, GstBuffer * buffer)
           break;
         }
 
+        case GST_V4L2_IO_DMABUF_IMPORT:
+        {
+          GstV4l2Meta *meta;
+          guint index;
+
+          meta = GST_V4L2_META_GET (buffer);
+          g_assert (meta != NULL);
+
+          index = meta->vbuffer.index;
+
+          /* the imported memory stays attached until the next import so that
+           * the planes always refer to valid dmabufs, this is what allows to
+           * queue empty buffers when draining */
+          if (pool->buffers[index] == NULL) {
+            GST_LOG_OBJECT (pool, "buffer %u not queued, putting on free list",
+                index);
+            GST_BUFFER_POOL_CLASS (parent_class)->release_buffer (bpool,
+                buffer);
+          } else {
+            GST_LOG_OBJECT (pool, "buffer %u is queued", index);
+          }
+          break;
+        }
+
         case GST_V4L2_IO_USERPTR:
         default:
           g_assert_not_reached ();
@@ -1324,6 +1465,7 @@ gst_v4l2_buffer_pool_new (GstV4l2Object * obj, GstCaps * caps)
   pool->video_fd = fd;
   pool->obj = obj;
   pool->can_alloc = TRUE;
+  pool->memory = V4L2_MEMORY_MMAP;
 
   config = gst_buffer_pool_get_config (GST_BUFFER_POOL_CAST (pool));
   gst_buffer_pool_config_set_params (config, caps, obj->sizeimage, 2, 0);
@@ -1411,6 +1553,108 @@ cleanup:
   }
 }
 
+/* Attach the dmabufs of @src to the planes of @dest so that the device reads
+ * them directly. @src has to carry one dmabuf memory per v4l2 plane. */
+static gboolean
+gst_v4l2_buffer_pool_import_dmabuf (GstV4l2BufferPool * pool,
+    GstBuffer * dest, GstBuffer * src)
+{
+  GstV4l2Object *obj = pool->obj;
+  GstV4l2Meta *meta;
+  GstMemory *mem;
+  guint i, n_mem;
+
+  meta = GST_V4L2_META_GET (dest);
+  g_assert (meta != NULL);
+
+  n_mem = gst_buffer_n_memory (src);
+  if (n_mem != meta->n_planes)
+    goto wrong_planes;
+
+  for (i = 0; i < n_mem; i++) {
+    mem = gst_buffer_peek_memory (src, i);
+
+    if (!gst_is_dmabuf_memory (mem))
+      goto not_dmabuf;
+
+    /* single plane buffers have no data_offset */
+    if (!V4L2_TYPE_IS_MULTIPLANAR (obj->type) && mem->offset != 0)
+      goto has_offset;
+  }
+
+  /* the device reads the planes with the stride it was configured with,
+   * there is no way to tell it about a different layout per buffer */
+  if (GST_VIDEO_INFO_FORMAT (&obj->info) != GST_VIDEO_FORMAT_ENCODED) {
+    GstVideoMeta *vmeta = gst_buffer_get_video_meta (src);
+    gint n_checked = V4L2_TYPE_IS_MULTIPLANAR (obj->type) ?
+        GST_VIDEO_INFO_N_PLANES (&obj->info) : 1;
+
+    for (i = 0; i < n_checked; i++) {
+      gint stride;
+
+      if (vmeta)
+        stride = vmeta->stride[i];
+      else
+        stride = GST_VIDEO_INFO_PLANE_STRIDE (&obj->info, i);
+
+      if (GST_VIDEO_FORMAT_INFO_IS_TILED (obj->info.finfo))
+        stride = GST_VIDEO_TILE_X_TILES (stride) <<
+            GST_VIDEO_FORMAT_INFO_TILE_WS (obj->info.finfo);
+
+      if (stride != obj->bytesperline[i])
+        goto wrong_stride;
+    }
+  }
+
+  /* release the memory of the previous import */
+  gst_buffer_remove_all_memory (dest);
+
+  for (i = 0; i < n_mem; i++) {
+    mem = gst_buffer_peek_memory (src, i);
+
+    meta->vplanes[i].m.fd = gst_dmabuf_memory_get_fd (mem);
+    meta->vplanes[i].length = mem->maxsize;
+    meta->vplanes[i].data_offset = mem->offset;
+
+    gst_buffer_append_memory (dest, gst_memory_ref (mem));
+  }
+
+  if (!V4L2_TYPE_IS_MULTIPLANAR (obj->type)) {
+    meta->vbuffer.m.fd = meta->vplanes[0].m.fd;
+    meta->vbuffer.length = meta->vplanes[0].length;
+  }
+
+  GST_LOG_OBJECT (pool, "imported %u dmabuf(s) from buffer %p into %u", n_mem,
+      src, meta->vbuffer.index);
+
+  return TRUE;
+
+  /* ERRORS */
+wrong_planes:
+  {
+    GST_ERROR_OBJECT (pool, "buffer %p has %u memories, device wants %u "
+        "planes", src, n_mem, meta->n_planes);
+    return FALSE;
+  }
+not_dmabuf:
+  {
+    GST_ERROR_OBJECT (pool, "memory %u of buffer %p is not a dmabuf", i, src);
+    return FALSE;
+  }
+has_offset:
+  {
+    GST_ERROR_OBJECT (pool, "memory of buffer %p has an offset of %"
+        G_GSIZE_FORMAT, src, mem->offset);
+    return FALSE;
+  }
+wrong_stride:
+  {
+    GST_ERROR_OBJECT (pool, "plane %u of buffer %p does not have the stride "
+        "of the device (%u)", i, src, obj->bytesperline[i]);
+    return FALSE;
+  }
+}
+
 /**
  * gst_v4l2_buffer_pool_process:
  * @bpool: a #GstBufferPool
@@ -1441,6 +1685,7 @@ gst_v4l2_buffer_pool_process (GstV4l2BufferPool * pool, GstBuffer * buf)
           ret = gst_v4l2_do_read (pool, buf);
           break;
 
+        case GST_V4L2_IO_DMABUF:
         case GST_V4L2_IO_MMAP:
         {
           GstBuffer *tmp;
@@ -1479,6 +1724,7 @@ gst_v4l2_buffer_pool_process (GstV4l2BufferPool * pool, GstBuffer * buf)
           break;
         case GST_V4L2_IO_DMABUF:
         case GST_V4L2_IO_MMAP:
+        case GST_V4L2_IO_DMABUF_IMPORT:
         {
           GstBuffer *to_queue;
 
@@ -1510,9 +1756,16 @@ gst_v4l2_buffer_pool_process (GstV4l2BufferPool * pool, GstBuffer * buf)
             if (ret != GST_FLOW_OK)
               goto acquire_failed;
 
-            /* copy into it and queue */
-            if (!gst_v4l2_object_copy (obj, to_queue, buf))
+            if (obj->mode == GST_V4L2_IO_DMABUF_IMPORT) {
+              /* queue the upstream dmabufs themselves */
+              if (!gst_v4l2_buffer_pool_import_dmabuf (pool, to_queue, buf)) {
+                gst_buffer_unref (to_queue);
+                goto import_failed;
+              }
+            } else if (!gst_v4l2_object_copy (obj, to_queue, buf)) {
+              /* copy into it and queue */
               goto copy_failed;
+            }
           }
 
           if ((ret = gst_v4l2_buffer_pool_qbuf (pool, to_queue)) != GST_FLOW_OK)
@@ -1574,6 +1827,12 @@ copy_failed:
     GST_ERROR_OBJECT (obj->element, "failed to copy data");
     return GST_FLOW_ERROR;
   }
+import_failed:
+  {
+    GST_ELEMENT_ERROR (obj->element, RESOURCE, WRITE, (NULL),
+        ("failed to import buffer %p into device '%s'", buf, obj->videodev));
+    return GST_FLOW_ERROR;
+  }
 start_failed:
   {
     GST_ERROR_OBJECT (obj->element, "failed to start streaming");
@@ -1616,6 +1875,7 @@ gst_v4l2_buffer_pool_flush (GstV4l2BufferPool * pool)
         case GST_V4L2_IO_MMAP:
         case GST_V4L2_IO_USERPTR:
         case GST_V4L2_IO_DMABUF:
+        case GST_V4L2_IO_DMABUF_IMPORT:
         {
           for (i = 0; i < pool->num_buffers; i++) {
             GstBuffer *buf = pool->buffers[i];
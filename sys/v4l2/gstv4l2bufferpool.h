@@ -52,14 +52,18 @@ struct _GstV4l2BufferPool
 
   GstAllocator *allocator;
   GstAllocationParams params;
+  enum v4l2_memory memory;   /* memory type of the v4l2 buffers */
   guint size;
   gboolean add_videometa;
   gboolean can_alloc;        /* if extra buffers can be allocated */
+  guint max_buffers;         /* limit when growing with CREATE_BUFS */
 
   guint num_buffers;         /* number of buffers we use */
   guint num_allocated;       /* number of buffers allocated by the driver */
   guint num_queued;          /* number of buffers queued in the driver */
   guint copy_threshold;      /* when our pool runs lower, start handing out copies */
+  guint64 num_copies;        /* frames handed out as copies */
+  gboolean copying;          /* the last acquired frame was a copy */
 
   gboolean streaming;
 
@@ -223,6 +223,9 @@ uevent_cb (GUdevClient * client, const gchar * action, GUdevDevice * device,
   if (g_udev_device_get_property_as_int (device, "ID_V4L_VERSION") != 2)
     return;
 
+  /* the device behind a bus position may have changed */
+  gst_v4l2_object_clear_caps_cache ();
+
   if (!strcmp (action, "add")) {
     GstDevice *gstdev = NULL;
 
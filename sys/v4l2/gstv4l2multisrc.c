@@ -0,0 +1,895 @@
+/*
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+/**
+ * SECTION:element-v4l2multisrc
+ *
+ * v4l2multisrc captures from several v4l2 devices at once, with one pad per
+ * device. A single streaming thread waits on all devices and dequeues the
+ * frames as they arrive, instead of one thread per v4l2src.
+ *
+ * When #GstV4l2MultiSrc:sync-tolerance is set, frames are grouped into sets
+ * with one frame of every device, captured no further apart than the
+ * tolerance. Frames that can't be part of a set are dropped, and all frames
+ * of a set get the same timestamp. Capture times are only comparable to
+ * that precision when the pipeline clock is the monotonic system clock,
+ * which is the default.
+ *
+ * Because the frames of all devices are pushed from the same thread, each
+ * pad should be followed by a queue so that one slow branch does not hold
+ * up the others.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 v4l2multisrc devices=/dev/video0,/dev/video1
+ *     sync-tolerance=5000000 name=src
+ *     src.src_0 ! queue ! videoconvert ! xvimagesink
+ *     src.src_1 ! queue ! videoconvert ! xvimagesink
+ * ]| This pipeline shows two cameras side by side, in frames captured at
+ * most 5ms apart.
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#include "gstv4l2multisrc.h"
+#include "v4l2_calls.h"
+
+#include <gst/gst-i18n-plugin.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_v4l2_multi_src_debug);
+#define GST_CAT_DEFAULT gst_v4l2_multi_src_debug
+
+#define DEFAULT_PROP_DEVICES NULL
+#define DEFAULT_PROP_SYNC_TOLERANCE 0
+
+/* frames kept per device while waiting for a set, anything more would take
+ * buffers away from the driver */
+#define MAX_PENDING 2
+
+enum
+{
+  PROP_0,
+  PROP_DEVICES,
+  PROP_SYNC_TOLERANCE
+};
+
+#define gst_v4l2_multi_src_parent_class parent_class
+G_DEFINE_TYPE (GstV4l2MultiSrc, gst_v4l2_multi_src, GST_TYPE_ELEMENT);
+
+static GstV4l2MultiSrcStream *
+gst_v4l2_multi_src_stream_new (GstV4l2MultiSrc * self, const gchar * device,
+    guint index)
+{
+  GstV4l2MultiSrcStream *stream;
+  GstPadTemplate *templ;
+  gchar *name;
+
+  stream = g_slice_new0 (GstV4l2MultiSrcStream);
+  stream->v4l2object = gst_v4l2_object_new (GST_ELEMENT (self),
+      V4L2_BUF_TYPE_VIDEO_CAPTURE, device, gst_v4l2_get_input,
+      gst_v4l2_set_input, NULL);
+  gst_poll_fd_init (&stream->pollfd);
+  g_queue_init (&stream->pending);
+
+  templ = gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (self),
+      "src_%u");
+  name = g_strdup_printf ("src_%u", index);
+  stream->pad = gst_pad_new_from_template (templ, name);
+  g_free (name);
+
+  gst_pad_set_element_private (stream->pad, stream);
+
+  return stream;
+}
+
+static void
+gst_v4l2_multi_src_stream_free (GstV4l2MultiSrcStream * stream)
+{
+  gst_v4l2_object_destroy (stream->v4l2object);
+  g_slice_free (GstV4l2MultiSrcStream, stream);
+}
+
+static gboolean gst_v4l2_multi_src_query (GstPad * pad, GstObject * parent,
+    GstQuery * query);
+
+static void
+gst_v4l2_multi_src_set_devices (GstV4l2MultiSrc * self, const gchar * devices)
+{
+  GList *l;
+  gchar **names;
+  guint i, index = 0;
+
+  for (l = self->streams; l; l = l->next) {
+    GstV4l2MultiSrcStream *stream = l->data;
+
+    gst_element_remove_pad (GST_ELEMENT (self), stream->pad);
+    gst_v4l2_multi_src_stream_free (stream);
+  }
+  g_list_free (self->streams);
+  self->streams = NULL;
+
+  g_free (self->devices);
+  self->devices = g_strdup (devices);
+
+  if (devices == NULL)
+    return;
+
+  names = g_strsplit (devices, ",", -1);
+  for (i = 0; names[i]; i++) {
+    GstV4l2MultiSrcStream *stream;
+    const gchar *device = g_strstrip (names[i]);
+
+    if (*device == '\0')
+      continue;
+
+    stream = gst_v4l2_multi_src_stream_new (self, device, index++);
+    gst_pad_set_query_function (stream->pad,
+        GST_DEBUG_FUNCPTR (gst_v4l2_multi_src_query));
+
+    self->streams = g_list_append (self->streams, stream);
+    gst_element_add_pad (GST_ELEMENT (self), stream->pad);
+  }
+  g_strfreev (names);
+
+  gst_element_no_more_pads (GST_ELEMENT (self));
+}
+
+static void
+gst_v4l2_multi_src_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec)
+{
+  GstV4l2MultiSrc *self = GST_V4L2_MULTI_SRC (object);
+
+  switch (prop_id) {
+    case PROP_DEVICES:
+      /* the pads follow the devices, they can't change once opened */
+      if (GST_STATE (self) != GST_STATE_NULL) {
+        g_warning ("Changing the `devices' property on v4l2multisrc when "
+            "the devices are open is not supported.");
+        break;
+      }
+      gst_v4l2_multi_src_set_devices (self, g_value_get_string (value));
+      break;
+    case PROP_SYNC_TOLERANCE:
+      self->sync_tolerance = g_value_get_uint64 (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_v4l2_multi_src_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec)
+{
+  GstV4l2MultiSrc *self = GST_V4L2_MULTI_SRC (object);
+
+  switch (prop_id) {
+    case PROP_DEVICES:
+      g_value_set_string (value, self->devices);
+      break;
+    case PROP_SYNC_TOLERANCE:
+      g_value_set_uint64 (value, self->sync_tolerance);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_v4l2_multi_src_finalize (GObject * object)
+{
+  GstV4l2MultiSrc *self = GST_V4L2_MULTI_SRC (object);
+
+  g_list_free_full (self->streams,
+      (GDestroyNotify) gst_v4l2_multi_src_stream_free);
+  g_free (self->devices);
+  gst_poll_free (self->poll);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gboolean
+gst_v4l2_multi_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  GstV4l2MultiSrc *self = GST_V4L2_MULTI_SRC (parent);
+  GstV4l2MultiSrcStream *stream = gst_pad_get_element_private (pad);
+  GstV4l2Object *obj = stream->v4l2object;
+  gboolean res = FALSE;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CAPS:{
+      GstCaps *filter, *caps;
+
+      gst_query_parse_caps (query, &filter);
+
+      if (GST_V4L2_IS_OPEN (obj)) {
+        caps = gst_v4l2_object_get_caps (obj, filter);
+      } else {
+        caps = gst_pad_get_pad_template_caps (pad);
+        if (filter) {
+          GstCaps *tmp = caps;
+
+          caps = gst_caps_intersect_full (filter, tmp,
+              GST_CAPS_INTERSECT_FIRST);
+          gst_caps_unref (tmp);
+        }
+      }
+
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      res = TRUE;
+      break;
+    }
+    case GST_QUERY_LATENCY:{
+      GstClockTime min_latency, max_latency;
+      guint num_buffers = 0;
+
+      if (!GST_V4L2_IS_OPEN (obj) || GST_V4L2_FPS_N (obj) <= 0 ||
+          GST_V4L2_FPS_D (obj) <= 0) {
+        GST_WARNING_OBJECT (pad, "Can't give latency since framerate isn't "
+            "fixated !");
+        break;
+      }
+
+      /* the time to capture one frame, plus the time it waits for the
+       * frames of the other devices */
+      min_latency = gst_util_uint64_scale_int (GST_SECOND,
+          GST_V4L2_FPS_D (obj), GST_V4L2_FPS_N (obj));
+
+      if (obj->pool != NULL)
+        num_buffers = GST_V4L2_BUFFER_POOL_CAST (obj->pool)->num_buffers;
+
+      if (num_buffers == 0)
+        max_latency = -1;
+      else
+        max_latency = num_buffers * min_latency;
+
+      min_latency += self->sync_tolerance;
+      if (max_latency != -1)
+        max_latency = MAX (max_latency, min_latency);
+
+      GST_DEBUG_OBJECT (pad,
+          "report latency min %" GST_TIME_FORMAT " max %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (min_latency), GST_TIME_ARGS (max_latency));
+
+      gst_query_set_latency (query, TRUE, min_latency, max_latency);
+      res = TRUE;
+      break;
+    }
+    default:
+      res = gst_pad_query_default (pad, parent, query);
+      break;
+  }
+
+  return res;
+}
+
+/* negotiate the format and the buffers of one device and start capturing,
+ * the way v4l2src does it from its own streaming thread */
+static gboolean
+gst_v4l2_multi_src_start_stream (GstV4l2MultiSrc * self,
+    GstV4l2MultiSrcStream * stream, guint group_id)
+{
+  GstV4l2Object *obj = stream->v4l2object;
+  GstCaps *thiscaps, *caps;
+  GstStructure *s;
+  GstQuery *query;
+  GstSegment segment;
+  GstEvent *event;
+  gchar *stream_id;
+  guint size, min, max;
+
+  stream_id = gst_pad_create_stream_id (stream->pad, GST_ELEMENT_CAST (self),
+      GST_PAD_NAME (stream->pad));
+  event = gst_event_new_stream_start (stream_id);
+  gst_event_set_group_id (event, group_id);
+  gst_pad_push_event (stream->pad, event);
+  g_free (stream_id);
+
+  thiscaps = gst_v4l2_object_get_caps (obj, NULL);
+  caps = gst_pad_peer_query_caps (stream->pad, thiscaps);
+  gst_caps_unref (thiscaps);
+
+  if (gst_caps_is_empty (caps))
+    goto no_caps;
+
+  /* same preference as v4l2src: the biggest size at the highest rate */
+  caps = gst_caps_truncate (caps);
+  s = gst_caps_get_structure (caps, 0);
+  gst_structure_fixate_field_nearest_int (s, "width", G_MAXINT);
+  gst_structure_fixate_field_nearest_int (s, "height", G_MAXINT);
+  gst_structure_fixate_field_nearest_fraction (s, "framerate", G_MAXINT, 1);
+  caps = gst_caps_fixate (caps);
+
+  GST_DEBUG_OBJECT (stream->pad, "fixated to %" GST_PTR_FORMAT, caps);
+
+  if (!gst_v4l2_object_set_format (obj, caps))
+    /* error already posted */
+    goto done;
+
+  gst_pad_set_caps (stream->pad, caps);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (stream->pad, gst_event_new_segment (&segment));
+
+  query = gst_query_new_allocation (caps, TRUE);
+  if (!gst_pad_peer_query (stream->pad, query))
+    GST_DEBUG_OBJECT (stream->pad, "allocation query failed");
+
+  if (!gst_v4l2_object_decide_allocation (obj, query)) {
+    gst_query_unref (query);
+    goto done;
+  }
+
+  gst_query_parse_nth_allocation_pool (query, 0, &stream->pool, &size, &min,
+      &max);
+  gst_query_unref (query);
+
+  if (!gst_buffer_pool_set_active (stream->pool, TRUE))
+    goto activate_failed;
+
+  gst_caps_unref (caps);
+
+  stream->pollfd.fd = obj->video_fd;
+  gst_poll_add_fd (self->poll, &stream->pollfd);
+  gst_poll_fd_ctl_read (self->poll, &stream->pollfd, TRUE);
+
+  stream->offset = 0;
+  stream->last_ret = GST_FLOW_OK;
+
+  return TRUE;
+
+  /* ERRORS */
+no_caps:
+  {
+    GST_ELEMENT_ERROR (self, STREAM, FORMAT, (NULL),
+        ("No common format for device %s", obj->videodev));
+    goto done;
+  }
+activate_failed:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS,
+        (_("Video device could not create buffer pool.")),
+        ("Failed to activate the pool of device %s", obj->videodev));
+    goto done;
+  }
+done:
+  {
+    gst_caps_unref (caps);
+    return FALSE;
+  }
+}
+
+static void
+gst_v4l2_multi_src_stop_stream (GstV4l2MultiSrc * self,
+    GstV4l2MultiSrcStream * stream)
+{
+  GstV4l2Object *obj = stream->v4l2object;
+
+  g_queue_foreach (&stream->pending, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&stream->pending);
+
+  if (stream->pollfd.fd >= 0) {
+    gst_poll_remove_fd (self->poll, &stream->pollfd);
+    gst_poll_fd_init (&stream->pollfd);
+  }
+
+  if (stream->pool) {
+    if (stream->pool != GST_BUFFER_POOL_CAST (obj->pool))
+      gst_buffer_pool_set_active (stream->pool, FALSE);
+    gst_object_unref (stream->pool);
+    stream->pool = NULL;
+  }
+
+  gst_v4l2_object_stop (obj);
+}
+
+/* only the plain system clock shares the time base of the driver */
+static gboolean
+gst_v4l2_multi_src_clock_is_monotonic (GstClock * clock)
+{
+  GstClockType clock_type;
+
+  if (G_OBJECT_TYPE (clock) != GST_TYPE_SYSTEM_CLOCK)
+    return FALSE;
+
+  g_object_get (clock, "clock-type", &clock_type, NULL);
+
+  return clock_type == GST_CLOCK_TYPE_MONOTONIC;
+}
+
+/* With the monotonic system clock, the capture time of the driver converts
+ * to running time as is, which is what makes the frames of different
+ * devices comparable. Otherwise fall back to sampling the clock and
+ * subtracting the delay since the capture, like v4l2src. */
+static void
+gst_v4l2_multi_src_timestamp (GstV4l2MultiSrc * self,
+    GstV4l2MultiSrcStream * stream, GstBuffer * buf)
+{
+  GstV4l2Object *obj = stream->v4l2object;
+  GstClock *clock;
+  GstClockTime abs_time, base_time, timestamp, delay = 0;
+  gboolean driver_ts = FALSE;
+
+  timestamp = GST_BUFFER_TIMESTAMP (buf);
+
+  GST_OBJECT_LOCK (self);
+  if ((clock = GST_ELEMENT_CLOCK (self)))
+    gst_object_ref (clock);
+  base_time = GST_ELEMENT_CAST (self)->base_time;
+  GST_OBJECT_UNLOCK (self);
+
+  if (clock) {
+    abs_time = gst_clock_get_time (clock);
+    driver_ts = gst_v4l2_multi_src_clock_is_monotonic (clock);
+    gst_object_unref (clock);
+  } else {
+    abs_time = GST_CLOCK_TIME_NONE;
+  }
+
+  if (GST_CLOCK_TIME_IS_VALID (timestamp)) {
+    struct timespec now;
+    GstClockTime gstnow;
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    gstnow = GST_TIMESPEC_TO_TIME (now);
+
+    if (gstnow < timestamp && (timestamp - gstnow) > (10 * GST_SECOND)) {
+      GTimeVal tv;
+
+      /* the driver uses the system time */
+      g_get_current_time (&tv);
+      gstnow = GST_TIMEVAL_TO_TIME (tv);
+      driver_ts = FALSE;
+    }
+
+    if (gstnow > timestamp)
+      delay = gstnow - timestamp;
+  } else {
+    driver_ts = FALSE;
+
+    /* we assume 1 frame latency otherwise */
+    if (GST_CLOCK_TIME_IS_VALID (obj->duration))
+      delay = obj->duration;
+  }
+
+  if (!GST_CLOCK_TIME_IS_VALID (abs_time)) {
+    timestamp = GST_CLOCK_TIME_NONE;
+  } else if (driver_ts) {
+    timestamp = timestamp > base_time ? timestamp - base_time : 0;
+  } else {
+    timestamp = abs_time - base_time;
+    timestamp = timestamp > delay ? timestamp - delay : 0;
+  }
+
+  GST_BUFFER_TIMESTAMP (buf) = timestamp;
+  GST_BUFFER_DURATION (buf) = obj->duration;
+  GST_BUFFER_OFFSET (buf) = stream->offset++;
+  GST_BUFFER_OFFSET_END (buf) = stream->offset;
+}
+
+static GstFlowReturn
+gst_v4l2_multi_src_capture (GstV4l2MultiSrc * self,
+    GstV4l2MultiSrcStream * stream, GstBuffer ** buf)
+{
+  GstV4l2Object *obj = stream->v4l2object;
+  GstFlowReturn ret;
+
+  /* the device is readable, this doesn't block */
+  ret = gst_buffer_pool_acquire_buffer (stream->pool, buf, NULL);
+  if (G_UNLIKELY (ret != GST_FLOW_OK))
+    return ret;
+
+  ret = gst_v4l2_buffer_pool_process (GST_V4L2_BUFFER_POOL_CAST (obj->pool),
+      *buf);
+  if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+    gst_buffer_unref (*buf);
+    *buf = NULL;
+    return ret;
+  }
+
+  gst_v4l2_multi_src_timestamp (self, stream, *buf);
+
+  return GST_FLOW_OK;
+}
+
+/* An unlinked device doesn't stop the others, only when none is linked
+ * anymore. */
+static GstFlowReturn
+gst_v4l2_multi_src_push (GstV4l2MultiSrc * self,
+    GstV4l2MultiSrcStream * stream, GstBuffer * buf)
+{
+  GstFlowReturn ret;
+  GList *l;
+
+  GST_LOG_OBJECT (stream->pad, "pushing frame %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)));
+
+  ret = gst_pad_push (stream->pad, buf);
+  stream->last_ret = ret;
+
+  if (ret != GST_FLOW_NOT_LINKED)
+    return ret;
+
+  for (l = self->streams; l; l = l->next) {
+    GstV4l2MultiSrcStream *other = l->data;
+
+    if (other->last_ret != GST_FLOW_NOT_LINKED)
+      return GST_FLOW_OK;
+  }
+
+  return ret;
+}
+
+/* As long as every device has a frame waiting, either the oldest frames are
+ * close enough to form a set, or the oldest of them can't be part of any set
+ * because another device is already past it. */
+static GstFlowReturn
+gst_v4l2_multi_src_push_sets (GstV4l2MultiSrc * self)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  while (ret == GST_FLOW_OK) {
+    GstV4l2MultiSrcStream *oldest = NULL;
+    GstClockTime min_ts = GST_CLOCK_TIME_NONE, max_ts = 0;
+    GList *l;
+
+    for (l = self->streams; l; l = l->next) {
+      GstV4l2MultiSrcStream *stream = l->data;
+      GstBuffer *buf = g_queue_peek_head (&stream->pending);
+
+      if (buf == NULL)
+        return GST_FLOW_OK;
+
+      if (oldest == NULL || GST_BUFFER_TIMESTAMP (buf) < min_ts) {
+        min_ts = GST_BUFFER_TIMESTAMP (buf);
+        oldest = stream;
+      }
+      max_ts = MAX (max_ts, GST_BUFFER_TIMESTAMP (buf));
+    }
+
+    if (max_ts - min_ts > self->sync_tolerance) {
+      GST_DEBUG_OBJECT (oldest->pad, "dropping unmatched frame %"
+          GST_TIME_FORMAT, GST_TIME_ARGS (min_ts));
+      gst_buffer_unref (g_queue_pop_head (&oldest->pending));
+      continue;
+    }
+
+    GST_LOG_OBJECT (self, "pushing set at %" GST_TIME_FORMAT " spread %"
+        GST_TIME_FORMAT, GST_TIME_ARGS (min_ts),
+        GST_TIME_ARGS (max_ts - min_ts));
+
+    for (l = self->streams; l && ret == GST_FLOW_OK; l = l->next) {
+      GstV4l2MultiSrcStream *stream = l->data;
+      GstBuffer *buf = g_queue_pop_head (&stream->pending);
+
+      /* the frames of a set are simultaneous for downstream */
+      GST_BUFFER_TIMESTAMP (buf) = min_ts;
+      ret = gst_v4l2_multi_src_push (self, stream, buf);
+    }
+  }
+
+  return ret;
+}
+
+static void
+gst_v4l2_multi_src_push_eos (GstV4l2MultiSrc * self)
+{
+  GList *l;
+
+  for (l = self->streams; l; l = l->next) {
+    GstV4l2MultiSrcStream *stream = l->data;
+
+    gst_pad_push_event (stream->pad, gst_event_new_eos ());
+  }
+}
+
+static void
+gst_v4l2_multi_src_loop (GstV4l2MultiSrc * self)
+{
+  GstV4l2MultiSrcStream *first = self->streams->data;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GList *l;
+  gint res;
+
+  res = gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE);
+  if (G_UNLIKELY (res < 0)) {
+    switch (errno) {
+      case EBUSY:
+        ret = GST_FLOW_FLUSHING;
+        goto pause;
+      case EAGAIN:
+      case EINTR:
+        return;
+      default:
+        goto poll_error;
+    }
+  }
+
+  for (l = self->streams; l && ret == GST_FLOW_OK; l = l->next) {
+    GstV4l2MultiSrcStream *stream = l->data;
+    GstBuffer *buf;
+
+    /* errors are reported by the dequeue */
+    if (!gst_poll_fd_can_read (self->poll, &stream->pollfd) &&
+        !gst_poll_fd_has_error (self->poll, &stream->pollfd))
+      continue;
+
+    ret = gst_v4l2_multi_src_capture (self, stream, &buf);
+    if (ret != GST_FLOW_OK)
+      break;
+
+    if (self->sync_tolerance == 0 || !GST_BUFFER_TIMESTAMP_IS_VALID (buf)) {
+      ret = gst_v4l2_multi_src_push (self, stream, buf);
+    } else {
+      if (g_queue_get_length (&stream->pending) >= MAX_PENDING) {
+        GST_DEBUG_OBJECT (stream->pad, "other devices are too late, dropping "
+            "oldest frame");
+        gst_buffer_unref (g_queue_pop_head (&stream->pending));
+      }
+      g_queue_push_tail (&stream->pending, buf);
+    }
+  }
+
+  if (ret == GST_FLOW_OK && self->sync_tolerance > 0)
+    ret = gst_v4l2_multi_src_push_sets (self);
+
+  if (G_UNLIKELY (ret != GST_FLOW_OK))
+    goto pause;
+
+  return;
+
+  /* ERRORS */
+poll_error:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, READ, (NULL),
+        ("poll error %d: %s (%d)", res, g_strerror (errno), errno));
+    ret = GST_FLOW_ERROR;
+    goto pause;
+  }
+pause:
+  {
+    const gchar *reason = gst_flow_get_name (ret);
+
+    GST_DEBUG_OBJECT (self, "pausing task, reason %s", reason);
+    gst_pad_pause_task (first->pad);
+
+    if (ret == GST_FLOW_EOS) {
+      gst_v4l2_multi_src_push_eos (self);
+    } else if (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS) {
+      GST_ELEMENT_ERROR (self, STREAM, FAILED,
+          (_("Internal data flow error.")),
+          ("streaming task paused, reason %s (%d)", reason, ret));
+      gst_v4l2_multi_src_push_eos (self);
+    }
+    return;
+  }
+}
+
+static gboolean
+gst_v4l2_multi_src_open (GstV4l2MultiSrc * self)
+{
+  GList *l;
+
+  if (self->streams == NULL)
+    goto no_devices;
+
+  for (l = self->streams; l; l = l->next) {
+    GstV4l2MultiSrcStream *stream = l->data;
+
+    if (!gst_v4l2_object_open (stream->v4l2object))
+      goto open_failed;
+  }
+
+  return TRUE;
+
+  /* ERRORS */
+no_devices:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND, (NULL),
+        ("No devices set, use the devices property"));
+    return FALSE;
+  }
+open_failed:
+  {
+    /* error already posted */
+    for (l = l->prev; l; l = l->prev) {
+      GstV4l2MultiSrcStream *stream = l->data;
+
+      gst_v4l2_object_close (stream->v4l2object);
+    }
+    return FALSE;
+  }
+}
+
+static void
+gst_v4l2_multi_src_close (GstV4l2MultiSrc * self)
+{
+  GList *l;
+
+  for (l = self->streams; l; l = l->next) {
+    GstV4l2MultiSrcStream *stream = l->data;
+
+    gst_v4l2_object_close (stream->v4l2object);
+  }
+}
+
+static gboolean
+gst_v4l2_multi_src_start (GstV4l2MultiSrc * self)
+{
+  guint group_id = gst_util_group_id_next ();
+  GList *l;
+
+  for (l = self->streams; l; l = l->next) {
+    if (!gst_v4l2_multi_src_start_stream (self, l->data, group_id))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void
+gst_v4l2_multi_src_stop (GstV4l2MultiSrc * self)
+{
+  GList *l;
+
+  for (l = self->streams; l; l = l->next)
+    gst_v4l2_multi_src_stop_stream (self, l->data);
+}
+
+static GstStateChangeReturn
+gst_v4l2_multi_src_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstV4l2MultiSrc *self = GST_V4L2_MULTI_SRC (element);
+  GstV4l2MultiSrcStream *first;
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (!gst_v4l2_multi_src_open (self))
+        return GST_STATE_CHANGE_FAILURE;
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
+      /* like any live source, only capture in PLAYING */
+      first = self->streams->data;
+      gst_poll_set_flushing (self->poll, FALSE);
+      gst_pad_start_task (first->pad,
+          (GstTaskFunction) gst_v4l2_multi_src_loop, self, NULL);
+      break;
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      first = self->streams->data;
+      gst_poll_set_flushing (self->poll, TRUE);
+      gst_pad_pause_task (first->pad);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      first = self->streams->data;
+      gst_poll_set_flushing (self->poll, TRUE);
+      gst_pad_stop_task (first->pad);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (!gst_v4l2_multi_src_start (self)) {
+        gst_v4l2_multi_src_stop (self);
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      ret = GST_STATE_CHANGE_NO_PREROLL;
+      break;
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      ret = GST_STATE_CHANGE_NO_PREROLL;
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_v4l2_multi_src_stop (self);
+      break;
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      gst_v4l2_multi_src_close (self);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static void
+gst_v4l2_multi_src_init (GstV4l2MultiSrc * self)
+{
+  self->poll = gst_poll_new (TRUE);
+  self->sync_tolerance = DEFAULT_PROP_SYNC_TOLERANCE;
+
+  GST_OBJECT_FLAG_SET (self, GST_ELEMENT_FLAG_SOURCE);
+}
+
+static void
+gst_v4l2_multi_src_class_init (GstV4l2MultiSrcClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->set_property = gst_v4l2_multi_src_set_property;
+  gobject_class->get_property = gst_v4l2_multi_src_get_property;
+  gobject_class->finalize = gst_v4l2_multi_src_finalize;
+
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_v4l2_multi_src_change_state);
+
+  /**
+   * GstV4l2MultiSrc:devices:
+   *
+   * Comma separated list of the devices to capture from, pad src_N is
+   * created for the Nth device. Can only be changed in the NULL state.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_DEVICES,
+      g_param_spec_string ("devices", "Devices",
+          "Comma separated list of devices", DEFAULT_PROP_DEVICES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstV4l2MultiSrc:sync-tolerance:
+   *
+   * When non zero, only push sets of one frame per device, captured at most
+   * this many nanoseconds apart. Unmatched frames are dropped.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_SYNC_TOLERANCE,
+      g_param_spec_uint64 ("sync-tolerance", "Sync tolerance",
+          "Largest capture time difference within a set of frames "
+          "(in ns, 0 = push frames as they come)", 0, G_MAXUINT64,
+          DEFAULT_PROP_SYNC_TOLERANCE,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (element_class,
+      gst_pad_template_new ("src_%u", GST_PAD_SRC, GST_PAD_SOMETIMES,
+          gst_v4l2_object_get_all_caps ()));
+
+  gst_element_class_set_static_metadata (element_class,
+      "Video (video4linux2) Multi Source", "Source/Video",
+      "Captures from several Video4Linux2 devices in a single thread",
+      "GStreamer developers");
+
+  GST_DEBUG_CATEGORY_INIT (gst_v4l2_multi_src_debug, "v4l2multisrc", 0,
+      "V4L2 multi device source element");
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef __GST_V4L2_MULTI_SRC_H__
+#define __GST_V4L2_MULTI_SRC_H__
+
+#include <gst/gst.h>
+
+#include <gstv4l2object.h>
+#include <gstv4l2bufferpool.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_V4L2_MULTI_SRC \
+  (gst_v4l2_multi_src_get_type())
+#define GST_V4L2_MULTI_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_V4L2_MULTI_SRC,GstV4l2MultiSrc))
+#define GST_V4L2_MULTI_SRC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_V4L2_MULTI_SRC,GstV4l2MultiSrcClass))
+#define GST_IS_V4L2_MULTI_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_V4L2_MULTI_SRC))
+#define GST_IS_V4L2_MULTI_SRC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_V4L2_MULTI_SRC))
+
+typedef struct _GstV4l2MultiSrc GstV4l2MultiSrc;
+typedef struct _GstV4l2MultiSrcClass GstV4l2MultiSrcClass;
+typedef struct _GstV4l2MultiSrcStream GstV4l2MultiSrcStream;
+
+struct _GstV4l2MultiSrcStream
+{
+  GstPad *pad;
+  GstV4l2Object *v4l2object;
+
+  /* where frames are acquired from, our own pool or, in read mode, the one
+   * downstream proposed */
+  GstBufferPool *pool;
+  GstPollFD pollfd;
+
+  /* frames waiting for the other devices to form a set, oldest first */
+  GQueue pending;
+
+  guint64 offset;
+  GstFlowReturn last_ret;
+};
+
+struct _GstV4l2MultiSrc
+{
+  GstElement parent;
+
+  /* < private > */
+  gchar *devices;
+  GList *streams;
+
+  /* all device fds, waited on by the single streaming thread */
+  GstPoll *poll;
+
+  /* properties */
+  GstClockTime sync_tolerance;
+};
+
+struct _GstV4l2MultiSrcClass
+{
+  GstElementClass parent_class;
+};
+
+GType gst_v4l2_multi_src_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_V4L2_MULTI_SRC_H__ */
@@ -66,6 +66,15 @@ enum
 
 static GSList *gst_v4l2_object_get_format_list (GstV4l2Object * v4l2object);
 
+/* probed caps per device, shared by all objects of the process and
+ * optionally stored in the file named by GST_V4L2_CAPS_CACHE */
+G_LOCK_DEFINE_STATIC (caps_cache);
+static GHashTable *caps_cache = NULL;
+static GKeyFile *caps_cache_file = NULL;
+static gchar *caps_cache_path = NULL;
+
+#define CAPS_CACHE_GROUP "caps"
+
 
 #define GST_TYPE_V4L2_DEVICE_FLAGS (gst_v4l2_device_get_type ())
 static GType
@@ -159,6 +168,8 @@ gst_v4l2_io_mode_get_type (void)
       {GST_V4L2_IO_MMAP, "GST_V4L2_IO_MMAP", "mmap"},
       {GST_V4L2_IO_USERPTR, "GST_V4L2_IO_USERPTR", "userptr"},
       {GST_V4L2_IO_DMABUF, "GST_V4L2_IO_DMABUF", "dmabuf"},
+      {GST_V4L2_IO_DMABUF_IMPORT, "GST_V4L2_IO_DMABUF_IMPORT",
+          "dmabuf-import"},
 
       {0, NULL, NULL}
     };
@@ -2182,7 +2193,13 @@ gst_v4l2_object_setup_pool (GstV4l2Object * v4l2object, GstCaps * caps)
   if (v4l2object->vcap.capabilities & V4L2_CAP_STREAMING) {
     if (v4l2object->req_mode == GST_V4L2_IO_AUTO)
       mode = GST_V4L2_IO_MMAP;
-  } else if (v4l2object->req_mode == GST_V4L2_IO_MMAP)
+  } else if (v4l2object->req_mode == GST_V4L2_IO_MMAP ||
+      v4l2object->req_mode == GST_V4L2_IO_DMABUF_IMPORT)
+    goto method_not_supported;
+
+  /* importing is only implemented for the queue we feed */
+  if (mode == GST_V4L2_IO_DMABUF_IMPORT &&
+      !V4L2_TYPE_IS_OUTPUT (v4l2object->type))
     goto method_not_supported;
 
   /* if still no transport selected, error out */
@@ -2853,12 +2870,151 @@ invalid_buffer:
   }
 }
 
+/* The probed caps only depend on the driver and the hardware behind it,
+ * identified by the capabilities. Devices without bus info can't be told
+ * apart and are not cached. */
+static gchar *
+gst_v4l2_object_caps_cache_key (GstV4l2Object * v4l2object)
+{
+  struct v4l2_capability *vcap = &v4l2object->vcap;
+  gchar *key, *hash;
+
+  if (vcap->bus_info[0] == '\0')
+    return NULL;
+
+  key = g_strdup_printf ("%s|%s|%s|%s|%u|%u|%d|%d",
+      v4l2object->videodev, (const gchar *) vcap->driver,
+      (const gchar *) vcap->card, (const gchar *) vcap->bus_info,
+      vcap->version, vcap->capabilities, v4l2object->type,
+      v4l2object->never_interlaced);
+  /* usable as key file key */
+  hash = g_compute_checksum_for_string (G_CHECKSUM_SHA1, key, -1);
+  g_free (key);
+
+  return hash;
+}
+
+static void
+gst_v4l2_object_caps_cache_init_unlocked (void)
+{
+  const gchar *path;
+  gchar **keys;
+  guint i;
+
+  if (caps_cache)
+    return;
+
+  caps_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) gst_caps_unref);
+
+  path = g_getenv ("GST_V4L2_CAPS_CACHE");
+  if (path == NULL || *path == '\0')
+    return;
+
+  caps_cache_path = g_strdup (path);
+  caps_cache_file = g_key_file_new ();
+  if (!g_key_file_load_from_file (caps_cache_file, caps_cache_path,
+          G_KEY_FILE_NONE, NULL))
+    return;
+
+  keys = g_key_file_get_keys (caps_cache_file, CAPS_CACHE_GROUP, NULL, NULL);
+  for (i = 0; keys && keys[i]; i++) {
+    gchar *str;
+    GstCaps *caps;
+
+    str = g_key_file_get_string (caps_cache_file, CAPS_CACHE_GROUP, keys[i],
+        NULL);
+    caps = str ? gst_caps_from_string (str) : NULL;
+    if (caps)
+      g_hash_table_insert (caps_cache, g_strdup (keys[i]), caps);
+    g_free (str);
+  }
+  g_strfreev (keys);
+
+  GST_DEBUG ("loaded %u cached caps from %s", g_hash_table_size (caps_cache),
+      caps_cache_path);
+}
+
+static void
+gst_v4l2_object_caps_cache_save_unlocked (void)
+{
+  gchar *data;
+  gsize len;
+
+  if (caps_cache_file == NULL)
+    return;
+
+  data = g_key_file_to_data (caps_cache_file, &len, NULL);
+  if (data && !g_file_set_contents (caps_cache_path, data, len, NULL))
+    GST_WARNING ("could not write caps cache %s", caps_cache_path);
+  g_free (data);
+}
+
+static GstCaps *
+gst_v4l2_object_caps_cache_lookup (const gchar * key)
+{
+  GstCaps *caps;
+
+  G_LOCK (caps_cache);
+  gst_v4l2_object_caps_cache_init_unlocked ();
+  caps = g_hash_table_lookup (caps_cache, key);
+  if (caps)
+    gst_caps_ref (caps);
+  G_UNLOCK (caps_cache);
+
+  return caps;
+}
+
+static void
+gst_v4l2_object_caps_cache_insert (const gchar * key, GstCaps * caps)
+{
+  G_LOCK (caps_cache);
+  gst_v4l2_object_caps_cache_init_unlocked ();
+  g_hash_table_replace (caps_cache, g_strdup (key), gst_caps_ref (caps));
+  if (caps_cache_file) {
+    gchar *str = gst_caps_to_string (caps);
+
+    g_key_file_set_string (caps_cache_file, CAPS_CACHE_GROUP, key, str);
+    g_free (str);
+    gst_v4l2_object_caps_cache_save_unlocked ();
+  }
+  G_UNLOCK (caps_cache);
+}
+
+/**
+ * gst_v4l2_object_clear_caps_cache:
+ *
+ * Forget all probed caps, including the stored ones. Called when devices are
+ * plugged or unplugged.
+ */
+void
+gst_v4l2_object_clear_caps_cache (void)
+{
+  G_LOCK (caps_cache);
+  if (caps_cache)
+    g_hash_table_remove_all (caps_cache);
+  if (caps_cache_file) {
+    g_key_file_remove_group (caps_cache_file, CAPS_CACHE_GROUP, NULL);
+    gst_v4l2_object_caps_cache_save_unlocked ();
+  }
+  G_UNLOCK (caps_cache);
+}
+
 GstCaps *
 gst_v4l2_object_get_caps (GstV4l2Object * v4l2object, GstCaps * filter)
 {
   GstCaps *ret;
   GSList *walk;
   GSList *formats;
+  gchar *key = NULL;
+
+  if (v4l2object->probed_caps == NULL) {
+    key = gst_v4l2_object_caps_cache_key (v4l2object);
+    if (key)
+      v4l2object->probed_caps = gst_v4l2_object_caps_cache_lookup (key);
+    if (v4l2object->probed_caps)
+      GST_DEBUG_OBJECT (v4l2object->element, "using cached caps");
+  }
 
   if (v4l2object->probed_caps == NULL) {
     formats = gst_v4l2_object_get_format_list (v4l2object);
@@ -2888,7 +3044,11 @@ gst_v4l2_object_get_caps (GstV4l2Object * v4l2object, GstCaps * filter)
       }
     }
     v4l2object->probed_caps = ret;
+
+    if (key && !gst_caps_is_empty (ret))
+      gst_v4l2_object_caps_cache_insert (key, ret);
   }
+  g_free (key);
 
   if (filter) {
     ret = gst_caps_intersect_full (filter, v4l2object->probed_caps,
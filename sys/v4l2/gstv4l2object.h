@@ -40,6 +40,8 @@ typedef struct _GstV4l2Xv GstV4l2Xv;
 /* size of v4l2 buffer pool in streaming case */
 #define GST_V4L2_MAX_BUFFERS 16
 #define GST_V4L2_MIN_BUFFERS 1
+/* number of buffers requested when no maximum was configured */
+#define GST_V4L2_DEFAULT_BUFFERS 4
 
 /* max frame width/height */
 #define GST_V4L2_MAX_SIZE (1<<15) /* 2^15 == 32768 */
@@ -56,7 +58,8 @@ typedef enum {
   GST_V4L2_IO_RW      = 1,
   GST_V4L2_IO_MMAP    = 2,
   GST_V4L2_IO_USERPTR = 3,
-  GST_V4L2_IO_DMABUF  = 4
+  GST_V4L2_IO_DMABUF  = 4,
+  GST_V4L2_IO_DMABUF_IMPORT = 5
 } GstV4l2IOMode;
 
 typedef gboolean  (*GstV4l2GetInOutFunction)  (GstV4l2Object * v4l2object, gint * input);
@@ -253,6 +256,8 @@ gboolean      gst_v4l2_object_copy        (GstV4l2Object * v4l2object,
 GstCaps *     gst_v4l2_object_get_caps    (GstV4l2Object * v4l2object,
                                            GstCaps * filter);
 
+void          gst_v4l2_object_clear_caps_cache (void);
+
 gboolean      gst_v4l2_object_setup_format (GstV4l2Object * v4l2object,
                                             GstVideoInfo * info,
                                             GstVideoAlignment * align);
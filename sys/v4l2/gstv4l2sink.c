@@ -45,6 +45,10 @@
  * original video frame geometry so that the box can be drawn to the correct
  * position. This also handles borders correctly, limiting coordinates to the
  * image area
+ * |[
+ * gst-launch-1.0 v4l2src io-mode=dmabuf ! v4l2sink io-mode=dmabuf-import
+ * ]| Displays the camera frames without copying them, the sink queues the
+ * dmabufs exported by the capture device into its own device.
  * </refsect2>
  */
 
@@ -547,6 +551,23 @@ gst_v4l2sink_propose_allocation (GstBaseSink * bsink, GstQuery * query)
   if (caps == NULL)
     goto no_caps;
 
+  if (obj->mode == GST_V4L2_IO_DMABUF_IMPORT) {
+    GstVideoInfo info;
+
+    if (!gst_video_info_from_caps (&info, caps))
+      goto no_caps;
+
+    /* our buffers have no memory of their own, upstream provides the
+     * dmabufs. The device holds on to all of them while they are queued, so
+     * leave upstream enough to keep producing. */
+    gst_query_add_allocation_pool (query, NULL, GST_VIDEO_INFO_SIZE (&info),
+        GST_V4L2_DEFAULT_BUFFERS + 2, 0);
+    gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+    gst_query_add_allocation_meta (query, GST_VIDEO_CROP_META_API_TYPE, NULL);
+
+    return TRUE;
+  }
+
   if ((pool = obj->pool))
     gst_object_ref (pool);
 
@@ -63,14 +63,39 @@ GST_DEBUG_CATEGORY (v4l2src_debug);
 #define GST_CAT_DEFAULT v4l2src_debug
 
 #define DEFAULT_PROP_DEVICE   "/dev/video0"
+#define DEFAULT_PROP_LOW_LATENCY FALSE
+#define DEFAULT_PROP_TIMESTAMP_SOURCE GST_V4L2SRC_TIMESTAMP_CLOCK
+
+/* fewest buffers to keep capturing while downstream holds one */
+#define LOW_LATENCY_BUFFERS 2
 
 enum
 {
   PROP_0,
   V4L2_STD_OBJECT_PROPS,
+  PROP_LOW_LATENCY,
+  PROP_TIMESTAMP_SOURCE,
   PROP_LAST
 };
 
+GType
+gst_v4l2src_timestamp_source_get_type (void)
+{
+  static GType timestamp_source = 0;
+
+  if (!timestamp_source) {
+    static const GEnumValue sources[] = {
+      {GST_V4L2SRC_TIMESTAMP_CLOCK, "GST_V4L2SRC_TIMESTAMP_CLOCK", "clock"},
+      {GST_V4L2SRC_TIMESTAMP_DRIVER, "GST_V4L2SRC_TIMESTAMP_DRIVER", "driver"},
+
+      {0, NULL, NULL}
+    };
+    timestamp_source = g_enum_register_static ("GstV4l2SrcTimestampSource",
+        sources);
+  }
+  return timestamp_source;
+}
+
 /* signals and args */
 enum
 {
@@ -143,6 +168,39 @@ gst_v4l2src_class_init (GstV4l2SrcClass * klass)
   gst_v4l2_object_install_properties_helper (gobject_class,
       DEFAULT_PROP_DEVICE);
 
+  /**
+   * GstV4l2Src:low-latency:
+   *
+   * Only keep two buffers in the capture queue, so that downstream always
+   * gets the most recent frame, and report the latency measured between the
+   * driver capture time and the moment the frame is pushed instead of one
+   * frame duration. When the measured delay grows, a new latency message is
+   * posted.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low latency",
+          "Capture with the smallest queue and report the measured latency",
+          DEFAULT_PROP_LOW_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstV4l2Src:timestamp-source:
+   *
+   * Where the buffer timestamps come from. With "driver" and the default
+   * monotonic system clock as pipeline clock, the capture time of the
+   * driver is converted to running time without sampling the clock, which
+   * avoids the scheduling jitter between the capture and the dequeue.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_TIMESTAMP_SOURCE,
+      g_param_spec_enum ("timestamp-source", "Timestamp source",
+          "Where the buffer timestamps come from",
+          GST_TYPE_V4L2SRC_TIMESTAMP_SOURCE, DEFAULT_PROP_TIMESTAMP_SOURCE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstV4l2Src::prepare-format:
    * @v4l2src: the v4l2src instance
@@ -200,6 +258,9 @@ gst_v4l2src_init (GstV4l2Src * v4l2src)
       V4L2_BUF_TYPE_VIDEO_CAPTURE, DEFAULT_PROP_DEVICE,
       gst_v4l2_get_input, gst_v4l2_set_input, NULL);
 
+  v4l2src->low_latency = DEFAULT_PROP_LOW_LATENCY;
+  v4l2src->timestamp_source = DEFAULT_PROP_TIMESTAMP_SOURCE;
+
   gst_base_src_set_format (GST_BASE_SRC (v4l2src), GST_FORMAT_TIME);
   gst_base_src_set_live (GST_BASE_SRC (v4l2src), TRUE);
 }
@@ -223,6 +284,12 @@ gst_v4l2src_set_property (GObject * object,
   if (!gst_v4l2_object_set_property_helper (v4l2src->v4l2object,
           prop_id, value, pspec)) {
     switch (prop_id) {
+      case PROP_LOW_LATENCY:
+        v4l2src->low_latency = g_value_get_boolean (value);
+        break;
+      case PROP_TIMESTAMP_SOURCE:
+        v4l2src->timestamp_source = g_value_get_enum (value);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -239,6 +306,12 @@ gst_v4l2src_get_property (GObject * object,
   if (!gst_v4l2_object_get_property_helper (v4l2src->v4l2object,
           prop_id, value, pspec)) {
     switch (prop_id) {
+      case PROP_LOW_LATENCY:
+        g_value_set_boolean (value, v4l2src->low_latency);
+        break;
+      case PROP_TIMESTAMP_SOURCE:
+        g_value_set_enum (value, v4l2src->timestamp_source);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -448,14 +521,51 @@ gst_v4l2src_set_caps (GstBaseSrc * src, GstCaps * caps)
   return TRUE;
 }
 
+/* In low-latency mode, the driver only gets as many buffers as it needs to
+ * keep capturing. Frames are then dropped in the driver rather than aging in
+ * the queue. Not growing and not copying follows from min == max. */
+static void
+gst_v4l2src_limit_queue (GstV4l2Src * src, GstQuery * query)
+{
+  GstV4l2Object *obj = src->v4l2object;
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstCaps *caps;
+  guint size, min, max, num;
+
+  gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+
+  /* read/write mode uses whatever pool downstream gave */
+  if (pool == GST_BUFFER_POOL_CAST (obj->pool)) {
+    num = MAX (LOW_LATENCY_BUFFERS, obj->min_buffers_for_capture + 1);
+
+    GST_DEBUG_OBJECT (src, "low latency, using %u buffers instead of %u", num,
+        min);
+
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_get_params (config, &caps, NULL, NULL, NULL);
+    gst_buffer_pool_config_set_params (config, caps, size, num, num);
+    gst_buffer_pool_set_config (pool, config);
+
+    gst_query_set_nth_allocation_pool (query, 0, pool, size, num, num);
+  }
+
+  if (pool)
+    gst_object_unref (pool);
+}
+
 static gboolean
 gst_v4l2src_decide_allocation (GstBaseSrc * bsrc, GstQuery * query)
 {
   GstV4l2Src *src = GST_V4L2SRC (bsrc);
   gboolean ret = FALSE;
 
-  if (gst_v4l2_object_decide_allocation (src->v4l2object, query))
+  if (gst_v4l2_object_decide_allocation (src->v4l2object, query)) {
+    if (src->low_latency)
+      gst_v4l2src_limit_queue (src, query);
+
     ret = GST_BASE_SRC_CLASS (parent_class)->decide_allocation (bsrc, query);
+  }
 
   return ret;
 }
@@ -505,6 +615,19 @@ gst_v4l2src_query (GstBaseSrc * bsrc, GstQuery * query)
       else
         max_latency = num_buffers * min_latency;
 
+      /* the timestamps are the capture time, so what downstream really has
+       * to wait for is how late the frames come out of the driver. Leave some
+       * headroom so that jitter on the delay doesn't trigger a new latency
+       * configuration for every frame. */
+      GST_OBJECT_LOCK (src);
+      if (src->low_latency && src->device_delay > 0) {
+        min_latency = src->device_delay + src->device_delay / 4;
+        if (max_latency != -1)
+          max_latency = MAX (max_latency, min_latency);
+      }
+      src->reported_latency = min_latency;
+      GST_OBJECT_UNLOCK (src);
+
       GST_DEBUG_OBJECT (bsrc,
           "report latency min %" GST_TIME_FORMAT " max %" GST_TIME_FORMAT,
           GST_TIME_ARGS (min_latency), GST_TIME_ARGS (max_latency));
@@ -536,6 +659,8 @@ gst_v4l2src_start (GstBaseSrc * src)
   GstV4l2Src *v4l2src = GST_V4L2SRC (src);
 
   v4l2src->offset = 0;
+  v4l2src->device_delay = 0;
+  v4l2src->reported_latency = 0;
 
   /* activate settings for first frame */
   v4l2src->ctrl_time = 0;
@@ -604,6 +729,41 @@ gst_v4l2src_change_state (GstElement * element, GstStateChange transition)
   return ret;
 }
 
+/* only the plain system clock shares the time base of the driver, slaved
+ * subclasses like the network clock don't */
+static gboolean
+gst_v4l2src_clock_is_monotonic (GstClock * clock)
+{
+  GstClockType clock_type;
+
+  if (G_OBJECT_TYPE (clock) != GST_TYPE_SYSTEM_CLOCK)
+    return FALSE;
+
+  g_object_get (clock, "clock-type", &clock_type, NULL);
+
+  return clock_type == GST_CLOCK_TYPE_MONOTONIC;
+}
+
+static void
+gst_v4l2src_update_delay (GstV4l2Src * v4l2src, GstClockTime delay)
+{
+  gboolean post = FALSE;
+
+  GST_OBJECT_LOCK (v4l2src);
+  if (delay > v4l2src->device_delay) {
+    v4l2src->device_delay = delay;
+    post = delay > v4l2src->reported_latency;
+  }
+  GST_OBJECT_UNLOCK (v4l2src);
+
+  if (post) {
+    GST_DEBUG_OBJECT (v4l2src, "capture delay grew to %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (delay));
+    gst_element_post_message (GST_ELEMENT_CAST (v4l2src),
+        gst_message_new_latency (GST_OBJECT_CAST (v4l2src)));
+  }
+}
+
 static GstFlowReturn
 gst_v4l2src_fill (GstPushSrc * src, GstBuffer * buf)
 {
@@ -613,6 +773,7 @@ gst_v4l2src_fill (GstPushSrc * src, GstBuffer * buf)
   GstClock *clock;
   GstClockTime abs_time, base_time, timestamp, duration;
   GstClockTime delay;
+  gboolean driver_ts = FALSE;
 
   ret =
       gst_v4l2_buffer_pool_process (GST_V4L2_BUFFER_POOL_CAST (obj->pool), buf);
@@ -640,6 +801,8 @@ gst_v4l2src_fill (GstPushSrc * src, GstBuffer * buf)
   /* sample pipeline clock */
   if (clock) {
     abs_time = gst_clock_get_time (clock);
+    if (v4l2src->timestamp_source == GST_V4L2SRC_TIMESTAMP_DRIVER)
+      driver_ts = gst_v4l2src_clock_is_monotonic (clock);
     gst_object_unref (clock);
   } else {
     abs_time = GST_CLOCK_TIME_NONE;
@@ -661,6 +824,7 @@ gst_v4l2src_fill (GstPushSrc * src, GstBuffer * buf)
       /* very large diff, fall back to system time */
       g_get_current_time (&now);
       gstnow = GST_TIMEVAL_TO_TIME (now);
+      driver_ts = FALSE;
     }
 
     if (gstnow > timestamp) {
@@ -672,7 +836,12 @@ gst_v4l2src_fill (GstPushSrc * src, GstBuffer * buf)
     GST_DEBUG_OBJECT (v4l2src, "ts: %" GST_TIME_FORMAT " now %" GST_TIME_FORMAT
         " delay %" GST_TIME_FORMAT, GST_TIME_ARGS (timestamp),
         GST_TIME_ARGS (gstnow), GST_TIME_ARGS (delay));
+
+    if (v4l2src->low_latency)
+      gst_v4l2src_update_delay (v4l2src, delay);
   } else {
+    driver_ts = FALSE;
+
     /* we assume 1 frame latency otherwise */
     if (GST_CLOCK_TIME_IS_VALID (duration))
       delay = duration;
@@ -684,7 +853,14 @@ gst_v4l2src_fill (GstPushSrc * src, GstBuffer * buf)
   GST_BUFFER_OFFSET (buf) = v4l2src->offset++;
   GST_BUFFER_OFFSET_END (buf) = v4l2src->offset;
 
-  if (G_LIKELY (abs_time != GST_CLOCK_TIME_NONE)) {
+  if (G_LIKELY (abs_time != GST_CLOCK_TIME_NONE) && driver_ts) {
+    /* same time base as the pipeline clock, the capture time converts to
+     * running time directly */
+    if (timestamp > base_time)
+      timestamp -= base_time;
+    else
+      timestamp = 0;
+  } else if (G_LIKELY (abs_time != GST_CLOCK_TIME_NONE)) {
     /* the time now is the time of the clock minus the base time */
     timestamp = abs_time - base_time;
 
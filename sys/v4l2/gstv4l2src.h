@@ -45,6 +45,26 @@ G_BEGIN_DECLS
 typedef struct _GstV4l2Src GstV4l2Src;
 typedef struct _GstV4l2SrcClass GstV4l2SrcClass;
 
+#define GST_TYPE_V4L2SRC_TIMESTAMP_SOURCE \
+  (gst_v4l2src_timestamp_source_get_type ())
+
+/**
+ * GstV4l2SrcTimestampSource:
+ * @GST_V4L2SRC_TIMESTAMP_CLOCK: sample the pipeline clock when the frame is
+ *   dequeued and subtract the delay reported by the driver
+ * @GST_V4L2SRC_TIMESTAMP_DRIVER: use the capture time of the driver as is
+ *   when it and the pipeline clock are both monotonic, otherwise behave like
+ *   @GST_V4L2SRC_TIMESTAMP_CLOCK
+ *
+ * How buffer timestamps are computed.
+ *
+ * Since: 1.4
+ */
+typedef enum {
+  GST_V4L2SRC_TIMESTAMP_CLOCK,
+  GST_V4L2SRC_TIMESTAMP_DRIVER
+} GstV4l2SrcTimestampSource;
+
 /**
  * GstV4l2Src:
  *
@@ -60,6 +80,14 @@ struct _GstV4l2Src
   guint64 offset;
 
   GstClockTime ctrl_time;
+
+  gboolean low_latency;
+  GstV4l2SrcTimestampSource timestamp_source;
+
+  /* largest delay between capture and dequeue, and the latency we reported,
+   * protected by the object lock */
+  GstClockTime device_delay;
+  GstClockTime reported_latency;
 };
 
 struct _GstV4l2SrcClass
@@ -70,6 +98,7 @@ struct _GstV4l2SrcClass
 };
 
 GType gst_v4l2src_get_type (void);
+GType gst_v4l2src_timestamp_source_get_type (void);
 
 G_END_DECLS
 
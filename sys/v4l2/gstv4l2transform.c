@@ -0,0 +1,844 @@
+/*
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+/* One element is registered per V4L2 memory-to-memory device that takes and
+ * produces raw video, e.g. v4l2video2convert. Such devices are scalers and
+ * colorspace converters, each input frame is queued on the OUTPUT queue and
+ * the converted frame dequeued from the CAPTURE queue.
+ *
+ * Combined with dmabuf import on the input and dmabuf export on the output,
+ * a camera can be scaled for an encoder without any CPU access to the pixels:
+ * |[
+ * gst-launch-1.0 v4l2src io-mode=dmabuf ! v4l2video2convert
+ *     io-mode=dmabuf-import capture-io-mode=dmabuf !
+ *     video/x-raw,width=640,height=360 ! v4l2video4enc io-mode=dmabuf-import !
+ *     fakesink
+ * ]|
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "gstv4l2transform.h"
+#include "v4l2_calls.h"
+
+#include <gst/gst-i18n-plugin.h>
+
+#define DEFAULT_PROP_DEVICE "/dev/video0"
+
+#define V4L2_TRANSFORM_QUARK \
+	g_quark_from_static_string("gst-v4l2-transform-info")
+
+GST_DEBUG_CATEGORY_STATIC (gst_v4l2_transform_debug);
+#define GST_CAT_DEFAULT gst_v4l2_transform_debug
+
+typedef struct
+{
+  gchar *device;
+  GstCaps *sink_caps;
+  GstCaps *src_caps;
+} GstV4l2TransformQData;
+
+enum
+{
+  PROP_0,
+  V4L2_STD_OBJECT_PROPS,
+  PROP_CAPTURE_IO_MODE
+};
+
+static void gst_v4l2_transform_class_init (GstV4l2TransformClass * klass);
+static void gst_v4l2_transform_init (GstV4l2Transform * self,
+    gpointer g_class);
+static void gst_v4l2_transform_base_init (gpointer g_class);
+
+static GstBaseTransformClass *parent_class = NULL;
+
+GType
+gst_v4l2_transform_get_type (void)
+{
+  static volatile gsize type = 0;
+
+  if (g_once_init_enter (&type)) {
+    GType _type;
+    static const GTypeInfo info = {
+      sizeof (GstV4l2TransformClass),
+      gst_v4l2_transform_base_init,
+      NULL,
+      (GClassInitFunc) gst_v4l2_transform_class_init,
+      NULL,
+      NULL,
+      sizeof (GstV4l2Transform),
+      0,
+      (GInstanceInitFunc) gst_v4l2_transform_init,
+      NULL
+    };
+
+    _type = g_type_register_static (GST_TYPE_BASE_TRANSFORM,
+        "GstV4l2Transform", &info, 0);
+
+    g_once_init_leave (&type, _type);
+  }
+  return type;
+}
+
+static void
+gst_v4l2_transform_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec)
+{
+  GstV4l2Transform *self = GST_V4L2_TRANSFORM (object);
+
+  switch (prop_id) {
+      /* Split IO mode so output is configure through 'io-mode' and capture
+       * through 'capture-io-mode' */
+    case PROP_IO_MODE:
+      gst_v4l2_object_set_property_helper (self->v4l2output, prop_id, value,
+          pspec);
+      break;
+    case PROP_CAPTURE_IO_MODE:
+      gst_v4l2_object_set_property_helper (self->v4l2capture, PROP_IO_MODE,
+          value, pspec);
+      break;
+
+    case PROP_DEVICE:
+      gst_v4l2_object_set_property_helper (self->v4l2output, prop_id, value,
+          pspec);
+      gst_v4l2_object_set_property_helper (self->v4l2capture, prop_id, value,
+          pspec);
+      break;
+
+      /* By default, only set on output */
+    default:
+      if (!gst_v4l2_object_set_property_helper (self->v4l2output,
+              prop_id, value, pspec)) {
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      }
+      break;
+  }
+}
+
+static void
+gst_v4l2_transform_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec)
+{
+  GstV4l2Transform *self = GST_V4L2_TRANSFORM (object);
+
+  switch (prop_id) {
+    case PROP_IO_MODE:
+      gst_v4l2_object_get_property_helper (self->v4l2output, prop_id, value,
+          pspec);
+      break;
+    case PROP_CAPTURE_IO_MODE:
+      gst_v4l2_object_get_property_helper (self->v4l2capture, PROP_IO_MODE,
+          value, pspec);
+      break;
+
+      /* By default read from output */
+    default:
+      if (!gst_v4l2_object_get_property_helper (self->v4l2output,
+              prop_id, value, pspec)) {
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      }
+      break;
+  }
+}
+
+static gboolean
+gst_v4l2_transform_open (GstV4l2Transform * self)
+{
+  GST_DEBUG_OBJECT (self, "Opening");
+
+  if (!gst_v4l2_object_open (self->v4l2output))
+    goto failure;
+
+  if (!gst_v4l2_object_open_shared (self->v4l2capture, self->v4l2output))
+    goto failure;
+
+  self->probed_sinkcaps = gst_v4l2_object_get_caps (self->v4l2output,
+      gst_v4l2_object_get_raw_caps ());
+
+  if (gst_caps_is_empty (self->probed_sinkcaps))
+    goto no_input_format;
+
+  self->probed_srccaps = gst_v4l2_object_get_caps (self->v4l2capture,
+      gst_v4l2_object_get_raw_caps ());
+
+  if (gst_caps_is_empty (self->probed_srccaps))
+    goto no_output_format;
+
+  return TRUE;
+
+no_input_format:
+  GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS,
+      (_("Converter on device %s has no supported input format"),
+          self->v4l2output->videodev), (NULL));
+  goto failure;
+
+
+no_output_format:
+  GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS,
+      (_("Converter on device %s has no supported output format"),
+          self->v4l2output->videodev), (NULL));
+  goto failure;
+
+failure:
+  if (GST_V4L2_IS_OPEN (self->v4l2output))
+    gst_v4l2_object_close (self->v4l2output);
+
+  if (GST_V4L2_IS_OPEN (self->v4l2capture))
+    gst_v4l2_object_close (self->v4l2capture);
+
+  gst_caps_replace (&self->probed_srccaps, NULL);
+  gst_caps_replace (&self->probed_sinkcaps, NULL);
+
+  return FALSE;
+}
+
+static void
+gst_v4l2_transform_close (GstV4l2Transform * self)
+{
+  GST_DEBUG_OBJECT (self, "Closing");
+
+  gst_v4l2_object_close (self->v4l2output);
+  gst_v4l2_object_close (self->v4l2capture);
+
+  gst_caps_replace (&self->probed_srccaps, NULL);
+  gst_caps_replace (&self->probed_sinkcaps, NULL);
+}
+
+static gboolean
+gst_v4l2_transform_stop (GstBaseTransform * trans)
+{
+  GstV4l2Transform *self = GST_V4L2_TRANSFORM (trans);
+
+  GST_DEBUG_OBJECT (self, "Stop");
+
+  gst_v4l2_object_stop (self->v4l2output);
+  gst_v4l2_object_stop (self->v4l2capture);
+  gst_caps_replace (&self->incaps, NULL);
+  gst_caps_replace (&self->outcaps, NULL);
+
+  return TRUE;
+}
+
+static gboolean
+gst_v4l2_transform_set_caps (GstBaseTransform * trans, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  GstV4l2Transform *self = GST_V4L2_TRANSFORM (trans);
+
+  if (self->incaps && self->outcaps) {
+    if (gst_caps_is_equal (incaps, self->incaps) &&
+        gst_caps_is_equal (outcaps, self->outcaps)) {
+      GST_DEBUG_OBJECT (trans, "Caps did not changed");
+      return TRUE;
+    }
+  }
+
+  /* the queues can only be reconfigured once stopped */
+  gst_v4l2_object_stop (self->v4l2output);
+  gst_v4l2_object_stop (self->v4l2capture);
+
+  gst_caps_replace (&self->incaps, incaps);
+  gst_caps_replace (&self->outcaps, outcaps);
+
+  /* the same caps on both sides are handled by passthrough */
+  if (gst_base_transform_is_passthrough (trans))
+    return TRUE;
+
+  if (!gst_v4l2_object_set_format (self->v4l2output, incaps))
+    goto incaps_failed;
+
+  if (!gst_v4l2_object_set_format (self->v4l2capture, outcaps))
+    goto outcaps_failed;
+
+  return TRUE;
+
+incaps_failed:
+  {
+    GST_ERROR_OBJECT (self, "failed to set input caps: %" GST_PTR_FORMAT,
+        incaps);
+    goto failed;
+  }
+outcaps_failed:
+  {
+    gst_v4l2_object_stop (self->v4l2output);
+    GST_ERROR_OBJECT (self, "failed to set output caps: %" GST_PTR_FORMAT,
+        outcaps);
+    goto failed;
+  }
+failed:
+  gst_caps_replace (&self->incaps, NULL);
+  gst_caps_replace (&self->outcaps, NULL);
+  return FALSE;
+}
+
+static gboolean
+gst_v4l2_transform_decide_allocation (GstBaseTransform * trans,
+    GstQuery * query)
+{
+  GstV4l2Transform *self = GST_V4L2_TRANSFORM (trans);
+  gboolean ret = FALSE;
+
+  GST_DEBUG_OBJECT (self, "called");
+
+  /* the converted frames always come from the capture queue */
+  if (gst_v4l2_object_decide_allocation (self->v4l2capture, query))
+    ret = GST_BASE_TRANSFORM_CLASS (parent_class)->decide_allocation (trans,
+        query);
+
+  return ret;
+}
+
+static gboolean
+gst_v4l2_transform_propose_allocation (GstBaseTransform * trans,
+    GstQuery * decide_query, GstQuery * query)
+{
+  GstV4l2Transform *self = GST_V4L2_TRANSFORM (trans);
+  GstV4l2Object *obj = self->v4l2output;
+  GstBufferPool *pool = NULL;
+  GstVideoInfo info;
+  GstCaps *caps;
+  guint size = 0;
+
+  /* In passthrough the base class forwards the query downstream */
+  if (decide_query == NULL)
+    return GST_BASE_TRANSFORM_CLASS (parent_class)->propose_allocation (trans,
+        decide_query, query);
+
+  gst_query_parse_allocation (query, &caps, NULL);
+
+  if (caps == NULL)
+    goto no_caps;
+
+  if (!gst_video_info_from_caps (&info, caps))
+    goto invalid_caps;
+
+  /* Let upstream render into the device buffers, unless it is about to give
+   * us its own dmabufs */
+  if (obj->pool && obj->mode != GST_V4L2_IO_DMABUF_IMPORT &&
+      gst_v4l2_object_caps_equal (obj, caps)) {
+    pool = gst_object_ref (obj->pool);
+    size = obj->sizeimage;
+  } else {
+    size = GST_VIDEO_INFO_SIZE (&info);
+  }
+
+  /* we need at least 2 buffers to operate */
+  gst_query_add_allocation_pool (query, pool, size, 2, 0);
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+  if (pool)
+    gst_object_unref (pool);
+
+  return TRUE;
+
+  /* ERRORS */
+no_caps:
+  {
+    GST_DEBUG_OBJECT (self, "no caps specified");
+    return FALSE;
+  }
+invalid_caps:
+  {
+    GST_DEBUG_OBJECT (self, "invalid caps specified");
+    return FALSE;
+  }
+}
+
+static GstCaps *
+gst_v4l2_transform_transform_caps (GstBaseTransform * btrans,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter)
+{
+  GstV4l2Transform *self = GST_V4L2_TRANSFORM (btrans);
+  GstCaps *ret, *other;
+
+  /* Any input can be converted into any output the device supports, the
+   * input caps come first so that passthrough is preferred */
+  if (direction == GST_PAD_SINK)
+    other = self->probed_srccaps;
+  else
+    other = self->probed_sinkcaps;
+
+  if (other)
+    other = gst_caps_ref (other);
+  else
+    other = gst_pad_get_pad_template_caps (direction == GST_PAD_SINK ?
+        GST_BASE_TRANSFORM_SRC_PAD (btrans) :
+        GST_BASE_TRANSFORM_SINK_PAD (btrans));
+
+  ret = gst_caps_merge (gst_caps_ref (caps), other);
+
+  if (filter) {
+    GstCaps *tmp = ret;
+    ret = gst_caps_intersect_full (filter, tmp, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (tmp);
+  }
+
+  GST_DEBUG_OBJECT (btrans, "transformed %" GST_PTR_FORMAT " into %"
+      GST_PTR_FORMAT, caps, ret);
+
+  return ret;
+}
+
+static GstCaps *
+gst_v4l2_transform_fixate_caps (GstBaseTransform * trans,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps)
+{
+  GstStructure *ins, *outs;
+  const gchar *format;
+  gint w, h, n, d;
+
+  othercaps = gst_caps_truncate (othercaps);
+  othercaps = gst_caps_make_writable (othercaps);
+
+  ins = gst_caps_get_structure (caps, 0);
+  outs = gst_caps_get_structure (othercaps, 0);
+
+  /* Keep whatever downstream leaves open as it is on the other side, so
+   * nothing gets converted needlessly */
+  if ((format = gst_structure_get_string (ins, "format")))
+    gst_structure_fixate_field_string (outs, "format", format);
+
+  if (gst_structure_get_int (ins, "width", &w))
+    gst_structure_fixate_field_nearest_int (outs, "width", w);
+
+  if (gst_structure_get_int (ins, "height", &h))
+    gst_structure_fixate_field_nearest_int (outs, "height", h);
+
+  if (gst_structure_get_fraction (ins, "framerate", &n, &d))
+    gst_structure_fixate_field_nearest_fraction (outs, "framerate", n, d);
+
+  if (gst_structure_get_fraction (ins, "pixel-aspect-ratio", &n, &d) &&
+      gst_structure_has_field (outs, "pixel-aspect-ratio"))
+    gst_structure_fixate_field_nearest_fraction (outs, "pixel-aspect-ratio",
+        n, d);
+
+  othercaps = gst_caps_fixate (othercaps);
+
+  GST_DEBUG_OBJECT (trans, "fixated to %" GST_PTR_FORMAT, othercaps);
+
+  return othercaps;
+}
+
+static gboolean
+gst_v4l2_transform_sink_event (GstBaseTransform * trans, GstEvent * event)
+{
+  GstV4l2Transform *self = GST_V4L2_TRANSFORM (trans);
+  gboolean ret;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      GST_DEBUG_OBJECT (self, "flush start");
+      gst_v4l2_object_unlock (self->v4l2output);
+      gst_v4l2_object_unlock (self->v4l2capture);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_BASE_TRANSFORM_CLASS (parent_class)->sink_event (trans, event);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_STOP:
+      /* Buffer should be back now */
+      GST_DEBUG_OBJECT (self, "flush stop");
+      gst_v4l2_object_unlock_stop (self->v4l2capture);
+      gst_v4l2_object_unlock_stop (self->v4l2output);
+      if (self->v4l2output->pool)
+        gst_v4l2_buffer_pool_flush (GST_V4L2_BUFFER_POOL (self->
+                v4l2output->pool));
+      if (self->v4l2capture->pool)
+        gst_v4l2_buffer_pool_flush (GST_V4L2_BUFFER_POOL (self->
+                v4l2capture->pool));
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+/* The device converts one frame at a time, so the conversion is done here:
+ * the input is queued on the OUTPUT queue and the output buffer is the frame
+ * dequeued from the CAPTURE queue. */
+static GstFlowReturn
+gst_v4l2_transform_prepare_output_buffer (GstBaseTransform * trans,
+    GstBuffer * inbuf, GstBuffer ** outbuf)
+{
+  GstV4l2Transform *self = GST_V4L2_TRANSFORM (trans);
+  GstBaseTransformClass *bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+  GstBufferPool *pool;
+  GstFlowReturn ret;
+
+  if (gst_base_transform_is_passthrough (trans)) {
+    GST_DEBUG_OBJECT (self, "Passthrough, no need to do anything");
+    *outbuf = inbuf;
+    return GST_FLOW_OK;
+  }
+
+  /* the output pool activates itself on the first buffer */
+  GST_LOG_OBJECT (self, "Queue input buffer");
+  ret = gst_v4l2_buffer_pool_process (GST_V4L2_BUFFER_POOL (self->v4l2output->
+          pool), inbuf);
+  if (G_UNLIKELY (ret != GST_FLOW_OK))
+    return ret;
+
+  pool = GST_BUFFER_POOL (self->v4l2capture->pool);
+  if (!gst_buffer_pool_is_active (pool) &&
+      !gst_buffer_pool_set_active (pool, TRUE))
+    goto activate_failed;
+
+  /* this polls until the device converted the frame */
+  GST_LOG_OBJECT (self, "Dequeue output buffer");
+  ret = gst_buffer_pool_acquire_buffer (pool, outbuf, NULL);
+  if (G_UNLIKELY (ret != GST_FLOW_OK))
+    return ret;
+
+  ret = gst_v4l2_buffer_pool_process (GST_V4L2_BUFFER_POOL (pool), *outbuf);
+  if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+    gst_buffer_unref (*outbuf);
+    *outbuf = NULL;
+    return ret;
+  }
+
+  if (bclass->copy_metadata &&
+      !bclass->copy_metadata (trans, inbuf, *outbuf)) {
+    /* something failed, post a warning */
+    GST_ELEMENT_WARNING (self, STREAM, NOT_IMPLEMENTED,
+        ("could not copy metadata"), (NULL));
+  }
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+activate_failed:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS,
+        (_("Video device could not create buffer pool.")), GST_ERROR_SYSTEM);
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstFlowReturn
+gst_v4l2_transform_transform (GstBaseTransform * trans, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  /* Nothing to do here, the frame was converted in prepare_output_buffer() */
+  return GST_FLOW_OK;
+}
+
+static GstStateChangeReturn
+gst_v4l2_transform_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstV4l2Transform *self = GST_V4L2_TRANSFORM (element);
+  GstStateChangeReturn ret = GST_STATE_CHANGE_SUCCESS;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (!gst_v4l2_transform_open (self))
+        return GST_STATE_CHANGE_FAILURE;
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_v4l2_object_unlock (self->v4l2output);
+      gst_v4l2_object_unlock (self->v4l2capture);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      gst_v4l2_transform_close (self);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static void
+gst_v4l2_transform_dispose (GObject * object)
+{
+  GstV4l2Transform *self = GST_V4L2_TRANSFORM (object);
+
+  gst_caps_replace (&self->probed_sinkcaps, NULL);
+  gst_caps_replace (&self->probed_srccaps, NULL);
+  gst_caps_replace (&self->incaps, NULL);
+  gst_caps_replace (&self->outcaps, NULL);
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+gst_v4l2_transform_finalize (GObject * object)
+{
+  GstV4l2Transform *self = GST_V4L2_TRANSFORM (object);
+
+  gst_v4l2_object_destroy (self->v4l2capture);
+  gst_v4l2_object_destroy (self->v4l2output);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_v4l2_transform_base_init (gpointer g_class)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+  GstV4l2TransformQData *qdata;
+  GstPadTemplate *templ;
+
+  qdata = g_type_get_qdata (G_TYPE_FROM_CLASS (g_class), V4L2_TRANSFORM_QUARK);
+  if (!qdata)
+    return;
+
+  templ =
+      gst_pad_template_new ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+      qdata->sink_caps);
+  gst_element_class_add_pad_template (element_class, templ);
+
+  templ =
+      gst_pad_template_new ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+      qdata->src_caps);
+  gst_element_class_add_pad_template (element_class, templ);
+}
+
+static void
+gst_v4l2_transform_init (GstV4l2Transform * self, gpointer g_class)
+{
+  GstV4l2TransformQData *qdata;
+
+  qdata = g_type_get_qdata (G_TYPE_FROM_CLASS (g_class), V4L2_TRANSFORM_QUARK);
+  if (!qdata)
+    return;
+
+  self->v4l2output = gst_v4l2_object_new (GST_ELEMENT (self),
+      V4L2_BUF_TYPE_VIDEO_OUTPUT, qdata->device,
+      gst_v4l2_get_output, gst_v4l2_set_output, NULL);
+  self->v4l2output->no_initial_format = TRUE;
+  self->v4l2output->keep_aspect = FALSE;
+
+  self->v4l2capture = gst_v4l2_object_new (GST_ELEMENT (self),
+      V4L2_BUF_TYPE_VIDEO_CAPTURE, qdata->device,
+      gst_v4l2_get_input, gst_v4l2_set_input, NULL);
+  self->v4l2capture->no_initial_format = TRUE;
+  self->v4l2capture->keep_aspect = FALSE;
+
+  g_object_set (self, "device", qdata->device, NULL);
+}
+
+static void
+gst_v4l2_transform_class_init (GstV4l2TransformClass * klass)
+{
+  GstElementClass *element_class;
+  GObjectClass *gobject_class;
+  GstBaseTransformClass *base_transform_class;
+
+  parent_class = g_type_class_peek_parent (klass);
+
+  element_class = (GstElementClass *) klass;
+  gobject_class = (GObjectClass *) klass;
+  base_transform_class = (GstBaseTransformClass *) klass;
+
+  gst_element_class_set_static_metadata (element_class,
+      "V4L2 Video Converter",
+      "Filter/Converter/Video/Scaler",
+      "Transform streams via V4L2 API",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+
+  gobject_class->dispose = GST_DEBUG_FUNCPTR (gst_v4l2_transform_dispose);
+  gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_v4l2_transform_finalize);
+  gobject_class->set_property =
+      GST_DEBUG_FUNCPTR (gst_v4l2_transform_set_property);
+  gobject_class->get_property =
+      GST_DEBUG_FUNCPTR (gst_v4l2_transform_get_property);
+
+  base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_v4l2_transform_stop);
+  base_transform_class->set_caps =
+      GST_DEBUG_FUNCPTR (gst_v4l2_transform_set_caps);
+  base_transform_class->sink_event =
+      GST_DEBUG_FUNCPTR (gst_v4l2_transform_sink_event);
+  base_transform_class->decide_allocation =
+      GST_DEBUG_FUNCPTR (gst_v4l2_transform_decide_allocation);
+  base_transform_class->propose_allocation =
+      GST_DEBUG_FUNCPTR (gst_v4l2_transform_propose_allocation);
+  base_transform_class->transform_caps =
+      GST_DEBUG_FUNCPTR (gst_v4l2_transform_transform_caps);
+  base_transform_class->fixate_caps =
+      GST_DEBUG_FUNCPTR (gst_v4l2_transform_fixate_caps);
+  base_transform_class->prepare_output_buffer =
+      GST_DEBUG_FUNCPTR (gst_v4l2_transform_prepare_output_buffer);
+  base_transform_class->transform =
+      GST_DEBUG_FUNCPTR (gst_v4l2_transform_transform);
+
+  base_transform_class->passthrough_on_same_caps = TRUE;
+
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_v4l2_transform_change_state);
+
+  gst_v4l2_object_install_properties_helper (gobject_class,
+      DEFAULT_PROP_DEVICE);
+
+  /**
+   * GstV4l2Transform:capture-io-mode
+   *
+   * Capture IO Mode
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_CAPTURE_IO_MODE,
+      g_param_spec_enum ("capture-io-mode", "Capture IO mode",
+          "Capture I/O mode",
+          GST_TYPE_V4L2_IO_MODE, GST_V4L2_IO_AUTO,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+/* Probing functions */
+static GstCaps *
+gst_v4l2_transform_probe_caps (gchar * device, gint video_fd,
+    enum v4l2_buf_type type, GstCaps * filter)
+{
+  gint n;
+  struct v4l2_fmtdesc format;
+  GstCaps *ret, *caps;
+
+  GST_DEBUG ("Getting %s format enumerations", device);
+  caps = gst_caps_new_empty ();
+
+  for (n = 0;; n++) {
+    GstStructure *template;
+
+    format.index = n;
+    format.type = type;
+
+    if (v4l2_ioctl (video_fd, VIDIOC_ENUM_FMT, &format) < 0)
+      break;                    /* end of enumeration */
+
+    GST_LOG ("index:       %u", format.index);
+    GST_LOG ("type:        %d", format.type);
+    GST_LOG ("flags:       %08x", format.flags);
+    GST_LOG ("description: '%s'", format.description);
+    GST_LOG ("pixelformat: %" GST_FOURCC_FORMAT,
+        GST_FOURCC_ARGS (format.pixelformat));
+
+    template = gst_v4l2_object_v4l2fourcc_to_structure (format.pixelformat);
+
+    if (template)
+      gst_caps_append_structure (caps, template);
+  }
+
+  caps = gst_caps_simplify (caps);
+
+  ret = gst_caps_intersect (filter, caps);
+  gst_caps_unref (filter);
+  gst_caps_unref (caps);
+
+  return ret;
+}
+
+gboolean
+gst_v4l2_transform_register (GstPlugin * plugin)
+{
+  gint i = -1;
+  gchar *device = NULL;
+
+  GST_DEBUG_CATEGORY_INIT (gst_v4l2_transform_debug, "v4l2transform", 0,
+      "V4L2 Converter");
+
+  while (TRUE) {
+    GstCaps *src_caps, *sink_caps;
+    gint video_fd;
+
+    g_free (device);
+    device = g_strdup_printf ("/dev/video%d", ++i);
+
+    if (!g_file_test (device, G_FILE_TEST_EXISTS))
+      break;
+
+    video_fd = open (device, O_RDWR);
+    if (video_fd == -1) {
+      GST_WARNING ("Failed to open %s", device);
+      continue;
+    }
+
+    /* get sink supported format */
+    sink_caps = gst_caps_merge (gst_v4l2_transform_probe_caps (device,
+            video_fd, V4L2_BUF_TYPE_VIDEO_OUTPUT,
+            gst_v4l2_object_get_raw_caps ()),
+        gst_v4l2_transform_probe_caps (device, video_fd,
+            V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE,
+            gst_v4l2_object_get_raw_caps ()));
+
+    /* get src supported format */
+    src_caps = gst_caps_merge (gst_v4l2_transform_probe_caps (device,
+            video_fd, V4L2_BUF_TYPE_VIDEO_CAPTURE,
+            gst_v4l2_object_get_raw_caps ()),
+        gst_v4l2_transform_probe_caps (device, video_fd,
+            V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE,
+            gst_v4l2_object_get_raw_caps ()));
+
+    /* both sides raw, this is neither a decoder nor an encoder */
+    if (!gst_caps_is_empty (sink_caps) && !gst_caps_is_empty (src_caps)) {
+      GTypeQuery type_query;
+      GTypeInfo type_info = { 0, };
+      GType type, subtype;
+      gchar *type_name;
+      GstV4l2TransformQData *qdata;
+
+      type = gst_v4l2_transform_get_type ();
+      g_type_query (type, &type_query);
+      memset (&type_info, 0, sizeof (type_info));
+      type_info.class_size = type_query.class_size;
+      type_info.instance_size = type_query.instance_size;
+
+      type_name = g_strdup_printf ("v4l2video%dconvert", i);
+      subtype = g_type_register_static (type, type_name, &type_info, 0);
+
+      qdata = g_new0 (GstV4l2TransformQData, 1);
+      qdata->device = g_strdup (device);
+      qdata->sink_caps = gst_caps_ref (sink_caps);
+      qdata->src_caps = gst_caps_ref (src_caps);
+
+      g_type_set_qdata (subtype, V4L2_TRANSFORM_QUARK, qdata);
+
+      gst_element_register (plugin, type_name, GST_RANK_NONE, subtype);
+
+      g_free (type_name);
+    }
+
+    close (video_fd);
+    gst_caps_unref (src_caps);
+    gst_caps_unref (sink_caps);
+  }
+
+  g_free (device);
+
+  return TRUE;
+}
@@ -0,0 +1,1126 @@
+/*
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+/* One element is registered per V4L2 memory-to-memory device that takes raw
+ * video on its OUTPUT queue and produces a supported codec on its CAPTURE
+ * queue, e.g. v4l2video4enc. Raw frames are queued on the OUTPUT side from
+ * the streaming thread while a task on the source pad dequeues the encoded
+ * frames.
+ *
+ * With io-mode=dmabuf-import, upstream buffers made of dmabuf memory (for
+ * example from v4l2src io-mode=dmabuf) are queued to the encoder without
+ * being copied:
+ * |[
+ * gst-launch-1.0 v4l2src io-mode=dmabuf ! v4l2video4enc io-mode=dmabuf-import
+ *     bitrate=2000000 gop-size=30 ! h264parse ! rtph264pay ! udpsink port=5000
+ * ]|
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "gstv4l2videoenc.h"
+#include "v4l2_calls.h"
+
+#include <gst/gst-i18n-plugin.h>
+
+#define DEFAULT_PROP_DEVICE "/dev/video0"
+#define DEFAULT_PROP_BITRATE 0
+#define DEFAULT_PROP_GOP_SIZE 0
+
+#define V4L2_VIDEO_ENC_QUARK \
+	g_quark_from_static_string("gst-v4l2-video-enc-info")
+
+GST_DEBUG_CATEGORY_STATIC (gst_v4l2_video_enc_debug);
+#define GST_CAT_DEFAULT gst_v4l2_video_enc_debug
+
+static GstFlowReturn gst_v4l2_video_enc_finish (GstVideoEncoder * encoder);
+
+typedef struct
+{
+  gchar *device;
+  GstCaps *sink_caps;
+  GstCaps *src_caps;
+} Gstv4l2VideoEncQData;
+
+enum
+{
+  PROP_0,
+  V4L2_STD_OBJECT_PROPS,
+  PROP_CAPTURE_IO_MODE,
+  PROP_BITRATE,
+  PROP_GOP_SIZE
+};
+
+static void gst_v4l2_video_enc_class_init (GstV4l2VideoEncClass * klass);
+static void gst_v4l2_video_enc_init (GstV4l2VideoEnc * self, gpointer g_class);
+static void gst_v4l2_video_enc_base_init (gpointer g_class);
+
+static GstVideoEncoderClass *parent_class = NULL;
+
+GType
+gst_v4l2_video_enc_get_type (void)
+{
+  static volatile gsize type = 0;
+
+  if (g_once_init_enter (&type)) {
+    GType _type;
+    static const GTypeInfo info = {
+      sizeof (GstV4l2VideoEncClass),
+      gst_v4l2_video_enc_base_init,
+      NULL,
+      (GClassInitFunc) gst_v4l2_video_enc_class_init,
+      NULL,
+      NULL,
+      sizeof (GstV4l2VideoEnc),
+      0,
+      (GInstanceInitFunc) gst_v4l2_video_enc_init,
+      NULL
+    };
+
+    _type = g_type_register_static (GST_TYPE_VIDEO_ENCODER, "GstV4l2VideoEnc",
+        &info, 0);
+
+    g_once_init_leave (&type, _type);
+  }
+  return type;
+}
+
+/* Rate control settings, 0 keeps the driver default */
+static void
+gst_v4l2_video_enc_set_controls (GstV4l2VideoEnc * self)
+{
+  if (self->bitrate > 0)
+    gst_v4l2_set_attribute (self->v4l2output, V4L2_CID_MPEG_VIDEO_BITRATE,
+        self->bitrate);
+
+  if (self->gop_size > 0)
+    gst_v4l2_set_attribute (self->v4l2output, V4L2_CID_MPEG_VIDEO_GOP_SIZE,
+        self->gop_size);
+}
+
+static void
+gst_v4l2_video_enc_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (object);
+
+  switch (prop_id) {
+      /* Split IO mode so output is configure through 'io-mode' and capture
+       * through 'capture-io-mode' */
+    case PROP_IO_MODE:
+      gst_v4l2_object_set_property_helper (self->v4l2output, prop_id, value,
+          pspec);
+      break;
+    case PROP_CAPTURE_IO_MODE:
+      gst_v4l2_object_set_property_helper (self->v4l2capture, PROP_IO_MODE,
+          value, pspec);
+      break;
+
+    case PROP_DEVICE:
+      gst_v4l2_object_set_property_helper (self->v4l2output, prop_id, value,
+          pspec);
+      gst_v4l2_object_set_property_helper (self->v4l2capture, prop_id, value,
+          pspec);
+      break;
+
+      /* Most drivers allow to change those while encoding */
+    case PROP_BITRATE:
+      self->bitrate = g_value_get_uint (value);
+      if (GST_V4L2_IS_OPEN (self->v4l2output) && self->bitrate > 0)
+        gst_v4l2_set_attribute (self->v4l2output, V4L2_CID_MPEG_VIDEO_BITRATE,
+            self->bitrate);
+      break;
+    case PROP_GOP_SIZE:
+      self->gop_size = g_value_get_uint (value);
+      if (GST_V4L2_IS_OPEN (self->v4l2output) && self->gop_size > 0)
+        gst_v4l2_set_attribute (self->v4l2output, V4L2_CID_MPEG_VIDEO_GOP_SIZE,
+            self->gop_size);
+      break;
+
+      /* By default, only set on output */
+    default:
+      if (!gst_v4l2_object_set_property_helper (self->v4l2output,
+              prop_id, value, pspec)) {
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      }
+      break;
+  }
+}
+
+static void
+gst_v4l2_video_enc_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (object);
+
+  switch (prop_id) {
+    case PROP_IO_MODE:
+      gst_v4l2_object_get_property_helper (self->v4l2output, prop_id, value,
+          pspec);
+      break;
+    case PROP_CAPTURE_IO_MODE:
+      gst_v4l2_object_get_property_helper (self->v4l2capture, PROP_IO_MODE,
+          value, pspec);
+      break;
+
+    case PROP_BITRATE:
+      g_value_set_uint (value, self->bitrate);
+      break;
+    case PROP_GOP_SIZE:
+      g_value_set_uint (value, self->gop_size);
+      break;
+
+      /* By default read from output */
+    default:
+      if (!gst_v4l2_object_get_property_helper (self->v4l2output,
+              prop_id, value, pspec)) {
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      }
+      break;
+  }
+}
+
+static gboolean
+gst_v4l2_video_enc_open (GstVideoEncoder * encoder)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (encoder);
+
+  GST_DEBUG_OBJECT (self, "Opening");
+
+  if (!gst_v4l2_object_open (self->v4l2output))
+    goto failure;
+
+  if (!gst_v4l2_object_open_shared (self->v4l2capture, self->v4l2output))
+    goto failure;
+
+  self->probed_sinkcaps = gst_v4l2_object_get_caps (self->v4l2output,
+      gst_v4l2_object_get_raw_caps ());
+
+  if (gst_caps_is_empty (self->probed_sinkcaps))
+    goto no_raw_format;
+
+  self->probed_srccaps = gst_v4l2_object_get_caps (self->v4l2capture,
+      gst_v4l2_object_get_codec_caps ());
+
+  if (gst_caps_is_empty (self->probed_srccaps))
+    goto no_encoded_format;
+
+  return TRUE;
+
+no_raw_format:
+  GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS,
+      (_("Encoder on device %s has no supported input format"),
+          self->v4l2output->videodev), (NULL));
+  goto failure;
+
+
+no_encoded_format:
+  GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS,
+      (_("Encoder on device %s has no supported output format"),
+          self->v4l2output->videodev), (NULL));
+  goto failure;
+
+failure:
+  if (GST_V4L2_IS_OPEN (self->v4l2output))
+    gst_v4l2_object_close (self->v4l2output);
+
+  if (GST_V4L2_IS_OPEN (self->v4l2capture))
+    gst_v4l2_object_close (self->v4l2capture);
+
+  gst_caps_replace (&self->probed_srccaps, NULL);
+  gst_caps_replace (&self->probed_sinkcaps, NULL);
+
+  return FALSE;
+}
+
+static gboolean
+gst_v4l2_video_enc_close (GstVideoEncoder * encoder)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (encoder);
+
+  GST_DEBUG_OBJECT (self, "Closing");
+
+  gst_v4l2_object_close (self->v4l2output);
+  gst_v4l2_object_close (self->v4l2capture);
+  gst_caps_replace (&self->probed_srccaps, NULL);
+  gst_caps_replace (&self->probed_sinkcaps, NULL);
+
+  return TRUE;
+}
+
+static gboolean
+gst_v4l2_video_enc_start (GstVideoEncoder * encoder)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (encoder);
+
+  GST_DEBUG_OBJECT (self, "Starting");
+
+  gst_v4l2_object_unlock (self->v4l2output);
+  g_atomic_int_set (&self->active, TRUE);
+  self->output_flow = GST_FLOW_OK;
+
+  return TRUE;
+}
+
+static gboolean
+gst_v4l2_video_enc_stop (GstVideoEncoder * encoder)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (encoder);
+
+  GST_DEBUG_OBJECT (self, "Stopping");
+
+  /* Should have been flushed already */
+  g_assert (g_atomic_int_get (&self->active) == FALSE);
+  g_assert (g_atomic_int_get (&self->processing) == FALSE);
+
+  gst_v4l2_object_stop (self->v4l2output);
+  gst_v4l2_object_stop (self->v4l2capture);
+
+  if (self->input_state) {
+    gst_video_codec_state_unref (self->input_state);
+    self->input_state = NULL;
+  }
+
+  GST_DEBUG_OBJECT (self, "Stopped");
+
+  return TRUE;
+}
+
+/* The rate control of most encoders needs the frame duration */
+static void
+gst_v4l2_video_enc_set_framerate (GstV4l2VideoEnc * self, GstVideoInfo * info)
+{
+  struct v4l2_streamparm streamparm;
+
+  if (info->fps_n <= 0 || info->fps_d <= 0)
+    return;
+
+  memset (&streamparm, 0x00, sizeof (struct v4l2_streamparm));
+  streamparm.type = self->v4l2output->type;
+  streamparm.parm.output.timeperframe.numerator = info->fps_d;
+  streamparm.parm.output.timeperframe.denominator = info->fps_n;
+
+  if (v4l2_ioctl (self->v4l2output->video_fd, VIDIOC_S_PARM, &streamparm) < 0)
+    GST_DEBUG_OBJECT (self, "Could not set framerate %d/%d: %s", info->fps_n,
+        info->fps_d, g_strerror (errno));
+}
+
+static gboolean
+gst_v4l2_video_enc_set_format (GstVideoEncoder * encoder,
+    GstVideoCodecState * state)
+{
+  gboolean ret = TRUE;
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (encoder);
+
+  GST_DEBUG_OBJECT (self, "Setting format: %" GST_PTR_FORMAT, state->caps);
+
+  if (self->input_state) {
+    if (gst_v4l2_object_caps_equal (self->v4l2output, state->caps)) {
+      GST_DEBUG_OBJECT (self, "Compatible caps");
+      goto done;
+    }
+
+    /* Encode what is pending with the old format, then reconfigure both
+     * queues */
+    gst_v4l2_video_enc_finish (encoder);
+    gst_v4l2_object_stop (self->v4l2output);
+    gst_v4l2_object_stop (self->v4l2capture);
+
+    gst_video_codec_state_unref (self->input_state);
+    self->input_state = NULL;
+  }
+
+  ret = gst_v4l2_object_set_format (self->v4l2output, state->caps);
+
+  if (ret) {
+    gst_v4l2_video_enc_set_framerate (self, &state->info);
+    gst_v4l2_video_enc_set_controls (self);
+    self->input_state = gst_video_codec_state_ref (state);
+  }
+
+done:
+  return ret;
+}
+
+static gboolean
+gst_v4l2_video_enc_flush (GstVideoEncoder * encoder)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (encoder);
+
+  GST_DEBUG_OBJECT (self, "Flushing");
+
+  /* Wait for capture thread to stop */
+  gst_pad_stop_task (encoder->srcpad);
+  self->output_flow = GST_FLOW_OK;
+
+  if (self->v4l2output->pool)
+    gst_v4l2_buffer_pool_flush (GST_V4L2_BUFFER_POOL (self->v4l2output->pool));
+  if (self->v4l2capture->pool)
+    gst_v4l2_buffer_pool_flush (GST_V4L2_BUFFER_POOL (self->
+            v4l2capture->pool));
+
+  /* Output will remain flushing until new frame comes in */
+  gst_v4l2_object_unlock_stop (self->v4l2capture);
+
+  return TRUE;
+}
+
+/* Picks the first format downstream accepts among the ones the device can
+ * produce, then configures the CAPTURE queue with it */
+static gboolean
+gst_v4l2_video_enc_negotiate (GstVideoEncoder * encoder)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (encoder);
+  GstVideoCodecState *state;
+  GstCaps *caps;
+
+  caps = gst_pad_peer_query_caps (encoder->srcpad, self->probed_srccaps);
+
+  GST_DEBUG_OBJECT (self, "Possible output caps %" GST_PTR_FORMAT, caps);
+
+  if (gst_caps_is_empty (caps)) {
+    gst_caps_unref (caps);
+    goto not_negotiated;
+  }
+
+  /* dimensions and framerate are filled in from the input state */
+  caps = gst_caps_fixate (gst_caps_truncate (caps));
+
+  state = gst_video_encoder_set_output_state (encoder, caps,
+      self->input_state);
+
+  if (!GST_VIDEO_ENCODER_CLASS (parent_class)->negotiate (encoder)) {
+    gst_video_codec_state_unref (state);
+    goto not_negotiated;
+  }
+
+  if (!GST_V4L2_IS_ACTIVE (self->v4l2capture) &&
+      !gst_v4l2_object_set_format (self->v4l2capture, state->caps)) {
+    gst_video_codec_state_unref (state);
+    goto not_negotiated;
+  }
+
+  gst_video_codec_state_unref (state);
+
+  return TRUE;
+
+not_negotiated:
+  {
+    GST_DEBUG_OBJECT (self, "Could not negotiate the encoded format");
+    return FALSE;
+  }
+}
+
+static GstFlowReturn
+gst_v4l2_video_enc_finish (GstVideoEncoder * encoder)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (encoder);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBufferPool *pool;
+  GstBuffer *buffer;
+
+  if (g_atomic_int_get (&self->processing) == FALSE)
+    return self->output_flow;
+
+  GST_DEBUG_OBJECT (self, "Finishing encoding");
+
+  pool = GST_BUFFER_POOL (self->v4l2output->pool);
+
+  /* Keep queuing empty buffers until the processing thread has stopped,
+   * _pool_process() will return FLUSHING when that happened. The buffers
+   * come from our own pool since there is no raw frame to copy. */
+  GST_VIDEO_ENCODER_STREAM_UNLOCK (encoder);
+  while (ret == GST_FLOW_OK) {
+    ret = gst_buffer_pool_acquire_buffer (pool, &buffer, NULL);
+    if (ret != GST_FLOW_OK)
+      break;
+
+    gst_buffer_resize (buffer, 0, 0);
+    ret = gst_v4l2_buffer_pool_process (GST_V4L2_BUFFER_POOL (pool), buffer);
+    gst_buffer_unref (buffer);
+  }
+
+  if (ret != GST_FLOW_FLUSHING) {
+    /* In dmabuf-import mode the buffers that never imported anything cannot
+     * be queued, stop the processing thread ourself */
+    GST_WARNING_OBJECT (self, "Could not drain the encoder: %s",
+        gst_flow_get_name (ret));
+    gst_v4l2_object_unlock (self->v4l2capture);
+    gst_pad_stop_task (encoder->srcpad);
+    g_atomic_int_set (&self->processing, FALSE);
+  }
+  GST_VIDEO_ENCODER_STREAM_LOCK (encoder);
+
+  g_assert (g_atomic_int_get (&self->processing) == FALSE);
+
+  if (ret == GST_FLOW_FLUSHING)
+    ret = self->output_flow;
+
+  GST_DEBUG_OBJECT (encoder, "Done draining buffers");
+
+  return ret;
+}
+
+static GstVideoCodecFrame *
+gst_v4l2_video_enc_get_oldest_frame (GstVideoEncoder * encoder)
+{
+  GstVideoCodecFrame *frame = NULL;
+  GList *frames, *l;
+  gint count = 0;
+
+  frames = gst_video_encoder_get_frames (encoder);
+
+  for (l = frames; l != NULL; l = l->next) {
+    GstVideoCodecFrame *f = l->data;
+
+    if (!frame || frame->pts > f->pts)
+      frame = f;
+
+    count++;
+  }
+
+  if (frame) {
+    GST_LOG_OBJECT (encoder,
+        "Oldest frame is %d %" GST_TIME_FORMAT " and %d frames left",
+        frame->system_frame_number, GST_TIME_ARGS (frame->pts), count - 1);
+    gst_video_codec_frame_ref (frame);
+  }
+
+  g_list_free_full (frames, (GDestroyNotify) gst_video_codec_frame_unref);
+
+  return frame;
+}
+
+static void
+gst_v4l2_video_enc_loop (GstVideoEncoder * encoder)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (encoder);
+  GstBufferPool *pool;
+  GstVideoCodecFrame *frame;
+  GstBuffer *buffer = NULL;
+  GstFlowReturn ret;
+
+  GST_LOG_OBJECT (encoder, "Allocate output buffer");
+
+  /* The encoded data comes straight from the device buffers, acquiring polls
+   * until the encoder produced a frame. */
+  pool = GST_BUFFER_POOL (self->v4l2capture->pool);
+  ret = gst_buffer_pool_acquire_buffer (pool, &buffer, NULL);
+
+  if (ret != GST_FLOW_OK)
+    goto beach;
+
+  /* Check if buffer isn't the last one */
+  if (gst_buffer_get_size (buffer) == 0)
+    goto beach;
+
+  GST_LOG_OBJECT (encoder, "Process output buffer");
+  ret =
+      gst_v4l2_buffer_pool_process (GST_V4L2_BUFFER_POOL (self->
+          v4l2capture->pool), buffer);
+
+  if (ret != GST_FLOW_OK)
+    goto beach;
+
+  frame = gst_v4l2_video_enc_get_oldest_frame (encoder);
+
+  if (frame) {
+    /* the pool flags encoded buffers from the driver keyframe flag */
+    if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+      GST_VIDEO_CODEC_FRAME_SET_SYNC_POINT (frame);
+
+    frame->output_buffer = buffer;
+    buffer = NULL;
+    ret = gst_video_encoder_finish_frame (encoder, frame);
+
+    if (ret != GST_FLOW_OK)
+      goto beach;
+  } else {
+    GST_WARNING_OBJECT (encoder, "Encoder is producing too many buffers");
+    gst_buffer_unref (buffer);
+  }
+
+  return;
+
+beach:
+  GST_DEBUG_OBJECT (encoder, "Leaving output thread");
+
+  gst_buffer_replace (&buffer, NULL);
+  self->output_flow = ret;
+  g_atomic_int_set (&self->processing, FALSE);
+  gst_v4l2_object_unlock (self->v4l2output);
+  gst_pad_pause_task (encoder->srcpad);
+}
+
+static GstFlowReturn
+gst_v4l2_video_enc_handle_frame (GstVideoEncoder * encoder,
+    GstVideoCodecFrame * frame)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (encoder);
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  GST_DEBUG_OBJECT (self, "Handling frame %d", frame->system_frame_number);
+
+  if (G_UNLIKELY (!g_atomic_int_get (&self->active)))
+    goto flushing;
+
+  if (G_UNLIKELY (self->input_state == NULL))
+    goto not_negotiated;
+
+  if (G_UNLIKELY (!GST_V4L2_IS_ACTIVE (self->v4l2output))) {
+    if (!gst_v4l2_object_set_format (self->v4l2output, self->input_state->caps))
+      goto not_negotiated;
+  }
+
+  if (G_UNLIKELY (!GST_V4L2_IS_ACTIVE (self->v4l2capture))) {
+    if (!gst_video_encoder_negotiate (encoder)) {
+      if (GST_PAD_IS_FLUSHING (encoder->srcpad))
+        goto flushing;
+      else
+        goto not_negotiated;
+    }
+  }
+
+  if (g_atomic_int_get (&self->processing) == FALSE) {
+    GstBufferPool *pool = GST_BUFFER_POOL (self->v4l2capture->pool);
+
+    /* It possible that the processing thread stopped due to an error */
+    if (self->output_flow != GST_FLOW_OK) {
+      GST_DEBUG_OBJECT (self, "Processing loop stopped with error, leaving");
+      ret = self->output_flow;
+      goto drop;
+    }
+
+    /* Nobody downstream allocates from the capture pool, activate it here
+     * so the device gets its buffers queued */
+    if (!gst_buffer_pool_is_active (pool) &&
+        !gst_buffer_pool_set_active (pool, TRUE))
+      goto activate_failed;
+
+    GST_DEBUG_OBJECT (self, "Starting encoding thread");
+
+    /* Enable processing input */
+    gst_v4l2_object_unlock_stop (self->v4l2output);
+    gst_v4l2_object_unlock_stop (self->v4l2capture);
+
+    /* Start the processing task, when it quits, the task will disable input
+     * processing to unlock input if draining, or prevent potential block */
+    g_atomic_int_set (&self->processing, TRUE);
+    gst_pad_start_task (encoder->srcpad,
+        (GstTaskFunction) gst_v4l2_video_enc_loop, self, NULL);
+  }
+
+  if (frame->input_buffer) {
+    GST_VIDEO_ENCODER_STREAM_UNLOCK (encoder);
+    ret =
+        gst_v4l2_buffer_pool_process (GST_V4L2_BUFFER_POOL (self->v4l2output->
+            pool), frame->input_buffer);
+    GST_VIDEO_ENCODER_STREAM_LOCK (encoder);
+
+    if (ret == GST_FLOW_FLUSHING) {
+      if (g_atomic_int_get (&self->processing) == FALSE)
+        ret = self->output_flow;
+    }
+
+    /* No need to keep input arround */
+    gst_buffer_replace (&frame->input_buffer, NULL);
+  }
+
+  gst_video_codec_frame_unref (frame);
+  return ret;
+
+  /* ERRORS */
+not_negotiated:
+  {
+    GST_ERROR_OBJECT (self, "not negotiated");
+    ret = GST_FLOW_NOT_NEGOTIATED;
+    goto drop;
+  }
+activate_failed:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS,
+        (_("Video device could not create buffer pool.")), GST_ERROR_SYSTEM);
+    ret = GST_FLOW_ERROR;
+    goto drop;
+  }
+flushing:
+  {
+    ret = GST_FLOW_FLUSHING;
+    goto drop;
+  }
+drop:
+  {
+    /* the encoder base class has no drop function, finishing a frame without
+     * output buffer discards it */
+    gst_video_encoder_finish_frame (encoder, frame);
+    return ret;
+  }
+}
+
+static gboolean
+gst_v4l2_video_enc_propose_allocation (GstVideoEncoder * encoder,
+    GstQuery * query)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (encoder);
+  GstV4l2Object *obj = self->v4l2output;
+  GstBufferPool *pool = NULL;
+  GstVideoInfo info;
+  GstCaps *caps;
+  guint size = 0;
+
+  gst_query_parse_allocation (query, &caps, NULL);
+
+  if (caps == NULL)
+    goto no_caps;
+
+  if (!gst_video_info_from_caps (&info, caps))
+    goto invalid_caps;
+
+  /* Let upstream render into the device buffers, unless it is about to give
+   * us its own dmabufs */
+  if (obj->pool && obj->mode != GST_V4L2_IO_DMABUF_IMPORT &&
+      gst_v4l2_object_caps_equal (obj, caps)) {
+    pool = gst_object_ref (obj->pool);
+    size = obj->sizeimage;
+  } else {
+    size = GST_VIDEO_INFO_SIZE (&info);
+  }
+
+  /* we need at least 2 buffers to operate */
+  gst_query_add_allocation_pool (query, pool, size, 2, 0);
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+  if (pool)
+    gst_object_unref (pool);
+
+  return TRUE;
+
+  /* ERRORS */
+no_caps:
+  {
+    GST_DEBUG_OBJECT (self, "no caps specified");
+    return FALSE;
+  }
+invalid_caps:
+  {
+    GST_DEBUG_OBJECT (self, "invalid caps specified");
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_v4l2_video_enc_src_query (GstVideoEncoder * encoder, GstQuery * query)
+{
+  gboolean ret = TRUE;
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (encoder);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CAPS:{
+      GstCaps *filter, *result = NULL;
+      gst_query_parse_caps (query, &filter);
+
+      if (self->probed_srccaps)
+        result = gst_caps_ref (self->probed_srccaps);
+      else
+        result = gst_v4l2_object_get_codec_caps ();
+
+      if (filter) {
+        GstCaps *tmp = result;
+        result =
+            gst_caps_intersect_full (filter, tmp, GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref (tmp);
+      }
+
+      GST_DEBUG_OBJECT (self, "Returning src caps %" GST_PTR_FORMAT, result);
+
+      gst_query_set_caps_result (query, result);
+      gst_caps_unref (result);
+      break;
+    }
+
+    default:
+      ret = GST_VIDEO_ENCODER_CLASS (parent_class)->src_query (encoder, query);
+      break;
+  }
+
+  return ret;
+}
+
+static gboolean
+gst_v4l2_video_enc_sink_query (GstVideoEncoder * encoder, GstQuery * query)
+{
+  gboolean ret = TRUE;
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (encoder);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CAPS:{
+      GstCaps *filter, *result = NULL;
+      gst_query_parse_caps (query, &filter);
+
+      if (self->probed_sinkcaps)
+        result = gst_caps_ref (self->probed_sinkcaps);
+      else
+        result = gst_v4l2_object_get_raw_caps ();
+
+      if (filter) {
+        GstCaps *tmp = result;
+        result =
+            gst_caps_intersect_full (filter, tmp, GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref (tmp);
+      }
+
+      GST_DEBUG_OBJECT (self, "Returning sink caps %" GST_PTR_FORMAT, result);
+
+      gst_query_set_caps_result (query, result);
+      gst_caps_unref (result);
+      break;
+    }
+
+    default:
+      ret = GST_VIDEO_ENCODER_CLASS (parent_class)->sink_query (encoder, query);
+      break;
+  }
+
+  return ret;
+}
+
+static gboolean
+gst_v4l2_video_enc_sink_event (GstVideoEncoder * encoder, GstEvent * event)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (encoder);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      gst_v4l2_object_unlock (self->v4l2output);
+      gst_v4l2_object_unlock (self->v4l2capture);
+    default:
+      break;
+  }
+
+  return GST_VIDEO_ENCODER_CLASS (parent_class)->sink_event (encoder, event);
+}
+
+static GstStateChangeReturn
+gst_v4l2_video_enc_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (element);
+
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY) {
+    g_atomic_int_set (&self->active, FALSE);
+    gst_v4l2_object_unlock (self->v4l2output);
+    gst_v4l2_object_unlock (self->v4l2capture);
+  }
+
+  return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+}
+
+static void
+gst_v4l2_video_enc_dispose (GObject * object)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (object);
+
+  gst_caps_replace (&self->probed_sinkcaps, NULL);
+  gst_caps_replace (&self->probed_srccaps, NULL);
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+gst_v4l2_video_enc_finalize (GObject * object)
+{
+  GstV4l2VideoEnc *self = GST_V4L2_VIDEO_ENC (object);
+
+  gst_v4l2_object_destroy (self->v4l2capture);
+  gst_v4l2_object_destroy (self->v4l2output);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_v4l2_video_enc_base_init (gpointer g_class)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+  Gstv4l2VideoEncQData *qdata;
+  GstPadTemplate *templ;
+
+  qdata = g_type_get_qdata (G_TYPE_FROM_CLASS (g_class), V4L2_VIDEO_ENC_QUARK);
+  if (!qdata)
+    return;
+
+  templ =
+      gst_pad_template_new ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+      qdata->sink_caps);
+  gst_element_class_add_pad_template (element_class, templ);
+
+  templ =
+      gst_pad_template_new ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+      qdata->src_caps);
+  gst_element_class_add_pad_template (element_class, templ);
+}
+
+static void
+gst_v4l2_video_enc_init (GstV4l2VideoEnc * self, gpointer g_class)
+{
+  Gstv4l2VideoEncQData *qdata;
+
+  qdata = g_type_get_qdata (G_TYPE_FROM_CLASS (g_class), V4L2_VIDEO_ENC_QUARK);
+  if (!qdata)
+    return;
+
+  self->bitrate = DEFAULT_PROP_BITRATE;
+  self->gop_size = DEFAULT_PROP_GOP_SIZE;
+
+  self->v4l2output = gst_v4l2_object_new (GST_ELEMENT (self),
+      V4L2_BUF_TYPE_VIDEO_OUTPUT, qdata->device,
+      gst_v4l2_get_output, gst_v4l2_set_output, NULL);
+  self->v4l2output->no_initial_format = TRUE;
+  self->v4l2output->keep_aspect = FALSE;
+
+  self->v4l2capture = gst_v4l2_object_new (GST_ELEMENT (self),
+      V4L2_BUF_TYPE_VIDEO_CAPTURE, qdata->device,
+      gst_v4l2_get_input, gst_v4l2_set_input, NULL);
+  self->v4l2capture->no_initial_format = TRUE;
+  self->v4l2capture->keep_aspect = FALSE;
+
+  g_object_set (self, "device", qdata->device, NULL);
+}
+
+static void
+gst_v4l2_video_enc_class_init (GstV4l2VideoEncClass * klass)
+{
+  GstElementClass *element_class;
+  GObjectClass *gobject_class;
+  GstVideoEncoderClass *video_encoder_class;
+
+  parent_class = g_type_class_peek_parent (klass);
+
+  element_class = (GstElementClass *) klass;
+  gobject_class = (GObjectClass *) klass;
+  video_encoder_class = (GstVideoEncoderClass *) klass;
+
+  gst_element_class_set_static_metadata (element_class,
+      "V4L2 Video Encoder",
+      "Codec/Encoder/Video",
+      "Encode video streams via V4L2 API",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+
+  gobject_class->dispose = GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_dispose);
+  gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_finalize);
+  gobject_class->set_property =
+      GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_set_property);
+  gobject_class->get_property =
+      GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_get_property);
+
+  video_encoder_class->open = GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_open);
+  video_encoder_class->close = GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_close);
+  video_encoder_class->start = GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_start);
+  video_encoder_class->stop = GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_stop);
+  video_encoder_class->finish = GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_finish);
+  video_encoder_class->flush = GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_flush);
+  video_encoder_class->set_format =
+      GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_set_format);
+  video_encoder_class->negotiate =
+      GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_negotiate);
+  video_encoder_class->propose_allocation =
+      GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_propose_allocation);
+  video_encoder_class->handle_frame =
+      GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_handle_frame);
+  video_encoder_class->sink_query =
+      GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_sink_query);
+  video_encoder_class->src_query =
+      GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_src_query);
+  video_encoder_class->sink_event =
+      GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_sink_event);
+
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_v4l2_video_enc_change_state);
+
+  gst_v4l2_object_install_properties_helper (gobject_class,
+      DEFAULT_PROP_DEVICE);
+
+  /**
+   * GstV4l2VideoEnc:capture-io-mode
+   *
+   * Capture IO Mode
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_CAPTURE_IO_MODE,
+      g_param_spec_enum ("capture-io-mode", "Capture IO mode",
+          "Capture I/O mode",
+          GST_TYPE_V4L2_IO_MODE, GST_V4L2_IO_AUTO,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstV4l2VideoEnc:bitrate
+   *
+   * Target bitrate in bits per second, 0 keeps the driver default.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_BITRATE,
+      g_param_spec_uint ("bitrate", "Bitrate",
+          "Target bitrate in bit/sec (0 = driver default)", 0, G_MAXINT,
+          DEFAULT_PROP_BITRATE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstV4l2VideoEnc:gop-size
+   *
+   * Distance between two keyframes in frames, 0 keeps the driver default.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_GOP_SIZE,
+      g_param_spec_uint ("gop-size", "GOP size",
+          "Number of frames in a group of pictures (0 = driver default)", 0,
+          G_MAXINT, DEFAULT_PROP_GOP_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+/* Probing functions */
+static GstCaps *
+gst_v4l2_video_enc_probe_caps (gchar * device, gint video_fd,
+    enum v4l2_buf_type type, GstCaps * filter)
+{
+  gint n;
+  struct v4l2_fmtdesc format;
+  GstCaps *ret, *caps;
+
+  GST_DEBUG ("Getting %s format enumerations", device);
+  caps = gst_caps_new_empty ();
+
+  for (n = 0;; n++) {
+    GstStructure *template;
+
+    format.index = n;
+    format.type = type;
+
+    if (v4l2_ioctl (video_fd, VIDIOC_ENUM_FMT, &format) < 0)
+      break;                    /* end of enumeration */
+
+    GST_LOG ("index:       %u", format.index);
+    GST_LOG ("type:        %d", format.type);
+    GST_LOG ("flags:       %08x", format.flags);
+    GST_LOG ("description: '%s'", format.description);
+    GST_LOG ("pixelformat: %" GST_FOURCC_FORMAT,
+        GST_FOURCC_ARGS (format.pixelformat));
+
+    template = gst_v4l2_object_v4l2fourcc_to_structure (format.pixelformat);
+
+    if (template)
+      gst_caps_append_structure (caps, template);
+  }
+
+  caps = gst_caps_simplify (caps);
+
+  ret = gst_caps_intersect (filter, caps);
+  gst_caps_unref (filter);
+  gst_caps_unref (caps);
+
+  return ret;
+}
+
+gboolean
+gst_v4l2_video_enc_register (GstPlugin * plugin)
+{
+  gint i = -1;
+  gchar *device = NULL;
+
+  GST_DEBUG_CATEGORY_INIT (gst_v4l2_video_enc_debug, "v4l2videoenc", 0,
+      "V4L2 Video Encoder");
+
+  while (TRUE) {
+    GstCaps *src_caps, *sink_caps;
+    gint video_fd;
+
+    g_free (device);
+    device = g_strdup_printf ("/dev/video%d", ++i);
+
+    if (!g_file_test (device, G_FILE_TEST_EXISTS))
+      break;
+
+    video_fd = open (device, O_RDWR);
+    if (video_fd == -1) {
+      GST_WARNING ("Failed to open %s", device);
+      continue;
+    }
+
+    /* get sink supported format */
+    sink_caps = gst_caps_merge (gst_v4l2_video_enc_probe_caps (device,
+            video_fd, V4L2_BUF_TYPE_VIDEO_OUTPUT,
+            gst_v4l2_object_get_raw_caps ()),
+        gst_v4l2_video_enc_probe_caps (device, video_fd,
+            V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE,
+            gst_v4l2_object_get_raw_caps ()));
+
+    /* get src supported format */
+    src_caps = gst_caps_merge (gst_v4l2_video_enc_probe_caps (device,
+            video_fd, V4L2_BUF_TYPE_VIDEO_CAPTURE,
+            gst_v4l2_object_get_codec_caps ()),
+        gst_v4l2_video_enc_probe_caps (device, video_fd,
+            V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE,
+            gst_v4l2_object_get_codec_caps ()));
+
+    if (!gst_caps_is_empty (sink_caps) && !gst_caps_is_empty (src_caps)) {
+      GTypeQuery type_query;
+      GTypeInfo type_info = { 0, };
+      GType type, subtype;
+      gchar *type_name;
+      Gstv4l2VideoEncQData *qdata;
+
+      type = gst_v4l2_video_enc_get_type ();
+      g_type_query (type, &type_query);
+      memset (&type_info, 0, sizeof (type_info));
+      type_info.class_size = type_query.class_size;
+      type_info.instance_size = type_query.instance_size;
+
+      type_name = g_strdup_printf ("v4l2video%denc", i);
+      subtype = g_type_register_static (type, type_name, &type_info, 0);
+
+      qdata = g_new0 (Gstv4l2VideoEncQData, 1);
+      qdata->device = g_strdup (device);
+      qdata->sink_caps = gst_caps_ref (sink_caps);
+      qdata->src_caps = gst_caps_ref (src_caps);
+
+      g_type_set_qdata (subtype, V4L2_VIDEO_ENC_QUARK, qdata);
+
+      gst_element_register (plugin, type_name, GST_RANK_PRIMARY + 1, subtype);
+
+      g_free (type_name);
+    }
+
+    close (video_fd);
+    gst_caps_unref (src_caps);
+    gst_caps_unref (sink_caps);
+  }
+
+  g_free (device);
+
+  return TRUE;
+}
@@ -23,9 +23,11 @@
  *
  * This element captures your X Display and creates raw RGB video.  It uses
  * the XDamage extension if available to only capture areas of the screen that
- * have changed since the last frame.  It uses the XFixes extension if
- * available to also capture your mouse pointer.  By default it will fixate to
- * 25 frames per second.
+ * have changed since the last frame.  These areas are attached to each frame
+ * as "damage" #GstVideoRegionOfInterestMeta, so that downstream can limit
+ * its work to them; a frame without any is identical to the previous one.
+ * It uses the XFixes extension if available to also capture your mouse
+ * pointer.  By default it will fixate to 25 frames per second.
  *
  * <refsect2>
  * <title>Example pipelines</title>
@@ -49,6 +51,7 @@
 #include <gst/gst.h>
 #include <gst/gst-i18n-plugin.h>
 #include <gst/video/video.h>
+#include <gst/video/gstvideometa.h>
 
 #include "gst/glib-compat-private.h"
 
@@ -444,6 +447,57 @@ copy_buffer (GstBuffer * dest, GstBuffer * src)
   gst_buffer_fill (dest, 0, map.data, map.size);
   gst_buffer_unmap (src, &map);
 }
+
+/* clip @rect to the area we capture, FALSE when it is outside of it */
+static gboolean
+gst_ximage_src_clip_rect (GstXImageSrc * ximagesrc, XRectangle * rect)
+{
+  gint startx, starty, endx, endy;
+
+  if (ximagesrc->endx <= ximagesrc->startx ||
+      ximagesrc->endy <= ximagesrc->starty)
+    return TRUE;
+
+  if (rect->x + rect->width - 1 < (gint) ximagesrc->startx ||
+      rect->x > (gint) ximagesrc->endx)
+    return FALSE;
+  if (rect->y + rect->height - 1 < (gint) ximagesrc->starty ||
+      rect->y > (gint) ximagesrc->endy)
+    return FALSE;
+
+  startx = MAX (rect->x, (gint) ximagesrc->startx);
+  starty = MAX (rect->y, (gint) ximagesrc->starty);
+  endx = MIN (rect->x + rect->width - 1, (gint) ximagesrc->endx);
+  endy = MIN (rect->y + rect->height - 1, (gint) ximagesrc->endy);
+
+  rect->x = startx;
+  rect->y = starty;
+  rect->width = endx - startx + 1;
+  rect->height = endy - starty + 1;
+
+  return TRUE;
+}
+
+/* Every frame captured with XDamage lists what changed since the previous
+ * one as "damage" region of interest metas, in frame coordinates. A frame
+ * without any did not change. */
+static void
+gst_ximage_src_add_damage (GstXImageSrc * ximagesrc, GstBuffer * ximage,
+    gint x, gint y, gint width, gint height)
+{
+  gst_buffer_add_video_region_of_interest_meta (ximage, "damage",
+      x - ximagesrc->startx, y - ximagesrc->starty, width, height);
+}
+
+static gboolean
+gst_ximage_src_remove_damage (GstBuffer * ximage, GstMeta ** meta,
+    gpointer user_data)
+{
+  if ((*meta)->info->api == GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE)
+    *meta = NULL;
+
+  return TRUE;
+}
 #endif
 
 /* Retrieve an XImageSrcBuffer, preferably from our
@@ -453,9 +507,29 @@ gst_ximage_src_ximage_get (GstXImageSrc * ximagesrc)
 {
   GstBuffer *ximage = NULL;
   GstMetaXImage *meta;
+#ifdef HAVE_XDAMAGE
+  gboolean in_place = FALSE;
+
+  /* when downstream is done with the last frame, only update its damaged
+   * parts instead of copying all of it into another image */
+  if (ximagesrc->have_xdamage && ximagesrc->use_damage &&
+      ximagesrc->last_ximage != NULL &&
+      gst_buffer_is_writable (ximagesrc->last_ximage)) {
+    meta = GST_META_XIMAGE_GET (ximagesrc->last_ximage);
+
+    if ((meta->width == ximagesrc->width) &&
+        (meta->height == ximagesrc->height)) {
+      GST_LOG_OBJECT (ximagesrc, "updating last frame in place");
+      ximage = ximagesrc->last_ximage;
+      ximagesrc->last_ximage = NULL;
+      GST_BUFFER_FLAGS (ximage) = 0;
+      in_place = TRUE;
+    }
+  }
+#endif
 
   g_mutex_lock (&ximagesrc->pool_lock);
-  while (ximagesrc->buffer_pool != NULL) {
+  while (ximage == NULL && ximagesrc->buffer_pool != NULL) {
     ximage = ximagesrc->buffer_pool->data;
 
     meta = GST_META_XIMAGE_GET (ximage);
@@ -463,6 +537,7 @@ gst_ximage_src_ximage_get (GstXImageSrc * ximagesrc)
     if ((meta->width != ximagesrc->width) ||
         (meta->height != ximagesrc->height)) {
       gst_ximage_buffer_free (ximage);
+      ximage = NULL;
     }
 
     ximagesrc->buffer_pool = g_slist_delete_link (ximagesrc->buffer_pool,
@@ -494,100 +569,89 @@ gst_ximage_src_ximage_get (GstXImageSrc * ximagesrc)
   meta = GST_META_XIMAGE_GET (ximage);
 
 #ifdef HAVE_XDAMAGE
+  /* recycled images still carry the damage of their previous use */
+  if (ximagesrc->have_xdamage && ximagesrc->use_damage)
+    gst_buffer_foreach_meta (ximage, gst_ximage_src_remove_damage, NULL);
+
   if (ximagesrc->have_xdamage && ximagesrc->use_damage &&
-      ximagesrc->last_ximage != NULL) {
+      (in_place || ximagesrc->last_ximage != NULL)) {
     XEvent ev;
-
-    /* have_frame is TRUE when either the entire screen has been
-     * grabbed or when the last image has been copied */
-    gboolean have_frame = FALSE;
+    GArray *damage;
+    guint64 area = 0;
+    gboolean full = FALSE;
+    guint i;
 
     GST_DEBUG_OBJECT (ximagesrc, "Retrieving screen using XDamage");
 
+    /* collect all damaged rectangles first, so that we know how much of the
+     * screen changed */
+    damage = g_array_new (FALSE, FALSE, sizeof (XRectangle));
     do {
       XNextEvent (ximagesrc->xcontext->disp, &ev);
 
       if (ev.type == ximagesrc->damage_event_base + XDamageNotify) {
         XserverRegion parts;
         XRectangle *rects;
-        int nrects;
+        int j, nrects;
 
         parts = XFixesCreateRegion (ximagesrc->xcontext->disp, 0, 0);
         XDamageSubtract (ximagesrc->xcontext->disp, ximagesrc->damage, None,
             parts);
-        /* Now copy out all of the damaged rectangles. */
         rects = XFixesFetchRegion (ximagesrc->xcontext->disp, parts, &nrects);
+        XFixesDestroyRegion (ximagesrc->xcontext->disp, parts);
         if (rects != NULL) {
-          int i;
-
-          if (!have_frame) {
-            GST_LOG_OBJECT (ximagesrc,
-                "Copying from last frame ximage->size: %" G_GSIZE_FORMAT,
-                gst_buffer_get_size (ximage));
-            copy_buffer (ximage, ximagesrc->last_ximage);
-            have_frame = TRUE;
-          }
-          for (i = 0; i < nrects; i++) {
+          for (j = 0; j < nrects; j++) {
             GST_LOG_OBJECT (ximagesrc,
                 "Damaged sub-region @ %d,%d size %dx%d reported",
-                rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+                rects[j].x, rects[j].y, rects[j].width, rects[j].height);
 
             /* if we only want a small area, clip this damage region to
              * area we want */
-            if (ximagesrc->endx > ximagesrc->startx &&
-                ximagesrc->endy > ximagesrc->starty) {
-              /* see if damage area intersects */
-              if (rects[i].x + rects[i].width - 1 < ximagesrc->startx ||
-                  rects[i].x > ximagesrc->endx) {
-                /* trivial reject */
-              } else if (rects[i].y + rects[i].height - 1 < ximagesrc->starty ||
-                  rects[i].y > ximagesrc->endy) {
-                /* trivial reject */
-              } else {
-                /* find intersect region */
-                int startx, starty, width, height;
-
-                startx = (rects[i].x < ximagesrc->startx) ? ximagesrc->startx :
-                    rects[i].x;
-                starty = (rects[i].y < ximagesrc->starty) ? ximagesrc->starty :
-                    rects[i].y;
-                width = (rects[i].x + rects[i].width - 1 < ximagesrc->endx) ?
-                    rects[i].x + rects[i].width - startx :
-                    ximagesrc->endx - startx + 1;
-                height = (rects[i].y + rects[i].height - 1 < ximagesrc->endy) ?
-                    rects[i].y + rects[i].height - starty : ximagesrc->endy -
-                    starty + 1;
-
-                GST_LOG_OBJECT (ximagesrc,
-                    "Retrieving damaged sub-region @ %d,%d size %dx%d as intersect region",
-                    startx, starty, width, height);
-                XGetSubImage (ximagesrc->xcontext->disp, ximagesrc->xwindow,
-                    startx, starty, width, height, AllPlanes, ZPixmap,
-                    meta->ximage, startx - ximagesrc->startx,
-                    starty - ximagesrc->starty);
-              }
-            } else {
-
-              GST_LOG_OBJECT (ximagesrc,
-                  "Retrieving damaged sub-region @ %d,%d size %dx%d",
-                  rects[i].x, rects[i].y, rects[i].width, rects[i].height);
-
-              XGetSubImage (ximagesrc->xcontext->disp, ximagesrc->xwindow,
-                  rects[i].x, rects[i].y,
-                  rects[i].width, rects[i].height,
-                  AllPlanes, ZPixmap, meta->ximage, rects[i].x, rects[i].y);
+            if (gst_ximage_src_clip_rect (ximagesrc, &rects[j])) {
+              area += (guint64) rects[j].width * rects[j].height;
+              g_array_append_val (damage, rects[j]);
             }
           }
           free (rects);
         }
       }
     } while (XPending (ximagesrc->xcontext->disp));
-    if (!have_frame) {
+
+#ifdef HAVE_XSHM
+    /* a single shared memory transfer beats copying the last frame and then
+     * fetching most of it again through the protocol */
+    if (ximagesrc->xcontext->use_xshm &&
+        area * 2 > (guint64) ximagesrc->width * ximagesrc->height) {
+      GST_LOG_OBJECT (ximagesrc, "Retrieving damaged screen using XShm");
+      XShmGetImage (ximagesrc->xcontext->disp, ximagesrc->xwindow,
+          meta->ximage, ximagesrc->startx, ximagesrc->starty, AllPlanes);
+      full = TRUE;
+    }
+#endif /* HAVE_XSHM */
+
+    if (!full && !in_place) {
       GST_LOG_OBJECT (ximagesrc,
           "Copying from last frame ximage->size: %" G_GSIZE_FORMAT,
           gst_buffer_get_size (ximage));
       copy_buffer (ximage, ximagesrc->last_ximage);
     }
+
+    for (i = 0; i < damage->len; i++) {
+      XRectangle *rect = &g_array_index (damage, XRectangle, i);
+
+      if (!full) {
+        GST_LOG_OBJECT (ximagesrc,
+            "Retrieving damaged sub-region @ %d,%d size %dx%d",
+            rect->x, rect->y, rect->width, rect->height);
+        XGetSubImage (ximagesrc->xcontext->disp, ximagesrc->xwindow,
+            rect->x, rect->y, rect->width, rect->height, AllPlanes, ZPixmap,
+            meta->ximage, rect->x - ximagesrc->startx,
+            rect->y - ximagesrc->starty);
+      }
+      gst_ximage_src_add_damage (ximagesrc, ximage, rect->x, rect->y,
+          rect->width, rect->height);
+    }
+    g_array_free (damage, TRUE);
 #ifdef HAVE_XFIXES
     /* re-get area where last mouse pointer was  but only if in our clipping
      * bounds */
@@ -637,12 +701,15 @@ gst_ximage_src_ximage_get (GstXImageSrc * ximagesrc)
               startx, starty, iwidth, iheight, AllPlanes, ZPixmap,
               meta->ximage, startx - ximagesrc->startx,
               starty - ximagesrc->starty);
+          gst_ximage_src_add_damage (ximagesrc, ximage, startx, starty,
+              iwidth, iheight);
         }
       } else {
 
         GST_DEBUG_OBJECT (ximagesrc, "Removing cursor from %d,%d", x, y);
         XGetSubImage (ximagesrc->xcontext->disp, ximagesrc->xwindow,
             x, y, width, height, AllPlanes, ZPixmap, meta->ximage, x, y);
+        gst_ximage_src_add_damage (ximagesrc, ximage, x, y, width, height);
       }
     }
 #endif
@@ -660,19 +727,19 @@ gst_ximage_src_ximage_get (GstXImageSrc * ximagesrc)
     } else
 #endif /* HAVE_XSHM */
     {
-      GST_DEBUG_OBJECT (ximagesrc, "Retrieving screen using XGetImage");
-      if (ximagesrc->remote) {
-        XGetSubImage (ximagesrc->xcontext->disp, ximagesrc->xwindow,
-            ximagesrc->startx, ximagesrc->starty, ximagesrc->width,
-            ximagesrc->height, AllPlanes, ZPixmap, meta->ximage, 0, 0);
-      } else {
-        meta->ximage =
-            XGetImage (ximagesrc->xcontext->disp, ximagesrc->xwindow,
-            ximagesrc->startx, ximagesrc->starty, ximagesrc->width,
-            ximagesrc->height, AllPlanes, ZPixmap);
-      }
+      /* fetch into the image our buffer memory wraps, XGetImage would
+       * allocate a new one every frame and leave the buffer pointing at the
+       * old data */
+      GST_DEBUG_OBJECT (ximagesrc, "Retrieving screen using XGetSubImage");
+      XGetSubImage (ximagesrc->xcontext->disp, ximagesrc->xwindow,
+          ximagesrc->startx, ximagesrc->starty, ximagesrc->width,
+          ximagesrc->height, AllPlanes, ZPixmap, meta->ximage, 0, 0);
     }
 #ifdef HAVE_XDAMAGE
+    /* without a previous frame, all of it is new */
+    if (ximagesrc->have_xdamage && ximagesrc->use_damage)
+      gst_ximage_src_add_damage (ximagesrc, ximage, ximagesrc->startx,
+          ximagesrc->starty, ximagesrc->width, ximagesrc->height);
   }
 #endif
 
@@ -755,6 +822,13 @@ gst_ximage_src_ximage_get (GstXImageSrc * ximagesrc)
                 (guint8 *) src);
           }
         }
+#ifdef HAVE_XDAMAGE
+        if (ximagesrc->have_xdamage && ximagesrc->use_damage)
+          gst_ximage_src_add_damage (ximagesrc, ximage, startx, starty,
+              MIN (iwidth, (gint) (ximagesrc->startx + ximagesrc->width) -
+                  startx), MIN (iheight,
+                  (gint) (ximagesrc->starty + ximagesrc->height) - starty));
+#endif
       }
     }
   }
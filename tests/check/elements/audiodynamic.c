@@ -422,6 +422,55 @@ GST_START_TEST (test_expand_hard_0_200)
 
 GST_END_TEST;
 
+GST_START_TEST (test_compress_hard_50_50_lookahead)
+{
+  GstElement *dynamic;
+  GstBuffer *inbuffer, *outbuffer;
+  GstCaps *caps;
+  gint16 in[8] = { -30000, 24576, -16384, 256, -128, 0, -24576, 30000 };
+  gint16 res[8];
+  gint i;
+
+  dynamic = setup_dynamic ();
+  g_object_set (G_OBJECT (dynamic), "mode", 0, NULL);
+  g_object_set (G_OBJECT (dynamic), "characteristics", 0, NULL);
+  g_object_set (G_OBJECT (dynamic), "ratio", 0.5, NULL);
+  g_object_set (G_OBJECT (dynamic), "threshold", 0.5, NULL);
+  /* longer than the buffer, so all of it is a single block */
+  g_object_set (G_OBJECT (dynamic), "lookahead", (guint64) GST_MSECOND,
+      NULL);
+  fail_unless (gst_element_set_state (dynamic,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  inbuffer = gst_buffer_new_and_alloc (16);
+  gst_buffer_fill (inbuffer, 0, in, 16);
+  caps = gst_caps_from_string (DYNAMIC_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, dynamic, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 1);
+  fail_if ((outbuffer = (GstBuffer *) buffers->data) == NULL);
+
+  fail_unless (gst_buffer_extract (outbuffer, 0, res, 16) == 16);
+
+  /* the peaks are compressed as without lookahead, but the gain is shared by
+   * all samples so the quiet ones are scaled down too */
+  fail_unless (res[0] > in[0]);
+  fail_unless (res[7] < in[7]);
+  fail_unless (res[2] > in[2]);
+  fail_unless (res[3] < in[3]);
+  fail_unless (res[5] == 0);
+  for (i = 0; i < 8; i++)
+    fail_unless (ABS (res[i] - in[i] * ((gdouble) res[7] / in[7])) <= 2.0);
+
+  /* cleanup */
+  cleanup_dynamic (dynamic);
+}
+
+GST_END_TEST;
+
 static Suite *
 dynamic_suite (void)
 {
@@ -436,6 +485,7 @@ dynamic_suite (void)
   tcase_add_test (tc_chain, test_expand_hard_50_200);
   tcase_add_test (tc_chain, test_expand_soft_50_200);
   tcase_add_test (tc_chain, test_expand_hard_0_200);
+  tcase_add_test (tc_chain, test_compress_hard_50_50_lookahead);
   return s;
 }
 
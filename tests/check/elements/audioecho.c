@@ -18,6 +18,10 @@
  * Boston, MA 02110-1301, USA.
  */
 
+/* FIXME 0.11: suppress warnings for deprecated API such as GValueArray
+ * with newer GLib versions (>= 2.31.0) */
+#define GLIB_DISABLE_DEPRECATION_WARNINGS
+
 #include <gst/check/gstcheck.h>
 #include <gst/audio/audio.h>
 
@@ -223,6 +227,72 @@ GST_START_TEST (test_feedback)
 
 GST_END_TEST;
 
+GST_START_TEST (test_taps)
+{
+  GstElement *echo;
+  GstBuffer *inbuffer, *outbuffer;
+  GstCaps *caps;
+  GValueArray *va;
+  GValue v = { 0, };
+  gdouble in[] = { 1.0, -1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, };
+  gdouble out[] = { 1.0, -1.0, 0.0, 0.0, 0.5, -0.5, 0.0, 0.0, 0.25, -0.25 };
+  gdouble res[10];
+
+  echo = setup_echo ();
+  g_object_set (G_OBJECT (echo), "delay", (GstClockTime) 20000, "intensity",
+      0.0, "feedback", 0.0, NULL);
+
+  /* echoes after 2 and 4 frames */
+  va = g_value_array_new (2);
+  g_value_init (&v, G_TYPE_UINT64);
+  g_value_set_uint64 (&v, 20000);
+  g_value_array_append (va, &v);
+  g_value_set_uint64 (&v, 40000);
+  g_value_array_append (va, &v);
+  g_value_unset (&v);
+  g_object_set (G_OBJECT (echo), "tap-delays", va, NULL);
+  g_value_array_free (va);
+
+  va = g_value_array_new (2);
+  g_value_init (&v, G_TYPE_FLOAT);
+  g_value_set_float (&v, 0.5);
+  g_value_array_append (va, &v);
+  g_value_set_float (&v, 0.25);
+  g_value_array_append (va, &v);
+  g_value_unset (&v);
+  g_object_set (G_OBJECT (echo), "tap-intensities", va, NULL);
+  g_value_array_free (va);
+
+  fail_unless (gst_element_set_state (echo,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (ECHO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, echo, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  inbuffer =
+      gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, in, sizeof (in), 0,
+      sizeof (in), NULL, NULL);
+  fail_unless (gst_buffer_memcmp (inbuffer, 0, in, sizeof (in)) == 0);
+  ASSERT_BUFFER_REFCOUNT (inbuffer, "inbuffer", 1);
+
+  /* pushing gives away my reference ... */
+  fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+  /* ... but it ends up being collected on the global buffer list */
+  fail_unless_equals_int (g_list_length (buffers), 1);
+  fail_if ((outbuffer = (GstBuffer *) buffers->data) == NULL);
+
+  fail_unless (gst_buffer_extract (outbuffer, 0, res,
+          sizeof (res)) == sizeof (res));
+  fail_unless (gst_buffer_memcmp (outbuffer, 0, out, sizeof (out)) == 0);
+
+  /* cleanup */
+  cleanup_echo (echo);
+}
+
+GST_END_TEST;
+
 static Suite *
 audioecho_suite (void)
 {
@@ -233,6 +303,7 @@ audioecho_suite (void)
   tcase_add_test (tc_chain, test_passthrough);
   tcase_add_test (tc_chain, test_echo);
   tcase_add_test (tc_chain, test_feedback);
+  tcase_add_test (tc_chain, test_taps);
 
   return s;
 }
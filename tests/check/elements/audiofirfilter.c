@@ -25,6 +25,9 @@
 #include <gst/gst.h>
 #include <gst/check/gstcheck.h>
 
+#include <math.h>
+#include <string.h>
+
 static gboolean have_eos = FALSE;
 
 static gboolean
@@ -177,6 +180,128 @@ GST_START_TEST (test_pipeline)
 
 GST_END_TEST;
 
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+#define AUDIO_FIR_FILTER_FORMAT "F64BE"
+#else
+#define AUDIO_FIR_FILTER_FORMAT "F64LE"
+#endif
+
+#define AUDIO_FIR_FILTER_CAPS_STRING              \
+    "audio/x-raw, "                               \
+    "format = (string) " AUDIO_FIR_FILTER_FORMAT ", " \
+    "layout = (string) interleaved, "             \
+    "channels = (int) 1, "                        \
+    "rate = (int) 44100"
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (AUDIO_FIR_FILTER_CAPS_STRING)
+    );
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (AUDIO_FIR_FILTER_CAPS_STRING)
+    );
+
+#define KERNEL_LENGTH 1000
+#define INPUT_LENGTH 4096
+
+/* The impulse response of a long kernel split into partitions must still
+ * be the kernel itself */
+static void
+check_impulse_response (guint partition_length)
+{
+  GstElement *filter;
+  GstPad *srcpad, *sinkpad;
+  GstBuffer *inbuffer;
+  GstCaps *caps;
+  GstSegment segment;
+  GstMapInfo map;
+  GValueArray *va;
+  GValue v = { 0, };
+  gdouble *in;
+  GList *node;
+  guint i, n = 0;
+
+  filter = gst_check_setup_element ("audiofirfilter");
+  srcpad = gst_check_setup_src_pad (filter, &srctemplate);
+  sinkpad = gst_check_setup_sink_pad (filter, &sinktemplate);
+  gst_pad_set_active (srcpad, TRUE);
+  gst_pad_set_active (sinkpad, TRUE);
+
+  va = g_value_array_new (KERNEL_LENGTH);
+  g_value_init (&v, G_TYPE_DOUBLE);
+  for (i = 0; i < KERNEL_LENGTH; i++) {
+    g_value_set_double (&v, sin (i * 0.1) / (i + 1));
+    g_value_array_append (va, &v);
+  }
+  g_value_unset (&v);
+  g_object_set (G_OBJECT (filter), "partition-length", partition_length,
+      "kernel", va, NULL);
+  g_value_array_free (va);
+
+  fail_unless (gst_element_set_state (filter,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (AUDIO_FIR_FILTER_CAPS_STRING);
+  gst_check_setup_events (srcpad, filter, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_segment (&segment)));
+
+  inbuffer = gst_buffer_new_and_alloc (INPUT_LENGTH * sizeof (gdouble));
+  GST_BUFFER_TIMESTAMP (inbuffer) = 0;
+  gst_buffer_map (inbuffer, &map, GST_MAP_WRITE);
+  in = (gdouble *) map.data;
+  memset (in, 0, map.size);
+  in[0] = 1.0;
+  gst_buffer_unmap (inbuffer, &map);
+
+  fail_unless (gst_pad_push (srcpad, inbuffer) == GST_FLOW_OK);
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_eos ()));
+
+  for (node = buffers; node; node = node->next) {
+    gdouble *res;
+    guint len;
+
+    gst_buffer_map (GST_BUFFER (node->data), &map, GST_MAP_READ);
+    res = (gdouble *) map.data;
+    len = map.size / sizeof (gdouble);
+    for (i = 0; i < len; i++, n++) {
+      gdouble expected = n < KERNEL_LENGTH ? sin (n * 0.1) / (n + 1) : 0.0;
+
+      fail_unless (fabs (res[i] - expected) < 1e-9,
+          "sample %u: %lf != %lf (partition length %u)", n, res[i],
+          expected, partition_length);
+    }
+    gst_buffer_unmap (GST_BUFFER (node->data), &map);
+  }
+  fail_unless_equals_int (n, INPUT_LENGTH);
+
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+
+  gst_pad_set_active (srcpad, FALSE);
+  gst_pad_set_active (sinkpad, FALSE);
+  gst_check_teardown_src_pad (filter);
+  gst_check_teardown_sink_pad (filter);
+  gst_check_teardown_element (filter);
+}
+
+GST_START_TEST (test_partitioned)
+{
+  check_impulse_response (0);
+  check_impulse_response (64);
+  check_impulse_response (300);
+  check_impulse_response (2048);
+}
+
+GST_END_TEST;
+
 static Suite *
 audiofirfilter_suite (void)
 {
@@ -185,6 +310,7 @@ audiofirfilter_suite (void)
 
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_pipeline);
+  tcase_add_test (tc_chain, test_partitioned);
 
   return s;
 }
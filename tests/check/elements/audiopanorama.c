@@ -545,6 +545,38 @@ GST_START_TEST (test_f32_stereo_right)
 
 GST_END_TEST;
 
+GST_START_TEST (test_f32_stereo_smoothing)
+{
+  gfloat in[4] = { 0.5, -0.2, 0.25, 0.1 };
+  /* fades from the middle to the right over the second buffer */
+  gfloat out[4] = { 0.25, -0.2 + 0.25, 0.0, 0.1 + 0.25 };
+  gfloat res[4];
+  GstElement *panorama = setup_panorama_f32_s (0, 0.0);
+  gint i;
+
+  g_object_set (G_OBJECT (panorama), "smoothing", TRUE, NULL);
+
+  do_panorama (in, sizeof (in), res, sizeof (res));
+  for (i = 0; i < 4; i++)
+    fail_unless (res[i] == in[i], "difference at pos=%d", i);
+
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+
+  g_object_set (G_OBJECT (panorama), "panorama", 1.0, NULL);
+  do_panorama (in, sizeof (in), res, sizeof (res));
+
+  GST_INFO ("exp. %+4.2f %+4.2f %+4.2f %+4.2f", out[0], out[1], out[2], out[3]);
+  GST_INFO ("real %+4.2f %+4.2f %+4.2f %+4.2f", res[0], res[1], res[2], res[3]);
+  for (i = 0; i < 4; i++)
+    fail_unless (ABS (res[i] - out[i]) < 1e-6, "difference at pos=%d", i);
+
+  cleanup_panorama (panorama);
+}
+
+GST_END_TEST;
+
 /* processing for method=simple */
 
 GST_START_TEST (test_s16_mono_middle_simple)
@@ -798,6 +830,7 @@ panorama_suite (void)
   tcase_add_test (tc_chain, test_f32_stereo_middle);
   tcase_add_test (tc_chain, test_f32_stereo_left);
   tcase_add_test (tc_chain, test_f32_stereo_right);
+  tcase_add_test (tc_chain, test_f32_stereo_smoothing);
   /* processing for method=simple */
   tcase_add_test (tc_chain, test_s16_mono_middle_simple);
   tcase_add_test (tc_chain, test_s16_mono_left_simple);
@@ -265,6 +265,61 @@ GST_START_TEST (test_unsync_v24)
 
 GST_END_TEST;
 
+GST_START_TEST (test_skip_binary_frames)
+{
+  GstElement *pipeline, *src;
+  GstTagList *tags = NULL;
+  const GstStructure *s;
+  GstMessage *msg;
+  GstBus *bus;
+  guint64 offset;
+  guint size;
+  gchar *path, *title = NULL;
+
+  pipeline = gst_parse_launch ("filesrc name=src ! id3demux "
+      "skip-binary-frames=true ! fakesink", NULL);
+  fail_unless (pipeline != NULL);
+
+  path = g_build_filename (GST_TEST_FILES_PATH,
+      "id3-588148-unsynced-v24.tag", NULL);
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  g_object_set (src, "location", path, NULL);
+  gst_object_unref (src);
+  g_free (path);
+
+  bus = gst_element_get_bus (pipeline);
+  fail_if (gst_element_set_state (pipeline, GST_STATE_PAUSED) ==
+      GST_STATE_CHANGE_FAILURE);
+
+  /* the APIC frame follows eight text frames with 72 bytes of content */
+  msg = gst_bus_poll (bus, GST_MESSAGE_ELEMENT, -1);
+  s = gst_message_get_structure (msg);
+  fail_unless (gst_structure_has_name (s, "id3demux-skipped-frame"));
+  fail_unless_equals_string (gst_structure_get_string (s, "frame-id"),
+      "APIC");
+  fail_unless (gst_structure_get_uint64 (s, "offset", &offset));
+  fail_unless_equals_uint64 (offset, 10 + 8 * 10 + 72);
+  fail_unless (gst_structure_get_uint (s, "size", &size));
+  fail_unless_equals_int (size, 10 + 38216);
+  gst_message_unref (msg);
+
+  msg = gst_bus_poll (bus, GST_MESSAGE_TAG, -1);
+  gst_message_parse_tag (msg, &tags);
+  gst_message_unref (msg);
+
+  fail_unless (gst_tag_list_get_string (tags, GST_TAG_TITLE, &title));
+  fail_unless_equals_string (title, "Starlight");
+  g_free (title);
+  fail_unless (gst_tag_list_get_value_index (tags, GST_TAG_IMAGE, 0) == NULL);
+  gst_tag_list_unref (tags);
+
+  gst_object_unref (bus);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
 static Suite *
 id3demux_suite (void)
 {
@@ -276,6 +331,7 @@ id3demux_suite (void)
   tcase_add_test (tc_chain, test_wcop);
   tcase_add_test (tc_chain, test_unsync_v23);
   tcase_add_test (tc_chain, test_unsync_v24);
+  tcase_add_test (tc_chain, test_skip_binary_frames);
 
   return s;
 }
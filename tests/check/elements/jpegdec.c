@@ -78,6 +78,67 @@ GST_START_TEST (test_jpegdec_explicit)
 
 GST_END_TEST;
 
+static GstBuffer *
+decode_image (guint n_threads)
+{
+  GstElement *pipeline, *source, *dec, *sink;
+  GstSample *sample;
+  GstBuffer *buffer;
+  gchar *filename;
+
+  pipeline = gst_pipeline_new (NULL);
+  source = gst_element_factory_make ("filesrc", NULL);
+  dec = gst_element_factory_make ("jpegdec", NULL);
+  sink = gst_element_factory_make ("appsink", NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), source, dec, sink, NULL);
+  gst_element_link_many (source, dec, sink, NULL);
+
+  filename = g_build_filename (GST_TEST_FILES_PATH, "image.jpg", NULL);
+  g_object_set (G_OBJECT (source), "location", filename, NULL);
+  g_free (filename);
+  g_object_set (G_OBJECT (dec), "n-threads", n_threads, NULL);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  sample = gst_app_sink_pull_sample (GST_APP_SINK (sink));
+  fail_unless (GST_IS_SAMPLE (sample));
+  buffer = gst_buffer_ref (gst_sample_get_buffer (sample));
+  gst_sample_unref (sample);
+
+  /* the pending frame must be output at EOS */
+  sample = gst_app_sink_pull_sample (GST_APP_SINK (sink));
+  fail_unless (sample == NULL);
+  fail_unless (gst_app_sink_is_eos (GST_APP_SINK (sink)));
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return buffer;
+}
+
+/* Verify decoding in other threads gives the same picture */
+GST_START_TEST (test_jpegdec_threads)
+{
+  GstBuffer *expected, *buffer;
+  GstMapInfo expected_map, map;
+
+  expected = decode_image (1);
+  buffer = decode_image (4);
+
+  gst_buffer_map (expected, &expected_map, GST_MAP_READ);
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  fail_unless_equals_int (map.size, expected_map.size);
+  fail_unless (memcmp (map.data, expected_map.data, map.size) == 0);
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unmap (expected, &expected_map);
+
+  gst_buffer_unref (buffer);
+  gst_buffer_unref (expected);
+}
+
+GST_END_TEST;
+
 /* Verify JPEG discovery is working. Right now jpegdec would be used,
  * but I have no idea how to actually verify this. */
 GST_START_TEST (test_jpegdec_discover)
@@ -134,6 +195,7 @@ jpegdec_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_jpegdec_explicit);
   tcase_add_test (tc_chain, test_jpegdec_discover);
+  tcase_add_test (tc_chain, test_jpegdec_threads);
 
   return s;
 }
@@ -0,0 +1,195 @@
+/* GStreamer
+ *
+ * unit test for latencyprobe
+ *
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstPad *mysrcpad, *mysinkpad, *myendsrcpad, *myendsinkpad;
+
+static GstFlowReturn
+drop_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  gst_buffer_unref (buffer);
+  return GST_FLOW_OK;
+}
+
+static GstPad *
+setup_pad (GstElement * element, GstStaticPadTemplate * templ,
+    const gchar * name)
+{
+  GstPad *pad, *elpad;
+
+  pad = gst_pad_new_from_static_template (templ, templ->name_template);
+  elpad = gst_element_get_static_pad (element, name);
+  fail_unless (elpad != NULL);
+
+  if (GST_PAD_IS_SRC (pad)) {
+    fail_unless (gst_pad_link (pad, elpad) == GST_PAD_LINK_OK);
+  } else {
+    gst_pad_set_chain_function (pad, drop_chain);
+    fail_unless (gst_pad_link (elpad, pad) == GST_PAD_LINK_OK);
+  }
+  gst_object_unref (elpad);
+  gst_pad_set_active (pad, TRUE);
+
+  return pad;
+}
+
+static GstElement *
+setup_latencyprobe (void)
+{
+  GstElement *probe;
+  GstSegment segment;
+
+  probe = gst_check_setup_element ("latencyprobe");
+  g_object_set (probe, "interval", (guint64) 0, NULL);
+
+  mysrcpad = setup_pad (probe, &srctemplate, "sink");
+  mysinkpad = setup_pad (probe, &sinktemplate, "src");
+  myendsrcpad = setup_pad (probe, &srctemplate, "end_sink");
+  myendsinkpad = setup_pad (probe, &sinktemplate, "end_src");
+
+  fail_unless (gst_element_set_state (probe,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (mysrcpad, gst_event_new_stream_start ("start"));
+  gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment));
+  gst_pad_push_event (myendsrcpad, gst_event_new_stream_start ("end"));
+  gst_pad_push_event (myendsrcpad, gst_event_new_segment (&segment));
+
+  return probe;
+}
+
+static void
+cleanup_latencyprobe (GstElement * probe)
+{
+  fail_unless (gst_element_set_state (probe,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+
+  gst_object_unref (mysrcpad);
+  gst_object_unref (mysinkpad);
+  gst_object_unref (myendsrcpad);
+  gst_object_unref (myendsinkpad);
+  gst_check_teardown_element (probe);
+}
+
+static void
+push_ts (GstPad * pad, GstClockTime ts)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_PTS (buffer) = ts;
+  fail_unless (gst_pad_push (pad, buffer) == GST_FLOW_OK);
+}
+
+static void
+check_stats (GstElement * probe, guint64 count, guint64 unmatched)
+{
+  GstStructure *s;
+  guint64 val, min, max, p50, p999;
+
+  g_object_get (probe, "stats", &s, NULL);
+  fail_unless (s != NULL);
+
+  fail_unless (gst_structure_get_uint64 (s, "count", &val));
+  fail_unless_equals_uint64 (val, count);
+  fail_unless (gst_structure_get_uint64 (s, "unmatched", &val));
+  fail_unless_equals_uint64 (val, unmatched);
+
+  if (count > 0) {
+    fail_unless (gst_structure_get_uint64 (s, "min", &min));
+    fail_unless (gst_structure_get_uint64 (s, "max", &max));
+    fail_unless (gst_structure_get_uint64 (s, "p50", &p50));
+    fail_unless (gst_structure_get_uint64 (s, "p999", &p999));
+    fail_unless (min <= p50);
+    fail_unless (p50 <= p999);
+    fail_unless (p999 <= max);
+  }
+
+  gst_structure_free (s);
+}
+
+GST_START_TEST (test_matched)
+{
+  GstElement *probe;
+  gint i;
+
+  probe = setup_latencyprobe ();
+
+  for (i = 0; i < 100; i++) {
+    push_ts (mysrcpad, i * GST_MSECOND);
+    push_ts (myendsrcpad, i * GST_MSECOND);
+  }
+  check_stats (probe, 100, 0);
+
+  cleanup_latencyprobe (probe);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_reordered)
+{
+  GstElement *probe;
+
+  probe = setup_latencyprobe ();
+
+  push_ts (mysrcpad, 0);
+  push_ts (mysrcpad, GST_MSECOND);
+  push_ts (mysrcpad, 2 * GST_MSECOND);
+  push_ts (myendsrcpad, 2 * GST_MSECOND);
+  push_ts (myendsrcpad, 0);
+  push_ts (myendsrcpad, GST_MSECOND);
+  check_stats (probe, 3, 0);
+
+  /* never seen at the start point */
+  push_ts (myendsrcpad, 3 * GST_MSECOND);
+  check_stats (probe, 3, 1);
+
+  cleanup_latencyprobe (probe);
+}
+
+GST_END_TEST;
+
+static Suite *
+latencyprobe_suite (void)
+{
+  Suite *s = suite_create ("latencyprobe");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_matched);
+  tcase_add_test (tc_chain, test_reordered);
+
+  return s;
+}
+
+GST_CHECK_MAIN (latencyprobe);
@@ -301,6 +301,64 @@ GST_START_TEST (test_int16)
 
 GST_END_TEST;
 
+GST_START_TEST (test_int16_packed)
+{
+  GstElement *level;
+  GstBuffer *inbuffer, *outbuffer;
+  GstBus *bus;
+  GstMessage *message;
+  const GstStructure *structure;
+  GBytes *bytes;
+  const gdouble *levels;
+  gsize size;
+  gint i;
+
+  level = setup_level (LEVEL_S16_CAPS_STRING);
+  g_object_set (level, "post-messages", TRUE, "packed-messages", TRUE,
+      "interval", GST_SECOND / 10, NULL);
+  gst_element_set_state (level, GST_STATE_PLAYING);
+  /* create a bus to get the level message on */
+  bus = gst_bus_new ();
+  gst_element_set_bus (level, bus);
+
+  /* create a fake 0.1 sec buffer with a half-amplitude block signal */
+  inbuffer = create_s16_buffer (16536, 16536);
+
+  fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 1);
+  fail_if ((outbuffer = (GstBuffer *) buffers->data) == NULL);
+  fail_unless (inbuffer == outbuffer);
+
+  message = gst_bus_poll (bus, GST_MESSAGE_ELEMENT, -1);
+  structure = gst_message_get_structure (message);
+
+  fail_if (gst_structure_has_field (structure, "rms"));
+  fail_unless (gst_structure_get (structure, "levels", G_TYPE_BYTES, &bytes,
+          NULL));
+  levels = g_bytes_get_data (bytes, &size);
+  fail_unless_equals_int (size, 2 * 3 * sizeof (gdouble));
+
+  /* block wave of half amplitude has -5.94 dB for rms, peak and decay */
+  for (i = 0; i < 2 * 3; ++i) {
+    GST_DEBUG ("level %d is %lf", i, levels[i]);
+    fail_if (levels[i] < -6.1);
+    fail_if (levels[i] > -5.9);
+  }
+  g_bytes_unref (bytes);
+
+  /* clean up */
+  /* flush current messages,and future state change messages */
+  gst_bus_set_flushing (bus, TRUE);
+  gst_message_unref (message);
+  gst_element_set_bus (level, NULL);
+  gst_object_unref (bus);
+  gst_buffer_unref (outbuffer);
+  gst_element_set_state (level, GST_STATE_NULL);
+  cleanup_level (level);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_int16_panned)
 {
   GstElement *level;
@@ -592,6 +650,7 @@ level_suite (void)
   tcase_add_test (tc_chain, test_ref_counts);
   tcase_add_test (tc_chain, test_message_is_valid);
   tcase_add_test (tc_chain, test_int16);
+  tcase_add_test (tc_chain, test_int16_packed);
   tcase_add_test (tc_chain, test_int16_panned);
   tcase_add_test (tc_chain, test_float);
   tcase_add_test (tc_chain, test_message_on_eos);
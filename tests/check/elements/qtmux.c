@@ -888,6 +888,94 @@ GST_START_TEST (test_average_bitrate)
 
 GST_END_TEST;
 
+GST_START_TEST (test_reserved_moov)
+{
+  gchar *location;
+  GstElement *qtmux;
+  GstElement *filesink;
+  GstBuffer *inbuffer;
+  GstCaps *caps;
+  GstSegment segment;
+  gchar *contents = NULL;
+  gsize length = 0, pos;
+  guint32 atom_size;
+  int i;
+
+  location = g_strdup_printf ("%s/%s-%d", g_get_tmp_dir (), "qtmuxtest",
+      g_random_int ());
+  qtmux = gst_check_setup_element ("qtmux");
+  g_object_set (qtmux, "reserved-max-duration", 60 * GST_SECOND, NULL);
+  filesink = gst_element_factory_make ("filesink", NULL);
+  g_object_set (filesink, "location", location, NULL);
+  gst_element_link (qtmux, filesink);
+  mysrcpad = setup_src_pad (qtmux, &srcvideoh264template, "video_%u");
+  fail_unless (mysrcpad != NULL);
+  gst_pad_set_active (mysrcpad, TRUE);
+
+  fail_unless (gst_element_set_state (filesink,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE,
+      "could not set filesink to playing");
+  fail_unless (gst_element_set_state (qtmux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  gst_pad_push_event (mysrcpad, gst_event_new_stream_start ("test"));
+
+  caps = gst_pad_get_pad_template_caps (mysrcpad);
+  gst_pad_set_caps (mysrcpad, caps);
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment)));
+
+  for (i = 0; i < 10; i++) {
+    inbuffer = gst_buffer_new_and_alloc (16);
+    gst_buffer_memset (inbuffer, 0, 0, 16);
+    GST_BUFFER_TIMESTAMP (inbuffer) = i * 40 * GST_MSECOND;
+    GST_BUFFER_DURATION (inbuffer) = 40 * GST_MSECOND;
+    fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+  }
+
+  /* send eos to have moov written */
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()) == TRUE);
+
+  gst_element_set_state (qtmux, GST_STATE_NULL);
+  gst_element_set_state (filesink, GST_STATE_NULL);
+
+  gst_pad_set_active (mysrcpad, FALSE);
+  teardown_src_pad (mysrcpad);
+  gst_object_unref (filesink);
+  gst_check_teardown_element (qtmux);
+
+  /* expect ftyp, moov written into the reserved space, free padding, mdat */
+  fail_unless (g_file_get_contents (location, &contents, &length, NULL));
+  fail_unless (length > 8);
+  pos = GST_READ_UINT32_BE (contents);
+  fail_unless (pos + 8 <= length);
+  fail_unless (memcmp (contents + pos + 4, "moov", 4) == 0);
+  pos += GST_READ_UINT32_BE (contents + pos);
+  fail_unless (pos + 8 <= length);
+  while (pos + 8 <= length && memcmp (contents + pos + 4, "free", 4) == 0) {
+    atom_size = GST_READ_UINT32_BE (contents + pos);
+    fail_unless (atom_size >= 8);
+    pos += atom_size;
+  }
+  fail_unless (pos + 8 <= length);
+  fail_unless (memcmp (contents + pos + 4, "mdat", 4) == 0);
+  /* and nothing after the media data */
+  atom_size = GST_READ_UINT32_BE (contents + pos);
+  if (atom_size == 1)
+    fail_unless (pos + GST_READ_UINT64_BE (contents + pos + 8) == length);
+  else
+    fail_unless (pos + atom_size == length);
+
+  g_free (contents);
+  g_unlink (location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
 
 static Suite *
 qtmux_suite (void)
@@ -918,6 +1006,7 @@ qtmux_suite (void)
   tcase_add_test (tc_chain, test_audio_pad_frag_asc_streamable);
 
   tcase_add_test (tc_chain, test_average_bitrate);
+  tcase_add_test (tc_chain, test_reserved_moov);
 
   tcase_add_test (tc_chain, test_reuse);
   tcase_add_test (tc_chain, test_encodebin_qtmux);
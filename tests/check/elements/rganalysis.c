@@ -1227,6 +1227,61 @@ GST_START_TEST (test_gain_album)
 
 GST_END_TEST;
 
+/* Same album as above, but every track is analyzed by its own element and in
+ * a different order.  The elements share the album result by album-id. */
+
+GST_START_TEST (test_gain_album_shared)
+{
+  static const struct
+  {
+    gint n_buffers;
+    gdouble amplitude;
+    gdouble gain;
+  } tracks[] = {
+    {
+    180, 0.25, -6.20}, {
+    8, 0.75, -15.70}, {
+    12, 0.5, -12.22}
+  };
+  GstElement *element;
+  GstTagList *tag_list;
+  gint accumulator;
+  gint num_tracks;
+  gint i, j;
+
+  for (j = 0; j < G_N_ELEMENTS (tracks); j++) {
+    element = setup_rganalysis ();
+    g_object_set (element, "num-tracks", 3, "album-id", "test-album", NULL);
+    set_playing_state (element);
+
+    send_stream_start_event (element);
+    send_caps_event (GST_AUDIO_NE (F32), 44100, 2);
+    send_segment_event (element);
+    accumulator = 0;
+    for (i = tracks[j].n_buffers; i--;)
+      push_buffer (test_buffer_square_float_stereo (&accumulator, 44100, 512,
+              tracks[j].amplitude, tracks[j].amplitude));
+    send_eos_event (element);
+    tag_list = poll_tags_followed_by_eos (element);
+    fail_unless_track_peak (tag_list, tracks[j].amplitude);
+    fail_unless_track_gain (tag_list, tracks[j].gain);
+    if (j < G_N_ELEMENTS (tracks) - 1) {
+      fail_if_album_tags (tag_list);
+    } else {
+      fail_unless_album_peak (tag_list, 0.75);
+      fail_unless_album_gain (tag_list, -12.18);
+    }
+    gst_tag_list_unref (tag_list);
+
+    g_object_get (element, "num-tracks", &num_tracks, NULL);
+    fail_unless_equals_int (num_tracks, G_N_ELEMENTS (tracks) - 1 - j);
+
+    cleanup_rganalysis (element);
+  }
+}
+
+GST_END_TEST;
+
 /* Checks ensuring that the "forced" property works as advertised. */
 
 GST_START_TEST (test_forced)
@@ -1920,6 +1975,7 @@ rganalysis_suite (void)
   tcase_add_test (tc_chain, test_peak_album_abort_to_track);
 
   tcase_add_test (tc_chain, test_gain_album);
+  tcase_add_test (tc_chain, test_gain_album_shared);
 
   tcase_add_test (tc_chain, test_forced);
   tcase_add_test (tc_chain, test_forced_separate);
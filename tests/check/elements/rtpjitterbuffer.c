@@ -294,6 +294,62 @@ GST_START_TEST (test_push_unordered)
 
 GST_END_TEST;
 
+static gint num_lists = 0;
+
+static GstFlowReturn
+chain_list_func (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  guint i, len;
+
+  len = gst_buffer_list_length (list);
+  GST_DEBUG ("got list of %u buffers", len);
+
+  g_mutex_lock (&check_mutex);
+  for (i = 0; i < len; i++)
+    buffers = g_list_append (buffers,
+        gst_buffer_ref (gst_buffer_list_get (list, i)));
+  num_lists++;
+  g_cond_signal (&check_cond);
+  g_mutex_unlock (&check_mutex);
+
+  gst_buffer_list_unref (list);
+
+  return GST_FLOW_OK;
+}
+
+GST_START_TEST (test_push_list)
+{
+  GstElement *jitterbuffer;
+  const guint num_buffers = 4;
+  GstBuffer *buffer;
+  GList *node;
+
+  jitterbuffer = setup_jitterbuffer (num_buffers);
+  gst_pad_set_chain_list_function (mysinkpad, chain_list_func);
+  num_lists = 0;
+  fail_unless (start_jitterbuffer (jitterbuffer)
+      == GST_STATE_CHANGE_SUCCESS, "could not set to playing");
+
+  /* push buffers: 0,3,2,1, the last ones are queued until 1 arrives and
+   * should come out in a list */
+  buffer = (GstBuffer *) inbuffers->data;
+  fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  for (node = g_list_last (inbuffers); node != inbuffers;
+      node = g_list_previous (node)) {
+    buffer = (GstBuffer *) node->data;
+    fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  }
+
+  /* check the buffer list */
+  check_jitterbuffer_results (jitterbuffer, num_buffers);
+  fail_unless (num_lists > 0);
+
+  /* cleanup */
+  cleanup_jitterbuffer (jitterbuffer);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_basetime)
 {
   GstElement *jitterbuffer;
@@ -1336,6 +1392,7 @@ rtpjitterbuffer_suite (void)
   tcase_add_test (tc_chain, test_push_forward_seq);
   tcase_add_test (tc_chain, test_push_backward_seq);
   tcase_add_test (tc_chain, test_push_unordered);
+  tcase_add_test (tc_chain, test_push_list);
   tcase_add_test (tc_chain, test_basetime);
   tcase_add_test (tc_chain, test_clear_pt_map);
   tcase_add_test (tc_chain, test_only_one_lost_event_on_large_gaps);
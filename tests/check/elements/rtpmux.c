@@ -241,6 +241,78 @@ GST_START_TEST (test_rtpmux_basic)
 
 GST_END_TEST;
 
+GST_START_TEST (test_rtpmux_buffer_list)
+{
+  GstElement *rtpmux;
+  GstPad *reqpad, *src, *sink;
+  GstBufferList *list;
+  GstCaps *caps;
+  GstSegment segment;
+  GList *l;
+  gint i;
+
+  rtpmux = gst_check_setup_element ("rtpmux");
+  g_object_set (rtpmux, "seqnum-offset", 100, "ssrc", 55, NULL);
+
+  reqpad = gst_element_get_request_pad (rtpmux, "sink_%u");
+  fail_unless (reqpad != NULL);
+  src = gst_pad_new_from_static_template (&srctemplate, "src");
+  fail_unless (gst_pad_link (src, reqpad) == GST_PAD_LINK_OK);
+  sink = gst_check_setup_sink_pad_by_name (rtpmux, &sinktemplate, "src");
+
+  fail_unless (gst_element_set_state (rtpmux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS);
+  gst_pad_set_active (sink, TRUE);
+  gst_pad_set_active (src, TRUE);
+
+  fail_unless (gst_pad_push_event (src, gst_event_new_stream_start ("s")));
+  caps = gst_caps_new_simple ("application/x-rtp",
+      "payload", G_TYPE_INT, 98, "clock-rate", G_TYPE_INT, 90000, NULL);
+  fail_unless (gst_pad_set_caps (src, caps));
+  gst_caps_unref (caps);
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (src, gst_event_new_segment (&segment)));
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 3; i++) {
+    GstRTPBuffer rtpbuffer = GST_RTP_BUFFER_INIT;
+    GstBuffer *inbuf = gst_rtp_buffer_new_allocate (10, 0, 0);
+
+    gst_rtp_buffer_map (inbuf, GST_MAP_WRITE, &rtpbuffer);
+    gst_rtp_buffer_set_payload_type (&rtpbuffer, 98);
+    gst_rtp_buffer_set_ssrc (&rtpbuffer, 44);
+    gst_rtp_buffer_set_seq (&rtpbuffer, 2000 + i);
+    gst_rtp_buffer_unmap (&rtpbuffer);
+    gst_buffer_list_add (list, inbuf);
+  }
+  fail_unless (gst_pad_push_list (src, list) == GST_FLOW_OK);
+
+  /* all buffers of the list come out, renumbered */
+  fail_unless_equals_int (g_list_length (buffers), 3);
+  for (l = buffers, i = 0; l; l = l->next, i++) {
+    GstRTPBuffer rtpbuffer = GST_RTP_BUFFER_INIT;
+
+    gst_rtp_buffer_map (l->data, GST_MAP_READ, &rtpbuffer);
+    fail_unless_equals_int (gst_rtp_buffer_get_ssrc (&rtpbuffer), 55);
+    fail_unless_equals_int (gst_rtp_buffer_get_seq (&rtpbuffer), 101 + i);
+    gst_rtp_buffer_unmap (&rtpbuffer);
+  }
+  gst_check_drop_buffers ();
+
+  gst_pad_set_active (sink, FALSE);
+  gst_pad_set_active (src, FALSE);
+  fail_unless (gst_element_set_state (rtpmux,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+  gst_check_teardown_pad_by_name (rtpmux, "src");
+  gst_pad_unlink (src, reqpad);
+  gst_object_unref (src);
+  gst_element_release_request_pad (rtpmux, reqpad);
+  gst_object_unref (reqpad);
+  gst_check_teardown_element (rtpmux);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_rtpdtmfmux_basic)
 {
   test_basic ("rtpdtmfmux", "sink_2", 10, basic_check_cb);
@@ -300,6 +372,7 @@ rtpmux_suite (void)
 
   tc_chain = tcase_create ("rtpmux_basic");
   tcase_add_test (tc_chain, test_rtpmux_basic);
+  tcase_add_test (tc_chain, test_rtpmux_buffer_list);
   suite_add_tcase (s, tc_chain);
 
   tc_chain = tcase_create ("rtpdtmfmux_basic");
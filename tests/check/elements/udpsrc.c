@@ -19,6 +19,7 @@
 #include <gst/check/gstcheck.h>
 #include <gio/gio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -109,6 +110,75 @@ GST_START_TEST (test_udpsrc_empty_packet)
 
 GST_END_TEST;
 
+GST_START_TEST (test_udpsrc_batched)
+{
+  GstElement *udpsrc;
+  GSocket *socket;
+  GstPad *sinkpad;
+  int port = 0;
+
+  udpsrc = gst_check_setup_element ("udpsrc");
+  fail_unless (udpsrc != NULL);
+  g_object_set (udpsrc, "port", 0, "batch-size", 8, "mtu", 1500, NULL);
+
+  sinkpad = gst_check_setup_sink_pad_by_name (udpsrc, &sinktemplate, "src");
+  fail_unless (sinkpad != NULL);
+  gst_pad_set_active (sinkpad, TRUE);
+
+  gst_element_set_state (udpsrc, GST_STATE_PLAYING);
+  g_object_get (udpsrc, "port", &port, NULL);
+  GST_INFO ("udpsrc port = %d", port);
+
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+
+  if (socket != NULL) {
+    GSocketAddress *sa;
+    GInetAddress *ia;
+    gchar data[12];
+    gint i;
+
+    ia = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+    sa = g_inet_socket_address_new (ia, port);
+
+    /* more packets than fit in one batch */
+    for (i = 0; i < 20; i++) {
+      g_snprintf (data, sizeof (data), "packet%02d", i);
+      fail_unless (g_socket_send_to (socket, sa, data, 9, NULL, NULL) == 9);
+    }
+
+    g_usleep (G_USEC_PER_SEC / 2);
+
+    fail_unless_equals_int (g_list_length (buffers), 20);
+
+    for (i = 0; i < 20; i++) {
+      GstBuffer *buf = GST_BUFFER (g_list_nth_data (buffers, i));
+      GstMapInfo map;
+
+      g_snprintf (data, sizeof (data), "packet%02d", i);
+      gst_buffer_map (buf, &map, GST_MAP_READ);
+      fail_unless_equals_int (map.size, 9);
+      fail_unless (memcmp (map.data, data, 9) == 0);
+      gst_buffer_unmap (buf, &map);
+    }
+
+    g_object_unref (sa);
+    g_object_unref (ia);
+  } else {
+    GST_WARNING ("Could not create IPv4 UDP socket for unit test");
+  }
+
+  gst_element_set_state (udpsrc, GST_STATE_NULL);
+
+  gst_check_teardown_pad_by_name (udpsrc, "src");
+  gst_check_teardown_element (udpsrc);
+
+  if (socket)
+    g_object_unref (socket);
+}
+
+GST_END_TEST;
+
 static Suite *
 udpsrc_suite (void)
 {
@@ -117,6 +187,7 @@ udpsrc_suite (void)
 
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_udpsrc_empty_packet);
+  tcase_add_test (tc_chain, test_udpsrc_batched);
   return s;
 }
 
@@ -49,15 +49,28 @@ static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS (VIDEO_CAPS_STRING));
 
+/* odd width, so the default layout has padding that y4m doesn't have */
+#define PADDED_CAPS_STRING "video/x-raw, " \
+                           "format = (string) I420, "\
+                           "width = (int) 10, " \
+                           "height = (int) 2, " \
+                           "framerate = (fraction) 25/1, " \
+                           "pixel-aspect-ratio = (fraction) 1/1"
+
+static GstStaticPadTemplate paddedtemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (PADDED_CAPS_STRING));
+
 
 static GstElement *
-setup_y4menc (void)
+setup_y4menc (GstStaticPadTemplate * srctmpl)
 {
   GstElement *y4menc;
 
   GST_DEBUG ("setup_y4menc");
   y4menc = gst_check_setup_element ("y4menc");
-  mysrcpad = gst_check_setup_src_pad (y4menc, &srctemplate);
+  mysrcpad = gst_check_setup_src_pad (y4menc, srctmpl);
   mysinkpad = gst_check_setup_sink_pad (y4menc, &sinktemplate);
   gst_pad_set_active (mysrcpad, TRUE);
   gst_pad_set_active (mysinkpad, TRUE);
@@ -88,7 +101,7 @@ GST_START_TEST (test_y4m)
   const gchar *data1 = "YUV4MPEG2 C420 W384 H288 Ip F25:1 A1:1\n";
   const gchar *data2 = "FRAME\n";
 
-  y4menc = setup_y4menc ();
+  y4menc = setup_y4menc (&srctemplate);
   fail_unless (gst_element_set_state (y4menc,
           GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
       "could not set to playing");
@@ -153,6 +166,61 @@ GST_START_TEST (test_y4m)
 
 GST_END_TEST;
 
+GST_START_TEST (test_y4m_repack)
+{
+  GstElement *y4menc;
+  GstBuffer *inbuffer, *outbuffer;
+  GstCaps *caps;
+  GstMapInfo map;
+  const gchar *header = "YUV4MPEG2 C420 W10 H2 Ip F25:1 A1:1\nFRAME\n";
+  guint8 *data;
+  gsize hlen = strlen (header);
+  gint i;
+
+  y4menc = setup_y4menc (&paddedtemplate);
+  fail_unless (gst_element_set_state (y4menc,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (PADDED_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, y4menc, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  /* default layout: Y stride 12, U and V stride 8, the padding is 0xff */
+  inbuffer = gst_buffer_new_and_alloc (12 * 2 + 8 + 8);
+  gst_buffer_map (inbuffer, &map, GST_MAP_WRITE);
+  memset (map.data, 0xff, map.size);
+  memset (map.data, 1, 10);
+  memset (map.data + 12, 2, 10);
+  memset (map.data + 24, 3, 5);
+  memset (map.data + 32, 4, 5);
+  gst_buffer_unmap (inbuffer, &map);
+  GST_BUFFER_TIMESTAMP (inbuffer) = 0;
+
+  fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 1);
+
+  outbuffer = GST_BUFFER (buffers->data);
+  gst_buffer_map (outbuffer, &map, GST_MAP_READ);
+  fail_unless_equals_int (map.size, hlen + 10 * 2 + 5 + 5);
+  fail_unless (memcmp (map.data, header, hlen) == 0);
+  data = map.data + hlen;
+  for (i = 0; i < 10; i++) {
+    fail_unless_equals_int (data[i], 1);
+    fail_unless_equals_int (data[10 + i], 2);
+  }
+  for (i = 0; i < 5; i++) {
+    fail_unless_equals_int (data[20 + i], 3);
+    fail_unless_equals_int (data[25 + i], 4);
+  }
+  gst_buffer_unmap (outbuffer, &map);
+
+  gst_check_drop_buffers ();
+  cleanup_y4menc (y4menc);
+}
+
+GST_END_TEST;
+
 static Suite *
 y4menc_suite (void)
 {
@@ -161,6 +229,7 @@ y4menc_suite (void)
 
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_y4m);
+  tcase_add_test (tc_chain, test_y4m_repack);
 
   return s;
 }
@@ -0,0 +1,172 @@
+/* GStreamer alpha benchmark
+ *
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the throughput of alpha for the set and green chroma keying
+ * methods on a number of input/output format pairs.
+ *
+ *   alpha-bench --width=1920 --height=1080 --frames=200 --threads=4
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+
+#define DEFAULT_WIDTH   1920
+#define DEFAULT_HEIGHT  1080
+#define DEFAULT_FRAMES  100
+#define DEFAULT_THREADS 1
+
+static gint opt_width = DEFAULT_WIDTH;
+static gint opt_height = DEFAULT_HEIGHT;
+static gint opt_frames = DEFAULT_FRAMES;
+static gint opt_threads = DEFAULT_THREADS;
+
+static const gchar *methods[] = { "set", "green" };
+
+static const struct
+{
+  const gchar *in_format;
+  const gchar *out_format;
+} pairs[] = {
+  {"AYUV", "AYUV"},
+  {"ARGB", "AYUV"},
+  {"AYUV", "BGRA"},
+  {"ARGB", "BGRA"},
+  {"RGB", "AYUV"},
+  {"BGRx", "ARGB"},
+  {"I420", "AYUV"},
+  {"I420", "BGRA"},
+  {"Y444", "AYUV"},
+  {"YUY2", "AYUV"},
+  {"UYVY", "ARGB"},
+};
+
+/* Returns the time per frame in ms, or -1 on error */
+static gdouble
+run_pipeline (const gchar * method, const gchar * in_format,
+    const gchar * out_format)
+{
+  GstElement *pipeline;
+  GstBus *bus;
+  GstMessage *msg;
+  GError *err = NULL;
+  gchar *pstr;
+  gint64 start, elapsed;
+  gdouble res = -1;
+
+  /* alpha=0.5 so that the set method never runs in passthrough */
+  pstr = g_strdup_printf ("videotestsrc num-buffers=%d pattern=smpte ! "
+      "video/x-raw,format=%s,width=%d,height=%d,framerate=30/1 ! "
+      "alpha method=%s alpha=0.5 n-threads=%d ! video/x-raw,format=%s ! "
+      "fakesink", opt_frames, in_format, opt_width, opt_height, method,
+      opt_threads, out_format);
+  pipeline = gst_parse_launch (pstr, &err);
+  g_free (pstr);
+
+  if (pipeline == NULL) {
+    g_printerr ("could not create pipeline: %s\n", err->message);
+    g_clear_error (&err);
+    return -1;
+  }
+
+  /* preroll first, so that negotiation and setup are not measured */
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  if (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_FAILURE)
+    goto done;
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  elapsed = g_get_monotonic_time () - start;
+  gst_object_unref (bus);
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS)
+    res = elapsed / 1000.0 / opt_frames;
+  gst_message_unref (msg);
+
+done:
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return res;
+}
+
+int
+main (int argc, char **argv)
+{
+  static const GOptionEntry bench_goptions[] = {
+    {"width", '\0', 0, G_OPTION_ARG_INT, &opt_width,
+        "width of the frames", NULL},
+    {"height", '\0', 0, G_OPTION_ARG_INT, &opt_height,
+        "height of the frames", NULL},
+    {"frames", 'n', 0, G_OPTION_ARG_INT, &opt_frames,
+        "number of frames for each method and format pair", NULL},
+    {"threads", 't', 0, G_OPTION_ARG_INT, &opt_threads,
+        "value of the n-threads property (0 = number of processors)", NULL},
+    {NULL, '\0', 0, 0, NULL, NULL, NULL}
+  };
+  GOptionContext *ctx;
+  GError *opt_err = NULL;
+  guint i, j;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  g_option_context_add_main_entries (ctx, bench_goptions, NULL);
+
+  if (!g_option_context_parse (ctx, &argc, &argv, &opt_err)) {
+    g_error ("Error parsing command line options: %s", opt_err->message);
+    return -1;
+  }
+  g_option_context_free (ctx);
+
+  if (opt_width <= 0 || opt_height <= 0 || opt_frames <= 0 || opt_threads < 0) {
+    g_printerr ("width, height and frames must be positive, threads must "
+        "not be negative\n");
+    return -1;
+  }
+
+  g_print ("%-6s %-6s    %-6s %10s %12s\n", "method", "in", "out",
+      "ms/frame", "Mpixels/s");
+
+  for (i = 0; i < G_N_ELEMENTS (methods); i++) {
+    for (j = 0; j < G_N_ELEMENTS (pairs); j++) {
+      gdouble ms = run_pipeline (methods[i], pairs[j].in_format,
+          pairs[j].out_format);
+
+      if (ms < 0) {
+        g_print ("%-6s %-6s -> %-6s failed\n", methods[i],
+            pairs[j].in_format, pairs[j].out_format);
+        continue;
+      }
+
+      g_print ("%-6s %-6s -> %-6s %10.3f %12.1f\n", methods[i],
+          pairs[j].in_format, pairs[j].out_format, ms,
+          (gdouble) opt_width * opt_height / (ms * 1000.0));
+    }
+  }
+
+  return 0;
+}
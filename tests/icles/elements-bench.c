@@ -0,0 +1,666 @@
+/* GStreamer element performance regression benchmark
+ *
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Runs a fixed set of cases over the hot paths of the plugins in this
+ * module and reports operations (buffers) per second, the time per
+ * operation and the memory allocations per operation. Most cases run a
+ * second, baseline pipeline without the element under test; its time and
+ * allocations are subtracted from the per operation numbers.
+ *
+ * With --csv the results are printed as comma separated values with a
+ * header line, so that they can be collected and compared over time.
+ *
+ *   elements-bench --filter=deinterlace --scale=2 --csv
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <unistd.h>
+
+#include <gst/gst.h>
+#include <glib/gstdio.h>
+
+#define DEFAULT_SCALE   1.0
+#define DEFAULT_PORT    50004
+
+static gdouble opt_scale = DEFAULT_SCALE;
+static gint opt_port = DEFAULT_PORT;
+static gchar *opt_filter = NULL;
+static gboolean opt_csv = FALSE;
+
+typedef struct
+{
+  guint64 ops;
+  gdouble seconds;
+  guint allocs;
+  /* the baseline run, 0 if there is none */
+  gdouble base_seconds;
+  guint base_allocs;
+} BenchResult;
+
+typedef struct _BenchCase BenchCase;
+
+/* returns FALSE when the case could not run */
+typedef gboolean (*BenchFunc) (const BenchCase * bench, guint n,
+    BenchResult * res);
+
+struct _BenchCase
+{
+  const gchar *name;
+  BenchFunc func;
+  /* buffers per run at scale 1 */
+  guint n;
+  /* pipeline descriptions, @N@ is replaced by the number of buffers and
+   * @FILE@ by a temporary file */
+  const gchar *pipeline;
+  const gchar *baseline;
+  const gchar *prepare;
+  /* case specific, e.g. the loss rate */
+  gdouble param;
+};
+
+/* counting allocator, installed as the default allocator so that every
+ * gst_buffer_new_allocate (NULL, ...) and gst_allocator_alloc (NULL, ...)
+ * done by the elements is accounted for. The memory itself comes from the
+ * system allocator and is also freed by it. */
+typedef GstAllocator BenchAllocator;
+typedef GstAllocatorClass BenchAllocatorClass;
+
+static GType bench_allocator_get_type (void);
+G_DEFINE_TYPE (BenchAllocator, bench_allocator, GST_TYPE_ALLOCATOR);
+
+static GstAllocator *sysmem_allocator;
+static volatile gint n_allocs;
+
+static GstMemory *
+bench_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  g_atomic_int_inc (&n_allocs);
+  return gst_allocator_alloc (sysmem_allocator, size, params);
+}
+
+static void
+bench_allocator_free (GstAllocator * allocator, GstMemory * mem)
+{
+  /* never reached, allocated memory belongs to the system allocator */
+  g_assert_not_reached ();
+}
+
+static void
+bench_allocator_class_init (BenchAllocatorClass * klass)
+{
+  klass->alloc = bench_allocator_alloc;
+  klass->free = bench_allocator_free;
+}
+
+static void
+bench_allocator_init (BenchAllocator * allocator)
+{
+  allocator->mem_type = "BenchMemory";
+}
+
+static gchar *
+expand_description (const gchar * desc, guint n, const gchar * file)
+{
+  gchar **parts, *tmp, *res, *nstr;
+
+  nstr = g_strdup_printf ("%u", n);
+  parts = g_strsplit (desc, "@N@", -1);
+  tmp = g_strjoinv (nstr, parts);
+  g_strfreev (parts);
+  g_free (nstr);
+
+  parts = g_strsplit (tmp, "@FILE@", -1);
+  res = g_strjoinv (file ? file : "", parts);
+  g_strfreev (parts);
+  g_free (tmp);
+
+  return res;
+}
+
+/* Runs the pipeline to EOS and returns the time it took in seconds, or -1
+ * on error. The allocations done while running are stored in @allocs. */
+static gdouble
+run_to_eos (const gchar * desc, guint n, const gchar * file, guint * allocs)
+{
+  GstElement *pipeline;
+  GstBus *bus;
+  GstMessage *msg;
+  GError *err = NULL;
+  gchar *pstr;
+  gint64 start, elapsed;
+  gdouble res = -1;
+
+  pstr = expand_description (desc, n, file);
+  pipeline = gst_parse_launch (pstr, &err);
+  g_free (pstr);
+
+  if (pipeline == NULL || err != NULL) {
+    GST_WARNING ("could not create pipeline: %s", err->message);
+    g_clear_error (&err);
+    if (pipeline)
+      gst_object_unref (pipeline);
+    return -1;
+  }
+
+  /* preroll first, so that negotiation and setup are not measured */
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  if (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_FAILURE)
+    goto done;
+
+  g_atomic_int_set (&n_allocs, 0);
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  elapsed = g_get_monotonic_time () - start;
+  if (allocs)
+    *allocs = g_atomic_int_get (&n_allocs);
+  gst_object_unref (bus);
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS)
+    res = elapsed / (gdouble) G_USEC_PER_SEC;
+  gst_message_unref (msg);
+
+done:
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return res;
+}
+
+static gboolean
+run_pipeline (const BenchCase * bench, guint n, BenchResult * res)
+{
+  gchar *file = NULL;
+  gboolean ret = FALSE;
+
+  if (bench->prepare) {
+    GError *err = NULL;
+    gint fd;
+
+    fd = g_file_open_tmp ("elements-bench-XXXXXX", &file, &err);
+    if (fd < 0) {
+      g_printerr ("could not create temporary file: %s\n", err->message);
+      g_clear_error (&err);
+      return FALSE;
+    }
+    close (fd);
+
+    if (run_to_eos (bench->prepare, n, file, NULL) < 0)
+      goto done;
+  }
+
+  res->ops = n;
+  res->seconds = run_to_eos (bench->pipeline, n, file, &res->allocs);
+  if (res->seconds < 0)
+    goto done;
+
+  if (bench->baseline) {
+    res->base_seconds = run_to_eos (bench->baseline, n, file,
+        &res->base_allocs);
+    if (res->base_seconds < 0)
+      goto done;
+  }
+  ret = TRUE;
+
+done:
+  if (file) {
+    g_unlink (file);
+    g_free (file);
+  }
+
+  return ret;
+}
+
+/* rtpjitterbuffer is driven directly from this thread. Its clock runs far
+ * ahead of the running time of the packets, so all timers expire at once
+ * and only the cost of inserting, popping and declaring lost packets is
+ * measured. */
+static GstStaticPadTemplate jb_src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+static GstStaticPadTemplate jb_sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+#define JB_PAYLOAD_SIZE 160
+#define JB_PACKET_DURATION (20 * GST_MSECOND)
+
+static GMutex jb_lock;
+static GCond jb_cond;
+static gboolean jb_eos;
+static guint64 jb_received;
+
+static GstFlowReturn
+jb_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  jb_received++;
+  gst_buffer_unref (buffer);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+jb_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  if (GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
+    g_mutex_lock (&jb_lock);
+    jb_eos = TRUE;
+    g_cond_signal (&jb_cond);
+    g_mutex_unlock (&jb_lock);
+  }
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+static GstBuffer *
+jb_make_packet (guint seq)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+
+  buffer = gst_buffer_new_allocate (NULL, 12 + JB_PAYLOAD_SIZE, NULL);
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  /* version 2, PCMU */
+  map.data[0] = 0x80;
+  map.data[1] = 0;
+  GST_WRITE_UINT16_BE (map.data + 2, seq & 0xffff);
+  GST_WRITE_UINT32_BE (map.data + 4, seq * JB_PAYLOAD_SIZE);
+  GST_WRITE_UINT32_BE (map.data + 8, 0x12345678);
+  memset (map.data + 12, 0xff, JB_PAYLOAD_SIZE);
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_DTS (buffer) = seq * JB_PACKET_DURATION;
+  GST_BUFFER_PTS (buffer) = GST_BUFFER_DTS (buffer);
+
+  return buffer;
+}
+
+static gboolean
+run_jitterbuffer (const BenchCase * bench, guint n, BenchResult * res)
+{
+  GstElement *jb;
+  GstPad *srcpad, *sinkpad, *pad;
+  GstClock *clock;
+  GstSegment segment;
+  GstCaps *caps;
+  GstBuffer **packets;
+  GRand *rand;
+  guint i, n_packets = 0;
+  gint64 start;
+
+  jb = gst_element_factory_make ("rtpjitterbuffer", NULL);
+  if (jb == NULL)
+    return FALSE;
+  g_object_set (jb, "latency", 200, "do-lost", TRUE, NULL);
+
+  srcpad = gst_pad_new_from_static_template (&jb_src_template, "src");
+  sinkpad = gst_pad_new_from_static_template (&jb_sink_template, "sink");
+  gst_pad_set_chain_function (sinkpad, jb_chain);
+  gst_pad_set_event_function (sinkpad, jb_event);
+
+  pad = gst_element_get_static_pad (jb, "sink");
+  gst_pad_link (srcpad, pad);
+  gst_object_unref (pad);
+  pad = gst_element_get_static_pad (jb, "src");
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (pad);
+  gst_pad_set_active (srcpad, TRUE);
+  gst_pad_set_active (sinkpad, TRUE);
+
+  clock = gst_system_clock_obtain ();
+  gst_element_set_clock (jb, clock);
+  gst_element_set_base_time (jb, 0);
+  gst_object_unref (clock);
+  gst_element_set_state (jb, GST_STATE_PLAYING);
+
+  /* create the packets up front, so that their allocation is not counted */
+  rand = g_rand_new_with_seed (42);
+  packets = g_new (GstBuffer *, n);
+  for (i = 0; i < n; i++) {
+    if (bench->param > 0.0 && g_rand_double (rand) < bench->param)
+      continue;
+    packets[n_packets++] = jb_make_packet (i);
+  }
+  g_rand_free (rand);
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("jitterbuffer"));
+  caps = gst_caps_from_string ("application/x-rtp,media=audio,payload=0,"
+      "clock-rate=8000,encoding-name=PCMU");
+  gst_pad_push_event (srcpad, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+
+  jb_eos = FALSE;
+  jb_received = 0;
+  g_atomic_int_set (&n_allocs, 0);
+  start = g_get_monotonic_time ();
+
+  for (i = 0; i < n_packets; i++)
+    gst_pad_push (srcpad, packets[i]);
+  gst_pad_push_event (srcpad, gst_event_new_eos ());
+
+  g_mutex_lock (&jb_lock);
+  while (!jb_eos)
+    g_cond_wait (&jb_cond, &jb_lock);
+  g_mutex_unlock (&jb_lock);
+
+  res->seconds = (g_get_monotonic_time () - start) / (gdouble) G_USEC_PER_SEC;
+  res->allocs = g_atomic_int_get (&n_allocs);
+  res->ops = n_packets;
+
+  gst_element_set_state (jb, GST_STATE_NULL);
+  gst_pad_set_active (srcpad, FALSE);
+  gst_pad_set_active (sinkpad, FALSE);
+  gst_object_unref (srcpad);
+  gst_object_unref (sinkpad);
+  gst_object_unref (jb);
+  g_free (packets);
+
+  return jb_received > 0;
+}
+
+/* multiudpsink sends as fast as it can to an udpsrc in another pipeline.
+ * The packets that arrive are counted, the time runs until the last one
+ * arrived. */
+static guint64 udp_received;
+static gint64 udp_last;
+
+static void
+udp_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  udp_received++;
+  udp_last = g_get_monotonic_time ();
+}
+
+static gboolean
+run_udp (const BenchCase * bench, guint n, BenchResult * res)
+{
+  GstElement *receiver, *sender, *sink;
+  GError *err = NULL;
+  GstBus *bus;
+  GstMessage *msg;
+  gchar *pstr;
+  gint64 start;
+  guint64 received;
+  guint idle = 0;
+  gboolean ret = FALSE;
+
+  pstr = g_strdup_printf ("udpsrc port=%d buffer-size=4194304 ! "
+      "fakesink name=sink signal-handoffs=true", opt_port);
+  receiver = gst_parse_launch (pstr, &err);
+  g_free (pstr);
+  if (receiver == NULL || err != NULL)
+    goto no_pipeline;
+
+  pstr = g_strdup_printf ("fakesrc num-buffers=%u sizetype=fixed "
+      "sizemax=%d ! multiudpsink clients=127.0.0.1:%d", n,
+      (gint) bench->param, opt_port);
+  sender = gst_parse_launch (pstr, &err);
+  g_free (pstr);
+  if (sender == NULL || err != NULL) {
+    gst_object_unref (receiver);
+    goto no_pipeline;
+  }
+
+  sink = gst_bin_get_by_name (GST_BIN (receiver), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (udp_handoff), NULL);
+  gst_object_unref (sink);
+
+  udp_received = 0;
+  gst_element_set_state (receiver, GST_STATE_PLAYING);
+  if (gst_element_get_state (receiver, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_FAILURE)
+    goto done;
+
+  gst_element_set_state (sender, GST_STATE_PAUSED);
+  if (gst_element_get_state (sender, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_FAILURE)
+    goto done;
+
+  g_atomic_int_set (&n_allocs, 0);
+  start = g_get_monotonic_time ();
+  gst_element_set_state (sender, GST_STATE_PLAYING);
+
+  bus = gst_element_get_bus (sender);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  gst_object_unref (bus);
+  if (GST_MESSAGE_TYPE (msg) != GST_MESSAGE_EOS) {
+    gst_message_unref (msg);
+    goto done;
+  }
+  gst_message_unref (msg);
+
+  /* wait until nothing arrives anymore, or for 2 seconds if nothing
+   * arrived at all */
+  do {
+    received = udp_received;
+    g_usleep (100 * 1000);
+    idle = received == udp_received ? idle + 1 : 0;
+  } while (received != udp_received || (received == 0 && idle < 20));
+
+  if (udp_received == 0)
+    goto done;
+
+  res->ops = udp_received;
+  res->seconds = (udp_last - start) / (gdouble) G_USEC_PER_SEC;
+  res->allocs = g_atomic_int_get (&n_allocs);
+  if (udp_received < n)
+    GST_INFO ("%" G_GUINT64_FORMAT " of %u packets lost", n - udp_received,
+        n);
+  ret = TRUE;
+
+done:
+  gst_element_set_state (sender, GST_STATE_NULL);
+  gst_element_set_state (receiver, GST_STATE_NULL);
+  gst_object_unref (sender);
+  gst_object_unref (receiver);
+
+  return ret;
+
+no_pipeline:
+  {
+    GST_WARNING ("could not create pipeline: %s", err ? err->message : "");
+    g_clear_error (&err);
+    return FALSE;
+  }
+}
+
+#define VIDEOMIXER_SRC(fmt, w, h) \
+  "videotestsrc num-buffers=@N@ pattern=ball ! video/x-raw,format=" fmt \
+  ",width=" #w ",height=" #h ",framerate=30/1"
+#define VIDEOMIXER_CASE(fmt) \
+  {"videomixer-" fmt, run_pipeline, 300, \
+   VIDEOMIXER_SRC (fmt, 640, 480) " ! videomixer name=m ! video/x-raw," \
+   "format=" fmt " ! fakesink " VIDEOMIXER_SRC (fmt, 320, 240) " ! m.", \
+   VIDEOMIXER_SRC (fmt, 640, 480) " ! fakesink " \
+   VIDEOMIXER_SRC (fmt, 320, 240) " ! fakesink", NULL, 0}
+
+#define DEINTERLACE_SRC \
+  "videotestsrc num-buffers=@N@ pattern=ball ! video/x-raw,format=YUY2," \
+  "width=720,height=576,framerate=25/1"
+#define DEINTERLACE_CASE(method) \
+  {"deinterlace-" method, run_pipeline, 300, \
+   DEINTERLACE_SRC " ! deinterlace mode=interlaced method=" method \
+   " ! fakesink", DEINTERLACE_SRC " ! fakesink", NULL, 0}
+
+#define AUDIO_SRC \
+  "audiotestsrc num-buffers=@N@ samplesperbuffer=1024 wave=white-noise ! " \
+  "audio/x-raw,format=F32LE,rate=48000,channels=2"
+#define AUDIO_CASE(name, filter) \
+  {name, run_pipeline, 2000, AUDIO_SRC " ! " filter " ! fakesink", \
+   AUDIO_SRC " ! fakesink", NULL, 0}
+
+#define JPEG_SRC(w, h) \
+  "videotestsrc num-buffers=@N@ pattern=ball ! video/x-raw,format=I420," \
+  "width=" #w ",height=" #h ",framerate=30/1"
+
+static const BenchCase cases[] = {
+  VIDEOMIXER_CASE ("AYUV"),
+  VIDEOMIXER_CASE ("BGRA"),
+  VIDEOMIXER_CASE ("ARGB"),
+  VIDEOMIXER_CASE ("xRGB"),
+  VIDEOMIXER_CASE ("RGB"),
+  VIDEOMIXER_CASE ("I420"),
+  VIDEOMIXER_CASE ("NV12"),
+  VIDEOMIXER_CASE ("YUY2"),
+
+  DEINTERLACE_CASE ("tomsmocomp"),
+  DEINTERLACE_CASE ("greedyh"),
+  DEINTERLACE_CASE ("greedyl"),
+  DEINTERLACE_CASE ("vfir"),
+  DEINTERLACE_CASE ("linear"),
+  DEINTERLACE_CASE ("linearblend"),
+
+  AUDIO_CASE ("audiowsinclimit-101",
+      "audiowsinclimit length=101 cutoff=4000"),
+  AUDIO_CASE ("audiowsinclimit-1001",
+      "audiowsinclimit length=1001 cutoff=4000"),
+  AUDIO_CASE ("audiowsincband-255",
+      "audiowsincband length=255 lower-frequency=1000 upper-frequency=4000"),
+  AUDIO_CASE ("audiocheblimit-4", "audiocheblimit poles=4 cutoff=4000"),
+  AUDIO_CASE ("audiocheblimit-8", "audiocheblimit poles=8 cutoff=4000"),
+  AUDIO_CASE ("audiochebband-8",
+      "audiochebband poles=8 lower-frequency=1000 upper-frequency=4000"),
+
+  {"jpegenc-720p", run_pipeline, 200,
+      JPEG_SRC (1280, 720) " ! jpegenc ! fakesink",
+      JPEG_SRC (1280, 720) " ! fakesink", NULL, 0},
+  {"jpegdec-720p", run_pipeline, 200,
+      "filesrc location=@FILE@ ! matroskademux ! jpegdec ! fakesink",
+      "filesrc location=@FILE@ ! matroskademux ! fakesink",
+      JPEG_SRC (1280, 720) " ! jpegenc ! matroskamux ! "
+      "filesink location=@FILE@", 0},
+
+  {"matroskademux", run_pipeline, 20000,
+      "filesrc location=@FILE@ ! matroskademux ! fakesink",
+      "filesrc location=@FILE@ ! fakesink",
+      JPEG_SRC (64, 48) " ! jpegenc ! matroskamux ! "
+      "filesink location=@FILE@", 0},
+  {"qtdemux", run_pipeline, 20000,
+      "filesrc location=@FILE@ ! qtdemux ! fakesink",
+      "filesrc location=@FILE@ ! fakesink",
+      JPEG_SRC (64, 48) " ! jpegenc ! qtmux ! filesink location=@FILE@", 0},
+
+  {"rtpjitterbuffer-0%", run_jitterbuffer, 100000, NULL, NULL, NULL, 0.0},
+  {"rtpjitterbuffer-1%", run_jitterbuffer, 100000, NULL, NULL, NULL, 0.01},
+  {"rtpjitterbuffer-10%", run_jitterbuffer, 100000, NULL, NULL, NULL, 0.1},
+
+  {"udp-loopback-200", run_udp, 200000, NULL, NULL, NULL, 200},
+  {"udp-loopback-1400", run_udp, 100000, NULL, NULL, NULL, 1400},
+};
+
+static void
+print_result (const BenchCase * bench, const BenchResult * res)
+{
+  gdouble ops_per_sec, ns_per_op, allocs_per_op;
+
+  ops_per_sec = res->seconds > 0 ? res->ops / res->seconds : 0;
+  ns_per_op = (res->seconds - res->base_seconds) * 1e9 / res->ops;
+  allocs_per_op = ((gdouble) res->allocs - res->base_allocs) / res->ops;
+
+  if (opt_csv)
+    g_print ("%s,%" G_GUINT64_FORMAT ",%.6f,%.1f,%.1f,%.3f\n", bench->name,
+        res->ops, res->seconds, ops_per_sec, ns_per_op, allocs_per_op);
+  else
+    g_print ("%-24s %10" G_GUINT64_FORMAT " %10.3f %12.1f %12.1f %10.3f\n",
+        bench->name, res->ops, res->seconds, ops_per_sec, ns_per_op,
+        allocs_per_op);
+}
+
+int
+main (int argc, char **argv)
+{
+  static const GOptionEntry bench_goptions[] = {
+    {"scale", 's', 0, G_OPTION_ARG_DOUBLE, &opt_scale,
+        "scale the number of buffers of every case", NULL},
+    {"filter", 'f', 0, G_OPTION_ARG_STRING, &opt_filter,
+        "only run the cases whose name contains this", NULL},
+    {"port", 'p', 0, G_OPTION_ARG_INT, &opt_port,
+        "UDP port for the loopback cases", NULL},
+    {"csv", '\0', 0, G_OPTION_ARG_NONE, &opt_csv,
+        "print comma separated values", NULL},
+    {NULL, '\0', 0, 0, NULL, NULL, NULL}
+  };
+  GOptionContext *ctx;
+  GError *opt_err = NULL;
+  guint i;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  g_option_context_add_main_entries (ctx, bench_goptions, NULL);
+
+  if (!g_option_context_parse (ctx, &argc, &argv, &opt_err)) {
+    g_error ("Error parsing command line options: %s", opt_err->message);
+    return -1;
+  }
+  g_option_context_free (ctx);
+
+  if (opt_scale <= 0) {
+    g_printerr ("scale must be positive\n");
+    return -1;
+  }
+
+  sysmem_allocator = gst_allocator_find (GST_ALLOCATOR_SYSMEM);
+  gst_allocator_set_default (g_object_new (bench_allocator_get_type (), NULL));
+
+  if (opt_csv)
+    g_print ("name,ops,seconds,ops_per_sec,ns_per_op,allocs_per_op\n");
+  else
+    g_print ("%-24s %10s %10s %12s %12s %10s\n", "case", "ops", "seconds",
+        "ops/s", "ns/op", "allocs/op");
+
+  for (i = 0; i < G_N_ELEMENTS (cases); i++) {
+    const BenchCase *bench = &cases[i];
+    BenchResult res = { 0, };
+    guint n;
+
+    if (opt_filter && strstr (bench->name, opt_filter) == NULL)
+      continue;
+
+    n = MAX (1, bench->n * opt_scale);
+
+    if (!bench->func (bench, n, &res) || res.ops == 0) {
+      if (!opt_csv)
+        g_print ("%-24s skipped\n", bench->name);
+      continue;
+    }
+
+    print_result (bench, &res);
+  }
+
+  gst_object_unref (sysmem_allocator);
+
+  return 0;
+}
@@ -0,0 +1,188 @@
+/* GStreamer G.711 benchmark
+ *
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the throughput of the mu-law and A-law encoders and decoders and
+ * of transcoding between the two, directly and through linear audio.  The
+ * time spent producing the input is measured separately and subtracted, and
+ * the result is given as the number of 8 kHz mono channels one core can
+ * keep up with.  The default buffer size is one 20 ms telephony packet.
+ *
+ *   law-bench --buffers=50000 --samples-per-buffer=160
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+
+#define DEFAULT_BUFFERS             20000
+#define DEFAULT_SAMPLES_PER_BUFFER  160
+
+#define RATE 8000
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define S16_NE "S16LE"
+#else
+#define S16_NE "S16BE"
+#endif
+
+static gint opt_buffers = DEFAULT_BUFFERS;
+static gint opt_samples_per_buffer = DEFAULT_SAMPLES_PER_BUFFER;
+
+enum
+{
+  INPUT_LINEAR,
+  INPUT_MULAW,
+  INPUT_ALAW,
+  N_INPUTS
+};
+
+/* appended to the audiotestsrc ! capsfilter source */
+static const gchar *inputs[N_INPUTS] = { "", " ! mulawenc", " ! alawenc" };
+
+static const struct
+{
+  const gchar *name;
+  gint input;
+  const gchar *elements;
+} cases[] = {
+  {"mulawenc", INPUT_LINEAR, "mulawenc"},
+  {"mulawdec", INPUT_MULAW, "mulawdec"},
+  {"alawenc", INPUT_LINEAR, "alawenc"},
+  {"alawdec", INPUT_ALAW, "alawdec"},
+  {"mulaw -> alaw", INPUT_MULAW, "alawenc"},
+  {"alaw -> mulaw", INPUT_ALAW, "alawdec ! audio/x-mulaw"},
+  {"mulaw -> alaw (linear)", INPUT_MULAW, "mulawdec ! alawenc"},
+  {"alaw -> mulaw (linear)", INPUT_ALAW,
+      "alawdec ! audio/x-raw ! mulawenc"},
+};
+
+/* Returns the time it took to run to EOS in s, or -1 on error */
+static gdouble
+run_pipeline (gint input, const gchar * elements)
+{
+  GstElement *pipeline;
+  GstBus *bus;
+  GstMessage *msg;
+  GError *err = NULL;
+  gchar *pstr;
+  gint64 start, elapsed;
+  gdouble res = -1;
+
+  pstr = g_strdup_printf ("audiotestsrc num-buffers=%d samplesperbuffer=%d "
+      "wave=pink-noise ! audio/x-raw,format=" S16_NE ",rate=%d,channels=1"
+      "%s%s%s ! fakesink", opt_buffers, opt_samples_per_buffer, RATE,
+      inputs[input], elements ? " ! " : "", elements ? elements : "");
+  pipeline = gst_parse_launch (pstr, &err);
+  g_free (pstr);
+
+  if (pipeline == NULL) {
+    g_printerr ("could not create pipeline: %s\n", err->message);
+    g_clear_error (&err);
+    return -1;
+  }
+
+  /* preroll first, so that negotiation and setup are not measured */
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  if (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_FAILURE)
+    goto done;
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  elapsed = g_get_monotonic_time () - start;
+  gst_object_unref (bus);
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS)
+    res = elapsed / (gdouble) G_USEC_PER_SEC;
+  gst_message_unref (msg);
+
+done:
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return res;
+}
+
+int
+main (int argc, char **argv)
+{
+  static const GOptionEntry bench_goptions[] = {
+    {"buffers", 'n', 0, G_OPTION_ARG_INT, &opt_buffers,
+        "number of buffers for each case", NULL},
+    {"samples-per-buffer", 's', 0, G_OPTION_ARG_INT, &opt_samples_per_buffer,
+        "number of samples in each buffer", NULL},
+    {NULL, '\0', 0, 0, NULL, NULL, NULL}
+  };
+  GOptionContext *ctx;
+  GError *opt_err = NULL;
+  gdouble base[N_INPUTS];
+  gdouble samples;
+  guint i;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  g_option_context_add_main_entries (ctx, bench_goptions, NULL);
+
+  if (!g_option_context_parse (ctx, &argc, &argv, &opt_err)) {
+    g_error ("Error parsing command line options: %s", opt_err->message);
+    return -1;
+  }
+  g_option_context_free (ctx);
+
+  if (opt_buffers <= 0 || opt_samples_per_buffer <= 0) {
+    g_printerr ("buffers and samples-per-buffer must be positive\n");
+    return -1;
+  }
+
+  samples = (gdouble) opt_buffers * opt_samples_per_buffer;
+
+  for (i = 0; i < N_INPUTS; i++) {
+    base[i] = run_pipeline (i, NULL);
+    if (base[i] < 0) {
+      g_printerr ("could not measure the input pipelines\n");
+      return -1;
+    }
+  }
+
+  g_print ("%-24s %12s %16s\n", "case", "Msamples/s", "channels/core");
+
+  for (i = 0; i < G_N_ELEMENTS (cases); i++) {
+    gdouble s = run_pipeline (cases[i].input, cases[i].elements);
+
+    if (s < 0) {
+      g_print ("%-24s failed\n", cases[i].name);
+      continue;
+    }
+
+    /* clamp, the difference can get lost in the noise for short runs */
+    s = MAX (s - base[cases[i].input], 1e-6);
+
+    g_print ("%-24s %12.1f %16.0f\n", cases[i].name,
+        samples / s / 1e6, samples / s / RATE);
+  }
+
+  return 0;
+}
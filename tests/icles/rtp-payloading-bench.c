@@ -0,0 +1,641 @@
+/* GStreamer RTP payloader/depayloader benchmark
+ *
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Pushes synthetic frames through pay ! depay pairs from the rtp plugin and
+ * reports packets per second, nanoseconds per packet and memory allocations
+ * per packet. The elements are driven directly from the calling thread so
+ * that only the cost of the payloader and depayloader is measured.
+ *
+ *   rtp-payloading-bench --size=8000 --mtu=1400 --frames=5000 --pair=h264
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+
+#define DEFAULT_SIZE    4096
+#define DEFAULT_MTU     1400
+#define DEFAULT_FRAMES  2000
+
+static gint opt_size = DEFAULT_SIZE;
+static gint opt_mtu = DEFAULT_MTU;
+static gint opt_frames = DEFAULT_FRAMES;
+static gchar *opt_pair = NULL;
+
+typedef GstBuffer *(*BenchMakeFrame) (guint size);
+typedef GList *(*BenchMakeHeaders) (void);
+
+typedef struct
+{
+  const gchar *name;
+  const gchar *pay;
+  const gchar *depay;
+  const gchar *caps;
+  /* duration of one frame, 0 to derive it from the frame size */
+  GstClockTime duration;
+  /* bytes per second, used when duration is 0 */
+  guint byte_rate;
+  BenchMakeFrame make_frame;
+  BenchMakeHeaders make_headers;
+} BenchPair;
+
+typedef struct
+{
+  guint64 packets;
+  guint64 frames_out;
+  GstFlowReturn ret;
+} BenchStats;
+
+/* counting allocator, installed as the default allocator so that every
+ * gst_buffer_new_allocate (NULL, ...) and gst_allocator_alloc (NULL, ...)
+ * done by the elements is accounted for. The memory itself comes from the
+ * system allocator and is also freed by it. */
+typedef GstAllocator BenchAllocator;
+typedef GstAllocatorClass BenchAllocatorClass;
+
+static GType bench_allocator_get_type (void);
+G_DEFINE_TYPE (BenchAllocator, bench_allocator, GST_TYPE_ALLOCATOR);
+
+static GstAllocator *sysmem_allocator;
+static volatile gint n_allocs;
+
+static GstMemory *
+bench_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  g_atomic_int_inc (&n_allocs);
+  return gst_allocator_alloc (sysmem_allocator, size, params);
+}
+
+static void
+bench_allocator_free (GstAllocator * allocator, GstMemory * mem)
+{
+  /* never reached, allocated memory belongs to the system allocator */
+  g_assert_not_reached ();
+}
+
+static void
+bench_allocator_class_init (BenchAllocatorClass * klass)
+{
+  klass->alloc = bench_allocator_alloc;
+  klass->free = bench_allocator_free;
+}
+
+static void
+bench_allocator_init (BenchAllocator * allocator)
+{
+  allocator->mem_type = "BenchMemory";
+}
+
+/* fill with a pattern that contains no start codes or markers */
+static void
+fill_pattern (guint8 * data, guint size, guint8 lo, guint8 hi)
+{
+  guint i;
+
+  for (i = 0; i < size; i++)
+    data[i] = lo + (i % (hi - lo + 1));
+}
+
+static GstBuffer *
+make_raw (guint size)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  buf = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  fill_pattern (map.data, map.size, 0x01, 0xfe);
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static GstBuffer *
+make_audio16 (guint size)
+{
+  return make_raw (MAX (size & ~3, 4));
+}
+
+static GstBuffer *
+make_h263p (guint size)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  buf = make_raw (MAX (size, 8));
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  /* picture start code */
+  map.data[0] = 0x00;
+  map.data[1] = 0x00;
+  map.data[2] = 0x80;
+  map.data[3] = 0x02;
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static const guint8 h264_sps[] = {
+  0x67, 0x64, 0x00, 0x14, 0xac, 0xd9, 0x41, 0x41, 0xfb, 0x01, 0x10, 0x00,
+  0x00, 0x03, 0x00, 0x17, 0x73, 0x59, 0x40, 0x00, 0xf1, 0x42, 0x99, 0x60
+};
+
+static const guint8 h264_pps[] = {
+  0x68, 0xeb, 0xec, 0xb2, 0x2c
+};
+
+static GstBuffer *
+make_h264 (guint size)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  guint8 *data;
+  guint hdr;
+
+  hdr = 4 + sizeof (h264_sps) + 4 + sizeof (h264_pps) + 4 + 2;
+  buf = gst_buffer_new_allocate (NULL, MAX (size, hdr + 1), NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  data = map.data;
+
+  GST_WRITE_UINT32_BE (data, 1);
+  memcpy (data + 4, h264_sps, sizeof (h264_sps));
+  data += 4 + sizeof (h264_sps);
+  GST_WRITE_UINT32_BE (data, 1);
+  memcpy (data + 4, h264_pps, sizeof (h264_pps));
+  data += 4 + sizeof (h264_pps);
+  /* IDR slice */
+  GST_WRITE_UINT32_BE (data, 1);
+  data[4] = 0x65;
+  data[5] = 0x88;
+  data += 6;
+  /* emulation prevention free filler */
+  fill_pattern (data, map.size - hdr, 0x80, 0xff);
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static GstBuffer *
+make_mp4v (guint size)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  buf = gst_buffer_new_allocate (NULL, MAX (size, 8), NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  /* VOP start code */
+  GST_WRITE_UINT32_BE (map.data, 0x000001b6);
+  fill_pattern (map.data + 4, map.size - 4, 0x80, 0xff);
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static GstBuffer *
+make_mpa (guint size)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  buf = make_raw (MAX (size, 8));
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  /* MPEG-1 layer 3 frame header */
+  GST_WRITE_UINT32_BE (map.data, 0xfffb9064);
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static GstBuffer *
+make_mp2t (guint size)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  guint i;
+
+  buf = make_raw (MAX (size / 188, 1) * 188);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  for (i = 0; i < map.size; i += 188)
+    map.data[i] = 0x47;
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static GstBuffer *
+make_jpeg (guint size)
+{
+  static const guint8 sof[] = {
+    0xff, 0xc0, 0x00, 0x11, 0x08, 0x01, 0xe0, 0x02, 0x80, 0x03,
+    0x01, 0x21, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01
+  };
+  static const guint8 sos[] = {
+    0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11,
+    0x00, 0x3f, 0x00
+  };
+  GstBuffer *buf;
+  GstMapInfo map;
+  guint8 *data;
+  guint hdr, i;
+
+  hdr = 2 + 2 * (4 + 1 + 64) + sizeof (sof) + sizeof (sos);
+  buf = gst_buffer_new_allocate (NULL, MAX (size, hdr + 16), NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  data = map.data;
+
+  *data++ = 0xff;
+  *data++ = 0xd8;
+  for (i = 0; i < 2; i++) {
+    *data++ = 0xff;
+    *data++ = 0xdb;
+    *data++ = 0x00;
+    *data++ = 0x43;
+    *data++ = i;
+    fill_pattern (data, 64, 0x01, 0x40);
+    data += 64;
+  }
+  memcpy (data, sof, sizeof (sof));
+  data += sizeof (sof);
+  memcpy (data, sos, sizeof (sos));
+  data += sizeof (sos);
+  /* scan data without markers, followed by EOI */
+  fill_pattern (data, map.size - hdr - 2, 0x00, 0xfe);
+  map.data[map.size - 2] = 0xff;
+  map.data[map.size - 1] = 0xd9;
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static GstBuffer *
+make_header (const gchar * id, guint size)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  buf = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  memset (map.data, 0, map.size);
+  memcpy (map.data, id, 7);
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static GList *
+make_theora_headers (void)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  GList *headers = NULL;
+
+  buf = make_header ("\200theora", 42);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  /* version 3.2.1, 640x480 */
+  map.data[7] = 3;
+  map.data[8] = 2;
+  map.data[9] = 1;
+  GST_WRITE_UINT16_BE (map.data + 10, 640 >> 4);
+  GST_WRITE_UINT16_BE (map.data + 12, 480 >> 4);
+  gst_buffer_unmap (buf, &map);
+  headers = g_list_append (headers, buf);
+  headers = g_list_append (headers, make_header ("\201theora", 16));
+  headers = g_list_append (headers, make_header ("\202theora", 64));
+
+  return headers;
+}
+
+static GstBuffer *
+make_theora (guint size)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  buf = make_raw (MAX (size, 2));
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  /* data packet, keyframe */
+  map.data[0] = 0x00;
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static GList *
+make_vorbis_headers (void)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  GList *headers = NULL;
+
+  buf = make_header ("\001vorbis", 30);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  /* version 0, 2 channels, 44100 Hz */
+  GST_WRITE_UINT32_LE (map.data + 7, 0);
+  map.data[11] = 2;
+  GST_WRITE_UINT32_LE (map.data + 12, 44100);
+  map.data[28] = 0xb8;
+  map.data[29] = 0x01;
+  gst_buffer_unmap (buf, &map);
+  headers = g_list_append (headers, buf);
+  headers = g_list_append (headers, make_header ("\003vorbis", 16));
+  headers = g_list_append (headers, make_header ("\005vorbis", 64));
+
+  return headers;
+}
+
+static GstBuffer *
+make_vorbis (guint size)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  buf = make_raw (MAX (size, 2));
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  /* audio packet */
+  map.data[0] = 0x00;
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static const BenchPair pairs[] = {
+  {"h263p", "rtph263ppay", "rtph263pdepay",
+        "video/x-h263,variant=(string)itu,h263version=(string)h263",
+      GST_SECOND / 30, 0, make_h263p, NULL},
+  {"h264", "rtph264pay", "rtph264depay",
+        "video/x-h264,stream-format=(string)byte-stream,alignment=(string)au",
+      GST_SECOND / 30, 0, make_h264, NULL},
+  {"mp4v", "rtpmp4vpay", "rtpmp4vdepay",
+        "video/mpeg,mpegversion=(int)4,systemstream=(boolean)false",
+      GST_SECOND / 30, 0, make_mp4v, NULL},
+  {"mp4a", "rtpmp4apay", "rtpmp4adepay",
+        "audio/mpeg,mpegversion=(int)4,stream-format=(string)raw,"
+        "codec_data=(buffer)1210",
+      GST_SECOND * 1024 / 44100, 0, make_raw, NULL},
+  {"mp4g", "rtpmp4gpay", "rtpmp4gdepay",
+        "audio/mpeg,mpegversion=(int)4,stream-format=(string)raw,"
+        "codec_data=(buffer)1210",
+      GST_SECOND * 1024 / 44100, 0, make_raw, NULL},
+  {"mpa", "rtpmpapay", "rtpmpadepay",
+        "audio/mpeg,mpegversion=(int)1,layer=(int)3,rate=(int)44100,"
+        "channels=(int)2",
+      GST_SECOND * 1152 / 44100, 0, make_mpa, NULL},
+  {"jpeg", "rtpjpegpay", "rtpjpegdepay",
+        "image/jpeg,width=(int)640,height=(int)480,framerate=(fraction)30/1",
+      GST_SECOND / 30, 0, make_jpeg, NULL},
+  {"mp2t", "rtpmp2tpay", "rtpmp2tdepay",
+        "video/mpegts,packetsize=(int)188,systemstream=(boolean)true",
+      0, 2000000 / 8, make_mp2t, NULL},
+  {"L16", "rtpL16pay", "rtpL16depay",
+        "audio/x-raw,format=(string)S16BE,layout=(string)interleaved,"
+        "rate=(int)44100,channels=(int)2",
+      0, 44100 * 4, make_audio16, NULL},
+  {"pcma", "rtppcmapay", "rtppcmadepay",
+        "audio/x-alaw,channels=(int)1,rate=(int)8000",
+      0, 8000, make_raw, NULL},
+  {"pcmu", "rtppcmupay", "rtppcmudepay",
+        "audio/x-mulaw,channels=(int)1,rate=(int)8000",
+      0, 8000, make_raw, NULL},
+  {"theora", "rtptheorapay", "rtptheoradepay", "video/x-theora",
+      GST_SECOND / 30, 0, make_theora, make_theora_headers},
+  {"vorbis", "rtpvorbispay", "rtpvorbisdepay", "audio/x-vorbis",
+      GST_SECOND * 1024 / 44100, 0, make_vorbis, make_vorbis_headers},
+};
+
+static GstPadProbeReturn
+count_packets (GstPad * pad, GstPadProbeInfo * info, BenchStats * stats)
+{
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+    stats->packets += gst_buffer_list_length (GST_PAD_PROBE_INFO_BUFFER_LIST
+        (info));
+  else
+    stats->packets++;
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstFlowReturn
+sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  BenchStats *stats = g_object_get_data (G_OBJECT (pad), "stats");
+
+  stats->frames_out++;
+  gst_buffer_unref (buffer);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+push_buffer (GstPad * srcpad, GstBuffer * buf, GstClockTime ts,
+    GstClockTime duration, BenchStats * stats)
+{
+  GST_BUFFER_PTS (buf) = ts;
+  GST_BUFFER_DTS (buf) = ts;
+  GST_BUFFER_DURATION (buf) = duration;
+
+  stats->ret = gst_pad_push (srcpad, buf);
+  return stats->ret == GST_FLOW_OK;
+}
+
+static gboolean
+run_pair (const BenchPair * pair, guint size, guint mtu, guint frames)
+{
+  GstElement *pipeline, *pay, *depay;
+  GstPad *srcpad, *sinkpad, *paysink, *paysrc, *depaysrc;
+  GstCaps *caps;
+  GstSegment segment;
+  GstBuffer *frame;
+  GList *headers, *walk;
+  BenchStats stats = { 0, 0, GST_FLOW_OK };
+  GstClockTime ts = 0, duration;
+  gint64 start, elapsed;
+  gint allocs;
+  guint i;
+  gboolean res = FALSE;
+
+  pipeline = gst_pipeline_new (NULL);
+  pay = gst_element_factory_make (pair->pay, NULL);
+  depay = gst_element_factory_make (pair->depay, NULL);
+  if (pay == NULL || depay == NULL) {
+    g_print ("%-8s skipped, %s or %s not available\n", pair->name, pair->pay,
+        pair->depay);
+    if (pay)
+      gst_object_unref (pay);
+    if (depay)
+      gst_object_unref (depay);
+    gst_object_unref (pipeline);
+    return TRUE;
+  }
+  g_object_set (pay, "mtu", mtu, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), pay, depay, NULL);
+  gst_element_link (pay, depay);
+
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+  g_object_set_data (G_OBJECT (sinkpad), "stats", &stats);
+  gst_pad_set_chain_function (sinkpad, sink_chain);
+
+  paysink = gst_element_get_static_pad (pay, "sink");
+  paysrc = gst_element_get_static_pad (pay, "src");
+  depaysrc = gst_element_get_static_pad (depay, "src");
+  gst_pad_link (srcpad, paysink);
+  gst_pad_link (depaysrc, sinkpad);
+  gst_pad_add_probe (paysrc,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      (GstPadProbeCallback) count_packets, &stats, NULL);
+
+  gst_pad_set_active (sinkpad, TRUE);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  gst_pad_set_active (srcpad, TRUE);
+
+  caps = gst_caps_from_string (pair->caps);
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("bench"));
+  gst_pad_push_event (srcpad, gst_event_new_caps (caps));
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+  gst_caps_unref (caps);
+
+  frame = pair->make_frame (size);
+  if (pair->duration)
+    duration = pair->duration;
+  else
+    duration = gst_util_uint64_scale_int (gst_buffer_get_size (frame),
+        GST_SECOND, pair->byte_rate);
+
+  headers = pair->make_headers ? pair->make_headers () : NULL;
+  for (walk = headers; walk; walk = g_list_next (walk)) {
+    if (!push_buffer (srcpad, walk->data, ts, 0, &stats))
+      break;
+  }
+  g_list_free (headers);
+  if (stats.ret != GST_FLOW_OK)
+    goto push_failed;
+
+  /* warm up, lets the elements negotiate and allocate their state */
+  if (!push_buffer (srcpad, gst_buffer_copy (frame), ts, duration, &stats))
+    goto push_failed;
+  ts += duration;
+
+  stats.packets = 0;
+  stats.frames_out = 0;
+  g_atomic_int_set (&n_allocs, 0);
+  start = g_get_monotonic_time ();
+
+  for (i = 0; i < frames; i++) {
+    /* shallow copy, shares the memory of the frame */
+    if (!push_buffer (srcpad, gst_buffer_copy (frame), ts, duration, &stats))
+      goto push_failed;
+    ts += duration;
+  }
+
+  elapsed = g_get_monotonic_time () - start;
+  allocs = g_atomic_int_get (&n_allocs);
+
+  if (stats.packets == 0) {
+    g_print ("%-8s no packets produced\n", pair->name);
+  } else {
+    g_print ("%-8s %6" G_GSIZE_FORMAT " %5u %8" G_GUINT64_FORMAT " %8"
+        G_GUINT64_FORMAT " %12.0f %10.1f %8.2f\n", pair->name,
+        gst_buffer_get_size (frame), mtu, stats.packets, stats.frames_out,
+        elapsed > 0 ? stats.packets * 1e6 / elapsed : 0.0,
+        elapsed * 1e3 / stats.packets, (gdouble) allocs / stats.packets);
+  }
+  res = TRUE;
+
+done:
+  gst_pad_push_event (srcpad, gst_event_new_eos ());
+  gst_buffer_unref (frame);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_pad_set_active (srcpad, FALSE);
+  gst_pad_set_active (sinkpad, FALSE);
+  gst_object_unref (paysink);
+  gst_object_unref (paysrc);
+  gst_object_unref (depaysrc);
+  gst_object_unref (srcpad);
+  gst_object_unref (sinkpad);
+  gst_object_unref (pipeline);
+
+  return res;
+
+  /* ERRORS */
+push_failed:
+  {
+    g_print ("%-8s push failed: %s\n", pair->name,
+        gst_flow_get_name (stats.ret));
+    goto done;
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  static const GOptionEntry bench_goptions[] = {
+    {"size", 's', 0, G_OPTION_ARG_INT, &opt_size,
+        "size of the synthetic frames in bytes", NULL},
+    {"mtu", 'm', 0, G_OPTION_ARG_INT, &opt_mtu,
+        "MTU configured on the payloaders", NULL},
+    {"frames", 'n', 0, G_OPTION_ARG_INT, &opt_frames,
+        "number of frames to push through each pair", NULL},
+    {"pair", 'p', 0, G_OPTION_ARG_STRING, &opt_pair,
+        "only run the pair with this name", NULL},
+    {NULL, '\0', 0, 0, NULL, NULL, NULL}
+  };
+  GOptionContext *ctx;
+  GError *opt_err = NULL;
+  gboolean ok = TRUE;
+  guint i;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  g_option_context_add_main_entries (ctx, bench_goptions, NULL);
+
+  if (!g_option_context_parse (ctx, &argc, &argv, &opt_err)) {
+    g_error ("Error parsing command line options: %s", opt_err->message);
+    return -1;
+  }
+  g_option_context_free (ctx);
+
+  if (opt_size <= 0 || opt_mtu <= 28 || opt_frames <= 0) {
+    g_printerr ("size, mtu and frames must be positive, mtu larger than 28\n");
+    return -1;
+  }
+
+  sysmem_allocator = gst_allocator_find (GST_ALLOCATOR_SYSMEM);
+  gst_allocator_set_default (g_object_new (bench_allocator_get_type (), NULL));
+
+  g_print ("%-8s %6s %5s %8s %8s %12s %10s %8s\n", "pair", "size", "mtu",
+      "packets", "frames", "packets/s", "ns/packet", "allocs");
+
+  for (i = 0; i < G_N_ELEMENTS (pairs); i++) {
+    if (opt_pair && g_ascii_strcasecmp (opt_pair, pairs[i].name))
+      continue;
+
+    ok &= run_pair (&pairs[i], opt_size, opt_mtu, opt_frames);
+  }
+
+  gst_object_unref (sysmem_allocator);
+  g_free (opt_pair);
+
+  return ok ? 0 : 1;
+}
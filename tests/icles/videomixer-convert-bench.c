@@ -0,0 +1,175 @@
+/* GStreamer videomixer conversion benchmark
+ *
+ * Copyright (C) 2014 GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Times videomixer with a single input for a number of input/output format
+ * pairs. Every pair is run a second time with the output in the input
+ * format, the difference approximates the cost of converting the input.
+ *
+ *   videomixer-convert-bench --width=1920 --height=1080 --frames=200
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+
+#define DEFAULT_WIDTH   1280
+#define DEFAULT_HEIGHT  720
+#define DEFAULT_FRAMES  100
+
+static gint opt_width = DEFAULT_WIDTH;
+static gint opt_height = DEFAULT_HEIGHT;
+static gint opt_frames = DEFAULT_FRAMES;
+
+typedef struct
+{
+  const gchar *in_format;
+  const gchar *in_colorimetry;
+  const gchar *out_format;
+  const gchar *out_colorimetry;
+} BenchPair;
+
+static const BenchPair pairs[] = {
+  /* fast paths */
+  {"I420", "bt601", "AYUV", "bt601"},
+  {"YUY2", "bt601", "I420", "bt601"},
+  {"UYVY", "bt601", "AYUV", "bt601"},
+  /* generic path */
+  {"I420", "bt601", "AYUV", "bt709"},
+  {"AYUV", "bt709", "I420", "bt601"},
+  {"RGB", "sRGB", "I420", "bt709"},
+  {"BGRx", "sRGB", "AYUV", "bt601"},
+  {"ARGB", "sRGB", "I420", "bt601"},
+  {"I420", "bt709", "BGRA", "sRGB"},
+  {"Y42B", "bt601", "NV12", "bt709"},
+  {"YVYU", "bt709", "Y444", "bt601"},
+};
+
+/* Returns the time per frame in ms, or -1 on error */
+static gdouble
+run_pipeline (const gchar * in_format, const gchar * in_colorimetry,
+    const gchar * out_format, const gchar * out_colorimetry)
+{
+  GstElement *pipeline;
+  GstBus *bus;
+  GstMessage *msg;
+  GError *err = NULL;
+  gchar *pstr;
+  gint64 start, elapsed;
+  gdouble res = -1;
+
+  pstr = g_strdup_printf ("videotestsrc num-buffers=%d ! "
+      "video/x-raw,format=%s,colorimetry=%s,width=%d,height=%d,"
+      "framerate=30/1 ! videomixer ! "
+      "video/x-raw,format=%s,colorimetry=%s ! fakesink", opt_frames,
+      in_format, in_colorimetry, opt_width, opt_height, out_format,
+      out_colorimetry);
+  pipeline = gst_parse_launch (pstr, &err);
+  g_free (pstr);
+
+  if (pipeline == NULL) {
+    g_printerr ("could not create pipeline: %s\n", err->message);
+    g_clear_error (&err);
+    return -1;
+  }
+
+  /* preroll first, so that negotiation and setup are not measured */
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  if (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_FAILURE)
+    goto done;
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  elapsed = g_get_monotonic_time () - start;
+  gst_object_unref (bus);
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS)
+    res = elapsed / 1000.0 / opt_frames;
+  gst_message_unref (msg);
+
+done:
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return res;
+}
+
+int
+main (int argc, char **argv)
+{
+  static const GOptionEntry bench_goptions[] = {
+    {"width", '\0', 0, G_OPTION_ARG_INT, &opt_width,
+        "width of the frames", NULL},
+    {"height", '\0', 0, G_OPTION_ARG_INT, &opt_height,
+        "height of the frames", NULL},
+    {"frames", 'n', 0, G_OPTION_ARG_INT, &opt_frames,
+        "number of frames to mix for each pair", NULL},
+    {NULL, '\0', 0, 0, NULL, NULL, NULL}
+  };
+  GOptionContext *ctx;
+  GError *opt_err = NULL;
+  guint i;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  g_option_context_add_main_entries (ctx, bench_goptions, NULL);
+
+  if (!g_option_context_parse (ctx, &argc, &argv, &opt_err)) {
+    g_error ("Error parsing command line options: %s", opt_err->message);
+    return -1;
+  }
+  g_option_context_free (ctx);
+
+  if (opt_width <= 0 || opt_height <= 0 || opt_frames <= 0) {
+    g_printerr ("width, height and frames must be positive\n");
+    return -1;
+  }
+
+  g_print ("%-10s %-6s    %-10s %-6s %10s %10s %10s\n", "in", "", "out", "",
+      "ms/frame", "no conv", "convert");
+
+  for (i = 0; i < G_N_ELEMENTS (pairs); i++) {
+    const BenchPair *pair = &pairs[i];
+    gdouble conv, base;
+
+    conv = run_pipeline (pair->in_format, pair->in_colorimetry,
+        pair->out_format, pair->out_colorimetry);
+    base = run_pipeline (pair->in_format, pair->in_colorimetry,
+        pair->in_format, pair->in_colorimetry);
+
+    if (conv < 0 || base < 0) {
+      g_print ("%-10s %-6s -> %-10s %-6s failed\n", pair->in_format,
+          pair->in_colorimetry, pair->out_format, pair->out_colorimetry);
+      continue;
+    }
+
+    g_print ("%-10s %-6s -> %-10s %-6s %10.3f %10.3f %10.3f\n",
+        pair->in_format, pair->in_colorimetry, pair->out_format,
+        pair->out_colorimetry, conv, base, conv - base);
+  }
+
+  return 0;
+}